@@ -62,16 +62,23 @@ CREATE TABLE device_%deviceid_songs (
   lyrics TEXT,
 
   originalyear INTEGER,
-  effective_originalyear INTEGER
+  effective_originalyear INTEGER,
+
+  file_identity TEXT,
+
+  replaygain_track_gain REAL,
+  replaygain_track_peak REAL,
+  replaygain_album_gain REAL,
+  replaygain_album_peak REAL
 );
 
 CREATE INDEX idx_device_%deviceid_songs_album ON device_%deviceid_songs (album);
 
 CREATE INDEX idx_device_%deviceid_songs_comp_artist ON device_%deviceid_songs (effective_compilation, artist);
 
-CREATE VIRTUAL TABLE device_%deviceid_fts USING fts3(
-  ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment, ftsyear
-  tokenize=unicode
+CREATE VIRTUAL TABLE device_%deviceid_fts USING %ftsmodule(
+  ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment, ftsyear,
+  %ftsoptions
 );
 
 UPDATE devices SET schema_version=0 WHERE ROWID=%deviceid;
@@ -49,12 +49,19 @@ CREATE TABLE jamendo.songs (
   lyrics TEXT,
 
   originalyear INTEGER,
-  effective_originalyear INTEGER
+  effective_originalyear INTEGER,
+
+  file_identity TEXT,
+
+  replaygain_track_gain REAL,
+  replaygain_track_peak REAL,
+  replaygain_album_gain REAL,
+  replaygain_album_peak REAL
 );
 
-CREATE VIRTUAL TABLE jamendo.songs_fts USING fts3(
+CREATE VIRTUAL TABLE jamendo.songs_fts USING %ftsmodule(
   ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment, ftsyear,
-  tokenize=unicode
+  %ftsoptions
 );
 
 CREATE INDEX jamendo.idx_jamendo_comp_artist ON songs (effective_compilation, artist);
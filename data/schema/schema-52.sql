@@ -0,0 +1,9 @@
+CREATE TABLE scan_checkpoints (
+  directory INTEGER NOT NULL,
+  path TEXT NOT NULL,
+  mtime INTEGER NOT NULL
+);
+
+CREATE INDEX idx_scan_checkpoints_directory ON scan_checkpoints (directory);
+
+UPDATE schema_version SET version=52;
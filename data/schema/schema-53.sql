@@ -0,0 +1,5 @@
+ALTER TABLE %allsongstables ADD COLUMN file_identity TEXT;
+
+CREATE INDEX idx_file_identity ON songs (file_identity);
+
+UPDATE schema_version SET version=53;
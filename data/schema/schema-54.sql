@@ -0,0 +1,42 @@
+CREATE TABLE songs_aggregates (
+  kind TEXT NOT NULL,
+  value TEXT NOT NULL,
+  effective_compilation INTEGER NOT NULL,
+  song_count INTEGER NOT NULL,
+  first_song INTEGER NOT NULL
+);
+
+CREATE INDEX idx_songs_aggregates ON songs_aggregates (kind, effective_compilation, value);
+
+CREATE TABLE songs_albums (
+  album TEXT NOT NULL,
+  artist TEXT NOT NULL,
+  albumartist TEXT NOT NULL,
+  effective_compilation INTEGER NOT NULL,
+  song_count INTEGER NOT NULL,
+  first_song INTEGER NOT NULL
+);
+
+CREATE INDEX idx_songs_albums ON songs_albums (album, artist, albumartist);
+
+INSERT INTO songs_aggregates (kind, value, effective_compilation, song_count, first_song)
+  SELECT 'artist', IFNULL(artist, ''), effective_compilation, COUNT(*), MIN(ROWID)
+  FROM songs WHERE unavailable = 0 GROUP BY 2, 3;
+
+INSERT INTO songs_aggregates (kind, value, effective_compilation, song_count, first_song)
+  SELECT 'effective_albumartist', IFNULL(effective_albumartist, ''), effective_compilation, COUNT(*), MIN(ROWID)
+  FROM songs WHERE unavailable = 0 GROUP BY 2, 3;
+
+INSERT INTO songs_aggregates (kind, value, effective_compilation, song_count, first_song)
+  SELECT 'album', IFNULL(album, ''), effective_compilation, COUNT(*), MIN(ROWID)
+  FROM songs WHERE unavailable = 0 GROUP BY 2, 3;
+
+INSERT INTO songs_aggregates (kind, value, effective_compilation, song_count, first_song)
+  SELECT 'genre', IFNULL(genre, ''), effective_compilation, COUNT(*), MIN(ROWID)
+  FROM songs WHERE unavailable = 0 GROUP BY 2, 3;
+
+INSERT INTO songs_albums (album, artist, albumartist, effective_compilation, song_count, first_song)
+  SELECT IFNULL(album, ''), IFNULL(artist, ''), IFNULL(albumartist, ''), effective_compilation, COUNT(*), MIN(ROWID)
+  FROM songs WHERE unavailable = 0 GROUP BY 1, 2, 3, 4;
+
+UPDATE schema_version SET version=54;
@@ -0,0 +1,19 @@
+CREATE INDEX idx_songs_grouping_artist_album
+  ON songs (artist, album, effective_compilation, unavailable);
+
+CREATE INDEX idx_songs_grouping_effective_albumartist_album
+  ON songs (effective_albumartist, album, effective_compilation, unavailable);
+
+CREATE INDEX idx_songs_grouping_artist_year_album_grouping
+  ON songs (artist, year, album, grouping, effective_compilation, unavailable);
+
+CREATE INDEX idx_songs_grouping_album
+  ON songs (album, effective_compilation, unavailable);
+
+CREATE INDEX idx_songs_grouping_genre_album
+  ON songs (genre, album, effective_compilation, unavailable);
+
+CREATE INDEX idx_songs_grouping_genre_artist_album
+  ON songs (genre, artist, album, effective_compilation, unavailable);
+
+UPDATE schema_version SET version=56;
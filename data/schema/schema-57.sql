@@ -0,0 +1,11 @@
+CREATE VIRTUAL TABLE icecast_stations_fts USING fts4(
+  ftsname, ftsgenre,
+  tokenize=unicode,
+  prefix="1,2,3"
+);
+
+INSERT INTO icecast_stations_fts (ROWID, ftsname, ftsgenre)
+    SELECT ROWID, name, genre
+    FROM icecast_stations;
+
+UPDATE schema_version SET version=57;
@@ -0,0 +1,7 @@
+ALTER TABLE playlist_items ADD COLUMN sort_key INTEGER NOT NULL DEFAULT 0;
+
+UPDATE playlist_items SET sort_key = ROWID * 1024;
+
+CREATE INDEX idx_playlist_items_sort_key ON playlist_items (playlist, sort_key);
+
+UPDATE schema_version SET version=58;
@@ -0,0 +1,3 @@
+ALTER TABLE playlists ADD COLUMN queue TEXT;
+
+UPDATE schema_version SET version=59;
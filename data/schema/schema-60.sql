@@ -0,0 +1,8 @@
+CREATE TABLE cue_sheets (
+  path TEXT PRIMARY KEY,
+  mtime INTEGER NOT NULL,
+  size INTEGER NOT NULL,
+  songs BLOB NOT NULL
+);
+
+UPDATE schema_version SET version=60;
@@ -0,0 +1,7 @@
+CREATE TABLE tag_reader_crashes (
+  path TEXT PRIMARY KEY,
+  mtime INTEGER NOT NULL,
+  crashes INTEGER NOT NULL
+);
+
+UPDATE schema_version SET version=61;
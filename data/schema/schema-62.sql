@@ -0,0 +1,29 @@
+CREATE TABLE songs_sync (
+  song_id INTEGER PRIMARY KEY,
+  revision INTEGER NOT NULL,
+  deleted INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE INDEX idx_songs_sync_revision ON songs_sync (revision);
+
+INSERT INTO songs_sync (song_id, revision) SELECT ROWID, ROWID FROM songs;
+
+CREATE TRIGGER songs_sync_insert AFTER INSERT ON songs BEGIN
+  INSERT OR REPLACE INTO songs_sync (song_id, revision, deleted)
+    VALUES (new.ROWID,
+            (SELECT IFNULL(MAX(revision), 0) + 1 FROM songs_sync), 0);
+END;
+
+CREATE TRIGGER songs_sync_update AFTER UPDATE ON songs BEGIN
+  INSERT OR REPLACE INTO songs_sync (song_id, revision, deleted)
+    VALUES (new.ROWID,
+            (SELECT IFNULL(MAX(revision), 0) + 1 FROM songs_sync), 0);
+END;
+
+CREATE TRIGGER songs_sync_delete AFTER DELETE ON songs BEGIN
+  INSERT OR REPLACE INTO songs_sync (song_id, revision, deleted)
+    VALUES (old.ROWID,
+            (SELECT IFNULL(MAX(revision), 0) + 1 FROM songs_sync), 1);
+END;
+
+UPDATE schema_version SET version=62;
@@ -0,0 +1,3 @@
+ALTER TABLE devices ADD COLUMN database_stamp TEXT NOT NULL DEFAULT '';
+
+UPDATE schema_version SET version=63;
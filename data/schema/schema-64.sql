@@ -0,0 +1,9 @@
+CREATE TABLE musicbrainz_discids (
+  discid TEXT PRIMARY KEY,
+  artist TEXT NOT NULL,
+  album TEXT NOT NULL,
+  tracks BLOB NOT NULL,
+  fetched INTEGER NOT NULL
+);
+
+UPDATE schema_version SET version=64;
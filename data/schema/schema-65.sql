@@ -0,0 +1,13 @@
+CREATE TABLE lastfm_scrobbles (
+  username TEXT NOT NULL,
+  artist TEXT NOT NULL,
+  title TEXT NOT NULL,
+  album TEXT NOT NULL,
+  track INTEGER NOT NULL,
+  duration INTEGER NOT NULL,
+  timestamp INTEGER NOT NULL
+);
+
+CREATE INDEX idx_lastfm_scrobbles_username ON lastfm_scrobbles (username);
+
+UPDATE schema_version SET version=65;
@@ -0,0 +1,7 @@
+CREATE TABLE musicbrainz_recordings (
+  mbid TEXT PRIMARY KEY,
+  tracks BLOB NOT NULL,
+  fetched INTEGER NOT NULL
+);
+
+UPDATE schema_version SET version=66;
@@ -0,0 +1,6 @@
+CREATE TABLE moodbar_features (
+  filename TEXT PRIMARY KEY,
+  features BLOB NOT NULL
+);
+
+UPDATE schema_version SET version=69;
@@ -0,0 +1,9 @@
+CREATE TABLE seafile_tree (
+  library TEXT NOT NULL,
+  path TEXT NOT NULL,
+  name TEXT,
+  entries BLOB NOT NULL,
+  PRIMARY KEY (library, path)
+);
+
+UPDATE schema_version SET version=70;
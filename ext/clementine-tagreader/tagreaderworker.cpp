@@ -23,9 +23,18 @@
 #include <QNetworkAccessManager>
 #include <QTextCodec>
 #include <QUrl>
+#include <cstring>
+
+const int TagReaderWorker::kSharedMemoryThreshold = 64 * 1024;
+const int TagReaderWorker::kSharedMemoryLifetimeMsec = 10000;
 
 TagReaderWorker::TagReaderWorker(QIODevice* socket, QObject* parent)
-    : AbstractMessageHandler<cpb::tagreader::Message>(socket, parent) {}
+    : AbstractMessageHandler<cpb::tagreader::Message>(socket, parent),
+      next_shared_memory_slot_(0) {
+  expire_timer_.setInterval(kSharedMemoryLifetimeMsec);
+  QObject::connect(&expire_timer_, &QTimer::timeout,
+                   [this]() { ExpireSharedMemory(); });
+}
 
 void TagReaderWorker::MessageArrived(const cpb::tagreader::Message& message) {
   cpb::tagreader::Message reply;
@@ -41,7 +50,16 @@ void TagReaderWorker::MessageArrived(const cpb::tagreader::Message& message) {
   if (message.has_read_file_request()) {
     tag_reader_.ReadFile(
         QStringFromStdString(message.read_file_request().filename()),
-        reply.mutable_read_file_response()->mutable_metadata());
+        reply.mutable_read_file_response()->mutable_metadata(),
+        message.read_file_request().fast());
+  } else if (message.has_read_files_request()) {
+    cpb::tagreader::ReadFilesResponse* response =
+        reply.mutable_read_files_response();
+    for (const std::string& filename :
+         message.read_files_request().filenames()) {
+      tag_reader_.ReadFile(QStringFromStdString(filename),
+                           response->add_metadata());
+    }
   } else if (message.has_save_file_request()) {
     reply.mutable_save_file_response()->set_success(tag_reader_.SaveFile(
         QStringFromStdString(message.save_file_request().filename()),
@@ -51,21 +69,45 @@ void TagReaderWorker::MessageArrived(const cpb::tagreader::Message& message) {
         tag_reader_.SaveSongStatisticsToFile(
             QStringFromStdString(
                 message.save_song_statistics_to_file_request().filename()),
-            message.save_song_statistics_to_file_request().metadata()));
+            message.save_song_statistics_to_file_request().metadata(),
+            message.save_song_statistics_to_file_request().include_rating()));
   } else if (message.has_save_song_rating_to_file_request()) {
     reply.mutable_save_song_rating_to_file_response()->set_success(
         tag_reader_.SaveSongRatingToFile(
             QStringFromStdString(
                 message.save_song_rating_to_file_request().filename()),
             message.save_song_rating_to_file_request().metadata()));
+  } else if (message.has_save_replaygain_to_file_request()) {
+    reply.mutable_save_replaygain_to_file_response()->set_success(
+        tag_reader_.SaveReplayGainToFile(
+            QStringFromStdString(
+                message.save_replaygain_to_file_request().filename()),
+            message.save_replaygain_to_file_request().metadata()));
   } else if (message.has_is_media_file_request()) {
     reply.mutable_is_media_file_response()->set_success(tag_reader_.IsMediaFile(
         QStringFromStdString(message.is_media_file_request().filename())));
   } else if (message.has_load_embedded_art_request()) {
-    QByteArray data = tag_reader_.LoadEmbeddedArt(
-        QStringFromStdString(message.load_embedded_art_request().filename()));
-    reply.mutable_load_embedded_art_response()->set_data(data.constData(),
-                                                         data.size());
+    const cpb::tagreader::LoadEmbeddedArtRequest& req =
+        message.load_embedded_art_request();
+    cpb::tagreader::LoadEmbeddedArtResponse* response =
+        reply.mutable_load_embedded_art_response();
+
+    QByteArray data =
+        tag_reader_.LoadEmbeddedArt(QStringFromStdString(req.filename()));
+
+    // Big covers would otherwise be copied in and out of the message and the
+    // socket several times over.
+    QString key;
+    if (req.allow_shared_memory() && data.size() >= kSharedMemoryThreshold) {
+      key = ShareData(data);
+    }
+
+    if (key.isEmpty()) {
+      response->set_data(data.constData(), data.size());
+    } else {
+      response->set_shared_memory_key(DataCommaSizeFromQString(key));
+      response->set_shared_memory_size(data.size());
+    }
   } else if (message.has_read_cloud_file_request()) {
 #ifdef HAVE_GOOGLE_DRIVE
     const cpb::tagreader::ReadCloudFileRequest& req =
@@ -85,6 +127,48 @@ void TagReaderWorker::MessageArrived(const cpb::tagreader::Message& message) {
   SendReply(message, &reply);
 }
 
+QString TagReaderWorker::ShareData(const QByteArray& data) {
+  ExpireSharedMemory();
+
+  // ExpireSharedMemory has made room, so the segments left are in the slots
+  // before this one.  If the client is still reading an old segment in this
+  // slot, create() fails and the data goes through the socket instead.
+  const QString key = TagReader::SharedMemoryKey(
+      QCoreApplication::applicationPid(), next_shared_memory_slot_);
+  next_shared_memory_slot_ =
+      (next_shared_memory_slot_ + 1) % TagReader::kMaxSharedMemorySegments;
+
+  std::unique_ptr<QSharedMemory> memory(new QSharedMemory(key));
+  if (!memory->create(data.size())) {
+    qLog(Warning) << "Couldn't create shared memory:" << memory->errorString();
+    return QString();
+  }
+
+  memory->lock();
+  memcpy(memory->data(), data.constData(), data.size());
+  memory->unlock();
+
+  QElapsedTimer age;
+  age.start();
+  shared_memory_.emplace_back(age, std::move(memory));
+  expire_timer_.start();
+
+  return key;
+}
+
+void TagReaderWorker::ExpireSharedMemory() {
+  // Detaching the last attachment frees the segment, so once the client has
+  // read it and let go, this is what frees it.
+  while (!shared_memory_.empty() &&
+         (shared_memory_.front().first.elapsed() >= kSharedMemoryLifetimeMsec ||
+          int(shared_memory_.size()) >=
+              TagReader::kMaxSharedMemorySegments)) {
+    shared_memory_.erase(shared_memory_.begin());
+  }
+
+  if (shared_memory_.empty()) expire_timer_.stop();
+}
+
 void TagReaderWorker::DeviceClosed() {
   AbstractMessageHandler<cpb::tagreader::Message>::DeviceClosed();
 
@@ -18,6 +18,13 @@
 #ifndef TAGREADERWORKER_H
 #define TAGREADERWORKER_H
 
+#include <QElapsedTimer>
+#include <QSharedMemory>
+#include <QTimer>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "clementine-config.h"
 #include "tagreader.h"
 #include "tagreadermessages.pb.h"
@@ -32,7 +39,23 @@ class TagReaderWorker : public AbstractMessageHandler<cpb::tagreader::Message> {
   void DeviceClosed();
 
  private:
+  // Images at least this big go through shared memory rather than the socket.
+  static const int kSharedMemoryThreshold;
+  // Segments are kept until the client's had time to read them.
+  static const int kSharedMemoryLifetimeMsec;
+
+  // Returns the key of a new segment holding data, or an empty string if it
+  // couldn't be made.
+  QString ShareData(const QByteArray& data);
+  void ExpireSharedMemory();
+
   TagReader tag_reader_;
+
+  typedef std::pair<QElapsedTimer, std::unique_ptr<QSharedMemory>> Segment;
+  std::vector<Segment> shared_memory_;
+  // See TagReader::SharedMemoryKey.
+  int next_shared_memory_slot_;
+  QTimer expire_timer_;
 };
 
 #endif  // TAGREADERWORKER_H
@@ -28,13 +28,23 @@
 #include <QBuffer>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QHash>
 #include <QStringList>
 #include <QTextStream>
 #include <QtMessageHandler>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include "logging.h"
+#include "messagering.h"
 
 namespace logging {
 
@@ -55,6 +65,223 @@ template <class T>
 static T CreateLogger(Level level, const QString& class_name, int line,
                       const char* category);
 
+// Messages waiting for the async writer.  Never deleted once made, a thread
+// might be pushing to it while it's being stopped.
+static std::atomic<MessageRing*> sRing(nullptr);
+static std::unique_ptr<std::thread> sWriter;
+static std::atomic<bool> sStopWriter(false);
+static const size_t kRingSize = 8192;
+
+// The writer sleeps on sWriterWake when there's nothing to write.  Pushing
+// only takes the mutex to wake it if it's waiting, and sPushed, which counts
+// pushes and drops, tells it whether anything arrived before it went to
+// sleep.
+static std::mutex sWriterWakeMutex;
+static std::condition_variable sWriterWake;
+static std::atomic<bool> sWriterWaiting(false);
+static std::atomic<uint64_t> sPushed(0);
+
+static std::atomic<uint64_t> sDropped(0);
+
+// Messages for each category in the current second.  Categories are hashed
+// into a fixed number of buckets so none of this needs a lock: categories that
+// share a bucket share its limit.
+struct RateBucket {
+  std::atomic<int64_t> second;
+  std::atomic<int> count;
+};
+static const int kRateBuckets = 256;
+static RateBucket sRateBuckets[kRateBuckets];
+static std::atomic<int> sRateLimit(0);
+
+// The last bytes written, for crash reports.  pos is where the next byte
+// goes.
+static std::atomic<bool> sMemoryLogEnabled(false);
+static std::mutex sMemoryLogMutex;
+static std::vector<char> sMemoryLog;
+static size_t sMemoryLogPos = 0;
+static bool sMemoryLogWrapped = false;
+
+static void AppendToMemoryLog(const char* data, size_t size) {
+  if (!sMemoryLogEnabled.load(std::memory_order_relaxed)) return;
+
+  std::lock_guard<std::mutex> l(sMemoryLogMutex);
+  const size_t capacity = sMemoryLog.size();
+  if (capacity == 0) return;
+
+  if (size > capacity) {
+    data += size - capacity;
+    size = capacity;
+  }
+  while (size > 0) {
+    const size_t chunk = std::min(size, capacity - sMemoryLogPos);
+    memcpy(sMemoryLog.data() + sMemoryLogPos, data, chunk);
+    data += chunk;
+    size -= chunk;
+    sMemoryLogPos += chunk;
+    if (sMemoryLogPos == capacity) {
+      sMemoryLogPos = 0;
+      sMemoryLogWrapped = true;
+    }
+  }
+}
+
+static void WriteLine(const std::string& line) {
+  fprintf(stderr, "%s\n", line.c_str());
+  AppendToMemoryLog(line.data(), line.size());
+  AppendToMemoryLog("\n", 1);
+}
+
+static void WriteQueued(MessageRing* ring) {
+  std::string line;
+  while (ring->Pop(&line)) WriteLine(line);
+}
+
+static void WakeWriter() {
+  sPushed.fetch_add(1);
+  if (sWriterWaiting.load()) {
+    std::lock_guard<std::mutex> l(sWriterWakeMutex);
+    sWriterWake.notify_one();
+  }
+}
+
+static void WriterLoop() {
+  MessageRing* ring = sRing.load(std::memory_order_acquire);
+  uint64_t reported_dropped = 0;
+
+  while (true) {
+    const bool stopping = sStopWriter.load();
+    const uint64_t pushed = sPushed.load();
+
+    std::string line;
+    bool wrote = false;
+    while (ring->Pop(&line)) {
+      WriteLine(line);
+      wrote = true;
+    }
+
+    const uint64_t dropped = sDropped.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped) {
+      WriteLine(QString("%1 log messages were dropped")
+                    .arg(dropped - reported_dropped)
+                    .toStdString());
+      reported_dropped = dropped;
+    }
+
+    if (stopping) break;
+    if (!wrote) {
+      std::unique_lock<std::mutex> l(sWriterWakeMutex);
+      sWriterWaiting.store(true);
+      sWriterWake.wait(l, [pushed]() {
+        return sPushed.load() != pushed || sStopWriter.load();
+      });
+      sWriterWaiting.store(false);
+    }
+  }
+  fflush(stderr);
+}
+
+// Where every formatted message ends up.  Fatal messages are written straight
+// away, after anything still queued, since the program is about to end.
+static void Output(const std::string& line, bool fatal) {
+  MessageRing* ring = sRing.load(std::memory_order_acquire);
+  if (ring) {
+    if (!fatal) {
+      std::string message(line);
+      if (!ring->Push(std::move(message))) {
+        sDropped.fetch_add(1, std::memory_order_relaxed);
+      }
+      WakeWriter();
+      return;
+    }
+    WriteQueued(ring);
+  }
+  WriteLine(line);
+}
+
+static bool WithinRateLimit(const QString& category) {
+  const int limit = sRateLimit.load(std::memory_order_relaxed);
+  if (limit <= 0) return true;
+
+  const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  RateBucket& bucket = sRateBuckets[qHash(category) % kRateBuckets];
+  int64_t second = bucket.second.load(std::memory_order_relaxed);
+  if (second != now && bucket.second.compare_exchange_strong(second, now)) {
+    bucket.count.store(0, std::memory_order_relaxed);
+  }
+  return bucket.count.fetch_add(1, std::memory_order_relaxed) < limit;
+}
+
+void StartAsyncWriter() {
+  if (sWriter) return;
+
+  static MessageRing* ring = new MessageRing(kRingSize);
+  sStopWriter = false;
+  sRing.store(ring, std::memory_order_release);
+  sWriter.reset(new std::thread(&WriterLoop));
+
+  static bool registered = false;
+  if (!registered) {
+    registered = true;
+    atexit(&StopAsyncWriter);
+  }
+}
+
+void StopAsyncWriter() {
+  if (!sWriter) return;
+
+  sStopWriter = true;
+  {
+    std::lock_guard<std::mutex> l(sWriterWakeMutex);
+    sWriterWake.notify_one();
+  }
+  sWriter->join();
+  sWriter.reset();
+
+  // Anything pushed while the writer was stopping.
+  MessageRing* ring = sRing.exchange(nullptr);
+  WriteQueued(ring);
+}
+
+void SetRateLimit(int messages_per_second) {
+  sRateLimit.store(messages_per_second);
+}
+
+uint64_t DroppedMessages() { return sDropped.load(); }
+
+void SetMemoryLogSize(size_t bytes) {
+  std::lock_guard<std::mutex> l(sMemoryLogMutex);
+  sMemoryLog.assign(bytes, '\0');
+  sMemoryLogPos = 0;
+  sMemoryLogWrapped = false;
+  sMemoryLogEnabled = bytes > 0;
+}
+
+std::string MemoryLog() {
+  std::lock_guard<std::mutex> l(sMemoryLogMutex);
+  std::string ret;
+  if (sMemoryLogWrapped) {
+    ret.assign(sMemoryLog.begin() + sMemoryLogPos, sMemoryLog.end());
+  }
+  ret.append(sMemoryLog.begin(), sMemoryLog.begin() + sMemoryLogPos);
+  return ret;
+}
+
+void DumpMemoryLog(int fd) {
+  // No lock: this is for crash handlers, where the thread holding it might
+  // be the one that crashed.  A line might be torn.
+  const char* data = sMemoryLog.data();
+  if (sMemoryLogWrapped) {
+    if (write(fd, data + sMemoryLogPos, sMemoryLog.size() - sMemoryLogPos) <
+        0) {
+      return;
+    }
+  }
+  if (write(fd, data, sMemoryLogPos) < 0) return;
+}
+
 void GLog(const char* domain, int level, const char* message, void* user_data) {
   switch (level) {
     case G_LOG_FLAG_RECURSION:
@@ -116,10 +343,12 @@ class LoggedDebug : public DebugBase<LoggedDebug> {
 
 static void MessageHandler(QtMsgType type, const QMessageLogContext& context,
                            const QString& message) {
-  if (strncmp(kMessageHandlerMagic, message.toLocal8Bit().data(),
+  const QByteArray local8bit = message.toLocal8Bit();
+  if (strncmp(kMessageHandlerMagic, local8bit.constData(),
               kMessageHandlerMagicLength) == 0) {
-    fprintf(stderr, "%s\n",
-            message.toLocal8Bit().data() + kMessageHandlerMagicLength);
+    Output(std::string(local8bit.constData() + kMessageHandlerMagicLength,
+                       local8bit.size() - kMessageHandlerMagicLength),
+           type == QtFatalMsg);
     return;
   }
 
@@ -144,7 +373,7 @@ static void MessageHandler(QtMsgType type, const QMessageLogContext& context,
     d << line.toLocal8Bit().constData();
     if (d.buf_) {
       d.buf_->close();
-      fprintf(stderr, "%s\n", d.buf_->buffer().data());
+      Output(d.buf_->buffer().toStdString(), type == QtFatalMsg);
     }
   }
 
@@ -256,6 +485,12 @@ static T CreateLogger(Level level, const QString& class_name, int line,
     return T();
   }
 
+  // Errors always get through.
+  if (level > Level_Error && !WithinRateLimit(filter_category)) {
+    sDropped.fetch_add(1, std::memory_order_relaxed);
+    return T();
+  }
+
   QString function_line = class_name;
   if (line != -1) {
     function_line += ":" + QString::number(line);
@@ -22,6 +22,7 @@
 #define LOGGING_H
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 
 #include <QDebug>
@@ -64,6 +65,29 @@ enum Level {
 void Init();
 void SetLevels(const QString& levels);
 
+// Writes messages from a background thread instead of the thread that logged
+// them.  They're queued in a fixed size ring buffer: if the writer can't keep
+// up, new messages are dropped and counted rather than making anyone wait.
+// Fatal messages are still written straight away.  The writer is stopped at
+// exit, after writing everything still queued.
+void StartAsyncWriter();
+void StopAsyncWriter();
+
+// Lets each category log at most this many messages a second, not counting
+// errors.  The rest are dropped and counted.  0, the default, means no limit.
+void SetRateLimit(int messages_per_second);
+
+// Messages dropped by the ring buffer being full or by the rate limit.
+uint64_t DroppedMessages();
+
+// Keeps the last bytes of log output in memory, for crash reports.  0, the
+// default, keeps none.
+void SetMemoryLogSize(size_t bytes);
+std::string MemoryLog();
+// Writes the in memory log to fd without taking any locks or allocating, so
+// it can be called from a crash handler.
+void DumpMemoryLog(int fd);
+
 void DumpStackTrace();
 
 QDebug CreateLoggerFatal(int line, const char* pretty_function,
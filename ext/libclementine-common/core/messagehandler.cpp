@@ -26,6 +26,17 @@
 
 #include "core/logging.h"
 
+namespace {
+
+// A buffer that grew bigger than this for one message, an embedded cover for
+// example, is let go of afterwards rather than kept.
+const int kMaxKeptBufferSize = 1024 * 1024;
+
+// Longer messages than this can only come from a corrupt length prefix.
+const quint32 kMaxMessageSize = 128 * 1024 * 1024;
+
+}  // namespace
+
 _MessageHandlerBase::_MessageHandlerBase(QIODevice* device, QObject* parent)
     : QObject(parent),
       device_(nullptr),
@@ -33,6 +44,7 @@ _MessageHandlerBase::_MessageHandlerBase(QIODevice* device, QObject* parent)
       flush_local_socket_(nullptr),
       reading_protobuf_(false),
       expected_length_(0),
+      buffer_used_(0),
       is_device_closed_(false) {
   if (device) {
     SetDevice(device);
@@ -42,8 +54,6 @@ _MessageHandlerBase::_MessageHandlerBase(QIODevice* device, QObject* parent)
 void _MessageHandlerBase::SetDevice(QIODevice* device) {
   device_ = device;
 
-  buffer_.open(QIODevice::ReadWrite);
-
   connect(device, SIGNAL(readyRead()), SLOT(DeviceReadyRead()));
 
   // Yeah I know.
@@ -61,30 +71,50 @@ void _MessageHandlerBase::SetDevice(QIODevice* device) {
 void _MessageHandlerBase::DeviceReadyRead() {
   while (device_->bytesAvailable()) {
     if (!reading_protobuf_) {
+      // Wait until the whole length has arrived
+      if (device_->bytesAvailable() < 4) break;
+
       // Read the length of the next message
       QDataStream s(device_);
       s >> expected_length_;
+      if (expected_length_ > kMaxMessageSize) {
+        qLog(Error) << "Message too long:" << expected_length_ << "bytes";
+        device_->close();
+        return;
+      }
 
+      if (buffer_.size() < int(expected_length_)) {
+        buffer_.resize(expected_length_);
+      }
+      buffer_used_ = 0;
       reading_protobuf_ = true;
     }
 
-    // Read some of the message
-    buffer_.write(device_->read(expected_length_ - buffer_.size()));
+    // Read some of the message straight into the buffer
+    const qint64 read = device_->read(buffer_.data() + buffer_used_,
+                                      expected_length_ - buffer_used_);
+    if (read < 0) {
+      device_->close();
+      return;
+    }
+    buffer_used_ += read;
 
     // Did we get everything?
-    if (buffer_.size() == expected_length_) {
+    if (buffer_used_ == int(expected_length_)) {
+      reading_protobuf_ = false;
+
       // Parse the message
-      if (!RawMessageArrived(buffer_.data())) {
+      if (!RawMessageArrived(buffer_.constData(), expected_length_)) {
         qLog(Error) << "Malformed protobuf message";
         device_->close();
         return;
       }
 
-      // Clear the buffer
-      buffer_.close();
-      buffer_.setData(QByteArray());
-      buffer_.open(QIODevice::ReadWrite);
-      reading_protobuf_ = false;
+      // A handler that ran a nested event loop might have started reading the
+      // next message into the buffer already.
+      if (!reading_protobuf_ && buffer_.size() > kMaxKeptBufferSize) {
+        buffer_.clear();
+      }
     }
   }
 }
@@ -21,7 +21,7 @@
 #ifndef MESSAGEHANDLER_H
 #define MESSAGEHANDLER_H
 
-#include <QBuffer>
+#include <QByteArray>
 #include <QMap>
 #include <QMutex>
 #include <QMutexLocker>
@@ -61,7 +61,7 @@ class _MessageHandlerBase : public QObject {
   virtual void DeviceClosed();
 
  protected:
-  virtual bool RawMessageArrived(const QByteArray& data) = 0;
+  virtual bool RawMessageArrived(const char* data, int size) = 0;
   virtual void AbortAll() = 0;
 
  protected:
@@ -74,7 +74,10 @@ class _MessageHandlerBase : public QObject {
 
   bool reading_protobuf_;
   quint32 expected_length_;
-  QBuffer buffer_;
+  // Kept between messages so it only grows to the biggest one, rather than
+  // being allocated again for each.
+  QByteArray buffer_;
+  int buffer_used_;
 
   bool is_device_closed_;
 };
@@ -108,22 +111,31 @@ class AbstractMessageHandler : public _MessageHandlerBase {
   // reply on the socket.  Used on the worker side.
   void SendReply(const MessageType& request, MessageType* reply);
 
+  // The number of requests that haven't had a reply yet.  Must be called from
+  // my thread.
+  int pending_requests() const { return pending_replies_.size(); }
+
  protected:
   // Called when a message is received from the socket.
   virtual void MessageArrived(const MessageType& message) {}
 
   // _MessageHandlerBase
-  bool RawMessageArrived(const QByteArray& data);
+  bool RawMessageArrived(const char* data, int size);
   void AbortAll();
 
  private:
   QMap<int, ReplyType*> pending_replies_;
+
+  // Messages are parsed into this one, so the strings and submessages it
+  // allocated for the last message are reused for the next.
+  MessageType message_;
+  bool message_in_use_;
 };
 
 template <typename MT>
 AbstractMessageHandler<MT>::AbstractMessageHandler(QIODevice* device,
                                                    QObject* parent)
-    : _MessageHandlerBase(device, parent) {}
+    : _MessageHandlerBase(device, parent), message_in_use_(false) {}
 
 template <typename MT>
 void AbstractMessageHandler<MT>::SendMessage(const MessageType& message) {
@@ -155,19 +167,26 @@ void AbstractMessageHandler<MT>::SendReply(const MessageType& request,
 }
 
 template <typename MT>
-bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray& data) {
-  MessageType message;
-  if (!message.ParseFromArray(data.constData(), data.size())) {
+bool AbstractMessageHandler<MT>::RawMessageArrived(const char* data,
+                                                   int size) {
+  // A handler that runs an event loop can get here again before it's done
+  // with message_.
+  MessageType nested_message;
+  MessageType* message = message_in_use_ ? &nested_message : &message_;
+  if (!message->ParseFromArray(data, size)) {
     return false;
   }
 
-  ReplyType* reply = pending_replies_.take(message.id());
+  ReplyType* reply = pending_replies_.take(message->id());
 
   if (reply) {
     // This is a reply to a message that we created earlier.
     reply->SetReply(message);
   } else {
-    MessageArrived(message);
+    const bool was_in_use = message_in_use_;
+    message_in_use_ = true;
+    MessageArrived(*message);
+    message_in_use_ = was_in_use;
   }
 
   return true;
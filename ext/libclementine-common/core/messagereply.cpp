@@ -17,12 +17,20 @@
 
 #include "messagereply.h"
 
+QMutex _MessageReplyBase::sWaitMutex;
+
 _MessageReplyBase::_MessageReplyBase(QObject* parent)
-    : QObject(parent), finished_(false), success_(false) {}
+    : QObject(parent), finished_(false), success_(false), released_(false) {}
 
 bool _MessageReplyBase::WaitForFinished() {
   qLog(Debug) << "Waiting on ID" << id();
-  semaphore_.acquire();
+  {
+    QMutexLocker l(&sWaitMutex);
+    if (!released_ && !wait_condition_) {
+      wait_condition_.reset(new QWaitCondition);
+    }
+    while (!released_) wait_condition_->wait(&sWaitMutex);
+  }
   qLog(Debug) << "Acquired ID" << id();
   return success_;
 }
@@ -34,5 +42,11 @@ void _MessageReplyBase::Abort() {
 
   emit Finished(success_);
   qLog(Debug) << "Releasing ID" << id() << "(aborted)";
-  semaphore_.release();
+  Release();
+}
+
+void _MessageReplyBase::Release() {
+  QMutexLocker l(&sWaitMutex);
+  released_ = true;
+  if (wait_condition_) wait_condition_->wakeAll();
 }
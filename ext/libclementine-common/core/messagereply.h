@@ -18,8 +18,10 @@
 #ifndef MESSAGEREPLY_H
 #define MESSAGEREPLY_H
 
+#include <QMutex>
 #include <QObject>
-#include <QSemaphore>
+#include <QWaitCondition>
+#include <memory>
 
 #include "core/logging.h"
 
@@ -36,8 +38,8 @@ class _MessageReplyBase : public QObject {
   bool is_finished() const { return finished_; }
   bool is_successful() const { return success_; }
 
-  // Waits for the reply to finish by waiting on a semaphore.  Never call this
-  // from the MessageHandler's thread or it will block forever.
+  // Waits for the reply to finish.  Never call this from the MessageHandler's
+  // thread or it will block forever.
   // Returns true if the call was successful.
   bool WaitForFinished();
 
@@ -47,10 +49,18 @@ signals:
   void Finished(bool success);
 
  protected:
+  // Wakes up anyone waiting for the reply.
+  void Release();
+
   bool finished_;
   bool success_;
+  bool released_;
 
-  QSemaphore semaphore_;
+  // There are lots of replies but few are ever waited for, so the wait
+  // condition is only made by the first thread that waits.  The replies
+  // share one mutex to guard it.
+  std::unique_ptr<QWaitCondition> wait_condition_;
+  static QMutex sWaitMutex;
 };
 
 // A reply future class that is returned immediately for requests that will
@@ -64,7 +74,8 @@ class MessageReply : public _MessageReplyBase {
   const MessageType& request_message() const { return request_message_; }
   const MessageType& message() const { return reply_message_; }
 
-  void SetReply(const MessageType& message);
+  // Takes the contents of message, leaving it empty.
+  void SetReply(MessageType* message);
 
  private:
   MessageType request_message_;
@@ -79,15 +90,15 @@ MessageReply<MessageType>::MessageReply(const MessageType& request_message,
 }
 
 template <typename MessageType>
-void MessageReply<MessageType>::SetReply(const MessageType& message) {
+void MessageReply<MessageType>::SetReply(MessageType* message) {
   Q_ASSERT(!finished_);
 
-  reply_message_.MergeFrom(message);
+  reply_message_.Swap(message);
   finished_ = true;
   success_ = true;
 
   qLog(Debug) << "Releasing ID" << id() << "(finished)";
-  semaphore_.release();
+  Release();
   emit Finished(success_);
 }
 
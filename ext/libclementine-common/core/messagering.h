@@ -0,0 +1,122 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Note: this file is licensed under the Apache License instead of GPL because
+// it is used by logging.cpp, which the Spotify blob links against.
+
+#ifndef MESSAGERING_H
+#define MESSAGERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// A fixed size queue of strings that any number of threads can push to and
+// pop from without taking a lock.  Push fails instead of waiting when the
+// queue is full.
+//
+// Each cell's sequence number says whose turn it is: a cell at position p is
+// free for the push of p when its sequence is p, and holds that push's string
+// for the pop of p when it's p + 1.
+class MessageRing {
+ public:
+  // size is rounded up to a power of two.
+  explicit MessageRing(size_t size) : mask_(RoundUp(size) - 1) {
+    cells_.reset(new Cell[mask_ + 1]);
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    push_pos_.store(0, std::memory_order_relaxed);
+    pop_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  bool Push(std::string&& message) {
+    size_t pos = push_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const ptrdiff_t diff =
+          static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // Full
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->message = std::move(message);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool Pop(std::string* message) {
+    size_t pos = pop_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const ptrdiff_t diff =
+          static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // Empty
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    message->swap(cell->message);
+    cell->message.clear();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    std::string message;
+  };
+
+  static size_t RoundUp(size_t size) {
+    size_t ret = 2;
+    while (ret < size) ret *= 2;
+    return ret;
+  }
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // Kept apart, so pushing threads and the popping thread don't keep taking
+  // the same cache line from each other.
+  std::atomic<size_t> push_pos_;
+  char padding_[64];
+  std::atomic<size_t> pop_pos_;
+};
+
+#endif  // MESSAGERING_H
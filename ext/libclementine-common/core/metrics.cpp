@@ -0,0 +1,215 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metrics.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+
+#include "core/logging.h"
+
+namespace metrics {
+
+const qint64 Histogram::kBucketBoundsUsec[] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000};
+
+Histogram::Histogram() : count_(0), sum_usec_(0) {
+  for (std::atomic<qint64>& bucket : buckets_) bucket.store(0);
+}
+
+void Histogram::ObserveUsec(qint64 usec) {
+  for (int i = 0; i < kBucketCount; ++i) {
+    if (usec <= kBucketBoundsUsec[i]) {
+      buckets_[i].fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+  }
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_usec_.fetch_add(usec, std::memory_order_relaxed);
+}
+
+namespace {
+
+enum Type { Type_Counter, Type_Gauge, Type_Histogram };
+
+struct Entry {
+  Type type_;
+  QString help_;
+  Counter* counter_;
+  Gauge* gauge_;
+  Histogram* histogram_;
+};
+
+// Never deleted, so metrics can still be updated while statics are being
+// destroyed on exit.
+QMutex* sMutex = new QMutex;
+QMap<QString, Entry>* sEntries = new QMap<QString, Entry>;
+
+const char* TypeName(Type type) {
+  switch (type) {
+    case Type_Counter:
+      return "counter";
+    case Type_Gauge:
+      return "gauge";
+    case Type_Histogram:
+      return "histogram";
+  }
+  return "untyped";
+}
+
+Entry* Find(const QString& name, Type type, const QString& help) {
+  QMap<QString, Entry>::iterator it = sEntries->find(name);
+  if (it == sEntries->end()) {
+    Entry entry = {type, help, nullptr, nullptr, nullptr};
+    it = sEntries->insert(name, entry);
+  } else if (it->type_ != type) {
+    qLog(Error) << "Metric" << name << "is a" << TypeName(it->type_)
+                << "not a" << TypeName(type);
+    return nullptr;
+  }
+  return &*it;
+}
+
+QByteArray Seconds(qint64 usec) {
+  return QByteArray::number(static_cast<double>(usec) / 1000000, 'g', 12);
+}
+
+QByteArray EscapeHelp(const QString& help) {
+  QByteArray ret = help.toUtf8();
+  ret.replace('\\', "\\\\");
+  ret.replace('\n', "\\n");
+  return ret;
+}
+
+}  // namespace
+
+// A metric that's already registered as another type still gets something to
+// update, it just isn't exported.
+Counter* GetCounter(const QString& name, const QString& help) {
+  QMutexLocker l(sMutex);
+  Entry* entry = Find(name, Type_Counter, help);
+  if (!entry) return new Counter;
+  if (!entry->counter_) entry->counter_ = new Counter;
+  return entry->counter_;
+}
+
+Gauge* GetGauge(const QString& name, const QString& help) {
+  QMutexLocker l(sMutex);
+  Entry* entry = Find(name, Type_Gauge, help);
+  if (!entry) return new Gauge;
+  if (!entry->gauge_) entry->gauge_ = new Gauge;
+  return entry->gauge_;
+}
+
+Histogram* GetHistogram(const QString& name, const QString& help) {
+  QMutexLocker l(sMutex);
+  Entry* entry = Find(name, Type_Histogram, help);
+  if (!entry) return new Histogram;
+  if (!entry->histogram_) entry->histogram_ = new Histogram;
+  return entry->histogram_;
+}
+
+QByteArray PrometheusText() {
+  QMutexLocker l(sMutex);
+
+  QByteArray ret;
+  for (QMap<QString, Entry>::const_iterator it = sEntries->constBegin();
+       it != sEntries->constEnd(); ++it) {
+    const QByteArray name = it.key().toUtf8();
+    ret += "# HELP " + name + " " + EscapeHelp(it->help_) + "\n";
+    ret += "# TYPE " + name + " " + TypeName(it->type_) + "\n";
+
+    switch (it->type_) {
+      case Type_Counter:
+        ret += name + " " + QByteArray::number(it->counter_->value()) + "\n";
+        break;
+
+      case Type_Gauge:
+        ret += name + " " + QByteArray::number(it->gauge_->value()) + "\n";
+        break;
+
+      case Type_Histogram: {
+        const Histogram* histogram = it->histogram_;
+        const qint64 count = histogram->count();
+
+        // Prometheus buckets count everything up to their bound.
+        qint64 cumulative = 0;
+        for (int i = 0; i < Histogram::kBucketCount; ++i) {
+          cumulative += histogram->bucket(i);
+          ret += name + "_bucket{le=\"" +
+                 Seconds(Histogram::kBucketBoundsUsec[i]) + "\"} " +
+                 QByteArray::number(cumulative) + "\n";
+        }
+        ret += name + "_bucket{le=\"+Inf\"} " + QByteArray::number(count) +
+               "\n";
+        ret += name + "_sum " + Seconds(histogram->sum_usec()) + "\n";
+        ret += name + "_count " + QByteArray::number(count) + "\n";
+        break;
+      }
+    }
+  }
+  return ret;
+}
+
+QString ToString() {
+  QMutexLocker l(sMutex);
+
+  QStringList lines;
+  for (QMap<QString, Entry>::const_iterator it = sEntries->constBegin();
+       it != sEntries->constEnd(); ++it) {
+    switch (it->type_) {
+      case Type_Counter:
+        lines << QString("%1: %2").arg(it.key()).arg(it->counter_->value());
+        break;
+
+      case Type_Gauge:
+        lines << QString("%1: %2").arg(it.key()).arg(it->gauge_->value());
+        break;
+
+      case Type_Histogram: {
+        const Histogram* histogram = it->histogram_;
+        const qint64 count = histogram->count();
+        if (count == 0) {
+          lines << QString("%1: none").arg(it.key());
+          break;
+        }
+
+        // The bucket the 90th percentile falls in.
+        QString p90 = "more";
+        qint64 cumulative = 0;
+        for (int i = 0; i < Histogram::kBucketCount; ++i) {
+          cumulative += histogram->bucket(i);
+          if (cumulative * 10 >= count * 9) {
+            p90 = QString::number(Histogram::kBucketBoundsUsec[i] / 1000.0);
+            break;
+          }
+        }
+
+        lines << QString("%1: %2 samples, mean %3 ms, 90% within %4 ms")
+                     .arg(it.key())
+                     .arg(count)
+                     .arg(histogram->sum_usec() / 1000.0 / count, 0, 'f', 1)
+                     .arg(p90);
+        break;
+      }
+    }
+  }
+  return lines.join("\n");
+}
+
+}  // namespace metrics
@@ -0,0 +1,121 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+
+// Counters, gauges and histograms of what the process is doing, for the debug
+// console and for exporting in the Prometheus text format.  A metric is made
+// the first time its name is asked for and lives until the process exits, so
+// hot paths look it up once and keep the pointer:
+//
+//   static metrics::Counter* songs_read = metrics::GetCounter(
+//       "clementine_library_songs_read_total", "Songs the library read");
+//   songs_read->Increment();
+//
+// Updating a metric is a relaxed atomic operation or two, and is thread safe.
+namespace metrics {
+
+class Counter {
+ public:
+  Counter() : value_(0) {}
+
+  void Increment(qint64 n = 1) {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+  qint64 value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  Q_DISABLE_COPY(Counter)
+  std::atomic<qint64> value_;
+};
+
+class Gauge {
+ public:
+  Gauge() : value_(0) {}
+
+  void Set(qint64 value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(qint64 n) { value_.fetch_add(n, std::memory_order_relaxed); }
+  qint64 value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  Q_DISABLE_COPY(Gauge)
+  std::atomic<qint64> value_;
+};
+
+// Counts durations into buckets from 100us to 5s.
+class Histogram {
+ public:
+  static const int kBucketCount = 10;
+  // The upper bound of each bucket.  Longer durations only count towards
+  // count() and sum_usec().
+  static const qint64 kBucketBoundsUsec[kBucketCount];
+
+  Histogram();
+
+  void ObserveUsec(qint64 usec);
+
+  qint64 count() const { return count_.load(std::memory_order_relaxed); }
+  qint64 sum_usec() const { return sum_usec_.load(std::memory_order_relaxed); }
+  // How many durations were longer than the bucket before but no longer than
+  // kBucketBoundsUsec[bucket].
+  qint64 bucket(int bucket) const {
+    return buckets_[bucket].load(std::memory_order_relaxed);
+  }
+
+ private:
+  Q_DISABLE_COPY(Histogram)
+  std::atomic<qint64> buckets_[kBucketCount];
+  std::atomic<qint64> count_;
+  std::atomic<qint64> sum_usec_;
+};
+
+// Adds how long it lived to a histogram.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram* histogram) : histogram_(histogram) {
+    timer_.start();
+  }
+  ~ScopedTimer() { histogram_->ObserveUsec(timer_.nsecsElapsed() / 1000); }
+
+ private:
+  Q_DISABLE_COPY(ScopedTimer)
+  Histogram* histogram_;
+  QElapsedTimer timer_;
+};
+
+// Return the metric called name, making it if it's the first time.  Names
+// follow the Prometheus conventions: counters end in _total and histograms
+// in _seconds.  help is only used the first time.
+Counter* GetCounter(const QString& name, const QString& help);
+Gauge* GetGauge(const QString& name, const QString& help);
+Histogram* GetHistogram(const QString& name, const QString& help);
+
+// Every metric in the Prometheus text exposition format, sorted by name.
+QByteArray PrometheusText();
+
+// Every metric as plain text, for the debug console.
+QString ToString();
+
+}  // namespace metrics
+
+#endif  // METRICS_H
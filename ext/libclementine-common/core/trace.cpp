@@ -0,0 +1,169 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <vector>
+
+#include "core/logging.h"
+
+namespace trace {
+
+std::atomic<bool> sEnabled(false);
+
+namespace {
+
+struct Event {
+  QByteArray name_;
+  char phase_;
+  qint64 start_usec_;
+  qint64 duration_usec_;
+  int thread_;
+};
+
+QMutex sMutex;
+QString sPath;
+QElapsedTimer sTimer;
+std::vector<Event> sEvents;
+QHash<Qt::HANDLE, int> sThreadIds;
+QHash<int, QString> sThreadNames;
+
+qint64 NowUsec() { return sTimer.nsecsElapsed() / 1000; }
+
+// Small numbers are easier to read in the viewer than thread handles.  Call
+// with sMutex held.
+int CurrentThread() {
+  const Qt::HANDLE handle = QThread::currentThreadId();
+  auto it = sThreadIds.constFind(handle);
+  if (it != sThreadIds.constEnd()) return *it;
+
+  const int id = sThreadIds.count() + 1;
+  sThreadIds[handle] = id;
+
+  QString name = QThread::currentThread()->objectName();
+  if (name.isEmpty()) name = id == 1 ? "main" : QString("thread %1").arg(id);
+  sThreadNames[id] = name;
+  return id;
+}
+
+void AddEvent(const QByteArray& name, char phase, qint64 start_usec,
+              qint64 duration_usec) {
+  QMutexLocker l(&sMutex);
+  if (!IsEnabled()) return;
+  sEvents.push_back(
+      {name, phase, start_usec, duration_usec, CurrentThread()});
+}
+
+}  // namespace
+
+void Start(const QString& path) {
+  QMutexLocker l(&sMutex);
+  sPath = path;
+  sTimer.start();
+  sEnabled.store(true);
+}
+
+void Finish() {
+  std::vector<Event> events;
+  QHash<int, QString> thread_names;
+  QString path;
+  {
+    QMutexLocker l(&sMutex);
+    if (!IsEnabled()) return;
+    sEnabled.store(false);
+    events.swap(sEvents);
+    thread_names.swap(sThreadNames);
+    sThreadIds.clear();
+    path = sPath;
+  }
+
+  const qint64 pid = QCoreApplication::applicationPid();
+
+  QJsonArray json_events;
+  for (auto it = thread_names.constBegin(); it != thread_names.constEnd();
+       ++it) {
+    QJsonObject event;
+    event["name"] = "thread_name";
+    event["ph"] = "M";
+    event["pid"] = pid;
+    event["tid"] = it.key();
+    event["args"] = QJsonObject{{"name", it.value()}};
+    json_events << event;
+  }
+
+  for (const Event& e : events) {
+    QJsonObject event;
+    event["name"] = QString::fromUtf8(e.name_);
+    event["cat"] = "clementine";
+    event["ph"] = QString(QChar(e.phase_));
+    event["ts"] = e.start_usec_;
+    if (e.phase_ == 'X') {
+      event["dur"] = e.duration_usec_;
+    } else {
+      event["s"] = "p";
+    }
+    event["pid"] = pid;
+    event["tid"] = e.thread_;
+    json_events << event;
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = json_events;
+  root["displayTimeUnit"] = "ms";
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qLog(Warning) << "Couldn't write the trace to" << path << ":"
+                  << file.errorString();
+    return;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  qLog(Info) << "Wrote" << events.size() << "trace events to" << path;
+}
+
+void Instant(const QString& name) {
+  if (!IsEnabled()) return;
+  AddEvent(name.toUtf8(), 'i', NowUsec(), 0);
+}
+
+Scope::Scope(const char* name) : start_usec_(0) {
+  if (!IsEnabled()) return;
+  name_ = name;
+  start_usec_ = NowUsec();
+}
+
+Scope::Scope(const QString& name) : start_usec_(0) {
+  if (!IsEnabled()) return;
+  name_ = name.toUtf8();
+  start_usec_ = NowUsec();
+}
+
+Scope::~Scope() {
+  if (name_.isEmpty() || !IsEnabled()) return;
+  AddEvent(name_, 'X', start_usec_, NowUsec() - start_usec_);
+}
+
+}  // namespace trace
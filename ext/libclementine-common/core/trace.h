@@ -0,0 +1,74 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+// Records how long things take as events in the Chrome trace event format,
+// which chrome://tracing and ui.perfetto.dev can open.  Nothing is recorded
+// unless Start has been called, and a disabled TRACE_SCOPE costs one atomic
+// load.
+//
+//   void Database::UpdateDatabaseSchema(...) {
+//     TRACE_SCOPE("Database::UpdateDatabaseSchema");
+//     ...
+//   }
+#define TRACE_SCOPE(name) \
+  trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_CONCAT2(a, b) a##b
+
+namespace trace {
+
+extern std::atomic<bool> sEnabled;
+
+// Starts recording.  Event times are from now.
+void Start(const QString& path);
+inline bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+// Stops recording and writes the events to the file given to Start.  Does
+// nothing if it's already been called.
+void Finish();
+
+// Marks a point in time.
+void Instant(const QString& name);
+
+class Scope {
+ public:
+  explicit Scope(const char* name);
+  explicit Scope(const QString& name);
+  ~Scope();
+
+  // For when the name isn't known until the work's done.
+  void set_name(const QString& name) {
+    if (!name_.isEmpty()) name_ = name.toUtf8();
+  }
+
+ private:
+  Q_DISABLE_COPY(Scope)
+
+  // Empty if we weren't recording when the scope started.
+  QByteArray name_;
+  qint64 start_usec_;
+};
+
+}  // namespace trace
+
+#endif  // TRACE_H
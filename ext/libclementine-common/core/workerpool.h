@@ -20,14 +20,21 @@
 
 #include <QAtomicInt>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QHash>
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QMutex>
 #include <QObject>
 #include <QProcess>
 #include <QQueue>
+#include <QStringList>
 #include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <functional>
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
 #include <QRandomGenerator>
@@ -36,6 +43,7 @@
 #include "clementine-config.h"
 #include "core/closure.h"
 #include "core/logging.h"
+#include "core/metrics.h"
 
 // Base class containing signals and slots - required because moc doesn't do
 // templated objects.
@@ -45,16 +53,60 @@ class _WorkerPoolBase : public QObject {
  public:
   _WorkerPoolBase(QObject* parent = nullptr);
 
+  // Requests are sent strictly in this order, so that work somebody is
+  // waiting for isn't stuck behind a library scan.
+  enum Priority {
+    Priority_Interactive = 0,
+    Priority_Playback,
+    Priority_Background,
+
+    PriorityCount
+  };
+
+  struct WorkerStats {
+    qint64 pid_;
+    int in_flight_;
+    // What the requests in flight are working on, see SetDescribeRequest.
+    QStringList in_flight_requests_;
+    int handled_;
+    double handled_per_second_;
+    int restarts_;
+  };
+
+  struct Stats {
+    int queue_depth_[PriorityCount];
+    qint64 longest_wait_msec_;
+    int restarts_;
+    QList<WorkerStats> workers_;
+
+    // How long recent requests took from being sent to a worker to being
+    // answered.
+    qint64 latency_p50_msec_;
+    qint64 latency_p90_msec_;
+    qint64 latency_p99_msec_;
+    qint64 latency_max_msec_;
+  };
+
 signals:
   // Emitted when a worker failed to start.  This usually happens when the
   // worker wasn't found, or couldn't be executed.
   void WorkerFailedToStart();
 
+  // Emitted when a worker dies while it has requests.  in_flight is what
+  // those requests were working on, see SetDescribeRequest.
+  void WorkerCrashed(const QStringList& in_flight);
+
+  // Emitted when a worker process that had connected dies, before it's
+  // restarted, so that anything it left behind can be cleaned up.
+  void WorkerDied(qint64 pid);
+
  protected slots:
   virtual void DoStart() {}
   virtual void NewConnection() {}
   virtual void ProcessError(QProcess::ProcessError) {}
   virtual void SendQueuedMessages() {}
+  virtual void StopIdleWorkers() {}
+  virtual void RequestFinished(bool) {}
 };
 
 // Manages a pool of one or more external processes.  A local socket server is
@@ -62,6 +114,13 @@ signals:
 // argv[1].  The process is expected to connect back to the socket server, and
 // when it does a HandlerType is created for it.
 // Instances of HandlerType are created in the WorkerPool's thread.
+//
+// Only one process is started at first.  Each worker is given a few requests
+// at a time, and the rest wait in a queue for their priority.  A worker only
+// has one background request at a time, so other requests don't have to
+// wait behind more than one.  When that queue gets long, or
+// a request has waited too long, another process is started, up to the worker
+// count.  Processes that have been idle for a while are stopped again.
 template <typename HandlerType>
 class WorkerPool : public _WorkerPoolBase {
  public:
@@ -76,22 +135,37 @@ class WorkerPool : public _WorkerPoolBase {
   // Start().
   void SetExecutableName(const QString& executable_name);
 
-  // Sets the number of worker process to use.  Defaults to
+  // Sets the largest number of worker processes to use.  Defaults to
   // 1 <= (processors / 2) <= 2.
   void SetWorkerCount(int count);
 
+  // Sets a function that names what a request works on, for example the files
+  // it reads.  Those names are what WorkerCrashed reports and what stats()
+  // lists as in flight.
+  void SetDescribeRequest(
+      std::function<QStringList(const MessageType&)> describe);
+
   // Sets the prefix to use for the local server (on unix this is a named pipe
   // in /tmp).  Defaults to QApplication::applicationName().  A random number
   // is appended to this name when creating each server.
   void SetLocalServerName(const QString& local_server_name);
 
-  // Starts all workers.
+  // Exports the queue depth as the gauge prefix_queue_depth and how long
+  // requests take as the histogram prefix_request_seconds.
+  void SetMetricsPrefix(const QString& prefix);
+
+  // Starts the first worker.
   void Start();
 
   // Fills in the message's "id" field and creates a reply future.  The message
   // is queued and the WorkerPool's thread will send it to the next available
-  // worker.  Can be called from any thread.
-  ReplyType* SendMessageWithReply(MessageType* message);
+  // worker, after anything of a higher priority.  Can be called from any
+  // thread.
+  ReplyType* SendMessageWithReply(MessageType* message,
+                                  Priority priority = Priority_Interactive);
+
+  // Must be called from my thread.
+  Stats stats() const;
 
  protected:
   // These are all reimplemented slots, they are called on the WorkerPool's
@@ -100,6 +174,8 @@ class WorkerPool : public _WorkerPoolBase {
   void NewConnection();
   void ProcessError(QProcess::ProcessError error);
   void SendQueuedMessages();
+  void StopIdleWorkers();
+  void RequestFinished(bool success);
 
  private:
   struct Worker {
@@ -107,16 +183,80 @@ class WorkerPool : public _WorkerPoolBase {
         : local_server_(NULL),
           local_socket_(NULL),
           process_(NULL),
-          handler_(NULL) {}
+          handler_(NULL),
+          started_msec_(0),
+          last_active_msec_(0),
+          handled_(0),
+          restarts_(0),
+          pid_(0) {}
 
     QLocalServer* local_server_;
     QLocalSocket* local_socket_;
     QProcess* process_;
     HandlerType* handler_;
+
+    qint64 started_msec_;
+    qint64 last_active_msec_;
+    int handled_;
+    int restarts_;
+    // Kept from when the worker connected, since the process no longer has
+    // one once it's died.
+    qint64 pid_;
+  };
+
+  struct QueuedReply {
+    ReplyType* reply_;
+    qint64 queued_msec_;
   };
 
+  // A request that's been given to a worker.  Requests that are aborted
+  // because their worker went away are kept until the worker's process error
+  // has been handled, which can come after its socket has been closed.
+  struct InFlightRequest {
+    QProcess* process_;
+    Priority priority_;
+    qint64 sent_msec_;
+    QStringList description_;
+  };
+
+  // A worker isn't given any more requests while it has this many, or
+  // any more background requests while it has this many of those.
+  static const int kMaxRequestsPerWorker = 4;
+  static const int kMaxBackgroundRequestsPerWorker = 1;
+
+  // Another worker is started when this many requests are waiting, or when
+  // one has waited this long.
+  static const int kStartWorkerQueueDepth = 16;
+  static const int kStartWorkerWaitMsec = 250;
+
+  // Workers after the first are stopped when they've had nothing to do for
+  // this long.
+  static const int kIdleWorkerMsec = 60000;
+  static const int kStopIdleWorkersIntervalMsec = 10000;
+
+  // Latency percentiles are worked out over this many of the latest requests.
+  static const int kLatencySamples = 1000;
+
   // Must only ever be called on my thread.
   void StartOneWorker(Worker* worker);
+  void AddWorker();
+  void StopOneWorker(Worker* worker);
+
+  // Forgets the requests that were in flight on a worker's process, and
+  // returns what they were working on.
+  QStringList TakeInFlight(QProcess* process);
+  QStringList InFlight(QProcess* process) const;
+  int InFlightCount(QProcess* process, Priority priority) const;
+  qint64 LatencyPercentile(const QVector<qint64>& sorted, int percent) const;
+
+  // Starts another worker if the queues are backing up.  Must be called on my
+  // thread with message_queue_mutex_ held.
+  void MaybeAddWorker();
+
+  // The number of requests waiting and how long the oldest has been waiting.
+  // Must be called with message_queue_mutex_ held.
+  int QueuedCount() const;
+  qint64 LongestWaitMsec() const;
 
   template <typename T>
   Worker* FindWorker(T Worker::*member, T value) {
@@ -142,9 +282,9 @@ class WorkerPool : public _WorkerPoolBase {
   // thread
   ReplyType* NewReply(MessageType* message);
 
-  // Returns the next handler, or NULL if there isn't one.  Must be called from
-  // my thread.
-  HandlerType* NextHandler() const;
+  // Returns the next worker that has room for another request of this
+  // priority, or NULL if there isn't one.  Must be called from my thread.
+  Worker* NextWorker(Priority priority);
 
  private:
   QString local_server_name_;
@@ -152,19 +292,42 @@ class WorkerPool : public _WorkerPoolBase {
   QString executable_path_;
 
   int worker_count_;
-  mutable int next_worker_;
+  int next_worker_;
   QList<Worker> workers_;
+  int restarts_;
+  QTimer* stop_idle_workers_timer_;
+
+  std::function<QStringList(const MessageType&)> describe_request_;
+  QHash<int, InFlightRequest> in_flight_;
+  QVector<qint64> latencies_msec_;
+  int next_latency_;
+
+  metrics::Gauge* queue_depth_gauge_;
+  metrics::Histogram* latency_histogram_;
 
   QAtomicInt next_id_;
+  QElapsedTimer clock_;
 
   QMutex message_queue_mutex_;
-  QQueue<ReplyType*> message_queue_;
+  QQueue<QueuedReply> message_queues_[PriorityCount];
 };
 
 template <typename HandlerType>
 WorkerPool<HandlerType>::WorkerPool(QObject* parent)
-    : _WorkerPoolBase(parent), next_worker_(0), next_id_(0) {
+    : _WorkerPoolBase(parent),
+      next_worker_(0),
+      restarts_(0),
+      stop_idle_workers_timer_(new QTimer(this)),
+      next_latency_(0),
+      queue_depth_gauge_(nullptr),
+      latency_histogram_(nullptr),
+      next_id_(0) {
   worker_count_ = qBound(1, QThread::idealThreadCount() / 2, 2);
+  clock_.start();
+
+  stop_idle_workers_timer_->setInterval(kStopIdleWorkersIntervalMsec);
+  connect(stop_idle_workers_timer_, SIGNAL(timeout()),
+          SLOT(StopIdleWorkers()));
   local_server_name_ = qApp->applicationName().toLower();
 
   if (local_server_name_.isEmpty()) local_server_name_ = "workerpool";
@@ -193,8 +356,10 @@ WorkerPool<HandlerType>::~WorkerPool() {
     }
   }
 
-  for (ReplyType* reply : message_queue_) {
-    reply->Abort();
+  for (const QQueue<QueuedReply>& queue : message_queues_) {
+    for (const QueuedReply& queued : queue) {
+      queued.reply_->Abort();
+    }
   }
 }
 
@@ -204,6 +369,13 @@ void WorkerPool<HandlerType>::SetWorkerCount(int count) {
   worker_count_ = count;
 }
 
+template <typename HandlerType>
+void WorkerPool<HandlerType>::SetDescribeRequest(
+    std::function<QStringList(const MessageType&)> describe) {
+  Q_ASSERT(workers_.isEmpty());
+  describe_request_ = describe;
+}
+
 template <typename HandlerType>
 void WorkerPool<HandlerType>::SetLocalServerName(
     const QString& local_server_name) {
@@ -218,6 +390,16 @@ void WorkerPool<HandlerType>::SetExecutableName(
   executable_name_ = executable_name;
 }
 
+template <typename HandlerType>
+void WorkerPool<HandlerType>::SetMetricsPrefix(const QString& prefix) {
+  Q_ASSERT(workers_.isEmpty());
+  queue_depth_gauge_ = metrics::GetGauge(
+      prefix + "_queue_depth", "Requests waiting for a worker");
+  latency_histogram_ = metrics::GetHistogram(
+      prefix + "_request_seconds",
+      "How long requests took from being sent to a worker to being answered");
+}
+
 template <typename HandlerType>
 void WorkerPool<HandlerType>::Start() {
   metaObject()->invokeMethod(this, "DoStart");
@@ -246,13 +428,61 @@ void WorkerPool<HandlerType>::DoStart() {
     }
   }
 
-  // Start all the workers
-  for (int i = 0; i < worker_count_; ++i) {
-    Worker worker;
-    StartOneWorker(&worker);
+  // More workers are started later if they're needed.
+  AddWorker();
+  stop_idle_workers_timer_->start();
+}
+
+template <typename HandlerType>
+void WorkerPool<HandlerType>::AddWorker() {
+  Worker worker;
+  worker.started_msec_ = worker.last_active_msec_ = clock_.elapsed();
+  StartOneWorker(&worker);
+
+  workers_ << worker;
+}
+
+template <typename HandlerType>
+void WorkerPool<HandlerType>::StopOneWorker(Worker* worker) {
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  qLog(Debug) << "Stopping idle worker" << worker;
 
-    workers_ << worker;
+  // The worker exits when his socket is closed.
+  disconnect(worker->process_, SIGNAL(error(QProcess::ProcessError)), this,
+             SLOT(ProcessError(QProcess::ProcessError)));
+  connect(worker->process_, SIGNAL(finished(int, QProcess::ExitStatus)),
+          worker->process_, SLOT(deleteLater()));
+  worker->local_socket_->close();
+
+  DeleteQObjectPointerLater(&worker->handler_);
+  DeleteQObjectPointerLater(&worker->local_socket_);
+  TakeInFlight(worker->process_);
+  worker->process_ = NULL;
+}
+
+template <typename HandlerType>
+void WorkerPool<HandlerType>::StopIdleWorkers() {
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  const qint64 now = clock_.elapsed();
+
+  // The first worker is always kept.
+  for (int i = workers_.count() - 1; i > 0; --i) {
+    Worker* worker = &workers_[i];
+    if (!worker->handler_ || worker->handler_->is_device_closed()) continue;
+
+    if (worker->handler_->pending_requests()) {
+      worker->last_active_msec_ = now;
+      continue;
+    }
+    if (now - worker->last_active_msec_ < kIdleWorkerMsec) continue;
+
+    StopOneWorker(worker);
+    workers_.removeAt(i);
   }
+
+  next_worker_ %= workers_.count();
 }
 
 template <typename HandlerType>
@@ -313,6 +543,7 @@ void WorkerPool<HandlerType>::NewConnection() {
 
   // Accept the connection.
   worker->local_socket_ = server->nextPendingConnection();
+  worker->pid_ = worker->process_->processId();
 
   // We only ever accept one connection per worker, so destroy the server now.
   worker->local_socket_->setParent(this);
@@ -344,13 +575,87 @@ void WorkerPool<HandlerType>::ProcessError(QProcess::ProcessError error) {
       emit WorkerFailedToStart();
       break;
 
-    default:
+    default: {
       // On any other error we just restart the process.
-      qLog(Debug) << "Worker" << worker << "failed with error" << error
-                  << "- restarting";
+      const QStringList in_flight = TakeInFlight(process);
+      ++worker->restarts_;
+      ++restarts_;
+
+      if (in_flight.isEmpty()) {
+        qLog(Debug) << "Worker" << worker << "failed with error" << error
+                    << "- restarting";
+      } else {
+        qLog(Warning) << "Worker" << worker << "failed with error" << error
+                      << "while working on" << in_flight << "- restarting ("
+                      << restarts_ << "restarts so far)";
+        emit WorkerCrashed(in_flight);
+      }
+
+      if (worker->pid_) {
+        emit WorkerDied(worker->pid_);
+        worker->pid_ = 0;
+      }
       StartOneWorker(worker);
       break;
+    }
+  }
+}
+
+template <typename HandlerType>
+void WorkerPool<HandlerType>::RequestFinished(bool success) {
+  ReplyType* reply = static_cast<ReplyType*>(sender());
+
+  // Aborted requests are kept for ProcessError.
+  if (!success) return;
+
+  typename QHash<int, InFlightRequest>::iterator it =
+      in_flight_.find(reply->id());
+  if (it == in_flight_.end()) return;
+
+  const qint64 latency = clock_.elapsed() - it->sent_msec_;
+  in_flight_.erase(it);
+  if (latency_histogram_) latency_histogram_->ObserveUsec(latency * 1000);
+
+  if (latencies_msec_.count() < kLatencySamples) {
+    latencies_msec_ << latency;
+  } else {
+    latencies_msec_[next_latency_] = latency;
+    next_latency_ = (next_latency_ + 1) % kLatencySamples;
+  }
+}
+
+template <typename HandlerType>
+QStringList WorkerPool<HandlerType>::TakeInFlight(QProcess* process) {
+  QStringList ret;
+  for (typename QHash<int, InFlightRequest>::iterator it = in_flight_.begin();
+       it != in_flight_.end();) {
+    if (it->process_ == process) {
+      ret << it->description_;
+      it = in_flight_.erase(it);
+    } else {
+      ++it;
+    }
   }
+  return ret;
+}
+
+template <typename HandlerType>
+QStringList WorkerPool<HandlerType>::InFlight(QProcess* process) const {
+  QStringList ret;
+  for (const InFlightRequest& request : in_flight_) {
+    if (request.process_ == process) ret << request.description_;
+  }
+  return ret;
+}
+
+template <typename HandlerType>
+int WorkerPool<HandlerType>::InFlightCount(QProcess* process,
+                                           Priority priority) const {
+  int ret = 0;
+  for (const InFlightRequest& request : in_flight_) {
+    if (request.process_ == process && request.priority_ == priority) ++ret;
+  }
+  return ret;
 }
 
 template <typename HandlerType>
@@ -364,13 +669,16 @@ typename WorkerPool<HandlerType>::ReplyType* WorkerPool<HandlerType>::NewReply(
 
 template <typename HandlerType>
 typename WorkerPool<HandlerType>::ReplyType*
-WorkerPool<HandlerType>::SendMessageWithReply(MessageType* message) {
+WorkerPool<HandlerType>::SendMessageWithReply(MessageType* message,
+                                              Priority priority) {
   ReplyType* reply = NewReply(message);
 
   // Add the pending reply to the queue
   {
     QMutexLocker l(&message_queue_mutex_);
-    message_queue_.enqueue(reply);
+    QueuedReply queued = {reply, clock_.elapsed()};
+    message_queues_[priority].enqueue(queued);
+    if (queue_depth_gauge_) queue_depth_gauge_->Add(1);
   }
 
   // Wake up the main thread
@@ -383,35 +691,152 @@ template <typename HandlerType>
 void WorkerPool<HandlerType>::SendQueuedMessages() {
   QMutexLocker l(&message_queue_mutex_);
 
-  while (!message_queue_.isEmpty()) {
-    ReplyType* reply = message_queue_.dequeue();
+  for (int priority = 0; priority < PriorityCount; ++priority) {
+    QQueue<QueuedReply>* queue = &message_queues_[priority];
+
+    while (!queue->isEmpty()) {
+      // Find a worker for this message
+      Worker* worker = NextWorker(Priority(priority));
+      if (!worker) break;
+
+      ReplyType* reply = queue->dequeue().reply_;
+      if (queue_depth_gauge_) queue_depth_gauge_->Add(-1);
+
+      // Give the worker another request when he's finished this one.
+      connect(reply, SIGNAL(Finished(bool)), SLOT(SendQueuedMessages()),
+              Qt::QueuedConnection);
+      connect(reply, SIGNAL(Finished(bool)), SLOT(RequestFinished(bool)),
+              Qt::DirectConnection);
+
+      InFlightRequest in_flight;
+      in_flight.process_ = worker->process_;
+      in_flight.priority_ = Priority(priority);
+      in_flight.sent_msec_ = clock_.elapsed();
+      if (describe_request_) {
+        in_flight.description_ = describe_request_(reply->request_message());
+      }
+      in_flight_[reply->id()] = in_flight;
 
-    // Find a worker for this message
-    HandlerType* handler = NextHandler();
-    if (!handler) {
-      // No available handlers - put the message on the front of the queue.
-      message_queue_.prepend(reply);
-      qLog(Debug) << "No available handlers to process request";
-      break;
+      ++worker->handled_;
+      worker->last_active_msec_ = in_flight.sent_msec_;
+      worker->handler_->SendRequest(reply);
     }
+  }
+
+  MaybeAddWorker();
+}
+
+template <typename HandlerType>
+void WorkerPool<HandlerType>::MaybeAddWorker() {
+  const int queued_count = QueuedCount();
+  if (queued_count == 0 || workers_.count() >= worker_count_) return;
+
+  // Wait for the last worker we started to connect before starting another.
+  for (const Worker& worker : workers_) {
+    if (!worker.handler_) return;
+  }
+
+  const qint64 waited_msec = LongestWaitMsec();
+  if (queued_count < kStartWorkerQueueDepth &&
+      waited_msec < kStartWorkerWaitMsec) {
+    return;
+  }
+
+  qLog(Debug) << queued_count << "requests waiting, the oldest for"
+              << waited_msec << "ms - starting another worker";
+  AddWorker();
+}
+
+template <typename HandlerType>
+int WorkerPool<HandlerType>::QueuedCount() const {
+  int ret = 0;
+  for (const QQueue<QueuedReply>& queue : message_queues_) {
+    ret += queue.count();
+  }
+  return ret;
+}
+
+template <typename HandlerType>
+qint64 WorkerPool<HandlerType>::LongestWaitMsec() const {
+  const qint64 now = clock_.elapsed();
 
-    handler->SendRequest(reply);
+  qint64 ret = 0;
+  for (const QQueue<QueuedReply>& queue : message_queues_) {
+    if (!queue.isEmpty()) ret = qMax(ret, now - queue.head().queued_msec_);
   }
+  return ret;
 }
 
 template <typename HandlerType>
-HandlerType* WorkerPool<HandlerType>::NextHandler() const {
+typename WorkerPool<HandlerType>::Worker*
+WorkerPool<HandlerType>::NextWorker(Priority priority) {
   for (int i = 0; i < workers_.count(); ++i) {
     const int worker_index = (next_worker_ + i) % workers_.count();
+    Worker* worker = &workers_[worker_index];
 
-    if (workers_[worker_index].handler_ &&
-        !workers_[worker_index].handler_->is_device_closed()) {
-      next_worker_ = (worker_index + 1) % workers_.count();
-      return workers_[worker_index].handler_;
+    if (!worker->handler_ || worker->handler_->is_device_closed() ||
+        worker->handler_->pending_requests() >= kMaxRequestsPerWorker) {
+      continue;
     }
+    // Background requests are only limited by the other background requests,
+    // so a worker busy with interactive ones can still take one.
+    if (priority == Priority_Background &&
+        InFlightCount(worker->process_, Priority_Background) >=
+            kMaxBackgroundRequestsPerWorker) {
+      continue;
+    }
+
+    next_worker_ = (worker_index + 1) % workers_.count();
+    return worker;
   }
 
   return NULL;
 }
 
+template <typename HandlerType>
+_WorkerPoolBase::Stats WorkerPool<HandlerType>::stats() const {
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  const qint64 now = clock_.elapsed();
+
+  Stats ret;
+  ret.restarts_ = restarts_;
+  {
+    QMutexLocker l(const_cast<QMutex*>(&message_queue_mutex_));
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+      ret.queue_depth_[priority] = message_queues_[priority].count();
+    }
+    ret.longest_wait_msec_ = LongestWaitMsec();
+  }
+
+  QVector<qint64> latencies = latencies_msec_;
+  std::sort(latencies.begin(), latencies.end());
+  ret.latency_p50_msec_ = LatencyPercentile(latencies, 50);
+  ret.latency_p90_msec_ = LatencyPercentile(latencies, 90);
+  ret.latency_p99_msec_ = LatencyPercentile(latencies, 99);
+  ret.latency_max_msec_ = latencies.isEmpty() ? 0 : latencies.last();
+
+  for (const Worker& worker : workers_) {
+    WorkerStats worker_stats;
+    worker_stats.pid_ = worker.process_ ? worker.process_->processId() : 0;
+    worker_stats.in_flight_ =
+        worker.handler_ ? worker.handler_->pending_requests() : 0;
+    worker_stats.in_flight_requests_ = InFlight(worker.process_);
+    worker_stats.handled_ = worker.handled_;
+    worker_stats.handled_per_second_ =
+        worker.handled_ * 1000.0 / qMax(qint64(1), now - worker.started_msec_);
+    worker_stats.restarts_ = worker.restarts_;
+    ret.workers_ << worker_stats;
+  }
+
+  return ret;
+}
+
+template <typename HandlerType>
+qint64 WorkerPool<HandlerType>::LatencyPercentile(
+    const QVector<qint64>& sorted, int percent) const {
+  if (sorted.isEmpty()) return 0;
+  return sorted[(sorted.count() - 1) * percent / 100];
+}
+
 #endif  // WORKERPOOL_H
@@ -30,6 +30,10 @@
 namespace {
 static const int kTaglibPrefixCacheBytes = 64 * 1024;  // Should be enough.
 static const int kTaglibSuffixCacheBytes = 8 * 1024;
+
+// Reads that aren't cached already fetch at least this much, so TagLib's
+// walk through the frames of a tag doesn't make a request for each one.
+static const int kMinRequestBytes = 64 * 1024;
 }  // namespace
 
 CloudStream::CloudStream(const QUrl& url, const QString& filename,
@@ -42,7 +46,8 @@ CloudStream::CloudStream(const QUrl& url, const QString& filename,
       cursor_(0),
       network_(new QNetworkAccessManager),
       cache_(length),
-      num_requests_(0) {}
+      num_requests_(0),
+      bytes_fetched_(0) {}
 
 TagLib::FileName CloudStream::name() const { return encoded_filename_.data(); }
 
@@ -55,8 +60,9 @@ bool CloudStream::CheckCache(int start, int end) {
   return true;
 }
 
-void CloudStream::FillCache(int start, TagLib::ByteVector data) {
-  for (int i = 0; i < data.size(); ++i) {
+void CloudStream::FillCache(int start, const QByteArray& data) {
+  const int size = qMin(data.size(), int(length_) - start);
+  for (int i = 0; i < size; ++i) {
     cache_.set(start + i, data[i]);
   }
 }
@@ -80,15 +86,25 @@ void CloudStream::Precache() {
   // OGG Vorbis may read the last 4KB.
   //
   // So, if we precache the first 64KB and the last 8KB we should be sorted :-)
-  // Ideally, we would use bytes=0-655364,-8096 but Google Drive does not seem
-  // to support multipart byte ranges yet so we have to make do with two
-  // requests.
-
-  seek(0, TagLib::IOStream::Beginning);
-  readBlock(kTaglibPrefixCacheBytes);
-  seek(kTaglibSuffixCacheBytes, TagLib::IOStream::End);
-  readBlock(kTaglibSuffixCacheBytes);
-  clear();
+  // The end is where ID3v1 and APE tags are.  Ideally, we would use
+  // bytes=0-655364,-8096 but Google Drive does not seem to support multipart
+  // byte ranges yet so we have to make do with two requests, which are made
+  // at the same time.
+  if (length_ == 0) return;
+
+  const int prefix_end = qMin(ulong(kTaglibPrefixCacheBytes), length_) - 1;
+  const int suffix_start =
+      qMax(0L, long(length_) - kTaglibSuffixCacheBytes);
+
+  if (suffix_start <= prefix_end + 1) {
+    FinishRequest(StartRequest(0, length_ - 1), 0);
+    return;
+  }
+
+  QNetworkReply* prefix = StartRequest(0, prefix_end);
+  QNetworkReply* suffix = StartRequest(suffix_start, length_ - 1);
+  FinishRequest(prefix, 0);
+  FinishRequest(suffix, suffix_start);
 }
 
 TagLib::ByteVector CloudStream::readBlock(size_t length) {
@@ -99,12 +115,37 @@ TagLib::ByteVector CloudStream::readBlock(size_t length) {
     return TagLib::ByteVector();
   }
 
-  if (CheckCache(start, end)) {
-    TagLib::ByteVector cached = GetCached(start, end);
-    cursor_ += cached.size();
-    return cached;
+  if (!CheckCache(start, end)) {
+    // Fetch everything from the first byte we don't have to the last in one
+    // request, and at least a chunk of it.
+    uint fetch_start = start;
+    while (cache_.test(fetch_start)) ++fetch_start;
+    uint fetch_end = end;
+    while (cache_.test(fetch_end)) --fetch_end;
+
+    fetch_end = qMax(fetch_end,
+                     uint(qMin(ulong(fetch_start + kMinRequestBytes),
+                               length_)) - 1);
+    while (fetch_end > fetch_start && cache_.test(fetch_end)) --fetch_end;
+
+    if (!FinishRequest(StartRequest(fetch_start, fetch_end), fetch_start)) {
+      return TagLib::ByteVector();
+    }
+  }
+
+  // The server might have sent less than we asked for.
+  uint cached_end = start;
+  while (cached_end <= end && cache_.test(cached_end)) ++cached_end;
+  if (cached_end == start) {
+    return TagLib::ByteVector();
   }
 
+  TagLib::ByteVector cached = GetCached(start, cached_end - 1);
+  cursor_ += cached.size();
+  return cached;
+}
+
+QNetworkReply* CloudStream::StartRequest(int start, int end) {
   QNetworkRequest request = QNetworkRequest(url_);
   if (!auth_.isEmpty()) {
     request.setRawHeader("Authorization", auth_.toUtf8());
@@ -120,24 +161,28 @@ TagLib::ByteVector CloudStream::readBlock(size_t length) {
   connect(reply, SIGNAL(sslErrors(QList<QSslError>)),
           SLOT(SSLErrors(QList<QSslError>)));
   ++num_requests_;
+  return reply;
+}
 
-  QEventLoop loop;
-  QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
-  loop.exec();
+bool CloudStream::FinishRequest(QNetworkReply* reply, int start) {
+  if (!reply->isFinished()) {
+    QEventLoop loop;
+    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+    loop.exec();
+  }
   reply->deleteLater();
 
   int code = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
   if (code >= 400) {
     qLog(Debug) << "Error retrieving url to tag:" << url_;
-    return TagLib::ByteVector();
+    return false;
   }
 
   QByteArray data = reply->readAll();
-  TagLib::ByteVector bytes(data.data(), data.size());
-  cursor_ += data.size();
+  bytes_fetched_ += data.size();
 
-  FillCache(start, bytes);
-  return bytes;
+  FillCache(start, data);
+  return true;
 }
 
 void CloudStream::writeBlock(const TagLib::ByteVector&) {
@@ -27,6 +27,11 @@
 #include <google/sparsetable>
 #include <taglib/tiostream.h>
 
+class QNetworkReply;
+
+// Reads a file from a cloud service with HTTP range requests.  TagLib makes
+// lots of small reads, so each request is rounded up to a chunk and the bytes
+// already fetched are remembered.
 class CloudStream : public QObject, public TagLib::IOStream {
   Q_OBJECT
  public:
@@ -52,15 +57,22 @@ class CloudStream : public QObject, public TagLib::IOStream {
   }
 
   int num_requests() const { return num_requests_; }
+  qint64 bytes_fetched() const { return bytes_fetched_; }
 
   // Use educated guess to request the bytes that TagLib will probably want.
   void Precache();
 
  private:
   bool CheckCache(int start, int end);
-  void FillCache(int start, TagLib::ByteVector data);
+  void FillCache(int start, const QByteArray& data);
   TagLib::ByteVector GetCached(int start, int end);
 
+  // Starts fetching the bytes from start to end inclusive.
+  QNetworkReply* StartRequest(int start, int end);
+  // Waits for the reply and puts what it got in the cache.  Returns false on
+  // error.
+  bool FinishRequest(QNetworkReply* reply, int start);
+
  private slots:
   void SSLErrors(const QList<QSslError>& errors);
 
@@ -76,6 +88,7 @@ class CloudStream : public QObject, public TagLib::IOStream {
 
   google::sparsetable<char> cache_;
   int num_requests_;
+  qint64 bytes_fetched_;
 };
 
 #endif  // GOOGLEDRIVESTREAM_H
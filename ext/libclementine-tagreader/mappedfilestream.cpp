@@ -0,0 +1,103 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mappedfilestream.h"
+
+#include "core/logging.h"
+
+MappedFileStream::MappedFileStream(const QString& filename)
+    : file_(filename),
+#ifdef Q_OS_WIN32
+      name_(filename.toStdWString()),
+#else
+      name_(QFile::encodeName(filename)),
+#endif
+      data_(nullptr),
+      size_(0),
+      cursor_(0) {
+  if (!file_.open(QIODevice::ReadOnly)) return;
+
+  size_ = file_.size();
+  if (size_ > 0) {
+    data_ = reinterpret_cast<const char*>(file_.map(0, size_));
+  }
+  if (!data_) size_ = 0;
+}
+
+MappedFileStream::~MappedFileStream() {
+  if (data_) file_.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data_)));
+}
+
+TagLib::FileName MappedFileStream::name() const {
+#ifdef Q_OS_WIN32
+  return name_.c_str();
+#else
+  return name_.constData();
+#endif
+}
+
+TagLib::ByteVector MappedFileStream::readBlock(size_t length) {
+  if (cursor_ >= size_) return TagLib::ByteVector();
+
+  const qint64 count = qMin(qint64(length), size_ - cursor_);
+  TagLib::ByteVector ret(data_ + cursor_, count);
+  cursor_ += count;
+  return ret;
+}
+
+void MappedFileStream::writeBlock(const TagLib::ByteVector&) {
+  qLog(Debug) << Q_FUNC_INFO << "not implemented";
+}
+
+void MappedFileStream::insert(const TagLib::ByteVector&, TagLib::offset_t,
+                              size_t) {
+  qLog(Debug) << Q_FUNC_INFO << "not implemented";
+}
+
+void MappedFileStream::removeBlock(TagLib::offset_t, size_t) {
+  qLog(Debug) << Q_FUNC_INFO << "not implemented";
+}
+
+bool MappedFileStream::readOnly() const { return true; }
+
+bool MappedFileStream::isOpen() const { return data_ != nullptr; }
+
+void MappedFileStream::seek(TagLib::offset_t offset,
+                            TagLib::IOStream::Position p) {
+  switch (p) {
+    case TagLib::IOStream::Beginning:
+      cursor_ = offset;
+      break;
+
+    case TagLib::IOStream::Current:
+      cursor_ += offset;
+      break;
+
+    case TagLib::IOStream::End:
+      cursor_ = size_ + offset;
+      break;
+  }
+  cursor_ = qMax(qint64(0), cursor_);
+}
+
+TagLib::offset_t MappedFileStream::tell() const { return cursor_; }
+
+TagLib::offset_t MappedFileStream::length() { return size_; }
+
+void MappedFileStream::truncate(TagLib::offset_t) {
+  qLog(Debug) << Q_FUNC_INFO << "not implemented";
+}
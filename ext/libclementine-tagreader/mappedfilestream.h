@@ -0,0 +1,60 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPEDFILESTREAM_H
+#define MAPPEDFILESTREAM_H
+
+#include <taglib/tiostream.h>
+
+#include <QFile>
+#include <string>
+
+// A read only TagLib stream over a file mapped into memory, so TagLib's many
+// small reads and seeks don't each go through stdio.  isOpen() is false if
+// the file couldn't be mapped.
+class MappedFileStream : public TagLib::IOStream {
+ public:
+  explicit MappedFileStream(const QString& filename);
+  ~MappedFileStream();
+
+  // TagLib::IOStream
+  TagLib::FileName name() const;
+  TagLib::ByteVector readBlock(size_t length);
+  void writeBlock(const TagLib::ByteVector&);
+  void insert(const TagLib::ByteVector&, TagLib::offset_t, size_t);
+  void removeBlock(TagLib::offset_t, size_t);
+  bool readOnly() const;
+  bool isOpen() const;
+  void seek(TagLib::offset_t offset, TagLib::IOStream::Position p);
+  TagLib::offset_t tell() const;
+  TagLib::offset_t length();
+  void truncate(TagLib::offset_t);
+
+ private:
+  QFile file_;
+#ifdef Q_OS_WIN32
+  const std::wstring name_;
+#else
+  const QByteArray name_;
+#endif
+
+  const char* data_;
+  qint64 size_;
+  qint64 cursor_;
+};
+
+#endif  // MAPPEDFILESTREAM_H
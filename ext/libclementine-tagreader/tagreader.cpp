@@ -34,6 +34,7 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QFileInfo>
+#include <QStringList>
 #include <QTextCodec>
 #include <QUrl>
 #include <QVector>
@@ -61,6 +62,7 @@
 #include "core/timeconstants.h"
 #include "fmpsparser.h"
 #include "gmereader.h"
+#include "mappedfilestream.h"
 
 // Taglib added support for FLAC pictures in 1.7.0
 #if (TAGLIB_MAJOR_VERSION > 1) || \
@@ -120,19 +122,32 @@ const char* TagReader::kMP4_FMPS_Playcount_ID =
 const char* TagReader::kMP4_FMPS_Score_ID =
     "----:com.apple.iTunes:FMPS_Rating_Amarok_Score";
 
+const int TagReader::kMaxSharedMemorySegments = 8;
+
+QString TagReader::SharedMemoryKey(qint64 pid, int slot) {
+  return QString("clementine-tagreader-%1-%2").arg(pid).arg(slot);
+}
+
 namespace {
 // Tags containing the year the album was originally released (in contrast to
 // other tags that contain the release year of the current edition)
 const char* kMP4_OriginalYear_ID = "----:com.apple.iTunes:ORIGINAL YEAR";
 const char* kASF_OriginalDate_ID = "WM/OriginalReleaseTime";
 const char* kASF_OriginalYear_ID = "WM/OriginalReleaseYear";
+
+// The same names are used by every format, only MP4 puts them in lower case
+// after a prefix.
+const char* kReplayGainTags[] = {
+    "REPLAYGAIN_TRACK_GAIN", "REPLAYGAIN_TRACK_PEAK", "REPLAYGAIN_ALBUM_GAIN",
+    "REPLAYGAIN_ALBUM_PEAK"};
+const char* kMP4_ReplayGain_Prefix = "----:com.apple.iTunes:";
 }  // namespace
 
 TagReader::TagReader()
     : factory_(new TagLibFileRefFactory), kEmbeddedCover("(embedded)") {}
 
 void TagReader::ReadFile(const QString& filename,
-                         cpb::tagreader::SongMetadata* song) const {
+                         cpb::tagreader::SongMetadata* song, bool fast) const {
   const QByteArray url(QUrl::fromLocalFile(filename).toEncoded());
   const QFileInfo info(filename);
 
@@ -168,7 +183,18 @@ void TagReader::ReadFile(const QString& filename,
               << "size=" << info.size() << "; mtime=" << mtime
               << "; birthtime=" << btime;
 
-  std::unique_ptr<TagLib::FileRef> fileref(factory_->GetFileRef(filename));
+  // The stream has to outlive the FileRef.
+  std::unique_ptr<MappedFileStream> stream;
+  std::unique_ptr<TagLib::FileRef> fileref;
+  if (fast) {
+    stream.reset(new MappedFileStream(filename));
+    if (stream->isOpen()) {
+      fileref.reset(new TagLib::FileRef(stream.get(), true,
+                                        TagLib::AudioProperties::Fast));
+    }
+  }
+  if (!fileref) fileref.reset(factory_->GetFileRef(filename));
+
   if (fileref->isNull()) {
     qLog(Info) << "TagLib hasn't been able to read " << filename << " file";
 
@@ -247,6 +273,13 @@ void TagReader::ReadFile(const QString& filename,
              song->mutable_performer());
     }
 
+    for (const char* name : kReplayGainTags) {
+      if (items.contains(name)) {
+        ParseReplayGainTag(name, TStringToQString(items[name].toString()),
+                           song);
+      }
+    }
+
     if (items.contains("PERFORMER")) {
       Decode(items["PERFORMER"].values().toString(", "), nullptr,
              song->mutable_performer());
@@ -262,7 +295,7 @@ void TagReader::ReadFile(const QString& filename,
              song->mutable_grouping());
     }
 
-    if (items.contains("LYRICS")) {
+    if (!fast && items.contains("LYRICS")) {
       Decode(items["LYRICS"].toString(), nullptr, song->mutable_lyrics());
     }
 
@@ -324,7 +357,9 @@ void TagReader::ReadFile(const QString& filename,
             map["TORY"].front()->toString().substr(0, 4).toInt());
       }
 
-      if (!map["USLT"].isEmpty()) {
+      if (fast) {
+        // Lyrics can be big, and aren't needed.
+      } else if (!map["USLT"].isEmpty()) {
         Decode(map["USLT"].front()->toString(), nullptr,
                song->mutable_lyrics());
       } else if (!map["SYLT"].isEmpty()) {
@@ -354,6 +389,10 @@ void TagReader::ReadFile(const QString& filename,
         if (frame && frame->description().startsWith("FMPS_")) {
           ParseFMPSFrame(TStringToQString(frame->description()),
                          TStringToQString(frame->fieldList()[1]), song);
+        } else if (frame &&
+                   frame->description().upper().startsWith("REPLAYGAIN_")) {
+          ParseReplayGainTag(TStringToQString(frame->description()),
+                             TStringToQString(frame->fieldList()[1]), song);
         }
       }
 
@@ -450,7 +489,7 @@ void TagReader::ReadFile(const QString& filename,
                song->mutable_grouping());
       }
       item = mp4_tag->item("\251lyr");
-      if (item.isValid()) {
+      if (!fast && item.isValid()) {
         Decode(item.toStringList().toString(" "), nullptr,
                song->mutable_lyrics());
       }
@@ -463,6 +502,16 @@ void TagReader::ReadFile(const QString& filename,
                 .toInt());
       }
 
+      for (const char* name : kReplayGainTags) {
+        item = mp4_tag->item(QStringToTaglibString(
+            kMP4_ReplayGain_Prefix + QString(name).toLower()));
+        if (item.isValid()) {
+          ParseReplayGainTag(
+              name, TStringToQString(item.toStringList().toString('\n')),
+              song);
+        }
+      }
+
       Decode(mp4_tag->comment(), nullptr, song->mutable_comment());
     }
   } else if (TagLib::APE::File* file =
@@ -653,6 +702,25 @@ void TagReader::ParseFMPSFrame(const QString& name, const QString& value,
   }
 }
 
+void TagReader::ParseReplayGainTag(const QString& name, const QString& value,
+                                   cpb::tagreader::SongMetadata* song) const {
+  // Gains are written like "-6.48 dB", peaks are plain numbers.
+  bool ok = false;
+  const float number = value.trimmed().section(' ', 0, 0).toFloat(&ok);
+  if (!ok) return;
+
+  const QString upper = name.toUpper();
+  if (upper == "REPLAYGAIN_TRACK_GAIN") {
+    song->set_replaygain_track_gain(number);
+  } else if (upper == "REPLAYGAIN_TRACK_PEAK") {
+    song->set_replaygain_track_peak(number);
+  } else if (upper == "REPLAYGAIN_ALBUM_GAIN") {
+    song->set_replaygain_album_gain(number);
+  } else if (upper == "REPLAYGAIN_ALBUM_PEAK") {
+    song->set_replaygain_album_peak(number);
+  }
+}
+
 void TagReader::ParseOggTag(const TagLib::Ogg::FieldListMap& map,
                             const QTextCodec* codec, QString* disc,
                             QString* compilation,
@@ -709,6 +777,11 @@ void TagReader::ParseOggTag(const TagLib::Ogg::FieldListMap& map,
     Decode(map["LYRICS"].front(), codec, song->mutable_lyrics());
   else if (!map["UNSYNCEDLYRICS"].isEmpty())
     Decode(map["UNSYNCEDLYRICS"].front(), codec, song->mutable_lyrics());
+
+  for (const char* name : kReplayGainTags) {
+    if (!map[name].isEmpty())
+      ParseReplayGainTag(name, TStringToQString(map[name].front()), song);
+  }
 }
 
 void TagReader::SetVorbisComments(
@@ -926,16 +999,88 @@ bool TagReader::SaveFile(const QString& filename,
 }
 
 bool TagReader::SaveSongStatisticsToFile(
-    const QString& filename, const cpb::tagreader::SongMetadata& song) const {
+    const QString& filename, const cpb::tagreader::SongMetadata& song,
+    bool include_rating) const {
   if (filename.isNull()) return false;
 
   qLog(Debug) << "Saving song statistics tags to" << filename;
 
+  return SaveFMPSTags(filename, song, true, include_rating);
+}
+
+bool TagReader::SaveSongRatingToFile(
+    const QString& filename, const cpb::tagreader::SongMetadata& song) const {
+  if (filename.isNull()) return false;
+
+  qLog(Debug) << "Saving song rating tags to" << filename;
+
+  return SaveFMPSTags(filename, song, false, true);
+}
+
+bool TagReader::SaveReplayGainToFile(
+    const QString& filename, const cpb::tagreader::SongMetadata& song) const {
+  if (filename.isNull()) return false;
+  if (!song.has_replaygain_track_gain()) return true;
+
+  qLog(Debug) << "Saving ReplayGain tags to" << filename;
+
   std::unique_ptr<TagLib::FileRef> fileref(factory_->GetFileRef(filename));
 
   if (!fileref || fileref->isNull())  // The file probably doesn't exist
     return false;
 
+  if (!SetReplayGain(fileref.get(), song)) return true;
+
+  bool ret = fileref->save();
+#ifdef Q_OS_LINUX
+  if (ret) {
+    // Linux: inotify doesn't seem to notice the change to the file unless we
+    // change the timestamps as well. (this is what touch does)
+    utimensat(0, QFile::encodeName(filename).constData(), nullptr, 0);
+  }
+#endif  // Q_OS_LINUX
+  return ret;
+}
+
+bool TagReader::SaveFMPSTags(const QString& filename,
+                             const cpb::tagreader::SongMetadata& song,
+                             bool statistics, bool rating) const {
+  if (rating && song.rating() < 0) {
+    // The FMPS spec says unrated == "tag not present". For us, no rating
+    // results in rating being -1, so don't write anything in that case.
+    // Actually, we should also remove tag set in this case, but in
+    // Clementine it is not possible to unset rating i.e. make a song "unrated".
+    qLog(Debug) << "Unrated: not saving the rating";
+    rating = false;
+  }
+  if (!statistics && !rating) return true;
+
+  std::unique_ptr<TagLib::FileRef> fileref(factory_->GetFileRef(filename));
+
+  if (!fileref || fileref->isNull())  // The file probably doesn't exist
+    return false;
+
+  // Both go in the same save, so the file is only rewritten once.
+  bool changed = false;
+  if (statistics) changed |= SetSongStatistics(fileref.get(), song);
+  if (rating) changed |= SetSongRating(fileref.get(), song);
+
+  // Nothing to save: stop now
+  if (!changed) return true;
+
+  bool ret = fileref->save();
+#ifdef Q_OS_LINUX
+  if (ret) {
+    // Linux: inotify doesn't seem to notice the change to the file unless we
+    // change the timestamps as well. (this is what touch does)
+    utimensat(0, QFile::encodeName(filename).constData(), nullptr, 0);
+  }
+#endif  // Q_OS_LINUX
+  return ret;
+}
+
+bool TagReader::SetSongStatistics(
+    TagLib::FileRef* fileref, const cpb::tagreader::SongMetadata& song) const {
   auto saveApeSongStats = [&](TagLib::APE::Tag* tag) {
     if (song.score())
       tag->setItem(
@@ -1008,40 +1153,13 @@ bool TagReader::SaveSongStatisticsToFile(
                  dynamic_cast<TagLib::WavPack::File*>(fileref->file())) {
     saveApeSongStats(file->APETag(true));
   } else {
-    // Nothing to save: stop now
-    return true;
-  }
-
-  bool ret = fileref->save();
-#ifdef Q_OS_LINUX
-  if (ret) {
-    // Linux: inotify doesn't seem to notice the change to the file unless we
-    // change the timestamps as well. (this is what touch does)
-    utimensat(0, QFile::encodeName(filename).constData(), nullptr, 0);
+    return false;
   }
-#endif  // Q_OS_LINUX
-  return ret;
+  return true;
 }
 
-bool TagReader::SaveSongRatingToFile(
-    const QString& filename, const cpb::tagreader::SongMetadata& song) const {
-  if (filename.isNull()) return false;
-
-  qLog(Debug) << "Saving song rating tags to" << filename;
-  if (song.rating() < 0) {
-    // The FMPS spec says unrated == "tag not present". For us, no rating
-    // results in rating being -1, so don't write anything in that case.
-    // Actually, we should also remove tag set in this case, but in
-    // Clementine it is not possible to unset rating i.e. make a song "unrated".
-    qLog(Debug) << "Unrated: do nothing";
-    return true;
-  }
-
-  std::unique_ptr<TagLib::FileRef> fileref(factory_->GetFileRef(filename));
-
-  if (!fileref || fileref->isNull())  // The file probably doesn't exist
-    return false;
-
+bool TagReader::SetSongRating(TagLib::FileRef* fileref,
+                              const cpb::tagreader::SongMetadata& song) const {
   auto saveApeSongRating = [&](TagLib::APE::Tag* tag) {
     tag->setItem("FMPS_Rating",
                  TagLib::APE::Item("FMPS_Rating",
@@ -1091,19 +1209,79 @@ bool TagReader::SaveSongRatingToFile(
                  dynamic_cast<TagLib::WavPack::File*>(fileref->file())) {
     saveApeSongRating(file->APETag(true));
   } else {
-    // Nothing to save: stop now
-    return true;
+    return false;
   }
+  return true;
+}
 
-  bool ret = fileref->save();
-#ifdef Q_OS_LINUX
-  if (ret) {
-    // Linux: inotify doesn't seem to notice the change to the file unless we
-    // change the timestamps as well. (this is what touch does)
-    utimensat(0, QFile::encodeName(filename).constData(), nullptr, 0);
+bool TagReader::SetReplayGain(TagLib::FileRef* fileref,
+                              const cpb::tagreader::SongMetadata& song) const {
+  // In the same order as kReplayGainTags.
+  QStringList values;
+  values << (song.has_replaygain_track_gain()
+                 ? QString::asprintf("%+.2f dB", song.replaygain_track_gain())
+                 : QString())
+         << (song.has_replaygain_track_peak()
+                 ? QString::asprintf("%.6f", song.replaygain_track_peak())
+                 : QString())
+         << (song.has_replaygain_album_gain()
+                 ? QString::asprintf("%+.2f dB", song.replaygain_album_gain())
+                 : QString())
+         << (song.has_replaygain_album_peak()
+                 ? QString::asprintf("%.6f", song.replaygain_album_peak())
+                 : QString());
+
+  auto saveApeReplayGain = [&](TagLib::APE::Tag* tag) {
+    for (int i = 0; i < values.count(); ++i) {
+      if (values[i].isEmpty()) continue;
+      tag->addValue(kReplayGainTags[i], QStringToTaglibString(values[i]),
+                    true);
+    }
+  };
+  auto saveXiphReplayGain = [&](TagLib::Ogg::XiphComment* tag) {
+    for (int i = 0; i < values.count(); ++i) {
+      if (values[i].isEmpty()) continue;
+      tag->addField(kReplayGainTags[i], QStringToTaglibString(values[i]),
+                    true);
+    }
+  };
+
+  if (TagLib::MPEG::File* file =
+          dynamic_cast<TagLib::MPEG::File*>(fileref->file())) {
+    TagLib::ID3v2::Tag* tag = file->ID3v2Tag(true);
+    for (int i = 0; i < values.count(); ++i) {
+      if (values[i].isEmpty()) continue;
+      SetUserTextFrame(QString(kReplayGainTags[i]), values[i], tag);
+    }
+  } else if (TagLib::FLAC::File* file =
+                 dynamic_cast<TagLib::FLAC::File*>(fileref->file())) {
+    saveXiphReplayGain(file->xiphComment(true));
+  } else if (TagLib::Ogg::XiphComment* tag =
+                 dynamic_cast<TagLib::Ogg::XiphComment*>(
+                     fileref->file()->tag())) {
+    saveXiphReplayGain(tag);
+  } else if (TagLib::MP4::File* file =
+                 dynamic_cast<TagLib::MP4::File*>(fileref->file())) {
+    TagLib::MP4::Tag* tag = file->tag();
+    for (int i = 0; i < values.count(); ++i) {
+      if (values[i].isEmpty()) continue;
+      tag->setItem(QStringToTaglibString(kMP4_ReplayGain_Prefix +
+                                         QString(kReplayGainTags[i]).toLower()),
+                   TagLib::StringList(QStringToTaglibString(values[i])));
+    }
+  } else if (TagLib::APE::File* file =
+                 dynamic_cast<TagLib::APE::File*>(fileref->file())) {
+    saveApeReplayGain(file->APETag(true));
+  } else if (TagLib::MPC::File* file =
+                 dynamic_cast<TagLib::MPC::File*>(fileref->file())) {
+    saveApeReplayGain(file->APETag(true));
+  } else if (TagLib::WavPack::File* file =
+                 dynamic_cast<TagLib::WavPack::File*>(fileref->file())) {
+    saveApeReplayGain(file->APETag(true));
+  } else {
+    return false;
   }
-#endif  // Q_OS_LINUX
-  return ret;
+  return true;
 }
 
 void TagReader::SetUserTextFrame(const QString& description,
@@ -1409,6 +1587,8 @@ bool TagReader::ReadCloudFile(const QUrl& download_url, const QString& title,
     return false;
   }
 
+  qLog(Debug) << "Fetched" << stream->bytes_fetched() << "bytes of" << title
+              << "in" << stream->num_requests() << "requests";
   if (stream->num_requests() > 2) {
     // Warn if pre-caching failed.
     qLog(Warning) << "Total requests for file:" << title
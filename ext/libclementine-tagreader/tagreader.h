@@ -56,17 +56,33 @@ class TagReader {
  public:
   TagReader();
 
-  void ReadFile(const QString& filename,
-                cpb::tagreader::SongMetadata* song) const;
+  // A worker shares big images through at most this many shared memory
+  // segments at once.  Their keys are made from the worker's pid and a slot
+  // that's reused, so the segments of a worker that crashed can be found and
+  // freed.
+  static const int kMaxSharedMemorySegments;
+  static QString SharedMemoryKey(qint64 pid, int slot);
+
+  // If fast is set the file is read through a memory map, audio properties
+  // are read at ReadStyle::Fast and lyrics are left out.  That's enough to
+  // tell whether the tags have changed, but not to replace them.
+  void ReadFile(const QString& filename, cpb::tagreader::SongMetadata* song,
+                bool fast = false) const;
   bool SaveFile(const QString& filename,
                 const cpb::tagreader::SongMetadata& song) const;
   // Returns false if something went wrong; returns true otherwise (might
   // returns true if the file exists but nothing has been written inside because
-  // statistics tag format is not supported for this kind of file)
+  // statistics tag format is not supported for this kind of file).  If
+  // include_rating is set the rating is saved too, in the same write.
   bool SaveSongStatisticsToFile(const QString& filename,
-                                const cpb::tagreader::SongMetadata& song) const;
+                                const cpb::tagreader::SongMetadata& song,
+                                bool include_rating = false) const;
   bool SaveSongRatingToFile(const QString& filename,
                             const cpb::tagreader::SongMetadata& song) const;
+  // Writes whichever ReplayGain values song has.  Like the statistics, returns
+  // true without writing anything if the format isn't supported.
+  bool SaveReplayGainToFile(const QString& filename,
+                            const cpb::tagreader::SongMetadata& song) const;
 
   bool IsMediaFile(const QString& filename) const;
   QByteArray LoadEmbeddedArt(const QString& filename) const;
@@ -84,6 +100,8 @@ class TagReader {
 
   void ParseFMPSFrame(const QString& name, const QString& value,
                       cpb::tagreader::SongMetadata* song) const;
+  void ParseReplayGainTag(const QString& name, const QString& value,
+                          cpb::tagreader::SongMetadata* song) const;
   void ParseOggTag(const TagLib::Ogg::FieldListMap& map,
                    const QTextCodec* codec, QString* disc, QString* compilation,
                    cpb::tagreader::SongMetadata* song) const;
@@ -127,6 +145,18 @@ class TagReader {
   static TagLib::ID3v2::PopularimeterFrame* GetPOPMFrameFromTag(
       TagLib::ID3v2::Tag* tag);
 
+  bool SaveFMPSTags(const QString& filename,
+                    const cpb::tagreader::SongMetadata& song, bool statistics,
+                    bool rating) const;
+  // These set the tags without saving the file.  They return false if the
+  // file's format has nowhere to put them.
+  bool SetSongStatistics(TagLib::FileRef* fileref,
+                         const cpb::tagreader::SongMetadata& song) const;
+  bool SetSongRating(TagLib::FileRef* fileref,
+                     const cpb::tagreader::SongMetadata& song) const;
+  bool SetReplayGain(TagLib::FileRef* fileref,
+                     const cpb::tagreader::SongMetadata& song) const;
+
   std::unique_ptr<FileRefFactory> factory_;
 
   const std::string kEmbeddedCover;
@@ -0,0 +1,257 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dspprocessor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+const float DspProcessor::kBandFrequencies[] = {
+    60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000};
+
+namespace {
+
+// Bands at less than this many dB are left out.
+const float kMinGain = 0.01f;
+
+// Bands this close to the Nyquist frequency can't be made into a filter.
+const double kMaxFrequencyOfRate = 0.45;
+
+// Once silence starts the filters' history decays towards denormals, which
+// are very slow on x86.  It's cleared well before then, at the end of each
+// buffer.
+const float kDenormalThreshold = 1e-15f;
+
+}  // namespace
+
+DspProcessor::DspProcessor()
+    : channels_(2),
+      passthrough_(true),
+      ll_(1),
+      rl_(0),
+      lr_(0),
+      rr_(1) {
+  Reset();
+}
+
+DspProcessor::Filter DspProcessor::Peaking(double frequency, double bandwidth,
+                                           double gain, int rate) {
+  const double a = std::pow(10.0, gain / 40);
+  const double w0 = 2 * M_PI * frequency / rate;
+  const double alpha = std::sin(w0) * bandwidth / (2 * frequency);
+  const double cos_w0 = std::cos(w0);
+  const double a0 = 1 + alpha / a;
+
+  Filter ret;
+  ret.b0_ = (1 + alpha * a) / a0;
+  ret.b1_ = -2 * cos_w0 / a0;
+  ret.b2_ = (1 - alpha * a) / a0;
+  ret.a1_ = -2 * cos_w0 / a0;
+  ret.a2_ = (1 - alpha / a) / a0;
+  return ret;
+}
+
+void DspProcessor::Configure(int rate, int channels, float preamp,
+                             float balance, const float* gains) {
+  channels_ = channels;
+
+  if (balance > 0) {
+    ll_ = 1 - balance;
+    rl_ = 0;
+    lr_ = balance;
+    rr_ = 1;
+  } else {
+    ll_ = 1;
+    rl_ = -balance;
+    lr_ = 0;
+    rr_ = 1 + balance;
+  }
+  ll_ *= preamp;
+  rl_ *= preamp;
+  lr_ *= preamp;
+  rr_ *= preamp;
+
+  std::vector<int> active;
+  float last_frequency = 0;
+  for (int band = 0; band < kBands; ++band) {
+    const float frequency = kBandFrequencies[band];
+    const float bandwidth = frequency - last_frequency;
+    last_frequency = frequency;
+
+    if (std::abs(gains[band]) < kMinGain ||
+        frequency >= rate * kMaxFrequencyOfRate) {
+      continue;
+    }
+
+    // A band that's just been turned on starts from silence.
+    if (std::find(active_.begin(), active_.end(), band) == active_.end()) {
+      z1_[band * 2] = z1_[band * 2 + 1] = 0;
+      z2_[band * 2] = z2_[band * 2 + 1] = 0;
+    }
+    filters_[band] = Peaking(frequency, bandwidth, gains[band], rate);
+    active.push_back(band);
+  }
+  active_.swap(active);
+
+  passthrough_ = active_.empty() && preamp == 1 &&
+                 (channels_ == 1 || balance == 0);
+}
+
+void DspProcessor::Reset() {
+  std::fill(z1_, z1_ + kBands * 2, 0.0f);
+  std::fill(z2_, z2_ + kBands * 2, 0.0f);
+}
+
+void DspProcessor::Process(float* samples, int frames) {
+  if (passthrough_) return;
+
+  if (channels_ == 1) {
+    ProcessMono(samples, frames);
+  } else {
+    ProcessStereo(samples, frames);
+  }
+
+  for (int i = 0; i < kBands * 2; ++i) {
+    if (std::abs(z1_[i]) < kDenormalThreshold) z1_[i] = 0;
+    if (std::abs(z2_[i]) < kDenormalThreshold) z2_[i] = 0;
+  }
+}
+
+void DspProcessor::ProcessMono(float* samples, int frames) {
+  // Balance doesn't mean anything in mono.
+  const float preamp = ll_ + lr_;
+
+  for (int i = 0; i < frames; ++i) {
+    float x = samples[i] * preamp;
+    for (int band : active_) {
+      const Filter& f = filters_[band];
+      float& z1 = z1_[band * 2];
+      float& z2 = z2_[band * 2];
+      const float y = f.b0_ * x + z1;
+      z1 = f.b1_ * x - f.a1_ * y + z2;
+      z2 = f.b2_ * x - f.a2_ * y;
+      x = y;
+    }
+    samples[i] = x;
+  }
+}
+
+void DspProcessor::ProcessStereo(float* samples, int frames) {
+  const int count = active_.size();
+
+#if defined(__SSE2__)
+  // Only the low two lanes are used, one for each channel.
+  __m128 b0[kBands], b1[kBands], b2[kBands], a1[kBands], a2[kBands];
+  __m128 z1[kBands], z2[kBands];
+  for (int i = 0; i < count; ++i) {
+    const int band = active_[i];
+    const Filter& f = filters_[band];
+    b0[i] = _mm_set1_ps(f.b0_);
+    b1[i] = _mm_set1_ps(f.b1_);
+    b2[i] = _mm_set1_ps(f.b2_);
+    a1[i] = _mm_set1_ps(f.a1_);
+    a2[i] = _mm_set1_ps(f.a2_);
+    z1[i] = _mm_setr_ps(z1_[band * 2], z1_[band * 2 + 1], 0, 0);
+    z2[i] = _mm_setr_ps(z2_[band * 2], z2_[band * 2 + 1], 0, 0);
+  }
+
+  const __m128 from_left = _mm_setr_ps(ll_, lr_, 0, 0);
+  const __m128 from_right = _mm_setr_ps(rl_, rr_, 0, 0);
+  for (int frame = 0; frame < frames; ++frame) {
+    float* out = samples + frame * 2;
+    __m128 x = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(out[0]), from_left),
+                          _mm_mul_ps(_mm_set1_ps(out[1]), from_right));
+    for (int i = 0; i < count; ++i) {
+      const __m128 y = _mm_add_ps(_mm_mul_ps(b0[i], x), z1[i]);
+      z1[i] = _mm_add_ps(
+          _mm_sub_ps(_mm_mul_ps(b1[i], x), _mm_mul_ps(a1[i], y)), z2[i]);
+      z2[i] = _mm_sub_ps(_mm_mul_ps(b2[i], x), _mm_mul_ps(a2[i], y));
+      x = y;
+    }
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), x);
+  }
+
+  for (int i = 0; i < count; ++i) {
+    const int band = active_[i];
+    _mm_storel_pi(reinterpret_cast<__m64*>(z1_ + band * 2), z1[i]);
+    _mm_storel_pi(reinterpret_cast<__m64*>(z2_ + band * 2), z2[i]);
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // A 64 bit register holds exactly one stereo frame.
+  float32x2_t b0[kBands], b1[kBands], b2[kBands], a1[kBands], a2[kBands];
+  float32x2_t z1[kBands], z2[kBands];
+  for (int i = 0; i < count; ++i) {
+    const int band = active_[i];
+    const Filter& f = filters_[band];
+    b0[i] = vdup_n_f32(f.b0_);
+    b1[i] = vdup_n_f32(f.b1_);
+    b2[i] = vdup_n_f32(f.b2_);
+    a1[i] = vdup_n_f32(f.a1_);
+    a2[i] = vdup_n_f32(f.a2_);
+    z1[i] = vld1_f32(z1_ + band * 2);
+    z2[i] = vld1_f32(z2_ + band * 2);
+  }
+
+  const float from_left_values[] = {ll_, lr_};
+  const float from_right_values[] = {rl_, rr_};
+  const float32x2_t from_left = vld1_f32(from_left_values);
+  const float32x2_t from_right = vld1_f32(from_right_values);
+  for (int frame = 0; frame < frames; ++frame) {
+    float* out = samples + frame * 2;
+    float32x2_t x = vmul_n_f32(from_left, out[0]);
+    x = vmla_n_f32(x, from_right, out[1]);
+    for (int i = 0; i < count; ++i) {
+      const float32x2_t y = vmla_f32(z1[i], b0[i], x);
+      z1[i] = vmls_f32(vmla_f32(z2[i], b1[i], x), a1[i], y);
+      z2[i] = vmls_f32(vmul_f32(b2[i], x), a2[i], y);
+      x = y;
+    }
+    vst1_f32(out, x);
+  }
+
+  for (int i = 0; i < count; ++i) {
+    const int band = active_[i];
+    vst1_f32(z1_ + band * 2, z1[i]);
+    vst1_f32(z2_ + band * 2, z2[i]);
+  }
+#else
+  for (int frame = 0; frame < frames; ++frame) {
+    float* out = samples + frame * 2;
+    float x[2] = {ll_ * out[0] + rl_ * out[1], lr_ * out[0] + rr_ * out[1]};
+    for (int i = 0; i < count; ++i) {
+      const int band = active_[i];
+      const Filter& f = filters_[band];
+      for (int c = 0; c < 2; ++c) {
+        float& z1 = z1_[band * 2 + c];
+        float& z2 = z2_[band * 2 + c];
+        const float y = f.b0_ * x[c] + z1;
+        z1 = f.b1_ * x[c] - f.a1_ * y + z2;
+        z2 = f.b2_ * x[c] - f.a2_ * y;
+        x[c] = y;
+      }
+    }
+    out[0] = x[0];
+    out[1] = x[1];
+  }
+#endif
+}
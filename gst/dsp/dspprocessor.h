@@ -0,0 +1,79 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GST_DSP_DSPPROCESSOR_H_
+#define GST_DSP_DSPPROCESSOR_H_
+
+#include <vector>
+
+// The sums behind the clementinedsp element: a preamp, a 10 band equalizer
+// and a stereo balance, all done in one pass over each buffer.  With SSE2 or
+// NEON the two channels of a stereo frame go through the equalizer's filters
+// side by side in one register.
+class DspProcessor {
+ public:
+  static const int kBands = 10;
+  static const float kBandFrequencies[kBands];
+
+  // Normalised so a0 is 1, and run in transposed direct form II.
+  struct Filter {
+    float b0_, b1_, b2_, a1_, a2_;
+  };
+
+  DspProcessor();
+
+  // gains has kBands gains in dB.  balance goes from -1 (left) to 1 (right)
+  // and, like audiopanorama's psychoacoustic method, moves the quiet side
+  // into the loud one rather than only turning it down.  Only 1 or 2
+  // channels are supported.
+  void Configure(int rate, int channels, float preamp, float balance,
+                 const float* gains);
+  // Forgets the filters' history, after a discontinuity.
+  void Reset();
+
+  // Whether Process wouldn't change anything.
+  bool is_passthrough() const { return passthrough_; }
+
+  // samples has frames * channels interleaved samples.
+  void Process(float* samples, int frames);
+
+  // A peaking filter from the RBJ audio EQ cookbook.  bandwidth is in Hz.
+  static Filter Peaking(double frequency, double bandwidth, double gain,
+                        int rate);
+
+ private:
+  void ProcessMono(float* samples, int frames);
+  void ProcessStereo(float* samples, int frames);
+
+  int channels_;
+  bool passthrough_;
+
+  // The preamp and balance as one matrix:
+  //   left  = ll_ * left + rl_ * right
+  //   right = lr_ * left + rr_ * right
+  float ll_, rl_, lr_, rr_;
+
+  // Bands with no gain aren't run at all.
+  Filter filters_[kBands];
+  std::vector<int> active_;
+
+  // The filters' history, left and right next to each other.
+  float z1_[kBands * 2];
+  float z2_[kBands * 2];
+};
+
+#endif  // GST_DSP_DSPPROCESSOR_H_
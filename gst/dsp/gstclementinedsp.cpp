@@ -0,0 +1,268 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gstclementinedsp.h"
+
+#include <cmath>
+
+GST_DEBUG_CATEGORY_STATIC (gst_clementinedsp_debug);
+#define GST_CAT_DEFAULT gst_clementinedsp_debug
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+# define FORMATS "{ F32LE, S16LE }"
+#else
+# define FORMATS "{ F32BE, S16BE }"
+#endif
+
+#define ALLOWED_CAPS \
+  GST_AUDIO_CAPS_MAKE (FORMATS) ", " \
+  "layout = (string) interleaved, " \
+  "channels = (int) [ 1, 2 ]"
+
+/* Integer samples are converted to floats this many frames at a time */
+#define S16_CHUNK_FRAMES 256
+
+enum {
+  PROP_0,
+  PROP_PREAMP,
+  PROP_PANORAMA,
+  PROP_BAND0
+  /* PROP_BAND0 + n is band n */
+};
+
+#define gst_clementinedsp_parent_class parent_class
+G_DEFINE_TYPE (GstClementineDsp, gst_clementinedsp, GST_TYPE_AUDIO_FILTER);
+
+static void gst_clementinedsp_finalize (GObject * object);
+static void gst_clementinedsp_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_clementinedsp_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static gboolean gst_clementinedsp_stop (GstBaseTransform * trans);
+static GstFlowReturn gst_clementinedsp_transform_ip (GstBaseTransform * trans,
+    GstBuffer * in);
+static gboolean gst_clementinedsp_setup (GstAudioFilter * base,
+    const GstAudioInfo * info);
+
+static void
+gst_clementinedsp_class_init (GstClementineDspClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+  GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS (klass);
+  GstCaps *caps;
+
+  gobject_class->set_property = gst_clementinedsp_set_property;
+  gobject_class->get_property = gst_clementinedsp_get_property;
+  gobject_class->finalize = gst_clementinedsp_finalize;
+
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_clementinedsp_stop);
+  trans_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_clementinedsp_transform_ip);
+  trans_class->transform_ip_on_passthrough = FALSE;
+
+  filter_class->setup = GST_DEBUG_FUNCPTR (gst_clementinedsp_setup);
+
+  g_object_class_install_property (gobject_class, PROP_PREAMP,
+      g_param_spec_float ("preamp", "Preamp",
+          "Volume before the equalizer", 0.0, 10.0, 1.0,
+          GParamFlags(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_PANORAMA,
+      g_param_spec_float ("panorama", "Panorama",
+          "Position in stereo panorama (-1.0 left -> 1.0 right)",
+          -1.0, 1.0, 0.0,
+          GParamFlags(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  for (int band = 0; band < DspProcessor::kBands; ++band) {
+    gchar *name = g_strdup_printf ("band%d", band);
+    gchar *blurb = g_strdup_printf ("Gain of the band at %.0f Hz",
+        DspProcessor::kBandFrequencies[band]);
+    g_object_class_install_property (gobject_class, PROP_BAND0 + band,
+        g_param_spec_float (name, name, blurb, -24.0, 12.0, 0.0,
+            GParamFlags(G_PARAM_READWRITE)));
+    g_free (name);
+    g_free (blurb);
+  }
+
+  GST_DEBUG_CATEGORY_INIT (gst_clementinedsp_debug, "clementinedsp", 0,
+      "preamp, equalizer and balance element");
+
+  gst_element_class_set_static_metadata (element_class,
+      "Preamp, equalizer and balance",
+      "Filter/Effect/Audio",
+      "Changes the volume, frequency response and stereo balance in one pass",
+      "Clementine developers");
+
+  caps = gst_caps_from_string (ALLOWED_CAPS);
+  gst_audio_filter_class_add_pad_templates (filter_class, caps);
+  gst_caps_unref (caps);
+}
+
+static void
+gst_clementinedsp_init (GstClementineDsp * dsp)
+{
+  dsp->preamp = 1.0;
+  dsp->panorama = 0.0;
+  for (int band = 0; band < DspProcessor::kBands; ++band)
+    dsp->gains[band] = 0.0;
+  dsp->dirty = TRUE;
+
+  dsp->processor = new DspProcessor;
+
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (dsp), TRUE);
+}
+
+static void
+gst_clementinedsp_finalize (GObject * object)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (object);
+
+  delete dsp->processor;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* Call with the object lock held */
+static gboolean
+gst_clementinedsp_is_neutral (GstClementineDsp * dsp)
+{
+  if (dsp->preamp != 1.0 || dsp->panorama != 0.0)
+    return FALSE;
+
+  for (int band = 0; band < DspProcessor::kBands; ++band) {
+    if (dsp->gains[band] != 0.0)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void
+gst_clementinedsp_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (object);
+
+  GST_OBJECT_LOCK (dsp);
+  if (prop_id == PROP_PREAMP) {
+    dsp->preamp = g_value_get_float (value);
+  } else if (prop_id == PROP_PANORAMA) {
+    dsp->panorama = g_value_get_float (value);
+  } else if (prop_id >= PROP_BAND0 &&
+             prop_id < PROP_BAND0 + DspProcessor::kBands) {
+    dsp->gains[prop_id - PROP_BAND0] = g_value_get_float (value);
+  } else {
+    GST_OBJECT_UNLOCK (dsp);
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    return;
+  }
+  dsp->dirty = TRUE;
+  const gboolean neutral = gst_clementinedsp_is_neutral (dsp);
+  GST_OBJECT_UNLOCK (dsp);
+
+  /* Buffers don't even have to be made writable while nothing's changed */
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (dsp), neutral);
+}
+
+static void
+gst_clementinedsp_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (object);
+
+  GST_OBJECT_LOCK (dsp);
+  if (prop_id == PROP_PREAMP) {
+    g_value_set_float (value, dsp->preamp);
+  } else if (prop_id == PROP_PANORAMA) {
+    g_value_set_float (value, dsp->panorama);
+  } else if (prop_id >= PROP_BAND0 &&
+             prop_id < PROP_BAND0 + DspProcessor::kBands) {
+    g_value_set_float (value, dsp->gains[prop_id - PROP_BAND0]);
+  } else {
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  }
+  GST_OBJECT_UNLOCK (dsp);
+}
+
+static gboolean
+gst_clementinedsp_setup (GstAudioFilter * base, const GstAudioInfo * info)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (base);
+
+  GST_OBJECT_LOCK (dsp);
+  dsp->dirty = TRUE;
+  GST_OBJECT_UNLOCK (dsp);
+
+  dsp->processor->Reset ();
+  return TRUE;
+}
+
+static gboolean
+gst_clementinedsp_stop (GstBaseTransform * trans)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (trans);
+
+  dsp->processor->Reset ();
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_clementinedsp_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
+{
+  GstClementineDsp *dsp = GST_CLEMENTINEDSP (trans);
+  const GstAudioInfo *info = GST_AUDIO_FILTER_INFO (dsp);
+  const int channels = GST_AUDIO_INFO_CHANNELS (info);
+
+  GST_OBJECT_LOCK (dsp);
+  if (dsp->dirty) {
+    dsp->processor->Configure (GST_AUDIO_INFO_RATE (info), channels,
+        dsp->preamp, dsp->panorama, dsp->gains);
+    dsp->dirty = FALSE;
+  }
+  GST_OBJECT_UNLOCK (dsp);
+
+  if (dsp->processor->is_passthrough () ||
+      GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP))
+    return GST_FLOW_OK;
+
+  GstMapInfo map;
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READWRITE))
+    return GST_FLOW_ERROR;
+
+  const int frames = map.size / GST_AUDIO_INFO_BPF (info);
+  if (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_F32) {
+    dsp->processor->Process (reinterpret_cast<gfloat*> (map.data), frames);
+  } else {
+    gint16 *samples = reinterpret_cast<gint16*> (map.data);
+    gfloat chunk[S16_CHUNK_FRAMES * 2];
+
+    for (int start = 0; start < frames; start += S16_CHUNK_FRAMES) {
+      const int count = MIN (S16_CHUNK_FRAMES, frames - start) * channels;
+      gint16 *in = samples + start * channels;
+
+      for (int i = 0; i < count; ++i)
+        chunk[i] = in[i] / 32768.0f;
+      dsp->processor->Process (chunk, count / channels);
+      for (int i = 0; i < count; ++i)
+        in[i] = CLAMP (lrintf (chunk[i] * 32768.0f), G_MININT16, G_MAXINT16);
+    }
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  return GST_FLOW_OK;
+}
@@ -0,0 +1,58 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GST_DSP_GSTCLEMENTINEDSP_H_
+#define GST_DSP_GSTCLEMENTINEDSP_H_
+
+#include <gst/gst.h>
+#include <gst/audio/gstaudiofilter.h>
+
+#include "dspprocessor.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CLEMENTINEDSP            (gst_clementinedsp_get_type())
+#define GST_CLEMENTINEDSP(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_CLEMENTINEDSP,GstClementineDsp))
+#define GST_IS_CLEMENTINEDSP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_CLEMENTINEDSP))
+#define GST_CLEMENTINEDSP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_CLEMENTINEDSP,GstClementineDspClass))
+#define GST_IS_CLEMENTINEDSP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_CLEMENTINEDSP))
+
+// Does the work of a volume, an equalizer-nbands and an audiopanorama
+// element in one, so there's only one pass over each buffer.  When nothing
+// would change the audio the element passes buffers straight through.
+struct GstClementineDsp {
+  GstAudioFilter parent;
+
+  /* properties, guarded by the object lock */
+  gfloat preamp;
+  gfloat panorama;
+  gfloat gains[DspProcessor::kBands];
+  gboolean dirty;
+
+  /* <private> only used in the streaming thread */
+  DspProcessor* processor;
+};
+
+struct GstClementineDspClass {
+  GstAudioFilterClass parent_class;
+};
+
+GType gst_clementinedsp_get_type (void);
+
+G_END_DECLS
+
+#endif  // GST_DSP_GSTCLEMENTINEDSP_H_
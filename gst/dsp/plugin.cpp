@@ -0,0 +1,48 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gst/gst.h>
+
+#include "gstclementinedsp.h"
+#include "plugin.h"
+
+namespace {
+
+static gboolean plugin_init(GstPlugin* plugin) {
+  if (!gst_element_register(plugin, "clementinedsp",
+          GST_RANK_NONE, GST_TYPE_CLEMENTINEDSP)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+}  // namespace
+
+int gstclementinedsp_register_static() {
+  return gst_plugin_register_static(
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    "clementinedsp",
+    "Preamp, equalizer and stereo balance in one element",
+    plugin_init,
+    "0.1",
+    "GPL",
+    "ClementineDsp",
+    "ClementineDsp",
+    "https://www.clementine-player.org");
+}
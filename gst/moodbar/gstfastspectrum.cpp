@@ -22,10 +22,13 @@
 #include <cstring>
 #include <cmath>
 
+#include <QByteArray>
+#include <QMap>
 #include <QMutex>
 #include <QMutexLocker>
 
 #include "gstfastspectrum.h"
+#include "plugin.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_fastspectrum_debug);
 #define GST_CAT_DEFAULT gst_fastspectrum_debug
@@ -52,6 +55,13 @@ enum {
   PROP_BANDS
 };
 
+// FFTW's planner isn't thread safe, but executing a plan on different arrays
+// is, so every instance with the same FFT size shares one plan and the lock
+// is only taken to make it.  The plans are kept until exit.
+static QMutex fftw_lock;
+static QMap<guint, fftw_plan> fftw_plans;
+static QByteArray fftw_wisdom_filename;
+
 #define gst_fastspectrum_parent_class parent_class
 G_DEFINE_TYPE (GstFastSpectrum, gst_fastspectrum, GST_TYPE_AUDIO_FILTER);
 
@@ -111,8 +121,6 @@ gst_fastspectrum_class_init (GstFastSpectrumClass * klass)
   caps = gst_caps_from_string (ALLOWED_CAPS);
   gst_audio_filter_class_add_pad_templates (filter_class, caps);
   gst_caps_unref (caps);
-
-  klass->fftw_lock = new QMutex;
 }
 
 static void
@@ -126,6 +134,47 @@ gst_fastspectrum_init (GstFastSpectrum * spectrum)
   g_mutex_init (&spectrum->lock);
 }
 
+static fftw_plan
+gst_fastspectrum_get_plan (guint nfft)
+{
+  QMutexLocker l(&fftw_lock);
+
+  fftw_plan plan = fftw_plans.value(nfft);
+  if (plan)
+    return plan;
+
+  // Measuring overwrites the arrays, so don't let it have anyone's data.
+  // fftw_malloc gives every array the same alignment, so the plan can be run
+  // on any instance's arrays afterwards.
+  double* input = reinterpret_cast<double*>(
+      fftw_malloc(sizeof(double) * nfft));
+  fftw_complex* output = reinterpret_cast<fftw_complex*>(
+      fftw_malloc(sizeof(fftw_complex) * (nfft/2+1)));
+  plan = fftw_plan_dft_r2c_1d(nfft, input, output, FFTW_MEASURE);
+  fftw_free(input);
+  fftw_free(output);
+
+  fftw_plans[nfft] = plan;
+
+  // Measuring takes a while, next time it can come straight from the wisdom.
+  if (!fftw_wisdom_filename.isEmpty() &&
+      !fftw_export_wisdom_to_filename(fftw_wisdom_filename.constData())) {
+    GST_WARNING ("could not save FFTW wisdom to %s",
+        fftw_wisdom_filename.constData());
+  }
+
+  return plan;
+}
+
+void
+gstfastspectrum_set_wisdom_file (const char* filename)
+{
+  QMutexLocker l(&fftw_lock);
+
+  fftw_wisdom_filename = filename;
+  fftw_import_wisdom_from_filename(filename);
+}
+
 static void
 gst_fastspectrum_alloc_channel_data (GstFastSpectrum * spectrum)
 {
@@ -140,29 +189,14 @@ gst_fastspectrum_alloc_channel_data (GstFastSpectrum * spectrum)
 
   spectrum->spect_magnitude = new double[bands]{};
 
-  GstFastSpectrumClass* klass = reinterpret_cast<GstFastSpectrumClass*>(
-      G_OBJECT_GET_CLASS(spectrum));
-  {
-    QMutexLocker l(klass->fftw_lock);
-    spectrum->plan = fftw_plan_dft_r2c_1d(
-        nfft,
-        spectrum->fft_input,
-        spectrum->fft_output,
-        FFTW_ESTIMATE);
-  }
+  spectrum->plan = gst_fastspectrum_get_plan(nfft);
   spectrum->channel_data_initialised = true;
 }
 
 static void
 gst_fastspectrum_free_channel_data (GstFastSpectrum * spectrum)
 {
-  GstFastSpectrumClass* klass = reinterpret_cast<GstFastSpectrumClass*>(
-      G_OBJECT_GET_CLASS(spectrum));
   if (spectrum->channel_data_initialised) {
-    {
-      QMutexLocker l(klass->fftw_lock);
-      fftw_destroy_plan(spectrum->plan);
-    }
     fftw_free(spectrum->fft_input);
     fftw_free(spectrum->fft_output);
     delete[] spectrum->input_ring_buffer;
@@ -394,8 +428,8 @@ gst_fastspectrum_run_fft (GstFastSpectrum * spectrum, guint input_pos)
     spectrum->fft_input[i] =
         spectrum->input_ring_buffer[(input_pos + i) % nfft];
 
-  // Should be safe to execute the same plan multiple times in parallel.
-  fftw_execute(spectrum->plan);
+  fftw_execute_dft_r2c(spectrum->plan, spectrum->fft_input,
+      spectrum->fft_output);
 
   gdouble val;
   /* Calculate magnitude in db */
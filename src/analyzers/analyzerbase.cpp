@@ -32,7 +32,9 @@
 #include <cmath>
 #include <cstdint>
 
+#include "analyzerglhost.h"
 #include "core/arraysize.h"
+#include "engines/spectrumservice.h"
 
 // INSTRUCTIONS Base2D
 // 1. do anything that depends on height() in init(), Base2D will call it before
@@ -68,16 +70,47 @@ Analyzer::Base::Base(QWidget* parent, uint scopeSize)
       lastScope_(),
       new_frame_(false),
       is_playing_(false),
+      subscribed_(false),
       barkband_table_(),
       prev_color_index_(0),
       bands_(0),
-      psychedelic_enabled_(false) {
+      psychedelic_enabled_(false),
+      gl_host_(nullptr) {
   lastScope_.resize(fht_->size());
 }
 
-void Analyzer::Base::hideEvent(QHideEvent*) { timer_.stop(); }
+Analyzer::Base::~Base() {
+  setSubscribed(false);
+  delete gl_host_;
+  delete fht_;
+}
+
+void Analyzer::Base::set_engine(EngineBase* engine) {
+  setSubscribed(false);
+  engine_ = engine;
+  setSubscribed(isVisible());
+}
+
+void Analyzer::Base::setSubscribed(bool subscribed) {
+  if (!engine_ || subscribed == subscribed_) return;
 
-void Analyzer::Base::showEvent(QShowEvent*) { timer_.start(timeout(), this); }
+  if (subscribed) {
+    engine_->spectrum()->AddSubscriber();
+  } else {
+    engine_->spectrum()->RemoveSubscriber();
+  }
+  subscribed_ = subscribed;
+}
+
+void Analyzer::Base::hideEvent(QHideEvent*) {
+  timer_.stop();
+  setSubscribed(false);
+}
+
+void Analyzer::Base::showEvent(QShowEvent*) {
+  setSubscribed(true);
+  timer_.start(timeout(), this);
+}
 
 void Analyzer::Base::transform(Scope& scope) {
   // this is a standard transformation that should give
@@ -94,32 +127,46 @@ void Analyzer::Base::transform(Scope& scope) {
     std::copy(scope.begin(), scope.begin() + aux.size(), aux.begin());
   }
 
-  fht_->logSpectrum(scope.data(), aux.data());
+  fht_->logSpectrumFromPower2(scope.data(), aux.data());
   fht_->scale(scope.data(), 1.0 / 20);
 
   scope.resize(fht_->size() / 2);  // second half of values are rubbish
 }
 
+void Analyzer::Base::setOpenGL(bool enabled) {
+  if (enabled == (gl_host_ != nullptr)) return;
+
+  if (enabled) {
+    gl_host_ = new AnalyzerGLHost(this);
+    gl_host_->show();
+  } else {
+    delete gl_host_;
+    gl_host_ = nullptr;
+    update();
+  }
+}
+
 void Analyzer::Base::paintEvent(QPaintEvent* e) {
+  // The host draws over the whole of us.
+  if (gl_host_) return;
+
   QPainter p(this);
   p.fillRect(e->rect(), palette().color(QPalette::Window));
+  drawFrame(p);
+}
 
+void Analyzer::Base::drawFrame(QPainter& p) {
   switch (engine_->state()) {
     case Engine::Playing: {
-      const Engine::Scope& thescope = engine_->scope(timeout_);
-      int i = 0;
-
-      // convert to mono here - our built in analyzers need mono, but the
-      // engines provide interleaved pcm
-      for (uint x = 0; static_cast<int>(x) < fht_->size(); ++x) {
-        lastScope_[x] = static_cast<double>(thescope[i] + thescope[i + 1]) /
-                        (2 * (1 << 15));
-        i += 2;
-      }
+      // The engine's spectrum service does the transform, so it's shared
+      // with any other analyzers that are showing.
+      const Scope& power =
+          engine_->spectrum()->Power2(fht_->sizeExp(), timeout_);
+      lastScope_.assign(power.begin(), power.end());
 
       is_playing_ = true;
       transform(lastScope_);
-      analyze(p, lastScope_, new_frame_);
+      analyzeFrame(p, lastScope_);
 
       lastScope_.resize(fht_->size());
 
@@ -127,7 +174,7 @@ void Analyzer::Base::paintEvent(QPaintEvent* e) {
     }
     case Engine::Paused:
       is_playing_ = false;
-      analyze(p, lastScope_, new_frame_);
+      analyzeFrame(p, lastScope_);
       break;
 
     default:
@@ -138,6 +185,17 @@ void Analyzer::Base::paintEvent(QPaintEvent* e) {
   new_frame_ = false;
 }
 
+void Analyzer::Base::analyzeFrame(QPainter& p, const Scope& s) {
+  if (gl_host_) {
+    p.beginNativePainting();
+    const bool drawn = analyzeGL(s, new_frame_);
+    p.endNativePainting();
+    if (drawn) return;
+  }
+
+  analyze(p, s, new_frame_);
+}
+
 int Analyzer::Base::resizeExponent(int exp) {
   if (exp < 3)
     exp = 3;
@@ -181,9 +239,9 @@ void Analyzer::Base::demo(QPainter& p) {
     for (uint i = 0; i < s.size(); ++i)
       s[i] = dt * (sin(M_PI + (i * M_PI) / s.size()) + 1.0);
 
-    analyze(p, s, new_frame_);
+    analyzeFrame(p, s);
   } else {
-    analyze(p, Scope(32, 0), new_frame_);
+    analyzeFrame(p, Scope(32, 0));
   }
   ++t;
 }
@@ -284,5 +342,9 @@ void Analyzer::Base::timerEvent(QTimerEvent* e) {
   if (e->timerId() != timer_.timerId()) return;
 
   new_frame_ = true;
-  update();
+  if (gl_host_) {
+    gl_host_->update();
+  } else {
+    update();
+  }
 }
@@ -52,6 +52,7 @@
 #endif
 #endif
 
+class AnalyzerGLHost;
 class QEvent;
 class QPaintEvent;
 class QResizeEvent;
@@ -64,11 +65,11 @@ class Base : public QWidget {
   Q_OBJECT
 
  public:
-  ~Base() { delete fht_; }
+  ~Base();
 
   uint timeout() const { return timeout_; }
 
-  void set_engine(EngineBase* engine) { engine_ = engine; }
+  void set_engine(EngineBase* engine);
 
   void changeTimeout(uint newTimeout) {
     timeout_ = newTimeout;
@@ -81,6 +82,9 @@ class Base : public QWidget {
   virtual void framerateChanged() {}
   virtual void psychedelicModeChanged(bool);
 
+  // Draws the analyzer with OpenGL rather than in software.
+  void setOpenGL(bool enabled);
+
  protected:
   explicit Base(QWidget*, uint scopeSize = 7);
 
@@ -91,16 +95,28 @@ class Base : public QWidget {
 
   void polishEvent();
 
+  // Tells the engine's spectrum service whether we want its transforms, so it
+  // can skip collecting samples while no analyzer is showing.
+  void setSubscribed(bool);
+
   int resizeExponent(int);
   int resizeForBands(int);
   int BandFrequency(int) const;
   void updateBandSize(const int);
   QColor getPsychedelicColor(const Scope&, const int, const int);
   virtual void init() {}
+  // Turns the FHT::power2 values the spectrum service hands out into whatever
+  // analyze() wants.
   virtual void transform(Scope&);
   virtual void analyze(QPainter& p, const Scope&, bool new_frame) = 0;
+  // Analyzers that can draw straight to gl_host_ with OpenGL do it here, with
+  // its context current, and return true.  Otherwise analyze() is used.
+  virtual bool analyzeGL(const Scope&, bool) { return false; }
   virtual void demo(QPainter& p);
 
+  // Calls analyzeGL() or analyze() with the frame.
+  void analyzeFrame(QPainter& p, const Scope&);
+
  protected:
   static const int kSampleRate =
       44100;  // we shouldn't need to care about ultrasonics
@@ -113,12 +129,21 @@ class Base : public QWidget {
 
   bool new_frame_;
   bool is_playing_;
+  bool subscribed_;
 
   QVector<uint> barkband_table_;
   double prev_colors_[10][3];
   int prev_color_index_;
   int bands_;
   bool psychedelic_enabled_;
+
+  // Covers the analyzer while it's drawn with OpenGL, and paints it with
+  // drawFrame().
+  AnalyzerGLHost* gl_host_;
+
+ private:
+  friend class AnalyzerGLHost;
+  void drawFrame(QPainter& p);
 };
 
 void interpolate(const Scope&, Scope&);
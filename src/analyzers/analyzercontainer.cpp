@@ -56,6 +56,7 @@ AnalyzerContainer::AnalyzerContainer(QWidget* parent)
       double_click_timer_(new QTimer(this)),
       ignore_next_click_(false),
       psychedelic_colors_on_(false),
+      opengl_on_(false),
       current_analyzer_(nullptr),
       engine_(nullptr) {
   QHBoxLayout* layout = new QHBoxLayout(this);
@@ -89,6 +90,9 @@ AnalyzerContainer::AnalyzerContainer(QWidget* parent)
   psychedelic_enable_ = context_menu_->addAction(
       tr("Use Psychedelic Colors"), this, SLOT(TogglePsychedelicColors()));
   psychedelic_enable_->setCheckable(true);
+  opengl_enable_ =
+      context_menu_->addAction(tr("Use OpenGL"), this, SLOT(ToggleOpenGL()));
+  opengl_enable_->setCheckable(true);
 
   context_menu_->addSeparator();
   // Visualisation action gets added in SetActions
@@ -155,6 +159,12 @@ void AnalyzerContainer::TogglePsychedelicColors() {
   SavePsychedelic();
 }
 
+void AnalyzerContainer::ToggleOpenGL() {
+  opengl_on_ = !opengl_on_;
+  if (current_analyzer_) current_analyzer_->setOpenGL(opengl_on_);
+  SaveOpenGL();
+}
+
 void AnalyzerContainer::ChangeAnalyzer(int id) {
   QObject* instance = analyzer_types_[id]->newInstance(Q_ARG(QWidget*, this));
 
@@ -172,6 +182,7 @@ void AnalyzerContainer::ChangeAnalyzer(int id) {
       current_framerate_ == 0 ? kMediumFramerate : current_framerate_;
   current_analyzer_->changeTimeout(1000 / current_framerate_);
   current_analyzer_->psychedelicModeChanged(psychedelic_colors_on_);
+  current_analyzer_->setOpenGL(opengl_on_);
 
   layout()->addWidget(current_analyzer_);
 
@@ -198,6 +209,10 @@ void AnalyzerContainer::Load() {
   psychedelic_colors_on_ = s.value("psychedelic", false).toBool();
   psychedelic_enable_->setChecked(psychedelic_colors_on_);
 
+  // Drawing
+  opengl_on_ = s.value("opengl", false).toBool();
+  opengl_enable_->setChecked(opengl_on_);
+
   // Analyzer
   QString type = s.value("type", "BlockAnalyzer").toString();
   if (type.isEmpty()) {
@@ -249,6 +264,13 @@ void AnalyzerContainer::SavePsychedelic() {
   s.setValue("psychedelic", psychedelic_colors_on_);
 }
 
+void AnalyzerContainer::SaveOpenGL() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+
+  s.setValue("opengl", opengl_on_);
+}
+
 void AnalyzerContainer::AddFramerate(const QString& name, int framerate) {
   QAction* action = context_menu_framerate_->addAction(name);
   group_framerate_->addAction(action);
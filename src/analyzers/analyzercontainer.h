@@ -54,6 +54,7 @@ class AnalyzerContainer : public QWidget {
   void DisableAnalyzer();
   void ShowPopupMenu();
   void TogglePsychedelicColors();
+  void ToggleOpenGL();
 
  private:
   static const int kLowFramerate;
@@ -65,6 +66,7 @@ class AnalyzerContainer : public QWidget {
   void Save();
   void SaveFramerate(int framerate);
   void SavePsychedelic();
+  void SaveOpenGL();
   template <typename T>
   void AddAnalyzerType();
   void AddFramerate(const QString& name, int framerate);
@@ -81,12 +83,14 @@ class AnalyzerContainer : public QWidget {
   QList<QAction*> actions_;
   QAction* disable_action_;
   QAction* psychedelic_enable_;
+  QAction* opengl_enable_;
 
   QAction* visualisation_action_;
   QTimer* double_click_timer_;
   QPoint last_click_pos_;
   bool ignore_next_click_;
   bool psychedelic_colors_on_;
+  bool opengl_on_;
 
   Analyzer::Base* current_analyzer_;
   EngineBase* engine_;
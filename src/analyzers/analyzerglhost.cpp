@@ -0,0 +1,182 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "analyzerglhost.h"
+
+#include <QEvent>
+#include <QOpenGLShaderProgram>
+#include <QPainter>
+
+#include "analyzerbase.h"
+#include "core/logging.h"
+
+namespace {
+
+const char* kColumnsVertexShader =
+    "attribute highp vec2 position;\n"
+    "varying highp vec2 coord;\n"
+    "void main() {\n"
+    "  coord = vec2((position.x + 1.0) / 2.0, (1.0 - position.y) / 2.0);\n"
+    "  gl_Position = vec4(position, 0.0, 1.0);\n"
+    "}\n";
+
+// The texture is a ring of columns, so the oldest one is drawn on the left
+// by starting just after the newest.
+const char* kColumnsFragmentShader =
+    "uniform sampler2D columns;\n"
+    "uniform highp float offset;\n"
+    "varying highp vec2 coord;\n"
+    "void main() {\n"
+    "  gl_FragColor = texture2D(columns, vec2(fract(coord.x + offset),\n"
+    "                                         coord.y));\n"
+    "}\n";
+
+void AppendRgba(QRgb color, QVector<uchar>* data) {
+  *data << qRed(color) << qGreen(color) << qBlue(color) << qAlpha(color);
+}
+
+}  // namespace
+
+AnalyzerGLHost::AnalyzerGLHost(Analyzer::Base* analyzer)
+    : QOpenGLWidget(analyzer),
+      analyzer_(analyzer),
+      program_failed_(false),
+      texture_(0),
+      texture_width_(0),
+      texture_height_(0),
+      column_(0) {
+  resize(analyzer->size());
+  analyzer->installEventFilter(this);
+}
+
+AnalyzerGLHost::~AnalyzerGLHost() {
+  // They belong to our context, so it has to be current to free them.
+  makeCurrent();
+  FreeColumns();
+  program_.reset();
+  doneCurrent();
+}
+
+bool AnalyzerGLHost::eventFilter(QObject* object, QEvent* event) {
+  if (object == analyzer_ && event->type() == QEvent::Resize) {
+    resize(analyzer_->size());
+  }
+  return false;
+}
+
+void AnalyzerGLHost::initializeGL() { initializeOpenGLFunctions(); }
+
+void AnalyzerGLHost::paintGL() {
+  QPainter p(this);
+  p.fillRect(rect(), analyzer_->palette().color(QPalette::Window));
+  analyzer_->drawFrame(p);
+}
+
+bool AnalyzerGLHost::InitColumns() {
+  if (program_) return true;
+  if (program_failed_) return false;
+
+  program_.reset(new QOpenGLShaderProgram);
+  if (!program_->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                         kColumnsVertexShader) ||
+      !program_->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                         kColumnsFragmentShader) ||
+      !program_->link()) {
+    qLog(Warning) << "Couldn't make the analyzer's shaders, drawing columns "
+                     "in software"
+                  << program_->log();
+    program_.reset();
+    program_failed_ = true;
+    return false;
+  }
+
+  return true;
+}
+
+void AnalyzerGLHost::FreeColumns() {
+  if (texture_) glDeleteTextures(1, &texture_);
+  texture_ = 0;
+  texture_width_ = 0;
+  texture_height_ = 0;
+}
+
+void AnalyzerGLHost::AddColumn(const QVector<QRgb>& column, QRgb background) {
+  if (!InitColumns()) return;
+
+  if (column.size() != texture_height_ || width() != texture_width_) {
+    FreeColumns();
+    if (width() <= 0 || column.isEmpty()) return;
+
+    texture_width_ = width();
+    texture_height_ = column.size();
+    column_ = texture_width_ - 1;
+
+    QVector<uchar> data;
+    data.reserve(texture_width_ * texture_height_ * 4);
+    for (int i = 0; i < texture_width_ * texture_height_; ++i) {
+      AppendRgba(background, &data);
+    }
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture_width_, texture_height_,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, data.constData());
+  }
+
+  // Only the new column goes to the GPU.
+  column_ = (column_ + 1) % texture_width_;
+
+  QVector<uchar> data;
+  data.reserve(texture_height_ * 4);
+  for (QRgb color : column) AppendRgba(color, &data);
+
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, column_, 0, 1, texture_height_, GL_RGBA,
+                  GL_UNSIGNED_BYTE, data.constData());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool AnalyzerGLHost::DrawColumns() {
+  if (!texture_ || !InitColumns()) return false;
+
+  static const GLfloat kQuad[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+
+  glViewport(0, 0, width() * devicePixelRatio(),
+             height() * devicePixelRatio());
+
+  program_->bind();
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  program_->setUniformValue("columns", 0);
+  program_->setUniformValue(
+      "offset", static_cast<GLfloat>(column_ + 1) / texture_width_);
+
+  const int position = program_->attributeLocation("position");
+  program_->enableAttributeArray(position);
+  program_->setAttributeArray(position, kQuad, 2);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  program_->disableAttributeArray(position);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  program_->release();
+  return true;
+}
@@ -0,0 +1,75 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYZERS_ANALYZERGLHOST_H_
+#define ANALYZERS_ANALYZERGLHOST_H_
+
+#include <QOpenGLFunctions>
+#include <QOpenGLWidget>
+#include <QRgb>
+#include <QVector>
+#include <memory>
+
+class QOpenGLShaderProgram;
+
+namespace Analyzer {
+class Base;
+}
+
+// Covers an analyzer and draws it with OpenGL instead of in software.  The
+// analyzer paints into it with the same QPainter calls as before, which Qt
+// turns into OpenGL, so fills and unchanged pixmaps are drawn by the GPU.
+//
+// Analyzers that draw a column at a time can keep the columns in a texture
+// here instead, which is scrolled by moving where it's drawn from rather than
+// by copying it.
+class AnalyzerGLHost : public QOpenGLWidget, protected QOpenGLFunctions {
+ public:
+  explicit AnalyzerGLHost(Analyzer::Base* analyzer);
+  ~AnalyzerGLHost();
+
+  // Adds a column of pixels, top first, on the right of the texture, and
+  // scrolls the others left.  If the column's height or the width of the
+  // widget changed, the texture starts again filled with background.  The
+  // context has to be current.
+  void AddColumn(const QVector<QRgb>& column, QRgb background);
+
+  // Draws the columns over the whole widget.  False if they can't be drawn
+  // this way here.
+  bool DrawColumns();
+
+ protected:
+  bool eventFilter(QObject* object, QEvent* event);
+  void initializeGL();
+  void paintGL();
+
+ private:
+  bool InitColumns();
+  void FreeColumns();
+
+  Analyzer::Base* analyzer_;
+
+  std::unique_ptr<QOpenGLShaderProgram> program_;
+  bool program_failed_;
+  GLuint texture_;
+  int texture_width_;
+  int texture_height_;
+  // Where the newest column is in the texture
+  int column_;
+};
+
+#endif  // ANALYZERS_ANALYZERGLHOST_H_
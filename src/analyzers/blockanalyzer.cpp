@@ -122,10 +122,9 @@ void BlockAnalyzer::framerateChanged() {  // virtual
 }
 
 void BlockAnalyzer::transform(Analyzer::Scope& s) {
-  for (uint x = 0; x < s.size(); ++x) s[x] *= 2.f;
-
-  fht_->spectrum(s.data());
-  fht_->scale(s.data(), 1.f / 20.f);
+  // The spectrum of the samples doubled.
+  fht_->spectrumFromPower2(s.data());
+  fht_->scale(s.data(), 2.f / 20.f);
 
   // the second half is pretty dull, so only show it if the user has a large
   // analyzer
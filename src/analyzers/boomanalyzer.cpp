@@ -94,7 +94,7 @@ void BoomAnalyzer::resizeEvent(QResizeEvent* e) {
 }
 
 void BoomAnalyzer::transform(Scope& s) {
-  fht_->spectrum(s.data());
+  fht_->spectrumFromPower2(s.data());
   fht_->scale(s.data(), 1.0 / 50);
 
   s.resize(scope_.size() <= kMaxBandCount / 2 ? kMaxBandCount / 2
@@ -24,11 +24,17 @@
 
 #include <cmath>
 
-FHT::FHT(int n) : num_((n < 3) ? 0 : 1 << n), exp2_((n < 3) ? -1 : n) {
+#include "fhtkernels.h"
+
+FHT::FHT(int n)
+    : num_((n < 3) ? 0 : 1 << n),
+      exp2_((n < 3) ? -1 : n),
+      kernels_(&FHTKernels::Get()) {
   if (n > 3) {
     buf_vector_.resize(num_);
     tab_vector_.resize(num_ * 2);
     makeCasTable();
+    makeTwiddleTables();
   }
 }
 
@@ -55,15 +61,31 @@ void FHT::makeCasTable(void) {
   }
 }
 
-void FHT::scale(float* p, float d) {
-  for (int i = 0; i < (num_ / 2); i++) *p++ *= d;
+void FHT::makeTwiddleTables() {
+  twiddle_vector_.resize(2 * (num_ - 8));
+  for (int ndiv2 = 8; ndiv2 < num_; ndiv2 *= 2) {
+    float* costab = twiddle_vector_.data() + 2 * (ndiv2 - 8);
+    float* sintab = costab + ndiv2;
+    const int stride = num_ / ndiv2;
+    for (int i = 0; i < ndiv2; i++) {
+      costab[i] = tab_()[i * stride];
+      sintab[i] = tab_()[i * stride + 1];
+    }
+  }
 }
 
+void FHT::scale(float* p, float d) { kernels_->scale(p, d, num_ / 2); }
+
 void FHT::ewma(float* d, float* s, float w) {
-  for (int i = 0; i < (num_ / 2); i++, d++, s++) *d = *d * w + *s * (1 - w);
+  kernels_->ewma(d, s, w, num_ / 2);
 }
 
 void FHT::logSpectrum(float* out, float* p) {
+  power2(p);
+  logSpectrumFromPower2(out, p);
+}
+
+void FHT::logSpectrumFromPower2(float* out, float* p) {
   int n = num_ / 2, i, j, k, *r;
   if (log_vector_.size() < n) {
     log_vector_.resize(n);
@@ -73,7 +95,7 @@ void FHT::logSpectrum(float* out, float* p) {
       *r = j >= n ? n - 1 : j;
     }
   }
-  semiLogSpectrum(p);
+  semiLogSpectrumFromPower2(p);
   *out++ = *p = *p / 100;
   for (k = i = 1, r = log_(); i < n; i++) {
     j = *r++;
@@ -89,6 +111,10 @@ void FHT::logSpectrum(float* out, float* p) {
 
 void FHT::semiLogSpectrum(float* p) {
   power2(p);
+  semiLogSpectrumFromPower2(p);
+}
+
+void FHT::semiLogSpectrumFromPower2(float* p) {
   for (int i = 0; i < (num_ / 2); i++, p++) {
     float e = 10.0 * log10(sqrt(*p / 2));
     *p = e < 0 ? 0 : e;
@@ -97,6 +123,10 @@ void FHT::semiLogSpectrum(float* p) {
 
 void FHT::spectrum(float* p) {
   power2(p);
+  spectrumFromPower2(p);
+}
+
+void FHT::spectrumFromPower2(float* p) {
   for (int i = 0; i < (num_ / 2); i++, p++)
     *p = static_cast<float>(sqrt(*p / 2));
 }
@@ -108,16 +138,7 @@ void FHT::power(float* p) {
 
 void FHT::power2(float* p) {
   _transform(p, num_, 0);
-
-  *p = static_cast<float>(2 * pow(*p, 2));
-  p++;
-
-  float* q = p + num_ - 2;
-  for (int i = 1; i < (num_ / 2); i++) {
-    *p = static_cast<float>(pow(*p, 2) + pow(*q, 2));
-    p++;
-    q--;
-  }
+  kernels_->power2(p, num_);
 }
 
 void FHT::transform(float* p) {
@@ -160,38 +181,26 @@ void FHT::_transform(float* p, int n, int k) {
     return;
   }
 
-  int i, j, ndiv2 = n / 2;
-  float a, *t1, *t2, *t3, *t4, *ptab, *pp;
-
-  for (i = 0, t1 = buf_(), t2 = buf_() + ndiv2, pp = &p[k]; i < ndiv2; i++)
-    *t1++ = *pp++, *t2++ = *pp++;
+  const int ndiv2 = n / 2;
+  float* lo = p + k;
+  float* hi = lo + ndiv2;
+  float* out_lo = buf_();
+  float* out_hi = out_lo + ndiv2;
 
-  std::copy(buf_(), buf_() + n, p + k);
+  kernels_->deinterleave(lo, out_lo, out_hi, ndiv2);
+  std::copy(buf_(), buf_() + n, lo);
 
   _transform(p, ndiv2, k);
   _transform(p, ndiv2, k + ndiv2);
 
-  j = num_ / ndiv2 - 1;
-  t1 = buf_();
-  t2 = t1 + ndiv2;
-  t3 = p + k + ndiv2;
-  ptab = tab_();
-  pp = p + k;
+  const float* costab = twiddle_vector_.constData() + 2 * (ndiv2 - 8);
+  const float* sintab = costab + ndiv2;
 
-  a = *ptab++ * *t3++;
-  a += *ptab * *pp;
-  ptab += j;
-
-  *t1++ = *pp + a;
-  *t2++ = *pp++ - a;
-
-  for (i = 1, t4 = p + k + n; i < ndiv2; i++, ptab += j) {
-    a = *ptab++ * *t3++;
-    a += *ptab * *--t4;
-
-    *t1++ = *pp + a;
-    *t2++ = *pp++ - a;
-  }
+  // The first sine term pairs with lo rather than hi, so it's done here.
+  const float a = costab[0] * hi[0] + sintab[0] * lo[0];
+  out_lo[0] = lo[0] + a;
+  out_hi[0] = lo[0] - a;
+  kernels_->butterfly(lo, hi, costab, sintab, out_lo, out_hi, ndiv2);
 
-  std::copy(buf_(), buf_() + n, p + k);
+  std::copy(buf_(), buf_() + n, lo);
 }
@@ -25,6 +25,8 @@
 
 #include <QVector>
 
+struct FHTKernels;
+
 /**
  * Implementation of the Hartley Transform after Bracewell's discrete
  * algorithm. The algorithm is subject to US patent No. 4,646,256 (1987)
@@ -40,6 +42,9 @@ class FHT {
   QVector<float> buf_vector_;
   QVector<float> tab_vector_;
   QVector<int> log_vector_;
+  QVector<float> twiddle_vector_;
+
+  const FHTKernels* kernels_;
 
   float* buf_();
   float* tab_();
@@ -52,11 +57,21 @@ class FHT {
    */
   void makeCasTable();
 
+  /**
+   * Copy the parts of the cas table used by each level of the recursion
+   * into contiguous cosine and sine arrays, so the butterflies can be
+   * vectorised.  The level combining halves of size n starts at
+   * twiddle_vector_[2 * (n - 8)], n cosines followed by n sines.
+   */
+  void makeTwiddleTables();
+
   /**
    * Recursive in-place Hartley transform. For internal use only!
    */
   void _transform(float*, int, int);
 
+  void semiLogSpectrumFromPower2(float*);
+
  public:
   /**
    * Prepare transform for data sets with @f$2^n@f$ numbers, whereby @f$n@f$
@@ -68,6 +83,14 @@ class FHT {
   ~FHT();
   int sizeExp() const;
   int size() const;
+
+  /**
+   * The kernels this uses for its inner loops.  Defaults to the fastest
+   * ones the CPU supports, the benchmark and tests swap in others.
+   */
+  const FHTKernels* kernels() const { return kernels_; }
+  void set_kernels(const FHTKernels* kernels) { kernels_ = kernels; }
+
   void scale(float*, float);
 
   /**
@@ -87,6 +110,13 @@ class FHT {
    */
   void logSpectrum(float* out, float* p);
 
+  /**
+   * The same as logSpectrum, but for values that already went through
+   * power2, for when the transform is shared between several users.
+   * @see SpectrumService
+   */
+  void logSpectrumFromPower2(float* out, float* p);
+
   /**
    * Semi-logarithmic audio spectrum.
    */
@@ -97,6 +127,11 @@ class FHT {
    */
   void spectrum(float*);
 
+  /**
+   * Fourier spectrum of values that already went through power2.
+   */
+  void spectrumFromPower2(float*);
+
   /**
    * Calculates a mathematically correct FFT power spectrum.
    * If further scaling is applied later, use power2 instead
@@ -0,0 +1,352 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fhtkernels.h"
+
+#if defined(__SSE2__)
+#define FHT_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 isn't something we can assume at compile time, so those versions are
+// built with a target attribute and only used if the CPU says it has it.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FHT_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FHT_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// The scalar loops, starting at index i so the vector versions can use them
+// for whatever is left over at the end.
+
+void ScaleFrom(float* p, float d, int i, int n) {
+  for (; i < n; ++i) p[i] *= d;
+}
+
+void EwmaFrom(float* d, const float* s, float w, int i, int n) {
+  for (; i < n; ++i) d[i] = d[i] * w + s[i] * (1 - w);
+}
+
+void Power2From(float* p, int num, int i) {
+  for (; i < num / 2; ++i) {
+    const float q = p[num - i];
+    p[i] = p[i] * p[i] + q * q;
+  }
+}
+
+void DeinterleaveFrom(const float* in, float* even, float* odd, int i, int n) {
+  for (; i < n; ++i) {
+    even[i] = in[i * 2];
+    odd[i] = in[i * 2 + 1];
+  }
+}
+
+void ButterflyFrom(const float* lo, const float* hi, const float* cos,
+                   const float* sin, float* out_lo, float* out_hi, int i,
+                   int n) {
+  for (; i < n; ++i) {
+    const float a = cos[i] * hi[i] + sin[i] * hi[n - i];
+    out_lo[i] = lo[i] + a;
+    out_hi[i] = lo[i] - a;
+  }
+}
+
+void ScaleScalar(float* p, float d, int n) { ScaleFrom(p, d, 0, n); }
+
+void EwmaScalar(float* d, const float* s, float w, int n) {
+  EwmaFrom(d, s, w, 0, n);
+}
+
+void Power2Scalar(float* p, int num) {
+  p[0] = 2 * p[0] * p[0];
+  Power2From(p, num, 1);
+}
+
+void DeinterleaveScalar(const float* in, float* even, float* odd, int n) {
+  DeinterleaveFrom(in, even, odd, 0, n);
+}
+
+void ButterflyScalar(const float* lo, const float* hi, const float* cos,
+                     const float* sin, float* out_lo, float* out_hi, int n) {
+  ButterflyFrom(lo, hi, cos, sin, out_lo, out_hi, 1, n);
+}
+
+const FHTKernels kScalar = {"scalar",           ScaleScalar,    EwmaScalar,
+                            Power2Scalar,       DeinterleaveScalar,
+                            ButterflyScalar};
+
+#ifdef FHT_HAVE_SSE2
+
+inline __m128 ReverseSse2(__m128 v) {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+void ScaleSse2(float* p, float d, int n) {
+  const __m128 vd = _mm_set1_ps(d);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(p + i, _mm_mul_ps(_mm_loadu_ps(p + i), vd));
+  }
+  ScaleFrom(p, d, i, n);
+}
+
+void EwmaSse2(float* d, const float* s, float w, int n) {
+  const __m128 vw = _mm_set1_ps(w);
+  const __m128 vw1 = _mm_set1_ps(1 - w);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(d + i,
+                  _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(d + i), vw),
+                             _mm_mul_ps(_mm_loadu_ps(s + i), vw1)));
+  }
+  EwmaFrom(d, s, w, i, n);
+}
+
+void Power2Sse2(float* p, int num) {
+  p[0] = 2 * p[0] * p[0];
+  int i = 1;
+  for (; i + 4 <= num / 2; i += 4) {
+    const __m128 a = _mm_loadu_ps(p + i);
+    const __m128 b = ReverseSse2(_mm_loadu_ps(p + num - i - 3));
+    _mm_storeu_ps(p + i, _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)));
+  }
+  Power2From(p, num, i);
+}
+
+void DeinterleaveSse2(const float* in, float* even, float* odd, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_loadu_ps(in + i * 2);
+    const __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+    _mm_storeu_ps(even + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(odd + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  DeinterleaveFrom(in, even, odd, i, n);
+}
+
+void ButterflySse2(const float* lo, const float* hi, const float* cos,
+                   const float* sin, float* out_lo, float* out_hi, int n) {
+  int i = 1;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 hi_rev = ReverseSse2(_mm_loadu_ps(hi + n - i - 3));
+    const __m128 a =
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cos + i), _mm_loadu_ps(hi + i)),
+                   _mm_mul_ps(_mm_loadu_ps(sin + i), hi_rev));
+    const __m128 l = _mm_loadu_ps(lo + i);
+    _mm_storeu_ps(out_lo + i, _mm_add_ps(l, a));
+    _mm_storeu_ps(out_hi + i, _mm_sub_ps(l, a));
+  }
+  ButterflyFrom(lo, hi, cos, sin, out_lo, out_hi, i, n);
+}
+
+const FHTKernels kSse2 = {"sse2",     ScaleSse2,        EwmaSse2,
+                          Power2Sse2, DeinterleaveSse2, ButterflySse2};
+
+#endif  // FHT_HAVE_SSE2
+
+#ifdef FHT_HAVE_AVX2
+
+#define FHT_AVX2 __attribute__((target("avx2")))
+
+// The scalar tails are built without VEX encoding, so each of these clears
+// the upper halves of the registers before falling back to them.  Otherwise
+// every instruction in the tail pays for the AVX to SSE transition.
+
+FHT_AVX2 inline __m256 ReverseAvx2(__m256 v) {
+  return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+FHT_AVX2 void ScaleAvx2(float* p, float d, int n) {
+  const __m256 vd = _mm256_set1_ps(d);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(p + i, _mm256_mul_ps(_mm256_loadu_ps(p + i), vd));
+  }
+  _mm256_zeroupper();
+  ScaleFrom(p, d, i, n);
+}
+
+FHT_AVX2 void EwmaAvx2(float* d, const float* s, float w, int n) {
+  const __m256 vw = _mm256_set1_ps(w);
+  const __m256 vw1 = _mm256_set1_ps(1 - w);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(d + i,
+                     _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(d + i), vw),
+                                   _mm256_mul_ps(_mm256_loadu_ps(s + i), vw1)));
+  }
+  _mm256_zeroupper();
+  EwmaFrom(d, s, w, i, n);
+}
+
+FHT_AVX2 void Power2Avx2(float* p, int num) {
+  p[0] = 2 * p[0] * p[0];
+  int i = 1;
+  for (; i + 8 <= num / 2; i += 8) {
+    const __m256 a = _mm256_loadu_ps(p + i);
+    const __m256 b = ReverseAvx2(_mm256_loadu_ps(p + num - i - 7));
+    _mm256_storeu_ps(p + i,
+                     _mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b)));
+  }
+  _mm256_zeroupper();
+  Power2From(p, num, i);
+}
+
+FHT_AVX2 void DeinterleaveAvx2(const float* in, float* even, float* odd,
+                               int n) {
+  // Shuffling within each 128 bit lane leaves the results in the order
+  // 0 1 4 5 2 3 6 7, which the permute puts right.
+  const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 a = _mm256_loadu_ps(in + i * 2);
+    const __m256 b = _mm256_loadu_ps(in + i * 2 + 8);
+    _mm256_storeu_ps(even + i,
+                     _mm256_permutevar8x32_ps(
+                         _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                         order));
+    _mm256_storeu_ps(odd + i,
+                     _mm256_permutevar8x32_ps(
+                         _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)),
+                         order));
+  }
+  _mm256_zeroupper();
+  DeinterleaveFrom(in, even, odd, i, n);
+}
+
+FHT_AVX2 void ButterflyAvx2(const float* lo, const float* hi, const float* cos,
+                            const float* sin, float* out_lo, float* out_hi,
+                            int n) {
+  int i = 1;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 hi_rev = ReverseAvx2(_mm256_loadu_ps(hi + n - i - 7));
+    const __m256 a = _mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(cos + i), _mm256_loadu_ps(hi + i)),
+        _mm256_mul_ps(_mm256_loadu_ps(sin + i), hi_rev));
+    const __m256 l = _mm256_loadu_ps(lo + i);
+    _mm256_storeu_ps(out_lo + i, _mm256_add_ps(l, a));
+    _mm256_storeu_ps(out_hi + i, _mm256_sub_ps(l, a));
+  }
+  _mm256_zeroupper();
+  ButterflyFrom(lo, hi, cos, sin, out_lo, out_hi, i, n);
+}
+
+#undef FHT_AVX2
+
+const FHTKernels kAvx2 = {"avx2",     ScaleAvx2,        EwmaAvx2,
+                          Power2Avx2, DeinterleaveAvx2, ButterflyAvx2};
+
+bool CpuHasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif  // FHT_HAVE_AVX2
+
+#ifdef FHT_HAVE_NEON
+
+inline float32x4_t ReverseNeon(float32x4_t v) {
+  const float32x4_t r = vrev64q_f32(v);
+  return vcombine_f32(vget_high_f32(r), vget_low_f32(r));
+}
+
+void ScaleNeon(float* p, float d, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) vst1q_f32(p + i, vmulq_n_f32(vld1q_f32(p + i), d));
+  ScaleFrom(p, d, i, n);
+}
+
+void EwmaNeon(float* d, const float* s, float w, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(d + i, vaddq_f32(vmulq_n_f32(vld1q_f32(d + i), w),
+                               vmulq_n_f32(vld1q_f32(s + i), 1 - w)));
+  }
+  EwmaFrom(d, s, w, i, n);
+}
+
+void Power2Neon(float* p, int num) {
+  p[0] = 2 * p[0] * p[0];
+  int i = 1;
+  for (; i + 4 <= num / 2; i += 4) {
+    const float32x4_t a = vld1q_f32(p + i);
+    const float32x4_t b = ReverseNeon(vld1q_f32(p + num - i - 3));
+    vst1q_f32(p + i, vaddq_f32(vmulq_f32(a, a), vmulq_f32(b, b)));
+  }
+  Power2From(p, num, i);
+}
+
+void DeinterleaveNeon(const float* in, float* even, float* odd, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const float32x4x2_t v = vld2q_f32(in + i * 2);
+    vst1q_f32(even + i, v.val[0]);
+    vst1q_f32(odd + i, v.val[1]);
+  }
+  DeinterleaveFrom(in, even, odd, i, n);
+}
+
+void ButterflyNeon(const float* lo, const float* hi, const float* cos,
+                   const float* sin, float* out_lo, float* out_hi, int n) {
+  int i = 1;
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t hi_rev = ReverseNeon(vld1q_f32(hi + n - i - 3));
+    const float32x4_t a =
+        vaddq_f32(vmulq_f32(vld1q_f32(cos + i), vld1q_f32(hi + i)),
+                  vmulq_f32(vld1q_f32(sin + i), hi_rev));
+    const float32x4_t l = vld1q_f32(lo + i);
+    vst1q_f32(out_lo + i, vaddq_f32(l, a));
+    vst1q_f32(out_hi + i, vsubq_f32(l, a));
+  }
+  ButterflyFrom(lo, hi, cos, sin, out_lo, out_hi, i, n);
+}
+
+const FHTKernels kNeon = {"neon",     ScaleNeon,        EwmaNeon,
+                          Power2Neon, DeinterleaveNeon, ButterflyNeon};
+
+#endif  // FHT_HAVE_NEON
+
+}  // namespace
+
+const FHTKernels& FHTKernels::Scalar() { return kScalar; }
+
+QList<const FHTKernels*> FHTKernels::Available() {
+  QList<const FHTKernels*> ret;
+  ret << &kScalar;
+#ifdef FHT_HAVE_SSE2
+  ret << &kSse2;
+#endif
+#ifdef FHT_HAVE_AVX2
+  if (CpuHasAvx2()) ret << &kAvx2;
+#endif
+#ifdef FHT_HAVE_NEON
+  ret << &kNeon;
+#endif
+  return ret;
+}
+
+const FHTKernels& FHTKernels::Get() {
+  // Available() lists them slowest first.
+  static const FHTKernels* const kernels = Available().last();
+  return *kernels;
+}
@@ -0,0 +1,58 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYZERS_FHTKERNELS_H_
+#define ANALYZERS_FHTKERNELS_H_
+
+#include <QList>
+
+// The inner loops of FHT, with a plain C++ version and SSE2, AVX2 and NEON
+// versions where the compiler and CPU support them.  Get() picks the fastest
+// one the CPU running us supports, the first time it's called.
+struct FHTKernels {
+  const char* name;
+
+  // p[i] *= d for i in [0, n).
+  void (*scale)(float* p, float d, int n);
+
+  // d[i] = d[i] * w + s[i] * (1 - w) for i in [0, n).
+  void (*ewma)(float* d, const float* s, float w, int n);
+
+  // Turns a Hartley transform of size num into power values:
+  // p[0] = 2 p[0]^2 and p[i] = p[i]^2 + p[num - i]^2 for i in [1, num / 2).
+  void (*power2)(float* p, int num);
+
+  // Splits the 2n values in in into those at even indices, written to even,
+  // and those at odd indices, written to odd.
+  void (*deinterleave)(const float* in, float* even, float* odd, int n);
+
+  // The butterfly that combines the transforms lo and hi of the two halves of
+  // a data set into the transform of the whole.  For i in [1, n):
+  //   a = cos[i] * hi[i] + sin[i] * hi[n - i]
+  //   out_lo[i] = lo[i] + a, out_hi[i] = lo[i] - a
+  // i = 0 is left to the caller, it's the odd one out.
+  void (*butterfly)(const float* lo, const float* hi, const float* cos,
+                    const float* sin, float* out_lo, float* out_hi, int n);
+
+  static const FHTKernels& Get();
+  static const FHTKernels& Scalar();
+
+  // Every version the CPU running us supports, Scalar() first.
+  static QList<const FHTKernels*> Available();
+};
+
+#endif  // ANALYZERS_FHTKERNELS_H_
@@ -26,13 +26,15 @@
 
 #include <QPainter>
 
+#include "analyzerglhost.h"
+
 using Analyzer::Scope;
 
 const char* Sonogram::kName =
     QT_TRANSLATE_NOOP("AnalyzerContainer", "Sonogram");
 
 Sonogram::Sonogram(QWidget* parent)
-    : Analyzer::Base(parent, 9), scope_size_(128) {}
+    : Analyzer::Base(parent, 9), canvas_column_(0), scope_size_(128) {}
 
 Sonogram::~Sonogram() {}
 
@@ -44,8 +46,9 @@ void Sonogram::resizeEvent(QResizeEvent* e) {
   resizeForBands(height() < 128 ? 128 : height());
 #endif
 
-  canvas_ = QPixmap(size());
+  canvas_ = QImage(size(), QImage::Format_RGB32);
   canvas_.fill(palette().color(QPalette::Background));
+  canvas_column_ = width() - 1;
   updateBandSize(scope_size_);
 }
 
@@ -55,16 +58,36 @@ void Sonogram::psychedelicModeChanged(bool enabled) {
 }
 
 void Sonogram::analyze(QPainter& p, const Scope& s, bool new_frame) {
-  if (!new_frame || engine_->state() == Engine::Paused) {
-    p.drawPixmap(0, 0, canvas_);
-    return;
+  if (canvas_.isNull()) return;
+
+  if (new_frame && engine_->state() != Engine::Paused) {
+    const QVector<QRgb> column = makeColumn(s);
+    canvas_column_ = (canvas_column_ + 1) % canvas_.width();
+    for (int y = 0; y < column.size() && y < canvas_.height(); ++y) {
+      reinterpret_cast<QRgb*>(canvas_.scanLine(y))[canvas_column_] = column[y];
+    }
   }
 
-  int x = width() - 1;
-  QColor c;
+  // The oldest column is the one after the newest.
+  const int oldest = canvas_column_ + 1;
+  if (oldest < canvas_.width()) {
+    p.drawImage(0, 0, canvas_, oldest, 0, canvas_.width() - oldest, -1);
+  }
+  p.drawImage(canvas_.width() - oldest, 0, canvas_, 0, 0, oldest, -1);
+}
 
-  QPainter canvas_painter(&canvas_);
-  canvas_painter.drawPixmap(0, 0, canvas_, 1, 0, x, -1);
+bool Sonogram::analyzeGL(const Scope& s, bool new_frame) {
+  if (new_frame && engine_->state() != Engine::Paused) {
+    gl_host_->AddColumn(makeColumn(s),
+                        palette().color(QPalette::Background).rgb());
+  }
+  return gl_host_->DrawColumns();
+}
+
+QVector<QRgb> Sonogram::makeColumn(const Scope& s) {
+  const QColor background = palette().color(QPalette::Background);
+  QVector<QRgb> column(height(), background.rgb());
+  QColor c;
 
   Scope::const_iterator it = s.begin(), end = s.end();
   if (scope_size_ != s.size()) {
@@ -74,9 +97,9 @@ void Sonogram::analyze(QPainter& p, const Scope& s, bool new_frame) {
 
   if (psychedelic_enabled_) {
     c = getPsychedelicColor(s, 20, 100);
-    for (int y = height() - 1; y;) {
+    for (int y = height() - 1; y > 0; --y) {
       if (it >= end || *it < .005) {
-        c = palette().color(QPalette::Background);
+        c = background;
       } else if (*it < .05) {
         c.setHsv(c.hue(), c.saturation(), 255 - static_cast<int>(*it * 4000.0));
       } else if (*it < 1.0) {
@@ -85,15 +108,14 @@ void Sonogram::analyze(QPainter& p, const Scope& s, bool new_frame) {
         c = getPsychedelicColor(s, 10, 50);
       }
 
-      canvas_painter.setPen(c);
-      canvas_painter.drawPoint(x, y--);
+      column[y] = c.rgb();
 
       if (it < end) ++it;
     }
   } else {
-    for (int y = height() - 1; y;) {
+    for (int y = height() - 1; y > 0; --y) {
       if (it >= end || *it < .005)
-        c = palette().color(QPalette::Background);
+        c = background;
       else if (*it < .05)
         c.setHsv(95, 255, 255 - static_cast<int>(*it * 4000.0));
       else if (*it < 1.0)
@@ -101,24 +123,20 @@ void Sonogram::analyze(QPainter& p, const Scope& s, bool new_frame) {
       else
         c = Qt::red;
 
-      canvas_painter.setPen(c);
-      canvas_painter.drawPoint(x, y--);
+      column[y] = c.rgb();
 
       if (it < end) ++it;
     }
   }
 
-  canvas_painter.end();
-
-  p.drawPixmap(0, 0, canvas_);
+  return column;
 }
 
 void Sonogram::transform(Scope& scope) {
-  fht_->power2(scope.data());
   fht_->scale(scope.data(), 1.0 / 256);
   scope.resize(fht_->size() / 2);
 }
 
 void Sonogram::demo(QPainter& p) {
-  analyze(p, Scope(fht_->size(), 0), new_frame_);
+  analyzeFrame(p, Scope(fht_->size(), 0));
 }
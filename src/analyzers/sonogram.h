@@ -25,6 +25,9 @@
 #ifndef ANALYZERS_SONOGRAM_H_
 #define ANALYZERS_SONOGRAM_H_
 
+#include <QImage>
+#include <QVector>
+
 #include "analyzerbase.h"
 
 class Sonogram : public Analyzer::Base {
@@ -37,12 +40,19 @@ class Sonogram : public Analyzer::Base {
 
  protected:
   void analyze(QPainter& p, const Analyzer::Scope&, bool new_frame);
+  bool analyzeGL(const Analyzer::Scope&, bool new_frame);
   void transform(Analyzer::Scope&);
   void demo(QPainter& p);
   void resizeEvent(QResizeEvent*);
   void psychedelicModeChanged(bool);
 
-  QPixmap canvas_;
+  // The colours of a new column, top first.
+  QVector<QRgb> makeColumn(const Analyzer::Scope&);
+
+  // A ring of columns, so scrolling only has to write the new one.
+  QImage canvas_;
+  // Where the newest column is in canvas_
+  int canvas_column_;
   int scope_size_;
 };
 
@@ -22,16 +22,25 @@
 
 #include "application.h"
 
+#include <QElapsedTimer>
+#include <QPixmapCache>
 #include <QSettings>
+#include <QThread>
 #include <QTimer>
 
 #include "config.h"
 #include "core/appearance.h"
 #include "core/database.h"
+#include "core/databasemaintenance.h"
 #include "core/lazy.h"
+#include "core/logging.h"
+#include "core/memorybudget.h"
+#include "core/metricsexporter.h"
 #include "core/player.h"
 #include "core/tagreaderclient.h"
 #include "core/taskmanager.h"
+#include "core/trace.h"
+#include "core/warmupscheduler.h"
 #include "covers/albumcoverloader.h"
 #include "covers/coverproviders.h"
 #include "covers/currentartloader.h"
@@ -48,6 +57,7 @@
 #include "internet/podcasts/podcastupdater.h"
 #include "library/library.h"
 #include "library/librarybackend.h"
+#include "library/replaygainscanner.h"
 #include "moodbar/moodbarcontroller.h"
 #include "moodbar/moodbarloader.h"
 #include "networkremote/networkremote.h"
@@ -64,9 +74,11 @@
 #ifdef HAVE_MOODBAR
 #include "moodbar/moodbarcontroller.h"
 #include "moodbar/moodbarloader.h"
+#include "moodbar/moodbarprecomputer.h"
 #endif
 
 bool Application::kIsPortable = false;
+bool Application::kIsHeadless = false;
 const char* Application::kLegacyPortableDataDir = "data";
 const char* Application::kDefaultPortableDataDir = "clementine-data";
 const char* Application::kPortableDataDir = nullptr;
@@ -81,40 +93,87 @@ bool Application::DebugFeaturesEnabled() {
   return (showConsole == "1");
 }
 
+namespace {
+
+// Wraps a Lazy's init function to log how long the subsystem took to build.
+template <typename T>
+std::function<T*()> Timed(const char* name, std::function<T*()> init) {
+  return [=]() {
+    TRACE_SCOPE(name);
+    QElapsedTimer timer;
+    timer.start();
+    T* ret = init();
+    qLog(Debug) << "Built" << name << "in" << timer.elapsed() << "ms";
+    return ret;
+  };
+}
+
+// Builds a subsystem in the warm-up unless it's already been built.
+template <typename T>
+void WarmUp(WarmUpScheduler* scheduler, const char* name, const Lazy<T>* lazy) {
+  scheduler->Add(name, [=]() { return static_cast<bool>(*lazy); },
+                 [=]() { lazy->get(); });
+}
+
+}  // namespace
+
 class ApplicationImpl {
  public:
   ApplicationImpl(Application* app)
       : settings_timer_(app),
-        tag_reader_client_([=]() {
+        warm_up_(app),
+        memory_budget_(Timed<MemoryBudget>("MemoryBudget", [=]() {
+          MemoryBudget* budget = new MemoryBudget(app);
+          QObject::connect(app, SIGNAL(SettingsChanged()), budget,
+                           SLOT(ReloadSettings()));
+          // The one QPixmapCache is shared by the library, global search and
+          // the playlist delegates.
+          budget->Register("Pixmaps", QPixmapCache::cacheLimit() * 1024ll,
+                           nullptr, [](qint64 bytes) {
+                             QPixmapCache::setCacheLimit(bytes / 1024);
+                           });
+          return budget;
+        })),
+        tag_reader_client_(Timed<TagReaderClient>("TagReaderClient", [=]() {
           TagReaderClient* client = new TagReaderClient(app);
           app->MoveToNewThread(client);
           client->Start();
           return client;
-        }),
-        database_([=]() {
+        })),
+        database_(Timed<Database>("Database", [=]() {
           Database* db = new Database(app, app);
           app->MoveToNewThread(db);
           DoInAMinuteOrSo(db, SLOT(DoBackup()));
           return db;
-        }),
-        album_cover_loader_([=]() {
+        })),
+        database_maintenance_(Timed<DatabaseMaintenance>(
+            "DatabaseMaintenance", [=]() {
+              DatabaseMaintenance* maintenance =
+                  new DatabaseMaintenance(app, database_.get());
+              app->MoveToThread(maintenance, database_->thread());
+              return maintenance;
+            })),
+        album_cover_loader_(Timed<AlbumCoverLoader>("AlbumCoverLoader", [=]() {
           AlbumCoverLoader* loader = new AlbumCoverLoader(app);
+          loader->RegisterWithBudget(memory_budget_.get());
           app->MoveToNewThread(loader);
           return loader;
-        }),
-        playlist_backend_([=]() {
+        })),
+        playlist_backend_(Timed<PlaylistBackend>("PlaylistBackend", [=]() {
           PlaylistBackend* backend = new PlaylistBackend(app, app);
           app->MoveToThread(backend, database_->thread());
           return backend;
-        }),
-        podcast_backend_([=]() {
+        })),
+        podcast_backend_(Timed<PodcastBackend>("PodcastBackend", [=]() {
           PodcastBackend* backend = new PodcastBackend(app, app);
           app->MoveToThread(backend, database_->thread());
           return backend;
-        }),
-        appearance_([=]() { return new Appearance(app); }),
-        cover_providers_([=]() {
+        })),
+        appearance_(Timed<Appearance>(
+            "Appearance", [=]() { return new Appearance(app); })),
+        cover_providers_(Timed<CoverProviders>("CoverProviders", [=]() {
           CoverProviders* cover_providers = new CoverProviders(app);
+          cover_providers->LoadHistory();
           // Initialize the repository of cover providers.
           cover_providers->AddProvider(new MusicbrainzCoverProvider);
           cover_providers->AddProvider(new DiscogsCoverProvider);
@@ -122,61 +181,99 @@ class ApplicationImpl {
           cover_providers->AddProvider(new LastFmCoverProvider(app));
 #endif
           return cover_providers;
-        }),
-        task_manager_([=]() { return new TaskManager(app); }),
-        player_([=]() { return new Player(app, app); }),
-        playlist_manager_([=]() { return new PlaylistManager(app); }),
-        current_art_loader_([=]() { return new CurrentArtLoader(app, app); }),
-        global_search_([=]() { return new GlobalSearch(app, app); }),
-        internet_model_([=]() { return new InternetModel(app, app); }),
-        library_([=]() { return new Library(app, app); }),
-        device_manager_([=]() { return new DeviceManager(app, app); }),
-        podcast_updater_([=]() { return new PodcastUpdater(app, app); }),
-        podcast_deleter_([=]() {
+        })),
+        task_manager_(Timed<TaskManager>(
+            "TaskManager", [=]() { return new TaskManager(app); })),
+        player_(Timed<Player>(
+            "Player", [=]() { return new Player(app, app); })),
+        playlist_manager_(Timed<PlaylistManager>(
+            "PlaylistManager", [=]() { return new PlaylistManager(app); })),
+        current_art_loader_(Timed<CurrentArtLoader>(
+            "CurrentArtLoader",
+            [=]() { return new CurrentArtLoader(app, app); })),
+        global_search_(Timed<GlobalSearch>(
+            "GlobalSearch", [=]() { return new GlobalSearch(app, app); })),
+        internet_model_(Timed<InternetModel>(
+            "InternetModel", [=]() { return new InternetModel(app, app); })),
+        library_(Timed<Library>(
+            "Library", [=]() { return new Library(app, app); })),
+        device_manager_(Timed<DeviceManager>(
+            "DeviceManager", [=]() { return new DeviceManager(app, app); })),
+        podcast_updater_(Timed<PodcastUpdater>(
+            "PodcastUpdater", [=]() { return new PodcastUpdater(app, app); })),
+        podcast_deleter_(Timed<PodcastDeleter>("PodcastDeleter", [=]() {
           PodcastDeleter* deleter = new PodcastDeleter(app, app);
           app->MoveToNewThread(deleter);
           return deleter;
-        }),
-        podcast_downloader_([=]() { return new PodcastDownloader(app, app); }),
-        gpodder_sync_([=]() { return new GPodderSync(app, app); }),
-        moodbar_loader_([=]() {
+        })),
+        podcast_downloader_(Timed<PodcastDownloader>(
+            "PodcastDownloader",
+            [=]() { return new PodcastDownloader(app, app); })),
+        gpodder_sync_(Timed<GPodderSync>(
+            "GPodderSync", [=]() { return new GPodderSync(app, app); })),
+        moodbar_loader_(Timed<MoodbarLoader>("MoodbarLoader", [=]() {
 #ifdef HAVE_MOODBAR
           return new MoodbarLoader(app, app);
 #else
           return nullptr;
 #endif
-        }),
-        moodbar_controller_([=]() {
+        })),
+        moodbar_controller_(Timed<MoodbarController>(
+            "MoodbarController", [=]() {
 #ifdef HAVE_MOODBAR
           return new MoodbarController(app, app);
 #else
           return nullptr;
 #endif
-        }),
+        })),
+        moodbar_precomputer_(Timed<MoodbarPrecomputer>(
+            "MoodbarPrecomputer", [=]() {
+#ifdef HAVE_MOODBAR
+          return new MoodbarPrecomputer(app, app);
+#else
+          return nullptr;
+#endif
+        })),
+        metrics_exporter_(Timed<MetricsExporter>("MetricsExporter", [=]() {
+          MetricsExporter* exporter = new MetricsExporter(app);
+          QObject::connect(app, SIGNAL(SettingsChanged()), exporter,
+                           SLOT(ReloadSettings()));
+          return exporter;
+        })),
+        replaygain_scanner_(Timed<ReplayGainScanner>(
+            "ReplayGainScanner",
+            [=]() { return new ReplayGainScanner(app, app); })),
         // Since NetworkRemote is moved to a different thread and creates
         // timers there, it should also be deleted on that thread.
-        network_remote_(
-            [=]() {
-              NetworkRemote* remote = new NetworkRemote(app);
-              app->MoveToNewThread(remote);
-              return remote;
-            },
+        network_remote_(Timed<NetworkRemote>("NetworkRemote",
+                                             [=]() {
+                                               NetworkRemote* remote =
+                                                   new NetworkRemote(app);
+                                               app->MoveToNewThread(remote);
+                                               return remote;
+                                             }),
             [=](NetworkRemote* remote) { remote->deleteLater(); }),
-        network_remote_helper_([=]() { return new NetworkRemoteHelper(app); }),
-        scrobbler_([=]() {
+        network_remote_helper_(Timed<NetworkRemoteHelper>(
+            "NetworkRemoteHelper",
+            [=]() { return new NetworkRemoteHelper(app); })),
+        scrobbler_(Timed<Scrobbler>("Scrobbler", [=]() {
 #ifdef HAVE_LIBLASTFM
           return new LastFMService(app, app);
 #else
           return nullptr;
 #endif
-        }) {
+        })) {
   }
 
   QTimer settings_timer_;
   QSettings settings_;
+  WarmUpScheduler warm_up_;
 
+  // Before everything that registers with it, so it's deleted after them.
+  Lazy<MemoryBudget> memory_budget_;
   Lazy<TagReaderClient> tag_reader_client_;
   Lazy<Database> database_;
+  Lazy<DatabaseMaintenance> database_maintenance_;
   Lazy<AlbumCoverLoader> album_cover_loader_;
   Lazy<PlaylistBackend> playlist_backend_;
   Lazy<PodcastBackend> podcast_backend_;
@@ -196,6 +293,9 @@ class ApplicationImpl {
   Lazy<GPodderSync> gpodder_sync_;
   Lazy<MoodbarLoader> moodbar_loader_;
   Lazy<MoodbarController> moodbar_controller_;
+  Lazy<MoodbarPrecomputer> moodbar_precomputer_;
+  Lazy<MetricsExporter> metrics_exporter_;
+  Lazy<ReplayGainScanner> replaygain_scanner_;
   Lazy<NetworkRemote> network_remote_;
   Lazy<NetworkRemoteHelper> network_remote_helper_;
   Lazy<Scrobbler> scrobbler_;
@@ -203,12 +303,15 @@ class ApplicationImpl {
 
 Application::Application(QObject* parent)
     : QObject(parent), p_(new ApplicationImpl(this)) {
+  TRACE_SCOPE("Application::Application");
   setObjectName("Clementine Application");
 
   // Show the splash
-  splash_.reset(new Splash());
-  splash_->show();
-  QCoreApplication::processEvents();
+  if (!kIsHeadless) {
+    splash_.reset(new Splash());
+    splash_->show();
+    QCoreApplication::processEvents();
+  }
 
   // This must be before library_->Init();
   // In the constructor the helper waits for the signal
@@ -224,6 +327,25 @@ Application::Application(QObject* parent)
   p_->settings_timer_.setInterval(1000);
   p_->settings_timer_.setSingleShot(true);
   connect(&(p_->settings_timer_), SIGNAL(timeout()), SLOT(SaveSettings_()));
+
+  // Everything the main window needs to show itself is built on demand while
+  // it's being made.  These aren't, so they're left until it's been shown.
+  WarmUpScheduler* warm_up = &p_->warm_up_;
+  WarmUp(warm_up, "AlbumCoverLoader", &p_->album_cover_loader_);
+  WarmUp(warm_up, "CoverProviders", &p_->cover_providers_);
+  WarmUp(warm_up, "CurrentArtLoader", &p_->current_art_loader_);
+  WarmUp(warm_up, "PodcastBackend", &p_->podcast_backend_);
+  WarmUp(warm_up, "PodcastUpdater", &p_->podcast_updater_);
+  WarmUp(warm_up, "PodcastDeleter", &p_->podcast_deleter_);
+  WarmUp(warm_up, "PodcastDownloader", &p_->podcast_downloader_);
+  WarmUp(warm_up, "GPodderSync", &p_->gpodder_sync_);
+  WarmUp(warm_up, "DatabaseMaintenance", &p_->database_maintenance_);
+  WarmUp(warm_up, "ReplayGainScanner", &p_->replaygain_scanner_);
+  WarmUp(warm_up, "MetricsExporter", &p_->metrics_exporter_);
+#ifdef HAVE_MOODBAR
+  WarmUp(warm_up, "MoodbarLoader", &p_->moodbar_loader_);
+  WarmUp(warm_up, "MoodbarPrecomputer", &p_->moodbar_precomputer_);
+#endif
 }
 
 Application::~Application() {
@@ -257,15 +379,25 @@ void Application::MoveToThread(QObject* object, QThread* thread) {
   object->moveToThread(thread);
 }
 
+void Application::ShowSplashMessage(const QString& message) {
+  if (!splash_ || QThread::currentThread() != thread()) return;
+
+  // This paints straight away, there's no need to go back to the event loop.
+  splash_->showMessage(message, Qt::AlignHCenter | Qt::AlignBottom, Qt::white);
+}
+
 void Application::AddError(const QString& message) { emit ErrorAdded(message); }
 
 void Application::Starting() {
   qLog(Debug) << "Application starting";
+  trace::Instant("Application::Starting");
 
   // Hide the splash
   if (splash_) {
     splash_.reset();
   }
+
+  p_->warm_up_.Start();
 }
 
 QString Application::language_without_region() const {
@@ -300,6 +432,10 @@ CurrentArtLoader* Application::current_art_loader() const {
 
 Database* Application::database() const { return p_->database_.get(); }
 
+DatabaseMaintenance* Application::database_maintenance() const {
+  return p_->database_maintenance_.get();
+}
+
 DeviceManager* Application::device_manager() const {
   return p_->device_manager_.get();
 }
@@ -328,6 +464,10 @@ LibraryDirectoryModel* Application::directory_model() const {
 
 LibraryModel* Application::library_model() const { return library()->model(); }
 
+MemoryBudget* Application::memory_budget() const {
+  return p_->memory_budget_.get();
+}
+
 MoodbarController* Application::moodbar_controller() const {
   return p_->moodbar_controller_.get();
 }
@@ -336,6 +476,10 @@ MoodbarLoader* Application::moodbar_loader() const {
   return p_->moodbar_loader_.get();
 }
 
+MoodbarPrecomputer* Application::moodbar_precomputer() const {
+  return p_->moodbar_precomputer_.get();
+}
+
 NetworkRemoteHelper* Application::network_remote_helper() const {
   return p_->network_remote_helper_.get();
 }
@@ -370,6 +514,10 @@ PodcastUpdater* Application::podcast_updater() const {
   return p_->podcast_updater_.get();
 }
 
+ReplayGainScanner* Application::replaygain_scanner() const {
+  return p_->replaygain_scanner_.get();
+}
+
 Scrobbler* Application::scrobbler() const { return p_->scrobbler_.get(); }
 
 TagReaderClient* Application::tag_reader_client() const {
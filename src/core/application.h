@@ -36,6 +36,7 @@ class Console;
 class CoverProviders;
 class CurrentArtLoader;
 class Database;
+class DatabaseMaintenance;
 class DeviceManager;
 class GlobalSearch;
 class GPodderSync;
@@ -43,8 +44,10 @@ class InternetModel;
 class Library;
 class LibraryBackend;
 class LibraryModel;
+class MemoryBudget;
 class MoodbarController;
 class MoodbarLoader;
+class MoodbarPrecomputer;
 class NetworkRemote;
 class NetworkRemoteHelper;
 class Player;
@@ -54,6 +57,7 @@ class PodcastBackend;
 class PodcastDeleter;
 class PodcastDownloader;
 class PodcastUpdater;
+class ReplayGainScanner;
 class Scrobbler;
 class Splash;
 class TagReaderClient;
@@ -64,6 +68,8 @@ class Application : public QObject {
 
  public:
   static bool kIsPortable;
+  // Set by --headless, there's no main window, tray icon or splash.
+  static bool kIsHeadless;
   static const char* kPortableDataDir;
   static const char* kLegacyPortableDataDir;
   static const char* kDefaultPortableDataDir;
@@ -86,6 +92,7 @@ class Application : public QObject {
   CoverProviders* cover_providers() const;
   CurrentArtLoader* current_art_loader() const;
   Database* database() const;
+  DatabaseMaintenance* database_maintenance() const;
   DeviceManager* device_manager() const;
   GlobalSearch* global_search() const;
   GPodderSync* gpodder_sync() const;
@@ -94,8 +101,10 @@ class Application : public QObject {
   LibraryBackend* library_backend() const;
   LibraryDirectoryModel* directory_model() const;
   LibraryModel* library_model() const;
+  MemoryBudget* memory_budget() const;
   MoodbarController* moodbar_controller() const;
   MoodbarLoader* moodbar_loader() const;
+  MoodbarPrecomputer* moodbar_precomputer() const;
   NetworkRemoteHelper* network_remote_helper() const;
   NetworkRemote* network_remote() const;
   Player* player() const;
@@ -105,6 +114,7 @@ class Application : public QObject {
   PodcastDeleter* podcast_deleter() const;
   PodcastDownloader* podcast_downloader() const;
   PodcastUpdater* podcast_updater() const;
+  ReplayGainScanner* replaygain_scanner() const;
   Scrobbler* scrobbler() const;
   TagReaderClient* tag_reader_client() const;
   TaskManager* task_manager() const;
@@ -114,6 +124,10 @@ class Application : public QObject {
   void MoveToNewThread(QObject* object);
   void MoveToThread(QObject* object, QThread* thread);
 
+  // Shows a message on the splash screen while it's up, for slow parts of
+  // startup.  Does nothing outside the GUI thread.
+  void ShowSplashMessage(const QString& message);
+
  public slots:
   void Starting();
   void AddError(const QString& message);
@@ -0,0 +1,99 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bktree.h"
+
+#include <algorithm>
+
+void BKTree::Insert(const QString& term) {
+  if (nodes_.isEmpty()) {
+    Node root;
+    root.term_ = term;
+    nodes_ << root;
+    return;
+  }
+
+  int index = 0;
+  forever {
+    const int distance = Distance(term, nodes_[index].term_);
+    if (distance == 0) return;
+
+    QMap<int, int>::const_iterator child =
+        nodes_[index].children_.constFind(distance);
+    if (child == nodes_[index].children_.constEnd()) {
+      Node node;
+      node.term_ = term;
+      nodes_ << node;
+      nodes_[index].children_[distance] = nodes_.count() - 1;
+      return;
+    }
+    index = child.value();
+  }
+}
+
+QList<BKTree::Match> BKTree::Find(const QString& term,
+                                  int max_distance) const {
+  QList<Match> ret;
+  if (nodes_.isEmpty()) return ret;
+
+  QList<int> pending;
+  pending << 0;
+
+  while (!pending.isEmpty()) {
+    const Node& node = nodes_[pending.takeLast()];
+    const int distance = Distance(term, node.term_);
+    if (distance <= max_distance) {
+      ret << Match(node.term_, distance);
+    }
+
+    // By the triangle inequality, only children whose distance from this
+    // node is within max_distance of ours can match.
+    QMap<int, int>::const_iterator it =
+        node.children_.lowerBound(distance - max_distance);
+    for (; it != node.children_.constEnd() &&
+           it.key() <= distance + max_distance;
+         ++it) {
+      pending << it.value();
+    }
+  }
+
+  return ret;
+}
+
+int BKTree::Distance(const QString& a, const QString& b) {
+  if (a.isEmpty()) return b.length();
+  if (b.isEmpty()) return a.length();
+
+  // Only the previous row of the table is needed.
+  QVector<int> row(b.length() + 1);
+  for (int j = 0; j <= b.length(); ++j) {
+    row[j] = j;
+  }
+
+  for (int i = 1; i <= a.length(); ++i) {
+    int diagonal = row[0];
+    row[0] = i;
+    for (int j = 1; j <= b.length(); ++j) {
+      const int above = row[j];
+      const int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+      row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + cost});
+      diagonal = above;
+    }
+  }
+
+  return row[b.length()];
+}
@@ -0,0 +1,59 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_BKTREE_H_
+#define CORE_BKTREE_H_
+
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+// A BK-tree of strings under edit distance.  It finds the stored strings
+// within a few edits of a query without comparing the query against all of
+// them.  Strings can't be removed; callers that need that should keep their
+// own counts and ignore stale matches.
+class BKTree {
+ public:
+  typedef QPair<QString, int> Match;  // String and its distance
+
+  BKTree() {}
+
+  int count() const { return nodes_.count(); }
+  void Clear() { nodes_.clear(); }
+
+  // Does nothing if the string is already in the tree.
+  void Insert(const QString& term);
+
+  // Returns every string within max_distance edits of term.
+  QList<Match> Find(const QString& term, int max_distance) const;
+
+  // The Levenshtein distance between a and b.
+  static int Distance(const QString& a, const QString& b);
+
+ private:
+  struct Node {
+    QString term_;
+    // Index in nodes_ of the child at each distance from this node.
+    QMap<int, int> children_;
+  };
+
+  QVector<Node> nodes_;
+};
+
+#endif  // CORE_BKTREE_H_
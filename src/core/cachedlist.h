@@ -21,6 +21,8 @@
 #define CORE_CACHEDLIST_H_
 
 #include <QDateTime>
+#include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QSettings>
 #include <algorithm>
 
@@ -32,6 +34,10 @@ class CachedList {
   // T must be a registered metatype and must support being stored in
   // QSettings.  This usually means you have to implement QDataStream streaming
   // operators, and use qRegisterMetaTypeStreamOperators.
+  //
+  // A stale list is still there to be shown while it's refreshed.  The
+  // validators of the reply it came from are kept with it, so the refresh
+  // can be a conditional request that costs nothing if it hasn't changed.
 
   typedef QList<T> ListType;
 
@@ -46,6 +52,8 @@ class CachedList {
     s.beginGroup(settings_group_);
 
     last_updated_ = s.value("last_refreshed_" + name_).toDateTime();
+    etag_ = s.value("etag_" + name_).toByteArray();
+    last_modified_ = s.value("last_modified_" + name_).toByteArray();
     data_.clear();
 
     const int count = s.beginReadArray(name_ + "_data");
@@ -61,6 +69,8 @@ class CachedList {
     s.beginGroup(settings_group_);
 
     s.setValue("last_refreshed_" + name_, last_updated_);
+    s.setValue("etag_" + name_, etag_);
+    s.setValue("last_modified_" + name_, last_modified_);
 
     s.beginWriteArray(name_ + "_data", data_.size());
     for (int i = 0; i < data_.size(); ++i) {
@@ -76,6 +86,39 @@ class CachedList {
     Save();
   }
 
+  // Like Update, and remembers reply's validators for the next refresh.
+  void Update(const ListType& data, const QNetworkReply* reply) {
+    etag_ = reply->rawHeader("ETag");
+    last_modified_ = reply->rawHeader("Last-Modified");
+    Update(data);
+  }
+
+  // Makes req conditional on the list having changed since it was fetched.
+  // Does nothing if there's no list to fall back on.
+  void PrepareRequest(QNetworkRequest* req) const {
+    if (data_.isEmpty()) return;
+    if (!etag_.isEmpty()) req->setRawHeader("If-None-Match", etag_);
+    if (!last_modified_.isEmpty()) {
+      req->setRawHeader("If-Modified-Since", last_modified_);
+    }
+  }
+
+  // Returns true if reply says the list hasn't changed, in which case the
+  // cached list is fresh again.
+  bool NotModified(const QNetworkReply* reply) {
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() !=
+        304) {
+      return false;
+    }
+    last_updated_ = QDateTime::currentDateTime();
+    QSettings s;
+    s.beginGroup(settings_group_);
+    s.setValue("last_refreshed_" + name_, last_updated_);
+    return true;
+  }
+
+  bool IsEmpty() const { return data_.isEmpty(); }
+
   bool IsStale() const {
     return last_updated_.isNull() ||
            last_updated_.secsTo(QDateTime::currentDateTime()) >
@@ -98,6 +141,8 @@ class CachedList {
   const int cache_duration_secs_;
 
   QDateTime last_updated_;
+  QByteArray etag_;
+  QByteArray last_modified_;
   ListType data_;
 };
 
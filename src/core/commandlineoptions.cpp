@@ -70,9 +70,13 @@ const char* CommandlineOptions::kHelpText =
     "      --verbose               %31\n"
     "      --log-levels <levels>   %32\n"
     "      --version               %33\n"
-    "  -x, --delete-current        %34\n";
+    "  -x, --delete-current        %34\n"
+    "      --trace-startup <file>  %35\n"
+    "      --log-memory <MB>       %36\n"
+    "      --headless              %37\n";
 
 const char* CommandlineOptions::kVersionText = "Clementine %1";
+const int CommandlineOptions::kDefaultLogMemoryMb = 1;
 
 CommandlineOptions::CommandlineOptions(int argc, char** argv)
     : argc_(argc),
@@ -87,7 +91,9 @@ CommandlineOptions::CommandlineOptions(int argc, char** argv)
       delete_current_track_(false),
       show_osd_(false),
       toggle_pretty_osd_(false),
-      log_levels_(logging::kDefaultLogLevels) {
+      headless_(false),
+      log_levels_(logging::kDefaultLogLevels),
+      log_memory_mb_(kDefaultLogMemoryMb) {
 #ifdef Q_OS_DARWIN
   // Remove -psn_xxx option that Mac passes when opened from Finder.
   RemoveArg("-psn", 1);
@@ -141,6 +147,9 @@ bool CommandlineOptions::Parse() {
       {"log-levels", required_argument, 0, LogLevels},
       {"version", no_argument, 0, Version},
       {"delete-current", no_argument, 0, 'x'},
+      {"trace-startup", required_argument, 0, TraceStartup},
+      {"log-memory", required_argument, 0, LogMemory},
+      {"headless", no_argument, 0, Headless},
       {0, 0, 0, 0}};
 
   // Parse the arguments
@@ -188,7 +197,11 @@ bool CommandlineOptions::Parse() {
                      tr("Equivalent to --log-levels *:3"),
                      tr("Comma separated list of class:level, level is 0-3"))
                 .arg(tr("Print out version information"),
-                     tr("Delete the currently playing song"));
+                     tr("Delete the currently playing song"),
+                     tr("Write a Chrome trace of the startup to <file>"),
+                     tr("Keep the last <MB> of the log in memory for crash "
+                        "reports"),
+                     tr("Play without showing any windows"));
 
         std::cout << translated_help_text.toLocal8Bit().constData();
         return false;
@@ -253,6 +266,16 @@ bool CommandlineOptions::Parse() {
       case LogLevels:
         log_levels_ = QString(optarg);
         break;
+      case TraceStartup:
+        trace_startup_path_ = QFile::decodeName(optarg);
+        break;
+      case LogMemory:
+        log_memory_mb_ = QString(optarg).toInt(&ok);
+        if (!ok || log_memory_mb_ < 0) log_memory_mb_ = kDefaultLogMemoryMb;
+        break;
+      case Headless:
+        headless_ = true;
+        break;
       case Version: {
         QString version_text =
             QString(kVersionText).arg(CLEMENTINE_VERSION_DISPLAY);
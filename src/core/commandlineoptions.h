@@ -78,6 +78,10 @@ class CommandlineOptions {
   QString language() const { return language_; }
   QString log_levels() const { return log_levels_; }
   QString playlist_name() const { return playlist_name_; }
+  // Only for this process, it isn't sent to another instance.
+  QString trace_startup_path() const { return trace_startup_path_; }
+  int log_memory_mb() const { return log_memory_mb_; }
+  bool headless() const { return headless_; }
 
   QByteArray Serialize() const;
   void Load(const QByteArray& serialized);
@@ -96,9 +100,14 @@ class CommandlineOptions {
     Version,
     VolumeIncreaseBy,
     VolumeDecreaseBy,
-    RestartOrPrevious
+    RestartOrPrevious,
+    TraceStartup,
+    LogMemory,
+    Headless
   };
 
+  static const int kDefaultLogMemoryMb;
+
   QString tr(const char* source_text);
   void RemoveArg(const QString& starts_with, int count);
 
@@ -121,6 +130,9 @@ class CommandlineOptions {
   QString language_;
   QString log_levels_;
   QString playlist_name_;
+  QString trace_startup_path_;
+  int log_memory_mb_;
+  bool headless_;
 
   QList<QUrl> urls_;
 };
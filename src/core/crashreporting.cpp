@@ -38,6 +38,8 @@
 #include "core/logging.h"
 
 #if defined(HAVE_BREAKPAD) and defined(Q_OS_LINUX)
+#include <fcntl.h>
+
 #include "client/linux/handler/exception_handler.h"
 #include "third_party/lss/linux_syscall_support.h"
 #endif
@@ -87,6 +89,20 @@ bool CrashReporting::Handler(const char* dump_path, const char* minidump_id,
   Print(dump_path);
   Print("/");
   Print(minidump_id);
+
+  // The end of the log goes next to it.  Nothing here can allocate.
+  char log_path[4096];
+  if (snprintf(log_path, sizeof(log_path), "%s/%s.log", dump_path,
+               minidump_id) < static_cast<int>(sizeof(log_path))) {
+    const int fd = sys_open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd >= 0) {
+      logging::DumpMemoryLog(fd);
+      sys_close(fd);
+      Print("\nThe end of the log has been saved to:\n  ");
+      Print(log_path);
+    }
+  }
+
   Print(
       "\n\nPlease send this to the developers so they can fix the problem:\n"
       "  http://code.google.com/p/clementine-player/issues/entry\n\n");
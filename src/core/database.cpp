@@ -27,13 +27,22 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <memory>
+
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
 #include <QLibrary>
 #include <QLibraryInfo>
 #include <QSqlDriver>
+#include <QSettings>
 #include <QSqlQuery>
 #include <QThread>
+#include <QTimer>
 #include <QUrl>
 #include <QVariant>
 #include <QtDebug>
@@ -41,14 +50,45 @@
 
 #include "config.h"
 #include "core/application.h"
+#include "core/executor.h"
 #include "core/logging.h"
+#include "core/metrics.h"
 #include "core/taskmanager.h"
+#include "core/trace.h"
 #include "scopedtransaction.h"
 #include "utilities.h"
 
 const char* Database::kDatabaseFilename = "clementine.db";
-const int Database::kSchemaVersion = 51;
+const int Database::kSchemaVersion = 70;
 const char* Database::kMagicAllSongsTables = "%allsongstables";
+const char* Database::kMagicFtsModule = "%ftsmodule";
+const char* Database::kMagicFtsOptions = "%ftsoptions";
+const char* Database::kSettingsGroup = "Database";
+const int Database::kDefaultWalAutoCheckpoint = 1000;
+const qint64 Database::kWalJournalSizeLimit = 16 * 1024 * 1024;
+const int Database::kDefaultSlowQueryMsec = 100;
+const int Database::kMaxSlowQueries = 20;
+const int Database::kStatementCacheSize = 32;
+const int Database::kDefaultBackupCount = 3;
+const int Database::kDefaultBackupIntervalHours = 24;
+
+namespace {
+
+// The backup copies this many pages at a time to start with, then doubles
+// or halves it to keep each step close to kBackupStepMsec.
+const int kMinBackupStepPages = 16;
+const int kMaxBackupStepPages = 4096;
+const int kBackupStepMsec = 20;
+// Sleeps this long between steps so writers can get at the database.
+const int kBackupYieldMsec = 10;
+// sqlite starts the copy over when another connection writes to the
+// database.  After this many restarts the backup is left for the next check,
+// rather than copying the rest in one step that would keep writers out.
+const int kMaxBackupRestarts = 5;
+
+const int kBackupCheckIntervalMsec = 60 * 60 * 1000;  // 1 hour
+
+}  // namespace
 
 int Database::sNextConnectionId = 1;
 QMutex Database::sNextConnectionIdMutex;
@@ -214,7 +254,17 @@ Database::Database(Application* app, QObject* parent,
       mutex_(QMutex::Recursive),
       injected_database_name_(database_name),
       query_hash_(0),
-      startup_schema_version_(-1) {
+      startup_schema_version_(-1),
+      wal_enabled_(false),
+      wal_autocheckpoint_(kDefaultWalAutoCheckpoint),
+      slow_query_msec_(kDefaultSlowQueryMsec),
+      defer_fts_rebuild_(false),
+      backup_timer_(new QTimer(this)),
+      backup_abort_(0),
+      statement_cache_generation_(0),
+      statement_cache_hits_(0),
+      statement_cache_misses_(0) {
+  TRACE_SCOPE("Database::Database");
   setObjectName("Database");
   {
     QMutexLocker l(&sNextConnectionIdMutex);
@@ -227,11 +277,38 @@ Database::Database(Application* app, QObject* parent,
   attached_databases_["jamendo"] = AttachedDatabase(
       directory_ + "/jamendo.db", ":/schema/jamendo.sql", false);
 
+  // WAL needs a real file shared between connections, so it's never used for
+  // the in-memory databases the tests inject.
+  if (injected_database_name_.isNull()) {
+    QSettings s;
+    s.beginGroup(kSettingsGroup);
+    wal_enabled_ = s.value("wal", false).toBool();
+    wal_autocheckpoint_ =
+        s.value("wal_autocheckpoint", kDefaultWalAutoCheckpoint).toInt();
+    slow_query_msec_ =
+        s.value("slow_query_msec", kDefaultSlowQueryMsec).toInt();
+  }
+
+  backup_timer_->setInterval(kBackupCheckIntervalMsec);
+  connect(backup_timer_, SIGNAL(timeout()), SLOT(DoBackup()));
+
   QMutexLocker l(&mutex_);
   Connect();
 }
 
-QSqlDatabase Database::Connect() {
+Database::~Database() {
+  backup_abort_.store(1);
+  backup_future_.waitForFinished();
+}
+
+QSqlDatabase Database::Connect() { return DoConnect(false); }
+
+QSqlDatabase Database::ConnectReadOnly() {
+  if (!wal_enabled_) return Connect();
+  return DoConnect(true);
+}
+
+QSqlDatabase Database::DoConnect(bool read_only) {
   QMutexLocker l(&connect_mutex_);
 
   // Create the directory if it doesn't exist
@@ -241,10 +318,11 @@ QSqlDatabase Database::Connect() {
     }
   }
 
-  const QString connection_id =
+  QString connection_id =
       QString("%1_thread_%2")
           .arg(connection_id_)
           .arg(reinterpret_cast<quint64>(QThread::currentThread()));
+  if (read_only) connection_id += "_readonly";
 
   // Try to find an existing connection for this thread
   QSqlDatabase db = QSqlDatabase::database(connection_id);
@@ -259,6 +337,8 @@ QSqlDatabase Database::Connect() {
   else
     db.setDatabaseName(directory_ + "/" + kDatabaseFilename);
 
+  if (read_only) db.setConnectOptions("QSQLITE_OPEN_READONLY");
+
   if (!db.open()) {
     app_->AddError("Database: " + db.lastError().text());
     return db;
@@ -301,33 +381,35 @@ QSqlDatabase Database::Connect() {
     // to release any remaining database locks!
   }
 
+  if (read_only) {
+    // Read-only connections are only ever opened after the read-write one
+    // from the constructor, so the schema is already in place.
+    AttachDatabases(db);
+    return db;
+  }
+
   if (db.tables().count() == 0) {
     // Set up initial schema
     qLog(Info) << "Creating initial database schema";
     UpdateDatabaseSchema(0, db);
   }
 
-  // Attach external databases
-  for (const QString& key : attached_databases_.keys()) {
-    QString filename = attached_databases_[key].filename_;
-
-    if (!injected_database_name_.isNull()) filename = injected_database_name_;
-
-    // Attach the db
-    QSqlQuery q(db);
-    q.prepare("ATTACH DATABASE :filename AS :alias");
-    q.bindValue(":filename", filename);
-    q.bindValue(":alias", key);
-    if (!q.exec()) {
-      qFatal("Couldn't attach external database '%s'",
-             key.toLatin1().constData());
-    }
-  }
+  AttachDatabases(db);
 
   if (startup_schema_version_ == -1) {
+    // The journal mode is persistent in the database file, so it only needs
+    // setting once, before any other connection has it open.
+    SetJournalMode(db);
     UpdateMainSchema(&db);
   }
 
+  if (wal_enabled_) {
+    // Durable across application crashes, only a power loss can roll back the
+    // last few transactions.
+    QSqlQuery q("PRAGMA synchronous = NORMAL", db);
+    q.exec();
+  }
+
   // We might have to initialise the schema in some attached databases now, if
   // they were deleted and don't match up with the main schema version.
   for (const QString& key : attached_databases_.keys()) {
@@ -348,7 +430,57 @@ QSqlDatabase Database::Connect() {
   return db;
 }
 
+void Database::AttachDatabases(QSqlDatabase& db) {
+  // Attach external databases
+  for (const QString& key : attached_databases_.keys()) {
+    QString filename = attached_databases_[key].filename_;
+
+    if (!injected_database_name_.isNull()) filename = injected_database_name_;
+
+    // Attach the db
+    QSqlQuery q(db);
+    q.prepare("ATTACH DATABASE :filename AS :alias");
+    q.bindValue(":filename", filename);
+    q.bindValue(":alias", key);
+    if (!q.exec()) {
+      qFatal("Couldn't attach external database '%s'",
+             key.toLatin1().constData());
+    }
+  }
+}
+
+void Database::SetJournalMode(QSqlDatabase& db) {
+  if (!injected_database_name_.isNull()) return;
+
+  // Without a schema name this applies to the attached databases too.
+  const QString mode = wal_enabled_ ? "WAL" : "DELETE";
+  QSqlQuery q(db);
+  if (!q.exec("PRAGMA journal_mode = " + mode) || !q.next() ||
+      q.value(0).toString().compare(mode, Qt::CaseInsensitive) != 0) {
+    qLog(Warning) << "Couldn't set journal mode to" << mode;
+    q.finish();
+    wal_enabled_ = false;
+    return;
+  }
+  q.finish();
+
+  if (!wal_enabled_) return;
+
+  qLog(Info) << "Using write-ahead logging, autocheckpoint every"
+             << wal_autocheckpoint_ << "pages";
+  q.exec(QString("PRAGMA wal_autocheckpoint = %1").arg(wal_autocheckpoint_));
+  q.finish();
+  q.exec(QString("PRAGMA journal_size_limit = %1").arg(kWalJournalSizeLimit));
+  q.finish();
+
+  // Fold whatever the last run left in the log back into the database so the
+  // -wal file doesn't keep growing across sessions.
+  q.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
 void Database::UpdateMainSchema(QSqlDatabase* db) {
+  TRACE_SCOPE("Database::UpdateMainSchema");
+
   // Get the database's schema version
   int schema_version = 0;
   {
@@ -365,12 +497,42 @@ void Database::UpdateMainSchema(QSqlDatabase* db) {
                   << ") is newer than I was expecting";
     return;
   }
-  if (schema_version < kSchemaVersion) {
-    // Update the schema
-    for (int v = schema_version + 1; v <= kSchemaVersion; ++v) {
-      UpdateDatabaseSchema(v, *db);
+  if (schema_version >= kSchemaVersion) return;
+
+  qLog(Info) << "Updating the database schema from version" << schema_version
+             << "to" << kSchemaVersion;
+  QElapsedTimer timer;
+  timer.start();
+
+  // One transaction for the lot is much quicker than one for each version,
+  // and the full text indexes, which some versions drop and fill again, are
+  // only filled once at the end.
+  ScopedTransaction t(db);
+  defer_fts_rebuild_ = true;
+
+  const int count = kSchemaVersion - schema_version;
+  for (int v = schema_version + 1; v <= kSchemaVersion; ++v) {
+    if (app_) {
+      app_->ShowSplashMessage(tr("Updating the database (%1 of %2)...")
+                                  .arg(v - schema_version)
+                                  .arg(count));
     }
+    UpdateDatabaseSchema(v, *db, true);
   }
+
+  defer_fts_rebuild_ = false;
+  if (!fts_rebuild_command_.isEmpty()) {
+    if (app_) app_->ShowSplashMessage(tr("Rebuilding the search index..."));
+    qLog(Info) << "Rebuilding the full text indexes";
+    ExecSongTablesCommands(*db, SongsTables(*db, kSchemaVersion),
+                           QStringList() << fts_rebuild_command_);
+    fts_rebuild_command_.clear();
+  }
+
+  t.Commit();
+  if (app_) app_->ShowSplashMessage(QString());
+
+  qLog(Info) << "Updated the database schema in" << timer.elapsed() << "ms";
 }
 
 void Database::RecreateAttachedDb(const QString& database_name) {
@@ -401,6 +563,7 @@ void Database::RecreateAttachedDb(const QString& database_name) {
   // We can't just re-attach the database now because it needs to be done for
   // each thread.  Close all the database connections, so each thread will
   // re-attach it when they next connect.
+  ClearStatementCache();
   for (const QString& name : QSqlDatabase::connectionNames()) {
     QSqlDatabase::removeDatabase(name);
   }
@@ -444,7 +607,10 @@ void Database::DetachDatabase(const QString& database_name) {
   attached_databases_.remove(database_name);
 }
 
-void Database::UpdateDatabaseSchema(int version, QSqlDatabase& db) {
+void Database::UpdateDatabaseSchema(int version, QSqlDatabase& db,
+                                    bool in_transaction) {
+  TRACE_SCOPE(QString("Database schema %1").arg(version));
+
   QString filename;
   if (version == 0)
     filename = ":/schema/schema.sql";
@@ -454,7 +620,8 @@ void Database::UpdateDatabaseSchema(int version, QSqlDatabase& db) {
   if (version == 31) {
     // This version used to do a bad job of converting filenames in the songs
     // table to file:// URLs.  Now we do it properly here instead.
-    ScopedTransaction t(&db);
+    std::unique_ptr<ScopedTransaction> t;
+    if (!in_transaction) t.reset(new ScopedTransaction(&db));
 
     UrlEncodeFilenameColumn("songs", db);
     UrlEncodeFilenameColumn("playlist_items", db);
@@ -467,14 +634,30 @@ void Database::UpdateDatabaseSchema(int version, QSqlDatabase& db) {
     qLog(Debug) << "Applying database schema update" << version << "from"
                 << filename;
     ExecSchemaCommandsFromFile(db, filename, version - 1, true);
-    t.Commit();
+    if (t) t->Commit();
+  } else if (version == 55 && !HasFts5(db)) {
+    // This version moves the full text indexes to FTS5, which isn't compiled
+    // into every sqlite.  The FTS3 tables keep working, the queries
+    // LibraryQuery makes are valid for both.
+    qLog(Warning) << "sqlite doesn't support FTS5, keeping the FTS3 indexes";
+    QSqlQuery q(db);
+    q.exec("UPDATE schema_version SET version=55");
+    CheckErrors(q);
   } else {
     qLog(Debug) << "Applying database schema update" << version << "from"
                 << filename;
-    ExecSchemaCommandsFromFile(db, filename, version - 1);
+    ExecSchemaCommandsFromFile(db, filename, version - 1, in_transaction);
   }
 }
 
+bool Database::HasFts5(QSqlDatabase& db) {
+  QSqlQuery q(db);
+  if (!q.exec("CREATE VIRTUAL TABLE temp.fts5_probe USING fts5(x)"))
+    return false;
+  q.exec("DROP TABLE temp.fts5_probe");
+  return true;
+}
+
 void Database::UrlEncodeFilenameColumn(const QString& table, QSqlDatabase& db) {
   QSqlQuery select(db);
   select.prepare(QString("SELECT ROWID, filename FROM %1").arg(table));
@@ -514,8 +697,20 @@ void Database::ExecSchemaCommandsFromFile(QSqlDatabase& db,
 
 void Database::ExecSchemaCommands(QSqlDatabase& db, const QString& schema,
                                   int schema_version, bool in_transaction) {
+  // Schema files that create full text indexes from scratch get FTS5 where
+  // sqlite has it, and fall back to FTS3 with our own tokenizer otherwise.
+  QString expanded(schema);
+  if (expanded.contains(kMagicFtsModule)) {
+    const bool fts5 = HasFts5(db);
+    expanded.replace(kMagicFtsModule, fts5 ? "fts5" : "fts3");
+    expanded.replace(kMagicFtsOptions,
+                     fts5 ? "tokenize = 'unicode61 remove_diacritics 1', "
+                            "prefix = '1 2 3'"
+                          : "tokenize=unicode");
+  }
+
   // Run each command
-  const QStringList commands(schema.split(QRegExp("; *\n\n")));
+  const QStringList commands(expanded.split(QRegExp("; *\n\n")));
 
   // We don't want this list to reflect possible DB schema changes
   // so we initialize it before executing any statements.
@@ -537,7 +732,27 @@ void Database::ExecSchemaCommands(QSqlDatabase& db, const QString& schema,
 void Database::ExecSongTablesCommands(QSqlDatabase& db,
                                       const QStringList& song_tables,
                                       const QStringList& commands) {
+  const QString fts_tables = QString(kMagicAllSongsTables) + "_fts";
+  bool drops_fts_tables = false;
   for (const QString& command : commands) {
+    if (command.trimmed().startsWith("DROP TABLE " + fts_tables)) {
+      drops_fts_tables = true;
+    }
+  }
+
+  for (const QString& command : commands) {
+    if (defer_fts_rebuild_) {
+      // Emptying an index that's about to be dropped is a waste of time too.
+      const QString trimmed = command.trimmed();
+      if (trimmed.startsWith("INSERT INTO " + fts_tables)) {
+        fts_rebuild_command_ = command;
+        continue;
+      }
+      if (drops_fts_tables && trimmed.startsWith("DELETE FROM " + fts_tables)) {
+        continue;
+      }
+    }
+
     // There are now lots of "songs" tables that need to have the same schema:
     // songs, magnatune_songs, and device_*_songs.  We allow a magic value
     // in the schema files to update all songs tables at once.
@@ -608,16 +823,196 @@ bool Database::CheckErrors(const QSqlQuery& query) {
   return false;
 }
 
-bool Database::IntegrityCheck(QSqlDatabase db) {
+void Database::RecordQueryTime(const QSqlQuery& query, QSqlDatabase& db,
+                               qint64 msec) {
+  static metrics::Histogram* query_time = metrics::GetHistogram(
+      "clementine_database_query_seconds", "How long library queries took");
+  query_time->ObserveUsec(msec * 1000);
+
+  // A threshold of 0 or less turns the log off.
+  if (slow_query_msec_ <= 0 || msec < slow_query_msec_) return;
+  if (query.lastError().isValid()) return;
+
+  const QString sql = query.lastQuery();
+  const QString bound = BoundQuery(query);
+
+  QMutexLocker l(&slow_queries_mutex_);
+  auto it = slow_queries_.find(sql);
+  if (it == slow_queries_.end()) {
+    // Make room by forgetting the fastest entry, unless this one is faster
+    // still.
+    if (slow_queries_.count() >= kMaxSlowQueries) {
+      auto fastest = slow_queries_.begin();
+      for (auto i = slow_queries_.begin(); i != slow_queries_.end(); ++i) {
+        if (i->slowest_msec_ < fastest->slowest_msec_) fastest = i;
+      }
+      if (fastest->slowest_msec_ >= msec) return;
+      slow_queries_.erase(fastest);
+    }
+    it = slow_queries_.insert(sql, SlowQuery());
+  }
+
+  it->count_++;
+  it->total_msec_ += msec;
+
+  // Only explain the query the first time it's seen, or when it gets slower,
+  // so a query that's always slow doesn't pay for the plan every time.
+  if (msec > it->slowest_msec_ || it->plan_.isEmpty()) {
+    it->slowest_msec_ = qMax(it->slowest_msec_, msec);
+    it->sql_ = bound;
+    it->plan_ = QueryPlan(query, db);
+
+    qLog(Warning) << "Slow query took" << msec << "ms:" << bound;
+    qLog(Warning) << "Query plan:" << it->plan_;
+  }
+}
+
+QList<Database::SlowQuery> Database::SlowQueries() const {
+  QMutexLocker l(&slow_queries_mutex_);
+  QList<SlowQuery> ret = slow_queries_.values();
+  std::sort(ret.begin(), ret.end(), [](const SlowQuery& a, const SlowQuery& b) {
+    return a.slowest_msec_ > b.slowest_msec_;
+  });
+  return ret;
+}
+
+std::shared_ptr<QSqlQuery> Database::CachedQuery(QSqlDatabase& db,
+                                                const QString& sql) {
+  const QString connection = db.connectionName();
+  QSqlQuery* query = nullptr;
+  int generation = 0;
+
+  {
+    QMutexLocker l(&statement_cache_mutex_);
+    generation = statement_cache_generation_;
+    StatementCache& cache = statement_caches_[connection];
+    auto it = cache.queries_.find(sql);
+    if (it != cache.queries_.end()) {
+      // Whoever has it out takes it off the free list, so two users of the
+      // same SQL at once get a statement each.
+      query = new QSqlQuery(it.value());
+      cache.queries_.erase(it);
+      cache.order_.removeOne(sql);
+    }
+  }
+
+  static metrics::Counter* hits = metrics::GetCounter(
+      "clementine_database_statement_cache_hits_total",
+      "Queries that reused a prepared statement");
+  static metrics::Counter* misses = metrics::GetCounter(
+      "clementine_database_statement_cache_misses_total",
+      "Queries that had to prepare their statement");
+
+  if (query) {
+    statement_cache_hits_.ref();
+    hits->Increment();
+  } else {
+    statement_cache_misses_.ref();
+    misses->Increment();
+    query = new QSqlQuery(db);
+    query->prepare(sql);
+  }
+
+  return std::shared_ptr<QSqlQuery>(
+      query, [this, connection, sql, generation](QSqlQuery* query) {
+        ReturnCachedQuery(connection, sql, generation, query);
+      });
+}
+
+void Database::ReturnCachedQuery(const QString& connection, const QString& sql,
+                                 int generation, QSqlQuery* query) {
+  // Finishing it lets go of the read lock its results hold.
+  query->finish();
+
+  if (!query->lastError().isValid()) {
+    QMutexLocker l(&statement_cache_mutex_);
+    StatementCache& cache = statement_caches_[connection];
+    if (generation == statement_cache_generation_ &&
+        !cache.queries_.contains(sql)) {
+      cache.queries_.insert(sql, *query);
+      cache.order_ << sql;
+
+      if (cache.order_.count() > kStatementCacheSize) {
+        cache.queries_.remove(cache.order_.takeFirst());
+      }
+    }
+  }
+
+  delete query;
+}
+
+void Database::ClearStatementCache() {
+  QMutexLocker l(&statement_cache_mutex_);
+  statement_caches_.clear();
+  statement_cache_generation_++;
+}
+
+QString Database::QueryPlan(const QSqlQuery& query, QSqlDatabase& db) const {
+  QSqlQuery plan(db);
+  if (!plan.prepare("EXPLAIN QUERY PLAN " + query.lastQuery())) {
+    return plan.lastError().text();
+  }
+  const int values = query.boundValues().count();
+  for (int i = 0; i < values; ++i) {
+    plan.bindValue(i, query.boundValue(i));
+  }
+  if (!plan.exec()) return plan.lastError().text();
+
+  // The columns are id, parent, notused and detail.
+  QStringList lines;
+  while (plan.next()) {
+    lines << plan.value(3).toString();
+  }
+  return lines.join("\n");
+}
+
+QString Database::BoundQuery(const QSqlQuery& query) {
+  QString sql = query.lastQuery();
+  const int values = query.boundValues().count();
+
+  int pos = 0;
+  for (int i = 0; i < values; ++i) {
+    pos = sql.indexOf('?', pos);
+    if (pos == -1) break;
+
+    const QVariant value = query.boundValue(i);
+    QString literal;
+    if (value.isNull()) {
+      literal = "NULL";
+    } else if (value.type() == QVariant::String ||
+               value.type() == QVariant::ByteArray) {
+      literal = "'" + value.toString().replace("'", "''") + "'";
+    } else {
+      literal = value.toString();
+    }
+
+    sql.replace(pos, 1, literal);
+    pos += literal.length();
+  }
+  return sql;
+}
+
+bool Database::IntegrityCheck(sqlite3* connection) {
   qLog(Debug) << "Starting database integrity check";
   int task_id = app_->task_manager()->StartTask(tr("Integrity check"));
 
+  // quick_check skips matching the indexes against their tables, which is
+  // most of the time a full integrity_check takes.
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(connection, "PRAGMA quick_check(10)", -1, &stmt,
+                         nullptr) != SQLITE_OK) {
+    qLog(Error) << "Failed to start database integrity check:"
+                << sqlite3_errmsg(connection);
+    app_->task_manager()->SetTaskFinished(task_id);
+    return false;
+  }
+
   bool ok = false;
   bool error_reported = false;
   // Ask for 10 error messages at most.
-  QSqlQuery q("PRAGMA integrity_check(10)", db);
-  while (q.next()) {
-    QString message = q.value(0).toString();
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    QString message = QString::fromUtf8(
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
 
     // If no errors are found, a single row with the value "ok" is returned
     if (message == "ok") {
@@ -635,6 +1030,7 @@ bool Database::IntegrityCheck(QSqlDatabase db) {
       error_reported = true;
     }
   }
+  sqlite3_finalize(stmt);
 
   app_->task_manager()->SetTaskFinished(task_id);
 
@@ -642,15 +1038,31 @@ bool Database::IntegrityCheck(QSqlDatabase db) {
 }
 
 void Database::DoBackup() {
-  QSqlDatabase db(this->Connect());
-
-  // Before we overwrite anything, make sure the database is not corrupt
-  QMutexLocker l(&mutex_);
-  const bool ok = IntegrityCheck(db);
-
-  if (ok) {
-    BackupFile(db.databaseName());
+  // The tests' in-memory databases have nothing to back up.
+  if (!injected_database_name_.isNull()) return;
+
+  if (!backup_timer_->isActive()) backup_timer_->start();
+  if (backup_future_.isRunning()) return;
+
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  const int count = s.value("backup_count", kDefaultBackupCount).toInt();
+  const int interval_hours =
+      s.value("backup_interval_hours", kDefaultBackupIntervalHours).toInt();
+  if (count <= 0) return;
+
+  const QString filename = directory_ + "/" + kDatabaseFilename;
+  const QFileInfo last_backup(BackupFilename(filename, 0));
+  if (last_backup.exists() &&
+      last_backup.lastModified().secsTo(QDateTime::currentDateTime()) <
+          interval_hours * 60 * 60) {
+    return;
   }
+
+  // The backup has connections of its own and doesn't need mutex_, so
+  // nothing else has to wait for it.
+  backup_future_ = Executor::Io()->Run<void>(
+      [this, filename, count]() { BackupFile(filename, count); });
 }
 
 bool Database::OpenDatabase(const QString& filename,
@@ -669,20 +1081,25 @@ bool Database::OpenDatabase(const QString& filename,
   return true;
 }
 
-void Database::BackupFile(const QString& filename) {
+QString Database::BackupFilename(const QString& filename, int index) {
+  if (index == 0) return filename + ".bak";
+  return QString("%1.bak.%2").arg(filename).arg(index);
+}
+
+void Database::BackupFile(const QString& filename, int count) {
   qLog(Debug) << "Starting database backup";
-  QString dest_filename = QString("%1.bak").arg(filename);
-  const int task_id =
-      app_->task_manager()->StartTask(tr("Backing up database"));
+  // Written next to the backups and only put in their place once it's
+  // complete, so a failed backup doesn't cost us the last good one.
+  const QString dest_filename = filename + ".bak.tmp";
+  QFile::remove(dest_filename);
 
   sqlite3* source_connection = nullptr;
   sqlite3* dest_connection = nullptr;
 
-  BOOST_SCOPE_EXIT((&source_connection)(&dest_connection)(task_id)(app_)) {
+  BOOST_SCOPE_EXIT((&source_connection)(&dest_connection)) {
     // Harmless to call sqlite3_close() with a nullptr pointer.
     sqlite3_close(source_connection);
     sqlite3_close(dest_connection);
-    app_->task_manager()->SetTaskFinished(task_id);
   }
   BOOST_SCOPE_EXIT_END
 
@@ -691,6 +1108,11 @@ void Database::BackupFile(const QString& filename) {
     return;
   }
 
+  // Before we replace anything, make sure the database is not corrupt
+  if (!IntegrityCheck(source_connection)) {
+    return;
+  }
+
   success = OpenDatabase(dest_filename, &dest_connection);
   if (!success) {
     return;
@@ -704,17 +1126,78 @@ void Database::BackupFile(const QString& filename) {
     return;
   }
 
+  const int task_id =
+      app_->task_manager()->StartTask(tr("Backing up database"));
+  QElapsedTimer timer;
+  timer.start();
+
   int ret = SQLITE_OK;
-  do {
-    ret = sqlite3_backup_step(backup, 16);
+  int step_pages = kMinBackupStepPages;
+  int restarts = 0;
+  int last_remaining = -1;
+  bool postponed = false;
+  forever {
+    if (backup_abort_.load()) {
+      ret = SQLITE_ABORT;
+      break;
+    }
+
+    QElapsedTimer step_timer;
+    step_timer.start();
+    ret = sqlite3_backup_step(backup, step_pages);
+    const qint64 step_msec = step_timer.elapsed();
+
     const int page_count = sqlite3_backup_pagecount(backup);
-    app_->task_manager()->SetTaskProgress(
-        task_id, page_count - sqlite3_backup_remaining(backup), page_count);
-  } while (ret == SQLITE_OK);
+    const int remaining = sqlite3_backup_remaining(backup);
+    if (ret != SQLITE_DONE && last_remaining != -1 &&
+        remaining > last_remaining && ++restarts == kMaxBackupRestarts) {
+      postponed = true;
+      break;
+    }
+    last_remaining = remaining;
+    app_->task_manager()->SetTaskProgress(task_id, page_count - remaining,
+                                          page_count);
 
-  if (ret != SQLITE_DONE) {
-    qLog(Error) << "Database backup failed";
+    if (ret != SQLITE_OK && ret != SQLITE_BUSY && ret != SQLITE_LOCKED) break;
+
+    if (step_msec * 2 < kBackupStepMsec) {
+      step_pages = qMin(step_pages * 2, kMaxBackupStepPages);
+    } else if (step_msec > kBackupStepMsec) {
+      step_pages = qMax(step_pages / 2, kMinBackupStepPages);
+    }
+    QThread::msleep(kBackupYieldMsec);
   }
 
   sqlite3_backup_finish(backup);
+  sqlite3_close(dest_connection);
+  dest_connection = nullptr;
+  app_->task_manager()->SetTaskFinished(task_id);
+
+  if (postponed) {
+    // The last backup keeps its mtime, so DoBackup tries again next time.
+    qLog(Info) << "Database keeps changing during the backup, trying again"
+               << "later";
+    QFile::remove(dest_filename);
+    return;
+  }
+  if (ret != SQLITE_DONE) {
+    if (ret != SQLITE_ABORT) qLog(Error) << "Database backup failed";
+    QFile::remove(dest_filename);
+    return;
+  }
+
+  // Keep count backups, newest first.  Any beyond that, from when the
+  // setting was higher, go.
+  for (int i = count; QFile::exists(BackupFilename(filename, i)); ++i) {
+    QFile::remove(BackupFilename(filename, i));
+  }
+  for (int i = count - 1; i > 0; --i) {
+    QFile::remove(BackupFilename(filename, i));
+    QFile::rename(BackupFilename(filename, i - 1), BackupFilename(filename, i));
+  }
+  QFile::remove(BackupFilename(filename, 0));
+  QFile::rename(dest_filename, BackupFilename(filename, 0));
+
+  qLog(Info) << "Backed up the database in" << timer.elapsed() << "ms, after"
+             << restarts << "restarts";
 }
@@ -26,12 +26,16 @@
 
 #include <sqlite3.h>
 
+#include <QAtomicInt>
+#include <QFuture>
 #include <QMap>
 #include <QMutex>
 #include <QObject>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QSqlQuery>
 #include <QStringList>
+#include <memory>
 
 #include "gtest/gtest_prod.h"
 
@@ -42,6 +46,7 @@ struct sqlite3_tokenizer_module;
 }
 
 class Application;
+class QTimer;
 
 class Database : public QObject {
   Q_OBJECT
@@ -49,6 +54,7 @@ class Database : public QObject {
  public:
   Database(Application* app, QObject* parent = nullptr,
            const QString& database_name = QString());
+  ~Database();
 
   struct AttachedDatabase {
     AttachedDatabase() {}
@@ -64,10 +70,55 @@ class Database : public QObject {
   static const int kSchemaVersion;
   static const char* kDatabaseFilename;
   static const char* kMagicAllSongsTables;
+  static const char* kMagicFtsModule;
+  static const char* kMagicFtsOptions;
+  static const char* kSettingsGroup;
+  static const int kDefaultWalAutoCheckpoint;
+  static const qint64 kWalJournalSizeLimit;
+  static const int kDefaultSlowQueryMsec;
+  static const int kMaxSlowQueries;
+  static const int kStatementCacheSize;
+  static const int kDefaultBackupCount;
+  static const int kDefaultBackupIntervalHours;
+
+  // A query that took longer than the "slow_query_msec" setting.  Repeats of
+  // the same SQL are folded into one entry.
+  struct SlowQuery {
+    SlowQuery() : count_(0), slowest_msec_(0), total_msec_(0) {}
+
+    QString sql_;   // With the values of the slowest run bound in
+    QString plan_;  // Output of EXPLAIN QUERY PLAN
+    int count_;
+    qint64 slowest_msec_;
+    qint64 total_msec_;
+  };
 
   QSqlDatabase Connect();
+  // Returns a connection that is only used for SELECTs.  With write-ahead
+  // logging enabled this is separate from the thread's read-write connection
+  // and readers don't need to hold Mutex(), so pair it with ReadMutex().
+  // Without WAL it's the same as Connect().
+  QSqlDatabase ConnectReadOnly();
   bool CheckErrors(const QSqlQuery& query);
+  // Call after running query on db.  Slow queries are logged along with their
+  // query plan and remembered for SlowQueries().
+  void RecordQueryTime(const QSqlQuery& query, QSqlDatabase& db, qint64 msec);
+  // The slowest queries seen since startup, slowest first.
+  QList<SlowQuery> SlowQueries() const;
+
+  // Returns a query on db prepared with sql.  Each connection keeps its
+  // last kStatementCacheSize statements, so SQL that's run again doesn't
+  // have to be prepared again.  The query goes back in the cache when the
+  // last copy of the pointer goes, so bind every value before each exec().
+  std::shared_ptr<QSqlQuery> CachedQuery(QSqlDatabase& db, const QString& sql);
+  // How many CachedQuery calls found their statement ready, and how many
+  // prepared a new one.
+  int statement_cache_hits() const { return statement_cache_hits_.load(); }
+  int statement_cache_misses() const { return statement_cache_misses_.load(); }
   QMutex* Mutex() { return &mutex_; }
+  // Null when readers can run alongside writers.  QMutexLocker accepts null.
+  QMutex* ReadMutex() { return wal_enabled_ ? nullptr : &mutex_; }
+  bool wal_enabled() const { return wal_enabled_; }
 
   void RecreateAttachedDb(const QString& database_name);
   void ExecSchemaCommands(QSqlDatabase& db, const QString& schema,
@@ -87,9 +138,21 @@ class Database : public QObject {
   void Error(const QString& message);
 
  public slots:
+  // Backs the database up in the background if the last backup is older
+  // than the "backup_interval_hours" setting, and checks again every hour.
   void DoBackup();
 
+ protected:
+  // Has to be called before connections are removed, the cached statements
+  // would keep them open.
+  void ClearStatementCache();
+
  private:
+  QSqlDatabase DoConnect(bool read_only);
+  void ReturnCachedQuery(const QString& connection, const QString& sql,
+                         int generation, QSqlQuery* query);
+  void AttachDatabases(QSqlDatabase& db);
+  void SetJournalMode(QSqlDatabase& db);
   void UpdateMainSchema(QSqlDatabase* db);
 
   void ExecSchemaCommandsFromFile(QSqlDatabase& db, const QString& filename,
@@ -98,12 +161,17 @@ class Database : public QObject {
   void ExecSongTablesCommands(QSqlDatabase& db, const QStringList& song_tables,
                               const QStringList& commands);
 
-  void UpdateDatabaseSchema(int version, QSqlDatabase& db);
+  void UpdateDatabaseSchema(int version, QSqlDatabase& db,
+                            bool in_transaction = false);
+  bool HasFts5(QSqlDatabase& db);
   void UrlEncodeFilenameColumn(const QString& table, QSqlDatabase& db);
   QStringList SongsTables(QSqlDatabase& db, int schema_version) const;
-  bool IntegrityCheck(QSqlDatabase db);
-  void BackupFile(const QString& filename);
+  bool IntegrityCheck(sqlite3* connection);
+  void BackupFile(const QString& filename, int count);
+  static QString BackupFilename(const QString& filename, int index);
   bool OpenDatabase(const QString& filename, sqlite3** connection) const;
+  QString QueryPlan(const QSqlQuery& query, QSqlDatabase& db) const;
+  static QString BoundQuery(const QSqlQuery& query);
 
   Application* app_;
 
@@ -130,6 +198,38 @@ class Database : public QObject {
   // This is the schema version of Clementine's DB from the app's last run.
   int startup_schema_version_;
 
+  bool wal_enabled_;
+  int wal_autocheckpoint_;
+
+  int slow_query_msec_;
+
+  // While UpdateMainSchema is applying a batch of schema versions, the
+  // commands that fill the songs tables' full text indexes are put off and
+  // only the last one is run, once, at the end.
+  bool defer_fts_rebuild_;
+  QString fts_rebuild_command_;
+  mutable QMutex slow_queries_mutex_;
+  // Unbound SQL -> stats
+  QMap<QString, SlowQuery> slow_queries_;
+
+  // The free statements of one connection, most recently used last.
+  struct StatementCache {
+    QMap<QString, QSqlQuery> queries_;
+    QStringList order_;
+  };
+  QMutex statement_cache_mutex_;
+  // Connection name -> its statements
+  QMap<QString, StatementCache> statement_caches_;
+  // Bumped by ClearStatementCache, queries taken out before that aren't
+  // put back.
+  int statement_cache_generation_;
+  QAtomicInt statement_cache_hits_;
+  QAtomicInt statement_cache_misses_;
+
+  QTimer* backup_timer_;
+  QFuture<void> backup_future_;
+  QAtomicInt backup_abort_;
+
   FRIEND_TEST(DatabaseTest, FTSOpenParsesSimpleInput);
   FRIEND_TEST(DatabaseTest, FTSOpenParsesUTF8Input);
   FRIEND_TEST(DatabaseTest, FTSOpenParsesMultipleTokens);
@@ -184,6 +284,7 @@ class MemoryDatabase : public Database {
       : Database(app, parent, ":memory:") {}
   ~MemoryDatabase() {
     // Make sure Qt doesn't reuse the same database
+    ClearStatementCache();
     QSqlDatabase::removeDatabase(Connect().connectionName());
   }
 };
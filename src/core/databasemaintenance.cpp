@@ -0,0 +1,391 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "databasemaintenance.h"
+
+#include <sqlite3.h>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimerEvent>
+
+#include "core/application.h"
+#include "core/database.h"
+#include "core/logging.h"
+#include "core/player.h"
+#include "core/taskmanager.h"
+#include "core/utilities.h"
+
+const int DatabaseMaintenance::kIdleMsec = 10 * 60 * 1000;  // 10 minutes
+const int DatabaseMaintenance::kIntervalDays = 7;
+const int DatabaseMaintenance::kStepIntervalMsec = 2000;
+const int DatabaseMaintenance::kVacuumPagesPerStep = 1024;
+
+namespace {
+
+// How many sqlite virtual machine instructions go by between checks for an
+// interruption.
+const int kProgressHandlerInstructions = 1000;
+
+sqlite3* SqliteHandle(QSqlDatabase& db) {
+  QVariant v = db.driver()->handle();
+  if (!v.isValid() || qstrcmp(v.typeName(), "sqlite3*") != 0) return nullptr;
+  return *static_cast<sqlite3**>(v.data());
+}
+
+}  // namespace
+
+DatabaseMaintenance::DatabaseMaintenance(Application* app, Database* db,
+                                         QObject* parent)
+    : QObject(parent),
+      app_(app),
+      db_(db),
+      enabled_(false),
+      on_battery_(false),
+      playing_(false),
+      running_(false),
+      task_id_(-1),
+      step_(Step_QuickCheck),
+      step_msec_(0),
+      fts_tables_loaded_(false),
+      interrupted_(0) {
+  if (!app_) return;
+
+  playing_ = app_->player()->GetState() == Engine::Playing;
+
+  connect(app_, SIGNAL(SettingsChanged()), SLOT(ReloadSettings()));
+  connect(app_->player(), SIGNAL(Playing()), SLOT(Interrupt()),
+          Qt::DirectConnection);
+  connect(app_->player(), SIGNAL(Playing()), SLOT(PlaybackStarted()));
+  connect(app_->player(), SIGNAL(Paused()), SLOT(PlaybackIdle()));
+  connect(app_->player(), SIGNAL(Stopped()), SLOT(PlaybackIdle()));
+
+  // We're about to be moved to the database's thread, which is where the
+  // timers have to be started.
+  QMetaObject::invokeMethod(this, "ReloadSettings", Qt::QueuedConnection);
+}
+
+QString DatabaseMaintenance::StepName(Step step) {
+  switch (step) {
+    case Step_QuickCheck:
+      return "quick_check";
+    case Step_Analyze:
+      return "analyze";
+    case Step_MergeFts:
+      return "merge_fts";
+    case Step_Vacuum:
+      return "vacuum";
+    case Step_Done:
+      break;
+  }
+  return QString();
+}
+
+void DatabaseMaintenance::ReloadSettings() {
+  QSettings s;
+  s.beginGroup(Database::kSettingsGroup);
+  enabled_ = s.value("maintenance", true).toBool();
+  on_battery_ = s.value("maintenance_on_battery", false).toBool();
+
+  if (!enabled_) {
+    idle_timer_.stop();
+    Pause();
+  } else if (!running_ && !playing_ && !idle_timer_.isActive()) {
+    idle_timer_.start(kIdleMsec, this);
+  }
+}
+
+void DatabaseMaintenance::PlaybackStarted() {
+  playing_ = true;
+  idle_timer_.stop();
+  Pause();
+}
+
+void DatabaseMaintenance::PlaybackIdle() {
+  playing_ = false;
+  if (enabled_ && !running_) idle_timer_.start(kIdleMsec, this);
+}
+
+void DatabaseMaintenance::timerEvent(QTimerEvent* e) {
+  if (e->timerId() == idle_timer_.timerId()) {
+    idle_timer_.stop();
+    if (!enabled_) return;
+
+    if (IsDue() && AllowedToRun()) {
+      Start();
+    } else {
+      // Look again later, we might be plugged in by then.
+      idle_timer_.start(kIdleMsec, this);
+    }
+  } else if (e->timerId() == step_timer_.timerId()) {
+    if (!AllowedToRun()) {
+      Pause();
+      idle_timer_.start(kIdleMsec, this);
+      return;
+    }
+
+    if (!RunStep()) {
+      Finish();
+    } else if (interrupted_.load()) {
+      Pause();
+    }
+  } else {
+    QObject::timerEvent(e);
+  }
+}
+
+bool DatabaseMaintenance::IsDue() const {
+  QSettings s;
+  s.beginGroup(Database::kSettingsGroup);
+  const QDateTime last_run = s.value("maintenance_last_run").toDateTime();
+
+  // A job that was interrupted carries on whenever it can.
+  return step_ != Step_QuickCheck || !last_run.isValid() ||
+         last_run.daysTo(QDateTime::currentDateTime()) >= kIntervalDays;
+}
+
+bool DatabaseMaintenance::AllowedToRun() const {
+  return enabled_ && !playing_ && (on_battery_ || !Utilities::IsOnBattery());
+}
+
+void DatabaseMaintenance::Start() {
+  if (running_) return;
+  running_ = true;
+  interrupted_.store(0);
+
+  if (step_ == Step_Done) step_ = Step_QuickCheck;
+  qLog(Info) << "Starting database maintenance at" << StepName(step_);
+
+  if (app_) {
+    task_id_ = app_->task_manager()->StartTask(tr("Optimizing database"));
+    app_->task_manager()->SetTaskProgress(task_id_, step_, Step_Done);
+  }
+  step_timer_.start(kStepIntervalMsec, this);
+}
+
+void DatabaseMaintenance::Interrupt() { interrupted_.store(1); }
+
+void DatabaseMaintenance::Pause() {
+  step_timer_.stop();
+  if (!running_) return;
+  running_ = false;
+
+  qLog(Info) << "Pausing database maintenance at" << StepName(step_);
+  if (app_) app_->task_manager()->SetTaskFinished(task_id_);
+  task_id_ = -1;
+}
+
+void DatabaseMaintenance::Finish() {
+  step_timer_.stop();
+  running_ = false;
+  fts_tables_loaded_ = false;
+
+  QSettings s;
+  s.beginGroup(Database::kSettingsGroup);
+  s.setValue("maintenance_last_run", QDateTime::currentDateTime());
+
+  qLog(Info) << "Database maintenance finished";
+  if (app_) app_->task_manager()->SetTaskFinished(task_id_);
+  task_id_ = -1;
+
+  emit Finished();
+}
+
+bool DatabaseMaintenance::RunStep() {
+  if (step_ == Step_Done) return false;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  bool step_done = true;
+  bool corrupt = false;
+  {
+    QMutexLocker l(db_->Mutex());
+    QSqlDatabase db(db_->Connect());
+
+    // Lets Interrupt() stop a statement part way through.  Whatever it was
+    // doing is rolled back.
+    sqlite3* handle = SqliteHandle(db);
+    if (handle) {
+      sqlite3_progress_handler(handle, kProgressHandlerInstructions,
+                               &ProgressHandler, this);
+    }
+
+    switch (step_) {
+      case Step_QuickCheck:
+        corrupt = !QuickCheck(db);
+        break;
+      case Step_Analyze:
+        Analyze(db);
+        break;
+      case Step_MergeFts:
+        step_done = MergeFts(db);
+        break;
+      case Step_Vacuum:
+        step_done = Vacuum(db);
+        break;
+      case Step_Done:
+        break;
+    }
+
+    if (handle) sqlite3_progress_handler(handle, 0, nullptr, nullptr);
+  }
+  step_msec_ += timer.elapsed();
+
+  if (interrupted_.load()) return true;
+
+  if (corrupt) {
+    // Rewriting a damaged database could only make things worse.
+    step_ = Step_Done;
+    step_msec_ = 0;
+    return false;
+  }
+
+  if (step_done) {
+    qLog(Info) << "Database maintenance:" << StepName(step_) << "took"
+               << step_msec_ << "ms";
+
+    QSettings s;
+    s.beginGroup(Database::kSettingsGroup);
+    s.setValue(QString("maintenance_%1_msec").arg(StepName(step_)),
+               step_msec_);
+
+    step_ = Step(step_ + 1);
+    step_msec_ = 0;
+    if (app_ && task_id_ != -1) {
+      app_->task_manager()->SetTaskProgress(task_id_, step_, Step_Done);
+    }
+  }
+
+  return step_ != Step_Done;
+}
+
+int DatabaseMaintenance::ProgressHandler(void* self) {
+  return reinterpret_cast<DatabaseMaintenance*>(self)->interrupted_.load();
+}
+
+bool DatabaseMaintenance::Exec(QSqlQuery* q, const QString& sql) {
+  if (q->exec(sql)) return true;
+
+  if (!interrupted_.load()) {
+    qLog(Warning) << "Database maintenance:" << sql << "failed:"
+                  << q->lastError().text();
+  }
+  return false;
+}
+
+bool DatabaseMaintenance::QuickCheck(QSqlDatabase& db) {
+  // Ask for 10 error messages at most.
+  QSqlQuery q(db);
+  if (!Exec(&q, "PRAGMA quick_check(10)")) return true;
+
+  QStringList errors;
+  while (q.next()) {
+    const QString message = q.value(0).toString();
+    // If no errors are found, a single row with the value "ok" is returned
+    if (message == "ok") return true;
+    errors << message;
+  }
+  if (interrupted_.load() || errors.isEmpty()) return true;
+
+  for (const QString& error : errors) {
+    qLog(Error) << "Database quick check:" << error;
+  }
+  if (app_) {
+    app_->AddError(
+        tr("Database corruption detected. Please read "
+           "https://github.com/clementine-player/Clementine/wiki/"
+           "Database-Corruption "
+           "for instructions on how to recover your database"));
+  }
+  return false;
+}
+
+void DatabaseMaintenance::Analyze(QSqlDatabase& db) {
+  QSqlQuery q(db);
+  Exec(&q, "SELECT 1 FROM sqlite_master WHERE name = 'sqlite_stat1'");
+  const bool analyzed = q.next();
+  q.finish();
+
+  // optimize only analyzes tables whose statistics look out of date, so the
+  // whole database needs doing once first.
+  if (!analyzed && !Exec(&q, "ANALYZE")) return;
+  q.finish();
+
+  // Does nothing in sqlite older than 3.18.
+  Exec(&q, "PRAGMA optimize");
+}
+
+bool DatabaseMaintenance::MergeFts(QSqlDatabase& db) {
+  QSqlQuery q(db);
+
+  if (!fts_tables_loaded_) {
+    if (!Exec(&q,
+              "SELECT name FROM sqlite_master WHERE type = 'table'"
+              " AND sql LIKE 'CREATE VIRTUAL TABLE % USING fts%'")) {
+      return true;
+    }
+    fts_tables_.clear();
+    while (q.next()) fts_tables_ << q.value(0).toString();
+    q.finish();
+    fts_tables_loaded_ = true;
+  }
+
+  // One index each time, the big ones can take a while.
+  if (!fts_tables_.isEmpty()) {
+    const QString table = fts_tables_.first();
+    // The same for FTS3, FTS4 and FTS5.
+    if (Exec(&q, QString("INSERT INTO %1(%1) VALUES('optimize')").arg(table)) ||
+        !interrupted_.load()) {
+      fts_tables_.removeFirst();
+    }
+  }
+
+  return fts_tables_.isEmpty();
+}
+
+bool DatabaseMaintenance::Vacuum(QSqlDatabase& db) {
+  QSqlQuery q(db);
+  Exec(&q, "PRAGMA auto_vacuum");
+  const int auto_vacuum = q.next() ? q.value(0).toInt() : 0;
+  q.finish();
+
+  // 2 is INCREMENTAL.  Changing it only takes effect after a full VACUUM.
+  if (auto_vacuum != 2) {
+    qLog(Info) << "Switching the database to incremental auto vacuum";
+    if (Exec(&q, "PRAGMA auto_vacuum = INCREMENTAL")) {
+      q.finish();
+      Exec(&q, "VACUUM");
+    }
+    return true;
+  }
+
+  // Each row frees another page.
+  if (Exec(&q, QString("PRAGMA incremental_vacuum(%1)")
+                   .arg(kVacuumPagesPerStep))) {
+    while (q.next()) {
+    }
+  }
+  q.finish();
+
+  Exec(&q, "PRAGMA freelist_count");
+  return !q.next() || q.value(0).toInt() == 0;
+}
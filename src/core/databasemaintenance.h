@@ -0,0 +1,133 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_DATABASEMAINTENANCE_H_
+#define CORE_DATABASEMAINTENANCE_H_
+
+#include <QAtomicInt>
+#include <QBasicTimer>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QStringList>
+
+class QSqlQuery;
+
+class Application;
+class Database;
+
+// Keeps the database in shape once a week or so, while nothing is playing:
+//
+//  1. PRAGMA quick_check, so nothing below rewrites a damaged database.
+//  2. ANALYZE the first time, PRAGMA optimize after, so the query planner's
+//     statistics follow the library as it grows.
+//  3. Merges the segments of each full text index into one.
+//  4. Gives free pages back to the filesystem with an incremental vacuum.
+//     The first run switches the database to auto_vacuum=INCREMENTAL, which
+//     takes one full VACUUM.
+//
+// Steps run one at a time with a pause in between, each holding the database
+// mutex.  Playback starting interrupts the running statement straight away
+// and the job carries on from the same step the next time things are idle.
+// It doesn't run on battery unless the "maintenance_on_battery" setting says
+// it may.  How long each step took is logged and kept in the settings.
+//
+// Lives in the database's thread.
+class DatabaseMaintenance : public QObject {
+  Q_OBJECT
+
+ public:
+  // app may be null, then it's only ever run through Start() and RunStep().
+  DatabaseMaintenance(Application* app, Database* db,
+                      QObject* parent = nullptr);
+
+  static const int kIdleMsec;
+  static const int kIntervalDays;
+  static const int kStepIntervalMsec;
+  static const int kVacuumPagesPerStep;
+
+  enum Step {
+    Step_QuickCheck,
+    Step_Analyze,
+    Step_MergeFts,
+    Step_Vacuum,
+    Step_Done,
+  };
+  static QString StepName(Step step);
+
+  Step step() const { return step_; }
+  bool is_running() const { return running_; }
+
+  // Does some of the current step and returns true if there's more to do.
+  // Stops early, leaving the step to be done again, if Interrupt() is called.
+  bool RunStep();
+
+ public slots:
+  // Starts now, whatever the time since the last run.
+  void Start();
+  // Stops what's running now and anything else until the next Start().
+  // Thread safe, so playback starting is connected to it directly.
+  void Interrupt();
+
+ signals:
+  void Finished();
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private slots:
+  void ReloadSettings();
+  void PlaybackStarted();
+  void PlaybackIdle();
+
+ private:
+  bool IsDue() const;
+  bool AllowedToRun() const;
+  void Pause();
+  void Finish();
+
+  // Runs sql, logging why it failed unless it was interrupted.
+  bool Exec(QSqlQuery* q, const QString& sql);
+
+  bool QuickCheck(QSqlDatabase& db);
+  void Analyze(QSqlDatabase& db);
+  bool MergeFts(QSqlDatabase& db);
+  bool Vacuum(QSqlDatabase& db);
+
+  static int ProgressHandler(void* self);
+
+  Application* app_;
+  Database* db_;
+
+  bool enabled_;
+  bool on_battery_;
+  bool playing_;
+
+  QBasicTimer idle_timer_;
+  QBasicTimer step_timer_;
+  bool running_;
+  int task_id_;
+
+  Step step_;
+  qint64 step_msec_;
+  // Full text indexes left to merge.
+  QStringList fts_tables_;
+  bool fts_tables_loaded_;
+
+  QAtomicInt interrupted_;
+};
+
+#endif  // CORE_DATABASEMAINTENANCE_H_
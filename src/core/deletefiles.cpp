@@ -19,11 +19,16 @@
 
 #include "deletefiles.h"
 
+#include <QFuture>
+#include <QMessageBox>
+#include <QPushButton>
 #include <QStringList>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrl>
 
+#include "core/concurrentrun.h"
 #include "musicstorage.h"
 #include "taskmanager.h"
 
@@ -35,6 +40,7 @@ DeleteFiles::DeleteFiles(TaskManager* task_manager,
       task_manager_(task_manager),
       storage_(storage),
       started_(false),
+      use_trash_(false),
       task_id_(0),
       progress_(0) {
   original_thread_ = thread();
@@ -42,6 +48,32 @@ DeleteFiles::DeleteFiles(TaskManager* task_manager,
 
 DeleteFiles::~DeleteFiles() {}
 
+bool DeleteFiles::ConfirmDeleteFromDisk(QWidget* parent, bool* use_trash) {
+  *use_trash = false;
+
+#ifdef Q_OS_LINUX
+  QMessageBox box(QMessageBox::Warning, tr("Delete files"),
+                  tr("These files can be moved to the trash, or permanently "
+                     "deleted from disk."),
+                  QMessageBox::Cancel, parent);
+  QPushButton* trash =
+      box.addButton(tr("Move to trash"), QMessageBox::AcceptRole);
+  QPushButton* remove =
+      box.addButton(tr("Delete permanently"), QMessageBox::DestructiveRole);
+  box.setDefaultButton(trash);
+  box.exec();
+
+  *use_trash = box.clickedButton() == trash;
+  return box.clickedButton() == trash || box.clickedButton() == remove;
+#else
+  return QMessageBox::warning(parent, tr("Delete files"),
+                              tr("These files will be permanently deleted from "
+                                 "disk, are you sure you want to continue?"),
+                              QMessageBox::Yes,
+                              QMessageBox::Cancel) == QMessageBox::Yes;
+#endif
+}
+
 void DeleteFiles::Start(const SongList& songs) {
   if (thread_) return;
 
@@ -87,10 +119,11 @@ void DeleteFiles::ProcessSomeFiles() {
   if (progress_ >= songs_.count()) {
     task_manager_->SetTaskProgress(task_id_, progress_, songs_.count());
 
-    storage_->FinishCopy(songs_with_errors_.isEmpty());
+    storage_->FinishDelete(songs_with_errors_.isEmpty());
 
     task_manager_->SetTaskFinished(task_id_);
 
+    if (!songs_deleted_.isEmpty()) emit SongsDeleted(songs_deleted_);
     emit Finished(songs_with_errors_);
 
     // Move back to the original thread so deleteLater() can get called in
@@ -104,20 +137,47 @@ void DeleteFiles::ProcessSomeFiles() {
   }
 
   // We process files in batches so we can be cancelled part-way through.
+  // Storages that delete in parallel get a batch for each delete.
+  const int max_deletes = qMax(1, storage_->MaxConcurrentDeletes());
+  const int n = qMin(songs_.count(), progress_ + kBatchSize * max_deletes);
+
+  if (max_deletes == 1) {
+    for (; progress_ < n; ++progress_) {
+      task_manager_->SetTaskProgress(task_id_, progress_, songs_.count());
+      FileDeleted(songs_[progress_], Delete(songs_[progress_]));
+    }
+  } else {
+    QThreadPool pool;
+    pool.setMaxThreadCount(max_deletes);
+
+    QList<QFuture<bool>> futures;
+    for (int i = progress_; i < n; ++i) {
+      const Song song = songs_[i];
+      futures << ConcurrentRun::Run<bool>(
+          &pool, [this, song]() { return Delete(song); });
+    }
 
-  const int n = qMin(songs_.count(), progress_ + kBatchSize);
-  for (; progress_ < n; ++progress_) {
-    task_manager_->SetTaskProgress(task_id_, progress_, songs_.count());
-
-    const Song& song = songs_[progress_];
-
-    MusicStorage::DeleteJob job;
-    job.metadata_ = song;
-
-    if (!storage_->DeleteFromStorage(job)) {
-      songs_with_errors_ << song;
+    for (int i = 0; i < futures.count(); ++i, ++progress_) {
+      FileDeleted(songs_[progress_], futures[i].result());
+      task_manager_->SetTaskProgress(task_id_, progress_, songs_.count());
     }
   }
 
   QTimer::singleShot(0, this, SLOT(ProcessSomeFiles()));
 }
+
+bool DeleteFiles::Delete(const Song& song) const {
+  MusicStorage::DeleteJob job;
+  job.metadata_ = song;
+  job.use_trash_ = use_trash_;
+
+  return storage_->DeleteFromStorage(job);
+}
+
+void DeleteFiles::FileDeleted(const Song& song, bool success) {
+  if (success) {
+    songs_deleted_ << song;
+  } else {
+    songs_with_errors_ << song;
+  }
+}
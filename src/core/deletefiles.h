@@ -27,6 +27,7 @@
 
 class MusicStorage;
 class TaskManager;
+class QWidget;
 
 class DeleteFiles : public QObject {
   Q_OBJECT
@@ -37,17 +38,31 @@ class DeleteFiles : public QObject {
 
   static const int kBatchSize;
 
+  // Asks whether to delete files from the disk.  Where there's a trash the
+  // files can be moved there instead, and use_trash is set if they should.
+  static bool ConfirmDeleteFromDisk(QWidget* parent, bool* use_trash);
+
+  // Call before Start
+  void set_use_trash(bool use_trash) { use_trash_ = use_trash; }
+
   void Start(const SongList& songs);
   void Start(const QStringList& filenames);
   void Start(const QUrl& url);
 
  signals:
+  // Every song whose file was deleted, emitted once just before Finished so
+  // the library can drop them in one go.
+  void SongsDeleted(const SongList& songs);
   void Finished(const SongList& songs_with_errors);
 
  private slots:
   void ProcessSomeFiles();
 
  private:
+  // Also called from the pool's threads when deleting in parallel.
+  bool Delete(const Song& song) const;
+  void FileDeleted(const Song& song, bool success);
+
   QThread* thread_;
   QThread* original_thread_;
   TaskManager* task_manager_;
@@ -56,10 +71,12 @@ class DeleteFiles : public QObject {
   SongList songs_;
 
   bool started_;
+  bool use_trash_;
 
   int task_id_;
   int progress_;
 
+  SongList songs_deleted_;
   SongList songs_with_errors_;
 };
 
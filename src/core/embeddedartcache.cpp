@@ -0,0 +1,165 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "embeddedartcache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <limits>
+
+#include "core/executor.h"
+#include "core/fasthash.h"
+#include "core/logging.h"
+#include "core/utilities.h"
+
+const qint64 EmbeddedArtCache::kMaxArtBytes = 256 * 1024 * 1024;
+const int EmbeddedArtCache::kMaxSongs = 100000;
+const int EmbeddedArtCache::kPruneInterval = 100;
+
+namespace {
+
+// Written once the files named with the SHA-1s that used to be the keys have
+// been cleared out.
+const char* kKeysMarker = "fasthash";
+
+void RemoveSha1Files(const QString& directory) {
+  QDir dir(directory);
+  for (const QString& name : dir.entryList(QDir::Files)) {
+    // 40 hex digits, the new keys have 32.
+    if (name.length() == 40) QFile::remove(dir.filePath(name));
+  }
+}
+
+// Files used more recently than this aren't touched again, so reading a whole
+// album's art doesn't rewrite the same inode for every song.
+const int kTouchIntervalSecs = 24 * 60 * 60;
+
+void TouchIfStale(const QString& filename) {
+  const QDateTime modified = QFileInfo(filename).lastModified();
+  if (modified.secsTo(QDateTime::currentDateTime()) > kTouchIntervalSecs) {
+    Utilities::TouchFile(filename);
+  }
+}
+
+}  // namespace
+
+EmbeddedArtCache::EmbeddedArtCache(const QString& directory)
+    : directory_(directory), puts_since_prune_(0) {
+  QDir().mkpath(directory_ + "/songs");
+  QDir().mkpath(directory_ + "/art");
+
+  const QString marker = directory_ + "/" + kKeysMarker;
+  if (!QFile::exists(marker)) {
+    Executor::Io()->Run<void>([directory, marker]() {
+      RemoveSha1Files(directory + "/songs");
+      RemoveSha1Files(directory + "/art");
+      QFile(marker).open(QIODevice::WriteOnly);
+    });
+  }
+
+  PruneLater();
+}
+
+void EmbeddedArtCache::PruneLater() {
+  const QString directory = directory_;
+  Executor::Io()->Run<void>([directory]() {
+    Utilities::PruneOldestFiles(directory + "/art", kMaxArtBytes,
+                                std::numeric_limits<int>::max());
+    Utilities::PruneOldestFiles(directory + "/songs",
+                                std::numeric_limits<qint64>::max(), kMaxSongs);
+  });
+}
+
+QString EmbeddedArtCache::SongKey(const QString& filename) {
+  const QFileInfo info(filename);
+  if (!info.exists()) return QString();
+
+  const QString source = QString("%1\n%2\n%3")
+                             .arg(info.absoluteFilePath())
+                             .arg(info.lastModified().toMSecsSinceEpoch())
+                             .arg(info.size());
+  return FastHash::Hash(source.toUtf8()).toHex();
+}
+
+QString EmbeddedArtCache::SongPath(const QString& song_key) const {
+  return directory_ + "/songs/" + song_key;
+}
+
+QString EmbeddedArtCache::ArtPath(const QByteArray& art_hash) const {
+  return directory_ + "/art/" + QString::fromLatin1(art_hash);
+}
+
+bool EmbeddedArtCache::Get(const QString& filename, QByteArray* data) const {
+  const QString song_key = SongKey(filename);
+  if (song_key.isEmpty()) return false;
+
+  // The song's file holds the hash of its art, or nothing if it has none.
+  const QString song_path = SongPath(song_key);
+  QFile song_file(song_path);
+  if (!song_file.open(QIODevice::ReadOnly)) return false;
+  const QByteArray art_hash = song_file.readAll().trimmed();
+  TouchIfStale(song_path);
+
+  data->clear();
+  if (art_hash.isEmpty()) return true;
+
+  // The art might have been pruned since.
+  const QString art_path = ArtPath(art_hash);
+  QFile art_file(art_path);
+  if (!art_file.open(QIODevice::ReadOnly)) return false;
+  *data = art_file.readAll();
+  TouchIfStale(art_path);
+  return true;
+}
+
+void EmbeddedArtCache::Put(const QString& filename, const QByteArray& data) {
+  const QString song_key = SongKey(filename);
+  if (song_key.isEmpty()) return;
+
+  QByteArray art_hash;
+  if (!data.isEmpty()) {
+    art_hash = FastHash::Hash(data).toHex();
+
+    // Another song on the album might have put it there already.
+    const QString art_path = ArtPath(art_hash);
+    if (QFile::exists(art_path)) {
+      TouchIfStale(art_path);
+    } else {
+      QSaveFile art_file(art_path);
+      if (!art_file.open(QIODevice::WriteOnly) ||
+          art_file.write(data) != data.size() || !art_file.commit()) {
+        qLog(Warning) << "Couldn't write embedded art to" << art_path;
+        return;
+      }
+    }
+  }
+
+  QSaveFile song_file(SongPath(song_key));
+  if (!song_file.open(QIODevice::WriteOnly) ||
+      song_file.write(art_hash) != art_hash.size() || !song_file.commit()) {
+    qLog(Warning) << "Couldn't write embedded art key for" << filename;
+    return;
+  }
+
+  if (puts_since_prune_.fetchAndAddRelaxed(1) + 1 >= kPruneInterval) {
+    puts_since_prune_.store(0);
+    PruneLater();
+  }
+}
@@ -0,0 +1,59 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_EMBEDDEDARTCACHE_H_
+#define CORE_EMBEDDEDARTCACHE_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+// Remembers the art embedded in song files so it doesn't have to be read out
+// of the tags again.  Songs are identified by their path, modification time
+// and size, so a song whose tags have changed since is read again.  The art
+// itself is stored under the hash of its data, so all the songs on an album
+// share one copy.  Safe to use from any thread.
+//
+// The art is kept to kMaxArtBytes and the songs to kMaxSongs.  Whatever was
+// used longest ago is dropped first, in the background, every kPruneInterval
+// new entries.
+class EmbeddedArtCache {
+ public:
+  explicit EmbeddedArtCache(const QString& directory);
+
+  static const qint64 kMaxArtBytes;
+  static const int kMaxSongs;
+  static const int kPruneInterval;
+
+  // Returns false if the song hasn't been cached.  data is left empty if the
+  // song has no art.
+  bool Get(const QString& filename, QByteArray* data) const;
+  void Put(const QString& filename, const QByteArray& data);
+
+ private:
+  // Returns an empty string if the file doesn't exist.
+  static QString SongKey(const QString& filename);
+
+  QString SongPath(const QString& song_key) const;
+  QString ArtPath(const QByteArray& art_hash) const;
+  void PruneLater();
+
+  const QString directory_;
+  QAtomicInt puts_since_prune_;
+};
+
+#endif  // CORE_EMBEDDEDARTCACHE_H_
@@ -0,0 +1,65 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "executor.h"
+
+#include <QThread>
+
+Executor::Executor(const QString& name, int max_threads,
+                   Utilities::IoPriority io_priority)
+    : name_(name), io_priority_(io_priority) {
+  pool_.setMaxThreadCount(qMax(1, max_threads));
+}
+
+Executor* Executor::Io() {
+  static Executor executor("io", 4, Utilities::IOPRIO_CLASS_IDLE);
+  return &executor;
+}
+
+Executor* Executor::Cpu() {
+  static Executor executor("cpu", QThread::idealThreadCount());
+  return &executor;
+}
+
+Executor* Executor::Db() {
+  static Executor executor("db", 2);
+  return &executor;
+}
+
+void Executor::UpdatePeakQueued() {
+  const int queued = queued_.load();
+  int peak = peak_queued_.load();
+  while (queued > peak && !peak_queued_.testAndSetRelaxed(peak, queued)) {
+    peak = peak_queued_.load();
+  }
+}
+
+Executor::Task::Task(Executor* executor) : executor_(executor) {
+  executor_->queued_.fetchAndAddRelaxed(-1);
+  executor_->active_.fetchAndAddRelaxed(1);
+
+  // The pool's threads aren't ours, so the priority is set as each task
+  // starts.  A thread only ever runs tasks from one pool, so it sticks.
+  if (executor_->io_priority_ != Utilities::IOPRIO_CLASS_NONE) {
+    Utilities::SetThreadIOPriority(executor_->io_priority_);
+  }
+}
+
+Executor::Task::~Task() {
+  executor_->active_.fetchAndAddRelaxed(-1);
+  executor_->completed_.fetchAndAddRelaxed(1);
+}
@@ -0,0 +1,98 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_EXECUTOR_H_
+#define CORE_EXECUTOR_H_
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+
+#include "core/concurrentrun.h"
+#include "core/utilities.h"
+
+// A named thread pool for one kind of background work, so that a flood of
+// one kind can't hold up the others the way it does when everything goes
+// through QThreadPool::globalInstance():
+//
+//   Io()  - blocking file access: stats, tag reads.  Few threads, run at idle
+//           IO priority so they keep out of playback's way.
+//   Cpu() - sorting, filtering, image scaling and moodbar rendering.  One
+//           thread per core.
+//   Db()  - database reads done off the GUI thread.  SQLite only lets one
+//           connection write at a time, so there's no point in many.
+//
+// Work that runs for the whole session, or holds the database for a long
+// time, should still have a thread of its own rather than take one of these.
+class Executor {
+ public:
+  Executor(const QString& name, int max_threads,
+           Utilities::IoPriority io_priority = Utilities::IOPRIO_CLASS_NONE);
+
+  static Executor* Io();
+  static Executor* Cpu();
+  static Executor* Db();
+
+  template <typename ReturnType>
+  QFuture<ReturnType> Run(std::function<ReturnType()> function) {
+    queued_.fetchAndAddRelaxed(1);
+    UpdatePeakQueued();
+    return ConcurrentRun::Run<ReturnType>(
+        &pool_, std::function<ReturnType()>([this, function]() {
+          Task task(this);
+          return function();
+        }));
+  }
+
+  const QString& name() const { return name_; }
+  int max_threads() const { return pool_.maxThreadCount(); }
+
+  // How many tasks are waiting for a thread, and how many are running.
+  int queued() const { return queued_.load(); }
+  int active() const { return active_.load(); }
+  // The most tasks that have been waiting at once.
+  int peak_queued() const { return peak_queued_.load(); }
+  int completed() const { return completed_.load(); }
+
+ private:
+  Q_DISABLE_COPY(Executor)
+
+  // Keeps the counts while a task runs.
+  class Task {
+   public:
+    explicit Task(Executor* executor);
+    ~Task();
+
+   private:
+    Executor* executor_;
+  };
+
+  void UpdatePeakQueued();
+
+  const QString name_;
+  const Utilities::IoPriority io_priority_;
+  QThreadPool pool_;
+
+  QAtomicInt queued_;
+  QAtomicInt active_;
+  QAtomicInt peak_queued_;
+  QAtomicInt completed_;
+};
+
+#endif  // CORE_EXECUTOR_H_
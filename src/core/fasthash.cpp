@@ -0,0 +1,150 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fasthash.h"
+
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+
+const quint64 kC1 = Q_UINT64_C(0x87c37b91114253d5);
+const quint64 kC2 = Q_UINT64_C(0x4cf5ad432745937f);
+
+const int kBlockSize = 16;
+const qint64 kReadSize = 1024 * 1024;
+
+inline quint64 Rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline quint64 FMix(quint64 k) {
+  k ^= k >> 33;
+  k *= Q_UINT64_C(0xff51afd7ed558ccd);
+  k ^= k >> 33;
+  k *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+  k ^= k >> 33;
+  return k;
+}
+
+// Little endian whatever the machine is, so hashes can be kept on disk.
+inline quint64 Load(const uchar* p) {
+  quint64 ret = 0;
+  for (int i = 7; i >= 0; --i) ret = (ret << 8) | p[i];
+  return ret;
+}
+
+inline void Store(quint64 value, char* p) {
+  for (int i = 0; i < 8; ++i) p[i] = static_cast<char>(value >> (i * 8));
+}
+
+inline quint64 MixK1(quint64 k1) { return Rotl(k1 * kC1, 31) * kC2; }
+inline quint64 MixK2(quint64 k2) { return Rotl(k2 * kC2, 33) * kC1; }
+
+}  // namespace
+
+FastHash::FastHash() { Reset(); }
+
+void FastHash::Reset() {
+  h1_ = 0;
+  h2_ = 0;
+  length_ = 0;
+  tail_length_ = 0;
+}
+
+void FastHash::AddBlock(const uchar* block) {
+  h1_ ^= MixK1(Load(block));
+  h1_ = Rotl(h1_, 27) + h2_;
+  h1_ = h1_ * 5 + 0x52dce729;
+
+  h2_ ^= MixK2(Load(block + 8));
+  h2_ = Rotl(h2_, 31) + h1_;
+  h2_ = h2_ * 5 + 0x38495ab5;
+}
+
+void FastHash::AddData(const char* data, int length) {
+  const uchar* p = reinterpret_cast<const uchar*>(data);
+  length_ += length;
+
+  if (tail_length_ > 0) {
+    const int count = qMin(length, kBlockSize - tail_length_);
+    memcpy(tail_ + tail_length_, p, count);
+    tail_length_ += count;
+    p += count;
+    length -= count;
+
+    if (tail_length_ < kBlockSize) return;
+    AddBlock(tail_);
+    tail_length_ = 0;
+  }
+
+  for (; length >= kBlockSize; p += kBlockSize, length -= kBlockSize) {
+    AddBlock(p);
+  }
+
+  memcpy(tail_, p, length);
+  tail_length_ = length;
+}
+
+QByteArray FastHash::Result() const {
+  quint64 h1 = h1_;
+  quint64 h2 = h2_;
+
+  quint64 k1 = 0;
+  quint64 k2 = 0;
+  for (int i = tail_length_ - 1; i >= 8; --i) {
+    k2 ^= quint64(tail_[i]) << ((i - 8) * 8);
+  }
+  for (int i = qMin(tail_length_, 8) - 1; i >= 0; --i) {
+    k1 ^= quint64(tail_[i]) << (i * 8);
+  }
+  if (tail_length_ > 8) h2 ^= MixK2(k2);
+  if (tail_length_ > 0) h1 ^= MixK1(k1);
+
+  h1 ^= length_;
+  h2 ^= length_;
+  h1 += h2;
+  h2 += h1;
+  h1 = FMix(h1);
+  h2 = FMix(h2);
+  h1 += h2;
+  h2 += h1;
+
+  QByteArray ret(kBlockSize, Qt::Uninitialized);
+  Store(h1, ret.data());
+  Store(h2, ret.data() + 8);
+  return ret;
+}
+
+QByteArray FastHash::Hash(const QByteArray& data) {
+  FastHash hash;
+  hash.AddData(data);
+  return hash.Result();
+}
+
+QByteArray FastHash::Hash(QIODevice* device) {
+  const bool was_open = device->isOpen();
+  if (!was_open && !device->open(QIODevice::ReadOnly)) return QByteArray();
+
+  FastHash hash;
+  while (!device->atEnd()) {
+    const QByteArray data = device->read(kReadSize);
+    if (data.isEmpty()) break;
+    hash.AddData(data);
+  }
+
+  if (!was_open) device->close();
+  return hash.Result();
+}
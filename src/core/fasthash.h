@@ -0,0 +1,64 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_FASTHASH_H_
+#define CORE_FASTHASH_H_
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QIODevice;
+
+// A 128-bit hash that's many times quicker than SHA-1, for cache keys and
+// for checking that files are the same.  It's MurmurHash3 (the x64_128
+// variant), so it's no good against someone crafting collisions on purpose:
+// don't use it for anything that has to be secure, or for anything other
+// programs check, like the SHA-1s the network remote sends.
+//
+// Data can be added in pieces of any size as it's read, the result is the
+// same as hashing it all at once.
+class FastHash {
+ public:
+  FastHash();
+
+  void Reset();
+  void AddData(const char* data, int length);
+  void AddData(const QByteArray& data) {
+    AddData(data.constData(), data.size());
+  }
+
+  // 16 bytes.  More data can still be added afterwards.
+  QByteArray Result() const;
+
+  static QByteArray Hash(const QByteArray& data);
+  // Reads the device from where it is to the end.  Opens it first, and closes
+  // it again afterwards, if it isn't open already.
+  static QByteArray Hash(QIODevice* device);
+
+ private:
+  void AddBlock(const uchar* block);
+
+  quint64 h1_;
+  quint64 h2_;
+  quint64 length_;
+
+  // Data that doesn't fill a block yet.
+  uchar tail_[16];
+  int tail_length_;
+};
+
+#endif  // CORE_FASTHASH_H_
@@ -29,6 +29,14 @@
 #include "core/logging.h"
 #include "core/utilities.h"
 
+// Enough to keep a fast disk busy without making a slow one seek between
+// files all the time.
+const int FilesystemMusicStorage::kMaxConcurrentCopies = 4;
+
+// Deleting is mostly waiting for the filesystem, network ones especially, and
+// hardly touches the disk.
+const int FilesystemMusicStorage::kMaxConcurrentDeletes = 8;
+
 FilesystemMusicStorage::FilesystemMusicStorage(const QString& root)
     : root_(root) {}
 
@@ -49,15 +57,18 @@ bool FilesystemMusicStorage::CopyToStorage(const CopyJob& job) {
   // Remove the destination file if it exists and we want to overwrite
   if (job.overwrite_ && dest.exists()) QFile::remove(dest.absoluteFilePath());
 
-  // Copy or move
+  // Copy or move.  Moves within a filesystem are just a rename.
   if (job.remove_original_)
     return QFile::rename(src.absoluteFilePath(), dest.absoluteFilePath());
   else
-    return QFile::copy(src.absoluteFilePath(), dest.absoluteFilePath());
+    return Utilities::CopyFileFast(src.absoluteFilePath(),
+                                   dest.absoluteFilePath());
 }
 
 bool FilesystemMusicStorage::DeleteFromStorage(const DeleteJob& job) {
   QString path = job.metadata_.url().toLocalFile();
+  if (job.use_trash_) return Utilities::MoveToTrash(path);
+
   QFileInfo fileInfo(path);
   if (fileInfo.isDir())
     return Utilities::RemoveRecursive(path);
@@ -27,9 +27,15 @@ class FilesystemMusicStorage : public virtual MusicStorage {
   explicit FilesystemMusicStorage(const QString& root);
   ~FilesystemMusicStorage() {}
 
+  static const int kMaxConcurrentCopies;
+  static const int kMaxConcurrentDeletes;
+
   QString LocalPath() const { return root_; }
 
+  bool AcceptsDirectWrites() const { return true; }
+  int MaxConcurrentCopies() const { return kMaxConcurrentCopies; }
   bool CopyToStorage(const CopyJob& job);
+  int MaxConcurrentDeletes() const { return kMaxConcurrentDeletes; }
   bool DeleteFromStorage(const DeleteJob& job);
 
  private:
@@ -24,6 +24,10 @@
 #include "macfslistener.h"
 #endif
 
+#ifdef Q_OS_LINUX
+#include "inotifyfslistener.h"
+#endif
+
 FileSystemWatcherInterface::FileSystemWatcherInterface(QObject* parent)
     : QObject(parent) {}
 
@@ -32,6 +36,14 @@ FileSystemWatcherInterface* FileSystemWatcherInterface::Create(
   FileSystemWatcherInterface* ret;
 #ifdef Q_OS_DARWIN
   ret = new MacFSListener(parent);
+#elif defined(Q_OS_LINUX)
+  InotifyFSListener* inotify = new InotifyFSListener(parent);
+  if (inotify->is_valid()) {
+    ret = inotify;
+  } else {
+    delete inotify;
+    ret = new QtFSListener(parent);
+  }
 #else
   ret = new QtFSListener(parent);
 #endif
@@ -21,6 +21,7 @@
 #define CORE_FILESYSTEMWATCHERINTERFACE_H_
 
 #include <QObject>
+#include <QStringList>
 
 class FileSystemWatcherInterface : public QObject {
   Q_OBJECT
@@ -34,7 +35,12 @@ class FileSystemWatcherInterface : public QObject {
   static FileSystemWatcherInterface* Create(QObject* parent = nullptr);
 
  signals:
+  // Something in this directory changed and the whole directory should be
+  // rescanned.
   void PathChanged(const QString& path);
+  // Only these files in the directory changed.  Backends that can't tell
+  // which files changed only emit PathChanged.
+  void FilesChanged(const QString& path, const QStringList& files);
 };
 
 #endif  // CORE_FILESYSTEMWATCHERINTERFACE_H_
@@ -0,0 +1,145 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "headlessplayer.h"
+
+#include "core/application.h"
+#include "core/commandlineoptions.h"
+#include "core/logging.h"
+#include "core/mimedata.h"
+#include "core/player.h"
+#include "core/timeconstants.h"
+#include "engines/enginebase.h"
+#include "playlist/playlist.h"
+#include "playlist/playlistmanager.h"
+#include "playlist/playlistsequence.h"
+
+HeadlessPlayer::HeadlessPlayer(Application* app,
+                               const CommandlineOptions& options,
+                               QObject* parent)
+    : QObject(parent), app_(app), sequence_(new PlaylistSequence) {
+  app_->player()->Init();
+
+  connect(app_->playlist_manager(), SIGNAL(PlayRequested(QModelIndex)),
+          SLOT(PlayIndex(QModelIndex)));
+
+  app_->playlist_manager()->Init(app_->library_backend(),
+                                 app_->playlist_backend(), sequence_.get(),
+                                 nullptr);
+
+  CommandlineOptionsReceived(options);
+}
+
+HeadlessPlayer::~HeadlessPlayer() {}
+
+void HeadlessPlayer::PlayIndex(const QModelIndex& index) {
+  if (!index.isValid()) return;
+
+  int row = index.row();
+  if (index.model() == app_->playlist_manager()->current()->proxy()) {
+    row =
+        app_->playlist_manager()->current()->proxy()->mapToSource(index).row();
+  }
+
+  app_->playlist_manager()->SetActiveToCurrent();
+  app_->player()->PlayAt(row, Engine::Manual, true);
+}
+
+void HeadlessPlayer::CommandlineOptionsReceived(
+    const QString& string_options) {
+  CommandlineOptions options;
+  options.Load(string_options.toLatin1());
+
+  // There's no window to raise.
+  if (!options.is_empty()) CommandlineOptionsReceived(options);
+}
+
+void HeadlessPlayer::CommandlineOptionsReceived(
+    const CommandlineOptions& options) {
+  Player* player = app_->player();
+
+  switch (options.player_action()) {
+    case CommandlineOptions::Player_Play:
+      if (options.urls().empty()) player->Play();
+      break;
+    case CommandlineOptions::Player_PlayPause:
+      player->PlayPause();
+      break;
+    case CommandlineOptions::Player_Pause:
+      player->Pause();
+      break;
+    case CommandlineOptions::Player_Stop:
+      player->Stop();
+      break;
+    case CommandlineOptions::Player_StopAfterCurrent:
+      player->StopAfterCurrent();
+      break;
+    case CommandlineOptions::Player_Previous:
+      player->Previous();
+      break;
+    case CommandlineOptions::Player_Next:
+      player->Next();
+      break;
+    case CommandlineOptions::Player_PlayPlaylist:
+      if (options.playlist_name().isEmpty()) {
+        qLog(Error) << "ERROR: playlist name missing";
+      } else {
+        player->PlayPlaylist(options.playlist_name());
+      }
+      break;
+    case CommandlineOptions::Player_RestartOrPrevious:
+      player->RestartOrPrevious();
+      break;
+    case CommandlineOptions::Player_None:
+      break;
+  }
+
+  if (!options.urls().empty()) {
+    // Without the window's add and play behaviour settings, URLs that don't
+    // say otherwise are appended.
+    MimeData* data = new MimeData;
+    data->setUrls(options.urls());
+    data->play_now_ =
+        options.player_action() == CommandlineOptions::Player_Play;
+    data->clear_first_ =
+        options.url_list_action() == CommandlineOptions::UrlList_Load;
+
+    Playlist* playlist = app_->playlist_manager()->current();
+    if (options.url_list_action() == CommandlineOptions::UrlList_CreateNew) {
+      data->name_for_new_playlist_ = options.playlist_name();
+      app_->playlist_manager()->New(data->get_name_for_new_playlist());
+      playlist = app_->playlist_manager()->current();
+    }
+
+    playlist->dropMimeData(data, Qt::CopyAction, -1, 0, QModelIndex());
+    delete data;
+  }
+
+  if (options.set_volume() != -1) player->SetVolume(options.set_volume());
+
+  if (options.volume_modifier() != 0)
+    player->SetVolume(player->GetVolume() + options.volume_modifier());
+
+  if (options.seek_to() != -1)
+    player->SeekTo(options.seek_to());
+  else if (options.seek_by() != 0)
+    player->SeekTo(player->engine()->position_nanosec() / kNsecPerSec +
+                   options.seek_by());
+
+  if (options.play_track_at() != -1)
+    player->PlayAt(options.play_track_at(), Engine::Manual, true);
+}
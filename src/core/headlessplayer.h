@@ -0,0 +1,55 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_HEADLESSPLAYER_H_
+#define CORE_HEADLESSPLAYER_H_
+
+#include <QModelIndex>
+#include <QObject>
+#include <memory>
+
+class Application;
+class CommandlineOptions;
+class PlaylistSequence;
+
+// Does the parts of MainWindow's job that playback needs when Clementine is
+// started with --headless: it loads the playlists, plays what's asked for and
+// handles the commandline options sent by other instances.  Everything else,
+// the network remote and MPRIS included, is the same as with a window.
+class HeadlessPlayer : public QObject {
+  Q_OBJECT
+
+ public:
+  HeadlessPlayer(Application* app, const CommandlineOptions& options,
+                 QObject* parent = nullptr);
+  ~HeadlessPlayer();
+
+ public slots:
+  void CommandlineOptionsReceived(const QString& string_options);
+  void CommandlineOptionsReceived(const CommandlineOptions& options);
+
+ private slots:
+  void PlayIndex(const QModelIndex& index);
+
+ private:
+  Application* app_;
+
+  // Never shown, but the playlists keep their shuffle and repeat modes in it.
+  std::unique_ptr<PlaylistSequence> sequence_;
+};
+
+#endif  // CORE_HEADLESSPLAYER_H_
@@ -0,0 +1,214 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "inotifyfslistener.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#include "core/logging.h"
+
+namespace {
+// IN_MODIFY catches files written through a handle that's never closed, and
+// IN_ATTRIB catches touched mtimes.  Both are coalesced with the rest.
+const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                            IN_MOVED_TO | IN_CLOSE_WRITE | IN_MODIFY |
+                            IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF |
+                            IN_ONLYDIR;
+}  // namespace
+
+const int InotifyFSListener::kCoalesceIntervalMsec = 500;
+const int InotifyFSListener::kPollIntervalMsec = 5 * 60 * 1000;  // 5 minutes
+
+InotifyFSListener::InotifyFSListener(QObject* parent)
+    : FileSystemWatcherInterface(parent),
+      fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      notifier_(nullptr),
+      coalesce_timer_(new QTimer(this)),
+      poll_timer_(new QTimer(this)) {
+  coalesce_timer_->setSingleShot(true);
+  coalesce_timer_->setInterval(kCoalesceIntervalMsec);
+  connect(coalesce_timer_, SIGNAL(timeout()), SLOT(EmitPendingChanges()));
+
+  poll_timer_->setInterval(kPollIntervalMsec);
+  connect(poll_timer_, SIGNAL(timeout()), SLOT(PollUnwatchedPaths()));
+
+  if (fd_ == -1) {
+    qLog(Warning) << "Failed to initialise inotify:" << strerror(errno);
+    return;
+  }
+
+  notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+  connect(notifier_, SIGNAL(activated(int)), SLOT(ReadEvents()));
+}
+
+InotifyFSListener::~InotifyFSListener() {
+  if (fd_ != -1) close(fd_);
+}
+
+bool InotifyFSListener::AddPath(const QString& path) {
+  if (fd_ == -1) return false;
+  if (path_watches_.contains(path) || unwatched_paths_.contains(path)) {
+    return true;
+  }
+
+  if (AddWatch(path)) return true;
+
+  if (errno != ENOSPC) {
+    qLog(Warning) << "Failed to watch" << path << strerror(errno);
+    return false;
+  }
+
+  // Out of watches.  Rather than missing changes in this directory, rescan
+  // it every so often.
+  if (unwatched_paths_.isEmpty()) {
+    qLog(Warning) << "Ran out of inotify watches after" << path_watches_.count()
+                  << "directories, raise fs.inotify.max_user_watches to watch"
+                  << "the rest.  Rescanning them every"
+                  << kPollIntervalMsec / 1000 << "seconds instead.";
+    poll_timer_->start();
+  }
+  unwatched_paths_.insert(path);
+  return true;
+}
+
+bool InotifyFSListener::AddWatch(const QString& path) {
+  const int wd =
+      inotify_add_watch(fd_, QFile::encodeName(path).constData(), kWatchMask);
+  if (wd == -1) return false;
+
+  watch_paths_[wd] = path;
+  path_watches_[path] = wd;
+  return true;
+}
+
+void InotifyFSListener::RemovePath(const QString& path) {
+  if (unwatched_paths_.remove(path) && unwatched_paths_.isEmpty()) {
+    poll_timer_->stop();
+  }
+
+  QHash<QString, int>::iterator it = path_watches_.find(path);
+  if (it == path_watches_.end()) return;
+
+  inotify_rm_watch(fd_, it.value());
+  watch_paths_.remove(it.value());
+  path_watches_.erase(it);
+}
+
+void InotifyFSListener::Clear() {
+  for (int wd : watch_paths_.keys()) {
+    inotify_rm_watch(fd_, wd);
+  }
+  watch_paths_.clear();
+  path_watches_.clear();
+  unwatched_paths_.clear();
+  poll_timer_->stop();
+  changed_dirs_.clear();
+  changed_files_.clear();
+}
+
+void InotifyFSListener::PollUnwatchedPaths() {
+  for (QSet<QString>::iterator it = unwatched_paths_.begin();
+       it != unwatched_paths_.end();) {
+    // Rescanned even if we can watch it now, since it's not been watched
+    // until now.
+    changed_dirs_.insert(*it);
+    if (AddWatch(*it)) {
+      it = unwatched_paths_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (unwatched_paths_.isEmpty()) {
+    qLog(Info) << "Watching all directories with inotify again";
+    poll_timer_->stop();
+  }
+  EmitPendingChanges();
+}
+
+void InotifyFSListener::ReadEvents() {
+  // Big enough for several events with maximum length names.
+  char buf[4096 * 4] __attribute__((aligned(__alignof__(inotify_event))));
+
+  forever {
+    const ssize_t len = read(fd_, buf, sizeof(buf));
+    if (len <= 0) break;
+
+    for (char* p = buf; p < buf + len;) {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+      p += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // We lost some events, so we can't trust what we know about any of
+        // the directories any more.
+        qLog(Warning) << "inotify event queue overflowed";
+        for (const QString& path : watch_paths_) {
+          changed_dirs_.insert(path);
+        }
+        continue;
+      }
+
+      const QString dir = watch_paths_.value(event->wd);
+      if (dir.isEmpty()) continue;
+
+      if (event->mask & IN_IGNORED) {
+        // The kernel removed the watch, e.g. because the directory was
+        // deleted.
+        watch_paths_.remove(event->wd);
+        path_watches_.remove(dir);
+        changed_dirs_.insert(dir);
+        continue;
+      }
+
+      if ((event->mask & (IN_ISDIR | IN_DELETE_SELF | IN_MOVE_SELF)) ||
+          event->len == 0) {
+        changed_dirs_.insert(dir);
+      } else {
+        changed_files_[dir].insert(dir + "/" +
+                                   QFile::decodeName(event->name));
+      }
+    }
+  }
+
+  if (!changed_dirs_.isEmpty() || !changed_files_.isEmpty()) {
+    coalesce_timer_->start();
+  }
+}
+
+void InotifyFSListener::EmitPendingChanges() {
+  for (const QString& dir : changed_dirs_) {
+    changed_files_.remove(dir);
+    emit PathChanged(dir);
+  }
+
+  for (QHash<QString, QSet<QString>>::const_iterator it =
+           changed_files_.constBegin();
+       it != changed_files_.constEnd(); ++it) {
+    emit FilesChanged(it.key(), it.value().toList());
+  }
+
+  changed_dirs_.clear();
+  changed_files_.clear();
+}
@@ -0,0 +1,81 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_INOTIFYFSLISTENER_H_
+#define CORE_INOTIFYFSLISTENER_H_
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+#include "filesystemwatcherinterface.h"
+
+class QSocketNotifier;
+class QTimer;
+
+// Watches directories using inotify directly.  Unlike QFileSystemWatcher this
+// tells us which files inside a directory changed, and coalesces bursts of
+// events (e.g. a file being copied in many small writes) into one
+// notification per file.
+class InotifyFSListener : public FileSystemWatcherInterface {
+  Q_OBJECT
+
+ public:
+  explicit InotifyFSListener(QObject* parent = nullptr);
+  ~InotifyFSListener();
+
+  static const int kCoalesceIntervalMsec;
+  static const int kPollIntervalMsec;
+
+  // False if inotify couldn't be initialised, in which case another backend
+  // should be used instead.
+  bool is_valid() const { return fd_ != -1; }
+
+  bool AddPath(const QString& path);
+  void RemovePath(const QString& path);
+  void Clear();
+
+ private slots:
+  void ReadEvents();
+  void EmitPendingChanges();
+  void PollUnwatchedPaths();
+
+ private:
+  bool AddWatch(const QString& path);
+
+ private:
+  int fd_;
+  QSocketNotifier* notifier_;
+  QTimer* coalesce_timer_;
+  QTimer* poll_timer_;
+
+  QHash<int, QString> watch_paths_;
+  QHash<QString, int> path_watches_;
+
+  // Directories we couldn't get a watch for because the user ran out of
+  // inotify watches.  These are rescanned every kPollIntervalMsec instead,
+  // and we try to watch them again in case some watches were freed.
+  QSet<QString> unwatched_paths_;
+
+  // Directories that need a full rescan, e.g. because a subdirectory was
+  // added or removed, or because the kernel's event queue overflowed.
+  QSet<QString> changed_dirs_;
+  // Files that changed, keyed by the watched directory they are in.
+  QHash<QString, QSet<QString>> changed_files_;
+};
+
+#endif  // CORE_INOTIFYFSLISTENER_H_
@@ -0,0 +1,78 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "latencystats.h"
+
+#include <algorithm>
+
+const int LatencyStats::kMaxSamples = 256;
+
+void LatencyStats::Record(const QString& name, qint64 usec) {
+  if (!samples_.contains(name)) names_ << name;
+
+  QList<qint64>& samples = samples_[name];
+  samples << usec;
+  if (samples.count() > kMaxSamples) samples.removeFirst();
+}
+
+void LatencyStats::Clear() {
+  names_.clear();
+  samples_.clear();
+}
+
+QList<LatencyStats::Summary> LatencyStats::Summaries() const {
+  QList<Summary> ret;
+  for (const QString& name : names_) {
+    QList<qint64> samples = samples_[name];
+    std::sort(samples.begin(), samples.end());
+
+    Summary summary;
+    summary.name_ = name;
+    summary.count_ = samples.count();
+    summary.min_usec_ = samples.first();
+    summary.median_usec_ = samples[samples.count() / 2];
+    summary.p90_usec_ = samples[samples.count() * 9 / 10];
+    summary.max_usec_ = samples.last();
+    ret << summary;
+  }
+  return ret;
+}
+
+QString LatencyStats::ToString() const {
+  auto msec = [](qint64 usec) {
+    return QString::number(double(usec) / 1000, 'f', 1).rightJustified(9);
+  };
+
+  QStringList lines;
+  lines << QString("%1 %2 %3 %4 %5 %6")
+               .arg("", -28)
+               .arg("count", 6)
+               .arg("min ms", 9)
+               .arg("median", 9)
+               .arg("90%", 9)
+               .arg("max", 9);
+  for (const Summary& summary : Summaries()) {
+    lines << QString("%1 %2 %3 %4 %5 %6")
+                 .arg(summary.name_, -28)
+                 .arg(summary.count_, 6)
+                 .arg(msec(summary.min_usec_))
+                 .arg(msec(summary.median_usec_))
+                 .arg(msec(summary.p90_usec_))
+                 .arg(msec(summary.max_usec_));
+  }
+  return lines.join("\n");
+}
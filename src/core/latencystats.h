@@ -0,0 +1,55 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_LATENCYSTATS_H_
+#define CORE_LATENCYSTATS_H_
+
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+// Keeps the most recent samples of a few named latencies, like the time from
+// pressing play to hearing audio, so their distributions can be shown in the
+// debug console.  Not thread-safe.
+class LatencyStats {
+ public:
+  static const int kMaxSamples;
+
+  struct Summary {
+    QString name_;
+    int count_;
+    qint64 min_usec_;
+    qint64 median_usec_;
+    qint64 p90_usec_;
+    qint64 max_usec_;
+  };
+
+  void Record(const QString& name, qint64 usec);
+  void Clear();
+
+  // One summary per name, in the order they were first recorded.
+  QList<Summary> Summaries() const;
+
+  // Summaries() as a plain text table in milliseconds.
+  QString ToString() const;
+
+ private:
+  QStringList names_;
+  QMap<QString, QList<qint64>> samples_;
+};
+
+#endif  // CORE_LATENCYSTATS_H_
@@ -0,0 +1,122 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "loudnessmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int LoudnessMeter::kSampleRate = 48000;
+const double LoudnessMeter::kReferenceLoudness = -18.0;
+const double LoudnessMeter::kSilence = -70.0;
+
+namespace {
+
+// The K-weighting filters from BS.1770 at 48 kHz: a high shelf for the
+// effect of the head, then a high pass.
+const double kShelf[] = {1.53512485958697, -2.69169618940638, 1.19839281085285,
+                         -1.69065929318241, 0.73248077421585};
+const double kHighpass[] = {1.0, -2.0, 1.0, -1.99004745483398,
+                            0.99007225036621};
+
+// Blocks are 400 ms long and start every 100 ms.
+const int kStepFrames = 4800;
+const size_t kStepsPerBlock = 4;
+
+// Blocks quieter than this are left out entirely, then so are the ones more
+// than kRelativeGate below the loudness of what's left.
+const double kAbsoluteGate = -70.0;
+const double kRelativeGate = -10.0;
+
+double Loudness(double power) { return -0.691 + 10 * std::log10(power); }
+
+}  // namespace
+
+double LoudnessMeter::FilterState::Apply(const Biquad& f, double x) {
+  const double y = f.b0 * x + f.b1 * x1 + f.b2 * x2 - f.a1 * y1 - f.a2 * y2;
+  x2 = x1;
+  x1 = x;
+  y2 = y1;
+  y1 = y;
+  return y;
+}
+
+LoudnessMeter::LoudnessMeter(int channels)
+    : channels_(channels),
+      shelf_(channels),
+      highpass_(channels),
+      step_sum_(0),
+      step_frames_(0),
+      peak_(0) {}
+
+void LoudnessMeter::Process(const float* samples, int frames) {
+  const Biquad shelf = {kShelf[0], kShelf[1], kShelf[2], kShelf[3], kShelf[4]};
+  const Biquad highpass = {kHighpass[0], kHighpass[1], kHighpass[2],
+                           kHighpass[3], kHighpass[4]};
+
+  for (int i = 0; i < frames; ++i) {
+    // Left and right are weighted the same, and a mono channel counts once.
+    for (int c = 0; c < channels_; ++c) {
+      const float sample = samples[i * channels_ + c];
+      peak_ = std::max(peak_, std::fabs(sample));
+
+      const double weighted =
+          highpass_[c].Apply(highpass, shelf_[c].Apply(shelf, sample));
+      step_sum_ += weighted * weighted;
+    }
+
+    if (++step_frames_ < kStepFrames) continue;
+
+    steps_.push_back(step_sum_);
+    if (steps_.size() > kStepsPerBlock) steps_.erase(steps_.begin());
+    step_sum_ = 0;
+    step_frames_ = 0;
+
+    if (steps_.size() == kStepsPerBlock) {
+      double sum = 0;
+      for (double step : steps_) sum += step;
+      blocks_.push_back(sum / (kStepFrames * kStepsPerBlock));
+    }
+  }
+}
+
+double LoudnessMeter::IntegratedLoudness(const std::vector<double>& blocks) {
+  double sum = 0;
+  int count = 0;
+  for (double power : blocks) {
+    if (power > 0 && Loudness(power) > kAbsoluteGate) {
+      sum += power;
+      ++count;
+    }
+  }
+  if (count == 0) return kSilence;
+
+  const double threshold = Loudness(sum / count) + kRelativeGate;
+
+  sum = 0;
+  count = 0;
+  for (double power : blocks) {
+    if (power > 0 && Loudness(power) > kAbsoluteGate &&
+        Loudness(power) > threshold) {
+      sum += power;
+      ++count;
+    }
+  }
+  if (count == 0) return kSilence;
+
+  return Loudness(sum / count);
+}
@@ -0,0 +1,77 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_LOUDNESSMETER_H_
+#define CORE_LOUDNESSMETER_H_
+
+#include <vector>
+
+// Measures integrated loudness the way EBU R128 (ITU-R BS.1770) does: the
+// audio is K-weighted, its power taken over 400 ms blocks every 100 ms, and
+// the blocks are gated to leave out silence and quiet passages.
+//
+// The filters are for 48 kHz, so the audio has to be resampled to that first.
+// Only mono and stereo are supported, anything else should be downmixed.
+class LoudnessMeter {
+ public:
+  static const int kSampleRate;
+  // The loudness ReplayGain 2.0 aims for, in LUFS.
+  static const double kReferenceLoudness;
+  // What's returned when nothing was loud enough to measure.
+  static const double kSilence;
+
+  explicit LoudnessMeter(int channels);
+
+  // samples are interleaved, between -1 and 1.
+  void Process(const float* samples, int frames);
+
+  double IntegratedLoudness() const { return IntegratedLoudness(blocks_); }
+  // The highest sample, not the true peak.
+  float peak() const { return peak_; }
+
+  // The mean square power of each gating block.  An album's loudness is the
+  // loudness of all its tracks' blocks together.
+  const std::vector<double>& blocks() const { return blocks_; }
+  static double IntegratedLoudness(const std::vector<double>& blocks);
+
+  // The ReplayGain 2.0 gain for audio of this loudness, in dB.
+  static double Gain(double loudness) { return kReferenceLoudness - loudness; }
+
+ private:
+  struct Biquad {
+    double b0, b1, b2, a1, a2;
+  };
+  struct FilterState {
+    FilterState() : x1(0), x2(0), y1(0), y2(0) {}
+    double x1, x2, y1, y2;
+    double Apply(const Biquad& f, double x);
+  };
+
+  const int channels_;
+  std::vector<FilterState> shelf_;
+  std::vector<FilterState> highpass_;
+
+  // Sums of squares of the last few 100 ms steps, the newest at the back.
+  std::vector<double> steps_;
+  double step_sum_;
+  int step_frames_;
+
+  std::vector<double> blocks_;
+  float peak_;
+};
+
+#endif  // CORE_LOUDNESSMETER_H_
@@ -0,0 +1,171 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memorybudget.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QSettings>
+
+#include "core/logging.h"
+#include "core/utilities.h"
+
+const char* MemoryBudget::kSettingsGroup = "MemoryBudget";
+const int MemoryBudget::kPressureCheckMsec = 10000;
+const qint64 MemoryBudget::kLowMemoryBytes = 128ll * 1024 * 1024;
+
+MemoryBudget::MemoryBudget(QObject* parent)
+    : QObject(parent), next_id_(1), limit_(0), under_pressure_(false) {
+  pressure_timer_.setInterval(kPressureCheckMsec);
+  connect(&pressure_timer_, SIGNAL(timeout()), SLOT(CheckPressure()));
+  if (AvailableSystemMemory() != -1) pressure_timer_.start();
+
+  ReloadSettings();
+}
+
+int MemoryBudget::Register(const QString& name, qint64 wanted_bytes,
+                           std::function<qint64()> used,
+                           std::function<void(qint64)> set_limit) {
+  QMutexLocker l(&mutex_);
+
+  Cache cache;
+  cache.id_ = next_id_++;
+  cache.name_ = name;
+  cache.wanted_bytes_ = wanted_bytes;
+  cache.used_ = used;
+  cache.set_limit_ = set_limit;
+  caches_ << cache;
+
+  if (limit_ > 0 || under_pressure_) {
+    // Everyone else's share got smaller, but they might not be safe to touch
+    // from this thread.
+    QMetaObject::invokeMethod(this, "ApplyLimits", Qt::QueuedConnection);
+    cache.set_limit_(LimitFor(cache));
+  }
+
+  return cache.id_;
+}
+
+void MemoryBudget::Unregister(int id) {
+  QMutexLocker l(&mutex_);
+  for (int i = 0; i < caches_.count(); ++i) {
+    if (caches_[i].id_ == id) {
+      caches_.removeAt(i);
+      break;
+    }
+  }
+}
+
+QList<MemoryBudget::Usage> MemoryBudget::usage() const {
+  QMutexLocker l(&mutex_);
+
+  QList<Usage> ret;
+  for (const Cache& cache : caches_) {
+    Usage usage;
+    usage.name_ = cache.name_;
+    usage.used_bytes_ = cache.used_ ? cache.used_() : -1;
+    usage.limit_bytes_ = LimitFor(cache);
+    ret << usage;
+  }
+  return ret;
+}
+
+qint64 MemoryBudget::limit() const {
+  QMutexLocker l(&mutex_);
+  return limit_;
+}
+
+bool MemoryBudget::under_pressure() const {
+  QMutexLocker l(&mutex_);
+  return under_pressure_;
+}
+
+void MemoryBudget::ReloadSettings() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  SetLimit(s.value("limit_mb", 0).toLongLong() * 1024 * 1024);
+}
+
+void MemoryBudget::SetLimit(qint64 bytes) {
+  {
+    QMutexLocker l(&mutex_);
+    if (bytes == limit_) return;
+    limit_ = bytes;
+  }
+  ApplyLimits();
+}
+
+void MemoryBudget::SetUnderPressure(bool under_pressure) {
+  {
+    QMutexLocker l(&mutex_);
+    if (under_pressure == under_pressure_) return;
+    under_pressure_ = under_pressure;
+  }
+  ApplyLimits();
+}
+
+void MemoryBudget::ApplyLimits() {
+  QMutexLocker l(&mutex_);
+  for (const Cache& cache : caches_) {
+    cache.set_limit_(LimitFor(cache));
+  }
+}
+
+void MemoryBudget::CheckPressure() {
+  const qint64 available = AvailableSystemMemory();
+  if (available == -1) return;
+
+  if (!under_pressure() && available < kLowMemoryBytes) {
+    qLog(Info) << "Only" << Utilities::PrettySize(available)
+               << "of memory left, shrinking caches";
+    SetUnderPressure(true);
+  } else if (under_pressure() && available > kLowMemoryBytes * 2) {
+    qLog(Info) << "Memory is available again, letting caches grow";
+    SetUnderPressure(false);
+  }
+}
+
+qint64 MemoryBudget::LimitFor(const Cache& cache) const {
+  qint64 total_wanted = 0;
+  for (const Cache& c : caches_) {
+    total_wanted += c.wanted_bytes_;
+  }
+
+  double scale = 1.0;
+  if (limit_ > 0 && total_wanted > limit_) {
+    scale = static_cast<double>(limit_) / total_wanted;
+  }
+  if (under_pressure_) scale /= 2;
+
+  return cache.wanted_bytes_ * scale;
+}
+
+qint64 MemoryBudget::AvailableSystemMemory() {
+#ifdef Q_OS_LINUX
+  QFile meminfo("/proc/meminfo");
+  if (!meminfo.open(QIODevice::ReadOnly)) return -1;
+
+  // "MemAvailable:    1234567 kB"
+  while (!meminfo.atEnd()) {
+    const QByteArray line = meminfo.readLine();
+    if (line.startsWith("MemAvailable:")) {
+      return line.mid(13).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+  }
+#endif
+  return -1;
+}
@@ -0,0 +1,103 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_MEMORYBUDGET_H_
+#define CORE_MEMORYBUDGET_H_
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+// Shares one memory limit between the in-memory caches.  Each cache registers
+// with the size it would like and is told how big it may be.  Without an
+// overall limit every cache gets what it asked for, with one they're all
+// scaled down together to fit in it.  While the system is short of memory
+// they're halved again.
+//
+// Register, Unregister and usage are thread safe.  Limits are handed out with
+// the budget's lock held, so a cache's functions mustn't call back into it.
+class MemoryBudget : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit MemoryBudget(QObject* parent = nullptr);
+
+  static const char* kSettingsGroup;
+  static const int kPressureCheckMsec;
+  // The system is short of memory below this much, and has recovered once
+  // twice as much is available again.
+  static const qint64 kLowMemoryBytes;
+
+  struct Usage {
+    QString name_;
+    // -1 if the cache can't tell.
+    qint64 used_bytes_;
+    qint64 limit_bytes_;
+  };
+
+  // used returns how many bytes the cache holds now, or -1 if it can't tell.
+  // set_limit is called with the most it may hold, straight away from the
+  // calling thread and later from the budget's.  Returns an ID for
+  // Unregister.
+  int Register(const QString& name, qint64 wanted_bytes,
+               std::function<qint64()> used,
+               std::function<void(qint64)> set_limit);
+  void Unregister(int id);
+
+  QList<Usage> usage() const;
+
+  // 0 if there's no overall limit.
+  qint64 limit() const;
+  bool under_pressure() const;
+
+ public slots:
+  void ReloadSettings();
+  void SetLimit(qint64 bytes);
+  void SetUnderPressure(bool under_pressure);
+
+ private slots:
+  void ApplyLimits();
+  void CheckPressure();
+
+ private:
+  struct Cache {
+    int id_;
+    QString name_;
+    qint64 wanted_bytes_;
+    std::function<qint64()> used_;
+    std::function<void(qint64)> set_limit_;
+  };
+
+  // The caller must hold mutex_.
+  qint64 LimitFor(const Cache& cache) const;
+
+  // Returns -1 where it can't be found out.
+  static qint64 AvailableSystemMemory();
+
+  mutable QMutex mutex_;
+  QList<Cache> caches_;
+  int next_id_;
+  qint64 limit_;
+  bool under_pressure_;
+
+  QTimer pressure_timer_;
+};
+
+#endif  // CORE_MEMORYBUDGET_H_
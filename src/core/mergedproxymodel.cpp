@@ -32,7 +32,6 @@ using std::placeholders::_2;
 
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
 using boost::multi_index::hashed_unique;
@@ -40,7 +39,6 @@ using boost::multi_index::identity;
 using boost::multi_index::indexed_by;
 using boost::multi_index::member;
 using boost::multi_index::multi_index_container;
-using boost::multi_index::ordered_unique;
 using boost::multi_index::tag;
 
 std::size_t hash_value(const QModelIndex& index) { return qHash(index); }
@@ -66,7 +64,7 @@ class MergedProxyModelPrivate {
       indexed_by<
           hashed_unique<tag<tag_by_source>,
                         member<Mapping, QModelIndex, &Mapping::source_index>>,
-          ordered_unique<tag<tag_by_pointer>, identity<Mapping*>>>>
+          hashed_unique<tag<tag_by_pointer>, identity<Mapping*>>>>
       MappingContainer;
 
  public:
@@ -75,6 +73,7 @@ class MergedProxyModelPrivate {
 
 MergedProxyModel::MergedProxyModel(QObject* parent)
     : QAbstractProxyModel(parent),
+      submodels_by_parent_valid_(false),
       resetting_model_(nullptr),
       p_(new MergedProxyModelPrivate) {}
 
@@ -108,14 +107,16 @@ void MergedProxyModel::AddSubModel(const QModelIndex& source_parent,
   if (rows) beginInsertRows(proxy_parent, 0, rows - 1);
 
   merge_points_.insert(submodel, source_parent);
+  InvalidateSubModelIndex();
 
   if (rows) endInsertRows();
 }
 
 void MergedProxyModel::RemoveSubModel(const QModelIndex& source_parent) {
   // Find the submodel that the parent corresponded to
-  QAbstractItemModel* submodel = merge_points_.key(source_parent);
+  QAbstractItemModel* submodel = SubModelAt(source_parent);
   merge_points_.remove(submodel);
+  InvalidateSubModelIndex();
 
   // The submodel might have been deleted already so we must be careful not
   // to dereference it.
@@ -192,6 +193,7 @@ void MergedProxyModel::SourceModelReset() {
   // Clear the containers
   p_->mappings_.clear();
   merge_points_.clear();
+  InvalidateSubModelIndex();
 
   endResetModel();
 }
@@ -254,6 +256,7 @@ void MergedProxyModel::RowsAboutToBeInserted(const QModelIndex& source_parent,
 }
 
 void MergedProxyModel::RowsInserted(const QModelIndex&, int, int) {
+  InvalidateSubModelIndex();
   endInsertRows();
 }
 
@@ -266,6 +269,7 @@ void MergedProxyModel::RowsAboutToBeRemoved(const QModelIndex& source_parent,
 }
 
 void MergedProxyModel::RowsRemoved(const QModelIndex&, int, int) {
+  InvalidateSubModelIndex();
   endRemoveRows();
 }
 
@@ -308,7 +312,7 @@ QModelIndex MergedProxyModel::index(int row, int column,
     source_index = sourceModel()->index(row, column, QModelIndex());
   } else {
     QModelIndex source_parent = mapToSource(parent);
-    const QAbstractItemModel* child_model = merge_points_.key(source_parent);
+    const QAbstractItemModel* child_model = SubModelAt(source_parent);
 
     if (child_model)
       source_index = child_model->index(row, column, QModelIndex());
@@ -337,7 +341,7 @@ int MergedProxyModel::rowCount(const QModelIndex& parent) const {
   QModelIndex source_parent = mapToSource(parent);
   if (!IsKnownModel(source_parent.model())) return 0;
 
-  const QAbstractItemModel* child_model = merge_points_.key(source_parent);
+  const QAbstractItemModel* child_model = SubModelAt(source_parent);
   if (child_model) {
     // Query the source model but disregard what it says, so it gets a chance
     // to lazy load
@@ -355,7 +359,7 @@ int MergedProxyModel::columnCount(const QModelIndex& parent) const {
   QModelIndex source_parent = mapToSource(parent);
   if (!IsKnownModel(source_parent.model())) return 0;
 
-  const QAbstractItemModel* child_model = merge_points_.key(source_parent);
+  const QAbstractItemModel* child_model = SubModelAt(source_parent);
   if (child_model) return child_model->columnCount(QModelIndex());
   return source_parent.model()->columnCount(source_parent);
 }
@@ -366,7 +370,7 @@ bool MergedProxyModel::hasChildren(const QModelIndex& parent) const {
   QModelIndex source_parent = mapToSource(parent);
   if (!IsKnownModel(source_parent.model())) return false;
 
-  const QAbstractItemModel* child_model = merge_points_.key(source_parent);
+  const QAbstractItemModel* child_model = SubModelAt(source_parent);
 
   if (child_model)
     return child_model->hasChildren(QModelIndex()) ||
@@ -476,13 +480,31 @@ void MergedProxyModel::fetchMore(const QModelIndex& parent) {
 QAbstractItemModel* MergedProxyModel::GetModel(
     const QModelIndex& source_index) const {
   // This is essentially const_cast<QAbstractItemModel*>(source_index.model()),
-  // but without the const_cast
+  // but only for models we know about.
   const QAbstractItemModel* const_model = source_index.model();
   if (const_model == sourceModel()) return sourceModel();
-  for (QAbstractItemModel* submodel : merge_points_.keys()) {
-    if (submodel == const_model) return submodel;
+
+  const auto it =
+      merge_points_.constFind(const_cast<QAbstractItemModel*>(const_model));
+  if (it == merge_points_.constEnd()) return nullptr;
+  return it.key();
+}
+
+QAbstractItemModel* MergedProxyModel::SubModelAt(
+    const QModelIndex& source_parent) const {
+  if (!submodels_by_parent_valid_) {
+    submodels_by_parent_.clear();
+    for (auto it = merge_points_.constBegin(); it != merge_points_.constEnd();
+         ++it) {
+      // Like QMap::key, the first submodel wins if there's more than one.
+      if (it.value().isValid() && !submodels_by_parent_.contains(it.value())) {
+        submodels_by_parent_.insert(it.value(), it.key());
+      }
+    }
+    submodels_by_parent_valid_ = true;
   }
-  return nullptr;
+
+  return submodels_by_parent_.value(source_parent, nullptr);
 }
 
 void MergedProxyModel::DataChanged(const QModelIndex& top_left,
@@ -498,6 +520,8 @@ void MergedProxyModel::LayoutAboutToBeChanged() {
 }
 
 void MergedProxyModel::LayoutChanged() {
+  InvalidateSubModelIndex();
+
   for (QAbstractItemModel* key : merge_points_.keys()) {
     if (!old_merge_points_.contains(key)) continue;
 
@@ -21,6 +21,7 @@
 #define CORE_MERGEDPROXYMODEL_H_
 
 #include <QAbstractProxyModel>
+#include <QHash>
 #include <memory>
 
 std::size_t hash_value(const QModelIndex& index);
@@ -98,10 +99,19 @@ class MergedProxyModel : public QAbstractProxyModel {
   QModelIndex GetActualSourceParent(const QModelIndex& source_parent,
                                     QAbstractItemModel* model) const;
   QAbstractItemModel* GetModel(const QModelIndex& source_index) const;
+  // The submodel merged in under source_parent, or nullptr.
+  QAbstractItemModel* SubModelAt(const QModelIndex& source_parent) const;
+  // Call when the merge points might have moved.
+  void InvalidateSubModelIndex() { submodels_by_parent_valid_ = false; }
   void DeleteAllMappings();
   bool IsKnownModel(const QAbstractItemModel* model) const;
 
   QMap<QAbstractItemModel*, QPersistentModelIndex> merge_points_;
+  // merge_points_ the other way round, so looking up whether an item has a
+  // submodel doesn't go through all of them.  The persistent indexes move
+  // when rows are added or removed, so it's rebuilt after that.
+  mutable QHash<QModelIndex, QAbstractItemModel*> submodels_by_parent_;
+  mutable bool submodels_by_parent_valid_;
   QAbstractItemModel* resetting_model_;
 
   QMap<QAbstractItemModel*, QModelIndex> old_merge_points_;
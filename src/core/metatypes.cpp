@@ -109,6 +109,8 @@ void RegisterMetaTypes() {
       "SomaFMService::Stream");
   qRegisterMetaTypeStreamOperators<IntergalacticFMService::Stream>(
       "IntergalacticFMService::Stream");
+  qRegisterMetaTypeStreamOperators<RadioBrowserService::Stream>(
+      "RadioBrowserService::Stream");
   qRegisterMetaType<SubdirectoryList>("SubdirectoryList");
   qRegisterMetaType<Subdirectory>("Subdirectory");
   qRegisterMetaType<QList<QUrl>>("QList<QUrl>");
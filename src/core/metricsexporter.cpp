@@ -0,0 +1,121 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metricsexporter.h"
+
+#include <QSettings>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "config.h"
+#include "core/logging.h"
+#include "core/metrics.h"
+
+#ifdef HAVE_DBUS
+#include <QDBusConnection>
+#endif
+
+const char* MetricsExporter::kSettingsGroup = "Metrics";
+const char* MetricsExporter::kDBusObjectPath = "/Metrics";
+
+MetricsExporter::MetricsExporter(QObject* parent)
+    : QObject(parent), server_(new QTcpServer(this)), dbus_registered_(false) {
+  connect(server_, SIGNAL(newConnection()), SLOT(NewConnection()));
+  ReloadSettings();
+}
+
+quint16 MetricsExporter::http_port() const {
+  return server_->isListening() ? server_->serverPort() : 0;
+}
+
+void MetricsExporter::ReloadSettings() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  SetHttpPort(s.value("http_port", 0).toUInt());
+  SetDBusEnabled(s.value("dbus", false).toBool());
+}
+
+void MetricsExporter::SetHttpPort(quint16 port) {
+  if (server_->isListening()) {
+    if (server_->serverPort() == port) return;
+    server_->close();
+  }
+  if (port == 0) return;
+
+  // Only local tools should see what the user's been doing.
+  if (!server_->listen(QHostAddress::LocalHost, port)) {
+    qLog(Warning) << "Couldn't serve metrics on port" << port << "-"
+                  << server_->errorString();
+    return;
+  }
+  qLog(Info) << "Serving metrics at http://localhost:" << port << "/metrics";
+}
+
+void MetricsExporter::SetDBusEnabled(bool enabled) {
+#ifdef HAVE_DBUS
+  if (enabled == dbus_registered_) return;
+
+  QDBusConnection bus = QDBusConnection::sessionBus();
+  if (enabled) {
+    dbus_registered_ = bus.registerObject(
+        kDBusObjectPath, this, QDBusConnection::ExportScriptableSlots);
+    if (!dbus_registered_) {
+      qLog(Warning) << "Couldn't export metrics on D-Bus";
+    }
+  } else {
+    bus.unregisterObject(kDBusObjectPath);
+    dbus_registered_ = false;
+  }
+#else
+  Q_UNUSED(enabled);
+#endif
+}
+
+QString MetricsExporter::Prometheus() const {
+  return QString::fromUtf8(metrics::PrometheusText());
+}
+
+void MetricsExporter::NewConnection() {
+  while (QTcpSocket* socket = server_->nextPendingConnection()) {
+    connect(socket, SIGNAL(readyRead()), SLOT(ReadyRead()));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  }
+}
+
+void MetricsExporter::ReadyRead() {
+  QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+  if (!socket || !socket->canReadLine()) return;
+
+  // Only the request line matters, the headers are ignored.
+  const QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+  socket->readAll();
+  disconnect(socket, SIGNAL(readyRead()), this, SLOT(ReadyRead()));
+
+  if (request.count() >= 2 && request[0] == "GET" &&
+      request[1] == "/metrics") {
+    const QByteArray body = metrics::PrometheusText();
+    socket->write("HTTP/1.0 200 OK\r\n");
+    socket->write("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    socket->write("Content-Length: " + QByteArray::number(body.size()) +
+                  "\r\n\r\n");
+    socket->write(body);
+  } else {
+    socket->write("HTTP/1.0 404 Not Found\r\n");
+    socket->write("Content-Length: 0\r\n\r\n");
+  }
+  socket->disconnectFromHost();
+}
@@ -0,0 +1,61 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_METRICSEXPORTER_H_
+#define CORE_METRICSEXPORTER_H_
+
+#include <QObject>
+#include <QString>
+
+class QTcpServer;
+
+// Makes the metrics from core/metrics.h available outside Clementine, if the
+// Metrics settings ask for it:
+//  - http_port: served in the Prometheus text format at
+//    http://localhost:<port>/metrics.  0, the default, turns it off.
+//  - dbus: the Prometheus method of org.clementine.Metrics on /Metrics on the
+//    session bus returns the same text.
+class MetricsExporter : public QObject {
+  Q_OBJECT
+  Q_CLASSINFO("D-Bus Interface", "org.clementine.Metrics")
+
+ public:
+  explicit MetricsExporter(QObject* parent = nullptr);
+
+  static const char* kSettingsGroup;
+  static const char* kDBusObjectPath;
+
+  quint16 http_port() const;
+
+ public slots:
+  void ReloadSettings();
+
+  Q_SCRIPTABLE QString Prometheus() const;
+
+ private slots:
+  void NewConnection();
+  void ReadyRead();
+
+ private:
+  void SetHttpPort(quint16 port);
+  void SetDBusEnabled(bool enabled);
+
+  QTcpServer* server_;
+  bool dbus_registered_;
+};
+
+#endif  // CORE_METRICSEXPORTER_H_
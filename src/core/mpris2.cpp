@@ -25,6 +25,7 @@
 
 #include <QApplication>
 #include <QDBusConnection>
+#include <QTimer>
 #include <QtConcurrentRun>
 #include <algorithm>
 
@@ -81,8 +82,17 @@ namespace mpris {
 const char* Mpris2::kMprisObjectPath = "/org/mpris/MediaPlayer2";
 const char* Mpris2::kServiceName = "org.mpris.MediaPlayer2.clementine";
 const char* Mpris2::kFreedesktopPath = "org.freedesktop.DBus.Properties";
+const int Mpris2::kSeekedIntervalMsec = 200;
+
+Mpris2::Mpris2(Application* app, QObject* parent)
+    : QObject(parent),
+      seeked_timer_(new QTimer(this)),
+      pending_seeked_(-1),
+      app_(app) {
+  seeked_timer_->setInterval(kSeekedIntervalMsec);
+  seeked_timer_->setSingleShot(true);
+  connect(seeked_timer_, SIGNAL(timeout()), SLOT(SeekedTimeout()));
 
-Mpris2::Mpris2(Application* app, QObject* parent) : QObject(parent), app_(app) {
   new Mpris2Root(this);
   new Mpris2TrackList(this);
   new Mpris2Player(this);
@@ -102,7 +112,8 @@ Mpris2::Mpris2(Application* app, QObject* parent) : QObject(parent), app_(app) {
   connect(app_->player()->engine(), SIGNAL(StateChanged(Engine::State)),
           SLOT(EngineStateChanged(Engine::State)));
   connect(app_->player(), SIGNAL(VolumeChanged(int)), SLOT(VolumeChanged()));
-  connect(app_->player(), SIGNAL(Seeked(qlonglong)), SIGNAL(Seeked(qlonglong)));
+  connect(app_->player(), SIGNAL(Seeked(qlonglong)),
+          SLOT(PlayerSeeked(qlonglong)));
 
   connect(app_->playlist_manager(), SIGNAL(PlaylistManagerInitialized()),
           SLOT(PlaylistManagerInitialized()));
@@ -127,6 +138,8 @@ void Mpris2::PlaylistManagerInitialized() {
 void Mpris2::EngineStateChanged(Engine::State newState) {
   if (newState != Engine::Playing && newState != Engine::Paused) {
     last_metadata_ = QVariantMap();
+    last_metadata_url_ = QUrl();
+    last_art_uri_.clear();
     EmitNotification("Metadata");
   }
 
@@ -153,6 +166,11 @@ void Mpris2::EmitNotification(const QString& name, const QVariant& val) {
 
 void Mpris2::EmitNotification(const QString& name, const QVariant& val,
                               const QString& mprisEntity) {
+  const QString key = mprisEntity + "." + name;
+  QMap<QString, QVariant>::iterator it = last_notified_.find(key);
+  if (it != last_notified_.end() && it.value() == val) return;
+  last_notified_[key] = val;
+
   QDBusMessage msg = QDBusMessage::createSignal(
       kMprisObjectPath, kFreedesktopPath, "PropertiesChanged");
   QVariantMap map;
@@ -334,7 +352,11 @@ QString Mpris2::current_track_id() const {
 // We send Metadata change notification as soon as the process of
 // changing song starts...
 void Mpris2::CurrentSongChanged(const Song& song) {
-  ArtLoaded(song, "");
+  // This also comes when only the tags of the same song changed, keep its
+  // cover until the new one is loaded rather than sending the metadata
+  // without it in between.
+  ArtLoaded(song,
+            song.url() == last_metadata_url_ ? last_art_uri_ : QString());
   EmitNotification("CanPlay");
   EmitNotification("CanPause");
   EmitNotification("CanGoNext", CanGoNext());
@@ -344,6 +366,9 @@ void Mpris2::CurrentSongChanged(const Song& song) {
 
 // ... and we add the cover information later, when it's available.
 void Mpris2::ArtLoaded(const Song& song, const QString& art_uri) {
+  last_metadata_url_ = song.url();
+  last_art_uri_ = art_uri;
+
   last_metadata_ = QVariantMap();
   song.ToXesam(&last_metadata_);
 
@@ -569,7 +594,26 @@ void Mpris2::PlaylistChanged(Playlist* playlist) {
 }
 
 void Mpris2::PlaylistCollectionChanged(Playlist* playlist) {
-  EmitNotification("PlaylistCount", "", "org.mpris.MediaPlayer2.Playlists");
+  EmitNotification("PlaylistCount", PlaylistCount(),
+                   "org.mpris.MediaPlayer2.Playlists");
+}
+
+void Mpris2::PlayerSeeked(qlonglong position) {
+  if (seeked_timer_->isActive()) {
+    pending_seeked_ = position;
+    return;
+  }
+
+  emit Seeked(position);
+  seeked_timer_->start();
+}
+
+void Mpris2::SeekedTimeout() {
+  if (pending_seeked_ == -1) return;
+
+  emit Seeked(pending_seeked_);
+  pending_seeked_ = -1;
+  seeked_timer_->start();
 }
 
 }  // namespace mpris
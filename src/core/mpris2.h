@@ -32,6 +32,8 @@ class Application;
 class MainWindow;
 class Playlist;
 
+class QTimer;
+
 typedef QList<QVariantMap> TrackMetadata;
 typedef QList<QDBusObjectPath> TrackIds;
 Q_DECLARE_METATYPE(TrackMetadata)
@@ -205,6 +207,9 @@ class Mpris2 : public QObject {
   void PlaylistChanged(Playlist* playlist);
   void PlaylistCollectionChanged(Playlist* playlist);
 
+  void PlayerSeeked(qlonglong position);
+  void SeekedTimeout();
+
  private:
   void EmitNotification(const QString& name);
   void EmitNotification(const QString& name, const QVariant& val);
@@ -224,7 +229,22 @@ class Mpris2 : public QObject {
   static const char* kServiceName;
   static const char* kFreedesktopPath;
 
+  // Dragging the seek slider seeks many times a second, Seeked is sent at
+  // most this often.  The last position is always sent.
+  static const int kSeekedIntervalMsec;
+
   QVariantMap last_metadata_;
+  // The song and cover the metadata is for, so a change that doesn't touch
+  // the cover can keep it.
+  QUrl last_metadata_url_;
+  QString last_art_uri_;
+
+  // The last value sent for each property, keyed by interface and name.
+  // Desktop widgets redraw for every notification, so only changes are sent.
+  QMap<QString, QVariant> last_notified_;
+
+  QTimer* seeked_timer_;
+  qlonglong pending_seeked_;
 
   Application* app_;
 };
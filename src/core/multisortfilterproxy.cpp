@@ -26,16 +26,108 @@
 #include "core/logging.h"
 
 MultiSortFilterProxy::MultiSortFilterProxy(QObject* parent)
-    : QSortFilterProxyModel(parent) {}
+    : QSortFilterProxyModel(parent),
+      empty_sort_key_(collator_.sortKey(QString())),
+      sort_keys_locale_aware_(isSortLocaleAware()),
+      sort_keys_case_sensitivity_(sortCaseSensitivity()) {}
 
 void MultiSortFilterProxy::AddSortSpec(int role, Qt::SortOrder order) {
   sorting_ << SortSpec(role, order);
+  ClearSortKeys();
+}
+
+void MultiSortFilterProxy::setSourceModel(QAbstractItemModel* source_model) {
+  for (const QMetaObject::Connection& connection : source_connections_) {
+    disconnect(connection);
+  }
+  source_connections_.clear();
+  ClearSortKeys();
+
+  // Connected before QSortFilterProxyModel connects its own, so the keys are
+  // gone by the time it sorts the changed rows again.
+  if (source_model) {
+    auto clear = [this]() { ClearSortKeys(); };
+    source_connections_
+        << connect(source_model, &QAbstractItemModel::dataChanged, clear)
+        << connect(source_model, &QAbstractItemModel::rowsInserted, clear)
+        << connect(source_model, &QAbstractItemModel::rowsRemoved, clear)
+        << connect(source_model, &QAbstractItemModel::rowsMoved, clear)
+        << connect(source_model, &QAbstractItemModel::columnsInserted, clear)
+        << connect(source_model, &QAbstractItemModel::columnsRemoved, clear)
+        << connect(source_model, &QAbstractItemModel::columnsMoved, clear)
+        << connect(source_model, &QAbstractItemModel::layoutChanged, clear)
+        << connect(source_model, &QAbstractItemModel::modelReset, clear);
+  }
+
+  QSortFilterProxyModel::setSourceModel(source_model);
+}
+
+void MultiSortFilterProxy::ClearSortKeys() {
+  sort_key_rows_.clear();
+  sort_keys_.clear();
+}
+
+int MultiSortFilterProxy::SortKeyRow(const QModelIndex& index) const {
+  if (sort_keys_locale_aware_ != isSortLocaleAware() ||
+      sort_keys_case_sensitivity_ != sortCaseSensitivity()) {
+    sort_key_rows_.clear();
+    sort_keys_.clear();
+    sort_keys_locale_aware_ = isSortLocaleAware();
+    sort_keys_case_sensitivity_ = sortCaseSensitivity();
+  }
+
+  QHash<QModelIndex, int>::const_iterator it = sort_key_rows_.constFind(index);
+  if (it != sort_key_rows_.constEnd()) return it.value();
+
+  SortKey key;
+  key.reserve(sorting_.count());
+  for (const SortSpec& spec : sorting_) {
+    SortValue value(empty_sort_key_);
+    value.value = index.data(spec.first);
+
+    switch (value.value.userType()) {
+      case QVariant::Invalid:
+      case QVariant::Int:
+      case QVariant::UInt:
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+      case QMetaType::Float:
+      case QVariant::Double:
+      case QVariant::Char:
+      case QVariant::Date:
+      case QVariant::Time:
+      case QVariant::DateTime:
+        break;
+
+      default:
+        value.has_text = true;
+        if (sort_keys_locale_aware_) {
+          value.collated = collator_.sortKey(value.value.toString());
+        } else if (sort_keys_case_sensitivity_ == Qt::CaseInsensitive) {
+          value.text = value.value.toString().toCaseFolded();
+        } else {
+          value.text = value.value.toString();
+        }
+        break;
+    }
+    key.push_back(value);
+  }
+
+  sort_keys_.push_back(key);
+  sort_key_rows_.insert(index, sort_keys_.size() - 1);
+  return sort_keys_.size() - 1;
 }
 
 bool MultiSortFilterProxy::lessThan(const QModelIndex& left,
                                     const QModelIndex& right) const {
-  for (const SortSpec& spec : sorting_) {
-    const int ret = Compare(left.data(spec.first), right.data(spec.first));
+  const int left_row = SortKeyRow(left);
+  const int right_row = SortKeyRow(right);
+  const SortKey& left_key = sort_keys_[left_row];
+  const SortKey& right_key = sort_keys_[right_row];
+
+  for (int i = 0; i < sorting_.count(); ++i) {
+    const SortSpec& spec = sorting_[i];
+    const int ret = Compare(left_key[i], right_key[i]);
 
     if (ret < 0) {
       return spec.second == Qt::AscendingOrder;
@@ -54,6 +146,15 @@ static inline int DoCompare(T left, T right) {
   return 0;
 }
 
+int MultiSortFilterProxy::Compare(const SortValue& left,
+                                  const SortValue& right) const {
+  if (left.has_text && right.has_text) {
+    if (sort_keys_locale_aware_) return left.collated.compare(right.collated);
+    return left.text.compare(right.text);
+  }
+  return Compare(left.value, right.value);
+}
+
 int MultiSortFilterProxy::Compare(const QVariant& left,
                                   const QVariant& right) const {
   // Copied from the QSortFilterProxyModel::lessThan implementation, but returns
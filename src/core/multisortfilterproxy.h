@@ -20,22 +20,62 @@
 #ifndef CORE_MULTISORTFILTERPROXY_H_
 #define CORE_MULTISORTFILTERPROXY_H_
 
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QHash>
 #include <QSortFilterProxyModel>
+#include <vector>
 
+// Sorts by several roles in turn.  The values of each row are read once and
+// kept, with strings already turned into collation keys, until the source
+// model changes.
 class MultiSortFilterProxy : public QSortFilterProxyModel {
  public:
   explicit MultiSortFilterProxy(QObject* parent = nullptr);
 
   void AddSortSpec(int role, Qt::SortOrder order = Qt::AscendingOrder);
 
+  void setSourceModel(QAbstractItemModel* source_model);
+
  protected:
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const;
 
  private:
+  struct SortValue {
+    explicit SortValue(const QCollatorSortKey& collated)
+        : has_text(false), collated(collated) {}
+
+    QVariant value;
+
+    // Set for values that are compared as strings.  text is case folded if
+    // the sort isn't case sensitive, collated is only set if it's locale
+    // aware.
+    bool has_text;
+    QString text;
+    QCollatorSortKey collated;
+  };
+  typedef std::vector<SortValue> SortKey;
+
+  // Where index's key is in sort_keys_, making it if it isn't there.
+  int SortKeyRow(const QModelIndex& index) const;
+  void ClearSortKeys();
+
+  int Compare(const SortValue& left, const SortValue& right) const;
   int Compare(const QVariant& left, const QVariant& right) const;
 
   typedef QPair<int, Qt::SortOrder> SortSpec;
   QList<SortSpec> sorting_;
+
+  QList<QMetaObject::Connection> source_connections_;
+
+  // Keys are looked up by source index.  The settings they were made with
+  // are kept so they can be thrown away if those change.
+  QCollator collator_;
+  QCollatorSortKey empty_sort_key_;
+  mutable QHash<QModelIndex, int> sort_key_rows_;
+  mutable std::vector<SortKey> sort_keys_;
+  mutable bool sort_keys_locale_aware_;
+  mutable Qt::CaseSensitivity sort_keys_case_sensitivity_;
 };
 
 #endif  // CORE_MULTISORTFILTERPROXY_H_
@@ -58,7 +58,12 @@ class MusicStorage {
   };
 
   struct DeleteJob {
+    DeleteJob() : use_trash_(false) {}
+
     Song metadata_;
+    // Filesystems move the file to the trash instead, other storages ignore
+    // this and delete it.
+    bool use_trash_;
   };
 
   virtual QString LocalPath() const { return QString(); }
@@ -74,10 +79,19 @@ class MusicStorage {
   virtual bool StartCopy(QList<Song::FileType>* supported_types) {
     return true;
   }
+  // True if files can be written straight to LocalPath, so a file that has to
+  // be transcoded first doesn't need CopyToStorage.
+  virtual bool AcceptsDirectWrites() const { return false; }
+  // How many CopyToStorage calls can be made at once from different threads.
+  // Jobs copied in parallel get no progress function.
+  virtual int MaxConcurrentCopies() const { return 1; }
   virtual bool CopyToStorage(const CopyJob& job) = 0;
   virtual void FinishCopy(bool success) {}
 
   virtual void StartDelete() {}
+  // How many DeleteFromStorage calls can be made at once from different
+  // threads.
+  virtual int MaxConcurrentDeletes() const { return 1; }
   virtual bool DeleteFromStorage(const DeleteJob& job) = 0;
   virtual void FinishDelete(bool success) {}
 
@@ -20,6 +20,7 @@
 #include "network.h"
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
 #include <QNetworkAccessManager>
 #include <QNetworkDiskCache>
@@ -27,6 +28,8 @@
 
 #include "core/closure.h"
 #include "core/logging.h"
+#include "core/networkscheduler.h"
+#include "core/queuednetworkreply.h"
 #include "utilities.h"
 
 QMutex ThreadSafeNetworkDiskCache::sMutex;
@@ -84,6 +87,11 @@ void ThreadSafeNetworkDiskCache::clear() {
   sCache->clear();
 }
 
+const QNetworkRequest::Attribute NetworkAccessManager::kScheduledAttribute =
+    QNetworkRequest::Attribute(QNetworkRequest::User);
+const QNetworkRequest::Attribute NetworkAccessManager::kCreatedAttribute =
+    QNetworkRequest::Attribute(QNetworkRequest::User + 1);
+
 NetworkAccessManager::NetworkAccessManager(QObject* parent)
     : QNetworkAccessManager(parent), timeout_msec_(0) {
   setCache(new ThreadSafeNetworkDiskCache(this));
@@ -94,8 +102,25 @@ NetworkAccessManager::NetworkAccessManager(int timeout, QObject* parent)
   setCache(new ThreadSafeNetworkDiskCache(this));
 }
 
+QString NetworkAccessManager::subsystem() const {
+  if (!subsystem_.isEmpty()) return subsystem_;
+  if (parent()) return parent()->metaObject()->className();
+  return "Other";
+}
+
 QNetworkReply* NetworkAccessManager::createRequest(
     Operation op, const QNetworkRequest& request, QIODevice* outgoingData) {
+  // Requests from a QueuedNetworkReply were set up the first time round.
+  if (request.attribute(kScheduledAttribute).toBool()) {
+    QNetworkReply* reply =
+        QNetworkAccessManager::createRequest(op, request, outgoingData);
+    new ScheduledRequest(request.url().host().toLower(), subsystem(),
+                         request.attribute(kCreatedAttribute).toLongLong(),
+                         reply);
+    AddTimeout(reply);
+    return reply;
+  }
+
   qLogCat(Debug, "NetworkRequests") << request.url();
   QByteArray user_agent = QString("%1 %2")
                               .arg(QCoreApplication::applicationName(),
@@ -117,22 +142,81 @@ QNetworkReply* NetworkAccessManager::createRequest(
                           "application/x-www-form-urlencoded");
   }
 
-  // Prefer the cache unless the caller has changed the setting already
-  if (request.attribute(QNetworkRequest::CacheLoadControlAttribute).toInt() ==
-      QNetworkRequest::PreferNetwork) {
-    new_request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
-                             QNetworkRequest::PreferCache);
+  // The cache is left on PreferNetwork, which uses cached replies for as long
+  // as their Cache-Control and Expires headers say they're fresh, and
+  // revalidates them with their ETag or Last-Modified after that.
+
+  const QString scheme = request.url().scheme();
+  const QString host = request.url().host().toLower();
+  if ((scheme != "http" && scheme != "https") || host.isEmpty()) {
+    QNetworkReply* reply =
+        QNetworkAccessManager::createRequest(op, new_request, outgoingData);
+    AddTimeout(reply);
+    return reply;
+  }
+
+  const qint64 created_msec = QDateTime::currentMSecsSinceEpoch();
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+  if (!scheduler->TryStart(host)) {
+    new_request.setAttribute(kCreatedAttribute, created_msec);
+    QueuedNetworkReply* queued =
+        new QueuedNetworkReply(this, op, new_request, outgoingData, host);
+    scheduler->Enqueue(host, request.priority(), queued);
+    return queued;
   }
 
   QNetworkReply* reply =
       QNetworkAccessManager::createRequest(op, new_request, outgoingData);
+  new ScheduledRequest(host, subsystem(), created_msec, reply);
+  AddTimeout(reply);
+  return reply;
+}
+
+void NetworkAccessManager::AddTimeout(QNetworkReply* reply) {
   if (timeout_msec_ > 0) {
     // Since the parent is the reply, this object will be destroyed when the
     // reply is destroyed.
     NetworkTimeouts* timeout = new NetworkTimeouts(timeout_msec_, reply);
     timeout->AddReply(reply);
   }
-  return reply;
+}
+
+ScheduledRequest::ScheduledRequest(const QString& host,
+                                   const QString& subsystem,
+                                   qint64 created_msec, QNetworkReply* reply)
+    : QObject(reply),
+      reply_(reply),
+      host_(host),
+      subsystem_(subsystem),
+      created_msec_(created_msec),
+      released_(false) {
+  connect(reply, SIGNAL(finished()), SLOT(Finished()));
+}
+
+ScheduledRequest::~ScheduledRequest() {
+  if (!released_) NetworkScheduler::Instance()->Release(host_);
+}
+
+void ScheduledRequest::Finished() {
+  if (released_) return;
+  released_ = true;
+
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+
+  // 429 Too Many Requests and 503 Service Unavailable can both say how long
+  // to wait before trying again.
+  const int status =
+      reply_->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if ((status == 429 || status == 503) && reply_->hasRawHeader("Retry-After")) {
+    const int seconds = reply_->rawHeader("Retry-After").toInt();
+    if (seconds > 0) scheduler->Backoff(host_, seconds * 1000);
+  }
+
+  scheduler->RecordRequest(
+      subsystem_, QDateTime::currentMSecsSinceEpoch() - created_msec_,
+      reply_->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool(),
+      reply_->error() != QNetworkReply::NoError);
+  scheduler->Release(host_);
 }
 
 NetworkTimeouts::NetworkTimeouts(int timeout_msec, QObject* parent)
@@ -143,9 +227,23 @@ void NetworkTimeouts::AddReply(QNetworkReply* reply) {
 
   connect(reply, SIGNAL(destroyed()), SLOT(ReplyFinished()));
   connect(reply, SIGNAL(finished()), SLOT(ReplyFinished()));
+
+  // Time spent waiting for the scheduler doesn't count.
+  QueuedNetworkReply* queued = qobject_cast<QueuedNetworkReply*>(reply);
+  if (queued && !queued->started()) {
+    timers_[reply] = 0;
+    connect(queued, SIGNAL(Started()), SLOT(QueuedReplyStarted()));
+    return;
+  }
+
   timers_[reply] = startTimer(timeout_msec_);
 }
 
+void NetworkTimeouts::QueuedReplyStarted() {
+  QNetworkReply* reply = reinterpret_cast<QNetworkReply*>(sender());
+  if (timers_.contains(reply)) timers_[reply] = startTimer(timeout_msec_);
+}
+
 void NetworkTimeouts::AddReply(RedirectFollower* reply) {
   if (redirect_timers_.contains(reply)) {
     return;
@@ -161,7 +259,8 @@ void NetworkTimeouts::AddReply(RedirectFollower* reply) {
 void NetworkTimeouts::ReplyFinished() {
   QNetworkReply* reply = reinterpret_cast<QNetworkReply*>(sender());
   if (timers_.contains(reply)) {
-    killTimer(timers_.take(reply));
+    const int timer = timers_.take(reply);
+    if (timer) killTimer(timer);
   }
 }
 
@@ -46,6 +46,9 @@ class ThreadSafeNetworkDiskCache : public QAbstractNetworkCache {
   static QNetworkDiskCache* sCache;
 };
 
+// Requests to http and https URLs go through the NetworkScheduler, which
+// might return a QueuedNetworkReply that starts later.  Set the request's
+// priority to move it up or down the queue.
 class NetworkAccessManager : public QNetworkAccessManager {
   Q_OBJECT
 
@@ -53,10 +56,44 @@ class NetworkAccessManager : public QNetworkAccessManager {
   explicit NetworkAccessManager(QObject* parent = nullptr);
   explicit NetworkAccessManager(int timeout, QObject* parent = nullptr);
 
+  // Set on requests that the scheduler has already let through.
+  static const QNetworkRequest::Attribute kScheduledAttribute;
+  // When the request was first made, in msec since the epoch.
+  static const QNetworkRequest::Attribute kCreatedAttribute;
+
+  // The name this manager's requests are counted under.  Defaults to the
+  // class name of the parent.
+  QString subsystem() const;
+  void set_subsystem(const QString& subsystem) { subsystem_ = subsystem; }
+
  protected:
   QNetworkReply* createRequest(Operation op, const QNetworkRequest& request,
                                QIODevice* outgoingData);
+  void AddTimeout(QNetworkReply* reply);
+
   int timeout_msec_;
+  QString subsystem_;
+};
+
+// A child of a reply that the scheduler let start.  Records how the request
+// went and gives its place back when the reply finishes or is deleted.
+class ScheduledRequest : public QObject {
+  Q_OBJECT
+
+ public:
+  ScheduledRequest(const QString& host, const QString& subsystem,
+                   qint64 created_msec, QNetworkReply* reply);
+  ~ScheduledRequest();
+
+ private slots:
+  void Finished();
+
+ private:
+  QNetworkReply* reply_;
+  QString host_;
+  QString subsystem_;
+  qint64 created_msec_;
+  bool released_;
 };
 
 class RedirectFollower : public QObject {
@@ -120,6 +157,7 @@ class NetworkTimeouts : public QObject {
 
  private slots:
   void ReplyFinished();
+  void QueuedReplyStarted();
   void RedirectFinished(RedirectFollower* redirect);
 
  private:
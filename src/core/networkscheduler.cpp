@@ -0,0 +1,212 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "networkscheduler.h"
+
+#include <QMetaObject>
+
+#include "core/logging.h"
+#include "core/queuednetworkreply.h"
+
+const int NetworkScheduler::kDefaultMaxConnections = 6;
+
+NetworkScheduler* NetworkScheduler::Instance() {
+  static NetworkScheduler instance;
+  return &instance;
+}
+
+NetworkScheduler::NetworkScheduler() {
+  clock_.start();
+
+  // The published limits of the services that rate-limit us.  Last.fm allows
+  // 5 requests a second, MusicBrainz and Discogs 1, and AcoustID 3.
+  SetDomainLimits("ws.audioscrobbler.com", 2, 200);
+  SetDomainLimits("musicbrainz.org", 1, 1000);
+  SetDomainLimits("api.discogs.com", 1, 1000);
+  SetDomainLimits("api.acoustid.org", 1, 334);
+}
+
+void NetworkScheduler::SetDomainLimits(const QString& domain,
+                                       int max_connections,
+                                       int min_interval_msec) {
+  QMutexLocker l(&mutex_);
+
+  Limits limits;
+  limits.max_connections_ = qMax(1, max_connections);
+  limits.min_interval_msec_ = qMax(0, min_interval_msec);
+  domain_limits_[domain.toLower()] = limits;
+
+  // Hosts we've already seen pick up the new limits from their next request.
+  for (auto it = hosts_.begin(); it != hosts_.end(); ++it) {
+    it->limits_ = LimitsForHost(it.key());
+  }
+}
+
+NetworkScheduler::Limits NetworkScheduler::LimitsForHost(
+    const QString& host) const {
+  for (auto it = domain_limits_.constBegin(); it != domain_limits_.constEnd();
+       ++it) {
+    if (host == it.key() || host.endsWith("." + it.key())) return it.value();
+  }
+
+  Limits limits;
+  limits.max_connections_ = kDefaultMaxConnections;
+  limits.min_interval_msec_ = 0;
+  return limits;
+}
+
+NetworkScheduler::Host* NetworkScheduler::HostState(const QString& host) {
+  auto it = hosts_.find(host);
+  if (it == hosts_.end()) {
+    Host state;
+    state.limits_ = LimitsForHost(host);
+    state.running_ = 0;
+    state.next_start_msec_ = 0;
+    it = hosts_.insert(host, state);
+  }
+  return &it.value();
+}
+
+qint64 NetworkScheduler::Reserve(Host* host) {
+  const qint64 now = clock_.elapsed();
+  const qint64 start = qMax(now, host->next_start_msec_);
+
+  host->running_++;
+  host->next_start_msec_ = start + host->limits_.min_interval_msec_;
+  return start - now;
+}
+
+bool NetworkScheduler::TryStart(const QString& host) {
+  QMutexLocker l(&mutex_);
+  Host* state = HostState(host);
+
+  if (!state->queue_.isEmpty() ||
+      state->running_ >= state->limits_.max_connections_ ||
+      state->next_start_msec_ > clock_.elapsed()) {
+    return false;
+  }
+
+  Reserve(state);
+  return true;
+}
+
+void NetworkScheduler::Enqueue(const QString& host,
+                               QNetworkRequest::Priority priority,
+                               QueuedNetworkReply* reply) {
+  QMutexLocker l(&mutex_);
+  Host* state = HostState(host);
+
+  // QNetworkRequest::Priority goes from High = 1 to Low = 5.
+  int pos = state->queue_.count();
+  while (pos > 0 && state->queue_[pos - 1].priority_ > priority) --pos;
+
+  QueuedRequest request;
+  request.priority_ = priority;
+  request.reply_ = reply;
+  state->queue_.insert(pos, request);
+
+  qLogCat(Debug, "NetworkRequests") << "Queued a request to" << host << "behind"
+                                    << pos << "others";
+
+  // A place might have come free since TryStart.
+  StartQueued(state);
+}
+
+void NetworkScheduler::StartQueued(Host* host) {
+  while (!host->queue_.isEmpty() &&
+         host->running_ < host->limits_.max_connections_) {
+    QueuedNetworkReply* reply = host->queue_.takeFirst().reply_;
+    const int wait_msec = Reserve(host);
+    QMetaObject::invokeMethod(reply, "StartAfter", Qt::QueuedConnection,
+                              Q_ARG(int, wait_msec));
+  }
+}
+
+void NetworkScheduler::Cancel(const QString& host, QueuedNetworkReply* reply) {
+  QMutexLocker l(&mutex_);
+  Host* state = HostState(host);
+
+  for (int i = 0; i < state->queue_.count(); ++i) {
+    if (state->queue_[i].reply_ == reply) {
+      state->queue_.removeAt(i);
+      return;
+    }
+  }
+
+  // It had been given a place but didn't use it.
+  state->running_--;
+  StartQueued(state);
+}
+
+void NetworkScheduler::Release(const QString& host) {
+  QMutexLocker l(&mutex_);
+  Host* state = HostState(host);
+
+  state->running_--;
+  StartQueued(state);
+
+  if (state->running_ == 0 && state->queue_.isEmpty() &&
+      state->next_start_msec_ <= clock_.elapsed()) {
+    hosts_.remove(host);
+  }
+}
+
+void NetworkScheduler::Backoff(const QString& host, int msec) {
+  QMutexLocker l(&mutex_);
+  Host* state = HostState(host);
+
+  qLog(Info) << host << "asked us to wait" << msec << "ms";
+  state->next_start_msec_ =
+      qMax(state->next_start_msec_, clock_.elapsed() + msec);
+}
+
+void NetworkScheduler::RecordRequest(const QString& subsystem, qint64 msec,
+                                     bool from_cache, bool failed) {
+  QMutexLocker l(&mutex_);
+
+  auto it = counts_.find(subsystem);
+  if (it == counts_.end()) {
+    Counts counts;
+    counts.requests_ = 0;
+    counts.cache_hits_ = 0;
+    counts.errors_ = 0;
+    it = counts_.insert(subsystem, counts);
+  }
+
+  it->requests_++;
+  if (from_cache) it->cache_hits_++;
+  if (failed) it->errors_++;
+  latency_.Record(subsystem, msec * 1000);
+}
+
+QList<NetworkScheduler::SubsystemStats> NetworkScheduler::Statistics() const {
+  QMutexLocker l(&mutex_);
+
+  QList<SubsystemStats> ret;
+  for (const LatencyStats::Summary& summary : latency_.Summaries()) {
+    const Counts& counts = counts_[summary.name_];
+
+    SubsystemStats stats;
+    stats.name_ = summary.name_;
+    stats.requests_ = counts.requests_;
+    stats.cache_hits_ = counts.cache_hits_;
+    stats.errors_ = counts.errors_;
+    stats.latency_ = summary;
+    ret << stats;
+  }
+  return ret;
+}
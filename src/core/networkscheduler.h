@@ -0,0 +1,127 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_NETWORKSCHEDULER_H_
+#define CORE_NETWORKSCHEDULER_H_
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QNetworkRequest>
+#include <QString>
+
+#include "core/latencystats.h"
+
+class QueuedNetworkReply;
+
+// Decides when requests made through a NetworkAccessManager can start.  Every
+// manager in the process shares the one instance, so the limits hold however
+// many parts of Clementine are talking to the same host.
+//
+// Each host gets a number of connections and, for the services that ask for
+// it, a minimum interval between starting requests.  Requests past those
+// limits wait in a queue per host, higher priority ones first.
+//
+// It also counts requests, cache hits and latency per subsystem, which is the
+// class name of the manager's parent unless the manager was given a name.
+// Thread-safe.
+class NetworkScheduler {
+ public:
+  static NetworkScheduler* Instance();
+
+  static const int kDefaultMaxConnections;
+
+  struct SubsystemStats {
+    QString name_;
+    int requests_;
+    int cache_hits_;
+    int errors_;
+    LatencyStats::Summary latency_;
+  };
+
+  // Applies to domain and its subdomains.
+  void SetDomainLimits(const QString& domain, int max_connections,
+                       int min_interval_msec);
+
+  // Returns true if a request to host can start straight away, in which case
+  // it's counted as running until Release is called.
+  bool TryStart(const QString& host);
+
+  // Queues a reply that TryStart turned down.  The reply's StartAfter slot is
+  // called in its own thread once it's been given a place.
+  void Enqueue(const QString& host, QNetworkRequest::Priority priority,
+               QueuedNetworkReply* reply);
+
+  // Takes a reply out of the queue, or gives up the place it was given if it
+  // never started.
+  void Cancel(const QString& host, QueuedNetworkReply* reply);
+
+  void Release(const QString& host);
+
+  // The host asked us to slow down, so nothing else starts there for msec.
+  void Backoff(const QString& host, int msec);
+
+  void RecordRequest(const QString& subsystem, qint64 msec, bool from_cache,
+                     bool failed);
+  QList<SubsystemStats> Statistics() const;
+
+ private:
+  NetworkScheduler();
+
+  struct Limits {
+    int max_connections_;
+    int min_interval_msec_;
+  };
+
+  struct QueuedRequest {
+    QNetworkRequest::Priority priority_;
+    QueuedNetworkReply* reply_;
+  };
+
+  struct Host {
+    Limits limits_;
+    int running_;
+    qint64 next_start_msec_;
+    QList<QueuedRequest> queue_;
+  };
+
+  struct Counts {
+    int requests_;
+    int cache_hits_;
+    int errors_;
+  };
+
+  Host* HostState(const QString& host);
+  Limits LimitsForHost(const QString& host) const;
+
+  // Counts another request as running and returns how long it has to wait
+  // before it starts.
+  qint64 Reserve(Host* host);
+  void StartQueued(Host* host);
+
+  mutable QMutex mutex_;
+  QElapsedTimer clock_;
+
+  QMap<QString, Limits> domain_limits_;
+  QMap<QString, Host> hosts_;
+
+  QMap<QString, Counts> counts_;
+  LatencyStats latency_;
+};
+
+#endif  // CORE_NETWORKSCHEDULER_H_
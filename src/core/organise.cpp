@@ -22,12 +22,17 @@
 #include "organise.h"
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QFuture>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrl>
 #include <functional>
 
+#include "core/concurrentrun.h"
 #include "core/logging.h"
 #include "core/tagreaderclient.h"
 #include "core/utilities.h"
@@ -37,7 +42,9 @@
 using std::placeholders::_1;
 
 const int Organise::kBatchSize = 10;
+const int Organise::kPathChangeBatchSize = 500;
 const int Organise::kTranscodeProgressInterval = 500;
+const qint64 Organise::kMaxPrefetchSize = 256 * 1024 * 1024;
 
 Organise::Organise(TaskManager* task_manager,
                    std::shared_ptr<MusicStorage> destination,
@@ -58,7 +65,9 @@ Organise::Organise(TaskManager* task_manager,
       tasks_complete_(0),
       started_(false),
       task_id_(0),
-      current_copy_progress_(0) {
+      current_copy_progress_(0),
+      bytes_copied_(0),
+      copy_msec_(0) {
   original_thread_ = thread();
 
   for (const NewSongInfo& song_info : songs_info) {
@@ -105,6 +114,8 @@ void Organise::ProcessSomeFiles() {
 
     UpdateProgress();
 
+    FlushPathChanges();
+    manifest_.Save();
     destination_->FinishCopy(files_with_errors_.isEmpty());
     if (eject_after_) destination_->Eject();
 
@@ -123,7 +134,10 @@ void Organise::ProcessSomeFiles() {
   }
 
   // We process files in batches so we can be cancelled part-way through.
-  for (int i = 0; i < kBatchSize; ++i) {
+  // Destinations that copy in parallel get a batch for each copy.
+  const int max_copies = qMax(1, destination_->MaxConcurrentCopies());
+  QList<PendingCopy> copies;
+  for (int i = 0; i < kBatchSize * max_copies; ++i) {
     SetSongProgress(0);
 
     if (tasks_pending_.isEmpty()) break;
@@ -163,11 +177,43 @@ void Organise::ProcessSomeFiles() {
       if (dest_type != Song::Type_Unknown) {
         // Get the preset
         TranscoderPreset preset = Transcoder::PresetForFileType(dest_type);
+
+        // Keeping a device in sync shouldn't encode everything again.  Only
+        // copies can be skipped, a move has to get rid of the original.
+        const QString root = destination_->LocalPath();
+        if (!root.isEmpty()) {
+          task.destination_path_ =
+              root + "/" +
+              Utilities::FiddleFileExtension(task.song_info_.new_filename_,
+                                             preset.extension_);
+          task.manifest_key_ = transcoder_->JobKey(song.url(), preset);
+          if (copy_ &&
+              manifest_.IsUpToDate(task.destination_path_,
+                                   task.manifest_key_)) {
+            qLog(Info) << "Skipping" << song.url().toLocalFile() << ","
+                       << task.destination_path_ << "is up to date";
+            tasks_complete_++;
+            continue;
+          }
+        }
+
         qLog(Debug) << "Transcoding with" << preset.name_;
 
-        // Get a temporary name for the transcoded file
-        task.transcoded_filename_ = transcode_temp_name_.fileName() + "-" +
-                                    QString::number(transcode_suffix_++);
+        if (destination_->AcceptsDirectWrites() && !root.isEmpty()) {
+          // The encoder writes the file where it's going, rather than to a
+          // temporary file that's copied afterwards.
+          if (!overwrite_ && QFile::exists(task.destination_path_)) {
+            files_with_errors_ << task.song_info_.song_.basefilename();
+            tasks_complete_++;
+            continue;
+          }
+          task.transcoded_filename_ = task.destination_path_;
+          task.written_in_place_ = true;
+        } else {
+          // Get a temporary name for the transcoded file
+          task.transcoded_filename_ = transcode_temp_name_.fileName() + "-" +
+                                      QString::number(transcode_suffix_++);
+        }
         task.new_extension_ = preset.extension_;
         task.new_filetype_ = dest_type;
         tasks_transcoding_[task.song_info_.song_.url().toLocalFile()] = task;
@@ -178,7 +224,7 @@ void Organise::ProcessSomeFiles() {
         // FileTranscoded() will get called when it's done.  At that point the
         // task will get re-added to the pending queue with the new filename.
         transcoder_->AddJob(task.song_info_.song_.url(), preset,
-                            task.transcoded_filename_);
+                            task.transcoded_filename_, true);
         transcoder_->Start();
         continue;
       }
@@ -193,35 +239,149 @@ void Organise::ProcessSomeFiles() {
     job.overwrite_ = overwrite_;
     job.mark_as_listened_ = mark_as_listened_;
     job.remove_original_ = !copy_;
-    job.progress_ = std::bind(&Organise::SetSongProgress, this, _1,
-                              !task.transcoded_filename_.isEmpty());
+    if (max_copies == 1) {
+      job.progress_ = std::bind(&Organise::SetSongProgress, this, _1,
+                                !task.transcoded_filename_.isEmpty());
+    }
 
-    if (!destination_->CopyToStorage(job)) {
+    PendingCopy copy;
+    copy.task_ = task;
+    copy.job_ = job;
+    if (task.written_in_place_) {
+      copy.needs_copy_ = false;
+      copy.success_ = true;
+    }
+    copies << copy;
+  }
+
+  CopyFiles(&copies, max_copies);
+
+  for (const PendingCopy& copy : copies) {
+    const Task& task = copy.task_;
+    const MusicStorage::CopyJob& job = copy.job_;
+
+    if (!copy.success_) {
       files_with_errors_ << task.song_info_.song_.basefilename();
     } else {
       if (job.remove_original_) {
         // Notify other aspects of system that song has been invalidated
         QString root = destination_->LocalPath();
-        QFileInfo new_file =
-            QFileInfo(root + "/" + task.song_info_.new_filename_);
-        emit SongPathChanged(song, new_file);
+        Song updated_song = job.metadata_;
+        updated_song.InitFromFilePartial(root + "/" +
+                                         task.song_info_.new_filename_);
+        path_changes_ << updated_song;
       }
       if (job.mark_as_listened_) {
         emit FileCopied(job.metadata_.id());
       }
+      if (!task.transcoded_filename_.isEmpty() &&
+          !task.destination_path_.isEmpty()) {
+        manifest_.Record(task.destination_path_, task.manifest_key_);
+      }
     }
 
     // Clean up the temporary transcoded file
-    if (!task.transcoded_filename_.isEmpty())
+    if (!task.transcoded_filename_.isEmpty() && !task.written_in_place_)
       QFile::remove(task.transcoded_filename_);
 
     tasks_complete_++;
   }
   SetSongProgress(0);
 
+  if (path_changes_.count() >= kPathChangeBatchSize) FlushPathChanges();
+
   QTimer::singleShot(0, this, SLOT(ProcessSomeFiles()));
 }
 
+void Organise::CopyFiles(QList<PendingCopy>* copies, int max_copies) {
+  QElapsedTimer timer;
+  timer.start();
+  for (const PendingCopy& copy : *copies) {
+    // Moves remove the source, so get its size first.
+    if (copy.needs_copy_) bytes_copied_ += QFileInfo(copy.job_.source_).size();
+  }
+
+  if (max_copies == 1 || copies->count() < 2) {
+    CopyFilesInOrder(copies);
+  } else {
+    // Each copy only touches its own PendingCopy, and this thread waits for
+    // all of them before looking at the results.
+    QThreadPool pool;
+    pool.setMaxThreadCount(max_copies);
+
+    QList<QFuture<void>> futures;
+    for (PendingCopy& copy : *copies) {
+      if (!copy.needs_copy_) continue;
+      PendingCopy* copy_ptr = &copy;
+      std::shared_ptr<MusicStorage> destination = destination_;
+      futures << ConcurrentRun::Run<void>(&pool, [copy_ptr, destination]() {
+        copy_ptr->success_ = destination->CopyToStorage(copy_ptr->job_);
+      });
+    }
+    for (QFuture<void>& future : futures) {
+      future.waitForFinished();
+    }
+  }
+
+  copy_msec_ += timer.elapsed();
+  UpdateTransferSpeed();
+}
+
+void Organise::CopyFilesInOrder(QList<PendingCopy>* copies) {
+  // Devices like MTP players take one file at a time, and would otherwise sit
+  // idle while each file is read from the disk.  The next file is read in the
+  // background while this one is sent.
+  QThreadPool pool;
+  pool.setMaxThreadCount(1);
+
+  QFuture<void> prefetch;
+  for (int i = 0; i < copies->count(); ++i) {
+    PendingCopy& copy = (*copies)[i];
+    if (!copy.needs_copy_) continue;
+
+    for (int j = i + 1; j < copies->count(); ++j) {
+      if (!copies->at(j).needs_copy_) continue;
+      const QString next = copies->at(j).job_.source_;
+      prefetch.waitForFinished();
+      prefetch =
+          ConcurrentRun::Run<void>(&pool, [next]() { PrefetchFile(next); });
+      break;
+    }
+
+    copy.success_ = destination_->CopyToStorage(copy.job_);
+  }
+  prefetch.waitForFinished();
+}
+
+void Organise::PrefetchFile(const QString& filename) {
+  QFile file(filename);
+  if (file.size() > kMaxPrefetchSize || !file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  // The data's thrown away, it's only read so the copy finds it in memory.
+  QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+  while (file.read(buffer.data(), buffer.size()) > 0) {
+  }
+}
+
+void Organise::UpdateTransferSpeed() {
+  if (copy_msec_ < 1000) return;
+
+  task_manager_->SetTaskName(
+      task_id_, tr("Organising files (%1/s)")
+                    .arg(Utilities::PrettySize(bytes_copied_ * 1000 /
+                                               copy_msec_)));
+}
+
+void Organise::FlushPathChanges() {
+  if (path_changes_.isEmpty()) return;
+
+  // The library updates all of them in one transaction.
+  emit SongPathsChanged(path_changes_);
+  path_changes_.clear();
+}
+
 Song::FileType Organise::CheckTranscode(Song::FileType original_type) const {
   if (original_type == Song::Type_Stream) return Song::Type_Unknown;
 
@@ -28,10 +28,11 @@
 #include <QTemporaryFile>
 #include <memory>
 
+#include "musicstorage.h"
 #include "organiseformat.h"
+#include "transcoder/transcodemanifest.h"
 #include "transcoder/transcoder.h"
 
-class MusicStorage;
 class TaskManager;
 
 class Organise : public QObject {
@@ -53,14 +54,19 @@ class Organise : public QObject {
            bool eject_after);
 
   static const int kBatchSize;
+  // Moved songs are sent to the library in lists of about this many.
+  static const int kPathChangeBatchSize;
   static const int kTranscodeProgressInterval;
+  // Files bigger than this aren't read ahead of being copied.
+  static const qint64 kMaxPrefetchSize;
 
   void Start();
 
  signals:
   void Finished(const QStringList& files_with_errors);
   void FileCopied(int database_id);
-  void SongPathChanged(const Song& song, const QFileInfo& new_file);
+  // The moved songs, with their new paths.
+  void SongPathsChanged(const SongList& songs);
 
  protected:
   void timerEvent(QTimerEvent* e);
@@ -77,7 +83,9 @@ class Organise : public QObject {
  private:
   struct Task {
     explicit Task(const NewSongInfo& song_info = NewSongInfo())
-        : song_info_(song_info), transcode_progress_(0.0) {}
+        : song_info_(song_info),
+          transcode_progress_(0.0),
+          written_in_place_(false) {}
 
     NewSongInfo song_info_;
 
@@ -85,8 +93,31 @@ class Organise : public QObject {
     QString transcoded_filename_;
     QString new_extension_;
     Song::FileType new_filetype_;
+    // Where the transcoded file ends up and what it was made from, for the
+    // manifest.  Only set for destinations with a local path.
+    QString destination_path_;
+    QByteArray manifest_key_;
+    // The encoder wrote transcoded_filename_ in the destination.
+    bool written_in_place_;
   };
 
+  struct PendingCopy {
+    PendingCopy() : needs_copy_(true), success_(false) {}
+
+    Task task_;
+    MusicStorage::CopyJob job_;
+    bool needs_copy_;
+    bool success_;
+  };
+
+  // Copies on up to max_copies threads at once, and waits for them all.
+  void CopyFiles(QList<PendingCopy>* copies, int max_copies);
+  void CopyFilesInOrder(QList<PendingCopy>* copies);
+  // Reads the file so it's in the page cache by the time it's copied.
+  static void PrefetchFile(const QString& filename);
+  void UpdateTransferSpeed();
+  void FlushPathChanges();
+
   QThread* thread_;
   QThread* original_thread_;
   TaskManager* task_manager_;
@@ -101,6 +132,9 @@ class Organise : public QObject {
   const bool eject_after_;
   int task_count_;
 
+  // Files on the destination that were transcoded by an earlier run.
+  TranscodeManifest manifest_;
+
   QBasicTimer transcode_progress_timer_;
   QTemporaryFile transcode_temp_name_;
   int transcode_suffix_;
@@ -114,7 +148,12 @@ class Organise : public QObject {
   int task_id_;
   int current_copy_progress_;
 
+  // Only copies to the destination are counted, not transcoding.
+  qint64 bytes_copied_;
+  qint64 copy_msec_;
+
   QStringList files_with_errors_;
+  SongList path_changes_;
 };
 
 #endif  // CORE_ORGANISE_H_
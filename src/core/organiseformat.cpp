@@ -24,9 +24,12 @@
 
 #include <QApplication>
 #include <QFileInfo>
+#include <QFuture>
 #include <QHash>
 #include <QPalette>
+#include <QThread>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 #include "core/arraysize.h"
 #include "core/timeconstants.h"
@@ -65,6 +68,48 @@ const char OrganiseFormat::kInvalidPrefixCharacters[] = ".";
 const int OrganiseFormat::kInvalidPrefixCharactersCount =
     arraysize(OrganiseFormat::kInvalidPrefixCharacters) - 1;
 
+namespace {
+
+// In the same order as kKnownTags.
+enum Tag {
+  Tag_Title,
+  Tag_Album,
+  Tag_Artist,
+  Tag_ArtistInitial,
+  Tag_AlbumArtist,
+  Tag_Composer,
+  Tag_Track,
+  Tag_Disc,
+  Tag_Bpm,
+  Tag_Year,
+  Tag_Genre,
+  Tag_Comment,
+  Tag_Length,
+  Tag_Bitrate,
+  Tag_Samplerate,
+  Tag_Extension,
+  Tag_Performer,
+  Tag_Grouping,
+  Tag_Lyrics,
+  Tag_OriginalYear,
+};
+
+// Lists shorter than this aren't worth splitting between threads.
+const int kMinSongsPerThread = 1000;
+
+// Removes a leading "the" and the space after it.
+void StripThe(QString* value) {
+  if (value->length() < 4 || !value->startsWith("the", Qt::CaseInsensitive) ||
+      !value->at(3).isSpace())
+    return;
+
+  int end = 4;
+  while (end < value->length() && value->at(end).isSpace()) ++end;
+  value->remove(0, end);
+}
+
+}  // namespace
+
 const QRgb OrganiseFormat::SyntaxHighlighter::kValidTagColorLight =
     qRgb(64, 64, 255);
 const QRgb OrganiseFormat::SyntaxHighlighter::kInvalidTagColorLight =
@@ -83,11 +128,71 @@ OrganiseFormat::OrganiseFormat(const QString& format)
     : format_(format),
       replace_non_ascii_(false),
       replace_spaces_(false),
-      replace_the_(false) {}
+      replace_the_(false) {
+  Compile();
+}
 
 void OrganiseFormat::set_format(const QString& v) {
   format_ = v;
   format_.replace('\\', '/');
+  Compile();
+}
+
+void OrganiseFormat::Compile() {
+  // This reads the format the same way as kBlockPattern and kTagPattern: a
+  // block is the text between a { and the next }, as long as there's
+  // something in it and no other {.  Anything else is literal.
+  instructions_.clear();
+
+  int block_begin = -1;
+  QString literal;
+  auto add = [this, &literal](Instruction::Type type, const QString& text,
+                              int tag) {
+    if (!literal.isEmpty()) {
+      const Instruction instruction = {Instruction::Type_Literal, literal, -1,
+                                       0};
+      instructions_.append(instruction);
+      literal.clear();
+    }
+    if (type != Instruction::Type_Literal) {
+      const Instruction instruction = {type, text, tag, 0};
+      instructions_.append(instruction);
+    }
+  };
+
+  for (int i = 0; i < format_.length(); ++i) {
+    const QChar c = format_[i];
+
+    if (c == '%') {
+      int end = i + 1;
+      while (end < format_.length() && format_[end].unicode() < 128 &&
+             format_[end].isLetter())
+        ++end;
+
+      const QString name = format_.mid(i + 1, end - i - 1);
+      add(Instruction::Type_Tag, name, kKnownTags.indexOf(name));
+      i = end - 1;
+    } else if (c == '{' && block_begin == -1) {
+      int end = i + 1;
+      while (end < format_.length() && format_[end] != '{' &&
+             format_[end] != '}')
+        ++end;
+
+      if (end > i + 1 && end < format_.length() && format_[end] == '}') {
+        add(Instruction::Type_Block, QString(), -1);
+        block_begin = instructions_.count() - 1;
+      } else {
+        literal.append(c);
+      }
+    } else if (c == '}' && block_begin != -1) {
+      add(Instruction::Type_Literal, QString(), -1);
+      instructions_[block_begin].block_end = instructions_.count();
+      block_begin = -1;
+    } else {
+      literal.append(c);
+    }
+  }
+  add(Instruction::Type_Literal, QString(), -1);
 }
 
 bool OrganiseFormat::IsValid() const {
@@ -100,7 +205,7 @@ bool OrganiseFormat::IsValid() const {
 
 QString OrganiseFormat::GetFilenameForSong(const Song& song,
                                            QString prefix_path) const {
-  QString filename = ParseBlock(format_, song);
+  QString filename = Evaluate(0, instructions_.count(), song);
 
   if (QFileInfo(filename).completeBaseName().isEmpty()) {
     // Avoid having empty filenames, or filenames with extension only: in this
@@ -112,7 +217,11 @@ QString OrganiseFormat::GetFilenameForSong(const Song& song,
         Utilities::PathWithoutFilenameExtension(filename) + song.basefilename();
   }
 
-  if (replace_spaces_) filename.replace(QRegExp("\\s"), "_");
+  if (replace_spaces_) {
+    for (int i = 0; i < filename.length(); ++i) {
+      if (filename[i].isSpace()) filename[i] = '_';
+    }
+  }
 
   if (replace_non_ascii_) {
     QString stripped;
@@ -164,8 +273,30 @@ QStringList OrganiseFormat::GetFilenamesForSongs(const SongList& songs) const {
   QHash<QString, int> filenames;
   QStringList new_filenames;
 
-  for (const Song& song : songs) {
-    QString new_filename = GetFilenameForSong(song);
+  QVector<QString> names(songs.count());
+  const int threads = qBound(
+      1, songs.count() / kMinSongsPerThread, QThread::idealThreadCount());
+  if (threads == 1) {
+    for (int i = 0; i < songs.count(); ++i) {
+      names[i] = GetFilenameForSong(songs[i]);
+    }
+  } else {
+    // Each thread fills in its own part of names.
+    QList<QFuture<void>> futures;
+    for (int t = 0; t < threads; ++t) {
+      const int begin = songs.count() * t / threads;
+      const int end = songs.count() * (t + 1) / threads;
+      futures << QtConcurrent::run([this, &songs, &names, begin, end]() {
+        for (int i = begin; i < end; ++i) {
+          names[i] = GetFilenameForSong(songs[i]);
+        }
+      });
+    }
+    for (QFuture<void>& future : futures) future.waitForFinished();
+  }
+
+  for (int i = 0; i < songs.count(); ++i) {
+    QString new_filename = names[i];
     if (filenames.contains(new_filename)) {
       QString song_number = QString::number(++filenames[new_filename]);
       new_filename = Utilities::PathWithoutFilenameExtension(new_filename) +
@@ -178,97 +309,122 @@ QStringList OrganiseFormat::GetFilenamesForSongs(const SongList& songs) const {
   return new_filenames;
 }
 
-QString OrganiseFormat::ParseBlock(QString block, const Song& song,
-                                   bool* any_empty) const {
-  QRegExp tag_regexp(kTagPattern);
-  QRegExp block_regexp(kBlockPattern);
+QString OrganiseFormat::Evaluate(int begin, int end, const Song& song,
+                                 bool* any_empty) const {
+  QString ret;
+  bool empty = false;
 
-  // Find any blocks first
-  int pos = 0;
-  while ((pos = block_regexp.indexIn(block, pos)) != -1) {
-    // Recursively parse the block
-    bool empty = false;
-    QString value = ParseBlock(block_regexp.cap(1), song, &empty);
-    if (empty) value = "";
-
-    // Replace the block's value
-    block.replace(pos, block_regexp.matchedLength(), value);
-    pos += value.length();
-  }
+  for (int i = begin; i < end; ++i) {
+    const Instruction& instruction = instructions_[i];
+    switch (instruction.type) {
+      case Instruction::Type_Literal:
+        ret.append(instruction.text);
+        break;
 
-  // Now look for tags
-  bool empty = false;
-  pos = 0;
-  while ((pos = tag_regexp.indexIn(block, pos)) != -1) {
-    QString value = TagValue(tag_regexp.cap(1), song);
-    if (value.isEmpty()) empty = true;
+      case Instruction::Type_Tag: {
+        const QString value = TagValue(instruction, song);
+        if (value.isEmpty()) empty = true;
+        ret.append(value);
+        break;
+      }
 
-    block.replace(pos, tag_regexp.matchedLength(), value);
-    pos += value.length();
+      case Instruction::Type_Block: {
+        // A block disappears if any of its tags are empty.
+        bool block_empty = false;
+        const QString value =
+            Evaluate(i + 1, instruction.block_end, song, &block_empty);
+        if (!block_empty) ret.append(value);
+        i = instruction.block_end - 1;
+        break;
+      }
+    }
   }
 
   if (any_empty) *any_empty = empty;
-  return block;
+  return ret;
 }
 
-QString OrganiseFormat::TagValue(const QString& tag, const Song& song) const {
+QString OrganiseFormat::TagValue(const Instruction& tag,
+                                 const Song& song) const {
   QString value;
 
-  if (tag_overrides_.contains(tag))
-    value = tag_overrides_.value(tag);
-  else if (tag == "title")
-    value = song.title();
-  else if (tag == "album")
-    value = song.album();
-  else if (tag == "artist")
-    value = song.artist();
-  else if (tag == "composer")
-    value = song.composer();
-  else if (tag == "performer")
-    value = song.performer();
-  else if (tag == "grouping")
-    value = song.grouping();
-  else if (tag == "lyrics")
-    value = song.lyrics();
-  else if (tag == "genre")
-    value = song.genre();
-  else if (tag == "comment")
-    value = song.comment();
-  else if (tag == "year")
-    value = QString::number(song.year());
-  else if (tag == "originalyear")
-    value = QString::number(song.effective_originalyear());
-  else if (tag == "track")
-    value = QString::number(song.track());
-  else if (tag == "disc")
-    value = QString::number(song.disc());
-  else if (tag == "bpm")
-    value = QString::number(song.bpm());
-  else if (tag == "length")
-    value = QString::number(song.length_nanosec() / kNsecPerSec);
-  else if (tag == "bitrate")
-    value = QString::number(song.bitrate());
-  else if (tag == "samplerate")
-    value = QString::number(song.samplerate());
-  else if (tag == "extension")
-    value = QFileInfo(song.url().toLocalFile()).suffix();
-  else if (tag == "artistinitial") {
-    value = song.effective_albumartist().trimmed();
-    if (replace_the_ && !value.isEmpty())
-      value.replace(QRegExp("^the\\s+", Qt::CaseInsensitive), "");
-    if (!value.isEmpty()) value = value[0].toUpper();
-  } else if (tag == "albumartist") {
-    value = song.is_compilation() ? "Various Artists"
-                                  : song.effective_albumartist();
+  if (!tag_overrides_.isEmpty() && tag_overrides_.contains(tag.text)) {
+    value = tag_overrides_.value(tag.text);
+  } else {
+    switch (tag.tag) {
+      case Tag_Title:
+        value = song.title();
+        break;
+      case Tag_Album:
+        value = song.album();
+        break;
+      case Tag_Artist:
+        value = song.artist();
+        break;
+      case Tag_Composer:
+        value = song.composer();
+        break;
+      case Tag_Performer:
+        value = song.performer();
+        break;
+      case Tag_Grouping:
+        value = song.grouping();
+        break;
+      case Tag_Lyrics:
+        value = song.lyrics();
+        break;
+      case Tag_Genre:
+        value = song.genre();
+        break;
+      case Tag_Comment:
+        value = song.comment();
+        break;
+      case Tag_Year:
+        value = QString::number(song.year());
+        break;
+      case Tag_OriginalYear:
+        value = QString::number(song.effective_originalyear());
+        break;
+      case Tag_Track:
+        value = QString::number(song.track());
+        break;
+      case Tag_Disc:
+        value = QString::number(song.disc());
+        break;
+      case Tag_Bpm:
+        value = QString::number(song.bpm());
+        break;
+      case Tag_Length:
+        value = QString::number(song.length_nanosec() / kNsecPerSec);
+        break;
+      case Tag_Bitrate:
+        value = QString::number(song.bitrate());
+        break;
+      case Tag_Samplerate:
+        value = QString::number(song.samplerate());
+        break;
+      case Tag_Extension:
+        value = QFileInfo(song.url().toLocalFile()).suffix();
+        break;
+      case Tag_ArtistInitial:
+        value = song.effective_albumartist().trimmed();
+        if (replace_the_) StripThe(&value);
+        if (!value.isEmpty()) value = value[0].toUpper();
+        break;
+      case Tag_AlbumArtist:
+        value = song.is_compilation() ? "Various Artists"
+                                      : song.effective_albumartist();
+        break;
+    }
   }
 
-  if (replace_the_ && (tag == "artist" || tag == "albumartist"))
-    value.replace(QRegExp("^the\\s+", Qt::CaseInsensitive), "");
+  if (replace_the_ && (tag.tag == Tag_Artist || tag.tag == Tag_AlbumArtist))
+    StripThe(&value);
 
   if (value == "0" || value == "-1") value = "";
 
   // Prepend a 0 to single-digit track numbers
-  if (tag == "track" && value.length() == 1) value.prepend('0');
+  if (tag.tag == Tag_Track && value.length() == 1) value.prepend('0');
 
   // Replace characters that really shouldn't be in paths
   for (int i = 0; i < kInvalidFatCharactersCount; ++i) {
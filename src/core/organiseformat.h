@@ -24,6 +24,7 @@
 #include <QSyntaxHighlighter>
 #include <QTextEdit>
 #include <QValidator>
+#include <QVector>
 
 #include "core/song.h"
 
@@ -62,6 +63,7 @@ class OrganiseFormat {
   QString GetFilenameForSong(const Song& song,
                              const TranscoderPreset& transcoder_preset,
                              QString prefix_path = "") const;
+  // Big lists are worked out in several threads.
   QStringList GetFilenamesForSongs(const SongList& songs) const;
 
   class Validator : public QValidator {
@@ -86,13 +88,29 @@ class OrganiseFormat {
   };
 
  private:
-  QString ParseBlock(QString block, const Song& song,
-                     bool* any_empty = nullptr) const;
-  QString TagValue(const QString& tag, const Song& song) const;
+  // The format is compiled into a list of these when it's set, so it isn't
+  // parsed again for every song.  A block is followed by its own
+  // instructions, block_end is the index just past them.
+  struct Instruction {
+    enum Type { Type_Literal, Type_Tag, Type_Block };
+
+    Type type;
+    // The literal text, or the tag's name.
+    QString text;
+    // The tag's index in kKnownTags, or -1.
+    int tag;
+    int block_end;
+  };
+
+  void Compile();
+  QString Evaluate(int begin, int end, const Song& song,
+                   bool* any_empty = nullptr) const;
+  QString TagValue(const Instruction& tag, const Song& song) const;
 
   QMap<QString, QString> tag_overrides_;
 
   QString format_;
+  QVector<Instruction> instructions_;
   bool replace_non_ascii_;
   bool replace_spaces_;
   bool replace_the_;
@@ -27,14 +27,21 @@
 
 #include "player.h"
 
+#include <QFile>
 #include <QSettings>
 #include <QSortFilterProxyModel>
 #include <QtConcurrentRun>
 #include <QtDebug>
 #include <memory>
 
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
 #include "config.h"
 #include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/urlhandler.h"
 #include "engines/enginebase.h"
@@ -52,6 +59,47 @@ using std::shared_ptr;
 
 const char* Player::kSettingsGroup = "Player";
 
+namespace {
+
+// Enough to cover the engine until the disk can keep up with it.
+const qint64 kPrefetchBytes = 4 * 1024 * 1024;
+
+// Reads the start of the file, so a disk that has spun down is awake by the
+// time the engine wants it and the first reads come from the page cache.
+// Returns how long it took in usec, or -1 if the file couldn't be read.
+qint64 PrefetchFileStart(const QString& filename) {
+  QElapsedTimer timer;
+  timer.start();
+
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return -1;
+
+#ifdef Q_OS_LINUX
+  // One big read instead of a readahead window at a time.
+  posix_fadvise(file.handle(), 0, kPrefetchBytes, POSIX_FADV_WILLNEED);
+#endif
+
+  // The data's thrown away, reading it just waits until it's cached.
+  QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+  qint64 remaining = kPrefetchBytes;
+  while (remaining > 0) {
+    const qint64 bytes = file.read(buffer.data(), buffer.size());
+    if (bytes <= 0) break;
+    remaining -= bytes;
+  }
+
+  return timer.nsecsElapsed() / 1000;
+}
+
+// Gives the engine the song's Replay Gain from the library, for files that
+// don't have it in their tags.
+void SetReplayGain(const Song& song, MediaPlaybackRequest* req) {
+  req->track_gain_ = song.replaygain_track_gain();
+  req->album_gain_ = song.replaygain_album_gain();
+}
+
+}  // namespace
+
 Player::Player(Application* app, QObject* parent)
     : PlayerInterface(parent),
       app_(app),
@@ -63,7 +111,8 @@ Player::Player(Application* app, QObject* parent)
       volume_before_mute_(50),
       last_pressed_previous_(QDateTime::currentDateTime()),
       menu_previousmode_(PreviousBehaviour_DontRestart),
-      seek_step_sec_(10) {
+      seek_step_sec_(10),
+      prefetch_id_(0) {
   settings_.beginGroup("Player");
 
   SetVolume(settings_.value("volume", 50).toInt());
@@ -83,6 +132,7 @@ void Player::Init() {
 
   connect(engine_.get(), SIGNAL(StateChanged(Engine::State)),
           SLOT(EngineStateChanged(Engine::State)));
+  connect(engine_.get(), SIGNAL(TrackNearingEnd()), SLOT(TrackNearingEnd()));
   connect(engine_.get(), SIGNAL(TrackAboutToEnd()), SLOT(TrackAboutToEnd()));
   connect(engine_.get(), SIGNAL(TrackEnded()), SLOT(TrackEnded()));
   connect(engine_.get(), SIGNAL(MetaData(Engine::SimpleMetaBundle)),
@@ -149,6 +199,7 @@ void Player::HandleLoadResult(const UrlHandler::LoadResult& result) {
       MediaPlaybackRequest req(result.original_url_, result.media_url_);
       if (!result.auth_header_.isEmpty())
         req.headers_["Authorization"] = result.auth_header_;
+      SetReplayGain(item->Metadata(), &req);
       engine_->Play(req, stream_change_type_, item->Metadata().has_cue(),
                     item->Metadata().beginning_nanosec(),
                     item->Metadata().end_nanosec());
@@ -475,6 +526,7 @@ void Player::PlayAt(int index, Engine::TrackChangeFlags change,
 
   current_item_ = app_->playlist_manager()->active()->current_item();
   const QUrl url = current_item_->Url();
+  next_req_ = MediaPlaybackRequest();
 
   if (url_handlers_.contains(url.scheme())) {
     // It's already loading
@@ -485,6 +537,7 @@ void Player::PlayAt(int index, Engine::TrackChangeFlags change,
   } else {
     loading_async_ = QUrl();
     MediaPlaybackRequest req(current_item_->Url());
+    SetReplayGain(current_item_->Metadata(), &req);
     engine_->Play(req, change, current_item_->Metadata().has_cue(),
                   current_item_->Metadata().beginning_nanosec(),
                   current_item_->Metadata().end_nanosec());
@@ -527,6 +580,8 @@ void Player::SeekTo(int seconds) {
   emit Seeked(nanosec / 1000);
 }
 
+void Player::SetScrubbing(bool scrubbing) { engine_->SetScrubbing(scrubbing); }
+
 void Player::SeekForward() {
   SeekTo(engine()->position_nanosec() / kNsecPerSec + seek_step_sec_);
 }
@@ -606,6 +661,90 @@ void Player::TogglePrettyOSD() {
   if (current_item_) emit ForceShowOSD(current_item_->Metadata(), true);
 }
 
+void Player::TrackNearingEnd() {
+  Playlist* playlist = app_->playlist_manager()->active();
+
+  // URL handlers queue up their own next tracks in TrackAboutToEnd.
+  PlaylistItemPtr current = playlist->current_item();
+  if (!current || url_handlers_.contains(current->Url().scheme())) return;
+
+  const int next_row = playlist->next_row();
+  if (next_row == -1) return;
+  PlaylistItemPtr next_item = playlist->item_at(next_row);
+  if (!next_item) return;
+
+  MediaPlaybackRequest req(next_item->Url());
+  if (url_handlers_.contains(req.RequestUrl().scheme())) {
+    // Crossfading starts the next track with PlayAt, which asks the URL
+    // handler itself.
+    if (engine_->is_autocrossfade_enabled()) return;
+    if (!ResolveNextRequest(&req)) return;
+    next_req_ = req;
+  }
+
+  StartPrefetch(req);
+}
+
+bool Player::ResolveNextRequest(MediaPlaybackRequest* req) {
+  UrlHandler* handler =
+      url_handlers_.value(req->RequestUrl().scheme(), nullptr);
+  if (handler == nullptr) return true;
+
+  // It's already loading
+  if (req->RequestUrl() == loading_async_) return false;
+
+  UrlHandler::LoadResult result = handler->LoadNext(req->RequestUrl());
+  switch (result.type_) {
+    case UrlHandler::LoadResult::NoMoreTracks:
+    case UrlHandler::LoadResult::Error:
+      return false;
+
+    case UrlHandler::LoadResult::WillLoadAsynchronously:
+      loading_async_ = req->RequestUrl();
+      return false;
+
+    case UrlHandler::LoadResult::TrackAvailable:
+      req->SetMediaUrl(result.media_url_);
+      break;
+  }
+  return true;
+}
+
+void Player::StartPrefetch(const MediaPlaybackRequest& req) {
+  ++prefetch_id_;
+  prefetch_url_ = req.RequestUrl();
+  prefetch_future_ = QFuture<qint64>();
+  preload_waiting_.invalidate();
+
+  if (!req.MediaUrl().isLocalFile()) return;
+
+  const QString filename = req.MediaUrl().toLocalFile();
+  prefetch_future_ = Executor::Io()->Run<qint64>(
+      [filename]() { return PrefetchFileStart(filename); });
+  NewClosure(prefetch_future_, this, SLOT(NextTrackPrefetched(int)),
+             prefetch_id_);
+}
+
+void Player::NextTrackPrefetched(int id) {
+  // Another track was prefetched since.
+  if (id != prefetch_id_) return;
+
+  const qint64 usec = prefetch_future_.result();
+  if (usec == -1) {
+    preload_waiting_.invalidate();
+    return;
+  }
+  engine_->RecordLatency("Next track prefetch", usec);
+
+  // The preload got there first, so it will have waited on the disk for
+  // about this long.
+  if (preload_waiting_.isValid()) {
+    engine_->RecordLatency("Next track prefetch miss",
+                           preload_waiting_.nsecsElapsed() / 1000);
+    preload_waiting_.invalidate();
+  }
+}
+
 void Player::TrackAboutToEnd() {
   // If the current track was from a URL handler then it might have special
   // behaviour to queue up a subsequent track.  We don't want to preload (and
@@ -652,24 +791,21 @@ void Player::TrackAboutToEnd() {
 
   MediaPlaybackRequest req(next_item->Url());
 
-  // Get the actual track URL rather than the stream URL.
-  UrlHandler* handler = url_handlers_.value(req.RequestUrl().scheme(), nullptr);
-  if (handler != nullptr) {
-    UrlHandler::LoadResult result = handler->LoadNext(req.RequestUrl());
-    switch (result.type_) {
-      case UrlHandler::LoadResult::NoMoreTracks:
-      case UrlHandler::LoadResult::Error:
-        return;
+  // Get the actual track URL rather than the stream URL, unless
+  // TrackNearingEnd already did.
+  if (next_req_.RequestUrl() == req.RequestUrl()) {
+    req = next_req_;
+  } else if (!ResolveNextRequest(&req)) {
+    return;
+  }
+  next_req_ = MediaPlaybackRequest();
+  SetReplayGain(next_item->Metadata(), &req);
 
-      case UrlHandler::LoadResult::WillLoadAsynchronously:
-        loading_async_ = req.RequestUrl();
-        return;
+  // The prefetch missed if it's still reading, or if the next track changed
+  // since it started.
+  if (req.RequestUrl() != prefetch_url_) StartPrefetch(req);
+  if (!prefetch_future_.isFinished()) preload_waiting_.start();
 
-      case UrlHandler::LoadResult::TrackAvailable:
-        req.SetMediaUrl(result.media_url_);
-        break;
-    }
-  }
   engine_->StartPreloading(req, next_item->Metadata().has_cue(),
                            next_item->Metadata().beginning_nanosec(),
                            next_item->Metadata().end_nanosec());
@@ -746,6 +882,10 @@ const UrlHandler* Player::HandlerForUrl(const QUrl& url) const {
   return *it;
 }
 
+UrlHandler* Player::HandlerForUrl(const QUrl& url) {
+  return url_handlers_.value(url.scheme(), nullptr);
+}
+
 void Player::UrlHandlerDestroyed(QObject* object) {
   UrlHandler* handler = static_cast<UrlHandler*>(object);
   const QString scheme = url_handlers_.key(handler);
@@ -28,6 +28,8 @@
 #define CORE_PLAYER_H_
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QObject>
 #include <QSettings>
 #include <memory>
@@ -144,6 +146,7 @@ class Player : public PlayerInterface {
   void UnregisterUrlHandler(UrlHandler* handler);
 
   const UrlHandler* HandlerForUrl(const QUrl& url) const;
+  UrlHandler* HandlerForUrl(const QUrl& url);
 
   bool PreviousWouldRestartTrack() const;
 
@@ -163,6 +166,8 @@ class Player : public PlayerInterface {
   void SeekTo(int seconds);
   void SeekForward();
   void SeekBackward();
+  // Set while the user is dragging the position slider.
+  void SetScrubbing(bool scrubbing);
 
   void CurrentMetadataChanged(const Song& metadata);
 
@@ -178,6 +183,7 @@ class Player : public PlayerInterface {
  private slots:
   void EngineStateChanged(Engine::State);
   void EngineMetadataReceived(const Engine::SimpleMetaBundle& bundle);
+  void TrackNearingEnd();
   void TrackAboutToEnd();
   void TrackEnded();
   // Play the next item on the playlist - disregarding radio stations like
@@ -197,6 +203,7 @@ class Player : public PlayerInterface {
 
   void UrlHandlerDestroyed(QObject* object);
   void HandleLoadResult(const UrlHandler::LoadResult& result);
+  void NextTrackPrefetched(int id);
 
  private:
   // Returns true if we were supposed to stop after this track.
@@ -204,6 +211,12 @@ class Player : public PlayerInterface {
 
   void HandleInvalidItem(const QUrl& url);
 
+  // Asks the URL handler for req's media URL.  Returns false if there won't
+  // be one in time to preload it.
+  bool ResolveNextRequest(MediaPlaybackRequest* req);
+  // Reads the start of req's file in the background, if it's a local one.
+  void StartPrefetch(const MediaPlaybackRequest& req);
+
  private:
   Application* app_;
   Scrobbler* lastfm_;
@@ -220,6 +233,15 @@ class Player : public PlayerInterface {
 
   QUrl loading_async_;
 
+  // The next item, resolved by TrackNearingEnd ready for TrackAboutToEnd.
+  MediaPlaybackRequest next_req_;
+
+  int prefetch_id_;
+  QUrl prefetch_url_;
+  QFuture<qint64> prefetch_future_;
+  // Running while the preload waits for the prefetch to finish.
+  QElapsedTimer preload_waiting_;
+
   int volume_before_mute_;
 
   QDateTime last_pressed_previous_;
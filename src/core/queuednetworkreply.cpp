@@ -0,0 +1,182 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "queuednetworkreply.h"
+
+#include <QTimer>
+
+#include "core/logging.h"
+#include "core/network.h"
+#include "core/networkscheduler.h"
+
+QueuedNetworkReply::QueuedNetworkReply(QNetworkAccessManager* manager,
+                                       QNetworkAccessManager::Operation op,
+                                       const QNetworkRequest& request,
+                                       QIODevice* outgoing_data,
+                                       const QString& host)
+    : QNetworkReply(manager),
+      manager_(manager),
+      outgoing_data_(outgoing_data),
+      host_(host),
+      scheduled_(true),
+      ignore_ssl_errors_(false),
+      inner_(nullptr) {
+  setOperation(op);
+  setRequest(request);
+  setUrl(request.url());
+  open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+QueuedNetworkReply::~QueuedNetworkReply() {
+  if (scheduled_) NetworkScheduler::Instance()->Cancel(host_, this);
+}
+
+void QueuedNetworkReply::StartAfter(int msec) {
+  if (!scheduled_) return;
+
+  if (msec > 0) {
+    QTimer::singleShot(msec, this, SLOT(Start()));
+  } else {
+    Start();
+  }
+}
+
+void QueuedNetworkReply::Start() {
+  if (!scheduled_) return;
+  scheduled_ = false;
+
+  // The manager lets this one straight through, and it gives the place back
+  // when it's finished.
+  QNetworkRequest req(request());
+  req.setAttribute(NetworkAccessManager::kScheduledAttribute, true);
+
+  switch (operation()) {
+    case QNetworkAccessManager::HeadOperation:
+      inner_ = manager_->head(req);
+      break;
+    case QNetworkAccessManager::PostOperation:
+      inner_ = manager_->post(req, outgoing_data_);
+      break;
+    case QNetworkAccessManager::PutOperation:
+      inner_ = manager_->put(req, outgoing_data_);
+      break;
+    case QNetworkAccessManager::DeleteOperation:
+      inner_ = manager_->deleteResource(req);
+      break;
+    case QNetworkAccessManager::CustomOperation: {
+      const QByteArray verb =
+          req.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+      inner_ = manager_->sendCustomRequest(req, verb, outgoing_data_);
+      break;
+    }
+    default:
+      inner_ = manager_->get(req);
+      break;
+  }
+
+  inner_->setParent(this);
+  if (readBufferSize() > 0) inner_->setReadBufferSize(readBufferSize());
+  if (ignore_ssl_errors_) inner_->ignoreSslErrors();
+
+  connect(inner_, SIGNAL(metaDataChanged()), SLOT(InnerMetaDataChanged()));
+  connect(inner_, SIGNAL(readyRead()), SIGNAL(readyRead()));
+  connect(inner_, SIGNAL(downloadProgress(qint64, qint64)),
+          SIGNAL(downloadProgress(qint64, qint64)));
+  connect(inner_, SIGNAL(uploadProgress(qint64, qint64)),
+          SIGNAL(uploadProgress(qint64, qint64)));
+  connect(inner_, SIGNAL(sslErrors(QList<QSslError>)),
+          SIGNAL(sslErrors(QList<QSslError>)));
+  connect(inner_, SIGNAL(error(QNetworkReply::NetworkError)),
+          SLOT(InnerError(QNetworkReply::NetworkError)));
+  connect(inner_, SIGNAL(finished()), SLOT(InnerFinished()));
+
+  emit Started();
+}
+
+void QueuedNetworkReply::CopyMetaData() {
+  setUrl(inner_->url());
+
+  for (const RawHeaderPair& header : inner_->rawHeaderPairs()) {
+    setRawHeader(header.first, header.second);
+  }
+
+  static const QNetworkRequest::Attribute kAttributes[] = {
+      QNetworkRequest::HttpStatusCodeAttribute,
+      QNetworkRequest::HttpReasonPhraseAttribute,
+      QNetworkRequest::RedirectionTargetAttribute,
+      QNetworkRequest::ConnectionEncryptedAttribute,
+      QNetworkRequest::SourceIsFromCacheAttribute,
+      QNetworkRequest::HttpPipeliningWasUsedAttribute};
+  for (QNetworkRequest::Attribute attribute : kAttributes) {
+    setAttribute(attribute, inner_->attribute(attribute));
+  }
+}
+
+void QueuedNetworkReply::InnerMetaDataChanged() {
+  CopyMetaData();
+  emit metaDataChanged();
+}
+
+void QueuedNetworkReply::InnerError(QNetworkReply::NetworkError code) {
+  setError(code, inner_->errorString());
+  emit error(code);
+}
+
+void QueuedNetworkReply::InnerFinished() {
+  CopyMetaData();
+  setFinished(true);
+  emit finished();
+}
+
+void QueuedNetworkReply::abort() {
+  if (inner_) {
+    inner_->abort();
+    return;
+  }
+  if (isFinished()) return;
+
+  if (scheduled_) {
+    scheduled_ = false;
+    NetworkScheduler::Instance()->Cancel(host_, this);
+  }
+
+  setError(OperationCanceledError, tr("Operation canceled"));
+  setFinished(true);
+  emit error(OperationCanceledError);
+  emit finished();
+}
+
+qint64 QueuedNetworkReply::bytesAvailable() const {
+  const qint64 inner_bytes = inner_ ? inner_->bytesAvailable() : 0;
+  return QNetworkReply::bytesAvailable() + inner_bytes;
+}
+
+qint64 QueuedNetworkReply::readData(char* data, qint64 max_size) {
+  if (!inner_) return 0;
+  if (isFinished() && inner_->bytesAvailable() == 0) return -1;
+  return inner_->read(data, max_size);
+}
+
+void QueuedNetworkReply::setReadBufferSize(qint64 size) {
+  QNetworkReply::setReadBufferSize(size);
+  if (inner_) inner_->setReadBufferSize(size);
+}
+
+void QueuedNetworkReply::ignoreSslErrors() {
+  ignore_ssl_errors_ = true;
+  if (inner_) inner_->ignoreSslErrors();
+}
@@ -0,0 +1,81 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_QUEUEDNETWORKREPLY_H_
+#define CORE_QUEUEDNETWORKREPLY_H_
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSslError>
+
+// What NetworkAccessManager returns for a request that the scheduler has made
+// wait.  When it's its turn it makes the real request through the same manager
+// and passes everything from that reply on, so callers can treat it as the
+// reply itself.
+class QueuedNetworkReply : public QNetworkReply {
+  Q_OBJECT
+
+ public:
+  QueuedNetworkReply(QNetworkAccessManager* manager,
+                     QNetworkAccessManager::Operation op,
+                     const QNetworkRequest& request, QIODevice* outgoing_data,
+                     const QString& host);
+  ~QueuedNetworkReply();
+
+  // True once the real request has been made.
+  bool started() const { return inner_ != nullptr; }
+
+  // QNetworkReply
+  void abort();
+  qint64 bytesAvailable() const;
+  bool isSequential() const { return true; }
+  void setReadBufferSize(qint64 size);
+
+ public slots:
+  void ignoreSslErrors();
+
+  // Called by NetworkScheduler.
+  void StartAfter(int msec);
+
+ signals:
+  void Started();
+
+ protected:
+  qint64 readData(char* data, qint64 max_size);
+
+ private slots:
+  void Start();
+  void InnerMetaDataChanged();
+  void InnerError(QNetworkReply::NetworkError code);
+  void InnerFinished();
+
+ private:
+  void CopyMetaData();
+
+  QNetworkAccessManager* manager_;
+  QIODevice* outgoing_data_;
+  QString host_;
+
+  // Set while we have a place in the scheduler that the real request hasn't
+  // taken over yet.
+  bool scheduled_;
+  bool ignore_ssl_errors_;
+
+  QNetworkReply* inner_;
+};
+
+#endif  // CORE_QUEUEDNETWORKREPLY_H_
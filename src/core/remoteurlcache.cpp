@@ -0,0 +1,69 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "remoteurlcache.h"
+
+#include <QDateTime>
+
+// Stations move their streams around now and again, so the playlists are
+// fetched again after a while.
+const int RemoteUrlCache::kDefaultMaxAgeSecs = 60 * 60;
+const int RemoteUrlCache::kMaxEntries = 500;
+
+RemoteUrlCache::RemoteUrlCache(int max_age_secs)
+    : max_age_msec_(qint64(max_age_secs) * 1000) {}
+
+SongList RemoteUrlCache::Lookup(const QUrl& url) const {
+  QMutexLocker l(&mutex_);
+
+  auto it = entries_.constFind(url);
+  if (it == entries_.constEnd()) return SongList();
+  if (QDateTime::currentMSecsSinceEpoch() - it->stored_msec_ >= max_age_msec_) {
+    return SongList();
+  }
+  return it->songs_;
+}
+
+void RemoteUrlCache::Store(const QUrl& url, const SongList& songs) {
+  if (songs.isEmpty()) return;
+
+  QMutexLocker l(&mutex_);
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  if (!entries_.contains(url) && entries_.count() >= kMaxEntries) {
+    // Make room by dropping the oldest entry.
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->stored_msec_ < oldest->stored_msec_) oldest = it;
+    }
+    entries_.erase(oldest);
+  }
+
+  Entry& entry = entries_[url];
+  entry.songs_ = songs;
+  entry.stored_msec_ = now;
+}
+
+void RemoteUrlCache::Clear() {
+  QMutexLocker l(&mutex_);
+  entries_.clear();
+}
+
+int RemoteUrlCache::count() const {
+  QMutexLocker l(&mutex_);
+  return entries_.count();
+}
@@ -0,0 +1,56 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_REMOTEURLCACHE_H_
+#define CORE_REMOTEURLCACHE_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QUrl>
+
+#include "song.h"
+
+// Remembers what remote URLs turned out to be - a playlist and the songs in
+// it, or an audio stream - so adding the same radio station or podcast again
+// doesn't have to fetch it to find out.  Safe to use from any thread.
+class RemoteUrlCache {
+ public:
+  static const int kDefaultMaxAgeSecs;
+  static const int kMaxEntries;
+
+  explicit RemoteUrlCache(int max_age_secs = kDefaultMaxAgeSecs);
+
+  // Returns an empty list if url hasn't been loaded recently.
+  SongList Lookup(const QUrl& url) const;
+  void Store(const QUrl& url, const SongList& songs);
+  void Clear();
+
+  int count() const;
+
+ private:
+  struct Entry {
+    SongList songs_;
+    qint64 stored_msec_;
+  };
+
+  const qint64 max_age_msec_;
+
+  mutable QMutex mutex_;
+  QHash<QUrl, Entry> entries_;
+};
+
+#endif  // CORE_REMOTEURLCACHE_H_
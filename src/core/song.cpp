@@ -40,6 +40,8 @@
 #include <QVariant>
 #include <QtConcurrentRun>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 #ifdef HAVE_LIBLASTFM
 #include "internet/lastfm/fixlastfm.h"
@@ -65,11 +67,13 @@
 #include "core/logging.h"
 #include "core/messagehandler.h"
 #include "core/mpris_common.h"
+#include "core/stringpool.h"
 #include "core/timeconstants.h"
 #include "core/utilities.h"
 #include "covers/albumcoverloader.h"
 #include "engines/enginebase.h"
 #include "gmereader.h"
+#include "library/libraryquery.h"
 #include "library/sqlrow.h"
 #include "tagreadermessages.pb.h"
 #include "widgets/trackslider.h"
@@ -115,7 +119,12 @@ const QStringList Song::kColumns = QStringList() << "title"
                                                  << "grouping"
                                                  << "lyrics"
                                                  << "originalyear"
-                                                 << "effective_originalyear";
+                                                 << "effective_originalyear"
+                                                 << "file_identity"
+                                                 << "replaygain_track_gain"
+                                                 << "replaygain_track_peak"
+                                                 << "replaygain_album_gain"
+                                                 << "replaygain_album_peak";
 
 const QStringList Song::kIntColumns = QStringList() << "track"
                                                     << "disc"
@@ -160,6 +169,15 @@ const QString Song::kFtsUpdateSpec =
 const QString Song::kManuallyUnsetCover = "(unset)";
 const QString Song::kEmbeddedCover = "(embedded)";
 
+namespace {
+
+// Whole albums and artists' worth of songs are loaded at once, so the fields
+// that repeat are shared between them rather than copied for each song.  The
+// loaders below and Song::InternStrings all use this one pool.
+StringPool sSharedStrings;
+
+}  // namespace
+
 struct Song::Private : public QSharedData {
   Private();
 
@@ -243,6 +261,16 @@ struct Song::Private : public QSharedData {
   bool unavailable_;
 
   QString etag_;
+
+  // Identifies the file independently of its path.  See
+  // Utilities::FileIdentity.
+  QString file_identity_;
+
+  // NaN when unknown.
+  float replaygain_track_gain_;
+  float replaygain_track_peak_;
+  float replaygain_album_gain_;
+  float replaygain_album_peak_;
 };
 
 Song::Private::Private()
@@ -274,7 +302,11 @@ Song::Private::Private()
       filetype_(Type_Unknown),
       init_from_file_(false),
       suspicious_tags_(false),
-      unavailable_(false) {}
+      unavailable_(false),
+      replaygain_track_gain_(std::numeric_limits<float>::quiet_NaN()),
+      replaygain_track_peak_(std::numeric_limits<float>::quiet_NaN()),
+      replaygain_album_gain_(std::numeric_limits<float>::quiet_NaN()),
+      replaygain_album_peak_(std::numeric_limits<float>::quiet_NaN()) {}
 
 Song::Song() : d(new Private) {}
 
@@ -350,6 +382,14 @@ bool Song::is_library_song() const {
 const QString& Song::art_automatic() const { return d->art_automatic_; }
 const QString& Song::art_manual() const { return d->art_manual_; }
 const QString& Song::etag() const { return d->etag_; }
+const QString& Song::file_identity() const { return d->file_identity_; }
+float Song::replaygain_track_gain() const { return d->replaygain_track_gain_; }
+float Song::replaygain_track_peak() const { return d->replaygain_track_peak_; }
+float Song::replaygain_album_gain() const { return d->replaygain_album_gain_; }
+float Song::replaygain_album_peak() const { return d->replaygain_album_peak_; }
+bool Song::has_replaygain() const {
+  return !std::isnan(d->replaygain_track_gain_);
+}
 bool Song::has_manually_unset_cover() const {
   return d->art_manual_ == kManuallyUnsetCover;
 }
@@ -403,6 +443,14 @@ void Song::set_score(int v) { d->score_ = qBound(0, v, 100); }
 void Song::set_cue_path(const QString& v) { d->cue_path_ = v; }
 void Song::set_unavailable(bool v) { d->unavailable_ = v; }
 void Song::set_etag(const QString& etag) { d->etag_ = etag; }
+void Song::set_file_identity(const QString& v) { d->file_identity_ = v; }
+void Song::set_replaygain(float track_gain, float track_peak, float album_gain,
+                          float album_peak) {
+  d->replaygain_track_gain_ = track_gain;
+  d->replaygain_track_peak_ = track_peak;
+  d->replaygain_album_gain_ = album_gain;
+  d->replaygain_album_peak_ = album_peak;
+}
 
 void Song::set_url(const QUrl& v) {
   if (Application::kIsPortable && v.isRelative()) {
@@ -564,6 +612,10 @@ void Song::InitFromProtobuf(const cpb::tagreader::SongMetadata& pb) {
     d->art_automatic_ = QStringFromStdString(pb.art_automatic());
   }
 
+  sSharedStrings.Intern({&d->album_, &d->artist_, &d->albumartist_,
+                         &d->composer_, &d->performer_, &d->grouping_,
+                         &d->genre_, &d->art_automatic_});
+
   if (pb.has_rating()) {
     d->rating_ = pb.rating();
   }
@@ -572,6 +624,13 @@ void Song::InitFromProtobuf(const cpb::tagreader::SongMetadata& pb) {
     d->playcount_ = pb.playcount();
   }
 
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  set_replaygain(
+      pb.has_replaygain_track_gain() ? pb.replaygain_track_gain() : nan,
+      pb.has_replaygain_track_peak() ? pb.replaygain_track_peak() : nan,
+      pb.has_replaygain_album_gain() ? pb.replaygain_album_gain() : nan,
+      pb.has_replaygain_album_peak() ? pb.replaygain_album_peak() : nan);
+
   InitArtManual();
 }
 
@@ -611,41 +670,78 @@ void Song::ToProtobuf(cpb::tagreader::SongMetadata* pb) const {
   pb->set_suspicious_tags(d->suspicious_tags_);
   pb->set_art_automatic(DataCommaSizeFromQString(d->art_automatic_));
   pb->set_type(static_cast<cpb::tagreader::SongMetadata_Type>(d->filetype_));
+
+  // Left unset when unknown, so the tag reader can tell.
+  if (!std::isnan(d->replaygain_track_gain_))
+    pb->set_replaygain_track_gain(d->replaygain_track_gain_);
+  if (!std::isnan(d->replaygain_track_peak_))
+    pb->set_replaygain_track_peak(d->replaygain_track_peak_);
+  if (!std::isnan(d->replaygain_album_gain_))
+    pb->set_replaygain_album_gain(d->replaygain_album_gain_);
+  if (!std::isnan(d->replaygain_album_peak_))
+    pb->set_replaygain_album_peak(d->replaygain_album_peak_);
 }
 
-void Song::InitFromQuery(const SqlRow& q, bool reliable_metadata, int col) {
+namespace {
+
+// Each value is only looked up once: QSqlQuery::value makes a new QVariant
+// every time.
+QString ToString(const QVariant& v) {
+  return v.isNull() ? QString() : v.toString();
+}
+int ToInt(const QVariant& v, int null_value = -1) {
+  return v.isNull() ? null_value : v.toInt();
+}
+qint64 ToLongLong(const QVariant& v, qint64 null_value = -1) {
+  return v.isNull() ? null_value : v.toLongLong();
+}
+float ToFloat(const QVariant& v) { return v.isNull() ? -1 : v.toDouble(); }
+float ToGain(const QVariant& v) {
+  return v.isNull() ? std::numeric_limits<float>::quiet_NaN() : v.toDouble();
+}
+
+// NaN means unknown, and two unknowns are the same.
+bool SameGain(float a, float b) {
+  return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+QVariant GainValue(float v) { return std::isnan(v) ? QVariant() : QVariant(v); }
+
+}  // namespace
+
+template <typename Row>
+void Song::InitFromRow(const Row& q, bool reliable_metadata, int col) {
   d->valid_ = true;
   d->init_from_file_ = reliable_metadata;
 
-#define tostr(n) (q.value(n).isNull() ? QString() : q.value(n).toString())
-#define toint(n) (q.value(n).isNull() ? -1 : q.value(n).toInt())
-#define tolonglong(n) (q.value(n).isNull() ? -1 : q.value(n).toLongLong())
-#define tofloat(n) (q.value(n).isNull() ? -1 : q.value(n).toDouble())
-
-  d->id_ = toint(col + 0);
-  d->title_ = tostr(col + 1);
-  d->album_ = tostr(col + 2);
-  d->artist_ = tostr(col + 3);
-  d->albumartist_ = tostr(col + 4);
-  d->composer_ = tostr(col + 5);
-  d->track_ = toint(col + 6);
-  d->disc_ = toint(col + 7);
-  d->bpm_ = tofloat(col + 8);
-  d->year_ = toint(col + 9);
-  d->originalyear_ = toint(col + 41);
-  d->genre_ = tostr(col + 10);
-  d->comment_ = tostr(col + 11);
+  d->id_ = ToInt(q.value(col + 0));
+  d->title_ = ToString(q.value(col + 1));
+  d->album_ = ToString(q.value(col + 2));
+  d->artist_ = ToString(q.value(col + 3));
+  d->albumartist_ = ToString(q.value(col + 4));
+  d->composer_ = ToString(q.value(col + 5));
+  d->track_ = ToInt(q.value(col + 6));
+  d->disc_ = ToInt(q.value(col + 7));
+  d->bpm_ = ToFloat(q.value(col + 8));
+  d->year_ = ToInt(q.value(col + 9));
+  d->originalyear_ = ToInt(q.value(col + 41));
+  d->genre_ = ToString(q.value(col + 10));
+  d->comment_ = ToString(q.value(col + 11));
   d->compilation_ = q.value(col + 12).toBool();
 
-  d->bitrate_ = toint(col + 13);
-  d->samplerate_ = toint(col + 14);
-
-  d->directory_id_ = toint(col + 15);
-  set_url(QUrl::fromEncoded(tostr(col + 16).toUtf8()));
-  d->basefilename_ = QFileInfo(d->url_.toLocalFile()).fileName();
-  d->mtime_ = toint(col + 17);
-  d->ctime_ = toint(col + 18);
-  d->filesize_ = toint(col + 19);
+  d->bitrate_ = ToInt(q.value(col + 13));
+  d->samplerate_ = ToInt(q.value(col + 14));
+
+  d->directory_id_ = ToInt(q.value(col + 15));
+  // The filename is stored as the encoded URL, there's no need to go through
+  // a QString to get it back.
+  set_url(QUrl::fromEncoded(q.value(col + 16).toByteArray()));
+  // QFileInfo would do the same, but it's a lot heavier.
+  d->basefilename_ = d->url_.isLocalFile()
+                         ? d->url_.fileName(QUrl::FullyDecoded)
+                         : QString();
+  d->mtime_ = ToInt(q.value(col + 17));
+  d->ctime_ = ToInt(q.value(col + 18));
+  d->filesize_ = ToInt(q.value(col + 19));
 
   d->sampler_ = q.value(col + 20).toBool();
 
@@ -653,40 +749,62 @@ void Song::InitFromQuery(const SqlRow& q, bool reliable_metadata, int col) {
   d->art_manual_ = q.value(col + 22).toString();
 
   d->filetype_ = FileType(q.value(col + 23).toInt());
-  d->playcount_ = q.value(col + 24).isNull() ? 0 : q.value(col + 24).toInt();
-  d->lastplayed_ = toint(col + 25);
-  d->rating_ = tofloat(col + 26);
+  d->playcount_ = ToInt(q.value(col + 24), 0);
+  d->lastplayed_ = ToInt(q.value(col + 25));
+  d->rating_ = ToFloat(q.value(col + 26));
 
   d->forced_compilation_on_ = q.value(col + 27).toBool();
   d->forced_compilation_off_ = q.value(col + 28).toBool();
 
   // effective_compilation = 29
 
-  d->skipcount_ = q.value(col + 30).isNull() ? 0 : q.value(col + 30).toInt();
-  d->score_ = q.value(col + 31).isNull() ? 0 : q.value(col + 31).toInt();
+  d->skipcount_ = ToInt(q.value(col + 30), 0);
+  d->score_ = ToInt(q.value(col + 31), 0);
 
   // do not move those statements - beginning must be initialized before
   // length is!
-  d->beginning_ =
-      q.value(col + 32).isNull() ? 0 : q.value(col + 32).toLongLong();
-  set_length_nanosec(tolonglong(col + 33));
+  d->beginning_ = ToLongLong(q.value(col + 32), 0);
+  set_length_nanosec(ToLongLong(q.value(col + 33)));
 
-  d->cue_path_ = tostr(col + 34);
+  d->cue_path_ = ToString(q.value(col + 34));
   d->unavailable_ = q.value(col + 35).toBool();
 
   // effective_albumartist = 36
   // etag = 37
 
-  d->performer_ = tostr(col + 38);
-  d->grouping_ = tostr(col + 39);
-  d->lyrics_ = tostr(col + 40);
+  d->performer_ = ToString(q.value(col + 38));
+  d->grouping_ = ToString(q.value(col + 39));
+  d->lyrics_ = ToString(q.value(col + 40));
+
+  // effective_originalyear = 42
+
+  d->file_identity_ = ToString(q.value(col + 43));
+
+  d->replaygain_track_gain_ = ToGain(q.value(col + 44));
+  d->replaygain_track_peak_ = ToGain(q.value(col + 45));
+  d->replaygain_album_gain_ = ToGain(q.value(col + 46));
+  d->replaygain_album_peak_ = ToGain(q.value(col + 47));
+
+  sSharedStrings.Intern({&d->album_, &d->artist_, &d->albumartist_,
+                         &d->composer_, &d->performer_, &d->grouping_,
+                         &d->genre_, &d->cue_path_, &d->art_automatic_,
+                         &d->art_manual_});
 
   InitArtManual();
+}
+
+void Song::InitFromQuery(const SqlRow& q, bool reliable_metadata, int col) {
+  InitFromRow(q, reliable_metadata, col);
+}
+
+void Song::InitFromQuery(const QSqlQuery& q, bool reliable_metadata,
+                         int col) {
+  InitFromRow(q, reliable_metadata, col);
+}
 
-#undef tostr
-#undef toint
-#undef tolonglong
-#undef tofloat
+void Song::InitFromQuery(const LibraryQuery& q, bool reliable_metadata,
+                         int col) {
+  InitFromRow(static_cast<const QSqlQuery&>(q), reliable_metadata, col);
 }
 
 void Song::InitFromFilePartial(const QString& filename) {
@@ -1007,6 +1125,17 @@ void Song::BindToQuery(QSqlQuery* query) const {
   query->bindValue(":effective_originalyear",
                    intval(this->effective_originalyear()));
 
+  query->bindValue(":file_identity", strval(d->file_identity_));
+
+  query->bindValue(":replaygain_track_gain",
+                   GainValue(d->replaygain_track_gain_));
+  query->bindValue(":replaygain_track_peak",
+                   GainValue(d->replaygain_track_peak_));
+  query->bindValue(":replaygain_album_gain",
+                   GainValue(d->replaygain_album_gain_));
+  query->bindValue(":replaygain_album_peak",
+                   GainValue(d->replaygain_album_peak_));
+
 #undef intval
 #undef notnullintval
 #undef strval
@@ -1099,6 +1228,49 @@ QString Song::TitleWithCompilationArtist() const {
   return title;
 }
 
+namespace {
+
+void AddStringMemoryUsage(const QString& s, QSet<const void*>* seen,
+                          qint64* bytes) {
+  if (s.capacity() == 0 || seen->contains(s.constData())) return;
+  seen->insert(s.constData());
+  *bytes += sizeof(QArrayData) + (s.capacity() + 1) * sizeof(QChar);
+}
+
+}  // namespace
+
+void Song::InternStrings() {
+  sSharedStrings.Intern({&d->title_, &d->album_, &d->artist_,
+                         &d->albumartist_, &d->composer_, &d->performer_,
+                         &d->grouping_, &d->genre_, &d->comment_,
+                         &d->cue_path_, &d->art_automatic_, &d->art_manual_});
+}
+
+void Song::AddMemoryUsage(QSet<const void*>* seen, qint64* bytes) const {
+  if (seen->contains(d.constData())) return;
+  seen->insert(d.constData());
+  *bytes += sizeof(Private);
+
+  for (const QString* s :
+       {&d->title_, &d->album_, &d->artist_, &d->albumartist_, &d->composer_,
+        &d->performer_, &d->grouping_, &d->lyrics_, &d->genre_, &d->comment_,
+        &d->basefilename_, &d->cue_path_, &d->art_automatic_, &d->art_manual_,
+        &d->etag_, &d->file_identity_}) {
+    AddStringMemoryUsage(*s, seen, bytes);
+  }
+
+  // QUrl keeps its parts in separate strings, which aren't reachable from
+  // here, so count roughly what its encoded form would take.
+  if (!d->url_.isEmpty()) {
+    *bytes += d->url_.toEncoded().size() * sizeof(QChar);
+  }
+
+  if (!d->image_.isNull() && !seen->contains(d->image_.constBits())) {
+    seen->insert(d->image_.constBits());
+    *bytes += qint64(d->image_.bytesPerLine()) * d->image_.height();
+  }
+}
+
 bool Song::IsMetadataEqual(const Song& other) const {
   return d->title_ == other.d->title_ && d->album_ == other.d->album_ &&
          d->artist_ == other.d->artist_ &&
@@ -1121,6 +1293,29 @@ bool Song::IsMetadataEqual(const Song& other) const {
          d->lyrics_ == other.d->lyrics_;
 }
 
+bool Song::IsRowDataEqual(const Song& other) const {
+  return IsMetadataEqual(other) && d->directory_id_ == other.d->directory_id_ &&
+         d->url_ == other.d->url_ && d->mtime_ == other.d->mtime_ &&
+         d->ctime_ == other.d->ctime_ && d->filesize_ == other.d->filesize_ &&
+         d->sampler_ == other.d->sampler_ &&
+         d->filetype_ == other.d->filetype_ &&
+         d->playcount_ == other.d->playcount_ &&
+         d->skipcount_ == other.d->skipcount_ &&
+         d->lastplayed_ == other.d->lastplayed_ &&
+         d->score_ == other.d->score_ &&
+         d->forced_compilation_on_ == other.d->forced_compilation_on_ &&
+         d->forced_compilation_off_ == other.d->forced_compilation_off_ &&
+         d->unavailable_ == other.d->unavailable_ &&
+         d->file_identity_ == other.d->file_identity_ &&
+         SameGain(d->replaygain_track_gain_,
+                  other.d->replaygain_track_gain_) &&
+         SameGain(d->replaygain_track_peak_,
+                  other.d->replaygain_track_peak_) &&
+         SameGain(d->replaygain_album_gain_,
+                  other.d->replaygain_album_gain_) &&
+         SameGain(d->replaygain_album_peak_, other.d->replaygain_album_peak_);
+}
+
 bool Song::IsEditable() const {
   return d->valid_ && !d->url_.isEmpty() && !is_stream() &&
          d->filetype_ != Type_Unknown && !has_cue();
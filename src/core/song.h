@@ -31,6 +31,7 @@
 
 #include <QImage>
 #include <QMetaType>
+#include <QSet>
 #include <QSharedDataPointer>
 #include <QVariantMap>
 
@@ -60,6 +61,8 @@ class Track;
 }
 #endif
 
+class LibraryQuery;
+class QSqlQuery;
 class SqlRow;
 
 class Song {
@@ -124,7 +127,13 @@ class Song {
   void Init(const QString& title, const QString& artist, const QString& album,
             qint64 beginning, qint64 end);
   void InitFromProtobuf(const cpb::tagreader::SongMetadata& pb);
+  // The columns from col on are the ROWID followed by kColumnSpec.  Reading
+  // straight from a query saves copying the whole row into a SqlRow first.
   void InitFromQuery(const SqlRow& query, bool reliable_metadata, int col = 0);
+  void InitFromQuery(const QSqlQuery& query, bool reliable_metadata,
+                     int col = 0);
+  void InitFromQuery(const LibraryQuery& query, bool reliable_metadata,
+                     int col = 0);
   void InitFromFilePartial(
       const QString& filename);  // Just store the filename: incomplete but fast
   void InitArtManual();  // Check if there is already a art in the cache and
@@ -223,6 +232,15 @@ class Song {
   const QString& art_manual() const;
 
   const QString& etag() const;
+  const QString& file_identity() const;
+
+  // ReplayGain 2.0 values in dB and as a linear peak, from the file's tags or
+  // from ReplayGainScanner.  NaN if they aren't known.
+  float replaygain_track_gain() const;
+  float replaygain_track_peak() const;
+  float replaygain_album_gain() const;
+  float replaygain_album_peak() const;
+  bool has_replaygain() const;
 
   // Returns true if this Song had it's cover manually unset by user.
   bool has_manually_unset_cover() const;
@@ -294,6 +312,9 @@ class Song {
   void set_cue_path(const QString& v);
   void set_unavailable(bool v);
   void set_etag(const QString& etag);
+  void set_file_identity(const QString& v);
+  void set_replaygain(float track_gain, float track_peak, float album_gain,
+                      float album_peak);
 
   // Setters that should only be used by tests
   void set_url(const QUrl& v);
@@ -302,6 +323,9 @@ class Song {
 
   // Comparison functions
   bool IsMetadataEqual(const Song& other) const;
+  // Like IsMetadataEqual, but also compares everything else that is stored in
+  // the library's songs table.
+  bool IsRowDataEqual(const Song& other) const;
   bool IsOnSameAlbum(const Song& other) const;
   bool IsSimilar(const Song& other) const;
 
@@ -312,9 +336,22 @@ class Song {
   // you need to hash the key to do fast lookups.
   QString AlbumKey() const;
 
+  // Makes this song's tag strings share their data with equal strings in the
+  // pool songs are loaded through, adding the ones that aren't there yet.
+  // Songs on the same album or by the same artist then hold one copy of those
+  // strings between them.  Songs loaded from the library or the tag reader
+  // already share their most repeated fields.
+  void InternStrings();
+  // Adds a rough estimate of the heap memory this song holds to bytes.  Data
+  // whose address is in seen has already been counted and is skipped.
+  void AddMemoryUsage(QSet<const void*>* seen, qint64* bytes) const;
+
   Song& operator=(const Song& other);
 
  private:
+  template <typename Row>
+  void InitFromRow(const Row& row, bool reliable_metadata, int col);
+
   struct Private;
   QSharedDataPointer<Private> d;
 };
@@ -61,6 +61,7 @@
 using std::placeholders::_1;
 
 QSet<QString> SongLoader::sRawUriSchemes;
+RemoteUrlCache SongLoader::sRemoteCache;
 const int SongLoader::kDefaultTimeout = 5000;
 
 SongLoader::SongLoader(LibraryBackendInterface* library, const Player* player,
@@ -105,6 +106,7 @@ SongLoader::~SongLoader() {
 }
 
 SongLoader::Result SongLoader::Load(const QUrl& url) {
+  requested_url_ = url;
   url_ = url;
 
   if (url_.scheme() == "file") {
@@ -119,8 +121,27 @@ SongLoader::Result SongLoader::Load(const QUrl& url) {
     return Success;
   }
 
+  // We've seen this one recently, so we already know what's there.
+  const SongList cached = sRemoteCache.Lookup(url_);
+  if (!cached.isEmpty()) {
+    qLog(Debug) << "Using cached songs for" << url_;
+    songs_ = cached;
+    return Success;
+  }
+
   // It could be a playlist, we give it a shot.
   if (LoadRemotePlaylist(url_)) {
+    CacheRemoteSongs();
+    return Success;
+  }
+
+  // The server already told us it's audio, so there's no need to start a
+  // typefind pipeline to find out.  audio/x-mpegurl and friends are
+  // playlists despite their names, so those still get sniffed.
+  if (mime_type_.startsWith("audio/") && !mime_type_.contains("mpegurl") &&
+      !mime_type_.contains("scpls") && !mime_type_.contains("asx")) {
+    AddAsRawStream();
+    CacheRemoteSongs();
     return Success;
   }
 
@@ -130,6 +151,12 @@ SongLoader::Result SongLoader::Load(const QUrl& url) {
   return BlockingLoadRequired;
 }
 
+bool SongLoader::IsPlaylist(const QUrl& url) const {
+  if (!url.isLocalFile()) return false;
+  return playlist_parser_->ParserForExtension(
+             QFileInfo(url.toLocalFile()).suffix().toLower()) != nullptr;
+}
+
 SongLoader::Result SongLoader::LoadFilenamesBlocking() {
   if (preload_func_) {
     return preload_func_();
@@ -147,15 +174,35 @@ SongLoader::Result SongLoader::LoadLocalPartial(const QString& filename) {
     LoadLocalDirectory(filename);
     return Success;
   }
-  Song song;
-  song.InitFromFilePartial(filename);
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return Success;
+
+  Song song = PartialSong(filename, file.read(PlaylistParser::kSniffSize));
   if (song.is_valid()) songs_ << song;
   return Success;
 }
 
+Song SongLoader::PartialSong(const QString& filename,
+                             const QByteArray& header) {
+  Song song;
+  if (PlaylistParser::LooksLikeAudio(header)) {
+    // The tags get read later anyway, so don't make TagLib open the file just
+    // to tell us it's audio.
+    song.set_url(QUrl::fromLocalFile(filename));
+    song.set_basefilename(QFileInfo(filename).fileName());
+    song.set_valid(true);
+  } else {
+    song.InitFromFilePartial(filename);
+  }
+  return song;
+}
+
 SongLoader::Result SongLoader::LoadAudioCD() {
 #ifdef HAVE_AUDIOCD
   CddaSongLoader* cdda_song_loader = new CddaSongLoader;
+  if (LibraryBackend* backend = qobject_cast<LibraryBackend*>(library_)) {
+    cdda_song_loader->set_database(backend->db());
+  }
   connect(cdda_song_loader, &CddaSongLoader::SongsUpdated, this,
           &SongLoader::AudioCDTracksLoadedSlot);
   connect(cdda_song_loader, &CddaSongLoader::Finished,
@@ -224,20 +271,32 @@ SongLoader::Result SongLoader::LoadLocalAsync(const QString& filename) {
   }
   QByteArray data(file.read(PlaylistParser::kMagicSize));
 
-  ParserBase* parser = playlist_parser_->ParserForMagic(data);
-  if (!parser) {
-    // Check the file extension as well, maybe the magic failed, or it was a
-    // basic M3U file which is just a plain list of filenames.
-    parser = playlist_parser_->ParserForExtension(
-        QFileInfo(filename).suffix().toLower());
+  // Most dropped files are audio, which a glance at the header tells us
+  // without asking every playlist parser.
+  const bool audio = PlaylistParser::LooksLikeAudio(data);
+
+  ParserBase* parser = nullptr;
+  if (!audio) {
+    parser = playlist_parser_->ParserForMagic(data);
+    if (!parser) {
+      // Check the file extension as well, maybe the magic failed, or it was a
+      // basic M3U file which is just a plain list of filenames.
+      parser = playlist_parser_->ParserForExtension(
+          QFileInfo(filename).suffix().toLower());
+    }
   }
 
   if (parser) {
     qLog(Debug) << "Parsing using" << parser->name();
 
     // It's a playlist!
-    file.reset();
-    songs_ = parser->Load(&file, filename, info.path());
+    if (chunk_callback_) {
+      parser->LoadMappedFile(&file, info.path(), chunk_callback_);
+    } else {
+      parser->LoadMappedFile(
+          &file, info.path(),
+          [this](const SongList& songs) { songs_ << songs; });
+    }
     return Success;
   }
 
@@ -257,8 +316,7 @@ SongLoader::Result SongLoader::LoadLocalAsync(const QString& filename) {
   }
 
   // Assume it's just a normal file
-  Song song;
-  song.InitFromFilePartial(filename);
+  Song song = PartialSong(filename, data);
   if (song.is_valid()) {
     songs_ << song;
     return Success;
@@ -269,11 +327,12 @@ SongLoader::Result SongLoader::LoadLocalAsync(const QString& filename) {
 
 void SongLoader::LoadMetadataBlocking() {
   for (int i = 0; i < songs_.size(); i++) {
-    EffectiveSongLoad(&songs_[i]);
+    EffectiveSongLoad(library_, &songs_[i]);
   }
 }
 
-void SongLoader::EffectiveSongLoad(Song* song) {
+void SongLoader::EffectiveSongLoad(LibraryBackendInterface* library,
+                                   Song* song) {
   if (!song) return;
 
   if (song->filetype() != Song::Type_Unknown) {
@@ -282,13 +341,14 @@ void SongLoader::EffectiveSongLoad(Song* song) {
   }
 
   // First, try to get the song from the library
-  Song library_song = library_->GetSongByUrl(song->url());
+  Song library_song = library->GetSongByUrl(song->url());
   if (library_song.is_valid()) {
     *song = library_song;
   } else {
     // it's a normal media file
     QString filename = song->url().toLocalFile();
-    TagReaderClient::Instance()->ReadFileBlocking(filename, song);
+    TagReaderClient::Instance()->ReadFileBlocking(
+        filename, song, TagReaderClient::Priority_Playback);
   }
 }
 
@@ -319,7 +379,7 @@ void SongLoader::LoadLocalDirectory(const QString& filename) {
   // one in our list to be fully loaded, so if the user has the "Start playing
   // when adding to playlist" preference behaviour set, it can enjoy the first
   // song being played (seek it, have moodbar, etc.)
-  if (!songs_.isEmpty()) EffectiveSongLoad(&(*songs_.begin()));
+  if (!songs_.isEmpty()) EffectiveSongLoad(library_, &(*songs_.begin()));
 }
 
 void SongLoader::AddAsRawStream() {
@@ -331,6 +391,10 @@ void SongLoader::AddAsRawStream() {
   songs_ << song;
 }
 
+void SongLoader::CacheRemoteSongs() {
+  sRemoteCache.Store(requested_url_, songs_);
+}
+
 void SongLoader::Timeout() {
   state_ = Finished;
   success_ = false;
@@ -352,6 +416,7 @@ void SongLoader::StopTypefind() {
     QBuffer buf(&buffer_);
     buf.open(QIODevice::ReadOnly);
     songs_ = parser_->Load(&buf);
+    CacheRemoteSongs();
   } else if (success_ && is_podcast_) {
     qLog(Debug) << "Parsing" << url_ << "as a podcast";
 
@@ -370,6 +435,7 @@ void SongLoader::StopTypefind() {
 
     // It wasn't a playlist - just put the URL in as a stream
     AddAsRawStream();
+    CacheRemoteSongs();
   }
 
   emit LoadRemoteFinished();
@@ -649,6 +715,7 @@ bool SongLoader::LoadRemotePlaylist(const QUrl& url) {
   // Now we check if there is a parser that can handle that MIME type.
   QString mime_type =
       headers_reply->header(QNetworkRequest::ContentTypeHeader).toString();
+  mime_type_ = mime_type.section(';', 0, 0).trimmed().toLower();
 
   ParserBase* const parser = playlist_parser_->ParserForMimeType(mime_type);
   if (parser == nullptr) {
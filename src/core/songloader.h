@@ -31,6 +31,7 @@
 #include <functional>
 #include <memory>
 
+#include "core/remoteurlcache.h"
 #include "core/tagreaderclient.h"
 #include "musicbrainz/musicbrainzclient.h"
 #include "song.h"
@@ -65,6 +66,16 @@ class SongLoader : public QObject {
   int timeout() const { return timeout_; }
   void set_timeout(int msec) { timeout_ = msec; }
 
+  // Local playlist files are parsed a chunk at a time.  If a callback is set
+  // it's given each chunk as soon as it's parsed, from the loading thread,
+  // and those songs aren't added to songs().
+  void set_chunk_callback(
+      const std::function<void(const SongList&)>& callback) {
+    chunk_callback_ = callback;
+  }
+  // Whether url is a local file that looks like a playlist.
+  bool IsPlaylist(const QUrl& url) const;
+
   // If Success is returned the songs are fully loaded. If BlockingLoadRequired
   // is returned LoadFilenamesBlocking() needs to be called next.
   Result Load(const QUrl& url);
@@ -76,6 +87,10 @@ class SongLoader : public QObject {
   // finished, the Song objects in songs() contain metadata now. This method is
   // blocking, do not call it from the UI thread.
   void LoadMetadataBlocking();
+  // Completely loads one song, looking it up in the library first.  Different
+  // songs can be loaded from different threads at once.  This method is
+  // blocking, do not call it from the UI thread.
+  static void EffectiveSongLoad(LibraryBackendInterface* library, Song* song);
   Result LoadAudioCD();
 
  signals:
@@ -100,11 +115,15 @@ class SongLoader : public QObject {
 
   Result LoadLocal(const QString& filename);
   Result LoadLocalAsync(const QString& filename);
-  void EffectiveSongLoad(Song* song);
   Result LoadLocalPartial(const QString& filename);
+  // Makes a partially loaded song for a local file, using its first few bytes
+  // to skip TagLib when it's obviously audio.
+  static Song PartialSong(const QString& filename, const QByteArray& header);
   void LoadLocalDirectory(const QString& filename);
 
   void AddAsRawStream();
+  // Remembers songs_ as what requested_url_ resolves to.
+  void CacheRemoteSongs();
 
   Result LoadRemote();
   bool LoadRemotePlaylist(const QUrl& url);
@@ -125,7 +144,10 @@ class SongLoader : public QObject {
 
  private:
   static QSet<QString> sRawUriSchemes;
+  static RemoteUrlCache sRemoteCache;
 
+  // url_ can be changed while it's loaded, this is the one Load was given.
+  QUrl requested_url_;
   QUrl url_;
   SongList songs_;
 
@@ -136,6 +158,7 @@ class SongLoader : public QObject {
 
   // For async loads
   std::function<Result()> preload_func_;
+  std::function<void(const SongList&)> chunk_callback_;
   int timeout_;
   State state_;
   bool success_;
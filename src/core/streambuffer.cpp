@@ -0,0 +1,88 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "streambuffer.h"
+
+#include <QMutexLocker>
+#include <cstring>
+
+StreamBuffer::StreamBuffer(QObject* parent)
+    : QIODevice(parent),
+      chunk_pos_(0),
+      size_(0),
+      finished_(false),
+      aborted_(false) {
+  open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void StreamBuffer::Append(const QByteArray& data) {
+  if (data.isEmpty()) return;
+
+  QMutexLocker l(&mutex_);
+  chunks_ << data;
+  size_ += data.size();
+  data_available_.wakeAll();
+}
+
+void StreamBuffer::Finish() {
+  QMutexLocker l(&mutex_);
+  finished_ = true;
+  data_available_.wakeAll();
+}
+
+void StreamBuffer::Abort() {
+  QMutexLocker l(&mutex_);
+  aborted_ = true;
+  data_available_.wakeAll();
+}
+
+qint64 StreamBuffer::bytesAvailable() const {
+  QMutexLocker l(&mutex_);
+  return size_ + QIODevice::bytesAvailable();
+}
+
+bool StreamBuffer::atEnd() const {
+  QMutexLocker l(&mutex_);
+  return aborted_ || (finished_ && size_ == 0);
+}
+
+qint64 StreamBuffer::readData(char* data, qint64 max_size) {
+  QMutexLocker l(&mutex_);
+  while (size_ == 0 && !finished_ && !aborted_) {
+    data_available_.wait(&mutex_);
+  }
+
+  if (aborted_) {
+    setErrorString("Aborted");
+    return -1;
+  }
+
+  qint64 ret = 0;
+  while (ret < max_size && !chunks_.isEmpty()) {
+    const QByteArray& chunk = chunks_.first();
+    const qint64 size = qMin<qint64>(max_size - ret, chunk.size() - chunk_pos_);
+    memcpy(data + ret, chunk.constData() + chunk_pos_, size);
+    ret += size;
+    chunk_pos_ += size;
+    if (chunk_pos_ == chunk.size()) {
+      chunks_.removeFirst();
+      chunk_pos_ = 0;
+    }
+  }
+  size_ -= ret;
+  return ret;
+}
@@ -0,0 +1,61 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_STREAMBUFFER_H_
+#define CORE_STREAMBUFFER_H_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+// A pipe between two threads: one appends data as it arrives, say from a
+// QNetworkReply, and the other reads it as a sequential device.  Reads wait
+// until there's some data, so the reader can be something like a
+// QXmlStreamReader that doesn't expect to run out part-way through.
+class StreamBuffer : public QIODevice {
+ public:
+  explicit StreamBuffer(QObject* parent = nullptr);
+
+  // These can be called from any thread.
+  void Append(const QByteArray& data);
+  // Readers get the rest of the data, then the end of the stream.
+  void Finish();
+  // Readers get an error straight away.
+  void Abort();
+
+  bool isSequential() const override { return true; }
+  qint64 bytesAvailable() const override;
+  bool atEnd() const override;
+
+ protected:
+  qint64 readData(char* data, qint64 max_size) override;
+  qint64 writeData(const char*, qint64) override { return -1; }
+
+ private:
+  mutable QMutex mutex_;
+  QWaitCondition data_available_;
+  // Read from the front, chunk_pos_ bytes into the first chunk.
+  QList<QByteArray> chunks_;
+  int chunk_pos_;
+  qint64 size_;
+  bool finished_;
+  bool aborted_;
+};
+
+#endif  // CORE_STREAMBUFFER_H_
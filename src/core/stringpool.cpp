@@ -0,0 +1,86 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stringpool.h"
+
+#include <QMutexLocker>
+
+StringPool::StringPool(int max_strings)
+    : max_strings_(max_strings), bytes_saved_(0), turned_away_(0) {}
+
+QString StringPool::Intern(const QString& s) {
+  if (s.isEmpty()) return s;
+
+  QMutexLocker l(&mutex_);
+  return InternLocked(s);
+}
+
+void StringPool::Intern(std::initializer_list<QString*> strings) {
+  QMutexLocker l(&mutex_);
+  for (QString* s : strings) {
+    if (!s->isEmpty()) *s = InternLocked(*s);
+  }
+}
+
+QString StringPool::InternLocked(const QString& s) {
+  QSet<QString>::const_iterator it = strings_.constFind(s);
+  if (it != strings_.constEnd()) {
+    if (it->constData() != s.constData()) {
+      bytes_saved_ += sizeof(QString::Data) + (s.size() + 1) * sizeof(QChar);
+    }
+    return *it;
+  }
+
+  if (strings_.count() >= max_strings_) {
+    if (turned_away_ == 0 || turned_away_ >= max_strings_ / 10) {
+      PruneLocked();
+    }
+    if (strings_.count() >= max_strings_) {
+      ++turned_away_;
+      return s;
+    }
+  }
+
+  strings_.insert(s);
+  return s;
+}
+
+void StringPool::Prune() {
+  QMutexLocker l(&mutex_);
+  PruneLocked();
+}
+
+void StringPool::PruneLocked() {
+  turned_away_ = 0;
+  for (QSet<QString>::iterator it = strings_.begin(); it != strings_.end();) {
+    if (it->isDetached()) {
+      it = strings_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int StringPool::count() const {
+  QMutexLocker l(&mutex_);
+  return strings_.count();
+}
+
+qint64 StringPool::bytes_saved() const {
+  QMutexLocker l(&mutex_);
+  return bytes_saved_;
+}
@@ -0,0 +1,71 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_STRINGPOOL_H_
+#define CORE_STRINGPOOL_H_
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include <initializer_list>
+
+// Hands out one shared copy of each distinct string, so that the thousands
+// of songs by the same artist or on the same album share one buffer instead
+// of each holding their own.  Only worth it for fields that repeat a lot.
+// Thread safe.
+//
+// Once the pool holds max_strings, the strings nothing but the pool refers to
+// any more are dropped.  If they're all still in use, new strings are handed
+// back unshared until some of them have been let go.
+class StringPool {
+ public:
+  explicit StringPool(int max_strings = 100000);
+
+  QString Intern(const QString& s);
+  // Interns each of the strings in place, taking the lock once for all of
+  // them.
+  void Intern(std::initializer_list<QString*> strings);
+
+  // Drops the strings nothing but the pool refers to.
+  void Prune();
+
+  int count() const;
+  // Roughly how many bytes of string data have been shared instead of
+  // allocated again.
+  qint64 bytes_saved() const;
+
+ private:
+  Q_DISABLE_COPY(StringPool)
+
+  // Returns the pool's copy of s, adding it if there's room.  The mutex must
+  // be held.
+  QString InternLocked(const QString& s);
+  void PruneLocked();
+
+  const int max_strings_;
+
+  mutable QMutex mutex_;
+  QSet<QString> strings_;
+  qint64 bytes_saved_;
+  // Strings turned away since the pool was last pruned.  Pruning a pool full
+  // of strings that are in use would only find nothing to drop again, so
+  // it's retried once enough have been turned away.
+  int turned_away_;
+};
+
+#endif  // CORE_STRINGPOOL_H_
@@ -25,20 +25,27 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QProcess>
+#include <QSharedMemory>
 #include <QTcpServer>
 #include <QThread>
+#include <QTimer>
 #include <QUrl>
 
 #include "player.h"
 #include "songpathparser.h"
+#include "tagreader.h"
+#include "utilities.h"
 
 const char* TagReaderClient::kWorkerExecutableName = "clementine-tagreader";
+const int TagReaderClient::kMaxReadFilesBatchSize = 100;
 TagReaderClient* TagReaderClient::sInstance = nullptr;
 
 TagReaderClient::TagReaderClient(QObject* parent)
     : QObject(parent),
       worker_pool_(new WorkerPool<HandlerType>(this)),
-      path_parser_(new SongPathParser()) {
+      path_parser_(new SongPathParser()),
+      art_cache_(Utilities::GetConfigPath(Utilities::Path_CacheRoot) +
+                 "/embeddedart") {
   sInstance = this;
   setObjectName("Tag reader client");
 
@@ -50,14 +57,50 @@ TagReaderClient::TagReaderClient(QObject* parent)
 
   worker_pool_->SetExecutableName(kWorkerExecutableName);
   worker_pool_->SetWorkerCount(num_workers);
+  worker_pool_->SetDescribeRequest(&TagReaderClient::RequestFiles);
+  worker_pool_->SetMetricsPrefix("clementine_tagreader");
   connect(worker_pool_, SIGNAL(WorkerFailedToStart()),
           SLOT(WorkerFailedToStart()));
+  connect(worker_pool_, SIGNAL(WorkerCrashed(QStringList)),
+          SIGNAL(WorkerCrashed(QStringList)));
+  connect(worker_pool_, SIGNAL(WorkerDied(qint64)),
+          SLOT(ReleaseSharedMemory(qint64)));
 }
 
 TagReaderClient::~TagReaderClient() {}
 
 void TagReaderClient::Start() { worker_pool_->Start(); }
 
+QStringList TagReaderClient::RequestFiles(
+    const cpb::tagreader::Message& message) {
+  QStringList ret;
+  if (message.has_read_file_request()) {
+    ret << QStringFromStdString(message.read_file_request().filename());
+  } else if (message.has_read_files_request()) {
+    for (const std::string& filename :
+         message.read_files_request().filenames()) {
+      ret << QStringFromStdString(filename);
+    }
+  } else if (message.has_save_file_request()) {
+    ret << QStringFromStdString(message.save_file_request().filename());
+  } else if (message.has_is_media_file_request()) {
+    ret << QStringFromStdString(message.is_media_file_request().filename());
+  } else if (message.has_load_embedded_art_request()) {
+    ret << QStringFromStdString(
+        message.load_embedded_art_request().filename());
+  } else if (message.has_save_song_statistics_to_file_request()) {
+    ret << QStringFromStdString(
+        message.save_song_statistics_to_file_request().filename());
+  } else if (message.has_save_song_rating_to_file_request()) {
+    ret << QStringFromStdString(
+        message.save_song_rating_to_file_request().filename());
+  } else if (message.has_save_replaygain_to_file_request()) {
+    ret << QStringFromStdString(
+        message.save_replaygain_to_file_request().filename());
+  }
+  return ret;
+}
+
 void TagReaderClient::ReloadSettings() { path_parser_->ReloadSettings(); }
 
 void TagReaderClient::WorkerFailedToStart() {
@@ -66,13 +109,41 @@ void TagReaderClient::WorkerFailedToStart() {
               << "not be able to read music file tags without it.";
 }
 
-TagReaderReply* TagReaderClient::ReadFile(const QString& filename) {
+void TagReaderClient::ReleaseSharedMemory(qint64 pid) {
+  for (int slot = 0; slot < TagReader::kMaxSharedMemorySegments; ++slot) {
+    // Whoever detaches last from a segment frees it.
+    QSharedMemory memory(TagReader::SharedMemoryKey(pid, slot));
+    if (memory.attach(QSharedMemory::ReadOnly)) memory.detach();
+  }
+}
+
+TagReaderReply* TagReaderClient::Send(cpb::tagreader::Message* message,
+                                      Priority priority) {
+  return worker_pool_->SendMessageWithReply(
+      message, static_cast<_WorkerPoolBase::Priority>(priority));
+}
+
+TagReaderReply* TagReaderClient::ReadFile(const QString& filename,
+                                          Priority priority, bool fast) {
   cpb::tagreader::Message message;
   cpb::tagreader::ReadFileRequest* req = message.mutable_read_file_request();
 
   req->set_filename(DataCommaSizeFromQString(filename));
+  req->set_fast(fast);
+
+  return Send(&message, priority);
+}
+
+TagReaderReply* TagReaderClient::ReadFiles(const QStringList& filenames,
+                                           Priority priority) {
+  cpb::tagreader::Message message;
+  cpb::tagreader::ReadFilesRequest* req = message.mutable_read_files_request();
+
+  for (const QString& filename : filenames) {
+    req->add_filenames(DataCommaSizeFromQString(filename));
+  }
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, priority);
 }
 
 TagReaderReply* TagReaderClient::SaveFile(const QString& filename,
@@ -83,28 +154,32 @@ TagReaderReply* TagReaderClient::SaveFile(const QString& filename,
   req->set_filename(DataCommaSizeFromQString(filename));
   metadata.ToProtobuf(req->mutable_metadata());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, Priority_Interactive);
 }
 
-TagReaderReply* TagReaderClient::UpdateSongStatistics(const Song& metadata) {
+TagReaderReply* TagReaderClient::UpdateSongStatistics(const Song& metadata,
+                                                      Priority priority,
+                                                      bool include_rating) {
   cpb::tagreader::Message message;
   cpb::tagreader::SaveSongStatisticsToFileRequest* req =
       message.mutable_save_song_statistics_to_file_request();
 
   req->set_filename(DataCommaSizeFromQString(metadata.url().toLocalFile()));
+  req->set_include_rating(include_rating);
   metadata.ToProtobuf(req->mutable_metadata());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, priority);
 }
 
 void TagReaderClient::UpdateSongsStatistics(const SongList& songs) {
   for (const Song& song : songs) {
-    TagReaderReply* reply = UpdateSongStatistics(song);
+    TagReaderReply* reply = UpdateSongStatistics(song, Priority_Background);
     connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
   }
 }
 
-TagReaderReply* TagReaderClient::UpdateSongRating(const Song& metadata) {
+TagReaderReply* TagReaderClient::UpdateSongRating(const Song& metadata,
+                                                  Priority priority) {
   cpb::tagreader::Message message;
   cpb::tagreader::SaveSongRatingToFileRequest* req =
       message.mutable_save_song_rating_to_file_request();
@@ -112,12 +187,31 @@ TagReaderReply* TagReaderClient::UpdateSongRating(const Song& metadata) {
   req->set_filename(DataCommaSizeFromQString(metadata.url().toLocalFile()));
   metadata.ToProtobuf(req->mutable_metadata());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, priority);
 }
 
 void TagReaderClient::UpdateSongsRating(const SongList& songs) {
   for (const Song& song : songs) {
-    TagReaderReply* reply = UpdateSongRating(song);
+    TagReaderReply* reply = UpdateSongRating(song, Priority_Background);
+    connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
+  }
+}
+
+TagReaderReply* TagReaderClient::UpdateSongReplayGain(const Song& metadata,
+                                                      Priority priority) {
+  cpb::tagreader::Message message;
+  cpb::tagreader::SaveReplayGainToFileRequest* req =
+      message.mutable_save_replaygain_to_file_request();
+
+  req->set_filename(DataCommaSizeFromQString(metadata.url().toLocalFile()));
+  metadata.ToProtobuf(req->mutable_metadata());
+
+  return Send(&message, priority);
+}
+
+void TagReaderClient::UpdateSongsReplayGain(const SongList& songs) {
+  for (const Song& song : songs) {
+    TagReaderReply* reply = UpdateSongReplayGain(song, Priority_Background);
     connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
   }
 }
@@ -129,17 +223,20 @@ TagReaderReply* TagReaderClient::IsMediaFile(const QString& filename) {
 
   req->set_filename(DataCommaSizeFromQString(filename));
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, Priority_Background);
 }
 
-TagReaderReply* TagReaderClient::LoadEmbeddedArt(const QString& filename) {
+TagReaderReply* TagReaderClient::LoadEmbeddedArt(const QString& filename,
+                                                 bool allow_shared_memory,
+                                                 Priority priority) {
   cpb::tagreader::Message message;
   cpb::tagreader::LoadEmbeddedArtRequest* req =
       message.mutable_load_embedded_art_request();
 
   req->set_filename(DataCommaSizeFromQString(filename));
+  req->set_allow_shared_memory(allow_shared_memory);
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, priority);
 }
 
 TagReaderReply* TagReaderClient::ReadCloudFile(
@@ -156,18 +253,80 @@ TagReaderReply* TagReaderClient::ReadCloudFile(
   req->set_mime_type(DataCommaSizeFromQString(mime_type));
   req->set_authorisation_header(DataCommaSizeFromQString(authorisation_header));
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return Send(&message, Priority_Background);
 }
 
-void TagReaderClient::ReadFileBlocking(const QString& filename, Song* song) {
+void TagReaderClient::ReadFileBlocking(const QString& filename, Song* song,
+                                       Priority priority) {
   Q_ASSERT(QThread::currentThread() != thread());
 
-  TagReaderReply* reply = ReadFile(filename);
-  if (reply->WaitForFinished()) {
-    song->InitFromProtobuf(reply->message().read_file_response().metadata());
-    path_parser_->GuessMissingFields(song, filename);
+  TagReaderReply* reply = ReadFile(filename, priority);
+  if (reply->WaitForFinished()) ParseReadFileReply(filename, reply, song);
+  DeleteReplyLater(reply);
+}
+
+void TagReaderClient::DeleteReplyLater(TagReaderReply* reply) {
+  reply->moveToThread(thread());
+  connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
+  if (reply->is_finished()) reply->deleteLater();
+}
+
+void TagReaderClient::ParseReadFileReply(const QString& filename,
+                                         TagReaderReply* reply, Song* song) {
+  song->InitFromProtobuf(reply->message().read_file_response().metadata());
+  path_parser_->GuessMissingFields(song, filename);
+}
+
+void TagReaderClient::ParseReadFilesReply(const QString& filename,
+                                          TagReaderReply* reply, int index,
+                                          Song* song) {
+  const cpb::tagreader::ReadFilesResponse& response =
+      reply->message().read_files_response();
+  if (index >= response.metadata_size()) return;
+  song->InitFromProtobuf(response.metadata(index));
+  path_parser_->GuessMissingFields(song, filename);
+}
+
+SongList TagReaderClient::ReadFilesBlocking(const QStringList& filenames,
+                                            Priority priority) {
+  Q_ASSERT(QThread::currentThread() != thread());
+
+  // Send every batch before waiting on any of them so that they can be
+  // processed by several workers at the same time.
+  QList<TagReaderReply*> replies;
+  for (int i = 0; i < filenames.count(); i += kMaxReadFilesBatchSize) {
+    replies << ReadFiles(filenames.mid(i, kMaxReadFilesBatchSize), priority);
+  }
+
+  SongList ret;
+  ret.reserve(filenames.count());
+
+  int offset = 0;
+  for (TagReaderReply* reply : replies) {
+    const int batch_size =
+        qMin(kMaxReadFilesBatchSize, filenames.count() - offset);
+
+    if (reply->WaitForFinished()) {
+      for (int i = 0; i < batch_size; ++i) {
+        Song song;
+        ParseReadFilesReply(filenames[offset + i], reply, i, &song);
+        ret << song;
+      }
+    } else {
+      qLog(Warning) << "Reading a batch of" << batch_size
+                    << "files failed, reading them one at a time";
+      for (int i = 0; i < batch_size; ++i) {
+        Song song;
+        ReadFileBlocking(filenames[offset + i], &song, priority);
+        ret << song;
+      }
+    }
+    DeleteReplyLater(reply);
+
+    offset += batch_size;
   }
-  reply->deleteLater();
+
+  return ret;
 }
 
 bool TagReaderClient::SaveFileBlocking(const QString& filename,
@@ -180,35 +339,37 @@ bool TagReaderClient::SaveFileBlocking(const QString& filename,
   if (reply->WaitForFinished()) {
     ret = reply->message().save_file_response().success();
   }
-  reply->deleteLater();
+  DeleteReplyLater(reply);
 
   return ret;
 }
 
-bool TagReaderClient::UpdateSongStatisticsBlocking(const Song& metadata) {
+bool TagReaderClient::UpdateSongStatisticsBlocking(const Song& metadata,
+                                                   Priority priority) {
   Q_ASSERT(QThread::currentThread() != thread());
 
   bool ret = false;
 
-  TagReaderReply* reply = UpdateSongStatistics(metadata);
+  TagReaderReply* reply = UpdateSongStatistics(metadata, priority);
   if (reply->WaitForFinished()) {
     ret = reply->message().save_song_statistics_to_file_response().success();
   }
-  reply->deleteLater();
+  DeleteReplyLater(reply);
 
   return ret;
 }
 
-bool TagReaderClient::UpdateSongRatingBlocking(const Song& metadata) {
+bool TagReaderClient::UpdateSongRatingBlocking(const Song& metadata,
+                                               Priority priority) {
   Q_ASSERT(QThread::currentThread() != thread());
 
   bool ret = false;
 
-  TagReaderReply* reply = UpdateSongRating(metadata);
+  TagReaderReply* reply = UpdateSongRating(metadata, priority);
   if (reply->WaitForFinished()) {
     ret = reply->message().save_song_rating_to_file_response().success();
   }
-  reply->deleteLater();
+  DeleteReplyLater(reply);
 
   return ret;
 }
@@ -222,23 +383,137 @@ bool TagReaderClient::IsMediaFileBlocking(const QString& filename) {
   if (reply->WaitForFinished()) {
     ret = reply->message().is_media_file_response().success();
   }
-  reply->deleteLater();
+  DeleteReplyLater(reply);
 
   return ret;
 }
 
-QImage TagReaderClient::LoadEmbeddedArtBlocking(const QString& filename) {
-  Q_ASSERT(QThread::currentThread() != thread());
-
+QImage TagReaderClient::LoadEmbeddedArtBlocking(const QString& filename,
+                                                Priority priority) {
   QImage ret;
+  ret.loadFromData(LoadEmbeddedArtDataBlocking(filename, priority));
+  return ret;
+}
 
-  TagReaderReply* reply = LoadEmbeddedArt(filename);
-  if (reply->WaitForFinished()) {
-    const std::string& data_str =
-        reply->message().load_embedded_art_response().data();
-    ret.loadFromData(QByteArray(data_str.data(), data_str.size()));
+QByteArray TagReaderClient::LoadEmbeddedArtDataBlocking(
+    const QString& filename, Priority priority) {
+  Q_ASSERT(QThread::currentThread() != thread());
+
+  QByteArray ret;
+  if (art_cache_.Get(filename, &ret)) return ret;
+
+  bool allow_shared_memory = true;
+  forever {
+    TagReaderReply* reply =
+        LoadEmbeddedArt(filename, allow_shared_memory, priority);
+    bool retry = false;
+    if (reply->WaitForFinished()) {
+      const cpb::tagreader::LoadEmbeddedArtResponse& response =
+          reply->message().load_embedded_art_response();
+      if (response.has_shared_memory_key()) {
+        // If it took us too long to get to it, ask for it the slow way.
+        retry = !ReadSharedMemory(response, &ret);
+      } else {
+        ret = QByteArray(response.data().data(), response.data().size());
+      }
+      if (!retry) art_cache_.Put(filename, ret);
+    }
+    DeleteReplyLater(reply);
+
+    if (!retry) break;
+    allow_shared_memory = false;
   }
-  reply->deleteLater();
 
   return ret;
 }
+
+template <typename T>
+void TagReaderClient::ForwardReply(
+    TagReaderReply* reply, QObject* receiver,
+    std::function<T(TagReaderReply*)> parse,
+    std::function<void(const T&)> callback) {
+  // The reply is parsed and deleted in our thread whatever happens to the
+  // receiver.  Slots are called in the order they were connected, so the
+  // result is always there by the time the receiver's slot runs.
+  std::shared_ptr<T> result(new T);
+  connect(reply, &_MessageReplyBase::Finished, [=](bool) {
+    *result = parse(reply);
+    reply->deleteLater();
+  });
+  connect(reply, &_MessageReplyBase::Finished, receiver,
+          [=](bool) { callback(*result); });
+}
+
+void TagReaderClient::ReadFileAsync(const QString& filename, const Song& song,
+                                    QObject* receiver,
+                                    std::function<void(const Song&)> callback,
+                                    Priority priority) {
+  ForwardReply<Song>(ReadFile(filename, priority), receiver,
+                     [=](TagReaderReply* reply) {
+                       Song ret(song);
+                       if (reply->is_successful()) {
+                         ParseReadFileReply(filename, reply, &ret);
+                       }
+                       return ret;
+                     },
+                     callback);
+}
+
+void TagReaderClient::SaveFileAsync(const QString& filename,
+                                    const Song& metadata, QObject* receiver,
+                                    std::function<void(bool)> callback) {
+  ForwardReply<bool>(
+      SaveFile(filename, metadata), receiver,
+      [](TagReaderReply* reply) {
+        return reply->is_successful() &&
+               reply->message().save_file_response().success();
+      },
+      callback);
+}
+
+void TagReaderClient::LoadEmbeddedArtAsync(
+    const QString& filename, QObject* receiver,
+    std::function<void(const QImage&)> callback, Priority priority) {
+  QByteArray data;
+  if (art_cache_.Get(filename, &data)) {
+    QImage image;
+    image.loadFromData(data);
+    QTimer::singleShot(0, receiver, [callback, image]() { callback(image); });
+    return;
+  }
+
+  // Nothing waits on the reply, so there's no telling how long it will be
+  // before it's read, and shared memory would often be gone by then.
+  ForwardReply<QImage>(
+      LoadEmbeddedArt(filename, false, priority), receiver,
+      [=](TagReaderReply* reply) {
+        QImage image;
+        if (!reply->is_successful()) return image;
+
+        const std::string& data =
+            reply->message().load_embedded_art_response().data();
+        const QByteArray bytes(data.data(), data.size());
+        art_cache_.Put(filename, bytes);
+        image.loadFromData(bytes);
+        return image;
+      },
+      callback);
+}
+
+bool TagReaderClient::ReadSharedMemory(
+    const cpb::tagreader::LoadEmbeddedArtResponse& response,
+    QByteArray* data) {
+  QSharedMemory memory(QStringFromStdString(response.shared_memory_key()));
+  if (!memory.attach(QSharedMemory::ReadOnly) ||
+      memory.size() < response.shared_memory_size()) {
+    qLog(Warning) << "Couldn't read embedded art from shared memory:"
+                  << memory.errorString();
+    return false;
+  }
+
+  memory.lock();
+  *data = QByteArray(static_cast<const char*>(memory.constData()),
+                     response.shared_memory_size());
+  memory.unlock();
+  return true;
+}
@@ -24,7 +24,9 @@
 #include <memory.h>
 
 #include <QStringList>
+#include <functional>
 
+#include "core/embeddedartcache.h"
 #include "core/messagehandler.h"
 #include "core/workerpool.h"
 #include "song.h"
@@ -44,17 +46,43 @@ class TagReaderClient : public QObject {
   typedef AbstractMessageHandler<cpb::tagreader::Message> HandlerType;
   typedef HandlerType::ReplyType ReplyType;
 
+  // Requests for something the user is waiting on go before ones for the
+  // song that's playing, and those go before library scans.
+  enum Priority {
+    Priority_Interactive = _WorkerPoolBase::Priority_Interactive,
+    Priority_Playback = _WorkerPoolBase::Priority_Playback,
+    Priority_Background = _WorkerPoolBase::Priority_Background,
+  };
+
   static const char* kWorkerExecutableName;
+  static const int kMaxReadFilesBatchSize;
 
   void Start();
   void ReloadSettings();
 
-  ReplyType* ReadFile(const QString& filename);
+  // A fast read is only good for telling whether the tags have changed, see
+  // TagReader::ReadFile.
+  ReplyType* ReadFile(const QString& filename,
+                      Priority priority = Priority_Interactive,
+                      bool fast = false);
+  ReplyType* ReadFiles(const QStringList& filenames,
+                       Priority priority = Priority_Background);
   ReplyType* SaveFile(const QString& filename, const Song& metadata);
-  ReplyType* UpdateSongStatistics(const Song& metadata);
-  ReplyType* UpdateSongRating(const Song& metadata);
+  // If include_rating is set the rating is written too, in the same save.
+  ReplyType* UpdateSongStatistics(const Song& metadata,
+                                  Priority priority = Priority_Interactive,
+                                  bool include_rating = false);
+  ReplyType* UpdateSongRating(const Song& metadata,
+                              Priority priority = Priority_Interactive);
+  // Writes the song's ReplayGain values to the file's tags.
+  ReplyType* UpdateSongReplayGain(const Song& metadata,
+                                  Priority priority = Priority_Background);
   ReplyType* IsMediaFile(const QString& filename);
-  ReplyType* LoadEmbeddedArt(const QString& filename);
+  // If allow_shared_memory is set, big images may come back in a shared memory
+  // segment that has to be read with ReadSharedMemory straight away.
+  ReplyType* LoadEmbeddedArt(const QString& filename,
+                             bool allow_shared_memory = false,
+                             Priority priority = Priority_Playback);
   ReplyType* ReadCloudFile(const QUrl& download_url, const QString& title,
                            int size, const QString& mime_type,
                            const QString& authorisation_header);
@@ -62,29 +90,106 @@ class TagReaderClient : public QObject {
   // Convenience functions that call the above functions and wait for a
   // response.  These block the calling thread with a semaphore, and must NOT
   // be called from the TagReaderClient's thread.
-  void ReadFileBlocking(const QString& filename, Song* song);
+  void ReadFileBlocking(const QString& filename, Song* song,
+                        Priority priority = Priority_Interactive);
+  // Reads many files at once.  The requests are split into batches of
+  // kMaxReadFilesBatchSize files that are spread across the workers.  The
+  // returned list has one entry per filename in the same order.  A batch that
+  // fails, because its worker crashed, is read again one file at a time so
+  // that only the files that can't be read on their own are left invalid.
+  SongList ReadFilesBlocking(const QStringList& filenames,
+                             Priority priority = Priority_Background);
   bool SaveFileBlocking(const QString& filename, const Song& metadata);
-  bool UpdateSongStatisticsBlocking(const Song& metadata);
-  bool UpdateSongRatingBlocking(const Song& metadata);
+  // Fills in song from a successful ReadFile reply, guessing missing fields
+  // from the filename the same way ReadFileBlocking does.
+  void ParseReadFileReply(const QString& filename, ReplyType* reply,
+                          Song* song);
+  // The same for the file at index in a successful ReadFiles reply.  The song
+  // is left invalid if the reply has no metadata for it.
+  void ParseReadFilesReply(const QString& filename, ReplyType* reply,
+                           int index, Song* song);
+  // Deletes a reply once it has finished, whether it has yet or not.  Must be
+  // called from the thread that sent the request.  That might be a
+  // QThreadPool thread, which has no event loop to run deleteLater() on, so
+  // the reply is handed over to the client's thread first.
+  void DeleteReplyLater(ReplyType* reply);
+  bool UpdateSongStatisticsBlocking(const Song& metadata,
+                                    Priority priority = Priority_Interactive);
+  bool UpdateSongRatingBlocking(const Song& metadata,
+                                Priority priority = Priority_Interactive);
   bool IsMediaFileBlocking(const QString& filename);
-  QImage LoadEmbeddedArtBlocking(const QString& filename);
+  QImage LoadEmbeddedArtBlocking(const QString& filename,
+                                 Priority priority = Priority_Playback);
+  // The image's file as it is in the tag, without decoding it.  These are
+  // answered from a cache on disk when the song hasn't changed.
+  QByteArray LoadEmbeddedArtDataBlocking(const QString& filename,
+                                         Priority priority = Priority_Playback);
+
+  // Versions of the blocking functions above that don't block.  callback is
+  // called in receiver's thread, which needs an event loop, once the worker
+  // has answered, and not at all if receiver has been deleted by then.  Unlike
+  // the blocking functions these can be called from any thread.
+  //
+  // The file's tags are read over the top of song, which is passed back to the
+  // callback unchanged if the file couldn't be read.
+  void ReadFileAsync(const QString& filename, const Song& song,
+                     QObject* receiver,
+                     std::function<void(const Song&)> callback,
+                     Priority priority = Priority_Interactive);
+  void SaveFileAsync(const QString& filename, const Song& metadata,
+                     QObject* receiver, std::function<void(bool)> callback);
+  void LoadEmbeddedArtAsync(const QString& filename, QObject* receiver,
+                            std::function<void(const QImage&)> callback,
+                            Priority priority = Priority_Playback);
+
+  // How busy the workers are.  Must be called from the TagReaderClient's
+  // thread.
+  _WorkerPoolBase::Stats worker_stats() const { return worker_pool_->stats(); }
+
+  // The local files a request works on.
+  static QStringList RequestFiles(const cpb::tagreader::Message& message);
 
   // TODO(David Sansome): Make this not a singleton
   static TagReaderClient* Instance() { return sInstance; }
 
+  // Copies the image out of a LoadEmbeddedArt response's segment.  Returns
+  // false if it's gone.
+  static bool ReadSharedMemory(
+      const cpb::tagreader::LoadEmbeddedArtResponse& response,
+      QByteArray* data);
+
+ signals:
+  // Emitted when a worker dies in the middle of some requests, with the files
+  // they were working on.  One of them probably killed it.
+  void WorkerCrashed(const QStringList& files);
+
  public slots:
   void UpdateSongsStatistics(const SongList& songs);
   void UpdateSongsRating(const SongList& songs);
+  void UpdateSongsReplayGain(const SongList& songs);
 
  private slots:
   void WorkerFailedToStart();
+  // Frees the shared memory segments a dead worker hadn't yet, see
+  // TagReader::SharedMemoryKey.
+  void ReleaseSharedMemory(qint64 pid);
 
  private:
   static TagReaderClient* sInstance;
 
+  ReplyType* Send(cpb::tagreader::Message* message, Priority priority);
+
+  // Calls callback in receiver's thread with what parse, called in ours, made
+  // of the reply.
+  template <typename T>
+  void ForwardReply(ReplyType* reply, QObject* receiver,
+                    std::function<T(ReplyType*)> parse,
+                    std::function<void(const T&)> callback);
+
   WorkerPool<HandlerType>* worker_pool_;
   QList<cpb::tagreader::Message> message_queue_;
   std::unique_ptr<SongPathParser> path_parser_;
+  EmbeddedArtCache art_cache_;
 };
 
 typedef TagReaderClient::ReplyType TagReaderReply;
@@ -20,7 +20,21 @@
 
 #include "taskmanager.h"
 
-TaskManager::TaskManager(QObject* parent) : QObject(parent), next_task_id_(1) {}
+#include <QTimer>
+
+const int TaskManager::kProgressIntervalMsec = 100;
+
+TaskManager::TaskManager(QObject* parent)
+    : QObject(parent),
+      next_task_id_(1),
+      progress_pending_(false),
+      progress_timer_(new QTimer(this)) {
+  clock_.start();
+
+  progress_timer_->setSingleShot(true);
+  progress_timer_->setInterval(kProgressIntervalMsec);
+  connect(progress_timer_, SIGNAL(timeout()), SLOT(ProgressTimeout()));
+}
 
 int TaskManager::StartTask(const QString& name) {
   Task t;
@@ -33,6 +47,8 @@ int TaskManager::StartTask(const QString& name) {
     QMutexLocker l(&mutex_);
     t.id = next_task_id_++;
     tasks_[t.id] = t;
+    progress_emitted_msec_[t.id] = clock_.elapsed();
+    progress_pending_ = false;
   }
 
   emit TasksChanged();
@@ -63,6 +79,18 @@ void TaskManager::SetTaskBlocksLibraryScans(int id) {
   emit PauseLibraryWatchers();
 }
 
+void TaskManager::SetTaskName(int id, const QString& name) {
+  {
+    QMutexLocker l(&mutex_);
+    if (!tasks_.contains(id)) return;
+
+    tasks_[id].name = name;
+    progress_pending_ = false;
+  }
+
+  emit TasksChanged();
+}
+
 void TaskManager::SetTaskProgress(int id, int progress, int max) {
   {
     QMutexLocker l(&mutex_);
@@ -71,6 +99,7 @@ void TaskManager::SetTaskProgress(int id, int progress, int max) {
     Task& t = tasks_[id];
     t.progress = progress;
     if (max) t.progress_max = max;
+    if (!ProgressChanged(id)) return;
   }
 
   emit TasksChanged();
@@ -84,6 +113,7 @@ void TaskManager::IncreaseTaskProgress(int id, int progress, int max) {
     Task& t = tasks_[id];
     t.progress += progress;
     if (max) t.progress_max = max;
+    if (!ProgressChanged(id)) return;
   }
 
   emit TasksChanged();
@@ -107,6 +137,8 @@ void TaskManager::SetTaskFinished(int id) {
     }
 
     tasks_.remove(id);
+    progress_emitted_msec_.remove(id);
+    progress_pending_ = false;
   }
 
   emit TasksChanged();
@@ -120,3 +152,38 @@ int TaskManager::GetTaskProgress(int id) {
     return tasks_[id].progress;
   }
 }
+
+bool TaskManager::ProgressChanged(int id) {
+  const qint64 now = clock_.elapsed();
+  if (now - progress_emitted_msec_.value(id) >= kProgressIntervalMsec) {
+    progress_emitted_msec_[id] = now;
+    // Every task's latest progress goes out with this one.
+    progress_pending_ = false;
+    return true;
+  }
+
+  if (!progress_pending_) {
+    progress_pending_ = true;
+    // Progress can be set from any thread, but the timer lives in ours.
+    QMetaObject::invokeMethod(this, "StartProgressTimer", Qt::QueuedConnection);
+  }
+  return false;
+}
+
+void TaskManager::StartProgressTimer() {
+  if (!progress_timer_->isActive()) progress_timer_->start();
+}
+
+void TaskManager::ProgressTimeout() {
+  {
+    QMutexLocker l(&mutex_);
+    // Something else has emitted TasksChanged since.
+    if (!progress_pending_) return;
+    progress_pending_ = false;
+
+    const qint64 now = clock_.elapsed();
+    for (qint64& emitted : progress_emitted_msec_) emitted = now;
+  }
+
+  emit TasksChanged();
+}
@@ -21,16 +21,23 @@
 #ifndef CORE_TASKMANAGER_H_
 #define CORE_TASKMANAGER_H_
 
+#include <QElapsedTimer>
 #include <QMap>
 #include <QMutex>
 #include <QObject>
 
+class QTimer;
+
 class TaskManager : public QObject {
   Q_OBJECT
 
  public:
   explicit TaskManager(QObject* parent = nullptr);
 
+  // Progress changes are passed on through TasksChanged at most this often
+  // for each task.  Starting, renaming and finishing a task always are.
+  static const int kProgressIntervalMsec;
+
   struct Task {
     int id;
     QString name;
@@ -58,6 +65,7 @@ class TaskManager : public QObject {
 
   int StartTask(const QString& name);
   void SetTaskBlocksLibraryScans(int id);
+  void SetTaskName(int id, const QString& name);
   void SetTaskProgress(int id, int progress, int max = 0);
   void IncreaseTaskProgress(int id, int progress, int max = 0);
   void SetTaskFinished(int id);
@@ -69,11 +77,25 @@ class TaskManager : public QObject {
   void PauseLibraryWatchers();
   void ResumeLibraryWatchers();
 
+ private slots:
+  void StartProgressTimer();
+  void ProgressTimeout();
+
  private:
+  // Called with mutex_ held after a task's progress changes.  Returns true if
+  // TasksChanged should be emitted now, otherwise makes sure it will be soon.
+  bool ProgressChanged(int id);
+
   QMutex mutex_;
   QMap<int, Task> tasks_;
   int next_task_id_;
 
+  QElapsedTimer clock_;
+  // When TasksChanged was last emitted for each task's progress.
+  QMap<int, qint64> progress_emitted_msec_;
+  bool progress_pending_;
+  QTimer* progress_timer_;
+
   Q_DISABLE_COPY(TaskManager)
 };
 
@@ -36,6 +36,8 @@
 #include <QIODevice>
 #include <QMetaEnum>
 #include <QMouseEvent>
+#include <QStandardPaths>
+#include <QStorageInfo>
 #include <QStringList>
 #include <QTcpServer>
 #include <QTemporaryFile>
@@ -57,7 +59,9 @@
 #endif
 
 #if defined(Q_OS_UNIX)
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/time.h>
 #elif defined(Q_OS_WIN32)
 #include <windows.h>
 
@@ -65,6 +69,11 @@
 #endif
 
 #ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
@@ -281,6 +290,91 @@ bool RemoveRecursive(const QString& path) {
   return dir.rmdir(path);
 }
 
+#ifdef Q_OS_LINUX
+// Renames path into the trash directory trash as the freedesktop.org trash
+// specification describes, so it has to be on the same filesystem.
+static bool MoveToTrashDir(const QString& path, const QString& trash) {
+  if (!QDir().mkpath(trash + "/files") || !QDir().mkpath(trash + "/info")) {
+    return false;
+  }
+  QFile::setPermissions(trash, QFile::ReadOwner | QFile::WriteOwner |
+                                   QFile::ExeOwner);
+
+  const QFileInfo file_info(path);
+  const QByteArray contents =
+      "[Trash Info]\nPath=" +
+      QUrl::toPercentEncoding(file_info.absoluteFilePath(), "/") +
+      "\nDeletionDate=" +
+      QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ss").toUtf8() +
+      "\n";
+
+  for (int i = 1; i < 1000; ++i) {
+    const QString name =
+        i == 1 ? file_info.fileName()
+               : QString("%1.%2").arg(file_info.fileName()).arg(i);
+    const QString info_path = trash + "/info/" + name + ".trashinfo";
+    const QString trashed_path = trash + "/files/" + name;
+
+    // Making the info file first claims the name, even against other
+    // programs trashing files at the same time.
+    const int fd = open(QFile::encodeName(info_path).constData(),
+                        O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+      if (errno == EEXIST) continue;
+      return false;
+    }
+    const bool written =
+        write(fd, contents.constData(), contents.size()) == contents.size();
+    close(fd);
+
+    // rename would replace a file left there without its info file.
+    if (written && QFileInfo(trashed_path).exists()) {
+      QFile::remove(info_path);
+      continue;
+    }
+
+    if (written && rename(QFile::encodeName(path).constData(),
+                          QFile::encodeName(trashed_path).constData()) == 0) {
+      return true;
+    }
+
+    QFile::remove(info_path);
+    return false;
+  }
+
+  return false;
+}
+#endif
+
+bool MoveToTrash(const QString& path) {
+#ifdef Q_OS_LINUX
+  const QString home_trash =
+      QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+      "/Trash";
+  if (MoveToTrashDir(path, home_trash)) return true;
+
+  // Files on other filesystems go in a trash at the top of that filesystem.
+  const QString top = QStorageInfo(path).rootPath();
+  if (top.isEmpty() || top == "/") return false;
+
+  const QString uid = QString::number(getuid());
+
+  // One the administrator made for everyone, if it's there and safe to use.
+  struct stat shared;
+  const QByteArray shared_path = QFile::encodeName(top + "/.Trash");
+  if (lstat(shared_path.constData(), &shared) == 0 &&
+      S_ISDIR(shared.st_mode) && (shared.st_mode & S_ISVTX) &&
+      MoveToTrashDir(path, top + "/.Trash/" + uid)) {
+    return true;
+  }
+
+  return MoveToTrashDir(path, top + "/.Trash-" + uid);
+#else
+  Q_UNUSED(path);
+  return false;
+#endif
+}
+
 bool CopyRecursive(const QString& source, const QString& destination) {
   // Make the destination directory
   QString dir_name = source.section('/', -1, -1);
@@ -337,6 +431,96 @@ bool Copy(QIODevice* source, QIODevice* destination) {
   return true;
 }
 
+bool CopyFileFast(const QString& source, const QString& destination) {
+#ifdef Q_OS_LINUX
+  const int in = open(QFile::encodeName(source).constData(), O_RDONLY);
+  if (in == -1) return false;
+
+  struct stat info;
+  if (fstat(in, &info) == -1) {
+    close(in);
+    return false;
+  }
+
+  const int out = open(QFile::encodeName(destination).constData(),
+                       O_WRONLY | O_CREAT | O_EXCL, info.st_mode & 0777);
+  if (out == -1) {
+    close(in);
+    return false;
+  }
+
+  bool done = false;
+#ifdef FICLONE
+  // Both files share the same blocks until one of them is changed.
+  done = ioctl(out, FICLONE, in) == 0;
+#endif
+
+#ifdef SYS_copy_file_range
+  // The data doesn't come up to user space, and some filesystems copy it
+  // on the server or the device.  Called through syscall since older C
+  // libraries don't have a wrapper.
+  bool fall_back = false;
+  for (off_t remaining = info.st_size; !done;) {
+    const ssize_t copied = syscall(SYS_copy_file_range, in, nullptr, out,
+                                   nullptr, qMin<off_t>(remaining, 1 << 30),
+                                   0);
+    if (copied == -1) {
+      // Not supported on this kernel or between these filesystems.
+      fall_back = errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                  errno == EOPNOTSUPP;
+      break;
+    }
+    remaining -= copied;
+    done = copied == 0 || remaining <= 0;
+  }
+  if (!done && !fall_back) {
+    close(in);
+    close(out);
+    QFile::remove(destination);
+    return false;
+  }
+#endif
+
+  close(in);
+  close(out);
+  if (done) return true;
+
+  QFile::remove(destination);
+#endif
+  return QFile::copy(source, destination);
+}
+
+bool TouchFile(const QString& filename) {
+#if defined(Q_OS_UNIX)
+  return utimes(QFile::encodeName(filename).constData(), nullptr) == 0;
+#elif (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+  QFile file(filename);
+  return file.open(QIODevice::ReadWrite) &&
+         file.setFileTime(QDateTime::currentDateTime(),
+                          QFileDevice::FileModificationTime);
+#else
+  return false;
+#endif
+}
+
+void PruneOldestFiles(const QString& directory, qint64 max_bytes,
+                      int max_files) {
+  const QFileInfoList files = QDir(directory).entryInfoList(
+      QDir::Files | QDir::Hidden, QDir::Time | QDir::Reversed);
+
+  qint64 bytes = 0;
+  for (const QFileInfo& file : files) bytes += file.size();
+  int count = files.count();
+
+  // Oldest first
+  for (const QFileInfo& file : files) {
+    if (bytes <= max_bytes && count <= max_files) break;
+    if (!QFile::remove(file.filePath())) continue;
+    bytes -= file.size();
+    --count;
+  }
+}
+
 QString ColorToRgba(const QColor& c) {
   return QString("rgba(%1, %2, %3, %4)")
       .arg(c.red())
@@ -390,6 +574,9 @@ QString GetConfigPath(ConfigPath config) {
     case Path_PixmapCache:
       return GetConfigPath(Path_CacheRoot) + "/pixmapcache";
 
+    case Path_TranscodeCache:
+      return GetConfigPath(Path_CacheRoot) + "/transcodecache";
+
     case Path_GstreamerRegistry:
       return GetConfigPath(Path_Root) +
              QString("/gst-registry-%1-bin")
@@ -512,6 +699,33 @@ QByteArray Sha1File(QFile& file) {
   return hash.result();
 }
 
+QString FileIdentity(const QString& filename) {
+#ifdef Q_OS_UNIX
+  struct stat info;
+  if (stat(QFile::encodeName(filename).constData(), &info) != 0) {
+    return QString();
+  }
+  return QString("%1:%2")
+      .arg(quint64(info.st_dev))
+      .arg(quint64(info.st_ino));
+#else
+  static const qint64 kChunkSize = 64 * 1024;
+
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return QString();
+
+  const qint64 size = file.size();
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(file.read(kChunkSize));
+  if (size > kChunkSize && file.seek(qMax(kChunkSize, size - kChunkSize))) {
+    hash.addData(file.read(kChunkSize));
+  }
+
+  return QString("%1:%2").arg(size).arg(
+      QString::fromLatin1(hash.result().toHex()));
+#endif
+}
+
 QByteArray Sha1CoverHash(const QString& artist, const QString& album) {
   QCryptographicHash hash(QCryptographicHash::Sha1);
   hash.addData(artist.toLower().toUtf8().constData());
@@ -671,6 +885,15 @@ int SetThreadIOPriority(IoPriority priority) {
 #endif
 }
 
+int SetThreadNiceness(int niceness) {
+#ifdef Q_OS_LINUX
+  // Linux gives each thread a niceness of its own.
+  return setpriority(PRIO_PROCESS, GetThreadId(), niceness);
+#else
+  return 0;
+#endif
+}
+
 int GetThreadId() {
 #ifdef Q_OS_LINUX
   return syscall(SYS_gettid);
@@ -710,6 +933,44 @@ bool IsLaptop() {
 #endif
 }
 
+bool IsOnBattery() {
+#ifdef Q_OS_WIN
+  SYSTEM_POWER_STATUS status;
+  if (!GetSystemPowerStatus(&status)) {
+    return false;
+  }
+
+  return status.ACLineStatus == 0;  // 0 = offline
+#elif defined(Q_OS_LINUX)
+  // Plugged in if any mains supply is online, even if a battery is also
+  // reporting that it's discharging.
+  bool discharging = false;
+  QDir dir("/sys/class/power_supply");
+  for (const QString& name :
+       dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+    auto read = [&](const QString& file) {
+      QFile f(dir.filePath(name + "/" + file));
+      if (!f.open(QIODevice::ReadOnly)) return QByteArray();
+      return f.readAll().trimmed();
+    };
+
+    const QByteArray type = read("type");
+    if (type == "Mains" && read("online") == "1") return false;
+    if (type == "Battery" && read("status") == "Discharging") {
+      discharging = true;
+    }
+  }
+  return discharging;
+#elif defined(Q_OS_MAC)
+  ScopedCFTypeRef<CFTypeRef> power_sources(IOPSCopyPowerSourcesInfo());
+  CFStringRef type = IOPSGetProvidingPowerSourceType(power_sources.get());
+  return type && CFStringCompare(type, CFSTR(kIOPSBatteryPowerValue), 0) ==
+                     kCFCompareEqualTo;
+#else
+  return false;
+#endif
+}
+
 QString SystemLanguageName() {
   QString system_language = QLocale::system().uiLanguages().empty()
                                 ? QLocale::system().name()
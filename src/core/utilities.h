@@ -58,8 +58,22 @@ QString GetTemporaryFileName();
 QString SaveToTemporaryFile(const QByteArray& data);
 
 bool RemoveRecursive(const QString& path);
+// Moves the file or directory to the freedesktop.org trash.  Only renames are
+// tried, false if the file couldn't be moved that way.
+bool MoveToTrash(const QString& path);
 bool CopyRecursive(const QString& source, const QString& destination);
 bool Copy(QIODevice* source, QIODevice* destination);
+// Like QFile::copy, but on Linux the data is shared with a reflink if the
+// filesystem can, and otherwise copied in the kernel with copy_file_range.
+// The destination must not exist.
+bool CopyFileFast(const QString& source, const QString& destination);
+// Sets the file's modification time to now.  Caches that are pruned oldest
+// first touch their files when they're used, so the ones in use are kept.
+bool TouchFile(const QString& filename);
+// Removes the files in directory that were modified longest ago until the
+// rest take up at most max_bytes and number at most max_files.
+void PruneOldestFiles(const QString& directory, qint64 max_bytes,
+                      int max_files);
 
 void OpenInFileBrowser(const QList<QUrl>& filenames);
 
@@ -74,6 +88,12 @@ QByteArray HmacMd5(const QByteArray& key, const QByteArray& data);
 QByteArray HmacSha256(const QByteArray& key, const QByteArray& data);
 QByteArray HmacSha1(const QByteArray& key, const QByteArray& data);
 QByteArray Sha1File(QFile& file);
+// Returns a string that identifies a file's contents independently of its
+// path, so that files that were moved or renamed can be recognised without
+// reading them fully.  On Unix this is the device and inode numbers, elsewhere
+// it's the size and a hash of the first and last 64KiB.  Returns an empty
+// string if the file can't be read.
+QString FileIdentity(const QString& filename);
 QByteArray Sha1CoverHash(const QString& artist, const QString& album);
 
 // Picks an unused ephemeral port number.  Doesn't hold the port open so
@@ -139,6 +159,7 @@ enum ConfigPath {
   Path_MoodbarCache,
   Path_PixmapCache,
   Path_CacheRoot,
+  Path_TranscodeCache,
 };
 QString GetConfigPath(ConfigPath config);
 
@@ -157,10 +178,14 @@ enum {
 static const int IOPRIO_CLASS_SHIFT = 13;
 
 int SetThreadIOPriority(IoPriority priority);
+// Only has an effect on Linux, elsewhere niceness is per process.
+int SetThreadNiceness(int niceness);
 int GetThreadId();
 
 // Returns true if this machine has a battery.
 bool IsLaptop();
+// Returns true if this machine is running from its battery right now.
+bool IsOnBattery();
 
 QString SystemLanguageName();
 
@@ -0,0 +1,64 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "warmupscheduler.h"
+
+#include <QElapsedTimer>
+
+#include "core/logging.h"
+#include "core/trace.h"
+
+WarmUpScheduler::WarmUpScheduler(QObject* parent) : QObject(parent) {
+  // A zero timer only fires once the events already queued, like paints and
+  // input, have been handled.
+  timer_.setInterval(0);
+  connect(&timer_, SIGNAL(timeout()), SLOT(RunNext()));
+}
+
+void WarmUpScheduler::Add(const QString& name, std::function<bool()> built,
+                          std::function<void()> build) {
+  steps_ << Step{name, built, build};
+}
+
+void WarmUpScheduler::Start() {
+  if (steps_.isEmpty()) {
+    emit Finished();
+    return;
+  }
+  timer_.start();
+}
+
+void WarmUpScheduler::RunNext() {
+  // Skip over anything that was needed early, so each slice builds one thing.
+  while (!steps_.isEmpty()) {
+    const Step step = steps_.takeFirst();
+    if (step.built_()) continue;
+
+    TRACE_SCOPE("WarmUp " + step.name_);
+    QElapsedTimer timer;
+    timer.start();
+    step.build_();
+    qLog(Debug) << "Warmed up" << step.name_ << "in" << timer.elapsed()
+                << "ms";
+    break;
+  }
+
+  if (steps_.isEmpty()) {
+    timer_.stop();
+    emit Finished();
+  }
+}
@@ -0,0 +1,65 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_WARMUPSCHEDULER_H_
+#define CORE_WARMUPSCHEDULER_H_
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+// Builds things that aren't needed for the first paint one at a time, each in
+// its own pass of the event loop, so they don't hold up the window or each
+// other.  Anything that's needed before its turn just gets built on demand as
+// usual - its step is then skipped.
+class WarmUpScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit WarmUpScheduler(QObject* parent = nullptr);
+
+  // built returns true if the thing has already been built.  build is called
+  // in a later slice if it hasn't.
+  void Add(const QString& name, std::function<bool()> built,
+           std::function<void()> build);
+
+  // Starts running the steps added so far.
+  void Start();
+
+  bool is_running() const { return timer_.isActive(); }
+  int pending() const { return steps_.count(); }
+
+ signals:
+  void Finished();
+
+ private slots:
+  void RunNext();
+
+ private:
+  struct Step {
+    QString name_;
+    std::function<bool()> built_;
+    std::function<void()> build_;
+  };
+
+  QList<Step> steps_;
+  QTimer timer_;
+};
+
+#endif  // CORE_WARMUPSCHEDULER_H_
@@ -20,21 +20,22 @@
 #include "albumcoverexporter.h"
 
 #include <QFile>
+#include <QStorageInfo>
+#include <QThread>
 #include <QThreadPool>
 
 #include "core/song.h"
 #include "coverexportrunnable.h"
 
-const int AlbumCoverExporter::kMaxConcurrentRequests = 3;
+const int AlbumCoverExporter::kMaxLocalThreads = 8;
+const int AlbumCoverExporter::kNetworkThreads = 16;
 
 AlbumCoverExporter::AlbumCoverExporter(QObject* parent)
     : QObject(parent),
       thread_pool_(new QThreadPool(this)),
       exported_(0),
       skipped_(0),
-      all_(0) {
-  thread_pool_->setMaxThreadCount(kMaxConcurrentRequests);
-}
+      all_(0) {}
 
 void AlbumCoverExporter::SetDialogResult(
     const AlbumCoverExport::DialogResult& dialog_result) {
@@ -42,18 +43,42 @@ void AlbumCoverExporter::SetDialogResult(
 }
 
 void AlbumCoverExporter::AddExportRequest(Song song) {
+  if (requests_.isEmpty()) {
+    first_destination_ = song.url().toLocalFile().section('/', 0, -2);
+  }
   requests_.append(new CoverExportRunnable(dialog_result_, song));
   all_ = requests_.count();
 }
 
-void AlbumCoverExporter::Cancel() { requests_.clear(); }
+void AlbumCoverExporter::Cancel() {
+  qDeleteAll(requests_);
+  requests_.clear();
+}
 
 void AlbumCoverExporter::StartExporting() {
   exported_ = 0;
   skipped_ = 0;
+
+  // The covers go next to the songs, which are usually all in one place.
+  thread_pool_->setMaxThreadCount(ThreadsForDestination(first_destination_));
   AddJobsToPool();
 }
 
+int AlbumCoverExporter::ThreadsForDestination(const QString& dir) {
+  // Each cover on a network share spends most of its time waiting for the
+  // server, so lots can be in flight at once.  A local disk is kept busy by
+  // a few, and more would just make it seek.
+  const QString type =
+      QString::fromLatin1(QStorageInfo(dir).fileSystemType()).toLower();
+  if (type.startsWith("nfs") || type.startsWith("cifs") ||
+      type.startsWith("smb") || type.contains("sshfs") ||
+      type.startsWith("afp") || type.contains("davfs")) {
+    return kNetworkThreads;
+  }
+
+  return qBound(2, QThread::idealThreadCount(), kMaxLocalThreads);
+}
+
 void AlbumCoverExporter::AddJobsToPool() {
   while (!requests_.isEmpty() &&
          thread_pool_->activeThreadCount() < thread_pool_->maxThreadCount()) {
@@ -36,7 +36,11 @@ class AlbumCoverExporter : public QObject {
   explicit AlbumCoverExporter(QObject* parent = nullptr);
   virtual ~AlbumCoverExporter() {}
 
-  static const int kMaxConcurrentRequests;
+  static const int kMaxLocalThreads;
+  static const int kNetworkThreads;
+
+  // How many covers to export at once to the filesystem dir is on.
+  static int ThreadsForDestination(const QString& dir);
 
   void SetDialogResult(const AlbumCoverExport::DialogResult& dialog_result);
   void AddExportRequest(Song song);
@@ -57,6 +61,7 @@ class AlbumCoverExporter : public QObject {
   AlbumCoverExport::DialogResult dialog_result_;
 
   QQueue<CoverExportRunnable*> requests_;
+  QString first_destination_;
   QThreadPool* thread_pool_;
 
   int exported_;
@@ -26,6 +26,9 @@
 #include "core/network.h"
 
 const int AlbumCoverFetcher::kMaxConcurrentRequests = 5;
+const int AlbumCoverFetcher::kNegativeCacheSecs = 60 * 60;
+
+QHash<QString, QDateTime> AlbumCoverFetcher::sMissingCovers;
 
 AlbumCoverFetcher::AlbumCoverFetcher(CoverProviders* cover_providers,
                                      QObject* parent,
@@ -49,6 +52,26 @@ quint64 AlbumCoverFetcher::FetchAlbumCover(const QString& artist,
   request.id = next_id_++;
   request.fetchall = fetchall;
 
+  const QString key = RequestKey(artist, album);
+
+  auto missing = sMissingCovers.find(key);
+  if (missing != sMissingCovers.end()) {
+    if (missing.value().secsTo(QDateTime::currentDateTime()) <
+        kNegativeCacheSecs) {
+      // The caller only knows the ID once we've returned.
+      QMetaObject::invokeMethod(this, "SendMissingCover", Qt::QueuedConnection,
+                                Q_ARG(quint64, request.id));
+      return request.id;
+    }
+    sMissingCovers.erase(missing);
+  }
+
+  if (fetches_by_key_.contains(key)) {
+    duplicate_requests_.insert(fetches_by_key_[key], request.id);
+    return request.id;
+  }
+
+  fetches_by_key_[key] = request.id;
   AddRequest(request);
   return request.id;
 }
@@ -74,8 +97,15 @@ void AlbumCoverFetcher::AddRequest(const CoverSearchRequest& req) {
   if (active_requests_.size() < kMaxConcurrentRequests) StartRequests();
 }
 
+QString AlbumCoverFetcher::RequestKey(const QString& artist,
+                                      const QString& album) {
+  return artist.simplified().toLower() + "\n" + album.simplified().toLower();
+}
+
 void AlbumCoverFetcher::Clear() {
   queued_requests_.clear();
+  fetches_by_key_.clear();
+  duplicate_requests_.clear();
 
   for (AlbumCoverFetcherSearch* search : active_requests_.values()) {
     search->Cancel();
@@ -125,5 +155,25 @@ void AlbumCoverFetcher::SingleCoverFetched(quint64 request_id,
   if (!search) return;
 
   search->deleteLater();
+
+  const CoverSearchRequest& request = search->request();
+  const QString key = RequestKey(request.artist, request.album);
+  fetches_by_key_.remove(key);
+  if (image.isNull()) {
+    sMissingCovers[key] = QDateTime::currentDateTime();
+  }
+
   emit AlbumCoverFetched(request_id, image, search->statistics());
+
+  // The statistics were only made once.
+  for (quint64 id : duplicate_requests_.values(request_id)) {
+    emit AlbumCoverFetched(id, image, CoverSearchStatistics());
+  }
+  duplicate_requests_.remove(request_id);
+}
+
+void AlbumCoverFetcher::SendMissingCover(quint64 request_id) {
+  CoverSearchStatistics statistics;
+  statistics.missing_images_++;
+  emit AlbumCoverFetched(request_id, QImage(), statistics);
 }
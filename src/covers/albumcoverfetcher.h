@@ -21,6 +21,7 @@
 #ifndef COVERS_ALBUMCOVERFETCHER_H_
 #define COVERS_ALBUMCOVERFETCHER_H_
 
+#include <QDateTime>
 #include <QHash>
 #include <QImage>
 #include <QList>
@@ -89,8 +90,13 @@ class AlbumCoverFetcher : public QObject {
   virtual ~AlbumCoverFetcher() {}
 
   static const int kMaxConcurrentRequests;
+  static const int kNegativeCacheSecs;
 
   quint64 SearchForCovers(const QString& artist, const QString& album);
+
+  // Requests for an album that's already being fetched are answered by the
+  // same fetch.  If an album had no cover the last time it was fetched, the
+  // null image is sent again without searching for a while.
   quint64 FetchAlbumCover(const QString& artist, const QString& album,
                           bool fetchall);
 
@@ -106,10 +112,14 @@ class AlbumCoverFetcher : public QObject {
   void SingleSearchFinished(quint64, CoverSearchResults results);
   void SingleCoverFetched(quint64, const QImage& cover);
   void StartRequests();
+  void SendMissingCover(quint64 request_id);
 
  private:
   void AddRequest(const CoverSearchRequest& req);
 
+  // The same album from different tags should only be fetched once.
+  static QString RequestKey(const QString& artist, const QString& album);
+
   CoverProviders* cover_providers_;
   QNetworkAccessManager* network_;
   quint64 next_id_;
@@ -117,6 +127,13 @@ class AlbumCoverFetcher : public QObject {
   QQueue<CoverSearchRequest> queued_requests_;
   QHash<quint64, AlbumCoverFetcherSearch*> active_requests_;
 
+  // Fetches by RequestKey, and the requests waiting on each one of them.
+  QHash<QString, quint64> fetches_by_key_;
+  QMultiHash<quint64, quint64> duplicate_requests_;
+
+  // When albums were found to have no cover, shared by all the fetchers.
+  static QHash<QString, QDateTime> sMissingCovers;
+
   QTimer* request_starter_;
 };
 
@@ -20,6 +20,7 @@
 
 #include "albumcoverfetchersearch.h"
 
+#include <QElapsedTimer>
 #include <QMutexLocker>
 #include <QNetworkReply>
 #include <QTimer>
@@ -36,6 +37,7 @@
 
 const int AlbumCoverFetcherSearch::kSearchTimeoutMs = 10000;
 const int AlbumCoverFetcherSearch::kImageLoadTimeoutMs = 2500;
+const int AlbumCoverFetcherSearch::kStaggerMs = 1500;
 const int AlbumCoverFetcherSearch::kTargetSize = 500;
 const float AlbumCoverFetcherSearch::kGoodScore = 1.85;
 
@@ -46,6 +48,7 @@ AlbumCoverFetcherSearch::AlbumCoverFetcherSearch(
       request_(request),
       image_load_timeout_(new NetworkTimeouts(kImageLoadTimeoutMs, this)),
       network_(network),
+      cover_providers_(nullptr),
       cancel_requested_(false) {
   // we will terminate the search after kSearchTimeoutMs milliseconds if we are
   // not
@@ -54,36 +57,75 @@ AlbumCoverFetcherSearch::AlbumCoverFetcherSearch(
 }
 
 void AlbumCoverFetcherSearch::TerminateSearch() {
+  waiting_providers_.clear();
+
   for (int id : pending_requests_.keys()) {
-    pending_requests_.take(id)->CancelSearch(id);
+    CoverProvider* provider = pending_requests_.take(id);
+    provider->CancelSearch(id);
+    cover_providers_->ProviderSearched(
+        provider->name(), search_time_.elapsed() - request_started_.take(id),
+        false);
   }
 
   AllProvidersFinished();
 }
 
 void AlbumCoverFetcherSearch::Start(CoverProviders* cover_providers) {
-  for (CoverProvider* provider : cover_providers->List()) {
+  cover_providers_ = cover_providers;
+  search_time_.start();
+
+  for (CoverProvider* provider : cover_providers->ListByHistory()) {
     // Skip provider if it does not have fetchall set, and we are doing fetchall
     // - "Fetch Missing Covers".
     if (!provider->fetchall() && request_.fetchall) {
       continue;
     }
+    waiting_providers_ << provider;
+  }
+
+  if (request_.search) {
+    // The user wants to see everything there is.
+    StartProviders(waiting_providers_.count());
+  } else {
+    // Ask the provider that's done best so far first.  The others are only
+    // asked if it doesn't answer quickly or doesn't have a good enough cover.
+    StartProviders(1);
+    QTimer::singleShot(kStaggerMs, this, SLOT(StartWaitingProviders()));
+  }
+
+  // end this search before it even began if there are no providers...
+  if (pending_requests_.isEmpty()) {
+    TerminateSearch();
+  }
+}
+
+bool AlbumCoverFetcherSearch::StartProviders(int count) {
+  int started = 0;
+  while (started < count && !waiting_providers_.isEmpty()) {
+    CoverProvider* provider = waiting_providers_.takeFirst();
+
     connect(provider, SIGNAL(SearchFinished(int, QList<CoverSearchResult>)),
             SLOT(ProviderSearchFinished(int, QList<CoverSearchResult>)));
-    const int id = cover_providers->NextId();
+    const int id = cover_providers_->NextId();
     const bool success =
         provider->StartSearch(request_.artist, request_.album, id);
 
     if (success) {
       pending_requests_[id] = provider;
+      request_started_[id] = search_time_.elapsed();
       statistics_.network_requests_made_++;
+      started++;
     }
   }
+  return started > 0;
+}
 
-  // end this search before it even began if there are no providers...
-  if (pending_requests_.isEmpty()) {
-    TerminateSearch();
-  }
+void AlbumCoverFetcherSearch::StartWaitingProviders() {
+  // Once the first provider has answered, its results decide whether the
+  // others are needed.
+  if (pending_requests_.isEmpty()) return;
+
+  StartProviders(waiting_providers_.count());
 }
 
 static bool CompareProviders(const CoverSearchResult& a,
@@ -96,6 +138,9 @@ void AlbumCoverFetcherSearch::ProviderSearchFinished(
   if (!pending_requests_.contains(id)) return;
 
   CoverProvider* provider = pending_requests_.take(id);
+  cover_providers_->ProviderSearched(
+      provider->name(), search_time_.elapsed() - request_started_.take(id),
+      !results.isEmpty());
 
   CoverSearchResults results_copy(results);
   // Set categories on the results
@@ -126,10 +171,9 @@ void AlbumCoverFetcherSearch::AllProvidersFinished() {
     return;
   }
 
-  // no results?
+  // no results?  Try the providers we haven't asked yet, if there are any.
   if (results_.isEmpty()) {
-    statistics_.missing_images_++;
-    emit AlbumCoverFetched(request_.id, QImage());
+    if (!StartProviders(waiting_providers_.count())) SendBestImage();
     return;
   }
 
@@ -155,8 +199,13 @@ void AlbumCoverFetcherSearch::FetchMoreImages() {
 
     qLog(Debug) << "Loading" << result.image_url << "from" << result.provider;
 
+    QNetworkRequest request(result.image_url);
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+    // Lots of covers tend to come from the same few hosts.
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
     RedirectFollower* image_reply =
-        new RedirectFollower(network_->get(QNetworkRequest(result.image_url)));
+        new RedirectFollower(network_->get(request));
     NewClosure(image_reply, SIGNAL(finished()), this,
                SLOT(ProviderCoverFetchFinished(RedirectFollower*)),
                image_reply);
@@ -167,8 +216,9 @@ void AlbumCoverFetcherSearch::FetchMoreImages() {
   }
 
   if (pending_image_loads_.isEmpty()) {
-    // There were no more results?  Time to give up.
-    SendBestImage();
+    // There were no more results?  Time to ask the other providers, or give up
+    // if they've all been asked.
+    if (!StartProviders(waiting_providers_.count())) SendBestImage();
   }
 }
 
@@ -242,6 +292,7 @@ void AlbumCoverFetcherSearch::SendBestImage() {
     image = best_image.second;
 
     statistics_.chosen_images_by_provider_[best_image.first]++;
+    cover_providers_->ProviderChosen(best_image.first);
     statistics_.chosen_images_++;
     statistics_.chosen_width_ += image.width();
     statistics_.chosen_height_ += image.height();
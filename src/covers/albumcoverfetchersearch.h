@@ -21,6 +21,8 @@
 #ifndef COVERS_ALBUMCOVERFETCHERSEARCH_H_
 #define COVERS_ALBUMCOVERFETCHERSEARCH_H_
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QMap>
 #include <QObject>
 
@@ -36,6 +38,8 @@ class RedirectFollower;
 // AlbumCoverFetcher. The search engages all of the known cover providers.
 // AlbumCoverFetcherSearch signals search results to an interested
 // AlbumCoverFetcher when all of the providers have done their part.
+// Searches that fetch a cover ask the providers one after another, best first
+// according to CoverProviders' history, and stop at the first good cover.
 class AlbumCoverFetcherSearch : public QObject {
   Q_OBJECT
 
@@ -49,6 +53,7 @@ class AlbumCoverFetcherSearch : public QObject {
   // is the caller's responsibility to delete the AlbumCoverFetcherSearch.
   void Cancel();
 
+  const CoverSearchRequest& request() const { return request_; }
   CoverSearchStatistics statistics() const { return statistics_; }
 
  signals:
@@ -62,10 +67,15 @@ class AlbumCoverFetcherSearch : public QObject {
   void ProviderSearchFinished(int id, const QList<CoverSearchResult>& results);
   void ProviderCoverFetchFinished(RedirectFollower* reply);
   void TerminateSearch();
+  void StartWaitingProviders();
 
  private:
   void AllProvidersFinished();
 
+  // Asks up to count of the waiting providers, returns false if none of them
+  // could be asked.
+  bool StartProviders(int count);
+
   void FetchMoreImages();
   float ScoreImage(const QImage& image) const;
   void SendBestImage();
@@ -73,6 +83,7 @@ class AlbumCoverFetcherSearch : public QObject {
  private:
   static const int kSearchTimeoutMs;
   static const int kImageLoadTimeoutMs;
+  static const int kStaggerMs;
   static const int kTargetSize;
   static const float kGoodScore;
 
@@ -84,7 +95,9 @@ class AlbumCoverFetcherSearch : public QObject {
   // Complete results (from all of the available providers).
   CoverSearchResults results_;
 
+  QList<CoverProvider*> waiting_providers_;
   QMap<int, CoverProvider*> pending_requests_;
+  QMap<int, qint64> request_started_;
   QMap<RedirectFollower*, QString> pending_image_loads_;
   NetworkTimeouts* image_load_timeout_;
 
@@ -93,6 +106,8 @@ class AlbumCoverFetcherSearch : public QObject {
   QMap<float, CandidateImage> candidate_images_;
 
   QNetworkAccessManager* network_;
+  CoverProviders* cover_providers_;
+  QElapsedTimer search_time_;
 
   bool cancel_requested_;
 };
@@ -23,25 +23,50 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QImageReader>
 #include <QNetworkReply>
 #include <QPainter>
+#include <QThread>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 #include "config.h"
 #include "core/closure.h"
 #include "core/logging.h"
+#include "core/memorybudget.h"
 #include "core/network.h"
 #include "core/tagreaderclient.h"
 #include "core/utilities.h"
 #include "internet/core/internetmodel.h"
 
+const int AlbumCoverLoader::kMaxDecodeThreads = 4;
+
 AlbumCoverLoader::AlbumCoverLoader(QObject* parent)
     : QObject(parent),
       stop_requested_(false),
+      active_local_tasks_(0),
+      scaled_cache_(Utilities::GetConfigPath(Utilities::Path_CacheRoot) +
+                    "/scaledcovers"),
+      budget_(nullptr),
+      budget_id_(0),
       next_id_(1),
       network_(new NetworkAccessManager(this)),
       connected_spotify_(false) {
   setObjectName("Album cover loader");
+  decode_pool_.setMaxThreadCount(
+      qBound(1, QThread::idealThreadCount(), kMaxDecodeThreads));
+}
+
+AlbumCoverLoader::~AlbumCoverLoader() {
+  if (budget_) budget_->Unregister(budget_id_);
+}
+
+void AlbumCoverLoader::RegisterWithBudget(MemoryBudget* budget) {
+  budget_ = budget;
+  budget_id_ = budget->Register(
+      "Scaled covers", ScaledCoverCache::kMemoryBytes,
+      [this]() { return scaled_cache_.memory_used(); },
+      [this](qint64 bytes) { scaled_cache_.set_memory_limit(bytes); });
 }
 
 QString AlbumCoverLoader::ImageCacheDir() {
@@ -69,6 +94,24 @@ void AlbumCoverLoader::CancelTasks(const QSet<quint64>& ids) {
   }
 }
 
+void AlbumCoverLoader::PrioritiseTasks(const QList<quint64>& ids) {
+  QMutexLocker l(&mutex_);
+
+  QMap<quint64, Task> moved;
+  for (QQueue<Task>::iterator it = tasks_.begin(); it != tasks_.end();) {
+    if (ids.contains(it->id)) {
+      moved[it->id] = *it;
+      it = tasks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (int i = ids.count() - 1; i >= 0; --i) {
+    if (moved.contains(ids[i])) tasks_.prepend(moved.take(ids[i]));
+  }
+}
+
 quint64 AlbumCoverLoader::LoadImageAsync(const AlbumCoverLoaderOptions& options,
                                          const QString& art_automatic,
                                          const QString& art_manual,
@@ -94,7 +137,8 @@ quint64 AlbumCoverLoader::LoadImageAsync(const AlbumCoverLoaderOptions& options,
 }
 
 void AlbumCoverLoader::ProcessTasks() {
-  while (!stop_requested_) {
+  while (!stop_requested_ &&
+         active_local_tasks_ < decode_pool_.maxThreadCount()) {
     // Get the next task
     Task task;
     {
@@ -108,21 +152,64 @@ void AlbumCoverLoader::ProcessTasks() {
 }
 
 void AlbumCoverLoader::ProcessTask(Task* task) {
-  TryLoadResult result = TryLoadImage(*task);
-  if (result.started_async) {
+  if (IsRemote(TaskFilename(*task)) && task->embedded_image.isNull()) {
     // The image is being loaded from a remote URL, we'll carry on later
     // when it's done
+    StartRemoteFetch(*task);
     return;
   }
 
+  ++active_local_tasks_;
+  QFuture<LocalLoadResult> future =
+      QtConcurrent::run(&decode_pool_, &AlbumCoverLoader::LoadLocal,
+                        &scaled_cache_, *task);
+  NewClosure(future, this, SLOT(LocalLoadFinished(QFuture<LocalLoadResult>)),
+             future);
+}
+
+void AlbumCoverLoader::LocalLoadFinished(QFuture<LocalLoadResult> future) {
+  --active_local_tasks_;
+
+  LocalLoadResult result = future.result();
   if (result.loaded_success) {
-    QImage scaled = ScaleAndPad(task->options, result.image);
-    emit ImageLoaded(task->id, scaled);
-    emit ImageLoaded(task->id, scaled, result.image);
-    return;
+    emit ImageLoaded(result.task.id, result.scaled);
+    emit ImageLoaded(result.task.id, result.scaled, result.original);
+  } else if (result.needs_remote) {
+    StartRemoteFetch(result.task);
+  } else {
+    NextState(&result.task);
+  }
+
+  ProcessTasks();
+}
+
+AlbumCoverLoader::LocalLoadResult AlbumCoverLoader::LoadLocal(
+    ScaledCoverCache* cache, Task task) {
+  LocalLoadResult ret;
+  ret.needs_remote = false;
+  ret.loaded_success = false;
+
+  forever {
+    const TryLoadResult result = TryLoadImage(cache, task);
+    if (result.is_remote) {
+      ret.needs_remote = true;
+      break;
+    }
+
+    if (result.loaded_success) {
+      ret.loaded_success = true;
+      ret.scaled = ScaleAndPad(task.options, result.image);
+      ret.original = result.image;
+      break;
+    }
+
+    // Try the automatic one next, the default image is up to NextState.
+    if (task.state != State_TryingManual) break;
+    task.state = State_TryingAuto;
   }
 
-  NextState(task);
+  ret.task = task;
+  return ret;
 }
 
 void AlbumCoverLoader::NextState(Task* task) {
@@ -138,44 +225,71 @@ void AlbumCoverLoader::NextState(Task* task) {
   }
 }
 
+QString AlbumCoverLoader::TaskFilename(const Task& task) {
+  switch (task.state) {
+    case State_TryingAuto:
+      return task.art_automatic;
+    case State_TryingManual:
+      return task.art_manual;
+  }
+  return QString();
+}
+
+bool AlbumCoverLoader::IsRemote(const QString& filename) {
+  return filename.toLower().startsWith("http://") ||
+         filename.toLower().startsWith("https://");
+}
+
 AlbumCoverLoader::TryLoadResult AlbumCoverLoader::TryLoadImage(
-    const Task& task) {
+    ScaledCoverCache* cache, const Task& task) {
   // An image embedded in the song itself takes priority
   if (!task.embedded_image.isNull())
     return TryLoadResult(false, true,
                          ScaleAndPad(task.options, task.embedded_image));
 
-  QString filename;
-  switch (task.state) {
-    case State_TryingAuto:
-      filename = task.art_automatic;
-      break;
-    case State_TryingManual:
-      filename = task.art_manual;
-      break;
-  }
+  const QString filename = TaskFilename(task);
 
   if (filename == Song::kManuallyUnsetCover)
     return TryLoadResult(false, true, task.options.default_output_image_);
 
-  if (filename == Song::kEmbeddedCover && !task.song_filename.isEmpty()) {
+  const bool embedded = filename == Song::kEmbeddedCover;
+
+  // Small covers come from the cache if anything has wanted this one at about
+  // this size before.
+  const int cached_size = CachedSize(task.options);
+  QString cache_key;
+  if (cached_size && !IsRemote(filename)) {
+    cache_key = ScaledCoverCache::SourceKey(
+        embedded ? task.song_filename : filename, embedded);
+  }
+  if (!cache_key.isEmpty()) {
+    const QImage image = cache->Get(cache_key, cached_size);
+    if (!image.isNull()) return TryLoadResult(false, true, image);
+  }
+
+  if (embedded && !task.song_filename.isEmpty()) {
     const QImage taglib_image =
         TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
             task.song_filename);
 
-    if (!taglib_image.isNull())
+    if (!taglib_image.isNull()) {
+      if (!cache_key.isEmpty()) {
+        const QImage image =
+            taglib_image.width() > cached_size ||
+                    taglib_image.height() > cached_size
+                ? taglib_image.scaled(cached_size, cached_size,
+                                      Qt::KeepAspectRatio,
+                                      Qt::SmoothTransformation)
+                : taglib_image;
+        cache->Put(cache_key, cached_size, image);
+        return TryLoadResult(false, true, image);
+      }
       return TryLoadResult(false, true,
                            ScaleAndPad(task.options, taglib_image));
+    }
   }
 
-  if (filename.toLower().startsWith("http://") ||
-      filename.toLower().startsWith("https://")) {
-    QUrl url(filename);
-    QNetworkReply* reply = network_->get(QNetworkRequest(url));
-    NewClosure(reply, SIGNAL(finished()), this,
-               SLOT(RemoteFetchFinished(QNetworkReply*)), reply);
-
-    remote_tasks_.insert(reply, task);
+  if (IsRemote(filename)) {
     return TryLoadResult(true, false, QImage());
   } else if (filename.isEmpty()) {
     // Avoid "QFSFileEngine::open: No file name specified" messages if we know
@@ -183,12 +297,49 @@ AlbumCoverLoader::TryLoadResult AlbumCoverLoader::TryLoadImage(
     return TryLoadResult(false, false, task.options.default_output_image_);
   }
 
-  QImage image(filename);
+  int max_size = cached_size;
+  if (!max_size && task.options.scale_output_image_ &&
+      !task.options.keep_original_image_) {
+    max_size = task.options.desired_height_;
+  }
+
+  QImage image = ReadImage(filename, max_size);
+  if (!cache_key.isEmpty()) cache->Put(cache_key, cached_size, image);
   return TryLoadResult(
       false, !image.isNull(),
       image.isNull() ? task.options.default_output_image_ : image);
 }
 
+int AlbumCoverLoader::CachedSize(const AlbumCoverLoaderOptions& options) {
+  if (!options.scale_output_image_ || options.keep_original_image_) return 0;
+  return ScaledCoverCache::StandardSize(options.desired_height_);
+}
+
+QImage AlbumCoverLoader::ReadImage(const QString& filename, int max_size) {
+  QImageReader reader(filename);
+
+  // Decoding a big JPEG straight to thumbnail size is many times quicker
+  // than decoding all of it and scaling it down afterwards.
+  if (max_size) {
+    QSize size = reader.size();
+    if (size.width() > max_size || size.height() > max_size) {
+      size.scale(max_size, max_size, Qt::KeepAspectRatio);
+      reader.setScaledSize(size);
+    }
+  }
+
+  return reader.read();
+}
+
+void AlbumCoverLoader::StartRemoteFetch(const Task& task) {
+  QUrl url(TaskFilename(task));
+  QNetworkReply* reply = network_->get(QNetworkRequest(url));
+  NewClosure(reply, SIGNAL(finished()), this,
+             SLOT(RemoteFetchFinished(QNetworkReply*)), reply);
+
+  remote_tasks_.insert(reply, task);
+}
+
 void AlbumCoverLoader::RemoteFetchFinished(QNetworkReply* reply) {
   reply->deleteLater();
 
@@ -21,17 +21,21 @@
 #ifndef COVERS_ALBUMCOVERLOADER_H_
 #define COVERS_ALBUMCOVERLOADER_H_
 
+#include <QFuture>
 #include <QImage>
 #include <QMutex>
 #include <QObject>
 #include <QQueue>
+#include <QThreadPool>
 #include <QUrl>
 
 #include "albumcoverloaderoptions.h"
 #include "config.h"
 #include "core/song.h"
+#include "scaledcovercache.h"
 
 class NetworkAccessManager;
+class MemoryBudget;
 class QNetworkReply;
 
 class AlbumCoverLoader : public QObject {
@@ -39,11 +43,17 @@ class AlbumCoverLoader : public QObject {
 
  public:
   explicit AlbumCoverLoader(QObject* parent = nullptr);
+  ~AlbumCoverLoader();
+
+  static const int kMaxDecodeThreads;
 
   void Stop() { stop_requested_ = true; }
 
   static QString ImageCacheDir();
 
+  // Lets budget shrink the covers kept in memory.
+  void RegisterWithBudget(MemoryBudget* budget);
+
   quint64 LoadImageAsync(const AlbumCoverLoaderOptions& options,
                          const Song& song);
   virtual quint64 LoadImageAsync(const AlbumCoverLoaderOptions& options,
@@ -55,6 +65,11 @@ class AlbumCoverLoader : public QObject {
   void CancelTask(quint64 id);
   void CancelTasks(const QSet<quint64>& ids);
 
+  // Moves any of these tasks that haven't started yet to the front of the
+  // queue, in the order they're given.  Use it for the covers that are on
+  // screen.
+  void PrioritiseTasks(const QList<quint64>& ids);
+
   static QPixmap TryLoadPixmap(const QString& automatic, const QString& manual,
                                const QString& filename = QString());
   static QImage ScaleAndPad(const AlbumCoverLoaderOptions& options,
@@ -62,6 +77,7 @@ class AlbumCoverLoader : public QObject {
 
  signals:
   void ImageLoaded(quint64 id, const QImage& image);
+  // original is only the full size image if the options asked to keep it.
   void ImageLoaded(quint64 id, const QImage& scaled, const QImage& original);
 
  protected slots:
@@ -89,20 +105,54 @@ class AlbumCoverLoader : public QObject {
   };
 
   struct TryLoadResult {
-    TryLoadResult(bool async, bool success, const QImage& i)
-        : started_async(async), loaded_success(success), image(i) {}
+    TryLoadResult(bool remote, bool success, const QImage& i)
+        : is_remote(remote), loaded_success(success), image(i) {}
 
-    bool started_async;
+    bool is_remote;
     bool loaded_success;
     QImage image;
   };
 
+  struct LocalLoadResult {
+    // The task's state is where it got to.
+    Task task;
+    bool needs_remote;
+    bool loaded_success;
+    QImage scaled;
+    QImage original;
+  };
+
+ protected slots:
+  void LocalLoadFinished(QFuture<LocalLoadResult> future);
+
+ protected:
   void ProcessTask(Task* task);
   void NextState(Task* task);
-  TryLoadResult TryLoadImage(const Task& task);
+  void StartRemoteFetch(const Task& task);
+
+  // These run in the decode pool.
+  static LocalLoadResult LoadLocal(ScaledCoverCache* cache, Task task);
+  static TryLoadResult TryLoadImage(ScaledCoverCache* cache, const Task& task);
+  static QImage ReadImage(const QString& filename, int max_size);
+
+  // The size of the cached cover to use for these options, or 0 if the cover
+  // shouldn't come from the cache.
+  static int CachedSize(const AlbumCoverLoaderOptions& options);
+
+  static QString TaskFilename(const Task& task);
+  static bool IsRemote(const QString& filename);
 
   bool stop_requested_;
 
+  // Files are read and decoded here, a few at a time, so the queue can still
+  // be reordered and cancelled.
+  QThreadPool decode_pool_;
+  int active_local_tasks_;
+
+  ScaledCoverCache scaled_cache_;
+  MemoryBudget* budget_;
+  int budget_id_;
+
   QMutex mutex_;
   QQueue<Task> tasks_;
   QMap<QNetworkReply*, Task> remote_tasks_;
@@ -26,11 +26,15 @@ struct AlbumCoverLoaderOptions {
   AlbumCoverLoaderOptions()
       : desired_height_(120),
         scale_output_image_(true),
-        pad_output_image_(true) {}
+        pad_output_image_(true),
+        keep_original_image_(false) {}
 
   int desired_height_;
   bool scale_output_image_;
   bool pad_output_image_;
+  // Otherwise images that are going to be scaled down are decoded straight
+  // to the smaller size.
+  bool keep_original_image_;
   QImage default_output_image_;
 };
 
@@ -19,10 +19,14 @@
 
 #include "coverexportrunnable.h"
 
+#include <QBuffer>
 #include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
 #include <QUrl>
 
 #include "albumcoverexporter.h"
+#include "core/fasthash.h"
 #include "core/song.h"
 #include "core/tagreaderclient.h"
 
@@ -74,37 +78,39 @@ void CoverExportRunnable::ProcessAndExportCover() {
 
   // either embedded or disk - the one we'll export for the current album
   QImage cover;
+  QSize cover_size;
 
-  QImage embedded_cover;
-  QImage disk_cover;
+  // A file cover that isn't resized is copied as it is, so all that's needed
+  // is its size.
+  bool copy_file = false;
 
-  // load embedded cover if any
   if (song_.has_embedded_cover()) {
-    embedded_cover = TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
-        song_.url().toLocalFile());
-
-    if (embedded_cover.isNull()) {
-      EmitCoverSkipped();
-      return;
-    }
-    cover = embedded_cover;
+    cover = TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
+        song_.url().toLocalFile(), TagReaderClient::Priority_Background);
+  } else if (!dialog_result_.IsSizeForced()) {
+    cover_size = QImageReader(cover_path).size();
+    copy_file = true;
+  } else {
+    // load a file cover which iss mandatory if there's no embedded cover
+    cover.load(cover_path);
   }
 
-  // load a file cover which iss mandatory if there's no embedded cover
-  disk_cover.load(cover_path);
-
-  if (embedded_cover.isNull()) {
-    if (disk_cover.isNull()) {
+  if (!copy_file) {
+    if (cover.isNull()) {
       EmitCoverSkipped();
       return;
     }
-    cover = disk_cover;
-  }
 
-  // rescale if necessary
-  if (dialog_result_.IsSizeForced()) {
-    cover = cover.scaled(QSize(dialog_result_.width_, dialog_result_.height_),
-                         Qt::IgnoreAspectRatio);
+    // rescale if necessary
+    if (dialog_result_.IsSizeForced()) {
+      cover =
+          cover.scaled(QSize(dialog_result_.width_, dialog_result_.height_),
+                       Qt::IgnoreAspectRatio);
+    }
+    cover_size = cover.size();
+  } else if (!cover_size.isValid()) {
+    EmitCoverSkipped();
+    return;
   }
 
   QString dir = song_.url().toLocalFile().section('/', 0, -2);
@@ -125,14 +131,13 @@ void CoverExportRunnable::ProcessAndExportCover() {
   if (QFile::exists(new_file) &&
       dialog_result_.overwrite_ != AlbumCoverExport::OverwriteMode_None) {
     // if the mode is "overwrite smaller" then skip the cover if a bigger one
-    // is already available in the folder
+    // is already available in the folder.  Only the header of the existing
+    // one needs reading for that.
     if (dialog_result_.overwrite_ == AlbumCoverExport::OverwriteMode_Smaller) {
-      QImage existing;
-      existing.load(new_file);
+      const QSize existing = QImageReader(new_file).size();
 
-      if (existing.isNull() ||
-          existing.size().height() >= cover.size().height() ||
-          existing.size().width() >= cover.size().width()) {
+      if (!existing.isValid() || existing.height() >= cover_size.height() ||
+          existing.width() >= cover_size.width()) {
         EmitCoverSkipped();
         return;
       }
@@ -144,7 +149,9 @@ void CoverExportRunnable::ProcessAndExportCover() {
     }
   }
 
-  if (cover.save(new_file)) {
+  const bool saved =
+      copy_file ? QFile::copy(cover_path, new_file) : cover.save(new_file);
+  if (saved) {
     EmitCoverExported();
   } else {
     EmitCoverSkipped();
@@ -168,10 +175,39 @@ void CoverExportRunnable::ExportCover() {
     return;
   }
 
-  // we're handling overwrite as remove + copy so we need to delete the old file
-  // first
-  if (dialog_result_.overwrite_ != AlbumCoverExport::OverwriteMode_None &&
-      QFile::exists(new_file)) {
+  // The embedded cover is written out as it is in the tag if it's a JPEG
+  // already, otherwise it has to be converted.
+  QByteArray embedded_data;
+  if (cover_path == Song::kEmbeddedCover) {
+    embedded_data = TagReaderClient::Instance()->LoadEmbeddedArtDataBlocking(
+        song_.url().toLocalFile(), TagReaderClient::Priority_Background);
+    if (embedded_data.isEmpty()) {
+      EmitCoverSkipped();
+      return;
+    }
+    if (!embedded_data.startsWith("\xff\xd8\xff")) {
+      QImage image;
+      QBuffer buffer(&embedded_data);
+      if (!image.loadFromData(embedded_data) ||
+          !buffer.open(QIODevice::WriteOnly) || !image.save(&buffer, "JPG")) {
+        EmitCoverSkipped();
+        return;
+      }
+    }
+  }
+
+  if (QFile::exists(new_file)) {
+    // Exporting the same covers again shouldn't have to write them all out
+    // again.
+    if (cover_path == Song::kEmbeddedCover
+            ? SameContents(new_file, embedded_data)
+            : SameContents(new_file, cover_path)) {
+      EmitCoverSkipped();
+      return;
+    }
+
+    // we're handling overwrite as remove + copy so we need to delete the old
+    // file first
     if (!QFile::remove(new_file)) {
       EmitCoverSkipped();
       return;
@@ -180,9 +216,10 @@ void CoverExportRunnable::ExportCover() {
 
   if (cover_path == Song::kEmbeddedCover) {
     // an embedded cover
-    QImage embedded = TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
-        song_.url().toLocalFile());
-    if (!embedded.save(new_file)) {
+    QFile file(new_file);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(embedded_data) != embedded_data.size()) {
+      file.remove();
       EmitCoverSkipped();
       return;
     }
@@ -196,6 +233,27 @@ void CoverExportRunnable::ExportCover() {
   EmitCoverExported();
 }
 
+bool CoverExportRunnable::SameContents(const QString& filename,
+                                       const QString& other_filename) {
+  // Files of different sizes can't be the same, and the size is much cheaper
+  // to find out than the hash on a network share.
+  if (QFileInfo(filename).size() != QFileInfo(other_filename).size()) {
+    return false;
+  }
+
+  QFile file(filename);
+  QFile other_file(other_filename);
+  return FastHash::Hash(&file) == FastHash::Hash(&other_file);
+}
+
+bool CoverExportRunnable::SameContents(const QString& filename,
+                                       const QByteArray& data) {
+  if (QFileInfo(filename).size() != data.size()) return false;
+
+  QFile file(filename);
+  return FastHash::Hash(&file) == FastHash::Hash(data);
+}
+
 void CoverExportRunnable::EmitCoverExported() { emit CoverExported(); }
 
 void CoverExportRunnable::EmitCoverSkipped() { emit CoverSkipped(); }
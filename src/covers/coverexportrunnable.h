@@ -50,6 +50,11 @@ class CoverExportRunnable : public QObject, public QRunnable {
   void ExportCover();
   QString GetCoverPath();
 
+  // Whether filename has the same contents as other_filename, or data.
+  static bool SameContents(const QString& filename,
+                           const QString& other_filename);
+  static bool SameContents(const QString& filename, const QByteArray& data);
+
   AlbumCoverExport::DialogResult dialog_result_;
   Song song_;
   AlbumCoverExporter* album_cover_exporter_;
@@ -20,11 +20,32 @@
 
 #include "coverproviders.h"
 
+#include <QSettings>
+#include <algorithm>
+
 #include "config.h"
 #include "core/logging.h"
 #include "coverprovider.h"
 
-CoverProviders::CoverProviders(QObject* parent) : QObject(parent) {}
+const char* CoverProviders::kSettingsGroup = "CoverProviders";
+
+namespace {
+
+// Once a provider has been searched this many times its counts are halved,
+// so it can win back its place if it changes.
+const int kMaxHistory = 200;
+
+// What a provider is assumed to take before it has answered anything.
+const int kDefaultMsec = 1000;
+
+}  // namespace
+
+CoverProviders::CoverProviders(QObject* parent)
+    : QObject(parent), history_loaded_(false) {}
+
+CoverProviders::~CoverProviders() {
+  if (history_loaded_) SaveHistory();
+}
 
 void CoverProviders::AddProvider(CoverProvider* provider) {
   {
@@ -62,3 +83,85 @@ void CoverProviders::ProviderDestroyed() {
 }
 
 int CoverProviders::NextId() { return next_id_.fetchAndAddRelaxed(1); }
+
+double CoverProviders::History::Score() const {
+  // How often the provider found anything and how often its cover was the
+  // one used, starting from a half so new providers get tried, over how slow
+  // it is.
+  const double accuracy = (found_ + chosen_ + 1.0) / (2.0 * searches_ + 2.0);
+  const double msec =
+      searches_ ? double(total_msec_) / searches_ : kDefaultMsec;
+  return accuracy / (1.0 + msec / 1000.0);
+}
+
+QList<CoverProvider*> CoverProviders::ListByHistory() const {
+  QMutexLocker locker(&mutex_);
+
+  QList<CoverProvider*> ret = cover_providers_.keys();
+  std::stable_sort(ret.begin(), ret.end(),
+                   [this](CoverProvider* a, CoverProvider* b) {
+                     return history_.value(cover_providers_[a]).Score() >
+                            history_.value(cover_providers_[b]).Score();
+                   });
+  return ret;
+}
+
+void CoverProviders::ProviderSearched(const QString& name, int msec,
+                                      bool found) {
+  QMutexLocker locker(&mutex_);
+
+  History& history = history_[name];
+  if (history.searches_ >= kMaxHistory) {
+    history.searches_ /= 2;
+    history.found_ /= 2;
+    history.chosen_ /= 2;
+    history.total_msec_ /= 2;
+  }
+
+  history.searches_++;
+  history.total_msec_ += msec;
+  if (found) history.found_++;
+}
+
+void CoverProviders::ProviderChosen(const QString& name) {
+  QMutexLocker locker(&mutex_);
+  history_[name].chosen_++;
+}
+
+void CoverProviders::LoadHistory() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+
+  QMutexLocker locker(&mutex_);
+  const int count = s.beginReadArray("history");
+  for (int i = 0; i < count; ++i) {
+    s.setArrayIndex(i);
+
+    History& history = history_[s.value("name").toString()];
+    history.searches_ = s.value("searches").toInt();
+    history.found_ = s.value("found").toInt();
+    history.chosen_ = s.value("chosen").toInt();
+    history.total_msec_ = s.value("total_msec").toLongLong();
+  }
+  s.endArray();
+
+  history_loaded_ = true;
+}
+
+void CoverProviders::SaveHistory() const {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+
+  QMutexLocker locker(&mutex_);
+  s.beginWriteArray("history", history_.count());
+  int i = 0;
+  for (auto it = history_.constBegin(); it != history_.constEnd(); ++it) {
+    s.setArrayIndex(i++);
+    s.setValue("name", it.key());
+    s.setValue("searches", it.value().searches_);
+    s.setValue("found", it.value().found_);
+    s.setValue("chosen", it.value().chosen_);
+    s.setValue("total_msec", it.value().total_msec_);
+  }
+  s.endArray();
+}
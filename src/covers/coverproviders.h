@@ -21,6 +21,7 @@
 #ifndef COVERS_COVERPROVIDERS_H_
 #define COVERS_COVERPROVIDERS_H_
 
+#include <QList>
 #include <QMap>
 #include <QMutex>
 #include <QObject>
@@ -36,6 +37,9 @@ class CoverProviders : public QObject {
 
  public:
   explicit CoverProviders(QObject* parent = nullptr);
+  ~CoverProviders();
+
+  static const char* kSettingsGroup;
 
   // Lets a cover provider register itself in the repository.
   void AddProvider(CoverProvider* provider);
@@ -49,14 +53,41 @@ class CoverProviders : public QObject {
 
   int NextId();
 
+  // Providers that have been quick to find the covers that were used come
+  // first.  Ones that haven't been tried yet go in the middle.
+  QList<CoverProvider*> ListByHistory() const;
+
+  // Searches report back here to build the history.  found is whether the
+  // provider returned any results, msec how long it took to answer.
+  void ProviderSearched(const QString& name, int msec, bool found);
+  void ProviderChosen(const QString& name);
+
+  // Restores the history from the settings, and saves it when this is deleted.
+  void LoadHistory();
+
  private slots:
   void ProviderDestroyed();
 
  private:
   Q_DISABLE_COPY(CoverProviders)
 
+  struct History {
+    History() : searches_(0), found_(0), chosen_(0), total_msec_(0) {}
+
+    double Score() const;
+
+    int searches_;
+    int found_;
+    int chosen_;
+    qint64 total_msec_;
+  };
+
+  void SaveHistory() const;
+
   QMap<CoverProvider*, QString> cover_providers_;
-  QMutex mutex_;
+  QMap<QString, History> history_;
+  bool history_loaded_;
+  mutable QMutex mutex_;
 
   QAtomicInt next_id_;
 };
@@ -32,13 +32,20 @@ CurrentArtLoader::CurrentArtLoader(Application* app, QObject* parent)
     : QObject(parent),
       app_(app),
       temp_file_pattern_(QDir::tempPath() + "/clementine-art-XXXXXX.jpg"),
-      id_(0) {
+      id_(0),
+      thumbnail_id_(0) {
   options_.scale_output_image_ = false;
   options_.pad_output_image_ = false;
   QIcon nocover = IconLoader::Load("nocover", IconLoader::Other);
   options_.default_output_image_ =
       nocover.pixmap(nocover.availableSizes().last()).toImage();
 
+  // The thumbnail is loaded separately so it's scaled in the loader, and
+  // usually comes out of its cache.
+  thumbnail_options_.desired_height_ = 120;
+  thumbnail_options_.pad_output_image_ = false;
+  thumbnail_options_.default_output_image_ = options_.default_output_image_;
+
   connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
           SLOT(TempArtLoaded(quint64, QImage)));
 
@@ -51,34 +58,38 @@ CurrentArtLoader::~CurrentArtLoader() {}
 void CurrentArtLoader::LoadArt(const Song& song) {
   last_song_ = song;
   id_ = app_->album_cover_loader()->LoadImageAsync(options_, last_song_);
+  thumbnail_id_ = app_->album_cover_loader()->LoadImageAsync(
+      thumbnail_options_, last_song_);
 }
 
 void CurrentArtLoader::TempArtLoaded(quint64 id, const QImage& image) {
-  if (id != id_) return;
-  id_ = 0;
-
-  QString uri;
-  QString thumbnail_uri;
-  QImage thumbnail;
-
-  if (image != options_.default_output_image_) {
-    temp_art_.reset(new QTemporaryFile(temp_file_pattern_));
-    temp_art_->setAutoRemove(true);
-    temp_art_->open();
-    image.save(temp_art_->fileName(), "JPEG");
-
-    // Scale the image down to make a thumbnail.  It's a bit crap doing it here
-    // since it's the GUI thread, but the alternative is hard.
-    temp_art_thumbnail_.reset(new QTemporaryFile(temp_file_pattern_));
-    temp_art_thumbnail_->open();
-    temp_art_thumbnail_->setAutoRemove(true);
-    thumbnail = image.scaledToHeight(120, Qt::SmoothTransformation);
-    thumbnail.save(temp_art_thumbnail_->fileName(), "JPEG");
-
-    uri = "file://" + temp_art_->fileName();
-    thumbnail_uri = "file://" + temp_art_thumbnail_->fileName();
+  if (id == id_) {
+    id_ = 0;
+
+    QString uri;
+    if (image != options_.default_output_image_) {
+      temp_art_.reset(new QTemporaryFile(temp_file_pattern_));
+      temp_art_->setAutoRemove(true);
+      temp_art_->open();
+      image.save(temp_art_->fileName(), "JPEG");
+      uri = "file://" + temp_art_->fileName();
+    }
+
+    emit ArtLoaded(last_song_, uri, image);
+  } else if (id == thumbnail_id_) {
+    thumbnail_id_ = 0;
+
+    QString thumbnail_uri;
+    QImage thumbnail;
+    if (image != thumbnail_options_.default_output_image_) {
+      temp_art_thumbnail_.reset(new QTemporaryFile(temp_file_pattern_));
+      temp_art_thumbnail_->open();
+      temp_art_thumbnail_->setAutoRemove(true);
+      thumbnail = image;
+      thumbnail.save(temp_art_thumbnail_->fileName(), "JPEG");
+      thumbnail_uri = "file://" + temp_art_thumbnail_->fileName();
+    }
+
+    emit ThumbnailLoaded(last_song_, thumbnail_uri, thumbnail);
   }
-
-  emit ArtLoaded(last_song_, uri, image);
-  emit ThumbnailLoaded(last_song_, thumbnail_uri, thumbnail);
 }
@@ -55,12 +55,14 @@ class CurrentArtLoader : public QObject {
  private:
   Application* app_;
   AlbumCoverLoaderOptions options_;
+  AlbumCoverLoaderOptions thumbnail_options_;
 
   QString temp_file_pattern_;
 
   std::unique_ptr<QTemporaryFile> temp_art_;
   std::unique_ptr<QTemporaryFile> temp_art_thumbnail_;
   quint64 id_;
+  quint64 thumbnail_id_;
 
   Song last_song_;
 };
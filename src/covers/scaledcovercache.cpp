@@ -0,0 +1,155 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scaledcovercache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <limits>
+
+#include "core/executor.h"
+#include "core/fasthash.h"
+#include "core/metrics.h"
+
+const int ScaledCoverCache::kMemoryBytes = 16 * 1024 * 1024;
+
+namespace {
+
+// Roughly what the library, the playlist, the cover manager and the now
+// playing widget ask for.
+const int kStandardSizes[] = {32, 64, 128, 512};
+
+// Written once the files named with the SHA-1s that used to be the keys have
+// been cleared out.
+const char* kKeysMarker = "fasthash";
+
+}  // namespace
+
+ScaledCoverCache::ScaledCoverCache(const QString& directory)
+    : directory_(directory), memory_(kMemoryBytes) {
+  QDir().mkpath(directory_);
+
+  const QString marker = directory_ + "/" + kKeysMarker;
+  if (!QFile::exists(marker)) {
+    Executor::Io()->Run<void>([directory, marker]() {
+      QDir dir(directory);
+      for (const QString& name : dir.entryList(QDir::Files)) {
+        // 40 hex digits then the size, the new keys have 32.
+        if (name.indexOf('-') == 40) QFile::remove(dir.filePath(name));
+      }
+      QFile(marker).open(QIODevice::WriteOnly);
+    });
+  }
+}
+
+int ScaledCoverCache::StandardSize(int size) {
+  for (int standard_size : kStandardSizes) {
+    if (size <= standard_size) return standard_size;
+  }
+  return 0;
+}
+
+QString ScaledCoverCache::SourceKey(const QString& filename, bool embedded) {
+  const QFileInfo info(filename);
+  if (!info.exists()) return QString();
+
+  // A cover that's changed since gets a new key, so there's no need to ever
+  // look at the cached one again.
+  const QString source = QString("%1\n%2\n%3\n%4")
+                             .arg(info.absoluteFilePath())
+                             .arg(embedded)
+                             .arg(info.lastModified().toMSecsSinceEpoch())
+                             .arg(info.size());
+  return FastHash::Hash(source.toUtf8()).toHex();
+}
+
+QString ScaledCoverCache::Filename(const QString& source_key,
+                                   int standard_size) const {
+  return QString("%1/%2-%3").arg(directory_, source_key).arg(standard_size);
+}
+
+QString ScaledCoverCache::MemoryKey(const QString& source_key,
+                                    int standard_size) {
+  return source_key + "-" + QString::number(standard_size);
+}
+
+QImage ScaledCoverCache::Get(const QString& source_key, int standard_size) {
+  static metrics::Counter* memory_hits = metrics::GetCounter(
+      "clementine_scaled_covers_memory_hits_total",
+      "Scaled covers found in memory");
+  static metrics::Counter* disk_hits = metrics::GetCounter(
+      "clementine_scaled_covers_disk_hits_total",
+      "Scaled covers read back from disk");
+  static metrics::Counter* misses = metrics::GetCounter(
+      "clementine_scaled_covers_misses_total",
+      "Scaled covers that had to be made from the original");
+
+  const QString key = MemoryKey(source_key, standard_size);
+  {
+    QMutexLocker l(&mutex_);
+    if (QImage* image = memory_.object(key)) {
+      memory_hits->Increment();
+      return *image;
+    }
+  }
+
+  QImageReader reader(Filename(source_key, standard_size));
+  QImage image = reader.read();
+  if (image.isNull()) {
+    misses->Increment();
+    return image;
+  }
+  disk_hits->Increment();
+
+  QMutexLocker l(&mutex_);
+  memory_.insert(key, new QImage(image), image.byteCount());
+  return image;
+}
+
+qint64 ScaledCoverCache::memory_used() {
+  QMutexLocker l(&mutex_);
+  return memory_.totalCost();
+}
+
+void ScaledCoverCache::set_memory_limit(qint64 bytes) {
+  QMutexLocker l(&mutex_);
+  memory_.setMaxCost(qMin<qint64>(bytes, std::numeric_limits<int>::max()));
+}
+
+void ScaledCoverCache::Put(const QString& source_key, int standard_size,
+                           const QImage& image) {
+  if (image.isNull()) return;
+
+  {
+    QMutexLocker l(&mutex_);
+    memory_.insert(MemoryKey(source_key, standard_size), new QImage(image),
+                   image.byteCount());
+  }
+
+  // Covers are mostly photos, but keep the ones with transparency lossless.
+  // The reader works out which it is when it's read back.
+  const QString filename = Filename(source_key, standard_size);
+  if (image.hasAlphaChannel()) {
+    image.save(filename, "PNG");
+  } else {
+    image.save(filename, "JPG", 90);
+  }
+}
@@ -0,0 +1,63 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COVERS_SCALEDCOVERCACHE_H_
+#define COVERS_SCALEDCOVERCACHE_H_
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+// Keeps covers scaled down to a few standard sizes, in memory and on disk, so
+// views that want a small cover don't each decode the original again.  A
+// cover is only kept at standard sizes, the request is served from the
+// smallest one that's at least as big and the caller scales it the rest of
+// the way.  The class is thread safe.
+class ScaledCoverCache {
+ public:
+  explicit ScaledCoverCache(const QString& directory);
+
+  static const int kMemoryBytes;
+
+  // Returns the standard size to use for covers of size, or 0 if size is
+  // bigger than all of them.
+  static int StandardSize(int size);
+
+  // Identifies the cover in filename, or the cover embedded in it, as it is
+  // now.  Returns an empty string if the file doesn't exist.
+  static QString SourceKey(const QString& filename, bool embedded);
+
+  // Returns a null image if the cover hasn't been cached at this size.
+  QImage Get(const QString& source_key, int standard_size);
+  void Put(const QString& source_key, int standard_size, const QImage& image);
+
+  // How many bytes of covers are held in memory, and the most that can be.
+  qint64 memory_used();
+  void set_memory_limit(qint64 bytes);
+
+ private:
+  QString Filename(const QString& source_key, int standard_size) const;
+  static QString MemoryKey(const QString& source_key, int standard_size);
+
+  const QString directory_;
+
+  QMutex mutex_;
+  QCache<QString, QImage> memory_;
+};
+
+#endif  // COVERS_SCALEDCOVERCACHE_H_
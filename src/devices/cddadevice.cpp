@@ -19,6 +19,7 @@
 
 #include <QUrl>
 
+#include "core/application.h"
 #include "library/librarybackend.h"
 #include "library/librarymodel.h"
 
@@ -32,6 +33,7 @@ CddaDevice::CddaDevice(const QUrl& url, DeviceLister* lister,
       cdio_(nullptr),
       disc_changed_timer_(),
       cdda_song_loader_(url) {
+  cdda_song_loader_.set_database(app->database());
   connect(&cdda_song_loader_, SIGNAL(SongsUpdated(SongList)), this,
           SLOT(SongsLoaded(SongList)));
   connect(&cdda_song_loader_, SIGNAL(Finished()), this,
@@ -26,9 +26,15 @@
 #include "cddadevice.h"
 #include "core/logging.h"
 #include "core/timeconstants.h"
+#include "musicbrainz/discidcache.h"
 
 CddaSongLoader::CddaSongLoader(const QUrl& url, QObject* parent)
-    : QObject(parent), url_(url), cdda_(nullptr), may_load_(true), disc_() {
+    : QObject(parent),
+      url_(url),
+      db_(nullptr),
+      cdda_(nullptr),
+      may_load_(true),
+      disc_() {
   connect(this, &CddaSongLoader::MusicBrainzDiscIdLoaded, this,
           &CddaSongLoader::LoadAudioCDTags);
   connect(this, &CddaSongLoader::SongsLoaded,
@@ -328,7 +334,19 @@ void CddaSongLoader::LoadSongsFromCdda() {
   gst_object_unref(pipeline);
 }
 
-void CddaSongLoader::LoadAudioCDTags(const QString& musicbrainz_discid) const {
+void CddaSongLoader::LoadAudioCDTags(const QString& musicbrainz_discid) {
+  musicbrainz_discid_ = musicbrainz_discid;
+
+  if (db_) {
+    const DiscIdCache::Entry entry =
+        DiscIdCache(db_).Lookup(musicbrainz_discid);
+    if (entry.is_valid() && !entry.is_stale()) {
+      qLog(Debug) << "Using cached MusicBrainz data for" << musicbrainz_discid;
+      ApplyMusicBrainzResults(entry.artist_, entry.album_, entry.tracks_);
+      return;
+    }
+  }
+
   MusicBrainzClient* musicbrainz_client = new MusicBrainzClient;
   connect(musicbrainz_client,
           SIGNAL(Finished(const QString&, const QString&,
@@ -345,6 +363,27 @@ void CddaSongLoader::ProcessMusicBrainzResponse(
   MusicBrainzClient* musicbrainz_client =
       qobject_cast<MusicBrainzClient*>(sender());
   musicbrainz_client->deleteLater();
+
+  if (db_) {
+    DiscIdCache cache(db_);
+    if (!results.empty()) {
+      cache.Store(musicbrainz_discid_, artist, album, results);
+    } else {
+      // We might be offline, an old answer is better than none.
+      const DiscIdCache::Entry entry = cache.Lookup(musicbrainz_discid_);
+      if (entry.is_valid()) {
+        ApplyMusicBrainzResults(entry.artist_, entry.album_, entry.tracks_);
+        return;
+      }
+    }
+  }
+
+  ApplyMusicBrainzResults(artist, album, results);
+}
+
+void CddaSongLoader::ApplyMusicBrainzResults(
+    const QString& artist, const QString& album,
+    const MusicBrainzClient::ResultList& results) {
   if (results.empty()) {
     // no real update; signal that no further updates will follow now
     emit Finished();
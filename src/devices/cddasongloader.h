@@ -31,6 +31,8 @@
 #include "core/song.h"
 #include "musicbrainz/musicbrainzclient.h"
 
+class Database;
+
 // This class provides a (hopefully) nice, high level interface to get CD
 // information and load tracks
 class CddaSongLoader : public QObject {
@@ -48,6 +50,9 @@ class CddaSongLoader : public QObject {
   void LoadSongs();
   bool IsActive() const;
 
+  // If set, MusicBrainz results are cached there by disc ID.
+  void set_database(Database* db) { db_ = db; }
+
   // The list of currently cached tracks. This gets updated when
   // LoadSongs() is called.
   SongList cached_tracks() const;
@@ -85,9 +90,11 @@ class CddaSongLoader : public QObject {
   void MusicBrainzDiscIdLoaded(const QString& musicbrainz_discid);
 
  private slots:
-  void LoadAudioCDTags(const QString& musicbrainz_discid) const;
+  void LoadAudioCDTags(const QString& musicbrainz_discid);
   void ProcessMusicBrainzResponse(const QString& artist, const QString& album,
                                   const MusicBrainzClient::ResultList& results);
+  void ApplyMusicBrainzResults(const QString& artist, const QString& album,
+                               const MusicBrainzClient::ResultList& results);
   void SetDiscTracks(const SongList& songs, bool has_titles);
 
  private:
@@ -106,11 +113,15 @@ class CddaSongLoader : public QObject {
   };
 
   QUrl url_;
+  Database* db_;
   GstElement* cdda_;
   QFuture<void> loading_future_;
   std::atomic<bool> may_load_;
   Disc disc_;
   mutable QMutex disc_mutex_;
+
+  // The disc ID that's being looked up on MusicBrainz.
+  QString musicbrainz_discid_;
 };
 
 #endif  // CDDASONGLOADER_H
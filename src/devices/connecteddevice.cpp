@@ -63,6 +63,16 @@ ConnectedDevice::ConnectedDevice(const QUrl& url, DeviceLister* lister,
 
 ConnectedDevice::~ConnectedDevice() {}
 
+QString ConnectedDevice::database_stamp() const {
+  // Devices that have just been added have nothing loaded yet.
+  if (first_time_) return QString();
+  return manager_->GetDatabaseStamp(database_id_);
+}
+
+void ConnectedDevice::set_database_stamp(const QString& stamp) {
+  manager_->SetDatabaseStamp(database_id_, stamp);
+}
+
 void ConnectedDevice::InitBackendDirectory(const QString& mount_point,
                                            bool first_time, bool rewrite_path) {
   if (first_time || backend_->GetAllDirectories().isEmpty()) {
@@ -56,6 +56,11 @@ class ConnectedDevice : public QObject,
   QUrl url() const { return url_; }
   int song_count() const { return song_count_; }
 
+  // The state of the device's database that the songs table matches, see
+  // DeviceDatabaseBackend::GetDatabaseStamp.
+  QString database_stamp() const;
+  void set_database_stamp(const QString& stamp);
+
   virtual void FinishCopy(bool success);
   virtual void FinishDelete(bool success);
 
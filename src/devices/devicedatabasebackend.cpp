@@ -143,3 +143,27 @@ void DeviceDatabaseBackend::SetDeviceOptions(int id,
   q.exec();
   db_->CheckErrors(q);
 }
+
+QString DeviceDatabaseBackend::GetDatabaseStamp(int id) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare("SELECT database_stamp FROM devices WHERE ROWID=:id");
+  q.bindValue(":id", id);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return QString();
+  return q.value(0).toString();
+}
+
+void DeviceDatabaseBackend::SetDatabaseStamp(int id, const QString& stamp) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare("UPDATE devices SET database_stamp=:stamp WHERE ROWID=:id");
+  q.bindValue(":stamp", stamp);
+  q.bindValue(":id", id);
+  q.exec();
+  db_->CheckErrors(q);
+}
@@ -59,6 +59,12 @@ class DeviceDatabaseBackend : public QObject {
                         MusicStorage::TranscodeMode mode,
                         Song::FileType format);
 
+  // Identifies the state of the device's own database when its songs table
+  // was last brought up to date, so it doesn't have to be read again if
+  // nothing has changed.  Empty if it's never been loaded.
+  QString GetDatabaseStamp(int id);
+  void SetDatabaseStamp(int id, const QString& stamp);
+
  private:
   Database* db_;
 };
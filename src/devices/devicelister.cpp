@@ -18,17 +18,19 @@
 #include "devicelister.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QThread>
 #include <QtDebug>
 
 #include "config.h"
+#include "core/logging.h"
 
 #ifdef HAVE_LIBGPOD
 #include <gpod/itdb.h>
 #endif
 
-DeviceLister::DeviceLister() : thread_(nullptr) {}
+DeviceLister::DeviceLister() : thread_(nullptr), init_time_msec_(-1) {}
 
 DeviceLister::~DeviceLister() {
   if (thread_) {
@@ -46,7 +48,15 @@ void DeviceLister::Start() {
   thread_->start();
 }
 
-void DeviceLister::ThreadStarted() { Init(); }
+void DeviceLister::ThreadStarted() {
+  QElapsedTimer timer;
+  timer.start();
+  Init();
+
+  init_time_msec_.store(timer.elapsed());
+  qLog(Info) << metaObject()->className() << "initialised in"
+             << init_time_msec_.load() << "ms";
+}
 
 namespace {
 
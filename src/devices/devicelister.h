@@ -19,6 +19,7 @@
 #define DEVICELISTER_H
 
 #include <QAbstractItemModel>
+#include <QAtomicInt>
 #include <QUrl>
 
 class ConnectedDevice;
@@ -39,6 +40,9 @@ class DeviceLister : public QObject {
   // taken from the one with the highest priority.
   virtual int priority() const { return 100; }
 
+  // How long Init took in the lister's thread, or -1 if it hasn't finished.
+  int init_time_msec() const { return init_time_msec_.load(); }
+
   // Query information about the devices that are available.  Must be
   // thread-safe.
   virtual QStringList DeviceUniqueIDs() = 0;
@@ -86,6 +90,9 @@ class DeviceLister : public QObject {
   QThread* thread_;
   int next_mount_request_id_;
 
+ private:
+  QAtomicInt init_time_msec_;
+
  private slots:
   void ThreadStarted();
 };
@@ -72,7 +72,8 @@ DeviceManager::DeviceManager(Application* app, QObject* parent)
     : SimpleTreeModel<DeviceInfo>(new DeviceInfo(this), parent),
       app_(app),
       not_connected_overlay_(
-          IconLoader::Load("edit-delete", IconLoader::Base)) {
+          IconLoader::Load("edit-delete", IconLoader::Base)),
+      listers_started_(false) {
   thread_pool_.setMaxThreadCount(1);
   connect(app_->task_manager(), SIGNAL(TasksChanged()), SLOT(TasksChanged()));
 
@@ -83,6 +84,11 @@ DeviceManager::DeviceManager(Application* app, QObject* parent)
 
   connect(this, SIGNAL(DeviceCreatedFromDb(DeviceInfo*)),
           SLOT(AddDeviceFromDb(DeviceInfo*)));
+  // The listers aren't started until the known devices are in the model, and
+  // the GUI has had a chance to show them.  Some of them wait for D-Bus
+  // services or a CD drive to spin up.
+  connect(this, SIGNAL(AllDevicesLoadedFromDb()), SLOT(StartListers()),
+          Qt::QueuedConnection);
   // This reads from the database and contends on the database mutex, which can
   // be very slow on startup.
   ConcurrentRun::Run<void>(&thread_pool_,
@@ -123,7 +129,7 @@ DeviceManager::DeviceManager(Application* app, QObject* parent)
 
 DeviceManager::~DeviceManager() {
   for (DeviceLister* lister : listers_) {
-    lister->ShutDown();
+    if (listers_started_) lister->ShutDown();
     delete lister;
   }
 
@@ -142,6 +148,15 @@ void DeviceManager::LoadAllDevices() {
     // thread. Send a signal to finish the device addition.
     emit DeviceCreatedFromDb(info);
   }
+  emit AllDevicesLoadedFromDb();
+}
+
+void DeviceManager::StartListers() {
+  if (listers_started_) return;
+  listers_started_ = true;
+
+  // Each lister initialises in a thread of its own.
+  for (DeviceLister* lister : listers_) lister->Start();
 }
 
 void DeviceManager::AddDeviceFromDb(DeviceInfo* info) {
@@ -309,8 +324,6 @@ void DeviceManager::AddLister(DeviceLister* lister) {
           SLOT(PhysicalDeviceRemoved(QString)));
   connect(lister, SIGNAL(DeviceChanged(QString)),
           SLOT(PhysicalDeviceChanged(QString)));
-
-  lister->Start();
 }
 
 DeviceInfo* DeviceManager::FindDeviceById(const QString& id) const {
@@ -705,6 +718,16 @@ void DeviceManager::SetDeviceOptions(QModelIndex idx,
                                mode, format);
 }
 
+QString DeviceManager::GetDatabaseStamp(int database_id) const {
+  if (database_id == -1) return QString();
+  return backend_->GetDatabaseStamp(database_id);
+}
+
+void DeviceManager::SetDatabaseStamp(int database_id, const QString& stamp) {
+  if (database_id == -1) return;
+  backend_->SetDatabaseStamp(database_id, stamp);
+}
+
 void DeviceManager::DeviceTaskStarted(int id) {
   ConnectedDevice* device = qobject_cast<ConnectedDevice*>(sender());
   if (!device) return;
@@ -95,6 +95,10 @@ class DeviceManager : public SimpleTreeModel<DeviceInfo> {
                         MusicStorage::TranscodeMode mode,
                         Song::FileType format);
 
+  // See DeviceDatabaseBackend.  Can be called from any thread.
+  QString GetDatabaseStamp(int database_id) const;
+  void SetDatabaseStamp(int database_id, const QString& stamp);
+
   // QAbstractItemModel
   QVariant data(const QModelIndex& idx, int role = Qt::DisplayRole) const;
 
@@ -105,6 +109,7 @@ class DeviceManager : public SimpleTreeModel<DeviceInfo> {
   void DeviceConnected(QModelIndex idx);
   void DeviceDisconnected(QModelIndex idx);
   void DeviceCreatedFromDb(DeviceInfo* info);
+  void AllDevicesLoadedFromDb();
 
  private slots:
   void PhysicalDeviceAdded(const QString& id);
@@ -116,6 +121,7 @@ class DeviceManager : public SimpleTreeModel<DeviceInfo> {
   void LoadAllDevices();
   void DeviceConnectFinished(const QString& id, bool success);
   void AddDeviceFromDb(DeviceInfo* info);
+  void StartListers();
 
  protected:
   void LazyPopulate(DeviceInfo* item) { LazyPopulate(item, true); }
@@ -138,6 +144,7 @@ class DeviceManager : public SimpleTreeModel<DeviceInfo> {
   QIcon not_connected_overlay_;
 
   QList<DeviceLister*> listers_;
+  bool listers_started_;
   QList<DeviceInfo*> devices_;
 
   QMultiMap<QString, QMetaObject> device_classes_;
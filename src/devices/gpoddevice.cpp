@@ -155,6 +155,10 @@ void GPodDevice::WriteDatabase(bool success) {
       // Update the library model
       if (!songs_to_add_.isEmpty()) backend_->AddOrUpdateSongs(songs_to_add_);
       if (!songs_to_remove_.isEmpty()) backend_->DeleteSongs(songs_to_remove_);
+
+      // The library matches what we've just written, so it doesn't have to
+      // be read again next time.
+      set_database_stamp(GPodLoader::DatabaseStamp(url_.path()));
     }
   }
 
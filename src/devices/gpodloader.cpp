@@ -19,7 +19,9 @@
 
 #include <gpod/itdb.h>
 
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QtDebug>
 
 #include "connecteddevice.h"
@@ -42,10 +44,31 @@ GPodLoader::GPodLoader(const QString& mount_point, TaskManager* task_manager,
 
 GPodLoader::~GPodLoader() {}
 
+QString GPodLoader::DatabaseStamp(const QString& mount_point) {
+  gchar* path = itdb_get_itunesdb_path(
+      QDir::toNativeSeparators(mount_point).toLocal8Bit());
+  if (!path) return QString();
+
+  const QFileInfo info(QString::fromLocal8Bit(path));
+  g_free(path);
+  if (!info.exists()) return QString();
+
+  return QString("%1:%2")
+      .arg(info.lastModified().toMSecsSinceEpoch())
+      .arg(info.size());
+}
+
 void GPodLoader::LoadDatabase() {
   int task_id = task_manager_->StartTask(tr("Loading iPod database"));
   emit TaskStarted(task_id);
 
+  // GPodDevice needs the parsed database to write to it later, so it's always
+  // loaded.  The songs only have to be converted again if it's changed since
+  // the last time.
+  const QString stamp = DatabaseStamp(mount_point_);
+  const bool up_to_date =
+      !stamp.isEmpty() && stamp == device_->database_stamp();
+
   // Load the iTunes database
   GError* error = nullptr;
   Itdb_iTunesDB* db =
@@ -66,6 +89,15 @@ void GPodLoader::LoadDatabase() {
     return;
   }
 
+  if (up_to_date) {
+    qLog(Debug) << "iPod database at" << mount_point_ << "hasn't changed";
+    moveToThread(original_thread_);
+
+    task_manager_->SetTaskFinished(task_id);
+    emit LoadFinished(db);
+    return;
+  }
+
   // Convert all the tracks from libgpod structs into Song classes
   const QString prefix = path_prefix_.isEmpty()
                              ? QDir::fromNativeSeparators(mount_point_)
@@ -83,11 +115,10 @@ void GPodLoader::LoadDatabase() {
     songs << song;
   }
 
-  // Need to remove all the existing songs in the database first
-  backend_->DeleteSongs(backend_->FindSongsInDirectory(1));
-
-  // Add the songs we've just loaded
-  backend_->AddOrUpdateSongs(songs);
+  // The songs from last time stay in the library while this happens, only the
+  // ones that changed are touched.
+  backend_->ReplaceSongsInDirectory(1, songs);
+  device_->set_database_stamp(stamp);
 
   moveToThread(original_thread_);
 
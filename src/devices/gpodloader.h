@@ -41,6 +41,9 @@ class GPodLoader : public QObject {
   void set_music_path_prefix(const QString& prefix) { path_prefix_ = prefix; }
   void set_song_type(Song::FileType type) { type_ = type; }
 
+  // Changes whenever the iTunesDB file on the device is written.
+  static QString DatabaseStamp(const QString& mount_point);
+
  public slots:
   void LoadDatabase();
 
@@ -136,6 +136,11 @@ void MtpDevice::FinishCopy(bool success) {
   if (success) {
     if (!songs_to_add_.isEmpty()) backend_->AddOrUpdateSongs(songs_to_add_);
     if (!songs_to_remove_.isEmpty()) backend_->DeleteSongs(songs_to_remove_);
+
+    // The library matches the device again.
+    if (connection_->is_valid()) {
+      set_database_stamp(MtpLoader::DatabaseStamp(connection_->device()));
+    }
   }
 
   songs_to_add_.clear();
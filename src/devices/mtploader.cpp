@@ -19,7 +19,10 @@
 
 #include <libmtp.h>
 
+#include <QStringList>
+
 #include "connecteddevice.h"
+#include "core/logging.h"
 #include "core/song.h"
 #include "core/taskmanager.h"
 #include "library/librarybackend.h"
@@ -38,6 +41,24 @@ MtpLoader::MtpLoader(const QUrl& url, TaskManager* task_manager,
 
 MtpLoader::~MtpLoader() {}
 
+QString MtpLoader::DatabaseStamp(LIBMTP_mtpdevice_t* device) {
+  if (LIBMTP_Get_Storage(device, LIBMTP_STORAGE_SORTBY_NOTSORTED) != 0) {
+    LIBMTP_Clear_Errorstack(device);
+    return QString();
+  }
+
+  QStringList storages;
+  for (LIBMTP_devicestorage_t* storage = device->storage; storage;
+       storage = storage->next) {
+    storages << QString("%1:%2:%3:%4")
+                    .arg(storage->id)
+                    .arg(storage->MaxCapacity)
+                    .arg(storage->FreeSpaceInBytes)
+                    .arg(storage->FreeSpaceInObjects);
+  }
+  return storages.join(";");
+}
+
 void MtpLoader::LoadDatabase() {
   int task_id = task_manager_->StartTask(tr("Loading MTP device"));
   emit TaskStarted(task_id);
@@ -57,6 +78,12 @@ bool MtpLoader::TryLoad() {
     return false;
   }
 
+  const QString stamp = DatabaseStamp(dev.device());
+  if (!stamp.isEmpty() && stamp == device_->database_stamp()) {
+    qLog(Debug) << "MTP device" << url_ << "hasn't changed";
+    return true;
+  }
+
   // Load the list of songs on the device
   SongList songs;
   LIBMTP_track_t* tracks =
@@ -73,11 +100,10 @@ bool MtpLoader::TryLoad() {
     LIBMTP_destroy_track_t(track);
   }
 
-  // Need to remove all the existing songs in the database first
-  backend_->DeleteSongs(backend_->FindSongsInDirectory(1));
-
-  // Add the songs we've just loaded
-  backend_->AddOrUpdateSongs(songs);
+  // The songs from last time stay in the library while this happens, only the
+  // ones that changed are touched.
+  backend_->ReplaceSongsInDirectory(1, songs);
+  device_->set_database_stamp(stamp);
 
   return true;
 }
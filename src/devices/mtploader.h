@@ -22,6 +22,8 @@
 #include <QUrl>
 #include <memory>
 
+struct LIBMTP_mtpdevice_struct;
+
 class ConnectedDevice;
 class LibraryBackend;
 class TaskManager;
@@ -35,6 +37,10 @@ class MtpLoader : public QObject {
             std::shared_ptr<ConnectedDevice> device);
   ~MtpLoader();
 
+  // MTP has no generation number for its database, but adding or removing
+  // anything changes the free space on one of the storages.
+  static QString DatabaseStamp(LIBMTP_mtpdevice_struct* device);
+
  public slots:
   void LoadDatabase();
 
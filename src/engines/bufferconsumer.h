@@ -26,7 +26,9 @@ class BufferConsumer {
  public:
   virtual ~BufferConsumer() {}
 
-  // This is called in some unspecified GStreamer thread.
+  // This is called in the thread of the GstEnginePipeline that produced the
+  // buffer, not the GStreamer streaming thread.  Buffers might be dropped if
+  // that thread is busy.
   // Ownership of the buffer is transferred to the BufferConsumer and it should
   // gst_buffer_unref it.
   virtual void ConsumeBuffer(GstBuffer* buffer, int pipeline_id) = 0;
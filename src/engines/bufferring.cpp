@@ -0,0 +1,53 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bufferring.h"
+
+BufferRing::BufferRing() : write_index_(0), read_index_(0) {}
+
+BufferRing::~BufferRing() {
+  for (QAtomicPointer<GstBuffer>& slot : slots_) {
+    GstBuffer* buffer = slot.fetchAndStoreOrdered(nullptr);
+    if (buffer) gst_buffer_unref(buffer);
+  }
+}
+
+void BufferRing::Push(GstBuffer* buffer) {
+  const quint32 index = write_index_.load();
+  GstBuffer* oldest = slots_[index % kCapacity].fetchAndStoreOrdered(buffer);
+  write_index_.storeRelease(index + 1);
+
+  // The consumer hadn't got round to this one yet.
+  if (oldest) gst_buffer_unref(oldest);
+}
+
+QList<GstBuffer*> BufferRing::TakeAll() {
+  const quint32 end = write_index_.loadAcquire();
+
+  // Skip over anything that's been overwritten since we last looked.
+  if (end - read_index_ > kCapacity) read_index_ = end - kCapacity;
+
+  QList<GstBuffer*> ret;
+  for (; read_index_ != end; ++read_index_) {
+    // A slot can already be empty if the producer lapped us while we were
+    // reading, in which case its newer buffer was taken a little early.
+    GstBuffer* buffer =
+        slots_[read_index_ % kCapacity].fetchAndStoreOrdered(nullptr);
+    if (buffer) ret << buffer;
+  }
+  return ret;
+}
@@ -0,0 +1,54 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINES_BUFFERRING_H_
+#define ENGINES_BUFFERRING_H_
+
+#include <gst/gstbuffer.h>
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QList>
+
+// A fixed size ring of buffer references passed from one producer thread to
+// one consumer thread without locking.  When the consumer falls behind the
+// oldest buffers are dropped, so the producer never waits for it.
+class BufferRing {
+ public:
+  static const quint32 kCapacity = 64;
+
+  BufferRing();
+  ~BufferRing();
+
+  // Producer side.  Takes ownership of buffer.
+  void Push(GstBuffer* buffer);
+
+  // Consumer side.  Returns the buffers pushed since the last call, oldest
+  // first.  The caller owns them and should gst_buffer_unref them.
+  QList<GstBuffer*> TakeAll();
+
+ private:
+  Q_DISABLE_COPY(BufferRing)
+
+  // Both threads swap buffers in and out of the slots atomically, so a buffer
+  // is always owned by exactly one of them.
+  QAtomicPointer<GstBuffer> slots_[kCapacity];
+  QAtomicInteger<quint32> write_index_;
+  quint32 read_index_;
+};
+
+#endif  // ENGINES_BUFFERRING_H_
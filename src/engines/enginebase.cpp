@@ -25,6 +25,7 @@
 #include <cmath>
 
 #include "core/timeconstants.h"
+#include "spectrumservice.h"
 
 const char* Engine::Base::kSettingsGroup = "Player";
 
@@ -38,7 +39,10 @@ Engine::Base::Base()
       crossfade_enabled_(true),
       autocrossfade_enabled_(false),
       crossfade_same_album_(false),
-      about_to_end_emitted_(false) {}
+      prefetch_lead_nanosec_(15 * kNsecPerSec),  // 15s
+      about_to_end_emitted_(false),
+      nearing_end_emitted_(false),
+      spectrum_(new SpectrumService(this)) {}
 
 Engine::Base::~Base() {}
 
@@ -52,6 +56,7 @@ bool Engine::Base::Load(const MediaPlaybackRequest& req, TrackChangeFlags,
   end_nanosec_ = end_nanosec;
 
   about_to_end_emitted_ = false;
+  nearing_end_emitted_ = false;
   return true;
 }
 
@@ -80,6 +85,9 @@ void Engine::Base::ReloadSettings() {
   fadeout_pause_enabled_ = s.value("FadeoutPauseEnabled", false).toBool();
   fadeout_pause_duration_nanosec_ =
       s.value("FadeoutPauseDuration", 250).toLongLong() * kNsecPerMsec;
+  // 0 turns the early prefetch off.
+  prefetch_lead_nanosec_ =
+      s.value("NextTrackPrefetchLead", 15).toLongLong() * kNsecPerSec;
 }
 
 void Engine::Base::EmitAboutToEnd() {
@@ -89,6 +97,13 @@ void Engine::Base::EmitAboutToEnd() {
   emit TrackAboutToEnd();
 }
 
+void Engine::Base::EmitNearingEnd() {
+  if (nearing_end_emitted_) return;
+
+  nearing_end_emitted_ = true;
+  emit TrackNearingEnd();
+}
+
 int Engine::Base::AddBackgroundStream(const QUrl& url) { return -1; }
 
 bool Engine::Base::Play(const MediaPlaybackRequest& req, TrackChangeFlags c,
@@ -28,11 +28,14 @@
 #include <QList>
 #include <QObject>
 #include <QUrl>
+#include <memory>
 #include <vector>
 
 #include "engine_fwd.h"
 #include "playbackrequest.h"
 
+class SpectrumService;
+
 namespace Engine {
 
 typedef std::vector<int16_t> Scope;
@@ -52,6 +55,9 @@ class Base : public QObject {
   virtual void Pause() = 0;
   virtual void Unpause() = 0;
   virtual void Seek(quint64 offset_nanosec) = 0;
+  // While the user drags the position slider, seeks may trade accuracy for
+  // speed.  Ending a scrub seeks accurately to wherever it ended up.
+  virtual void SetScrubbing(bool scrubbing) {}
 
   virtual int AddBackgroundStream(const QUrl& url);
   virtual void StopBackgroundStream(int id) {}
@@ -88,10 +94,24 @@ class Base : public QObject {
   // Simple accessors
   inline uint volume() const { return volume_; }
   virtual const Scope& scope(int chunk_length) { return scope_; }
+  // Like scope, but engines that can point straight into their own buffers
+  // instead of copying into scope_.  Returns interleaved stereo samples, count
+  // of them, which stay valid until the next call.
+  virtual const int16_t* scope_samples(int chunk_length, int* count) {
+    const Scope& samples = scope(chunk_length);
+    *count = samples.size();
+    return samples.data();
+  }
+  // Shared by all the analyzers, so the scope is only transformed once.
+  SpectrumService* spectrum() const { return spectrum_.get(); }
   bool is_fadeout_enabled() const { return fadeout_enabled_; }
   bool is_crossfade_enabled() const { return crossfade_enabled_; }
   bool is_autocrossfade_enabled() const { return autocrossfade_enabled_; }
   bool crossfade_same_album() const { return crossfade_same_album_; }
+  qint64 prefetch_lead_nanosec() const { return prefetch_lead_nanosec_; }
+
+  // Adds a sample to the engine's latency stats, if it keeps any.
+  virtual void RecordLatency(const QString& name, qint64 usec) {}
 
   static const char* kSettingsGroup;
   static const int kScopeSize = 1024;
@@ -109,6 +129,10 @@ class Base : public QObject {
   // away from finishing
   void TrackAboutToEnd();
 
+  // Emitted once per track, prefetch_lead_nanosec() before TrackAboutToEnd,
+  // so the next track can be found and read from disk in good time.
+  void TrackNearingEnd();
+
   void TrackEnded();
 
   void FadeoutFinishedSignal();
@@ -136,6 +160,7 @@ class Base : public QObject {
   virtual void SetVolumeSW(uint percent) = 0;
   static uint MakeVolumeLogarithmic(uint volume);
   void EmitAboutToEnd();
+  void EmitNearingEnd();
 
  protected:
   uint volume_;
@@ -151,9 +176,12 @@ class Base : public QObject {
   bool crossfade_same_album_;
   bool fadeout_pause_enabled_;
   qint64 fadeout_pause_duration_nanosec_;
+  qint64 prefetch_lead_nanosec_;
 
  private:
   bool about_to_end_emitted_;
+  bool nearing_end_emitted_;
+  std::unique_ptr<SpectrumService> spectrum_;
   Q_DISABLE_COPY(Base)
 };
 
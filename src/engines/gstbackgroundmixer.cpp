@@ -0,0 +1,277 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gstbackgroundmixer.h"
+
+#include "core/logging.h"
+#include "core/signalchecker.h"
+#include "core/utilities.h"
+#include "gstengine.h"
+#include "gstenginepipeline.h"
+
+GstBackgroundMixer::GstBackgroundMixer(GstEngine* engine)
+    : GstPipelineBase("background"),
+      engine_(engine),
+      sink_(GstEngine::kAutoSink),
+      mixer_(nullptr) {}
+
+GstBackgroundMixer::~GstBackgroundMixer() {
+  // The streams' probes point at their Stream, so the streaming threads have
+  // to be stopped before streams_ goes.
+  if (pipeline_) {
+    GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
+    gst_bus_remove_watch(bus);
+    gst_object_unref(bus);
+
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+  }
+}
+
+void GstBackgroundMixer::set_output_device(const QString& sink,
+                                           const QVariant& device) {
+  sink_ = sink;
+  device_ = device;
+}
+
+bool GstBackgroundMixer::Init() {
+  if (!GstPipelineBase::Init()) return false;
+
+  GstElement* audiosink = engine_->CreateElement(sink_, pipeline_);
+  if (!audiosink) {
+    qLog(Error) << "Failed to create audio sink";
+    return false;
+  }
+  GstEnginePipeline::SetSinkDevice(audiosink, device_);
+
+  mixer_ = engine_->CreateElement("audiomixer", pipeline_);
+  GstElement* resample = engine_->CreateElement("audioresample", pipeline_);
+  GstElement* convert = engine_->CreateElement("audioconvert", pipeline_);
+  if (!mixer_ || !resample || !convert) {
+    qLog(Error) << "Failed to create elements";
+    return false;
+  }
+
+  if (!gst_element_link_many(mixer_, resample, convert, audiosink, nullptr)) {
+    qLog(Error) << "Failed to link the mixer to the audio sink";
+    return false;
+  }
+
+  GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
+  gst_bus_add_watch(bus, BusCallback, this);
+  gst_object_unref(bus);
+
+  return true;
+}
+
+int GstBackgroundMixer::AddStream(const QUrl& url,
+                                  const QString& source_description) {
+  std::shared_ptr<Stream> stream(new Stream);
+  stream->mixer_ = this;
+  stream->id_ = NewId();
+  stream->url_ = url;
+  stream->source_description_ = source_description;
+  stream->volume_percent_ = 30;
+  stream->bin_ = nullptr;
+  stream->convert_ = nullptr;
+  stream->volume_ = nullptr;
+  stream->mixer_pad_ = nullptr;
+
+  if (!StartStream(stream.get())) {
+    StopStream(stream.get());
+    return -1;
+  }
+  streams_[stream->id_] = stream;
+
+  if (GST_STATE_TARGET(pipeline_) != GST_STATE_PLAYING &&
+      gst_element_set_state(pipeline_, GST_STATE_PLAYING) ==
+          GST_STATE_CHANGE_FAILURE) {
+    qLog(Warning) << "Could not set the background mixer to PLAYING";
+    RemoveStream(stream->id_);
+    return -1;
+  }
+
+  return stream->id_;
+}
+
+void GstBackgroundMixer::RemoveStream(int id) {
+  std::shared_ptr<Stream> stream = streams_.take(id);
+  if (!stream) return;
+
+  StopStream(stream.get());
+
+  // Let go of the output device when nothing's playing.
+  if (streams_.isEmpty()) gst_element_set_state(pipeline_, GST_STATE_NULL);
+}
+
+void GstBackgroundMixer::SetStreamVolume(int id, int percent) {
+  std::shared_ptr<Stream> stream = streams_.value(id);
+  if (!stream) return;
+
+  stream->volume_percent_ = percent;
+  if (stream->volume_) {
+    g_object_set(G_OBJECT(stream->volume_), "volume", percent * 0.01,
+                 nullptr);
+  }
+}
+
+void GstBackgroundMixer::RestartStream(int id) {
+  std::shared_ptr<Stream> stream = streams_.value(id);
+  if (!stream) return;
+
+  // Building a new bin is simpler than seeking one part of a running
+  // pipeline back to the start.
+  StopStream(stream.get());
+  if (!StartStream(stream.get())) {
+    qLog(Warning) << "Could not restart background stream" << stream->url_;
+    RemoveStream(id);
+  }
+}
+
+bool GstBackgroundMixer::StartStream(Stream* stream) {
+  stream->bin_ = gst_bin_new(nullptr);
+  gst_bin_add(GST_BIN(pipeline_), stream->bin_);
+
+  stream->convert_ = engine_->CreateElement("audioconvert", stream->bin_);
+  stream->volume_ = engine_->CreateElement("volume", stream->bin_);
+  if (!stream->convert_ || !stream->volume_) return false;
+
+  g_object_set(G_OBJECT(stream->volume_), "volume",
+               stream->volume_percent_ * 0.01, nullptr);
+  gst_element_link(stream->convert_, stream->volume_);
+
+  if (!stream->source_description_.isEmpty()) {
+    GError* error = nullptr;
+    GstElement* source = gst_parse_bin_from_description(
+        stream->source_description_.toUtf8().constData(), TRUE, &error);
+    if (error) {
+      qLog(Warning) << QString::fromLocal8Bit(error->message);
+      g_error_free(error);
+      return false;
+    }
+    gst_bin_add(GST_BIN(stream->bin_), source);
+    gst_element_link(source, stream->convert_);
+  } else {
+    GstElement* source = engine_->CreateElement("uridecodebin", stream->bin_);
+    if (!source) return false;
+    g_object_set(G_OBJECT(source), "uri",
+                 Utilities::GetUriForGstreamer(stream->url_).constData(),
+                 nullptr);
+    CHECKED_GCONNECT(G_OBJECT(source), "pad-added", &NewPadCallback, stream);
+  }
+
+  GstPad* pad = gst_element_get_static_pad(stream->volume_, "src");
+  gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, &EosProbe,
+                    stream, nullptr);
+  GstPad* ghost = gst_ghost_pad_new("src", pad);
+  gst_object_unref(pad);
+  gst_element_add_pad(stream->bin_, ghost);
+
+  // The mixer lines its inputs up by running time, so a stream added to a
+  // running mix has to start from now rather than from 0.
+  gst_pad_set_offset(ghost, running_time());
+
+  stream->mixer_pad_ = gst_element_get_request_pad(mixer_, "sink_%u");
+  if (gst_pad_link(ghost, stream->mixer_pad_) != GST_PAD_LINK_OK) {
+    qLog(Warning) << "Could not link background stream to the mixer";
+    return false;
+  }
+
+  gst_element_sync_state_with_parent(stream->bin_);
+  return true;
+}
+
+void GstBackgroundMixer::StopStream(Stream* stream) {
+  if (!stream->bin_) return;
+
+  // Releasing the mixer's pad first wakes up the streaming thread if it's
+  // waiting for the mixer, so the bin can be shut down.
+  if (stream->mixer_pad_) {
+    GstPad* ghost = gst_element_get_static_pad(stream->bin_, "src");
+    if (ghost) {
+      gst_pad_unlink(ghost, stream->mixer_pad_);
+      gst_object_unref(ghost);
+    }
+    gst_element_release_request_pad(mixer_, stream->mixer_pad_);
+    gst_object_unref(stream->mixer_pad_);
+    stream->mixer_pad_ = nullptr;
+  }
+
+  gst_element_set_state(stream->bin_, GST_STATE_NULL);
+  gst_bin_remove(GST_BIN(pipeline_), stream->bin_);
+  stream->bin_ = nullptr;
+  stream->convert_ = nullptr;
+  stream->volume_ = nullptr;
+}
+
+qint64 GstBackgroundMixer::running_time() const {
+  GstClock* clock = gst_element_get_clock(pipeline_);
+  if (!clock) return 0;
+
+  const GstClockTime now = gst_clock_get_time(clock);
+  gst_object_unref(clock);
+  return now - gst_element_get_base_time(pipeline_);
+}
+
+gboolean GstBackgroundMixer::BusCallback(GstBus*, GstMessage* msg,
+                                         gpointer self) {
+  GstBackgroundMixer* instance = reinterpret_cast<GstBackgroundMixer*>(self);
+
+  if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+    GError* error = nullptr;
+    gchar* debugs = nullptr;
+    gst_message_parse_error(msg, &error, &debugs);
+    qLog(Warning) << instance->id() << "background mixer error:"
+                  << QString::fromLocal8Bit(error->message)
+                  << QString::fromLocal8Bit(debugs);
+    g_error_free(error);
+    g_free(debugs);
+  }
+
+  return TRUE;
+}
+
+void GstBackgroundMixer::NewPadCallback(GstElement*, GstPad* pad,
+                                        gpointer self) {
+  Stream* stream = reinterpret_cast<Stream*>(self);
+
+  GstCaps* caps = gst_pad_query_caps(pad, nullptr);
+  const bool is_audio =
+      caps && gst_caps_get_size(caps) > 0 &&
+      g_str_has_prefix(
+          gst_structure_get_name(gst_caps_get_structure(caps, 0)), "audio/");
+  if (caps) gst_caps_unref(caps);
+  if (!is_audio) return;
+
+  GstPad* sink = gst_element_get_static_pad(stream->convert_, "sink");
+  if (!GST_PAD_IS_LINKED(sink)) gst_pad_link(pad, sink);
+  gst_object_unref(sink);
+}
+
+GstPadProbeReturn GstBackgroundMixer::EosProbe(GstPad*, GstPadProbeInfo* info,
+                                               gpointer self) {
+  Stream* stream = reinterpret_cast<Stream*>(self);
+
+  if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_EOS) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  // If the mixer saw this it would stop waiting for the stream, and once
+  // every stream had ended the whole mix would end.
+  QMetaObject::invokeMethod(stream->mixer_, "RestartStream",
+                            Qt::QueuedConnection, Q_ARG(int, stream->id_));
+  return GST_PAD_PROBE_DROP;
+}
@@ -0,0 +1,100 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINES_GSTBACKGROUNDMIXER_H_
+#define ENGINES_GSTBACKGROUNDMIXER_H_
+
+#include <QMap>
+#include <QUrl>
+#include <QVariant>
+#include <memory>
+
+#include "gstpipelinebase.h"
+
+class GstEngine;
+
+// Plays all the background streams through one audiomixer, so they share a
+// single output device and resampler however many of them are playing:
+//
+//   stream1 ! audioconvert ! volume ! \
+//   stream2 ! audioconvert ! volume ! - audiomixer ! audioresample
+//                                       ! audioconvert ! audiosink
+//
+// Streams that end are started again from the beginning.  The pipeline is
+// only PLAYING while it has streams, so the device isn't held open otherwise.
+class GstBackgroundMixer : public GstPipelineBase {
+  Q_OBJECT
+
+ public:
+  GstBackgroundMixer(GstEngine* engine);
+  ~GstBackgroundMixer();
+
+  // Call before Init
+  void set_output_device(const QString& sink, const QVariant& device);
+
+  bool Init();
+
+  // source_description is a gst-launch description to play instead of url,
+  // or empty.  Returns an ID for the stream, from the same sequence as
+  // pipeline IDs, or -1 on error.
+  int AddStream(const QUrl& url, const QString& source_description);
+  void RemoveStream(int id);
+  bool HasStream(int id) const { return streams_.contains(id); }
+  bool has_streams() const { return !streams_.isEmpty(); }
+
+  // Only sets the stream's volume element, nothing is rebuilt.
+  void SetStreamVolume(int id, int percent);
+
+ private slots:
+  void RestartStream(int id);
+
+ private:
+  struct Stream {
+    GstBackgroundMixer* mixer_;
+    int id_;
+    QUrl url_;
+    QString source_description_;
+    int volume_percent_;
+
+    GstElement* bin_;
+    GstElement* convert_;
+    GstElement* volume_;
+    GstPad* mixer_pad_;
+  };
+
+  // Makes the stream's bin and links it to a new mixer pad.
+  bool StartStream(Stream* stream);
+  void StopStream(Stream* stream);
+
+  // The running time of the mixer's output, which is where new streams have
+  // to start to be heard straight away.
+  qint64 running_time() const;
+
+  static gboolean BusCallback(GstBus*, GstMessage*, gpointer);
+  static void NewPadCallback(GstElement*, GstPad*, gpointer);
+  static GstPadProbeReturn EosProbe(GstPad*, GstPadProbeInfo*, gpointer);
+
+  GstEngine* engine_;
+  QString sink_;
+  QVariant device_;
+
+  GstElement* mixer_;
+
+  QMap<int, std::shared_ptr<Stream>> streams_;
+};
+
+#endif  // ENGINES_GSTBACKGROUNDMIXER_H_
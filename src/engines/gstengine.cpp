@@ -34,6 +34,7 @@
 #include <QTimeLine>
 #include <QTimer>
 #include <QtConcurrentRun>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <memory>
@@ -47,8 +48,11 @@
 #include "core/timeconstants.h"
 #include "core/utilities.h"
 #include "devicefinder.h"
+#include "gst/dsp/plugin.h"
+#include "gstbackgroundmixer.h"
 #include "gstenginedebug.h"
 #include "gstenginepipeline.h"
+#include "spectrumservice.h"
 #include "ui/console.h"
 
 #ifdef HAVE_MOODBAR
@@ -114,15 +118,29 @@ GstEngine::GstEngine(Application* app)
       rg_compression_(true),
       buffer_duration_nanosec_(1 * kNsecPerSec),  // 1s
       buffer_min_fill_(33),
+      adaptive_buffering_(false),
       mono_playback_(false),
       sample_rate_(kAutoSampleRate),
+      reuse_pipeline_(false),
+      current_pipeline_reusable_(false),
       seek_timer_(new QTimer(this)),
+      waiting_to_seek_(false),
+      seek_pos_(0),
+      scrubbing_(false),
+      scrub_needs_accurate_seek_(false),
       timer_id_(-1),
       next_element_id_(0),
+      mix_background_streams_(false),
       is_fading_out_to_pause_(false),
       has_faded_out_(false),
       scope_chunk_(0),
-      have_new_buffer_(false) {
+      have_new_buffer_(false),
+      scope_chunks_(0),
+      scope_window_(nullptr),
+      scope_window_size_(0),
+      play_started_usec_(-1),
+      about_to_end_usec_(-1),
+      buffering_started_usec_(-1) {
   seek_timer_->setSingleShot(true);
   seek_timer_->setInterval(kSeekDelayNanosec / kNsecPerMsec);
   connect(seek_timer_, SIGNAL(timeout()), SLOT(SeekNow()));
@@ -143,6 +161,8 @@ GstEngine::~GstEngine() {
   EnsureInitialised();
 
   current_pipeline_.reset();
+  background_mixer_.reset();
+  ReleaseLatestBuffer();
 
   qDeleteAll(device_finders_);
 
@@ -169,8 +189,16 @@ void GstEngine::InitialiseGstreamer() {
 
   gst_pb_utils_init();
 
+  gstclementinedsp_register_static();
+
 #ifdef HAVE_MOODBAR
   gstfastspectrum_register_static();
+
+  // So moodbar FFTs don't have to be measured again on every run.
+  const QString cache_dir = Utilities::GetConfigPath(Utilities::Path_CacheRoot);
+  QDir().mkpath(cache_dir);
+  gstfastspectrum_set_wisdom_file(
+      QFile::encodeName(cache_dir + "/fftw-wisdom").constData());
 #endif
 
   QSet<QString> plugin_names;
@@ -240,11 +268,21 @@ void GstEngine::ReloadSettings() {
       s.value("bufferduration", 4000).toLongLong() * kNsecPerMsec;
 
   buffer_min_fill_ = s.value("bufferminfill", 33).toInt();
+  adaptive_buffering_ = s.value("adaptivebuffering", false).toBool();
 
   mono_playback_ = s.value("monoplayback", false).toBool();
   sample_rate_ = s.value("samplerate", kAutoSampleRate).toInt();
   format_ = s.value(GstEngine::kSettingFormat, GstEngine::kOutFormatDetect)
                 .toString();
+
+  reuse_pipeline_ = s.value("reusepipeline", false).toBool();
+  current_pipeline_reusable_ = false;
+
+  // Streams that are already playing stay where they are.
+  mix_background_streams_ = s.value("mixbackgroundstreams", false).toBool();
+  if (background_mixer_ && !background_mixer_->has_streams()) {
+    background_mixer_.reset();
+  }
 }
 
 qint64 GstEngine::position_nanosec() const {
@@ -286,8 +324,15 @@ Engine::State GstEngine::state() const {
 }
 
 void GstEngine::ConsumeBuffer(GstBuffer* buffer, int pipeline_id) {
-  // Schedule this to run in the GUI thread.  The buffer gets added to the
-  // queue and unreffed by UpdateScope.
+  // Nobody is looking at the analyzers, so there's no point keeping buffers
+  // for them.
+  if (!spectrum()->has_subscribers()) {
+    gst_buffer_unref(buffer);
+    return;
+  }
+
+  // Schedule this to run in the GUI thread.  The buffer is kept as
+  // latest_buffer_ until the next one replaces it.
   if (!QMetaObject::invokeMethod(this, "AddBufferToScope",
                                  Q_ARG(GstBuffer*, buffer),
                                  Q_ARG(int, pipeline_id))) {
@@ -306,15 +351,40 @@ void GstEngine::AddBufferToScope(GstBuffer* buf, int pipeline_id) {
     return;
   }
 
-  if (latest_buffer_ != nullptr) {
-    gst_buffer_unref(latest_buffer_);
+  ReleaseLatestBuffer();
+
+  // Map it once here, rather than on every scope update, and read the samples
+  // in place until the next buffer arrives.
+  if (!gst_buffer_map(buf, &latest_map_, GST_MAP_READ)) {
+    gst_buffer_unref(buf);
+    return;
   }
 
   latest_buffer_ = buf;
   have_new_buffer_ = true;
 }
 
+void GstEngine::ReleaseLatestBuffer() {
+  scope_window_ = nullptr;
+  scope_window_size_ = 0;
+
+  if (latest_buffer_ == nullptr) return;
+
+  gst_buffer_unmap(latest_buffer_, &latest_map_);
+  gst_buffer_unref(latest_buffer_);
+  latest_buffer_ = nullptr;
+}
+
 const Engine::Scope& GstEngine::scope(int chunk_length) {
+  int count = 0;
+  const int16_t* samples = scope_samples(chunk_length, &count);
+  if (samples != scope_.data()) {
+    std::copy(samples, samples + count, scope_.begin());
+  }
+  return scope_;
+}
+
+const int16_t* GstEngine::scope_samples(int chunk_length, int* count) {
   // the new buffer could have a different size
   if (have_new_buffer_) {
     if (latest_buffer_ != nullptr) {
@@ -335,7 +405,13 @@ const Engine::Scope& GstEngine::scope(int chunk_length) {
     UpdateScope(chunk_length);
   }
 
-  return scope_;
+  if (scope_window_ == nullptr) {
+    *count = scope_.size();
+    return scope_.data();
+  }
+
+  *count = scope_window_size_;
+  return scope_window_;
 }
 
 void GstEngine::UpdateScope(int chunk_length) {
@@ -345,47 +421,27 @@ void GstEngine::UpdateScope(int chunk_length) {
   if (!GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(latest_buffer_))) return;
   if (GST_BUFFER_DURATION(latest_buffer_) == 0) return;
 
-  GstMapInfo map;
-  gst_buffer_map(latest_buffer_, &map, GST_MAP_READ);
+  // in case a buffer doesn't arrive in time, keep showing the last chunk
+  if (scope_chunk_ >= scope_chunks_) return;
 
   // determine where to split the buffer
   int chunk_density =
-      (map.size * kNsecPerMsec) / GST_BUFFER_DURATION(latest_buffer_);
+      (latest_map_.size * kNsecPerMsec) / GST_BUFFER_DURATION(latest_buffer_);
 
   int chunk_size = chunk_length * chunk_density;
 
-  // in case a buffer doesn't arrive in time
-  if (scope_chunk_ >= scope_chunks_) {
-    scope_chunk_ = 0;
-    gst_buffer_unmap(latest_buffer_, &map);
-    return;
-  }
-
-  const sample_type* source = reinterpret_cast<sample_type*>(map.data);
-  sample_type* dest = scope_.data();
-  source += (chunk_size / sizeof(sample_type)) * scope_chunk_;
-
-  int bytes = 0;
-
-  // make sure we don't go beyond the end of the buffer
-  if (scope_chunk_ == scope_chunks_ - 1) {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(
-                     map.size - (chunk_size * scope_chunk_)),
-                 scope_.size() * sizeof(sample_type));
-  } else {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(chunk_size),
-                 scope_.size() * sizeof(sample_type));
-  }
-
+  const sample_type* source =
+      reinterpret_cast<const sample_type*>(latest_map_.data);
+  const gsize offset = (chunk_size / sizeof(sample_type)) * scope_chunk_;
+  const gsize available = latest_map_.size / sizeof(sample_type);
   scope_chunk_++;
-  memcpy(dest, source, bytes);
-
-  gst_buffer_unmap(latest_buffer_, &map);
 
-  if (scope_chunk_ == scope_chunks_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-  }
+  // make sure we don't go beyond the end of the buffer.  The window can run
+  // on into the next chunk, which is as good as anything we'd show instead.
+  if (offset >= available) return;
+  scope_window_ = source + offset;
+  scope_window_size_ =
+      qMin(available - offset, static_cast<gsize>(scope_.size()));
 }
 
 void GstEngine::StartPreloading(const MediaPlaybackRequest& req,
@@ -407,6 +463,7 @@ bool GstEngine::Load(const MediaPlaybackRequest& req,
 
   Engine::Base::Load(req, change, force_stop_at_end, beginning_nanosec,
                      end_nanosec);
+  about_to_end_usec_ = -1;
 
   bool crossfade =
       current_pipeline_ && ((crossfade_enabled_ && change & Engine::Manual) ||
@@ -425,6 +482,12 @@ bool GstEngine::Load(const MediaPlaybackRequest& req,
     return true;
   }
 
+  if (!crossfade &&
+      ReuseCurrentPipeline(req, force_stop_at_end ? end_nanosec : 0)) {
+    BufferingFinished();
+    return true;
+  }
+
   shared_ptr<GstEnginePipeline> pipeline =
       CreatePipeline(req, force_stop_at_end ? end_nanosec : 0);
   if (!pipeline) return false;
@@ -433,6 +496,7 @@ bool GstEngine::Load(const MediaPlaybackRequest& req,
 
   BufferingFinished();
   current_pipeline_ = pipeline;
+  current_pipeline_reusable_ = true;
 
   SetVolume(volume_);
   SetEqualizerEnabled(equalizer_enabled_);
@@ -447,6 +511,25 @@ bool GstEngine::Load(const MediaPlaybackRequest& req,
   return true;
 }
 
+bool GstEngine::ReuseCurrentPipeline(const MediaPlaybackRequest& req,
+                                     qint64 end_nanosec) {
+  if (!reuse_pipeline_ || !current_pipeline_reusable_ || !current_pipeline_ ||
+      is_fading_out_to_pause_ || current_pipeline_ == fadeout_pipeline_) {
+    return false;
+  }
+
+  // These are built from a fixed pipeline description, not a url.
+  if (req.url_.scheme() == "hypnotoad" || req.url_.scheme() == "enterprise") {
+    return false;
+  }
+
+  if (!current_pipeline_->Reuse(req, end_nanosec)) {
+    current_pipeline_reusable_ = false;
+    return false;
+  }
+  return true;
+}
+
 void GstEngine::StartFadeout() {
   if (is_fading_out_to_pause_) return;
 
@@ -481,6 +564,9 @@ bool GstEngine::Play(quint64 offset_nanosec) {
 
   if (!current_pipeline_ || current_pipeline_->is_buffering()) return false;
 
+  play_started_usec_ = g_get_monotonic_time();
+  current_pipeline_->MeasureTimeToFirstAudio();
+
   QFuture<GstStateChangeReturn> future =
       current_pipeline_->SetState(GST_STATE_PLAYING);
   NewClosure(future, this,
@@ -500,6 +586,12 @@ void GstEngine::PlayDone(QFuture<GstStateChangeReturn> future,
 
   if (!IsCurrentPipeline(pipeline_id)) return;
 
+  if (play_started_usec_ != -1 && ret != GST_STATE_CHANGE_FAILURE) {
+    latency_stats_.Record("Play to PLAYING state",
+                          g_get_monotonic_time() - play_started_usec_);
+  }
+  play_started_usec_ = -1;
+
   if (ret == GST_STATE_CHANGE_FAILURE) {
     // Failure, but we got a redirection URL - try loading that instead
     QUrl redirect_url = current_pipeline_->redirect_url();
@@ -644,11 +736,29 @@ void GstEngine::SeekNow() {
 
   if (!current_pipeline_) return;
 
-  if (!current_pipeline_->Seek(seek_pos_)) {
+  bool ok;
+  if (scrubbing_) {
+    ok = current_pipeline_->SeekFast(seek_pos_);
+    scrub_needs_accurate_seek_ = true;
+  } else {
+    ok = current_pipeline_->Seek(seek_pos_);
+    scrub_needs_accurate_seek_ = false;
+  }
+
+  if (!ok) {
     qLog(Warning) << "Seek failed";
   }
 }
 
+void GstEngine::SetScrubbing(bool scrubbing) {
+  scrubbing_ = scrubbing;
+  if (scrubbing_ || !scrub_needs_accurate_seek_) return;
+
+  // Land exactly where the scrub ended, without waiting for the seek timer.
+  waiting_to_seek_ = true;
+  SeekNow();
+}
+
 void GstEngine::SetEqualizerEnabled(bool enabled) {
   equalizer_enabled_ = enabled;
 
@@ -704,8 +814,17 @@ void GstEngine::timerEvent(QTimerEvent* e) {
 
     // only if we know the length of the current stream...
     if (current_length > 0) {
+      // Give the player a head start on the next track, before the preload.
+      if (prefetch_lead_nanosec_ > 0 &&
+          remaining < gap + prefetch_lead_nanosec_ + fudge) {
+        EmitNearingEnd();
+      }
+
       // emit TrackAboutToEnd when we're a few seconds away from finishing
       if (remaining < gap + fudge) {
+        if (about_to_end_usec_ == -1) {
+          about_to_end_usec_ = g_get_monotonic_time();
+        }
         EmitAboutToEnd();
       }
     }
@@ -755,6 +874,13 @@ void GstEngine::HandlePipelineError(int pipeline_id, const QString& message,
 void GstEngine::EndOfStreamReached(int pipeline_id, bool has_next_track) {
   if (!IsCurrentPipeline(pipeline_id)) return;
 
+  // How much warning the preload gave before the track ran out.
+  if (about_to_end_usec_ != -1) {
+    latency_stats_.Record("Preload to end of track",
+                          g_get_monotonic_time() - about_to_end_usec_);
+    about_to_end_usec_ = -1;
+  }
+
   if (!has_next_track) {
     current_pipeline_.reset();
     BufferingFinished();
@@ -842,6 +968,8 @@ shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline() {
   connect(ret.get(), SIGNAL(BufferingProgress(int)),
           SLOT(BufferingProgress(int)));
   connect(ret.get(), SIGNAL(BufferingFinished()), SLOT(BufferingFinished()));
+  connect(ret.get(), SIGNAL(LatencyMeasured(int, QString, qint64)),
+          SLOT(LatencyMeasured(int, QString, qint64)));
 
   return ret;
 }
@@ -850,6 +978,18 @@ shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline(
     const MediaPlaybackRequest& req, qint64 end_nanosec) {
   shared_ptr<GstEnginePipeline> ret = CreatePipeline();
 
+  if (adaptive_buffering_ && !req.url_.isLocalFile() &&
+      !req.url_.host().isEmpty()) {
+    const StreamBufferPolicy::Params params = buffer_policy_.ParamsForHost(
+        req.url_.host(), buffer_duration_nanosec_, buffer_min_fill_);
+    qLog(Debug) << "Buffering" << req.url_.host() << "for"
+                << params.duration_nanosec_ / kNsecPerMsec << "msec";
+    ret->set_buffer_duration_nanosec(params.duration_nanosec_);
+    ret->set_buffer_min_fill(params.low_percent_);
+    ret->set_buffer_high_fill(params.high_percent_);
+    ret->set_buffer_policy(&buffer_policy_);
+  }
+
   if (req.url_.scheme() == "hypnotoad") {
     if (!ret->InitFromString(kHypnotoadPipeline)) {
       qLog(Error) << "Could not initialize pipeline" << kHypnotoadPipeline;
@@ -906,6 +1046,27 @@ void GstEngine::BackgroundStreamPlayDone(QFuture<GstStateChangeReturn> future,
 }
 
 int GstEngine::AddBackgroundStream(const QUrl& url) {
+  if (mix_background_streams_) {
+    if (!background_mixer_) {
+      EnsureInitialised();
+      background_mixer_.reset(new GstBackgroundMixer(this));
+      background_mixer_->set_output_device(sink_, device_);
+      if (!background_mixer_->Init()) {
+        qLog(Error) << "Could not initialize the background mixer";
+        background_mixer_.reset();
+        return -1;
+      }
+    }
+
+    QString description;
+    if (url.scheme() == "hypnotoad") {
+      description = kHypnotoadPipeline;
+    } else if (url.scheme() == "enterprise") {
+      description = kEnterprisePipeline;
+    }
+    return background_mixer_->AddStream(url, description);
+  }
+
   shared_ptr<GstEnginePipeline> pipeline = CreatePipeline(url, 0);
   if (!pipeline) {
     return -1;
@@ -916,6 +1077,10 @@ int GstEngine::AddBackgroundStream(const QUrl& url) {
 }
 
 void GstEngine::StopBackgroundStream(int id) {
+  if (background_mixer_ && background_mixer_->HasStream(id)) {
+    background_mixer_->RemoveStream(id);
+    return;
+  }
   background_streams_.remove(id);  // Removes last shared_ptr reference.
 }
 
@@ -925,6 +1090,10 @@ void GstEngine::BackgroundStreamFinished() {
 }
 
 void GstEngine::SetBackgroundStreamVolume(int id, int volume) {
+  if (background_mixer_ && background_mixer_->HasStream(id)) {
+    background_mixer_->SetStreamVolume(id, volume);
+    return;
+  }
   shared_ptr<GstEnginePipeline> pipeline = background_streams_[id];
   Q_ASSERT(pipeline);
   pipeline->SetVolume(volume);
@@ -937,6 +1106,10 @@ void GstEngine::BufferingStarted() {
 
   buffering_task_id_ = task_manager_->StartTask(tr("Buffering"));
   task_manager_->SetTaskProgress(buffering_task_id_, 0, 100);
+
+  if (buffering_started_usec_ == -1) {
+    buffering_started_usec_ = g_get_monotonic_time();
+  }
 }
 
 void GstEngine::BufferingProgress(int percent) {
@@ -948,6 +1121,22 @@ void GstEngine::BufferingFinished() {
     task_manager_->SetTaskFinished(buffering_task_id_);
     buffering_task_id_ = -1;
   }
+
+  if (buffering_started_usec_ != -1) {
+    latency_stats_.Record("Buffering stall",
+                          g_get_monotonic_time() - buffering_started_usec_);
+    buffering_started_usec_ = -1;
+  }
+}
+
+void GstEngine::LatencyMeasured(int pipeline_id, const QString& name,
+                                qint64 usec) {
+  if (!IsCurrentPipeline(pipeline_id)) return;
+  latency_stats_.Record(name, usec);
+}
+
+void GstEngine::RecordLatency(const QString& name, qint64 usec) {
+  latency_stats_.Record(name, usec);
 }
 
 GstEngine::OutputDetailsList GstEngine::GetOutputsList() const {
@@ -33,8 +33,10 @@
 #include <memory>
 
 #include "bufferconsumer.h"
+#include "core/latencystats.h"
 #include "core/timeconstants.h"
 #include "enginebase.h"
+#include "streambufferpolicy.h"
 
 class QTimer;
 class QTimerEvent;
@@ -43,6 +45,7 @@ class Application;
 class Console;
 class DeviceFinder;
 class GstEngineDebug;
+class GstBackgroundMixer;
 class GstEnginePipeline;
 class TaskManager;
 
@@ -92,6 +95,7 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   qint64 length_nanosec() const;
   Engine::State state() const;
   const Engine::Scope& scope(int chunk_length);
+  const int16_t* scope_samples(int chunk_length, int* count);
 
   OutputDetailsList GetOutputsList() const;
 
@@ -100,6 +104,9 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   // BufferConsumer
   void ConsumeBuffer(GstBuffer* buffer, int pipeline_id);
 
+  // Only call from the engine's thread, the stats aren't thread-safe.
+  void RecordLatency(const QString& name, qint64 usec);
+
  public slots:
   void StartPreloading(const MediaPlaybackRequest& req, bool force_stop_at_end,
                        qint64 beginning_nanosec, qint64 end_nanosec);
@@ -111,6 +118,7 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   void Pause();
   void Unpause();
   void Seek(quint64 offset_nanosec);
+  void SetScrubbing(bool scrubbing);
 
   /** Set whether equalizer is enabled */
   void SetEqualizerEnabled(bool);
@@ -142,6 +150,7 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   std::shared_ptr<GstEnginePipeline> GetCurrentPipeline() {
     return current_pipeline_;
   }
+  LatencyStats* latency_stats() { return &latency_stats_; }
 
  private slots:
   void EndOfStreamReached(int pipeline_id, bool has_next_track);
@@ -158,6 +167,7 @@ class GstEngine : public Engine::Base, public BufferConsumer {
 
   void BufferingStarted();
   void BufferingProgress(int percent);
+  void LatencyMeasured(int pipeline_id, const QString& name, qint64 usec);
   void BufferingFinished();
 
  private:
@@ -179,8 +189,12 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   std::shared_ptr<GstEnginePipeline> CreatePipeline();
   std::shared_ptr<GstEnginePipeline> CreatePipeline(
       const MediaPlaybackRequest& req, qint64 end_nanosec);
+  // Tries to play req in current_pipeline_ instead of making a new one.
+  bool ReuseCurrentPipeline(const MediaPlaybackRequest& req,
+                            qint64 end_nanosec);
 
   void UpdateScope(int chunk_length);
+  void ReleaseLatestBuffer();
 
   int AddBackgroundStream(std::shared_ptr<GstEnginePipeline> pipeline);
 
@@ -202,6 +216,9 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   QString sink_;
   QVariant device_;
 
+  // Declared before the pipelines, which report to it when they're destroyed.
+  StreamBufferPolicy buffer_policy_;
+
   std::shared_ptr<GstEnginePipeline> current_pipeline_;
   std::shared_ptr<GstEnginePipeline> fadeout_pipeline_;
   std::shared_ptr<GstEnginePipeline> fadeout_pause_pipeline_;
@@ -209,7 +226,10 @@ class GstEngine : public Engine::Base, public BufferConsumer {
 
   QList<BufferConsumer*> buffer_consumers_;
 
+  // The latest buffer for the analyzers, which stays mapped while we hold it
+  // so scope_samples can point into it.
   GstBuffer* latest_buffer_;
+  GstMapInfo latest_map_;
 
   bool equalizer_enabled_;
   int equalizer_preamp_;
@@ -225,10 +245,20 @@ class GstEngine : public Engine::Base, public BufferConsumer {
 
   int buffer_min_fill_;
 
+  // Whether network streams get their buffer sized by buffer_policy_ rather
+  // than always using the settings above.
+  bool adaptive_buffering_;
+
   bool mono_playback_;
   int sample_rate_;
   QString format_;
 
+  // When set, track changes that don't crossfade keep the current pipeline
+  // and only swap its decoder.  Cleared for the current pipeline when the
+  // settings change, since its audio bin was built with the old ones.
+  bool reuse_pipeline_;
+  bool current_pipeline_reusable_;
+
   mutable bool can_decode_success_;
   mutable bool can_decode_last_;
 
@@ -237,20 +267,40 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   bool waiting_to_seek_;
   quint64 seek_pos_;
 
+  // Seeks made while scrubbing are fast ones, so scrub_needs_accurate_seek_
+  // is set until an accurate seek has been made at the end.
+  bool scrubbing_;
+  bool scrub_needs_accurate_seek_;
+
   int timer_id_;
   int next_element_id_;
 
   QHash<int, std::shared_ptr<GstEnginePipeline>> background_streams_;
 
+  // When set, new background streams are mixed in background_mixer_ instead
+  // of each getting a pipeline and an output of their own.
+  bool mix_background_streams_;
+  std::unique_ptr<GstBackgroundMixer> background_mixer_;
+
   bool is_fading_out_to_pause_;
   bool has_faded_out_;
 
   int scope_chunk_;
   bool have_new_buffer_;
   int scope_chunks_;
+  const int16_t* scope_window_;
+  int scope_window_size_;
 
   QList<DeviceFinder*> device_finders_;
 
+  // Timings along the playback path, shown in GstEngineDebug.  The *_usec_
+  // fields are g_get_monotonic_time() values, or -1 when nothing's being
+  // timed.
+  LatencyStats latency_stats_;
+  qint64 play_started_usec_;
+  qint64 about_to_end_usec_;
+  qint64 buffering_started_usec_;
+
 #ifdef Q_OS_DARWIN
   GTlsDatabase* tls_database_;
 #endif
@@ -17,6 +17,8 @@
 
 #include "gstenginedebug.h"
 
+#include <QFontDatabase>
+
 #include "core/logging.h"
 #include "gstengine.h"
 #include "gstenginepipeline.h"
@@ -25,6 +27,12 @@ GstEngineDebug::GstEngineDebug(GstEngine* engine, QWidget* parent)
     : QWidget(parent), engine_(engine) {
   ui_.setupUi(this);
   connect(ui_.dump_graph_button, SIGNAL(clicked()), SLOT(DumpGraph()));
+  connect(ui_.refresh_latency_button, SIGNAL(clicked()), SLOT(ShowLatency()));
+  connect(ui_.reset_latency_button, SIGNAL(clicked()), SLOT(ResetLatency()));
+
+  ui_.latency_output->setFont(
+      QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  ShowLatency();
 }
 
 void GstEngineDebug::DumpGraph() {
@@ -33,3 +41,12 @@ void GstEngineDebug::DumpGraph() {
     pipeline->DumpGraph();
   }
 }
+
+void GstEngineDebug::ShowLatency() {
+  ui_.latency_output->setPlainText(engine_->latency_stats()->ToString());
+}
+
+void GstEngineDebug::ResetLatency() {
+  engine_->latency_stats()->Clear();
+  ShowLatency();
+}
@@ -31,6 +31,8 @@ class GstEngineDebug : public QWidget {
 
  private slots:
   void DumpGraph();
+  void ShowLatency();
+  void ResetLatency();
 
  private:
   Ui::GstEngineDebug ui_;
@@ -24,6 +24,9 @@
 #include <QDir>
 #include <QPair>
 #include <QRegExp>
+#include <cmath>
+#include <gst/controller/gstdirectcontrolbinding.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
 #include <limits>
 
 #include "bufferconsumer.h"
@@ -31,6 +34,7 @@
 #include "core/concurrentrun.h"
 #include "core/logging.h"
 #include "core/mac_startup.h"
+#include "core/metrics.h"
 #include "core/signalchecker.h"
 #include "core/utilities.h"
 #include "gstelementdeleter.h"
@@ -41,11 +45,15 @@
 #include "internet/core/internetmodel.h"
 
 const int GstEnginePipeline::kGstStateTimeoutNanosecs = 10000000;
+// A seek that hasn't finished after this long is assumed to never finish, so
+// later seeks don't wait for it forever.
+const qint64 GstEnginePipeline::kSeekTimeoutUsec = 2 * 1000 * 1000;
 const int GstEnginePipeline::kFaderFudgeMsec = 2000;
+// The control source only interpolates in straight lines, so curved fades are
+// made of pieces this long.
+const int GstEnginePipeline::kFaderStepMsec = 20;
 
 const int GstEnginePipeline::kEqBandCount = 10;
-const int GstEnginePipeline::kEqBandFrequencies[] = {
-    60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000};
 
 GstElementDeleter* GstEnginePipeline::sElementDeleter = nullptr;
 
@@ -53,12 +61,15 @@ GstEnginePipeline::GstEnginePipeline(GstEngine* engine)
     : GstPipelineBase("audio"),
       engine_(engine),
       valid_(false),
+      reusable_(false),
       sink_(GstEngine::kAutoSink),
       segment_start_(0),
       segment_start_received_(false),
       emit_track_ended_on_stream_start_(false),
       emit_track_ended_on_time_discontinuity_(false),
       last_buffer_offset_(0),
+      first_audio_since_usec_(0),
+      first_decoded_since_usec_(0),
       eq_enabled_(false),
       eq_preamp_(0),
       stereo_balance_(0.0f),
@@ -66,9 +77,12 @@ GstEnginePipeline::GstEnginePipeline(GstEngine* engine)
       rg_mode_(0),
       rg_preamp_(0.0),
       rg_compression_(true),
+      rg_fallback_gain_(0),
       buffer_duration_nanosec_(1 * kNsecPerSec),
       buffer_min_fill_(33),
+      buffer_high_fill_(99),
       buffering_(false),
+      buffer_policy_(nullptr),
       mono_playback_(false),
       sample_rate_(GstEngine::kAutoSampleRate),
       end_offset_nanosec_(-1),
@@ -79,9 +93,19 @@ GstEnginePipeline::GstEnginePipeline(GstEngine* engine)
       pipeline_is_initialised_(false),
       pipeline_is_connected_(false),
       pending_seek_nanosec_(-1),
+      seek_started_usec_(0),
+      queued_seek_nanosec_(-1),
+      queued_seek_flags_(GST_SEEK_FLAG_NONE),
+      seek_audio_since_usec_(0),
       last_known_position_ns_(0),
       volume_percent_(100),
       volume_modifier_(1.0),
+      fader_start_msec_(0),
+      use_fudge_timer_(true),
+      fader_control_(nullptr),
+      fader_binding_(nullptr),
+      volume_stream_time_(-1),
+      fader_schedule_pending_(0),
       uridecodebin_(nullptr),
       audiobin_(nullptr),
       queue_(nullptr),
@@ -89,8 +113,7 @@ GstEnginePipeline::GstEnginePipeline(GstEngine* engine)
       rgvolume_(nullptr),
       rglimiter_(nullptr),
       audioconvert2_(nullptr),
-      equalizer_(nullptr),
-      stereo_panorama_(nullptr),
+      dsp_(nullptr),
       volume_(nullptr),
       audioscale_(nullptr),
       audiosink_(nullptr),
@@ -128,12 +151,44 @@ void GstEnginePipeline::set_buffer_min_fill(int percent) {
   buffer_min_fill_ = percent;
 }
 
+void GstEnginePipeline::set_buffer_high_fill(int percent) {
+  buffer_high_fill_ = percent;
+}
+
 void GstEnginePipeline::set_mono_playback(bool enabled) {
   mono_playback_ = enabled;
 }
 
 void GstEnginePipeline::set_sample_rate(int rate) { sample_rate_ = rate; }
 
+void GstEnginePipeline::SetSinkDevice(GstElement* sink,
+                                      const QVariant& device) {
+  if (g_object_class_find_property(G_OBJECT_GET_CLASS(sink), "device") &&
+      !device.toString().isEmpty()) {
+    switch (device.type()) {
+      case QVariant::Int:
+        g_object_set(G_OBJECT(sink), "device", device.toInt(), nullptr);
+        break;
+      case QVariant::LongLong:
+        g_object_set(G_OBJECT(sink), "device", device.toLongLong(), nullptr);
+        break;
+      case QVariant::String:
+        g_object_set(G_OBJECT(sink), "device",
+                     device.toString().toUtf8().constData(), nullptr);
+        break;
+      case QVariant::ByteArray: {
+        g_object_set(G_OBJECT(sink), "device",
+                     device.toByteArray().constData(), nullptr);
+        break;
+      }
+
+      default:
+        qLog(Warning) << "Unknown device type" << device;
+        break;
+    }
+  }
+}
+
 bool GstEnginePipeline::ReplaceDecodeBin(GstElement* new_bin) {
   if (!new_bin) return false;
 
@@ -213,8 +268,9 @@ bool GstEnginePipeline::InitAudioBin() {
   // samples for the scope, the other is kept as float32 and sent to the
   // speaker.
   //   tee1 ! probe_queue ! probe_converter ! <caps16> ! probe_sink
-  //   tee2 ! audio_queue ! equalizer_preamp ! equalizer ! volume ! audioscale
-  //        ! convert ! audiosink
+  //   tee2 ! audio_queue ! dsp ! volume ! audioscale ! convert ! audiosink
+  // dsp is our own element that does the equalizer's preamp, the equalizer
+  // and the stereo balance in one go.
 
   gst_segment_init(&last_decodebin_segment_, GST_FORMAT_TIME);
 
@@ -229,31 +285,7 @@ bool GstEnginePipeline::InitAudioBin() {
     return false;
   }
 
-  if (g_object_class_find_property(G_OBJECT_GET_CLASS(audiosink_), "device") &&
-      !device_.toString().isEmpty()) {
-    switch (device_.type()) {
-      case QVariant::Int:
-        g_object_set(G_OBJECT(audiosink_), "device", device_.toInt(), nullptr);
-        break;
-      case QVariant::LongLong:
-        g_object_set(G_OBJECT(audiosink_), "device", device_.toLongLong(),
-                     nullptr);
-        break;
-      case QVariant::String:
-        g_object_set(G_OBJECT(audiosink_), "device",
-                     device_.toString().toUtf8().constData(), nullptr);
-        break;
-      case QVariant::ByteArray: {
-        g_object_set(G_OBJECT(audiosink_), "device",
-                     device_.toByteArray().constData(), nullptr);
-        break;
-      }
-
-      default:
-        qLog(Warning) << "Unknown device type" << device_;
-        break;
-    }
-  }
+  SetSinkDevice(audiosink_, device_);
 
   // Create all the other elements
   GstElement *probe_queue, *probe_converter, *probe_sink, *audio_queue,
@@ -268,18 +300,15 @@ bool GstEnginePipeline::InitAudioBin() {
   probe_sink = engine_->CreateElement("fakesink", audiobin_);
 
   audio_queue = engine_->CreateElement("queue", audiobin_);
-  equalizer_preamp_ = engine_->CreateElement("volume", audiobin_);
-  equalizer_ = engine_->CreateElement("equalizer-nbands", audiobin_);
-  stereo_panorama_ = engine_->CreateElement("audiopanorama", audiobin_);
+  dsp_ = engine_->CreateElement("clementinedsp", audiobin_);
   volume_ = engine_->CreateElement("volume", audiobin_);
   audioscale_ = engine_->CreateElement("audioresample", audiobin_);
   convert = engine_->CreateElement("audioconvert", audiobin_);
   capsfilter_ = engine_->CreateElement("capsfilter", audiobin_);
 
   if (!queue_ || !audioconvert_ || !tee_ || !probe_queue || !probe_converter ||
-      !probe_sink || !audio_queue || !equalizer_preamp_ || !equalizer_ ||
-      !stereo_panorama_ || !volume_ || !audioscale_ || !convert ||
-      !capsfilter_) {
+      !probe_sink || !audio_queue || !dsp_ || !volume_ || !audioscale_ ||
+      !convert || !capsfilter_) {
     qLog(Error) << "Failed to create elements";
     return false;
   }
@@ -308,6 +337,13 @@ bool GstEnginePipeline::InitAudioBin() {
     g_object_set(G_OBJECT(rgvolume_), "pre-amp", double(rg_preamp_), nullptr);
     g_object_set(G_OBJECT(rglimiter_), "enabled", int(rg_compression_),
                  nullptr);
+
+    // rgvolume works out its gain again when each track starts, so that's
+    // when it has to be given the new track's fallback.
+    GstPad* rg_pad = gst_element_get_static_pad(rgvolume_, "sink");
+    gst_pad_add_probe(rg_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                      &RgStreamStartProbe, this, nullptr);
+    gst_object_unref(rg_pad);
   }
 
   // Create a pad on the outside of the audiobin and connect it to the pad of
@@ -327,48 +363,8 @@ bool GstEnginePipeline::InitAudioBin() {
   // Configure the fakesink properly
   g_object_set(G_OBJECT(probe_sink), "sync", TRUE, nullptr);
 
-  // Setting the equalizer bands:
-  //
-  // GStreamer's GstIirEqualizerNBands sets up shelve filters for the first and
-  // last bands as corner cases. That was causing the "inverted slider" bug.
-  // As a workaround, we create two dummy bands at both ends of the spectrum.
-  // This causes the actual first and last adjustable bands to be
-  // implemented using band-pass filters.
-
-  g_object_set(G_OBJECT(equalizer_), "num-bands", 10 + 2, nullptr);
-
-  // Dummy first band (bandwidth 0, cutting below 20Hz):
-  GstObject* first_band = GST_OBJECT(
-      gst_child_proxy_get_child_by_index(GST_CHILD_PROXY(equalizer_), 0));
-  g_object_set(G_OBJECT(first_band), "freq", 20.0, "bandwidth", 0, "gain", 0.0f,
-               nullptr);
-  g_object_unref(G_OBJECT(first_band));
-
-  // Dummy last band (bandwidth 0, cutting over 20KHz):
-  GstObject* last_band = GST_OBJECT(gst_child_proxy_get_child_by_index(
-      GST_CHILD_PROXY(equalizer_), kEqBandCount + 1));
-  g_object_set(G_OBJECT(last_band), "freq", 20000.0, "bandwidth", 0, "gain",
-               0.0f, nullptr);
-  g_object_unref(G_OBJECT(last_band));
-
-  int last_band_frequency = 0;
-  for (int i = 0; i < kEqBandCount; ++i) {
-    const int index_in_eq = i + 1;
-    GstObject* band = GST_OBJECT(gst_child_proxy_get_child_by_index(
-        GST_CHILD_PROXY(equalizer_), index_in_eq));
-
-    const float frequency = kEqBandFrequencies[i];
-    const float bandwidth = frequency - last_band_frequency;
-    last_band_frequency = frequency;
-
-    g_object_set(G_OBJECT(band), "freq", frequency, "bandwidth", bandwidth,
-                 "gain", 0.0f, nullptr);
-    g_object_unref(G_OBJECT(band));
-  }
-
   // Set the stereo balance.
-  g_object_set(G_OBJECT(stereo_panorama_), "panorama", stereo_balance_,
-               nullptr);
+  g_object_set(G_OBJECT(dsp_), "panorama", stereo_balance_, nullptr);
 
   // Set the buffer duration.  We set this on this queue instead of the
   // decode bin (in ReplaceDecodeBin()) because setting it on the decode bin
@@ -380,6 +376,7 @@ bool GstEnginePipeline::InitAudioBin() {
   g_object_set(G_OBJECT(queue_), "max-size-time", buffer_duration_nanosec_,
                nullptr);
   g_object_set(G_OBJECT(queue_), "low-percent", buffer_min_fill_, nullptr);
+  g_object_set(G_OBJECT(queue_), "high-percent", buffer_high_fill_, nullptr);
 
   if (buffer_duration_nanosec_ > 0) {
     g_object_set(G_OBJECT(queue_), "use-buffering", true, nullptr);
@@ -424,8 +421,7 @@ bool GstEnginePipeline::InitAudioBin() {
   // Link the analyzer output of the tee
   gst_element_link(probe_queue, probe_converter);
 
-  gst_element_link_many(audio_queue, equalizer_preamp_, equalizer_,
-                        stereo_panorama_, volume_, audioscale_, convert,
+  gst_element_link_many(audio_queue, dsp_, volume_, audioscale_, convert,
                         nullptr);
 
   // We only limit the media type to raw audio.
@@ -444,11 +440,24 @@ bool GstEnginePipeline::InitAudioBin() {
   gst_element_link_filtered(convert, audiosink_, caps);
   gst_caps_unref(caps);
 
+  // Fades are a curve on the volume, which is only switched on while there's
+  // a fade.  Absolute so the curve's values are the volume itself.
+  fader_control_ = gst_interpolation_control_source_new();
+  g_object_set(G_OBJECT(fader_control_), "mode",
+               GST_INTERPOLATION_MODE_LINEAR, nullptr);
+  fader_binding_ = gst_direct_control_binding_new_absolute(
+      GST_OBJECT(volume_), "volume", fader_control_);
+  gst_object_add_control_binding(GST_OBJECT(volume_), fader_binding_);
+  gst_control_binding_set_disabled(fader_binding_, TRUE);
+
   // Add probes and handlers.
   pad = gst_element_get_static_pad(probe_converter, "src");
   gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, HandoffCallback, this,
                     nullptr);
   gst_object_unref(pad);
+  pad = gst_element_get_static_pad(volume_, "sink");
+  gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, FaderProbe, this, nullptr);
+  gst_object_unref(pad);
   GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
   gst_bus_set_sync_handler(bus, BusCallbackSync, this, nullptr);
   gst_bus_add_watch(bus, BusCallback, this);
@@ -490,6 +499,7 @@ bool GstEnginePipeline::InitFromReq(const MediaPlaybackRequest& req,
   if (!Init()) return false;
 
   current_ = req;
+  UpdateFallbackGain();
   QUrl url = current_.url_;
 #ifdef HAVE_AUDIOCD
   if (url.scheme() == "cdda" && !url.path().isEmpty()) {
@@ -513,10 +523,68 @@ bool GstEnginePipeline::InitFromReq(const MediaPlaybackRequest& req,
   // Link decoder and audio bins if decoder bin already has a src pad.
   MaybeLinkDecodeToAudio();
 
+  // CD tracks need their source device set up from scratch.
+  reusable_ = url.scheme() != "cdda";
+  return true;
+}
+
+bool GstEnginePipeline::Reuse(const MediaPlaybackRequest& req,
+                              qint64 end_nanosec) {
+  if (!reusable_ || req.url_.scheme() == "cdda") return false;
+
+  // READY keeps the audio bin's elements and the output device open, but
+  // drops whatever the old decoder had queued and resets the running time.
+  if (gst_element_set_state(pipeline_, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE) {
+    return false;
+  }
+
+  ReportThroughput();
+
+  // Messages from the old track mustn't be mistaken for the new one's.
+  GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
+  gst_bus_set_flushing(bus, TRUE);
+  gst_bus_set_flushing(bus, FALSE);
+  gst_object_unref(bus);
+
+  // ReplaceDecodeBin drops the bin's reference to it, so it has to be shut
+  // down first.
+  gst_element_set_state(uridecodebin_, GST_STATE_NULL);
+
+  current_ = req;
+  UpdateFallbackGain();
+  next_ = MediaPlaybackRequest();
+  end_offset_nanosec_ = end_nanosec;
+  next_beginning_offset_nanosec_ = 0;
+  next_end_offset_nanosec_ = 0;
+  ignore_next_seek_ = false;
+  emit_track_ended_on_stream_start_ = false;
+  emit_track_ended_on_time_discontinuity_ = false;
+  last_buffer_offset_ = 0;
+  buffering_ = false;
+  redirect_url_ = QUrl();
+  pending_seek_nanosec_ = -1;
+  seek_started_usec_ = 0;
+  queued_seek_nanosec_ = -1;
+  last_known_position_ns_ = 0;
+
+  // Going to READY reset the running time, so the new decoder's buffers
+  // mustn't be offset to follow on from the old one's like they are for
+  // gapless playback.
+  gst_segment_init(&last_decodebin_segment_, GST_FORMAT_TIME);
+
+  if (!ReplaceDecodeBin(current_.url_)) {
+    reusable_ = false;
+    return false;
+  }
+
+  MaybeLinkDecodeToAudio();
   return true;
 }
 
 GstEnginePipeline::~GstEnginePipeline() {
+  ReportThroughput();
+
   if (pipeline_) {
     GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
     gst_bus_remove_watch(bus);
@@ -539,6 +607,8 @@ GstEnginePipeline::~GstEnginePipeline() {
       }
     }
   }
+
+  if (fader_control_) gst_object_unref(fader_control_);
 }
 
 gboolean GstEnginePipeline::BusCallback(GstBus*, GstMessage* msg,
@@ -604,6 +674,10 @@ GstBusSyncReply GstEnginePipeline::BusCallbackSync(GstBus*, GstMessage* msg,
       instance->StreamStatusMessageReceived(msg);
       break;
 
+    case GST_MESSAGE_ASYNC_DONE:
+      QMetaObject::invokeMethod(instance, "SeekDone", Qt::QueuedConnection);
+      break;
+
     case GST_MESSAGE_STREAM_START:
       if (instance->emit_track_ended_on_stream_start_) {
         qLog(Debug) << "New segment started, EOS will signal on next buffer "
@@ -772,10 +846,39 @@ void GstEnginePipeline::StateChangedMessageReceived(GstMessage* msg) {
   }
 }
 
+void GstEnginePipeline::RecordThroughput(GstMessage* msg) {
+  if (!buffer_policy_ || current_.url_.isLocalFile()) return;
+
+  GstBufferingMode mode;
+  gint avg_in = 0;
+  gint avg_out = 0;
+  gint64 buffering_left = 0;
+  gst_message_parse_buffering_stats(msg, &mode, &avg_in, &avg_out,
+                                    &buffering_left);
+  if (mode != GST_BUFFERING_STREAM && mode != GST_BUFFERING_DOWNLOAD) return;
+
+  QMutexLocker l(&throughput_mutex_);
+  throughput_[current_.url_.host()].AddSample(avg_in, avg_out);
+}
+
+void GstEnginePipeline::ReportThroughput() {
+  QMap<QString, ThroughputStats> throughput;
+  {
+    QMutexLocker l(&throughput_mutex_);
+    throughput.swap(throughput_);
+  }
+
+  if (!buffer_policy_) return;
+  for (auto it = throughput.begin(); it != throughput.end(); ++it) {
+    buffer_policy_->AddMeasurement(it.key(), it.value());
+  }
+}
+
 void GstEnginePipeline::BufferingMessageReceived(GstMessage* msg) {
   // Only handle buffering messages from the queue2 element in audiobin - not
   // the one that's created automatically by uridecodebin.
   if (GST_ELEMENT(GST_MESSAGE_SRC(msg)) != queue_) {
+    RecordThroughput(msg);
     return;
   }
 
@@ -792,6 +895,11 @@ void GstEnginePipeline::BufferingMessageReceived(GstMessage* msg) {
   const GstState current_state = state();
 
   if (percent == 0 && current_state == GST_STATE_PLAYING && !buffering_) {
+    static metrics::Counter* underruns = metrics::GetCounter(
+        "clementine_engine_underruns_total",
+        "Times playback paused because the stream's buffer ran out");
+    underruns->Increment();
+
     buffering_ = true;
     emit BufferingStarted();
 
@@ -899,6 +1007,14 @@ GstPadProbeReturn GstEnginePipeline::DecodebinProbe(GstPad* pad,
   const GstPadProbeType info_type = GST_PAD_PROBE_INFO_TYPE(info);
 
   if (info_type & GST_PAD_PROBE_TYPE_BUFFER) {
+    const qint64 first_decoded_since =
+        instance->first_decoded_since_usec_.fetchAndStoreRelaxed(0);
+    if (first_decoded_since) {
+      emit instance->LatencyMeasured(
+          instance->id(), "Gapless decoder start",
+          g_get_monotonic_time() - first_decoded_since);
+    }
+
     // The decodebin produced a buffer.  Record its end time, so we can offset
     // the buffers produced by the next decodebin when transitioning to the next
     // song.
@@ -933,21 +1049,60 @@ GstPadProbeReturn GstEnginePipeline::DecodebinProbe(GstPad* pad,
   return GST_PAD_PROBE_OK;
 }
 
+GstPadProbeReturn GstEnginePipeline::FaderProbe(GstPad* pad,
+                                                GstPadProbeInfo* info,
+                                                gpointer self) {
+  GstEnginePipeline* instance = reinterpret_cast<GstEnginePipeline*>(self);
+  GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+  if (!GST_BUFFER_PTS_IS_VALID(buf)) return GST_PAD_PROBE_OK;
+
+  // The volume element looks the curve up by stream time.
+  GstClockTime end = GST_BUFFER_PTS(buf);
+  if (GST_BUFFER_DURATION_IS_VALID(buf)) end += GST_BUFFER_DURATION(buf);
+  GstEvent* event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+  if (event) {
+    const GstSegment* segment = nullptr;
+    gst_event_parse_segment(event, &segment);
+    end = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, end);
+    gst_event_unref(event);
+  }
+  if (!GST_CLOCK_TIME_IS_VALID(end)) return GST_PAD_PROBE_OK;
+
+  instance->volume_stream_time_.store(end);
+  if (instance->fader_schedule_pending_.testAndSetOrdered(1, 0)) {
+    QMetaObject::invokeMethod(instance, "ScheduleFade", Qt::QueuedConnection);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
 GstPadProbeReturn GstEnginePipeline::HandoffCallback(GstPad*,
                                                      GstPadProbeInfo* info,
                                                      gpointer self) {
   GstEnginePipeline* instance = reinterpret_cast<GstEnginePipeline*>(self);
   GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
 
-  QList<BufferConsumer*> consumers;
-  {
-    QMutexLocker l(&instance->buffer_consumers_mutex_);
-    consumers = instance->buffer_consumers_;
+  const qint64 first_audio_since =
+      instance->first_audio_since_usec_.fetchAndStoreRelaxed(0);
+  if (first_audio_since) {
+    emit instance->LatencyMeasured(instance->id(), "Play to first audio",
+                                   g_get_monotonic_time() - first_audio_since);
   }
 
-  for (BufferConsumer* consumer : consumers) {
-    gst_buffer_ref(buf);
-    consumer->ConsumeBuffer(buf, instance->id());
+  const qint64 seek_audio_since =
+      instance->seek_audio_since_usec_.fetchAndStoreRelaxed(0);
+  if (seek_audio_since) {
+    emit instance->LatencyMeasured(instance->id(), "Seek to audio",
+                                   g_get_monotonic_time() - seek_audio_since);
+  }
+
+  if (instance->buffer_consumer_count_.load() > 0) {
+    instance->buffer_ring_.Push(gst_buffer_ref(buf));
+
+    // Only wake up the consumers' thread once per batch of buffers.
+    if (instance->buffer_ring_drain_pending_.testAndSetOrdered(0, 1)) {
+      QMetaObject::invokeMethod(instance, "DrainBufferRing",
+                                Qt::QueuedConnection);
+    }
   }
 
   // Calculate the end time of this buffer so we can stop playback if it's
@@ -1027,6 +1182,32 @@ GstPadProbeReturn GstEnginePipeline::EventHandoffCallback(GstPad*,
   return GST_PAD_PROBE_OK;
 }
 
+GstPadProbeReturn GstEnginePipeline::RgStreamStartProbe(GstPad*,
+                                                        GstPadProbeInfo* info,
+                                                        gpointer self) {
+  GstEnginePipeline* instance = reinterpret_cast<GstEnginePipeline*>(self);
+  GstEvent* e = GST_PAD_PROBE_INFO_EVENT(info);
+
+  if (GST_EVENT_TYPE(e) == GST_EVENT_STREAM_START) {
+    g_object_set(G_OBJECT(instance->rgvolume_), "fallback-gain",
+                 instance->rg_fallback_gain_.loadAcquire() / 100.0, nullptr);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+void GstEnginePipeline::UpdateFallbackGain() {
+  // Album mode falls back to the track gain if there's no album gain, like
+  // rgvolume does with tags.
+  float gain = current_.track_gain_;
+  if (rg_mode_ == 1 && !std::isnan(current_.album_gain_)) {
+    gain = current_.album_gain_;
+  }
+
+  // rgvolume only adds the pre-amp to gains from tags.
+  rg_fallback_gain_.storeRelease(
+      std::isnan(gain) ? 0 : qRound((gain + rg_preamp_) * 100));
+}
+
 void GstEnginePipeline::SourceDrainedCallback(GstURIDecodeBin* bin,
                                               gpointer self) {
   GstEnginePipeline* instance = reinterpret_cast<GstEnginePipeline*>(self);
@@ -1100,6 +1281,7 @@ void GstEnginePipeline::TransitionToNext() {
   GstElement* old_decode_bin = uridecodebin_;
 
   ignore_tags_ = true;
+  first_decoded_since_usec_.store(g_get_monotonic_time());
 
   if (!ReplaceDecodeBin(next_.url_)) {
     qLog(Error) << "ReplaceDecodeBin failed with " << next_.url_;
@@ -1109,6 +1291,7 @@ void GstEnginePipeline::TransitionToNext() {
   MaybeLinkDecodeToAudio();
 
   current_ = next_;
+  UpdateFallbackGain();
   end_offset_nanosec_ = next_end_offset_nanosec_;
   next_ = MediaPlaybackRequest();
   next_beginning_offset_nanosec_ = 0;
@@ -1126,6 +1309,10 @@ void GstEnginePipeline::TransitionToNext() {
   ignore_tags_ = false;
 }
 
+void GstEnginePipeline::MeasureTimeToFirstAudio() {
+  first_audio_since_usec_.store(g_get_monotonic_time());
+}
+
 qint64 GstEnginePipeline::position() const {
   if (pipeline_is_initialised_)
     gst_element_query_position(pipeline_, GST_FORMAT_TIME,
@@ -1167,9 +1354,57 @@ bool GstEnginePipeline::Seek(qint64 nanosec) {
   }
 
   pending_seek_nanosec_ = -1;
+  return DoSeek(nanosec, GstSeekFlags(GST_SEEK_FLAG_FLUSH |
+                                      GST_SEEK_FLAG_ACCURATE));
+}
+
+bool GstEnginePipeline::SeekFast(qint64 nanosec) {
+  if (!pipeline_is_connected_ || !pipeline_is_initialised_) {
+    pending_seek_nanosec_ = nanosec;
+    return true;
+  }
+
+  pending_seek_nanosec_ = -1;
+  return DoSeek(nanosec, GstSeekFlags(GST_SEEK_FLAG_FLUSH |
+                                      GST_SEEK_FLAG_KEY_UNIT |
+                                      GST_SEEK_FLAG_SNAP_NEAREST));
+}
+
+bool GstEnginePipeline::DoSeek(qint64 nanosec, GstSeekFlags flags) {
   last_known_position_ns_ = nanosec;
-  return gst_element_seek_simple(pipeline_, GST_FORMAT_TIME,
-                                 GST_SEEK_FLAG_FLUSH, nanosec);
+
+  const qint64 now = g_get_monotonic_time();
+  if (seek_started_usec_ && now - seek_started_usec_ < kSeekTimeoutUsec) {
+    queued_seek_nanosec_ = nanosec;
+    queued_seek_flags_ = flags;
+    return true;
+  }
+
+  queued_seek_nanosec_ = -1;
+  seek_started_usec_ = now;
+  seek_audio_since_usec_.store(now);
+  if (!gst_element_seek_simple(pipeline_, GST_FORMAT_TIME, flags, nanosec)) {
+    seek_started_usec_ = 0;
+    seek_audio_since_usec_.store(0);
+    return false;
+  }
+
+  // The fade's curve was for the old stream times.
+  volume_stream_time_.store(-1);
+  if (fader_) ScheduleFade();
+  return true;
+}
+
+void GstEnginePipeline::SeekDone() {
+  seek_started_usec_ = 0;
+
+  if (queued_seek_nanosec_ != -1) {
+    const qint64 nanosec = queued_seek_nanosec_;
+    queued_seek_nanosec_ = -1;
+    if (!DoSeek(nanosec, queued_seek_flags_)) {
+      qLog(Warning) << "Queued seek failed";
+    }
+  }
 }
 
 void GstEnginePipeline::SetEqualizerEnabled(bool enabled) {
@@ -1198,12 +1433,8 @@ void GstEnginePipeline::UpdateEqualizer() {
     else
       gain *= 0.12;
 
-    const int index_in_eq = i + 1;
-    // Offset because of the first dummy band we created.
-    GstObject* band = GST_OBJECT(gst_child_proxy_get_child_by_index(
-        GST_CHILD_PROXY(equalizer_), index_in_eq));
-    g_object_set(G_OBJECT(band), "gain", gain, nullptr);
-    g_object_unref(G_OBJECT(band));
+    const QByteArray name = QString("band%1").arg(i).toLatin1();
+    g_object_set(G_OBJECT(dsp_), name.constData(), gain, nullptr);
   }
 
   // Update preamp
@@ -1211,13 +1442,12 @@ void GstEnginePipeline::UpdateEqualizer() {
   if (eq_enabled_)
     preamp = float(eq_preamp_ + 100) * 0.01;  // To scale from 0.0 to 2.0
 
-  g_object_set(G_OBJECT(equalizer_preamp_), "volume", preamp, nullptr);
+  g_object_set(G_OBJECT(dsp_), "preamp", preamp, nullptr);
 }
 
 void GstEnginePipeline::UpdateStereoBalance() {
-  if (stereo_panorama_) {
-    g_object_set(G_OBJECT(stereo_panorama_), "panorama", stereo_balance_,
-                 nullptr);
+  if (dsp_) {
+    g_object_set(G_OBJECT(dsp_), "panorama", stereo_balance_, nullptr);
   }
 }
 
@@ -1226,14 +1456,23 @@ void GstEnginePipeline::SetVolume(int percent) {
   UpdateVolume();
 }
 
-void GstEnginePipeline::SetVolumeModifier(qreal mod) {
-  volume_modifier_ = mod;
-  UpdateVolume();
+void GstEnginePipeline::UpdateVolume() {
+  // The fade's curve has the volume in it too.
+  if (fader_) {
+    ScheduleFade();
+  } else {
+    HoldVolume();
+  }
 }
 
-void GstEnginePipeline::UpdateVolume() {
-  float vol = double(volume_percent_) * 0.01 * volume_modifier_;
-  g_object_set(G_OBJECT(volume_), "volume", vol, nullptr);
+void GstEnginePipeline::HoldVolume() {
+  if (fader_binding_) gst_control_binding_set_disabled(fader_binding_, TRUE);
+  g_object_set(G_OBJECT(volume_), "volume", VolumeFor(volume_modifier_),
+               nullptr);
+}
+
+double GstEnginePipeline::VolumeFor(qreal modifier) const {
+  return double(volume_percent_) * 0.01 * modifier;
 }
 
 void GstEnginePipeline::SetOutputFormat(const QString& format) {
@@ -1253,35 +1492,90 @@ void GstEnginePipeline::StartFader(qint64 duration_nanosec,
   // If there's already another fader running then start from the same time
   // that one was already at.
   int start_time = direction == QTimeLine::Forward ? 0 : duration_msec;
-  if (fader_ && fader_->state() == QTimeLine::Running) {
+  if (fader_) {
     if (duration_msec == fader_->duration()) {
-      start_time = fader_->currentTime();
+      start_time = FaderTime();
     } else {
       // Calculate the position in the new fader with the same value from
       // the old fader, so no volume jumps appear
       qreal time = qreal(duration_msec) *
-                   (qreal(fader_->currentTime()) / qreal(fader_->duration()));
+                   (qreal(FaderTime()) / qreal(fader_->duration()));
       start_time = qRound(time);
     }
   }
 
   fader_.reset(new QTimeLine(duration_msec, this));
-  connect(fader_.get(), SIGNAL(valueChanged(qreal)),
-          SLOT(SetVolumeModifier(qreal)));
-  connect(fader_.get(), SIGNAL(finished()), SLOT(FaderTimelineFinished()));
   fader_->setDirection(direction);
   fader_->setCurveShape(shape);
-  fader_->setCurrentTime(start_time);
-  fader_->resume();
+  fader_start_msec_ = start_time;
+  fader_clock_.start();
 
   fader_fudge_timer_.stop();
   use_fudge_timer_ = use_fudge_timer;
 
-  SetVolumeModifier(fader_->currentValue());
+  ScheduleFade();
+}
+
+int GstEnginePipeline::FaderTime() const {
+  if (!fader_clock_.isValid()) return fader_start_msec_;
+
+  const int elapsed = fader_clock_.elapsed();
+  if (fader_->direction() == QTimeLine::Forward) {
+    return qMin(fader_->duration(), fader_start_msec_ + elapsed);
+  }
+  return qMax(0, fader_start_msec_ - elapsed);
+}
+
+void GstEnginePipeline::ScheduleFade() {
+  fader_schedule_pending_.store(0);
+  if (!fader_) return;
+
+  const int now_msec = FaderTime();
+  volume_modifier_ = fader_->valueForTime(now_msec);
+  fader_start_msec_ = now_msec;
+
+  const qint64 stream_time = volume_stream_time_.load();
+  if (stream_time < 0) {
+    // Stay where the fade is until FaderProbe says when "now" is in the
+    // stream, and carry on from there.
+    fader_clock_.invalidate();
+    fader_end_timer_.stop();
+    HoldVolume();
+    fader_schedule_pending_.store(1);
+    return;
+  }
+
+  const int end_msec =
+      fader_->direction() == QTimeLine::Forward ? fader_->duration() : 0;
+  const int remaining_msec = qAbs(end_msec - now_msec);
+  const int steps = fader_->curveShape() == QTimeLine::LinearCurve
+                        ? 1
+                        : qMax(1, remaining_msec / kFaderStepMsec);
+
+  GstTimedValueControlSource* source =
+      GST_TIMED_VALUE_CONTROL_SOURCE(fader_control_);
+  gst_timed_value_control_source_unset_all(source);
+  for (int i = 0; i <= steps; ++i) {
+    const int offset_msec = qint64(remaining_msec) * i / steps;
+    const int msec =
+        end_msec > now_msec ? now_msec + offset_msec : now_msec - offset_msec;
+    gst_timed_value_control_source_set(
+        source, stream_time + qint64(offset_msec) * kNsecPerMsec,
+        VolumeFor(fader_->valueForTime(msec)));
+  }
+  gst_control_binding_set_disabled(fader_binding_, FALSE);
+
+  // The main thread only has to wake up once more, at the end.
+  fader_clock_.start();
+  fader_end_timer_.start(remaining_msec, this);
 }
 
 void GstEnginePipeline::FaderTimelineFinished() {
+  fader_end_timer_.stop();
+  fader_schedule_pending_.store(0);
+  volume_modifier_ = fader_->valueForTime(FaderTime());
   fader_.reset();
+  HoldVolume();
 
   // Wait a little while longer before emitting the finished signal (and
   // probably destroying the pipeline) to account for delays in the audio
@@ -1298,6 +1592,11 @@ void GstEnginePipeline::FaderTimelineFinished() {
 }
 
 void GstEnginePipeline::timerEvent(QTimerEvent* e) {
+  if (e->timerId() == fader_end_timer_.timerId()) {
+    FaderTimelineFinished();
+    return;
+  }
+
   if (e->timerId() == fader_fudge_timer_.timerId()) {
     fader_fudge_timer_.stop();
     emit FaderFinished();
@@ -1310,16 +1609,40 @@ void GstEnginePipeline::timerEvent(QTimerEvent* e) {
 void GstEnginePipeline::AddBufferConsumer(BufferConsumer* consumer) {
   QMutexLocker l(&buffer_consumers_mutex_);
   buffer_consumers_ << consumer;
+  buffer_consumer_count_.store(buffer_consumers_.count());
 }
 
 void GstEnginePipeline::RemoveBufferConsumer(BufferConsumer* consumer) {
   QMutexLocker l(&buffer_consumers_mutex_);
   buffer_consumers_.removeAll(consumer);
+  buffer_consumer_count_.store(buffer_consumers_.count());
 }
 
 void GstEnginePipeline::RemoveAllBufferConsumers() {
   QMutexLocker l(&buffer_consumers_mutex_);
   buffer_consumers_.clear();
+  buffer_consumer_count_.store(0);
+}
+
+void GstEnginePipeline::DrainBufferRing() {
+  // Clear the flag first so a buffer pushed while we're draining schedules
+  // another call.
+  buffer_ring_drain_pending_.store(0);
+  const QList<GstBuffer*> buffers = buffer_ring_.TakeAll();
+
+  QList<BufferConsumer*> consumers;
+  {
+    QMutexLocker l(&buffer_consumers_mutex_);
+    consumers = buffer_consumers_;
+  }
+
+  for (GstBuffer* buf : buffers) {
+    for (BufferConsumer* consumer : consumers) {
+      gst_buffer_ref(buf);
+      consumer->ConsumeBuffer(buf, id());
+    }
+    gst_buffer_unref(buf);
+  }
 }
 
 void GstEnginePipeline::SetNextReq(const MediaPlaybackRequest& req,
@@ -18,7 +18,9 @@
 #ifndef GSTENGINEPIPELINE_H
 #define GSTENGINEPIPELINE_H
 
+#include <QAtomicInteger>
 #include <QBasicTimer>
+#include <QElapsedTimer>
 #include <QFuture>
 #include <QMutex>
 #include <QThreadPool>
@@ -26,9 +28,11 @@
 #include <QUrl>
 #include <memory>
 
+#include "bufferring.h"
 #include "engine_fwd.h"
 #include "gstpipelinebase.h"
 #include "playbackrequest.h"
+#include "streambufferpolicy.h"
 
 class GstElementDeleter;
 class GstEngine;
@@ -49,15 +53,31 @@ class GstEnginePipeline : public GstPipelineBase {
   void set_replaygain(bool enabled, int mode, float preamp, bool compression);
   void set_buffer_duration_nanosec(qint64 duration_nanosec);
   void set_buffer_min_fill(int percent);
+  void set_buffer_high_fill(int percent);
+  // Streams' download throughput is reported to policy when they finish.
+  // It must outlive the pipeline.
+  void set_buffer_policy(StreamBufferPolicy* policy) {
+    buffer_policy_ = policy;
+  }
   void set_mono_playback(bool enabled);
   void set_sample_rate(int rate);
   void set_format(const QString& format) { format_ = format; }
 
+  // Sets the sink's "device" property, if it has one and device isn't empty.
+  static void SetSinkDevice(GstElement* sink, const QVariant& device);
+
   // Creates the pipeline, returns false on error
   bool InitFromReq(const MediaPlaybackRequest& req, qint64 end_nanosec);
   bool InitFromString(const QString& pipeline);
 
-  // BufferConsumers get fed audio data.  Thread-safe.
+  // Points a pipeline made by InitFromReq at a different track, keeping the
+  // audio bin and output device and only replacing the decoder.  The pipeline
+  // is left in the READY state.  Returns false if this pipeline can't be
+  // reused, in which case a new one should be made instead.
+  bool Reuse(const MediaPlaybackRequest& req, qint64 end_nanosec);
+
+  // BufferConsumers get fed audio data in this object's thread, never the
+  // streaming thread.  Thread-safe.
   void AddBufferConsumer(BufferConsumer* consumer);
   void RemoveBufferConsumer(BufferConsumer* consumer);
   void RemoveAllBufferConsumers();
@@ -65,10 +85,15 @@ class GstEnginePipeline : public GstPipelineBase {
   // Control the music playback
   QFuture<GstStateChangeReturn> SetState(GstState state);
   Q_INVOKABLE bool Seek(qint64 nanosec);
+  // Seeks to the nearest key frame instead, which is much quicker for
+  // compressed and network streams.
+  bool SeekFast(qint64 nanosec);
   void SetEqualizerEnabled(bool enabled);
   void SetEqualizerParams(int preamp, const QList<int>& band_gains);
   void SetVolume(int percent);
   void SetStereoBalance(float value);
+  // The fade is scheduled in the pipeline, so it's sample accurate and
+  // carries on whatever the main thread is doing.
   void StartFader(qint64 duration_nanosec,
                   QTimeLine::Direction direction = QTimeLine::Forward,
                   QTimeLine::CurveShape shape = QTimeLine::LinearCurve,
@@ -102,9 +127,6 @@ class GstEnginePipeline : public GstPipelineBase {
 
   QString source_device() const { return source_device_; }
 
- public slots:
-  void SetVolumeModifier(qreal mod);
-
  signals:
   void EndOfStreamReached(int pipeline_id, bool has_next_track);
   void MetadataFound(int pipeline_id, const Engine::SimpleMetaBundle& bundle);
@@ -113,6 +135,8 @@ class GstEnginePipeline : public GstPipelineBase {
   void Error(int pipeline_id, const QString& message, int domain,
              int error_code);
   void FaderFinished();
+  // Emitted from the streaming thread.
+  void LatencyMeasured(int pipeline_id, const QString& name, qint64 usec);
 
   void BufferingStarted();
   void BufferingProgress(int percent);
@@ -130,7 +154,10 @@ class GstEnginePipeline : public GstPipelineBase {
   static GstPadProbeReturn HandoffCallback(GstPad*, GstPadProbeInfo*, gpointer);
   static GstPadProbeReturn EventHandoffCallback(GstPad*, GstPadProbeInfo*,
                                                 gpointer);
+  static GstPadProbeReturn FaderProbe(GstPad*, GstPadProbeInfo*, gpointer);
   static GstPadProbeReturn DecodebinProbe(GstPad*, GstPadProbeInfo*, gpointer);
+  static GstPadProbeReturn RgStreamStartProbe(GstPad*, GstPadProbeInfo*,
+                                              gpointer);
   static void SourceDrainedCallback(GstURIDecodeBin*, gpointer);
   static void SourceSetupCallback(GstURIDecodeBin*, GParamSpec* pspec,
                                   gpointer);
@@ -138,11 +165,20 @@ class GstEnginePipeline : public GstPipelineBase {
 
   static QByteArray GstUriFromUrl(const QUrl& url);
 
+  // Works out rgvolume's fallback gain from current_.  Call whenever
+  // current_ changes.
+  void UpdateFallbackGain();
+
   void TagMessageReceived(GstMessage*);
   void ErrorMessageReceived(GstMessage*);
   void ElementMessageReceived(GstMessage*);
   void StateChangedMessageReceived(GstMessage*);
   void BufferingMessageReceived(GstMessage*);
+  // Samples the download rate from the buffering stats of uridecodebin's
+  // own queue.
+  void RecordThroughput(GstMessage*);
+  // Hands the throughput measured so far to buffer_policy_.
+  void ReportThroughput();
   void StreamStatusMessageReceived(GstMessage*);
 
   QString ParseTag(GstTagList* list, const char* tag) const;
@@ -152,6 +188,11 @@ class GstEnginePipeline : public GstPipelineBase {
   GstElement* CreateDecodeBinFromUrl(const QUrl& url);
 
   void UpdateVolume();
+  // Sets the volume element to volume_modifier_ without any fade.
+  void HoldVolume();
+  double VolumeFor(qreal modifier) const;
+  // How far through fader_ the fade is now.
+  int FaderTime() const;
   void UpdateEqualizer();
   void UpdateStereoBalance();
   void SetOutputFormat(const QString& format);
@@ -160,6 +201,14 @@ class GstEnginePipeline : public GstPipelineBase {
 
   void TransitionToNext();
 
+  // Seeks straight away, or if the last seek hasn't finished yet replaces
+  // any seek that's already waiting for it.
+  bool DoSeek(qint64 nanosec, GstSeekFlags flags);
+
+  // Emits LatencyMeasured with the time until the next buffer reaches the
+  // output.
+  void MeasureTimeToFirstAudio();
+
   // If the decodebin is special (ie. not really a uridecodebin) then it'll have
   // a src pad immediately and we can link it after everything's created.
   void MaybeLinkDecodeToAudio();
@@ -169,12 +218,20 @@ class GstEnginePipeline : public GstPipelineBase {
 
  private slots:
   void FaderTimelineFinished();
+  // Puts the rest of the fade on the volume element's control source, from
+  // the stream time that's about to reach it.
+  void ScheduleFade();
+  // Called when the last flushing seek has finished prerolling.
+  void SeekDone();
+  // Hands the buffers queued by HandoffCallback to the BufferConsumers.
+  void DrainBufferRing();
 
  private:
   static const int kGstStateTimeoutNanosecs;
+  static const qint64 kSeekTimeoutUsec;
   static const int kFaderFudgeMsec;
+  static const int kFaderStepMsec;
   static const int kEqBandCount;
-  static const int kEqBandFrequencies[];
 
   static GstElementDeleter* sElementDeleter;
 
@@ -182,18 +239,30 @@ class GstEnginePipeline : public GstPipelineBase {
 
   // General settings for the pipeline
   bool valid_;
+  bool reusable_;
   QString sink_;
   QVariant device_;
 
-  // These get called when there is a new audio buffer available
+  // These get called when there is a new audio buffer available.  The
+  // streaming thread only pushes buffers onto buffer_ring_, and never takes
+  // buffer_consumers_mutex_, so a slow consumer can't make playback stutter.
   QList<BufferConsumer*> buffer_consumers_;
   QMutex buffer_consumers_mutex_;
+  QAtomicInt buffer_consumer_count_;
+  BufferRing buffer_ring_;
+  QAtomicInt buffer_ring_drain_pending_;
   qint64 segment_start_;
   bool segment_start_received_;
   bool emit_track_ended_on_stream_start_;
   bool emit_track_ended_on_time_discontinuity_;
   qint64 last_buffer_offset_;
 
+  // Monotonic times in microseconds of when we started waiting for the first
+  // buffer to reach the output, or to come out of a new decoder after a
+  // gapless transition.  0 when we're not waiting.
+  QAtomicInteger<qint64> first_audio_since_usec_;
+  QAtomicInteger<qint64> first_decoded_since_usec_;
+
   // Equalizer
   bool eq_enabled_;
   int eq_preamp_;
@@ -209,12 +278,22 @@ class GstEnginePipeline : public GstPipelineBase {
   int rg_mode_;
   float rg_preamp_;
   bool rg_compression_;
+  // The gain rgvolume uses for tracks without tags, in hundredths of a dB.
+  // Set on rgvolume when the track's stream starts, in a streaming thread.
+  QAtomicInt rg_fallback_gain_;
 
   // Buffering
   quint64 buffer_duration_nanosec_;
   int buffer_min_fill_;
+  int buffer_high_fill_;
   bool buffering_;
 
+  // Throughput of the streams played so far, by host.  Written from the
+  // thread that posts buffering messages.
+  StreamBufferPolicy* buffer_policy_;
+  QMutex throughput_mutex_;
+  QMap<QString, ThroughputStats> throughput_;
+
   bool mono_playback_;
   int sample_rate_;
   QString format_;
@@ -256,6 +335,16 @@ class GstEnginePipeline : public GstPipelineBase {
   bool pipeline_is_connected_;
   qint64 pending_seek_nanosec_;
 
+  // Every flushing seek stalls the pipeline until it has prerolled again, so
+  // only one is sent at a time.  Seeks made meanwhile only keep the latest,
+  // which is sent when the first is done.  seek_started_usec_ is the
+  // monotonic time the one in progress was sent, or 0.
+  qint64 seek_started_usec_;
+  qint64 queued_seek_nanosec_;
+  GstSeekFlags queued_seek_flags_;
+  // When the latest seek was sent, until its first buffer reaches the scope.
+  QAtomicInteger<qint64> seek_audio_since_usec_;
+
   // We can only use gst_element_query_position() when the pipeline is in
   // PAUSED nor PLAYING state. Whenever we get a new position (e.g. after a
   // correct call to gst_element_query_position() or after a seek), we store
@@ -266,9 +355,24 @@ class GstEnginePipeline : public GstPipelineBase {
   int volume_percent_;
   qreal volume_modifier_;
 
+  // fader_ is never started, it only gives the length and shape of the fade.
+  // The fade itself is a curve on the volume element's control source, which
+  // GStreamer applies sample by sample in stream time.  fader_clock_ isn't
+  // valid while the fade waits for a buffer to say what the stream time is.
   std::unique_ptr<QTimeLine> fader_;
+  int fader_start_msec_;
+  QElapsedTimer fader_clock_;
+  QBasicTimer fader_end_timer_;
   QBasicTimer fader_fudge_timer_;
   bool use_fudge_timer_;
+  GstControlSource* fader_control_;
+  GstControlBinding* fader_binding_;
+
+  // Set from the streaming thread.  The stream time of the end of the last
+  // buffer that reached the volume element, or -1 if there hasn't been one
+  // since the last seek.
+  QAtomicInteger<qint64> volume_stream_time_;
+  QAtomicInt fader_schedule_pending_;
 
   // Bins
   // uridecodebin ! audiobin
@@ -281,9 +385,7 @@ class GstEnginePipeline : public GstPipelineBase {
   GstElement* rgvolume_;
   GstElement* rglimiter_;
   GstElement* audioconvert2_;
-  GstElement* equalizer_preamp_;
-  GstElement* equalizer_;
-  GstElement* stereo_panorama_;
+  GstElement* dsp_;
   GstElement* volume_;
   GstElement* audioscale_;
   GstElement* audiosink_;
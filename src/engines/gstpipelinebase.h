@@ -33,6 +33,10 @@ class GstPipelineBase : public QObject {
   // Globally unique across all pipelines.
   int id() const { return id_; }
 
+  // Takes the next ID from the same sequence, for things that need to be told
+  // apart from pipelines.
+  static int NewId() { return sId++; }
+
   void DumpGraph();
 
  protected:
@@ -20,14 +20,22 @@
 
 #include <QMap>
 #include <QUrl>
+#include <limits>
 
 class MediaPlaybackRequest {
  public:
   // For local songs and raw streams, the request and media URLs are the same.
-  MediaPlaybackRequest(const QUrl& url) : request_url_(url), url_(url) {}
+  MediaPlaybackRequest(const QUrl& url)
+      : request_url_(url),
+        url_(url),
+        track_gain_(kNoGain),
+        album_gain_(kNoGain) {}
   MediaPlaybackRequest(const QUrl& request_url, const QUrl& media_url)
-      : request_url_(request_url), url_(media_url) {}
-  MediaPlaybackRequest() {}
+      : request_url_(request_url),
+        url_(media_url),
+        track_gain_(kNoGain),
+        album_gain_(kNoGain) {}
+  MediaPlaybackRequest() : track_gain_(kNoGain), album_gain_(kNoGain) {}
 
   const QUrl& RequestUrl() const { return request_url_; }
   const QUrl& MediaUrl() const { return url_; }
@@ -38,6 +46,14 @@ class MediaPlaybackRequest {
 
   typedef QMap<QByteArray, QByteArray> HeaderList;
   HeaderList headers_;
+
+  // Replay Gain measured by the library, in dB, for files that have none in
+  // their tags.  NaN if there's none.
+  float track_gain_;
+  float album_gain_;
+
+ private:
+  static constexpr float kNoGain = std::numeric_limits<float>::quiet_NaN();
 };
 
 #endif  // ENGINES_PLAYBACKREQUEST_H_
@@ -0,0 +1,98 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "spectrumservice.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "analyzers/fht.h"
+#include "enginebase.h"
+
+SpectrumService::SpectrumService(Engine::Base* engine)
+    : engine_(engine), frame_(0), mono_(Engine::Base::kScopeSize / 2) {}
+
+SpectrumService::~SpectrumService() {}
+
+void SpectrumService::MaybeAdvance(int hop_msec) {
+  // Analyzers with the same frame rate ask within a few milliseconds of each
+  // other, so anything well inside the hop is the same frame.
+  if (frame_ != 0 && since_advance_.elapsed() < hop_msec * 3 / 4) return;
+
+  since_advance_.start();
+  ++frame_;
+
+  // Our analyzers need mono, but the engines provide interleaved pcm.  If the
+  // engine has fewer samples than we want the rest are left from last time.
+  int count = 0;
+  const int16_t* samples = engine_->scope_samples(hop_msec, &count);
+  count = std::min(count, static_cast<int>(mono_.size()) * 2);
+  MixToMono(samples, count, mono_.data());
+}
+
+void SpectrumService::MixToMono(const int16_t* samples, int count,
+                                float* mono) {
+  const float kScale = 1.0f / (2 * (1 << 15));
+  const int frames = count / 2;
+  int x = 0;
+
+#if defined(__SSE2__)
+  // madd against ones adds each left and right pair into 32 bits.
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128 scale = _mm_set1_ps(kScale);
+  for (; x + 4 <= frames; x += 4) {
+    const __m128i pairs = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(samples + x * 2));
+    const __m128i sums = _mm_madd_epi16(pairs, ones);
+    _mm_storeu_ps(mono + x, _mm_mul_ps(_mm_cvtepi32_ps(sums), scale));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for (; x + 4 <= frames; x += 4) {
+    const int16x4x2_t pairs = vld2_s16(samples + x * 2);
+    const int32x4_t sums = vaddl_s16(pairs.val[0], pairs.val[1]);
+    vst1q_f32(mono + x, vmulq_n_f32(vcvtq_f32_s32(sums), kScale));
+  }
+#endif
+
+  for (; x < frames; ++x) {
+    mono[x] = (samples[x * 2] + samples[x * 2 + 1]) * kScale;
+  }
+}
+
+const std::vector<float>& SpectrumService::Power2(int exp, int hop_msec) {
+  MaybeAdvance(hop_msec);
+
+  Transform& transform = transforms_[exp];
+  if (!transform.fht_) {
+    transform.fht_.reset(new FHT(exp));
+    transform.power_.resize(transform.fht_->size());
+  }
+
+  if (transform.frame_ != frame_) {
+    const int size = std::min(transform.power_.size(), mono_.size());
+    std::copy(mono_.begin(), mono_.begin() + size, transform.power_.begin());
+    transform.fht_->power2(transform.power_.data());
+    transform.frame_ = frame_;
+  }
+
+  return transform.power_;
+}
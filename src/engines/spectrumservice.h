@@ -0,0 +1,84 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINES_SPECTRUMSERVICE_H_
+#define ENGINES_SPECTRUMSERVICE_H_
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+class FHT;
+
+namespace Engine {
+class Base;
+}
+
+// Transforms the engine's scope for the analyzers.  However many analyzers are
+// showing, the scope is read once per hop, and each size of transform is done
+// once per hop and shared by the analyzers that asked for it.
+//
+// Everything here happens in the GUI thread, like the analyzers' painting,
+// except has_subscribers which the engine may check from anywhere.
+class SpectrumService {
+ public:
+  explicit SpectrumService(Engine::Base* engine);
+  ~SpectrumService();
+
+  // FHT::power2 of the latest 2^exp mono samples, so the first half holds the
+  // power values.  hop_msec is how often the caller wants a new frame, and is
+  // passed on to Engine::Base::scope.
+  const std::vector<float>& Power2(int exp, int hop_msec);
+
+  // How many times the scope has been read.
+  quint64 frame() const { return frame_; }
+
+  // Analyzers subscribe while they're showing.  With no subscribers the
+  // engine doesn't need to keep any samples for us at all.
+  void AddSubscriber() { subscribers_.ref(); }
+  void RemoveSubscriber() { subscribers_.deref(); }
+  bool has_subscribers() const { return subscribers_.load() > 0; }
+
+  // Mixes count interleaved stereo samples down to mono floats in [-1, 1).
+  static void MixToMono(const int16_t* samples, int count, float* mono);
+
+ private:
+  struct Transform {
+    Transform() : frame_(0) {}
+
+    std::unique_ptr<FHT> fht_;
+    std::vector<float> power_;
+    quint64 frame_;
+  };
+
+  void MaybeAdvance(int hop_msec);
+
+  Engine::Base* engine_;
+  QAtomicInt subscribers_;
+
+  QElapsedTimer since_advance_;
+  quint64 frame_;
+  std::vector<float> mono_;
+
+  // Keyed by the size exponent.
+  std::map<int, Transform> transforms_;
+};
+
+#endif  // ENGINES_SPECTRUMSERVICE_H_
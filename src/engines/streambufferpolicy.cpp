@@ -0,0 +1,155 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "streambufferpolicy.h"
+
+#include <QSettings>
+#include <QtGlobal>
+#include <cmath>
+
+#include "core/timeconstants.h"
+
+const char* StreamBufferPolicy::kSettingsGroup = "StreamBuffering";
+const int StreamBufferPolicy::kMaxHosts = 100;
+const int StreamBufferPolicy::kMinSamples = 5;
+
+namespace {
+
+// How much a new stream counts for against what we already knew.
+const double kNewStreamWeight = 0.3;
+
+}  // namespace
+
+ThroughputStats::ThroughputStats() : count_(0), mean_(0), m2_(0) {}
+
+void ThroughputStats::AddSample(qint64 bytes_in_per_sec,
+                                qint64 bytes_out_per_sec) {
+  if (bytes_in_per_sec <= 0 || bytes_out_per_sec <= 0) return;
+
+  // Welford's online mean and variance.
+  const double value = double(bytes_in_per_sec) / bytes_out_per_sec;
+  ++count_;
+  const double delta = value - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (value - mean_);
+}
+
+double ThroughputStats::jitter() const {
+  if (count_ < 2 || mean_ <= 0) return 0;
+  return std::sqrt(m2_ / (count_ - 1)) / mean_;
+}
+
+StreamBufferPolicy::StreamBufferPolicy() { Load(); }
+
+StreamBufferPolicy::Params StreamBufferPolicy::ParamsFor(
+    double headroom, double jitter, qint64 default_duration_nanosec,
+    int default_low_percent) {
+  // The configured buffer is about right for a link that downloads twice as
+  // fast as it plays.  Faster links need less, and every bit of jitter needs
+  // more to ride out the dips.
+  const double scale = (1 + 2 * jitter) * 2 / qBound(0.5, headroom, 8.0);
+
+  Params ret;
+  ret.duration_nanosec_ =
+      qBound(qint64(500 * kNsecPerMsec),
+             qint64(default_duration_nanosec * scale),
+             4 * default_duration_nanosec);
+
+  // Erratic links start refilling sooner, and wait until the buffer is nearly
+  // full before playing again.  Steady ones can carry on at 60%.
+  ret.low_percent_ = qBound(10, default_low_percent + int(30 * jitter), 80);
+  ret.high_percent_ = qBound(ret.low_percent_ + 10, 60 + int(80 * jitter), 99);
+  return ret;
+}
+
+StreamBufferPolicy::Params StreamBufferPolicy::ParamsForHost(
+    const QString& host, qint64 default_duration_nanosec,
+    int default_low_percent) const {
+  if (!hosts_.contains(host)) {
+    Params ret;
+    ret.duration_nanosec_ = default_duration_nanosec;
+    ret.low_percent_ = default_low_percent;
+    ret.high_percent_ = 99;
+    return ret;
+  }
+
+  const HostInfo& info = hosts_[host];
+  return ParamsFor(info.headroom_, info.jitter_, default_duration_nanosec,
+                   default_low_percent);
+}
+
+void StreamBufferPolicy::AddMeasurement(const QString& host,
+                                        const ThroughputStats& stats) {
+  if (host.isEmpty() || stats.count() < kMinSamples) return;
+
+  if (hosts_.contains(host)) {
+    HostInfo& info = hosts_[host];
+    info.headroom_ += kNewStreamWeight * (stats.headroom() - info.headroom_);
+    info.jitter_ += kNewStreamWeight * (stats.jitter() - info.jitter_);
+    info.last_used_ = QDateTime::currentDateTime();
+  } else {
+    HostInfo info;
+    info.headroom_ = stats.headroom();
+    info.jitter_ = stats.jitter();
+    info.last_used_ = QDateTime::currentDateTime();
+    hosts_[host] = info;
+  }
+
+  // Forget the hosts we haven't heard from for the longest.
+  while (hosts_.count() > kMaxHosts) {
+    auto oldest = hosts_.begin();
+    for (auto it = hosts_.begin(); it != hosts_.end(); ++it) {
+      if (it->last_used_ < oldest->last_used_) oldest = it;
+    }
+    hosts_.erase(oldest);
+  }
+
+  Save();
+}
+
+void StreamBufferPolicy::Load() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+
+  const int count = s.beginReadArray("hosts");
+  for (int i = 0; i < count; ++i) {
+    s.setArrayIndex(i);
+    HostInfo info;
+    info.headroom_ = s.value("headroom").toDouble();
+    info.jitter_ = s.value("jitter").toDouble();
+    info.last_used_ = s.value("last_used").toDateTime();
+    hosts_[s.value("host").toString()] = info;
+  }
+  s.endArray();
+}
+
+void StreamBufferPolicy::Save() const {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.remove("hosts");
+
+  s.beginWriteArray("hosts", hosts_.count());
+  int i = 0;
+  for (auto it = hosts_.begin(); it != hosts_.end(); ++it) {
+    s.setArrayIndex(i++);
+    s.setValue("host", it.key());
+    s.setValue("headroom", it->headroom_);
+    s.setValue("jitter", it->jitter_);
+    s.setValue("last_used", it->last_used_);
+  }
+  s.endArray();
+}
@@ -0,0 +1,90 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINES_STREAMBUFFERPOLICY_H_
+#define ENGINES_STREAMBUFFERPOLICY_H_
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+
+// Download throughput of one stream, as a multiple of the rate it's played
+// back at, from the samples in queue2's buffering messages.
+class ThroughputStats {
+ public:
+  ThroughputStats();
+
+  void AddSample(qint64 bytes_in_per_sec, qint64 bytes_out_per_sec);
+
+  int count() const { return count_; }
+  // How many times faster than it's played back the stream downloads.
+  double headroom() const { return mean_; }
+  // How much the headroom varies: its standard deviation over its mean.
+  double jitter() const;
+
+ private:
+  int count_;
+  double mean_;
+  double m2_;
+};
+
+// Picks buffer sizes for network streams from how well earlier streams from
+// the same host downloaded: fast, steady hosts get a short buffer so they
+// start quickly, slow or erratic ones a longer buffer that refills further
+// before playing again.  What's learned about each host is kept in QSettings.
+class StreamBufferPolicy {
+ public:
+  StreamBufferPolicy();
+
+  static const char* kSettingsGroup;
+  static const int kMaxHosts;
+  static const int kMinSamples;
+
+  struct Params {
+    qint64 duration_nanosec_;
+    int low_percent_;
+    int high_percent_;
+  };
+
+  // Scales the user's configured buffer for a link with this headroom and
+  // jitter.
+  static Params ParamsFor(double headroom, double jitter,
+                          qint64 default_duration_nanosec,
+                          int default_low_percent);
+
+  // The buffer to use for a stream from host, or the defaults if we don't
+  // know anything about it yet.
+  Params ParamsForHost(const QString& host, qint64 default_duration_nanosec,
+                       int default_low_percent) const;
+
+  // Folds a finished stream's throughput into what we know about its host.
+  void AddMeasurement(const QString& host, const ThroughputStats& stats);
+
+ private:
+  struct HostInfo {
+    double headroom_;
+    double jitter_;
+    QDateTime last_used_;
+  };
+
+  void Load();
+  void Save() const;
+
+  QMap<QString, HostInfo> hosts_;
+};
+
+#endif  // ENGINES_STREAMBUFFERPOLICY_H_
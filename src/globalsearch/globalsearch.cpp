@@ -32,11 +32,20 @@
 const int GlobalSearch::kDelayedSearchTimeoutMs = 200;
 const char* GlobalSearch::kSettingsGroup = "GlobalSearch";
 const int GlobalSearch::kMaxResultsPerEmission = 500;
+const int GlobalSearch::kResultCacheSize = 100;
+const int GlobalSearch::kSoftDeadlineMs = 3000;
+const int GlobalSearch::kHardDeadlineMs = 10000;
+const int GlobalSearch::kLatencyBucketsMs[] = {50,   100,  250, 500,
+                                               1000, 2500, 5000};
+const int GlobalSearch::kMaxArtTasksPerProvider = 4;
+const int GlobalSearch::kLatencyBucketCount =
+    sizeof(GlobalSearch::kLatencyBucketsMs) / sizeof(int);
 
 GlobalSearch::GlobalSearch(Application* app, QObject* parent)
     : QObject(parent),
       app_(app),
       next_id_(1),
+      result_cache_(kResultCacheSize),
       url_provider_(new UrlSearchProvider(app, this)) {
   cover_loader_options_.desired_height_ = SearchProvider::kArtHeight;
   cover_loader_options_.pad_output_image_ = true;
@@ -56,6 +65,8 @@ void GlobalSearch::ConnectProvider(SearchProvider* provider) {
   connect(provider, SIGNAL(SearchFinished(int)), SLOT(SearchFinishedSlot(int)));
   connect(provider, SIGNAL(ArtLoaded(int, QImage)),
           SLOT(ArtLoadedSlot(int, QImage)));
+  connect(provider, SIGNAL(ResultsInvalidated()),
+          SLOT(ResultsInvalidatedSlot()));
   connect(provider, SIGNAL(destroyed(QObject*)),
           SLOT(ProviderDestroyedSlot(QObject*)));
 }
@@ -85,23 +96,48 @@ void GlobalSearch::AddProvider(SearchProvider* provider) {
 int GlobalSearch::SearchAsync(const QString& query) {
   const int id = next_id_++;
 
+  emit SearchAboutToStart();
   emit SearchAsyncSig(id, query);
 
   return id;
 }
 
 void GlobalSearch::DoSearchAsync(int id, const QString& query) {
-  pending_search_providers_[id] = 0;
+  const QString cache_query = query.simplified().toLower();
+
+  PendingSearch& search = pending_searches_[id];
+  search.cache_query_ = cache_query;
+  search.timer_.start();
+  search.soft_deadline_timer_ = startTimer(kSoftDeadlineMs);
+  search.hard_deadline_timer_ = startTimer(kHardDeadlineMs);
+
+  QList<SearchProvider*> providers;
+  if (url_provider_->LooksLikeUrl(query)) {
+    providers << url_provider_;
+  } else {
+    for (SearchProvider* provider : providers_.keys()) {
+      if (is_provider_usable(provider)) providers << provider;
+    }
+  }
+
+  // Add every provider before asking any, since one might finish straight
+  // away.  Only delayed providers haven't been asked at the start.
+  for (SearchProvider* provider : providers) {
+    search.running_[provider] = provider->wants_delayed_queries() ? -1 : 0;
+  }
 
   int timer_id = -1;
 
   if (url_provider_->LooksLikeUrl(query)) {
     url_provider_->SearchAsync(id, query);
   } else {
-    for (SearchProvider* provider : providers_.keys()) {
-      if (!is_provider_usable(provider)) continue;
+    for (SearchProvider* provider : providers) {
+      if (SearchCache(id, cache_query, provider)) continue;
 
-      pending_search_providers_[id]++;
+      if (provider->result_cache_ttl() != SearchProvider::kResultsNotCached) {
+        uncached_results_[qMakePair(id, provider)] =
+            SearchProvider::ResultList();
+      }
 
       if (provider->wants_delayed_queries()) {
         if (timer_id == -1) {
@@ -117,12 +153,82 @@ void GlobalSearch::DoSearchAsync(int id, const QString& query) {
   }
 }
 
+bool GlobalSearch::SearchCache(int id, const QString& query,
+                               SearchProvider* provider) {
+  if (provider->result_cache_ttl() == SearchProvider::kResultsNotCached) {
+    return false;
+  }
+
+  const ResultCacheKey key(provider, query);
+  CachedResults* cached = result_cache_.object(key);
+  if (!cached) return false;
+
+  if (!cached->expires_.isNull() &&
+      cached->expires_ < QDateTime::currentDateTime()) {
+    result_cache_.remove(key);
+    return false;
+  }
+
+  // Callers expect results to arrive after SearchAsync has returned.
+  if (cached_replies_.isEmpty()) {
+    QMetaObject::invokeMethod(this, "EmitCachedResults", Qt::QueuedConnection);
+  }
+
+  CachedReply reply;
+  reply.id_ = id;
+  reply.provider_ = provider;
+  reply.results_ = cached->results_;
+  cached_replies_ << reply;
+  return true;
+}
+
+void GlobalSearch::EmitCachedResults() {
+  const QList<CachedReply> replies = cached_replies_;
+  cached_replies_.clear();
+
+  for (const CachedReply& reply : replies) {
+    if (!pending_searches_.contains(reply.id_)) continue;
+
+    AddResults(reply.id_, reply.results_);
+    FinishProviderSearch(reply.id_, reply.provider_, false);
+  }
+}
+
+void GlobalSearch::ResultsInvalidatedSlot() {
+  ForgetCachedResults(static_cast<SearchProvider*>(sender()));
+}
+
+void GlobalSearch::ForgetCachedResults(SearchProvider* provider) {
+  for (const ResultCacheKey& key : result_cache_.keys()) {
+    if (key.first == provider) {
+      result_cache_.remove(key);
+    }
+  }
+
+  // Don't cache the results of searches that are still running either.
+  QMap<QPair<int, SearchProvider*>, SearchProvider::ResultList>::iterator it =
+      uncached_results_.begin();
+  while (it != uncached_results_.end()) {
+    if (it.key().second == provider) {
+      it = uncached_results_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void GlobalSearch::CancelSearch(int id) {
   QMap<int, DelayedSearch>::iterator it;
   for (it = delayed_searches_.begin(); it != delayed_searches_.end(); ++it) {
     if (it.value().id_ == id) {
+      const QList<SearchProvider*> providers = it.value().providers_;
       killTimer(it.key());
       delayed_searches_.erase(it);
+
+      // These were never asked, so they don't count as late.
+      for (SearchProvider* provider : providers) {
+        FinishProviderSearch(id, provider, false);
+      }
       return;
     }
   }
@@ -131,16 +237,93 @@ void GlobalSearch::CancelSearch(int id) {
 void GlobalSearch::timerEvent(QTimerEvent* e) {
   QMap<int, DelayedSearch>::iterator it = delayed_searches_.find(e->timerId());
   if (it != delayed_searches_.end()) {
-    for (SearchProvider* provider : it.value().providers_) {
-      provider->SearchAsync(it.value().id_, it.value().query_);
-    }
+    const DelayedSearch delayed = it.value();
     delayed_searches_.erase(it);
+    killTimer(e->timerId());
+
+    for (SearchProvider* provider : delayed.providers_) {
+      QMap<int, PendingSearch>::iterator search =
+          pending_searches_.find(delayed.id_);
+      if (search == pending_searches_.end()) break;
+      if (!search->running_.contains(provider)) continue;
+
+      search->running_[provider] = search->timer_.elapsed();
+      provider->SearchAsync(delayed.id_, delayed.query_);
+    }
     return;
   }
 
+  for (QMap<int, PendingSearch>::const_iterator search =
+           pending_searches_.constBegin();
+       search != pending_searches_.constEnd(); ++search) {
+    if (e->timerId() == search->soft_deadline_timer_) {
+      SoftDeadlineReached(search.key());
+      return;
+    }
+    if (e->timerId() == search->hard_deadline_timer_) {
+      HardDeadlineReached(search.key());
+      return;
+    }
+  }
+
   QObject::timerEvent(e);
 }
 
+void GlobalSearch::SoftDeadlineReached(int id) {
+  PendingSearch& search = pending_searches_[id];
+  killTimer(search.soft_deadline_timer_);
+  search.soft_deadline_timer_ = -1;
+
+  if (search.finished_emitted_) return;
+
+  // Let the UI consider the search done, but keep showing results from the
+  // late providers until the hard deadline.
+  QStringList late;
+  for (SearchProvider* provider : search.running_.keys()) {
+    late << provider->name();
+  }
+  qLog(Debug) << "Search" << id << "still waiting for" << late;
+
+  search.finished_emitted_ = true;
+  emit SearchFinished(id);
+}
+
+void GlobalSearch::HardDeadlineReached(int id) {
+  const PendingSearch search = pending_searches_.take(id);
+  killTimer(search.hard_deadline_timer_);
+  if (search.soft_deadline_timer_ != -1) {
+    killTimer(search.soft_deadline_timer_);
+  }
+
+  // Anything these providers send for this search from now on is ignored.
+  for (SearchProvider* provider : search.running_.keys()) {
+    qLog(Warning) << "Search provider" << provider->name()
+                  << "didn't finish search" << id << "in time";
+
+    uncached_results_.remove(qMakePair(id, provider));
+    if (providers_.contains(provider)) {
+      providers_[provider].latency_.timeouts_++;
+    }
+  }
+
+  for (SearchProvider* provider : search.running_.keys()) {
+    emit ProviderSearchFinished(id, provider);
+  }
+  if (!search.finished_emitted_) {
+    emit SearchFinished(id);
+  }
+}
+
+void GlobalSearch::RecordLatency(SearchProvider* provider, qint64 msec) {
+  if (!providers_.contains(provider)) return;
+
+  int bucket = 0;
+  while (bucket < kLatencyBucketCount && msec >= kLatencyBucketsMs[bucket]) {
+    ++bucket;
+  }
+  providers_[provider].latency_.counts_[bucket]++;
+}
+
 QString GlobalSearch::PixmapCacheKey(
     const SearchProvider::Result& result) const {
   return "globalsearch:" % QString::number(qulonglong(result.provider_)) % "," %
@@ -149,6 +332,26 @@ QString GlobalSearch::PixmapCacheKey(
 
 void GlobalSearch::ResultsAvailableSlot(int id,
                                         SearchProvider::ResultList results) {
+  SearchProvider* provider = static_cast<SearchProvider*>(sender());
+
+  // Drop results for searches that were abandoned at the hard deadline.
+  QMap<int, PendingSearch>::const_iterator search =
+      pending_searches_.constFind(id);
+  if (search == pending_searches_.constEnd() ||
+      !search->running_.contains(provider)) {
+    return;
+  }
+
+  QMap<QPair<int, SearchProvider*>, SearchProvider::ResultList>::iterator it =
+      uncached_results_.find(qMakePair(id, provider));
+  if (it != uncached_results_.end()) {
+    it.value() << results;
+  }
+
+  AddResults(id, results);
+}
+
+void GlobalSearch::AddResults(int id, SearchProvider::ResultList results) {
   if (results.isEmpty()) return;
 
   // Limit the number of results that are used from each emission.
@@ -170,15 +373,54 @@ void GlobalSearch::ResultsAvailableSlot(int id,
 }
 
 void GlobalSearch::SearchFinishedSlot(int id) {
-  if (!pending_search_providers_.contains(id)) return;
-
   SearchProvider* provider = static_cast<SearchProvider*>(sender());
-  const int remaining = --pending_search_providers_[id];
+  const QPair<int, SearchProvider*> uncached_key(id, provider);
+
+  QMap<int, PendingSearch>::const_iterator search =
+      pending_searches_.constFind(id);
+  if (search == pending_searches_.constEnd() ||
+      !search->running_.contains(provider)) {
+    uncached_results_.remove(uncached_key);
+    return;
+  }
+
+  if (uncached_results_.contains(uncached_key)) {
+    CachedResults* cached = new CachedResults;
+    cached->results_ = uncached_results_.take(uncached_key);
+    if (provider->result_cache_ttl() > 0) {
+      cached->expires_ = QDateTime::currentDateTime().addSecs(
+          provider->result_cache_ttl());
+    }
+    result_cache_.insert(ResultCacheKey(provider, search->cache_query_),
+                         cached);
+  }
+
+  FinishProviderSearch(id, provider, true);
+}
+
+void GlobalSearch::FinishProviderSearch(int id, SearchProvider* provider,
+                                        bool record_latency) {
+  QMap<int, PendingSearch>::iterator it = pending_searches_.find(id);
+  if (it == pending_searches_.end() || !it->running_.contains(provider)) {
+    return;
+  }
+
+  const qint64 started = it->running_.take(provider);
+  if (record_latency && started != -1) {
+    RecordLatency(provider, it->timer_.elapsed() - started);
+  }
+
+  bool emit_finished = false;
+  if (it->running_.isEmpty()) {
+    if (it->soft_deadline_timer_ != -1) killTimer(it->soft_deadline_timer_);
+    killTimer(it->hard_deadline_timer_);
+    emit_finished = !it->finished_emitted_;
+    pending_searches_.erase(it);
+  }
 
   emit ProviderSearchFinished(id, provider);
-  if (remaining == 0) {
+  if (emit_finished) {
     emit SearchFinished(id);
-    pending_search_providers_.remove(id);
   }
 }
 
@@ -187,14 +429,21 @@ void GlobalSearch::ProviderDestroyedSlot(QObject* object) {
   if (!providers_.contains(provider)) return;
 
   providers_.remove(provider);
+  ForgetCachedResults(provider);
   emit ProviderRemoved(provider);
 
   // We have to abort any pending searches since we can't tell whether they
   // were on this provider.
-  for (int id : pending_search_providers_.keys()) {
-    emit SearchFinished(id);
+  const QMap<int, PendingSearch> searches = pending_searches_;
+  pending_searches_.clear();
+  for (QMap<int, PendingSearch>::const_iterator it = searches.constBegin();
+       it != searches.constEnd(); ++it) {
+    if (it->soft_deadline_timer_ != -1) killTimer(it->soft_deadline_timer_);
+    killTimer(it->hard_deadline_timer_);
+    if (!it->finished_emitted_) emit SearchFinished(it.key());
   }
-  pending_search_providers_.clear();
+  uncached_results_.clear();
+  cached_replies_.clear();
 }
 
 QList<SearchProvider*> GlobalSearch::providers() const {
@@ -212,63 +461,115 @@ int GlobalSearch::LoadArtAsync(const SearchProvider::Result& result) {
     return id;
   }
 
+  // The URL provider isn't in providers_, and has nothing to queue for.
+  if (!providers_.contains(result.provider_)) {
+    StartArt(id, result);
+    return id;
+  }
+
+  QueuedArt request;
+  request.id_ = id;
+  request.result_ = result;
+  providers_[result.provider_].queued_art_.append(request);
+  art_providers_[id] = result.provider_;
+
+  TakeNextQueuedArt(result.provider_);
+  return id;
+}
+
+void GlobalSearch::TakeNextQueuedArt(SearchProvider* provider) {
+  if (!providers_.contains(provider)) return;
+
+  // Art from song metadata is loaded by us, so the provider's hint doesn't
+  // apply to it.
+  const int max_tasks =
+      provider->wants_serialised_art() && !provider->art_is_in_song_metadata()
+          ? 1
+          : kMaxArtTasksPerProvider;
+
+  // Providers can emit ArtLoaded straight away, which comes back here, so
+  // the data is looked up again each time round.
+  while (providers_.contains(provider)) {
+    ProviderData* data = &providers_[provider];
+    if (data->queued_art_.isEmpty() || data->running_art_.count() >= max_tasks)
+      break;
+
+    const QueuedArt request = data->queued_art_.takeLast();
+    data->running_art_.insert(request.id_);
+    StartArt(request.id_, request.result_);
+  }
+}
+
+void GlobalSearch::StartArt(int id, const SearchProvider::Result& result) {
   if (result.provider_->art_is_in_song_metadata()) {
     quint64 loader_id = app_->album_cover_loader()->LoadImageAsync(
         cover_loader_options_, result.metadata_);
     cover_loader_tasks_[loader_id] = id;
-  } else if (providers_.contains(result.provider_) &&
-             result.provider_->wants_serialised_art()) {
-    QueuedArt request;
-    request.id_ = id;
-    request.result_ = result;
-
-    QList<QueuedArt>* queued_art = &providers_[result.provider_].queued_art_;
-
-    queued_art->append(request);
-
-    if (queued_art->count() == 1) {
-      TakeNextQueuedArt(result.provider_);
-    }
   } else {
     result.provider_->LoadArtAsync(id, result);
   }
-
-  return id;
 }
 
-void GlobalSearch::TakeNextQueuedArt(SearchProvider* provider) {
-  if (!providers_.contains(provider) ||
-      providers_[provider].queued_art_.isEmpty())
+void GlobalSearch::CancelArt(int id) {
+  if (!pending_art_searches_.contains(id)) return;
+
+  SearchProvider* provider = art_providers_.value(id);
+  if (provider && providers_.contains(provider)) {
+    QList<QueuedArt>* queued_art = &providers_[provider].queued_art_;
+    for (int i = 0; i < queued_art->count(); ++i) {
+      if (queued_art->at(i).id_ == id) {
+        queued_art->removeAt(i);
+        art_providers_.remove(id);
+        pending_art_searches_.remove(id);
+        return;
+      }
+    }
+  }
+
+  // The cover loader can drop a task it hasn't got to yet, which frees the
+  // slot for the next one.
+  for (auto it = cover_loader_tasks_.begin(); it != cover_loader_tasks_.end();
+       ++it) {
+    if (it.value() != id) continue;
+
+    app_->album_cover_loader()->CancelTask(it.key());
+    cover_loader_tasks_.erase(it);
+    pending_art_searches_.remove(id);
+    art_providers_.remove(id);
+    if (provider && providers_.contains(provider)) {
+      providers_[provider].running_art_.remove(id);
+      TakeNextQueuedArt(provider);
+    }
     return;
+  }
 
-  const QueuedArt& data = providers_[provider].queued_art_.first();
-  provider->LoadArtAsync(data.id_, data.result_);
+  // Providers always finish, and free the slot then.
+  cancelled_art_.insert(id);
 }
 
 void GlobalSearch::ArtLoadedSlot(int id, const QImage& image) {
-  SearchProvider* provider = static_cast<SearchProvider*>(sender());
-  HandleLoadedArt(id, image, provider);
+  HandleLoadedArt(id, image);
 }
 
 void GlobalSearch::AlbumArtLoaded(quint64 id, const QImage& image) {
   if (!cover_loader_tasks_.contains(id)) return;
   int orig_id = cover_loader_tasks_.take(id);
 
-  HandleLoadedArt(orig_id, image, nullptr);
+  HandleLoadedArt(orig_id, image);
 }
 
-void GlobalSearch::HandleLoadedArt(int id, const QImage& image,
-                                   SearchProvider* provider) {
+void GlobalSearch::HandleLoadedArt(int id, const QImage& image) {
+  if (!pending_art_searches_.contains(id)) return;
   const QString key = pending_art_searches_.take(id);
 
   QPixmap pixmap = QPixmap::fromImage(image);
   pixmap_cache_.insert(key, pixmap);
 
-  emit ArtLoaded(id, pixmap);
+  if (!cancelled_art_.remove(id)) emit ArtLoaded(id, pixmap);
 
-  if (provider && providers_.contains(provider) &&
-      !providers_[provider].queued_art_.isEmpty()) {
-    providers_[provider].queued_art_.removeFirst();
+  SearchProvider* provider = art_providers_.take(id);
+  if (provider && providers_.contains(provider)) {
+    providers_[provider].running_art_.remove(id);
     TakeNextQueuedArt(provider);
   }
 }
@@ -330,6 +631,14 @@ bool GlobalSearch::is_provider_usable(SearchProvider* provider) const {
   return is_provider_enabled(provider) && provider->IsLoggedIn();
 }
 
+GlobalSearch::LatencyStats GlobalSearch::provider_latency(
+    const SearchProvider* const_provider) const {
+  SearchProvider* provider = const_cast<SearchProvider*>(const_provider);
+
+  if (!providers_.contains(provider)) return LatencyStats();
+  return providers_[provider].latency_;
+}
+
 void GlobalSearch::ReloadSettings() {
   QSettings s;
   s.beginGroup(kSettingsGroup);
@@ -379,3 +688,13 @@ QStringList GlobalSearch::GetSuggestions(int count) {
   }
   return ret;
 }
+
+QString GlobalSearch::GetCorrection(const QString& query) {
+  for (SearchProvider* provider : providers_.keys()) {
+    if (!is_provider_usable(provider)) continue;
+
+    const QString correction = provider->GetCorrection(query);
+    if (!correction.isEmpty()) return correction;
+  }
+  return QString();
+}
@@ -18,8 +18,13 @@
 #ifndef GLOBALSEARCH_H
 #define GLOBALSEARCH_H
 
+#include <QCache>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QPixmapCache>
+#include <QSet>
+#include <QVector>
 
 #include "covers/albumcoverloaderoptions.h"
 #include "searchprovider.h"
@@ -37,6 +42,23 @@ class GlobalSearch : public QObject {
   static const int kDelayedSearchTimeoutMs;
   static const char* kSettingsGroup;
   static const int kMaxResultsPerEmission;
+  static const int kResultCacheSize;
+  static const int kSoftDeadlineMs;
+  static const int kHardDeadlineMs;
+  static const int kLatencyBucketsMs[];
+  static const int kLatencyBucketCount;
+  static const int kMaxArtTasksPerProvider;
+
+  // How long a provider took to finish its searches.  counts_ has one entry
+  // per bucket in kLatencyBucketsMs, each counting searches that finished
+  // before that many milliseconds, and a last one for slower searches.
+  struct LatencyStats {
+    LatencyStats() : counts_(kLatencyBucketCount + 1, 0), timeouts_(0) {}
+
+    QVector<int> counts_;
+    // Searches that were abandoned at the hard deadline.
+    int timeouts_;
+  };
 
   Application* application() const { return app_; }
 
@@ -46,11 +68,16 @@ class GlobalSearch : public QObject {
   bool SetProviderEnabled(const SearchProvider* provider, bool enabled);
 
   int SearchAsync(const QString& query);
+  // Requests for each provider wait for one of its kMaxArtTasksPerProvider
+  // slots, and the newest is taken first since it's for results that have
+  // just been drawn.
   int LoadArtAsync(const SearchProvider::Result& result);
   MimeData* LoadTracks(const SearchProvider::ResultList& results);
   QStringList GetSuggestions(int count);
+  QString GetCorrection(const QString& query);
 
   void CancelSearch(int id);
+  // ArtLoaded won't be emitted for this request.
   void CancelArt(int id);
 
   bool FindCachedPixmap(const SearchProvider::Result& result,
@@ -60,12 +87,15 @@ class GlobalSearch : public QObject {
   QList<SearchProvider*> providers() const;
   bool is_provider_enabled(const SearchProvider* provider) const;
   bool is_provider_usable(SearchProvider* provider) const;
+  LatencyStats provider_latency(const SearchProvider* provider) const;
 
  public slots:
 
   void ReloadSettings();
 
  signals:
+  // Emitted before any provider is asked, so providers can still be added.
+  void SearchAboutToStart();
   void SearchAsyncSig(int id, const QString& query);
   void ResultsAvailable(int id, const SearchProvider::ResultList& results);
   void ProviderSearchFinished(int id, const SearchProvider* provider);
@@ -84,6 +114,8 @@ class GlobalSearch : public QObject {
   void DoSearchAsync(int id, const QString& query);
   void ResultsAvailableSlot(int id, SearchProvider::ResultList results);
   void SearchFinishedSlot(int id);
+  void ResultsInvalidatedSlot();
+  void EmitCachedResults();
 
   void ArtLoadedSlot(int id, const QImage& image);
   void AlbumArtLoaded(quint64 id, const QImage& image);
@@ -92,10 +124,21 @@ class GlobalSearch : public QObject {
 
  private:
   void ConnectProvider(SearchProvider* provider);
-  void HandleLoadedArt(int id, const QImage& image, SearchProvider* provider);
+  void HandleLoadedArt(int id, const QImage& image);
   void TakeNextQueuedArt(SearchProvider* provider);
+  void StartArt(int id, const SearchProvider::Result& result);
   QString PixmapCacheKey(const SearchProvider::Result& result) const;
 
+  void AddResults(int id, SearchProvider::ResultList results);
+  void FinishProviderSearch(int id, SearchProvider* provider,
+                            bool record_latency);
+  void SoftDeadlineReached(int id);
+  void HardDeadlineReached(int id);
+  void RecordLatency(SearchProvider* provider, qint64 msec);
+
+  bool SearchCache(int id, const QString& query, SearchProvider* provider);
+  void ForgetCachedResults(SearchProvider* provider);
+
   void SaveProvidersSettings();
 
  private:
@@ -111,8 +154,45 @@ class GlobalSearch : public QObject {
   };
 
   struct ProviderData {
+    // Waiting for a slot, oldest first.
     QList<QueuedArt> queued_art_;
+    // Being loaded by the provider or the cover loader.
+    QSet<int> running_art_;
     bool enabled_;
+    LatencyStats latency_;
+  };
+
+  struct PendingSearch {
+    PendingSearch()
+        : finished_emitted_(false),
+          soft_deadline_timer_(-1),
+          hard_deadline_timer_(-1) {}
+
+    QString cache_query_;
+    QElapsedTimer timer_;
+
+    // Providers that haven't finished yet, with the time they were asked in
+    // milliseconds since the search started, or -1 while they're delayed.
+    QMap<SearchProvider*, qint64> running_;
+
+    // SearchFinished is emitted at the soft deadline if providers are late.
+    bool finished_emitted_;
+    int soft_deadline_timer_;
+    int hard_deadline_timer_;
+  };
+
+  // Results keyed by provider and normalised query.
+  typedef QPair<SearchProvider*, QString> ResultCacheKey;
+
+  struct CachedResults {
+    SearchProvider::ResultList results_;
+    QDateTime expires_;  // Null if they don't expire
+  };
+
+  struct CachedReply {
+    int id_;
+    SearchProvider* provider_;
+    SearchProvider::ResultList results_;
   };
 
   Application* app_;
@@ -122,10 +202,23 @@ class GlobalSearch : public QObject {
   QMap<int, DelayedSearch> delayed_searches_;
 
   int next_id_;
-  QMap<int, int> pending_search_providers_;
+  QMap<int, PendingSearch> pending_searches_;
+
+  // Results gathered so far for searches that will go in the result cache.
+  // Entries are dropped if the provider invalidates its results meanwhile.
+  QMap<QPair<int, SearchProvider*>, SearchProvider::ResultList>
+      uncached_results_;
+
+  QCache<ResultCacheKey, CachedResults> result_cache_;
+  QList<CachedReply> cached_replies_;
 
   QPixmapCache pixmap_cache_;
   QMap<int, QString> pending_art_searches_;
+  // Which provider each queued or running art request is using a slot of.
+  QMap<int, SearchProvider*> art_providers_;
+  // Running requests that were cancelled.  They still go in the pixmap cache
+  // when they finish.
+  QSet<int> cancelled_art_;
 
   // Used for providers with ArtIsInSongMetadata set.
   AlbumCoverLoaderOptions cover_loader_options_;
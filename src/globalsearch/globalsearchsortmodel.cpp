@@ -22,61 +22,90 @@
 #include "searchprovider.h"
 
 GlobalSearchSortModel::GlobalSearchSortModel(QObject* parent)
-    : QSortFilterProxyModel(parent) {}
+    : QSortFilterProxyModel(parent),
+      empty_sort_key_(collator_.sortKey(QString())) {}
 
-bool GlobalSearchSortModel::lessThan(const QModelIndex& left,
-                                     const QModelIndex& right) const {
-  // Compare the provider sort index first.
-  const int index_left =
-      left.data(GlobalSearchModel::Role_ProviderIndex).toInt();
-  const int index_right =
-      right.data(GlobalSearchModel::Role_ProviderIndex).toInt();
-  if (index_left < index_right) return true;
-  if (index_left > index_right) return false;
+void GlobalSearchSortModel::setSourceModel(QAbstractItemModel* source_model) {
+  for (const QMetaObject::Connection& connection : source_connections_) {
+    disconnect(connection);
+  }
+  source_connections_.clear();
+  ClearSortKeys();
+
+  // Connected before QSortFilterProxyModel connects its own, so the keys are
+  // gone by the time it sorts the changed rows again.
+  if (source_model) {
+    auto clear = [this]() { ClearSortKeys(); };
+    source_connections_
+        << connect(source_model, &QAbstractItemModel::dataChanged, clear)
+        << connect(source_model, &QAbstractItemModel::rowsInserted, clear)
+        << connect(source_model, &QAbstractItemModel::rowsRemoved, clear)
+        << connect(source_model, &QAbstractItemModel::rowsMoved, clear)
+        << connect(source_model, &QAbstractItemModel::layoutChanged, clear)
+        << connect(source_model, &QAbstractItemModel::modelReset, clear);
+  }
 
-  // Dividers always go first
-  if (left.data(LibraryModel::Role_IsDivider).toBool()) return true;
-  if (right.data(LibraryModel::Role_IsDivider).toBool()) return false;
+  QSortFilterProxyModel::setSourceModel(source_model);
+}
 
-  // Containers go before songs if they're at the same level
-  const bool left_is_container =
-      left.data(LibraryModel::Role_ContainerType).isValid();
-  const bool right_is_container =
-      right.data(LibraryModel::Role_ContainerType).isValid();
-  if (left_is_container && !right_is_container) return true;
-  if (right_is_container && !left_is_container) return false;
+void GlobalSearchSortModel::ClearSortKeys() {
+  sort_key_rows_.clear();
+  sort_keys_.clear();
+}
 
-  // Containers get sorted on their sort text.
-  if (left_is_container) {
-    return QString::localeAwareCompare(
-               left.data(LibraryModel::Role_SortText).toString(),
-               right.data(LibraryModel::Role_SortText).toString()) < 0;
+int GlobalSearchSortModel::SortKeyRow(const QModelIndex& index) const {
+  QHash<QModelIndex, int>::const_iterator it = sort_key_rows_.constFind(index);
+  if (it != sort_key_rows_.constEnd()) return it.value();
+
+  SortKey key(empty_sort_key_);
+  key.provider_index =
+      index.data(GlobalSearchModel::Role_ProviderIndex).toInt();
+  key.is_divider = index.data(LibraryModel::Role_IsDivider).toBool();
+  key.is_container = index.data(LibraryModel::Role_ContainerType).isValid();
+  key.disc = 0;
+  key.track = 0;
+
+  if (key.is_container) {
+    key.text =
+        collator_.sortKey(index.data(LibraryModel::Role_SortText).toString());
+  } else if (!key.is_divider) {
+    const SearchProvider::Result result =
+        index.data(GlobalSearchModel::Role_Result)
+            .value<SearchProvider::Result>();
+    key.disc = result.metadata_.disc();
+    key.track = result.metadata_.track();
+    key.text = collator_.sortKey(result.metadata_.title());
   }
 
-  // Otherwise we're comparing songs.  Sort by disc, track, then title.
-  const SearchProvider::Result r1 =
-      left.data(GlobalSearchModel::Role_Result).value<SearchProvider::Result>();
-  const SearchProvider::Result r2 = right.data(GlobalSearchModel::Role_Result)
-                                        .value<SearchProvider::Result>();
+  sort_keys_.push_back(key);
+  sort_key_rows_.insert(index, sort_keys_.size() - 1);
+  return sort_keys_.size() - 1;
+}
 
-#define CompareInt(field)                                       \
-  if (r1.metadata_.field() < r2.metadata_.field()) return true; \
-  if (r1.metadata_.field() > r2.metadata_.field()) return false
+bool GlobalSearchSortModel::lessThan(const QModelIndex& left,
+                                     const QModelIndex& right) const {
+  const int left_row = SortKeyRow(left);
+  const int right_row = SortKeyRow(right);
+  const SortKey& l = sort_keys_[left_row];
+  const SortKey& r = sort_keys_[right_row];
 
-  int ret = 0;
+  // Compare the provider sort index first.
+  if (l.provider_index < r.provider_index) return true;
+  if (l.provider_index > r.provider_index) return false;
 
-#define CompareString(field)                                                   \
-  ret =                                                                        \
-      QString::localeAwareCompare(r1.metadata_.field(), r2.metadata_.field()); \
-  if (ret < 0) return true;                                                    \
-  if (ret > 0) return false
+  // Dividers always go first
+  if (l.is_divider) return true;
+  if (r.is_divider) return false;
 
-  CompareInt(disc);
-  CompareInt(track);
-  CompareString(title);
+  // Containers go before songs if they're at the same level
+  if (l.is_container && !r.is_container) return true;
+  if (r.is_container && !l.is_container) return false;
 
-  return false;
+  // Containers get sorted on their sort text.
+  if (l.is_container) return l.text.compare(r.text) < 0;
 
-#undef CompareInt
-#undef CompareString
+  // Otherwise we're comparing songs.  Sort by disc, track, then title.
+  if (l.disc != r.disc) return l.disc < r.disc;
+  if (l.track != r.track) return l.track < r.track;
+  return l.text.compare(r.text) < 0;
 }
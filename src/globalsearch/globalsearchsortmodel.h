@@ -18,14 +18,46 @@
 #ifndef GLOBALSEARCHSORTMODEL_H
 #define GLOBALSEARCHSORTMODEL_H
 
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QHash>
 #include <QSortFilterProxyModel>
+#include <vector>
 
+// The values of each row are read once and kept until the source model
+// changes, so sorting doesn't unpack the search result for every comparison.
 class GlobalSearchSortModel : public QSortFilterProxyModel {
  public:
   GlobalSearchSortModel(QObject* parent = nullptr);
 
+  void setSourceModel(QAbstractItemModel* source_model);
+
  protected:
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const;
+
+ private:
+  struct SortKey {
+    explicit SortKey(const QCollatorSortKey& text) : text(text) {}
+
+    int provider_index;
+    bool is_divider;
+    bool is_container;
+    int disc;
+    int track;
+    // The sort text of containers, or the title of songs.
+    QCollatorSortKey text;
+  };
+
+  // Where index's key is in sort_keys_, making it if it isn't there.
+  int SortKeyRow(const QModelIndex& index) const;
+  void ClearSortKeys();
+
+  QList<QMetaObject::Connection> source_connections_;
+
+  QCollator collator_;
+  QCollatorSortKey empty_sort_key_;
+  mutable QHash<QModelIndex, int> sort_key_rows_;
+  mutable std::vector<SortKey> sort_keys_;
 };
 
 #endif  // GLOBALSEARCHSORTMODEL_H
@@ -41,6 +41,7 @@
 #include "searchproviderstatuswidget.h"
 #include "suggestionwidget.h"
 #include "ui_globalsearchview.h"
+#include "widgets/didyoumean.h"
 
 using std::placeholders::_1;
 using std::placeholders::_2;
@@ -162,6 +163,12 @@ GlobalSearchView::GlobalSearchView(Application* app, QWidget* parent)
           Qt::QueuedConnection);
   connect(engine_, SIGNAL(ArtLoaded(int, QPixmap)),
           SLOT(ArtLoaded(int, QPixmap)), Qt::QueuedConnection);
+  connect(engine_, SIGNAL(SearchFinished(int)), SLOT(SearchFinished(int)),
+          Qt::QueuedConnection);
+
+  did_you_mean_ = new DidYouMean(ui_->search, this);
+  connect(did_you_mean_, SIGNAL(Accepted(QString)),
+          SLOT(StartSearch(QString)));
 }
 
 GlobalSearchView::~GlobalSearchView() { delete ui_; }
@@ -281,6 +288,8 @@ void GlobalSearchView::StartSearch(const QString& query) {
 void GlobalSearchView::TextEdited(const QString& text) {
   const QString trimmed(text.trimmed());
 
+  did_you_mean_->hide();
+
   // Add results to the back model, switch models after some delay.
   back_model_->Clear();
   current_model_ = back_model_;
@@ -304,8 +313,19 @@ void GlobalSearchView::AddResults(int id,
   current_model_->AddResults(results);
 }
 
+void GlobalSearchView::SearchFinished(int id) {
+  if (id != last_search_id_ || current_model_->rowCount() != 0) return;
+
+  const QString correction =
+      engine_->GetCorrection(ui_->search->text().trimmed());
+  if (!correction.isEmpty()) {
+    did_you_mean_->Show(correction);
+  }
+}
+
 void GlobalSearchView::SwapModels() {
-  art_requests_.clear();
+  // The art for the old results would only hold up the new ones.
+  CancelArtRequests();
 
   std::swap(front_model_, back_model_);
   std::swap(front_proxy_, back_proxy_);
@@ -373,6 +393,11 @@ void GlobalSearchView::ArtLoaded(int id, const QPixmap& pixmap) {
   }
 }
 
+void GlobalSearchView::CancelArtRequests() {
+  for (int id : art_requests_.keys()) engine_->CancelArt(id);
+  art_requests_.clear();
+}
+
 MimeData* GlobalSearchView::SelectedMimeData() {
   if (!ui_->results->selectionModel()) return nullptr;
 
@@ -580,7 +605,7 @@ void GlobalSearchView::SetGroupBy(const LibraryModel::Grouping& g) {
   // songs when they will be displayed again anyway (when
   // GlobalSearchItemDelegate::paint will call
   // LazyLoadArt)
-  art_requests_.clear();
+  CancelArtRequests();
   // Update the models
   front_model_->SetGroupBy(g, true);
   back_model_->SetGroupBy(g, false);
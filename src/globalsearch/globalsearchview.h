@@ -26,6 +26,7 @@
 #include "ui/settingsdialog.h"
 
 class Application;
+class DidYouMean;
 class GlobalSearchModel;
 class GroupByDialog;
 class SearchProviderStatusWidget;
@@ -74,6 +75,7 @@ class GlobalSearchView : public QWidget {
   void SwapModels();
   void TextEdited(const QString& text);
   void AddResults(int id, const SearchProvider::ResultList& results);
+  void SearchFinished(int id);
   void ArtLoaded(int id, const QPixmap& pixmap);
 
   void FocusOnFilter(QKeyEvent* event);
@@ -90,6 +92,8 @@ class GlobalSearchView : public QWidget {
 
  private:
   MimeData* SelectedMimeData();
+  // Cancels the art still loading for the front model and forgets it.
+  void CancelArtRequests();
 
   bool SearchKeyEvent(QKeyEvent* event);
   bool ResultsContextMenuEvent(QContextMenuEvent* event);
@@ -126,6 +130,8 @@ class GlobalSearchView : public QWidget {
   QList<SearchProviderStatusWidget*> provider_status_widgets_;
   QList<SuggestionWidget*> suggestion_widgets_;
 
+  DidYouMean* did_you_mean_;
+
   QIcon search_icon_;
   QIcon warning_icon_;
 
@@ -20,11 +20,20 @@
 #include "internet/icecast/icecastbackend.h"
 #include "ui/iconloader.h"
 
+namespace {
+const int kResultCacheTtlSecs = 30 * 60;
+}  // namespace
+
 IcecastSearchProvider::IcecastSearchProvider(
     std::shared_ptr<IcecastBackend> backend, Application* app, QObject* parent)
     : BlockingSearchProvider(app, parent), backend_(backend) {
   Init("Icecast", "icecast", IconLoader::Load("icon_radio", IconLoader::Lastfm),
        DisabledByDefault);
+
+  // The station list is refreshed from the directory every so often.
+  set_result_cache_ttl(kResultCacheTtlSecs);
+  connect(backend_.get(), SIGNAL(DatabaseReset()),
+          SIGNAL(ResultsInvalidated()));
 }
 
 SearchProvider::ResultList IcecastSearchProvider::Search(int id,
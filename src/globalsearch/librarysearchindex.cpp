@@ -0,0 +1,313 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "librarysearchindex.h"
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
+
+#include "core/database.h"
+#include "core/executor.h"
+#include "core/logging.h"
+#include "library/librarybackend.h"
+#include "library/libraryquery.h"
+
+// Same as a trigram, so every word searchable through the index is counted.
+const int LibrarySearchIndex::kMinWordLength = 3;
+
+LibrarySearchIndex::LibrarySearchIndex(LibraryBackend* backend, QObject* parent)
+    : QObject(parent), backend_(backend), ready_(false), building_(false) {
+  connect(backend_, SIGNAL(SongsDiscovered(SongList)),
+          SLOT(SongsDiscovered(SongList)));
+  connect(backend_, SIGNAL(SongsDeleted(SongList)),
+          SLOT(SongsDeleted(SongList)));
+  connect(backend_, SIGNAL(DatabaseReset()), SLOT(DatabaseReset()));
+}
+
+LibrarySearchIndex::~LibrarySearchIndex() { build_future_.waitForFinished(); }
+
+void LibrarySearchIndex::Build() {
+  build_future_.waitForFinished();
+
+  {
+    QMutexLocker l(&mutex_);
+    building_ = true;
+    pending_changes_.clear();
+  }
+
+  build_future_ = Executor::Db()->Run<void>([this]() { DoBuild(); });
+}
+
+void LibrarySearchIndex::DoBuild() {
+  QElapsedTimer timer;
+  timer.start();
+
+  QHash<int, QString> texts;
+  PostingLists postings;
+  QHash<QString, int> word_counts;
+  BKTree words;
+
+  {
+    QMutexLocker l(backend_->db()->ReadMutex());
+
+    // Songs come out in ROWID order so each posting list ends up sorted.
+    LibraryQuery q;
+    q.SetColumnSpec("ROWID, title, artist, album");
+    q.SetOrderBy("ROWID");
+    if (backend_->ExecQuery(&q)) {
+      while (q.Next()) {
+        const int id = q.Value(0).toInt();
+        const QString text = Normalise(q.Value(1).toString() + " " +
+                                       q.Value(2).toString() + " " +
+                                       q.Value(3).toString());
+        texts[id] = text;
+        for (quint64 trigram : Trigrams(text)) {
+          postings[trigram] << id;
+        }
+        for (const QString& word : Words(text)) {
+          if (word_counts[word]++ == 0) words.Insert(word);
+        }
+      }
+    }
+  }
+
+  QMutexLocker l(&mutex_);
+  texts_.swap(texts);
+  postings_.swap(postings);
+  word_counts_.swap(word_counts);
+  std::swap(words_, words);
+
+  for (const QPair<int, QString>& change : pending_changes_) {
+    if (change.second.isNull())
+      RemoveSongLocked(change.first);
+    else
+      AddSongLocked(change.first, change.second);
+  }
+  pending_changes_.clear();
+
+  building_ = false;
+  ready_ = true;
+
+  qLog(Debug) << "Built search index of" << texts_.count() << "songs and"
+              << postings_.count() << "trigrams in" << timer.elapsed() << "ms";
+}
+
+QString LibrarySearchIndex::Normalise(const QString& text) {
+  const QString decomposed =
+      text.normalized(QString::NormalizationForm_KD).toLower();
+
+  QString ret;
+  ret.reserve(decomposed.length());
+  for (const QChar& c : decomposed) {
+    if (c.category() == QChar::Mark_NonSpacing) continue;
+    ret += c.isLetterOrNumber() ? c : QChar(' ');
+  }
+  return ret;
+}
+
+QString LibrarySearchIndex::SongText(const Song& song) {
+  return Normalise(song.title() + " " + song.artist() + " " + song.album());
+}
+
+QList<quint64> LibrarySearchIndex::Trigrams(const QString& text) {
+  QSet<quint64> ret;
+  for (int i = 0; i + 2 < text.length(); ++i) {
+    const QChar a = text[i];
+    const QChar b = text[i + 1];
+    const QChar c = text[i + 2];
+    // Words never contain spaces, so trigrams that span words are useless.
+    if (a == ' ' || b == ' ' || c == ' ') continue;
+
+    ret << ((quint64(a.unicode()) << 32) | (quint64(b.unicode()) << 16) |
+            quint64(c.unicode()));
+  }
+  return ret.toList();
+}
+
+QStringList LibrarySearchIndex::Words(const QString& text) {
+  QStringList ret;
+  for (const QString& word : text.split(' ', QString::SkipEmptyParts)) {
+    if (word.length() >= kMinWordLength) ret << word;
+  }
+  return ret;
+}
+
+void LibrarySearchIndex::AddSongLocked(int id, const QString& text) {
+  if (texts_.contains(id)) RemoveSongLocked(id);
+  texts_[id] = text;
+
+  for (const QString& word : Words(text)) {
+    if (word_counts_[word]++ == 0) words_.Insert(word);
+  }
+
+  for (quint64 trigram : Trigrams(text)) {
+    QVector<int>& ids = postings_[trigram];
+    QVector<int>::iterator it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) ids.insert(it, id);
+  }
+}
+
+void LibrarySearchIndex::RemoveSongLocked(int id) {
+  if (!texts_.contains(id)) return;
+
+  const QString text = texts_.take(id);
+  for (const QString& word : Words(text)) {
+    if (--word_counts_[word] == 0) word_counts_.remove(word);
+  }
+
+  for (quint64 trigram : Trigrams(text)) {
+    PostingLists::iterator list = postings_.find(trigram);
+    if (list == postings_.end()) continue;
+
+    QVector<int>& ids = list.value();
+    QVector<int>::iterator it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it != ids.end() && *it == id) ids.erase(it);
+    if (ids.isEmpty()) postings_.erase(list);
+  }
+}
+
+void LibrarySearchIndex::SongsDiscovered(const SongList& songs) {
+  QMutexLocker l(&mutex_);
+  for (const Song& song : songs) {
+    if (building_)
+      pending_changes_ << qMakePair(song.id(), SongText(song));
+    else
+      AddSongLocked(song.id(), SongText(song));
+  }
+}
+
+void LibrarySearchIndex::SongsDeleted(const SongList& songs) {
+  QMutexLocker l(&mutex_);
+  for (const Song& song : songs) {
+    if (building_)
+      pending_changes_ << qMakePair(song.id(), QString());
+    else
+      RemoveSongLocked(song.id());
+  }
+}
+
+void LibrarySearchIndex::DatabaseReset() {
+  {
+    QMutexLocker l(&mutex_);
+    ready_ = false;
+  }
+  Build();
+}
+
+bool LibrarySearchIndex::Search(const QString& query, QList<int>* ids) const {
+  // Column filters and the like need the real query.
+  if (query.contains(':')) return false;
+
+  const QStringList words =
+      Normalise(query).split(' ', QString::SkipEmptyParts);
+  if (words.isEmpty()) return false;
+
+  QList<quint64> trigrams;
+  for (const QString& word : words) {
+    trigrams << Trigrams(word);
+  }
+  if (trigrams.isEmpty()) return false;
+
+  QMutexLocker l(&mutex_);
+  if (!ready_) return false;
+
+  // Intersect the posting lists, starting with the shortest.
+  QList<const QVector<int>*> lists;
+  for (quint64 trigram : trigrams) {
+    PostingLists::const_iterator it = postings_.constFind(trigram);
+    if (it == postings_.constEnd()) return true;  // No matches at all
+    lists << &it.value();
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](const QVector<int>* a, const QVector<int>* b) {
+              return a->count() < b->count();
+            });
+
+  QVector<int> candidates = *lists.first();
+  for (int i = 1; i < lists.count() && !candidates.isEmpty(); ++i) {
+    QVector<int> intersection;
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          lists[i]->begin(), lists[i]->end(),
+                          std::back_inserter(intersection));
+    candidates.swap(intersection);
+  }
+
+  // Having all the trigrams of a word doesn't mean having the word, and short
+  // words weren't looked at at all yet.
+  for (int id : candidates) {
+    const QString text = texts_.value(id);
+    bool matches = true;
+    for (const QString& word : words) {
+      if (!text.contains(word)) {
+        matches = false;
+        break;
+      }
+    }
+    if (matches) *ids << id;
+  }
+  return true;
+}
+
+QString LibrarySearchIndex::Correct(const QString& query) const {
+  if (query.contains(':')) return QString();
+
+  const QStringList words =
+      Normalise(query).split(' ', QString::SkipEmptyParts);
+
+  QMutexLocker l(&mutex_);
+  if (!ready_) return QString();
+
+  QStringList ret;
+  bool corrected = false;
+
+  for (const QString& word : words) {
+    if (word.length() < kMinWordLength || word_counts_.contains(word)) {
+      ret << word;
+      continue;
+    }
+
+    // Allow more typos in longer words.  Among the closest matches prefer the
+    // most common word.
+    const int max_distance = word.length() <= 4 ? 1 : 2;
+    QString best;
+    int best_distance = max_distance + 1;
+    int best_count = 0;
+
+    for (const BKTree::Match& match : words_.Find(word, max_distance)) {
+      const int count = word_counts_.value(match.first);
+      if (count == 0) continue;
+
+      if (match.second < best_distance ||
+          (match.second == best_distance && count > best_count)) {
+        best = match.first;
+        best_distance = match.second;
+        best_count = count;
+      }
+    }
+
+    if (best.isEmpty()) {
+      ret << word;
+    } else {
+      ret << best;
+      corrected = true;
+    }
+  }
+
+  return corrected ? ret.join(" ") : QString();
+}
@@ -0,0 +1,103 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GLOBALSEARCH_LIBRARYSEARCHINDEX_H_
+#define GLOBALSEARCH_LIBRARYSEARCHINDEX_H_
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QVector>
+
+#include "core/bktree.h"
+#include "core/song.h"
+
+class LibraryBackend;
+
+// An in-memory trigram index over the title, artist and album of every song
+// in a library.  It finds songs containing each word of a query anywhere in
+// those fields, without going to the database.  It also keeps a BK-tree of the
+// words in those fields to suggest corrections for misspelt queries.  The
+// index is built in the background and then kept up to date from the
+// backend's signals.
+class LibrarySearchIndex : public QObject {
+  Q_OBJECT
+
+ public:
+  LibrarySearchIndex(LibraryBackend* backend, QObject* parent = nullptr);
+  ~LibrarySearchIndex();
+
+  // Starts building the index in the background.
+  void Build();
+
+  // Puts the IDs of the songs matching query in ids.  Returns false if the
+  // index isn't ready yet or can't answer this query, for example because all
+  // its words are shorter than a trigram or it uses column filters.
+  // Thread-safe.
+  bool Search(const QString& query, QList<int>* ids) const;
+
+  // Returns query with each word that isn't in the library replaced by the
+  // closest one that is, or an empty string if nothing needed correcting.
+  // Thread-safe.
+  QString Correct(const QString& query) const;
+
+  // Lower case, without diacritics and with anything that isn't a letter or
+  // number replaced by a space.
+  static QString Normalise(const QString& text);
+
+ private slots:
+  void SongsDiscovered(const SongList& songs);
+  void SongsDeleted(const SongList& songs);
+  void DatabaseReset();
+
+ private:
+  typedef QHash<quint64, QVector<int>> PostingLists;
+
+  static const int kMinWordLength;
+
+  static QString SongText(const Song& song);
+  static QList<quint64> Trigrams(const QString& text);
+  static QStringList Words(const QString& text);
+
+  void DoBuild();
+  void AddSongLocked(int id, const QString& text);
+  void RemoveSongLocked(int id);
+
+  LibraryBackend* backend_;
+  QFuture<void> build_future_;
+
+  mutable QMutex mutex_;
+  bool ready_;
+  bool building_;
+
+  // Normalised text of each song, used to check candidates.
+  QHash<int, QString> texts_;
+  // Sorted song IDs for each trigram.
+  PostingLists postings_;
+  // How many times each word appears, and a tree of every word that has
+  // appeared.  Words whose count is back to 0 are still in the tree.
+  QHash<QString, int> word_counts_;
+  BKTree words_;
+  // Changes that arrived while the index was being built.  A null text means
+  // the song was removed.
+  QList<QPair<int, QString>> pending_changes_;
+};
+
+#endif  // GLOBALSEARCH_LIBRARYSEARCHINDEX_H_
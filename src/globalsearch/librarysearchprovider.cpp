@@ -25,12 +25,15 @@
 
 #include "core/logging.h"
 #include "covers/albumcoverloader.h"
+#include "globalsearch/librarysearchindex.h"
 #include "library/librarybackend.h"
 #include "library/libraryquery.h"
 #include "library/sqlrow.h"
 #include "playlist/songmimedata.h"
 
-LibrarySearchProvider::LibrarySearchProvider(LibraryBackendInterface* backend,
+const int LibrarySearchProvider::kMaxIdsPerQuery = 500;
+
+LibrarySearchProvider::LibrarySearchProvider(LibraryBackend* backend,
                                              const QString& name,
                                              const QString& id,
                                              const QIcon& icon,
@@ -45,10 +48,31 @@ LibrarySearchProvider::LibrarySearchProvider(LibraryBackendInterface* backend,
   }
 
   Init(name, id, icon, hints);
+
+  set_result_cache_ttl(kCacheUntilInvalidated);
+  connect(backend_, SIGNAL(SongsDiscovered(SongList)),
+          SIGNAL(ResultsInvalidated()));
+  connect(backend_, SIGNAL(SongsDeleted(SongList)),
+          SIGNAL(ResultsInvalidated()));
+  connect(backend_, SIGNAL(DatabaseReset()), SIGNAL(ResultsInvalidated()));
+}
+
+LibrarySearchProvider::~LibrarySearchProvider() {}
+
+void LibrarySearchProvider::EnableIndex() {
+  if (index_) return;
+
+  index_.reset(new LibrarySearchIndex(backend_));
+  index_->Build();
 }
 
 SearchProvider::ResultList LibrarySearchProvider::Search(int id,
                                                          const QString& query) {
+  QList<int> ids;
+  if (index_ && index_->Search(query, &ids)) {
+    return SongsById(ids);
+  }
+
   QueryOptions options;
   options.set_filter(query);
 
@@ -70,6 +94,34 @@ SearchProvider::ResultList LibrarySearchProvider::Search(int id,
   return ret;
 }
 
+SearchProvider::ResultList LibrarySearchProvider::SongsById(
+    const QList<int>& ids) {
+  ResultList ret;
+
+  for (int i = 0; i < ids.count(); i += kMaxIdsPerQuery) {
+    QStringList chunk;
+    for (int id : ids.mid(i, kMaxIdsPerQuery)) {
+      chunk << QString::number(id);
+    }
+
+    LibraryQuery q;
+    q.SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
+    q.AddWhere("%songs_table.ROWID", chunk, "IN");
+
+    if (!backend_->ExecQuery(&q)) {
+      return ResultList();
+    }
+
+    while (q.Next()) {
+      Result result(this);
+      result.metadata_.InitFromQuery(q, true);
+      ret << result;
+    }
+  }
+
+  return ret;
+}
+
 MimeData* LibrarySearchProvider::LoadTracks(const ResultList& results) {
   MimeData* ret = SearchProvider::LoadTracks(results);
   static_cast<SongMimeData*>(ret)->backend = backend_;
@@ -77,6 +129,11 @@ MimeData* LibrarySearchProvider::LoadTracks(const ResultList& results) {
   return ret;
 }
 
+QString LibrarySearchProvider::GetCorrection(const QString& query) {
+  if (!index_) return QString();
+  return index_->Correct(query);
+}
+
 QStringList LibrarySearchProvider::GetSuggestions(int count) {
   // We'd like to use order by random(), but that's O(n) in sqlite, so instead
   // get the largest ROWID and pick a couple of random numbers within that
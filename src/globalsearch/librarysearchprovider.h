@@ -18,23 +18,39 @@
 #ifndef LIBRARYSEARCHPROVIDER_H
 #define LIBRARYSEARCHPROVIDER_H
 
+#include <memory>
+
 #include "searchprovider.h"
 
-class LibraryBackendInterface;
+class LibraryBackend;
+class LibrarySearchIndex;
 
 class LibrarySearchProvider : public BlockingSearchProvider {
  public:
-  LibrarySearchProvider(LibraryBackendInterface* backend, const QString& name,
+  LibrarySearchProvider(LibraryBackend* backend, const QString& name,
                         const QString& id, const QIcon& icon,
                         bool enabled_by_default, Application* app,
                         QObject* parent = nullptr);
+  ~LibrarySearchProvider();
+
+  // Answers searches from an in-memory trigram index where possible instead
+  // of querying the database each time.  The index is built in the
+  // background.
+  void EnableIndex();
 
   ResultList Search(int id, const QString& query);
   MimeData* LoadTracks(const ResultList& results);
   QStringList GetSuggestions(int count);
+  QString GetCorrection(const QString& query);
 
  private:
-  LibraryBackendInterface* backend_;
+  ResultList SongsById(const QList<int>& ids);
+
+ private:
+  static const int kMaxIdsPerQuery;
+
+  LibraryBackend* backend_;
+  std::unique_ptr<LibrarySearchIndex> index_;
 };
 
 #endif  // LIBRARYSEARCHPROVIDER_H
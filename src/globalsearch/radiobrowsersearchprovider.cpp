@@ -21,6 +21,8 @@
 
 namespace {
 const int kSearchStationLimit = 10;
+// Searches go to the server, so remember the results for a while.
+const int kResultCacheTtlSecs = 10 * 60;
 }  // namespace
 
 RadioBrowserSearchProvider::RadioBrowserSearchProvider(
@@ -29,6 +31,7 @@ RadioBrowserSearchProvider::RadioBrowserSearchProvider(
   Init(RadioBrowserService::kServiceName, "radiobrowser",
        IconLoader::Load("radiobrowser", IconLoader::Provider),
        WantsDelayedQueries);
+  set_result_cache_ttl(kResultCacheTtlSecs);
   connect(service_, &RadioBrowserService::SearchFinished, this,
           &RadioBrowserSearchProvider::SearchFinishedSlot);
 }
@@ -26,9 +26,14 @@
 #include "playlist/songmimedata.h"
 
 const int SearchProvider::kArtHeight = 32;
+const int SearchProvider::kResultsNotCached = -1;
+const int SearchProvider::kCacheUntilInvalidated = 0;
 
 SearchProvider::SearchProvider(Application* app, QObject* parent)
-    : QObject(parent), app_(app), hints_(0) {}
+    : QObject(parent),
+      app_(app),
+      hints_(0),
+      result_cache_ttl_(kResultsNotCached) {}
 
 void SearchProvider::Init(const QString& name, const QString& id,
                           const QIcon& icon, Hints hints) {
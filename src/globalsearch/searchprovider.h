@@ -36,6 +36,8 @@ class SearchProvider : public QObject {
   SearchProvider(Application* app, QObject* parent = nullptr);
 
   static const int kArtHeight;
+  static const int kResultsNotCached;
+  static const int kCacheUntilInvalidated;
 
   struct Result {
     Result(SearchProvider* provider = 0)
@@ -122,6 +124,12 @@ class SearchProvider : public QObject {
     return hints() & MimeDataContainsUrlsOnly;
   }
 
+  // How long GlobalSearch may reuse this provider's results for a query it has
+  // seen before, in seconds.  kCacheUntilInvalidated keeps them until the
+  // provider emits ResultsInvalidated, kResultsNotCached (the default) turns
+  // caching off.
+  int result_cache_ttl() const { return result_cache_ttl_; }
+
   // Starts a search.  Must emit ResultsAvailable zero or more times and then
   // SearchFinished exactly once, using this ID.
   virtual void SearchAsync(int id, const QString& query) = 0;
@@ -140,6 +148,11 @@ class SearchProvider : public QObject {
   // strings.  Remember to set the CanGiveSuggestions hint.
   virtual QStringList GetSuggestions(int count) { return QStringList(); }
 
+  // Returns a corrected spelling of a query that found nothing, or an empty
+  // string if the provider doesn't have one.  Called on the main thread, so
+  // this has to be quick.
+  virtual QString GetCorrection(const QString& query) { return QString(); }
+
   // If provider needs user login to search and play songs, this method should
   // be reimplemented
   virtual bool IsLoggedIn() { return true; }
@@ -156,6 +169,9 @@ class SearchProvider : public QObject {
 
   void ArtLoaded(int id, const QImage& image);
 
+  // Tells GlobalSearch that results it cached for this provider are stale.
+  void ResultsInvalidated();
+
  protected:
   // These functions treat queries in the same way as LibraryQuery.  They're
   // useful for figuring out whether you got a result because it matched in
@@ -167,6 +183,7 @@ class SearchProvider : public QObject {
   void Init(const QString& name, const QString& id, const QIcon& icon,
             Hints hints = NoHints);
   void SetHint(Hint hint, bool set = true);
+  void set_result_cache_ttl(int secs) { result_cache_ttl_ = secs; }
 
   struct PendingState {
     PendingState() : orig_id_(-1) {}
@@ -193,6 +210,7 @@ class SearchProvider : public QObject {
   QIcon icon_;
   Hints hints_;
   QImage icon_as_image_;
+  int result_cache_ttl_;
 };
 
 Q_DECLARE_METATYPE(SearchProvider::Result)
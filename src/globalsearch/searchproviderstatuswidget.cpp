@@ -18,6 +18,7 @@
 #include "searchproviderstatuswidget.h"
 
 #include <QMouseEvent>
+#include <QStringList>
 
 #include "core/application.h"
 #include "globalsearch.h"
@@ -36,6 +37,7 @@ SearchProviderStatusWidget::SearchProviderStatusWidget(
 
   ui_->icon->setPixmap(provider->icon().pixmap(16));
   ui_->name->setText(provider->name());
+  ui_->name->installEventFilter(this);
 
   const bool enabled = engine->is_provider_enabled(provider);
   const bool logged_in = provider->IsLoggedIn();
@@ -61,7 +63,43 @@ SearchProviderStatusWidget::SearchProviderStatusWidget(
 
 SearchProviderStatusWidget::~SearchProviderStatusWidget() { delete ui_; }
 
+QString SearchProviderStatusWidget::LatencySummary() const {
+  const GlobalSearch::LatencyStats stats = engine_->provider_latency(provider_);
+
+  QStringList lines;
+  int lower = 0;
+  for (int i = 0; i < GlobalSearch::kLatencyBucketCount; ++i) {
+    const int upper = GlobalSearch::kLatencyBucketsMs[i];
+    if (stats.counts_[i]) {
+      lines << tr("%1 - %2 ms: %3")
+                   .arg(lower)
+                   .arg(upper)
+                   .arg(stats.counts_[i]);
+    }
+    lower = upper;
+  }
+  if (stats.counts_.last()) {
+    lines << tr("Over %1 ms: %2").arg(lower).arg(stats.counts_.last());
+  }
+  if (stats.timeouts_) {
+    lines << tr("Timed out: %1").arg(stats.timeouts_);
+  }
+
+  if (lines.isEmpty()) {
+    return tr("No searches yet");
+  }
+  return tr("Search times") + "\n" + lines.join("\n");
+}
+
 bool SearchProviderStatusWidget::eventFilter(QObject* object, QEvent* event) {
+  if (object == ui_->name) {
+    // Fill in the latest numbers just before the tooltip is shown.
+    if (event->type() == QEvent::ToolTip) {
+      ui_->name->setToolTip(LatencySummary());
+    }
+    return QWidget::eventFilter(object, event);
+  }
+
   if (object != ui_->disabled_reason) {
     return QWidget::eventFilter(object, event);
   }
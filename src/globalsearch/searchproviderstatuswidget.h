@@ -33,6 +33,9 @@ class SearchProviderStatusWidget : public QWidget {
 
   bool eventFilter(QObject* object, QEvent* event);
 
+ private:
+  QString LatencySummary() const;
+
  private:
   Ui_SearchProviderStatusWidget* ui_;
 
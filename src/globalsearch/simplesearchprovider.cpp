@@ -41,13 +41,16 @@ SimpleSearchProvider::SimpleSearchProvider(Application* app, QObject* parent)
       result_limit_(kDefaultResultLimit),
       max_suggestion_count_(-1),
       items_dirty_(true),
-      has_searched_before_(false) {}
+      has_searched_before_(false) {
+  set_result_cache_ttl(kCacheUntilInvalidated);
+}
 
 void SimpleSearchProvider::MaybeRecreateItems() {
   if (has_searched_before_) {
     RecreateItems();
   } else {
     items_dirty_ = true;
+    emit ResultsInvalidated();
   }
 }
 
@@ -96,6 +99,8 @@ void SimpleSearchProvider::SetItems(const ItemList& items) {
   for (ItemList::iterator it = items_.begin(); it != items_.end(); ++it) {
     it->metadata_.set_filetype(Song::Type_Stream);
   }
+
+  emit ResultsInvalidated();
 }
 
 QStringList SimpleSearchProvider::GetSuggestions(int count) {
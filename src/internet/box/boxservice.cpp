@@ -49,6 +49,7 @@ static const int kRootFolderId = 0;
 static const char* kFileContent = "https://api.box.com/2.0/files/%1/content";
 
 static const char* kEvents = "https://api.box.com/2.0/events";
+static const int kEventsLimit = 5000;  // Maximum according to API docs.
 }  // namespace
 
 BoxService::BoxService(Application* app, InternetModel* parent)
@@ -157,9 +158,10 @@ void BoxService::UpdateFiles() {
     return;
   }
 
-  // First run we scan as events may not cover everything.
-  FetchRecursiveFolderItems(kRootFolderId);
+  // First run we scan as events may not cover everything.  The cursor is
+  // taken before the scan so nothing that changes during it is missed.
   InitialiseEventsCursor();
+  FetchRecursiveFolderItems(kRootFolderId);
 }
 
 void BoxService::InitialiseEventsCursor() {
@@ -179,9 +181,9 @@ void BoxService::InitialiseEventsFinished(QNetworkReply* reply) {
   QJsonObject json_response =
       QJsonDocument::fromJson(reply->readAll()).object();
   if (json_response.contains("next_stream_position")) {
-    QSettings s;
-    s.beginGroup(kSettingsGroup);
-    s.setValue("cursor", json_response["next_stream_position"].toString());
+    SaveCursorWhenIndexed(
+        kSettingsGroup,
+        json_response["next_stream_position"].toVariant().toString());
   }
 }
 
@@ -203,6 +205,7 @@ void BoxService::FetchRecursiveFolderItems(const int folder_id,
   QNetworkRequest request(url);
   AddAuthorizationHeader(&request);
   QNetworkReply* reply = network_->get(request);
+  BeginIndexingRequest();
   NewClosure(reply, SIGNAL(finished()), this,
              SLOT(FetchFolderItemsFinished(QNetworkReply*, int)), reply,
              folder_id);
@@ -231,6 +234,8 @@ void BoxService::FetchFolderItemsFinished(QNetworkReply* reply,
       MaybeAddFileEntry(entry);
     }
   }
+
+  EndIndexingRequest();
 }
 
 void BoxService::MaybeAddFileEntry(const QJsonObject& entry) {
@@ -239,6 +244,11 @@ void BoxService::MaybeAddFileEntry(const QJsonObject& entry) {
   url.setScheme("box");
   url.setPath("/" + entry["id"].toString());
 
+  // Don't follow the redirect for files we've already got.
+  if (!ShouldIndexFile(url, mime_type)) {
+    return;
+  }
+
   Song song;
   song.set_url(url);
   song.set_ctime(
@@ -250,6 +260,7 @@ void BoxService::MaybeAddFileEntry(const QJsonObject& entry) {
 
   // This is actually a redirect. Follow it now.
   QNetworkReply* reply = FetchContentUrlForFile(entry["id"].toString());
+  BeginIndexingRequest();
   NewClosure(reply, SIGNAL(finished()), this,
              SLOT(RedirectFollowed(QNetworkReply*, Song, QString)), reply, song,
              mime_type);
@@ -268,20 +279,18 @@ void BoxService::RedirectFollowed(QNetworkReply* reply, const Song& song,
   reply->deleteLater();
   QVariant redirect =
       reply->attribute(QNetworkRequest::RedirectionTargetAttribute);
-  if (!redirect.isValid()) {
-    return;
+  if (redirect.isValid()) {
+    MaybeAddFileToDatabase(song, mime_type, redirect.toUrl(),
+                           QString("Bearer %1").arg(access_token_));
   }
-
-  QUrl real_url = redirect.toUrl();
-  MaybeAddFileToDatabase(song, mime_type, real_url,
-                         QString("Bearer %1").arg(access_token_));
+  EndIndexingRequest();
 }
 
 void BoxService::UpdateFilesFromCursor(const QString& cursor) {
   QUrl url(kEvents);
   QUrlQuery url_query;
   url_query.addQueryItem("stream_position", cursor);
-  url_query.addQueryItem("limit", "5000");
+  url_query.addQueryItem("limit", QString::number(kEventsLimit));
   url.setQuery(url_query);
   QNetworkRequest request(url);
   AddAuthorizationHeader(&request);
@@ -291,14 +300,15 @@ void BoxService::UpdateFilesFromCursor(const QString& cursor) {
 }
 
 void BoxService::FetchEventsFinished(QNetworkReply* reply) {
-  // TODO(John Maguire): Page through events.
   reply->deleteLater();
   QJsonObject json_response =
       QJsonDocument::fromJson(reply->readAll()).object();
+  if (!json_response.contains("next_stream_position")) {
+    return;
+  }
 
-  QSettings s;
-  s.beginGroup(kSettingsGroup);
-  s.setValue("cursor", json_response["next_stream_position"].toString());
+  const QString cursor =
+      json_response["next_stream_position"].toVariant().toString();
 
   QJsonArray entries = json_response["entries"].toArray();
   for (const QJsonValue& e : entries) {
@@ -321,6 +331,13 @@ void BoxService::FetchEventsFinished(QNetworkReply* reply) {
       }
     }
   }
+
+  SaveCursorWhenIndexed(kSettingsGroup, cursor);
+
+  // A full page means there are more events waiting.
+  if (entries.size() >= kEventsLimit) {
+    UpdateFilesFromCursor(cursor);
+  }
 }
 
 QUrl BoxService::GetStreamingUrlFromSongId(const QString& id) {
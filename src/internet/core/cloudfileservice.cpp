@@ -23,6 +23,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSettings>
 #include <QSortFilterProxyModel>
 
 #include "core/application.h"
@@ -39,6 +40,8 @@
 #include "playlist/playlist.h"
 #include "ui/iconloader.h"
 
+const int CloudFileService::kMaxConcurrentTagReads = 4;
+
 CloudFileService::CloudFileService(Application* app, InternetModel* parent,
                                    const QString& service_name,
                                    const QString& service_id, const QIcon& icon,
@@ -53,7 +56,8 @@ CloudFileService::CloudFileService(Application* app, InternetModel* parent,
       settings_page_(settings_page),
       indexing_task_id_(-1),
       indexing_task_progress_(0),
-      indexing_task_max_(0) {
+      indexing_task_max_(0),
+      indexing_requests_(0) {
   library_backend_.reset(new LibraryBackend,
                          [](QObject* obj) { obj->deleteLater(); });
   library_backend_->moveToThread(app_->database()->thread());
@@ -142,7 +146,8 @@ void CloudFileService::MaybeAddFileToDatabase(const Song& metadata,
                                               const QString& mime_type,
                                               const QUrl& download_url,
                                               const QString& authorisation) {
-  if (!ShouldIndexFile(metadata.url(), mime_type)) {
+  if (indexing_urls_.contains(metadata.url()) ||
+      !ShouldIndexFile(metadata.url(), mime_type)) {
     return;
   }
 
@@ -155,14 +160,32 @@ void CloudFileService::MaybeAddFileToDatabase(const Song& metadata,
   task_manager_->SetTaskProgress(indexing_task_id_, indexing_task_progress_,
                                  indexing_task_max_);
 
-  TagReaderClient::ReplyType* reply = app_->tag_reader_client()->ReadCloudFile(
-      download_url, metadata.title(), metadata.filesize(), mime_type,
-      authorisation);
-  pending_tagreader_replies_.append(reply);
+  TagRead read;
+  read.metadata_ = metadata;
+  read.mime_type_ = mime_type;
+  read.download_url_ = download_url;
+  read.authorisation_ = authorisation;
+  queued_tag_reads_.enqueue(read);
+  indexing_urls_.insert(metadata.url());
 
-  NewClosure(reply, SIGNAL(Finished(bool)), this,
-             SLOT(ReadTagsFinished(TagReaderClient::ReplyType*, Song)), reply,
-             metadata);
+  StartTagReads();
+}
+
+void CloudFileService::StartTagReads() {
+  while (!queued_tag_reads_.isEmpty() &&
+         pending_tagreader_replies_.count() < kMaxConcurrentTagReads) {
+    const TagRead read = queued_tag_reads_.dequeue();
+
+    TagReaderClient::ReplyType* reply =
+        app_->tag_reader_client()->ReadCloudFile(
+            read.download_url_, read.metadata_.title(),
+            read.metadata_.filesize(), read.mime_type_, read.authorisation_);
+    pending_tagreader_replies_.append(reply);
+
+    NewClosure(reply, SIGNAL(Finished(bool)), this,
+               SLOT(ReadTagsFinished(TagReaderClient::ReplyType*, Song)),
+               reply, read.metadata_);
+  }
 }
 
 void CloudFileService::ReadTagsFinished(TagReaderClient::ReplyType* reply,
@@ -177,34 +200,68 @@ void CloudFileService::ReadTagsFinished(TagReaderClient::ReplyType* reply,
   }
 
   pending_tagreader_replies_.removeAt(index_reply);
-
-  indexing_task_progress_++;
-  if (indexing_task_progress_ == indexing_task_max_) {
-    task_manager_->SetTaskFinished(indexing_task_id_);
-    indexing_task_id_ = -1;
-    emit AllIndexingTasksFinished();
-  } else {
-    task_manager_->SetTaskProgress(indexing_task_id_, indexing_task_progress_,
-                                   indexing_task_max_);
-  }
+  indexing_urls_.remove(metadata.url());
 
   const cpb::tagreader::ReadCloudFileResponse& message =
       reply->message().read_cloud_file_response();
   if (!message.has_metadata() || !message.metadata().filesize()) {
     qLog(Debug) << "Failed to tag:" << metadata.url();
+  } else {
+    cpb::tagreader::SongMetadata metadata_pb;
+    metadata.ToProtobuf(&metadata_pb);
+    metadata_pb.MergeFrom(message.metadata());
+
+    Song song;
+    song.InitFromProtobuf(metadata_pb);
+    song.set_directory_id(0);
+
+    qLog(Debug) << "Adding song to db:" << song.title();
+    library_backend_->AddOrUpdateSongs(SongList() << song);
+  }
+
+  indexing_task_progress_++;
+  task_manager_->SetTaskProgress(indexing_task_id_, indexing_task_progress_,
+                                 indexing_task_max_);
+
+  StartTagReads();
+  MaybeFinishIndexing();
+}
+
+void CloudFileService::MaybeFinishIndexing() {
+  if (indexing_requests_ > 0 || !pending_tagreader_replies_.isEmpty() ||
+      !queued_tag_reads_.isEmpty()) {
     return;
   }
 
-  cpb::tagreader::SongMetadata metadata_pb;
-  metadata.ToProtobuf(&metadata_pb);
-  metadata_pb.MergeFrom(message.metadata());
+  if (indexing_task_id_ != -1) {
+    task_manager_->SetTaskFinished(indexing_task_id_);
+    indexing_task_id_ = -1;
+  }
+  emit AllIndexingTasksFinished();
+}
+
+void CloudFileService::BeginIndexingRequest() { indexing_requests_++; }
+
+void CloudFileService::EndIndexingRequest() {
+  indexing_requests_--;
+  MaybeFinishIndexing();
+}
 
-  Song song;
-  song.InitFromProtobuf(metadata_pb);
-  song.set_directory_id(0);
+void CloudFileService::SaveCursorWhenIndexed(const QString& settings_group,
+                                             const QString& cursor) {
+  if (is_indexing()) {
+    NewClosure(this, SIGNAL(AllIndexingTasksFinished()), this,
+               SLOT(SaveCursor(QString, QString)), settings_group, cursor);
+  } else {
+    SaveCursor(settings_group, cursor);
+  }
+}
 
-  qLog(Debug) << "Adding song to db:" << song.title();
-  library_backend_->AddOrUpdateSongs(SongList() << song);
+void CloudFileService::SaveCursor(const QString& settings_group,
+                                  const QString& cursor) {
+  QSettings s;
+  s.beginGroup(settings_group);
+  s.setValue("cursor", cursor);
 }
 
 bool CloudFileService::IsSupportedMimeType(const QString& mime_type) const {
@@ -234,6 +291,8 @@ QString CloudFileService::GuessMimeTypeForFile(const QString& filename) const {
 void CloudFileService::AbortReadTagsReplies() {
   qLog(Debug) << "Aborting the read tags replies";
   pending_tagreader_replies_.clear();
+  queued_tag_reads_.clear();
+  indexing_urls_.clear();
 
   task_manager_->SetTaskFinished(indexing_task_id_);
   indexing_task_id_ = -1;
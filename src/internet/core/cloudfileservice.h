@@ -21,6 +21,8 @@
 #define INTERNET_CORE_CLOUDFILESERVICE_H_
 
 #include <QMenu>
+#include <QQueue>
+#include <QSet>
 #include <memory>
 
 #include "core/tagreaderclient.h"
@@ -47,7 +49,9 @@ class CloudFileService : public InternetService {
   virtual void LazyPopulate(QStandardItem* item) override;
 
   virtual bool has_credentials() const = 0;
-  bool is_indexing() const { return indexing_task_id_ != -1; }
+  bool is_indexing() const {
+    return indexing_task_id_ != -1 || indexing_requests_ > 0;
+  }
 
   bool ConfigRequired() override { return !has_credentials(); }
  signals:
@@ -67,6 +71,18 @@ class CloudFileService : public InternetService {
   QString GuessMimeTypeForFile(const QString& filename) const;
   void AbortReadTagsReplies();
 
+  // For services that have to make another request before they can call
+  // MaybeAddFileToDatabase.  Indexing isn't finished until every call to
+  // BeginIndexingRequest has been matched by EndIndexingRequest.
+  void BeginIndexingRequest();
+  void EndIndexingRequest();
+
+  // Saves a change feed cursor under settings_group once every file found so
+  // far has been indexed, so if Clementine is closed first the changes are
+  // fetched again next time.
+  void SaveCursorWhenIndexed(const QString& settings_group,
+                             const QString& cursor);
+
   // Called once when context menu is created
   virtual void PopulateContextMenu() override;
 
@@ -77,6 +93,7 @@ class CloudFileService : public InternetService {
                         const Song& metadata);
   void FullRescanRequested();
   virtual void DoFullRescan() {}
+  void SaveCursor(const QString& settings_group, const QString& cursor);
 
  protected:
   QStandardItem* root_;
@@ -92,12 +109,31 @@ class CloudFileService : public InternetService {
   QList<TagReaderClient::ReplyType*> pending_tagreader_replies_;
 
  private:
+  struct TagRead {
+    Song metadata_;
+    QString mime_type_;
+    QUrl download_url_;
+    QString authorisation_;
+  };
+
+  void StartTagReads();
+  void MaybeFinishIndexing();
+
+  // Every read downloads part of the file, so only a few run at once.
+  static const int kMaxConcurrentTagReads;
+
   QIcon icon_;
   SettingsDialog::Page settings_page_;
 
   int indexing_task_id_;
   int indexing_task_progress_;
   int indexing_task_max_;
+  int indexing_requests_;
+
+  QQueue<TagRead> queued_tag_reads_;
+  // The URLs of files in queued_tag_reads_ or being read, so files that turn
+  // up again in the change feed aren't read twice.
+  QSet<QUrl> indexing_urls_;
 };
 
 #endif  // INTERNET_CORE_CLOUDFILESERVICE_H_
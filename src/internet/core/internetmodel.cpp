@@ -25,12 +25,18 @@
 
 #include "internet/core/internetmodel.h"
 
+#include <QElapsedTimer>
 #include <QMimeData>
 #include <QtDebug>
 
+#include "core/application.h"
 #include "core/closure.h"
 #include "core/logging.h"
 #include "core/mergedproxymodel.h"
+#include "core/player.h"
+#include "core/trace.h"
+#include "core/urlhandler.h"
+#include "globalsearch/globalsearch.h"
 #include "internet/core/internetmimedata.h"
 #include "internet/core/internetservice.h"
 #include "internet/digitally/digitallyimportedservicebase.h"
@@ -44,6 +50,7 @@
 #include "internet/somafm/somafmservice.h"
 #include "internet/subsonic/subsonicservice.h"
 #include "smartplaylists/generatormimedata.h"
+#include "ui/iconloader.h"
 
 #ifdef HAVE_GOOGLE_DRIVE
 #include "internet/googledrive/googledriveservice.h"
@@ -66,56 +73,261 @@ using smart_playlists::GeneratorMimeData;
 using smart_playlists::GeneratorPtr;
 
 QMap<QString, InternetService*>* InternetModel::sServices = nullptr;
+InternetModel* InternetModel::sInstance = nullptr;
 
 const char* InternetModel::kSettingsGroup = "InternetModel";
 
+namespace {
+
+// Stands in for a deferred service's URL handler.  Loading a URL creates the
+// service, which registers its own handler in our place, and hands the URL on
+// to that.
+class DeferredUrlHandler : public UrlHandler {
+ public:
+  DeferredUrlHandler(const QString& scheme, const QIcon& icon,
+                     const QString& service_name, Player* player,
+                     QObject* parent)
+      : UrlHandler(parent),
+        scheme_(scheme),
+        icon_(icon),
+        service_name_(service_name),
+        player_(player) {}
+
+  QString scheme() const { return scheme_; }
+  QIcon icon() const { return icon_; }
+
+  LoadResult StartLoading(const QUrl& url) {
+    InternetModel::ServiceByName(service_name_);
+
+    UrlHandler* handler = player_->HandlerForUrl(url);
+    if (!handler || handler == this) {
+      qLog(Warning) << "No URL handler for" << url.scheme() << "after creating"
+                    << service_name_;
+      return LoadResult(url, LoadResult::Error);
+    }
+    return handler->StartLoading(url);
+  }
+
+ private:
+  QString scheme_;
+  QIcon icon_;
+  QString service_name_;
+  Player* player_;
+};
+
+}  // namespace
+
 InternetModel::InternetModel(Application* app, QObject* parent)
     : QStandardItemModel(parent),
       app_(app),
       merged_model_(new MergedProxyModel(this)) {
+  TRACE_SCOPE("InternetModel::InternetModel");
   if (!sServices) {
     sServices = new QMap<QString, InternetService*>;
   }
   Q_ASSERT(sServices->isEmpty());
+  sInstance = this;
 
   merged_model_->setSourceModel(this);
   connect(merged_model_, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
           SLOT(RowsAboutToBeRemoved(QModelIndex, int, int)));
-
-  AddService(new ClassicalRadioService(app, this));
-  AddService(new DigitallyImportedService(app, this));
-  AddService(new IcecastService(app, this));
-  AddService(new JamendoService(app, this));
-  AddService(new JazzRadioService(app, this));
-  AddService(new MagnatuneService(app, this));
-  AddService(new PodcastService(app, this));
-  AddService(new RockRadioService(app, this));
-  AddService(new SavedRadio(app, this));
-  AddService(new RadioTunesService(app, this));
-  AddService(new SomaFMService(app, this));
-  AddService(new IntergalacticFMService(app, this));
-  AddService(new RadioBrowserService(app, this));
-  AddService(new SubsonicService(app, this));
+  connect(app->global_search(), SIGNAL(SearchAboutToStart()),
+          SLOT(CreateSearchableServices()));
+
+  // These are used straight away by the main window or the playlists, so
+  // there's nothing to gain from deferring them.
+  CreateService([=]() { return new ClassicalRadioService(app, this); });
+  CreateService([=]() { return new DigitallyImportedService(app, this); });
+  CreateService([=]() { return new JazzRadioService(app, this); });
+  CreateService([=]() { return new MagnatuneService(app, this); });
+  CreateService([=]() { return new PodcastService(app, this); });
+  CreateService([=]() { return new RockRadioService(app, this); });
+  CreateService([=]() { return new SavedRadio(app, this); });
+  CreateService([=]() { return new RadioTunesService(app, this); });
+
+  AddDeferredService(IcecastService::kServiceName,
+                     IconLoader::Load("icon_radio", IconLoader::Lastfm),
+                     QStringList(), true,
+                     [=]() { return new IcecastService(app, this); });
+  AddDeferredService(JamendoService::kServiceName,
+                     IconLoader::Load("jamendo", IconLoader::Provider),
+                     QStringList(), true,
+                     [=]() { return new JamendoService(app, this); });
+  AddDeferredService(SomaFMService::kServiceName,
+                     IconLoader::Load("somafm", IconLoader::Provider),
+                     QStringList() << "somafm", true,
+                     [=]() { return new SomaFMService(app, this); });
+  AddDeferredService(IntergalacticFMService::kServiceName,
+                     IconLoader::Load("intergalacticfm", IconLoader::Provider),
+                     QStringList() << "intergalacticfm", true,
+                     [=]() { return new IntergalacticFMService(app, this); });
+  AddDeferredService(RadioBrowserService::kServiceName,
+                     IconLoader::Load("radiobrowser", IconLoader::Provider),
+                     QStringList() << RadioBrowserService::kSchemeName, true,
+                     [=]() { return new RadioBrowserService(app, this); });
+  AddDeferredService(SubsonicService::kServiceName,
+                     IconLoader::Load("subsonic", IconLoader::Provider),
+                     QStringList() << "subsonic", true,
+                     [=]() { return new SubsonicService(app, this); });
 #ifdef HAVE_BOX
-  AddService(new BoxService(app, this));
+  AddDeferredService(BoxService::kServiceName,
+                     IconLoader::Load("box", IconLoader::Provider),
+                     QStringList() << "box", true,
+                     [=]() { return new BoxService(app, this); });
 #endif
 #ifdef HAVE_DROPBOX
-  AddService(new DropboxService(app, this));
+  AddDeferredService(DropboxService::kServiceName,
+                     IconLoader::Load("dropbox", IconLoader::Provider),
+                     QStringList() << "dropbox", true,
+                     [=]() { return new DropboxService(app, this); });
 #endif
 #ifdef HAVE_GOOGLE_DRIVE
-  AddService(new GoogleDriveService(app, this));
+  AddDeferredService(GoogleDriveService::kServiceName,
+                     IconLoader::Load("googledrive", IconLoader::Provider),
+                     QStringList() << "googledrive", true,
+                     [=]() { return new GoogleDriveService(app, this); });
 #endif
 #ifdef HAVE_SEAFILE
-  AddService(new SeafileService(app, this));
+  AddDeferredService(SeafileService::kServiceName,
+                     IconLoader::Load("seafile", IconLoader::Provider),
+                     QStringList() << "seafile", true,
+                     [=]() { return new SeafileService(app, this); });
 #endif
 #ifdef HAVE_SKYDRIVE
-  AddService(new SkydriveService(app, this));
+  AddDeferredService(SkydriveService::kServiceName,
+                     IconLoader::Load("skydrive", IconLoader::Provider),
+                     QStringList() << "onedrive", true,
+                     [=]() { return new SkydriveService(app, this); });
 #endif
 
   invisibleRootItem()->sortChildren(0, Qt::AscendingOrder);
   UpdateServices();
 }
 
+InternetModel::~InternetModel() {
+  if (sInstance == this) sInstance = nullptr;
+}
+
+InternetService* InternetModel::CreateService(const ServiceFactory& factory) {
+  trace::Scope scope("InternetModel::CreateService");
+  QElapsedTimer timer;
+  timer.start();
+  InternetService* service = factory();
+  const qint64 msec = timer.elapsed();
+  scope.set_name("Create " + service->name());
+
+  qLog(Debug) << "Creating internet service" << service->name() << "took"
+              << msec << "ms";
+  construction_msec_[service->name()] = msec;
+
+  AddService(service);
+  return service;
+}
+
+void InternetModel::AddDeferredService(const QString& name, const QIcon& icon,
+                                       const QStringList& url_schemes,
+                                       bool searchable,
+                                       const ServiceFactory& factory) {
+  DeferredService deferred;
+  deferred.item_ = new QStandardItem(icon, name);
+  deferred.item_->setData(Type_Service, Role_Type);
+  deferred.item_->setData(true, Role_CanLazyLoad);
+  deferred.shown_ = true;
+  deferred.searchable_ = searchable;
+  deferred.factory_ = factory;
+
+  for (const QString& scheme : url_schemes) {
+    UrlHandler* handler =
+        new DeferredUrlHandler(scheme, icon, name, app_->player(), this);
+    app_->player()->RegisterUrlHandler(handler);
+    deferred.url_handlers_ << handler;
+  }
+
+  invisibleRootItem()->appendRow(deferred.item_);
+  deferred_services_.insert(name, deferred);
+}
+
+InternetService* InternetModel::CreateDeferredService(const QString& name) {
+  TRACE_SCOPE("Create " + name);
+
+  // Taken out first in case the service asks for itself while it's created.
+  DeferredService deferred = deferred_services_.take(name);
+
+  // The service registers its own URL handlers, and we might be in the
+  // middle of one of these.
+  for (UrlHandler* handler : deferred.url_handlers_) {
+    app_->player()->UnregisterUrlHandler(handler);
+    handler->deleteLater();
+  }
+
+  if (deferred.shown_) {
+    invisibleRootItem()->removeRow(deferred.item_->row());
+  } else {
+    delete deferred.item_;
+  }
+
+  InternetService* service = CreateService(deferred.factory_);
+  if (!shown_services_.contains(service)) return service;
+
+  // AddService put the root item at the end, move it to where ours was.
+  ServiceItem& service_item = shown_services_[service];
+  invisibleRootItem()->takeRow(service_item.item->row());
+  if (deferred.shown_) {
+    invisibleRootItem()->insertRow(FindItemPosition(service_item.item->text()),
+                                   service_item.item);
+  } else {
+    service_item.shown = false;
+  }
+
+  return service;
+}
+
+void InternetModel::DeferredServiceExpanded(const QString& name) {
+  if (!deferred_services_.contains(name)) return;
+
+  InternetService* service = CreateDeferredService(name);
+  if (!shown_services_.contains(service) || !shown_services_[service].shown) {
+    return;
+  }
+
+  // The view saw an empty item, so expand the real one.
+  const QModelIndex index = indexFromItem(shown_services_[service].item);
+  emit ScrollToIndex(merged_model_->mapFromSource(index));
+}
+
+void InternetModel::CreateSearchableServices() {
+  for (const QString& name : deferred_services_.keys()) {
+    if (deferred_services_[name].searchable_) CreateDeferredService(name);
+  }
+}
+
+QMap<QString, InternetModel::ServiceItem> InternetModel::deferred_services()
+    const {
+  QMap<QString, ServiceItem> ret;
+  for (auto it = deferred_services_.constBegin();
+       it != deferred_services_.constEnd(); ++it) {
+    ServiceItem service_item;
+    service_item.item = it.value().item_;
+    service_item.shown = it.value().shown_;
+    ret.insert(it.key(), service_item);
+  }
+  return ret;
+}
+
+void InternetModel::SetDeferredServiceShown(DeferredService* deferred,
+                                            bool shown) {
+  if (deferred->shown_ == shown) return;
+
+  if (shown) {
+    invisibleRootItem()->insertRow(FindItemPosition(deferred->item_->text()),
+                                   deferred->item_);
+  } else {
+    // Don't delete the item, it's put back if the service is shown again
+    invisibleRootItem()->takeRow(deferred->item_->row());
+  }
+  deferred->shown_ = shown;
+}
+
 void InternetModel::AddService(InternetService* service) {
   QStandardItem* root = service->CreateRootItem();
   if (!root) {
@@ -183,6 +395,9 @@ void InternetModel::ServiceDeleted() {
 
 InternetService* InternetModel::ServiceByName(const QString& name) {
   if (sServices->contains(name)) return sServices->value(name);
+  if (sInstance && sInstance->deferred_services_.contains(name)) {
+    return sInstance->CreateDeferredService(name);
+  }
   return nullptr;
 }
 
@@ -226,6 +441,13 @@ int InternetModel::rowCount(const QModelIndex& parent) const {
     if (service) {
       item->setData(false, Role_CanLazyLoad);
       service->LazyPopulate(item);
+    } else if (parent.data(Role_Type).toInt() == Type_Service) {
+      // A deferred service's root item.  Creating the service replaces the
+      // item, which can't be done while the view is asking about it.
+      item->setData(false, Role_CanLazyLoad);
+      QMetaObject::invokeMethod(const_cast<InternetModel*>(this),
+                                "DeferredServiceExpanded", Qt::QueuedConnection,
+                                Q_ARG(QString, item->text()));
     }
   }
 
@@ -376,11 +598,18 @@ void InternetModel::UpdateServices() {
   QStringList keys = s.childKeys();
 
   for (const QString& service_name : keys) {
+    bool setting_val = s.value(service_name).toBool();
+
+    // Showing or hiding a service doesn't need it to be created.
+    if (deferred_services_.contains(service_name)) {
+      SetDeferredServiceShown(&deferred_services_[service_name], setting_val);
+      continue;
+    }
+
     InternetService* internet_service = ServiceByName(service_name);
     if (internet_service == nullptr) {
       continue;
     }
-    bool setting_val = s.value(service_name).toBool();
 
     // Only update if values are different
     if (setting_val && !shown_services_[internet_service].shown) {
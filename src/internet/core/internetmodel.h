@@ -23,6 +23,8 @@
 #ifndef INTERNET_CORE_INTERNETMODEL_H_
 #define INTERNET_CORE_INTERNETMODEL_H_
 
+#include <functional>
+
 #include "core/song.h"
 #include "library/librarymodel.h"
 #include "playlist/playlistitem.h"
@@ -38,6 +40,7 @@ class PlayerInterface;
 class InternetService;
 class SettingsDialog;
 class TaskManager;
+class UrlHandler;
 
 #ifdef HAVE_LIBLASTFM
 class LastFMService;
@@ -48,6 +51,7 @@ class InternetModel : public QStandardItemModel {
 
  public:
   explicit InternetModel(Application* app, QObject* parent = nullptr);
+  ~InternetModel();
 
   enum Role {
     // Services can use this role to distinguish between different types of
@@ -120,7 +124,10 @@ class InternetModel : public QStandardItemModel {
     bool shown;
   };
 
-  // Needs to be static for InternetPlaylistItem::restore
+  typedef std::function<InternetService*()> ServiceFactory;
+
+  // Needs to be static for InternetPlaylistItem::restore.  Creates the
+  // service if it was deferred.
   static InternetService* ServiceByName(const QString& name);
   static const char* kSettingsGroup;
 
@@ -134,6 +141,13 @@ class InternetModel : public QStandardItemModel {
   // removed from the model.
   void AddService(InternetService* service);
   void RemoveService(InternetService* service);
+  // Adds a service without creating it.  A root item with its name and icon
+  // stands in for it until it's needed: when the item is expanded, when
+  // something asks for the service by name, when a URL with one of
+  // url_schemes is loaded or, if it's searchable, when a global search starts.
+  void AddDeferredService(const QString& name, const QIcon& icon,
+                          const QStringList& url_schemes, bool searchable,
+                          const ServiceFactory& factory);
   void HideService(InternetService* service);
   void ShowService(InternetService* service);
   // Add or remove the services according to the setting file
@@ -172,6 +186,13 @@ class InternetModel : public QStandardItemModel {
   const QMap<InternetService*, ServiceItem> shown_services() const {
     return shown_services_;
   }
+  // The root items of the services that haven't been created yet, by name.
+  QMap<QString, ServiceItem> deferred_services() const;
+
+  // How long each service that's been created took to construct, in msec.
+  const QMap<QString, qint64>& construction_msec() const {
+    return construction_msec_;
+  }
 
  signals:
   void StreamError(const QString& message);
@@ -183,16 +204,34 @@ class InternetModel : public QStandardItemModel {
  private slots:
   void ServiceDeleted();
   void RowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+  void DeferredServiceExpanded(const QString& name);
+  void CreateSearchableServices();
 
  private:
+  struct DeferredService {
+    QStandardItem* item_;
+    bool shown_;
+    bool searchable_;
+    ServiceFactory factory_;
+    QList<UrlHandler*> url_handlers_;
+  };
+
+  // Creates a service, timing how long it takes, and adds it.
+  InternetService* CreateService(const ServiceFactory& factory);
+  InternetService* CreateDeferredService(const QString& name);
+  void SetDeferredServiceShown(DeferredService* deferred, bool shown);
+
   // Index is about to be removed from the merged model
   void IndexAboutToBeRemoved(const QModelIndex& index);
   // Determine if d or one of its ancestors is equal to a.
   bool IsInLineage(QModelIndex d, const QModelIndex& a);
 
   QMap<InternetService*, ServiceItem> shown_services_;
+  QMap<QString, DeferredService> deferred_services_;
+  QMap<QString, qint64> construction_msec_;
 
   static QMap<QString, InternetService*>* sServices;
+  static InternetModel* sInstance;
 
   Application* app_;
   MergedProxyModel* merged_model_;
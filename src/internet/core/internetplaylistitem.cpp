@@ -56,7 +56,7 @@ bool InternetPlaylistItem::InitFromQuery(const SqlRow& query) {
   const int row =
       (Song::kColumns.count() + 1) * PlaylistBackend::kSongTableJoins;
 
-  service_name_ = query.value(row + 1).toString();
+  service_name_ = query.toString(row + 1);
 
   metadata_.InitFromQuery(query, false, (Song::kColumns.count() + 1) * 3);
   InitMetadata();
@@ -44,6 +44,7 @@ class InternetPlaylistItem : public PlaylistItem {
 
   Song Metadata() const;
   QUrl Url() const;
+  void InternStrings() { metadata_.InternStrings(); }
 
  protected:
   QVariant DatabaseValue(DatabaseColumn) const;
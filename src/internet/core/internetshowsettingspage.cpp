@@ -37,13 +37,23 @@ InternetShowSettingsPage::InternetShowSettingsPage(SettingsDialog* parent)
 }
 
 void InternetShowSettingsPage::Load() {
+  InternetModel* model = dialog()->app()->internet_model();
+
+  // Services that haven't been created yet are listed by name, so opening
+  // this page doesn't create them.
+  QMap<QString, InternetModel::ServiceItem> services =
+      model->deferred_services();
   QMap<InternetService*, InternetModel::ServiceItem> shown_services =
-      dialog()->app()->internet_model()->shown_services();
+      model->shown_services();
+  for (auto service_it = shown_services.constBegin();
+       service_it != shown_services.constEnd(); service_it++) {
+    services.insert(service_it.key()->name(), service_it.value());
+  }
 
   ui_->sources->clear();
 
-  for (auto service_it = shown_services.constBegin();
-       service_it != shown_services.constEnd(); service_it++) {
+  for (auto service_it = services.constBegin();
+       service_it != services.constEnd(); service_it++) {
     QTreeWidgetItem* item = new QTreeWidgetItem;
 
     // Get the same text and the same icon as the service tree
@@ -54,7 +64,7 @@ void InternetShowSettingsPage::Load() {
         service_it.value().shown ? Qt::Checked : Qt::Unchecked;
     item->setData(0, Qt::CheckStateRole, check_state);
     /* We have to store the constant name of the service */
-    item->setData(1, Qt::UserRole, service_it.key()->name());
+    item->setData(1, Qt::UserRole, service_it.key());
 
     ui_->sources->invisibleRootItem()->addChild(item);
   }
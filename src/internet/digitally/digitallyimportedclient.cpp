@@ -112,10 +112,12 @@ DigitallyImportedClient::AuthReply DigitallyImportedClient::ParseAuthReply(
   return ret;
 }
 
-QNetworkReply* DigitallyImportedClient::GetChannelList() {
+QNetworkReply* DigitallyImportedClient::GetChannelList(
+    const CachedList<Channel>& cached) {
   // QNetworkRequest req(QUrl(QString(kChannelListUrl)));
   QNetworkRequest req(QUrl(QString(kChannelListUrl).arg(service_name_)));
   SetAuthorisationHeader(&req);
+  cached.PrepareRequest(&req);
 
   return network_->get(req);
 }
@@ -25,6 +25,8 @@
 #include <QSettings>
 #include <QUrl>
 
+#include "core/cachedlist.h"
+
 class QNetworkAccessManager;
 class QNetworkReply;
 class QNetworkRequest;
@@ -69,7 +71,8 @@ class DigitallyImportedClient : public QObject {
   QNetworkReply* Auth(const QString& username, const QString& password);
   AuthReply ParseAuthReply(QNetworkReply* reply) const;
 
-  QNetworkReply* GetChannelList();
+  // Only fetches the list again if it's changed since cached was fetched.
+  QNetworkReply* GetChannelList(const CachedList<Channel>& cached);
   ChannelList ParseChannelList(QNetworkReply* reply) const;
 
  private:
@@ -59,6 +59,7 @@ DigitallyImportedServiceBase::DigitallyImportedServiceBase(
       root_(nullptr),
       saved_channels_(kSettingsGroup, api_service_name,
                       kStreamsCacheDurationSecs),
+      refreshing_(false),
       api_client_(new DigitallyImportedClient(api_service_name, this)) {
   ReloadSettings();
 
@@ -88,19 +89,20 @@ void DigitallyImportedServiceBase::LazyPopulate(QStandardItem* parent) {
 }
 
 void DigitallyImportedServiceBase::RefreshStreams() {
-  if (IsChannelListStale()) {
-    ForceRefreshStreams();
-    return;
-  }
-
+  // Show what we had last time straight away, even if it's old, and replace
+  // it when the new list comes in.
   PopulateStreams();
+  if (IsChannelListStale()) ForceRefreshStreams();
 }
 
 void DigitallyImportedServiceBase::ForceRefreshStreams() {
+  if (refreshing_) return;
+  refreshing_ = true;
+
   // Start a task to tell the user we're busy
   int task_id = app_->task_manager()->StartTask(tr("Getting streams"));
 
-  QNetworkReply* reply = api_client_->GetChannelList();
+  QNetworkReply* reply = api_client_->GetChannelList(saved_channels_);
   NewClosure(reply, SIGNAL(finished()), this,
              SLOT(RefreshStreamsFinished(QNetworkReply*, int)), reply, task_id);
 }
@@ -109,13 +111,21 @@ void DigitallyImportedServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
                                                           int task_id) {
   app_->task_manager()->SetTaskFinished(task_id);
   reply->deleteLater();
+  refreshing_ = false;
+
+  // Keep the old list rather than emptying it if we couldn't get a new one.
+  if (reply->error() != QNetworkReply::NoError) {
+    qLog(Error) << reply->errorString();
+    return;
+  }
+  if (saved_channels_.NotModified(reply)) return;
 
   // Parse the list and sort by name
   DigitallyImportedClient::ChannelList channels =
       api_client_->ParseChannelList(reply);
   std::sort(channels.begin(), channels.end());
 
-  saved_channels_.Update(channels);
+  saved_channels_.Update(channels, reply);
 
   // Only update the item's children if it's already been populated
   if (!root_->data(InternetModel::Role_CanLazyLoad).toBool()) PopulateStreams();
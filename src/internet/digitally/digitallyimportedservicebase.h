@@ -106,6 +106,7 @@ class DigitallyImportedServiceBase : public InternetService {
   QStandardItem* context_item_;
 
   CachedList<DigitallyImportedClient::Channel> saved_channels_;
+  bool refreshing_;
 
   DigitallyImportedClient* api_client_;
 };
@@ -54,6 +54,9 @@ static const char* kListFolderContinueEndpoint =
 static const char* kLongPollEndpoint =
     "https://notify.dropboxapi.com/2/files/list_folder/longpoll";
 
+// The most entries list_folder gives back at a time.
+static const int kListFolderLimit = 2000;
+
 }  // namespace
 
 DropboxService::DropboxService(Application* app, InternetModel* parent)
@@ -65,6 +68,7 @@ DropboxService::DropboxService(Application* app, InternetModel* parent)
   settings.beginGroup(kSettingsGroup);
   // OAuth2 version of dropbox auth token.
   access_token_ = settings.value("access_token2").toString();
+  cursor_ = settings.value("cursor").toString();
   app->player()->RegisterUrlHandler(new DropboxUrlHandler(this, this));
 }
 
@@ -99,18 +103,14 @@ QByteArray DropboxService::GenerateAuthorisationHeader() {
 }
 
 void DropboxService::RequestFileList() {
-  QSettings s;
-  s.beginGroup(kSettingsGroup);
-
-  QString cursor = s.value("cursor", "").toString();
-
-  if (cursor.isEmpty()) {
+  if (cursor_.isEmpty()) {
     QUrl url = QUrl(QString(kListFolderEndpoint));
 
     QJsonObject json;
     json.insert("path", "");
     json.insert("recursive", true);
     json.insert("include_deleted", true);
+    json.insert("limit", kListFolderLimit);
 
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", GenerateAuthorisationHeader());
@@ -123,7 +123,7 @@ void DropboxService::RequestFileList() {
   } else {
     QUrl url = QUrl(kListFolderContinueEndpoint);
     QJsonObject json;
-    json.insert("cursor", cursor);
+    json.insert("cursor", cursor_);
     QJsonDocument document(json);
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", GenerateAuthorisationHeader());
@@ -147,9 +147,12 @@ void DropboxService::RequestFileListFinished(QNetworkReply* reply) {
     library_backend_->DeleteAll();
   }
 
-  QSettings settings;
-  settings.beginGroup(kSettingsGroup);
-  settings.setValue("cursor", json_response["cursor"].toString());
+  // Ask for the next page now so it downloads while this one is handled.
+  const bool has_more = json_response["has_more"].toBool();
+  cursor_ = json_response["cursor"].toString();
+  if (has_more) {
+    RequestFileList();
+  }
 
   QJsonArray contents = json_response["entries"].toArray();
   qLog(Debug) << "File list found:" << contents.size();
@@ -175,6 +178,7 @@ void DropboxService::RequestFileListFinished(QNetworkReply* reply) {
     }
 
     if (ShouldIndexFile(url, GuessMimeTypeForFile(url.toString()))) {
+      BeginIndexingRequest();
       QNetworkReply* reply = FetchContentUrl(url);
       connect(reply, &QNetworkReply::finished, [=] {
         this->FetchContentUrlFinished(reply, item.toVariantMap());
@@ -182,13 +186,9 @@ void DropboxService::RequestFileListFinished(QNetworkReply* reply) {
     }
   }
 
-  if (json_response.contains("has_more") &&
-      json_response["has_more"].toBool()) {
-    QSettings s;
-    s.beginGroup(kSettingsGroup);
-    s.setValue("cursor", json_response["cursor"].toVariant());
-    RequestFileList();
-  } else {
+  SaveCursorWhenIndexed(kSettingsGroup, cursor_);
+
+  if (!has_more) {
     // Long-poll wait for changes.
     LongPollDelta();
   }
@@ -199,12 +199,10 @@ void DropboxService::LongPollDelta() {
     // Might have been signed out by the user.
     return;
   }
-  QSettings s;
-  s.beginGroup(kSettingsGroup);
 
   QUrl request_url = QUrl(QString(kLongPollEndpoint));
   QJsonObject json;
-  json.insert("cursor", s.value("cursor").toString());
+  json.insert("cursor", cursor_);
   json.insert("timeout", 30);
   QNetworkRequest request(request_url);
   request.setRawHeader("Content-Type", "application/json; charset=utf-8");
@@ -250,7 +248,10 @@ void DropboxService::FetchContentUrlFinished(QNetworkReply* reply,
   reply->deleteLater();
 
   QJsonDocument document = ParseJsonReply(reply);
-  if (document.isNull()) return;
+  if (document.isNull()) {
+    EndIndexingRequest();
+    return;
+  }
 
   QJsonObject json_response = document.object();
   QFileInfo info(data["path_lower"].toString());
@@ -273,6 +274,7 @@ void DropboxService::FetchContentUrlFinished(QNetworkReply* reply,
       song, GuessMimeTypeForFile(url.toString()),
       QUrl::fromEncoded(json_response["link"].toVariant().toByteArray()),
       QString());
+  EndIndexingRequest();
 }
 
 QUrl DropboxService::GetStreamingUrlFromSongId(const QUrl& url) {
@@ -59,6 +59,9 @@ class DropboxService : public CloudFileService {
 
  private:
   QString access_token_;
+  // The latest cursor we've seen, which is only saved in the settings once
+  // the files before it have been indexed.
+  QString cursor_;
 
   NetworkAccessManager* network_;
 };
@@ -40,6 +40,14 @@ static const char* kGoogleDriveFile =
     "https://www.googleapis.com/drive/v2/files/%1";
 static const char* kGoogleDriveChanges =
     "https://www.googleapis.com/drive/v2/changes";
+// The most the changes list gives back at a time.
+static const int kChangesPageSize = 1000;
+// Only what File is asked for while indexing, the full metadata of each file
+// is most of the response otherwise.
+static const char* kChangesFields =
+    "largestChangeId,nextPageToken,items(fileId,deleted,file(id,etag,title,"
+    "mimeType,description,fileSize,downloadUrl,modifiedDate,createdDate,"
+    "labels/trashed))";
 static const char* kGoogleOAuthUserInfoEndpoint =
     "https://www.googleapis.com/oauth2/v1/userinfo";
 
@@ -191,6 +199,8 @@ void Client::MakeListChangesRequest(ListChangesResponse* response,
   if (!page_token.isEmpty()) {
     url_query.addQueryItem("pageToken", page_token);
   }
+  url_query.addQueryItem("maxResults", QString::number(kChangesPageSize));
+  url_query.addQueryItem("fields", kChangesFields);
 
   url.setQuery(url_query);
 
@@ -224,6 +234,12 @@ void Client::ListChangesFinished(ListChangesResponse* response,
     response->next_cursor_ = json_result["largestChangeId"].toString();
   }
 
+  // Ask for the next page now so it downloads while this one is handled.
+  const bool has_next_page = json_result.contains("nextPageToken");
+  if (has_next_page) {
+    MakeListChangesRequest(response, json_result["nextPageToken"].toString());
+  }
+
   // Emit the FilesFound signal for the files in the response.
   FileList files;
   QList<QUrl> files_deleted;
@@ -243,10 +259,7 @@ void Client::ListChangesFinished(ListChangesResponse* response,
   emit response->FilesFound(files);
   emit response->FilesDeleted(files_deleted);
 
-  // Get the next page of results if there is one.
-  if (json_result.contains("nextPageToken")) {
-    MakeListChangesRequest(response, json_result["nextPageToken"].toString());
-  } else {
+  if (!has_next_page) {
     emit response->Finished();
   }
 }
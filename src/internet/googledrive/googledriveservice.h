@@ -58,7 +58,6 @@ class GoogleDriveService : public CloudFileService {
   void FilesFound(const QList<google_drive::File>& files);
   void FilesDeleted(const QList<QUrl>& files);
   void ListChangesFinished(google_drive::ListChangesResponse* response);
-  void SaveCursor(const QString& cursor);
 
   void OpenWithDrive();
   void DoFullRescan() override;
@@ -22,12 +22,15 @@
 #include "icecastbackend.h"
 
 #include <QSqlQuery>
+#include <QStringList>
 #include <QVariant>
 
 #include "core/database.h"
 #include "core/scopedtransaction.h"
 
 const char* IcecastBackend::kTableName = "icecast_stations";
+const char* IcecastBackend::kFtsTableName = "icecast_stations_fts";
+const int IcecastBackend::kMinGenreStations = 3;
 
 IcecastBackend::IcecastBackend(QObject* parent) : QObject(parent) {}
 
@@ -38,15 +41,21 @@ QStringList IcecastBackend::GetGenresAlphabetical(const QString& filter) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db = db_->Connect();
 
-  QString where = filter.isEmpty() ? "" : "WHERE name LIKE :filter";
+  const QString match = FtsQuery(filter);
+  QString where = match.isEmpty()
+                      ? ""
+                      : QString(
+                            "WHERE ROWID IN (SELECT ROWID FROM %1"
+                            " WHERE %1 MATCH :filter)")
+                            .arg(kFtsTableName);
 
   QString sql = QString("SELECT DISTINCT genre FROM %1 %2 ORDER BY genre")
                     .arg(kTableName, where);
 
   QSqlQuery q(db);
   q.prepare(sql);
-  if (!filter.isEmpty()) {
-    q.bindValue(":filter", QString("%" + filter + "%"));
+  if (!match.isEmpty()) {
+    q.bindValue(":filter", match);
   }
 
   q.exec();
@@ -63,7 +72,13 @@ QStringList IcecastBackend::GetGenresByPopularity(const QString& filter) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db = db_->Connect();
 
-  QString where = filter.isEmpty() ? "" : "WHERE name LIKE :filter";
+  const QString match = FtsQuery(filter);
+  QString where = match.isEmpty()
+                      ? ""
+                      : QString(
+                            "WHERE ROWID IN (SELECT ROWID FROM %1"
+                            " WHERE %1 MATCH :filter)")
+                            .arg(kFtsTableName);
 
   QString sql = QString(
                     "SELECT genre, COUNT(*) AS count FROM %1 "
@@ -73,8 +88,8 @@ QStringList IcecastBackend::GetGenresByPopularity(const QString& filter) {
                     .arg(kTableName, where);
   QSqlQuery q(db);
   q.prepare(sql);
-  if (!filter.isEmpty()) {
-    q.bindValue(":filter", QString("%" + filter + "%"));
+  if (!match.isEmpty()) {
+    q.bindValue(":filter", match);
   }
 
   q.exec();
@@ -99,9 +114,13 @@ IcecastBackend::StationList IcecastBackend::GetStations(const QString& filter,
     where_clauses << "genre = :genre";
     bound_items << genre;
   }
-  if (!filter.isEmpty()) {
-    where_clauses << "name LIKE :filter";
-    bound_items << "%" + filter + "%";
+  const QString match = FtsQuery(filter);
+  if (!match.isEmpty()) {
+    where_clauses << QString(
+                         "ROWID IN (SELECT ROWID FROM %1"
+                         " WHERE %1 MATCH :filter)")
+                         .arg(kFtsTableName);
+    bound_items << match;
   }
 
   QString sql = QString(
@@ -136,6 +155,21 @@ IcecastBackend::StationList IcecastBackend::GetStations(const QString& filter,
   return ret;
 }
 
+QString IcecastBackend::FtsQuery(const QString& filter) {
+  // Like LibraryQuery, match every word as a prefix and drop anything else
+  // since the tokenizer splits on it anyway.
+  QString clean(filter);
+  for (QChar& c : clean) {
+    if (!c.isLetterOrNumber() && c != '_') c = ' ';
+  }
+
+  QStringList terms;
+  for (const QString& word : clean.split(' ', QString::SkipEmptyParts)) {
+    terms << word + "*";
+  }
+  return terms.join(" ");
+}
+
 bool IcecastBackend::IsEmpty() {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db = db_->Connect();
@@ -145,34 +179,80 @@ bool IcecastBackend::IsEmpty() {
   return !q.next();
 }
 
-void IcecastBackend::ClearAndAddStations(const StationList& stations) {
+void IcecastBackend::BeginAddStations() {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db = db_->Connect();
+
+  // A temporary table belongs to this thread's connection, which is why the
+  // steps have to stay on one thread.  It's left over if an earlier update on
+  // the same thread stopped part way through.
+  QSqlQuery q(db);
+  q.exec(QString("DROP TABLE IF EXISTS temp.%1_new").arg(kTableName));
+  if (db_->CheckErrors(q)) return;
+
+  q.exec(QString("CREATE TEMP TABLE %1_new ("
+                 "  name TEXT, url TEXT, mime_type TEXT, bitrate INTEGER,"
+                 "  channels INTEGER, samplerate INTEGER, genre TEXT)")
+             .arg(kTableName));
+  db_->CheckErrors(q);
+}
+
+void IcecastBackend::AddStations(const StationList& stations) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db = db_->Connect();
+  ScopedTransaction t(&db);
+
+  QSqlQuery q(db);
+  q.prepare(QString("INSERT INTO temp.%1_new (name, url, mime_type, bitrate,"
+                    "                         channels, samplerate, genre)"
+                    " VALUES (:name, :url, :mime_type, :bitrate,"
+                    "         :channels, :samplerate, :genre)")
+                .arg(kTableName));
+
+  for (const Station& station : stations) {
+    q.bindValue(":name", station.name);
+    q.bindValue(":url", station.url);
+    q.bindValue(":mime_type", station.mime_type);
+    q.bindValue(":bitrate", station.bitrate);
+    q.bindValue(":channels", station.channels);
+    q.bindValue(":samplerate", station.samplerate);
+    q.bindValue(":genre", station.genre);
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+
+  t.Commit();
+}
+
+void IcecastBackend::FinishAddStations() {
   {
     QMutexLocker l(db_->Mutex());
     QSqlDatabase db = db_->Connect();
     ScopedTransaction t(&db);
 
-    // Remove all existing items
-    QSqlQuery q(db);
-    q.prepare(QString("DELETE FROM %1").arg(kTableName));
-    q.exec();
-    if (db_->CheckErrors(q)) return;
+    const QStringList commands =
+        QStringList()
+        << "DELETE FROM %1"
+        << "DELETE FROM %2"
+        // Keep the first of each name.  Duplicates tend to be multiple URLs
+        // for the same station.  Inserting them in name order means the
+        // stations come back sorted without an ORDER BY.
+        << "INSERT INTO %1 (name, url, mime_type, bitrate, channels,"
+           "                samplerate, genre)"
+           " SELECT name, url, mime_type, bitrate, channels, samplerate, genre"
+           " FROM temp.%1_new"
+           " WHERE ROWID IN (SELECT MIN(ROWID) FROM temp.%1_new GROUP BY name)"
+           " ORDER BY name COLLATE NOCASE"
+        << "UPDATE %1 SET genre = 'Other' WHERE genre IN ("
+           "  SELECT genre FROM %1 GROUP BY genre HAVING COUNT(*) < %3)"
+        << "INSERT INTO %2 (ROWID, ftsname, ftsgenre)"
+           " SELECT ROWID, name, genre FROM %1"
+        << "DROP TABLE temp.%1_new";
 
-    q.prepare(QString("INSERT INTO %1 (name, url, mime_type, bitrate,"
-                      "                channels, samplerate, genre)"
-                      " VALUES (:name, :url, :mime_type, :bitrate,"
-                      "         :channels, :samplerate, :genre)")
-                  .arg(kTableName));
-
-    // Add these ones
-    for (const Station& station : stations) {
-      q.bindValue(":name", station.name);
-      q.bindValue(":url", station.url);
-      q.bindValue(":mime_type", station.mime_type);
-      q.bindValue(":bitrate", station.bitrate);
-      q.bindValue(":channels", station.channels);
-      q.bindValue(":samplerate", station.samplerate);
-      q.bindValue(":genre", station.genre);
-      q.exec();
+    QSqlQuery q(db);
+    for (const QString& command : commands) {
+      q.exec(command.arg(kTableName, kFtsTableName,
+                         QString::number(kMinGenreStations)));
       if (db_->CheckErrors(q)) return;
     }
 
@@ -35,6 +35,7 @@ class IcecastBackend : public QObject {
   void Init(Database* db);
 
   static const char* kTableName;
+  static const char* kFtsTableName;
 
   struct Station {
     Station() : bitrate(0), channels(0), samplerate(0) {}
@@ -56,7 +57,18 @@ class IcecastBackend : public QObject {
   StationList GetStations(const QString& filter = QString(),
                           const QString& genre = QString());
 
-  void ClearAndAddStations(const StationList& stations);
+  // Replacing the whole directory happens in steps so it can be read a batch
+  // at a time: BeginAddStations(), AddStations() for each batch, then
+  // FinishAddStations().  The new stations are kept aside until the last step
+  // swaps them in, so the old ones stay browsable meanwhile.  Every step must
+  // be called from the same thread.
+  void BeginAddStations();
+  void AddStations(const StationList& stations);
+  // Drops duplicate names, folds genres with less than kMinGenreStations
+  // into "Other" and emits DatabaseReset().
+  void FinishAddStations();
+
+  static const int kMinGenreStations;
 
   bool IsEmpty();
 
@@ -64,6 +76,9 @@ class IcecastBackend : public QObject {
   void DatabaseReset();
 
  private:
+  // Turns filter text into a MATCH expression for kFtsTableName.
+  static QString FtsQuery(const QString& filter);
+
   Database* db_;
 };
 
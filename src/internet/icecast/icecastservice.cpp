@@ -23,15 +23,14 @@
 
 #include <QDesktopServices>
 #include <QMenu>
-#include <QMultiHash>
 #include <QNetworkReply>
 #include <QRegExp>
 #include <QtConcurrentRun>
-#include <algorithm>
 
 #include "core/application.h"
 #include "core/closure.h"
 #include "core/database.h"
+#include "core/logging.h"
 #include "core/mergedproxymodel.h"
 #include "core/network.h"
 #include "core/taskmanager.h"
@@ -44,13 +43,11 @@
 #include "playlist/songplaylistitem.h"
 #include "ui/iconloader.h"
 
-using std::sort;
-using std::unique;
-
 const char* IcecastService::kServiceName = "Icecast";
 const char* IcecastService::kDirectoryUrl =
     "http://data.clementine-player.org/icecast-directory";
 const char* IcecastService::kHomepage = "http://dir.xiph.org/";
+const int IcecastService::kStationBatchSize = 1000;
 
 IcecastService::IcecastService(Application* app, InternetModel* parent)
     : InternetService(kServiceName, app, parent, parent),
@@ -130,47 +127,13 @@ void IcecastService::DownloadDirectoryFinished(QNetworkReply* reply,
     return;
   }
 
-  QFuture<IcecastBackend::StationList> future =
+  QFuture<int> future =
       QtConcurrent::run(this, &IcecastService::ParseDirectory, reply);
-  NewClosure(
-      future, this,
-      SLOT(ParseDirectoryFinished(QFuture<IcecastBackend::StationList>, int)),
-      future, task_id);
+  NewClosure(future, this, SLOT(ParseDirectoryFinished(QFuture<int>, int)),
+             future, task_id);
 }
 
 namespace {
-template <typename T>
-struct GenreSorter {
-  explicit GenreSorter(const QMultiHash<QString, T>& genres)
-      : genres_(genres) {}
-
-  bool operator()(const QString& a, const QString& b) const {
-    return genres_.count(a) > genres_.count(b);
-  }
-
- private:
-  const QMultiHash<QString, T>& genres_;
-};
-
-template <typename T>
-struct StationSorter {
-  bool operator()(const T& a, const T& b) const {
-    return a.name.compare(b.name, Qt::CaseInsensitive) < 0;
-  }
-};
-
-template <typename T>
-struct StationSorter<T*> {
-  bool operator()(const T* a, const T* b) const {
-    return a->name.compare(b->name, Qt::CaseInsensitive) < 0;
-  }
-};
-
-template <typename T>
-struct StationEquality {
-  bool operator()(T a, T b) const { return a.name == b.name; }
-};
-
 QStringList FilterGenres(const QStringList& genres) {
   QStringList ret;
   for (const QString& genre : genres) {
@@ -194,57 +157,47 @@ QStringList FilterGenres(const QStringList& genres) {
 }
 }  // namespace
 
-void IcecastService::ParseDirectoryFinished(
-    QFuture<IcecastBackend::StationList> future, int task_id) {
-  IcecastBackend::StationList all_stations = future.result();
-  sort(all_stations.begin(), all_stations.end(),
-       StationSorter<IcecastBackend::Station>());
-  // Remove duplicates by name. These tend to be multiple URLs for the same
-  // station.
-  IcecastBackend::StationList::iterator it =
-      unique(all_stations.begin(), all_stations.end(),
-             StationEquality<IcecastBackend::Station>());
-  all_stations.erase(it, all_stations.end());
-
-  // Cluster stations by genre.
-  QMultiHash<QString, IcecastBackend::Station*> genres;
-
-  // Add stations.
-  for (int i = 0; i < all_stations.count(); ++i) {
-    IcecastBackend::Station& s = all_stations[i];
-    genres.insert(s.genre, &s);
-  }
-
-  QSet<QString> genre_set = genres.keys().toSet();
-
-  // Merge genres with only 1 or 2 stations into "Other".
-  for (const QString& genre : genre_set) {
-    if (genres.count(genre) < 3) {
-      const QList<IcecastBackend::Station*>& small_genre = genres.values(genre);
-      for (IcecastBackend::Station* s : small_genre) {
-        s->genre = "Other";
-      }
-    }
+void IcecastService::ParseDirectoryFinished(QFuture<int> future,
+                                            int task_id) {
+  if (future.result() == 0) {
+    app_->AddError(tr("Failed to update icecast directory:\n%1")
+                       .arg(tr("No stations were found")));
   }
 
-  backend_->ClearAndAddStations(all_stations);
-
   app_->task_manager()->SetTaskFinished(task_id);
 }
 
-IcecastBackend::StationList IcecastService::ParseDirectory(
-    QIODevice* device) const {
+int IcecastService::ParseDirectory(QIODevice* device) {
   QXmlStreamReader reader(device);
-  IcecastBackend::StationList stations;
+  IcecastBackend::StationList batch;
+  int count = 0;
+
+  backend_->BeginAddStations();
   while (!reader.atEnd()) {
     reader.readNext();
     if (reader.tokenType() == QXmlStreamReader::StartElement &&
         reader.name() == "entry") {
-      stations << ReadStation(&reader);
+      batch << ReadStation(&reader);
+      if (batch.count() >= kStationBatchSize) {
+        backend_->AddStations(batch);
+        count += batch.count();
+        batch.clear();
+      }
     }
   }
+  backend_->AddStations(batch);
+  count += batch.count();
   device->deleteLater();
-  return stations;
+
+  if (reader.hasError()) {
+    qLog(Warning) << "Error parsing icecast directory:" << reader.errorString();
+  }
+
+  // Keep the old directory rather than replacing it with nothing.
+  if (count > 0) {
+    backend_->FinishAddStations();
+  }
+  return count;
 }
 
 IcecastBackend::Station IcecastService::ReadStation(
@@ -45,6 +45,9 @@ class IcecastService : public InternetService {
   static const char* kServiceName;
   static const char* kDirectoryUrl;
   static const char* kHomepage;
+  // Stations are written to the database this many at a time while the
+  // directory is parsed.
+  static const int kStationBatchSize;
 
   enum ItemType {
     Type_Stream = 3000,
@@ -62,13 +65,13 @@ class IcecastService : public InternetService {
   void LoadDirectory();
   void Homepage();
   void DownloadDirectoryFinished(QNetworkReply* reply, int task_id);
-  void ParseDirectoryFinished(QFuture<IcecastBackend::StationList> future,
-                              int task_id);
+  void ParseDirectoryFinished(QFuture<int> future, int task_id);
 
  private:
   void RequestDirectory(const QUrl& url, int task_id);
   void EnsureMenuCreated();
-  IcecastBackend::StationList ParseDirectory(QIODevice* device) const;
+  // Runs in a worker thread, returns the number of stations read.
+  int ParseDirectory(QIODevice* device);
   IcecastBackend::Station ReadStation(QXmlStreamReader* reader) const;
 
   QStandardItem* root_;
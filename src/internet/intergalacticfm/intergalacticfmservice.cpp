@@ -60,6 +60,7 @@ IntergalacticFMServiceBase::IntergalacticFMServiceBase(
       root_(nullptr),
       network_(new NetworkAccessManager(this)),
       streams_(name, "streams", kStreamsCacheDurationSecs),
+      refreshing_(false),
       name_(name),
       channel_list_url_(channel_list_url),
       homepage_url_(homepage_url),
@@ -113,7 +114,12 @@ void IntergalacticFMServiceBase::ShowContextMenu(const QPoint& global_pos) {
 }
 
 void IntergalacticFMServiceBase::ForceRefreshStreams() {
-  QNetworkReply* reply = network_->get(QNetworkRequest(channel_list_url_));
+  if (refreshing_) return;
+  refreshing_ = true;
+
+  QNetworkRequest req(channel_list_url_);
+  streams_.PrepareRequest(&req);
+  QNetworkReply* reply = network_->get(req);
   int task_id = app_->task_manager()->StartTask(tr("Getting channels"));
 
   NewClosure(reply, SIGNAL(finished()), this,
@@ -124,6 +130,7 @@ void IntergalacticFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
                                                         int task_id) {
   app_->task_manager()->SetTaskFinished(task_id);
   reply->deleteLater();
+  refreshing_ = false;
 
   if (reply->error() != QNetworkReply::NoError) {
     app_->AddError(
@@ -131,6 +138,9 @@ void IntergalacticFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
     return;
   }
 
+  // The list we already have is still right.
+  if (streams_.NotModified(reply)) return;
+
   StreamList list;
 
   QXmlStreamReader reader(reply);
@@ -143,7 +153,7 @@ void IntergalacticFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
     }
   }
 
-  streams_.Update(list);
+  streams_.Update(list, reply);
   streams_.Sort();
 
   // Only update the item's children if it's already been populated
@@ -229,11 +239,10 @@ IntergalacticFMServiceBase::StreamList IntergalacticFMServiceBase::Streams() {
 }
 
 void IntergalacticFMServiceBase::RefreshStreams() {
-  if (IsStreamListStale()) {
-    ForceRefreshStreams();
-    return;
-  }
+  // Show what we had last time straight away, even if it's old, and replace
+  // it when the new list comes in.
   PopulateStreams();
+  if (IsStreamListStale()) ForceRefreshStreams();
 }
 
 void IntergalacticFMServiceBase::PopulateStreams() {
@@ -269,10 +278,12 @@ void IntergalacticFMServiceBase::ReloadSettings() {
   streams_.Sort();
 }
 
+const char* IntergalacticFMService::kServiceName = "Intergalactic FM";
+
 IntergalacticFMService::IntergalacticFMService(Application* app,
                                                InternetModel* parent)
     : IntergalacticFMServiceBase(
-          app, parent, "Intergalactic FM",
+          app, parent, kServiceName,
           QUrl("https://www.intergalactic.fm/channels.xml"),
           QUrl("https://www.intergalactic.fm"), QUrl(),
           IconLoader::Load("intergalacticfm", IconLoader::Provider)) {}
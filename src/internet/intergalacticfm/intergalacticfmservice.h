@@ -95,6 +95,7 @@ class IntergalacticFMServiceBase : public InternetService {
   QNetworkAccessManager* network_;
 
   CachedList<Stream> streams_;
+  bool refreshing_;
 
   const QString name_;
   const QUrl channel_list_url_;
@@ -106,6 +107,8 @@ class IntergalacticFMServiceBase : public InternetService {
 class IntergalacticFMService : public IntergalacticFMServiceBase {
  public:
   IntergalacticFMService(Application* app, InternetModel* parent);
+
+  static const char* kServiceName;
 };
 
 QDataStream& operator<<(QDataStream& out,
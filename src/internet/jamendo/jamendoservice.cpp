@@ -27,6 +27,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QNetworkReply>
+#include <QSettings>
 #include <QSortFilterProxyModel>
 #include <QXmlStreamReader>
 #include <QtConcurrentRun>
@@ -37,6 +38,7 @@
 #include "core/mergedproxymodel.h"
 #include "core/network.h"
 #include "core/scopedtransaction.h"
+#include "core/streambuffer.h"
 #include "core/taskmanager.h"
 #include "core/timeconstants.h"
 #include "globalsearch/globalsearch.h"
@@ -87,6 +89,10 @@ JamendoService::JamendoService(Application* app, InternetModel* parent)
       library_sort_model_(new QSortFilterProxyModel(this)),
       search_provider_(nullptr),
       load_database_task_id_(0),
+      directory_reply_(nullptr),
+      directory_buffer_(nullptr),
+      directory_gzip_(nullptr),
+      directory_parsed_(false),
       total_song_count_(0),
       accepted_download_(false) {
   library_backend_.reset(new LibraryBackend,
@@ -141,7 +147,10 @@ JamendoService::JamendoService(Application* app, InternetModel* parent)
           SLOT(SearchProviderToggled(const SearchProvider*, bool)));
 }
 
-JamendoService::~JamendoService() {}
+JamendoService::~JamendoService() {
+  // Let ParseDirectory finish rather than leave it waiting for data.
+  if (directory_buffer_) directory_buffer_->Abort();
+}
 
 QStandardItem* JamendoService::CreateRootItem() {
   QStandardItem* item = new QStandardItem(
@@ -173,6 +182,8 @@ void JamendoService::UpdateTotalSongCount(int count) {
 }
 
 void JamendoService::DownloadDirectory() {
+  if (directory_reply_ || directory_buffer_) return;
+
   // don't ask if we're refreshing the database
   if (total_song_count_ == 0) {
     if (QMessageBox::question(nullptr, tr("Jamendo database"),
@@ -188,9 +199,25 @@ void JamendoService::DownloadDirectory() {
   req.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
                    QNetworkRequest::AlwaysNetwork);
 
-  QNetworkReply* reply = network_->get(req);
-  connect(reply, SIGNAL(finished()), SLOT(DownloadDirectoryFinished()));
-  connect(reply, SIGNAL(downloadProgress(qint64, qint64)),
+  // The catalogue is big, don't download it again if it hasn't changed.
+  if (total_song_count_ > 0) {
+    QSettings s;
+    s.beginGroup(kSettingsGroup);
+    const QByteArray etag = s.value("catalogue_etag").toByteArray();
+    const QByteArray last_modified =
+        s.value("catalogue_last_modified").toByteArray();
+    if (!etag.isEmpty()) req.setRawHeader("If-None-Match", etag);
+    if (!last_modified.isEmpty()) {
+      req.setRawHeader("If-Modified-Since", last_modified);
+    }
+  }
+
+  directory_reply_ = network_->get(req);
+  connect(directory_reply_, SIGNAL(readyRead()),
+          SLOT(DownloadDirectoryReadyRead()));
+  connect(directory_reply_, SIGNAL(finished()),
+          SLOT(DownloadDirectoryFinished()));
+  connect(directory_reply_, SIGNAL(downloadProgress(qint64, qint64)),
           SLOT(DownloadDirectoryProgress(qint64, qint64)));
 
   if (!load_database_task_id_) {
@@ -205,31 +232,62 @@ void JamendoService::DownloadDirectoryProgress(qint64 received, qint64 total) {
                                         static_cast<int>(progress * 100), 100);
 }
 
-void JamendoService::DownloadDirectoryFinished() {
-  QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-  Q_ASSERT(reply);
+void JamendoService::DownloadDirectoryReadyRead() {
+  QNetworkReply* reply = directory_reply_;
 
-  app_->task_manager()->SetTaskFinished(load_database_task_id_);
-  load_database_task_id_ = 0;
+  if (!directory_buffer_) {
+    // Anything else, like 304 Not Modified, is dealt with when it finishes.
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() !=
+        200) {
+      return;
+    }
 
-  // TODO(John Maguire): Not leak reply.
-  QtIOCompressor* gzip = new QtIOCompressor(reply);
-  gzip->setStreamFormat(QtIOCompressor::GzipFormat);
-  if (!gzip->open(QIODevice::ReadOnly)) {
-    qLog(Warning) << "Jamendo library not in gzip format";
-    delete gzip;
-    return;
+    // The catalogue is parsed and stored while it's still downloading.
+    directory_buffer_ = new StreamBuffer;
+    directory_gzip_ = new QtIOCompressor(directory_buffer_);
+    directory_gzip_->setStreamFormat(QtIOCompressor::GzipFormat);
+    directory_gzip_->open(QIODevice::ReadOnly);
+    directory_parsed_ = false;
+    directory_etag_ = reply->rawHeader("ETag");
+    directory_last_modified_ = reply->rawHeader("Last-Modified");
+
+    QFuture<void> future = QtConcurrent::run(
+        this, &JamendoService::ParseDirectory, directory_gzip_);
+    NewClosure(future, this, SLOT(ParseDirectoryFinished()));
   }
 
-  load_database_task_id_ =
-      app_->task_manager()->StartTask(tr("Parsing Jamendo catalogue"));
+  directory_buffer_->Append(reply->readAll());
+}
+
+void JamendoService::DownloadDirectoryFinished() {
+  QNetworkReply* reply = directory_reply_;
+  directory_reply_ = nullptr;
+  reply->deleteLater();
+
+  const int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 304) {
+    qLog(Info) << "Jamendo catalogue hasn't changed";
+  } else if (reply->error() != QNetworkReply::NoError) {
+    qLog(Warning) << "Failed to download the Jamendo catalogue:"
+                  << reply->errorString();
+  }
+
+  if (!directory_buffer_) {
+    app_->task_manager()->SetTaskFinished(load_database_task_id_);
+    load_database_task_id_ = 0;
+    return;
+  }
 
-  QFuture<void> future =
-      QtConcurrent::run(this, &JamendoService::ParseDirectory, gzip);
-  NewClosure(future, this, SLOT(ParseDirectoryFinished()));
+  if (reply->error() != QNetworkReply::NoError) {
+    directory_buffer_->Abort();
+  } else {
+    directory_buffer_->Append(reply->readAll());
+    directory_buffer_->Finish();
+  }
 }
 
-void JamendoService::ParseDirectory(QIODevice* device) const {
+void JamendoService::ParseDirectory(QIODevice* device) {
   int total_count = 0;
 
   // Bit of a hack: don't update the model while we're parsing the xml
@@ -260,15 +318,20 @@ void JamendoService::ParseDirectory(QIODevice* device) const {
       total_count += songs.count();
       songs.clear();
       track_ids.clear();
-
-      // Update progress info
-      app_->task_manager()->SetTaskProgress(load_database_task_id_, total_count,
-                                            kApproxDatabaseSize);
     }
   }
 
+  if (reader.hasError()) {
+    qLog(Warning) << "Failed to parse the Jamendo catalogue:"
+                  << reader.errorString();
+  } else {
+    directory_parsed_ = true;
+  }
+
   library_backend_->AddOrUpdateSongs(songs);
   InsertTrackIds(track_ids);
+  total_count += songs.count();
+  qLog(Info) << "Loaded" << total_count << "songs from the Jamendo catalogue";
 
   connect(library_backend_.get(), SIGNAL(SongsDiscovered(SongList)),
           library_model_, SLOT(SongsDiscovered(SongList)));
@@ -402,6 +465,22 @@ Song JamendoService::ReadTrack(const QString& artist, const QString& album,
 }
 
 void JamendoService::ParseDirectoryFinished() {
+  delete directory_gzip_;
+  directory_gzip_ = nullptr;
+  delete directory_buffer_;
+  directory_buffer_ = nullptr;
+
+  // The parser gave up before the end.
+  if (directory_reply_) directory_reply_->abort();
+
+  // Only skip the next download if this one's in the database.
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.setValue("catalogue_etag",
+             directory_parsed_ ? directory_etag_ : QByteArray());
+  s.setValue("catalogue_last_modified",
+             directory_parsed_ ? directory_last_modified_ : QByteArray());
+
   // show smart playlists
   library_model_->set_show_smart_playlists(true);
   library_model_->Reset();
@@ -36,6 +36,9 @@ class SearchProvider;
 
 class QIODevice;
 class QMenu;
+class QNetworkReply;
+class QtIOCompressor;
+class StreamBuffer;
 class QSortFilterProxyModel;
 
 class JamendoService : public InternetService {
@@ -74,7 +77,8 @@ class JamendoService : public InternetService {
   static const int kApproxDatabaseSize;
 
  private:
-  void ParseDirectory(QIODevice* device) const;
+  // Runs in a worker thread, reading the catalogue as it's downloaded.
+  void ParseDirectory(QIODevice* device);
 
   typedef QList<int> TrackIdList;
 
@@ -91,6 +95,7 @@ class JamendoService : public InternetService {
  private slots:
   void DownloadDirectory();
   void DownloadDirectoryProgress(qint64 received, qint64 total);
+  void DownloadDirectoryReadyRead();
   void DownloadDirectoryFinished();
   void ParseDirectoryFinished();
   void UpdateTotalSongCount(int count);
@@ -115,6 +120,16 @@ class JamendoService : public InternetService {
 
   int load_database_task_id_;
 
+  // The catalogue being downloaded, and the pipe it goes through to get to
+  // ParseDirectory.
+  QNetworkReply* directory_reply_;
+  StreamBuffer* directory_buffer_;
+  QtIOCompressor* directory_gzip_;
+  bool directory_parsed_;
+  // Saved once the catalogue these came with has been parsed.
+  QByteArray directory_etag_;
+  QByteArray directory_last_modified_;
+
   int total_song_count_;
 
   bool accepted_download_;
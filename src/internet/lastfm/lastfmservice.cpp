@@ -35,7 +35,9 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QSettings>
+#include <QTimer>
 #include <QUrlQuery>
+#include <QXmlStreamReader>
 #include <algorithm>
 
 #include "lastfmservice.h"
@@ -48,6 +50,7 @@
 
 #include "core/application.h"
 #include "core/closure.h"
+#include "core/database.h"
 #include "core/logging.h"
 #include "core/network.h"
 #include "core/player.h"
@@ -77,15 +80,37 @@ const char* LastFMService::kSecret = "d3072b60ae626be12be69448f5c46e70";
 const char* LastFMService::kAuthLoginUrl =
     "https://www.last.fm/api/auth/?api_key=%1&token=%2";
 
+const int LastFMService::kMaxScrobblesPerRequest = 50;
+const int LastFMService::kNowPlayingDelayMsec = 3000;
+
+namespace {
+const int kFirstRetryMsec = 30 * 1000;
+const int kMaxRetryMsec = 60 * 60 * 1000;
+}  // namespace
+
 LastFMService::LastFMService(Application* app, QObject* parent)
     : Scrobbler(parent),
+      now_playing_timer_(new QTimer(this)),
+      submitting_scrobbles_(false),
+      scrobble_failures_(0),
+      scrobble_retry_timer_(new QTimer(this)),
+      single_scrobbles_left_(0),
       scrobbling_enabled_(false),
       connection_problems_(false),
       app_(app),
-      network_(new NetworkAccessManager) {
+      network_(new NetworkAccessManager),
+      journal_(new ScrobbleJournal(app->database())) {
 #ifdef HAVE_LIBLASTFM1
   lastfm::ws::setScheme(lastfm::ws::Https);
 #endif
+  network_->set_subsystem(metaObject()->className());
+
+  now_playing_timer_->setSingleShot(true);
+  now_playing_timer_->setInterval(kNowPlayingDelayMsec);
+  connect(now_playing_timer_, SIGNAL(timeout()), SLOT(SendNowPlaying()));
+
+  scrobble_retry_timer_->setSingleShot(true);
+  connect(scrobble_retry_timer_, SIGNAL(timeout()), SLOT(SubmitScrobbles()));
 
   ReloadSettings();
 
@@ -142,6 +167,24 @@ QByteArray SignApiRequest(QList<QPair<QString, QString>> params) {
   return QCryptographicHash::hash(to_sign.toUtf8(), QCryptographicHash::Md5)
       .toHex();
 }
+
+// Returns 0 if Last.fm took the request, otherwise the error code it gave,
+// or -1 if the reply couldn't be understood.
+int LastFMErrorCode(const QByteArray& data) {
+  QXmlStreamReader reader(data);
+  while (!reader.atEnd()) {
+    if (reader.readNext() != QXmlStreamReader::StartElement) continue;
+
+    if (reader.name() == "lfm" &&
+        reader.attributes().value("status") == "ok") {
+      return 0;
+    }
+    if (reader.name() == "error") {
+      return reader.attributes().value("code").toString().toInt();
+    }
+  }
+  return -1;
+}
 }  // namespace
 
 void LastFMService::Authenticate() {
@@ -312,8 +355,10 @@ QString LastFMService::ErrorString(lastfm::ws::Error error) const {
 bool LastFMService::InitScrobbler() {
   if (!IsAuthenticated() || !IsScrobblingEnabled()) return false;
 
-  if (!scrobbler_)
+  if (!scrobbler_) {
     scrobbler_.reset(new lastfm::Audioscrobbler(kAudioscrobblerClientId));
+    ImportScrobbleCache();
+  }
 
 // reemit the signal since the sender is private
 #ifdef HAVE_LIBLASTFM1
@@ -369,8 +414,8 @@ void LastFMService::NowPlaying(const Song& song) {
 
       qLog(Info) << "Scrobbling stream track" << mtrack.title() << "length"
                  << duration_secs;
-      scrobbler_->cache(mtrack);
-      scrobbler_->submit();
+      JournalTrack(mtrack);
+      SubmitScrobbles();
 
       emit ScrobbledRadioStream();
     }
@@ -395,7 +440,13 @@ void LastFMService::NowPlaying(const Song& song) {
 // no impact as we get a different error when actually trying to scrobble.
 #endif
 
-  scrobbler_->nowPlaying(mtrack);
+  now_playing_ = mtrack;
+  now_playing_timer_->start();
+}
+
+void LastFMService::SendNowPlaying() {
+  if (!InitScrobbler()) return;
+  scrobbler_->nowPlaying(now_playing_);
 }
 
 void LastFMService::CacheSong(int scrobble_point) {
@@ -403,7 +454,7 @@ void LastFMService::CacheSong(int scrobble_point) {
 
   if (!already_cached_to_scrobble_ && scrobble_point) {
     qLog(Info) << "Caching song to scrobble at" << scrobble_point;
-    scrobbler_->cache(last_track_);
+    JournalTrack(last_track_);
     already_cached_to_scrobble_ = true;
   }
   emit CachedToScrobble();
@@ -412,13 +463,135 @@ void LastFMService::CacheSong(int scrobble_point) {
 void LastFMService::Scrobble() {
   if (!InitScrobbler()) return;
 
-  lastfm::compat::ScrobbleCache cache(lastfm::ws::Username);
-  qLog(Debug) << "There are" << cache.tracks().count()
-              << "tracks in the last.fm cache before submit request.";
+  qLog(Debug) << "There are" << journal_->Count(lastfm::ws::Username)
+              << "tracks in the scrobble journal before submit request.";
 
   // Let's mark a track as cached, useful when the connection is down
   emit ScrobbleError(30);
-  if (!cache.tracks().isEmpty()) scrobbler_->submit();
+  SubmitScrobbles();
+}
+
+void LastFMService::ImportScrobbleCache() {
+  // Scrobbles liblastfm cached before we kept our own journal.
+  lastfm::compat::ScrobbleCache cache(lastfm::ws::Username);
+  const QList<lastfm::Track> tracks = cache.tracks();
+  if (tracks.isEmpty()) return;
+
+  qLog(Info) << "Moving" << tracks.count()
+             << "scrobbles from the liblastfm cache to the journal";
+  for (const lastfm::Track& track : tracks) {
+    JournalTrack(track);
+  }
+  cache.remove(tracks);
+}
+
+void LastFMService::JournalTrack(const lastfm::Track& track) {
+  ScrobbleJournal::Entry entry;
+  entry.artist_ = track.artist().name();
+  entry.title_ = track.title();
+  entry.album_ = track.album().title();
+  entry.track_ = track.trackNumber();
+  entry.duration_secs_ = track.duration();
+  entry.timestamp_ = track.timestamp().toTime_t();
+  journal_->Add(lastfm::ws::Username, entry);
+}
+
+void LastFMService::SubmitScrobbles() {
+  if (!InitScrobbler()) return;
+  if (submitting_scrobbles_ || scrobble_retry_timer_->isActive()) return;
+
+  const ScrobbleJournal::EntryList entries = journal_->Next(
+      lastfm::ws::Username,
+      single_scrobbles_left_ > 0 ? 1 : kMaxScrobblesPerRequest);
+  if (entries.isEmpty()) return;
+
+  QList<QPair<QString, QString>> params;
+  params << qMakePair(QString("method"), QString("track.scrobble"))
+         << qMakePair(QString("api_key"), QString(kApiKey))
+         << qMakePair(QString("sk"), lastfm::ws::SessionKey);
+  for (int i = 0; i < entries.count(); ++i) {
+    const ScrobbleJournal::Entry& entry = entries[i];
+    const QString index = QString("[%1]").arg(i);
+
+    params << qMakePair("artist" + index, entry.artist_)
+           << qMakePair("track" + index, entry.title_)
+           << qMakePair("timestamp" + index,
+                        QString::number(entry.timestamp_));
+    if (!entry.album_.isEmpty()) {
+      params << qMakePair("album" + index, entry.album_);
+    }
+    if (entry.track_ > 0) {
+      params << qMakePair("trackNumber" + index,
+                          QString::number(entry.track_));
+    }
+    if (entry.duration_secs_ > 0) {
+      params << qMakePair("duration" + index,
+                          QString::number(entry.duration_secs_));
+    }
+  }
+  params << qMakePair(QString("api_sig"), QString(SignApiRequest(params)));
+
+  // QUrlQuery leaves '+' alone, which the server would take as a space.
+  QByteArray body;
+  for (const auto& p : params) {
+    if (!body.isEmpty()) body += '&';
+    body += QUrl::toPercentEncoding(p.first) + '=' +
+            QUrl::toPercentEncoding(p.second);
+  }
+
+  QNetworkRequest request(QUrl("https://ws.audioscrobbler.com/2.0/"));
+  request.setHeader(QNetworkRequest::ContentTypeHeader,
+                    "application/x-www-form-urlencoded");
+
+  qLog(Debug) << "Submitting" << entries.count() << "scrobbles";
+  submitting_scrobbles_ = true;
+  QNetworkReply* reply = network_->post(request, body);
+  NewClosure(reply, SIGNAL(finished()), [this, reply, entries]() {
+    SubmitScrobblesFinished(reply, entries);
+  });
+}
+
+void LastFMService::SubmitScrobblesFinished(
+    QNetworkReply* reply, const ScrobbleJournal::EntryList& entries) {
+  reply->deleteLater();
+  submitting_scrobbles_ = false;
+
+  const int error = LastFMErrorCode(reply->readAll());
+  connection_problems_ = error == -1;
+
+  if (error == lastfm::ws::InvalidParameters && entries.count() > 1) {
+    // Any one of them could be the one Last.fm can't read.
+    qLog(Warning) << "Last.fm rejected a batch of" << entries.count()
+                  << "scrobbles, sending them one at a time";
+    single_scrobbles_left_ = entries.count();
+    SubmitScrobbles();
+    return;
+  }
+
+  if (error == 0 || error == lastfm::ws::InvalidParameters) {
+    // Scrobbles Last.fm ignored are in the reply, but sending them again
+    // won't make any difference.  Nor will it for ones it can't read.
+    if (error != 0) {
+      qLog(Warning) << "Last.fm rejected the scrobble of"
+                    << entries.first().artist_ << "-"
+                    << entries.first().title_;
+    }
+    journal_->Remove(entries);
+    single_scrobbles_left_ = qMax(0, single_scrobbles_left_ - entries.count());
+    scrobble_failures_ = 0;
+    emit ScrobbleSubmitted();
+
+    SubmitScrobbles();
+    return;
+  }
+
+  const int delay_msec =
+      qMin(kMaxRetryMsec, kFirstRetryMsec << qMin(scrobble_failures_, 7));
+  ++scrobble_failures_;
+  qLog(Warning) << "Submitting scrobbles failed with error" << error
+                << reply->errorString() << "- trying again in"
+                << delay_msec / 1000 << "seconds";
+  scrobble_retry_timer_->start(delay_msec);
 }
 
 void LastFMService::Love() {
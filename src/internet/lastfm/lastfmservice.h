@@ -34,11 +34,13 @@ uint qHash(const lastfm::Track& track);
 
 #include "internet/core/scrobbler.h"
 #include "lastfmcompat.h"
+#include "scrobblejournal.h"
 
 class Application;
 class LastFMUrlHandler;
 class NetworkAccessManager;
 class QAction;
+class QTimer;
 class Song;
 
 class LastFMService : public Scrobbler {
@@ -55,6 +57,9 @@ class LastFMService : public Scrobbler {
   static const char* kSecret;
   static const char* kAuthLoginUrl;
 
+  static const int kMaxScrobblesPerRequest;
+  static const int kNowPlayingDelayMsec;
+
   void ReloadSettings();
 
   virtual QString Icon() { return ":last.fm/lastfm.png"; }
@@ -100,11 +105,19 @@ class LastFMService : public Scrobbler {
 
   void ScrobblerStatus(int value);
 
+  void SendNowPlaying();
+  void SubmitScrobbles();
+
  private:
   QString ErrorString(lastfm::ws::Error error) const;
   bool InitScrobbler();
   lastfm::Track TrackFromSong(const Song& song) const;
 
+  void ImportScrobbleCache();
+  void JournalTrack(const lastfm::Track& track);
+  void SubmitScrobblesFinished(QNetworkReply* reply,
+                               const ScrobbleJournal::EntryList& entries);
+
   static QUrl FixupUrl(const QUrl& url);
 
  private:
@@ -113,6 +126,20 @@ class LastFMService : public Scrobbler {
   lastfm::Track next_metadata_;
   bool already_cached_to_scrobble_{false};
 
+  // Now playing updates wait a moment so skipping quickly through a playlist
+  // only sends the last one.
+  lastfm::Track now_playing_;
+  QTimer* now_playing_timer_;
+
+  // Scrobbles are kept here until Last.fm has taken them, and sent in
+  // batches.  Failures back off exponentially.
+  bool submitting_scrobbles_;
+  int scrobble_failures_;
+  QTimer* scrobble_retry_timer_;
+  // When Last.fm can't read a batch, its scrobbles are sent again one at a
+  // time so only the bad ones are dropped.  How many are left to send so.
+  int single_scrobbles_left_;
+
   QUrl last_url_;
 
   bool scrobbling_enabled_;
@@ -127,6 +154,7 @@ class LastFMService : public Scrobbler {
 
   Application* app_;
   std::unique_ptr<NetworkAccessManager> network_;
+  std::unique_ptr<ScrobbleJournal> journal_;
 };
 
 #endif  // INTERNET_LASTFM_LASTFMSERVICE_H_
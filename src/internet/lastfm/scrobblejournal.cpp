@@ -0,0 +1,109 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scrobblejournal.h"
+
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+#include "core/database.h"
+
+ScrobbleJournal::ScrobbleJournal(Database* db) : db_(db) {}
+
+void ScrobbleJournal::Add(const QString& username, const Entry& entry) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "INSERT INTO lastfm_scrobbles"
+      " (username, artist, title, album, track, duration, timestamp)"
+      " VALUES (:username, :artist, :title, :album, :track, :duration,"
+      "  :timestamp)");
+  q.bindValue(":username", username);
+  q.bindValue(":artist", entry.artist_);
+  q.bindValue(":title", entry.title_);
+  q.bindValue(":album", entry.album_);
+  q.bindValue(":track", entry.track_);
+  q.bindValue(":duration", entry.duration_secs_);
+  q.bindValue(":timestamp", entry.timestamp_);
+  q.exec();
+  db_->CheckErrors(q);
+}
+
+ScrobbleJournal::EntryList ScrobbleJournal::Next(const QString& username,
+                                                 int max_count) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "SELECT ROWID, artist, title, album, track, duration, timestamp"
+      " FROM lastfm_scrobbles"
+      " WHERE username = :username"
+      " ORDER BY timestamp, ROWID"
+      " LIMIT :limit");
+  q.bindValue(":username", username);
+  q.bindValue(":limit", max_count);
+  q.exec();
+  if (db_->CheckErrors(q)) return EntryList();
+
+  EntryList ret;
+  while (q.next()) {
+    Entry entry;
+    entry.id_ = q.value(0).toLongLong();
+    entry.artist_ = q.value(1).toString();
+    entry.title_ = q.value(2).toString();
+    entry.album_ = q.value(3).toString();
+    entry.track_ = q.value(4).toInt();
+    entry.duration_secs_ = q.value(5).toInt();
+    entry.timestamp_ = q.value(6).toLongLong();
+    ret << entry;
+  }
+  return ret;
+}
+
+int ScrobbleJournal::Count(const QString& username) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare("SELECT COUNT(*) FROM lastfm_scrobbles WHERE username = :username");
+  q.bindValue(":username", username);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return 0;
+  return q.value(0).toInt();
+}
+
+void ScrobbleJournal::Remove(const EntryList& entries) {
+  if (entries.isEmpty()) return;
+
+  QStringList ids;
+  for (const Entry& entry : entries) {
+    ids << QString::number(entry.id_);
+  }
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("DELETE FROM lastfm_scrobbles WHERE ROWID IN (%1)")
+                .arg(ids.join(",")));
+  q.exec();
+  db_->CheckErrors(q);
+}
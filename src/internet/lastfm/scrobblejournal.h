@@ -0,0 +1,57 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INTERNET_LASTFM_SCROBBLEJOURNAL_H_
+#define INTERNET_LASTFM_SCROBBLEJOURNAL_H_
+
+#include <QList>
+#include <QString>
+
+class Database;
+
+// Scrobbles waiting to be sent to Last.fm, kept in the database so they
+// survive being offline for a while, or Clementine being closed.
+class ScrobbleJournal {
+ public:
+  explicit ScrobbleJournal(Database* db);
+
+  struct Entry {
+    Entry() : id_(-1), track_(-1), duration_secs_(0), timestamp_(0) {}
+
+    qint64 id_;
+    QString artist_;
+    QString title_;
+    QString album_;
+    int track_;
+    int duration_secs_;
+    qint64 timestamp_;  // Seconds since the epoch, when it started playing
+  };
+  typedef QList<Entry> EntryList;
+
+  void Add(const QString& username, const Entry& entry);
+
+  // The oldest max_count scrobbles for this user.
+  EntryList Next(const QString& username, int max_count);
+  int Count(const QString& username);
+
+  void Remove(const EntryList& entries);
+
+ private:
+  Database* db_;
+};
+
+#endif  // INTERNET_LASTFM_SCROBBLEJOURNAL_H_
@@ -32,15 +32,18 @@
 #include <QSettings>
 #include <QSortFilterProxyModel>
 #include <QXmlStreamReader>
+#include <QtConcurrentRun>
 #include <QtDebug>
 
 #include "core/application.h"
+#include "core/closure.h"
 #include "core/database.h"
 #include "core/logging.h"
 #include "core/mergedproxymodel.h"
 #include "core/network.h"
 #include "core/player.h"
 #include "core/song.h"
+#include "core/streambuffer.h"
 #include "core/taskmanager.h"
 #include "core/timeconstants.h"
 #include "globalsearch/globalsearch.h"
@@ -80,6 +83,10 @@ MagnatuneService::MagnatuneService(Application* app, InternetModel* parent)
       library_filter_(nullptr),
       library_sort_model_(new QSortFilterProxyModel(this)),
       load_database_task_id_(0),
+      database_reply_(nullptr),
+      database_buffer_(nullptr),
+      database_gzip_(nullptr),
+      database_parsed_(false),
       membership_(Membership_None),
       format_(Format_Ogg),
       total_song_count_(0),
@@ -145,58 +152,140 @@ void MagnatuneService::UpdateTotalSongCount(int count) {
 }
 
 void MagnatuneService::ReloadDatabase() {
+  if (database_reply_ || database_buffer_) return;
+
   QNetworkRequest request = QNetworkRequest(QUrl(kDatabaseUrl));
   request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
                        QNetworkRequest::AlwaysNetwork);
 
-  QNetworkReply* reply = network_->get(request);
-  connect(reply, SIGNAL(finished()), SLOT(ReloadDatabaseFinished()));
+  // Don't load the catalogue again if it hasn't changed.
+  if (total_song_count_ > 0) {
+    QSettings s;
+    s.beginGroup(kSettingsGroup);
+    const QByteArray etag = s.value("database_etag").toByteArray();
+    const QByteArray last_modified =
+        s.value("database_last_modified").toByteArray();
+    if (!etag.isEmpty()) request.setRawHeader("If-None-Match", etag);
+    if (!last_modified.isEmpty()) {
+      request.setRawHeader("If-Modified-Since", last_modified);
+    }
+  }
+
+  database_reply_ = network_->get(request);
+  connect(database_reply_, SIGNAL(readyRead()),
+          SLOT(ReloadDatabaseReadyRead()));
+  connect(database_reply_, SIGNAL(finished()), SLOT(ReloadDatabaseFinished()));
 
   if (!load_database_task_id_)
     load_database_task_id_ =
         app_->task_manager()->StartTask(tr("Downloading Magnatune catalogue"));
 }
 
+void MagnatuneService::ReloadDatabaseReadyRead() {
+  QNetworkReply* reply = database_reply_;
+
+  if (!database_buffer_) {
+    // Anything else, like 304 Not Modified, is dealt with when it finishes.
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() !=
+        200) {
+      return;
+    }
+
+    // Only the compressed file is kept in memory.  It's decompressed and
+    // parsed a bit at a time once it's all here, so the database isn't held
+    // for as long as the download takes.
+    database_buffer_ = new StreamBuffer;
+    database_etag_ = reply->rawHeader("ETag");
+    database_last_modified_ = reply->rawHeader("Last-Modified");
+  }
+
+  database_buffer_->Append(reply->readAll());
+}
+
 void MagnatuneService::ReloadDatabaseFinished() {
-  QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+  QNetworkReply* reply = database_reply_;
+  database_reply_ = nullptr;
+  reply->deleteLater();
+
+  const int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 304) {
+    qLog(Info) << "Magnatune catalogue hasn't changed";
+  } else if (reply->error() != QNetworkReply::NoError) {
+    qLog(Error) << "Failed to download the Magnatune catalogue:"
+                << reply->errorString();
+  }
 
-  app_->task_manager()->SetTaskFinished(load_database_task_id_);
-  load_database_task_id_ = 0;
+  if (!database_buffer_) {
+    app_->task_manager()->SetTaskFinished(load_database_task_id_);
+    load_database_task_id_ = 0;
+    return;
+  }
 
   if (reply->error() != QNetworkReply::NoError) {
-    // TODO(David Sansome): Error handling
-    qLog(Error) << reply->errorString();
+    delete database_buffer_;
+    database_buffer_ = nullptr;
+    app_->task_manager()->SetTaskFinished(load_database_task_id_);
+    load_database_task_id_ = 0;
     return;
   }
 
-  if (root_->hasChildren()) root_->removeRows(0, root_->rowCount());
+  database_buffer_->Append(reply->readAll());
+  database_buffer_->Finish();
 
-  // The XML file is compressed
-  QtIOCompressor gzip(reply);
-  gzip.setStreamFormat(QtIOCompressor::GzipFormat);
-  if (!gzip.open(QIODevice::ReadOnly)) {
-    qLog(Warning) << "Error opening gzip stream";
-    return;
-  }
+  database_gzip_ = new QtIOCompressor(database_buffer_);
+  database_gzip_->setStreamFormat(QtIOCompressor::GzipFormat);
+  database_gzip_->open(QIODevice::ReadOnly);
+  database_parsed_ = false;
+
+  QFuture<void> future = QtConcurrent::run(
+      this, &MagnatuneService::ParseDatabase, database_gzip_);
+  NewClosure(future, this, SLOT(ParseDatabaseFinished()));
+}
 
-  // Remove all existing songs in the database
-  library_backend_->DeleteAll();
+void MagnatuneService::ParseDatabase(QIODevice* device) {
+  // Each track goes straight into the database, so only one is ever held
+  // here.  The old catalogue stays if anything goes wrong.
+  LibraryBackend::BulkReplace writer(library_backend_.get());
 
-  // Parse the XML we got from Magnatune
-  QXmlStreamReader reader(&gzip);
-  SongList songs;
+  QXmlStreamReader reader(device);
   while (!reader.atEnd()) {
     reader.readNext();
 
     if (reader.tokenType() == QXmlStreamReader::StartElement &&
         reader.name() == "Track") {
-      songs << ReadTrack(reader);
+      if (!writer.Add(ReadTrack(reader))) return;
     }
   }
 
-  // Add the songs to the database
-  library_backend_->AddOrUpdateSongs(songs);
-  library_model_->Reset();
+  if (reader.hasError()) {
+    qLog(Warning) << "Failed to parse the Magnatune catalogue:"
+                  << reader.errorString();
+    return;
+  }
+
+  database_parsed_ = writer.Commit();
+}
+
+void MagnatuneService::ParseDatabaseFinished() {
+  delete database_gzip_;
+  database_gzip_ = nullptr;
+  delete database_buffer_;
+  database_buffer_ = nullptr;
+
+  if (database_parsed_ && root_->hasChildren()) {
+    root_->removeRows(0, root_->rowCount());
+  }
+
+  // Only skip the next download if this one's in the database.
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.setValue("database_etag", database_parsed_ ? database_etag_ : QByteArray());
+  s.setValue("database_last_modified",
+             database_parsed_ ? database_last_modified_ : QByteArray());
+
+  app_->task_manager()->SetTaskFinished(load_database_task_id_);
+  load_database_task_id_ = 0;
 }
 
 Song MagnatuneService::ReadTrack(QXmlStreamReader& reader) {
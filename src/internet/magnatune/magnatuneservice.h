@@ -25,13 +25,17 @@
 
 #include "internet/core/internetservice.h"
 
+class QIODevice;
 class QNetworkAccessManager;
+class QNetworkReply;
 class QSortFilterProxyModel;
 class QMenu;
+class QtIOCompressor;
 
 class LibraryBackend;
 class LibraryModel;
 class MagnatuneUrlHandler;
+class StreamBuffer;
 
 class MagnatuneService : public InternetService {
   Q_OBJECT
@@ -95,7 +99,9 @@ class MagnatuneService : public InternetService {
  private slots:
   void UpdateTotalSongCount(int count);
   void ReloadDatabase();
+  void ReloadDatabaseReadyRead();
   void ReloadDatabaseFinished();
+  void ParseDatabaseFinished();
 
   void Download();
   void Homepage();
@@ -104,6 +110,7 @@ class MagnatuneService : public InternetService {
  private:
   void EnsureMenuCreated();
 
+  void ParseDatabase(QIODevice* device);
   Song ReadTrack(QXmlStreamReader& reader);
 
  private:
@@ -119,6 +126,16 @@ class MagnatuneService : public InternetService {
   QSortFilterProxyModel* library_sort_model_;
   int load_database_task_id_;
 
+  // The catalogue being downloaded, and the pipe it goes through to get to
+  // ParseDatabase once it's all here.
+  QNetworkReply* database_reply_;
+  StreamBuffer* database_buffer_;
+  QtIOCompressor* database_gzip_;
+  bool database_parsed_;
+  // Saved once the catalogue these came with is in the database.
+  QByteArray database_etag_;
+  QByteArray database_last_modified_;
+
   MembershipType membership_;
   QString username_;
   QString password_;
@@ -68,5 +68,9 @@ void FixedOpmlPage::LoadFinished(PodcastUrlLoaderReply* reply) {
       model()->CreateOpmlContainerItems(reply->opml_results(),
                                         model()->invisibleRootItem());
       break;
+
+    case PodcastUrlLoaderReply::Type_NotModified:
+      // Only for conditional requests.
+      break;
   }
 }
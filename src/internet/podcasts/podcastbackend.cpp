@@ -161,6 +161,22 @@ void PodcastBackend::UpdateEpisodes(const PodcastEpisodeList& episodes) {
   emit EpisodesUpdated(episodes);
 }
 
+void PodcastBackend::UpdateExtra(const Podcast& podcast) {
+  QByteArray extra;
+  QDataStream extra_stream(&extra, QIODevice::WriteOnly);
+  extra_stream << podcast.extra();
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare("UPDATE podcasts SET extra = :extra WHERE ROWID = :id");
+  q.bindValue(":extra", extra);
+  q.bindValue(":id", podcast.database_id());
+  q.exec();
+  db_->CheckErrors(q);
+}
+
 PodcastList PodcastBackend::GetAllSubscriptions() {
   PodcastList ret;
 
@@ -243,6 +259,42 @@ PodcastEpisodeList PodcastBackend::GetEpisodes(int podcast_id) {
   return ret;
 }
 
+QMap<int, int> PodcastBackend::GetUnlistenedEpisodeCounts() {
+  QMap<int, int> ret;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "SELECT podcast_id, COUNT(*) FROM podcast_episodes"
+      " WHERE COALESCE(listened, 0) = 0"
+      " GROUP BY podcast_id");
+  q.exec();
+  if (db_->CheckErrors(q)) return ret;
+
+  while (q.next()) {
+    ret[q.value(0).toInt()] = q.value(1).toInt();
+  }
+
+  return ret;
+}
+
+int PodcastBackend::GetUnlistenedEpisodeCount(int podcast_id) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "SELECT COUNT(*) FROM podcast_episodes"
+      " WHERE podcast_id = :id AND COALESCE(listened, 0) = 0");
+  q.bindValue(":id", podcast_id);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return 0;
+
+  return q.value(0).toInt();
+}
+
 PodcastEpisode PodcastBackend::GetEpisodeById(int id) {
   PodcastEpisode ret;
 
@@ -20,6 +20,7 @@
 #ifndef INTERNET_PODCASTS_PODCASTBACKEND_H_
 #define INTERNET_PODCASTS_PODCASTBACKEND_H_
 
+#include <QMap>
 #include <QObject>
 
 #include "podcast.h"
@@ -53,6 +54,10 @@ class PodcastBackend : public QObject {
   // Returns podcast episodes that match various keys.  All these queries are
   // indexed.
   PodcastEpisodeList GetEpisodes(int podcast_id);
+  // How many episodes haven't been listened to in every podcast that has
+  // some, keyed by podcast ID, from one query.
+  QMap<int, int> GetUnlistenedEpisodeCounts();
+  int GetUnlistenedEpisodeCount(int podcast_id);
   PodcastEpisode GetEpisodeById(int id);
   PodcastEpisode GetEpisodeByUrl(const QUrl& url);
   PodcastEpisode GetEpisodeByUrlOrLocalUrl(const QUrl& url);
@@ -73,6 +78,10 @@ class PodcastBackend : public QObject {
   // local_url) on episodes that must already exist in the database.
   void UpdateEpisodes(const PodcastEpisodeList& episodes);
 
+  // Saves the extra field of a podcast that must already exist in the
+  // database.
+  void UpdateExtra(const Podcast& podcast);
+
  signals:
   void SubscriptionAdded(const Podcast& podcast);
   void SubscriptionRemoved(const Podcast& podcast);
@@ -22,6 +22,7 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QMap>
 #include <QNetworkReply>
 #include <QSettings>
 #include <QTimer>
@@ -37,39 +38,89 @@
 #include "podcastbackend.h"
 
 const char* PodcastDownloader::kSettingsGroup = "Podcasts";
+const int PodcastDownloader::kDefaultMaxDownloads = 2;
+const int PodcastDownloader::kMaxDownloadsPerHost = 2;
 
-Task::Task(PodcastEpisode episode, QFile* file, PodcastBackend* backend)
-    : file_(file),
+Task::Task(PodcastEpisode episode, const QString& filename,
+           QNetworkAccessManager* network, PodcastBackend* backend)
+    : filename_(filename),
+      file_(filename + ".part"),
       episode_(episode),
-      req_(QNetworkRequest(episode.url())),
       backend_(backend),
-      network_(new NetworkAccessManager(this)),
-      repl(new RedirectFollower(network_->get(req_))) {
+      network_(network),
+      resume_from_(0),
+      positioned_(false) {}
+
+PodcastEpisode Task::episode() const { return episode_; }
+
+bool Task::Start() {
+  if (!file_.open(QIODevice::ReadWrite)) {
+    qLog(Warning) << "Could not open the file" << file_.fileName()
+                  << "for writing";
+    emit ProgressChanged(episode_, PodcastDownload::NotDownloading, 0);
+    return false;
+  }
+
+  QNetworkRequest req(episode_.url());
+  // Whole episodes can wait behind anything else going to the same host.
+  req.setPriority(QNetworkRequest::LowPriority);
+  resume_from_ = file_.size();
+  if (resume_from_ > 0) {
+    qLog(Info) << "Resuming" << episode_.url() << "from" << resume_from_;
+    req.setRawHeader("Range",
+                     QString("bytes=%1-").arg(resume_from_).toLatin1());
+  }
+
+  repl.reset(new RedirectFollower(network_->get(req)));
   connect(repl.get(), SIGNAL(readyRead()), SLOT(reading()));
   connect(repl.get(), SIGNAL(finished()), SLOT(finishedInternal()));
   connect(repl.get(), SIGNAL(downloadProgress(qint64, qint64)),
           SLOT(downloadProgressInternal(qint64, qint64)));
-  emit ProgressChanged(episode_, PodcastDownload::Queued, 0);
+  return true;
 }
 
-PodcastEpisode Task::episode() const { return episode_; }
+int Task::http_status() const {
+  return repl->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+}
 
 void Task::reading() {
+  if (!positioned_) {
+    switch (http_status()) {
+      case 206:
+        file_.seek(resume_from_);
+        break;
+      case 200:
+        // The server ignored the range and is sending all of it.
+        resume_from_ = 0;
+        file_.resize(0);
+        file_.seek(0);
+        break;
+      default:
+        // An error page, which mustn't end up in the file.
+        repl->readAll();
+        return;
+    }
+    positioned_ = true;
+  }
+
   qint64 bytes = 0;
   forever {
     bytes = repl->bytesAvailable();
     if (bytes <= 0) break;
 
-    file_->write(repl->reply()->read(bytes));
+    file_.write(repl->reply()->read(bytes));
   }
 }
 void Task::finishedPublic() {
-  disconnect(repl.get(), SIGNAL(readyRead()), 0, 0);
-  disconnect(repl.get(), SIGNAL(downloadProgress(qint64, qint64)), 0, 0);
-  disconnect(repl.get(), SIGNAL(finished()), 0, 0);
+  if (repl) {
+    disconnect(repl.get(), SIGNAL(readyRead()), 0, 0);
+    disconnect(repl.get(), SIGNAL(downloadProgress(qint64, qint64)), 0, 0);
+    disconnect(repl.get(), SIGNAL(finished()), 0, 0);
+    repl->abort();
+  }
   emit ProgressChanged(episode_, PodcastDownload::NotDownloading, 0);
-  // Delete the file
-  file_->remove();
+  // Delete the partial file
+  file_.remove();
   emit finished(this);
 }
 
@@ -77,19 +128,33 @@ void Task::finishedInternal() {
   if (repl->error() != QNetworkReply::NoError) {
     qLog(Warning) << "Error downloading episode:" << repl->errorString();
     emit ProgressChanged(episode_, PodcastDownload::NotDownloading, 0);
-    // Delete the file
-    file_->remove();
+    if (http_status() == 416) {
+      // The partial file doesn't match what's on the server any more.
+      file_.remove();
+    } else {
+      // Keep what we've got so the download can carry on from there.
+      file_.close();
+    }
     emit finished(this);
     return;
   }
 
-  qLog(Info) << "Download of" << file_->fileName() << "finished";
+  file_.close();
+  if (!file_.rename(filename_)) {
+    qLog(Warning) << "Could not rename" << file_.fileName() << "to"
+                  << filename_;
+    emit ProgressChanged(episode_, PodcastDownload::NotDownloading, 0);
+    emit finished(this);
+    return;
+  }
+
+  qLog(Info) << "Download of" << filename_ << "finished";
 
   // Tell the database the episode has been updated.  Get it from the DB again
   // in case the listened field changed in the mean time.
   PodcastEpisode episode = episode_;
   episode.set_downloaded(true);
-  episode.set_local_url(QUrl::fromLocalFile(file_->fileName()));
+  episode.set_local_url(QUrl::fromLocalFile(filename_));
   backend_->UpdateEpisodes(PodcastEpisodeList() << episode);
   Podcast podcast =
       backend_->GetSubscriptionById(episode.podcast_database_id());
@@ -97,8 +162,11 @@ void Task::finishedInternal() {
 
   emit ProgressChanged(episode_, PodcastDownload::Finished, 0);
 
-  // I didn't ecountered even a single podcast with a correct metadata
-  TagReaderClient::Instance()->SaveFileBlocking(file_->fileName(), song);
+  // I didn't ecountered even a single podcast with a correct metadata.
+  // Nothing needs to wait for the tags to be saved.
+  TagReaderReply* reply =
+      TagReaderClient::Instance()->SaveFile(filename_, song);
+  connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
   emit finished(this);
 }
 
@@ -106,8 +174,11 @@ void Task::downloadProgressInternal(qint64 received, qint64 total) {
   if (total <= 0) {
     emit ProgressChanged(episode_, PodcastDownload::Downloading, 0);
   } else {
-    emit ProgressChanged(episode_, PodcastDownload::Downloading,
-                         static_cast<float>(received) / total * 100);
+    // A resumed download only counts what's left.
+    emit ProgressChanged(
+        episode_, PodcastDownload::Downloading,
+        static_cast<float>(resume_from_ + received) / (resume_from_ + total) *
+            100);
   }
 }
 
@@ -117,7 +188,8 @@ PodcastDownloader::PodcastDownloader(Application* app, QObject* parent)
       backend_(app_->podcast_backend()),
       network_(new NetworkAccessManager(this)),
       disallowed_filename_characters_("[^a-zA-Z0-9_~ -]"),
-      auto_download_(false) {
+      auto_download_(false),
+      max_downloads_(kDefaultMaxDownloads) {
   connect(backend_, SIGNAL(EpisodesAdded(PodcastEpisodeList)),
           SLOT(EpisodesAdded(PodcastEpisodeList)));
   connect(backend_, SIGNAL(SubscriptionAdded(Podcast)),
@@ -145,6 +217,10 @@ void PodcastDownloader::ReloadSettings() {
 
   auto_download_ = s.value("auto_download", false).toBool();
   download_dir_ = s.value("download_dir", DefaultDownloadDir()).toString();
+  max_downloads_ =
+      qMax(1, s.value("max_downloads", kDefaultMaxDownloads).toInt());
+
+  StartTasks();
 }
 
 QString PodcastDownloader::FilenameForEpisode(
@@ -171,7 +247,14 @@ QString PodcastDownloader::FilenameForEpisode(
                           file_extension);
     }
 
-    if (!QFile::exists(filename)) {
+    // A .part file for this name is left alone, so that it's resumed, unless
+    // another episode is downloading into it.
+    bool in_use = false;
+    for (Task* task : list_tasks_) {
+      in_use |= task->filename() == filename;
+    }
+
+    if (!QFile::exists(filename) && !in_use) {
       return filename;
     }
 
@@ -197,15 +280,8 @@ void PodcastDownloader::DownloadEpisode(const PodcastEpisode& episode) {
       download_dir_ + "/" + SanitiseFilenameComponent(podcast.title());
   const QString filepath = FilenameForEpisode(directory, episode);
 
-  // Open the output file
   QDir().mkpath(directory);
-  QFile* file = new QFile(filepath);
-  if (!file->open(QIODevice::WriteOnly)) {
-    qLog(Warning) << "Could not open the file" << filepath << "for writing";
-    return;
-  }
-
-  Task* task = new Task(episode, file, backend_);
+  Task* task = new Task(episode, filepath, network_, backend_);
 
   list_tasks_ << task;
   qLog(Info) << "Downloading" << task->episode().url() << "to" << filepath;
@@ -215,11 +291,48 @@ void PodcastDownloader::DownloadEpisode(const PodcastEpisode& episode) {
                                  int)),
           SIGNAL(ProgressChanged(const PodcastEpisode&, PodcastDownload::State,
                                  int)));
+  emit ProgressChanged(episode, PodcastDownload::Queued, 0);
+
+  StartTasks();
+}
+
+void PodcastDownloader::StartTasks() {
+  int running = 0;
+  QMap<QString, int> running_per_host;
+  for (Task* task : list_tasks_) {
+    if (task->is_started()) {
+      running++;
+      running_per_host[task->host()]++;
+    }
+  }
+
+  QList<Task*> failed;
+  for (Task* task : list_tasks_) {
+    if (running >= max_downloads_) break;
+    if (task->is_started() ||
+        running_per_host[task->host()] >= kMaxDownloadsPerHost) {
+      continue;
+    }
+
+    if (!task->Start()) {
+      failed << task;
+      continue;
+    }
+    running++;
+    running_per_host[task->host()]++;
+  }
+
+  for (Task* task : failed) {
+    list_tasks_.removeAll(task);
+    task->deleteLater();
+  }
 }
 
 void PodcastDownloader::ReplyFinished(Task* task) {
   list_tasks_.removeAll(task);
-  delete task;
+  task->deleteLater();
+
+  StartTasks();
 }
 
 QString PodcastDownloader::SanitiseFilenameComponent(
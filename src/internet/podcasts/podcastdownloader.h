@@ -47,12 +47,22 @@ namespace PodcastDownload {
 enum State { NotDownloading, Queued, Downloading, Finished };
 }
 
+// Downloads one episode into a .part file next to filename, which is renamed
+// when it's complete.  If the .part file is already there the download is
+// resumed from the end of it with a Range request.
 class Task : public QObject {
   Q_OBJECT
 
  public:
-  Task(PodcastEpisode episode, QFile* file, PodcastBackend* backend);
+  Task(PodcastEpisode episode, const QString& filename,
+       QNetworkAccessManager* network, PodcastBackend* backend);
   PodcastEpisode episode() const;
+  const QString& filename() const { return filename_; }
+  QString host() const { return episode_.url().host(); }
+  bool is_started() const { return repl != nullptr; }
+
+  // Returns false if the .part file couldn't be opened.
+  bool Start();
 
  signals:
   void ProgressChanged(const PodcastEpisode& episode,
@@ -68,12 +78,19 @@ class Task : public QObject {
   void finishedInternal();
 
  private:
-  std::unique_ptr<QFile> file_;
+  int http_status() const;
+
+  QString filename_;
+  QFile file_;
   PodcastEpisode episode_;
-  QNetworkRequest req_;
   PodcastBackend* backend_;
-  std::unique_ptr<NetworkAccessManager> network_;
+  QNetworkAccessManager* network_;
   std::unique_ptr<RedirectFollower> repl;
+
+  // How much of the .part file was there when the download started, and
+  // whether the reply has said if it's carrying on from there.
+  qint64 resume_from_;
+  bool positioned_;
 };
 
 class PodcastDownloader : public QObject {
@@ -83,6 +100,9 @@ class PodcastDownloader : public QObject {
   explicit PodcastDownloader(Application* app, QObject* parent = nullptr);
 
   static const char* kSettingsGroup;
+  static const int kDefaultMaxDownloads;
+  static const int kMaxDownloadsPerHost;
+
   PodcastEpisodeList EpisodesDownloading(const PodcastEpisodeList& episodes);
   QString DefaultDownloadDir() const;
 
@@ -108,6 +128,10 @@ class PodcastDownloader : public QObject {
                              const PodcastEpisode& episode) const;
   QString SanitiseFilenameComponent(const QString& text) const;
 
+  // Starts queued tasks until there are max_downloads_ running, with no more
+  // than kMaxDownloadsPerHost from any one server.
+  void StartTasks();
+
  private:
   Application* app_;
   PodcastBackend* backend_;
@@ -117,6 +141,7 @@ class PodcastDownloader : public QObject {
 
   bool auto_download_;
   QString download_dir_;
+  int max_downloads_;
 
   QList<Task*> list_tasks_;
 };
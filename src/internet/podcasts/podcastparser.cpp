@@ -31,6 +31,49 @@ const char* PodcastParser::kAtomNamespace = "http://www.w3.org/2005/atom";
 const char* PodcastParser::kItunesNamespace =
     "http://www.itunes.com/dtds/podcast-1.0.dtd";
 
+namespace {
+
+// Like QXmlStreamReader::readElementText, but returns an empty string for
+// text longer than max_length, without keeping all of it.
+QString ReadElementText(QXmlStreamReader* reader, int max_length) {
+  if (max_length == 0) {
+    return reader->readElementText();
+  }
+
+  QString ret;
+  bool too_long = false;
+  int depth = 1;
+  while (!reader->atEnd()) {
+    switch (reader->readNext()) {
+      case QXmlStreamReader::Characters:
+        if (!too_long) {
+          ret.append(reader->text());
+          if (ret.length() > max_length) {
+            too_long = true;
+            ret.clear();
+          }
+        }
+        break;
+
+      case QXmlStreamReader::StartElement:
+        depth++;
+        break;
+
+      case QXmlStreamReader::EndElement:
+        if (--depth == 0) {
+          return ret;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+  return QString();
+}
+
+}  // namespace
+
 PodcastParser::PodcastParser() {
   supported_mime_types_ << "application/rss+xml"
                         << "application/xml"
@@ -58,6 +101,11 @@ bool PodcastParser::TryMagic(const QByteArray& data) const {
 }
 
 QVariant PodcastParser::Load(QIODevice* device, const QUrl& url) const {
+  return Load(device, url, Options());
+}
+
+QVariant PodcastParser::Load(QIODevice* device, const QUrl& url,
+                             const Options& options) const {
   QXmlStreamReader reader(device);
 
   while (!reader.atEnd()) {
@@ -66,7 +114,7 @@ QVariant PodcastParser::Load(QIODevice* device, const QUrl& url) const {
         const QStringRef name = reader.name();
         if (name == "rss") {
           Podcast podcast;
-          if (!ParseRss(&reader, &podcast)) {
+          if (!ParseRss(&reader, options, &podcast)) {
             return QVariant();
           } else {
             podcast.set_url(url);
@@ -93,16 +141,24 @@ QVariant PodcastParser::Load(QIODevice* device, const QUrl& url) const {
   return QVariant();
 }
 
-bool PodcastParser::ParseRss(QXmlStreamReader* reader, Podcast* ret) const {
+bool PodcastParser::ParseRss(QXmlStreamReader* reader, const Options& options,
+                             Podcast* ret) const {
   if (!Utilities::ParseUntilElement(reader, "channel")) {
     return false;
   }
 
-  ParseChannel(reader, ret);
+  ParseChannel(reader, options, ret);
   return true;
 }
 
-void PodcastParser::ParseChannel(QXmlStreamReader* reader, Podcast* ret) const {
+void PodcastParser::ParseChannel(QXmlStreamReader* reader,
+                                 const Options& options, Podcast* ret) const {
+  // Whether the items so far have been newest first.  Only then is it safe to
+  // stop at the first known item.
+  bool newest_first = true;
+  QDateTime previous_date;
+  int items = 0;
+
   while (!reader->atEnd()) {
     QXmlStreamReader::TokenType type = reader->readNext();
     switch (type) {
@@ -117,7 +173,8 @@ void PodcastParser::ParseChannel(QXmlStreamReader* reader, Podcast* ret) const {
           ret->set_link(
               QUrl::fromEncoded(reader->readElementText().toLatin1()));
         } else if (name == "description") {
-          ret->set_description(reader->readElementText());
+          ret->set_description(
+              ReadElementText(reader, options.max_description_length_));
         } else if (name == "owner" && lower_namespace == kItunesNamespace) {
           ParseItunesOwner(reader, ret);
         } else if (name == "image") {
@@ -129,7 +186,25 @@ void PodcastParser::ParseChannel(QXmlStreamReader* reader, Podcast* ret) const {
                    reader->attributes().value("rel") == "self") {
           ret->set_url(QUrl::fromEncoded(reader->readElementText().toLatin1()));
         } else if (name == "item") {
-          ParseItem(reader, ret);
+          const PodcastEpisode episode = ParseItem(reader, options);
+          const QDateTime& date = episode.publication_date();
+          if (items++ > 0 && date > previous_date) {
+            newest_first = false;
+          }
+          previous_date = date;
+
+          const bool known_url = options.known_urls_.contains(episode.url());
+          const bool old = options.newest_known_.isValid() &&
+                           date < options.newest_known_;
+
+          // The first item could be the only one in an oldest first feed.
+          if ((known_url || old) && newest_first && items > 1) {
+            qLog(Debug) << "Stopping at known episode" << episode.url();
+            return;
+          }
+          if (!known_url && !episode.url().isEmpty()) {
+            ret->add_episode(episode);
+          }
         } else {
           Utilities::ConsumeCurrentElement(reader);
         }
@@ -195,7 +270,8 @@ void PodcastParser::ParseItunesOwner(QXmlStreamReader* reader,
   }
 }
 
-void PodcastParser::ParseItem(QXmlStreamReader* reader, Podcast* ret) const {
+PodcastEpisode PodcastParser::ParseItem(QXmlStreamReader* reader,
+                                        const Options& options) const {
   PodcastEpisode episode;
 
   while (!reader->atEnd()) {
@@ -209,7 +285,8 @@ void PodcastParser::ParseItem(QXmlStreamReader* reader, Podcast* ret) const {
         if (name == "title") {
           episode.set_title(reader->readElementText());
         } else if (name == "description") {
-          episode.set_description(reader->readElementText());
+          episode.set_description(
+              ReadElementText(reader, options.max_description_length_));
         } else if (name == "pubDate") {
           QString date = reader->readElementText();
           episode.set_publication_date(Utilities::ParseRFC822DateTime(date));
@@ -256,15 +333,13 @@ void PodcastParser::ParseItem(QXmlStreamReader* reader, Podcast* ret) const {
         if (!episode.publication_date().isValid()) {
           episode.set_publication_date(QDateTime::currentDateTime());
         }
-        if (!episode.url().isEmpty()) {
-          ret->add_episode(episode);
-        }
-        return;
+        return episode;
 
       default:
         break;
     }
   }
+  return episode;
 }
 
 bool PodcastParser::ParseOpml(QXmlStreamReader* reader,
@@ -20,6 +20,8 @@
 #ifndef INTERNET_PODCASTS_PODCASTPARSER_H_
 #define INTERNET_PODCASTS_PODCASTPARSER_H_
 
+#include <QDateTime>
+#include <QSet>
 #include <QStringList>
 
 #include "podcast.h"
@@ -38,6 +40,19 @@ class PodcastParser {
   static const char* kAtomNamespace;
   static const char* kItunesNamespace;
 
+  // For refreshing a podcast that's already known.  If the feed lists its
+  // newest items first, parsing stops at the first item that's in known_urls_
+  // or older than newest_known_, and only the new items are returned.
+  // Descriptions longer than max_description_length_ characters are dropped
+  // without being kept in memory, 0 keeps them all.
+  struct Options {
+    Options() : max_description_length_(0) {}
+
+    QSet<QUrl> known_urls_;
+    QDateTime newest_known_;
+    int max_description_length_;
+  };
+
   const QStringList& supported_mime_types() const {
     return supported_mime_types_;
   }
@@ -47,17 +62,22 @@ class PodcastParser {
   // contains a Podcast or an OpmlContainer.  If the QVariant isNull then an
   // error occurred parsing the XML.
   QVariant Load(QIODevice* device, const QUrl& url) const;
+  QVariant Load(QIODevice* device, const QUrl& url,
+                const Options& options) const;
 
   // Really quick test to see if some data might be supported.  Load() might
   // still return a null QVariant.
   bool TryMagic(const QByteArray& data) const;
 
  private:
-  bool ParseRss(QXmlStreamReader* reader, Podcast* ret) const;
-  void ParseChannel(QXmlStreamReader* reader, Podcast* ret) const;
+  bool ParseRss(QXmlStreamReader* reader, const Options& options,
+                Podcast* ret) const;
+  void ParseChannel(QXmlStreamReader* reader, const Options& options,
+                    Podcast* ret) const;
   void ParseImage(QXmlStreamReader* reader, Podcast* ret) const;
   void ParseItunesOwner(QXmlStreamReader* reader, Podcast* ret) const;
-  void ParseItem(QXmlStreamReader* reader, Podcast* ret) const;
+  PodcastEpisode ParseItem(QXmlStreamReader* reader,
+                           const Options& options) const;
 
   bool ParseOpml(QXmlStreamReader* reader, OpmlContainer* ret) const;
   void ParseOutline(QXmlStreamReader* reader, OpmlContainer* ret) const;
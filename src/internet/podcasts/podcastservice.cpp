@@ -218,6 +218,10 @@ void PodcastService::LazyPopulate(QStandardItem* parent) {
       PopulatePodcastList(model_->invisibleRootItem());
       model()->merged_model()->AddSubModel(parent->index(), proxy_);
       break;
+
+    case Type_Podcast:
+      PopulatePodcast(parent);
+      break;
   }
 }
 
@@ -232,13 +236,61 @@ void PodcastService::PopulatePodcastList(QStandardItem* parent) {
     default_icon_ = IconLoader::Load("podcast", IconLoader::Provider);
   }
 
+  const QMap<int, int> unlistened_counts =
+      backend_->GetUnlistenedEpisodeCounts();
   for (const Podcast& podcast : backend_->GetAllSubscriptions()) {
-    parent->appendRow(CreatePodcastItem(podcast));
+    parent->appendRow(CreatePodcastItem(
+        podcast, unlistened_counts.value(podcast.database_id())));
   }
 }
 
 void PodcastService::ClearPodcastList(QStandardItem* parent) {
   parent->removeRows(0, parent->rowCount());
+
+  // Podcasts aren't expanded again until they're next shown, so nothing can
+  // be left pointing at the old items.
+  podcasts_by_database_id_.clear();
+  episodes_by_database_id_.clear();
+}
+
+void PodcastService::PopulatePodcast(QStandardItem* item) {
+  const Podcast podcast = item->data(Role_Podcast).value<Podcast>();
+
+  qint64 number = 0;
+  for (const PodcastEpisode& episode :
+       backend_->GetEpisodes(podcast.database_id())) {
+    if (episode.listened() && hide_listened_) continue;
+
+    item->appendRow(CreatePodcastEpisodeItem(episode));
+    ++number;
+
+    if ((number >= show_episodes_) && (show_episodes_ != 0)) {
+      break;
+    }
+  }
+}
+
+void PodcastService::ClearPodcast(QStandardItem* item) {
+  // Remove any episode ID -> item mappings for the episodes in this podcast.
+  for (int i = 0; i < item->rowCount(); ++i) {
+    QStandardItem* episode_item = item->child(i);
+    const int episode_id =
+        episode_item->data(Role_Episode).value<PodcastEpisode>().database_id();
+
+    episodes_by_database_id_.remove(episode_id);
+  }
+
+  item->removeRows(0, item->rowCount());
+}
+
+void PodcastService::UpdatePodcastItems(const QSet<int>& database_ids) {
+  for (int database_id : database_ids) {
+    QStandardItem* item = podcasts_by_database_id_.value(database_id);
+    if (!item) continue;
+
+    UpdatePodcastText(item, backend_->GetUnlistenedEpisodeCount(database_id));
+    ReloadPodcast(item->data(Role_Podcast).value<Podcast>());
+  }
 }
 
 void PodcastService::UpdatePodcastText(QStandardItem* item,
@@ -354,33 +406,14 @@ void PodcastService::UpdatePodcastText(QStandardItem* item,
   }
 }
 
-QStandardItem* PodcastService::CreatePodcastItem(const Podcast& podcast) {
+QStandardItem* PodcastService::CreatePodcastItem(const Podcast& podcast,
+                                                 int unlistened_count) {
   QStandardItem* item = new QStandardItem;
 
-  // Add the episodes in this podcast and gather aggregate stats.
-  int unlistened_count = 0;
-  qint64 number = 0;
-  for (const PodcastEpisode& episode :
-       backend_->GetEpisodes(podcast.database_id())) {
-    if (!episode.listened()) {
-      unlistened_count++;
-    }
-
-    if (episode.listened() && hide_listened_) {
-      continue;
-    } else {
-      item->appendRow(CreatePodcastEpisodeItem(episode));
-      ++number;
-    }
-
-    if ((number >= show_episodes_) && (show_episodes_ != 0)) {
-      break;
-    }
-  }
-
   item->setIcon(default_icon_);
   item->setData(Type_Podcast, InternetModel::Role_Type);
   item->setData(QVariant::fromValue(podcast), Role_Podcast);
+  item->setData(true, InternetModel::Role_CanLazyLoad);
   item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsDragEnabled |
                  Qt::ItemIsSelectable);
   UpdatePodcastText(item, unlistened_count);
@@ -396,14 +429,7 @@ QStandardItem* PodcastService::CreatePodcastItem(const Podcast& podcast) {
 }
 
 void PodcastService::RemovePodcastItem(QStandardItem* item) {
-  // Remove any episode ID -> item mappings for the episodes in this podcast.
-  for (int i = 0; i < item->rowCount(); ++i) {
-    QStandardItem* episode_item = item->child(i);
-    const int episode_id =
-        episode_item->data(Role_Episode).value<PodcastEpisode>().database_id();
-
-    episodes_by_database_id_.remove(episode_id);
-  }
+  ClearPodcast(item);
 
   // Remove this podcast's row
   model_->removeRow(item->row());
@@ -625,7 +651,8 @@ void PodcastService::SubscriptionAdded(const Podcast& podcast) {
   // added it.
   QStandardItem* item = podcasts_by_database_id_[podcast.database_id()];
   if (!item) {
-    item = CreatePodcastItem(podcast);
+    item = CreatePodcastItem(
+        podcast, backend_->GetUnlistenedEpisodeCount(podcast.database_id()));
     model_->appendRow(item);
   }
 
@@ -644,60 +671,37 @@ void PodcastService::EpisodesAdded(const PodcastEpisodeList& episodes) {
 
   for (const PodcastEpisode& episode : episodes) {
     const int database_id = episode.podcast_database_id();
-    QStandardItem* parent = podcasts_by_database_id_[database_id];
+    QStandardItem* parent = podcasts_by_database_id_.value(database_id);
     if (!parent) continue;
 
-    parent->appendRow(CreatePodcastEpisodeItem(episode));
-    if (!seen_podcast_ids.contains(database_id)) {
-      // Update the unlistened count text once for each podcast
-      int unlistened_count = 0;
-      for (const PodcastEpisode& episode : backend_->GetEpisodes(database_id)) {
-        if (!episode.listened()) {
-          unlistened_count++;
-        }
-      }
-
-      UpdatePodcastText(parent, unlistened_count);
-      seen_podcast_ids.insert(database_id);
+    // Podcasts that haven't been expanded get the new episodes when they are.
+    if (!parent->data(InternetModel::Role_CanLazyLoad).toBool()) {
+      parent->appendRow(CreatePodcastEpisodeItem(episode));
     }
-    const Podcast podcast = parent->data(Role_Podcast).value<Podcast>();
-    ReloadPodcast(podcast);
+    seen_podcast_ids.insert(database_id);
   }
+
+  UpdatePodcastItems(seen_podcast_ids);
 }
 
 void PodcastService::EpisodesUpdated(const PodcastEpisodeList& episodes) {
   QSet<int> seen_podcast_ids;
-  QMap<int, Podcast> podcasts_map;
 
   for (const PodcastEpisode& episode : episodes) {
     const int podcast_database_id = episode.podcast_database_id();
-    QStandardItem* item = episodes_by_database_id_[episode.database_id()];
-    QStandardItem* parent = podcasts_by_database_id_[podcast_database_id];
-    if (!item || !parent) continue;
-    // Update the episode data on the item, and update the item's text.
-    item->setData(QVariant::fromValue(episode), Role_Episode);
-    UpdateEpisodeText(item);
-
-    // Update the parent podcast's text too.
-    if (!seen_podcast_ids.contains(podcast_database_id)) {
-      // Update the unlistened count text once for each podcast
-      int unlistened_count = 0;
-      for (const PodcastEpisode& episode :
-           backend_->GetEpisodes(podcast_database_id)) {
-        if (!episode.listened()) {
-          unlistened_count++;
-        }
-      }
+    if (!podcasts_by_database_id_.value(podcast_database_id)) continue;
+    seen_podcast_ids.insert(podcast_database_id);
 
-      UpdatePodcastText(parent, unlistened_count);
-      seen_podcast_ids.insert(podcast_database_id);
+    // Update the episode data on the item, and update the item's text.  It
+    // only has an item if its podcast has been expanded.
+    QStandardItem* item = episodes_by_database_id_.value(episode.database_id());
+    if (item) {
+      item->setData(QVariant::fromValue(episode), Role_Episode);
+      UpdateEpisodeText(item);
     }
-    const Podcast podcast = parent->data(Role_Podcast).value<Podcast>();
-    podcasts_map[podcast.database_id()] = podcast;
-  }
-  for (const Podcast& podcast_tmp : podcasts_map.values()) {
-    ReloadPodcast(podcast_tmp);
   }
+
+  UpdatePodcastItems(seen_podcast_ids);
 }
 
 void PodcastService::DownloadSelectedEpisode() {
@@ -735,13 +739,12 @@ void PodcastService::DeleteDownloadedData() {
 void PodcastService::DownloadProgressChanged(const PodcastEpisode& episode,
                                              PodcastDownload::State state,
                                              int percent) {
-  QStandardItem* item = episodes_by_database_id_[episode.database_id()];
+  QStandardItem* item = episodes_by_database_id_.value(episode.database_id());
   QStandardItem* item2 =
-      podcasts_by_database_id_[episode.podcast_database_id()];
-  if (!item || !item2) return;
+      podcasts_by_database_id_.value(episode.podcast_database_id());
 
-  UpdateEpisodeText(item, state, percent);
-  UpdatePodcastText(item2, state, percent);
+  if (item) UpdateEpisodeText(item, state, percent);
+  if (item2) UpdatePodcastText(item2, state, percent);
 }
 
 void PodcastService::ShowConfig() {
@@ -860,8 +863,11 @@ void PodcastService::ReloadPodcast(const Podcast& podcast) {
   if (!(hide_listened_ || (show_episodes_ > 0))) {
     return;
   }
-  QStandardItem* item = podcasts_by_database_id_[podcast.database_id()];
+  QStandardItem* item = podcasts_by_database_id_.value(podcast.database_id());
+
+  // Podcasts that haven't been expanded are filled in when they are.
+  if (!item || item->data(InternetModel::Role_CanLazyLoad).toBool()) return;
 
-  RemovePodcastItem(item);
-  model_->invisibleRootItem()->appendRow(CreatePodcastItem(podcast));
+  ClearPodcast(item);
+  PopulatePodcast(item);
 }
@@ -22,6 +22,7 @@
 #define INTERNET_PODCASTS_PODCASTSERVICE_H_
 
 #include <QScopedPointer>
+#include <QSet>
 #include <memory>
 
 #include "internet/core/internetmodel.h"
@@ -107,6 +108,12 @@ class PodcastService : public InternetService {
   void UpdatePodcastListenedStateAsync(const Song& metadata);
   void PopulatePodcastList(QStandardItem* parent);
   void ClearPodcastList(QStandardItem* parent);
+  // Adds the podcast's episodes, as many as the settings allow.
+  void PopulatePodcast(QStandardItem* item);
+  void ClearPodcast(QStandardItem* item);
+  // Updates the unlistened counts of these podcasts, and reloads the ones
+  // that have been expanded if the settings hide some episodes.
+  void UpdatePodcastItems(const QSet<int>& database_ids);
   void UpdatePodcastText(QStandardItem* item, int unlistened_count) const;
   void UpdateEpisodeText(
       QStandardItem* item,
@@ -117,7 +124,9 @@ class PodcastService : public InternetService {
       PodcastDownload::State state = PodcastDownload::NotDownloading,
       int percent = 0);
 
-  QStandardItem* CreatePodcastItem(const Podcast& podcast);
+  // The item has no episodes until it's expanded.
+  QStandardItem* CreatePodcastItem(const Podcast& podcast,
+                                   int unlistened_count);
   QStandardItem* CreatePodcastEpisodeItem(const PodcastEpisode& episode);
   void RemovePodcastItem(QStandardItem* item);
 
@@ -22,8 +22,22 @@
 #include "internet/podcasts/podcastservice.h"
 #include "playlist/songmimedata.h"
 
-PodcastServiceModel::PodcastServiceModel(QObject* parent)
-    : QStandardItemModel(parent) {}
+PodcastServiceModel::PodcastServiceModel(PodcastService* service)
+    : QStandardItemModel(service), service_(service) {}
+
+bool PodcastServiceModel::hasChildren(const QModelIndex& parent) const {
+  if (parent.data(InternetModel::Role_CanLazyLoad).toBool()) return true;
+  return QStandardItemModel::hasChildren(parent);
+}
+
+int PodcastServiceModel::rowCount(const QModelIndex& parent) const {
+  if (parent.data(InternetModel::Role_CanLazyLoad).toBool()) {
+    QStandardItem* item = itemFromIndex(parent);
+    item->setData(false, InternetModel::Role_CanLazyLoad);
+    service_->LazyPopulate(item);
+  }
+  return QStandardItemModel::rowCount(parent);
+}
 
 QMimeData* PodcastServiceModel::mimeData(const QModelIndexList& indexes) const {
   SongMimeData* data = new SongMimeData;
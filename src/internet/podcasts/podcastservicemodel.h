@@ -22,21 +22,28 @@
 
 #include <QStandardItemModel>
 
+class PodcastService;
 class SongMimeData;
 
+// Podcast items with InternetModel::Role_CanLazyLoad set get their episodes
+// from the service the first time anything asks how many they have.
 class PodcastServiceModel : public QStandardItemModel {
   Q_OBJECT
 
  public:
-  explicit PodcastServiceModel(QObject* parent = nullptr);
+  explicit PodcastServiceModel(PodcastService* service);
 
   QMimeData* mimeData(const QModelIndexList& indexes) const;
+  bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+  int rowCount(const QModelIndex& parent = QModelIndex()) const;
 
  private:
   void MimeDataForPodcast(const QModelIndex& index, SongMimeData* data,
                           QList<QUrl>* urls) const;
   void MimeDataForEpisode(const QModelIndex& index, SongMimeData* data,
                           QList<QUrl>* urls) const;
+
+  PodcastService* service_;
 };
 
 #endif  // INTERNET_PODCASTS_PODCASTSERVICEMODEL_H_
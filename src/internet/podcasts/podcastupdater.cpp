@@ -30,6 +30,10 @@
 #include "podcasturlloader.h"
 
 const char* PodcastUpdater::kSettingsGroup = "Podcasts";
+const char* PodcastUpdater::kEtagKey = "http:etag";
+const char* PodcastUpdater::kLastModifiedKey = "http:last_modified";
+const int PodcastUpdater::kMaxConcurrentUpdates = 8;
+const int PodcastUpdater::kMaxDescriptionLength = 64 * 1024;
 
 PodcastUpdater::PodcastUpdater(Application* app, QObject* parent)
     : QObject(parent),
@@ -106,23 +110,55 @@ void PodcastUpdater::SubscriptionAdded(const Podcast& podcast) {
   }
 }
 
+PodcastUrlLoaderReply* PodcastUpdater::Load(const Podcast& podcast) {
+  // The parser only has to find the episodes we haven't got yet.
+  PodcastParser::Options options;
+  options.max_description_length_ = kMaxDescriptionLength;
+  for (const PodcastEpisode& episode :
+       app_->podcast_backend()->GetEpisodes(podcast.database_id())) {
+    options.known_urls_.insert(episode.url());
+    if (!options.newest_known_.isValid() ||
+        episode.publication_date() > options.newest_known_) {
+      options.newest_known_ = episode.publication_date();
+    }
+  }
+
+  return loader_->Load(podcast.url(), podcast.extra(kEtagKey).toByteArray(),
+                       podcast.extra(kLastModifiedKey).toByteArray(), options);
+}
+
 void PodcastUpdater::UpdatePodcastNow(const Podcast& podcast) {
-  PodcastUrlLoaderReply* reply = loader_->Load(podcast.url());
+  PodcastUrlLoaderReply* reply = Load(podcast);
   NewClosure(reply, SIGNAL(Finished(bool)), this,
              SLOT(PodcastLoaded(PodcastUrlLoaderReply*, Podcast, bool)), reply,
              podcast, false);
 }
 
 void PodcastUpdater::UpdateAllPodcastsNow() {
+  if (pending_replies_ > 0) {
+    // The last update hasn't finished yet.
+    return;
+  }
+
   for (const Podcast& podcast :
        app_->podcast_backend()->GetAllSubscriptions()) {
-    PodcastUrlLoaderReply* reply = loader_->Load(podcast.url());
-    NewClosure(reply, SIGNAL(Finished(bool)), this,
-               SLOT(PodcastLoaded(PodcastUrlLoaderReply*, Podcast, bool)),
-               reply, podcast, true);
-
+    queued_podcasts_.enqueue(podcast);
     pending_replies_++;
   }
+
+  for (int i = 0; i < kMaxConcurrentUpdates; ++i) {
+    StartNextUpdate();
+  }
+}
+
+void PodcastUpdater::StartNextUpdate() {
+  if (queued_podcasts_.isEmpty()) return;
+
+  const Podcast podcast = queued_podcasts_.dequeue();
+  PodcastUrlLoaderReply* reply = Load(podcast);
+  NewClosure(reply, SIGNAL(Finished(bool)), this,
+             SLOT(PodcastLoaded(PodcastUrlLoaderReply*, Podcast, bool)), reply,
+             podcast, true);
 }
 
 void PodcastUpdater::PodcastLoaded(PodcastUrlLoaderReply* reply,
@@ -130,6 +166,8 @@ void PodcastUpdater::PodcastLoaded(PodcastUrlLoaderReply* reply,
   reply->deleteLater();
 
   if (one_of_many) {
+    StartNextUpdate();
+
     if (--pending_replies_ == 0) {
       // This was the last reply we were waiting for.  Save this time as being
       // the last successful update and restart the timer.
@@ -145,6 +183,11 @@ void PodcastUpdater::PodcastLoaded(PodcastUrlLoaderReply* reply,
     return;
   }
 
+  if (reply->result_type() == PodcastUrlLoaderReply::Type_NotModified) {
+    qLog(Debug) << "Podcast" << podcast.url() << "hasn't changed";
+    return;
+  }
+
   if (reply->result_type() != PodcastUrlLoaderReply::Type_Podcast) {
     qLog(Warning) << "The URL" << podcast.url()
                   << "no longer contains a podcast";
@@ -173,4 +216,15 @@ void PodcastUpdater::PodcastLoaded(PodcastUrlLoaderReply* reply,
   app_->podcast_backend()->AddEpisodes(&new_episodes);
   qLog(Info) << "Added" << new_episodes.count() << "new episodes for"
              << podcast.url();
+
+  // Remember the validators for the next update, but only write them if
+  // they've changed.
+  if (reply->etag() != podcast.extra(kEtagKey).toByteArray() ||
+      reply->last_modified() !=
+          podcast.extra(kLastModifiedKey).toByteArray()) {
+    Podcast podcast_copy(podcast);
+    podcast_copy.set_extra(kEtagKey, reply->etag());
+    podcast_copy.set_extra(kLastModifiedKey, reply->last_modified());
+    app_->podcast_backend()->UpdateExtra(podcast_copy);
+  }
 }
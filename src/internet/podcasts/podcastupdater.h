@@ -22,16 +22,19 @@
 
 #include <QDateTime>
 #include <QObject>
+#include <QQueue>
+
+#include "podcast.h"
 
 class Application;
-class Podcast;
 class PodcastUrlLoader;
 class PodcastUrlLoaderReply;
 
 class QTimer;
 
 // Responsible for updating podcasts when they're first subscribed to, and
-// then updating them at regular intervals afterwards.
+// then updating them at regular intervals afterwards.  Feeds are fetched with
+// conditional requests, so ones that haven't changed aren't downloaded again.
 class PodcastUpdater : public QObject {
   Q_OBJECT
 
@@ -40,6 +43,10 @@ class PodcastUpdater : public QObject {
 
   static const char* kSettingsGroup;
 
+  // Keys in Podcast::extra for the validators of the last fetched feed.
+  static const char* kEtagKey;
+  static const char* kLastModifiedKey;
+
  public slots:
   void UpdateAllPodcastsNow();
   void UpdatePodcastNow(const Podcast& podcast);
@@ -54,6 +61,13 @@ class PodcastUpdater : public QObject {
  private:
   void RestartTimer();
   void SaveSettings();
+  PodcastUrlLoaderReply* Load(const Podcast& podcast);
+  void StartNextUpdate();
+
+  // How many feeds are fetched at once during a full update.
+  static const int kMaxConcurrentUpdates;
+  // Longer descriptions in refreshed feeds are dropped.
+  static const int kMaxDescriptionLength;
 
  private:
   Application* app_;
@@ -63,7 +77,9 @@ class PodcastUpdater : public QObject {
 
   QTimer* update_timer_;
   PodcastUrlLoader* loader_;
+  // Includes the podcasts in queued_podcasts_.
   int pending_replies_;
+  QQueue<Podcast> queued_podcasts_;
 };
 
 #endif  // INTERNET_PODCASTS_PODCASTUPDATER_H_
@@ -93,6 +93,12 @@ PodcastUrlLoaderReply* PodcastUrlLoader::Load(const QString& url_text) {
 }
 
 PodcastUrlLoaderReply* PodcastUrlLoader::Load(const QUrl& url) {
+  return Load(url, QByteArray(), QByteArray(), PodcastParser::Options());
+}
+
+PodcastUrlLoaderReply* PodcastUrlLoader::Load(
+    const QUrl& url, const QByteArray& etag, const QByteArray& last_modified,
+    const PodcastParser::Options& options) {
   // Create a reply
   PodcastUrlLoaderReply* reply = new PodcastUrlLoaderReply(url, this);
 
@@ -100,6 +106,9 @@ PodcastUrlLoaderReply* PodcastUrlLoader::Load(const QUrl& url) {
   RequestState* state = new RequestState;
   state->redirects_remaining_ = kMaxRedirects + 1;
   state->reply_ = reply;
+  state->etag_ = etag;
+  state->last_modified_ = last_modified;
+  state->options_ = options;
 
   // Start the first request
   NextRequest(url, state);
@@ -125,6 +134,12 @@ void PodcastUrlLoader::NextRequest(const QUrl& url, RequestState* state) {
   QNetworkRequest req(url);
   req.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
                    QNetworkRequest::AlwaysNetwork);
+  if (!state->etag_.isEmpty()) {
+    req.setRawHeader("If-None-Match", state->etag_);
+  }
+  if (!state->last_modified_.isEmpty()) {
+    req.setRawHeader("If-Modified-Since", state->last_modified_);
+  }
   QNetworkReply* network_reply = network_->get(req);
 
   NewClosure(network_reply, SIGNAL(finished()), this,
@@ -152,6 +167,11 @@ void PodcastUrlLoader::RequestFinished(RequestState* state,
 
   const QVariant http_status =
       reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+  if (http_status.toInt() == 304) {
+    state->reply_->SetNotModified();
+    delete state;
+    return;
+  }
   if (http_status.isValid() && http_status.toInt() != 200) {
     SendErrorAndDelete(
         QString("HTTP %1: %2")
@@ -167,7 +187,9 @@ void PodcastUrlLoader::RequestFinished(RequestState* state,
   const QString content_type =
       reply->header(QNetworkRequest::ContentTypeHeader).toString();
   if (parser_->SupportsContentType(content_type)) {
-    const QVariant ret = parser_->Load(reply, reply->url());
+    state->reply_->SetValidators(reply->rawHeader("ETag"),
+                                 reply->rawHeader("Last-Modified"));
+    const QVariant ret = parser_->Load(reply, reply->url(), state->options_);
 
     if (ret.canConvert<Podcast>()) {
       state->reply_->SetFinished(PodcastList() << ret.value<Podcast>());
@@ -228,6 +250,18 @@ void PodcastUrlLoaderReply::SetFinished(const OpmlContainer& results) {
   emit Finished(true);
 }
 
+void PodcastUrlLoaderReply::SetNotModified() {
+  result_type_ = Type_NotModified;
+  finished_ = true;
+  emit Finished(true);
+}
+
+void PodcastUrlLoaderReply::SetValidators(const QByteArray& etag,
+                                          const QByteArray& last_modified) {
+  etag_ = etag;
+  last_modified_ = last_modified;
+}
+
 void PodcastUrlLoaderReply::SetFinished(const QString& error_text) {
   error_text_ = error_text;
   finished_ = true;
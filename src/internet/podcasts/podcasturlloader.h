@@ -25,8 +25,7 @@
 
 #include "opmlcontainer.h"
 #include "podcast.h"
-
-class PodcastParser;
+#include "podcastparser.h"
 
 class QNetworkAccessManager;
 class QNetworkReply;
@@ -37,7 +36,9 @@ class PodcastUrlLoaderReply : public QObject {
  public:
   PodcastUrlLoaderReply(const QUrl& url, QObject* parent);
 
-  enum ResultType { Type_Podcast, Type_Opml };
+  // Type_NotModified is only used for conditional requests, when the feed
+  // hasn't changed since it was last fetched.
+  enum ResultType { Type_Podcast, Type_Opml, Type_NotModified };
 
   const QUrl& url() const { return url_; }
   bool is_finished() const { return finished_; }
@@ -48,9 +49,16 @@ class PodcastUrlLoaderReply : public QObject {
   const PodcastList& podcast_results() const { return podcast_results_; }
   const OpmlContainer& opml_results() const { return opml_results_; }
 
+  // The validators the server sent with the feed, to give to the next
+  // conditional request.
+  const QByteArray& etag() const { return etag_; }
+  const QByteArray& last_modified() const { return last_modified_; }
+
   void SetFinished(const QString& error_text);
   void SetFinished(const PodcastList& results);
   void SetFinished(const OpmlContainer& results);
+  void SetNotModified();
+  void SetValidators(const QByteArray& etag, const QByteArray& last_modified);
 
  signals:
   void Finished(bool success);
@@ -63,6 +71,9 @@ class PodcastUrlLoaderReply : public QObject {
   ResultType result_type_;
   PodcastList podcast_results_;
   OpmlContainer opml_results_;
+
+  QByteArray etag_;
+  QByteArray last_modified_;
 };
 
 class PodcastUrlLoader : public QObject {
@@ -77,6 +88,13 @@ class PodcastUrlLoader : public QObject {
   PodcastUrlLoaderReply* Load(const QString& url_text);
   PodcastUrlLoaderReply* Load(const QUrl& url);
 
+  // Sends If-None-Match and If-Modified-Since with the request, if they're
+  // not empty, so the reply can be Type_NotModified.  The feed is parsed with
+  // options.
+  PodcastUrlLoaderReply* Load(const QUrl& url, const QByteArray& etag,
+                              const QByteArray& last_modified,
+                              const PodcastParser::Options& options);
+
   // Both the FixPodcastUrl functions replace common podcatcher URL schemes
   // like itpc:// or zune:// with their http:// equivalents.  The QString
   // overload also cleans up user-entered text a bit - stripping whitespace and
@@ -88,6 +106,10 @@ class PodcastUrlLoader : public QObject {
   struct RequestState {
     int redirects_remaining_;
     PodcastUrlLoaderReply* reply_;
+
+    QByteArray etag_;
+    QByteArray last_modified_;
+    PodcastParser::Options options_;
   };
 
   typedef QPair<QString, QString> QuickPrefix;
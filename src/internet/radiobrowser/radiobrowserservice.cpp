@@ -132,6 +132,8 @@ const char* RadioBrowserService::kSettingsGroup = "RadioBrowser";
 const char* RadioBrowserService::kSchemeName = "radiobrowser";
 const char* RadioBrowserService::defaultServer =
     "http://all.api.radio-browser.info";
+const int RadioBrowserService::kListsCacheDurationSecs =
+    60 * 60 * 24 * 7;  // 1 week
 
 RadioBrowserService::RadioBrowserService(Application* app,
                                          InternetModel* parent)
@@ -143,6 +145,19 @@ RadioBrowserService::RadioBrowserService(Application* app,
       url_handler_(new RadioBrowserUrlHandler(app, this, this)),
       homepage_url_(QUrl("https://www.radio-browser.info")),
       icon_(IconLoader::Load("radiobrowser", IconLoader::Provider)) {
+  for (const Branch& branch : BranchList) {
+    const QString name = branch.name.toLower().replace(' ', '_');
+    if (branch.type == Type_Category) {
+      category_lists_[branch.list_url].reset(new CachedList<QString>(
+          kSettingsGroup, name, kListsCacheDurationSecs));
+      category_lists_[branch.list_url]->Load();
+    } else {
+      top100_lists_[branch.items_url].reset(new CachedList<Stream>(
+          kSettingsGroup, name, kListsCacheDurationSecs));
+      top100_lists_[branch.items_url]->Load();
+    }
+  }
+
   app_->player()->RegisterUrlHandler(url_handler_);
   app_->global_search()->AddProvider(
       new RadioBrowserSearchProvider(app_, this, this));
@@ -200,17 +215,28 @@ void RadioBrowserService::RefreshCategory(QStandardItem* item) {
     return;
   }
 
-  QString determined_url = item->data(RadioBrowserService::Role_ListUrl)
-                               .toString()
-                               .arg(main_server_url_);
-  QUrl url(determined_url);
+  const QString list_url =
+      item->data(RadioBrowserService::Role_ListUrl).toString();
+  QUrl url(list_url.arg(main_server_url_));
 
-  QNetworkReply* reply = network_->get(QNetworkRequest(url));
+  // Show what we had last time straight away, even if it's old.
+  CachedList<QString>* cache = category_lists_.value(list_url).get();
+  if (cache && !cache->IsEmpty()) {
+    QStringList list = cache->Data();
+    PopulateCategory(item, list);
+    if (!cache->IsStale()) return;
+  }
+
+  QNetworkRequest req(url);
+  if (cache) cache->PrepareRequest(&req);
+  QNetworkReply* reply = network_->get(req);
   int task_id = app_->task_manager()->StartTask(tr("Getting channels"));
 
   connect(reply, &QNetworkReply::finished, [=] {
     app_->task_manager()->SetTaskFinished(task_id);
     reply->deleteLater();
+    if (cache && cache->NotModified(reply)) return;
+
     QJsonDocument document = ParseJsonReply(reply);
     if (document.isNull()) {
       LastRequestFailed();
@@ -225,6 +251,12 @@ void RadioBrowserService::RefreshCategory(QStandardItem* item) {
       list << item["name"].toString();
     }
 
+    // Don't collapse what's been opened if nothing changed.
+    if (cache) {
+      const bool changed = cache->IsEmpty() || cache->Data() != list;
+      cache->Update(list, reply);
+      if (!changed) return;
+    }
     PopulateCategory(item, list);
   });
 }
@@ -244,8 +276,9 @@ void RadioBrowserService::RefreshCategoryItem(QStandardItem* item) {
   QNetworkReply* reply = network_->get(QNetworkRequest(url));
   int task_id = app_->task_manager()->StartTask(tr("Getting channels"));
 
-  connect(reply, &QNetworkReply::finished,
-          [=] { this->RefreshStreamsFinished(reply, task_id, item); });
+  connect(reply, &QNetworkReply::finished, [=] {
+    this->RefreshStreamsFinished(reply, task_id, item, nullptr);
+  });
 }
 
 void RadioBrowserService::RefreshTop100(QStandardItem* item) {
@@ -254,16 +287,25 @@ void RadioBrowserService::RefreshTop100(QStandardItem* item) {
     return;
   }
 
-  QString determined_url = item->data(RadioBrowserService::Role_ItemsUrl)
-                               .toString()
-                               .arg(main_server_url_);
-  QUrl url(determined_url);
+  const QString items_url =
+      item->data(RadioBrowserService::Role_ItemsUrl).toString();
+  QUrl url(items_url.arg(main_server_url_));
 
-  QNetworkReply* reply = network_->get(QNetworkRequest(url));
+  CachedList<Stream>* cache = top100_lists_.value(items_url).get();
+  if (cache && !cache->IsEmpty()) {
+    StreamList list = cache->Data();
+    PopulateStreams(item, list);
+    if (!cache->IsStale()) return;
+  }
+
+  QNetworkRequest req(url);
+  if (cache) cache->PrepareRequest(&req);
+  QNetworkReply* reply = network_->get(req);
   int task_id = app_->task_manager()->StartTask(tr("Getting channels"));
 
-  connect(reply, &QNetworkReply::finished,
-          [=] { this->RefreshStreamsFinished(reply, task_id, item); });
+  connect(reply, &QNetworkReply::finished, [=] {
+    this->RefreshStreamsFinished(reply, task_id, item, cache);
+  });
 }
 
 void RadioBrowserService::ShowContextMenu(const QPoint& global_pos) {
@@ -317,9 +359,12 @@ QMenu* RadioBrowserService::GetStationMenu(QStandardItem* item) {
 
 void RadioBrowserService::RefreshStreamsFinished(QNetworkReply* reply,
                                                  int task_id,
-                                                 QStandardItem* item) {
+                                                 QStandardItem* item,
+                                                 CachedList<Stream>* cache) {
   app_->task_manager()->SetTaskFinished(task_id);
   reply->deleteLater();
+  if (cache && cache->NotModified(reply)) return;
+
   QJsonDocument document = ParseJsonReply(reply);
   if (document.isNull()) {
     LastRequestFailed();
@@ -334,6 +379,7 @@ void RadioBrowserService::RefreshStreamsFinished(QNetworkReply* reply,
     ReadStation(station, &list, url_handler_);
   }
 
+  if (cache) cache->Update(list, reply);
   PopulateStreams(item, list);
 }
 
@@ -352,6 +398,17 @@ Song RadioBrowserService::Stream::ToSong(const QString& prefix) const {
   return ret;
 }
 
+QDataStream& operator<<(QDataStream& out,
+                        const RadioBrowserService::Stream& stream) {
+  out << stream.name_ << stream.url_ << stream.favicon_;
+  return out;
+}
+
+QDataStream& operator>>(QDataStream& in, RadioBrowserService::Stream& stream) {
+  in >> stream.name_ >> stream.url_ >> stream.favicon_;
+  return in;
+}
+
 void RadioBrowserService::Homepage() {
   QDesktopServices::openUrl(homepage_url_);
 }
@@ -19,7 +19,9 @@
 #define INTERNET_RADIOBROWSER_RADIOBROWSERSERVICE_H_
 
 #include <QJsonObject>
+#include <QMap>
 #include <QMenu>
+#include <memory>
 
 #include "core/cachedlist.h"
 #include "internet/core/internetmodel.h"
@@ -66,6 +68,7 @@ class RadioBrowserService : public InternetService {
   static const char* kSettingsGroup;
   static const char* kSchemeName;
   static const char* defaultServer;
+  static const int kListsCacheDurationSecs;
 
   QString url_scheme() const { return kSchemeName; }
   QIcon icon() const { return icon_; }
@@ -95,7 +98,8 @@ class RadioBrowserService : public InternetService {
   void RefreshCategoryItem(QStandardItem* item);
   void RefreshTop100(QStandardItem* item);
   void RefreshStreamsFinished(QNetworkReply* reply, int task_id,
-                              QStandardItem* item);
+                              QStandardItem* item,
+                              CachedList<Stream>* cache);
   void Homepage();
   void ShowConfig() override;
   void AddToSavedRadio(bool checked);
@@ -117,6 +121,17 @@ class RadioBrowserService : public InternetService {
   QString main_server_url_;
   const QUrl homepage_url_;
   const QIcon icon_;
+
+  // The category and top 100 lists, by the URL they're fetched from, so
+  // they can be shown before the server answers.  The stations in each
+  // category aren't kept, there are far too many of them.
+  QMap<QString, std::shared_ptr<CachedList<QString>>> category_lists_;
+  QMap<QString, std::shared_ptr<CachedList<Stream>>> top100_lists_;
 };
 
+QDataStream& operator<<(QDataStream& out,
+                        const RadioBrowserService::Stream& stream);
+QDataStream& operator>>(QDataStream& in, RadioBrowserService::Stream& stream);
+Q_DECLARE_METATYPE(RadioBrowserService::Stream)
+
 #endif  // INTERNET_RADIOBROWSER_RADIOBROWSERSERVICE_H_
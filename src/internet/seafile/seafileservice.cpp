@@ -65,11 +65,17 @@ SeafileService::SeafileService(Application* app, InternetModel* parent)
   access_token_ = s.value("access_token").toString();
   server_ = s.value("server").toString();
 
-  QByteArray tree_bytes = s.value("tree").toByteArray();
-
-  if (!tree_bytes.isEmpty()) {
-    QDataStream stream(&tree_bytes, QIODevice::ReadOnly);
-    stream >> tree_;
+  tree_.Load(app->database());
+
+  // The tree used to be kept in the settings, all in one go
+  if (s.contains("tree")) {
+    QByteArray tree_bytes = s.value("tree").toByteArray();
+    if (!tree_bytes.isEmpty()) {
+      QDataStream stream(&tree_bytes, QIODevice::ReadOnly);
+      stream >> tree_;
+      tree_.Save();
+    }
+    s.remove("tree");
   }
 
   app->player()->RegisterUrlHandler(new SeafileUrlHandler(this, this));
@@ -96,7 +102,6 @@ void SeafileService::ForgetCredentials() {
   s.beginGroup(kSettingsGroup);
 
   s.remove("access_token");
-  s.remove("tree");
   access_token_.clear();
   tree_.Clear();
 
@@ -574,14 +579,14 @@ void SeafileService::DeleteEntry(const QString& library, const QString& path,
   QList<QPair<QString, SeafileTree::Entry>> files_to_delete;
   if (entry.is_library()) {
     SeafileTree::TreeItem* item = tree_.FindLibrary(library);
-    files_to_delete = tree_.GetRecursiveFilesOfDir("/", item);
+    files_to_delete = tree_.GetRecursiveFilesOfDir(library, "/", item);
     tree_.DeleteLibrary(library);
   } else {
     if (entry.is_dir()) {
       SeafileTree::TreeItem* item =
           tree_.FindFromAbsolutePath(library, path + entry.name() + "/");
-      files_to_delete =
-          tree_.GetRecursiveFilesOfDir(path + entry.name() + "/", item);
+      files_to_delete = tree_.GetRecursiveFilesOfDir(
+          library, path + entry.name() + "/", item);
     } else {
       files_to_delete.append(qMakePair(path, entry));
     }
@@ -666,6 +671,7 @@ void SeafileService::FinishedTaskInProgress() {
   if (indexing_task_progress_ == indexing_task_max_) {
     task_manager_->SetTaskFinished(indexing_task_id_);
     indexing_task_id_ = -1;
+    tree_.Save();
     UpdatingLibrariesFinishedSignal();
   } else {
     task_manager_->SetTaskProgress(indexing_task_id_, indexing_task_progress_,
@@ -674,13 +680,6 @@ void SeafileService::FinishedTaskInProgress() {
 }
 
 SeafileService::~SeafileService() {
-  // Save the tree !
-  QSettings s;
-  s.beginGroup(kSettingsGroup);
-
-  QByteArray tree_byte;
-  QDataStream stream(&tree_byte, QIODevice::WriteOnly);
-  stream << tree_;
-
-  s.setValue("tree", tree_byte);
+  // Save what changed since the last indexing
+  tree_.Save();
 }
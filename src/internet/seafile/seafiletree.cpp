@@ -20,17 +20,137 @@
 
 #include <QDir>
 #include <QRegExp>
+#include <QSqlQuery>
 #include <QStringList>
 
+#include "core/database.h"
 #include "core/logging.h"
+#include "core/scopedtransaction.h"
 
-SeafileTree::SeafileTree(QObject* parent) : QObject(parent) {}
+SeafileTree::SeafileTree(QObject* parent) : QObject(parent), db_(nullptr) {}
 
 SeafileTree::SeafileTree(const SeafileTree& copy, QObject* parent)
-    : QObject(parent) {
+    : QObject(parent), db_(nullptr) {
   libraries_ = copy.libraries();
 }
 
+void SeafileTree::Load(Database* db) {
+  qDeleteAll(libraries_);
+  libraries_.clear();
+  dirty_.clear();
+  deleted_.clear();
+
+  db_ = db;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase connection(db_->Connect());
+
+  QSqlQuery q(connection);
+  q.exec("SELECT library, name FROM seafile_tree WHERE path = '/'");
+  if (db_->CheckErrors(q)) return;
+
+  while (q.next()) {
+    TreeItem* library = new TreeItem(
+        Entry(q.value(1).toString(), q.value(0).toString(), Entry::LIBRARY));
+    library->set_loaded(false);
+    libraries_.append(library);
+  }
+}
+
+void SeafileTree::Save() {
+  if (!db_ || (dirty_.isEmpty() && deleted_.isEmpty())) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase connection(db_->Connect());
+  ScopedTransaction t(&connection);
+
+  // Deleted first, a directory can be deleted and then added again
+  QSqlQuery remove(connection);
+  remove.prepare(
+      "DELETE FROM seafile_tree WHERE library = :library"
+      " AND substr(path, 1, :length) = :path");
+  for (const Dir& dir : deleted_) {
+    remove.bindValue(":library", dir.first);
+    remove.bindValue(":length", dir.second.length());
+    remove.bindValue(":path", dir.second);
+    remove.exec();
+    if (db_->CheckErrors(remove)) return;
+  }
+
+  QSqlQuery write(connection);
+  write.prepare(
+      "INSERT OR REPLACE INTO seafile_tree (library, path, name, entries)"
+      " VALUES (:library, :path, :name, :entries)");
+  for (const Dir& dir : dirty_) {
+    // Gone since it changed
+    TreeItem* item = FindFromAbsolutePath(dir.first, dir.second);
+    if (!item) continue;
+
+    QByteArray entries;
+    QDataStream stream(&entries, QIODevice::WriteOnly);
+    stream << item->children_entries();
+
+    write.bindValue(":library", dir.first);
+    write.bindValue(":path", dir.second);
+    write.bindValue(":name", item->entry().is_library() ? item->entry().name()
+                                                        : QString());
+    write.bindValue(":entries", entries);
+    write.exec();
+    if (db_->CheckErrors(write)) return;
+  }
+
+  t.Commit();
+
+  dirty_.clear();
+  deleted_.clear();
+}
+
+void SeafileTree::LoadChildren(const QString& library, const QString& path,
+                               TreeItem* item) {
+  if (item->loaded()) return;
+  item->set_loaded(true);
+
+  if (!db_) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase connection(db_->Connect());
+
+  QSqlQuery q(connection);
+  q.prepare(
+      "SELECT entries FROM seafile_tree"
+      " WHERE library = :library AND path = :path");
+  q.bindValue(":library", library);
+  q.bindValue(":path", path);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return;
+
+  QByteArray bytes = q.value(0).toByteArray();
+  QDataStream stream(&bytes, QIODevice::ReadOnly);
+  Entries entries;
+  stream >> entries;
+
+  for (const Entry& entry : entries) {
+    TreeItem* child = new TreeItem(entry);
+    child->set_loaded(!entry.is_dir());
+    item->AppendChild(child);
+  }
+}
+
+void SeafileTree::MarkDirty(const QString& library, const QString& path) {
+  if (db_) dirty_.insert(qMakePair(library, path));
+}
+
+void SeafileTree::MarkAllDirty(const QString& library, const QString& path,
+                               const TreeItem* item) {
+  dirty_.insert(qMakePair(library, path));
+
+  for (TreeItem* child : item->children()) {
+    if (child->entry().is_dir()) {
+      MarkAllDirty(library, path + child->entry().name() + "/", child);
+    }
+  }
+}
+
 QList<SeafileTree::TreeItem*> SeafileTree::libraries() const {
   return libraries_;
 }
@@ -45,12 +165,14 @@ void SeafileTree::Print() const {
 
 void SeafileTree::AddLibrary(const QString& name, const QString& id) {
   libraries_.append(new TreeItem(Entry(name, id, Entry::Type::LIBRARY)));
+  MarkDirty(id, "/");
 }
 
 void SeafileTree::DeleteLibrary(const QString& id) {
   for (int i = 0; i < libraries_.size(); ++i) {
     if (libraries_.at(i)->entry().id() == id) {
-      libraries_.removeAt(i);
+      delete libraries_.takeAt(i);
+      if (db_) deleted_.insert(qMakePair(id, QString("/")));
       return;
     }
   }
@@ -73,6 +195,9 @@ bool SeafileTree::AddEntry(const QString& library, const QString& path,
 
   dir_node->AppendChild(entry);
 
+  MarkDirty(library, path);
+  if (entry.is_dir()) MarkDirty(library, path + entry.name() + "/");
+
   return true;
 }
 
@@ -146,15 +271,21 @@ SeafileTree::TreeItem* SeafileTree::FindFromAbsolutePath(const QString& library,
   }
 
   QStringList path_parts = path.split("/", QString::SkipEmptyParts);
+  QString node_path = "/";
 
   for (const QString& part : path_parts) {
+    LoadChildren(library, node_path, node_item);
     node_item = node_item->FindChild(part);
 
     if (!node_item) {
-      break;
+      return nullptr;
     }
+
+    node_path += part + "/";
   }
 
+  LoadChildren(library, node_path, node_item);
+
   return node_item;
 }
 
@@ -184,16 +315,32 @@ bool SeafileTree::DeleteEntry(const QString& library, const QString& path,
 
   delete item_entry;
 
+  MarkDirty(library, path);
+  if (db_ && entry.is_dir()) {
+    deleted_.insert(qMakePair(library, path + entry.name() + "/"));
+  }
+
   return true;
 }
 
 void SeafileTree::Clear() {
   qDeleteAll(libraries_);
   libraries_.clear();
+  dirty_.clear();
+  deleted_.clear();
+
+  if (!db_) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase connection(db_->Connect());
+
+  QSqlQuery q(connection);
+  q.exec("DELETE FROM seafile_tree");
+  db_->CheckErrors(q);
 }
 
 QList<QPair<QString, SeafileTree::Entry>> SeafileTree::GetRecursiveFilesOfDir(
-    const QString& path, const TreeItem* item) {
+    const QString& library, const QString& path, TreeItem* item) {
   // key = path, value = entry
   QList<QPair<QString, Entry>> files;
 
@@ -205,12 +352,15 @@ QList<QPair<QString, SeafileTree::Entry>> SeafileTree::GetRecursiveFilesOfDir(
     files.append(qMakePair(path, item->entry()));
     // Get files of the dir
   } else {
+    LoadChildren(library, path, item);
+
     for (TreeItem* child_item : item->children()) {
       if (child_item->entry().is_file()) {
         files.append(qMakePair(path, child_item->entry()));
       } else {
         QString name = child_item->entry().name() + "/";
-        files.append(GetRecursiveFilesOfDir(path + name, child_item));
+        files.append(
+            GetRecursiveFilesOfDir(library, path + name, child_item));
       }
     }
   }
@@ -301,6 +451,8 @@ QList<SeafileTree::TreeItem*> SeafileTree::TreeItem::children() const {
 }
 SeafileTree::Entry SeafileTree::TreeItem::entry() const { return entry_; }
 void SeafileTree::TreeItem::set_entry(const Entry& entry) { entry_ = entry; }
+bool SeafileTree::TreeItem::loaded() const { return loaded_; }
+void SeafileTree::TreeItem::set_loaded(bool loaded) { loaded_ = loaded; }
 void SeafileTree::TreeItem::set_children(const QList<TreeItem*>& children) {
   children_ = children;
 }
@@ -389,7 +541,15 @@ QDataStream& operator<<(QDataStream& out, const SeafileTree& tree) {
 }
 
 QDataStream& operator>>(QDataStream& in, SeafileTree& tree) {
+  qDeleteAll(tree.libraries_);
   in >> tree.libraries_;
 
+  // None of this is in the database yet
+  if (tree.db_) {
+    for (SeafileTree::TreeItem* library : tree.libraries_) {
+      tree.MarkAllDirty(library->entry().id(), "/", library);
+    }
+  }
+
   return in;
 }
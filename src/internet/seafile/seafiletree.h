@@ -26,12 +26,20 @@
 #include <QList>
 #include <QObject>
 #include <QPair>
+#include <QSet>
 #include <QString>
 
 #include "internet/core/cloudfileservice.h"
 
+class Database;
+
 // Reproduce the file system of Seafile server libraries
 // Analog to a tree
+//
+// The tree is kept in the database with one row per directory, holding the
+// directory's entries.  Only the libraries are read by Load, each directory is
+// read the first time something looks inside it, and Save only writes the
+// directories that changed.
 class SeafileTree : public QObject {
   Q_OBJECT
 
@@ -88,9 +96,11 @@ class SeafileTree : public QObject {
    public:
     TreeItem(const Entry& entry = Entry(),
              const QList<TreeItem*>& children = QList<TreeItem*>())
-        : entry_(entry), children_(children) {}
+        : entry_(entry), children_(children), loaded_(true) {}
     TreeItem(const TreeItem& copy)
-        : entry_(copy.entry()), children_(copy.children()) {}
+        : entry_(copy.entry()),
+          children_(copy.children()),
+          loaded_(copy.loaded()) {}
     ~TreeItem();
 
     TreeItem* child(int i) const;
@@ -103,6 +113,10 @@ class SeafileTree : public QObject {
     Entry entry() const;
     void set_entry(const Entry& entry);
 
+    // False if the children are still in the database
+    bool loaded() const;
+    void set_loaded(bool loaded);
+
     void AppendChild(TreeItem* child);
     void AppendChild(const Entry& entry);
 
@@ -118,6 +132,7 @@ class SeafileTree : public QObject {
    private:
     Entry entry_;
     QList<TreeItem*> children_;
+    bool loaded_;
 
     friend QDataStream& operator<<(QDataStream& out,
                                    SeafileTree::TreeItem* item);
@@ -125,6 +140,12 @@ class SeafileTree : public QObject {
                                    SeafileTree::TreeItem*& item);
   };
 
+  // Forgets the tree in memory and reads the libraries from db.  The tree is
+  // kept there from now on.
+  void Load(Database* db);
+  // Writes the directories that changed since the last save
+  void Save();
+
   QList<TreeItem*> libraries() const;
 
   void AddLibrary(const QString& name, const QString& id);
@@ -137,7 +158,7 @@ class SeafileTree : public QObject {
   // Get a list of pair (path, entry) corresponding to the subfiles (and
   // recursively to the subsubfiles...) of the given item
   QList<QPair<QString, SeafileTree::Entry>> GetRecursiveFilesOfDir(
-      const QString& path, const TreeItem* item);
+      const QString& library, const QString& path, TreeItem* item);
 
   // nullptr if we didn't find the library with the given id
   TreeItem* FindLibrary(const QString& library);
@@ -149,7 +170,7 @@ class SeafileTree : public QObject {
   void CheckEntries(const Entries& server_entries, const Entry& library,
                     const QString& path);
 
-  // Destroy the tree
+  // Destroy the tree, in the database too
   void Clear();
 
   // Print the tree in the debug log
@@ -167,8 +188,26 @@ class SeafileTree : public QObject {
                 const SeafileTree::Entry& entry);
 
  private:
+  // key : library, value : path
+  typedef QPair<QString, QString> Dir;
+
+  // Reads the children of item from the database if they aren't there yet
+  void LoadChildren(const QString& library, const QString& path,
+                    TreeItem* item);
+  void MarkDirty(const QString& library, const QString& path);
+  // Marks item and every directory under it, for trees that didn't come from
+  // the database
+  void MarkAllDirty(const QString& library, const QString& path,
+                    const TreeItem* item);
+
   QList<TreeItem*> libraries_;
 
+  Database* db_;
+  // Directories to write, and directories to remove with everything under
+  // them, on the next save.
+  QSet<Dir> dirty_;
+  QSet<Dir> deleted_;
+
   friend QDataStream& operator<<(QDataStream& out, const SeafileTree& tree);
   friend QDataStream& operator>>(QDataStream& in, SeafileTree& tree);
 };
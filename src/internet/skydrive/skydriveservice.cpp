@@ -54,6 +54,12 @@ static const char* kOAuthScope =
 static const char* kGraphUserInfo = "https://graph.microsoft.com/v1.0/me";
 static const char* kDriveBase = "https://graph.microsoft.com/v1.0/me/drive/";
 
+// The delta's next links keep these, so they're only given to the first page.
+static const int kDeltaPageSize = 1000;
+static const char* kDeltaFields =
+    "id,name,file,folder,deleted,size,createdDateTime,lastModifiedDateTime,"
+    "description";
+
 }  // namespace
 
 const char* SkydriveService::kServiceName = "OneDrive";
@@ -141,10 +147,27 @@ void SkydriveService::FetchUserInfoFinished(QNetworkReply* reply) {
   ListFiles();
 }
 
-void SkydriveService::ListFiles() { ListFiles("root"); }
+void SkydriveService::ListFiles() {
+  // The cursor is the delta link from the end of the last sync, which only
+  // returns what changed since then.
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  const QString cursor = s.value("cursor").toString();
+
+  if (!cursor.isEmpty()) {
+    ListChanges(QUrl(cursor));
+    return;
+  }
+
+  QUrl url(QString(kDriveBase) + "root/delta");
+  QUrlQuery url_query;
+  url_query.addQueryItem("$top", QString::number(kDeltaPageSize));
+  url_query.addQueryItem("$select", kDeltaFields);
+  url.setQuery(url_query);
+  ListChanges(url);
+}
 
-void SkydriveService::ListFiles(const QString& folder) {
-  QUrl url(QString(kDriveBase) + folder + "/children");
+void SkydriveService::ListChanges(const QUrl& url) {
   QNetworkRequest request(url);
   AddAuthorizationHeader(&request);
 
@@ -156,11 +179,27 @@ void SkydriveService::ListFiles(const QString& folder) {
 void SkydriveService::ListFilesFinished(QNetworkReply* reply) {
   reply->deleteLater();
 
+  if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() ==
+      410) {
+    // The delta link has expired, so everything has to be fetched again.
+    qLog(Debug) << "OneDrive delta link expired, starting again";
+    QSettings s;
+    s.beginGroup(kSettingsGroup);
+    s.remove("cursor");
+    ListFiles();
+    return;
+  }
+
   QJsonDocument document = ParseJsonReply(reply);
   if (document.isNull()) return;
 
   QJsonObject json_response = document.object();
 
+  // Ask for the next page now so it downloads while this one is handled.
+  if (json_response.contains("@odata.nextLink")) {
+    ListChanges(QUrl(json_response["@odata.nextLink"].toString()));
+  }
+
   QJsonArray items = json_response["value"].toArray();
   for (const QJsonValue& f : items) {
     QJsonObject item = f.toObject();
@@ -168,8 +207,17 @@ void SkydriveService::ListFilesFinished(QNetworkReply* reply) {
     const QString id = item["id"].toString();
     const QString name = item["name"].toString();
 
-    if (item.contains("folder")) {
-      ListFiles(QString("items/%1").arg(id));
+    if (item.contains("deleted")) {
+      QUrl url;
+      url.setScheme(GetScheme());
+      url.setPath("/" + id);
+      Song song = library_backend_->GetSongByUrl(url);
+      if (song.is_valid()) {
+        qLog(Debug) << "Deleting:" << url << song.title();
+        library_backend_->DeleteSongs(SongList() << song);
+      }
+    } else if (item.contains("folder")) {
+      // The delta covers the whole drive, folders included.
     } else if (item.contains("file")) {
       // The response provides a mime type, but it doesn't know about some
       // types that we care about.
@@ -197,6 +245,11 @@ void SkydriveService::ListFilesFinished(QNetworkReply* reply) {
       qLog(Debug) << "Unknown item type for" << name;
     }
   }
+
+  if (json_response.contains("@odata.deltaLink")) {
+    SaveCursorWhenIndexed(kSettingsGroup,
+                          json_response["@odata.deltaLink"].toString());
+  }
 }
 
 QUrl SkydriveService::ItemUrl(const QString& id, const QString& path) {
@@ -244,6 +297,10 @@ void SkydriveService::ForgetCredentials() {
 }
 
 void SkydriveService::DoFullRescan() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.remove("cursor");
+
   library_backend_->DeleteAll();
   ListFiles();
 }
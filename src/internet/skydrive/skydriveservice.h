@@ -63,7 +63,7 @@ class SkydriveService : public CloudFileService {
   void AddAuthorizationHeader(QNetworkRequest* request);
   void FetchUserInfo();
   void ListFiles();
-  void ListFiles(const QString& folder);
+  void ListChanges(const QUrl& url);
   void EnsureConnected();
   QUrl ItemUrl(const QString& id, const QString& path);
   void DoFullRescan() override;
@@ -62,6 +62,7 @@ SomaFMServiceBase::SomaFMServiceBase(Application* app, InternetModel* parent,
       root_(nullptr),
       network_(new NetworkAccessManager(this)),
       streams_(name, "streams", kStreamsCacheDurationSecs),
+      refreshing_(false),
       name_(name),
       channel_list_url_(channel_list_url),
       homepage_url_(homepage_url),
@@ -115,7 +116,12 @@ void SomaFMServiceBase::ShowContextMenu(const QPoint& global_pos) {
 }
 
 void SomaFMServiceBase::ForceRefreshStreams() {
-  QNetworkReply* reply = network_->get(QNetworkRequest(channel_list_url_));
+  if (refreshing_) return;
+  refreshing_ = true;
+
+  QNetworkRequest req(channel_list_url_);
+  streams_.PrepareRequest(&req);
+  QNetworkReply* reply = network_->get(req);
   int task_id = app_->task_manager()->StartTask(tr("Getting channels"));
 
   NewClosure(reply, SIGNAL(finished()), this,
@@ -126,6 +132,7 @@ void SomaFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
                                                int task_id) {
   app_->task_manager()->SetTaskFinished(task_id);
   reply->deleteLater();
+  refreshing_ = false;
 
   if (reply->error() != QNetworkReply::NoError) {
     // TODO(David Sansome): Error handling
@@ -133,6 +140,9 @@ void SomaFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
     return;
   }
 
+  // The list we already have is still right.
+  if (streams_.NotModified(reply)) return;
+
   StreamList list;
 
   QXmlStreamReader reader(reply);
@@ -145,7 +155,7 @@ void SomaFMServiceBase::RefreshStreamsFinished(QNetworkReply* reply,
     }
   }
 
-  streams_.Update(list);
+  streams_.Update(list, reply);
   streams_.Sort();
 
   // Only update the item's children if it's already been populated
@@ -220,11 +230,10 @@ SomaFMServiceBase::StreamList SomaFMServiceBase::Streams() {
 }
 
 void SomaFMServiceBase::RefreshStreams() {
-  if (IsStreamListStale()) {
-    ForceRefreshStreams();
-    return;
-  }
+  // Show what we had last time straight away, even if it's old, and replace
+  // it when the new list comes in.
   PopulateStreams();
+  if (IsStreamListStale()) ForceRefreshStreams();
 }
 
 void SomaFMServiceBase::PopulateStreams() {
@@ -259,8 +268,10 @@ void SomaFMServiceBase::ReloadSettings() {
   streams_.Sort();
 }
 
+const char* SomaFMService::kServiceName = "SomaFM";
+
 SomaFMService::SomaFMService(Application* app, InternetModel* parent)
-    : SomaFMServiceBase(app, parent, "SomaFM",
+    : SomaFMServiceBase(app, parent, kServiceName,
                         QUrl("https://somafm.com/channels.xml"),
                         QUrl("https://somafm.com"), QUrl(),
                         IconLoader::Load("somafm", IconLoader::Provider)) {}
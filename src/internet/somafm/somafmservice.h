@@ -95,6 +95,7 @@ class SomaFMServiceBase : public InternetService {
   QNetworkAccessManager* network_;
 
   CachedList<Stream> streams_;
+  bool refreshing_;
 
   const QString name_;
   const QUrl channel_list_url_;
@@ -106,6 +107,8 @@ class SomaFMServiceBase : public InternetService {
 class SomaFMService : public SomaFMServiceBase {
  public:
   SomaFMService(Application* app, InternetModel* parent);
+
+  static const char* kServiceName;
 };
 
 QDataStream& operator<<(QDataStream& out, const SomaFMService::Stream& stream);
@@ -22,10 +22,14 @@
 
 #include "subsonicservice.h"
 
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
 #include <QMenu>
 #include <QNetworkAccessManager>
 #include <QNetworkCookieJar>
 #include <QNetworkReply>
+#include <QSettings>
 #include <QSortFilterProxyModel>
 #include <QSslConfiguration>
 #include <QUrlQuery>
@@ -414,11 +418,23 @@ void SubsonicService::UpdateServer(const QString& server) {
 
 const int SubsonicLibraryScanner::kAlbumChunkSize = 500;
 const int SubsonicLibraryScanner::kConcurrentRequests = 8;
+const int SubsonicLibraryScanner::kMaxConcurrentRequests = 32;
 const int SubsonicLibraryScanner::kCoverArtSize = 1024;
 
+namespace {
+
+const quint32 kCacheMagic = 0x53534143;  // "SSAC"
+const quint32 kCacheVersion = 1;
+
+}  // namespace
+
 SubsonicLibraryScanner::SubsonicLibraryScanner(SubsonicService* service,
                                                QObject* parent)
-    : QObject(parent), service_(service), scanning_(false) {}
+    : QObject(parent),
+      service_(service),
+      scanning_(false),
+      concurrent_requests_(kConcurrentRequests),
+      cached_album_count_(0) {}
 
 SubsonicLibraryScanner::~SubsonicLibraryScanner() {}
 
@@ -427,9 +443,19 @@ void SubsonicLibraryScanner::Scan() {
     return;
   }
 
+  QSettings s;
+  s.beginGroup(SubsonicService::kSettingsGroup);
+  concurrent_requests_ =
+      qBound(1, s.value("concurrent_requests", kConcurrentRequests).toInt(),
+             kMaxConcurrentRequests);
+
   album_queue_.clear();
   pending_requests_.clear();
   songs_.clear();
+  new_cache_.clear();
+  cached_album_count_ = 0;
+  LoadCache();
+
   scanning_ = true;
   GetAlbumList(0);
 }
@@ -479,9 +505,29 @@ void SubsonicLibraryScanner::OnGetAlbumListFinished(QNetworkReply* reply,
         return;
       }
 
-      album_queue_ << reader.attributes().value("id").toString();
+      // There's no modification time for albums in the API, but adding or
+      // removing songs changes the count and duration.  Some servers send a
+      // "changed" time as well.
+      const QXmlStreamAttributes attributes = reader.attributes();
+      Album album;
+      album.id_ = attributes.value("id").toString();
+      album.stamp_ = QStringList({attributes.value("changed").toString(),
+                                  attributes.value("created").toString(),
+                                  attributes.value("songCount").toString(),
+                                  attributes.value("duration").toString()})
+                         .join("/");
       albums_added++;
       reader.skipCurrentElement();
+
+      AlbumCache::const_iterator it = cache_.constFind(album.id_);
+      QString error;
+      if (it != cache_.constEnd() && it->stamp_ == album.stamp_ &&
+          ReadAlbum(qUncompress(it->response_), &error)) {
+        new_cache_[album.id_] = *it;
+        cached_album_count_++;
+        continue;
+      }
+      album_queue_ << album;
     }
   }
 
@@ -489,14 +535,14 @@ void SubsonicLibraryScanner::OnGetAlbumListFinished(QNetworkReply* reply,
     // Non-empty reply means potentially more albums to fetch
     GetAlbumList(offset + kAlbumChunkSize);
   } else if (album_queue_.empty()) {
-    // Empty reply and no albums means an empty Subsonic server
-    scanning_ = false;
-    emit ScanFinished();
+    // Empty reply and nothing to fetch means an empty Subsonic server, or
+    // nothing's changed
+    FinishScan();
   } else {
     // Empty reply but we have some albums, time to start fetching songs
     // Start up the maximum number of concurrent requests, finished requests get
     // replaced with new ones
-    for (int i = 0; i < kConcurrentRequests && !album_queue_.empty(); ++i) {
+    for (int i = 0; i < concurrent_requests_ && !album_queue_.empty(); ++i) {
       GetAlbum(album_queue_.dequeue());
     }
   }
@@ -504,31 +550,59 @@ void SubsonicLibraryScanner::OnGetAlbumListFinished(QNetworkReply* reply,
 
 void SubsonicLibraryScanner::OnGetAlbumFinished(QNetworkReply* reply) {
   reply->deleteLater();
-  pending_requests_.remove(reply);
+  const Album album = pending_requests_.take(reply);
 
-  QXmlStreamReader reader(reply);
+  const QByteArray response = reply->readAll();
+  QString error;
+  if (!ReadAlbum(response, &error)) {
+    if (!error.isEmpty()) {
+      ParsingError(error);
+      return;
+    }
+  } else {
+    CachedAlbum cached;
+    cached.stamp_ = album.stamp_;
+    cached.response_ = qCompress(response);
+    new_cache_[album.id_] = cached;
+  }
+
+  // Start the next request if albums remain
+  if (!album_queue_.empty()) {
+    GetAlbum(album_queue_.dequeue());
+  }
+
+  // If this was the last response, we're done!
+  if (album_queue_.empty() && pending_requests_.empty()) {
+    FinishScan();
+  }
+}
+
+bool SubsonicLibraryScanner::ReadAlbum(const QByteArray& response,
+                                       QString* error) {
+  QXmlStreamReader reader(response);
   reader.readNextStartElement();
 
   if (reader.name() != "subsonic-response") {
-    ParsingError("Not a subsonic-response. Aborting scan.");
-    return;
+    *error = "Not a subsonic-response. Aborting scan.";
+    return false;
   }
 
   if (reader.attributes().value("status") != "ok") {
     // TODO(Alan Briolat): error handling
-    return;
+    return false;
   }
 
   // Read album information
   reader.readNextStartElement();
   if (reader.name() != "album") {
-    ParsingError("album tag expected. Aborting scan.");
-    return;
+    *error = "album tag expected. Aborting scan.";
+    return false;
   }
 
   QString album_artist = reader.attributes().value("artist").toString();
 
   // Read song information
+  SongList songs;
   while (reader.readNextStartElement()) {
     // skip multi-artist and multi-genre tags
     if ((reader.name() == "artists") || (reader.name() == "genres")) {
@@ -536,27 +610,19 @@ void SubsonicLibraryScanner::OnGetAlbumFinished(QNetworkReply* reply) {
       continue;
     }
     if (reader.name() != "song") {
-      ParsingError("song tag expected. Aborting scan.");
-      return;
+      *error = "song tag expected. Aborting scan.";
+      return false;
     }
 
     Song song = service_->ReadSong(reader);
     song.set_albumartist(album_artist);
 
-    songs_ << song;
+    songs << song;
     reader.skipCurrentElement();
   }
 
-  // Start the next request if albums remain
-  if (!album_queue_.empty()) {
-    GetAlbum(album_queue_.dequeue());
-  }
-
-  // If this was the last response, we're done!
-  if (album_queue_.empty() && pending_requests_.empty()) {
-    scanning_ = false;
-    emit ScanFinished();
-  }
+  songs_ << songs;
+  return true;
 }
 
 void SubsonicLibraryScanner::GetAlbumList(int offset) {
@@ -571,10 +637,10 @@ void SubsonicLibraryScanner::GetAlbumList(int offset) {
              SLOT(OnGetAlbumListFinished(QNetworkReply*, int)), reply, offset);
 }
 
-void SubsonicLibraryScanner::GetAlbum(const QString& id) {
+void SubsonicLibraryScanner::GetAlbum(const Album& album) {
   QUrl url = service_->BuildRequestUrl("getAlbum");
   QUrlQuery url_query(url.query());
-  url_query.addQueryItem("id", id);
+  url_query.addQueryItem("id", album.id_);
   if (service_->IsAmpache()) {
     url_query.addQueryItem("ampache", "1");
   }
@@ -582,7 +648,7 @@ void SubsonicLibraryScanner::GetAlbum(const QString& id) {
   QNetworkReply* reply = service_->Send(url);
   NewClosure(reply, SIGNAL(finished()), this,
              SLOT(OnGetAlbumFinished(QNetworkReply*)), reply);
-  pending_requests_.insert(reply);
+  pending_requests_.insert(reply, album);
 }
 
 void SubsonicLibraryScanner::ParsingError(const QString& message) {
@@ -591,6 +657,79 @@ void SubsonicLibraryScanner::ParsingError(const QString& message) {
   emit ScanFinished();
 }
 
+void SubsonicLibraryScanner::FinishScan() {
+  qLog(Info) << "Subsonic scan fetched"
+             << new_cache_.count() - cached_album_count_ << "albums,"
+             << cached_album_count_ << "were unchanged";
+
+  // Albums that weren't listed this time have gone from the server.
+  cache_ = new_cache_;
+  new_cache_.clear();
+  SaveCache();
+
+  scanning_ = false;
+  emit ScanFinished();
+}
+
+QString SubsonicLibraryScanner::CacheFilename() {
+  return Utilities::GetConfigPath(Utilities::Path_CacheRoot) +
+         "/subsonicalbums";
+}
+
+QString SubsonicLibraryScanner::CacheServer() {
+  QSettings s;
+  s.beginGroup(SubsonicService::kSettingsGroup);
+  return s.value("username").toString() + "@" +
+         s.value("server").toString();
+}
+
+void SubsonicLibraryScanner::LoadCache() {
+  cache_.clear();
+
+  QFile file(CacheFilename());
+  if (!file.open(QIODevice::ReadOnly)) return;
+
+  QDataStream s(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  QString server;
+  qint32 count = 0;
+  s >> magic >> version;
+  if (magic != kCacheMagic || version != kCacheVersion) return;
+  s >> server >> count;
+  if (server != CacheServer()) return;
+
+  for (int i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+    QString id;
+    CachedAlbum album;
+    s >> id >> album.stamp_ >> album.response_;
+    cache_[id] = album;
+  }
+
+  if (s.status() != QDataStream::Ok) {
+    qLog(Warning) << "Subsonic album cache is corrupt";
+    cache_.clear();
+  }
+}
+
+void SubsonicLibraryScanner::SaveCache() const {
+  QDir().mkpath(Utilities::GetConfigPath(Utilities::Path_CacheRoot));
+
+  QFile file(CacheFilename());
+  if (!file.open(QIODevice::WriteOnly)) {
+    qLog(Warning) << "Couldn't save the Subsonic album cache to"
+                  << file.fileName();
+    return;
+  }
+
+  QDataStream s(&file);
+  s << kCacheMagic << kCacheVersion << CacheServer() << qint32(cache_.count());
+  for (AlbumCache::const_iterator it = cache_.constBegin();
+       it != cache_.constEnd(); ++it) {
+    s << it.key() << it->stamp_ << it->response_;
+  }
+}
+
 Song SubsonicService::ReadSong(QXmlStreamReader& reader) {
   Song song;
   QString id = reader.attributes().value("id").toString();
@@ -22,6 +22,7 @@
 #ifndef INTERNET_SUBSONIC_SUBSONICSERVICE_H_
 #define INTERNET_SUBSONIC_SUBSONICSERVICE_H_
 
+#include <QHash>
 #include <QQueue>
 #include <memory>
 
@@ -190,7 +191,10 @@ class SubsonicLibraryScanner : public QObject {
   const SongList& GetSongs() const { return songs_; }
 
   static const int kAlbumChunkSize;
+  // The default number of albums fetched at once, see concurrent_requests in
+  // the settings.
   static const int kConcurrentRequests;
+  static const int kMaxConcurrentRequests;
   static const int kCoverArtSize;
 
  signals:
@@ -199,19 +203,48 @@ class SubsonicLibraryScanner : public QObject {
  private slots:
   // Step 1: use getAlbumList2 type=alphabeticalByName to list all albums
   void OnGetAlbumListFinished(QNetworkReply* reply, int offset);
-  // Step 2: use getAlbum id=? to list all songs for each album
+  // Step 2: use getAlbum id=? to list all songs for each album, unless the
+  // album hasn't changed since it was cached
   void OnGetAlbumFinished(QNetworkReply* reply);
 
  private:
+  struct Album {
+    QString id_;
+    // Changes when the album does, made from what getAlbumList2 tells us.
+    QString stamp_;
+  };
+
+  struct CachedAlbum {
+    QString stamp_;
+    QByteArray response_;  // qCompressed getAlbum response
+  };
+  typedef QHash<QString, CachedAlbum> AlbumCache;
+
   void GetAlbumList(int offset);
-  void GetAlbum(const QString& id);
+  void GetAlbum(const Album& album);
+  // Adds the album's songs to songs_, returns false if the response isn't
+  // one.
+  bool ReadAlbum(const QByteArray& response, QString* error);
   void ParsingError(const QString& message);
+  void FinishScan();
+
+  static QString CacheFilename();
+  // Identifies the server and user the cache is for.
+  static QString CacheServer();
+  void LoadCache();
+  void SaveCache() const;
 
   SubsonicService* service_;
   bool scanning_;
-  QQueue<QString> album_queue_;
-  QSet<QNetworkReply*> pending_requests_;
+  int concurrent_requests_;
+  QQueue<Album> album_queue_;
+  QHash<QNetworkReply*, Album> pending_requests_;
   SongList songs_;
+
+  // What was cached at the end of the last scan, and what this one's seen.
+  AlbumCache cache_;
+  AlbumCache new_cache_;
+  int cached_album_count_;
 };
 
 #endif  // INTERNET_SUBSONIC_SUBSONICSERVICE_H_
@@ -65,6 +65,10 @@ void SubsonicSettingsPage::Load() {
   ui_->password->setText(s.value("password").toString());
   ui_->usesslv3->setChecked(s.value("usesslv3").toBool());
   ui_->verifycert->setChecked(s.value("verifycert", true).toBool());
+  ui_->concurrent_requests->setValue(
+      s.value("concurrent_requests",
+              SubsonicLibraryScanner::kConcurrentRequests)
+          .toInt());
 
   // If the settings are complete, SubsonicService will have used them already
   // and
@@ -83,6 +87,7 @@ void SubsonicSettingsPage::Save() {
   s.setValue("password", ui_->password->text());
   s.setValue("usesslv3", ui_->usesslv3->isChecked());
   s.setValue("verifycert", ui_->verifycert->isChecked());
+  s.setValue("concurrent_requests", ui_->concurrent_requests->value());
 }
 
 void SubsonicSettingsPage::LoginStateChanged(
@@ -0,0 +1,214 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "albumiconatlas.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <cstring>
+
+#include "core/logging.h"
+
+const int AlbumIconAtlas::kInitialTiles = 256;
+const quint32 AlbumIconAtlas::kMagic = 0x434c4154;  // "CLAT"
+const quint32 AlbumIconAtlas::kVersion = 1;
+
+AlbumIconAtlas::AlbumIconAtlas(const QString& filename, int tile_size,
+                               int max_tiles)
+    : tile_size_(tile_size),
+      max_tiles_(max_tiles),
+      file_(filename),
+      index_filename_(filename + ".index"),
+      data_(nullptr),
+      capacity_(0),
+      next_slot_(0),
+      index_dirty_(false) {
+  if (!Open()) {
+    qLog(Warning) << "Couldn't open album icon atlas" << filename;
+    return;
+  }
+  LoadIndex();
+}
+
+AlbumIconAtlas::~AlbumIconAtlas() {
+  if (index_dirty_) SaveIndex();
+  if (data_) file_.unmap(data_);
+}
+
+bool AlbumIconAtlas::Open() {
+  QDir().mkpath(QFileInfo(file_.fileName()).path());
+  if (!file_.open(QIODevice::ReadWrite)) return false;
+
+  Header header;
+  if (file_.read(reinterpret_cast<char*>(&header), sizeof(header)) ==
+          sizeof(header) &&
+      header.magic == kMagic && header.version == kVersion &&
+      int(header.tile_size) == tile_size_ &&
+      int(header.capacity) <= max_tiles_ &&
+      file_.size() ==
+          qint64(sizeof(Header)) + qint64(header.capacity) * tile_bytes()) {
+    data_ = file_.map(0, file_.size());
+    if (data_) {
+      capacity_ = header.capacity;
+      return true;
+    }
+  }
+
+  // The file is new, from an older version or was cut short - start again.
+  Reset();
+  return data_ != nullptr;
+}
+
+bool AlbumIconAtlas::Resize(int capacity) {
+  if (data_) {
+    file_.unmap(data_);
+    data_ = nullptr;
+  }
+
+  const qint64 size = qint64(sizeof(Header)) + qint64(capacity) * tile_bytes();
+  if (!file_.resize(size)) return false;
+
+  data_ = file_.map(0, size);
+  if (!data_) return false;
+
+  capacity_ = capacity;
+
+  Header* header = reinterpret_cast<Header*>(data_);
+  header->magic = kMagic;
+  header->version = kVersion;
+  header->tile_size = tile_size_;
+  header->capacity = capacity_;
+  return true;
+}
+
+void AlbumIconAtlas::Reset() {
+  slot_keys_.clear();
+  slots_.clear();
+  free_slots_.clear();
+  next_slot_ = 0;
+  index_dirty_ = true;
+
+  QFile::remove(index_filename_);
+  Resize(qMin(kInitialTiles, max_tiles_));
+}
+
+void AlbumIconAtlas::LoadIndex() {
+  QFile file(index_filename_);
+  if (!file.open(QIODevice::ReadOnly)) return;
+
+  QDataStream s(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint32 next_slot = 0;
+  QStringList slot_keys;
+  s >> magic >> version >> next_slot >> slot_keys;
+
+  if (s.status() != QDataStream::Ok || magic != kMagic ||
+      version != kVersion || slot_keys.count() > capacity_ ||
+      next_slot < 0 || next_slot >= qMax(1, capacity_)) {
+    qLog(Warning) << "Ignoring invalid album icon atlas index"
+                  << index_filename_;
+    return;
+  }
+
+  slot_keys_ = slot_keys;
+  next_slot_ = next_slot;
+  for (int i = 0; i < slot_keys_.count(); ++i) {
+    if (slot_keys_[i].isEmpty())
+      free_slots_ << i;
+    else
+      slots_[slot_keys_[i]] = i;
+  }
+}
+
+void AlbumIconAtlas::SaveIndex() const {
+  QSaveFile file(index_filename_);
+  if (!file.open(QIODevice::WriteOnly)) return;
+
+  QDataStream s(&file);
+  s << kMagic << kVersion << qint32(next_slot_) << slot_keys_;
+  file.commit();
+}
+
+QImage AlbumIconAtlas::Lookup(const QString& key) const {
+  const int slot = slots_.value(key, -1);
+  if (slot == -1 || !data_) return QImage();
+
+  // Copy the pixels so the image stays valid if the file gets remapped.
+  return QImage(tile(slot), tile_size_, tile_size_, tile_size_ * 4,
+                QImage::Format_ARGB32_Premultiplied)
+      .copy();
+}
+
+void AlbumIconAtlas::Insert(const QString& key, const QImage& image) {
+  if (!data_ || image.isNull()) return;
+
+  int slot = slots_.value(key, -1);
+  if (slot == -1) {
+    if (!free_slots_.isEmpty()) {
+      slot = free_slots_.takeLast();
+    } else if (slot_keys_.count() < capacity_ ||
+               (capacity_ < max_tiles_ &&
+                Resize(qMin(capacity_ * 2, max_tiles_)))) {
+      slot = slot_keys_.count();
+      slot_keys_ << QString();
+    } else if (data_ && capacity_ > 0) {
+      // Full - overwrite the oldest tile.
+      slot = next_slot_;
+      next_slot_ = (next_slot_ + 1) % capacity_;
+      slots_.remove(slot_keys_[slot]);
+    } else {
+      return;
+    }
+
+    slot_keys_[slot] = key;
+    slots_[key] = slot;
+    index_dirty_ = true;
+  }
+
+  // Tiles are always square, so pad anything that isn't.
+  QImage tile_image(tile_size_, tile_size_,
+                    QImage::Format_ARGB32_Premultiplied);
+  tile_image.fill(Qt::transparent);
+  {
+    const QImage scaled =
+        image.scaled(tile_size_, tile_size_, Qt::KeepAspectRatio,
+                     Qt::SmoothTransformation);
+    QPainter p(&tile_image);
+    p.drawImage((tile_size_ - scaled.width()) / 2,
+                (tile_size_ - scaled.height()) / 2, scaled);
+  }
+
+  uchar* dest = tile(slot);
+  for (int y = 0; y < tile_size_; ++y) {
+    memcpy(dest + y * tile_size_ * 4, tile_image.constScanLine(y),
+           tile_size_ * 4);
+  }
+}
+
+void AlbumIconAtlas::Remove(const QString& key) {
+  const int slot = slots_.value(key, -1);
+  if (slot == -1) return;
+
+  slots_.remove(key);
+  slot_keys_[slot] = QString();
+  free_slots_ << slot;
+  index_dirty_ = true;
+}
@@ -0,0 +1,83 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBRARY_ALBUMICONATLAS_H_
+#define LIBRARY_ALBUMICONATLAS_H_
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+// A persistent store of small, square album icons.  All the icons live as raw
+// ARGB32 tiles in one memory-mapped file, so loading an icon after a restart
+// costs a page fault instead of decoding the original cover.  The key of each
+// tile is kept in a small index file next to it.  Once the atlas is full the
+// oldest tiles are overwritten.
+class AlbumIconAtlas {
+ public:
+  AlbumIconAtlas(const QString& filename, int tile_size, int max_tiles);
+  ~AlbumIconAtlas();
+
+  static const int kInitialTiles;
+
+  // Returns a null image if the key isn't in the atlas.
+  QImage Lookup(const QString& key) const;
+  void Insert(const QString& key, const QImage& image);
+  void Remove(const QString& key);
+
+ private:
+  struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 tile_size;
+    quint32 capacity;
+  };
+
+  static const quint32 kMagic;
+  static const quint32 kVersion;
+
+  int tile_bytes() const { return tile_size_ * tile_size_ * 4; }
+  uchar* tile(int slot) const {
+    return data_ + sizeof(Header) + qint64(slot) * tile_bytes();
+  }
+
+  bool Open();
+  bool Resize(int capacity);
+  void Reset();
+  void LoadIndex();
+  void SaveIndex() const;
+
+  const int tile_size_;
+  const int max_tiles_;
+
+  QFile file_;
+  QString index_filename_;
+  uchar* data_;
+  int capacity_;
+
+  // The key stored in each slot, empty for free slots.
+  QStringList slot_keys_;
+  QHash<QString, int> slots_;
+  QList<int> free_slots_;
+  // The next slot to overwrite once the atlas is full.
+  int next_slot_;
+  bool index_dirty_;
+};
+
+#endif  // LIBRARY_ALBUMICONATLAS_H_
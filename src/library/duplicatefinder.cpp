@@ -0,0 +1,252 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "duplicatefinder.h"
+
+#include <QCoreApplication>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVariant>
+
+#include "core/application.h"
+#include "core/closure.h"
+#include "core/database.h"
+#include "core/executor.h"
+#include "core/logging.h"
+#include "core/scopedtransaction.h"
+#include "core/taskmanager.h"
+#include "library/fingerprintindex.h"
+#include "library/librarybackend.h"
+#include "musicbrainz/chromaprinter.h"
+
+// Enough for FingerprintIndex::kStoredItems, with a little to spare.
+const int DuplicateFinder::kFingerprintSecs = 20;
+const int DuplicateFinder::kBatchSize = 32;
+
+DuplicateFinder::DuplicateFinder(Application* app, QObject* parent)
+    : QObject(parent),
+      app_(app),
+      task_id_(-1),
+      abort_(new QAtomicInt(0)),
+      jobs_(0),
+      done_(0),
+      total_(0) {}
+
+DuplicateFinder::~DuplicateFinder() {
+  // Whatever is still being fingerprinted is thrown away.
+  abort_->storeRelease(1);
+}
+
+void DuplicateFinder::Start() {
+  if (is_running()) return;
+
+  task_id_ = app_->task_manager()->StartTask(tr("Finding duplicate songs"));
+
+  LibraryBackend* backend = app_->library_backend();
+  QFuture<SongList> future = Executor::Db()->Run<SongList>(
+      [backend]() { return backend->GetAllSongs(); });
+  NewClosure(future, this, SLOT(SongsLoaded(QFuture<SongList>)), future);
+}
+
+void DuplicateFinder::SongsLoaded(QFuture<SongList> future) {
+  songs_.clear();
+  for (const Song& song : future.result()) {
+    if (song.is_unavailable() || song.url().scheme() != "file") continue;
+    // A cue sheet's songs are all in one file.
+    if (song.has_cue()) continue;
+    songs_[song.id()] = song;
+  }
+
+  Database* db = app_->database();
+  QFuture<StoredFingerprintList> fingerprints =
+      Executor::Db()->Run<StoredFingerprintList>(
+          [db]() { return LoadFingerprints(db); });
+  NewClosure(fingerprints, this,
+             SLOT(FingerprintsLoaded(QFuture<StoredFingerprintList>)),
+             fingerprints);
+}
+
+void DuplicateFinder::FingerprintsLoaded(
+    QFuture<StoredFingerprintList> future) {
+  fingerprints_.clear();
+  QHash<int, uint> mtimes;
+  for (const StoredFingerprint& stored : future.result()) {
+    fingerprints_[stored.song_id_] = stored.fingerprint_;
+    mtimes[stored.song_id_] = stored.mtime_;
+  }
+
+  // Songs whose files have changed since they were fingerprinted are done
+  // again.
+  SongList songs;
+  for (const Song& song : songs_) {
+    auto it = mtimes.constFind(song.id());
+    if (it != mtimes.constEnd() && it.value() == song.mtime()) continue;
+
+    fingerprints_.remove(song.id());
+    songs << song;
+  }
+
+  queue_.clear();
+  for (int i = 0; i < songs.count(); i += kBatchSize) {
+    queue_ << songs.mid(i, kBatchSize);
+  }
+  done_ = 0;
+  total_ = songs.count();
+  qLog(Info) << "Fingerprinting" << total_ << "songs," << fingerprints_.count()
+             << "already done";
+
+  StartMore();
+}
+
+void DuplicateFinder::StartMore() {
+  const int max_jobs = qMax(1, QThread::idealThreadCount());
+  while (jobs_ < max_jobs && !queue_.isEmpty()) {
+    const SongList songs = queue_.takeFirst();
+    std::shared_ptr<QAtomicInt> abort = abort_;
+    QFuture<StoredFingerprintList> future =
+        Executor::Cpu()->Run<StoredFingerprintList>([songs, abort]() {
+          return FingerprintSongs(songs, abort.get());
+        });
+    NewClosure(future, this,
+               SLOT(BatchFinished(QFuture<StoredFingerprintList>)), future);
+    ++jobs_;
+  }
+
+  app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+  if (jobs_ > 0 || !queue_.isEmpty()) return;
+
+  // Everything's fingerprinted, now the songs can be compared.
+  const QHash<int, QByteArray> fingerprints = fingerprints_;
+  QFuture<QList<QList<int>>> future = Executor::Cpu()->Run<QList<QList<int>>>(
+      [fingerprints]() { return Search(fingerprints); });
+  NewClosure(future, this, SLOT(SearchFinished(QFuture<QList<QList<int>>>)),
+             future);
+}
+
+void DuplicateFinder::BatchFinished(QFuture<StoredFingerprintList> future) {
+  --jobs_;
+
+  const StoredFingerprintList fingerprints = future.result();
+  for (const StoredFingerprint& stored : fingerprints) {
+    fingerprints_[stored.song_id_] = stored.fingerprint_;
+  }
+  done_ += fingerprints.count();
+
+  Database* db = app_->database();
+  Executor::Db()->Run<void>(
+      [db, fingerprints]() { SaveFingerprints(db, fingerprints); });
+
+  StartMore();
+}
+
+void DuplicateFinder::SearchFinished(QFuture<QList<QList<int>>> future) {
+  SongList duplicates;
+  for (const QList<int>& group : future.result()) {
+    for (int id : group) duplicates << songs_[id];
+  }
+  qLog(Info) << "Found" << future.result().count() << "groups of duplicates";
+
+  songs_.clear();
+  fingerprints_.clear();
+  app_->task_manager()->SetTaskFinished(task_id_);
+  task_id_ = -1;
+
+  emit Finished(duplicates);
+}
+
+DuplicateFinder::StoredFingerprintList DuplicateFinder::LoadFingerprints(
+    Database* db) {
+  QMutexLocker l(db->Mutex());
+  QSqlDatabase connection(db->Connect());
+
+  QSqlQuery q(connection);
+  q.exec(
+      "DELETE FROM fingerprints"
+      " WHERE song_id NOT IN (SELECT ROWID FROM songs)");
+  db->CheckErrors(q);
+
+  q.exec("SELECT song_id, mtime, fingerprint FROM fingerprints");
+  StoredFingerprintList ret;
+  if (db->CheckErrors(q)) return ret;
+
+  while (q.next()) {
+    StoredFingerprint stored;
+    stored.song_id_ = q.value(0).toInt();
+    stored.mtime_ = q.value(1).toUInt();
+    stored.fingerprint_ = q.value(2).toByteArray();
+    ret << stored;
+  }
+  return ret;
+}
+
+void DuplicateFinder::SaveFingerprints(
+    Database* db, const StoredFingerprintList& fingerprints) {
+  QMutexLocker l(db->Mutex());
+  QSqlDatabase connection(db->Connect());
+  ScopedTransaction t(&connection);
+
+  QSqlQuery q(connection);
+  q.prepare(
+      "INSERT OR REPLACE INTO fingerprints (song_id, mtime, fingerprint)"
+      " VALUES (:song_id, :mtime, :fingerprint)");
+  for (const StoredFingerprint& stored : fingerprints) {
+    q.bindValue(":song_id", stored.song_id_);
+    q.bindValue(":mtime", stored.mtime_);
+    q.bindValue(":fingerprint", stored.fingerprint_);
+    q.exec();
+    if (db->CheckErrors(q)) return;
+  }
+
+  t.Commit();
+}
+
+DuplicateFinder::StoredFingerprintList DuplicateFinder::FingerprintSongs(
+    const SongList& songs, const QAtomicInt* abort) {
+  Q_ASSERT(QThread::currentThread() != qApp->thread());
+
+  StoredFingerprintList ret;
+  for (const Song& song : songs) {
+    if (abort->loadAcquire()) break;
+
+    Chromaprinter chromaprinter(song.url().toLocalFile(), kFingerprintSecs);
+    chromaprinter.CreateFingerprint();
+
+    FingerprintIndex::Fingerprint fingerprint =
+        chromaprinter.raw_fingerprint();
+    if (int(fingerprint.size()) > FingerprintIndex::kStoredItems) {
+      fingerprint.resize(FingerprintIndex::kStoredItems);
+    }
+
+    StoredFingerprint stored;
+    stored.song_id_ = song.id();
+    stored.mtime_ = song.mtime();
+    stored.fingerprint_ = FingerprintIndex::Pack(fingerprint);
+    ret << stored;
+  }
+  return ret;
+}
+
+QList<QList<int>> DuplicateFinder::Search(
+    const QHash<int, QByteArray>& fingerprints) {
+  FingerprintIndex index;
+  for (auto it = fingerprints.constBegin(); it != fingerprints.constEnd();
+       ++it) {
+    if (it.value().isEmpty()) continue;
+    index.Add(it.key(), FingerprintIndex::Unpack(it.value()));
+  }
+  return index.FindDuplicates();
+}
@@ -0,0 +1,105 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBRARY_DUPLICATEFINDER_H_
+#define LIBRARY_DUPLICATEFINDER_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <memory>
+
+#include "core/song.h"
+
+class Application;
+class Database;
+
+// Finds songs in the library that are the same recording, however they're
+// tagged, by comparing their acoustic fingerprints.
+//
+// Songs are fingerprinted in the background the first time, and the
+// fingerprints are kept in the database, so next time only new and changed
+// files have to be decoded.  Looking for duplicates then uses a
+// FingerprintIndex, so it doesn't compare every song with every other one.
+class DuplicateFinder : public QObject {
+  Q_OBJECT
+
+ public:
+  DuplicateFinder(Application* app, QObject* parent = nullptr);
+  ~DuplicateFinder();
+
+  // Fingerprints are made from this much of the start of each song.
+  static const int kFingerprintSecs;
+  // How many songs each fingerprinting job does before it reports back.
+  static const int kBatchSize;
+
+  bool is_running() const { return task_id_ != -1; }
+
+ public slots:
+  // Does nothing if it's already running.
+  void Start();
+
+ signals:
+  // The songs in each group of duplicates are next to each other.  Empty if
+  // there weren't any.
+  void Finished(const SongList& duplicates);
+
+ private:
+  struct StoredFingerprint {
+    int song_id_;
+    uint mtime_;
+    // Empty if the song couldn't be fingerprinted.
+    QByteArray fingerprint_;
+  };
+  typedef QList<StoredFingerprint> StoredFingerprintList;
+
+  // Also forgets the fingerprints of songs that aren't in the library any
+  // more.
+  static StoredFingerprintList LoadFingerprints(Database* db);
+  static void SaveFingerprints(Database* db,
+                               const StoredFingerprintList& fingerprints);
+  static StoredFingerprintList FingerprintSongs(const SongList& songs,
+                                                const QAtomicInt* abort);
+  static QList<QList<int>> Search(
+      const QHash<int, QByteArray>& fingerprints);
+
+ private slots:
+  void SongsLoaded(QFuture<SongList> future);
+  void FingerprintsLoaded(QFuture<StoredFingerprintList> future);
+  void BatchFinished(QFuture<StoredFingerprintList> future);
+  void SearchFinished(QFuture<QList<QList<int>>> future);
+
+ private:
+  void StartMore();
+
+  Application* app_;
+
+  int task_id_;
+  std::shared_ptr<QAtomicInt> abort_;
+
+  QHash<int, Song> songs_;
+  QHash<int, QByteArray> fingerprints_;
+  QList<SongList> queue_;
+  int jobs_;
+  int done_;
+  int total_;
+};
+
+#endif  // LIBRARY_DUPLICATEFINDER_H_
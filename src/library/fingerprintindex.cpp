@@ -0,0 +1,187 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fingerprintindex.h"
+
+#include <QMap>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <algorithm>
+#include <numeric>
+
+const int FingerprintIndex::kStoredItems = 120;
+const int FingerprintIndex::kIndexedItems = 64;
+const int FingerprintIndex::kMaxOffset = 16;
+const double FingerprintIndex::kDefaultMinSimilarity = 0.8;
+
+namespace {
+
+// The buckets are for this many of each item's top bits.  With fewer,
+// unrelated songs would share buckets more often, and with more, the items
+// of two encodes would have to be closer to land in the same one.
+const int kBucketBits = 24;
+
+// A bucket with more songs than this is for something lots of songs have,
+// like silence, and says nothing about whether they're the same.
+const size_t kMaxBucketSize = 32;
+
+// How many buckets two songs have to share before they're compared.
+const int kMinSharedBuckets = 2;
+
+int FindRoot(std::vector<int>* parents, int i) {
+  while ((*parents)[i] != i) {
+    (*parents)[i] = (*parents)[(*parents)[i]];
+    i = (*parents)[i];
+  }
+  return i;
+}
+
+}  // namespace
+
+QByteArray FingerprintIndex::Pack(const Fingerprint& fingerprint) {
+  QByteArray ret;
+  ret.resize(int(fingerprint.size()) * 4);
+
+  uchar* data = reinterpret_cast<uchar*>(ret.data());
+  for (quint32 item : fingerprint) {
+    qToLittleEndian(item, data);
+    data += 4;
+  }
+  return ret;
+}
+
+FingerprintIndex::Fingerprint FingerprintIndex::Unpack(
+    const QByteArray& data) {
+  Fingerprint ret(data.size() / 4);
+
+  const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+  for (size_t i = 0; i < ret.size(); ++i) {
+    ret[i] = qFromLittleEndian<quint32>(p + i * 4);
+  }
+  return ret;
+}
+
+double FingerprintIndex::Similarity(const Fingerprint& a, const Fingerprint& b,
+                                    int max_offset) {
+  if (a.empty() || b.empty()) return 0;
+
+  const int a_size = a.size();
+  const int b_size = b.size();
+  const int min_overlap = qMax(1, qMin(a_size, b_size) / 2);
+
+  double best = 0;
+  for (int offset = -max_offset; offset <= max_offset; ++offset) {
+    // b[i] lines up with a[i + offset].
+    const int begin = qMax(0, -offset);
+    const int end = qMin(b_size, a_size - offset);
+    const int overlap = end - begin;
+    if (overlap < min_overlap) continue;
+
+    int differing = 0;
+    for (int i = begin; i < end; ++i) {
+      differing += qPopulationCount(a[i + offset] ^ b[i]);
+    }
+    best = qMax(best, 1.0 - double(differing) / (32.0 * overlap));
+  }
+  return best;
+}
+
+void FingerprintIndex::Add(int song_id, const Fingerprint& fingerprint) {
+  ids_.push_back(song_id);
+  offsets_.push_back(items_.size());
+  items_.insert(items_.end(), fingerprint.begin(), fingerprint.end());
+}
+
+int FingerprintIndex::EndOf(int i) const {
+  return i + 1 < int(offsets_.size()) ? offsets_[i + 1] : items_.size();
+}
+
+FingerprintIndex::Fingerprint FingerprintIndex::FingerprintAt(int i) const {
+  return Fingerprint(items_.begin() + offsets_[i], items_.begin() + EndOf(i));
+}
+
+QList<QList<int>> FingerprintIndex::FindDuplicates(
+    double min_similarity) const {
+  const int songs = ids_.size();
+
+  // The bucket goes in the top half of each entry and the song in the bottom
+  // half, so sorting them puts each bucket's songs next to each other.
+  std::vector<quint64> entries;
+  for (int i = 0; i < songs; ++i) {
+    const size_t first = entries.size();
+    const int end = qMin(offsets_[i] + kIndexedItems, EndOf(i));
+    for (int j = offsets_[i]; j < end; ++j) {
+      const quint64 bucket = items_[j] >> (32 - kBucketBits);
+      entries.push_back((bucket << 32) | quint32(i));
+    }
+
+    // A song only counts once in each bucket.
+    std::sort(entries.begin() + first, entries.end());
+    entries.erase(std::unique(entries.begin() + first, entries.end()),
+                  entries.end());
+  }
+  std::sort(entries.begin(), entries.end());
+
+  // How many buckets each pair of songs shares.  Within a bucket the songs
+  // are in order, so the first of a pair is always the lower one.
+  QHash<quint64, int> shared;
+  for (size_t begin = 0; begin < entries.size();) {
+    size_t end = begin + 1;
+    while (end < entries.size() &&
+           (entries[end] >> 32) == (entries[begin] >> 32)) {
+      ++end;
+    }
+
+    if (end - begin <= kMaxBucketSize) {
+      for (size_t x = begin; x < end; ++x) {
+        for (size_t y = x + 1; y < end; ++y) {
+          ++shared[(entries[x] << 32) | quint32(entries[y])];
+        }
+      }
+    }
+    begin = end;
+  }
+  std::vector<quint64>().swap(entries);
+
+  std::vector<int> parents(songs);
+  std::iota(parents.begin(), parents.end(), 0);
+  for (auto it = shared.constBegin(); it != shared.constEnd(); ++it) {
+    if (it.value() < kMinSharedBuckets) continue;
+
+    const int first = int(it.key() >> 32);
+    const int second = int(it.key() & 0xffffffff);
+    const int first_root = FindRoot(&parents, first);
+    const int second_root = FindRoot(&parents, second);
+    if (first_root == second_root) continue;
+
+    if (Similarity(FingerprintAt(first), FingerprintAt(second)) >=
+        min_similarity) {
+      parents[first_root] = second_root;
+    }
+  }
+
+  QMap<int, QList<int>> groups;
+  for (int i = 0; i < songs; ++i) {
+    groups[FindRoot(&parents, i)] << ids_[i];
+  }
+
+  QList<QList<int>> ret;
+  for (const QList<int>& group : groups) {
+    if (group.count() > 1) ret << group;
+  }
+  return ret;
+}
@@ -0,0 +1,77 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBRARY_FINGERPRINTINDEX_H_
+#define LIBRARY_FINGERPRINTINDEX_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <vector>
+
+// Finds songs whose Chromaprint fingerprints are nearly the same, without
+// comparing every fingerprint with every other one.
+//
+// Each item of a raw fingerprint is a 32 bit hash of an eighth of a second or
+// so of audio, and two encodes of the same recording only differ in a few of
+// their bits.  The index is locality-sensitive: every song is put in a bucket
+// for each of its first items' top bits, and only songs that share enough of
+// those buckets are compared properly.
+class FingerprintIndex {
+ public:
+  typedef std::vector<quint32> Fingerprint;
+
+  // Fingerprints are cut down to this many items, about 15 seconds, before
+  // they're stored.  That's plenty to tell recordings apart.
+  static const int kStoredItems;
+  // How many of a fingerprint's items go into the buckets.
+  static const int kIndexedItems;
+  // How far either way, in items, two fingerprints are lined up to compare
+  // them, for rips that start a little earlier or later.
+  static const int kMaxOffset;
+  static const double kDefaultMinSimilarity;
+
+  // Four little-endian bytes for each item.
+  static QByteArray Pack(const Fingerprint& fingerprint);
+  static Fingerprint Unpack(const QByteArray& data);
+
+  // The fraction of bits that are the same where a and b line up best, or 0
+  // if they don't overlap by at least half of the shorter one.
+  static double Similarity(const Fingerprint& a, const Fingerprint& b,
+                           int max_offset = kMaxOffset);
+
+  void Add(int song_id, const Fingerprint& fingerprint);
+  int count() const { return ids_.size(); }
+
+  // Returns the songs that are at least min_similarity alike, in groups of
+  // two or more.  Takes a while for a big library, so call it in another
+  // thread.
+  QList<QList<int>> FindDuplicates(
+      double min_similarity = kDefaultMinSimilarity) const;
+
+ private:
+  // Fingerprint i starts at items_[offsets_[i]] and ends where the next one
+  // starts.
+  int EndOf(int i) const;
+  Fingerprint FingerprintAt(int i) const;
+
+  std::vector<int> ids_;
+  std::vector<int> offsets_;
+  std::vector<quint32> items_;
+};
+
+#endif  // LIBRARY_FINGERPRINTINDEX_H_
@@ -17,12 +17,17 @@
 
 #include "library.h"
 
+#include <QCoreApplication>
+#include <QTimer>
+
 #include "core/application.h"
 #include "core/database.h"
+#include "core/logging.h"
 #include "core/player.h"
 #include "core/tagreaderclient.h"
 #include "core/taskmanager.h"
 #include "core/thread.h"
+#include "core/trace.h"
 #include "librarybackend.h"
 #include "librarydirectorymodel.h"
 #include "librarymodel.h"
@@ -34,6 +39,14 @@ const char* Library::kSongsTable = "songs";
 const char* Library::kDirsTable = "directories";
 const char* Library::kSubdirsTable = "subdirectories";
 const char* Library::kFtsTable = "songs_fts";
+const char* Library::kScanCheckpointsTable = "scan_checkpoints";
+const char* Library::kCueSheetsTable = "cue_sheets";
+const char* Library::kTagReaderCrashesTable = "tag_reader_crashes";
+const char* Library::kAggregatesTable = "songs_aggregates";
+const char* Library::kAlbumsTable = "songs_albums";
+
+const int Library::kWriteBackDelayMsec = 30000;
+const int Library::kMaxWriteBackDelayMsec = 10 * 60 * 1000;
 
 Library::Library(Application* app, QObject* parent)
     : QObject(parent),
@@ -43,12 +56,21 @@ Library::Library(Application* app, QObject* parent)
       watcher_(nullptr),
       watcher_thread_(nullptr),
       save_statistics_in_files_(false),
-      save_ratings_in_files_(false) {
+      save_ratings_in_files_(false),
+      write_back_timer_(new QTimer(this)) {
+  write_back_timer_->setSingleShot(true);
+  write_back_timer_->setInterval(kWriteBackDelayMsec);
+  connect(write_back_timer_, SIGNAL(timeout()), SLOT(WriteBackTimeout()));
+
   backend_.reset(new LibraryBackend);
   backend()->moveToThread(app->database()->thread());
 
   backend_->Init(app->database(), kSongsTable, kDirsTable, kSubdirsTable,
                  kFtsTable);
+  backend_->set_scan_checkpoints_table(kScanCheckpointsTable);
+  backend_->set_cue_sheets_table(kCueSheetsTable);
+  backend_->set_tag_reader_crashes_table(kTagReaderCrashesTable);
+  backend_->set_aggregate_tables(kAggregatesTable, kAlbumsTable);
 
   using smart_playlists::Generator;
   using smart_playlists::GeneratorPtr;
@@ -132,6 +154,8 @@ Library::~Library() {
 }
 
 void Library::Init() {
+  TRACE_SCOPE("Library::Init");
+
   watcher_ = new LibraryWatcher;
   watcher_thread_ = new Thread(this);
   watcher_thread_->SetIoPriority(Utilities::IOPRIO_CLASS_IDLE);
@@ -166,10 +190,20 @@ void Library::Init() {
           backend_.get(), SLOT(AddOrUpdateSubdirs(SubdirectoryList)));
   connect(watcher_, SIGNAL(CompilationsNeedUpdating()), backend_.get(),
           SLOT(UpdateCompilations()));
+  connect(watcher_, SIGNAL(ScanCheckpointReached(SubdirectoryList)),
+          backend_.get(), SLOT(AddScanCheckpoint(SubdirectoryList)));
+  connect(watcher_, SIGNAL(ScanCheckpointCleared(int)), backend_.get(),
+          SLOT(ClearScanCheckpoint(int)));
   connect(watcher_, &LibraryWatcher::Error, app_, &Application::AddError);
+  connect(app_->tag_reader_client(), SIGNAL(WorkerCrashed(QStringList)),
+          backend_.get(), SLOT(AddTagReaderCrash(QStringList)));
   connect(app_->playlist_manager(), SIGNAL(CurrentSongChanged(Song)),
           SLOT(CurrentSongChanged(Song)));
   connect(app_->player(), SIGNAL(Stopped()), SLOT(Stopped()));
+  // The tag reader workers are gone by the time we're deleted, so changes
+  // still waiting to be written have to be written before then.
+  connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+          SLOT(FlushWriteBackBlocking()));
 
   // This will start the watcher checking for updates
   backend_->LoadDirectoriesAsync();
@@ -205,56 +239,116 @@ void Library::WriteAllSongsStatisticsToFiles() {
   const int nb_songs = all_songs.size();
   int i = 0;
   for (const Song& song : all_songs) {
-    TagReaderClient::Instance()->UpdateSongStatisticsBlocking(song);
-    TagReaderClient::Instance()->UpdateSongRatingBlocking(song);
+    TagReaderClient::Instance()->UpdateSongStatisticsBlocking(
+        song, TagReaderClient::Priority_Background);
+    TagReaderClient::Instance()->UpdateSongRatingBlocking(
+        song, TagReaderClient::Priority_Background);
     app_->task_manager()->SetTaskProgress(task_id, ++i, nb_songs);
   }
   app_->task_manager()->SetTaskFinished(task_id);
 }
 
-void Library::Stopped() { CurrentSongChanged(Song()); }
+void Library::Stopped() {
+  current_wma_song_url_ = QUrl();
+  FlushWriteBack();
+}
 
 void Library::CurrentSongChanged(const Song& song) {
-  TagReaderReply* reply = nullptr;
-  if (queued_rating_.is_valid()) {
-    reply = app_->tag_reader_client()->UpdateSongRating(queued_rating_);
-    queued_rating_ = Song();
-  } else if (queued_statistics_.is_valid()) {
-    reply = app_->tag_reader_client()->UpdateSongStatistics(queued_statistics_);
-    queued_statistics_ = Song();
-  }
+  current_wma_song_url_ =
+      song.filetype() == Song::Type_Asf ? song.url() : QUrl();
+}
 
-  if (reply) {
-    connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
+void Library::SongsRatingChanged(const SongList& songs) {
+  if (save_ratings_in_files_) QueueWriteBack(songs, false, true);
+}
+
+void Library::SongsStatisticsChanged(const SongList& songs) {
+  if (save_statistics_in_files_) QueueWriteBack(songs, true, false);
+}
+
+void Library::QueueWriteBack(const SongList& songs, bool statistics,
+                             bool rating) {
+  if (songs.isEmpty()) return;
+  if (pending_writes_.isEmpty()) oldest_pending_write_.start();
+
+  for (const Song& song : songs) {
+    PendingWrite& write = pending_writes_[song.url()];
+    write.song_ = song;
+    write.statistics_ |= statistics;
+    write.rating_ |= rating;
   }
 
-  if (song.filetype() == Song::Type_Asf) {
-    current_wma_song_url_ = song.url();
+  if (!write_back_timer_->isActive()) write_back_timer_->start();
+}
+
+void Library::WriteBackTimeout() {
+  // Rewriting files while something's playing competes with it for the disk,
+  // so wait for a pause unless the changes have waited long enough already.
+  if (app_->player()->GetState() == Engine::Playing &&
+      oldest_pending_write_.elapsed() < kMaxWriteBackDelayMsec) {
+    write_back_timer_->start();
+    return;
   }
+  FlushWriteBack();
 }
 
-void Library::SongsRatingChanged(const SongList& songs) {
-  if (save_ratings_in_files_) {
-    app_->tag_reader_client()->UpdateSongsRating(
-        FilterCurrentWMASong(songs, &queued_rating_));
+void Library::FlushWriteBack() {
+  for (TagReaderReply* reply : SendWriteBack()) {
+    connect(reply, SIGNAL(Finished(bool)), reply, SLOT(deleteLater()));
   }
 }
 
-void Library::SongsStatisticsChanged(const SongList& songs) {
-  if (save_statistics_in_files_) {
-    app_->tag_reader_client()->UpdateSongsStatistics(
-        FilterCurrentWMASong(songs, &queued_statistics_));
+void Library::FlushWriteBackBlocking() {
+  // Plays and ratings that are still waiting to be written to the database
+  // have to be written to the files too.  The backend tells us about them
+  // from its own thread, so deliver those signals now.
+  QMetaObject::invokeMethod(backend_.get(), "FlushStatistics",
+                            backend_->thread() == thread()
+                                ? Qt::DirectConnection
+                                : Qt::BlockingQueuedConnection);
+  QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+
+  // Nothing will be playing any more, and there won't be another chance to
+  // write the song that was.
+  current_wma_song_url_ = QUrl();
+
+  for (TagReaderReply* reply : SendWriteBack()) {
+    reply->WaitForFinished();
+    reply->deleteLater();
   }
 }
 
-SongList Library::FilterCurrentWMASong(SongList songs, Song* queued) {
-  for (SongList::iterator it = songs.begin(); it != songs.end();) {
-    if (it->url() == current_wma_song_url_) {
-      *queued = *it;
-      it = songs.erase(it);
+QList<TagReaderReply*> Library::SendWriteBack() {
+  write_back_timer_->stop();
+
+  QList<TagReaderReply*> replies;
+  QHash<QUrl, PendingWrite> kept;
+  for (auto it = pending_writes_.constBegin(); it != pending_writes_.constEnd();
+       ++it) {
+    if (!current_wma_song_url_.isEmpty() && it.key() == current_wma_song_url_) {
+      kept.insert(it.key(), it.value());
+      continue;
+    }
+
+    const PendingWrite& write = it.value();
+    TagReaderReply* reply = nullptr;
+    if (write.statistics_) {
+      reply = app_->tag_reader_client()->UpdateSongStatistics(
+          write.song_, TagReaderClient::Priority_Background, write.rating_);
     } else {
-      ++it;
+      reply = app_->tag_reader_client()->UpdateSongRating(
+          write.song_, TagReaderClient::Priority_Background);
     }
+    replies << reply;
+  }
+
+  qLog(Debug) << "Wrote statistics to" << pending_writes_.size() - kept.size()
+              << "files";
+
+  pending_writes_ = kept;
+  if (!pending_writes_.isEmpty()) {
+    oldest_pending_write_.start();
+    write_back_timer_->start();
   }
-  return songs;
+  return replies;
 }
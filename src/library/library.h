@@ -18,12 +18,14 @@
 #ifndef LIBRARY_H
 #define LIBRARY_H
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QObject>
 #include <QUrl>
 #include <memory>
 
 #include "core/song.h"
+#include "core/tagreaderclient.h"
 
 class Application;
 class Database;
@@ -34,6 +36,8 @@ class LibraryWatcher;
 class TaskManager;
 class Thread;
 
+class QTimer;
+
 class Library : public QObject {
   Q_OBJECT
 
@@ -45,6 +49,16 @@ class Library : public QObject {
   static const char* kDirsTable;
   static const char* kSubdirsTable;
   static const char* kFtsTable;
+  static const char* kScanCheckpointsTable;
+  static const char* kCueSheetsTable;
+  static const char* kTagReaderCrashesTable;
+  static const char* kAggregatesTable;
+  static const char* kAlbumsTable;
+
+  // Statistics and rating changes are written to the files this long after
+  // the first one, once nothing is playing, but never later than the maximum.
+  static const int kWriteBackDelayMsec;
+  static const int kMaxWriteBackDelayMsec;
 
   void Init();
 
@@ -74,10 +88,27 @@ class Library : public QObject {
   void CurrentSongChanged(const Song& song);
   void Stopped();
 
+  void WriteBackTimeout();
+  void FlushWriteBack();
+  // Writes every pending change, even while something's playing, and waits
+  // until they've all been written.  Called when the application quits.
+  void FlushWriteBackBlocking();
+
  private:
-  SongList FilterCurrentWMASong(SongList songs, Song* queued);
+  void QueueWriteBack(const SongList& songs, bool statistics, bool rating);
+  // Sends the pending changes to the tag reader, returning its replies.
+  QList<TagReaderReply*> SendWriteBack();
 
  private:
+  struct PendingWrite {
+    PendingWrite() : statistics_(false), rating_(false) {}
+
+    // The latest version of the song, which has the latest of both.
+    Song song_;
+    bool statistics_;
+    bool rating_;
+  };
+
   Application* app_;
   std::shared_ptr<LibraryBackend> backend_;
   LibraryModel* model_;
@@ -89,12 +120,16 @@ class Library : public QObject {
   bool save_statistics_in_files_;
   bool save_ratings_in_files_;
 
+  // Changes waiting to be written to the files, one entry per file however
+  // many times it changed, so each file is rewritten at most once a flush.
+  QHash<QUrl, PendingWrite> pending_writes_;
+  QElapsedTimer oldest_pending_write_;
+  QTimer* write_back_timer_;
+
   // Hack: Gstreamer doesn't cope well with WMA files being rewritten while
-  // being played, so we delay statistics and rating changes until the current
-  // song has finished playing.
+  // being played, so we keep statistics and rating changes queued until the
+  // current song has finished playing.
   QUrl current_wma_song_url_;
-  Song queued_statistics_;
-  Song queued_rating_;
 
   // DB schema versions which should trigger a full library rescan (each of
   // those with a short reason why).
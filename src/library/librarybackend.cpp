@@ -18,12 +18,18 @@
 #include "librarybackend.h"
 
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QHash>
 #include <QSettings>
+#include <QTimer>
 #include <QVariant>
 #include <QtDebug>
+#include <cmath>
+#include <limits>
 
 #include "core/application.h"
 #include "core/database.h"
@@ -33,8 +39,82 @@
 #include "libraryquery.h"
 #include "smartplaylists/search.h"
 #include "sqlrow.h"
+#include "tagreadermessages.pb.h"
 
 const char* LibraryBackend::kSettingsGroup = "LibraryBackend";
+const int LibraryBackend::kMaxInlineIds = 100;
+const int LibraryBackend::kQuarantineCrashes = 2;
+
+const char* LibraryBackend::kAggregateColumns[] = {
+    "artist", "effective_albumartist", "album", "genre", nullptr};
+
+namespace {
+
+// A row in either of the aggregate tables.  kind is the column for rows in the
+// aggregates table and empty for rows in the albums table.
+struct AggregateKey {
+  QString kind;
+  QString value;
+  QString artist;
+  QString albumartist;
+  int compilation;
+
+  bool operator==(const AggregateKey& other) const {
+    return kind == other.kind && value == other.value &&
+           artist == other.artist && albumartist == other.albumartist &&
+           compilation == other.compilation;
+  }
+};
+
+uint qHash(const AggregateKey& key) {
+  return ::qHash(key.kind) ^ ::qHash(key.value) ^ ::qHash(key.artist) ^
+         ::qHash(key.albumartist) ^ key.compilation;
+}
+
+struct AggregateDelta {
+  AggregateDelta()
+      : song_count(0), first_song(std::numeric_limits<int>::max()) {}
+
+  int song_count;
+  int first_song;
+};
+
+// Stored values are never null so they can be compared with =.
+QString NotNull(const QString& value) {
+  return value.isNull() ? QString("") : value;
+}
+
+QString AggregateValue(const Song& song, const QString& column) {
+  if (column == "artist") return NotNull(song.artist());
+  if (column == "effective_albumartist")
+    return NotNull(song.effective_albumartist());
+  if (column == "album") return NotNull(song.album());
+  return NotNull(song.genre());
+}
+
+QList<AggregateKey> AggregateKeys(const Song& song) {
+  QList<AggregateKey> ret;
+  const int compilation = song.is_compilation() ? 1 : 0;
+
+  for (int i = 0; LibraryBackend::kAggregateColumns[i]; ++i) {
+    AggregateKey key;
+    key.kind = LibraryBackend::kAggregateColumns[i];
+    key.value = AggregateValue(song, key.kind);
+    key.compilation = compilation;
+    ret << key;
+  }
+
+  AggregateKey album;
+  album.value = NotNull(song.album());
+  album.artist = NotNull(song.artist());
+  album.albumartist = NotNull(song.albumartist());
+  album.compilation = compilation;
+  ret << album;
+
+  return ret;
+}
+
+}  // namespace
 
 const char* LibraryBackend::kNewScoreSql =
     "case when playcount <= 0 then (%1 * 100 + score) / 2"
@@ -42,11 +122,20 @@ const char* LibraryBackend::kNewScoreSql =
     "skipcount + 1)"
     " end";
 
+const int LibraryBackend::kStatisticsFlushMsec = 500;
+
 LibraryBackend::LibraryBackend(QObject* parent)
     : LibraryBackendInterface(parent),
       save_statistics_in_file_(false),
       save_ratings_in_file_(false) {}
 
+LibraryBackend::~LibraryBackend() {
+  // Plays and ratings from the last moments before quitting might still be
+  // waiting for the flush timer.  Library flushes them itself when the
+  // application quits, so it can write them to the files as well.
+  FlushStatistics();
+}
+
 void LibraryBackend::Init(Database* db, const QString& songs_table,
                           const QString& fts_table) {
   db_ = db;
@@ -73,30 +162,103 @@ void LibraryBackend::UpdateTotalSongCountAsync() {
 }
 
 void LibraryBackend::IncrementPlayCountAsync(int id) {
-  metaObject()->invokeMethod(this, "IncrementPlayCount", Qt::QueuedConnection,
-                             Q_ARG(int, id));
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  QueueStatistics(QList<int>() << id, [now](PendingStatistics* pending) {
+    pending->events << PendingStatistics::Event{false, 1.0f, now};
+  });
 }
 
 void LibraryBackend::IncrementSkipCountAsync(int id, float progress) {
-  metaObject()->invokeMethod(this, "IncrementSkipCount", Qt::QueuedConnection,
-                             Q_ARG(int, id), Q_ARG(float, progress));
+  progress = qBound(0.0f, progress, 1.0f);
+  QueueStatistics(QList<int>() << id, [progress](PendingStatistics* pending) {
+    pending->events << PendingStatistics::Event{true, progress, 0};
+  });
 }
 
 void LibraryBackend::ResetStatisticsAsync(int id) {
-  metaObject()->invokeMethod(this, "ResetStatistics", Qt::QueuedConnection,
-                             Q_ARG(int, id));
+  QueueStatistics(QList<int>() << id, [](PendingStatistics* pending) {
+    pending->reset = true;
+    pending->events.clear();
+  });
 }
 
 void LibraryBackend::UpdateSongRatingAsync(int id, float rating) {
-  metaObject()->invokeMethod(this, "UpdateSongRating", Qt::QueuedConnection,
-                             Q_ARG(int, id), Q_ARG(float, rating));
+  UpdateSongsRatingAsync(QList<int>() << id, rating);
 }
 
 void LibraryBackend::UpdateSongsRatingAsync(const QList<int>& ids,
                                             float rating) {
-  metaObject()->invokeMethod(this, "UpdateSongsRating", Qt::QueuedConnection,
-                             Q_ARG(const QList<int>&, ids),
-                             Q_ARG(float, rating));
+  QueueStatistics(ids, [rating](PendingStatistics* pending) {
+    pending->has_rating = true;
+    pending->rating = rating;
+  });
+}
+
+void LibraryBackend::QueueStatistics(
+    const QList<int>& ids, std::function<void(PendingStatistics*)> change) {
+  bool was_empty = false;
+  {
+    QMutexLocker l(&pending_statistics_mutex_);
+    was_empty = pending_statistics_.isEmpty();
+    for (int id : ids) {
+      if (id != -1) change(&pending_statistics_[id]);
+    }
+    if (pending_statistics_.isEmpty()) return;
+  }
+
+  // The timer has to be started in the backend's thread.
+  if (was_empty) {
+    metaObject()->invokeMethod(this, "StartStatisticsFlushTimer",
+                               Qt::QueuedConnection);
+  }
+}
+
+void LibraryBackend::StartStatisticsFlushTimer() {
+  QTimer::singleShot(kStatisticsFlushMsec, this, SLOT(FlushStatistics()));
+}
+
+void LibraryBackend::UpdateReplayGainAsync(const SongList& songs) {
+  metaObject()->invokeMethod(this, "UpdateReplayGain", Qt::QueuedConnection,
+                             Q_ARG(SongList, songs));
+}
+
+void LibraryBackend::EnsureGroupingIndexAsync(const QStringList& columns) {
+  metaObject()->invokeMethod(this, "EnsureGroupingIndex",
+                             Qt::QueuedConnection,
+                             Q_ARG(QStringList, columns));
+}
+
+void LibraryBackend::EnsureGroupingIndex(const QStringList& columns) {
+  if (columns.isEmpty()) return;
+
+  // Indexes in an attached database take the schema on their own name.
+  QString schema;
+  QString table = songs_table_;
+  if (table.contains('.')) {
+    schema = table.section('.', 0, 0) + ".";
+    table = table.section('.', 1);
+  }
+
+  // Named after the table too, as index names are shared by every table in a
+  // database.  schema-56.sql creates the standard groupings' indexes with the
+  // same names.
+  const QString name =
+      QString("idx_%1_grouping_%2").arg(table, columns.join("_"));
+  if (grouping_indexes_.contains(name)) return;
+
+  QStringList indexed = columns;
+  indexed << "effective_compilation"
+          << "unavailable";
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+  QSqlQuery q(db);
+  q.prepare(QString("CREATE INDEX IF NOT EXISTS %1%2 ON %3 (%4)")
+                .arg(schema, name, table, indexed.join(", ")));
+  q.exec();
+  if (db_->CheckErrors(q)) return;
+
+  grouping_indexes_ << name;
 }
 
 void LibraryBackend::LoadDirectories() {
@@ -128,25 +290,30 @@ void LibraryBackend::ChangeDirPath(int id, const QString& old_path,
   const QByteArray old_url = QUrl::fromLocalFile(old_path).toEncoded();
   const QByteArray new_url = QUrl::fromLocalFile(new_path).toEncoded();
 
-  const int path_len = old_url.length();
+  // Subdirectories are stored as plain paths, songs as URLs.  Everything after
+  // the old prefix is kept as it is, along with each subdirectory's mtime, so
+  // the watcher only has to rescan the ones that have really changed.
+  // substr() counts from 1.  Filenames are bound as blobs and a blob never
+  // compares equal to text, so the concatenation is cast back.
 
   // Do the subdirs table
   q = QSqlQuery(db);
   q.prepare(QString("UPDATE %1 SET path=:path || substr(path, %2)"
                     " WHERE directory=:id")
                 .arg(subdirs_table_)
-                .arg(path_len));
-  q.bindValue(":path", new_url);
+                .arg(old_path.length() + 1));
+  q.bindValue(":path", new_path);
   q.bindValue(":id", id);
   q.exec();
   if (db_->CheckErrors(q)) return;
 
   // Do the songs table
   q = QSqlQuery(db);
-  q.prepare(QString("UPDATE %1 SET filename=:path || substr(filename, %2)"
+  q.prepare(QString("UPDATE %1"
+                    " SET filename=CAST(:path || substr(filename, %2) AS BLOB)"
                     " WHERE directory=:id")
                 .arg(songs_table_)
-                .arg(path_len));
+                .arg(old_url.length() + 1));
   q.bindValue(":path", new_url);
   q.bindValue(":id", id);
   q.exec();
@@ -203,6 +370,232 @@ SubdirectoryList LibraryBackend::SubdirsInDirectory(int id, QSqlDatabase& db) {
   return subdirs;
 }
 
+SubdirectoryList LibraryBackend::ScanCheckpoint(int id) {
+  if (scan_checkpoints_table_.isEmpty()) return SubdirectoryList();
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("SELECT path, mtime FROM %1"
+                    " WHERE directory = :dir")
+                .arg(scan_checkpoints_table_));
+  q.bindValue(":dir", id);
+  q.exec();
+  if (db_->CheckErrors(q)) return SubdirectoryList();
+
+  SubdirectoryList subdirs;
+  while (q.next()) {
+    Subdirectory subdir;
+    subdir.directory_id = id;
+    subdir.path = q.value(0).toString();
+    subdir.mtime = q.value(1).toUInt();
+    subdirs << subdir;
+  }
+
+  return subdirs;
+}
+
+void LibraryBackend::AddScanCheckpoint(const SubdirectoryList& subdirs) {
+  if (scan_checkpoints_table_.isEmpty()) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("INSERT INTO %1 (directory, path, mtime)"
+                    " VALUES (:id, :path, :mtime)")
+                .arg(scan_checkpoints_table_));
+
+  ScopedTransaction transaction(&db);
+  for (const Subdirectory& subdir : subdirs) {
+    q.bindValue(":id", subdir.directory_id);
+    q.bindValue(":path", subdir.path);
+    q.bindValue(":mtime", subdir.mtime);
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+  transaction.Commit();
+}
+
+void LibraryBackend::ClearScanCheckpoint(int dir_id) {
+  if (scan_checkpoints_table_.isEmpty()) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("DELETE FROM %1 WHERE directory = :id")
+                .arg(scan_checkpoints_table_));
+  q.bindValue(":id", dir_id);
+  q.exec();
+  db_->CheckErrors(q);
+}
+
+namespace {
+
+// Cached cue sheet songs are stored as their tag reader messages, plus the
+// fields those don't have.
+const int kCueSheetFormatVersion = 1;
+
+QByteArray SerializeCueSheet(const SongList& songs) {
+  QByteArray ret;
+  QDataStream s(&ret, QIODevice::WriteOnly);
+  s.setVersion(QDataStream::Qt_5_6);
+  s << kCueSheetFormatVersion << songs.count();
+
+  for (const Song& song : songs) {
+    cpb::tagreader::SongMetadata pb;
+    song.ToProtobuf(&pb);
+    s << QByteArray::fromStdString(pb.SerializeAsString())
+      << song.beginning_nanosec() << song.length_nanosec()
+      << song.art_manual();
+  }
+  return ret;
+}
+
+bool DeserializeCueSheet(const QByteArray& data, const QString& cue_path,
+                         SongList* songs) {
+  QDataStream s(data);
+  s.setVersion(QDataStream::Qt_5_6);
+
+  int version = 0;
+  int count = 0;
+  s >> version >> count;
+  if (version != kCueSheetFormatVersion) return false;
+
+  for (int i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+    QByteArray message;
+    qint64 beginning = 0;
+    qint64 length = 0;
+    QString art_manual;
+    s >> message >> beginning >> length >> art_manual;
+
+    cpb::tagreader::SongMetadata pb;
+    if (!pb.ParseFromArray(message.constData(), message.size())) return false;
+
+    Song song;
+    song.InitFromProtobuf(pb);
+    song.set_beginning_nanosec(beginning);
+    song.set_length_nanosec(length);
+    song.set_art_manual(art_manual);
+    song.set_cue_path(cue_path);
+    *songs << song;
+  }
+  return s.status() == QDataStream::Ok;
+}
+
+}  // namespace
+
+bool LibraryBackend::GetCachedCueSheet(const QString& path, uint mtime,
+                                       qint64 size, SongList* songs) {
+  if (cue_sheets_table_.isEmpty()) return false;
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlQuery q(db_->ConnectReadOnly());
+  q.prepare(QString("SELECT songs FROM %1"
+                    " WHERE path = :path AND mtime = :mtime AND size = :size")
+                .arg(cue_sheets_table_));
+  q.bindValue(":path", path);
+  q.bindValue(":mtime", mtime);
+  q.bindValue(":size", size);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return false;
+
+  SongList ret;
+  if (!DeserializeCueSheet(q.value(0).toByteArray(), path, &ret)) {
+    return false;
+  }
+  *songs = ret;
+  return true;
+}
+
+void LibraryBackend::CacheCueSheet(const QString& path, uint mtime,
+                                   qint64 size, const SongList& songs) {
+  if (cue_sheets_table_.isEmpty()) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("INSERT OR REPLACE INTO %1 (path, mtime, size, songs)"
+                    " VALUES (:path, :mtime, :size, :songs)")
+                .arg(cue_sheets_table_));
+  q.bindValue(":path", path);
+  q.bindValue(":mtime", mtime);
+  q.bindValue(":size", size);
+  q.bindValue(":songs", SerializeCueSheet(songs));
+  q.exec();
+  db_->CheckErrors(q);
+}
+
+QHash<QString, uint> LibraryBackend::QuarantinedFiles() {
+  QHash<QString, uint> ret;
+  if (tag_reader_crashes_table_.isEmpty()) return ret;
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlQuery q(db_->ConnectReadOnly());
+  q.prepare(QString("SELECT path, mtime FROM %1 WHERE crashes >= :crashes")
+                .arg(tag_reader_crashes_table_));
+  q.bindValue(":crashes", kQuarantineCrashes);
+  q.exec();
+  if (db_->CheckErrors(q)) return ret;
+
+  while (q.next()) {
+    ret[q.value(0).toString()] = q.value(1).toUInt();
+  }
+  return ret;
+}
+
+void LibraryBackend::AddTagReaderCrash(const QStringList& files) {
+  if (tag_reader_crashes_table_.isEmpty() || files.isEmpty()) return;
+
+  // A whole batch of files, like the ones a playlist is loaded with, can't be
+  // blamed for one crash.  The batch is read again one file at a time, and
+  // whichever of them crashes the worker on its own is counted then.
+  if (files.count() != 1) {
+    qLog(Debug) << "Not counting a tag reader crash with" << files.count()
+                << "files in flight";
+    return;
+  }
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+  ScopedTransaction t(&db);
+
+  QSqlQuery select(db);
+  select.prepare(QString("SELECT mtime, crashes FROM %1 WHERE path = :path")
+                     .arg(tag_reader_crashes_table_));
+  QSqlQuery replace(db);
+  replace.prepare(QString("INSERT OR REPLACE INTO %1 (path, mtime, crashes)"
+                          " VALUES (:path, :mtime, :crashes)")
+                      .arg(tag_reader_crashes_table_));
+
+  for (const QString& file : files) {
+    const uint mtime = QFileInfo(file).lastModified().toTime_t();
+
+    // Earlier crashes only count if the file hasn't changed since.
+    int crashes = 0;
+    select.bindValue(":path", file);
+    select.exec();
+    if (db_->CheckErrors(select)) return;
+    if (select.next() && select.value(0).toUInt() == mtime) {
+      crashes = select.value(1).toInt();
+    }
+
+    crashes = qMax(crashes + 1, kQuarantineCrashes);
+    qLog(Warning) << "Quarantining" << file << "- it crashed the tag reader";
+
+    replace.bindValue(":path", file);
+    replace.bindValue(":mtime", mtime);
+    replace.bindValue(":crashes", crashes);
+    replace.exec();
+    if (db_->CheckErrors(replace)) return;
+  }
+
+  t.Commit();
+}
+
 void LibraryBackend::UpdateTotalSongCount() {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
@@ -262,6 +655,16 @@ void LibraryBackend::RemoveDirectory(int dir_id) {
   q.exec();
   if (db_->CheckErrors(q)) return;
 
+  // Forget about any scan of this directory that was interrupted
+  if (!scan_checkpoints_table_.isEmpty()) {
+    q = QSqlQuery(db);
+    q.prepare(QString("DELETE FROM %1 WHERE directory = :id")
+                  .arg(scan_checkpoints_table_));
+    q.bindValue(":id", dir_id);
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+
   // Now remove the directory itself
   q = QSqlQuery(db);
   q.prepare(QString("DELETE FROM %1 WHERE ROWID = :id").arg(dirs_table_));
@@ -305,6 +708,33 @@ void LibraryBackend::SongPathChanged(const Song& song,
   AddOrUpdateSongs(updated_songs);
 }
 
+void LibraryBackend::ReplaceSongsInDirectory(int directory_id,
+                                             const SongList& songs) {
+  QHash<QUrl, Song> old_songs;
+  for (const Song& song : FindSongsInDirectory(directory_id)) {
+    old_songs.insert(song.url(), song);
+  }
+
+  SongList new_songs;
+  new_songs.reserve(songs.count());
+  for (Song song : songs) {
+    const Song old_song = old_songs.take(song.url());
+    if (old_song.is_valid()) {
+      // Keep everything the device doesn't know about, like play counts.
+      song.set_id(old_song.id());
+      song.set_playcount(old_song.playcount());
+      song.set_skipcount(old_song.skipcount());
+      song.set_lastplayed(old_song.lastplayed());
+      song.set_rating(old_song.rating());
+    }
+    new_songs << song;
+  }
+
+  // Whatever's left has gone from the device.
+  if (!old_songs.isEmpty()) DeleteSongs(old_songs.values());
+  AddOrUpdateSongs(new_songs);
+}
+
 void LibraryBackend::AddOrUpdateSubdirs(const SubdirectoryList& subdirs) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
@@ -359,12 +789,14 @@ void LibraryBackend::AddOrUpdateSubdirs(const SubdirectoryList& subdirs) {
 }
 
 void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
+  if (songs.isEmpty()) return;
+
+  QElapsedTimer timer;
+  timer.start();
+
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
-  QSqlQuery check_dir(db);
-  check_dir.prepare(
-      QString("SELECT ROWID FROM %1 WHERE ROWID = :id").arg(dirs_table_));
   QSqlQuery add_song(db);
   add_song.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec +
                            ")"
@@ -387,22 +819,40 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
       QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id")
           .arg(fts_table_));
 
+  // Do a sanity check first - make sure the songs' directories still exist.
+  // This is to fix a possible race condition when a directory is removed
+  // while LibraryWatcher is scanning it.
+  QSet<int> directory_ids;
+  if (!dirs_table_.isEmpty()) {
+    QSqlQuery q(db);
+    q.prepare(QString("SELECT ROWID FROM %1").arg(dirs_table_));
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+    while (q.next()) directory_ids.insert(q.value(0).toInt());
+  }
+
+  // Get the previous data of all the songs that are being updated in one
+  // query.
+  QStringList update_ids;
+  for (const Song& song : songs) {
+    if (song.id() != -1) update_ids << QString::number(song.id());
+  }
+  QHash<int, Song> old_songs;
+  if (!update_ids.isEmpty()) {
+    for (const Song& old_song : GetSongsById(update_ids, db)) {
+      old_songs[old_song.id()] = old_song;
+    }
+  }
+
   ScopedTransaction transaction(&db);
 
   SongList added_songs;
   SongList deleted_songs;
+  int unchanged_count = 0;
 
   for (const Song& song : songs) {
-    // Do a sanity check first - make sure the song's directory still exists
-    // This is to fix a possible race condition when a directory is removed
-    // while LibraryWatcher is scanning it.
-    if (!dirs_table_.isEmpty()) {
-      check_dir.bindValue(":id", song.directory_id());
-      check_dir.exec();
-      if (db_->CheckErrors(check_dir)) continue;
-
-      if (!check_dir.next()) continue;  // Directory didn't exist
-    }
+    if (!dirs_table_.isEmpty() && !directory_ids.contains(song.directory_id()))
+      continue;  // Directory didn't exist
 
     if (song.id() == -1) {
       // Create
@@ -425,9 +875,16 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
       copy.set_id(id);
       added_songs << copy;
     } else {
-      // Get the previous song data first
-      Song old_song(GetSongById(song.id()));
-      if (!old_song.is_valid()) continue;
+      QHash<int, Song>::const_iterator it = old_songs.constFind(song.id());
+      if (it == old_songs.constEnd()) continue;
+      const Song& old_song = *it;
+
+      // Don't bother writing the row or telling the model about it if nothing
+      // that's stored in the database has changed.
+      if (old_song.IsRowDataEqual(song)) {
+        unchanged_count++;
+        continue;
+      }
 
       // Update
       song.BindToQuery(&update_song);
@@ -445,8 +902,17 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
     }
   }
 
+  UpdateAggregates(deleted_songs, added_songs, db);
+
   transaction.Commit();
 
+  const qint64 elapsed = timer.elapsed();
+  qLog(Debug) << "Wrote" << added_songs.count() << "songs to" << songs_table_
+              << "in" << elapsed << "ms ("
+              << (elapsed > 0 ? added_songs.count() * 1000 / elapsed
+                              : added_songs.count())
+              << "rows/s)," << unchanged_count << "unchanged";
+
   if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
 
   if (!added_songs.isEmpty()) emit SongsDiscovered(added_songs);
@@ -459,12 +925,16 @@ void LibraryBackend::UpdateMTimesOnly(const SongList& songs) {
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(db);
-  q.prepare(QString("UPDATE %1 SET mtime = :mtime WHERE ROWID = :id")
+  q.prepare(QString("UPDATE %1 SET mtime = :mtime,"
+                    " file_identity = :file_identity WHERE ROWID = :id")
                 .arg(songs_table_));
 
   ScopedTransaction transaction(&db);
   for (const Song& song : songs) {
     q.bindValue(":mtime", song.mtime());
+    q.bindValue(":file_identity", song.file_identity().isNull()
+                                      ? QVariant(QVariant::String)
+                                      : song.file_identity());
     q.bindValue(":id", song.id());
     q.exec();
     db_->CheckErrors(q);
@@ -472,6 +942,40 @@ void LibraryBackend::UpdateMTimesOnly(const SongList& songs) {
   transaction.Commit();
 }
 
+void LibraryBackend::UpdateReplayGain(const SongList& songs) {
+  if (songs.isEmpty()) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(QString("UPDATE %1 SET replaygain_track_gain = :track_gain,"
+                    " replaygain_track_peak = :track_peak,"
+                    " replaygain_album_gain = :album_gain,"
+                    " replaygain_album_peak = :album_peak"
+                    " WHERE ROWID = :id")
+                .arg(songs_table_));
+
+  // Values that weren't measured are stored as NULL.
+  auto value = [](float v) {
+    return std::isnan(v) ? QVariant(QVariant::Double) : QVariant(v);
+  };
+
+  ScopedTransaction transaction(&db);
+  for (const Song& song : songs) {
+    q.bindValue(":track_gain", value(song.replaygain_track_gain()));
+    q.bindValue(":track_peak", value(song.replaygain_track_peak()));
+    q.bindValue(":album_gain", value(song.replaygain_album_gain()));
+    q.bindValue(":album_peak", value(song.replaygain_album_peak()));
+    q.bindValue(":id", song.id());
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+  transaction.Commit();
+
+  emit SongsReplayGainChanged(songs);
+}
+
 void LibraryBackend::DeleteSongs(const SongList& songs) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
@@ -492,6 +996,7 @@ void LibraryBackend::DeleteSongs(const SongList& songs) {
     remove_fts.exec();
     db_->CheckErrors(remove_fts);
   }
+  UpdateAggregates(songs, SongList(), db);
   transaction.Commit();
 
   emit SongsDeleted(songs);
@@ -515,9 +1020,22 @@ void LibraryBackend::MarkSongsUnavailable(const SongList& songs,
     remove.exec();
     db_->CheckErrors(remove);
   }
+
+  // The songs passed in might already have the new flag set.
+  SongList changed_songs;
+  for (Song song : songs) {
+    song.set_unavailable(false);
+    changed_songs << song;
+  }
+  if (unavailable)
+    UpdateAggregates(changed_songs, SongList(), db);
+  else
+    UpdateAggregates(SongList(), changed_songs, db);
+
   transaction.Commit();
 
   emit SongsDeleted(songs);
+  emit SongsAvailabilityChanged(songs, unavailable);
   UpdateTotalSongCountAsync();
 }
 
@@ -527,7 +1045,7 @@ QStringList LibraryBackend::GetAll(const QString& column,
   query.SetColumnSpec("DISTINCT " + column);
   query.AddCompilationRequirement(false);
 
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
   if (!ExecQuery(&query)) return QStringList();
 
   QStringList ret;
@@ -556,7 +1074,7 @@ QStringList LibraryBackend::GetAllArtistsWithAlbums(const QueryOptions& opt) {
   query2.AddWhere("albumartist", "", "=");
 
   {
-    QMutexLocker l(db_->Mutex());
+    QMutexLocker l(db_->ReadMutex());
     if (!ExecQuery(&query) || !ExecQuery(&query2)) {
       return QStringList();
     }
@@ -607,7 +1125,7 @@ SongList LibraryBackend::GetSongs(const QString& artist, const QString& album,
 
 SongList LibraryBackend::ExecLibraryQuery(LibraryQuery* query) {
   query->SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
   if (!ExecQuery(query)) return SongList();
 
   SongList ret;
@@ -674,6 +1192,52 @@ SongList LibraryBackend::GetSongsByForeignId(const QStringList& ids,
   return ret.toList();
 }
 
+QString LibraryBackend::IdsCondition(const QString& column,
+                                     const QStringList& ids,
+                                     QSqlDatabase& db) {
+  // Rows of placeholders in each INSERT, under SQLite's limit on bound values.
+  static const int kIdsPerInsert = 500;
+
+  if (ids.count() <= kMaxInlineIds) {
+    QStringList numbers;
+    for (const QString& id : ids) numbers << QString::number(id.toInt());
+    return QString("%1 IN (%2)").arg(column, numbers.join(","));
+  }
+
+  // Temporary tables belong to the connection, so this one is only ever
+  // used by one thread at a time.  Filling it in a savepoint rather than a
+  // transaction works whether or not the caller is in a transaction already.
+  QSqlQuery create(db);
+  create.prepare(
+      "CREATE TEMP TABLE IF NOT EXISTS library_ids (id INTEGER PRIMARY KEY)");
+  create.exec();
+  QSqlQuery savepoint("SAVEPOINT library_ids", db);
+  QSqlQuery clear("DELETE FROM temp.library_ids", db);
+  if (db_->CheckErrors(create) || db_->CheckErrors(savepoint) ||
+      db_->CheckErrors(clear))
+    return "0";
+
+  for (int i = 0; i < ids.count(); i += kIdsPerInsert) {
+    const int count = qMin(kIdsPerInsert, ids.count() - i);
+
+    QStringList placeholders;
+    for (int j = 0; j < count; ++j) placeholders << "(?)";
+    std::shared_ptr<QSqlQuery> insert = db_->CachedQuery(
+        db, "INSERT OR IGNORE INTO temp.library_ids VALUES " +
+                placeholders.join(","));
+    for (int j = 0; j < count; ++j) {
+      insert->bindValue(j, ids[i + j].toInt());
+    }
+    insert->exec();
+    if (db_->CheckErrors(*insert)) break;
+  }
+
+  QSqlQuery release("RELEASE library_ids", db);
+  db_->CheckErrors(release);
+
+  return QString("%1 IN (SELECT id FROM temp.library_ids)").arg(column);
+}
+
 Song LibraryBackend::GetSongById(int id, QSqlDatabase& db) {
   SongList list = GetSongsById(QStringList() << QString::number(id), db);
   if (list.isEmpty()) return Song();
@@ -682,13 +1246,16 @@ Song LibraryBackend::GetSongById(int id, QSqlDatabase& db) {
 
 SongList LibraryBackend::GetSongsById(const QStringList& ids,
                                       QSqlDatabase& db) {
-  QString in = ids.join(",");
+  return GetSongsWhere(IdsCondition("ROWID", ids, db), db);
+}
 
+SongList LibraryBackend::GetSongsWhere(const QString& condition,
+                                       QSqlDatabase& db) {
   QSqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec +
                     " FROM %1"
-                    " WHERE ROWID IN (%2)")
-                .arg(songs_table_, in));
+                    " WHERE %2")
+                .arg(songs_table_, condition));
   q.exec();
   if (db_->CheckErrors(q)) return SongList();
 
@@ -731,6 +1298,40 @@ SongList LibraryBackend::GetSongsByUrl(const QUrl& url) {
   return songlist;
 }
 
+SongList LibraryBackend::GetSongsByUrls(const QList<QUrl>& urls) {
+  // SQLite limits how many values can be bound to one statement.
+  static const int kMaxUrlsPerQuery = 500;
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
+
+  SongList ret;
+  for (int i = 0; i < urls.count(); i += kMaxUrlsPerQuery) {
+    const QList<QUrl> chunk = urls.mid(i, kMaxUrlsPerQuery);
+
+    QStringList placeholders;
+    for (int j = 0; j < chunk.count(); ++j) placeholders << "?";
+
+    QSqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec +
+                      " FROM %1"
+                      " WHERE filename IN (%2) AND unavailable = 0")
+                  .arg(songs_table_, placeholders.join(",")));
+    for (const QUrl& url : chunk) {
+      q.addBindValue(url.toEncoded());
+    }
+    q.exec();
+    if (db_->CheckErrors(q)) return ret;
+
+    while (q.next()) {
+      Song song;
+      song.InitFromQuery(q, true);
+      ret << song;
+    }
+  }
+  return ret;
+}
+
 LibraryBackend::AlbumList LibraryBackend::GetCompilationAlbums(
     const QueryOptions& opt) {
   return GetAlbums(QString(), QString(), true, opt);
@@ -743,7 +1344,7 @@ SongList LibraryBackend::GetCompilationSongs(const QString& album,
   query.AddCompilationRequirement(true);
   query.AddWhere("album", album);
 
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
   if (!ExecQuery(&query)) return SongList();
 
   SongList ret;
@@ -820,6 +1421,8 @@ void LibraryBackend::UpdateCompilations() {
     }
   }
 
+  UpdateAggregates(deleted_songs, added_songs, db);
+
   transaction.Commit();
 
   if (!deleted_songs.isEmpty()) {
@@ -871,40 +1474,45 @@ LibraryBackend::AlbumList LibraryBackend::GetAlbums(const QString& artist,
                                                     const QueryOptions& opt) {
   AlbumList ret;
 
-  LibraryQuery query(opt);
-  query.SetColumnSpec(
-      "album, artist, albumartist, compilation, sampler, art_automatic, "
-      "art_manual, filename");
-  query.SetOrderBy("album");
-
-  if (compilation) {
-    query.AddCompilationRequirement(true);
-  } else if (!album_artist.isNull()) {
-    query.AddCompilationRequirement(false);
-    query.AddWhere("albumartist", album_artist);
-  } else if (!artist.isNull()) {
-    query.AddCompilationRequirement(false);
-    query.AddWhere("artist", artist);
-  }
+  QSqlQuery q;
+  if (CanUseAggregates(opt)) {
+    q = GetAggregateAlbums(artist, album_artist, compilation);
+    if (!q.isActive()) return ret;
+  } else {
+    LibraryQuery query(opt);
+    query.SetColumnSpec(
+        "album, artist, albumartist, compilation, sampler, art_automatic, "
+        "art_manual, filename");
+    query.SetOrderBy("album");
+
+    if (compilation) {
+      query.AddCompilationRequirement(true);
+    } else if (!album_artist.isNull()) {
+      query.AddCompilationRequirement(false);
+      query.AddWhere("albumartist", album_artist);
+    } else if (!artist.isNull()) {
+      query.AddCompilationRequirement(false);
+      query.AddWhere("artist", artist);
+    }
 
-  {
-    QMutexLocker l(db_->Mutex());
+    QMutexLocker l(db_->ReadMutex());
     if (!ExecQuery(&query)) return ret;
+    q = query;
   }
 
   QString last_album;
   QString last_artist;
   QString last_album_artist;
-  while (query.Next()) {
-    bool compilation = query.Value(3).toBool() || query.Value(4).toBool();
+  while (q.next()) {
+    bool compilation = q.value(3).toBool() || q.value(4).toBool();
 
     Album info;
-    info.artist = compilation ? QString() : query.Value(1).toString();
-    info.album_artist = compilation ? QString() : query.Value(2).toString();
-    info.album_name = query.Value(0).toString();
-    info.art_automatic = query.Value(5).toString();
-    info.art_manual = query.Value(6).toString();
-    info.first_url = QUrl::fromEncoded(query.Value(7).toByteArray());
+    info.artist = compilation ? QString() : q.value(1).toString();
+    info.album_artist = compilation ? QString() : q.value(2).toString();
+    info.album_name = q.value(0).toString();
+    info.art_automatic = q.value(5).toString();
+    info.art_manual = q.value(6).toString();
+    info.first_url = QUrl::fromEncoded(q.value(7).toByteArray());
 
     if ((info.artist == last_artist ||
          info.album_artist == last_album_artist) &&
@@ -921,6 +1529,229 @@ LibraryBackend::AlbumList LibraryBackend::GetAlbums(const QString& artist,
   return ret;
 }
 
+bool LibraryBackend::CanUseAggregates(const QueryOptions& opt) const {
+  return !aggregates_table_.isEmpty() && opt.filter().isEmpty() &&
+         opt.max_age() == -1 &&
+         opt.query_mode() == QueryOptions::QueryMode_All;
+}
+
+SqlRowList LibraryBackend::GetAggregateValues(const QString& column,
+                                              int compilation) {
+  SqlRowList ret;
+
+  QString sql =
+      QString("SELECT DISTINCT value FROM %1 WHERE kind = :kind")
+          .arg(aggregates_table_);
+  if (compilation != -1)
+    sql += QString(" AND effective_compilation = %1").arg(compilation);
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlQuery q(db_->ConnectReadOnly());
+  q.prepare(sql);
+  q.bindValue(":kind", column);
+  q.exec();
+  if (db_->CheckErrors(q)) return ret;
+
+  while (q.next()) {
+    ret << SqlRow(q);
+  }
+  return ret;
+}
+
+QSqlQuery LibraryBackend::GetAggregateAlbums(const QString& artist,
+                                             const QString& album_artist,
+                                             bool compilation) {
+  // Same columns as the LibraryQuery in GetAlbums.  The albums table doesn't
+  // keep the sampler flag separately but it's folded into
+  // effective_compilation.
+  QString sql = QString(
+                    "SELECT a.album, a.artist, a.albumartist,"
+                    "       a.effective_compilation, 0, s.art_automatic,"
+                    "       s.art_manual, s.filename"
+                    " FROM %1 AS a INNER JOIN %2 AS s"
+                    "   ON s.ROWID = a.first_song")
+                    .arg(albums_table_, songs_table_);
+  if (compilation) {
+    sql += " WHERE a.effective_compilation = 1";
+  } else if (!album_artist.isNull()) {
+    sql += " WHERE a.effective_compilation = 0 AND a.albumartist = :artist";
+  } else if (!artist.isNull()) {
+    sql += " WHERE a.effective_compilation = 0 AND a.artist = :artist";
+  }
+  sql += " ORDER BY a.album";
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlQuery q(db_->ConnectReadOnly());
+  q.prepare(sql);
+  if (!compilation && !album_artist.isNull()) {
+    q.bindValue(":artist", album_artist);
+  } else if (!compilation && !artist.isNull()) {
+    q.bindValue(":artist", artist);
+  }
+  q.exec();
+  db_->CheckErrors(q);
+  return q;
+}
+
+void LibraryBackend::UpdateAggregates(const SongList& removed,
+                                      const SongList& added, QSqlDatabase& db) {
+  if (aggregates_table_.isEmpty()) return;
+  if (removed.isEmpty() && added.isEmpty()) return;
+
+  QHash<int, const Song*> added_by_id;
+  for (const Song& song : added) {
+    if (!song.is_unavailable()) added_by_id[song.id()] = &song;
+  }
+
+  // Work out the net change to each row, and remember which rows might have
+  // lost the song they point to.
+  QHash<AggregateKey, AggregateDelta> deltas;
+  QList<QPair<AggregateKey, int>> stale;
+
+  for (const Song& song : removed) {
+    if (song.is_unavailable()) continue;
+
+    QList<AggregateKey> new_keys;
+    if (added_by_id.contains(song.id()))
+      new_keys = AggregateKeys(*added_by_id[song.id()]);
+
+    for (const AggregateKey& key : AggregateKeys(song)) {
+      deltas[key].song_count--;
+      if (!new_keys.contains(key)) stale << qMakePair(key, song.id());
+    }
+  }
+
+  for (const Song* song : added_by_id) {
+    for (const AggregateKey& key : AggregateKeys(*song)) {
+      AggregateDelta& delta = deltas[key];
+      delta.song_count++;
+      delta.first_song = qMin(delta.first_song, song->id());
+    }
+  }
+
+  QSqlQuery update(db);
+  update.prepare(QString("UPDATE %1 SET song_count = song_count + :delta,"
+                         " first_song = MIN(first_song, :first_song)"
+                         " WHERE kind = :kind AND value = :value"
+                         " AND effective_compilation = :compilation")
+                     .arg(aggregates_table_));
+  QSqlQuery insert(db);
+  insert.prepare(QString("INSERT INTO %1 (kind, value, effective_compilation,"
+                         " song_count, first_song)"
+                         " VALUES (:kind, :value, :compilation, :delta,"
+                         " :first_song)")
+                     .arg(aggregates_table_));
+  QSqlQuery update_album(db);
+  update_album.prepare(
+      QString("UPDATE %1 SET song_count = song_count + :delta,"
+              " first_song = MIN(first_song, :first_song)"
+              " WHERE album = :album AND artist = :artist"
+              " AND albumartist = :albumartist"
+              " AND effective_compilation = :compilation")
+          .arg(albums_table_));
+  QSqlQuery insert_album(db);
+  insert_album.prepare(
+      QString("INSERT INTO %1 (album, artist, albumartist,"
+              " effective_compilation, song_count, first_song)"
+              " VALUES (:album, :artist, :albumartist, :compilation, :delta,"
+              " :first_song)")
+          .arg(albums_table_));
+
+  for (auto it = deltas.constBegin(); it != deltas.constEnd(); ++it) {
+    const AggregateKey& key = it.key();
+    const AggregateDelta& delta = it.value();
+    if (delta.song_count == 0 &&
+        delta.first_song == std::numeric_limits<int>::max())
+      continue;
+
+    QSqlQuery& q = key.kind.isEmpty() ? update_album : update;
+    q.bindValue(":delta", delta.song_count);
+    q.bindValue(":first_song", delta.first_song);
+    q.bindValue(":compilation", key.compilation);
+    if (key.kind.isEmpty()) {
+      q.bindValue(":album", key.value);
+      q.bindValue(":artist", key.artist);
+      q.bindValue(":albumartist", key.albumartist);
+    } else {
+      q.bindValue(":kind", key.kind);
+      q.bindValue(":value", key.value);
+    }
+    q.exec();
+    if (db_->CheckErrors(q)) continue;
+    if (q.numRowsAffected() > 0 || delta.song_count <= 0) continue;
+
+    QSqlQuery& i = key.kind.isEmpty() ? insert_album : insert;
+    i.bindValue(":delta", delta.song_count);
+    i.bindValue(":first_song", delta.first_song);
+    i.bindValue(":compilation", key.compilation);
+    if (key.kind.isEmpty()) {
+      i.bindValue(":album", key.value);
+      i.bindValue(":artist", key.artist);
+      i.bindValue(":albumartist", key.albumartist);
+    } else {
+      i.bindValue(":kind", key.kind);
+      i.bindValue(":value", key.value);
+    }
+    i.exec();
+    db_->CheckErrors(i);
+  }
+
+  QSqlQuery q(db);
+  q.exec(QString("DELETE FROM %1 WHERE song_count <= 0").arg(aggregates_table_));
+  db_->CheckErrors(q);
+  q.exec(QString("DELETE FROM %1 WHERE song_count <= 0").arg(albums_table_));
+  db_->CheckErrors(q);
+
+  // Point rows whose first song went away at another one of their songs.  This
+  // needs a scan of the songs table, but only happens for the few rows that
+  // were pointing at a song that changed.
+  for (const QPair<AggregateKey, int>& entry : stale) {
+    const AggregateKey& key = entry.first;
+
+    QSqlQuery fix(db);
+    if (key.kind.isEmpty()) {
+      fix.prepare(
+          QString("UPDATE %1 SET first_song = (SELECT MIN(ROWID) FROM %2"
+                  "   WHERE IFNULL(album, '') = :album"
+                  "   AND IFNULL(artist, '') = :artist"
+                  "   AND IFNULL(albumartist, '') = :albumartist"
+                  "   AND effective_compilation = :compilation"
+                  "   AND unavailable = 0)"
+                  " WHERE album = :row_album AND artist = :row_artist"
+                  " AND albumartist = :row_albumartist"
+                  " AND effective_compilation = :row_compilation"
+                  " AND first_song = :id")
+              .arg(albums_table_, songs_table_));
+      fix.bindValue(":album", key.value);
+      fix.bindValue(":artist", key.artist);
+      fix.bindValue(":albumartist", key.albumartist);
+      fix.bindValue(":row_album", key.value);
+      fix.bindValue(":row_artist", key.artist);
+      fix.bindValue(":row_albumartist", key.albumartist);
+    } else {
+      fix.prepare(
+          QString("UPDATE %1 SET first_song = (SELECT MIN(ROWID) FROM %2"
+                  "   WHERE IFNULL(%3, '') = :value"
+                  "   AND effective_compilation = :compilation"
+                  "   AND unavailable = 0)"
+                  " WHERE kind = :kind AND value = :row_value"
+                  " AND effective_compilation = :row_compilation"
+                  " AND first_song = :id")
+              .arg(aggregates_table_, songs_table_, key.kind));
+      fix.bindValue(":value", key.value);
+      fix.bindValue(":kind", key.kind);
+      fix.bindValue(":row_value", key.value);
+    }
+    // Only the row of the key the song left: the row it moved to may point at
+    // it now too.
+    fix.bindValue(":compilation", key.compilation);
+    fix.bindValue(":row_compilation", key.compilation);
+    fix.bindValue(":id", entry.second);
+    fix.exec();
+    db_->CheckErrors(fix);
+  }
+}
+
 LibraryBackend::Album LibraryBackend::GetAlbumArt(const QString& artist,
                                                   const QString& albumartist,
                                                   const QString& album) {
@@ -938,7 +1769,7 @@ LibraryBackend::Album LibraryBackend::GetAlbumArt(const QString& artist,
   }
   query.AddWhere("album", album);
 
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
   if (!ExecQuery(&query)) return ret;
 
   if (query.Next()) {
@@ -1078,6 +1909,8 @@ void LibraryBackend::ForceCompilation(const QString& album,
     }
   }
 
+  UpdateAggregates(deleted_songs, added_songs, db);
+
   if (!added_songs.isEmpty() || !deleted_songs.isEmpty()) {
     emit SongsDeleted(deleted_songs);
     emit SongsDiscovered(added_songs);
@@ -1085,7 +1918,14 @@ void LibraryBackend::ForceCompilation(const QString& album,
 }
 
 bool LibraryBackend::ExecQuery(LibraryQuery* q) {
-  return !db_->CheckErrors(q->Exec(db_->Connect(), songs_table_, fts_table_));
+  QSqlDatabase db(db_->ConnectReadOnly());
+
+  QElapsedTimer timer;
+  timer.start();
+  QSqlQuery query = q->Exec(db_, db, songs_table_, fts_table_);
+  db_->RecordQueryTime(query, db, timer.elapsed());
+
+  return !db_->CheckErrors(query);
 }
 
 SongList LibraryBackend::FindSongs(const smart_playlists::Search& search) {
@@ -1099,7 +1939,11 @@ SongList LibraryBackend::FindSongs(const smart_playlists::Search& search) {
   SongList ret;
   QSqlQuery query(db);
   query.prepare(sql);
+
+  QElapsedTimer timer;
+  timer.start();
   query.exec();
+  db_->RecordQueryTime(query, db, timer.elapsed());
   if (db_->CheckErrors(query)) return ret;
 
   // Read the results
@@ -1111,6 +1955,50 @@ SongList LibraryBackend::FindSongs(const smart_playlists::Search& search) {
   return ret;
 }
 
+QList<int> LibraryBackend::FindSongIds(
+    const smart_playlists::Search& search) {
+  smart_playlists::Search ids_search = search;
+  ids_search.ids_only_ = true;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QList<int> ret;
+  QSqlQuery query(db);
+  query.prepare(ids_search.ToSql(songs_table()));
+
+  QElapsedTimer timer;
+  timer.start();
+  query.exec();
+  db_->RecordQueryTime(query, db, timer.elapsed());
+  if (db_->CheckErrors(query)) return ret;
+
+  while (query.next()) {
+    ret << query.value(0).toInt();
+  }
+  return ret;
+}
+
+int LibraryBackend::CountSongs(const smart_playlists::Search& search) {
+  smart_playlists::Search ids_search = search;
+  ids_search.ids_only_ = true;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery query(db);
+  query.prepare("SELECT COUNT(*) FROM (" + ids_search.ToSql(songs_table()) +
+                ")");
+
+  QElapsedTimer timer;
+  timer.start();
+  query.exec();
+  db_->RecordQueryTime(query, db, timer.elapsed());
+  if (db_->CheckErrors(query) || !query.next()) return 0;
+
+  return query.value(0).toInt();
+}
+
 SongList LibraryBackend::GetAllSongs() {
   // Get all the songs!
   return FindSongs(smart_playlists::Search(
@@ -1198,18 +2086,219 @@ void LibraryBackend::UpdateSongsRating(const QList<int>& id_list,
   for (int i : id_list) {
     id_str_list << QString::number(i);
   }
-  QString ids = id_str_list.join(",");
+  // The same condition finds the songs again afterwards, so a long list is
+  // only loaded into the id table once.
+  const QString condition = IdsCondition("ROWID", id_str_list, db);
+
   QSqlQuery q(db);
   q.prepare(QString("UPDATE %1 SET rating = :rating"
-                    " WHERE ROWID IN (%2)")
-                .arg(songs_table_, ids));
+                    " WHERE %2")
+                .arg(songs_table_, condition));
   q.bindValue(":rating", rating);
   q.exec();
   if (db_->CheckErrors(q)) return;
-  SongList new_song_list = GetSongsById(id_str_list, db);
+  SongList new_song_list = GetSongsWhere(condition, db);
   emit SongsRatingChanged(new_song_list);
 }
 
+void LibraryBackend::FlushStatistics() {
+  QMap<int, PendingStatistics> pending;
+  {
+    QMutexLocker l(&pending_statistics_mutex_);
+    pending.swap(pending_statistics_);
+  }
+  if (pending.isEmpty()) return;
+
+  SongList statistics_changed;
+  SongList ratings_changed;
+  {
+    QMutexLocker l(db_->Mutex());
+    QSqlDatabase db(db_->Connect());
+    ScopedTransaction t(&db);
+
+    std::shared_ptr<QSqlQuery> reset = db_->CachedQuery(
+        db, QString("UPDATE %1 SET playcount = 0, skipcount = 0,"
+                    "              lastplayed = -1, score = 0"
+                    " WHERE ROWID = :id")
+                .arg(songs_table_));
+    std::shared_ptr<QSqlQuery> play = db_->CachedQuery(
+        db, QString("UPDATE %1 SET playcount = playcount + 1,"
+                    "              lastplayed = :now,"
+                    "              score = " +
+                    QString(kNewScoreSql).arg("1.0") + " WHERE ROWID = :id")
+                .arg(songs_table_));
+
+    QStringList statistics_ids;
+    QMap<float, QStringList> ids_by_rating;
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+      const PendingStatistics& p = it.value();
+      if (p.has_rating) ids_by_rating[p.rating] << QString::number(it.key());
+      if (!p.reset && p.events.isEmpty()) continue;
+      statistics_ids << QString::number(it.key());
+
+      if (p.reset) {
+        reset->bindValue(":id", it.key());
+        reset->exec();
+        if (db_->CheckErrors(*reset)) {
+          RequeueStatistics(pending);
+          return;
+        }
+      }
+
+      for (const PendingStatistics::Event& event : p.events) {
+        if (!event.skip) {
+          play->bindValue(":now", event.time);
+          play->bindValue(":id", it.key());
+          play->exec();
+          if (db_->CheckErrors(*play)) {
+            RequeueStatistics(pending);
+            return;
+          }
+          continue;
+        }
+
+        // The progress is part of the score's expression, so each one is a
+        // different statement.
+        QSqlQuery skip(db);
+        skip.prepare(QString("UPDATE %1 SET skipcount = skipcount + 1,"
+                             "              score = " +
+                             QString(kNewScoreSql).arg(event.progress) +
+                             " WHERE ROWID = :id")
+                         .arg(songs_table_));
+        skip.bindValue(":id", it.key());
+        skip.exec();
+        if (db_->CheckErrors(skip)) {
+          RequeueStatistics(pending);
+          return;
+        }
+      }
+    }
+
+    QStringList rating_ids;
+    for (auto it = ids_by_rating.constBegin(); it != ids_by_rating.constEnd();
+         ++it) {
+      QSqlQuery q(db);
+      q.prepare(QString("UPDATE %1 SET rating = :rating WHERE %2")
+                    .arg(songs_table_, IdsCondition("ROWID", it.value(), db)));
+      q.bindValue(":rating", it.key());
+      q.exec();
+      if (db_->CheckErrors(q)) {
+        RequeueStatistics(pending);
+        return;
+      }
+      rating_ids << it.value();
+    }
+
+    if (!statistics_ids.isEmpty()) {
+      statistics_changed =
+          GetSongsWhere(IdsCondition("ROWID", statistics_ids, db), db);
+    }
+    if (!rating_ids.isEmpty()) {
+      ratings_changed =
+          GetSongsWhere(IdsCondition("ROWID", rating_ids, db), db);
+    }
+
+    t.Commit();
+  }
+
+  if (!statistics_changed.isEmpty()) {
+    emit SongsStatisticsChanged(statistics_changed);
+  }
+  if (!ratings_changed.isEmpty()) emit SongsRatingChanged(ratings_changed);
+}
+
+void LibraryBackend::RequeueStatistics(
+    const QMap<int, PendingStatistics>& failed) {
+  bool was_empty = false;
+  {
+    QMutexLocker l(&pending_statistics_mutex_);
+    was_empty = pending_statistics_.isEmpty();
+    for (auto it = failed.constBegin(); it != failed.constEnd(); ++it) {
+      PendingStatistics* pending = &pending_statistics_[it.key()];
+      PendingStatistics merged = it.value();
+
+      // Anything queued since happened after the failed changes.
+      if (pending->reset) {
+        merged.reset = true;
+        merged.events = pending->events;
+      } else {
+        merged.events << pending->events;
+      }
+      if (pending->has_rating) {
+        merged.has_rating = true;
+        merged.rating = pending->rating;
+      }
+      *pending = merged;
+    }
+  }
+
+  if (was_empty) StartStatisticsFlushTimer();
+}
+
+LibraryBackend::BulkReplace::BulkReplace(LibraryBackend* backend)
+    : backend_(backend),
+      lock_(backend->db_->Mutex()),
+      db_(backend->db_->Connect()),
+      transaction_(&db_),
+      add_song_(db_),
+      add_song_fts_(db_),
+      count_(0),
+      failed_(false) {
+  Q_ASSERT(backend_->aggregates_table_.isEmpty());
+  timer_.start();
+
+  for (const QString& table : QStringList()
+                                  << backend_->songs_table_
+                                  << backend_->fts_table_) {
+    QSqlQuery q("DELETE FROM " + table, db_);
+    q.exec();
+    if (backend_->db_->CheckErrors(q)) failed_ = true;
+  }
+
+  add_song_.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec +
+                            ") VALUES (" + Song::kBindSpec + ")")
+                        .arg(backend_->songs_table_));
+  add_song_fts_.prepare(QString("INSERT INTO %1 (ROWID, " +
+                                Song::kFtsColumnSpec + ") VALUES (:id, " +
+                                Song::kFtsBindSpec + ")")
+                            .arg(backend_->fts_table_));
+}
+
+bool LibraryBackend::BulkReplace::Add(const Song& song) {
+  if (failed_) return false;
+
+  song.BindToQuery(&add_song_);
+  add_song_.exec();
+  if (backend_->db_->CheckErrors(add_song_)) {
+    failed_ = true;
+    return false;
+  }
+
+  add_song_fts_.bindValue(":id", add_song_.lastInsertId());
+  song.BindToFtsQuery(&add_song_fts_);
+  add_song_fts_.exec();
+  if (backend_->db_->CheckErrors(add_song_fts_)) {
+    failed_ = true;
+    return false;
+  }
+
+  ++count_;
+  return true;
+}
+
+bool LibraryBackend::BulkReplace::Commit() {
+  if (failed_) return false;
+  transaction_.Commit();
+
+  const qint64 elapsed = timer_.elapsed();
+  qLog(Debug) << "Replaced" << backend_->songs_table_ << "with" << count_
+              << "songs in" << elapsed << "ms";
+
+  emit backend_->DatabaseReset();
+  backend_->UpdateTotalSongCountAsync();
+  return true;
+}
+
 void LibraryBackend::DeleteAll() {
   {
     QMutexLocker l(db_->Mutex());
@@ -1224,6 +2313,16 @@ void LibraryBackend::DeleteAll() {
     q.exec();
     if (db_->CheckErrors(q)) return;
 
+    if (!aggregates_table_.isEmpty()) {
+      q = QSqlQuery("DELETE FROM " + aggregates_table_, db);
+      q.exec();
+      if (db_->CheckErrors(q)) return;
+
+      q = QSqlQuery("DELETE FROM " + albums_table_, db);
+      q.exec();
+      if (db_->CheckErrors(q)) return;
+    }
+
     t.Commit();
   }
 
@@ -18,14 +18,24 @@
 #ifndef LIBRARYBACKEND_H
 #define LIBRARYBACKEND_H
 
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QObject>
 #include <QSet>
+#include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QUrl>
+#include <functional>
 
+#include "core/scopedtransaction.h"
 #include "core/song.h"
 #include "directory.h"
 #include "libraryquery.h"
+#include "sqlrow.h"
 
 class Database;
 
@@ -106,6 +116,8 @@ class LibraryBackendInterface : public QObject {
                             const QString& album) = 0;
 
   virtual Song GetSongById(int id) = 0;
+  // Returns the songs with the given ids that exist, in no particular order.
+  virtual SongList GetSongsById(const QList<int>& ids) = 0;
 
   // Returns all sections of a song with the given filename. If there's just one
   // section
@@ -117,6 +129,9 @@ class LibraryBackendInterface : public QObject {
   // Using default beginning value is suitable when searching for single-section
   // songs.
   virtual Song GetSongByUrl(const QUrl& url, qint64 beginning = 0) = 0;
+  // Returns all sections of all songs with any of the given filenames, in no
+  // particular order.  Much faster than calling GetSongsByUrl for each one.
+  virtual SongList GetSongsByUrls(const QList<QUrl>& urls) = 0;
 
   virtual void AddDirectory(const QString& path) = 0;
   virtual void RemoveDirectory(int dir_id) = 0;
@@ -131,6 +146,7 @@ class LibraryBackend : public LibraryBackendInterface {
   static const char* kSettingsGroup;
 
   Q_INVOKABLE LibraryBackend(QObject* parent = nullptr);
+  ~LibraryBackend();
   void Init(Database* db, const QString& songs_table, const QString& fts_table);
   void Init(Database* db, const QString& songs_table, const QString& dirs_table,
             const QString& subdirs_table, const QString& fts_table);
@@ -141,6 +157,58 @@ class LibraryBackend : public LibraryBackendInterface {
   QString dirs_table() const { return dirs_table_; }
   QString subdirs_table() const { return subdirs_table_; }
 
+  // Subdirectories that were scanned by a scan that hasn't finished yet are
+  // recorded here so that an interrupted scan can be resumed.  Checkpoints are
+  // disabled if no table is set.
+  void set_scan_checkpoints_table(const QString& table) {
+    scan_checkpoints_table_ = table;
+  }
+  bool has_scan_checkpoints() const {
+    return !scan_checkpoints_table_.isEmpty();
+  }
+
+  // The songs each cue sheet was parsed into are cached here, along with the
+  // sheet's mtime and size, so sheets that haven't changed don't have to be
+  // parsed again by every scan.  The cache is disabled if no table is set.
+  void set_cue_sheets_table(const QString& table) { cue_sheets_table_ = table; }
+  // Returns false if the sheet at path isn't cached with this mtime and size.
+  bool GetCachedCueSheet(const QString& path, uint mtime, qint64 size,
+                         SongList* songs);
+  void CacheCueSheet(const QString& path, uint mtime, qint64 size,
+                     const SongList& songs);
+
+  // Files that crashed a tag reader worker are counted here.  A file is
+  // quarantined, and skipped by scans until its mtime changes, when it was
+  // the only one being read by the worker.  Crashes with several files in
+  // flight aren't counted, since any one of them could be innocent.
+  // Disabled if no table is set.
+  static const int kQuarantineCrashes;
+  void set_tag_reader_crashes_table(const QString& table) {
+    tag_reader_crashes_table_ = table;
+  }
+  // Returns the quarantined files with the mtime they had when they crashed.
+  QHash<QString, uint> QuarantinedFiles();
+
+  // Song counts per artist, album artist, album and genre are kept up to date
+  // in these tables so that unfiltered views of the whole library don't have
+  // to scan every song.  They're only maintained if the tables are set.
+  void set_aggregate_tables(const QString& aggregates_table,
+                            const QString& albums_table) {
+    aggregates_table_ = aggregates_table;
+    albums_table_ = albums_table;
+  }
+
+  // The columns that have an entry in the aggregates table.  Null terminated.
+  static const char* kAggregateColumns[];
+
+  // Whether queries with these options can be answered from the aggregate
+  // tables.
+  bool CanUseAggregates(const QueryOptions& opt) const;
+  // Distinct values of one of kAggregateColumns across all available songs.
+  // compilation is 0 or 1 to only consider songs with that
+  // effective_compilation, or -1 for all songs.
+  SqlRowList GetAggregateValues(const QString& column, int compilation = -1);
+
   // Get a list of directories in the library.  Emits DirectoriesDiscovered.
   void LoadDirectoriesAsync();
 
@@ -149,6 +217,7 @@ class LibraryBackend : public LibraryBackendInterface {
 
   SongList FindSongsInDirectory(int id);
   SubdirectoryList SubdirsInDirectory(int id);
+  SubdirectoryList ScanCheckpoint(int id);
   DirectoryList GetAllDirectories();
   void ChangeDirPath(int id, const QString& old_path, const QString& new_path);
 
@@ -185,6 +254,7 @@ class LibraryBackend : public LibraryBackendInterface {
 
   SongList GetSongsByUrl(const QUrl& url);
   Song GetSongByUrl(const QUrl& url, qint64 beginning = 0);
+  SongList GetSongsByUrls(const QList<QUrl>& urls);
 
   void AddDirectory(const QString& path);
   void RemoveDirectory(int dir_id);
@@ -192,24 +262,75 @@ class LibraryBackend : public LibraryBackendInterface {
   bool ExecQuery(LibraryQuery* q);
   SongList ExecLibraryQuery(LibraryQuery* query);
   SongList FindSongs(const smart_playlists::Search& search);
+  // Returns the IDs of every song matching the search, in no particular order.
+  QList<int> FindSongIds(const smart_playlists::Search& search);
+  // How many songs match the search, ignoring its limit.
+  int CountSongs(const smart_playlists::Search& search);
   SongList GetAllSongs();
 
+  // These are kept for kStatisticsFlushMsec and then written together in one
+  // transaction, with one SongsStatisticsChanged and one SongsRatingChanged
+  // for everything that changed.
   void IncrementPlayCountAsync(int id);
   void IncrementSkipCountAsync(int id, float progress);
   void ResetStatisticsAsync(int id);
   void UpdateSongRatingAsync(int id, float rating);
   void UpdateSongsRatingAsync(const QList<int>& ids, float rating);
+  // Stores the songs' ReplayGain values, and nothing else about them.
+  void UpdateReplayGainAsync(const SongList& songs);
 
   void DeleteAll();
 
+  // Replaces every song with the ones given to Add, for loading a whole
+  // catalogue.  The tables are emptied and the songs inserted in one
+  // transaction, with one prepared statement for each table and nothing
+  // looked up first.  Songs are written as they're added so the caller
+  // doesn't have to keep them.  Holds the database lock while it exists, and
+  // keeps the old songs if it's destroyed before Commit.  Only for backends
+  // without aggregate tables.
+  class BulkReplace {
+   public:
+    explicit BulkReplace(LibraryBackend* backend);
+
+    // Returns false if the song couldn't be written.  Nothing more can be
+    // added after that.
+    bool Add(const Song& song);
+    // Emits DatabaseReset.  Returns false if anything failed.
+    bool Commit();
+
+   private:
+    Q_DISABLE_COPY(BulkReplace)
+
+    LibraryBackend* backend_;
+    QMutexLocker lock_;
+    QSqlDatabase db_;
+    ScopedTransaction transaction_;
+    QSqlQuery add_song_;
+    QSqlQuery add_song_fts_;
+    QElapsedTimer timer_;
+    int count_;
+    bool failed_;
+  };
+
+  // Indexes the songs table on columns, followed by effective_compilation and
+  // unavailable, so LibraryModel can expand a grouping over those columns with
+  // a range scan.  Does nothing if the index already exists.
+  void EnsureGroupingIndexAsync(const QStringList& columns);
+
  public slots:
   void LoadDirectories();
   void UpdateTotalSongCount();
   void AddOrUpdateSongs(const SongList& songs);
+  // Makes the directory hold exactly these songs.  Songs are matched to the
+  // ones already there by URL, so only the ones that changed are written.
+  void ReplaceSongsInDirectory(int directory_id, const SongList& songs);
   void UpdateMTimesOnly(const SongList& songs);
   void DeleteSongs(const SongList& songs);
   void MarkSongsUnavailable(const SongList& songs, bool unavailable = true);
   void AddOrUpdateSubdirs(const SubdirectoryList& subdirs);
+  void AddScanCheckpoint(const SubdirectoryList& subdirs);
+  void ClearScanCheckpoint(int dir_id);
+  void AddTagReaderCrash(const QStringList& files);
   void UpdateCompilations();
   void UpdateManualAlbumArt(const QString& artist, const QString& albumartist,
                             const QString& album, const QString& art);
@@ -220,6 +341,11 @@ class LibraryBackend : public LibraryBackendInterface {
   void ResetStatistics(int id);
   void UpdateSongRating(int id, float rating);
   void UpdateSongsRating(const QList<int>& id_list, float rating);
+  void UpdateReplayGain(const SongList& songs);
+  void EnsureGroupingIndex(const QStringList& columns);
+  // Writes everything given to the statistics and rating *Async methods so
+  // far.
+  void FlushStatistics();
   // Tells the library model that a song path has changed
   void SongPathChanged(const Song& song, const QFileInfo& new_file);
 
@@ -230,12 +356,19 @@ class LibraryBackend : public LibraryBackendInterface {
 
   void SongsDiscovered(const SongList& songs);
   void SongsDeleted(const SongList& songs);
+  // The library watcher found that these songs' files have gone, or come
+  // back.
+  void SongsAvailabilityChanged(const SongList& songs, bool unavailable);
   void SongsStatisticsChanged(const SongList& songs);
   void SongsRatingChanged(const SongList& songs);
+  void SongsReplayGainChanged(const SongList& songs);
   void DatabaseReset();
 
   void TotalSongCountUpdated(int total);
 
+ private slots:
+  void StartStatisticsFlushTimer();
+
  private:
   struct CompilationInfo {
     CompilationInfo() : has_samplers(0), has_not_samplers(0) {}
@@ -247,7 +380,41 @@ class LibraryBackend : public LibraryBackendInterface {
     int has_not_samplers;
   };
 
+  // What the statistics and rating *Async methods have been asked to do to
+  // one song since the last flush.
+  struct PendingStatistics {
+    PendingStatistics() : reset(false), has_rating(false), rating(0) {}
+
+    // A play, with the time it was played, or a skip, with how far through
+    // the song it was.
+    struct Event {
+      bool skip;
+      float progress;
+      uint time;
+    };
+
+    bool reset;
+    // Plays and skips since the reset, if there was one, in order.  The
+    // score depends on the order.
+    QList<Event> events;
+    bool has_rating;
+    float rating;
+  };
+
   static const char* kNewScoreSql;
+  static const int kStatisticsFlushMsec;
+
+  // Adds the change for each song to pending_statistics_, and starts the
+  // flush timer if nothing was waiting.  Safe to call from any thread.
+  void QueueStatistics(const QList<int>& ids,
+                       std::function<void(PendingStatistics*)> change);
+  // Puts changes that couldn't be written back in front of the ones queued
+  // since, so they're tried again with the next flush.
+  void RequeueStatistics(const QMap<int, PendingStatistics>& failed);
+
+  // Lists of more ids than this are put in a temporary table rather than
+  // written out in the SQL.
+  static const int kMaxInlineIds;
 
   void UpdateCompilations(const QSqlDatabase& db, SongList& deleted_songs,
                           SongList& added_songs, const QUrl& url,
@@ -259,6 +426,19 @@ class LibraryBackend : public LibraryBackendInterface {
 
   Song GetSongById(int id, QSqlDatabase& db);
   SongList GetSongsById(const QStringList& ids, QSqlDatabase& db);
+  // A condition on column that matches the ids, for a WHERE clause.  Long
+  // lists are loaded into a temporary table on db and matched against that.
+  QString IdsCondition(const QString& column, const QStringList& ids,
+                       QSqlDatabase& db);
+  SongList GetSongsWhere(const QString& condition, QSqlDatabase& db);
+
+  QSqlQuery GetAggregateAlbums(const QString& artist,
+                               const QString& album_artist, bool compilation);
+  // removed holds songs as they were before a change to the songs table and
+  // added the same or other songs as they are now.  Must be called inside the
+  // same transaction as the change.
+  void UpdateAggregates(const SongList& removed, const SongList& added,
+                        QSqlDatabase& db);
 
  private:
   Database* db_;
@@ -266,8 +446,20 @@ class LibraryBackend : public LibraryBackendInterface {
   QString dirs_table_;
   QString subdirs_table_;
   QString fts_table_;
+  QString scan_checkpoints_table_;
+  QString cue_sheets_table_;
+  QString tag_reader_crashes_table_;
+  QString aggregates_table_;
+  QString albums_table_;
   bool save_statistics_in_file_;
   bool save_ratings_in_file_;
+
+  // Names of the grouping indexes known to exist.  Only used on the backend's
+  // thread.
+  QSet<QString> grouping_indexes_;
+
+  QMutex pending_statistics_mutex_;
+  QMap<int, PendingStatistics> pending_statistics_;
 };
 
 #endif  // LIBRARYBACKEND_H
@@ -348,13 +348,20 @@ void LibraryFilterWidget::FilterTextChanged(const QString& text) {
   // even with FTS, so if there are a large number of songs in the database
   // introduce a small delay before actually filtering the model, so if the
   // user is typing the first few characters of something it will be quicker.
-  const bool delay =
-      (delay_behaviour_ == AlwaysDelayed) ||
-      (delay_behaviour_ == DelayedOnLargeLibraries && !text.isEmpty() &&
-       text.length() < 3 && model_->total_song_count() >= 100000);
+  // Otherwise only wait long enough to see if another key is coming, so a
+  // word typed quickly is only searched for once.  Clearing the filter is
+  // done straight away.
+  int delay_msec = 0;
+  if (delay_behaviour_ == AlwaysDelayed) {
+    delay_msec = kFilterDelay;
+  } else if (delay_behaviour_ == DelayedOnLargeLibraries && !text.isEmpty()) {
+    delay_msec = text.length() < 3 && model_->total_song_count() >= 100000
+                     ? kFilterDelay
+                     : kTypingDelay;
+  }
 
-  if (delay) {
-    filter_delay_->start();
+  if (delay_msec) {
+    filter_delay_->start(delay_msec);
   } else {
     filter_delay_->stop();
     FilterDelayTimeout();
@@ -42,9 +42,13 @@ class LibraryFilterWidget : public QWidget {
   ~LibraryFilterWidget();
 
   static const int kFilterDelay = 500;  // msec
+  // How long to wait for the next key while typing.
+  static const int kTypingDelay = 150;  // msec
 
   enum DelayBehaviour {
     AlwaysInstant,
+    // Waits for typing to stop, and longer for short filters on large
+    // libraries.
     DelayedOnLargeLibraries,
     AlwaysDelayed,
   };
@@ -18,18 +18,19 @@
 #include "librarymodel.h"
 
 #include <QFuture>
+#include <QHash>
 #include <QIODevice>
 #include <QMetaEnum>
-#include <QNetworkCacheMetaData>
-#include <QNetworkDiskCache>
 #include <QPixmapCache>
 #include <QSettings>
 #include <QStringList>
+#include <QTimer>
 #include <QUrl>
 #include <QtConcurrentRun>
 #include <algorithm>
 #include <functional>
 
+#include "albumiconatlas.h"
 #include "core/application.h"
 #include "core/database.h"
 #include "core/logging.h"
@@ -61,13 +62,78 @@ const char* LibraryModel::kSmartPlaylistsSettingsGroup =
 const char* LibraryModel::kSavedGroupingsSettingsGroup = "SavedGroupings";
 const int LibraryModel::kSmartPlaylistsVersion = 4;
 const int LibraryModel::kPrettyCoverSize = 32;
-const qint64 LibraryModel::kIconCacheSize = 100000000;  //~100MB
+const int LibraryModel::kFetchChunkSize = 500;
+const int LibraryModel::kIconAtlasMaxTiles = 16384;  // ~64MB
 
 static bool IsArtistGroupBy(const LibraryModel::GroupBy by) {
   return by == LibraryModel::GroupBy_Artist ||
          by == LibraryModel::GroupBy_AlbumArtist;
 }
 
+// The columns FilterQuery() adds to the WHERE clause for this type, which are
+// also the ones InitQuery() selects.
+static QStringList GroupByColumns(const LibraryModel::GroupBy type) {
+  switch (type) {
+    case LibraryModel::GroupBy_Artist:
+      return QStringList() << "artist";
+    case LibraryModel::GroupBy_Album:
+      return QStringList() << "album";
+    case LibraryModel::GroupBy_YearAlbum:
+      return QStringList() << "year"
+                           << "album"
+                           << "grouping";
+    case LibraryModel::GroupBy_OriginalYearAlbum:
+      return QStringList() << "year"
+                           << "originalyear"
+                           << "album"
+                           << "grouping";
+    case LibraryModel::GroupBy_Year:
+      return QStringList() << "year";
+    case LibraryModel::GroupBy_OriginalYear:
+      return QStringList() << "effective_originalyear";
+    case LibraryModel::GroupBy_Composer:
+      return QStringList() << "composer";
+    case LibraryModel::GroupBy_Performer:
+      return QStringList() << "performer";
+    case LibraryModel::GroupBy_Disc:
+      return QStringList() << "disc";
+    case LibraryModel::GroupBy_Grouping:
+      return QStringList() << "grouping";
+    case LibraryModel::GroupBy_Genre:
+      return QStringList() << "genre";
+    case LibraryModel::GroupBy_AlbumArtist:
+      return QStringList() << "effective_albumartist";
+    case LibraryModel::GroupBy_FileType:
+      return QStringList() << "filetype";
+    case LibraryModel::GroupBy_Bitrate:
+      return QStringList() << "bitrate";
+    case LibraryModel::GroupBy_None:
+      break;
+  }
+  return QStringList();
+}
+
+// Whether every song that matches filter also matches previous, so if
+// previous matched nothing filter won't either.  Only filters that carry on
+// typing plain words are known to do that: field searches like "year:>1990"
+// can match more as they're typed, and so can FTS operators.
+static bool FilterOnlyNarrows(const QString& previous, const QString& filter) {
+  if (previous.trimmed().isEmpty() || !filter.startsWith(previous) ||
+      filter.contains(':')) {
+    return false;
+  }
+
+  static const QStringList kOperators = QStringList() << "AND"
+                                                      << "OR"
+                                                      << "NOT"
+                                                      << "NEAR";
+  for (const QString& word :
+       filter.split(QRegExp("\\W+"), QString::SkipEmptyParts)) {
+    if (kOperators.contains(word)) return false;
+  }
+  return true;
+}
+
 static bool IsCompilationArtistNode(const LibraryItem* node) {
   return node == node->parent->compilation_artist_node_;
 }
@@ -84,9 +150,10 @@ LibraryModel::LibraryModel(std::shared_ptr<LibraryBackend> backend,
       album_icon_(IconLoader::Load("x-clementine-album", IconLoader::Base)),
       playlists_dir_icon_(IconLoader::Load("folder-sound", IconLoader::Base)),
       playlist_icon_(IconLoader::Load("x-clementine-albums", IconLoader::Base)),
-      icon_cache_(new QNetworkDiskCache(this)),
       thread_pool_(this),
+      pending_rows_timer_(new QTimer(this)),
       init_task_id_(-1),
+      applied_reset_generation_(0),
       use_pretty_covers_(false),
       show_dividers_(true) {
   root_->lazy_loaded = true;
@@ -95,16 +162,18 @@ LibraryModel::LibraryModel(std::shared_ptr<LibraryBackend> backend,
   group_by_[1] = GroupBy_Album;
   group_by_[2] = GroupBy_None;
 
+  pending_rows_timer_->setInterval(0);
+  pending_rows_timer_->setSingleShot(true);
+  connect(pending_rows_timer_, SIGNAL(timeout()), SLOT(PostMorePendingRows()));
+
   cover_loader_options_.desired_height_ = kPrettyCoverSize;
   cover_loader_options_.pad_output_image_ = true;
   cover_loader_options_.scale_output_image_ = true;
 
-  connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
-          SLOT(AlbumArtLoaded(quint64, QImage)));
-
-  icon_cache_->setCacheDirectory(
-      Utilities::GetConfigPath(Utilities::Path_PixmapCache));
-  icon_cache_->setMaximumCacheSize(LibraryModel::kIconCacheSize);
+  if (app_) {
+    connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
+            SLOT(AlbumArtLoaded(quint64, QImage)));
+  }
 
   QIcon nocover = IconLoader::Load("nocover", IconLoader::Other);
   no_cover_icon_ = nocover.pixmap(nocover.availableSizes().last())
@@ -155,6 +224,31 @@ void LibraryModel::SaveGrouping(QString name) {
   QSettings s;
   s.beginGroup(kSavedGroupingsSettingsGroup);
   s.setValue(name, buffer);
+
+  backend_->EnsureGroupingIndexAsync(GroupingIndexColumns(group_by_));
+}
+
+QStringList LibraryModel::GroupingIndexColumns(const Grouping& g) {
+  QStringList ret;
+  for (int i = 0; i < 3; ++i) {
+    for (const QString& column : GroupByColumns(g[i])) {
+      if (!ret.contains(column)) ret << column;
+    }
+  }
+  return ret;
+}
+
+bool LibraryModel::IsSavedGrouping(const Grouping& g) const {
+  QSettings s;
+  s.beginGroup(kSavedGroupingsSettingsGroup);
+  for (const QString& name : s.childKeys()) {
+    QByteArray bytes = s.value(name).toByteArray();
+    QDataStream ds(&bytes, QIODevice::ReadOnly);
+    Grouping saved;
+    ds >> saved;
+    if (saved == g) return true;
+  }
+  return false;
 }
 
 void LibraryModel::Init(bool async) {
@@ -168,7 +262,9 @@ void LibraryModel::Init(bool async) {
     endResetModel();
 
     // Show a loading indicator in the status bar too.
-    init_task_id_ = app_->task_manager()->StartTask(tr("Loading songs"));
+    if (app_) {
+      init_task_id_ = app_->task_manager()->StartTask(tr("Loading songs"));
+    }
 
     ResetAsync();
   } else {
@@ -177,6 +273,9 @@ void LibraryModel::Init(bool async) {
 }
 
 void LibraryModel::SongsDiscovered(const SongList& songs) {
+  // The pending rows were read before these songs changed.
+  PostAllPendingRows();
+
   for (const Song& song : songs) {
     // Sanity check to make sure we don't add songs that are outside the user's
     // filter
@@ -280,6 +379,8 @@ void LibraryModel::SongsDiscovered(const SongList& songs) {
 }
 
 void LibraryModel::SongsSlightlyChanged(const SongList& songs) {
+  PostAllPendingRows();
+
   // This is called if there was a minor change to the songs that will not
   // normally require the library to be restructured.  We can just update our
   // internal cache of Song objects without worrying about resetting the model.
@@ -394,6 +495,8 @@ QString LibraryModel::DividerDisplayText(GroupBy type,
 }
 
 void LibraryModel::SongsDeleted(const SongList& songs) {
+  PostAllPendingRows();
+
   // Delete the actual song nodes first, keeping track of each parent so we
   // might check to see if they're empty later.
   QSet<LibraryItem*> parents;
@@ -445,7 +548,7 @@ void LibraryModel::SongsDeleted(const SongList& songs) {
       // Remove from pixmap cache
       const QString cache_key = AlbumIconPixmapCacheKey(ItemToIndex(node));
       QPixmapCache::remove(cache_key);
-      icon_cache_->remove(QUrl(cache_key));
+      if (icon_atlas_) icon_atlas_->Remove(cache_key);
       if (pending_cache_keys_.contains(cache_key)) {
         pending_cache_keys_.remove(cache_key);
       }
@@ -502,6 +605,23 @@ QString LibraryModel::AlbumIconPixmapCacheKey(const QModelIndex& index) const {
   return "libraryart:" + path.join("/");
 }
 
+AlbumIconAtlas* LibraryModel::IconAtlas() {
+  if (!icon_atlas_) {
+    // Icons are keyed by their place in the tree, which is the same in every
+    // model, so each songs table gets an atlas of its own.
+    QString name = "albumicons";
+    const QString table = backend_->songs_table();
+    if (table != "songs") {
+      name += "-" + QString(table).replace(QRegExp("[^a-zA-Z0-9_]"), "_");
+    }
+    icon_atlas_.reset(new AlbumIconAtlas(
+        Utilities::GetConfigPath(Utilities::Path_PixmapCache) + "/" + name +
+            ".atlas",
+        kPrettyCoverSize, kIconAtlasMaxTiles));
+  }
+  return icon_atlas_.get();
+}
+
 QVariant LibraryModel::AlbumIcon(const QModelIndex& index) {
   LibraryItem* item = IndexToItem(index);
   if (!item) return no_cover_icon_;
@@ -514,13 +634,11 @@ QVariant LibraryModel::AlbumIcon(const QModelIndex& index) {
   }
 
   // Try to load it from the disk cache
-  std::unique_ptr<QIODevice> cache(icon_cache_->data(QUrl(cache_key)));
-  if (cache) {
-    QImage cached_pixmap;
-    if (cached_pixmap.load(cache.get(), "XPM")) {
-      QPixmapCache::insert(cache_key, QPixmap::fromImage(cached_pixmap));
-      return QPixmap::fromImage(cached_pixmap);
-    }
+  const QImage cached_image = IconAtlas()->Lookup(cache_key);
+  if (!cached_image.isNull()) {
+    cached_pixmap = QPixmap::fromImage(cached_image);
+    QPixmapCache::insert(cache_key, cached_pixmap);
+    return cached_pixmap;
   }
 
   // Maybe we're loading a pixmap already?
@@ -557,18 +675,8 @@ void LibraryModel::AlbumArtLoaded(quint64 id, const QImage& image) {
     QPixmapCache::insert(cache_key, QPixmap::fromImage(image));
   }
 
-  // If we have a valid cover not already in the disk cache
-  std::unique_ptr<QIODevice> cached_img(icon_cache_->data(QUrl(cache_key)));
-  if (!cached_img && !image.isNull()) {
-    QNetworkCacheMetaData item_metadata;
-    item_metadata.setSaveToDisk(true);
-    item_metadata.setUrl(QUrl(cache_key));
-    QIODevice* cache = icon_cache_->prepare(item_metadata);
-    if (cache) {
-      image.save(cache, "XPM");
-      icon_cache_->insert(cache);
-    }
-  }
+  // Keep valid covers on disk for next time
+  if (!image.isNull()) IconAtlas()->Insert(cache_key, image);
 
   const QModelIndex index = ItemToIndex(item);
   emit dataChanged(index, index);
@@ -650,10 +758,8 @@ QVariant LibraryModel::data(const LibraryItem* item, int role) const {
       return item->metadata.artist();
 
     case Role_Editable:
-      if (!item->lazy_loaded) {
-        const_cast<LibraryModel*>(this)->LazyPopulate(
-            const_cast<LibraryItem*>(item), true);
-      }
+      const_cast<LibraryModel*>(this)->LazyPopulate(
+          const_cast<LibraryItem*>(item), true);
 
       if (item->type == LibraryItem::Type_Container) {
         // if we have even one non editable item as a child, we ourselves
@@ -688,7 +794,7 @@ bool LibraryModel::HasCompilations(const LibraryQuery& query) {
   q.AddCompilationRequirement(true);
   q.SetLimit(1);
 
-  QMutexLocker l(backend_->db()->Mutex());
+  QMutexLocker l(backend_->db()->ReadMutex());
   if (!backend_->ExecQuery(&q)) return false;
 
   return q.Next();
@@ -701,6 +807,25 @@ LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
   int child_level = parent == root_ ? 0 : parent->container_level + 1;
   GroupBy child_type = child_level >= 3 ? GroupBy_None : group_by_[child_level];
 
+  // The top level of the whole library can come straight from the aggregate
+  // tables without looking at any songs.
+  const QString aggregate_column = AggregateColumn(child_type);
+  if (parent == root_ && !aggregate_column.isNull() &&
+      backend_->CanUseAggregates(query_options_)) {
+    if (IsArtistGroupBy(child_type)) {
+      result.create_va =
+          show_various_artists_ &&
+          !backend_->GetAggregateValues(aggregate_column, 1).isEmpty();
+      result.rows = backend_->GetAggregateValues(aggregate_column, 0);
+    } else {
+      result.rows = backend_->GetAggregateValues(aggregate_column);
+    }
+    for (const SqlRow& row : result.rows) {
+      result.keys << KeyFromQuery(child_type, row);
+    }
+    return result;
+  }
+
   // Initialise the query.  child_type says what type of thing we want (artists,
   // songs, etc.)
   LibraryQuery q(query_options_);
@@ -725,11 +850,12 @@ LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
   }
 
   // Execute the query
-  QMutexLocker l(backend_->db()->Mutex());
+  QMutexLocker l(backend_->db()->ReadMutex());
   if (!backend_->ExecQuery(&q)) return result;
 
   while (q.Next()) {
     result.rows << SqlRow(q);
+    result.keys << KeyFromQuery(child_type, result.rows.last());
   }
   return result;
 }
@@ -760,36 +886,322 @@ void LibraryModel::PostQuery(LibraryItem* parent,
 }
 
 void LibraryModel::LazyPopulate(LibraryItem* parent, bool signal) {
-  if (parent->lazy_loaded) return;
+  if (parent->lazy_loaded) {
+    // Whoever asked wants all the children, not just the first chunk.
+    PostPendingRows(parent, -1);
+    return;
+  }
   parent->lazy_loaded = true;
 
   QueryResult result = RunQuery(parent);
   PostQuery(parent, result, signal);
 }
 
+void LibraryModel::fetchMore(const QModelIndex& parent) {
+  if (!parent.isValid()) return;
+
+  LibraryItem* item = IndexToItem(parent);
+  if (item->lazy_loaded) return;
+  item->lazy_loaded = true;
+
+  QueryResult result = RunQuery(item);
+  if (result.rows.count() <= kFetchChunkSize) {
+    PostQuery(item, result, true);
+    return;
+  }
+
+  // Expanding something like Various artists on a big library would make
+  // tens of thousands of items in one go.  The view gets the first chunk
+  // now and the rest follow a chunk per pass of the event loop, so it can
+  // paint in between.
+  PendingRows& pending = pending_rows_[item];
+  pending.result = result;
+  pending.next = 0;
+  if (result.create_va) CreateCompilationArtistNode(true, item);
+
+  PostPendingRows(item, kFetchChunkSize);
+}
+
+void LibraryModel::PostPendingRows(LibraryItem* parent, int count) {
+  QHash<LibraryItem*, PendingRows>::iterator it = pending_rows_.find(parent);
+  if (it == pending_rows_.end()) return;
+
+  const int child_level = parent == root_ ? 0 : parent->container_level + 1;
+  const GroupBy child_type =
+      child_level >= 3 ? GroupBy_None : group_by_[child_level];
+
+  const SqlRowList& rows = it->result.rows;
+  const int begin = it->next;
+  const int end =
+      count == -1 ? rows.count() : qMin(rows.count(), begin + count);
+
+  // One insert for the whole chunk, the items themselves don't signal.
+  beginInsertRows(ItemToIndex(parent), parent->children.count(),
+                  parent->children.count() + end - begin - 1);
+  for (int i = begin; i < end; ++i) {
+    LibraryItem* item = ItemFromQuery(child_type, false, child_level == 0,
+                                      parent, rows[i], child_level);
+    if (child_type == GroupBy_None)
+      song_nodes_[item->metadata.id()] = item;
+    else
+      container_nodes_[child_level][item->key] = item;
+  }
+  endInsertRows();
+
+  if (end == rows.count()) {
+    pending_rows_.erase(it);
+  } else {
+    it->next = end;
+    pending_rows_timer_->start();
+  }
+}
+
+void LibraryModel::PostMorePendingRows() {
+  if (pending_rows_.isEmpty()) return;
+  PostPendingRows(pending_rows_.begin().key(), kFetchChunkSize);
+}
+
+void LibraryModel::PostAllPendingRows() {
+  while (!pending_rows_.isEmpty()) {
+    PostPendingRows(pending_rows_.begin().key(), -1);
+  }
+}
+
 void LibraryModel::ResetAsync() {
+  const int generation = reset_generation_.fetchAndAddOrdered(1) + 1;
   QFuture<LibraryModel::QueryResult> future =
-      QtConcurrent::run(&thread_pool_, this, &LibraryModel::RunQuery, root_);
-  NewClosure(future, this,
-             SLOT(ResetAsyncQueryFinished(QFuture<LibraryModel::QueryResult>)),
-             future);
+      QtConcurrent::run(&thread_pool_, [this, generation]() {
+        // Typing in the filter asks for a reset on every key, only the last
+        // one is worth running.
+        if (reset_generation_.load() != generation) return QueryResult();
+        return RunQuery(root_);
+      });
+  NewClosure(
+      future, this,
+      SLOT(ResetAsyncQueryFinished(QFuture<LibraryModel::QueryResult>, int)),
+      future, generation);
 }
 
 void LibraryModel::ResetAsyncQueryFinished(
-    QFuture<LibraryModel::QueryResult> future) {
+    QFuture<LibraryModel::QueryResult> future, int generation) {
+  // A newer reset will replace the tree anyway.
+  if (generation != reset_generation_.load()) return;
+
   const struct QueryResult result = future.result();
 
-  BeginReset();
-  root_->lazy_loaded = true;
+  // If the top level is still grouped the same way we can patch the existing
+  // tree instead of throwing it away, which keeps expanded nodes expanded.
+  // Showing or hiding the smart playlists node still needs a full reset.
+  const bool show_smart_playlists =
+      show_smart_playlists_ && query_options_.filter().isEmpty();
+  if (root_->lazy_loaded && applied_group_by_.first == group_by_.first &&
+      show_smart_playlists == (smart_playlist_node_ != nullptr)) {
+    Regroup(root_, result);
+  } else {
+    BeginReset();
+    root_->lazy_loaded = true;
+
+    PostQuery(root_, result, false);
 
-  PostQuery(root_, result, false);
+    endResetModel();
+  }
+  applied_group_by_ = group_by_;
+  applied_reset_generation_ = generation;
+  applied_filter_ = query_options_.filter();
 
   if (init_task_id_ != -1) {
     app_->task_manager()->SetTaskFinished(init_task_id_);
     init_task_id_ = -1;
   }
+}
 
-  endResetModel();
+void LibraryModel::Regroup(LibraryItem* parent, const QueryResult& result) {
+  const int child_level = parent == root_ ? 0 : parent->container_level + 1;
+  const GroupBy child_type =
+      child_level >= 3 ? GroupBy_None : group_by_[child_level];
+  const GroupBy old_child_type =
+      child_level >= 3 ? GroupBy_None : applied_group_by_[child_level];
+
+  // The fresh result has everything that was still waiting, and is more up
+  // to date.
+  pending_rows_.remove(parent);
+
+  if (child_type != old_child_type) {
+    // None of the old children can survive a change of type at this level.
+    while (!parent->children.isEmpty()) {
+      DeleteItem(parent->children.last());
+    }
+    parent->compilation_artist_node_ = nullptr;
+    PostQuery(parent, result, true);
+    return;
+  }
+
+  // Keys aren't always unique among siblings (albums with the same name and
+  // a different grouping, for example), so match them up by count.
+  QHash<QString, int> wanted;
+  for (const QString& key : result.keys) wanted[key]++;
+
+  // Remove the children that aren't in the new result.
+  QList<LibraryItem*> survivors;
+  QHash<QString, int> surviving;
+  for (int i = parent->children.count() - 1; i >= 0; --i) {
+    LibraryItem* child = parent->children[i];
+    if (child->type == LibraryItem::Type_Divider ||
+        child->type == LibraryItem::Type_PlaylistContainer)
+      continue;
+
+    if (IsCompilationArtistNode(child)) {
+      if (result.create_va)
+        survivors << child;
+      else
+        DeleteItem(child);
+      continue;
+    }
+
+    const QString key = child->type == LibraryItem::Type_Song
+                            ? QString::number(child->metadata.id())
+                            : child->key;
+    if (wanted.value(key) > 0) {
+      wanted[key]--;
+      surviving[key]++;
+      survivors << child;
+    } else {
+      DeleteItem(child);
+    }
+  }
+
+  // Add the new ones.
+  if (result.create_va && !parent->compilation_artist_node_) {
+    CreateCompilationArtistNode(true, parent);
+  }
+  for (int i = 0; i < result.rows.count(); ++i) {
+    const QString& key = result.keys[i];
+    if (surviving.value(key) > 0) {
+      surviving[key]--;
+      continue;
+    }
+
+    LibraryItem* item = ItemFromQuery(child_type, true, child_level == 0,
+                                      parent, result.rows[i], child_level);
+    if (child_type == GroupBy_None)
+      song_nodes_[item->metadata.id()] = item;
+    else
+      container_nodes_[child_level][item->key] = item;
+  }
+
+  if (parent == root_) DeleteEmptyDividers();
+
+  // The contents of anything that was already loaded might have changed too.
+  // These are the nodes the user has expanded, so it's a small set.
+  for (LibraryItem* child : survivors) {
+    if (child->type == LibraryItem::Type_Container && child->lazy_loaded) {
+      Regroup(child, RunQuery(child));
+    }
+  }
+}
+
+void LibraryModel::DeleteItem(LibraryItem* item) {
+  ForgetItem(item);
+
+  beginRemoveRows(ItemToIndex(item->parent), item->row, item->row);
+  item->parent->Delete(item->row);
+  endRemoveRows();
+}
+
+void LibraryModel::ForgetItem(LibraryItem* item) {
+  for (LibraryItem* child : item->children) {
+    ForgetItem(child);
+  }
+
+  if (item->type == LibraryItem::Type_Song) {
+    if (song_nodes_.value(item->metadata.id()) == item)
+      song_nodes_.remove(item->metadata.id());
+  } else if (item->type == LibraryItem::Type_Container) {
+    if (IsCompilationArtistNode(item)) {
+      item->parent->compilation_artist_node_ = nullptr;
+    } else if (container_nodes_[item->container_level].value(item->key) ==
+               item) {
+      container_nodes_[item->container_level].remove(item->key);
+    }
+  }
+
+  pending_rows_.remove(item);
+
+  QMap<quint64, ItemAndCacheKey>::iterator i = pending_art_.begin();
+  while (i != pending_art_.end()) {
+    if (i.value().first == item) {
+      pending_cache_keys_.remove(i.value().second);
+      i = pending_art_.erase(i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+void LibraryModel::DeleteEmptyDividers() {
+  QSet<QString> used_keys;
+  for (LibraryItem* node : container_nodes_[0].values()) {
+    used_keys << DividerKey(group_by_[0], node);
+  }
+
+  for (const QString& divider_key : divider_nodes_.keys()) {
+    if (used_keys.contains(divider_key)) continue;
+
+    int row = divider_nodes_[divider_key]->row;
+    beginRemoveRows(ItemToIndex(root_), row, row);
+    root_->Delete(row);
+    endRemoveRows();
+    divider_nodes_.remove(divider_key);
+  }
+}
+
+QString LibraryModel::AggregateColumn(GroupBy type) {
+  switch (type) {
+    case GroupBy_Artist:
+      return "artist";
+    case GroupBy_AlbumArtist:
+      return "effective_albumartist";
+    case GroupBy_Album:
+      return "album";
+    case GroupBy_Genre:
+      return "genre";
+    default:
+      return QString();
+  }
+}
+
+QString LibraryModel::KeyFromQuery(GroupBy type, const SqlRow& row) {
+  // This must match the keys given by ItemFromQuery.
+  Song song;
+  switch (type) {
+    case GroupBy_YearAlbum:
+      return PrettyYearAlbum(qMax(0, row.value(0).toInt()),
+                             row.value(1).toString());
+
+    case GroupBy_OriginalYearAlbum:
+      song.set_year(row.value(0).toInt());
+      song.set_originalyear(row.value(1).toInt());
+      return PrettyYearAlbum(qMax(0, song.effective_originalyear()),
+                             row.value(2).toString());
+
+    case GroupBy_Year:
+    case GroupBy_OriginalYear:
+    case GroupBy_Bitrate:
+      return QString::number(qMax(0, row.value(0).toInt()));
+
+    case GroupBy_Disc:
+      return QString::number(row.value(0).toInt());
+
+    case GroupBy_FileType:
+      return Song::TextForFiletype(Song::FileType(row.value(0).toInt()));
+
+    case GroupBy_None:
+      // Songs are matched on their ROWID rather than their title.
+      return QString::number(row.value(0).toInt());
+
+    default:
+      return row.value(0).toString();
+  }
 }
 
 void LibraryModel::BeginReset() {
@@ -802,11 +1214,13 @@ void LibraryModel::BeginReset() {
   divider_nodes_.clear();
   pending_art_.clear();
   pending_cache_keys_.clear();
+  pending_rows_.clear();
   smart_playlist_node_ = nullptr;
 
   root_ = new LibraryItem(this);
   root_->compilation_artist_node_ = nullptr;
   root_->lazy_loaded = false;
+  applied_group_by_ = group_by_;
 
   // Smart playlists?
   if (show_smart_playlists_ && query_options_.filter().isEmpty())
@@ -814,12 +1228,21 @@ void LibraryModel::BeginReset() {
 }
 
 void LibraryModel::Reset() {
+  // Any async resets still running are older than this one.
+  applied_reset_generation_ = reset_generation_.fetchAndAddOrdered(1) + 1;
+  applied_filter_ = query_options_.filter();
+
   BeginReset();
 
   // Populate top level
   LazyPopulate(root_, false);
 
   endResetModel();
+
+  if (init_task_id_ != -1) {
+    app_->task_manager()->SetTaskFinished(init_task_id_);
+    init_task_id_ = -1;
+  }
 }
 
 void LibraryModel::InitQuery(GroupBy type, LibraryQuery* q) {
@@ -1337,6 +1760,18 @@ void LibraryModel::SetFilterAge(int age) {
 
 void LibraryModel::SetFilterText(const QString& text) {
   query_options_.set_filter(text);
+
+  // The tree can be left alone if it's up to date and the new filter can't
+  // change it: the same words spaced differently are the same query, and
+  // carrying on typing after nothing matched won't match anything either.
+  if (applied_reset_generation_ == reset_generation_.load() &&
+      (text.simplified() == applied_filter_.simplified() ||
+       (root_->children.isEmpty() &&
+        FilterOnlyNarrows(applied_filter_, text)))) {
+    applied_filter_ = text;
+    return;
+  }
+
   ResetAsync();
 }
 
@@ -1355,6 +1790,12 @@ bool LibraryModel::canFetchMore(const QModelIndex& parent) const {
 void LibraryModel::SetGroupBy(const Grouping& g) {
   group_by_ = g;
 
+  // The standard groupings are indexed by the schema, but saved ones get
+  // their indexes here, including ones saved before the index existed.
+  if (IsSavedGrouping(g)) {
+    backend_->EnsureGroupingIndexAsync(GroupingIndexColumns(g));
+  }
+
   ResetAsync();
   emit GroupingChanged(g);
 }
@@ -19,8 +19,8 @@
 #define LIBRARYMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QIcon>
-#include <QNetworkDiskCache>
 #include <QThreadPool>
 #include <memory>
 
@@ -35,14 +35,16 @@
 #include "smartplaylists/generator_fwd.h"
 #include "sqlrow.h"
 
-class Application;
 class AlbumCoverLoader;
+class AlbumIconAtlas;
+class Application;
 class LibraryBackend;
 namespace smart_playlists {
 class Search;
 }
 
 class QSettings;
+class QTimer;
 
 class LibraryModel : public SimpleTreeModel<LibraryItem> {
   Q_OBJECT
@@ -58,7 +60,8 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   static const char* kSavedGroupingsSettingsGroup;
   static const int kSmartPlaylistsVersion;
   static const int kPrettyCoverSize;
-  static const qint64 kIconCacheSize;
+  static const int kFetchChunkSize;
+  static const int kIconAtlasMaxTiles;
 
   enum Role {
     Role_Type = Qt::UserRole + 1,
@@ -114,6 +117,8 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
     QueryResult() : create_va(false) {}
 
     SqlRowList rows;
+    // The key each row's item will get, in the same order as rows.
+    QStringList keys;
     bool create_va;
   };
 
@@ -155,6 +160,7 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   QStringList mimeTypes() const;
   QMimeData* mimeData(const QModelIndexList& indexes) const;
   bool canFetchMore(const QModelIndex& parent) const;
+  void fetchMore(const QModelIndex& parent);
 
   // Whether or not to use album cover art, if it exists, in the library view
   void set_pretty_covers(bool use_pretty_covers);
@@ -166,6 +172,9 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   // Save the current grouping
   void SaveGrouping(QString name);
 
+  // The columns of an index that turns every level of g into a range scan.
+  static QStringList GroupingIndexColumns(const Grouping& g);
+
   // Utility functions for manipulating text
   static QString TextOrUnknown(const QString& text);
   static QString PrettyYearAlbum(int year, const QString& album);
@@ -201,10 +210,13 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   void TotalSongCountUpdatedSlot(int count);
 
   // Called after ResetAsync
-  void ResetAsyncQueryFinished(QFuture<LibraryModel::QueryResult> future);
+  void ResetAsyncQueryFinished(QFuture<LibraryModel::QueryResult> future,
+                               int generation);
 
   void AlbumArtLoaded(quint64 id, const QImage& image);
 
+  void PostMorePendingRows();
+
  private:
   // Provides some optimisations for loading the list of items in the root.
   // This gets called a lot when filtering the playlist, so it's nice to be
@@ -212,10 +224,29 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   QueryResult RunQuery(LibraryItem* parent);
   void PostQuery(LibraryItem* parent, const QueryResult& result, bool signal);
 
+  // Adds up to count of the rows still waiting to go under parent, or all of
+  // them if count is -1.
+  void PostPendingRows(LibraryItem* parent, int count);
+  void PostAllPendingRows();
+
   bool HasCompilations(const LibraryQuery& query);
+  bool IsSavedGrouping(const Grouping& g) const;
 
   void BeginReset();
 
+  // Brings the children of parent in line with a fresh query result: items
+  // whose keys are still there are kept along with their loaded children,
+  // the rest are removed and new ones inserted.  Recurses into loaded
+  // children.
+  void Regroup(LibraryItem* parent, const QueryResult& result);
+  void DeleteItem(LibraryItem* item);
+  void ForgetItem(LibraryItem* item);
+  void DeleteEmptyDividers();
+  static QString KeyFromQuery(GroupBy type, const SqlRow& row);
+  // The column in LibraryBackend's aggregates table for this grouping, or a
+  // null string if it has none.
+  static QString AggregateColumn(GroupBy type);
+
   // Functions for working with queries and creating items.
   // When the model is reset or when a node is lazy-loaded the Library
   // constructs a database query to populate the items.  Filters are added
@@ -253,6 +284,7 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
 
   // Helpers
   QString AlbumIconPixmapCacheKey(const QModelIndex& index) const;
+  AlbumIconAtlas* IconAtlas();
   QVariant AlbumIcon(const QModelIndex& index);
   QVariant data(const LibraryItem* item, int role) const;
   bool CompareItems(const LibraryItem* a, const LibraryItem* b) const;
@@ -268,6 +300,8 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
 
   QueryOptions query_options_;
   Grouping group_by_;
+  // The grouping the current tree was built with.
+  Grouping applied_group_by_;
 
   // Keyed on database ID
   QMap<int, LibraryItem*> song_nodes_;
@@ -289,12 +323,29 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   QIcon playlists_dir_icon_;
   QIcon playlist_icon_;
 
-  QNetworkDiskCache* icon_cache_;
+  // Created the first time a pretty cover is needed.
+  std::unique_ptr<AlbumIconAtlas> icon_atlas_;
 
   QThreadPool thread_pool_;
 
+  // The rows of big nodes that haven't been made into items yet.  These are
+  // added a chunk at a time in later passes of the event loop.
+  struct PendingRows {
+    QueryResult result;
+    int next;
+  };
+  QHash<LibraryItem*, PendingRows> pending_rows_;
+  QTimer* pending_rows_timer_;
+
   int init_task_id_;
 
+  // Bumped by every reset.  Async queries for an older one aren't run if
+  // they haven't started yet, and their results are thrown away.
+  QAtomicInt reset_generation_;
+  // The reset the tree that's showing came from, and the filter it used.
+  int applied_reset_generation_;
+  QString applied_filter_;
+
   bool use_pretty_covers_;
   bool show_dividers_;
 
@@ -32,8 +32,20 @@ bool LibraryPlaylistItem::IsTypeSupported(const QString& type) {
 }
 
 void LibraryPlaylistItem::Reload() {
-  TagReaderClient::Instance()->ReadFileBlocking(song_.url().toLocalFile(),
-                                                &song_);
+  TagReaderClient::Instance()->ReadFileBlocking(
+      song_.url().toLocalFile(), &song_, TagReaderClient::Priority_Playback);
+}
+
+void LibraryPlaylistItem::ReloadAsync(QObject* receiver,
+                                      std::function<void()> done) {
+  PlaylistItemPtr self = shared_from_this();
+  TagReaderClient::Instance()->ReadFileAsync(
+      song_.url().toLocalFile(), song_, receiver,
+      [this, self, done](const Song& song) {
+        song_ = song;
+        done();
+      },
+      TagReaderClient::Priority_Playback);
 }
 
 bool LibraryPlaylistItem::InitFromQuery(const SqlRow& query) {
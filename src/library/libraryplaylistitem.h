@@ -30,6 +30,7 @@ class LibraryPlaylistItem : public DbPlaylistItem {
 
   bool InitFromQuery(const SqlRow& query);
   void Reload();
+  void ReloadAsync(QObject* receiver, std::function<void()> done);
 
   bool IsLocalLibraryItem() const { return true; }
 };
@@ -21,6 +21,7 @@
 #include <QSqlError>
 #include <QtDebug>
 
+#include "core/database.h"
 #include "core/song.h"
 
 QueryOptions::QueryOptions() : max_age_(-1), query_mode_(QueryMode_All) {}
@@ -51,12 +52,30 @@ const QMap<QString, Song::FileType> kFiletypeId = QMap<QString, Song::FileType>(
                                       {"stream", Song::Type_Stream},
                                       {"unknown", Song::Type_Unknown}});
 
+// Turns some text into prefix terms for a MATCH, optionally restricted to one
+// column.  Anything that isn't a word character is dropped since the
+// tokenizers split on it anyway and FTS5 treats most of it as syntax.
+static QString FtsPrefixTerms(const QString& text,
+                              const QString& column = QString()) {
+  QString clean(text);
+  for (QChar& c : clean) {
+    if (!c.isLetterOrNumber() && c != '_') c = ' ';
+  }
+
+  QString ret;
+  for (const QString& word : clean.split(' ', QString::SkipEmptyParts)) {
+    if (!column.isEmpty()) ret += column + ":";
+    ret += word + "* ";
+  }
+  return ret;
+}
+
 LibraryQuery::LibraryQuery(const QueryOptions& options)
     : include_unavailable_(false), join_with_fts_(false), limit_(-1) {
   if (!options.filter().isEmpty()) {
     // We need to munge the filter text a little bit to get it to work as
-    // expected with sqlite's FTS3:
-    //  1) Append * to all tokens.
+    // expected with sqlite's FTS3 and FTS5:
+    //  1) Split tokens into words and append * to each.
     //  2) Prefix "fts" to column names.
     //  3) Remove colons which don't correspond to column names.
     //
@@ -82,7 +101,7 @@ LibraryQuery::LibraryQuery(const QueryOptions& options)
         if (Song::kFtsColumns.contains(
                 "fts" + columntoken,
                 Qt::CaseInsensitive)) {  // Is it a FTS column?
-          query += "fts" + columntoken + ":" + subtoken + "* ";
+          query += FtsPrefixTerms(subtoken, "fts" + columntoken.toLower());
         } else if (Song::kColumns.contains(columntoken, Qt::CaseInsensitive)) {
           // We need to extract the operator and the value from the subtoken
           QRegExp operatorRe("^(" + kNumericCompOperators.join("|") + ")(.*)");
@@ -140,12 +159,10 @@ LibraryQuery::LibraryQuery(const QueryOptions& options)
             AddWhere(columntoken, val, op);
           }
         } else {  // We did't recognize this as a column
-          token.replace(":", " ");
-          token = token.trimmed();
-          query += token + "* ";
+          query += FtsPrefixTerms(token);
         }
       } else {
-        query += token + "* ";
+        query += FtsPrefixTerms(token);
       }
     }
 
@@ -225,7 +242,8 @@ void LibraryQuery::AddCompilationRequirement(bool compilation) {
       << QString("+effective_compilation = %1").arg(compilation ? 1 : 0);
 }
 
-QSqlQuery LibraryQuery::Exec(QSqlDatabase db, const QString& songs_table,
+QSqlQuery LibraryQuery::Exec(Database* database, QSqlDatabase db,
+                             const QString& songs_table,
                              const QString& fts_table) {
   QString sql;
 
@@ -253,12 +271,12 @@ QSqlQuery LibraryQuery::Exec(QSqlDatabase db, const QString& songs_table,
   sql.replace("%fts_table_noprefix", fts_table.section('.', -1, -1));
   sql.replace("%fts_table", fts_table);
 
-  query_ = QSqlQuery(db);
-  query_.prepare(sql);
+  statement_ = database->CachedQuery(db, sql);
+  query_ = *statement_;
 
   // Bind values
-  for (const QVariant& value : bound_values_) {
-    query_.addBindValue(value);
+  for (int i = 0; i < bound_values_.count(); ++i) {
+    query_.bindValue(i, bound_values_[i]);
   }
 
   query_.exec();
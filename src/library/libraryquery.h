@@ -23,7 +23,9 @@
 #include <QStringList>
 #include <QVariant>
 #include <QVariantList>
+#include <memory>
 
+class Database;
 class Song;
 class LibraryBackend;
 
@@ -86,8 +88,9 @@ class LibraryQuery {
     include_unavailable_ = include_unavailable;
   }
 
-  QSqlQuery Exec(QSqlDatabase db, const QString& songs_table,
-                 const QString& fts_table);
+  // The statement comes from database's cache.
+  QSqlQuery Exec(Database* database, QSqlDatabase db,
+                 const QString& songs_table, const QString& fts_table);
   bool Next();
   QVariant Value(int column) const;
 
@@ -108,6 +111,8 @@ class LibraryQuery {
   bool duplicates_only_;
 
   QSqlQuery query_;
+  // Keeps query_'s statement out of the cache while it's in use.
+  std::shared_ptr<QSqlQuery> statement_;
 };
 
 #endif  // LIBRARYQUERY_H
@@ -674,12 +674,8 @@ void LibraryView::Organise() {
 }
 
 void LibraryView::Delete() {
-  if (QMessageBox::warning(this, tr("Delete files"),
-                           tr("These files will be permanently deleted from "
-                              "disk, are you sure you want to continue?"),
-                           QMessageBox::Yes,
-                           QMessageBox::Cancel) != QMessageBox::Yes)
-    return;
+  bool use_trash = false;
+  if (!DeleteFiles::ConfirmDeleteFromDisk(this, &use_trash)) return;
 
   // We can cheat and always take the storage of the first directory, since
   // they'll all be FilesystemMusicStorage in a library and deleting doesn't
@@ -691,6 +687,9 @@ void LibraryView::Delete() {
           .value<std::shared_ptr<MusicStorage>>();
 
   DeleteFiles* delete_files = new DeleteFiles(app_->task_manager(), storage);
+  delete_files->set_use_trash(use_trash);
+  connect(delete_files, SIGNAL(SongsDeleted(SongList)),
+          app_->library_backend(), SLOT(DeleteSongs(SongList)));
   connect(delete_files, SIGNAL(Finished(SongList)),
           SLOT(DeleteFinished(SongList)));
   delete_files->Start(GetSelectedSongs());
@@ -26,12 +26,15 @@
 #include <QMutexLocker>
 #include <QSet>
 #include <QSettings>
+#include <QStorageInfo>
 #include <QThread>
 #include <QTimer>
 #include <QtDebug>
 
+#include "core/concurrentrun.h"
 #include "core/filesystemwatcherinterface.h"
 #include "core/logging.h"
+#include "core/metrics.h"
 #include "core/tagreaderclient.h"
 #include "core/taskmanager.h"
 #include "core/utilities.h"
@@ -53,6 +56,10 @@ static const int kUnfilteredImageLimit = 10;
 QStringList LibraryWatcher::sValidImages;
 
 const char* LibraryWatcher::kSettingsGroup = "LibraryWatcher";
+const int LibraryWatcher::kMaxParallelScanVolumes = 4;
+const int LibraryWatcher::kCheckpointInterval = 100;
+const int LibraryWatcher::kDefaultTagReadWindow = 32;
+const int LibraryWatcher::kTagReadBatchSize = 8;
 
 LibraryWatcher::LibraryWatcher(QObject* parent)
     : QObject(parent),
@@ -61,13 +68,17 @@ LibraryWatcher::LibraryWatcher(QObject* parent)
       fs_watcher_(FileSystemWatcherInterface::Create(this)),
       scan_on_startup_(true),
       monitor_(true),
+      parallel_scan_(false),
+      tag_read_window_(kDefaultTagReadWindow),
       rescan_timer_(new QTimer(this)),
       rescan_paused_(false),
-      total_watches_(0),
-      cue_parser_(new CueParser(backend_, this)) {
+      total_watches_(0) {
   rescan_timer_->setInterval(1000);
   rescan_timer_->setSingleShot(true);
 
+  scan_thread_pool_.setMaxThreadCount(
+      qBound(1, QThread::idealThreadCount(), kMaxParallelScanVolumes));
+
   if (sValidImages.isEmpty()) {
     sValidImages << "jpg"
                  << "png"
@@ -86,7 +97,7 @@ LibraryWatcher::LibraryWatcher(QObject* parent)
 // thread. So the Directory object will not be deleted out from under us.
 LibraryWatcher::ScanTransaction::ScanTransaction(
     LibraryWatcher* watcher, const LibraryWatcher::WatchedDir& dir,
-    bool incremental, bool ignores_mtime)
+    bool incremental, bool ignores_mtime, bool whole_directory)
     : progress_(0),
       progress_max_(0),
       dir_(dir),
@@ -94,7 +105,12 @@ LibraryWatcher::ScanTransaction::ScanTransaction(
       ignores_mtime_(ignores_mtime),
       watcher_(watcher),
       cached_songs_dirty_(true),
-      known_subdirs_dirty_(true) {
+      songs_by_identity_dirty_(true),
+      known_subdirs_dirty_(true),
+      read_ahead_in_flight_(0),
+      uses_checkpoint_(whole_directory &&
+                       watcher->backend_->has_scan_checkpoints()),
+      has_checkpoint_(false) {
   QString description;
   if (watcher_->device_name_.isEmpty())
     description = tr("Updating library");
@@ -103,15 +119,40 @@ LibraryWatcher::ScanTransaction::ScanTransaction(
 
   task_id_ = watcher_->task_manager_->StartTask(description);
   emit watcher_->ScanStarted(task_id_);
+
+  if (uses_checkpoint_) {
+    for (const Subdirectory& subdir :
+         watcher_->backend_->ScanCheckpoint(dir_id())) {
+      checkpoint_[subdir.path] = subdir.mtime;
+    }
+  }
+  if (!checkpoint_.isEmpty()) {
+    qLog(Info) << "Resuming interrupted scan of" << dir_.path << "-"
+               << checkpoint_.count() << "subdirectories already scanned";
+    has_checkpoint_ = true;
+  }
+
+  quarantined_ = watcher_->backend_->QuarantinedFiles();
 }
 
 LibraryWatcher::ScanTransaction::~ScanTransaction() {
-  // If we're stopping then don't commit the transaction
+  ClearReadAhead();
+
+  // If we're stopping then don't commit the transaction.  Anything that was
+  // committed at a checkpoint stays, so the scan can resume from there.
   if (aborted()) {
     watcher_->task_manager_->SetTaskFinished(task_id_);
     return;
   }
 
+  CommitResults();
+
+  watcher_->task_manager_->SetTaskFinished(task_id_);
+
+  if (has_checkpoint_) emit watcher_->ScanCheckpointCleared(dir_id());
+}
+
+void LibraryWatcher::ScanTransaction::CommitResults() {
   if (!new_songs.isEmpty()) emit watcher_->NewOrUpdatedSongs(new_songs);
 
   if (!touched_songs.isEmpty()) emit watcher_->SongsMTimeUpdated(touched_songs);
@@ -120,23 +161,72 @@ LibraryWatcher::ScanTransaction::~ScanTransaction() {
 
   if (!readded_songs.isEmpty()) emit watcher_->SongsReadded(readded_songs);
 
+  // The checkpoint is recorded before the subdirectory mtimes, so if we crash
+  // in between the subdirectories will be rediscovered but not rescanned.
+  if (!finished_subdirs_.isEmpty()) {
+    emit watcher_->ScanCheckpointReached(finished_subdirs_);
+    has_checkpoint_ = true;
+  }
+
   if (!new_subdirs.isEmpty()) emit watcher_->SubdirsDiscovered(new_subdirs);
 
   if (!touched_subdirs.isEmpty())
     emit watcher_->SubdirsMTimeUpdated(touched_subdirs);
 
-  watcher_->task_manager_->SetTaskFinished(task_id_);
-
-  for (const Subdirectory& subdir : deleted_subdirs) {
-    watcher_->RemoveWatch(dir_, subdir);
-  }
+  // Transactions started by a parallel scan finish on a pool thread, but the
+  // filesystem watcher may only be touched from the watcher's own thread.
+  if (QThread::currentThread() != watcher_->thread()) {
+    QMutexLocker l(&watcher_->pending_watches_mutex_);
+    for (const Subdirectory& subdir : deleted_subdirs) {
+      watcher_->pending_removed_watches_ << qMakePair(Directory(dir_), subdir);
+    }
+    if (watcher_->monitor_) {
+      for (const Subdirectory& subdir : new_subdirs) {
+        watcher_->pending_added_watches_
+            << qMakePair(Directory(dir_), subdir.path);
+      }
+    }
+  } else {
+    for (const Subdirectory& subdir : deleted_subdirs) {
+      watcher_->RemoveWatch(dir_, subdir);
+    }
 
-  if (watcher_->monitor_) {
-    // Watch the new subdirectories
-    for (const Subdirectory& subdir : new_subdirs) {
-      watcher_->AddWatch(dir_, subdir.path);
+    if (watcher_->monitor_) {
+      // Watch the new subdirectories
+      for (const Subdirectory& subdir : new_subdirs) {
+        watcher_->AddWatch(dir_, subdir.path);
+      }
     }
   }
+
+  new_songs.clear();
+  touched_songs.clear();
+  deleted_songs.clear();
+  readded_songs.clear();
+  new_subdirs.clear();
+  touched_subdirs.clear();
+  deleted_subdirs.clear();
+  finished_subdirs_.clear();
+}
+
+bool LibraryWatcher::ScanTransaction::IsCheckpointed(const QString& path,
+                                                     uint mtime) const {
+  QHash<QString, uint>::const_iterator it = checkpoint_.constFind(path);
+  return it != checkpoint_.constEnd() && it.value() == mtime;
+}
+
+bool LibraryWatcher::ScanTransaction::IsQuarantined(
+    const QString& file) const {
+  QHash<QString, uint>::const_iterator it = quarantined_.constFind(file);
+  return it != quarantined_.constEnd() &&
+         it.value() == QFileInfo(file).lastModified().toTime_t();
+}
+
+void LibraryWatcher::ScanTransaction::SubdirectoryFinished(
+    const Subdirectory& subdir) {
+  if (!uses_checkpoint_) return;
+  finished_subdirs_ << subdir;
+  if (finished_subdirs_.count() >= kCheckpointInterval) CommitResults();
 }
 
 void LibraryWatcher::ScanTransaction::AddToProgress(int n) {
@@ -149,35 +239,234 @@ void LibraryWatcher::ScanTransaction::AddToProgressMax(int n) {
   watcher_->task_manager_->SetTaskProgress(task_id_, progress_, progress_max_);
 }
 
-SongList LibraryWatcher::ScanTransaction::FindSongsInSubdirectory(
-    const QString& path) {
+void LibraryWatcher::ScanTransaction::ReadAhead(
+    const QStringList& files, const QSet<QString>& fast_files) {
+  ClearReadAhead();
+
+  read_ahead_fast_ = fast_files;
+  for (const QString& file : files) {
+    read_ahead_files_.enqueue(file);
+    read_ahead_set_.insert(file);
+  }
+  FillReadAheadWindow();
+}
+
+bool LibraryWatcher::ScanTransaction::TakeReadAheadSong(const QString& file,
+                                                        Song* out,
+                                                        bool* fast_read) {
+  if (!read_ahead_set_.remove(file)) return false;
+  const bool fast = read_ahead_fast_.remove(file);
+
+  // Anything in front of this file was passed over.
+  TagReaderReply* reply = nullptr;
+  int index = 0;
+  bool batch = false;
+  bool owns_reply = true;
+  while (!read_ahead_replies_.isEmpty()) {
+    ReadAheadRequest& next = read_ahead_replies_.head();
+    const int pos = next.files.indexOf(file, next.next);
+    const int end = pos == -1 ? next.files.count() : pos + 1;
+    for (int i = next.next; i < end; ++i) {
+      read_ahead_set_.remove(next.files[i]);
+      read_ahead_fast_.remove(next.files[i]);
+    }
+    read_ahead_in_flight_ -= end - next.next;
+    next.next = end;
+
+    if (pos != -1) {
+      reply = next.reply;
+      index = pos;
+      batch = next.files.count() > 1;
+      // The rest of a batch is still to be taken from the same reply.
+      owns_reply = next.next == next.files.count();
+      if (owns_reply) read_ahead_replies_.dequeue();
+      break;
+    }
+    TagReaderClient::Instance()->DeleteReplyLater(
+        read_ahead_replies_.dequeue().reply);
+  }
+
+  if (reply && fast && !fast_read) {
+    TagReaderClient::Instance()->DeleteReplyLater(reply);
+    FillReadAheadWindow();
+    return false;
+  }
+  if (fast_read) *fast_read = reply && fast;
+
+  if (!reply) {
+    while (!read_ahead_files_.isEmpty()) {
+      const QString next = read_ahead_files_.dequeue();
+      if (next == file) break;
+      read_ahead_set_.remove(next);
+      read_ahead_fast_.remove(next);
+    }
+    reply = TagReaderClient::Instance()->ReadFile(
+        file, TagReaderClient::Priority_Background);
+  }
+
+  // Keep the workers busy while we wait.
+  FillReadAheadWindow();
+
+  if (reply->WaitForFinished()) {
+    if (batch) {
+      TagReaderClient::Instance()->ParseReadFilesReply(file, reply, index, out);
+    } else {
+      TagReaderClient::Instance()->ParseReadFileReply(file, reply, out);
+    }
+  } else if (batch) {
+    // The worker crashed somewhere in the batch, so this file might not be
+    // the one to blame.
+    TagReaderClient::Instance()->ReadFileBlocking(
+        file, out, TagReaderClient::Priority_Background);
+  }
+  if (owns_reply) TagReaderClient::Instance()->DeleteReplyLater(reply);
+  return true;
+}
+
+void LibraryWatcher::ScanTransaction::FillReadAheadWindow() {
+  while (read_ahead_in_flight_ < watcher_->tag_read_window_ &&
+         !read_ahead_files_.isEmpty()) {
+    ReadAheadRequest request;
+    request.next = 0;
+    request.fast = read_ahead_fast_.contains(read_ahead_files_.head());
+    request.files << read_ahead_files_.dequeue();
+
+    // Full reads are batched to save a round trip to the worker per file.
+    while (!request.fast && request.files.count() < kTagReadBatchSize &&
+           read_ahead_in_flight_ + request.files.count() <
+               watcher_->tag_read_window_ &&
+           !read_ahead_files_.isEmpty() &&
+           !read_ahead_fast_.contains(read_ahead_files_.head())) {
+      request.files << read_ahead_files_.dequeue();
+    }
+
+    if (request.files.count() == 1) {
+      request.reply = TagReaderClient::Instance()->ReadFile(
+          request.files[0], TagReaderClient::Priority_Background,
+          request.fast);
+    } else {
+      request.reply = TagReaderClient::Instance()->ReadFiles(
+          request.files, TagReaderClient::Priority_Background);
+    }
+    read_ahead_in_flight_ += request.files.count();
+    read_ahead_replies_.enqueue(request);
+  }
+}
+
+void LibraryWatcher::ScanTransaction::ClearReadAhead() {
+  while (!read_ahead_replies_.isEmpty()) {
+    TagReaderClient::Instance()->DeleteReplyLater(
+        read_ahead_replies_.dequeue().reply);
+  }
+  read_ahead_in_flight_ = 0;
+  read_ahead_files_.clear();
+  read_ahead_set_.clear();
+  read_ahead_fast_.clear();
+}
+
+CueParser* LibraryWatcher::ScanTransaction::cue_parser() {
+  if (!cue_parser_) cue_parser_.reset(new CueParser(nullptr));
+  return cue_parser_.get();
+}
+
+void LibraryWatcher::ScanTransaction::LoadCachedSongs() {
   if (cached_songs_dirty_) {
     cached_songs_ = watcher_->backend_->FindSongsInDirectory(dir_id());
     cached_songs_dirty_ = false;
+    songs_by_identity_dirty_ = true;
+
+    songs_by_subdir_.clear();
+    songs_by_file_.clear();
+    for (const Song& song : cached_songs_) {
+      const QString file = song.url().toLocalFile();
+      songs_by_subdir_[file.section('/', 0, -2)] << song;
+      songs_by_file_[file] << song;
+    }
+  }
+}
+
+bool LibraryWatcher::ScanTransaction::FindSongByFileIdentity(
+    const QString& identity, Song* out) {
+  LoadCachedSongs();
+
+  if (songs_by_identity_dirty_) {
+    songs_by_identity_.clear();
+    for (const Song& song : cached_songs_) {
+      if (song.file_identity().isEmpty()) continue;
+
+      if (songs_by_identity_.contains(song.file_identity())) {
+        songs_by_identity_[song.file_identity()] = Song();
+      } else {
+        songs_by_identity_[song.file_identity()] = song;
+      }
+    }
+    songs_by_identity_dirty_ = false;
+  }
+
+  const Song song = songs_by_identity_.value(identity);
+  if (!song.is_valid()) return false;
+
+  *out = song;
+  return true;
+}
+
+void LibraryWatcher::ScanTransaction::SongMoved(const Song& song) {
+  moved_song_ids_.insert(song.id());
+
+  // The old path might have been scanned already.
+  for (int i = deleted_songs.count() - 1; i >= 0; --i) {
+    if (deleted_songs[i].id() == song.id()) deleted_songs.removeAt(i);
   }
+}
+
+SongList LibraryWatcher::ScanTransaction::FindSongsInSubdirectory(
+    const QString& path) {
+  LoadCachedSongs();
+  return songs_by_subdir_.value(path);
+}
+
+SongList LibraryWatcher::ScanTransaction::FindSongsForFile(
+    const QString& file) {
+  LoadCachedSongs();
 
-  // TODO: Make this faster
   SongList ret;
-  for (const Song& song : cached_songs_) {
-    if (song.url().toLocalFile().section('/', 0, -2) == path) ret << song;
+  for (const Song& song : songs_by_file_.value(file)) {
+    if (!song.is_unavailable()) ret << song;
   }
   return ret;
 }
 
+bool LibraryWatcher::ScanTransaction::FindSongByPath(const QString& file,
+                                                     Song* out) {
+  LoadCachedSongs();
+
+  QHash<QString, SongList>::const_iterator it = songs_by_file_.constFind(file);
+  if (it == songs_by_file_.constEnd()) return false;
+
+  *out = it->first();
+  return true;
+}
+
 void LibraryWatcher::ScanTransaction::SetKnownSubdirs(
     const SubdirectoryList& subdirs) {
   known_subdirs_ = subdirs;
   known_subdirs_dirty_ = false;
+
+  seen_subdirs_.clear();
+  subdirs_by_parent_.clear();
+  for (const Subdirectory& subdir : known_subdirs_) {
+    if (subdir.mtime == 0) continue;
+    seen_subdirs_.insert(subdir.path);
+    subdirs_by_parent_[subdir.path.left(
+        subdir.path.lastIndexOf(QDir::separator()))] << subdir;
+  }
 }
 
 bool LibraryWatcher::ScanTransaction::HasSeenSubdir(const QString& path) {
   if (known_subdirs_dirty_)
     SetKnownSubdirs(watcher_->backend_->SubdirsInDirectory(dir_id()));
 
-  for (const Subdirectory& subdir : known_subdirs_) {
-    if (subdir.path == path && subdir.mtime != 0) return true;
-  }
-  return false;
+  return seen_subdirs_.contains(path);
 }
 
 SubdirectoryList LibraryWatcher::ScanTransaction::GetImmediateSubdirs(
@@ -185,15 +474,7 @@ SubdirectoryList LibraryWatcher::ScanTransaction::GetImmediateSubdirs(
   if (known_subdirs_dirty_)
     SetKnownSubdirs(watcher_->backend_->SubdirsInDirectory(dir_id()));
 
-  SubdirectoryList ret;
-  for (const Subdirectory& subdir : known_subdirs_) {
-    if (subdir.path.left(subdir.path.lastIndexOf(QDir::separator())) == path &&
-        subdir.mtime != 0) {
-      ret << subdir;
-    }
-  }
-
-  return ret;
+  return subdirs_by_parent_.value(path);
 }
 
 SubdirectoryList LibraryWatcher::ScanTransaction::GetAllSubdirs() {
@@ -250,7 +531,8 @@ void LibraryWatcher::AddDirectory(const Directory& dir,
     for (const Subdirectory& subdir : subdirs) {
       if (transaction.aborted()) return;
 
-      if (scan_on_startup_) ScanSubdirectory(subdir.path, subdir, &transaction);
+      if (scan_on_startup_ || transaction.resuming())
+        ScanSubdirectory(subdir.path, subdir, &transaction);
 
       if (monitor_) AddWatch(new_dir, subdir.path);
     }
@@ -262,7 +544,13 @@ void LibraryWatcher::AddDirectory(const Directory& dir,
 void LibraryWatcher::ScanSubdirectory(const QString& path,
                                       const Subdirectory& subdir,
                                       ScanTransaction* t,
-                                      bool force_noincremental) {
+                                      bool force_noincremental,
+                                      const QSet<QString>* only_files) {
+  static metrics::Counter* directories_scanned = metrics::GetCounter(
+      "clementine_library_directories_scanned_total",
+      "Directories the library scanner looked through");
+  directories_scanned->Increment();
+
   QFileInfo path_info(path);
   QDir path_dir(path);
 
@@ -283,6 +571,8 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
     return;
   }
 
+  // A subdirectory's mtime is only committed once its children have been
+  // scanned too, so it can be trusted even when resuming.
   if (!t->ignores_mtime() && !force_noincremental && t->is_incremental() &&
       subdir.mtime == path_info.lastModified().toTime_t()) {
     // The directory hasn't changed since last time
@@ -334,7 +624,8 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
       if (!skip_file_extensions_.contains(ext_part)) {
         if (sValidImages.contains(ext_part))
           album_art[dir_part] << child;
-        else if (!child_info.isHidden())
+        else if (!child_info.isHidden() &&
+                 (!only_files || only_files->contains(child)))
           files_on_disk << child;
       }
     }
@@ -342,9 +633,32 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
 
   if (t->aborted()) return;
 
+  if (t->resuming() &&
+      t->IsCheckpointed(path, path_info.lastModified().toTime_t())) {
+    // The files in this directory were already scanned before the last scan
+    // was interrupted, but its children might not have been.
+    t->AddToProgress(1);
+    t->AddToProgressMax(my_new_subdirs.count());
+    for (const Subdirectory& my_new_subdir : my_new_subdirs) {
+      if (t->aborted()) return;
+      ScanSubdirectory(my_new_subdir.path, my_new_subdir, t, true);
+    }
+
+    if (subdir.directory_id == -1) {
+      Subdirectory updated_subdir;
+      updated_subdir.directory_id = t->dir_id();
+      updated_subdir.mtime = path_info.lastModified().toTime_t();
+      updated_subdir.path = path;
+      t->new_subdirs << updated_subdir;
+    }
+    return;
+  }
+
   // Ask the database for a list of files in this directory
   SongList songs_in_db = t->FindSongsInSubdirectory(path);
 
+  PrefetchTags(files_on_disk, t);
+
   QSet<QString> cues_processed;
 
   // Now compare the list from the database with the list of files on disk
@@ -355,7 +669,7 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
     QString matching_cue = NoExtensionPart(file) + ".cue";
 
     Song matching_song;
-    if (FindSongByPath(songs_in_db, file, &matching_song)) {
+    if (t->FindSongByPath(file, &matching_song)) {
       uint matching_cue_mtime = GetMtimeForCue(matching_cue);
 
       // The song is in the database and still on disk.
@@ -406,13 +720,33 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
         }
       }
 
+      // Songs added by older versions don't know their file's identity yet,
+      // so record it cheaply without rereading the file.
+      if (!t->ignores_mtime() && !changed && !matching_song.has_cue() &&
+          matching_song.file_identity().isEmpty()) {
+        Song song(matching_song);
+        song.set_file_identity(Utilities::FileIdentity(file));
+        if (!song.file_identity().isEmpty()) t->touched_songs << song;
+      }
+
       // nothing has changed - mark the song available without re-scanning
       if (matching_song.is_unavailable()) t->readded_songs << matching_song;
 
     } else {
-      // The song is on disk but not in the DB
+      // The song is on disk but not in the DB.  See if it's one we already
+      // know about that was just moved here.
+      Song moved_song;
+      if (FindMovedSong(file, matching_cue, t, &moved_song)) {
+        QString image = ImageForSong(file, &album_art, t);
+        if (!moved_song.has_embedded_cover())
+          moved_song.set_art_automatic(image);
+
+        t->new_songs << moved_song;
+        continue;
+      }
+
       SongList song_list =
-          ScanNewFile(file, path, matching_cue, &cues_processed);
+          ScanNewFile(file, path, matching_cue, &cues_processed, t);
 
       if (song_list.isEmpty()) {
         continue;
@@ -421,9 +755,11 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
       qLog(Debug) << file << "created";
       // choose an image for the song(s)
       QString image = ImageForSong(file, &album_art, t);
+      const QString identity = Utilities::FileIdentity(file);
 
       for (Song song : song_list) {
         song.set_directory_id(t->dir_id());
+        song.set_file_identity(identity);
         if (song.art_automatic().isEmpty()) song.set_art_automatic(image);
 
         t->new_songs << song;
@@ -433,14 +769,28 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
 
   // Look for deleted songs
   for (const Song& song : songs_in_db) {
-    if (!song.is_unavailable() &&
-        !files_on_disk.contains(song.url().toLocalFile())) {
-      qLog(Debug) << "Song deleted from disk:" << song.url().toLocalFile();
+    const QString song_path = song.url().toLocalFile();
+    if (only_files && !only_files->contains(song_path)) continue;
+    if (t->IsMoved(song.id())) continue;
+
+    if (!song.is_unavailable() && !files_on_disk.contains(song_path)) {
+      qLog(Debug) << "Song deleted from disk:" << song_path;
       t->deleted_songs << song;
     }
   }
 
-  // Add this subdir to the new or touched list
+  t->AddToProgress(1);
+
+  // Recurse into the new subdirs that we found
+  t->AddToProgressMax(my_new_subdirs.count());
+  for (const Subdirectory& my_new_subdir : my_new_subdirs) {
+    if (t->aborted()) return;
+    ScanSubdirectory(my_new_subdir.path, my_new_subdir, t, true);
+  }
+
+  // Add this subdir to the new or touched list.  This is only done once its
+  // children have been scanned, so that an interrupted scan can't leave it
+  // with an up to date mtime and children that were never looked at.
   Subdirectory updated_subdir;
   updated_subdir.directory_id = t->dir_id();
   updated_subdir.mtime =
@@ -455,15 +805,8 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
   if (updated_subdir.mtime ==
       0) {  // Subdirectory deleted, mark it for removal from the watcher.
     t->deleted_subdirs << updated_subdir;
-  }
-
-  t->AddToProgress(1);
-
-  // Recurse into the new subdirs that we found
-  t->AddToProgressMax(my_new_subdirs.count());
-  for (const Subdirectory& my_new_subdir : my_new_subdirs) {
-    if (t->aborted()) return;
-    ScanSubdirectory(my_new_subdir.path, my_new_subdir, t, true);
+  } else {
+    t->SubdirectoryFinished(updated_subdir);
   }
 }
 
@@ -472,10 +815,7 @@ void LibraryWatcher::UpdateCueAssociatedSongs(const QString& file,
                                               const QString& matching_cue,
                                               const QString& image,
                                               ScanTransaction* t) {
-  QFile cue(matching_cue);
-  cue.open(QIODevice::ReadOnly);
-
-  SongList old_sections = backend_->GetSongsByUrl(QUrl::fromLocalFile(file));
+  SongList old_sections = t->FindSongsForFile(file);
 
   QHash<quint64, Song> sections_map;
   for (const Song& song : old_sections) {
@@ -485,7 +825,7 @@ void LibraryWatcher::UpdateCueAssociatedSongs(const QString& file,
   QSet<int> used_ids;
 
   // update every song that's in the cue and library
-  for (Song cue_song : cue_parser_->Load(&cue, matching_cue, path)) {
+  for (Song cue_song : LoadCueSheet(matching_cue, path, t)) {
     cue_song.set_directory_id(t->dir_id());
 
     Song matching = sections_map[cue_song.beginning_nanosec()];
@@ -516,8 +856,7 @@ void LibraryWatcher::UpdateNonCueAssociatedSong(const QString& file,
   // 'raw' (cueless) song and we just remove the rest of the sections
   // from the library
   if (cue_deleted) {
-    for (const Song& song :
-         backend_->GetSongsByUrl(QUrl::fromLocalFile(file))) {
+    for (const Song& song : t->FindSongsForFile(file)) {
       if (!song.IsMetadataEqual(matching_song)) {
         t->deleted_songs << song;
       }
@@ -525,8 +864,22 @@ void LibraryWatcher::UpdateNonCueAssociatedSong(const QString& file,
   }
 
   Song song_on_disk;
+  bool fast_read = false;
+  ReadSong(file, &song_on_disk, t, &fast_read);
+  if (fast_read) {
+    if (FastReadMatches(song_on_disk, matching_song, image)) {
+      // Only the mtime changed.
+      Song touched(matching_song);
+      touched.set_mtime(song_on_disk.mtime());
+      t->touched_songs << touched;
+      return;
+    }
+
+    // Something changed, so read it properly.
+    song_on_disk = Song();
+    ReadSong(file, &song_on_disk, t);
+  }
   song_on_disk.set_directory_id(t->dir_id());
-  TagReaderClient::Instance()->ReadFileBlocking(file, &song_on_disk);
 
   if (song_on_disk.is_valid()) {
     PreserveUserSetData(file, image, matching_song, &song_on_disk, t);
@@ -535,7 +888,8 @@ void LibraryWatcher::UpdateNonCueAssociatedSong(const QString& file,
 
 SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
                                      const QString& matching_cue,
-                                     QSet<QString>* cues_processed) {
+                                     QSet<QString>* cues_processed,
+                                     ScanTransaction* t) {
   SongList song_list;
 
   uint matching_cue_mtime = GetMtimeForCue(matching_cue);
@@ -544,21 +898,21 @@ SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
     // don't process the same cue many times
     if (cues_processed->contains(matching_cue)) return song_list;
 
-    QFile cue(matching_cue);
-    cue.open(QIODevice::ReadOnly);
-
     // Ignore FILEs pointing to other media files. Also, watch out for incorrect
     // media files. Playlist parser for CUEs considers every entry in sheet
     // valid and we don't want invalid media getting into library!
     QString file_nfd = file.normalized(QString::NormalizationForm_D);
-    for (const Song& cue_song : cue_parser_->Load(&cue, matching_cue, path)) {
+    for (const Song& cue_song : LoadCueSheet(matching_cue, path, t)) {
       if (cue_song.url().toLocalFile().normalized(
               QString::NormalizationForm_D) == file_nfd) {
-        if (TagReaderClient::Instance()->IsMediaFileBlocking(file)) {
-          song_list << cue_song;
-        }
+        song_list << cue_song;
       }
     }
+    if (!song_list.isEmpty() &&
+        (t->IsQuarantined(file) ||
+         !TagReaderClient::Instance()->IsMediaFileBlocking(file))) {
+      song_list.clear();
+    }
 
     if (!song_list.isEmpty()) {
       *cues_processed << matching_cue;
@@ -567,7 +921,7 @@ SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
     // it's a normal media file
   } else {
     Song song;
-    TagReaderClient::Instance()->ReadFileBlocking(file, &song);
+    ReadSong(file, &song, t);
 
     if (song.is_valid()) {
       song_list << song;
@@ -577,11 +931,146 @@ SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
   return song_list;
 }
 
+void LibraryWatcher::PrefetchTags(const QStringList& files_on_disk,
+                                  ScanTransaction* t) {
+  QStringList files_to_read;
+  QSet<QString> fast_files;
+  for (const QString& file : files_on_disk) {
+    // Files with a cue sheet are handled section by section.
+    if (GetMtimeForCue(NoExtensionPart(file) + ".cue")) continue;
+    if (t->IsQuarantined(file)) continue;
+
+    Song matching_song;
+    if (!t->FindSongByPath(file, &matching_song)) {
+      // New files are always read.
+      files_to_read << file;
+    } else if (matching_song.has_cue()) {
+      continue;
+    } else if (t->ignores_mtime()) {
+      // A full rescan is asked for to fix up what a fast read can't see, so
+      // every file gets a full read.
+      files_to_read << file;
+    } else if (matching_song.mtime() !=
+               QFileInfo(file).lastModified().toTime_t()) {
+      // It's changed, so ScanSubdirectory will reread it.  Files are often
+      // touched without their tags changing, so a quick look first tells
+      // whether a full read is needed.
+      files_to_read << file;
+      if (!matching_song.is_unavailable()) fast_files << file;
+    }
+  }
+
+  t->ReadAhead(files_to_read, fast_files);
+}
+
+bool LibraryWatcher::FindMovedSong(const QString& file,
+                                   const QString& matching_cue,
+                                   ScanTransaction* t, Song* out) {
+  // All the sections of a cue sheet share the same file, so they can't be
+  // matched one to one.
+  if (GetMtimeForCue(matching_cue)) return false;
+
+  const QString identity = Utilities::FileIdentity(file);
+  if (identity.isEmpty()) return false;
+
+  Song song;
+  if (!t->FindSongByFileIdentity(identity, &song)) return false;
+  if (song.has_cue() || t->IsMoved(song.id())) return false;
+
+  // If the old file is still there then this is a copy or a hard link.
+  const QString old_path = song.url().toLocalFile();
+  if (old_path == file || QFile::exists(old_path)) return false;
+
+  // A move keeps the file as it was.  Inodes are reused, so without this a
+  // new file could take over the tags and statistics of a deleted one.
+  QFileInfo info(file);
+  if (info.size() != song.filesize() ||
+      info.lastModified().toTime_t() != song.mtime()) {
+    return false;
+  }
+
+  qLog(Debug) << file << "moved from" << old_path;
+
+  t->SongMoved(song);
+
+  song.set_url(QUrl::fromLocalFile(file));
+  song.set_basefilename(info.fileName());
+  song.set_directory_id(t->dir_id());
+  song.set_mtime(info.lastModified().toTime_t());
+  song.set_filesize(info.size());
+  song.set_unavailable(false);
+
+  *out = song;
+  return true;
+}
+
+void LibraryWatcher::ReadSong(const QString& file, Song* out,
+                              ScanTransaction* t, bool* fast_read) {
+  if (fast_read) *fast_read = false;
+  if (t->IsQuarantined(file)) {
+    qLog(Debug) << "Not reading" << file << "- it crashed the tag reader";
+    return;
+  }
+
+  static metrics::Counter* songs_read = metrics::GetCounter(
+      "clementine_library_songs_read_total",
+      "Files the library scanner read the tags of");
+  songs_read->Increment();
+
+  if (t->TakeReadAheadSong(file, out, fast_read)) return;
+  TagReaderClient::Instance()->ReadFileBlocking(
+      file, out, TagReaderClient::Priority_Background);
+}
+
+bool LibraryWatcher::FastReadMatches(const Song& fast_read,
+                                     const Song& matching_song,
+                                     const QString& image) {
+  // Lyrics and the audio properties aren't read properly, so they're not
+  // compared, but they can hardly change without the size of the file
+  // changing too.  The playcount in the file is never used.
+  if (!fast_read.is_valid() ||
+      fast_read.filesize() != matching_song.filesize() ||
+      fast_read.has_embedded_cover() != matching_song.has_embedded_cover()) {
+    return false;
+  }
+  if (!matching_song.has_embedded_cover() &&
+      matching_song.art_automatic() != image) {
+    return false;
+  }
+
+  return fast_read.title() == matching_song.title() &&
+         fast_read.album() == matching_song.album() &&
+         fast_read.artist() == matching_song.artist() &&
+         fast_read.albumartist() == matching_song.albumartist() &&
+         fast_read.composer() == matching_song.composer() &&
+         fast_read.performer() == matching_song.performer() &&
+         fast_read.grouping() == matching_song.grouping() &&
+         fast_read.track() == matching_song.track() &&
+         fast_read.disc() == matching_song.disc() &&
+         fast_read.year() == matching_song.year() &&
+         fast_read.originalyear() == matching_song.originalyear() &&
+         fast_read.genre() == matching_song.genre() &&
+         fast_read.comment() == matching_song.comment() &&
+         fast_read.is_compilation() == matching_song.is_compilation() &&
+         fast_read.bpm() == matching_song.bpm() &&
+         (fast_read.rating() == -1.0f ||
+          fast_read.rating() == matching_song.rating()) &&
+         fast_read.replaygain_track_gain() ==
+             matching_song.replaygain_track_gain() &&
+         fast_read.replaygain_track_peak() ==
+             matching_song.replaygain_track_peak() &&
+         fast_read.replaygain_album_gain() ==
+             matching_song.replaygain_album_gain() &&
+         fast_read.replaygain_album_peak() ==
+             matching_song.replaygain_album_peak();
+}
+
 void LibraryWatcher::PreserveUserSetData(const QString& file,
                                          const QString& image,
                                          const Song& matching_song, Song* out,
                                          ScanTransaction* t) {
   out->set_id(matching_song.id());
+  out->set_file_identity(Utilities::FileIdentity(file));
 
   // Previous versions of Clementine incorrectly overwrote this and
   // stored it in the DB, so we can't rely on matching_song to
@@ -607,6 +1096,42 @@ void LibraryWatcher::PreserveUserSetData(const QString& file,
   }
 }
 
+SongList LibraryWatcher::LoadCueSheet(const QString& cue_path,
+                                      const QString& path,
+                                      ScanTransaction* t) {
+  const QFileInfo cue_info(cue_path);
+  const uint mtime = GetMtimeForCue(cue_path);
+  const qint64 size = cue_info.size();
+
+  SongList songs;
+  if (backend_->GetCachedCueSheet(cue_path, mtime, size, &songs)) {
+    // The sheet hasn't changed, but the sections also hold the tags of the
+    // files they're in, so those have to be unchanged too.  A section's mtime
+    // is the later of its file's and the sheet's.
+    bool files_changed = false;
+    QSet<QUrl> checked_files;
+    for (const Song& song : songs) {
+      if (checked_files.contains(song.url())) continue;
+      checked_files << song.url();
+
+      const QFileInfo info(song.url().toLocalFile());
+      if (!info.exists() || info.size() != song.filesize() ||
+          info.lastModified().toTime_t() > uint(song.mtime())) {
+        files_changed = true;
+        break;
+      }
+    }
+    if (!files_changed) return songs;
+  }
+
+  QFile cue(cue_path);
+  cue.open(QIODevice::ReadOnly);
+  songs = t->cue_parser()->Load(&cue, cue_path, path);
+
+  backend_->CacheCueSheet(cue_path, mtime, size, songs);
+  return songs;
+}
+
 uint LibraryWatcher::GetMtimeForCue(const QString& cue_path) {
   // slight optimisation
   if (cue_path.isEmpty()) {
@@ -629,6 +1154,9 @@ void LibraryWatcher::AddWatch(const Directory& dir, const QString& path) {
 
   connect(fs_watcher_, SIGNAL(PathChanged(const QString&)), this,
           SLOT(DirectoryChanged(const QString&)), Qt::UniqueConnection);
+  connect(fs_watcher_, SIGNAL(FilesChanged(const QString&, const QStringList&)),
+          this, SLOT(FilesChanged(const QString&, const QStringList&)),
+          Qt::UniqueConnection);
   if (!fs_watcher_->AddPath(path)) {
     // Since this may be a system error, don't spam the user.
     static int errCount = 0;
@@ -673,6 +1201,7 @@ void LibraryWatcher::RemoveDirectory(int dir_id) {
 
 void LibraryWatcher::DoRemoveDirectory(int dir_id) {
   rescan_queue_.remove(dir_id);
+  rescan_files_queue_.remove(dir_id);
 
   const WatchedDir& dir = watched_dirs_.list_[dir_id];
   // Stop watching the directory's subdirectories
@@ -683,18 +1212,6 @@ void LibraryWatcher::DoRemoveDirectory(int dir_id) {
   watched_dirs_.Remove(dir_id);
 }
 
-bool LibraryWatcher::FindSongByPath(const SongList& list, const QString& path,
-                                    Song* out) {
-  // TODO: Make this faster
-  for (const Song& song : list) {
-    if (song.url().toLocalFile() == path) {
-      *out = song;
-      return true;
-    }
-  }
-  return false;
-}
-
 void LibraryWatcher::DirectoryChanged(const QString& subdir) {
   // Find what dir it was in
   QHash<QString, Directory>::const_iterator it =
@@ -713,8 +1230,28 @@ void LibraryWatcher::DirectoryChanged(const QString& subdir) {
   if (!rescan_paused_) rescan_timer_->start();
 }
 
+void LibraryWatcher::FilesChanged(const QString& subdir,
+                                  const QStringList& files) {
+  QHash<QString, Directory>::const_iterator it =
+      subdir_mapping_.constFind(subdir);
+  if (it == subdir_mapping_.constEnd()) {
+    return;
+  }
+  const Directory& dir = *it;
+
+  qLog(Debug) << files.count() << "files changed in" << subdir
+              << "under directory" << dir.path << "id" << dir.id;
+
+  rescan_files_queue_[dir.id][subdir].unite(files.toSet());
+
+  if (!rescan_paused_) rescan_timer_->start();
+}
+
 void LibraryWatcher::RescanPathsNow() {
-  for (int id : rescan_queue_.keys()) {
+  QSet<int> ids = rescan_queue_.keys().toSet();
+  ids.unite(rescan_files_queue_.keys().toSet());
+
+  for (int id : ids) {
     if (!watched_dirs_.list_.contains(id)) {
       qLog(Warning) << "Rescan id" << id << "not in watch list.";
       continue;
@@ -723,10 +1260,18 @@ void LibraryWatcher::RescanPathsNow() {
 
     if (!dir.active_) continue;
 
-    ScanTransaction transaction(this, dir, false);
-    transaction.AddToProgressMax(rescan_queue_[id].count());
+    const QStringList& paths = rescan_queue_[id];
+    QHash<QString, QSet<QString>>& files = rescan_files_queue_[id];
+    for (const QString& path : paths) {
+      files.remove(path);
+    }
+
+    // Only part of the directory is rescanned, so the checkpoint of an
+    // interrupted full scan must be kept.
+    ScanTransaction transaction(this, dir, false, false, false);
+    transaction.AddToProgressMax(paths.count() + files.count());
 
-    for (const QString& path : rescan_queue_[id]) {
+    for (const QString& path : paths) {
       if (transaction.aborted()) return;
       Subdirectory subdir;
       subdir.directory_id = id;
@@ -734,9 +1279,20 @@ void LibraryWatcher::RescanPathsNow() {
       subdir.path = path;
       ScanSubdirectory(path, subdir, &transaction);
     }
+
+    for (QHash<QString, QSet<QString>>::const_iterator it = files.constBegin();
+         it != files.constEnd(); ++it) {
+      if (transaction.aborted()) return;
+      Subdirectory subdir;
+      subdir.directory_id = id;
+      subdir.mtime = 0;
+      subdir.path = it.key();
+      ScanSubdirectory(it.key(), subdir, &transaction, false, &it.value());
+    }
   }
 
   rescan_queue_.clear();
+  rescan_files_queue_.clear();
 
   emit CompilationsNeedUpdating();
 }
@@ -825,6 +1381,9 @@ void LibraryWatcher::ReloadSettings() {
   s.beginGroup(kSettingsGroup);
   scan_on_startup_ = s.value("startup_scan", true).toBool();
   monitor_ = s.value("monitor", true).toBool();
+  parallel_scan_ = s.value("parallel_scan", false).toBool();
+  tag_read_window_ =
+      qMax(1, s.value("tag_read_window", kDefaultTagReadWindow).toInt());
 
   best_image_filters_.clear();
   QStringList filters = s.value("cover_art_patterns", QStringList() << "front"
@@ -862,7 +1421,9 @@ void LibraryWatcher::SetRescanPausedAsync(bool pause) {
 
 void LibraryWatcher::SetRescanPaused(bool pause) {
   rescan_paused_ = pause;
-  if (!rescan_paused_ && !rescan_queue_.isEmpty()) RescanPathsNow();
+  if (!rescan_paused_ &&
+      (!rescan_queue_.isEmpty() || !rescan_files_queue_.isEmpty()))
+    RescanPathsNow();
 }
 
 void LibraryWatcher::IncrementalScanAsync() {
@@ -878,30 +1439,102 @@ void LibraryWatcher::IncrementalScanNow() { PerformScan(true, false); }
 void LibraryWatcher::FullScanNow() { PerformScan(false, true); }
 
 void LibraryWatcher::PerformScan(bool incremental, bool ignore_mtimes) {
-  for (const WatchedDir& dir : watched_dirs_.list_.values()) {
-    qLog(Debug) << "Scanning library directory" << dir.GetPath();
-    ScanTransaction transaction(this, dir, incremental, ignore_mtimes);
-    SubdirectoryList subdirs(transaction.GetAllSubdirs());
-
-    // On Linux systems, if the library directory is deleted then re-created,
-    // inotify won't find it. This could be corrected by watching parent
-    // directories, but not worth the complexity for an edge case.
-    if (subdirs.isEmpty()) {
-      qLog(Debug) << "Library directory wasn't in subdir list.";
-      Subdirectory subdir;
-      subdir.path = dir.GetPath();
-      subdir.directory_id = dir.GetId();
-      subdirs << subdir;
-    }
+  if (parallel_scan_ && watched_dirs_.list_.count() > 1) {
+    PerformParallelScan(incremental, ignore_mtimes);
+    return;
+  }
 
-    transaction.AddToProgressMax(subdirs.count());
+  for (const WatchedDir& dir : watched_dirs_.list_) {
+    if (!ScanWatchedDir(dir, incremental, ignore_mtimes)) return;
+  }
 
-    for (const Subdirectory& subdir : subdirs) {
-      if (transaction.aborted()) return;
+  emit CompilationsNeedUpdating();
+}
 
-      ScanSubdirectory(subdir.path, subdir, &transaction);
-    }
+bool LibraryWatcher::ScanWatchedDir(const WatchedDir& dir, bool incremental,
+                                    bool ignore_mtimes) {
+  qLog(Debug) << "Scanning library directory" << dir.GetPath();
+  ScanTransaction transaction(this, dir, incremental, ignore_mtimes);
+  SubdirectoryList subdirs(transaction.GetAllSubdirs());
+
+  // On Linux systems, if the library directory is deleted then re-created,
+  // inotify won't find it. This could be corrected by watching parent
+  // directories, but not worth the complexity for an edge case.
+  if (subdirs.isEmpty()) {
+    qLog(Debug) << "Library directory wasn't in subdir list.";
+    Subdirectory subdir;
+    subdir.path = dir.GetPath();
+    subdir.directory_id = dir.GetId();
+    subdirs << subdir;
   }
 
+  transaction.AddToProgressMax(subdirs.count());
+
+  for (const Subdirectory& subdir : subdirs) {
+    if (transaction.aborted()) return false;
+
+    ScanSubdirectory(subdir.path, subdir, &transaction);
+  }
+
+  return true;
+}
+
+void LibraryWatcher::PerformParallelScan(bool incremental,
+                                         bool ignore_mtimes) {
+  // Keep one queue of directories per physical volume.  Directories whose
+  // volume can't be determined get a queue of their own.
+  QMap<QString, QList<int>> volumes;
+  for (const WatchedDir& dir : watched_dirs_.list_) {
+    QStorageInfo storage(dir.path);
+    QString key = storage.isValid() ? QString::fromLocal8Bit(storage.device())
+                                    : dir.path;
+    if (key.isEmpty()) key = dir.path;
+    volumes[key] << dir.id;
+  }
+
+  qLog(Debug) << "Scanning" << watched_dirs_.list_.count()
+              << "library directories on" << volumes.count() << "volumes";
+
+  // The watch list is only modified on this thread, which blocks until every
+  // volume has been scanned, so the pool threads can safely read it.
+  QList<QFuture<void>> futures;
+  for (const QList<int>& dir_ids : volumes) {
+    futures << ConcurrentRun::Run<void>(
+        &scan_thread_pool_, std::bind(&LibraryWatcher::ScanVolume, this,
+                                      dir_ids, incremental, ignore_mtimes));
+  }
+  for (QFuture<void>& future : futures) {
+    future.waitForFinished();
+  }
+
+  ApplyPendingWatches();
+
   emit CompilationsNeedUpdating();
 }
+
+void LibraryWatcher::ScanVolume(const QList<int>& dir_ids, bool incremental,
+                                bool ignore_mtimes) {
+  Utilities::SetThreadIOPriority(Utilities::IOPRIO_CLASS_IDLE);
+
+  for (int id : dir_ids) {
+    QMap<int, WatchedDir>::const_iterator it =
+        watched_dirs_.list_.constFind(id);
+    if (it == watched_dirs_.list_.constEnd()) continue;
+
+    if (!ScanWatchedDir(*it, incremental, ignore_mtimes)) return;
+  }
+}
+
+void LibraryWatcher::ApplyPendingWatches() {
+  QMutexLocker l(&pending_watches_mutex_);
+
+  for (const QPair<Directory, Subdirectory>& watch : pending_removed_watches_) {
+    RemoveWatch(watch.first, watch.second);
+  }
+  for (const QPair<Directory, QString>& watch : pending_added_watches_) {
+    AddWatch(watch.first, watch.second);
+  }
+
+  pending_removed_watches_.clear();
+  pending_added_watches_.clear();
+}
@@ -22,9 +22,16 @@
 #include <QMap>
 #include <QMutex>
 #include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
 #include <QStringList>
+#include <QThreadPool>
+
+#include <memory>
 
 #include "core/song.h"
+#include "core/tagreaderclient.h"
 #include "directory.h"
 
 class QFileSystemWatcher;
@@ -43,6 +50,21 @@ class LibraryWatcher : public QObject {
 
   static const char* kSettingsGroup;
 
+  // The maximum number of volumes that are scanned at the same time when
+  // parallel scanning is enabled.
+  static const int kMaxParallelScanVolumes;
+
+  // How many subdirectories are scanned before the results so far are
+  // committed to the library and recorded in the scan checkpoint.
+  static const int kCheckpointInterval;
+
+  // How many files a scan has tag reads in flight for, unless the
+  // tag_read_window setting says otherwise.
+  static const int kDefaultTagReadWindow;
+
+  // The most files in one batched tag read request of the read-ahead window.
+  static const int kTagReadBatchSize;
+
   void set_backend(LibraryBackend* backend) { backend_ = backend; }
   void set_task_manager(TaskManager* task_manager) {
     task_manager_ = task_manager;
@@ -70,6 +92,8 @@ class LibraryWatcher : public QObject {
   void SubdirsDiscovered(const SubdirectoryList& subdirs);
   void SubdirsMTimeUpdated(const SubdirectoryList& subdirs);
   void CompilationsNeedUpdating();
+  void ScanCheckpointReached(const SubdirectoryList& subdirs);
+  void ScanCheckpointCleared(int dir_id);
 
   void ScanStarted(int task_id);
 
@@ -93,19 +117,28 @@ class LibraryWatcher : public QObject {
   // Each directory has one or more subdirectories, and any number of
   // subdirectories can be scanned during one transaction.  ScanSubdirectory()
   // adds its results to the members of this transaction class, and they are
-  // "committed" through calls to the LibraryBackend in the transaction's dtor.
+  // "committed" through calls to the LibraryBackend in the transaction's dtor,
+  // and also every kCheckpointInterval subdirectories so that a long scan of a
+  // whole directory that gets interrupted can resume from the last checkpoint.
+  // Scans of only part of a directory leave its checkpoint alone.
   // The transaction also caches the list of songs in this directory according
   // to the library.  Multiple calls to FindSongsInSubdirectory during one
   // transaction will only result in one call to
-  // LibraryBackend::FindSongsInDirectory.
+  // LibraryBackend::FindSongsInDirectory, and the songs are indexed by
+  // subdirectory and file as they're loaded so each lookup is a hash lookup.
   class ScanTransaction {
    public:
     ScanTransaction(LibraryWatcher* watcher,
                     const LibraryWatcher::WatchedDir& dir, bool incremental,
-                    bool ignores_mtime = false);
+                    bool ignores_mtime = false, bool whole_directory = true);
     ~ScanTransaction();
 
     SongList FindSongsInSubdirectory(const QString& path);
+    // The available songs in the library for this file, more than one if
+    // it's in a cue sheet.
+    SongList FindSongsForFile(const QString& file);
+    // The first song in the library for this file, even if it's unavailable.
+    bool FindSongByPath(const QString& file, Song* out);
     bool HasSeenSubdir(const QString& path);
     void SetKnownSubdirs(const SubdirectoryList& subdirs);
     SubdirectoryList GetImmediateSubdirs(const QString& path);
@@ -114,6 +147,41 @@ class LibraryWatcher : public QObject {
     void AddToProgress(int n = 1);
     void AddToProgressMax(int n);
 
+    // True if a previous scan of this directory was interrupted.  The
+    // subdirectories it had already finished are skipped.
+    bool resuming() const { return !checkpoint_.isEmpty(); }
+    bool IsCheckpointed(const QString& path, uint mtime) const;
+
+    // True if the file has crashed the tag reader and hasn't changed since,
+    // see LibraryBackend::QuarantinedFiles.  Its tags aren't read.
+    bool IsQuarantined(const QString& file) const;
+
+    // Looks for a song in this directory whose file has the given identity.
+    // Returns false if there isn't exactly one.
+    bool FindSongByFileIdentity(const QString& identity, Song* out);
+    // Marks a song as moved so it isn't treated as deleted from its old path.
+    void SongMoved(const Song& song);
+    bool IsMoved(int song_id) const { return moved_song_ids_.contains(song_id); }
+    // Each transaction has a parser of its own, since transactions of a
+    // parallel scan run on several threads at once.
+    CueParser* cue_parser();
+    // Called when all the files in a subdirectory, and all its children, have
+    // been scanned.
+    void SubdirectoryFinished(const Subdirectory& subdir);
+
+    // Starts reading the tags of these files, keeping up to the watcher's
+    // tag read window of files in flight so every tag reader worker has
+    // something to do.  The files should be taken in the same order; any
+    // that are passed over are dropped.  Files in fast_files get a fast read,
+    // see TagReader::ReadFile.  The rest are read in batches.
+    void ReadAhead(const QStringList& files,
+                   const QSet<QString>& fast_files = QSet<QString>());
+    // Waits for the tags of a file given to ReadAhead().  Returns false if
+    // the file wasn't read ahead.  fast_read is set if it was a fast read; if
+    // fast_read is null, fast reads are thrown away and false is returned.
+    bool TakeReadAheadSong(const QString& file, Song* out,
+                           bool* fast_read = nullptr);
+
     int dir_id() const { return dir_.id; }
     bool is_incremental() const { return incremental_; }
     bool ignores_mtime() const { return ignores_mtime_; }
@@ -131,6 +199,9 @@ class LibraryWatcher : public QObject {
    private:
     ScanTransaction& operator=(const ScanTransaction&) { return *this; }
 
+    // Sends the results so far to the LibraryBackend and clears them.
+    void CommitResults();
+
     int task_id_;
     int progress_;
     int progress_max_;
@@ -147,25 +218,76 @@ class LibraryWatcher : public QObject {
 
     LibraryWatcher* watcher_;
 
+    void LoadCachedSongs();
+
     SongList cached_songs_;
     bool cached_songs_dirty_;
+    // Built with cached_songs_.  Both include unavailable songs.
+    QHash<QString, SongList> songs_by_subdir_;
+    QHash<QString, SongList> songs_by_file_;
+
+    // Built from cached_songs_ the first time it's needed.  Identities shared
+    // by more than one song map to an invalid Song.
+    QHash<QString, Song> songs_by_identity_;
+    bool songs_by_identity_dirty_;
+    QSet<int> moved_song_ids_;
 
     SubdirectoryList known_subdirs_;
     bool known_subdirs_dirty_;
+    // Built with known_subdirs_, only for subdirectories with an mtime.
+    QSet<QString> seen_subdirs_;
+    QHash<QString, SubdirectoryList> subdirs_by_parent_;
+
+    void FillReadAheadWindow();
+    void ClearReadAhead();
+
+    // A ReadFile request for one file, or a ReadFiles request for a batch of
+    // files that all get a full read.  The files still to be taken are
+    // files[next] onwards.
+    struct ReadAheadRequest {
+      QStringList files;
+      int next;
+      bool fast;
+      TagReaderReply* reply;
+    };
+
+    // Files given to ReadAhead() that haven't been requested yet, then the
+    // requests in flight, both in the order the files will be taken.
+    QQueue<QString> read_ahead_files_;
+    QQueue<ReadAheadRequest> read_ahead_replies_;
+    // How many files of read_ahead_replies_ are still to be taken.
+    int read_ahead_in_flight_;
+    QSet<QString> read_ahead_set_;
+    QSet<QString> read_ahead_fast_;
+
+    // Only whole directory scans, with a checkpoints table in the backend,
+    // read and write the checkpoint.
+    bool uses_checkpoint_;
+    // Subdirectories finished in earlier, interrupted, scans (path -> mtime).
+    QHash<QString, uint> checkpoint_;
+    bool has_checkpoint_;
+
+    QHash<QString, uint> quarantined_;
+    // Subdirectories finished since the last checkpoint.
+    SubdirectoryList finished_subdirs_;
+
+    std::unique_ptr<CueParser> cue_parser_;
   };
 
  private slots:
   void DirectoryChanged(const QString& path);
+  void FilesChanged(const QString& path, const QStringList& files);
   void IncrementalScanNow();
   void FullScanNow();
   void RescanPathsNow();
+  // If only_files is given, only those files in the subdirectory are compared
+  // against the library.
   void ScanSubdirectory(const QString& path, const Subdirectory& subdir,
-                        ScanTransaction* t, bool force_noincremental = false);
+                        ScanTransaction* t, bool force_noincremental = false,
+                        const QSet<QString>* only_files = nullptr);
   void DoRemoveDirectory(int dir_id);
 
  private:
-  static bool FindSongByPath(const SongList& list, const QString& path,
-                             Song* out);
   inline static QString NoExtensionPart(const QString& fileName);
   inline static QString ExtensionPart(const QString& fileName);
   inline static QString DirectoryPart(const QString& fileName);
@@ -176,7 +298,26 @@ class LibraryWatcher : public QObject {
   void AddWatch(const Directory& dir, const QString& path);
   void RemoveWatch(const Directory& dir, const Subdirectory& subdir);
   uint GetMtimeForCue(const QString& cue_path);
+  // Parses a cue sheet, or returns the songs it was parsed into last time if
+  // neither it nor the files it refers to have changed since.
+  SongList LoadCueSheet(const QString& cue_path, const QString& path,
+                        ScanTransaction* t);
   void PerformScan(bool incremental, bool ignore_mtimes);
+  // Scans every subdirectory of a single watched directory.  Returns false if
+  // the scan was aborted.
+  bool ScanWatchedDir(const WatchedDir& dir, bool incremental,
+                      bool ignore_mtimes);
+  // Groups the watched directories by the volume they live on and scans each
+  // volume on its own thread from scan_thread_pool_.  Directories on the same
+  // volume are still scanned one after another so spinning disks are read
+  // sequentially.
+  void PerformParallelScan(bool incremental, bool ignore_mtimes);
+  // Runs on a scan_thread_pool_ thread.
+  void ScanVolume(const QList<int>& dir_ids, bool incremental,
+                  bool ignore_mtimes);
+  // Applies watch changes queued by transactions that finished on a
+  // scan_thread_pool_ thread.  Must be called on the watcher's thread.
+  void ApplyPendingWatches();
 
   // Updates the sections of a cue associated and altered (according to mtime)
   // media file during a scan.
@@ -200,7 +341,23 @@ class LibraryWatcher : public QObject {
   // has many sections (like a CUE related media file).
   SongList ScanNewFile(const QString& file, const QString& path,
                        const QString& matching_cue,
-                       QSet<QString>* cues_processed);
+                       QSet<QString>* cues_processed, ScanTransaction* t);
+  // Starts reading the tags of every file in a subdirectory that we already
+  // know, or expect, will need to be read.
+  void PrefetchTags(const QStringList& files_on_disk, ScanTransaction* t);
+  // Looks for a song in the library that was moved to this file from
+  // somewhere else in the same directory, by comparing file identities.  If
+  // one is found it's updated with its new path, keeping its tags and user
+  // data, and returned in out.
+  bool FindMovedSong(const QString& file, const QString& matching_cue,
+                     ScanTransaction* t, Song* out);
+  // Reads a single file, using the prefetched tags if there are any.
+  void ReadSong(const QString& file, Song* out, ScanTransaction* t,
+                bool* fast_read = nullptr);
+  // True if a song from a fast read has the same tags as the library's song,
+  // so there's no need to read it properly.
+  static bool FastReadMatches(const Song& fast_read, const Song& matching_song,
+                              const QString& image);
 
  private:
   LibraryBackend* backend_;
@@ -222,6 +379,8 @@ class LibraryWatcher : public QObject {
 
   bool scan_on_startup_;
   bool monitor_;
+  bool parallel_scan_;
+  int tag_read_window_;
 
   // All methods of QMap are reentrant We should only need to worry about
   // syncronizing methods that remove directories on the watcher thread and
@@ -247,11 +406,20 @@ class LibraryWatcher : public QObject {
   QTimer* rescan_timer_;
   QMap<int, QStringList>
       rescan_queue_;  // dir id -> list of subdirs to be scanned
+  // dir id -> subdir -> files in that subdir to be rescanned.  Subdirs that
+  // are also in rescan_queue_ are scanned fully instead.
+  QMap<int, QHash<QString, QSet<QString>>> rescan_files_queue_;
   bool rescan_paused_;
 
   int total_watches_;
 
-  CueParser* cue_parser_;
+  QThreadPool scan_thread_pool_;
+
+  // QFileSystemWatcher isn't thread safe, so transactions that finish on a
+  // scan_thread_pool_ thread queue their watch changes here instead.
+  QMutex pending_watches_mutex_;
+  QList<QPair<Directory, QString>> pending_added_watches_;
+  QList<QPair<Directory, Subdirectory>> pending_removed_watches_;
 
   static QStringList sValidImages;
 };
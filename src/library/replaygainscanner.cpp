@@ -0,0 +1,447 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "replaygainscanner.h"
+
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <QThread>
+#include <QTimerEvent>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
+#include "core/logging.h"
+#include "core/loudnessmeter.h"
+#include "core/player.h"
+#include "core/signalchecker.h"
+#include "core/tagreaderclient.h"
+#include "core/taskmanager.h"
+#include "engines/gstengine.h"
+#include "library/librarybackend.h"
+
+const int ReplayGainScanner::kIdleMsec = 5 * 60 * 1000;  // 5 minutes
+const float ReplayGainScanner::kMaxGain = 24.0;
+
+namespace {
+
+// A file that doesn't decode anything for this long is given up on.
+const int kStallSecs = 30;
+
+// Decodes one file into a LoudnessMeter.
+class TrackMeasurement {
+ public:
+  TrackMeasurement(const QString& filename, const QAtomicInt* abort)
+      : filename_(filename),
+        abort_(abort),
+        convert_(nullptr),
+        channels_(0),
+        buffers_(0) {}
+
+  // Returns false if the file couldn't be decoded or abort was set.
+  bool Run();
+
+  const LoudnessMeter& meter() const { return *meter_; }
+
+ private:
+  static GstElement* CreateElement(const char* factory_name, GstElement* bin);
+  static void NewPadCallback(GstElement*, GstPad* pad, gpointer data);
+  static GstFlowReturn NewSampleCallback(GstAppSink* app_sink, gpointer self);
+
+  const QString filename_;
+  const QAtomicInt* abort_;
+
+  GstElement* convert_;
+
+  // Made from the first sample's caps, in a streaming thread.  Only read
+  // here once the pipeline has stopped.
+  int channels_;
+  std::unique_ptr<LoudnessMeter> meter_;
+
+  // Counts the buffers decoded so far, to notice when decoding stalls.
+  QAtomicInt buffers_;
+};
+
+GstElement* TrackMeasurement::CreateElement(const char* factory_name,
+                                            GstElement* bin) {
+  GstElement* ret = gst_element_factory_make(factory_name, nullptr);
+  if (!ret) {
+    qLog(Warning) << "Couldn't create the gstreamer element" << factory_name;
+    return nullptr;
+  }
+  gst_bin_add(GST_BIN(bin), ret);
+  return ret;
+}
+
+bool TrackMeasurement::Run() {
+  GstElement* pipeline = gst_pipeline_new("replaygain");
+  GstElement* src = CreateElement("filesrc", pipeline);
+  GstElement* decode = CreateElement("decodebin", pipeline);
+  GstElement* convert = CreateElement("audioconvert", pipeline);
+  GstElement* resample = CreateElement("audioresample", pipeline);
+  GstElement* sink = CreateElement("appsink", pipeline);
+
+  if (!src || !decode || !convert || !resample || !sink) {
+    gst_object_unref(pipeline);
+    return false;
+  }
+
+  convert_ = convert;
+  gst_element_link(src, decode);
+  gst_element_link(convert, resample);
+
+  // The meter's filters are for 48kHz, and it only knows mono and stereo, so
+  // audioconvert downmixes anything with more channels.
+  GstCaps* caps = gst_caps_new_simple(
+      "audio/x-raw", "format", G_TYPE_STRING, "F32LE", "layout", G_TYPE_STRING,
+      "interleaved", "rate", G_TYPE_INT, LoudnessMeter::kSampleRate,
+      "channels", GST_TYPE_INT_RANGE, 1, 2, nullptr);
+  gst_element_link_filtered(resample, sink, caps);
+  gst_caps_unref(caps);
+
+  GstAppSinkCallbacks callbacks;
+  memset(&callbacks, 0, sizeof(callbacks));
+  callbacks.new_sample = NewSampleCallback;
+  gst_app_sink_set_callbacks(reinterpret_cast<GstAppSink*>(sink), &callbacks,
+                             this, nullptr);
+  g_object_set(G_OBJECT(sink), "sync", FALSE, nullptr);
+  g_object_set(src, "location", filename_.toUtf8().constData(), nullptr);
+  CHECKED_GCONNECT(decode, "pad-added", &NewPadCallback, this);
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+  // The whole file has to be decoded, which can take a while, so keep
+  // waking up to see whether we've been told to stop.
+  GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+  bool finished = false;
+  int last_buffers = 0;
+  int stalled_secs = 0;
+  forever {
+    GstMessage* msg = gst_bus_timed_pop_filtered(
+        bus, GST_SECOND,
+        static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+
+    if (msg) {
+      if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError* error = nullptr;
+        gchar* debugs = nullptr;
+        gst_message_parse_error(msg, &error, &debugs);
+        qLog(Debug) << "Error measuring" << filename_ << ":"
+                    << QString::fromLocal8Bit(error->message);
+        g_error_free(error);
+        g_free(debugs);
+      } else {
+        finished = true;
+      }
+      gst_message_unref(msg);
+      break;
+    }
+
+    if (abort_->loadAcquire()) break;
+
+    const int buffers = buffers_.loadAcquire();
+    if (buffers != last_buffers) {
+      last_buffers = buffers;
+      stalled_secs = 0;
+    } else if (++stalled_secs >= kStallSecs) {
+      qLog(Warning) << "Decoding" << filename_ << "stalled";
+      break;
+    }
+  }
+
+  // Stop the streaming threads before the meter is used here.
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(pipeline);
+  convert_ = nullptr;
+
+  return finished && meter_ && !abort_->loadAcquire();
+}
+
+void TrackMeasurement::NewPadCallback(GstElement*, GstPad* pad,
+                                      gpointer data) {
+  TrackMeasurement* me = reinterpret_cast<TrackMeasurement*>(data);
+  GstPad* const audiopad = gst_element_get_static_pad(me->convert_, "sink");
+
+  if (!GST_PAD_IS_LINKED(audiopad)) gst_pad_link(pad, audiopad);
+  gst_object_unref(audiopad);
+}
+
+GstFlowReturn TrackMeasurement::NewSampleCallback(GstAppSink* app_sink,
+                                                  gpointer self) {
+  TrackMeasurement* me = reinterpret_cast<TrackMeasurement*>(self);
+
+  GstSample* sample = gst_app_sink_pull_sample(app_sink);
+  if (!sample) return GST_FLOW_ERROR;
+  if (me->abort_->loadAcquire()) {
+    gst_sample_unref(sample);
+    return GST_FLOW_EOS;
+  }
+
+  if (!me->meter_) {
+    GstCaps* caps = gst_sample_get_caps(sample);
+    if (caps) {
+      gst_structure_get_int(gst_caps_get_structure(caps, 0), "channels",
+                            &me->channels_);
+    }
+    if (me->channels_ < 1 || me->channels_ > 2) {
+      gst_sample_unref(sample);
+      return GST_FLOW_ERROR;
+    }
+    me->meter_.reset(new LoudnessMeter(me->channels_));
+  }
+
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    me->meter_->Process(reinterpret_cast<const float*>(map.data),
+                        int(map.size / (sizeof(float) * me->channels_)));
+    gst_buffer_unmap(buffer, &map);
+  }
+  gst_sample_unref(sample);
+
+  me->buffers_.ref();
+  return GST_FLOW_OK;
+}
+
+float ClampedGain(double loudness) {
+  return qBound(-ReplayGainScanner::kMaxGain,
+                float(LoudnessMeter::Gain(loudness)),
+                ReplayGainScanner::kMaxGain);
+}
+
+}  // namespace
+
+ReplayGainScanner::ReplayGainScanner(Application* app, QObject* parent)
+    : QObject(parent),
+      app_(app),
+      enabled_(false),
+      write_tags_(false),
+      max_jobs_(1),
+      running_(false),
+      loading_(false),
+      abort_(new QAtomicInt(0)),
+      next_job_id_(0),
+      done_(0),
+      total_(0),
+      task_id_(-1) {
+  connect(app_, SIGNAL(SettingsChanged()), SLOT(ReloadSettings()));
+  connect(app_->player(), SIGNAL(Playing()), SLOT(PlaybackStarted()));
+  connect(app_->player(), SIGNAL(Paused()), SLOT(PlaybackIdle()));
+  connect(app_->player(), SIGNAL(Stopped()), SLOT(PlaybackIdle()));
+  ReloadSettings();
+}
+
+ReplayGainScanner::~ReplayGainScanner() {
+  // Whatever is still being measured is thrown away.
+  abort_->storeRelease(1);
+}
+
+void ReplayGainScanner::ReloadSettings() {
+  QSettings s;
+  s.beginGroup(GstEngine::kSettingsGroup);
+  enabled_ = s.value("rganalyse", false).toBool() &&
+             s.value("rgenabled", false).toBool();
+  write_tags_ = s.value("rgwritetags", false).toBool();
+  max_jobs_ = qMax(1, s.value("rganalysejobs", 1).toInt());
+
+  if (!enabled_) {
+    idle_timer_.stop();
+    Pause();
+  } else if (!running_ && app_->player()->GetState() != Engine::Playing) {
+    idle_timer_.start(kIdleMsec, this);
+  }
+}
+
+void ReplayGainScanner::PlaybackStarted() {
+  idle_timer_.stop();
+  Pause();
+}
+
+void ReplayGainScanner::PlaybackIdle() {
+  if (enabled_ && !running_) idle_timer_.start(kIdleMsec, this);
+}
+
+void ReplayGainScanner::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != idle_timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  idle_timer_.stop();
+  if (enabled_) Start();
+}
+
+void ReplayGainScanner::Start() {
+  if (running_) return;
+  running_ = true;
+
+  task_id_ = app_->task_manager()->StartTask(tr("Analysing loudness"));
+
+  if (!queue_.isEmpty()) {
+    // Carrying on from where we were paused.
+    app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+    StartMore();
+    return;
+  }
+
+  if (loading_) return;
+  loading_ = true;
+
+  LibraryBackend* backend = app_->library_backend();
+  QFuture<SongList> future = Executor::Db()->Run<SongList>(
+      [backend]() { return backend->GetAllSongs(); });
+  NewClosure(future, this, SLOT(SongsLoaded(QFuture<SongList>)), future);
+}
+
+void ReplayGainScanner::SongsLoaded(QFuture<SongList> future) {
+  loading_ = false;
+
+  // Only the album's tracks without tags are measured together, so if some
+  // of an album's tracks already have tags the album gain is for the rest.
+  QMap<QString, SongList> albums;
+  for (const Song& song : future.result()) {
+    if (song.is_unavailable() || song.url().scheme() != "file") continue;
+    if (song.has_cue() || song.has_replaygain()) continue;
+    if (failed_ids_.contains(song.id())) continue;
+
+    const QString key =
+        song.album().isEmpty()
+            ? QString("#%1").arg(song.id())
+            : QString("%1:%2:%3").arg(QString::number(song.directory_id()),
+                                      song.effective_albumartist(),
+                                      song.album());
+    albums[key] << song;
+  }
+
+  queue_ = albums.values();
+  done_ = 0;
+  total_ = 0;
+  for (const SongList& album : queue_) total_ += album.count();
+  qLog(Info) << "Analysing the loudness of" << total_ << "songs";
+
+  if (!running_) return;
+  app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+  StartMore();
+}
+
+void ReplayGainScanner::StartMore() {
+  if (!running_) return;
+
+  while (jobs_.count() < max_jobs_ && !queue_.isEmpty()) {
+    const int job_id = next_job_id_++;
+    Job& job = jobs_[job_id];
+    job.songs_ = queue_.takeFirst();
+    job.abort_ = abort_;
+
+    const SongList songs = job.songs_;
+    std::shared_ptr<QAtomicInt> abort = abort_;
+    QFuture<SongList> future = Executor::Cpu()->Run<SongList>(
+        [songs, abort]() { return Analyse(songs, abort.get()); });
+    NewClosure(future, this, SLOT(AlbumFinished(QFuture<SongList>, int)),
+               future, job_id);
+  }
+
+  app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+  if (queue_.isEmpty() && jobs_.isEmpty()) Finish();
+}
+
+void ReplayGainScanner::AlbumFinished(QFuture<SongList> future, int job_id) {
+  const Job job = jobs_.take(job_id);
+
+  if (job.abort_->loadAcquire()) {
+    // Stopped part way through, so measure the album again next time.
+    queue_.prepend(job.songs_);
+    return;
+  }
+
+  const SongList measured = future.result();
+  QSet<int> measured_ids;
+  for (const Song& song : measured) measured_ids << song.id();
+  for (const Song& song : job.songs_) {
+    if (!measured_ids.contains(song.id())) failed_ids_ << song.id();
+  }
+  done_ += job.songs_.count();
+
+  if (!measured.isEmpty()) {
+    app_->library_backend()->UpdateReplayGainAsync(measured);
+    if (write_tags_) app_->tag_reader_client()->UpdateSongsReplayGain(measured);
+  }
+
+  StartMore();
+}
+
+void ReplayGainScanner::Pause() {
+  if (!running_) return;
+
+  running_ = false;
+  abort_->storeRelease(1);
+  abort_.reset(new QAtomicInt(0));
+  app_->task_manager()->SetTaskFinished(task_id_);
+  task_id_ = -1;
+}
+
+void ReplayGainScanner::Finish() {
+  qLog(Info) << "Finished analysing the loudness of the library";
+  Pause();
+  done_ = total_ = 0;
+}
+
+SongList ReplayGainScanner::Analyse(const SongList& songs,
+                                    const QAtomicInt* abort) {
+  Q_ASSERT(QThread::currentThread() != qApp->thread());
+
+  SongList ret;
+  std::vector<double> album_blocks;
+  float album_peak = 0;
+
+  for (const Song& song : songs) {
+    TrackMeasurement track(song.url().toLocalFile(), abort);
+    if (!track.Run()) {
+      if (abort->loadAcquire()) return SongList();
+      continue;
+    }
+
+    const LoudnessMeter& meter = track.meter();
+    album_blocks.insert(album_blocks.end(), meter.blocks().begin(),
+                        meter.blocks().end());
+    album_peak = qMax(album_peak, meter.peak());
+
+    Song copy(song);
+    copy.set_replaygain(ClampedGain(meter.IntegratedLoudness()), meter.peak(),
+                        std::numeric_limits<float>::quiet_NaN(),
+                        std::numeric_limits<float>::quiet_NaN());
+    ret << copy;
+  }
+
+  // Songs that aren't on an album don't get an album gain.
+  if (ret.isEmpty() || songs.first().album().isEmpty()) return ret;
+
+  const float album_gain =
+      ClampedGain(LoudnessMeter::IntegratedLoudness(album_blocks));
+  for (Song& song : ret) {
+    song.set_replaygain(song.replaygain_track_gain(),
+                        song.replaygain_track_peak(), album_gain, album_peak);
+  }
+  return ret;
+}
@@ -0,0 +1,111 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBRARY_REPLAYGAINSCANNER_H_
+#define LIBRARY_REPLAYGAINSCANNER_H_
+
+#include <QAtomicInt>
+#include <QBasicTimer>
+#include <QFuture>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <memory>
+
+#include "core/song.h"
+
+class Application;
+
+// Measures the loudness of the library's songs that don't have any Replay
+// Gain tags, and stores Replay Gain 2.0 values for them in the library so they
+// play at the same loudness as everything else.  The values can be written to
+// the files' tags as well.
+//
+// Like the MoodbarPrecomputer it only runs once nothing has been playing for a
+// while, and stops as soon as something starts playing again.  Songs are
+// measured an album at a time, so they get an album gain too.
+class ReplayGainScanner : public QObject {
+  Q_OBJECT
+
+ public:
+  ReplayGainScanner(Application* app, QObject* parent = nullptr);
+  ~ReplayGainScanner();
+
+  static const int kIdleMsec;
+  // Measured gains are kept within this many dB either way, so a track that's
+  // almost silent isn't turned up until it clips.
+  static const float kMaxGain;
+
+  // Decodes and measures the songs, which should all be on the same album,
+  // and returns the ones that could be measured with their Replay Gain set.
+  // Returns nothing if abort was set before it finished.  Blocks for a long
+  // time, so don't call it from the GUI thread.
+  static SongList Analyse(const SongList& songs, const QAtomicInt* abort);
+
+ public slots:
+  // Starts going through the library straight away, or carries on where it
+  // left off.
+  void Start();
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private slots:
+  void ReloadSettings();
+  void PlaybackStarted();
+  void PlaybackIdle();
+
+  void SongsLoaded(QFuture<SongList> future);
+  void AlbumFinished(QFuture<SongList> future, int job_id);
+
+ private:
+  struct Job {
+    SongList songs_;
+    std::shared_ptr<QAtomicInt> abort_;
+  };
+
+  void StartMore();
+  void Pause();
+  void Finish();
+
+  Application* app_;
+
+  bool enabled_;
+  bool write_tags_;
+  int max_jobs_;
+
+  QBasicTimer idle_timer_;
+  bool running_;
+  bool loading_;
+
+  // Set when the scanner pauses, to stop the albums being measured.  Each
+  // run gets a new one.
+  std::shared_ptr<QAtomicInt> abort_;
+
+  QList<SongList> queue_;
+  QMap<int, Job> jobs_;
+  int next_job_id_;
+  // Songs that couldn't be decoded, so they're not tried again every time.
+  QSet<int> failed_ids_;
+
+  int done_;
+  int total_;
+  int task_id_;
+};
+
+#endif  // LIBRARY_REPLAYGAINSCANNER_H_
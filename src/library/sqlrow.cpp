@@ -22,13 +22,22 @@
 
 #include "libraryquery.h"
 
-SqlRow::SqlRow(const QSqlQuery& query) { Init(query); }
+SqlRow::SqlRow() : query_(nullptr) {}
 
-SqlRow::SqlRow(const LibraryQuery& query) { Init(query); }
+SqlRow::SqlRow(const QSqlQuery& query) : query_(nullptr) { Init(query); }
+
+SqlRow::SqlRow(const LibraryQuery& query) : query_(nullptr) { Init(query); }
+
+SqlRow SqlRow::View(const QSqlQuery& query) {
+  SqlRow ret;
+  ret.query_ = &query;
+  return ret;
+}
 
 void SqlRow::Init(const QSqlQuery& query) {
-  int rows = query.record().count();
-  for (int i = 0; i < rows; ++i) {
+  const int columns = query.record().count();
+  columns_.reserve(columns);
+  for (int i = 0; i < columns; ++i) {
     columns_ << query.value(i);
   }
 }
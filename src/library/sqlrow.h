@@ -19,26 +19,42 @@
 #define SQLROW_H
 
 #include <QList>
+#include <QSqlQuery>
 #include <QVariant>
-
-class QSqlQuery;
+#include <QVector>
 
 class LibraryQuery;
 
 class SqlRow {
  public:
   // WARNING: Implicit construction from QSqlQuery and LibraryQuery.
+  // These copy the query's current row, so they can be kept after it moves.
   SqlRow(const QSqlQuery& query);
   SqlRow(const LibraryQuery& query);
 
-  const QVariant& value(int i) const { return columns_[i]; }
+  // A row that reads its values from query's current row rather than copying
+  // them.  The query has to stay on that row while this is used, so it's for
+  // handing a row to something that takes what it wants from it straight away.
+  static SqlRow View(const QSqlQuery& query);
+
+  QVariant value(int i) const {
+    return query_ ? query_->value(i) : columns_[i];
+  }
+
+  QString toString(int i) const { return value(i).toString(); }
+  int toInt(int i) const { return value(i).toInt(); }
+  qint64 toLongLong(int i) const { return value(i).toLongLong(); }
+  bool toBool(int i) const { return value(i).toBool(); }
+  bool isNull(int i) const { return value(i).isNull(); }
 
  private:
   SqlRow();
 
   void Init(const QSqlQuery& query);
 
-  QList<QVariant> columns_;
+  const QSqlQuery* query_;
+  // A QList would allocate each QVariant separately.
+  QVector<QVariant> columns_;
 };
 
 typedef QList<SqlRow> SqlRowList;
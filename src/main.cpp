@@ -44,6 +44,7 @@
 #include <QSslSocket>
 #include <QSysInfo>
 #include <QTextCodec>
+#include <QTimer>
 #include <QTranslator>
 #include <QtConcurrentRun>
 #include <QtDebug>
@@ -53,6 +54,7 @@
 #include "core/commandlineoptions.h"
 #include "core/crashreporting.h"
 #include "core/database.h"
+#include "core/headlessplayer.h"
 #include "core/logging.h"
 #include "core/mac_startup.h"
 #include "core/metatypes.h"
@@ -60,6 +62,7 @@
 #include "core/networkproxyfactory.h"
 #include "core/potranslator.h"
 #include "core/song.h"
+#include "core/trace.h"
 #include "core/ubuntuunityhack.h"
 #include "core/utilities.h"
 #include "engines/enginebase.h"
@@ -101,6 +104,9 @@ Q_IMPORT_PLUGIN(QSQLiteDriverPlugin)
 
 namespace {
 
+// Messages a second each logging category gets before the rest are dropped.
+const int kLogRateLimit = 1000;
+
 void LoadTranslation(const QString& prefix, const QString& path,
                      const QString& language) {
   QTranslator* t = new PoTranslator;
@@ -225,6 +231,20 @@ void CheckPortable() {
   qLog(Info) << "Using default config locations.";
 }
 
+// Ends the startup trace once the main window has been painted.
+class FirstPaintTracer : public QObject {
+ public:
+  bool eventFilter(QObject* object, QEvent* event) override {
+    if (event->type() == QEvent::Paint) {
+      trace::Instant("First paint");
+      object->removeEventFilter(this);
+      // Let the rest of the window be painted first.
+      QTimer::singleShot(0, &trace::Finish);
+    }
+    return false;
+  }
+};
+
 }  // namespace
 
 #ifdef HAVE_GIO
@@ -283,6 +303,11 @@ int main(int argc, char* argv[]) {
   logging::Init();
   g_log_set_default_handler(reinterpret_cast<GLogFunc>(&logging::GLog),
                             nullptr);
+  // Logging from the GStreamer and scanning threads shouldn't have to wait
+  // for the terminal.  Chatty categories are limited so a flood of debug
+  // messages can't fill the queue for everyone else.
+  logging::StartAsyncWriter();
+  logging::SetRateLimit(kLogRateLimit);
 
   CommandlineOptions options(argc, argv);
 
@@ -299,6 +324,10 @@ int main(int argc, char* argv[]) {
     // full QApplication so it works without an X server
     if (!options.Parse()) return 1;
     logging::SetLevels(options.log_levels());
+    logging::SetMemoryLogSize(options.log_memory_mb() * 1024 * 1024);
+    if (!options.trace_startup_path().isEmpty()) {
+      trace::Start(options.trace_startup_path());
+    }
 
     if (a.isRunning()) {
       if (options.is_empty()) {
@@ -331,12 +360,23 @@ int main(int argc, char* argv[]) {
 
   IncreaseFDLimit();
 
+  // The playlists and library models still need a QApplication for their
+  // icons and pixmaps, but nothing is ever shown so it doesn't need a display.
+  if (options.headless()) {
+    Application::kIsHeadless = true;
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+  }
+
   QtSingleApplication a(argc, argv);
 
 #ifdef HAVE_LIBLASTFM
   lastfm::ws::ApiKey = LastFMService::kApiKey;
   lastfm::ws::SharedSecret = LastFMService::kSecret;
-  lastfm::setNetworkAccessManager(new NetworkAccessManager);
+  NetworkAccessManager* lastfm_network = new NetworkAccessManager;
+  lastfm_network->set_subsystem("liblastfm");
+  lastfm::setNetworkAccessManager(lastfm_network);
 #endif
 
   // A bug in Qt means the wheel_scroll_lines setting gets ignored and replaced
@@ -418,11 +458,15 @@ int main(int argc, char* argv[]) {
                                : override_language;
 
   // Translations
-  LoadTranslation("qt", QLibraryInfo::location(QLibraryInfo::TranslationsPath),
-                  language);
-  LoadTranslation("clementine", ":/translations", language);
-  LoadTranslation("clementine", a.applicationDirPath(), language);
-  LoadTranslation("clementine", QDir::currentPath(), language);
+  {
+    TRACE_SCOPE("LoadTranslations");
+    LoadTranslation("qt",
+                    QLibraryInfo::location(QLibraryInfo::TranslationsPath),
+                    language);
+    LoadTranslation("clementine", ":/translations", language);
+    LoadTranslation("clementine", a.applicationDirPath(), language);
+    LoadTranslation("clementine", QDir::currentPath(), language);
+  }
 
   // Icons
   IconLoader::Init();
@@ -448,6 +492,21 @@ int main(int argc, char* argv[]) {
   UbuntuUnityHack hack;
 #endif  // Q_OS_LINUX
 
+  if (options.headless()) {
+#ifdef HAVE_DBUS
+    mpris::Mpris mpris(&app);
+#endif
+    HeadlessPlayer player(&app, options);
+    QObject::connect(&a, SIGNAL(messageReceived(QString)), &player,
+                     SLOT(CommandlineOptionsReceived(QString)));
+    if (trace::IsEnabled()) {
+      QObject::connect(&a, &QCoreApplication::aboutToQuit, &trace::Finish);
+    }
+
+    QMetaObject::invokeMethod(&app, "Starting", Qt::QueuedConnection);
+    return a.exec();
+  }
+
   // Create the tray icon and OSD
   std::unique_ptr<SystemTrayIcon> tray_icon(
       SystemTrayIcon::CreateSystemTrayIcon());
@@ -471,6 +530,13 @@ int main(int argc, char* argv[]) {
   QObject::connect(&a, SIGNAL(messageReceived(QString)), &w,
                    SLOT(CommandlineOptionsReceived(QString)));
 
+  // If the window starts hidden in the tray, the trace ends when we quit.
+  FirstPaintTracer first_paint_tracer;
+  if (trace::IsEnabled()) {
+    w.installEventFilter(&first_paint_tracer);
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, &trace::Finish);
+  }
+
   // Use a queued connection so the invokation occurs after the application
   // loop starts.
   QMetaObject::invokeMethod(&app, "Starting", Qt::QueuedConnection);
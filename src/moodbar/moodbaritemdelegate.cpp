@@ -21,16 +21,19 @@
 #include <QPainter>
 #include <QSettings>
 #include <QSortFilterProxyModel>
-#include <QtConcurrentRun>
 
 #include "core/application.h"
 #include "core/closure.h"
+#include "core/executor.h"
+#include "core/memorybudget.h"
 #include "moodbarloader.h"
 #include "moodbarpipeline.h"
 #include "moodbarrenderer.h"
 #include "playlist/playlist.h"
 #include "playlist/playlistview.h"
 
+const int MoodbarItemDelegate::kPixmapCacheBytes = 8 * 1024 * 1024;  // 8MB
+
 MoodbarItemDelegate::Data::Data() : state_(State_None) {}
 
 MoodbarItemDelegate::MoodbarItemDelegate(Application* app, PlaylistView* view,
@@ -38,9 +41,19 @@ MoodbarItemDelegate::MoodbarItemDelegate(Application* app, PlaylistView* view,
     : QItemDelegate(parent),
       app_(app),
       view_(view),
+      pixmaps_(kPixmapCacheBytes),
       style_(MoodbarRenderer::Style_Normal) {
   connect(app_, SIGNAL(SettingsChanged()), SLOT(ReloadSettings()));
   ReloadSettings();
+
+  budget_id_ = app_->memory_budget()->Register(
+      "Moodbar pixmaps", kPixmapCacheBytes,
+      [this]() { return pixmaps_.totalCost(); },
+      [this](qint64 bytes) { pixmaps_.setMaxCost(bytes); });
+}
+
+MoodbarItemDelegate::~MoodbarItemDelegate() {
+  app_->memory_budget()->Unregister(budget_id_);
 }
 
 void MoodbarItemDelegate::ReloadSettings() {
@@ -95,13 +108,23 @@ QPixmap MoodbarItemDelegate::PixmapForIndex(const QModelIndex& index,
 
     case Data::State_Loaded:
       // Is the pixmap the right size?
-      if (data->pixmap_.size() != size) {
-        StartLoadingImage(url, data);
+      if (data->pixmap_.size() != size && !FindCachedPixmap(url, data)) {
+        if (data->colors_.isEmpty()) {
+          // The pixmap came from the cache, so there's nothing to render a
+          // new one from yet.
+          StartLoadingData(url, data);
+        } else {
+          StartLoadingImage(url, data);
+        }
       }
 
       return data->pixmap_;
 
     case Data::State_None:
+      if (FindCachedPixmap(url, data)) {
+        data->state_ = Data::State_Loaded;
+        return data->pixmap_;
+      }
       break;
   }
 
@@ -111,6 +134,25 @@ QPixmap MoodbarItemDelegate::PixmapForIndex(const QModelIndex& index,
   return QPixmap();
 }
 
+QString MoodbarItemDelegate::PixmapCacheKey(const QUrl& url,
+                                            const QSize& size) const {
+  return QString("%1 %2x%3 %4 %5")
+      .arg(QString::fromUtf8(url.toEncoded()))
+      .arg(size.width())
+      .arg(size.height())
+      .arg(style_)
+      .arg(qApp->palette().cacheKey());
+}
+
+bool MoodbarItemDelegate::FindCachedPixmap(const QUrl& url, Data* data) {
+  const QPixmap* pixmap =
+      pixmaps_.object(PixmapCacheKey(url, data->desired_size_));
+  if (!pixmap) return false;
+
+  data->pixmap_ = *pixmap;
+  return true;
+}
+
 void MoodbarItemDelegate::StartLoadingData(const QUrl& url, Data* data) {
   data->state_ = Data::State_LoadingData;
 
@@ -151,7 +193,12 @@ void MoodbarItemDelegate::ReloadAllColors() {
   for (const QUrl& url : data_.keys()) {
     Data* data = data_[url];
 
-    if (data->state_ == Data::State_Loaded) {
+    if (data->state_ != Data::State_Loaded) continue;
+
+    if (FindCachedPixmap(url, data)) {
+      // It's been drawn in this style before, but the colors are stale now.
+      data->colors_.clear();
+    } else {
       StartLoadingData(url, data);
     }
   }
@@ -182,8 +229,12 @@ void MoodbarItemDelegate::StartLoadingColors(const QUrl& url,
                                              Data* data) {
   data->state_ = Data::State_LoadingColors;
 
-  QFuture<ColorVector> future = QtConcurrent::run(
-      MoodbarRenderer::Colors, bytes, style_, qApp->palette());
+  const MoodbarRenderer::MoodbarStyle style = style_;
+  const QPalette palette = qApp->palette();
+  QFuture<ColorVector> future =
+      Executor::Cpu()->Run<ColorVector>([bytes, style, palette]() {
+        return MoodbarRenderer::Colors(bytes, style, palette);
+      });
   NewClosure(future, this, SLOT(ColorsLoaded(QUrl, QFuture<ColorVector>)), url,
              future);
 }
@@ -208,8 +259,11 @@ void MoodbarItemDelegate::ColorsLoaded(const QUrl& url,
 void MoodbarItemDelegate::StartLoadingImage(const QUrl& url, Data* data) {
   data->state_ = Data::State_LoadingImage;
 
-  QFuture<QImage> future = QtConcurrent::run(
-      MoodbarRenderer::RenderToImage, data->colors_, data->desired_size_);
+  const ColorVector colors = data->colors_;
+  const QSize size = data->desired_size_;
+  QFuture<QImage> future = Executor::Cpu()->Run<QImage>([colors, size]() {
+    return MoodbarRenderer::RenderToImage(colors, size);
+  });
   NewClosure(future, this, SLOT(ImageLoaded(QUrl, QFuture<QImage>)), url,
              future);
 }
@@ -236,6 +290,12 @@ void MoodbarItemDelegate::ImageLoaded(const QUrl& url, QFuture<QImage> future) {
   data->pixmap_ = QPixmap::fromImage(image);
   data->state_ = Data::State_Loaded;
 
+  if (!image.isNull()) {
+    pixmaps_.insert(PixmapCacheKey(url, image.size()),
+                    new QPixmap(data->pixmap_),
+                    image.width() * image.height() * image.depth() / 8);
+  }
+
   Playlist* playlist = view_->playlist();
   const QSortFilterProxyModel* filter = playlist->proxy();
 
@@ -37,6 +37,10 @@ class MoodbarItemDelegate : public QItemDelegate {
  public:
   MoodbarItemDelegate(Application* app, PlaylistView* view,
                       QObject* parent = nullptr);
+  ~MoodbarItemDelegate();
+
+  // How much memory the rendered pixmaps can use.
+  static const int kPixmapCacheBytes;
 
   void paint(QPainter* painter, const QStyleOptionViewItem& option,
              const QModelIndex& index) const;
@@ -77,6 +81,9 @@ class MoodbarItemDelegate : public QItemDelegate {
 
   bool RemoveFromCacheIfIndexesInvalid(const QUrl& url, Data* data);
 
+  QString PixmapCacheKey(const QUrl& url, const QSize& size) const;
+  bool FindCachedPixmap(const QUrl& url, Data* data);
+
   void ReloadAllColors();
 
  private:
@@ -84,6 +91,12 @@ class MoodbarItemDelegate : public QItemDelegate {
   PlaylistView* view_;
   QCache<QUrl, Data> data_;
 
+  // Rendered moodbars for every size and style they've been drawn at, so
+  // they don't have to be loaded and rendered again when a song scrolls
+  // back into view or a column goes back to its old width.
+  QCache<QString, QPixmap> pixmaps_;
+  int budget_id_;
+
   MoodbarRenderer::MoodbarStyle style_;
 };
 
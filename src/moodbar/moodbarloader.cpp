@@ -28,9 +28,12 @@
 
 #include "core/application.h"
 #include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/utilities.h"
 #include "moodbarpipeline.h"
+#include "moodbarstore.h"
+#include "smartplaylists/similarityindex.h"
 
 #ifdef Q_OS_WIN32
 #include <windows.h>
@@ -38,11 +41,16 @@
 
 MoodbarLoader::MoodbarLoader(Application* app, QObject* parent)
     : QObject(parent),
+      app_(app),
+      store_(new MoodbarStore(
+          Utilities::GetConfigPath(Utilities::Path_MoodbarCache) +
+          "/moodbars.store")),
       cache_(new QNetworkDiskCache(this)),
       thread_(new QThread(this)),
       kMaxActiveRequests(qMax(1, QThread::idealThreadCount() / 2)),
       save_alongside_originals_(false),
-      disable_moodbar_calculation_(false) {
+      disable_moodbar_calculation_(false),
+      low_rate_analysis_(false) {
   cache_->setCacheDirectory(
       Utilities::GetConfigPath(Utilities::Path_MoodbarCache));
   cache_->setMaximumCacheSize(60 * 1024 *
@@ -64,6 +72,7 @@ void MoodbarLoader::ReloadSettings() {
       s.value("save_alongside_originals", false).toBool();
 
   disable_moodbar_calculation_ = !s.value("calculate", true).toBool();
+  low_rate_analysis_ = s.value("low_rate_analysis", false).toBool();
   MaybeTakeNextRequest();
 }
 
@@ -80,6 +89,10 @@ QStringList MoodbarLoader::MoodFilenames(const QString& song_filename) {
                        << dir_path + "/" + mood_filename;
 }
 
+uint MoodbarLoader::FileMtime(const QUrl& url) {
+  return QFileInfo(url.toLocalFile()).lastModified().toTime_t();
+}
+
 MoodbarLoader::Result MoodbarLoader::Load(const QUrl& url, QByteArray* data,
                                           MoodbarPipeline** async_pipeline) {
   if (url.scheme() != "file") {
@@ -88,6 +101,12 @@ MoodbarLoader::Result MoodbarLoader::Load(const QUrl& url, QByteArray* data,
 
   // Are we in the middle of loading this moodbar already?
   if (requests_.contains(url)) {
+    // Someone's waiting for it now, so it can't wait behind the library.
+    if (queued_background_requests_.removeOne(url)) {
+      requests_[url]->set_low_priority(false);
+      queued_requests_ << url;
+      MaybeTakeNextRequest();
+    }
     *async_pipeline = requests_[url];
     return WillLoadAsync;
   }
@@ -104,42 +123,113 @@ MoodbarLoader::Result MoodbarLoader::Load(const QUrl& url, QByteArray* data,
     }
   }
 
-  // Maybe it exists in the cache?
+  // Maybe it exists in the store?
+  const uint mtime = FileMtime(url);
+  if (store_->Get(url, mtime, data)) {
+    qLog(Info) << "Loading stored moodbar data for" << filename;
+    return Loaded;
+  }
+
+  // Or in the old cache?
   std::unique_ptr<QIODevice> cache_device(cache_->data(url));
   if (cache_device) {
     qLog(Info) << "Loading cached moodbar data for" << filename;
     *data = cache_device->readAll();
+    cache_device.reset();
+
     if (!data->isEmpty()) {
+      store_->Put(url, mtime, *data);
+      cache_->remove(url);
       return Loaded;
     }
   }
 
+  // There was no existing file, analyze the audio file and create one.
+  MoodbarPipeline* pipeline = CreatePipeline(url);
+  queued_requests_ << url;
+
+  MaybeTakeNextRequest();
+
+  *async_pipeline = pipeline;
+  return WillLoadAsync;
+}
+
+MoodbarPipeline* MoodbarLoader::Precompute(const QUrl& url) {
+  if (url.scheme() != "file" || disable_moodbar_calculation_) {
+    return nullptr;
+  }
+
+  if (requests_.contains(url)) return requests_[url];
+
+  for (const QString& possible_mood_file : MoodFilenames(url.toLocalFile())) {
+    if (QFile::exists(possible_mood_file)) return nullptr;
+  }
+  if (store_->Contains(url, FileMtime(url)) ||
+      cache_->metaData(url).isValid()) {
+    return nullptr;
+  }
+
+  MoodbarPipeline* pipeline = CreatePipeline(url);
+  pipeline->set_low_priority(true);
+  queued_background_requests_ << url;
+
+  MaybeTakeNextRequest();
+  return pipeline;
+}
+
+void MoodbarLoader::UpdateFeatures(const QUrl& url) {
+  QByteArray data;
+  for (const QString& possible_mood_file : MoodFilenames(url.toLocalFile())) {
+    QFile f(possible_mood_file);
+    if (f.open(QIODevice::ReadOnly)) {
+      data = f.readAll();
+      break;
+    }
+  }
+  if (data.isEmpty() && !store_->Get(url, FileMtime(url), &data)) return;
+
+  SaveFeatures(url, data);
+}
+
+void MoodbarLoader::SaveFeatures(const QUrl& url, const QByteArray& data) {
+  SimilarityIndex::Features features;
+  if (!SimilarityIndex::FromMoodbar(data, &features)) return;
+
+  Database* db = app_->database();
+  Executor::Db()->Run<void>(
+      [db, url, features]() { SimilarityIndex::Save(db, url, features); });
+}
+
+MoodbarPipeline* MoodbarLoader::CreatePipeline(const QUrl& url) {
   if (!thread_->isRunning()) thread_->start(QThread::IdlePriority);
 
-  // There was no existing file, analyze the audio file and create one.
   MoodbarPipeline* pipeline = new MoodbarPipeline(url);
+  pipeline->set_low_rate(low_rate_analysis_);
   pipeline->moveToThread(thread_);
   NewClosure(pipeline, SIGNAL(Finished(bool)), this,
              SLOT(RequestFinished(MoodbarPipeline*, QUrl)), pipeline, url);
 
   requests_[url] = pipeline;
-  queued_requests_ << url;
-
-  MaybeTakeNextRequest();
-
-  *async_pipeline = pipeline;
-  return WillLoadAsync;
+  return pipeline;
 }
 
 void MoodbarLoader::MaybeTakeNextRequest() {
   Q_ASSERT(QThread::currentThread() == qApp->thread());
 
-  if (active_requests_.count() >= kMaxActiveRequests ||
-      queued_requests_.isEmpty() || disable_moodbar_calculation_) {
+  if (disable_moodbar_calculation_) return;
+
+  QUrl url;
+  if (active_requests_.count() - active_background_requests_.count() <
+          kMaxActiveRequests &&
+      !queued_requests_.isEmpty()) {
+    url = queued_requests_.takeFirst();
+  } else if (active_requests_.count() < kMaxActiveRequests &&
+             !queued_background_requests_.isEmpty()) {
+    url = queued_background_requests_.takeFirst();
+    active_background_requests_ << url;
+  } else {
     return;
   }
-
-  const QUrl url = queued_requests_.takeFirst();
   active_requests_ << url;
 
   qLog(Info) << "Creating moodbar data for" << url.toLocalFile();
@@ -153,15 +243,9 @@ void MoodbarLoader::RequestFinished(MoodbarPipeline* request, const QUrl& url) {
     qLog(Info) << "Moodbar data generated successfully for"
                << url.toLocalFile();
 
-    // Save the data in the cache
-    QNetworkCacheMetaData metadata;
-    metadata.setUrl(url);
-
-    QIODevice* cache_file = cache_->prepare(metadata);
-    if (cache_file) {
-      cache_file->write(request->data());
-      cache_->insert(cache_file);
-    }
+    // Save the data in the store
+    store_->Put(url, FileMtime(url), request->data());
+    SaveFeatures(url, request->data());
 
     // Save the data alongside the original as well if we're configured to.
     if (save_alongside_originals_) {
@@ -187,6 +271,7 @@ void MoodbarLoader::RequestFinished(MoodbarPipeline* request, const QUrl& url) {
   // Remove the request from the active list and delete it
   requests_.remove(url);
   active_requests_.remove(url);
+  active_background_requests_.remove(url);
 
   QTimer::singleShot(1000, request, SLOT(deleteLater()));
 
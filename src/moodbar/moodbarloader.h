@@ -21,12 +21,14 @@
 #include <QMap>
 #include <QObject>
 #include <QSet>
+#include <memory>
 
 class QNetworkDiskCache;
 class QUrl;
 
 class Application;
 class MoodbarPipeline;
+class MoodbarStore;
 
 class MoodbarLoader : public QObject {
   Q_OBJECT
@@ -51,6 +53,15 @@ class MoodbarLoader : public QObject {
   Result Load(const QUrl& url, QByteArray* data,
               MoodbarPipeline** async_pipeline);
 
+  // Queues moodbar data to be made for url at a low priority, behind anything
+  // Load asked for.  Returns the pipeline that will make it, or nullptr if
+  // url already has moodbar data or can never have any.
+  MoodbarPipeline* Precompute(const QUrl& url);
+
+  // Works out the SimilarityIndex features of the moodbar url already has,
+  // for songs whose moodbars were made before features were kept.
+  void UpdateFeatures(const QUrl& url);
+
  private slots:
   void ReloadSettings();
 
@@ -59,8 +70,16 @@ class MoodbarLoader : public QObject {
 
  private:
   static QStringList MoodFilenames(const QString& song_filename);
+  static uint FileMtime(const QUrl& url);
+
+  MoodbarPipeline* CreatePipeline(const QUrl& url);
+  void SaveFeatures(const QUrl& url, const QByteArray& data);
 
  private:
+  Application* app_;
+  std::unique_ptr<MoodbarStore> store_;
+  // Where moodbar data used to be kept.  It's moved into the store as it's
+  // read.
   QNetworkDiskCache* cache_;
   QThread* thread_;
 
@@ -70,8 +89,14 @@ class MoodbarLoader : public QObject {
   QList<QUrl> queued_requests_;
   QSet<QUrl> active_requests_;
 
+  // Requests from Precompute only run while there are spare slots, and never
+  // hold up the ones from Load.
+  QList<QUrl> queued_background_requests_;
+  QSet<QUrl> active_background_requests_;
+
   bool save_alongside_originals_;
   bool disable_moodbar_calculation_;
+  bool low_rate_analysis_;
 };
 
 #endif  // MOODBARLOADER_H
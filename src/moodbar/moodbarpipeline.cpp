@@ -30,12 +30,15 @@
 
 bool MoodbarPipeline::sIsAvailable = false;
 const int MoodbarPipeline::kBands = 128;
+const int MoodbarPipeline::kLowRateHz = 11025;
 
 MoodbarPipeline::MoodbarPipeline(const QUrl& local_filename)
     : QObject(nullptr),
       local_filename_(local_filename),
       pipeline_(nullptr),
       convert_element_(nullptr),
+      low_priority_(false),
+      low_rate_(false),
       success_(false),
       running_(false) {}
 
@@ -91,8 +94,29 @@ void MoodbarPipeline::Start() {
   }
 
   // Join them together
-  if (!gst_element_link(convert_element_, spectrum) ||
-      !gst_element_link(spectrum, fakesink)) {
+  bool linked = false;
+  if (low_rate_) {
+    GstElement* resample = CreateElement("audioresample");
+    if (!resample) {
+      pipeline_ = nullptr;
+      emit Finished(false);
+      return;
+    }
+
+    // The moodbar is far too coarse for resampling artifacts to show.
+    g_object_set(resample, "quality", 0, nullptr);
+
+    GstCaps* caps =
+        gst_caps_new_simple("audio/x-raw", "rate", G_TYPE_INT, kLowRateHz,
+                            "channels", G_TYPE_INT, 1, nullptr);
+    linked = gst_element_link(convert_element_, resample) &&
+             gst_element_link_filtered(resample, spectrum, caps);
+    gst_caps_unref(caps);
+  } else {
+    linked = gst_element_link(convert_element_, spectrum);
+  }
+
+  if (!linked || !gst_element_link(spectrum, fakesink)) {
     qLog(Error) << "Failed to link elements";
     pipeline_ = nullptr;
     emit Finished(false);
@@ -160,6 +184,9 @@ void MoodbarPipeline::NewPadCallback(GstElement*, GstPad* pad, gpointer data) {
   gst_structure_get_int(structure, "rate", &rate);
   gst_caps_unref(caps);
 
+  // The spectrum sees the resampled audio, not what's decoded.
+  if (self->low_rate_) rate = kLowRateHz;
+
   if (self->builder_ != nullptr)
     self->builder_->Init(kBands, rate);
   else
@@ -180,12 +207,34 @@ GstBusSyncReply MoodbarPipeline::BusCallbackSync(GstBus*, GstMessage* msg,
       self->Stop(false);
       break;
 
+    case GST_MESSAGE_STREAM_STATUS:
+      if (self->low_priority_) {
+        GstStreamStatusType type;
+        GstElement* owner;
+        gst_message_parse_stream_status(msg, &type, &owner);
+
+        const GValue* val = gst_message_get_stream_status_object(msg);
+        if (type == GST_STREAM_STATUS_TYPE_CREATE &&
+            G_VALUE_TYPE(val) == GST_TYPE_TASK) {
+          GstTask* task = static_cast<GstTask*>(g_value_get_object(val));
+          gst_task_set_enter_callback(task, &LowPriorityTaskEnterCallback,
+                                      nullptr, nullptr);
+        }
+      }
+      break;
+
     default:
       break;
   }
   return GST_BUS_PASS;
 }
 
+void MoodbarPipeline::LowPriorityTaskEnterCallback(GstTask*, GThread*,
+                                                   gpointer) {
+  Utilities::SetThreadIOPriority(Utilities::IOPRIO_CLASS_IDLE);
+  Utilities::SetThreadNiceness(19);
+}
+
 void MoodbarPipeline::Stop(bool success) {
   success_ = success;
   running_ = false;
@@ -37,6 +37,16 @@ class MoodbarPipeline : public QObject {
 
   static bool IsAvailable();
 
+  // Low priority pipelines run their streaming threads niced and with idle
+  // IO priority.  Call before Start.
+  void set_low_priority(bool low_priority) { low_priority_ = low_priority; }
+
+  // Low rate pipelines mix the audio down and resample it to kLowRateHz
+  // before the spectrum is taken, which means a fraction of the FFTs.  The
+  // top of the bark scale is lost, so the blue part of the moodbar only
+  // comes from the upper mid range.  Call before Start.
+  void set_low_rate(bool low_rate) { low_rate_ = low_rate; }
+
   bool success() const { return success_; }
   const QByteArray& data() const { return data_; }
 
@@ -58,10 +68,12 @@ class MoodbarPipeline : public QObject {
   static gboolean BusCallback(GstBus*, GstMessage* msg, gpointer data);
   static GstBusSyncReply BusCallbackSync(GstBus*, GstMessage* msg,
                                          gpointer data);
+  static void LowPriorityTaskEnterCallback(GstTask*, GThread*, gpointer);
 
  private:
   static bool sIsAvailable;
   static const int kBands;
+  static const int kLowRateHz;
 
   QUrl local_filename_;
   GstElement* pipeline_;
@@ -69,6 +81,8 @@ class MoodbarPipeline : public QObject {
 
   std::unique_ptr<MoodbarBuilder> builder_;
 
+  bool low_priority_;
+  bool low_rate_;
   bool success_;
   bool running_;
   QByteArray data_;
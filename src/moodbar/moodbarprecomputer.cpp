@@ -0,0 +1,204 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "moodbarprecomputer.h"
+
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+#include <QTimerEvent>
+
+#include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
+#include "core/logging.h"
+#include "core/player.h"
+#include "core/taskmanager.h"
+#include "library/librarybackend.h"
+#include "moodbarloader.h"
+#include "moodbarpipeline.h"
+#include "smartplaylists/similarityindex.h"
+
+const char* MoodbarPrecomputer::kSettingsGroup = "Moodbar";
+const int MoodbarPrecomputer::kIdleMsec = 5 * 60 * 1000;  // 5 minutes
+const int MoodbarPrecomputer::kMaxChecksPerBatch = 50;
+
+MoodbarPrecomputer::MoodbarPrecomputer(Application* app, QObject* parent)
+    : QObject(parent),
+      app_(app),
+      enabled_(false),
+      max_jobs_(1),
+      running_(false),
+      loading_(false),
+      start_more_pending_(false),
+      active_(0),
+      done_(0),
+      total_(0),
+      task_id_(-1) {
+  connect(app_, SIGNAL(SettingsChanged()), SLOT(ReloadSettings()));
+  connect(app_->player(), SIGNAL(Playing()), SLOT(PlaybackStarted()));
+  connect(app_->player(), SIGNAL(Paused()), SLOT(PlaybackIdle()));
+  connect(app_->player(), SIGNAL(Stopped()), SLOT(PlaybackIdle()));
+  ReloadSettings();
+}
+
+void MoodbarPrecomputer::ReloadSettings() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  enabled_ = s.value("precompute", false).toBool() &&
+             s.value("calculate", true).toBool();
+  max_jobs_ = qMax(1, s.value("precompute_jobs", 1).toInt());
+
+  if (!enabled_) {
+    idle_timer_.stop();
+  } else if (!running_ && app_->player()->GetState() != Engine::Playing) {
+    idle_timer_.start(kIdleMsec, this);
+  }
+}
+
+void MoodbarPrecomputer::PlaybackStarted() {
+  idle_timer_.stop();
+  Pause();
+}
+
+void MoodbarPrecomputer::PlaybackIdle() {
+  if (enabled_ && !running_) idle_timer_.start(kIdleMsec, this);
+}
+
+void MoodbarPrecomputer::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != idle_timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  idle_timer_.stop();
+  if (enabled_) Start();
+}
+
+void MoodbarPrecomputer::Start() {
+  if (running_) return;
+  running_ = true;
+
+  task_id_ = app_->task_manager()->StartTask(tr("Calculating moodbars"));
+
+  if (!queue_.isEmpty()) {
+    // Carrying on from where we were paused.
+    app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+    StartMore();
+    return;
+  }
+
+  if (loading_) return;
+  loading_ = true;
+
+  LibraryBackend* backend = app_->library_backend();
+  QFuture<SongList> future = Executor::Db()->Run<SongList>(
+      [backend]() { return backend->GetAllSongs(); });
+  NewClosure(future, this, SLOT(SongsLoaded(QFuture<SongList>)), future);
+}
+
+void MoodbarPrecomputer::SongsLoaded(QFuture<SongList> future) {
+  QSet<QUrl> seen;
+  for (const Song& song : future.result()) {
+    const QUrl& url = song.url();
+    if (song.is_unavailable() || url.scheme() != "file") continue;
+    if (seen.contains(url)) continue;
+
+    seen << url;
+    queue_ << url;
+  }
+
+  Database* db = app_->database();
+  QFuture<QSet<QByteArray>> features = Executor::Db()->Run<QSet<QByteArray>>(
+      [db]() { return SimilarityIndex::LoadFilenames(db); });
+  NewClosure(features, this,
+             SLOT(FeaturesLoaded(QFuture<QSet<QByteArray>>)), features);
+}
+
+void MoodbarPrecomputer::FeaturesLoaded(QFuture<QSet<QByteArray>> future) {
+  loading_ = false;
+
+  const QSet<QByteArray> filenames = future.result();
+  missing_features_.clear();
+  for (const QUrl& url : queue_) {
+    if (!filenames.contains(url.toEncoded())) missing_features_ << url;
+  }
+
+  done_ = 0;
+  total_ = queue_.count();
+  qLog(Info) << "Checking" << total_ << "songs for moodbar data";
+
+  if (!running_) return;
+  app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+  StartMore();
+}
+
+void MoodbarPrecomputer::StartMore() {
+  start_more_pending_ = false;
+  if (!running_) return;
+
+  // Most songs will already have moodbars, and checking means touching the
+  // disk, so don't hold up the event loop for too long at a time.
+  int checks = 0;
+  while (active_ < max_jobs_ && !queue_.isEmpty()) {
+    if (checks++ >= kMaxChecksPerBatch) {
+      start_more_pending_ = true;
+      QTimer::singleShot(0, this, SLOT(StartMore()));
+      break;
+    }
+
+    const QUrl url = queue_.takeFirst();
+    MoodbarPipeline* pipeline = app_->moodbar_loader()->Precompute(url);
+    if (!pipeline) {
+      if (missing_features_.remove(url)) {
+        app_->moodbar_loader()->UpdateFeatures(url);
+      }
+      ++done_;
+      continue;
+    }
+    missing_features_.remove(url);
+
+    ++active_;
+    NewClosure(pipeline, SIGNAL(Finished(bool)), this,
+               SLOT(RequestFinished()));
+  }
+
+  app_->task_manager()->SetTaskProgress(task_id_, done_, total_);
+  if (queue_.isEmpty() && active_ == 0) Finish();
+}
+
+void MoodbarPrecomputer::RequestFinished() {
+  --active_;
+  ++done_;
+
+  if (running_ && !start_more_pending_) StartMore();
+}
+
+void MoodbarPrecomputer::Pause() {
+  if (!running_) return;
+
+  // Whatever's already been handed to the loader is left to finish.
+  running_ = false;
+  app_->task_manager()->SetTaskFinished(task_id_);
+  task_id_ = -1;
+}
+
+void MoodbarPrecomputer::Finish() {
+  qLog(Info) << "Finished calculating moodbars for the library";
+  Pause();
+  done_ = total_ = 0;
+}
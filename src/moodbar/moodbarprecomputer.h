@@ -0,0 +1,91 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOODBARPRECOMPUTER_H
+#define MOODBARPRECOMPUTER_H
+
+#include <QBasicTimer>
+#include <QFuture>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QUrl>
+
+#include "core/song.h"
+
+class Application;
+
+// Works through the library making moodbar data for every song that doesn't
+// have any yet, so it's there before the song is first played.
+//
+// Runs on its own once nothing has been playing for a while, if it's enabled,
+// and steps aside as soon as something starts playing again.  The songs are
+// passed to the MoodbarLoader at a low priority, so anything that needs a
+// moodbar now still gets it first.
+class MoodbarPrecomputer : public QObject {
+  Q_OBJECT
+
+ public:
+  MoodbarPrecomputer(Application* app, QObject* parent = nullptr);
+
+  static const char* kSettingsGroup;
+  static const int kIdleMsec;
+  static const int kMaxChecksPerBatch;
+
+ public slots:
+  // Starts going through the library straight away, or carries on where it
+  // left off.
+  void Start();
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private slots:
+  void ReloadSettings();
+  void PlaybackStarted();
+  void PlaybackIdle();
+
+  void SongsLoaded(QFuture<SongList> future);
+  void FeaturesLoaded(QFuture<QSet<QByteArray>> future);
+  void StartMore();
+  void RequestFinished();
+
+ private:
+  void Pause();
+  void Finish();
+
+  Application* app_;
+
+  bool enabled_;
+  int max_jobs_;
+
+  QBasicTimer idle_timer_;
+  bool running_;
+  bool loading_;
+  bool start_more_pending_;
+
+  QList<QUrl> queue_;
+  // Songs in the queue that already have moodbars might still need their
+  // features working out.
+  QSet<QUrl> missing_features_;
+  int active_;
+  int done_;
+  int total_;
+  int task_id_;
+};
+
+#endif  // MOODBARPRECOMPUTER_H
@@ -28,6 +28,8 @@
 #include <QTimeLine>
 
 #include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 
 const int MoodbarProxyStyle::kMarginSize = 3;
@@ -43,7 +45,6 @@ MoodbarProxyStyle::MoodbarProxyStyle(Application* app, QSlider* slider)
       moodbar_style_(MoodbarRenderer::Style_Normal),
       state_(MoodbarOff),
       fade_timeline_(new QTimeLine(1000, this)),
-      moodbar_colors_dirty_(true),
       moodbar_pixmap_dirty_(true),
       context_menu_(nullptr),
       show_moodbar_action_(nullptr),
@@ -74,17 +75,43 @@ void MoodbarProxyStyle::ReloadSettings() {
 
   if (new_style != moodbar_style_) {
     moodbar_style_ = new_style;
-    moodbar_colors_dirty_ = true;
-    slider_->update();
+    StartLoadingColors();
   }
 }
 
 void MoodbarProxyStyle::SetMoodbarData(const QByteArray& data) {
   data_ = data;
-  moodbar_colors_dirty_ = true;  // Redraw next time
+  StartLoadingColors();
   NextState();
 }
 
+void MoodbarProxyStyle::StartLoadingColors() {
+  if (data_.isEmpty()) {
+    colors_future_ = QFuture<ColorVector>();
+    return;
+  }
+
+  const QByteArray data = data_;
+  const MoodbarRenderer::MoodbarStyle style = moodbar_style_;
+  const QPalette palette = slider_->palette();
+  colors_future_ = Executor::Cpu()->Run<ColorVector>([data, style, palette]() {
+    return MoodbarRenderer::Colors(data, style, palette);
+  });
+  NewClosure(colors_future_, this, SLOT(ColorsLoaded(QFuture<ColorVector>)),
+             colors_future_);
+}
+
+void MoodbarProxyStyle::ColorsLoaded(QFuture<ColorVector> future) {
+  if (future != colors_future_) return;
+
+  moodbar_colors_ = future.result();
+  moodbar_pixmap_dirty_ = true;
+
+  // A fade that started before the colors were ready needs them too.
+  if (state_ == FadingToOn) fade_target_ = QPixmap();
+  slider_->update();
+}
+
 void MoodbarProxyStyle::SetMoodbarEnabled(bool enabled) {
   enabled_ = enabled;
 
@@ -234,13 +261,6 @@ void MoodbarProxyStyle::Render(ComplexControl control,
 }
 
 void MoodbarProxyStyle::EnsureMoodbarRendered(const QStyleOptionSlider* opt) {
-  if (moodbar_colors_dirty_) {
-    moodbar_colors_ =
-        MoodbarRenderer::Colors(data_, moodbar_style_, slider_->palette());
-    moodbar_colors_dirty_ = false;
-    moodbar_pixmap_dirty_ = true;
-  }
-
   if (moodbar_pixmap_dirty_) {
     moodbar_pixmap_ = MoodbarPixmap(moodbar_colors_, slider_->size(),
                                     slider_->palette(), opt);
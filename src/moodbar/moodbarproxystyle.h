@@ -18,6 +18,7 @@
 #ifndef MOODBARPROXYSTYLE_H
 #define MOODBARPROXYSTYLE_H
 
+#include <QFuture>
 #include <QProxyStyle>
 
 #include "moodbarrenderer.h"
@@ -63,6 +64,7 @@ class MoodbarProxyStyle : public QProxyStyle {
 
  private:
   void NextState();
+  void StartLoadingColors();
 
   void Render(ComplexControl control, const QStyleOptionSlider* option,
               QPainter* painter, const QWidget* widget);
@@ -76,6 +78,7 @@ class MoodbarProxyStyle : public QProxyStyle {
  private slots:
   void ReloadSettings();
   void FaderValueChanged(qreal value);
+  void ColorsLoaded(QFuture<ColorVector> future);
   void ChangeStyle(QAction* action);
 
  private:
@@ -92,7 +95,8 @@ class MoodbarProxyStyle : public QProxyStyle {
   QPixmap fade_source_;
   QPixmap fade_target_;
 
-  bool moodbar_colors_dirty_;
+  // Only the colors from the latest data and style are used.
+  QFuture<ColorVector> colors_future_;
   bool moodbar_pixmap_dirty_;
   ColorVector moodbar_colors_;
   QPixmap moodbar_pixmap_;
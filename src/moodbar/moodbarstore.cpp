@@ -0,0 +1,313 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "moodbarstore.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+
+#include "core/logging.h"
+
+const qint64 MoodbarStore::kMinCompactBytes = 1024 * 1024;  // 1MB
+const quint32 MoodbarStore::kMagic = 0x434c4d53;            // "CLMS"
+const quint32 MoodbarStore::kRecordMagic = 0x4d4f4f44;      // "MOOD"
+const quint32 MoodbarStore::kVersion = 1;
+
+MoodbarStore::MoodbarStore(const QString& filename)
+    : file_(filename),
+      index_filename_(filename + ".index"),
+      data_(nullptr),
+      mapped_size_(0),
+      end_(0),
+      indexed_end_(0),
+      wasted_bytes_(0),
+      index_dirty_(false) {
+  if (!Open()) {
+    qLog(Warning) << "Couldn't open moodbar store" << filename;
+    return;
+  }
+
+  if (wasted_bytes_ > kMinCompactBytes && wasted_bytes_ * 2 > end_) {
+    Compact();
+  }
+}
+
+MoodbarStore::~MoodbarStore() {
+  if (index_dirty_ && file_.isOpen()) SaveIndex();
+  if (data_) file_.unmap(data_);
+}
+
+bool MoodbarStore::Open() {
+  QDir().mkpath(QFileInfo(file_.fileName()).path());
+  if (!file_.open(QIODevice::ReadWrite)) return false;
+
+  Header header;
+  if (file_.read(reinterpret_cast<char*>(&header), sizeof(header)) ==
+          sizeof(header) &&
+      header.magic == kMagic && header.version == kVersion) {
+    end_ = indexed_end_ = sizeof(Header);
+    LoadIndex();
+    ReadRecords(end_);
+  } else {
+    // The file is new or from an older version - start again.
+    Reset();
+  }
+
+  return Map();
+}
+
+void MoodbarStore::Reset() {
+  if (data_) {
+    file_.unmap(data_);
+    data_ = nullptr;
+    mapped_size_ = 0;
+  }
+
+  entries_.clear();
+  wasted_bytes_ = 0;
+  QFile::remove(index_filename_);
+
+  const Header header = {kMagic, kVersion};
+  file_.resize(0);
+  file_.seek(0);
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file_.flush();
+
+  end_ = indexed_end_ = sizeof(Header);
+  index_dirty_ = true;
+}
+
+bool MoodbarStore::Map() {
+  if (data_) {
+    file_.unmap(data_);
+    data_ = nullptr;
+    mapped_size_ = 0;
+  }
+
+  data_ = file_.map(0, end_);
+  if (!data_) return false;
+
+  mapped_size_ = end_;
+  return true;
+}
+
+void MoodbarStore::LoadIndex() {
+  QFile file(index_filename_);
+  if (!file.open(QIODevice::ReadOnly)) return;
+
+  QDataStream s(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint64 indexed_end = 0;
+  qint64 wasted_bytes = 0;
+  qint32 count = 0;
+  s >> magic >> version >> indexed_end >> wasted_bytes >> count;
+
+  if (s.status() != QDataStream::Ok || magic != kMagic ||
+      version != kVersion || indexed_end < qint64(sizeof(Header)) ||
+      indexed_end > file_.size() || count < 0) {
+    qLog(Warning) << "Ignoring invalid moodbar store index" << index_filename_;
+    return;
+  }
+
+  QHash<QByteArray, Entry> entries;
+  entries.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    QByteArray key;
+    quint32 mtime = 0;
+    qint64 offset = 0;
+    qint32 length = 0;
+    s >> key >> mtime >> offset >> length;
+
+    if (s.status() != QDataStream::Ok || length < 0 ||
+        offset + length > indexed_end) {
+      qLog(Warning) << "Ignoring invalid moodbar store index"
+                    << index_filename_;
+      return;
+    }
+
+    const Entry entry = {mtime, offset, length};
+    entries[key] = entry;
+  }
+
+  entries_.swap(entries);
+  end_ = indexed_end_ = indexed_end;
+  wasted_bytes_ = wasted_bytes;
+}
+
+void MoodbarStore::SaveIndex() {
+  QSaveFile file(index_filename_);
+  if (!file.open(QIODevice::WriteOnly)) return;
+
+  QDataStream s(&file);
+  s << kMagic << kVersion << end_ << wasted_bytes_
+    << qint32(entries_.count());
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it) {
+    s << it.key() << quint32(it->mtime_) << it->offset_
+      << qint32(it->length_);
+  }
+
+  if (file.commit()) {
+    indexed_end_ = end_;
+    index_dirty_ = false;
+  }
+}
+
+void MoodbarStore::ReadRecords(qint64 pos) {
+  const qint64 size = file_.size();
+
+  while (file_.seek(pos)) {
+    RecordHeader header;
+    if (file_.read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+            sizeof(header) ||
+        header.magic != kRecordMagic ||
+        pos + qint64(sizeof(header)) + header.key_bytes + header.data_bytes >
+            size) {
+      break;
+    }
+
+    const QByteArray key = file_.read(header.key_bytes);
+    if (key.size() != int(header.key_bytes)) break;
+
+    const Entry entry = {header.mtime,
+                         pos + qint64(sizeof(header)) + key.size(),
+                         int(header.data_bytes)};
+    AddEntry(key, entry);
+    pos += record_bytes(key, entry.length_);
+  }
+
+  // Anything after the last whole record was being written when we last
+  // exited.
+  if (pos < size) {
+    qLog(Warning) << "Dropping" << size - pos
+                  << "bytes from the end of the moodbar store";
+    file_.resize(pos);
+  }
+
+  end_ = pos;
+  if (end_ != indexed_end_) index_dirty_ = true;
+}
+
+void MoodbarStore::AddEntry(const QByteArray& key, const Entry& entry) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    wasted_bytes_ += record_bytes(key, it->length_);
+    *it = entry;
+  } else {
+    entries_.insert(key, entry);
+  }
+}
+
+bool MoodbarStore::Contains(const QUrl& url, uint mtime) const {
+  auto it = entries_.constFind(url.toEncoded());
+  return it != entries_.constEnd() && it->mtime_ == mtime;
+}
+
+bool MoodbarStore::Get(const QUrl& url, uint mtime, QByteArray* data) {
+  auto it = entries_.constFind(url.toEncoded());
+  if (it == entries_.constEnd() || it->mtime_ != mtime) return false;
+
+  // The map only covers the records that were there when it was made.
+  if (it->offset_ + it->length_ > mapped_size_ && !Map()) return false;
+
+  *data = QByteArray(reinterpret_cast<const char*>(data_ + it->offset_),
+                     it->length_);
+  return true;
+}
+
+void MoodbarStore::Put(const QUrl& url, uint mtime, const QByteArray& data) {
+  if (!file_.isOpen()) return;
+
+  const QByteArray key = url.toEncoded();
+  const RecordHeader header = {kRecordMagic, quint32(key.size()),
+                               quint32(data.size()), mtime};
+
+  if (!file_.seek(end_) ||
+      file_.write(reinterpret_cast<const char*>(&header), sizeof(header)) !=
+          sizeof(header) ||
+      file_.write(key) != key.size() || file_.write(data) != data.size() ||
+      !file_.flush()) {
+    qLog(Warning) << "Couldn't write to moodbar store" << file_.fileName();
+    file_.resize(end_);
+    return;
+  }
+
+  const Entry entry = {mtime, end_ + qint64(sizeof(header)) + key.size(),
+                       data.size()};
+  AddEntry(key, entry);
+  end_ += record_bytes(key, data.size());
+  index_dirty_ = true;
+}
+
+void MoodbarStore::Compact() {
+  if (!file_.isOpen() || (mapped_size_ < end_ && !Map())) return;
+
+  QSaveFile out(file_.fileName());
+  if (!out.open(QIODevice::WriteOnly)) return;
+
+  const Header header = {kMagic, kVersion};
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  QHash<QByteArray, Entry> entries;
+  entries.reserve(entries_.count());
+  qint64 pos = sizeof(Header);
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it) {
+    const QByteArray& key = it.key();
+    const RecordHeader record = {kRecordMagic, quint32(key.size()),
+                                 quint32(it->length_), it->mtime_};
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    out.write(key);
+    out.write(reinterpret_cast<const char*>(data_ + it->offset_), it->length_);
+
+    const Entry entry = {it->mtime_, pos + qint64(sizeof(record)) + key.size(),
+                         it->length_};
+    entries.insert(key, entry);
+    pos += record_bytes(key, it->length_);
+  }
+
+  // The old file can't be replaced while it's open everywhere.
+  const qint64 old_size = end_;
+  file_.unmap(data_);
+  data_ = nullptr;
+  mapped_size_ = 0;
+  file_.close();
+
+  const bool replaced = out.commit();
+  if (!file_.open(QIODevice::ReadWrite)) {
+    qLog(Warning) << "Couldn't reopen moodbar store" << file_.fileName();
+    entries_.clear();
+    return;
+  }
+
+  if (!replaced) {
+    qLog(Warning) << "Couldn't compact moodbar store" << file_.fileName();
+    Map();
+    return;
+  }
+
+  entries_.swap(entries);
+  end_ = pos;
+  wasted_bytes_ = 0;
+  Map();
+  SaveIndex();
+
+  qLog(Info) << "Compacted moodbar store from" << old_size << "to" << end_
+             << "bytes";
+}
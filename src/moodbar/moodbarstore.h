@@ -0,0 +1,108 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOODBARSTORE_H
+#define MOODBARSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+class QUrl;
+
+// Keeps the moodbar data for every song in one file, instead of a small cache
+// file each.  Records are only ever appended to the memory-mapped data file,
+// and an index of where each song's latest record starts is kept in a file
+// next to it.  Records written since the index was last saved are found
+// again by reading the end of the data file.
+//
+// Each record is stored with the modification time of the song's file, and
+// is ignored once the file has changed.  When more than half the data file
+// is taken up by records that have been replaced, it's rewritten without
+// them.
+class MoodbarStore {
+ public:
+  explicit MoodbarStore(const QString& filename);
+  ~MoodbarStore();
+
+  static const qint64 kMinCompactBytes;
+
+  bool Contains(const QUrl& url, uint mtime) const;
+
+  // Returns false if there's no data for url that's as new as mtime.
+  bool Get(const QUrl& url, uint mtime, QByteArray* data);
+  void Put(const QUrl& url, uint mtime, const QByteArray& data);
+
+  // Rewrites the data file with only the latest record for each song.
+  void Compact();
+
+  int count() const { return entries_.count(); }
+  qint64 wasted_bytes() const { return wasted_bytes_; }
+
+ private:
+  struct Header {
+    quint32 magic;
+    quint32 version;
+  };
+
+  struct RecordHeader {
+    quint32 magic;
+    quint32 key_bytes;
+    quint32 data_bytes;
+    quint32 mtime;
+  };
+
+  struct Entry {
+    uint mtime_;
+    // Where the record's data starts in the data file.
+    qint64 offset_;
+    int length_;
+  };
+
+  static const quint32 kMagic;
+  static const quint32 kRecordMagic;
+  static const quint32 kVersion;
+
+  static qint64 record_bytes(const QByteArray& key, int length) {
+    return sizeof(RecordHeader) + key.size() + length;
+  }
+
+  bool Open();
+  void Reset();
+  bool Map();
+  void LoadIndex();
+  void SaveIndex();
+  void ReadRecords(qint64 pos);
+  void AddEntry(const QByteArray& key, const Entry& entry);
+
+  QFile file_;
+  QString index_filename_;
+  uchar* data_;
+  qint64 mapped_size_;
+
+  // The end of the last whole record.
+  qint64 end_;
+  // How far into the data file the saved index goes.
+  qint64 indexed_end_;
+  qint64 wasted_bytes_;
+
+  QHash<QByteArray, Entry> entries_;
+  bool index_dirty_;
+};
+
+#endif  // MOODBARSTORE_H
@@ -24,6 +24,7 @@
 #include <QJsonParseError>
 #include <QNetworkReply>
 #include <QStringList>
+#include <QTimer>
 #include <QUrlQuery>
 #include <algorithm>
 
@@ -35,42 +36,101 @@
 const char* AcoustidClient::kClientId = "qsZGpeLx";
 const char* AcoustidClient::kUrl = "https://api.acoustid.org/v2/lookup";
 const int AcoustidClient::kDefaultTimeout = 5000;  // msec
+const int AcoustidClient::kBatchDelayMsec = 500;
+const int AcoustidClient::kMaxBatchSize = 20;
 
 AcoustidClient::AcoustidClient(QObject* parent)
     : QObject(parent),
       network_(new NetworkAccessManager(this)),
-      timeouts_(new NetworkTimeouts(kDefaultTimeout, this)) {}
+      timeouts_(new NetworkTimeouts(kDefaultTimeout, this)),
+      batch_timer_(new QTimer(this)) {
+  batch_timer_->setSingleShot(true);
+  batch_timer_->setInterval(kBatchDelayMsec);
+  connect(batch_timer_, SIGNAL(timeout()), SLOT(SendBatch()));
+}
 
 void AcoustidClient::SetTimeout(int msec) { timeouts_->SetTimeout(msec); }
 
 void AcoustidClient::Start(int id, const QString& fingerprint,
                            int duration_msec) {
+  Request request;
+  request.id_ = id;
+  request.fingerprint_ = fingerprint;
+  request.duration_msec_ = duration_msec;
+  queue_ << request;
+
+  if (queue_.count() >= kMaxBatchSize) {
+    SendBatch();
+  } else if (!batch_timer_->isActive()) {
+    batch_timer_->start();
+  }
+}
+
+void AcoustidClient::SendBatch() {
+  batch_timer_->stop();
+  if (queue_.isEmpty()) return;
+
   typedef QPair<QString, QString> Param;
 
   QList<Param> parameters;
   parameters << Param("format", "json") << Param("client", kClientId)
-             << Param("duration", QString::number(duration_msec / kMsecPerSec))
-             << Param("meta", "recordingids+sources")
-             << Param("fingerprint", fingerprint);
+             << Param("meta", "recordingids+sources");
+
+  QList<int> ids;
+  while (!queue_.isEmpty() && ids.count() < kMaxBatchSize) {
+    const Request request = queue_.takeFirst();
+    const QString index = QString::number(ids.count());
+    parameters << Param("duration." + index,
+                        QString::number(request.duration_msec_ / kMsecPerSec))
+               << Param("fingerprint." + index, request.fingerprint_);
+    ids << request.id_;
+  }
 
-  QUrl url(kUrl);
-  QUrlQuery url_query;
-  url_query.setQueryItems(parameters);
-  url.setQuery(url_query);
-  QNetworkRequest req(url);
+  // Fingerprints are too long to go in the URL once there are a few of them.
+  QUrlQuery body;
+  body.setQueryItems(parameters);
+  QNetworkRequest req{QUrl(kUrl)};
+  req.setHeader(QNetworkRequest::ContentTypeHeader,
+                "application/x-www-form-urlencoded");
 
-  QNetworkReply* reply = network_->get(req);
+  QNetworkReply* reply =
+      network_->post(req, body.toString(QUrl::FullyEncoded).toUtf8());
   NewClosure(reply, SIGNAL(finished()), this,
-             SLOT(RequestFinished(QNetworkReply*, int)), reply, id);
-  requests_[id] = reply;
+             SLOT(RequestFinished(QNetworkReply*)), reply);
+  requests_[reply] = ids;
 
   timeouts_->AddReply(reply);
+
+  if (!queue_.isEmpty()) batch_timer_->start();
 }
 
-void AcoustidClient::Cancel(int id) { delete requests_.take(id); }
+void AcoustidClient::Cancel(int id) {
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if (it->id_ == id) {
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (auto it = requests_.begin(); it != requests_.end();) {
+    QList<int>& ids = it.value();
+    std::replace(ids.begin(), ids.end(), id, -1);
+    if (std::count(ids.begin(), ids.end(), -1) == ids.count()) {
+      // Nobody wants anything from this reply any more.
+      delete it.key();
+      it = requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
 
 void AcoustidClient::CancelAll() {
-  qDeleteAll(requests_.values());
+  queue_.clear();
+  batch_timer_->stop();
+
+  qDeleteAll(requests_.keys());
   requests_.clear();
 }
 
@@ -89,40 +149,40 @@ struct IdSource {
 };
 }  // namespace
 
-void AcoustidClient::RequestFinished(QNetworkReply* reply, int request_id) {
+void AcoustidClient::RequestFinished(QNetworkReply* reply) {
   reply->deleteLater();
-  requests_.remove(request_id);
+  const QList<int> ids = requests_.take(reply);
 
-  if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() !=
-      200) {
-    emit Finished(request_id, QStringList());
-    return;
-  }
+  // The results for each index in the request.
+  QMap<int, QStringList> results;
 
   QJsonParseError error;
   QJsonDocument json_document =
       QJsonDocument::fromJson(reply->readAll(), &error);
+  QJsonObject json_object = json_document.object();
 
-  if (error.error != QJsonParseError::NoError) {
-    emit Finished(request_id, QStringList());
-    return;
+  if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() ==
+          200 &&
+      error.error == QJsonParseError::NoError &&
+      json_object["status"].toString() == "ok") {
+    for (const QJsonValue& v : json_object["fingerprints"].toArray()) {
+      QJsonObject fingerprint = v.toObject();
+      results[fingerprint["index"].toVariant().toInt()] =
+          ParseResults(fingerprint["results"].toArray());
+    }
   }
 
-  QJsonObject json_object = json_document.object();
-
-  QString status = json_object["status"].toString();
-  if (status != "ok") {
-    emit Finished(request_id, QStringList());
-    return;
+  for (int i = 0; i < ids.count(); ++i) {
+    if (ids[i] != -1) emit Finished(ids[i], results.value(i));
   }
+}
 
+QStringList AcoustidClient::ParseResults(const QJsonArray& json_results) {
   // Get the results:
   // -in a first step, gather ids and their corresponding number of sources
   // -then sort results by number of sources (the results are originally
   //  unsorted but results with more sources are likely to be more accurate)
   // -keep only the ids, as sources where useful only to sort the results
-  QJsonArray json_results = json_object["results"].toArray();
-
   // List of <id, nb of sources> pairs
   QList<IdSource> id_source_list;
 
@@ -141,10 +201,9 @@ void AcoustidClient::RequestFinished(QNetworkReply* reply, int request_id) {
 
   std::stable_sort(id_source_list.begin(), id_source_list.end());
 
-  QList<QString> id_list;
+  QStringList id_list;
   for (const IdSource& is : id_source_list) {
     id_list << is.id_;
   }
-
-  emit Finished(request_id, id_list);
+  return id_list;
 }
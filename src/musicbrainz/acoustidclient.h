@@ -18,13 +18,16 @@
 #ifndef ACOUSTIDCLIENT_H
 #define ACOUSTIDCLIENT_H
 
+#include <QList>
 #include <QMap>
 #include <QObject>
 
 class NetworkTimeouts;
 
+class QJsonArray;
 class QNetworkAccessManager;
 class QNetworkReply;
+class QTimer;
 
 class AcoustidClient : public QObject {
   Q_OBJECT
@@ -36,6 +39,7 @@ class AcoustidClient : public QObject {
   // You can create one AcoustidClient and make multiple requests using it.
   // IDs are provided by the caller when a request is started and included in
   // the Finished signal - they have no meaning to AcoustidClient.
+  // Fingerprints started close together are looked up in one request.
 
  public:
   AcoustidClient(QObject* parent = nullptr);
@@ -43,6 +47,11 @@ class AcoustidClient : public QObject {
   // Network requests will be aborted after this interval.
   void SetTimeout(int msec);
 
+  // How long Start waits for more fingerprints before sending a request, and
+  // how many go in one request.
+  static const int kBatchDelayMsec;
+  static const int kMaxBatchSize;
+
   // Starts a request and returns immediately.  Finished() will be emitted
   // later with the same ID.
   void Start(int id, const QString& fingerprint, int duration_msec);
@@ -59,16 +68,31 @@ class AcoustidClient : public QObject {
   void Finished(int id, const QStringList& mbid_list);
 
  private slots:
-  void RequestFinished(QNetworkReply* reply, int id);
+  void SendBatch();
+  void RequestFinished(QNetworkReply* reply);
 
  private:
+  struct Request {
+    int id_;
+    QString fingerprint_;
+    int duration_msec_;
+  };
+
+  static QStringList ParseResults(const QJsonArray& results);
+
   static const char* kClientId;
   static const char* kUrl;
   static const int kDefaultTimeout;
 
   QNetworkAccessManager* network_;
   NetworkTimeouts* timeouts_;
-  QMap<int, QNetworkReply*> requests_;
+
+  QList<Request> queue_;
+  QTimer* batch_timer_;
+
+  // The IDs looked up by each reply, by their index in the request.
+  // Cancelled ones are -1.
+  QMap<QNetworkReply*, QList<int>> requests_;
 };
 
 #endif  // ACOUSTIDCLIENT_H
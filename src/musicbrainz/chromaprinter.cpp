@@ -35,11 +35,18 @@ typedef unsigned int u_int32_t;
 
 static const int kDecodeRate = 11025;
 static const int kDecodeChannels = 1;
-static const int kPlayLengthSecs = 30;
 static const int kTimeoutSecs = 10;
 
-Chromaprinter::Chromaprinter(const QString& filename)
-    : filename_(filename), convert_element_(nullptr) {}
+const int Chromaprinter::kDefaultLengthSecs = 120;
+
+Chromaprinter::Chromaprinter(const QString& filename, int length_secs)
+    : filename_(filename),
+      length_secs_(length_secs),
+      pipeline_(nullptr),
+      convert_element_(nullptr),
+      chromaprint_(nullptr),
+      samples_needed_(qint64(length_secs) * kDecodeRate * kDecodeChannels),
+      samples_fed_(0) {}
 
 Chromaprinter::~Chromaprinter() {}
 
@@ -60,8 +67,6 @@ GstElement* Chromaprinter::CreateElement(const QString& factory_name,
 QString Chromaprinter::CreateFingerprint() {
   Q_ASSERT(QThread::currentThread() != qApp->thread());
 
-  buffer_.open(QIODevice::WriteOnly);
-
   GstElement* pipeline = gst_pipeline_new("pipeline");
   GstElement* src = CreateElement("filesrc", pipeline);
   GstElement* decode = CreateElement("decodebin", pipeline);
@@ -70,11 +75,16 @@ QString Chromaprinter::CreateFingerprint() {
   GstElement* sink = CreateElement("appsink", pipeline);
 
   if (!src || !decode || !convert || !resample || !sink) {
+    gst_object_unref(pipeline);
     return QString();
   }
 
+  pipeline_ = pipeline;
   convert_element_ = convert;
 
+  // The fingerprint doesn't need a good resampler, just a fast one.
+  g_object_set(G_OBJECT(resample), "quality", 0, nullptr);
+
   // Connect the elements
   gst_element_link_many(src, decode, nullptr);
   gst_element_link_many(convert, resample, nullptr);
@@ -92,7 +102,6 @@ QString Chromaprinter::CreateFingerprint() {
   gst_app_sink_set_callbacks(reinterpret_cast<GstAppSink*>(sink), &callbacks,
                              this, nullptr);
   g_object_set(G_OBJECT(sink), "sync", FALSE, nullptr);
-  g_object_set(G_OBJECT(sink), "emit-signals", TRUE, nullptr);
 
   // Set the filename
   g_object_set(src, "location", filename_.toUtf8().constData(), nullptr);
@@ -101,24 +110,31 @@ QString Chromaprinter::CreateFingerprint() {
   GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
   CHECKED_GCONNECT(decode, "pad-added", &NewPadCallback, this);
 
-  // Play only first x seconds
+  ChromaprintContext* chromaprint =
+      chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+  chromaprint_start(chromaprint, kDecodeRate, kDecodeChannels);
+  chromaprint_ = chromaprint;
+
+  QElapsedTimer time;
+  time.start();
+
+  // Play only first x seconds.  Not every demuxer stops at the end of the
+  // segment, so NewBufferCallback also stops once it has enough.
   gst_element_set_state(pipeline, GST_STATE_PAUSED);
   // wait for state change before seeking
   gst_element_get_state(pipeline, nullptr, nullptr, kTimeoutSecs * GST_SECOND);
   gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
                    GST_SEEK_TYPE_SET, 0 * GST_SECOND, GST_SEEK_TYPE_SET,
-                   kPlayLengthSecs * GST_SECOND);
-
-  QElapsedTimer time;
-  time.start();
+                   length_secs_ * GST_SECOND);
 
   // Start playing
   gst_element_set_state(pipeline, GST_STATE_PLAYING);
 
-  // Wait until EOS or error
+  // Wait until EOS or error, or until the callback says it has enough
   GstMessage* msg = gst_bus_timed_pop_filtered(
       bus, kTimeoutSecs * GST_SECOND,
-      static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+      static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR |
+                                  GST_MESSAGE_APPLICATION));
 
   if (msg != nullptr) {
     if (msg->type == GST_MESSAGE_ERROR) {
@@ -137,18 +153,12 @@ QString Chromaprinter::CreateFingerprint() {
     gst_message_unref(msg);
   }
 
-  int decode_time = time.restart();
-
-  buffer_.close();
+  // Stop the streaming threads before chromaprint is used here.
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  chromaprint_ = nullptr;
 
-  // Generate fingerprint from recorded buffer data
-  QByteArray data = buffer_.data();
+  int decode_time = time.restart();
 
-  ChromaprintContext* chromaprint =
-      chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
-  chromaprint_start(chromaprint, kDecodeRate, kDecodeChannels);
-  chromaprint_feed(chromaprint, reinterpret_cast<int16_t*>(data.data()),
-                   data.size() / 2);
   chromaprint_finish(chromaprint);
 
   int size = 0;
@@ -164,7 +174,11 @@ QString Chromaprinter::CreateFingerprint() {
   int ret = chromaprint_get_raw_fingerprint(chromaprint, &fprint, &size);
 
   QByteArray fingerprint;
+  raw_fingerprint_.clear();
   if (ret == 1) {
+    const quint32* items = reinterpret_cast<const quint32*>(fprint);
+    raw_fingerprint_.assign(items, items + size);
+
     int encoded_size = 0;
     chromaprint_encode_fingerprint(fprint, size, CHROMAPRINT_ALGORITHM_DEFAULT,
                                    &encoded, &encoded_size, 1);
@@ -178,13 +192,14 @@ QString Chromaprinter::CreateFingerprint() {
   int codegen_time = time.elapsed();
 
   qLog(Debug) << "Decode time:" << decode_time
-              << "Codegen time:" << codegen_time;
+              << "Codegen time:" << codegen_time << "for"
+              << samples_fed_ / kDecodeRate << "seconds";
 
   // Cleanup
   callbacks.new_sample = nullptr;
   gst_object_unref(bus);
-  gst_element_set_state(pipeline, GST_STATE_NULL);
   gst_object_unref(pipeline);
+  pipeline_ = nullptr;
 
   return fingerprint;
 }
@@ -209,15 +224,34 @@ GstFlowReturn Chromaprinter::NewBufferCallback(GstAppSink* app_sink,
 
   GstSample* sample = gst_app_sink_pull_sample(app_sink);
   if (!sample) return GST_FLOW_ERROR;
+  if (me->samples_fed_ >= me->samples_needed_) {
+    gst_sample_unref(sample);
+    return GST_FLOW_EOS;
+  }
+
   GstBuffer* buffer = gst_sample_get_buffer(sample);
   if (buffer) {
     GstMapInfo map;
     if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-      me->buffer_.write(reinterpret_cast<const char*>(map.data), map.size);
+      const qint64 samples =
+          qMin(qint64(map.size / sizeof(int16_t)),
+               me->samples_needed_ - me->samples_fed_);
+      chromaprint_feed(me->chromaprint_, reinterpret_cast<int16_t*>(map.data),
+                       static_cast<int>(samples));
+      me->samples_fed_ += samples;
       gst_buffer_unmap(buffer, &map);
     }
   }
   gst_sample_unref(sample);
 
+  if (me->samples_fed_ >= me->samples_needed_) {
+    // That's all chromaprint needs, don't wait for the rest to be decoded.
+    gst_element_post_message(
+        me->pipeline_,
+        gst_message_new_application(
+            GST_OBJECT(app_sink), gst_structure_new_empty("enough-audio")));
+    return GST_FLOW_EOS;
+  }
+
   return GST_FLOW_OK;
 }
@@ -18,11 +18,12 @@
 #ifndef CHROMAPRINTER_H
 #define CHROMAPRINTER_H
 
+#include <chromaprint.h>
 #include <gst/app/gstappsink.h>
 #include <gst/gst.h>
 
-#include <QBuffer>
 #include <QString>
+#include <vector>
 
 class Chromaprinter {
   // Creates a Chromaprint fingerprint from a song.
@@ -31,9 +32,16 @@ class Chromaprinter {
   // a song via Acoustid.
   // You should create one Chromaprinter for each file you want to fingerprint.
   // This class works well with QtConcurrentMap.
+  // Audio is decoded straight to the rate and channels Chromaprint works in
+  // and fed to it as it arrives, stopping once there's enough.
 
  public:
-  Chromaprinter(const QString& filename);
+  // Chromaprint doesn't look at more than this, and it's what AcoustID's own
+  // fpcalc uses.
+  static const int kDefaultLengthSecs;
+
+  Chromaprinter(const QString& filename,
+                int length_secs = kDefaultLengthSecs);
   ~Chromaprinter();
 
   // Creates a fingerprint from the song.  This method is blocking, so you want
@@ -41,6 +49,12 @@ class Chromaprinter {
   // could be created.
   QString CreateFingerprint();
 
+  // The fingerprint CreateFingerprint made, before it was encoded for
+  // AcoustID: one 32 bit hash for every eighth of a second or so.
+  const std::vector<quint32>& raw_fingerprint() const {
+    return raw_fingerprint_;
+  }
+
  private:
   GstElement* CreateElement(const QString& factory_name,
                             GstElement* bin = nullptr);
@@ -50,10 +64,17 @@ class Chromaprinter {
 
  private:
   QString filename_;
+  int length_secs_;
 
+  GstElement* pipeline_;
   GstElement* convert_element_;
 
-  QBuffer buffer_;
+  // Only used in the streaming thread while the pipeline is playing.
+  ChromaprintContext* chromaprint_;
+  qint64 samples_needed_;
+  qint64 samples_fed_;
+
+  std::vector<quint32> raw_fingerprint_;
 };
 
 #endif  // CHROMAPRINTER_H
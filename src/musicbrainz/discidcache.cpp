@@ -0,0 +1,102 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "discidcache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include "core/database.h"
+
+const int DiscIdCache::kMaxAgeDays = 30;
+
+namespace {
+
+const int kTracksVersion = 1;
+
+}  // namespace
+
+DiscIdCache::DiscIdCache(Database* db) : db_(db) {}
+
+bool DiscIdCache::Entry::is_stale() const {
+  return QDateTime::fromTime_t(fetched_).daysTo(
+             QDateTime::currentDateTime()) >= kMaxAgeDays;
+}
+
+DiscIdCache::Entry DiscIdCache::Lookup(const QString& discid) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "SELECT artist, album, tracks, fetched FROM musicbrainz_discids"
+      " WHERE discid = :discid");
+  q.bindValue(":discid", discid);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return Entry();
+
+  QByteArray data = q.value(2).toByteArray();
+  QDataStream s(&data, QIODevice::ReadOnly);
+  qint32 version = 0;
+  qint32 count = 0;
+  s >> version >> count;
+  if (version != kTracksVersion) return Entry();
+
+  Entry ret;
+  for (int i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+    MusicBrainzClient::Result track;
+    s >> track;
+    ret.tracks_ << track;
+  }
+  if (s.status() != QDataStream::Ok) return Entry();
+
+  ret.artist_ = q.value(0).toString();
+  ret.album_ = q.value(1).toString();
+  ret.fetched_ = q.value(3).toLongLong();
+  return ret;
+}
+
+void DiscIdCache::Store(const QString& discid, const QString& artist,
+                        const QString& album,
+                        const MusicBrainzClient::ResultList& tracks) {
+  QByteArray data;
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s << qint32(kTracksVersion) << qint32(tracks.count());
+    for (const MusicBrainzClient::Result& track : tracks) {
+      s << track;
+    }
+  }
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "INSERT OR REPLACE INTO musicbrainz_discids"
+      " (discid, artist, album, tracks, fetched)"
+      " VALUES (:discid, :artist, :album, :tracks, :fetched)");
+  q.bindValue(":discid", discid);
+  q.bindValue(":artist", artist);
+  q.bindValue(":album", album);
+  q.bindValue(":tracks", data);
+  q.bindValue(":fetched", QDateTime::currentDateTime().toTime_t());
+  q.exec();
+  db_->CheckErrors(q);
+}
@@ -0,0 +1,58 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MUSICBRAINZ_DISCIDCACHE_H_
+#define MUSICBRAINZ_DISCIDCACHE_H_
+
+#include <QString>
+
+#include "musicbrainzclient.h"
+
+class Database;
+
+// Remembers what MusicBrainz said about each disc ID, so a CD that's been
+// seen before gets its track names straight away, even offline.
+class DiscIdCache {
+ public:
+  explicit DiscIdCache(Database* db);
+
+  // Entries older than this are looked up again, but are still used if the
+  // lookup fails.
+  static const int kMaxAgeDays;
+
+  struct Entry {
+    Entry() : fetched_(0) {}
+
+    bool is_valid() const { return fetched_ != 0; }
+    bool is_stale() const;
+
+    QString artist_;
+    QString album_;
+    MusicBrainzClient::ResultList tracks_;
+    qint64 fetched_;  // Seconds since the epoch
+  };
+
+  // Returns an invalid entry if the disc hasn't been seen.
+  Entry Lookup(const QString& discid);
+  void Store(const QString& discid, const QString& artist,
+             const QString& album, const MusicBrainzClient::ResultList& tracks);
+
+ private:
+  Database* db_;
+};
+
+#endif  // MUSICBRAINZ_DISCIDCACHE_H_
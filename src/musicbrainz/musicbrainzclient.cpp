@@ -18,8 +18,10 @@
 #include "musicbrainzclient.h"
 
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QNetworkReply>
 #include <QSet>
+#include <QTimer>
 #include <QUrlQuery>
 #include <QXmlStreamReader>
 #include <algorithm>
@@ -28,6 +30,7 @@
 #include "core/logging.h"
 #include "core/network.h"
 #include "core/utilities.h"
+#include "recordingcache.h"
 
 const char* MusicBrainzClient::kTrackUrl =
     "https://musicbrainz.org/ws/2/recording/";
@@ -41,13 +44,21 @@ MusicBrainzClient::MusicBrainzClient(QObject* parent,
                                      QNetworkAccessManager* network)
     : QObject(parent),
       network_(network ? network : new NetworkAccessManager(this)),
-      timeouts_(new NetworkTimeouts(kDefaultTimeout, this)) {}
+      timeouts_(new NetworkTimeouts(kDefaultTimeout, this)),
+      db_(nullptr) {}
 
 void MusicBrainzClient::Start(int id, const QStringList& mbid_list) {
   typedef QPair<QString, QString> Param;
 
   int request_number = 0;
   for (const QString& mbid : mbid_list) {
+    ResultList cached;
+    if (db_ && RecordingCache(db_).Lookup(mbid, &cached)) {
+      pending_results_[id] << PendingResults(request_number++, cached);
+      if (request_number >= kMaxRequestPerTrack) break;
+      continue;
+    }
+
     QList<Param> parameters;
     parameters << Param("inc", "artists+releases+media");
 
@@ -59,8 +70,8 @@ void MusicBrainzClient::Start(int id, const QStringList& mbid_list) {
 
     QNetworkReply* reply = network_->get(req);
     NewClosure(reply, SIGNAL(finished()), this,
-               SLOT(RequestFinished(QNetworkReply*, int, int)), reply, id,
-               request_number++);
+               SLOT(RequestFinished(QNetworkReply*, int, int, QString)),
+               reply, id, request_number++, mbid);
     requests_.insert(id, reply);
 
     timeouts_->AddReply(reply);
@@ -69,6 +80,15 @@ void MusicBrainzClient::Start(int id, const QStringList& mbid_list) {
       break;
     }
   }
+
+  // If everything was cached there's no reply to wait for, but the caller
+  // doesn't expect Finished before we return.
+  if (!requests_.contains(id)) {
+    QTimer::singleShot(0, this, [this, id]() {
+      // Unless it was cancelled in the meantime.
+      if (pending_results_.contains(id)) FinishIfDone(id);
+    });
+  }
 }
 
 void MusicBrainzClient::StartDiscIdRequest(const QString& discid) {
@@ -91,11 +111,15 @@ void MusicBrainzClient::StartDiscIdRequest(const QString& discid) {
   timeouts_->AddReply(reply);
 }
 
-void MusicBrainzClient::Cancel(int id) { delete requests_.take(id); }
+void MusicBrainzClient::Cancel(int id) {
+  delete requests_.take(id);
+  pending_results_.remove(id);
+}
 
 void MusicBrainzClient::CancelAll() {
   qDeleteAll(requests_.values());
   requests_.clear();
+  pending_results_.clear();
 }
 
 void MusicBrainzClient::DiscIdRequestFinished(const QString& discid,
@@ -181,7 +205,8 @@ void MusicBrainzClient::DiscIdRequestFinished(const QString& discid,
 }
 
 void MusicBrainzClient::RequestFinished(QNetworkReply* reply, int id,
-                                        int request_number) {
+                                        int request_number,
+                                        const QString& mbid) {
   reply->deleteLater();
 
   const int nb_removed = requests_.remove(id, reply);
@@ -207,6 +232,8 @@ void MusicBrainzClient::RequestFinished(QNetworkReply* reply, int id,
       }
     }
     pending_results_[id] << PendingResults(request_number, res);
+
+    if (db_ && !reader.hasError()) RecordingCache(db_).Store(mbid, res);
   } else {
     qLog(Error)
         << "Error:"
@@ -215,17 +242,21 @@ void MusicBrainzClient::RequestFinished(QNetworkReply* reply, int id,
     qLog(Error) << reply->readAll();
   }
 
+  FinishIfDone(id);
+}
+
+void MusicBrainzClient::FinishIfDone(int id) {
   // No more pending requests for this id: emit the results we have.
-  if (!requests_.contains(id)) {
-    // Merge the results we have
-    ResultList ret;
-    QList<PendingResults> result_list_list = pending_results_.take(id);
-    std::sort(result_list_list.begin(), result_list_list.end());
-    for (const PendingResults& result_list : result_list_list) {
-      ret << result_list.results_;
-    }
-    emit Finished(id, UniqueResults(ret, KeepOriginalOrder));
+  if (requests_.contains(id)) return;
+
+  // Merge the results we have
+  ResultList ret;
+  QList<PendingResults> result_list_list = pending_results_.take(id);
+  std::sort(result_list_list.begin(), result_list_list.end());
+  for (const PendingResults& result_list : result_list_list) {
+    ret << result_list.results_;
   }
+  emit Finished(id, UniqueResults(ret, KeepOriginalOrder));
 }
 
 bool MusicBrainzClient::MediumHasDiscid(const QString& discid,
@@ -408,3 +439,18 @@ MusicBrainzClient::ResultList MusicBrainzClient::UniqueResults(
   }
   return ret;
 }
+
+QDataStream& operator<<(QDataStream& s, const MusicBrainzClient::Result& r) {
+  s << r.title_ << r.artist_ << r.album_ << qint32(r.duration_msec_)
+    << qint32(r.track_) << qint32(r.year_);
+  return s;
+}
+
+QDataStream& operator>>(QDataStream& s, MusicBrainzClient::Result& r) {
+  qint32 duration_msec, track, year;
+  s >> r.title_ >> r.artist_ >> r.album_ >> duration_msec >> track >> year;
+  r.duration_msec_ = duration_msec;
+  r.track_ = track;
+  r.year_ = year;
+  return s;
+}
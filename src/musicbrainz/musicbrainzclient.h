@@ -23,8 +23,10 @@
 #include <QObject>
 #include <QXmlStreamReader>
 
+class Database;
 class NetworkTimeouts;
 
+class QDataStream;
 class QNetworkAccessManager;
 class QNetworkReply;
 
@@ -76,6 +78,10 @@ class MusicBrainzClient : public QObject {
   };
   typedef QList<Result> ResultList;
 
+  // Recordings are cached in the database if one is set, so looking up the
+  // same songs again doesn't need MusicBrainz.
+  void set_database(Database* db) { db_ = db; }
+
   // Starts a request and returns immediately.  Finished() will be emitted
   // later with the same ID.
   void Start(int id, const QStringList& mbid);
@@ -99,7 +105,8 @@ class MusicBrainzClient : public QObject {
  private slots:
   // id identifies the track, and request_number means it's the
   // 'request_number'th request for this track
-  void RequestFinished(QNetworkReply* reply, int id, int request_number);
+  void RequestFinished(QNetworkReply* reply, int id, int request_number,
+                       const QString& mbid);
   void DiscIdRequestFinished(const QString& discid, QNetworkReply* reply);
 
  private:
@@ -172,6 +179,9 @@ class MusicBrainzClient : public QObject {
   static ResultList UniqueResults(const ResultList& results,
                                   UniqueResultsSortOption opt = SortResults);
 
+  // Emits Finished if there are no more replies to wait for.
+  void FinishIfDone(int id);
+
  private:
   static const char* kTrackUrl;
   static const char* kDiscUrl;
@@ -181,6 +191,7 @@ class MusicBrainzClient : public QObject {
 
   QNetworkAccessManager* network_;
   NetworkTimeouts* timeouts_;
+  Database* db_;
   QMultiMap<int, QNetworkReply*> requests_;
   // Results we received so far, kept here until all the replies are finished
   QMap<int, QList<PendingResults>> pending_results_;
@@ -190,4 +201,8 @@ inline uint qHash(const MusicBrainzClient::Result& result) {
   return qHash(result.album_) ^ qHash(result.artist_) ^ result.duration_msec_ ^
          qHash(result.title_) ^ result.track_ ^ result.year_;
 }
+
+QDataStream& operator<<(QDataStream& s, const MusicBrainzClient::Result& r);
+QDataStream& operator>>(QDataStream& s, MusicBrainzClient::Result& r);
+
 #endif  // MUSICBRAINZCLIENT_H
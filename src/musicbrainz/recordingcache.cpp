@@ -0,0 +1,97 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "recordingcache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include "core/database.h"
+
+const int RecordingCache::kMaxAgeDays = 90;
+
+namespace {
+
+const int kTracksVersion = 1;
+
+}  // namespace
+
+RecordingCache::RecordingCache(Database* db) : db_(db) {}
+
+bool RecordingCache::Lookup(const QString& mbid,
+                            MusicBrainzClient::ResultList* tracks) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "SELECT tracks, fetched FROM musicbrainz_recordings"
+      " WHERE mbid = :mbid");
+  q.bindValue(":mbid", mbid);
+  q.exec();
+  if (db_->CheckErrors(q) || !q.next()) return false;
+
+  const QDateTime fetched = QDateTime::fromTime_t(q.value(1).toUInt());
+  if (fetched.daysTo(QDateTime::currentDateTime()) >= kMaxAgeDays) {
+    return false;
+  }
+
+  QByteArray data = q.value(0).toByteArray();
+  QDataStream s(&data, QIODevice::ReadOnly);
+  qint32 version = 0;
+  qint32 count = 0;
+  s >> version >> count;
+  if (version != kTracksVersion) return false;
+
+  MusicBrainzClient::ResultList ret;
+  for (int i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+    MusicBrainzClient::Result track;
+    s >> track;
+    ret << track;
+  }
+  if (s.status() != QDataStream::Ok) return false;
+
+  *tracks = ret;
+  return true;
+}
+
+void RecordingCache::Store(const QString& mbid,
+                           const MusicBrainzClient::ResultList& tracks) {
+  QByteArray data;
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s << qint32(kTracksVersion) << qint32(tracks.count());
+    for (const MusicBrainzClient::Result& track : tracks) {
+      s << track;
+    }
+  }
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare(
+      "INSERT OR REPLACE INTO musicbrainz_recordings (mbid, tracks, fetched)"
+      " VALUES (:mbid, :tracks, :fetched)");
+  q.bindValue(":mbid", mbid);
+  q.bindValue(":tracks", data);
+  q.bindValue(":fetched", QDateTime::currentDateTime().toTime_t());
+  q.exec();
+  db_->CheckErrors(q);
+}
@@ -0,0 +1,45 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MUSICBRAINZ_RECORDINGCACHE_H_
+#define MUSICBRAINZ_RECORDINGCACHE_H_
+
+#include <QString>
+
+#include "musicbrainzclient.h"
+
+class Database;
+
+// Remembers the releases MusicBrainz gave for each recording MBID, so tags
+// for songs that have been looked up before can be fixed without asking
+// again.
+class RecordingCache {
+ public:
+  explicit RecordingCache(Database* db);
+
+  // Entries older than this are looked up again.
+  static const int kMaxAgeDays;
+
+  // Returns false if the recording isn't cached, or its entry is too old.
+  bool Lookup(const QString& mbid, MusicBrainzClient::ResultList* tracks);
+  void Store(const QString& mbid, const MusicBrainzClient::ResultList& tracks);
+
+ private:
+  Database* db_;
+};
+
+#endif  // MUSICBRAINZ_RECORDINGCACHE_H_
@@ -17,21 +17,24 @@
 
 #include "tagfetcher.h"
 
-#include <QFuture>
-#include <QFutureWatcher>
+#include <QThread>
 #include <QUrl>
-#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
 #include "acoustidclient.h"
 #include "chromaprinter.h"
+#include "core/closure.h"
 #include "core/timeconstants.h"
 #include "musicbrainzclient.h"
 
 TagFetcher::TagFetcher(QObject* parent)
     : QObject(parent),
-      fingerprint_watcher_(nullptr),
+      generation_(0),
       acoustid_client_(new AcoustidClient(this)),
       musicbrainz_client_(new MusicBrainzClient(this)) {
+  fingerprint_pool_.setMaxThreadCount(
+      qMax(1, QThread::idealThreadCount() - 1));
+
   connect(acoustid_client_, SIGNAL(Finished(int, QStringList)),
           SLOT(PuidsFound(int, QStringList)));
   connect(musicbrainz_client_,
@@ -39,6 +42,15 @@ TagFetcher::TagFetcher(QObject* parent)
           SLOT(TagsFetched(int, MusicBrainzClient::ResultList)));
 }
 
+void TagFetcher::set_database(Database* db) {
+  musicbrainz_client_->set_database(db);
+}
+
+TagFetcher::~TagFetcher() {
+  // The pool waits for the songs that are being fingerprinted.
+  Cancel();
+}
+
 QString TagFetcher::GetFingerprint(const Song& song) {
   return Chromaprinter(song.url().toLocalFile()).CreateFingerprint();
 }
@@ -48,11 +60,18 @@ void TagFetcher::StartFetch(const SongList& songs) {
 
   songs_ = songs;
 
-  QFuture<QString> future = QtConcurrent::mapped(songs_, GetFingerprint);
-  fingerprint_watcher_ = new QFutureWatcher<QString>(this);
-  connect(fingerprint_watcher_, SIGNAL(resultReadyAt(int)),
-          SLOT(FingerprintFound(int)));
-  fingerprint_watcher_->setFuture(future);
+  const int generation = generation_.load();
+  for (int i = 0; i < songs_.count(); ++i) {
+    const Song song = songs_[i];
+    QFuture<QString> future =
+        QtConcurrent::run(&fingerprint_pool_, [this, generation, song]() {
+          if (generation_.load() != generation) return QString();
+          return GetFingerprint(song);
+        });
+    NewClosure(future, this,
+               SLOT(FingerprintFound(QFuture<QString>, int, int)), future,
+               generation, i);
+  }
 
   for (const Song& song : songs) {
     emit Progress(song, tr("Fingerprinting song"));
@@ -60,26 +79,20 @@ void TagFetcher::StartFetch(const SongList& songs) {
 }
 
 void TagFetcher::Cancel() {
-  if (fingerprint_watcher_) {
-    fingerprint_watcher_->cancel();
-
-    delete fingerprint_watcher_;
-    fingerprint_watcher_ = nullptr;
-  }
+  generation_.ref();
 
   acoustid_client_->CancelAll();
   musicbrainz_client_->CancelAll();
   songs_.clear();
 }
 
-void TagFetcher::FingerprintFound(int index) {
-  QFutureWatcher<QString>* watcher =
-      reinterpret_cast<QFutureWatcher<QString>*>(sender());
-  if (!watcher || index >= songs_.count()) {
+void TagFetcher::FingerprintFound(QFuture<QString> future, int generation,
+                                  int index) {
+  if (generation != generation_.load() || index >= songs_.count()) {
     return;
   }
 
-  const QString fingerprint = watcher->resultAt(index);
+  const QString fingerprint = future.result();
   const Song& song = songs_[index];
 
   if (fingerprint.isEmpty()) {
@@ -18,13 +18,16 @@
 #ifndef TAGFETCHER_H
 #define TAGFETCHER_H
 
-#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QFuture>
 #include <QObject>
+#include <QThreadPool>
 
 #include "core/song.h"
 #include "musicbrainzclient.h"
 
 class AcoustidClient;
+class Database;
 
 class TagFetcher : public QObject {
   Q_OBJECT
@@ -34,6 +37,10 @@ class TagFetcher : public QObject {
 
  public:
   TagFetcher(QObject* parent = nullptr);
+  ~TagFetcher();
+
+  // MusicBrainz results are cached in the database if one is set.
+  void set_database(Database* db);
 
   void StartFetch(const SongList& songs);
 
@@ -46,14 +53,22 @@ class TagFetcher : public QObject {
                        const SongList& songs_guessed);
 
  private slots:
-  void FingerprintFound(int index);
+  void FingerprintFound(QFuture<QString> future, int generation, int index);
   void PuidsFound(int index, const QStringList& puid_list);
   void TagsFetched(int index, const MusicBrainzClient::ResultList& result);
 
  private:
   static QString GetFingerprint(const Song& song);
 
-  QFutureWatcher<QString>* fingerprint_watcher_;
+  // Bumped by Cancel.  Songs from an older generation that haven't started
+  // yet are skipped, and their fingerprints are ignored.
+  QAtomicInt generation_;
+
+  // Fingerprinting has a pool of its own, a core short of the machine, so a
+  // big selection keeps the rest busy without holding up the UI or anything
+  // else that uses the global pool.
+  QThreadPool fingerprint_pool_;
+
   AcoustidClient* acoustid_client_;
   MusicBrainzClient* musicbrainz_client_;
 
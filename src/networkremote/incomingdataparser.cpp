@@ -25,6 +25,7 @@
 #include "core/timeconstants.h"
 #include "engines/enginebase.h"
 #include "internet/core/internetmodel.h"
+#include "mainthread.h"
 #include "playlist/playlist.h"
 #include "playlist/playlistmanager.h"
 #include "playlist/playlistsequence.h"
@@ -196,7 +197,12 @@ void IncomingDataParser::Parse(const cpb::remote::Message& msg) {
           msg.response_song_offer().accepted());
       break;
     case cpb::remote::GET_LIBRARY:
-      emit SendLibrary(client);
+      if (msg.has_request_library()) {
+        emit SendLibraryChanges(client,
+                                msg.request_library().since_revision());
+      } else {
+        emit SendLibrary(client);
+      }
       break;
     case cpb::remote::RATE_SONG:
       RateSong(msg);
@@ -207,6 +213,7 @@ void IncomingDataParser::Parse(const cpb::remote::Message& msg) {
     case cpb::remote::REQUEST_FILES:
       emit SendListFiles(
           QString::fromStdString(msg.request_list_files().relative_path()),
+          msg.request_list_files().offset(), msg.request_list_files().limit(),
           client);
       break;
     case cpb::remote::APPEND_FILES:
@@ -215,6 +222,9 @@ void IncomingDataParser::Parse(const cpb::remote::Message& msg) {
     case cpb::remote::REQUEST_SAVED_RADIOS:
       emit SendSavedRadios(client);
       break;
+    case cpb::remote::GET_ART:
+      emit SendArt(client, QStringFromStdString(msg.request_art().art_hash()));
+      break;
 
     default:
       break;
@@ -229,8 +239,17 @@ void IncomingDataParser::ChangeSong(const cpb::remote::Message& msg) {
   // Get the first entry and check if there is a song
   const cpb::remote::RequestChangeSong& request = msg.request_change_song();
 
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  Player* player = app_->player();
+  int active_id = -1;
+  Engine::State state = Engine::Empty;
+  MainThread::Run([&]() {
+    active_id = playlist_manager->active_id();
+    state = player->GetState();
+  });
+
   // Check if we need to change the playlist
-  if (request.playlist_id() != app_->playlist_manager()->active_id()) {
+  if (request.playlist_id() != active_id) {
     emit SetActivePlaylist(request.playlist_id());
   }
 
@@ -243,7 +262,7 @@ void IncomingDataParser::ChangeSong(const cpb::remote::Message& msg) {
     // Enque the selected song
     case MainWindow::PlaylistAddBehaviour_Enqueue:
       emit Enque(request.playlist_id(), request.song_index());
-      if (app_->player()->GetState() != Engine::Playing) {
+      if (state != Engine::Playing) {
         emit PlayAt(request.song_index(), Engine::Manual, false);
       }
 
@@ -302,8 +321,7 @@ void IncomingDataParser::InsertUrls(const cpb::remote::Message& msg) {
     }
 
     if (request.has_new_playlist_name())
-      playlist_id =
-          app_->playlist_manager()->New(request.new_playlist_name().c_str());
+      playlist_id = NewPlaylist(request.new_playlist_name().c_str());
 
     // Insert the urls
     emit InsertUrls(playlist_id, urls, request.position(), request.play_now(),
@@ -320,14 +338,20 @@ void IncomingDataParser::InsertUrls(const cpb::remote::Message& msg) {
     // create a new playlist if required and not already done above by
     // InsertUrls
     if (request.has_new_playlist_name() && playlist_id == request.playlist_id())
-      playlist_id =
-          app_->playlist_manager()->New(request.new_playlist_name().c_str());
+      playlist_id = NewPlaylist(request.new_playlist_name().c_str());
 
     emit InsertSongs(request.playlist_id(), songs, request.position(),
                      request.play_now(), request.enqueue());
   }
 }
 
+int IncomingDataParser::NewPlaylist(const QString& name) {
+  // The new playlist has to be made in the main thread, and we need its id.
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  return MainThread::Get<int>(
+      [playlist_manager, name]() { return playlist_manager->New(name); });
+}
+
 void IncomingDataParser::RemoveSongs(const cpb::remote::Message& msg) {
   const cpb::remote::RequestRemoveSongs& request = msg.request_remove_songs();
 
@@ -484,7 +508,9 @@ void IncomingDataParser::AppendFilesToPlaylist(
       }
     } else if (req_append.has_playlist_id()) {
       // if playing we will drop the files in another playlist
-      if (app_->player()->GetState() == Engine::Playing)
+      Player* player = app_->player();
+      if (MainThread::Get<Engine::State>(
+              [player]() { return player->GetState(); }) == Engine::Playing)
         data->playlist_id = req_append.playlist_id();
       else
         // as me may play the song, we change the current playlist
@@ -60,12 +60,14 @@ class IncomingDataParser : public QObject {
   void RemoveSongs(int id, const QList<int>& indices);
   void SeekTo(int seconds);
   void SendLibrary(RemoteClient* client);
+  void SendLibraryChanges(RemoteClient* client, qint64 since_revision);
   void RateCurrentSong(double);
 
   void DoGlobalSearch(QString, RemoteClient*);
 
   void SendSavedRadios(RemoteClient* client);
-  void SendListFiles(QString, RemoteClient*);
+  void SendArt(RemoteClient* client, const QString& art_hash);
+  void SendListFiles(QString, int, int, RemoteClient*);
   void AddToPlaylistSignal(QMimeData* data);
   void SetCurrentPlaylist(int id);
 
@@ -80,6 +82,8 @@ class IncomingDataParser : public QObject {
   void SetRepeatMode(const cpb::remote::Repeat& repeat);
   void SetShuffleMode(const cpb::remote::Shuffle& shuffle);
   void InsertUrls(const cpb::remote::Message& msg);
+  // Makes a new playlist in the main thread and returns its id.
+  int NewPlaylist(const QString& name);
   void RemoveSongs(const cpb::remote::Message& msg);
   void ClientConnect(const cpb::remote::Message& msg, RemoteClient* client);
   void SendPlaylists(const cpb::remote::Message& msg);
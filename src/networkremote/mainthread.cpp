@@ -0,0 +1,116 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mainthread.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <memory>
+
+namespace {
+
+// How often a waiting thread checks whether the application is quitting.
+const int kQuitCheckMsec = 100;
+
+QAtomicInt sQuitting(0);
+
+struct Call {
+  Call() : cancelled_(false) {}
+
+  std::function<void()> function_;
+
+  // Held while function_ runs, so the caller can't give up half way.
+  QMutex mutex_;
+  bool cancelled_;
+  QSemaphore done_;
+};
+
+// Moved to the main thread, where it runs the call when it gets the event.
+class Caller : public QObject {
+ public:
+  explicit Caller(std::shared_ptr<Call> call) : call_(call) {}
+
+  bool event(QEvent* e) {
+    if (e->type() != QEvent::User) return QObject::event(e);
+
+    {
+      QMutexLocker l(&call_->mutex_);
+      if (!call_->cancelled_) call_->function_();
+      call_->done_.release();
+    }
+    deleteLater();
+    return true;
+  }
+
+ private:
+  std::shared_ptr<Call> call_;
+};
+
+bool Quitting() {
+  return sQuitting.load() || QCoreApplication::closingDown();
+}
+
+}  // namespace
+
+namespace MainThread {
+
+void Init() {
+  Q_ASSERT(QThread::currentThread() ==
+           QCoreApplication::instance()->thread());
+
+  // Once the event loop has stopped the main thread will only wait for the
+  // other threads, so nothing posted to it would ever run.
+  static bool connected = false;
+  if (connected) return;
+  connected = true;
+  QObject::connect(QCoreApplication::instance(),
+                   &QCoreApplication::aboutToQuit,
+                   []() { sQuitting.store(1); });
+}
+
+bool Run(std::function<void()> function) {
+  QCoreApplication* app = QCoreApplication::instance();
+  if (QThread::currentThread() == app->thread()) {
+    function();
+    return true;
+  }
+
+  if (Quitting()) return false;
+
+  std::shared_ptr<Call> call(new Call);
+  call->function_ = function;
+
+  Caller* caller = new Caller(call);
+  caller->moveToThread(app->thread());
+  QCoreApplication::postEvent(caller, new QEvent(QEvent::User));
+
+  while (!call->done_.tryAcquire(1, kQuitCheckMsec)) {
+    if (Quitting()) {
+      QMutexLocker l(&call->mutex_);
+      if (call->done_.tryAcquire()) return true;
+      call->cancelled_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace MainThread
@@ -0,0 +1,50 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NETWORKREMOTE_MAINTHREAD_H
+#define NETWORKREMOTE_MAINTHREAD_H
+
+#include <functional>
+
+// The network remote, its clients and their song senders run in a thread of
+// their own, so sockets and file transfers never hold up the GUI.  The player
+// and the playlists live in the main thread, so anything that reads or
+// changes them goes through these.
+
+namespace MainThread {
+
+// Starts watching for the application quitting.  Must be called from the main
+// thread before Run is called from any other.
+void Init();
+
+// Runs function in the main thread and waits for it to finish.  If the
+// application quits first it gives up and returns false, and function is
+// never run.  Called from the main thread it just runs function.
+bool Run(std::function<void()> function);
+
+// Runs function in the main thread and returns what it returned, or a default
+// constructed T if the application quit first.
+template <typename T>
+T Get(std::function<T()> function) {
+  T ret = T();
+  Run([&ret, &function]() { ret = function(); });
+  return ret;
+}
+
+}  // namespace MainThread
+
+#endif  // NETWORKREMOTE_MAINTHREAD_H
@@ -26,6 +26,7 @@
 #include "core/logging.h"
 #include "covers/currentartloader.h"
 #include "networkremote/incomingdataparser.h"
+#include "networkremote/mainthread.h"
 #include "networkremote/outgoingdatacreator.h"
 #include "networkremote/zeroconf.h"
 #include "playlist/playlistmanager.h"
@@ -37,6 +38,8 @@ const char* NetworkRemote::kTranscoderSettingPostfix = "/NetworkRemote";
 NetworkRemote::NetworkRemote(Application* app, QObject* parent)
     : QObject(parent), signals_connected_(false), app_(app) {
   setObjectName("Network remote");
+  // Still in the main thread, before we're moved to our own.
+  MainThread::Init();
 }
 
 NetworkRemote::~NetworkRemote() { StopServer(); }
@@ -171,6 +174,10 @@ void NetworkRemote::AcceptConnection() {
 
     connect(incoming_data_parser_.get(), SIGNAL(SendLibrary(RemoteClient*)),
             outgoing_data_creator_.get(), SLOT(SendLibrary(RemoteClient*)));
+    connect(incoming_data_parser_.get(),
+            SIGNAL(SendLibraryChanges(RemoteClient*, qint64)),
+            outgoing_data_creator_.get(),
+            SLOT(SendLibraryChanges(RemoteClient*, qint64)));
 
     connect(incoming_data_parser_.get(),
             SIGNAL(DoGlobalSearch(QString, RemoteClient*)),
@@ -178,11 +185,15 @@ void NetworkRemote::AcceptConnection() {
             SLOT(DoGlobalSearch(QString, RemoteClient*)));
 
     connect(incoming_data_parser_.get(),
-            SIGNAL(SendListFiles(QString, RemoteClient*)),
+            SIGNAL(SendListFiles(QString, int, int, RemoteClient*)),
             outgoing_data_creator_.get(),
-            SLOT(SendListFiles(QString, RemoteClient*)));
+            SLOT(SendListFiles(QString, int, int, RemoteClient*)));
     connect(incoming_data_parser_.get(), SIGNAL(SendSavedRadios(RemoteClient*)),
             outgoing_data_creator_.get(), SLOT(SendSavedRadios(RemoteClient*)));
+    connect(incoming_data_parser_.get(),
+            SIGNAL(SendArt(RemoteClient*, QString)),
+            outgoing_data_creator_.get(),
+            SLOT(SendArt(RemoteClient*, QString)));
   }
 
   QTcpServer* server = qobject_cast<QTcpServer*>(sender());
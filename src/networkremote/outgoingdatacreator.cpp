@@ -17,7 +17,10 @@
 
 #include "outgoingdatacreator.h"
 
+#include <QCache>
+#include <QCryptographicHash>
 #include <QDir>
+#include <QMutex>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <cmath>
@@ -30,16 +33,36 @@
 #include "internet/core/internetmodel.h"
 #include "internet/internetradio/savedradio.h"
 #include "library/librarybackend.h"
+#include "mainthread.h"
 #include "networkremote.h"
 #include "ui/iconloader.h"
 
 const quint32 OutgoingDataCreator::kFileChunkSize = 100000;  // in Bytes
 
+namespace {
+
+// The current song's art is sent again with every metadata update, and to
+// every client, so the last one that was compressed is kept.
+QMutex sEncodedArtMutex;
+qint64 sEncodedArtKey = 0;
+QByteArray sEncodedArt;
+QString sEncodedArtHash;
+
+// Art that's been sent recently by its hash, for clients that fetch it with
+// GET_ART.  The cost is in bytes.
+QCache<QString, QByteArray> sArtByHash(16 * 1024 * 1024);
+
+// How many entries of the directories remotes have browsed are kept.
+const int kMaxCachedListedFiles = 50000;
+
+}  // namespace
+
 OutgoingDataCreator::OutgoingDataCreator(Application* app)
     : app_(app),
       aww_(false),
       ultimate_reader_(new UltimateLyricsReader(this)),
-      fetcher_(new SongInfoFetcher(this)) {
+      fetcher_(new SongInfoFetcher(this)),
+      file_listings_(kMaxCachedListedFiles) {
   // Create Keep Alive Timer
   keep_alive_timer_ = new QTimer(this);
   connect(keep_alive_timer_, SIGNAL(timeout()), this, SLOT(SendKeepAlive()));
@@ -145,12 +168,18 @@ SongInfoProvider* OutgoingDataCreator::ProviderByName(
   return nullptr;
 }
 
-void OutgoingDataCreator::SendDataToClients(cpb::remote::Message* msg) {
+void OutgoingDataCreator::SendDataToClients(
+    cpb::remote::Message* msg, cpb::remote::Message* without_art) {
   // Check if we have clients to send data to
   if (clients_->empty()) {
     return;
   }
 
+  // Serialised once for all the clients
+  OutgoingMessage outgoing(msg);
+  std::unique_ptr<OutgoingMessage> outgoing_without_art;
+  if (without_art) outgoing_without_art.reset(new OutgoingMessage(without_art));
+
   for (RemoteClient* client : *clients_) {
     // Do not send data to downloaders
     if (client->isDownloader()) {
@@ -163,7 +192,11 @@ void OutgoingDataCreator::SendDataToClients(cpb::remote::Message* msg) {
 
     // Check if the client is still active
     if (client->State() == QTcpSocket::ConnectedState) {
-      client->SendData(msg);
+      if (outgoing_without_art && client->art_by_hash()) {
+        client->SendData(outgoing_without_art.get());
+      } else {
+        client->SendData(&outgoing);
+      }
     } else {
       clients_->removeAt(clients_->indexOf(client));
       delete client;
@@ -195,7 +228,9 @@ void OutgoingDataCreator::SendClementineInfo() {
 
 void OutgoingDataCreator::SetEngineState(
     cpb::remote::ResponseClementineInfo* msg) {
-  switch (app_->player()->GetState()) {
+  Player* player = app_->player();
+  switch (MainThread::Get<Engine::State>(
+      [player]() { return player->GetState(); })) {
     case Engine::Idle:
       msg->set_state(cpb::remote::Idle);
       break;
@@ -213,9 +248,9 @@ void OutgoingDataCreator::SetEngineState(
 }
 
 void OutgoingDataCreator::SendAllPlaylists() {
-  // Get all Playlists
-  PlaylistManager* playlist_manager = app_->playlist_manager();
-  int active_playlist = playlist_manager->active_id();
+  // Get all playlists, even ones that are hidden in the UI.
+  const PlaylistBackend::PlaylistList all_playlists =
+      app_->playlist_backend()->GetAllPlaylists();
 
   // Create message
   cpb::remote::Message msg;
@@ -224,51 +259,60 @@ void OutgoingDataCreator::SendAllPlaylists() {
   cpb::remote::ResponsePlaylists* playlists = msg.mutable_response_playlists();
   playlists->set_include_closed(true);
 
-  // Get all playlists, even ones that are hidden in the UI.
-  for (const PlaylistBackend::Playlist& p :
-       app_->playlist_backend()->GetAllPlaylists()) {
-    bool playlist_open = playlist_manager->IsPlaylistOpen(p.id);
-    int item_count =
-        playlist_open ? playlist_manager->playlist(p.id)->rowCount() : 0;
-
-    // Create a new playlist
-    cpb::remote::Playlist* playlist = playlists->add_playlist();
-    playlist->set_name(DataCommaSizeFromQString(p.name));
-    playlist->set_id(p.id);
-    playlist->set_active((p.id == active_playlist));
-    playlist->set_item_count(item_count);
-    playlist->set_closed(!playlist_open);
-    playlist->set_favorite(p.favorite);
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  if (!MainThread::Run([&]() {
+        int active_playlist = playlist_manager->active_id();
+
+        for (const PlaylistBackend::Playlist& p : all_playlists) {
+          bool playlist_open = playlist_manager->IsPlaylistOpen(p.id);
+          int item_count = 0;
+          if (playlist_open) {
+            Playlist* open_playlist = playlist_manager->playlist(p.id);
+            open_playlist->RestoreBlocking();
+            item_count = open_playlist->rowCount();
+          }
+
+          // Create a new playlist
+          cpb::remote::Playlist* playlist = playlists->add_playlist();
+          playlist->set_name(DataCommaSizeFromQString(p.name));
+          playlist->set_id(p.id);
+          playlist->set_active((p.id == active_playlist));
+          playlist->set_item_count(item_count);
+          playlist->set_closed(!playlist_open);
+          playlist->set_favorite(p.favorite);
+        }
+      })) {
+    return;
   }
 
   SendDataToClients(&msg);
 }
 
 void OutgoingDataCreator::SendAllActivePlaylists() {
-  // Get all Playlists
-  QList<Playlist*> app_playlists = app_->playlist_manager()->GetAllPlaylists();
-  int active_playlist = app_->playlist_manager()->active_id();
-
   // Create message
   cpb::remote::Message msg;
   msg.set_type(cpb::remote::PLAYLISTS);
 
   cpb::remote::ResponsePlaylists* playlists = msg.mutable_response_playlists();
 
-  QListIterator<Playlist*> it(app_playlists);
-  while (it.hasNext()) {
-    // Get the next Playlist
-    Playlist* p = it.next();
-    QString playlist_name = app_->playlist_manager()->GetPlaylistName(p->id());
-
-    // Create a new playlist
-    cpb::remote::Playlist* playlist = playlists->add_playlist();
-    playlist->set_name(DataCommaSizeFromQString(playlist_name));
-    playlist->set_id(p->id());
-    playlist->set_active((p->id() == active_playlist));
-    playlist->set_item_count(p->rowCount());
-    playlist->set_closed(false);
-    playlist->set_favorite(p->is_favorite());
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  if (!MainThread::Run([&]() {
+        int active_playlist = playlist_manager->active_id();
+
+        for (Playlist* p : playlist_manager->GetAllPlaylists()) {
+          QString playlist_name = playlist_manager->GetPlaylistName(p->id());
+
+          // Create a new playlist
+          cpb::remote::Playlist* playlist = playlists->add_playlist();
+          playlist->set_name(DataCommaSizeFromQString(playlist_name));
+          playlist->set_id(p->id());
+          playlist->set_active((p->id() == active_playlist));
+          playlist->set_item_count(p->rowCount());
+          playlist->set_closed(false);
+          playlist->set_favorite(p->is_favorite());
+        }
+      })) {
+    return;
   }
 
   SendDataToClients(&msg);
@@ -300,20 +344,37 @@ void OutgoingDataCreator::PlaylistRenamed(int id, const QString& new_name) {
 
 void OutgoingDataCreator::SendFirstData(bool send_playlist_songs) {
   Player* player = app_->player();
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+
+  bool has_item = false;
+  int volume = 0;
+  bool playing = false;
+  int active_id = -1;
+  PlaylistSequence::ShuffleMode shuffle_mode = PlaylistSequence::Shuffle_Off;
+  PlaylistSequence::RepeatMode repeat_mode = PlaylistSequence::Repeat_Off;
+  if (!MainThread::Run([&]() {
+        has_item = player->GetCurrentItem() != nullptr;
+        volume = player->GetVolume();
+        playing = player->engine()->state() == Engine::Playing;
+        active_id = playlist_manager->active_id();
+        shuffle_mode = playlist_manager->sequence()->shuffle_mode();
+        repeat_mode = playlist_manager->sequence()->repeat_mode();
+      })) {
+    return;
+  }
+
   // First Send the current song
-  PlaylistItemPtr item = player->GetCurrentItem();
-  if (!item) {
+  if (!has_item) {
     qLog(Info) << "No current item found!";
   }
 
   CurrentSongChanged(current_song_, current_uri_, current_image_);
 
   // then the current volume
-  VolumeChanged(player->GetVolume());
+  VolumeChanged(volume);
 
   // Check if we need to start the track position timer
-  if (!track_position_timer_->isActive() &&
-      player->engine()->state() == Engine::Playing) {
+  if (!track_position_timer_->isActive() && playing) {
     track_position_timer_->start(1000);
   }
 
@@ -325,12 +386,12 @@ void OutgoingDataCreator::SendFirstData(bool send_playlist_songs) {
 
   // Send the tracks of the active playlist
   if (send_playlist_songs) {
-    SendPlaylistSongs(app_->playlist_manager()->active_id());
+    SendPlaylistSongs(active_id);
   }
 
   // Send the current random and repeat mode
-  SendShuffleMode(app_->playlist_manager()->sequence()->shuffle_mode());
-  SendRepeatMode(app_->playlist_manager()->sequence()->repeat_mode());
+  SendShuffleMode(shuffle_mode);
+  SendRepeatMode(repeat_mode);
 
   // We send all first data
   cpb::remote::Message msg;
@@ -357,11 +418,21 @@ void OutgoingDataCreator::SendSongMetadata() {
   msg.set_type(cpb::remote::CURRENT_METAINFO);
 
   // If there is no song, create an empty node, otherwise fill it with data
-  int i = app_->playlist_manager()->active()->current_row();
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  int i = MainThread::Get<int>([playlist_manager]() {
+    return playlist_manager->active()->current_row();
+  });
   CreateSong(current_song_, current_image_, i,
              msg.mutable_response_current_metadata()->mutable_song_metadata());
 
-  SendDataToClients(&msg);
+  // Clients that cache art only get the hash, and ask for covers they don't
+  // have yet.
+  cpb::remote::Message without_art = msg;
+  without_art.mutable_response_current_metadata()
+      ->mutable_song_metadata()
+      ->clear_art();
+
+  SendDataToClients(&msg, &without_art);
 }
 
 void OutgoingDataCreator::CreateSong(const Song& song, const QImage& art,
@@ -396,22 +467,33 @@ void OutgoingDataCreator::CreateSong(const Song& song, const QImage& art,
 
     // Append coverart
     if (!art.isNull()) {
-      QImage small;
-      // Check if we resize the image
-      if (art.width() > 1000 || art.height() > 1000) {
-        small = art.scaled(1000, 1000, Qt::KeepAspectRatio);
-      } else {
-        small = art;
-      }
+      QMutexLocker l(&sEncodedArtMutex);
+      if (art.cacheKey() != sEncodedArtKey) {
+        QImage small;
+        // Check if we resize the image
+        if (art.width() > 1000 || art.height() > 1000) {
+          small = art.scaled(1000, 1000, Qt::KeepAspectRatio);
+        } else {
+          small = art;
+        }
 
-      // Read the image in a buffer and compress it
-      QByteArray data;
-      QBuffer buf(&data);
-      buf.open(QIODevice::WriteOnly);
-      small.save(&buf, "JPG");
+        // Read the image in a buffer and compress it
+        sEncodedArt.clear();
+        QBuffer buf(&sEncodedArt);
+        buf.open(QIODevice::WriteOnly);
+        small.save(&buf, "JPG");
+        sEncodedArtKey = art.cacheKey();
+
+        sEncodedArtHash = QString::fromLatin1(
+            QCryptographicHash::hash(sEncodedArt, QCryptographicHash::Sha1)
+                .toHex());
+        sArtByHash.insert(sEncodedArtHash, new QByteArray(sEncodedArt),
+                          sEncodedArt.size());
+      }
 
       // Append the Data in the protocol buffer
-      song_metadata->set_art(data.constData(), data.size());
+      song_metadata->set_art(sEncodedArt.constData(), sEncodedArt.size());
+      song_metadata->set_art_hash(DataCommaSizeFromQString(sEncodedArtHash));
     }
   }
 }
@@ -425,9 +507,18 @@ void OutgoingDataCreator::VolumeChanged(int volume) {
 }
 
 void OutgoingDataCreator::SendPlaylistSongs(int id) {
-  // Get the PlaylistQByteArray(data.data(), data.size()
-  Playlist* playlist = app_->playlist_manager()->playlist(id);
-  if (!playlist) {
+  // Only the songs are copied in the main thread, the message is made here.
+  bool found = false;
+  SongList song_list;
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  MainThread::Run([&]() {
+    Playlist* playlist = playlist_manager->playlist(id);
+    if (!playlist) return;
+    found = true;
+    playlist->RestoreBlocking();
+    song_list = playlist->GetAllSongs();
+  });
+  if (!found) {
     qLog(Info) << "Could not find playlist with id = " << id;
     return;
   }
@@ -447,7 +538,6 @@ void OutgoingDataCreator::SendPlaylistSongs(int id) {
 
   // Send all songs
   int index = 0;
-  SongList song_list = playlist->GetAllSongs();
   QListIterator<Song> it(song_list);
   QImage null_img;
   while (it.hasNext()) {
@@ -558,7 +648,9 @@ void OutgoingDataCreator::UpdateTrackPosition() {
   cpb::remote::Message msg;
   msg.set_type(cpb::remote::UPDATE_TRACK_POSITION);
 
-  qint64 position_nanosec = app_->player()->engine()->position_nanosec();
+  Player* player = app_->player();
+  qint64 position_nanosec = MainThread::Get<qint64>(
+      [player]() { return player->engine()->position_nanosec(); });
   int position = static_cast<int>(
       std::floor(static_cast<double>(position_nanosec) / kNsecPerSec + 0.5));
 
@@ -625,48 +717,116 @@ void OutgoingDataCreator::SendLibrary(RemoteClient* client) {
   // Detach the database
   app_->database()->DetachDatabase("songs_export");
 
-  // Open the file
-  QFile file(temp_file_name);
+  SendLibraryFile(client, temp_file_name,
+                  cpb::remote::ResponseLibraryChunk());
+}
+
+void OutgoingDataCreator::SendLibraryChanges(RemoteClient* client,
+                                             qint64 since_revision) {
+  QString temp_file_name = Utilities::GetTemporaryFileName();
+
+  Database::AttachedDatabase adb(temp_file_name, "", true);
+  QSqlDatabase db(app_->database()->Connect());
+
+  // Taken before anything is copied, so a change made while we copy is sent
+  // again next time rather than missed.
+  QSqlQuery revision_query(db);
+  revision_query.exec("SELECT IFNULL(MAX(revision), 0) FROM songs_sync");
+  if (app_->database()->CheckErrors(revision_query)) return;
+  revision_query.next();
+  const qint64 revision = revision_query.value(0).toLongLong();
+
+  // A revision from the future means the database was made again since the
+  // client last synced, so it has to start over.
+  if (since_revision < 0 || since_revision > revision) since_revision = 0;
+
+  app_->database()->AttachDatabaseOnDbConnection("songs_export", adb, db);
+
+  // The revision is an integer so it's safe to put straight in the query.
+  // Songs that went unavailable are deleted as far as the client knows.
+  const QString since = QString::number(since_revision);
+  QStringList commands;
+  if (since_revision == 0) {
+    commands << "CREATE TABLE songs_export.songs AS"
+                " SELECT ROWID AS song_id, * FROM songs"
+                " WHERE unavailable = 0"
+             << "CREATE TABLE songs_export.deleted_songs (song_id INTEGER)";
+  } else {
+    commands << QString(
+                    "CREATE TABLE songs_export.songs AS"
+                    " SELECT songs.ROWID AS song_id, songs.* FROM songs"
+                    " JOIN songs_sync ON songs_sync.song_id = songs.ROWID"
+                    " WHERE songs_sync.revision > %1"
+                    " AND songs.unavailable = 0")
+                    .arg(since)
+             << QString(
+                    "CREATE TABLE songs_export.deleted_songs AS"
+                    " SELECT songs_sync.song_id AS song_id FROM songs_sync"
+                    " LEFT JOIN songs ON songs.ROWID = songs_sync.song_id"
+                    " WHERE songs_sync.revision > %1"
+                    " AND (songs_sync.deleted = 1 OR songs.unavailable = 1)")
+                    .arg(since);
+  }
+
+  for (const QString& command : commands) {
+    QSqlQuery q(command, db);
+    if (app_->database()->CheckErrors(q)) {
+      app_->database()->DetachDatabase("songs_export");
+      QFile::remove(temp_file_name);
+      return;
+    }
+  }
+
+  app_->database()->DetachDatabase("songs_export");
+
+  qLog(Debug) << "Sending library changes from revision" << since_revision
+              << "to" << revision;
+
+  cpb::remote::ResponseLibraryChunk header;
+  header.set_revision(revision);
+  header.set_since_revision(since_revision);
+  SendLibraryFile(client, temp_file_name, header);
+}
+
+void OutgoingDataCreator::SendLibraryFile(
+    RemoteClient* client, const QString& file_name,
+    const cpb::remote::ResponseLibraryChunk& header) {
+  // The file goes when the transfer is done, or the client goes away.
+  std::shared_ptr<QFile> file(new QFile(file_name), [](QFile* file) {
+    file->remove();
+    delete file;
+  });
 
   // Get the sha1 hash
-  QByteArray sha1 = Utilities::Sha1File(file).toHex();
+  const QByteArray sha1 = Utilities::Sha1File(*file).toHex();
   qLog(Debug) << "Library sha1" << sha1;
 
-  file.open(QIODevice::ReadOnly);
-
-  QByteArray data;
-  cpb::remote::Message msg;
-  cpb::remote::ResponseLibraryChunk* chunk =
-      msg.mutable_response_library_chunk();
-  msg.set_type(cpb::remote::LIBRARY_CHUNK);
+  file->open(QIODevice::ReadOnly);
 
   // Calculate the number of chunks
-  int chunk_count = qRound((file.size() / kFileChunkSize) + 0.5);
-  int chunk_number = 1;
+  const int chunk_count = qRound((file->size() / kFileChunkSize) + 0.5);
+  std::shared_ptr<int> chunk_number(new int(1));
+
+  // The chunks are read as the client takes them.
+  client->SendBulk([=](cpb::remote::Message* msg) {
+    if (file->atEnd()) return false;
 
-  while (!file.atEnd()) {
     // Read file chunk
-    data = file.read(kFileChunkSize);
+    const QByteArray data = file->read(kFileChunkSize);
+
+    msg->set_type(cpb::remote::LIBRARY_CHUNK);
+    cpb::remote::ResponseLibraryChunk* chunk =
+        msg->mutable_response_library_chunk();
 
     // Set chunk data
+    chunk->CopyFrom(header);
     chunk->set_chunk_count(chunk_count);
-    chunk->set_chunk_number(chunk_number);
-    chunk->set_size(file.size());
+    chunk->set_chunk_number((*chunk_number)++);
+    chunk->set_size(file->size());
     chunk->set_data(data.data(), data.size());
     chunk->set_file_hash(sha1.data(), sha1.size());
-
-    // Send data directly to the client
-    client->SendData(&msg);
-
-    // Clear working data
-    chunk->Clear();
-    data.clear();
-
-    chunk_number++;
-  }
-
-  // Remove temporary file
-  file.remove();
+    return true;
+  });
 }
 
 void OutgoingDataCreator::EnableKittens(bool aww) { aww_ = aww; }
@@ -757,8 +917,8 @@ void OutgoingDataCreator::SearchFinished(int id) {
   qLog(Debug) << "SearchFinished" << req.id_ << req.query_;
 }
 
-void OutgoingDataCreator::SendListFiles(QString relative_path,
-                                        RemoteClient* client) {
+void OutgoingDataCreator::SendListFiles(QString relative_path, int offset,
+                                        int limit, RemoteClient* client) {
   cpb::remote::Message msg;
   msg.set_type(cpb::remote::LIST_FILES);
   cpb::remote::ResponseListFiles* files = msg.mutable_response_list_files();
@@ -789,15 +949,59 @@ void OutgoingDataCreator::SendListFiles(QString relative_path,
       files->set_relative_path(
           root_dir.relativeFilePath(fi_folder.absoluteFilePath())
               .toStdString());
-      QDir dir(fi_folder.absoluteFilePath());
-      dir.setFilter(QDir::NoDotAndDotDot | QDir::AllEntries);
-      dir.setSorting(QDir::Name | QDir::DirsFirst);
-
-      for (const QFileInfo& fi : dir.entryInfoList()) {
-        if (fi.isDir() || files_music_extensions_.contains(fi.suffix())) {
-          cpb::remote::FileMetadata* pb_file = files->add_files();
-          pb_file->set_is_dir(fi.isDir());
-          pb_file->set_filename(fi.fileName().toStdString());
+
+      const QString path = fi_folder.absoluteFilePath();
+      QFileInfoList entries;
+      const FileListing* cached = file_listings_.object(path);
+      if (cached && cached->mtime_ == fi_folder.lastModified()) {
+        entries = cached->files_;
+      } else {
+        QDir dir(path);
+        dir.setFilter(QDir::NoDotAndDotDot | QDir::AllEntries);
+        dir.setSorting(QDir::Name | QDir::DirsFirst);
+        for (const QFileInfo& fi : dir.entryInfoList()) {
+          if (fi.isDir() || files_music_extensions_.contains(fi.suffix())) {
+            entries << fi;
+          }
+        }
+
+        FileListing* listing = new FileListing;
+        listing->mtime_ = fi_folder.lastModified();
+        listing->files_ = entries;
+        file_listings_.insert(path, listing, qMax(1, entries.count()));
+      }
+
+      const int total = entries.count();
+      const int begin = qBound(0, offset, total);
+      const int end = limit > 0 ? qMin(total, begin + limit) : total;
+      files->set_offset(begin);
+      files->set_total_count(total);
+
+      // Only the library songs of the files being sent are looked up.
+      QList<QUrl> urls;
+      for (int i = begin; i < end; ++i) {
+        const QFileInfo& fi = entries[i];
+        if (!fi.isDir()) urls << QUrl::fromLocalFile(fi.absoluteFilePath());
+      }
+      QMap<QUrl, Song> songs;
+      if (!urls.isEmpty()) {
+        for (const Song& song : app_->library_backend()->GetSongsByUrls(urls)) {
+          if (!songs.contains(song.url())) songs[song.url()] = song;
+        }
+      }
+
+      for (int i = begin; i < end; ++i) {
+        const QFileInfo& fi = entries[i];
+        cpb::remote::FileMetadata* pb_file = files->add_files();
+        pb_file->set_is_dir(fi.isDir());
+        pb_file->set_filename(fi.fileName().toStdString());
+
+        if (!fi.isDir()) {
+          const Song song =
+              songs.value(QUrl::fromLocalFile(fi.absoluteFilePath()));
+          if (song.is_valid()) {
+            CreateSong(song, QImage(), i, pb_file->mutable_song_metadata());
+          }
         }
       }
     }
@@ -824,3 +1028,19 @@ void OutgoingDataCreator::SendSavedRadios(RemoteClient* client) {
   }
   client->SendData(&msg);
 }
+
+void OutgoingDataCreator::SendArt(RemoteClient* client,
+                                  const QString& art_hash) {
+  cpb::remote::Message msg;
+  msg.set_type(cpb::remote::ART);
+
+  cpb::remote::ResponseArt* response = msg.mutable_response_art();
+  response->set_art_hash(DataCommaSizeFromQString(art_hash));
+  {
+    QMutexLocker l(&sEncodedArtMutex);
+    const QByteArray* art = sArtByHash.object(art_hash);
+    if (art) response->set_art(art->constData(), art->size());
+  }
+
+  client->SendData(&msg);
+}
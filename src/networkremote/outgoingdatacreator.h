@@ -1,6 +1,9 @@
 #ifndef OUTGOINGDATACREATOR_H
 #define OUTGOINGDATACREATOR_H
 
+#include <QCache>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QImage>
 #include <QList>
 #include <QMap>
@@ -52,6 +55,7 @@ class OutgoingDataCreator : public QObject {
   }
   void SetMusicExtensions(const QStringList& files_music_extensions) {
     files_music_extensions_ = files_music_extensions;
+    file_listings_.clear();
   }
   void SetAllowDownloads(bool allow_downloads) {
     allow_downloads_ = allow_downloads;
@@ -84,6 +88,7 @@ class OutgoingDataCreator : public QObject {
   void GetLyrics();
   void SendLyrics(int id, const SongInfoFetcher::Result& result);
   void SendLibrary(RemoteClient* client);
+  void SendLibraryChanges(RemoteClient* client, qint64 since_revision);
   void EnableKittens(bool aww);
   void SendKitten(const QImage& kitten);
 
@@ -91,8 +96,12 @@ class OutgoingDataCreator : public QObject {
   void ResultsAvailable(int id, const SearchProvider::ResultList& results);
   void SearchFinished(int id);
 
-  void SendListFiles(QString relative_path, RemoteClient* client);
+  // Sends limit entries of the directory from offset, or all of them if limit
+  // is 0.
+  void SendListFiles(QString relative_path, int offset, int limit,
+                     RemoteClient* client);
   void SendSavedRadios(RemoteClient* client);
+  void SendArt(RemoteClient* client, const QString& art_hash);
 
  private:
   Application* app_;
@@ -116,7 +125,21 @@ class OutgoingDataCreator : public QObject {
 
   QMap<int, GlobalSearchRequest> global_search_result_map_;
 
-  void SendDataToClients(cpb::remote::Message* msg);
+  // A directory's music files and subdirectories, sorted the way they're
+  // sent.  Kept until the directory changes, remotes often ask again.
+  struct FileListing {
+    QDateTime mtime_;
+    QFileInfoList files_;
+  };
+  QCache<QString, FileListing> file_listings_;
+
+  // Clients that asked for art by hash get without_art instead, if it's set.
+  void SendDataToClients(cpb::remote::Message* msg,
+                         cpb::remote::Message* without_art = nullptr);
+  // Queues the file to go to the client in chunks, each a copy of header
+  // with the data filled in, and removes it once it's sent.
+  void SendLibraryFile(RemoteClient* client, const QString& file_name,
+                       const cpb::remote::ResponseLibraryChunk& header);
   void SetEngineState(cpb::remote::ResponseClementineInfo* msg);
   void CheckEnabledProviders();
   SongInfoProvider* ProviderByName(const QString& name) const;
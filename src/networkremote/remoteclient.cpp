@@ -18,20 +18,87 @@
 #include "remoteclient.h"
 
 #include <QDataStream>
+#include <QHostAddress>
 #include <QSettings>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#endif
 
 #include "core/logging.h"
 #include "networkremote.h"
 
+const int RemoteClient::kCompressionThreshold = 512;
+const quint32 RemoteClient::kCompressedFlag = 0x80000000;
+const qint64 RemoteClient::kHighWatermark = 1024 * 1024;
+const qint64 RemoteClient::kLowWatermark = 256 * 1024;
+const qint64 RemoteClient::kMaxQueuedBytes = 32 * 1024 * 1024;
+
+namespace {
+// How much of a raw file is written before going back to the event loop.
+const qint64 kRawFileChunk = 1024 * 1024;
+// The incoming buffer is let go of after a message bigger than this.
+const int kMaxKeptBufferSize = 1024 * 1024;
+}  // namespace
+
+const QByteArray& OutgoingMessage::Frame(
+    cpb::remote::Compression compression) {
+  if (frames_.contains(compression)) return frames_[compression];
+
+  // Set the default version
+  msg_->set_version(msg_->default_instance().version());
+
+  // The info message tells each client the compression it gets.
+  if (msg_->has_response_clementine_info()) {
+    msg_->mutable_response_clementine_info()->set_compression(compression);
+  }
+
+  // Serialize the message
+  std::string data = msg_->SerializeAsString();
+  quint32 flags = 0;
+
+  // Song files are compressed already, it's not worth trying again.
+  if (compression == cpb::remote::CompressionDeflate &&
+      static_cast<int>(data.length()) >= RemoteClient::kCompressionThreshold &&
+      msg_->type() != cpb::remote::SONG_FILE_CHUNK) {
+    // qCompress puts the length of the uncompressed data in front.
+    QByteArray compressed = qCompress(
+        reinterpret_cast<const uchar*>(data.data()), data.length());
+    if (compressed.size() < static_cast<int>(data.length())) {
+      data.assign(compressed.constData(), compressed.size());
+      flags = RemoteClient::kCompressedFlag;
+    }
+  }
+
+  // The length of the data goes first
+  QByteArray& ret = frames_[compression];
+  ret.reserve(data.length() + 4);
+  QDataStream s(&ret, QIODevice::WriteOnly);
+  s << quint32(data.length() | flags);
+  ret.append(data.data(), data.length());
+  return ret;
+}
+
 RemoteClient::RemoteClient(Application* app, QTcpSocket* client)
     : app_(app),
       downloader_(false),
+      raw_song_files_(false),
+      art_by_hash_(false),
+      compression_(cpb::remote::CompressionNone),
       client_(client),
-      song_sender_(new SongSender(app, this)) {
+      song_sender_(new SongSender(app, this)),
+      queued_bytes_(0),
+      raw_notifier_(nullptr) {
   reading_protobuf_ = false;
+  expected_compressed_ = false;
+  buffer_used_ = 0;
 
   // Connect to the slot IncomingData when receiving data
   connect(client, SIGNAL(readyRead()), this, SLOT(IncomingData()));
+  connect(client, SIGNAL(bytesWritten(qint64)), this, SLOT(BytesWritten()));
 
   // Check if we use auth code
   QSettings s;
@@ -52,6 +119,9 @@ RemoteClient::RemoteClient(Application* app, QTcpSocket* client)
 }
 
 RemoteClient::~RemoteClient() {
+  // Bulk sources can hold files open.
+  ClearQueue();
+
   client_->close();
   if (client_->state() == QAbstractSocket::ConnectedState)
     client_->waitForDisconnected(2000);
@@ -74,6 +144,9 @@ void RemoteClient::IncomingData() {
       QDataStream s(client_);
       s >> expected_length_;
 
+      expected_compressed_ = expected_length_ & kCompressedFlag;
+      expected_length_ &= ~kCompressedFlag;
+
       // Receiving more than 128mb is very unlikely
       // Flush the data and disconnect the client
       if (expected_length_ > 134217728) {
@@ -83,20 +156,50 @@ void RemoteClient::IncomingData() {
         return;
       }
 
+      if (buffer_.size() < static_cast<qint32>(expected_length_)) {
+        buffer_.resize(expected_length_);
+      }
+      buffer_used_ = 0;
       reading_protobuf_ = true;
     }
 
     // Read some of the message
-    buffer_.append(
-        client_->read(static_cast<qint32>(expected_length_) - buffer_.size()));
+    const qint64 read = client_->read(buffer_.data() + buffer_used_,
+                                      expected_length_ - buffer_used_);
+    if (read < 0) {
+      client_->close();
+      return;
+    }
+    buffer_used_ += read;
 
     // Did we get everything?
-    if (buffer_.size() == static_cast<qint32>(expected_length_)) {
+    if (buffer_used_ == static_cast<qint32>(expected_length_)) {
+      // Only the start of buffer_ is this message.
+      const QByteArray buffer =
+          QByteArray::fromRawData(buffer_.constData(), buffer_used_);
+
       // Parse the message
-      ParseMessage(buffer_);
+      if (expected_compressed_) {
+        // qUncompress wants the same 4 byte length in front that we have.
+        // It's held to the same limit as an uncompressed message.
+        QDataStream length_stream(buffer);
+        quint32 uncompressed_length = 0;
+        length_stream >> uncompressed_length;
+        const QByteArray data = uncompressed_length <= 134217728
+                                    ? qUncompress(buffer)
+                                    : QByteArray();
+        if (data.isEmpty()) {
+          qLog(Debug) << "Received invalid compressed data, disconnect client";
+          client_->close();
+          return;
+        }
+        ParseMessage(data);
+      } else {
+        ParseMessage(buffer);
+      }
 
-      // Clear the buffer
-      buffer_.clear();
+      // The buffer is kept for the next message, unless it's grown big.
+      if (buffer_.size() > kMaxKeptBufferSize) buffer_.clear();
       reading_protobuf_ = false;
     }
   }
@@ -120,7 +223,10 @@ void RemoteClient::ParseMessage(const QByteArray& data) {
 
   if (msg.type() == cpb::remote::CONNECT) {
     setDownloader(msg.request_connect().downloader());
+    raw_song_files_ = msg.request_connect().raw_song_files();
+    art_by_hash_ = msg.request_connect().art_by_hash();
     qDebug() << "Downloader" << downloader_;
+    ChooseCompression(msg.request_connect());
   }
 
   // Check if downloads are allowed
@@ -145,51 +251,214 @@ void RemoteClient::ParseMessage(const QByteArray& data) {
   emit Parse(msg);
 }
 
+void RemoteClient::ChooseCompression(
+    const cpb::remote::RequestConnect& request) {
+  compression_ = cpb::remote::CompressionNone;
+  for (int compression : request.compression()) {
+    if (compression == cpb::remote::CompressionDeflate) {
+      compression_ = cpb::remote::CompressionDeflate;
+    }
+  }
+}
+
 void RemoteClient::DisconnectClient(cpb::remote::ReasonDisconnect reason) {
   cpb::remote::Message msg;
   msg.set_type(cpb::remote::DISCONNECT);
 
   msg.mutable_response_disconnect()->set_reason_disconnect(reason);
-  SendDataToClient(&msg);
+
+  // Nothing else matters now, so this goes before anything still queued.
+  ClearQueue();
+  if (client_->state() == QTcpSocket::ConnectedState) {
+    client_->write(OutgoingMessage(&msg).Frame(compression_));
+  }
 
   // Just close the connection. The next time the outgoing data creator
   // sends a keep alive, the client will be deleted
   client_->close();
 }
 
-// Sends data to client without check if authenticated
-void RemoteClient::SendDataToClient(cpb::remote::Message* msg) {
-  // Set the default version
-  msg->set_version(msg->default_instance().version());
+bool RemoteClient::IsLatestState(cpb::remote::MsgType type) {
+  switch (type) {
+    case cpb::remote::UPDATE_TRACK_POSITION:
+    case cpb::remote::SET_VOLUME:
+    case cpb::remote::CURRENT_METAINFO:
+    case cpb::remote::KEEP_ALIVE:
+      return true;
+    default:
+      return false;
+  }
+}
 
+// Sends data to client without check if authenticated
+void RemoteClient::SendDataToClient(OutgoingMessage* msg) {
   // Check if we are still connected
-  if (client_->state() == QTcpSocket::ConnectedState) {
-    // Serialize the message
-    std::string data = msg->SerializeAsString();
-
-    // write the length of the data first
-    QDataStream s(client_);
-    s << qint32(data.length());
-    if (downloader_) {
-      // Don't use QDataSteam for large files
-      client_->write(data.data(), data.length());
-    } else {
-      s.writeRawData(data.data(), data.length());
-    }
-
-    // Do NOT flush data here! If the client is already disconnected, it
-    // causes a SIGPIPE termination!!!
-  } else {
+  if (client_->state() != QTcpSocket::ConnectedState) {
     qDebug() << "Closed";
     client_->close();
+    return;
+  }
+
+  if (IsLatestState(msg->type())) {
+    // Only the newest one of these is worth sending.
+    latest_state_[msg->type()] = msg->Frame(compression_);
+  } else {
+    QueuedMessage queued;
+    queued.data_ = msg->Frame(compression_);
+    queued_bytes_ += queued.data_.size();
+    queue_.enqueue(queued);
+
+    if (queued_bytes_ > kMaxQueuedBytes) {
+      qLog(Warning) << "Network remote client isn't keeping up, disconnecting"
+                    << client_->peerAddress().toString();
+      ClearQueue();
+      client_->abort();
+      return;
+    }
   }
+
+  Flush();
 }
 
 void RemoteClient::SendData(cpb::remote::Message* msg) {
+  OutgoingMessage outgoing(msg);
+  SendData(&outgoing);
+}
+
+void RemoteClient::SendData(OutgoingMessage* msg) {
   // Check if client is authenticated before sending the data
   if (authenticated_) {
     SendDataToClient(msg);
   }
 }
 
+void RemoteClient::SendBulk(BulkSource source) {
+  if (!authenticated_ || client_->state() != QTcpSocket::ConnectedState) {
+    return;
+  }
+
+  QueuedMessage queued;
+  queued.bulk_ = source;
+  queue_.enqueue(queued);
+  Flush();
+}
+
+void RemoteClient::SendRawFile(cpb::remote::Message* header,
+                               std::shared_ptr<QFile> file) {
+  if (!authenticated_ || client_->state() != QTcpSocket::ConnectedState) {
+    return;
+  }
+
+  QueuedMessage queued_header;
+  queued_header.data_ = OutgoingMessage(header).Frame(compression_);
+  queued_bytes_ += queued_header.data_.size();
+  queue_.enqueue(queued_header);
+
+  QueuedMessage queued;
+  queued.file_ = file;
+  queue_.enqueue(queued);
+  Flush();
+}
+
+void RemoteClient::RawWritable() {
+  raw_notifier_->setEnabled(false);
+  Flush();
+}
+
+bool RemoteClient::WriteRawFile(QueuedMessage* queued) {
+  QFile* file = queued->file_.get();
+  const qint64 length =
+      qMin(kRawFileChunk, file->size() - queued->file_offset_);
+
+#ifdef Q_OS_LINUX
+  // sendfile goes around the socket's own buffer, so that has to be empty
+  // first.  Its bytesWritten calls Flush again once it is.
+  if (client_->bytesToWrite() > 0) return false;
+
+  if (!raw_notifier_) {
+    raw_notifier_ = new QSocketNotifier(client_->socketDescriptor(),
+                                        QSocketNotifier::Write, this);
+    connect(raw_notifier_, SIGNAL(activated(int)), SLOT(RawWritable()));
+  }
+
+  off_t offset = queued->file_offset_;
+  const ssize_t written =
+      sendfile(client_->socketDescriptor(), file->handle(), &offset, length);
+  if (written < 0 && errno != EAGAIN && errno != EINTR) {
+    qLog(Warning) << "Couldn't send" << file->fileName() << strerror(errno);
+    client_->abort();
+    return false;
+  }
+  if (written > 0) queued->file_offset_ += written;
+
+  // Carry on when the socket has room again, rather than keep the event loop
+  // busy for the whole file.
+  raw_notifier_->setEnabled(true);
+  return false;
+#else
+  // Elsewhere the data is still read, but not copied into a protobuf.
+  const QByteArray data =
+      file->seek(queued->file_offset_) ? file->read(length) : QByteArray();
+  if (data.isEmpty()) {
+    qLog(Warning) << "Couldn't send" << file->fileName();
+    client_->abort();
+    return false;
+  }
+  client_->write(data);
+  queued->file_offset_ += data.size();
+  return true;
+#endif
+}
+
+void RemoteClient::BytesWritten() {
+  // Waiting for the buffer to drain a bit means writing in bigger batches.
+  if (client_->bytesToWrite() <= kLowWatermark) Flush();
+}
+
+void RemoteClient::Flush() {
+  // Do NOT flush the socket here! If the client is already disconnected, it
+  // causes a SIGPIPE termination!!!
+  while (client_->state() == QTcpSocket::ConnectedState &&
+         client_->bytesToWrite() < kHighWatermark) {
+    // Nothing can go in the middle of a raw file.
+    const bool in_raw_file =
+        !queue_.isEmpty() && queue_.head().file_ && queue_.head().file_offset_;
+
+    if (!latest_state_.isEmpty() && !in_raw_file) {
+      client_->write(latest_state_.take(latest_state_.firstKey()));
+      continue;
+    }
+
+    if (queue_.isEmpty()) break;
+    QueuedMessage& head = queue_.head();
+
+    if (head.file_) {
+      if (head.file_offset_ >= head.file_->size()) {
+        queue_.dequeue();
+      } else if (!WriteRawFile(&head)) {
+        break;
+      }
+    } else if (head.bulk_) {
+      // Bulk sources only make a message when there's room for it, so a
+      // whole file never sits in memory.
+      cpb::remote::Message msg;
+      if (head.bulk_(&msg)) {
+        client_->write(OutgoingMessage(&msg).Frame(compression_));
+      } else {
+        queue_.dequeue();
+      }
+    } else {
+      client_->write(head.data_);
+      queued_bytes_ -= head.data_.size();
+      queue_.dequeue();
+    }
+  }
+}
+
+void RemoteClient::ClearQueue() {
+  queue_.clear();
+  latest_state_.clear();
+  queued_bytes_ = 0;
+}
+
 QAbstractSocket::SocketState RemoteClient::State() { return client_->state(); }
@@ -1,23 +1,73 @@
 #ifndef REMOTECLIENT_H
 #define REMOTECLIENT_H
 
+#include <QMap>
+#include <QQueue>
+#include <QFile>
 #include <QTcpSocket>
+#include <functional>
+#include <memory>
 
 #include "core/application.h"
 #include "remotecontrolmessages.pb.h"
 #include "songsender.h"
 
+// A message going to several clients.  It's serialised the first time it's
+// sent, then again only for clients that use a different compression.
+class OutgoingMessage {
+ public:
+  explicit OutgoingMessage(cpb::remote::Message* msg) : msg_(msg) {}
+
+  cpb::remote::MsgType type() const { return msg_->type(); }
+
+  // The message with its length prefix, compressed if it's worth it.
+  const QByteArray& Frame(cpb::remote::Compression compression);
+
+ private:
+  cpb::remote::Message* msg_;
+  QMap<int, QByteArray> frames_;
+};
+
+class QSocketNotifier;
+
 class RemoteClient : public QObject {
   Q_OBJECT
  public:
   RemoteClient(Application* app, QTcpSocket* client);
   ~RemoteClient();
 
+  // Messages smaller than this are never compressed.
+  static const int kCompressionThreshold;
+  // Set in the length prefix of compressed messages.
+  static const quint32 kCompressedFlag;
+
+  // Queued messages are written while the socket has less than the high
+  // watermark waiting, and writing starts again when it drains below the
+  // low one.
+  static const qint64 kHighWatermark;
+  static const qint64 kLowWatermark;
+  // A client with more than this queued is too slow and is disconnected.
+  static const qint64 kMaxQueuedBytes;
+
+  // Fills in the next message of a bulk transfer and returns true, or returns
+  // false when there are none left.
+  typedef std::function<bool(cpb::remote::Message*)> BulkSource;
+
   // This method checks if client is authenticated before sending the data
   void SendData(cpb::remote::Message* msg);
+  void SendData(OutgoingMessage* msg);
+  // Queues a transfer that's too big to make all at once.  Its messages are
+  // only made as the socket has room for them, in order with the others.
+  // The source is destroyed when it's done or the client goes away.
+  void SendBulk(BulkSource source);
+  // Queues header followed by the contents of file, not wrapped in anything.
+  // On Linux the file goes to the socket with sendfile.
+  void SendRawFile(cpb::remote::Message* header, std::shared_ptr<QFile> file);
   QAbstractSocket::SocketState State();
   void setDownloader(bool downloader);
   bool isDownloader() { return downloader_; }
+  bool raw_song_files() const { return raw_song_files_; }
+  bool art_by_hash() const { return art_by_hash_; }
   void DisconnectClient(cpb::remote::ReasonDisconnect reason);
 
   SongSender* song_sender() { return song_sender_; }
@@ -29,15 +79,37 @@ class RemoteClient : public QObject {
 
  private slots:
   void IncomingData();
+  void BytesWritten();
+  void RawWritable();
 
  signals:
   void Parse(const cpb::remote::Message& msg);
 
  private:
   void ParseMessage(const QByteArray& data);
+  void ChooseCompression(const cpb::remote::RequestConnect& request);
 
   // Sends data to client without check if authenticated
-  void SendDataToClient(cpb::remote::Message* msg);
+  void SendDataToClient(OutgoingMessage* msg);
+
+  // Messages that describe the current state, so a newer one replaces one
+  // that hasn't been sent yet.
+  static bool IsLatestState(cpb::remote::MsgType type);
+  void Flush();
+  void ClearQueue();
+
+  struct QueuedMessage {
+    QueuedMessage() : file_offset_(0) {}
+
+    QByteArray data_;
+    BulkSource bulk_;
+    std::shared_ptr<QFile> file_;
+    qint64 file_offset_;
+  };
+
+  // Writes some more of a raw file.  Returns false if it has to wait for the
+  // socket, in which case Flush is called again when it can carry on.
+  bool WriteRawFile(QueuedMessage* queued);
 
   Application* app_;
 
@@ -46,13 +118,25 @@ class RemoteClient : public QObject {
   bool authenticated_;
   bool allow_downloads_;
   bool downloader_;
+  bool raw_song_files_;
+  bool art_by_hash_;
+  cpb::remote::Compression compression_;
 
   QTcpSocket* client_;
   bool reading_protobuf_;
   quint32 expected_length_;
+  bool expected_compressed_;
+  // Kept from one message to the next, buffer_used_ bytes of it are filled.
   QByteArray buffer_;
+  int buffer_used_;
   SongSender* song_sender_;
 
+  // Sent before anything in queue_, by message type.
+  QMap<int, QByteArray> latest_state_;
+  QQueue<QueuedMessage> queue_;
+  qint64 queued_bytes_;
+  QSocketNotifier* raw_notifier_;
+
   QString files_root_folder_;
   QStringList files_music_extensions_;
 };
@@ -19,23 +19,29 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
+#include <QSettings>
+#include <memory>
 
 #include "core/application.h"
 #include "core/logging.h"
 #include "core/utilities.h"
 #include "library/librarybackend.h"
+#include "networkremote/mainthread.h"
 #include "networkremote/networkremote.h"
 #include "networkremote/outgoingdatacreator.h"
 #include "networkremote/remoteclient.h"
 #include "playlist/playlistitem.h"
 
 const quint32 SongSender::kFileChunkSize = 100000;  // in Bytes
+const qint64 SongSender::kTranscodeCacheSize = 2ll * 1024 * 1024 * 1024;
 
 SongSender::SongSender(Application* app, RemoteClient* client)
     : app_(app),
       client_(client),
       transcoder_(
-          new Transcoder(this, NetworkRemote::kTranscoderSettingPostfix)) {
+          new Transcoder(this, NetworkRemote::kTranscoderSettingPostfix)),
+      offer_when_sent_(false) {
   QSettings s;
   s.beginGroup(NetworkRemote::kSettingsGroup);
 
@@ -55,7 +61,6 @@ SongSender::SongSender(Application* app, RemoteClient* client)
 
   connect(transcoder_, SIGNAL(JobComplete(QUrl, QString, bool)),
           SLOT(TranscodeJobComplete(QUrl, QString, bool)));
-  connect(transcoder_, SIGNAL(AllJobsComplete()), SLOT(StartTransfer()));
 
   total_transcode_ = 0;
 }
@@ -63,16 +68,18 @@ SongSender::SongSender(Application* app, RemoteClient* client)
 SongSender::~SongSender() {
   disconnect(transcoder_, SIGNAL(JobComplete(QUrl, QString, bool)), this,
              SLOT(TranscodeJobComplete(QUrl, QString, bool)));
-  disconnect(transcoder_, SIGNAL(AllJobsComplete()), this,
-             SLOT(StartTransfer()));
   transcoder_->Cancel();
+
+  // Don't leave half finished files in the cache.
+  for (const QString& output : transcoding_) QFile::remove(output);
 }
 
 void SongSender::SendSongs(const cpb::remote::RequestDownloadSongs& request) {
-  Song current_song;
-  if (app_->player()->GetCurrentItem()) {
-    current_song = app_->player()->GetCurrentItem()->Metadata();
-  }
+  Player* player = app_->player();
+  Song current_song = MainThread::Get<Song>([player]() {
+    PlaylistItemPtr item = player->GetCurrentItem();
+    return item ? item->Metadata() : Song();
+  });
 
   switch (request.download_item()) {
     case cpb::remote::CurrentItem: {
@@ -97,32 +104,82 @@ void SongSender::SendSongs(const cpb::remote::RequestDownloadSongs& request) {
       break;
   }
 
+  // The transfer starts straight away, a song that's still being transcoded
+  // when it's accepted is sent once it's done.
   if (transcode_lossless_files_) {
     TranscodeLosslessFiles();
-  } else {
-    StartTransfer();
   }
+  StartTransfer();
 }
 
 void SongSender::TranscodeLosslessFiles() {
+  QDir().mkpath(Utilities::GetConfigPath(Utilities::Path_TranscodeCache));
+
+  bool started = false;
   for (DownloadItem item : download_queue_) {
     // Check only lossless files
     if (!item.song_.IsFileLossless()) continue;
 
-    // Add the file to the transcoder
-    QUrl local_file = item.song_.url();
+    const QString local_file = item.song_.url().toLocalFile();
+    if (transcoder_map_.contains(local_file) ||
+        transcoding_.contains(local_file)) {
+      continue;
+    }
+    total_transcode_++;
+
+    const QString cached = TranscodeCachePath(local_file);
+    if (QFile::exists(cached)) {
+      qLog(Debug) << "using cached transcode of" << local_file;
+      Utilities::TouchFile(cached);
+      transcoder_map_.insert(local_file, cached);
+      continue;
+    }
 
-    transcoder_->AddTemporaryJob(local_file, transcoder_preset_);
+    // The transcoder runs as many jobs at once as it has threads, in queue
+    // order, so the next songs are ready by the time they're wanted.  Jobs
+    // write to a .part file that's only renamed once it's complete.
+    const QString output = cached + ".part";
+    transcoder_->AddJob(item.song_.url(), transcoder_preset_, output, true);
+    transcoding_.insert(local_file, output);
+    started = true;
 
-    qLog(Debug) << "transcoding" << local_file.toLocalFile();
-    total_transcode_++;
+    qLog(Debug) << "transcoding" << local_file;
   }
 
-  if (total_transcode_ > 0) {
-    transcoder_->Start();
-    SendTranscoderStatus();
-  } else {
-    StartTransfer();
+  if (started) transcoder_->Start();
+  if (total_transcode_ > 0) SendTranscoderStatus();
+}
+
+QString SongSender::TranscodeCachePath(const QString& local_file) const {
+  const QByteArray key =
+      transcoder_->JobKey(QUrl::fromLocalFile(local_file), transcoder_preset_);
+  return QString("%1/%2.%3")
+      .arg(Utilities::GetConfigPath(Utilities::Path_TranscodeCache),
+           QString::fromLatin1(key), transcoder_preset_.extension_);
+}
+
+void SongSender::PruneTranscodeCache() {
+  QDir dir(Utilities::GetConfigPath(Utilities::Path_TranscodeCache));
+  const QFileInfoList files =
+      dir.entryInfoList(QStringList() << "*." + transcoder_preset_.extension_,
+                        QDir::Files, QDir::Time | QDir::Reversed);
+
+  qint64 total = 0;
+  for (const QFileInfo& file : files) total += file.size();
+
+  // Transcodes that are waiting to be sent are kept even if that leaves the
+  // cache over its limit.
+  QSet<QString> in_use;
+  for (const QString& path : transcoder_map_.values()) {
+    in_use.insert(QFileInfo(path).absoluteFilePath());
+  }
+
+  // Least recently used first, files are touched whenever they're sent.
+  for (const QFileInfo& file : files) {
+    if (total <= kTranscodeCacheSize) break;
+    if (in_use.contains(file.absoluteFilePath())) continue;
+    total -= file.size();
+    QFile::remove(file.filePath());
   }
 }
 
@@ -131,12 +188,20 @@ void SongSender::TranscodeJobComplete(const QUrl& input, const QString& output,
   Q_ASSERT(input.isLocalFile());  // songsender only handles local files
   qLog(Debug) << input.toLocalFile() << "transcoded to" << output << success;
 
+  const QString local_file = input.toLocalFile();
+  const QString cached = transcoding_.take(local_file);
+
   // If it wasn't successful send original file
-  if (success) {
-    transcoder_map_.insert(input.toLocalFile(), output);
+  const QString cached_path = cached.left(cached.length() - 5);  // ".part"
+  if (success && !cached.isEmpty() && QFile::rename(output, cached_path)) {
+    transcoder_map_.insert(local_file, cached_path);
+    PruneTranscodeCache();
+  } else {
+    QFile::remove(output);
   }
 
   SendTranscoderStatus();
+  SendReadySongs();
 }
 
 void SongSender::SendTranscoderStatus() {
@@ -222,10 +287,37 @@ void SongSender::ResponseSongOffer(bool accepted) {
 
   // Get the item and send the single song
   DownloadItem item = download_queue_.dequeue();
-  if (accepted) SendSingleSong(item);
 
-  // And offer the next song
-  OfferNextSong();
+  // Clients that take raw files get the next offer first, so they can answer
+  // it while this file arrives and the next one is ready straight after.
+  const bool raw = client_->raw_song_files();
+  if (raw) OfferNextSong();
+
+  if (accepted) pending_sends_.append(item);
+  SendReadySongs();
+
+  // Otherwise the next song is offered once this one has gone.
+  if (!raw) {
+    if (pending_sends_.isEmpty()) {
+      OfferNextSong();
+    } else {
+      offer_when_sent_ = true;
+    }
+  }
+}
+
+void SongSender::SendReadySongs() {
+  // In order, so a song that's still transcoding holds up the ones after it.
+  while (!pending_sends_.isEmpty() &&
+         !transcoding_.contains(
+             pending_sends_.first().song_.url().toLocalFile())) {
+    SendSingleSong(pending_sends_.takeFirst());
+  }
+
+  if (pending_sends_.isEmpty() && offer_when_sent_) {
+    offer_when_sent_ = false;
+    OfferNextSong();
+  }
 }
 
 void SongSender::SendSingleSong(DownloadItem download_item) {
@@ -235,80 +327,91 @@ void SongSender::SendSingleSong(DownloadItem download_item) {
   QString local_file = download_item.song_.url().toLocalFile();
   bool is_transcoded = transcoder_map_.contains(local_file);
 
+  // Transcoded files stay in the cache for next time.
   if (is_transcoded) {
-    local_file = transcoder_map_.take(local_file);
+    local_file = transcoder_map_.value(local_file);
+    Utilities::TouchFile(local_file);
   }
 
-  // Open the file
-  QFile file(local_file);
+  std::shared_ptr<QFile> file(new QFile(local_file));
 
   // Get sha1 for file
-  QByteArray sha1 = Utilities::Sha1File(file).toHex();
+  const QByteArray sha1 = Utilities::Sha1File(*file).toHex();
   qLog(Debug) << "sha1 for file" << local_file << "=" << sha1;
 
-  file.open(QIODevice::ReadOnly);
+  file->open(QIODevice::ReadOnly);
 
-  QByteArray data;
-  cpb::remote::Message msg;
-  cpb::remote::ResponseSongFileChunk* chunk =
-      msg.mutable_response_song_file_chunk();
-  msg.set_type(cpb::remote::SONG_FILE_CHUNK);
+  // The metadata is sent with the first chunk, so the client knows what file
+  // it receives.
+  cpb::remote::SongMetadata song_metadata;
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  int i = MainThread::Get<int>([playlist_manager]() {
+    return playlist_manager->active()->current_row();
+  });
+  OutgoingDataCreator::CreateSong(download_item.song_, QImage(), i,
+                                  &song_metadata);
+
+  // if the file was transcoded, we have to change the filename and filesize
+  if (is_transcoded) {
+    song_metadata.set_file_size(file->size());
+    QString basefilename = download_item.song_.basefilename();
+    QFileInfo info(basefilename);
+    basefilename.replace("." + info.suffix(),
+                         "." + transcoder_preset_.extension_);
+    song_metadata.set_filename(DataCommaSizeFromQString(basefilename));
+  }
+
+  if (client_->raw_song_files()) {
+    // Only the size and hash go in the protobuf, the file follows as it is.
+    cpb::remote::Message msg;
+    msg.set_type(cpb::remote::SONG_FILE_CHUNK);
+    cpb::remote::ResponseSongFileChunk* chunk =
+        msg.mutable_response_song_file_chunk();
+    chunk->set_chunk_count(1);
+    chunk->set_chunk_number(1);
+    chunk->set_file_count(download_item.song_count_);
+    chunk->set_file_number(download_item.song_no_);
+    chunk->set_size(file->size());
+    chunk->set_file_hash(sha1.data(), sha1.size());
+    chunk->mutable_song_metadata()->CopyFrom(song_metadata);
+    chunk->set_raw_data_follows(true);
 
-  QImage null_image;
+    client_->SendRawFile(&msg, file);
+    return;
+  }
 
   // Calculate the number of chunks
-  int chunk_count = qRound((file.size() / kFileChunkSize) + 0.5);
-  int chunk_number = 1;
+  const int chunk_count = qRound((file->size() / kFileChunkSize) + 0.5);
+  std::shared_ptr<int> chunk_number(new int(1));
+
+  // The chunks are read as the client takes them, and the next song offer is
+  // queued after them.
+  client_->SendBulk([=](cpb::remote::Message* msg) {
+    if (file->atEnd()) return false;
 
-  while (!file.atEnd()) {
     // Read file chunk
-    data = file.read(kFileChunkSize);
+    const QByteArray data = file->read(kFileChunkSize);
+
+    msg->set_type(cpb::remote::SONG_FILE_CHUNK);
+    cpb::remote::ResponseSongFileChunk* chunk =
+        msg->mutable_response_song_file_chunk();
 
     // Set chunk data
     chunk->set_chunk_count(chunk_count);
-    chunk->set_chunk_number(chunk_number);
+    chunk->set_chunk_number(*chunk_number);
     chunk->set_file_count(download_item.song_count_);
     chunk->set_file_number(download_item.song_no_);
-    chunk->set_size(file.size());
+    chunk->set_size(file->size());
     chunk->set_data(data.data(), data.size());
     chunk->set_file_hash(sha1.data(), sha1.size());
 
-    // On the first chunk send the metadata, so the client knows
-    // what file it receives.
-    if (chunk_number == 1) {
-      int i = app_->playlist_manager()->active()->current_row();
-      cpb::remote::SongMetadata* song_metadata =
-          msg.mutable_response_song_file_chunk()->mutable_song_metadata();
-      OutgoingDataCreator::CreateSong(download_item.song_, null_image, i,
-                                      song_metadata);
-
-      // if the file was transcoded, we have to change the filename and filesize
-      if (is_transcoded) {
-        song_metadata->set_file_size(file.size());
-        QString basefilename = download_item.song_.basefilename();
-        QFileInfo info(basefilename);
-        basefilename.replace("." + info.suffix(),
-                             "." + transcoder_preset_.extension_);
-        song_metadata->set_filename(DataCommaSizeFromQString(basefilename));
-      }
+    if (*chunk_number == 1) {
+      chunk->mutable_song_metadata()->CopyFrom(song_metadata);
     }
 
-    // Send data directly to the client
-    client_->SendData(&msg);
-
-    // Clear working data
-    chunk->Clear();
-    data.clear();
-
-    chunk_number++;
-  }
-
-  // If the file was transcoded, delete the temporary one
-  if (is_transcoded) {
-    file.remove();
-  } else {
-    file.close();
-  }
+    (*chunk_number)++;
+    return true;
+  });
 }
 
 void SongSender::SendAlbum(const Song& song) {
@@ -326,12 +429,20 @@ void SongSender::SendAlbum(const Song& song) {
 void SongSender::SendPlaylist(
     const cpb::remote::RequestDownloadSongs& request) {
   int playlist_id = request.playlist_id();
-  Playlist* playlist = app_->playlist_manager()->playlist(playlist_id);
-  if (!playlist) {
+  bool found = false;
+  SongList song_list;
+  PlaylistManager* playlist_manager = app_->playlist_manager();
+  MainThread::Run([&]() {
+    Playlist* playlist = playlist_manager->playlist(playlist_id);
+    if (!playlist) return;
+    found = true;
+    playlist->RestoreBlocking();
+    song_list = playlist->GetAllSongs();
+  });
+  if (!found) {
     qLog(Info) << "Could not find playlist with id = " << playlist_id;
     return;
   }
-  SongList song_list = playlist->GetAllSongs();
 
   QList<int> requested_ids;
   for (auto song_id : request.songs_ids()) requested_ids << song_id;
@@ -28,6 +28,8 @@ class SongSender : public QObject {
   ~SongSender();
 
   static const quint32 kFileChunkSize;
+  // Transcoded files are kept for repeated downloads up to this size in total.
+  static const qint64 kTranscodeCacheSize;
 
  public slots:
   void SendSongs(const cpb::remote::RequestDownloadSongs& request);
@@ -47,9 +49,16 @@ class SongSender : public QObject {
   bool transcode_lossless_files_;
 
   QQueue<DownloadItem> download_queue_;
+  // Source files to their transcoded copies that are ready.
   QMap<QString, QString> transcoder_map_;
+  // Source files still being transcoded, to where the output is going.
+  QMap<QString, QString> transcoding_;
   int total_transcode_;
 
+  // Accepted songs waiting for their transcode, in order.
+  QList<DownloadItem> pending_sends_;
+  bool offer_when_sent_;
+
   void SendSingleSong(DownloadItem download_item);
   void SendAlbum(const Song& song);
   void SendPlaylist(const cpb::remote::RequestDownloadSongs& request);
@@ -57,6 +66,9 @@ class SongSender : public QObject {
   void OfferNextSong();
   void SendTotalFileSize();
   void TranscodeLosslessFiles();
+  QString TranscodeCachePath(const QString& local_file) const;
+  void PruneTranscodeCache();
+  void SendReadySongs();
   void SendTranscoderStatus();
 };
 
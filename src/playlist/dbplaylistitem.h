@@ -29,6 +29,7 @@ class DbPlaylistItem : public PlaylistItem {
 
   Song Metadata() const;
   void SetMetadata(const Song& song) { song_ = song; }
+  void InternStrings() { song_.InternStrings(); }
 
   QUrl Url() const;
 
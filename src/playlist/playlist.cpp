@@ -20,19 +20,24 @@
 #include <QApplication>
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QLinkedList>
 #include <QMimeData>
 #include <QMutableListIterator>
 #include <QSortFilterProxyModel>
+#include <QStorageInfo>
+#include <QTimer>
 #include <QUndoStack>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QtDebug>
 #include <algorithm>
 #include <functional>
 #include <memory>
-#include <unordered_map>
+#include <numeric>
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
 #include <QRandomGenerator>
@@ -40,6 +45,7 @@
 
 #include "core/application.h"
 #include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/player.h"
 #include "core/tagreaderclient.h"
@@ -60,6 +66,7 @@
 #include "playlistbackend.h"
 #include "playlistfilter.h"
 #include "playlistitemmimedata.h"
+#include "playlistsortkeys.h"
 #include "playlistundocommands.h"
 #include "playlistview.h"
 #include "queue.h"
@@ -71,9 +78,6 @@
 #include "songplaylistitem.h"
 
 using std::shared_ptr;
-using std::unordered_map;
-using std::placeholders::_1;
-using std::placeholders::_2;
 
 using smart_playlists::Generator;
 using smart_playlists::GeneratorInserter;
@@ -98,18 +102,19 @@ const char* Playlist::kSortIgnorePrefixList = "sort_ignore_prefix_list";
 
 const int Playlist::kUndoStackSize = 20;
 const int Playlist::kUndoItemLimit = 500;
+const qint64 Playlist::kUndoMemoryLimit = 64 * 1024 * 1024;
+const int Playlist::kRowChangeBatchMsec = 16;
+const int Playlist::kMinItemsForBackgroundSort = 5000;
+const int Playlist::kRestoreFirstChunkSize = 100;
+const int Playlist::kRestoreChunkSize = 2000;
 
 const qint64 Playlist::kMinScrobblePointNsecs = 31ll * kNsecPerSec;
 const qint64 Playlist::kMaxScrobblePointNsecs = 240ll * kNsecPerSec;
 
 namespace {
-QString removePrefix(const QString& a, const QStringList& prefixes) {
-  for (const QString& prefix : prefixes) {
-    if (a.startsWith(prefix)) {
-      return a.mid(prefix.size());
-    }
-  }
-  return a;
+QVector<int> SortRows(std::shared_ptr<PlaylistSortKeys> keys,
+                      Qt::SortOrder order) {
+  return keys->Sort(order);
 }
 }  // namespace
 
@@ -133,25 +138,35 @@ Playlist::Playlist(PlaylistBackend* backend, TaskManager* task_manager,
       have_incremented_playcount_(false),
       playlist_sequence_(nullptr),
       ignore_sorting_(false),
+      last_sort_id_(0),
+      queued_row_changes_timer_(new QTimer(this)),
       undo_stack_(new QUndoStack(this)),
       special_type_(special_type),
+      restore_state_(Restore_NotStarted),
+      restore_offset_(0),
+      restore_row_(0),
+      save_pending_(false),
       cancel_restore_(false) {
   undo_stack_->setUndoLimit(kUndoStackSize);
+  connect(undo_stack_, SIGNAL(indexChanged(int)), SLOT(LimitUndoMemory()));
+
+  queued_row_changes_timer_->setSingleShot(true);
+  queued_row_changes_timer_->setInterval(kRowChangeBatchMsec);
+  connect(queued_row_changes_timer_, SIGNAL(timeout()),
+          SLOT(EmitQueuedRowChanges()));
 
   connect(this, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
           SIGNAL(PlaylistChanged()));
   connect(this, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
           SIGNAL(PlaylistChanged()));
 
-  Restore();
-
   proxy_->setSourceModel(this);
   queue_->setSourceModel(this);
 
   connect(queue_, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
           SLOT(TracksAboutToBeDequeued(QModelIndex, int, int)));
   connect(queue_, SIGNAL(rowsRemoved(QModelIndex, int, int)),
-          SLOT(TracksDequeued()));
+          SLOT(TracksDequeued(QModelIndex, int, int)));
 
   connect(queue_, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
           SLOT(TracksEnqueued(const QModelIndex&, int, int)));
@@ -301,7 +316,7 @@ QVariant Playlist::data(const QModelIndex& index, int role) const {
       PlaylistItemPtr item = items_[index.row()];
       Song song = item->Metadata();
 
-      // Don't forget to change Playlist::CompareItems when adding new columns
+      // Don't forget to change PlaylistSortKeys when adding new columns
       switch (index.column()) {
         case Column_Title:
           return song.PrettyTitle();
@@ -416,8 +431,59 @@ QVariant Playlist::data(const QModelIndex& index, int role) const {
 }
 
 void Playlist::MoodbarUpdated(const QModelIndex& index) {
-  emit dataChanged(index.sibling(index.row(), Column_Mood),
-                   index.sibling(index.row(), Column_Mood));
+  QueueRowChanged(index.row(), Column_Mood, Column_Mood);
+}
+
+void Playlist::QueueRowChanged(int row, int first_column, int last_column) {
+  if (row < 0 || row >= items_.count()) return;
+
+  QueuedRowChange change;
+  change.index_ = index(row, 0);
+  change.first_column_ = first_column;
+  change.last_column_ = last_column;
+  queued_row_changes_ << change;
+
+  if (!queued_row_changes_timer_->isActive()) queued_row_changes_timer_->start();
+}
+
+void Playlist::EmitQueuedRowChanges() {
+  // Rows that were removed in the meantime have invalid indexes by now, the
+  // others have moved with any rows inserted before them.
+  QMap<int, QPair<int, int>> columns_by_row;
+  for (const QueuedRowChange& change : queued_row_changes_) {
+    if (!change.index_.isValid()) continue;
+
+    const int row = change.index_.row();
+    auto it = columns_by_row.find(row);
+    if (it == columns_by_row.end()) {
+      columns_by_row.insert(row, qMakePair(change.first_column_,
+                                           change.last_column_));
+    } else {
+      it->first = qMin(it->first, change.first_column_);
+      it->second = qMax(it->second, change.last_column_);
+    }
+  }
+  queued_row_changes_.clear();
+
+  // One signal for each run of neighbouring rows, covering all the columns
+  // that changed in any of them.
+  auto it = columns_by_row.constBegin();
+  while (it != columns_by_row.constEnd()) {
+    const int first_row = it.key();
+    int last_row = first_row;
+    int first_column = it->first;
+    int last_column = it->second;
+
+    for (++it; it != columns_by_row.constEnd() && it.key() == last_row + 1;
+         ++it) {
+      last_row = it.key();
+      first_column = qMin(first_column, it->first);
+      last_column = qMax(last_column, it->second);
+    }
+
+    emit dataChanged(index(first_row, first_column),
+                     index(last_row, last_column));
+  }
 }
 
 bool Playlist::setData(const QModelIndex& index, const QVariant& value,
@@ -449,9 +515,8 @@ void Playlist::SongSaveComplete(TagReaderReply* reply,
                                 const QPersistentModelIndex& index) {
   if (reply->is_successful() && index.isValid()) {
     if (reply->message().save_file_response().success()) {
-      QFuture<void> future = item_at(index.row())->BackgroundReload();
-      NewClosure(future, this, SLOT(ItemReloadComplete(QPersistentModelIndex)),
-                 index);
+      item_at(index.row())
+          ->ReloadAsync(this, [this, index]() { ItemReloadComplete(index); });
     } else {
       emit Error(
           tr("An error occurred writing metadata to '%1'")
@@ -466,6 +531,7 @@ void Playlist::ItemReloadComplete(const QPersistentModelIndex& index) {
   if (index.isValid()) {
     emit dataChanged(index, index);
     emit EditingFinished(index);
+    Save(PlaylistItemList() << item_at(index.row()));
   }
 }
 
@@ -487,9 +553,9 @@ void Playlist::ShuffleModeChanged(PlaylistSequence::ShuffleMode mode) {
 }
 
 bool Playlist::FilterContainsVirtualIndex(int i) const {
-  if (i < 0 || i >= virtual_items_.count()) return false;
+  if (i < 0 || i >= shuffle_order_.count()) return false;
 
-  return proxy_->filterAcceptsRow(virtual_items_[i], QModelIndex());
+  return proxy_->filterAcceptsRow(shuffle_order_.row(i), QModelIndex());
 }
 
 int Playlist::NextVirtualIndex(int i, bool ignore_repeat_track) const {
@@ -502,7 +568,7 @@ int Playlist::NextVirtualIndex(int i, bool ignore_repeat_track) const {
   // This one's easy - if we have to repeat the current track then just return i
   if (repeat_mode == PlaylistSequence::Repeat_Track && !ignore_repeat_track) {
     if (!FilterContainsVirtualIndex(i))
-      return virtual_items_.count();  // It's not in the filter any more
+      return shuffle_order_.count();  // It's not in the filter any more
     return i;
   }
 
@@ -513,9 +579,9 @@ int Playlist::NextVirtualIndex(int i, bool ignore_repeat_track) const {
 
     // Advance i until we find any track that is in the filter, skipping
     // the selected to be skipped
-    while (i < virtual_items_.count() &&
+    while (i < shuffle_order_.count() &&
            (!FilterContainsVirtualIndex(i) ||
-            item_at(virtual_items_[i])->GetShouldSkip())) {
+            item_at(shuffle_order_.row(i))->GetShouldSkip())) {
       ++i;
     }
     return i;
@@ -523,11 +589,11 @@ int Playlist::NextVirtualIndex(int i, bool ignore_repeat_track) const {
 
   // We need to advance i until we get something else on the same album
   Song last_song = current_item_metadata();
-  for (int j = i + 1; j < virtual_items_.count(); ++j) {
-    if (item_at(virtual_items_[j])->GetShouldSkip()) {
+  for (int j = i + 1; j < shuffle_order_.count(); ++j) {
+    if (item_at(shuffle_order_.row(j))->GetShouldSkip()) {
       continue;
     }
-    Song this_song = item_at(virtual_items_[j])->Metadata();
+    Song this_song = item_at(shuffle_order_.row(j))->Metadata();
     if (((last_song.is_compilation() && this_song.is_compilation()) ||
          last_song.effective_albumartist() ==
              this_song.effective_albumartist()) &&
@@ -538,7 +604,7 @@ int Playlist::NextVirtualIndex(int i, bool ignore_repeat_track) const {
   }
 
   // Couldn't find one - return past the end of the list
-  return virtual_items_.count();
+  return shuffle_order_.count();
 }
 
 int Playlist::PreviousVirtualIndex(int i, bool ignore_repeat_track) const {
@@ -561,7 +627,7 @@ int Playlist::PreviousVirtualIndex(int i, bool ignore_repeat_track) const {
 
     // Decrement i until we find any track that is in the filter
     while (i >= 0 && (!FilterContainsVirtualIndex(i) ||
-                      item_at(virtual_items_[i])->GetShouldSkip()))
+                      item_at(shuffle_order_.row(i))->GetShouldSkip()))
       --i;
     return i;
   }
@@ -569,10 +635,10 @@ int Playlist::PreviousVirtualIndex(int i, bool ignore_repeat_track) const {
   // We need to decrement i until we get something else on the same album
   Song last_song = current_item_metadata();
   for (int j = i - 1; j >= 0; --j) {
-    if (item_at(virtual_items_[j])->GetShouldSkip()) {
+    if (item_at(shuffle_order_.row(j))->GetShouldSkip()) {
       continue;
     }
-    Song this_song = item_at(virtual_items_[j])->Metadata();
+    Song this_song = item_at(shuffle_order_.row(j))->Metadata();
     if (((last_song.is_compilation() && this_song.is_compilation()) ||
          last_song.artist() == this_song.artist()) &&
         last_song.album() == this_song.album() &&
@@ -593,7 +659,7 @@ int Playlist::next_row(bool ignore_repeat_track) const {
 
   int next_virtual_index =
       NextVirtualIndex(current_virtual_index_, ignore_repeat_track);
-  if (next_virtual_index >= virtual_items_.count()) {
+  if (next_virtual_index >= shuffle_order_.count()) {
     // We've gone off the end of the playlist.
 
     switch (playlist_sequence_->repeat_mode()) {
@@ -611,10 +677,10 @@ int Playlist::next_row(bool ignore_repeat_track) const {
   }
 
   // Still off the end?  Then just give up
-  if (next_virtual_index < 0 || next_virtual_index >= virtual_items_.count())
+  if (next_virtual_index < 0 || next_virtual_index >= shuffle_order_.count())
     return -1;
 
-  return virtual_items_[next_virtual_index];
+  return shuffle_order_.row(next_virtual_index);
 }
 
 int Playlist::previous_row(bool ignore_repeat_track) const {
@@ -632,7 +698,7 @@ int Playlist::previous_row(bool ignore_repeat_track) const {
 
       default:
         prev_virtual_index =
-            PreviousVirtualIndex(virtual_items_.count(), ignore_repeat_track);
+            PreviousVirtualIndex(shuffle_order_.count(), ignore_repeat_track);
         break;
     }
   }
@@ -640,7 +706,7 @@ int Playlist::previous_row(bool ignore_repeat_track) const {
   // Still off the beginning?  Then just give up
   if (prev_virtual_index < 0) return -1;
 
-  return virtual_items_[prev_virtual_index];
+  return shuffle_order_.row(prev_virtual_index);
 }
 
 int Playlist::dynamic_history_length() const {
@@ -672,16 +738,23 @@ void Playlist::set_current_row(int i, bool is_stopping) {
   if (i == -1) {
     current_virtual_index_ = -1;
   } else if (is_shuffled_ && current_virtual_index_ == -1) {
-    // This is the first thing we're playing so we want to make sure the array
-    // is shuffled
+    // This is the first thing we're playing so we want to make sure the order
+    // is shuffled.  It starts with the one we've been asked to play.
     ReshuffleIndices();
-
-    // Bring the one we've been asked to play to the start of the list
-    virtual_items_.takeAt(virtual_items_.indexOf(i));
-    virtual_items_.prepend(i);
-    current_virtual_index_ = 0;
   } else if (is_shuffled_) {
-    current_virtual_index_ = virtual_items_.indexOf(i);
+    // Going back to something we've played already moves us back through the
+    // history, anything else is played next.
+    const int virtual_index = shuffle_order_.virtual_index(i);
+    if (virtual_index >= 0 && virtual_index < shuffle_history_.count()) {
+      current_virtual_index_ = virtual_index;
+    } else {
+      shuffle_history_.erase(
+          shuffle_history_.begin() +
+              qMin(current_virtual_index_ + 1, shuffle_history_.count()),
+          shuffle_history_.end());
+      shuffle_history_ << current_item_index_;
+      UpdateShuffleOrder();
+    }
   } else {
     current_virtual_index_ = i;
   }
@@ -960,7 +1033,7 @@ void Playlist::MoveItemsWithoutUndo(const QList<int>& source_rows, int pos) {
           pidx, index(pidx.row() + d, pidx.column(), QModelIndex()));
     }
   }
-  current_virtual_index_ = virtual_items_.indexOf(current_row());
+  UpdateShuffleOrder();
 
   layoutChanged();
   Save();
@@ -1009,7 +1082,7 @@ void Playlist::MoveItemsWithoutUndo(int start, const QList<int>& dest_rows) {
           pidx, index(pidx.row() + d, pidx.column(), QModelIndex()));
     }
   }
-  current_virtual_index_ = virtual_items_.indexOf(current_row());
+  UpdateShuffleOrder();
 
   layoutChanged();
   Save();
@@ -1019,6 +1092,10 @@ void Playlist::InsertItems(const PlaylistItemList& itemsIn, int pos,
                            bool play_now, bool enqueue, bool enqueue_next) {
   if (itemsIn.isEmpty()) return;
 
+  // Load the items that are already in the playlist first, so the new ones
+  // get saved along with them.
+  Restore();
+
   PlaylistItemList items = itemsIn;
 
   // exercise vetoes
@@ -1087,7 +1164,6 @@ void Playlist::InsertItemsWithoutUndo(const PlaylistItemList& items, int pos,
   for (int i = start; i <= end; ++i) {
     PlaylistItemPtr item = items[i - start];
     items_.insert(i, item);
-    virtual_items_ << virtual_items_.count();
 
     if (item->IsLocalLibraryItem()) {
       int id = item->Metadata().id();
@@ -1121,7 +1197,7 @@ void Playlist::InsertItemsWithoutUndo(const PlaylistItemList& items, int pos,
   }
 
   Save();
-  ReshuffleIndices();
+  UpdateShuffleOrder();
 }
 
 void Playlist::InsertLibraryItems(const SongList& songs, int pos, bool play_now,
@@ -1194,50 +1270,52 @@ void Playlist::InsertInternetItems(InternetService* service,
 
 void Playlist::UpdateItems(const SongList& songs) {
   qLog(Debug) << "Updating playlist with new tracks' info";
-  // We first convert our songs list into a linked list (a 'real' list),
-  // because removals are faster with QLinkedList.
-  // Next, we walk through the list of playlist's items then the list of songs
-  // we want to update: if an item corresponds to the song (we rely on URL for
-  // this), we update the item with the new metadata, then we remove song from
-  // our list because we will not need to check it again.
+  // We first group the songs by URL, so updates for a few songs don't have to
+  // look through all of them for every item.
+  // Next, we walk through the list of playlist's items: if an item corresponds
+  // to a song (we rely on URL for this), we update the item with the new
+  // metadata, then we remove the song because we will not need to check it
+  // again.
   // And we also update undo actions.
-  QLinkedList<Song> songs_list;
-  for (const Song& song : songs) songs_list.append(song);
+  QHash<QUrl, QLinkedList<Song>> songs_by_url;
+  for (const Song& song : songs) songs_by_url[song.url()].append(song);
 
-  for (int i = 0; i < items_.size(); i++) {
+  for (int i = 0; i < items_.size() && !songs_by_url.isEmpty(); i++) {
     // Update current items list
-    QMutableLinkedListIterator<Song> it(songs_list);
-    while (it.hasNext()) {
-      const Song& song = it.next();
-      PlaylistItemPtr& item = items_[i];
-      if (item->Metadata().url() == song.url() &&
-          (item->Metadata().filetype() == Song::Type_Unknown ||
-           // Stream may change and may need to be updated too
-           item->Metadata().filetype() == Song::Type_Stream ||
-           // And CD tracks as well (tags are loaded in a second step)
-           item->Metadata().filetype() == Song::Type_Cdda)) {
-        PlaylistItemPtr new_item;
-        if (song.is_library_song()) {
-          new_item = PlaylistItemPtr(new LibraryPlaylistItem(song));
-          library_items_by_id_.insertMulti(song.id(), new_item);
-        } else {
-          new_item = PlaylistItemPtr(new SongPlaylistItem(song));
-        }
-        items_[i] = new_item;
-        emit dataChanged(index(i, 0), index(i, ColumnCount - 1));
-        // Also update undo actions
-        for (int i = 0; i < undo_stack_->count(); i++) {
-          QUndoCommand* undo_action =
-              const_cast<QUndoCommand*>(undo_stack_->command(i));
-          PlaylistUndoCommands::InsertItems* undo_action_insert =
-              dynamic_cast<PlaylistUndoCommands::InsertItems*>(undo_action);
-          if (undo_action_insert) {
-            bool found_and_updated = undo_action_insert->UpdateItem(new_item);
-            if (found_and_updated) break;
-          }
-        }
-        it.remove();
-        break;
+    const PlaylistItemPtr& item = items_[i];
+    if (item->Metadata().filetype() != Song::Type_Unknown &&
+        // Stream may change and may need to be updated too
+        item->Metadata().filetype() != Song::Type_Stream &&
+        // And CD tracks as well (tags are loaded in a second step)
+        item->Metadata().filetype() != Song::Type_Cdda) {
+      continue;
+    }
+
+    QHash<QUrl, QLinkedList<Song>>::iterator it =
+        songs_by_url.find(item->Metadata().url());
+    if (it == songs_by_url.end()) continue;
+
+    const Song song = it->takeFirst();
+    if (it->isEmpty()) songs_by_url.erase(it);
+
+    PlaylistItemPtr new_item;
+    if (song.is_library_song()) {
+      new_item = PlaylistItemPtr(new LibraryPlaylistItem(song));
+      library_items_by_id_.insertMulti(song.id(), new_item);
+    } else {
+      new_item = PlaylistItemPtr(new SongPlaylistItem(song));
+    }
+    items_[i] = new_item;
+    QueueRowChanged(i);
+    // Also update undo actions
+    for (int i = 0; i < undo_stack_->count(); i++) {
+      QUndoCommand* undo_action =
+          const_cast<QUndoCommand*>(undo_stack_->command(i));
+      PlaylistUndoCommands::InsertItems* undo_action_insert =
+          dynamic_cast<PlaylistUndoCommands::InsertItems*>(undo_action);
+      if (undo_action_insert) {
+        bool found_and_updated = undo_action_insert->UpdateItem(new_item);
+        if (found_and_updated) break;
       }
     }
   }
@@ -1280,102 +1358,6 @@ QMimeData* Playlist::mimeData(const QModelIndexList& indexes) const {
   return data;
 }
 
-bool Playlist::CompareItems(int column, Qt::SortOrder order,
-                            shared_ptr<PlaylistItem> _a,
-                            shared_ptr<PlaylistItem> _b,
-                            const QStringList& prefixes) {
-  shared_ptr<PlaylistItem> a = order == Qt::AscendingOrder ? _a : _b;
-  shared_ptr<PlaylistItem> b = order == Qt::AscendingOrder ? _b : _a;
-
-#define cmp(field) return a->Metadata().field() < b->Metadata().field()
-#define strcmp(field)                                                 \
-  return QString::localeAwareCompare(                                 \
-             removePrefix(a->Metadata().field().toLower(), prefixes), \
-             removePrefix(b->Metadata().field().toLower(), prefixes)) < 0;
-
-  switch (column) {
-    case Column_Title:
-      strcmp(title);
-    case Column_Artist:
-      strcmp(artist);
-    case Column_Album:
-      strcmp(album);
-    case Column_Length:
-      cmp(length_nanosec);
-    case Column_Track:
-      cmp(track);
-    case Column_Disc:
-      cmp(disc);
-    case Column_Year:
-      cmp(year);
-    case Column_OriginalYear:
-      cmp(originalyear);
-    case Column_Genre:
-      strcmp(genre);
-    case Column_AlbumArtist:
-      strcmp(playlist_albumartist);
-    case Column_Composer:
-      strcmp(composer);
-    case Column_Performer:
-      strcmp(performer);
-    case Column_Grouping:
-      strcmp(grouping);
-
-    case Column_Rating:
-      cmp(rating);
-    case Column_PlayCount:
-      cmp(playcount);
-    case Column_SkipCount:
-      cmp(skipcount);
-    case Column_LastPlayed:
-      cmp(lastplayed);
-    case Column_Score:
-      cmp(score);
-
-    case Column_BPM:
-      cmp(bpm);
-    case Column_Bitrate:
-      cmp(bitrate);
-    case Column_Samplerate:
-      cmp(samplerate);
-    case Column_Filename:
-      return (QString::localeAwareCompare(a->Url().path().toLower(),
-                                          b->Url().path().toLower()) < 0);
-    case Column_BaseFilename:
-      cmp(basefilename);
-    case Column_Filesize:
-      cmp(filesize);
-    case Column_Filetype:
-      cmp(filetype);
-    case Column_DateModified:
-      cmp(mtime);
-    case Column_DateCreated:
-      cmp(ctime);
-
-    case Column_Comment:
-      strcmp(comment);
-    case Column_Source:
-      cmp(url);
-  }
-
-#undef cmp
-#undef strcmp
-
-  return false;
-}
-
-bool Playlist::ComparePathDepths(Qt::SortOrder order,
-                                 shared_ptr<PlaylistItem> _a,
-                                 shared_ptr<PlaylistItem> _b) {
-  shared_ptr<PlaylistItem> a = order == Qt::AscendingOrder ? _a : _b;
-  shared_ptr<PlaylistItem> b = order == Qt::AscendingOrder ? _b : _a;
-
-  int a_dir_level = a->Url().path().count('/');
-  int b_dir_level = b->Url().path().count('/');
-
-  return a_dir_level < b_dir_level;
-}
-
 QString Playlist::column_name(Column column) {
   switch (column) {
     case Column_Title:
@@ -1465,10 +1447,14 @@ QString Playlist::abbreviated_column_name(Column column) {
 void Playlist::sort(int column, Qt::SortOrder order) {
   if (ignore_sorting_) return;
 
-  PlaylistItemList new_items(items_);
-  PlaylistItemList::iterator begin = new_items.begin();
+  PendingSort sort;
+  sort.id_ = ++last_sort_id_;
+  sort.column_ = column;
+  sort.order_ = order;
+  sort.begin_ = 0;
   if (dynamic_playlist_ && current_item_index_.isValid())
-    begin += current_item_index_.row() + 1;
+    sort.begin_ = current_item_index_.row() + 1;
+  sort.items_ = items_;
 
   QSettings s;
   s.beginGroup(Playlist::kSettingsGroup);
@@ -1485,37 +1471,76 @@ void Playlist::sort(int column, Qt::SortOrder order) {
   }
   s.endGroup();
 
-  if (column == Column_Album) {
-    // When sorting by album, also take into account discs and tracks.
-    std::stable_sort(begin, new_items.end(),
-                     std::bind(&Playlist::CompareItems, Column_Track, order, _1,
-                               _2, prefixes));
-    std::stable_sort(begin, new_items.end(),
-                     std::bind(&Playlist::CompareItems, Column_Disc, order, _1,
-                               _2, prefixes));
-    std::stable_sort(begin, new_items.end(),
-                     std::bind(&Playlist::CompareItems, Column_Album, order, _1,
-                               _2, prefixes));
-  } else if (column == Column_Filename) {
-    // When sorting by full paths we also expect a hierarchical order. This
-    // returns a breath-first ordering of paths.
-    std::stable_sort(begin, new_items.end(),
-                     std::bind(&Playlist::CompareItems, Column_Filename, order,
-                               _1, _2, prefixes));
-    std::stable_sort(begin, new_items.end(),
-                     std::bind(&Playlist::ComparePathDepths, order, _1, _2));
-  } else {
-    std::stable_sort(
-        begin, new_items.end(),
-        std::bind(&Playlist::CompareItems, column, order, _1, _2, prefixes));
+  std::shared_ptr<PlaylistSortKeys> keys(new PlaylistSortKeys(
+      column, prefixes, items_.mid(sort.begin_)));
+
+  if (keys->count() < kMinItemsForBackgroundSort) {
+    pending_sort_ = PendingSort();
+    ApplySort(sort, keys->Sort(order));
+    return;
   }
 
-  undo_stack_->push(
-      new PlaylistUndoCommands::SortItems(this, column, order, new_items));
+  // Big playlists are sorted in the background.  The items are still read on
+  // this thread, the keys only hold copies of their fields.
+  pending_sort_ = sort;
+  QFuture<QVector<int>> future = Executor::Cpu()->Run<QVector<int>>(
+      [keys, order]() { return SortRows(keys, order); });
+  NewClosure(future, this, SLOT(SortFinished(QFuture<QVector<int>>, int)),
+             future, sort.id_);
+}
+
+void Playlist::SortFinished(QFuture<QVector<int>> future, int sort_id) {
+  // A later sort replaced this one.
+  if (sort_id != pending_sort_.id_) return;
+
+  const PendingSort sort = pending_sort_;
+  pending_sort_ = PendingSort();
+
+  int begin = 0;
+  if (dynamic_playlist_ && current_item_index_.isValid())
+    begin = current_item_index_.row() + 1;
+
+  if (items_ != sort.items_ || begin != sort.begin_) {
+    // The playlist changed while it was being sorted, start again.
+    this->sort(sort.column_, sort.order_);
+    return;
+  }
+
+  ApplySort(sort, future.result());
+}
+
+void Playlist::ApplySort(const PendingSort& sort, const QVector<int>& rows) {
+  undo_stack_->push(new PlaylistUndoCommands::SortItems(
+      this, sort.column_, sort.order_, sort.begin_, rows));
 
   ReshuffleIndices();
 }
 
+void Playlist::LimitUndoMemory() {
+  // Only commands that have been done are counted, the ones that could be
+  // redone go away with the next push anyway.  The latest one is always kept.
+  const int done = undo_stack_->index();
+  qint64 cost = 0;
+  int i = done - 1;
+  for (; i >= 0; --i) {
+    PlaylistUndoCommands::Base* command =
+        dynamic_cast<PlaylistUndoCommands::Base*>(
+            const_cast<QUndoCommand*>(undo_stack_->command(i)));
+    if (!command) continue;
+
+    cost += command->memory_cost();
+    if (cost > kUndoMemoryLimit && i != done - 1) break;
+  }
+
+  // Drop the oldest commands until the rest fit.
+  for (; i >= 0; --i) {
+    PlaylistUndoCommands::Base* command =
+        dynamic_cast<PlaylistUndoCommands::Base*>(
+            const_cast<QUndoCommand*>(undo_stack_->command(i)));
+    if (command && !command->expired()) command->Expire();
+  }
+}
+
 void Playlist::ReOrderWithoutUndo(const PlaylistItemList& new_items) {
   layoutAboutToBeChanged();
 
@@ -1533,6 +1558,8 @@ void Playlist::ReOrderWithoutUndo(const PlaylistItemList& new_items) {
                           index(new_rows[item], idx.column(), idx.parent()));
   }
 
+  UpdateShuffleOrder();
+
   layoutChanged();
 
   emit PlaylistChanged();
@@ -1555,32 +1582,113 @@ void Playlist::SetCurrentIsPaused(bool paused) {
                 index(current_item_index_.row(), ColumnCount - 1));
 }
 
-void Playlist::Save() const {
+void Playlist::Save(const PlaylistItemList& changed_items) const {
   if (!backend_ || is_loading_) return;
 
+  if (restore_state_ != Restore_Finished) {
+    // Saving now would drop the rows that haven't been loaded yet, so wait
+    // until they have.
+    save_pending_ = true;
+    pending_changed_items_ << changed_items;
+    return;
+  }
+
   backend_->SavePlaylistAsync(id_, items_, last_played_row(),
-                              dynamic_playlist_);
+                              dynamic_playlist_, queue_->SourceRows(),
+                              changed_items);
 }
 
-void Playlist::Restore() {
-  if (!backend_) return;
+void Playlist::SaveQueue() const {
+  if (!backend_ || is_loading_) return;
 
-  items_.clear();
-  virtual_items_.clear();
-  library_items_by_id_.clear();
+  if (restore_state_ != Restore_Finished) {
+    // The queue is saved along with the rest of the playlist once it's loaded.
+    Save();
+    return;
+  }
+
+  backend_->SaveQueueAsync(id_, queue_->SourceRows());
+}
+
+void Playlist::Restore() {
+  if (!backend_ || restore_state_ != Restore_NotStarted) return;
 
+  restore_state_ = Restore_Loading;
   cancel_restore_ = false;
-  QFuture<QList<PlaylistItemPtr>> future =
-      QtConcurrent::run(backend_, &PlaylistBackend::GetPlaylistItems, id_);
-  NewClosure(future, this, SLOT(ItemsLoaded(QFuture<PlaylistItemList>)),
-             future);
+
+  // Load the first screenful straight away so the playlist can be shown, and
+  // stream the rest in from a background thread.
+  PlaylistItemList items =
+      backend_->GetPlaylistItems(id_, 0, kRestoreFirstChunkSize);
+  restore_offset_ = items.count();
+  restore_row_ = 0;
+  restored_items_.clear();
+  InsertRestoredItems(items);
+
+  if (items.count() == kRestoreFirstChunkSize) {
+    LoadRestoreChunk();
+  } else {
+    // Still finish asynchronously, like a longer playlist would, so there's
+    // time to connect to RestoreFinished.
+    metaObject()->invokeMethod(this, "FinishRestore", Qt::QueuedConnection);
+  }
+}
+
+void Playlist::LoadRestoreChunk() {
+  PlaylistBackend* backend = backend_;
+  const int id = id_;
+  const int offset = restore_offset_;
+  restore_future_ =
+      Executor::Db()->Run<PlaylistItemList>([backend, id, offset]() {
+        return backend->GetPlaylistItems(id, offset, kRestoreChunkSize);
+      });
+  NewClosure(restore_future_, this,
+             SLOT(ItemsLoaded(QFuture<PlaylistItemList>)), restore_future_);
+}
+
+void Playlist::RestoreBlocking() {
+  Restore();
+  if (restore_state_ != Restore_Loading) return;
+
+  // Chunks have to be read in order, so wait for the one that's being read
+  // before reading everything after it.
+  bool more = false;
+  if (restore_future_.isStarted()) {
+    restore_future_.waitForFinished();
+    PlaylistItemList items = restore_future_.result();
+    restore_future_ = QFuture<PlaylistItemList>();
+    restore_offset_ += items.count();
+    more = items.count() == kRestoreChunkSize;
+    InsertRestoredItems(items);
+  }
+
+  if (more) {
+    PlaylistItemList items = backend_->GetPlaylistItems(id_, restore_offset_);
+    restore_offset_ += items.count();
+    InsertRestoredItems(items);
+  }
+
+  FinishRestore();
 }
 
 void Playlist::ItemsLoaded(QFuture<PlaylistItemList> future) {
-  if (cancel_restore_) return;
+  // Chunks that RestoreBlocking() already took aren't inserted again.
+  if (cancel_restore_ || future != restore_future_) return;
+  restore_future_ = QFuture<PlaylistItemList>();
 
   PlaylistItemList items = future.result();
+  restore_offset_ += items.count();
+
+  // Start reading the next chunk while this one is being inserted.
+  const bool more = items.count() == kRestoreChunkSize;
+  if (more) LoadRestoreChunk();
+
+  InsertRestoredItems(items);
+
+  if (!more) FinishRestore();
+}
 
+void Playlist::InsertRestoredItems(PlaylistItemList items) {
   // backend returns empty elements for library items which it couldn't
   // match (because they got deleted); we don't need those
   QMutableListIterator<PlaylistItemPtr> it(items);
@@ -1588,21 +1696,58 @@ void Playlist::ItemsLoaded(QFuture<PlaylistItemList> future) {
     PlaylistItemPtr item = it.next();
 
     if (item->IsLocalLibraryItem() && item->Metadata().url().isEmpty()) {
+      restored_items_ << PlaylistItemPtr();
       it.remove();
+    } else {
+      restored_items_ << item;
     }
   }
 
+  // Each chunk goes after the previous one, even if other items were added
+  // to the playlist in the meantime.
+  const int pos = qMin(restore_row_, items_.count());
+
   is_loading_ = true;
-  InsertItems(items, 0);
+  InsertItems(items, pos);
   is_loading_ = false;
 
+  restore_row_ = pos + items.count();
+}
+
+int Playlist::RestoredRow(int saved_row) const {
+  if (saved_row < 0 || saved_row >= restored_items_.count()) return -1;
+
+  const PlaylistItemPtr& item = restored_items_[saved_row];
+  if (!item) return -1;
+  return items_.indexOf(item);
+}
+
+void Playlist::FinishRestore() {
+  if (cancel_restore_ || restore_state_ != Restore_Loading) return;
+
+  restore_state_ = Restore_Finished;
+
   PlaylistBackend::Playlist p = backend_->GetPlaylist(id_);
 
-  // the newly loaded list of items might be shorter than it was before so
-  // look out for a bad last_played index
-  last_played_item_index_ = p.last_played == -1 || p.last_played >= rowCount()
-                                ? QModelIndex()
-                                : index(p.last_played);
+  // The saved rows are the ones the items had when the playlist was saved.
+  // Items that couldn't be restored, or were added in the meantime, move the
+  // others around, so look the rows up through the items themselves.
+  const int last_played = RestoredRow(p.last_played);
+  last_played_item_index_ =
+      last_played == -1 ? QModelIndex() : index(last_played);
+
+  // Put the queue back, leaving out rows that aren't there any more.
+  QModelIndexList queued;
+  for (int saved_row : p.queue) {
+    const int row = RestoredRow(saved_row);
+    if (row != -1 && !queue_->ContainsSourceRow(row)) {
+      queued << index(row, 0);
+    }
+  }
+  restored_items_.clear();
+  is_loading_ = true;
+  queue_->ToggleTracks(queued);
+  is_loading_ = false;
 
   if (!p.dynamic_type.isEmpty()) {
     GeneratorPtr gen = Generator::Create(p.dynamic_type);
@@ -1631,7 +1776,14 @@ void Playlist::ItemsLoaded(QFuture<PlaylistItemList> future) {
 
   // should we gray out deleted songs asynchronously on startup?
   if (s.value("greyoutdeleted", false).toBool()) {
-    QtConcurrent::run(this, &Playlist::InvalidateDeletedSongs);
+    InvalidateDeletedSongs();
+  }
+
+  if (save_pending_) {
+    save_pending_ = false;
+    PlaylistItemList changed_items;
+    changed_items.swap(pending_changed_items_);
+    Save(changed_items);
   }
 }
 
@@ -1728,23 +1880,16 @@ PlaylistItemList Playlist::RemoveItemsWithoutUndo(int row, int count) {
 
   endRemoveRows();
 
-  QList<int>::iterator it = virtual_items_.begin();
-  while (it != virtual_items_.end()) {
-    if (*it >= items_.count())
-      it = virtual_items_.erase(it);
-    else
-      ++it;
-  }
+  UpdateShuffleOrder();
 
   // Reset current_virtual_index_
-  if (current_row() == -1)
+  if (current_row() == -1) {
     if (row - 1 > 0 && row - 1 < items_.size()) {
-      current_virtual_index_ = virtual_items_.indexOf(row - 1);
+      current_virtual_index_ = shuffle_order_.virtual_index(row - 1);
     } else {
       current_virtual_index_ = -1;
     }
-  else
-    current_virtual_index_ = virtual_items_.indexOf(current_row());
+  }
 
   Save();
   return ret;
@@ -1893,8 +2038,11 @@ void Playlist::UpdatePlayCountPoint(qint64 seek_point_nanosec) {
 }
 
 void Playlist::Clear() {
-  // If loading songs from session restore async, don't insert them
+  // If loading songs from session restore async, don't insert them.  What's
+  // left after clearing is the whole playlist, so it can be saved again.
   cancel_restore_ = true;
+  restore_state_ = Restore_Finished;
+  restored_items_.clear();
 
   const int count = items_.count();
 
@@ -1968,19 +2116,31 @@ void Playlist::RemoveItemsNotInQueue() {
 }
 
 void Playlist::ReloadItems(const QList<int>& rows) {
+  PlaylistItemList items;
+  QList<QPersistentModelIndex> indexes;
   for (int row : rows) {
-    PlaylistItemPtr item = item_at(row);
+    items << item_at(row);
+    indexes << QPersistentModelIndex(index(row, 0));
+  }
 
-    item->Reload();
+  // All the items are read at once, and rows can move about in the mean time.
+  PlaylistItem::ReloadAllAsync(items, this, [this, items, indexes]() {
+    PlaylistItemList reloaded;
+    for (int i = 0; i < indexes.count(); ++i) {
+      if (!indexes[i].isValid()) continue;
 
-    if (row == current_row()) {
-      InformOfCurrentSongChange();
-    } else {
-      emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+      const int row = indexes[i].row();
+      reloaded << items[i];
+
+      if (row == current_row()) {
+        InformOfCurrentSongChange();
+      } else {
+        QueueRowChanged(row);
+      }
     }
-  }
 
-  Save();
+    Save(reloaded);
+  });
 }
 
 void Playlist::RateSong(const QModelIndex& index, double rating) {
@@ -2026,36 +2186,25 @@ void Playlist::SongInsertVetoListenerDestroyed() {
 }
 
 void Playlist::Shuffle() {
-  PlaylistItemList new_items(items_);
-
   int begin = 0;
   if (dynamic_playlist_ && current_item_index_.isValid())
     begin += current_item_index_.row() + 1;
 
-  const int count = items_.count();
-  for (int i = begin; i < count; ++i) {
+  const int count = items_.count() - begin;
+  QVector<int> new_rows(count);
+  std::iota(new_rows.begin(), new_rows.end(), 0);
+  for (int i = 0; i < count; ++i) {
 #if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
     int new_pos = i + (qrand() % (count - i));
 #else
     int new_pos = QRandomGenerator::global()->bounded(i, count);
 #endif
-    std::swap(new_items[i], new_items[new_pos]);
+    std::swap(new_rows[i], new_rows[new_pos]);
   }
 
-  undo_stack_->push(new PlaylistUndoCommands::ShuffleItems(this, new_items));
-}
-
-namespace {
-bool AlbumShuffleComparator(const QMap<QString, int>& album_key_positions,
-                            const QMap<int, QString>& album_keys, int left,
-                            int right) {
-  const int left_pos = album_key_positions[album_keys[left]];
-  const int right_pos = album_key_positions[album_keys[right]];
-
-  if (left_pos == right_pos) return left < right;
-  return left_pos < right_pos;
+  undo_stack_->push(
+      new PlaylistUndoCommands::ShuffleItems(this, begin, new_rows));
 }
-}  // namespace
 
 void Playlist::ReshuffleIndices() {
   if (!playlist_sequence_) {
@@ -2063,19 +2212,24 @@ void Playlist::ReshuffleIndices() {
   }
 
   if (playlist_sequence_->shuffle_mode() == PlaylistSequence::Shuffle_Off) {
-    // No shuffling - sort the virtual item list normally.
-    std::sort(virtual_items_.begin(), virtual_items_.end());
-    if (current_row() != -1)
-      current_virtual_index_ = virtual_items_.indexOf(current_row());
+    // No shuffling - play the items in order.
+    shuffle_history_.clear();
+    shuffle_order_.SetInOrder(items_.count());
+    current_virtual_index_ = current_row();
     return;
   }
 
-  // If the user is already playing a song, advance the begin iterator to
-  // only shuffle items that haven't been played yet.
-  QList<int>::iterator begin = virtual_items_.begin();
-  QList<int>::iterator end = virtual_items_.end();
-  if (current_virtual_index_ != -1)
-    std::advance(begin, current_virtual_index_ + 1);
+  // If the user is already playing a song, only shuffle items that haven't
+  // been played yet.  Otherwise start with the song that's selected.
+  if (shuffle_order_.is_shuffled() && current_virtual_index_ != -1) {
+    shuffle_history_.erase(
+        shuffle_history_.begin() +
+            qMin(current_virtual_index_ + 1, shuffle_history_.count()),
+        shuffle_history_.end());
+  } else {
+    shuffle_history_.clear();
+    if (current_item_index_.isValid()) shuffle_history_ << current_item_index_;
+  }
 
   switch (playlist_sequence_->shuffle_mode()) {
     case PlaylistSequence::Shuffle_Off:
@@ -2084,51 +2238,74 @@ void Playlist::ReshuffleIndices() {
 
     case PlaylistSequence::Shuffle_All:
     case PlaylistSequence::Shuffle_InsideAlbum:
-      std::random_shuffle(begin, end);
+      shuffle_order_.Shuffle(items_.count());
       break;
 
     case PlaylistSequence::Shuffle_Albums: {
-      QMap<int, QString> album_keys;  // real index -> key
-      QSet<QString> album_key_set;    // unique keys
-
-      // Find all the unique albums in the playlist
-      for (QList<int>::iterator it = begin; it != end; ++it) {
-        const int index = *it;
-        const QString key = items_[index]->Metadata().AlbumKey();
-        album_keys[index] = key;
-        album_key_set << key;
-      }
-
-      // Shuffle them
-      QStringList shuffled_album_keys = album_key_set.values();
-      std::random_shuffle(shuffled_album_keys.begin(),
-                          shuffled_album_keys.end());
-
       // If the user is currently playing a song, force its album to be first
       // Or if the song was not playing but it was selected, force its album
       // to be first.
-      if (current_virtual_index_ != -1 || current_row() != -1) {
-        const QString key = items_[current_row()]->Metadata().AlbumKey();
-        const int pos = shuffled_album_keys.indexOf(key);
-        if (pos >= 1) {
-          std::swap(shuffled_album_keys[0], shuffled_album_keys[pos]);
-        }
-      }
+      int first_group = -1;
+      const QVector<QVector<int>> groups =
+          AlbumGroups(current_row(), &first_group);
+      shuffle_order_.ShuffleGroups(groups, first_group);
+      break;
+    }
+  }
 
-      // Create album key -> position mapping for fast lookup
-      QMap<QString, int> album_key_positions;
-      for (int i = 0; i < shuffled_album_keys.count(); ++i) {
-        album_key_positions[shuffled_album_keys[i]] = i;
-      }
+  UpdateShuffleOrder();
+}
 
-      // Sort the virtual items
-      std::stable_sort(begin, end,
-                       std::bind(AlbumShuffleComparator, album_key_positions,
-                                 album_keys, _1, _2));
+void Playlist::UpdateShuffleOrder() {
+  if (!shuffle_order_.is_shuffled()) {
+    shuffle_order_.set_count(items_.count());
+    current_virtual_index_ = current_row();
+    return;
+  }
 
-      break;
+  if (playlist_sequence_ &&
+      playlist_sequence_->shuffle_mode() == PlaylistSequence::Shuffle_Albums) {
+    // Albums are told apart by their songs' metadata, so they have to be
+    // found again when the rows change.
+    int first_group = -1;
+    const QVector<QVector<int>> groups =
+        AlbumGroups(current_row(), &first_group);
+    shuffle_order_.SetGroups(groups, first_group);
+  } else {
+    shuffle_order_.set_count(items_.count());
+  }
+
+  QList<int> history;
+  QList<QPersistentModelIndex>::iterator it = shuffle_history_.begin();
+  while (it != shuffle_history_.end()) {
+    if (it->isValid()) {
+      history << it->row();
+      ++it;
+    } else {
+      it = shuffle_history_.erase(it);
     }
   }
+  shuffle_order_.set_history(history);
+
+  current_virtual_index_ = shuffle_order_.virtual_index(current_row());
+}
+
+QVector<QVector<int>> Playlist::AlbumGroups(int row, int* group) const {
+  QVector<QVector<int>> ret;
+  QHash<QString, int> groups_by_key;
+
+  for (int i = 0; i < items_.count(); ++i) {
+    const QString key = items_[i]->Metadata().AlbumKey();
+    QHash<QString, int>::const_iterator it = groups_by_key.constFind(key);
+    if (it == groups_by_key.constEnd()) {
+      it = groups_by_key.insert(key, ret.count());
+      ret << QVector<int>();
+    }
+    ret[it.value()] << i;
+    if (i == row) *group = it.value();
+  }
+
+  return ret;
 }
 
 void Playlist::set_sequence(PlaylistSequence* v) {
@@ -2171,38 +2348,72 @@ void Playlist::TracksAboutToBeDequeued(const QModelIndex&, int begin, int end) {
   }
 }
 
-void Playlist::TracksDequeued() {
+void Playlist::TracksDequeued(const QModelIndex&, int begin, int) {
   for (const QModelIndex& index : temp_dequeue_change_indexes_) {
-    emit dataChanged(index, index);
+    QueueRowChanged(index.row(), index.column(), index.column());
   }
   temp_dequeue_change_indexes_.clear();
+
+  // The tracks after the removed ones moved up the queue.
+  QueuePositionsChanged(begin);
   emit QueueChanged();
+  SaveQueue();
 }
 
-void Playlist::TracksEnqueued(const QModelIndex&, int begin, int end) {
-  const QModelIndex& b =
-      queue_->mapToSource(queue_->index(begin, Column_Title));
-  const QModelIndex& e = queue_->mapToSource(queue_->index(end, Column_Title));
-  emit dataChanged(b, e);
+void Playlist::TracksEnqueued(const QModelIndex&, int begin, int) {
+  QueuePositionsChanged(begin);
+  SaveQueue();
 }
 
 void Playlist::QueueLayoutChanged() {
-  for (int i = 0; i < queue_->rowCount(); ++i) {
+  QueuePositionsChanged(0);
+  SaveQueue();
+}
+
+void Playlist::QueuePositionsChanged(int begin) {
+  for (int i = begin; i < queue_->rowCount(); ++i) {
     const QModelIndex& index =
         queue_->mapToSource(queue_->index(i, Column_Title));
-    emit dataChanged(index, index);
+    QueueRowChanged(index.row(), Column_Title, Column_Title);
   }
 }
 
 void Playlist::ItemChanged(PlaylistItemPtr item) {
   for (int row = 0; row < items_.count(); ++row) {
     if (items_[row] == item) {
-      emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+      QueueRowChanged(row);
       return;
     }
   }
 }
 
+void Playlist::LibrarySongsChanged(const SongList& songs) {
+  const PlaylistItemPtr current = current_item();
+  bool current_changed = false;
+
+  // The items only keep the song's ID in the database, so there's nothing to
+  // save.
+  QSet<PlaylistItem*> changed;
+  for (const Song& song : songs) {
+    for (PlaylistItemPtr item : library_items_by_id_.values(song.id())) {
+      if (item->Metadata().directory_id() != song.directory_id()) continue;
+
+      if (item == current && !song.IsMetadataEqual(item->Metadata())) {
+        current_changed = true;
+      }
+      static_cast<LibraryPlaylistItem*>(item.get())->SetMetadata(song);
+      changed << item.get();
+    }
+  }
+  if (changed.isEmpty()) return;
+
+  for (int row = 0; row < items_.count() && !changed.isEmpty(); ++row) {
+    if (changed.remove(items_[row].get())) QueueRowChanged(row);
+  }
+
+  if (current_changed) InformOfCurrentSongChange();
+}
+
 void Playlist::InformOfCurrentSongChange() {
   emit dataChanged(index(current_item_index_.row(), 0),
                    index(current_item_index_.row(), ColumnCount - 1));
@@ -2215,28 +2426,30 @@ void Playlist::InformOfCurrentSongChange() {
   }
 }
 
-void Playlist::InvalidateDeletedSongs() {
-  QList<int> invalidated_rows;
+void Playlist::LibrarySongsAvailabilityChanged(const SongList& songs,
+                                               bool unavailable) {
+  QSet<PlaylistItem*> changed;
+  for (const Song& song : songs) {
+    for (PlaylistItemPtr item : library_items_by_id_.values(song.id())) {
+      if (item->Metadata().directory_id() != song.directory_id()) continue;
+      if (SetItemMissing(item, unavailable)) changed << item.get();
+    }
+  }
 
-  for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
-    Song song = item->Metadata();
+  for (int row = 0; row < items_.count() && !changed.isEmpty(); ++row) {
+    if (changed.remove(items_[row].get())) QueueRowChanged(row);
+  }
+}
 
-    if (!song.is_stream()) {
-      bool exists = QFile::exists(song.url().toLocalFile());
+bool Playlist::SetItemMissing(PlaylistItemPtr item, bool missing) {
+  if (missing == item->HasForegroundColor(kInvalidSongPriority)) return false;
 
-      if (!exists && !item->HasForegroundColor(kInvalidSongPriority)) {
-        // gray out the song if it's not there
-        item->SetForegroundColor(kInvalidSongPriority, kInvalidSongColor);
-        invalidated_rows.append(row);
-      } else if (exists && item->HasForegroundColor(kInvalidSongPriority)) {
-        item->RemoveForegroundColor(kInvalidSongPriority);
-        invalidated_rows.append(row);
-      }
-    }
+  if (missing) {
+    item->SetForegroundColor(kInvalidSongPriority, kInvalidSongColor);
+  } else {
+    item->RemoveForegroundColor(kInvalidSongPriority);
   }
-
-  ReloadItems(invalidated_rows);
+  return true;
 }
 
 void Playlist::RemoveDeletedSongs() {
@@ -2254,61 +2467,248 @@ void Playlist::RemoveDeletedSongs() {
   removeRows(rows_to_remove);
 }
 
-struct SongSimilarHash {
-  long operator()(const Song& song) const { return HashSimilar(song); }
-};
-
-struct SongSimilarEqual {
-  long operator()(const Song& song1, const Song& song2) const {
-    return song1.IsSimilar(song2);
-  }
-};
-
 void Playlist::RemoveDuplicateSongs() {
+  // Songs are duplicates when they have the same title and artist, ignoring
+  // case, like Song::IsSimilar.  Of each set of duplicates the one with the
+  // highest bitrate is kept.
+  struct Kept {
+    int row_;
+    int bitrate_;
+  };
+  QHash<QString, Kept> unique_songs;
+  unique_songs.reserve(items_.count());
   QList<int> rows_to_remove;
-  unordered_map<Song, int, SongSimilarHash, SongSimilarEqual> unique_songs;
 
   for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
-    const Song& song = item->Metadata();
+    const Song song = items_[row]->Metadata();
+    const QString key = song.title().toCaseFolded() + QChar(0) +
+                        song.artist().toCaseFolded();
+
+    auto it = unique_songs.find(key);
+    if (it == unique_songs.end()) {
+      unique_songs.insert(key, Kept{row, song.bitrate()});
+    } else if (song.bitrate() > it->bitrate_) {
+      rows_to_remove << it->row_;
+      *it = Kept{row, song.bitrate()};
+    } else {
+      rows_to_remove << row;
+    }
+  }
+
+  RemoveRowsInOneStep(rows_to_remove);
+}
 
-    bool found_duplicate = false;
+namespace {
 
-    auto uniq_song_it = unique_songs.find(song);
-    if (uniq_song_it != unique_songs.end()) {
-      const Song& uniq_song = uniq_song_it->first;
+// Checking a file that takes longer than this means its mount is asleep or
+// unreachable, so the rest of the files on it are left alone.
+const int kSlowMountMsec = 2000;
 
-      if (song.bitrate() > uniq_song.bitrate()) {
-        rows_to_remove.append(unique_songs[uniq_song]);
-        unique_songs.erase(uniq_song);
-        unique_songs.insert(std::make_pair(song, row));
-      } else {
-        rows_to_remove.append(row);
+struct FileToCheck {
+  QString path_;
+  PlaylistItemPtr item_;
+};
+typedef QList<FileToCheck> FilesToCheck;
+
+struct CheckedFile {
+  FileToCheck file_;
+  bool exists_;
+};
+typedef QList<CheckedFile> CheckedFiles;
+
+CheckedFiles CheckFilesOnMount(const FilesToCheck& files) {
+  // Files in the same directory are all found with one listing rather than a
+  // stat each, which matters on network mounts.
+  QMap<QString, FilesToCheck> files_by_dir;
+  for (const FileToCheck& file : files) {
+    files_by_dir[QFileInfo(file.path_).path()] << file;
+  }
+
+  CheckedFiles checked;
+  QElapsedTimer timer;
+  for (auto it = files_by_dir.constBegin(); it != files_by_dir.constEnd();
+       ++it) {
+    timer.start();
+    const QSet<QString> entries =
+        QDir(it.key())
+            .entryList(QDir::Files | QDir::Hidden | QDir::System)
+            .toSet();
+
+    for (const FileToCheck& file : it.value()) {
+      // A case insensitive file system can have the file under another case.
+      const bool exists = entries.contains(QFileInfo(file.path_).fileName()) ||
+                          QFile::exists(file.path_);
+      checked << CheckedFile{file, exists};
+    }
+
+    if (timer.elapsed() > kSlowMountMsec) {
+      qLog(Warning) << "Not checking the rest of the files near" << it.key()
+                    << "because the check took" << timer.elapsed() << "ms";
+      break;
+    }
+  }
+  return checked;
+}
+
+// Returns the items of the files that could be checked and were found, or
+// weren't.
+PlaylistItemList CheckFiles(const FilesToCheck& files, bool exist) {
+  // Longest mount points first, so each file goes to the innermost one.
+  QStringList mount_points;
+  for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+    mount_points << storage.rootPath();
+  }
+  std::sort(mount_points.begin(), mount_points.end(),
+            [](const QString& a, const QString& b) {
+              return a.length() > b.length();
+            });
+
+  QMap<QString, FilesToCheck> files_by_mount;
+  for (const FileToCheck& file : files) {
+    QString mount;
+    for (const QString& mount_point : mount_points) {
+      if (file.path_.startsWith(mount_point)) {
+        mount = mount_point;
+        break;
       }
-      found_duplicate = true;
     }
+    files_by_mount[mount] << file;
+  }
+
+  // One mount being slow doesn't hold up the others.
+  QList<FilesToCheck> groups = files_by_mount.values();
+  QFuture<CheckedFiles> future =
+      QtConcurrent::mapped(groups, &CheckFilesOnMount);
+  future.waitForFinished();
 
-    if (!found_duplicate) {
-      unique_songs.insert(std::make_pair(song, row));
+  PlaylistItemList ret;
+  for (const CheckedFiles& checked : future.results()) {
+    for (const CheckedFile& file : checked) {
+      if (file.exists_ == exist) ret << file.file_.item_;
     }
   }
+  return ret;
+}
 
-  removeRows(rows_to_remove);
+PlaylistItemList FindUnavailableFiles(const FilesToCheck& files) {
+  return CheckFiles(files, false);
+}
+
+PlaylistItemList FindAvailableFiles(const FilesToCheck& files) {
+  return CheckFiles(files, true);
 }
 
+}  // namespace
+
 void Playlist::RemoveUnavailableSongs() {
+  FilesToCheck files;
+  for (const PlaylistItemPtr& item : items_) {
+    const Song song = item->Metadata();
+
+    // check only local files
+    if (song.url().isLocalFile()) {
+      files << FileToCheck{song.url().toLocalFile(), item};
+    }
+  }
+  if (files.isEmpty()) return;
+
+  QFuture<PlaylistItemList> future =
+      Executor::Io()->Run<PlaylistItemList>(
+          [files]() { return FindUnavailableFiles(files); });
+  NewClosure(future, this,
+             SLOT(UnavailableSongsFound(QFuture<PlaylistItemList>)), future);
+}
+
+void Playlist::UnavailableSongsFound(QFuture<PlaylistItemList> future) {
+  const PlaylistItemList unavailable = future.result();
+  if (unavailable.isEmpty()) return;
+
+  // The playlist might have changed while the files were being checked, so
+  // find the items again.
+  QSet<const PlaylistItem*> items;
+  for (const PlaylistItemPtr& item : unavailable) items.insert(item.get());
+
   QList<int> rows_to_remove;
+  for (int row = 0; row < items_.count(); ++row) {
+    if (items.contains(items_[row].get())) rows_to_remove << row;
+  }
+
+  RemoveRowsInOneStep(rows_to_remove);
+}
+
+void Playlist::InvalidateDeletedSongs() {
+  // Files that are greyed out are looked for to see if they've come back, the
+  // others to see if they've gone.
+  FilesToCheck present_files;
+  FilesToCheck missing_files;
   for (int row = 0; row < items_.count(); ++row) {
     PlaylistItemPtr item = items_[row];
-    const Song& song = item->Metadata();
+    const Song song = item->Metadata();
+    if (song.is_stream()) continue;
 
-    // check only local files
-    if (song.url().isLocalFile() && !QFile::exists(song.url().toLocalFile())) {
-      rows_to_remove.append(row);
+    // The library watcher already knows which library songs have gone, and
+    // tells us when that changes through LibrarySongsAvailabilityChanged.
+    if (item->IsLocalLibraryItem()) {
+      if (SetItemMissing(item, song.is_unavailable())) QueueRowChanged(row);
+      continue;
+    }
+
+    const FileToCheck file{song.url().toLocalFile(), item};
+    if (item->HasForegroundColor(kInvalidSongPriority)) {
+      missing_files << file;
+    } else {
+      present_files << file;
     }
   }
 
-  removeRows(rows_to_remove);
+  if (!present_files.isEmpty()) {
+    QFuture<PlaylistItemList> future = Executor::Io()->Run<PlaylistItemList>(
+        [present_files]() { return FindUnavailableFiles(present_files); });
+    NewClosure(future, this,
+               SLOT(DeletedSongsFound(QFuture<PlaylistItemList>, bool)),
+               future, true);
+  }
+  if (!missing_files.isEmpty()) {
+    QFuture<PlaylistItemList> future = Executor::Io()->Run<PlaylistItemList>(
+        [missing_files]() { return FindAvailableFiles(missing_files); });
+    NewClosure(future, this,
+               SLOT(DeletedSongsFound(QFuture<PlaylistItemList>, bool)),
+               future, false);
+  }
+}
+
+void Playlist::DeletedSongsFound(QFuture<PlaylistItemList> future,
+                                 bool missing) {
+  const PlaylistItemList found = future.result();
+  if (found.isEmpty()) return;
+
+  // The playlist might have changed while the files were being checked, so
+  // find the items again.
+  QSet<PlaylistItem*> items;
+  for (const PlaylistItemPtr& item : found) items.insert(item.get());
+
+  QList<int> rows;
+  for (int row = 0; row < items_.count(); ++row) {
+    PlaylistItemPtr item = items_[row];
+    if (items.contains(item.get()) && SetItemMissing(item, missing)) {
+      rows << row;
+    }
+  }
+
+  ReloadItems(rows);
+}
+
+void Playlist::RemoveRowsInOneStep(const QList<int>& rows) {
+  if (rows.isEmpty()) return;
+
+  if (rows.count() > kUndoItemLimit) {
+    // Too big to keep in the undo stack. Also clear the stack because it
+    // might have been invalidated.
+    RemoveItemsWithoutUndo(rows);
+    undo_stack_->clear();
+  } else {
+    undo_stack_->push(new PlaylistUndoCommands::RemoveItems(this, rows));
+  }
 }
 
 bool Playlist::ApplyValidityOnCurrentSong(const QUrl& url, bool valid) {
@@ -2344,6 +2744,7 @@ void Playlist::SkipTracks(const QModelIndexList& source_indexes) {
   for (const QModelIndex& source_index : source_indexes) {
     PlaylistItemPtr track_to_skip = item_at(source_index.row());
     track_to_skip->SetShouldSkip(!((track_to_skip)->GetShouldSkip()));
-    emit dataChanged(source_index, source_index);
+    QueueRowChanged(source_index.row(), source_index.column(),
+                    source_index.column());
   }
 }
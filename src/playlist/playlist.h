@@ -19,12 +19,15 @@
 #define PLAYLIST_H
 
 #include <QAbstractItemModel>
+#include <QFuture>
 #include <QList>
+#include <QVector>
 
 #include "core/song.h"
 #include "core/tagreaderclient.h"
 #include "playlistitem.h"
 #include "playlistsequence.h"
+#include "playlistshuffleorder.h"
 #include "smartplaylists/generator_fwd.h"
 
 class LibraryBackend;
@@ -36,6 +39,7 @@ class InternetService;
 class TaskManager;
 
 class QSortFilterProxyModel;
+class QTimer;
 class QUndoStack;
 class QStringList;
 
@@ -163,13 +167,23 @@ class Playlist : public QAbstractListModel {
 
   static const int kUndoStackSize;
   static const int kUndoItemLimit;
+  // Once the undo stack keeps more than this many bytes, the oldest commands
+  // are dropped.
+  static const qint64 kUndoMemoryLimit;
+  // Changes to rows within this long of each other are announced with one
+  // dataChanged per run of rows, about once a frame.
+  static const int kRowChangeBatchMsec;
+  // Playlists with at least this many items to sort are sorted in a
+  // background thread.
+  static const int kMinItemsForBackgroundSort;
+  // Restored playlists are loaded in chunks: one screenful straight away,
+  // then the rest in the background.
+  static const int kRestoreFirstChunkSize;
+  static const int kRestoreChunkSize;
 
   static const qint64 kMinScrobblePointNsecs;
   static const qint64 kMaxScrobblePointNsecs;
 
-  static bool CompareItems(int column, Qt::SortOrder order, PlaylistItemPtr a,
-                           PlaylistItemPtr b, const QStringList& prefixes = {});
-
   static QString column_name(Column column);
   static QString abbreviated_column_name(Column column);
 
@@ -178,8 +192,15 @@ class Playlist : public QAbstractListModel {
                                const QVariant& value);
 
   // Persistence
-  void Save() const;
+  // changed_items are items whose metadata changed in place.  Rows that were
+  // only added, removed or moved are found by the backend.
+  void Save(const PlaylistItemList& changed_items = PlaylistItemList()) const;
+  // Loads the playlist from the database if that hasn't been done yet.
+  // Playlists are only restored when they're first shown or played.
   void Restore();
+  // Like Restore(), but doesn't return until every item has been loaded.
+  // For callers that read the whole playlist, e.g. to save it to a file.
+  void RestoreBlocking();
 
   // Accessors
   QSortFilterProxyModel* proxy() const;
@@ -280,7 +301,9 @@ class Playlist : public QAbstractListModel {
   bool ApplyValidityOnCurrentSong(const QUrl& url, bool valid);
   // Grays out and reloads all deleted songs in all playlists. Also, "ungreys"
   // those songs
-  // which were once deleted but now got restored somehow.
+  // which were once deleted but now got restored somehow.  Library songs
+  // follow the library, other files are looked for a directory at a time in
+  // the background.
   void InvalidateDeletedSongs();
   // Removes from the playlist all local files that don't exist anymore.
   void RemoveDeletedSongs();
@@ -323,9 +346,6 @@ class Playlist : public QAbstractListModel {
   bool removeRows(int row, int count,
                   const QModelIndex& parent = QModelIndex());
 
-  static bool ComparePathDepths(Qt::SortOrder, PlaylistItemPtr,
-                                PlaylistItemPtr);
-
  public slots:
   void set_current_row(int index, bool is_stopping = false);
   void Paused();
@@ -336,6 +356,13 @@ class Playlist : public QAbstractListModel {
   void ClearStreamMetadata();
   void SetStreamMetadata(const QUrl& url, const Song& song);
   void ItemChanged(PlaylistItemPtr item);
+  // Gives the library items for these songs their new metadata, going
+  // through the playlist once however many songs there are.  The rows that
+  // changed are signalled together with the other queued row changes.
+  void LibrarySongsChanged(const SongList& songs);
+  // Greys out the library items for these songs, or restores them.
+  void LibrarySongsAvailabilityChanged(const SongList& songs,
+                                       bool unavailable);
   void UpdateItems(const SongList& songs);
 
   void Clear();
@@ -379,6 +406,11 @@ class Playlist : public QAbstractListModel {
   int NextVirtualIndex(int i, bool ignore_repeat_track) const;
   int PreviousVirtualIndex(int i, bool ignore_repeat_track) const;
   bool FilterContainsVirtualIndex(int i) const;
+  // Brings shuffle_order_ up to date after rows were added, removed or moved,
+  // without shuffling the rows that haven't been played yet again.
+  void UpdateShuffleOrder();
+  // The rows of each album in the playlist, and which one the row is on.
+  QVector<QVector<int>> AlbumGroups(int row, int* group) const;
   void TurnOnDynamicPlaylist(smart_playlists::GeneratorPtr gen);
 
   void InsertInternetItems(const InternetModel* model,
@@ -405,17 +437,30 @@ class Playlist : public QAbstractListModel {
 
   // Removes rows with given indices from this playlist.
   bool removeRows(QList<int>& rows);
+  // Removes the rows, which needn't be next to each other, in one undo step.
+  void RemoveRowsInOneStep(const QList<int>& rows);
+
+  // Repaints the queue numbers of the tracks from position begin in the queue.
+  void QueuePositionsChanged(int begin);
+  // Saves only the queue, when the rows themselves haven't changed.
+  void SaveQueue() const;
 
  private slots:
   void TracksAboutToBeDequeued(const QModelIndex&, int begin, int end);
-  void TracksDequeued();
+  void TracksDequeued(const QModelIndex&, int begin, int end);
   void TracksEnqueued(const QModelIndex&, int begin, int end);
   void QueueLayoutChanged();
   void SongSaveComplete(TagReaderReply* reply,
                         const QPersistentModelIndex& index);
   void ItemReloadComplete(const QPersistentModelIndex& index);
   void ItemsLoaded(QFuture<PlaylistItemList> future);
+  void UnavailableSongsFound(QFuture<PlaylistItemList> future);
+  void DeletedSongsFound(QFuture<PlaylistItemList> future, bool missing);
+  void FinishRestore();
+  void SortFinished(QFuture<QVector<int>> future, int sort_id);
+  void LimitUndoMemory();
   void SongInsertVetoListenerDestroyed();
+  void EmitQueuedRowChanges();
 
  private:
   bool is_loading_;
@@ -432,8 +477,10 @@ class Playlist : public QAbstractListModel {
   bool favorite_;
 
   PlaylistItemList items_;
-  QList<int> virtual_items_;  // Contains the indices into items_ in the order
-                              // that they will be played.
+  // The order that items_ will be played in, and the rows played so far when
+  // shuffled, oldest first.
+  PlaylistShuffleOrder shuffle_order_;
+  QList<QPersistentModelIndex> shuffle_history_;
   // A map of library ID to playlist item - for fast lookups when library
   // items change.
   QMultiMap<int, PlaylistItemPtr> library_items_by_id_;
@@ -441,6 +488,21 @@ class Playlist : public QAbstractListModel {
   QPersistentModelIndex current_item_index_;
   QPersistentModelIndex last_played_item_index_;
   QPersistentModelIndex stop_after_;
+
+  // Marks columns of a row as changed.  dataChanged is emitted for them,
+  // merged with the other rows that changed, the next time
+  // queued_row_changes_timer_ fires.
+  void QueueRowChanged(int row, int first_column = 0,
+                       int last_column = ColumnCount - 1);
+  // Returns true if the item wasn't already in that state.
+  bool SetItemMissing(PlaylistItemPtr item, bool missing);
+  struct QueuedRowChange {
+    QPersistentModelIndex index_;
+    int first_column_;
+    int last_column_;
+  };
+  QList<QueuedRowChange> queued_row_changes_;
+  QTimer* queued_row_changes_timer_;
   bool current_is_paused_;
   int current_virtual_index_;
 
@@ -457,6 +519,21 @@ class Playlist : public QAbstractListModel {
   // Hack to stop QTreeView::setModel sorting the playlist
   bool ignore_sorting_;
 
+  // The sort running in the background, if any.
+  struct PendingSort {
+    PendingSort() : id_(0), column_(0), order_(Qt::AscendingOrder), begin_(0) {}
+
+    int id_;
+    int column_;
+    Qt::SortOrder order_;
+    // Only items from this row on are sorted.
+    int begin_;
+    PlaylistItemList items_;
+  };
+  void ApplySort(const PendingSort& sort, const QVector<int>& rows);
+  PendingSort pending_sort_;
+  int last_sort_id_;
+
   QUndoStack* undo_stack_;
 
   smart_playlists::GeneratorPtr dynamic_playlist_;
@@ -469,6 +546,25 @@ class Playlist : public QAbstractListModel {
   qint64 min_play_count_point_nsecs_;
   qint64 max_play_count_point_nsecs_;
 
+  enum RestoreState { Restore_NotStarted, Restore_Loading, Restore_Finished };
+  void LoadRestoreChunk();
+  void InsertRestoredItems(PlaylistItemList items);
+  RestoreState restore_state_;
+  // How many rows have been read from the database, and where the next
+  // chunk of them goes in the playlist.
+  int restore_offset_;
+  int restore_row_;
+  // The chunk that's being read in the background, if there is one.
+  QFuture<PlaylistItemList> restore_future_;
+  // Every item read from the database so far, by its saved row, so that the
+  // saved queue and last played row can be mapped to the rows the items ended
+  // up in.  Items that weren't restored are null.
+  PlaylistItemList restored_items_;
+  int RestoredRow(int saved_row) const;
+  // Saves that were asked for before the playlist was restored.
+  mutable bool save_pending_;
+  mutable PlaylistItemList pending_changed_items_;
+
   // Cancel async restore if songs are already replaced
   bool cancel_restore_;
 };
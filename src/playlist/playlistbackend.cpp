@@ -20,7 +20,10 @@
 #include <QFile>
 #include <QHash>
 #include <QMutexLocker>
+#include <QSettings>
+#include <QSet>
 #include <QSqlQuery>
+#include <QVector>
 #include <QtDebug>
 #include <functional>
 #include <memory>
@@ -32,6 +35,7 @@
 #include "core/song.h"
 #include "library/librarybackend.h"
 #include "library/sqlrow.h"
+#include "playlist/playlist.h"
 #include "playlist/songplaylistitem.h"
 #include "playlistparsers/cueparser.h"
 #include "smartplaylists/generator.h"
@@ -42,6 +46,62 @@ using std::placeholders::_1;
 using smart_playlists::GeneratorPtr;
 
 const int PlaylistBackend::kSongTableJoins = 4;
+// schema-58.sql uses the same spacing.
+const qint64 PlaylistBackend::kSortKeySpacing = 1024;
+
+namespace {
+
+// The queue is stored as a list of rows separated by commas.
+QString QueueToString(const QList<int>& queue) {
+  QStringList ret;
+  for (int row : queue) ret << QString::number(row);
+  return ret.join(",");
+}
+
+QList<int> QueueFromString(const QString& queue) {
+  QList<int> ret;
+  for (const QString& row : queue.split(',', QString::SkipEmptyParts)) {
+    bool ok = false;
+    const int value = row.toInt(&ok);
+    if (ok) ret << value;
+  }
+  return ret;
+}
+
+// Returns which of the values form the longest strictly increasing
+// subsequence, ignoring negative values.
+QVector<bool> LongestIncreasingRun(const QVector<int>& values) {
+  // tails[i] is the index of the smallest value that ends an increasing run of
+  // length i + 1, previous[] links each value to the one before it in its run.
+  QVector<int> tails;
+  QVector<int> previous(values.count(), -1);
+  for (int i = 0; i < values.count(); ++i) {
+    if (values[i] < 0) continue;
+
+    int lo = 0;
+    int hi = tails.count();
+    while (lo < hi) {
+      const int mid = (lo + hi) / 2;
+      if (values[tails[mid]] < values[i])
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo > 0) previous[i] = tails[lo - 1];
+    if (lo == tails.count())
+      tails << i;
+    else
+      tails[lo] = i;
+  }
+
+  QVector<bool> ret(values.count(), false);
+  for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = previous[i]) {
+    ret[i] = true;
+  }
+  return ret;
+}
+
+}  // namespace
 
 PlaylistBackend::PlaylistBackend(Application* app, QObject* parent)
     : QObject(parent), app_(app), db_(app_->database()) {}
@@ -81,7 +141,7 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(
   q.prepare(
       "SELECT ROWID, name, last_played, dynamic_playlist_type,"
       "       dynamic_playlist_data, dynamic_playlist_backend,"
-      "       special_type, ui_path, is_favorite"
+      "       special_type, ui_path, is_favorite, queue"
       " FROM playlists"
       " " +
       condition + " ORDER BY ui_order");
@@ -99,6 +159,7 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(
     p.special_type = q.value(6).toString();
     p.ui_path = q.value(7).toString();
     p.favorite = q.value(8).toBool();
+    p.queue = QueueFromString(q.value(9).toString());
     ret << p;
   }
 
@@ -113,7 +174,7 @@ PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(int id) {
   q.prepare(
       "SELECT ROWID, name, last_played, dynamic_playlist_type,"
       "       dynamic_playlist_data, dynamic_playlist_backend,"
-      "       special_type, ui_path, is_favorite"
+      "       special_type, ui_path, is_favorite, queue"
       " FROM playlists"
       " WHERE ROWID=:id");
   q.bindValue(":id", id);
@@ -132,11 +193,13 @@ PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(int id) {
   p.special_type = q.value(6).toString();
   p.ui_path = q.value(7).toString();
   p.favorite = q.value(8).toBool();
+  p.queue = QueueFromString(q.value(9).toString());
 
   return p;
 }
 
-QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
+QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist, int limit,
+                                           const SavedItem* after) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
@@ -151,7 +214,7 @@ QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
                   "       p.ROWID, " +
                   Song::JoinSpec("p") +
                   ","
-                  "       p.type, p.radio_service"
+                  "       p.type, p.radio_service, p.sort_key"
                   " FROM playlist_items AS p"
                   " LEFT JOIN songs"
                   "    ON p.library_id = songs.ROWID"
@@ -160,18 +223,48 @@ QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
                   " LEFT JOIN jamendo.songs AS jamendo_songs"
                   "    ON p.library_id = jamendo_songs.ROWID"
                   " WHERE p.playlist = :playlist";
+  // Carry on from where the previous chunk stopped rather than using OFFSET,
+  // which would step over all the rows before it again.
+  if (after) {
+    query +=
+        " AND (p.sort_key > :after_sort_key"
+        "      OR (p.sort_key = :after_sort_key2 AND p.ROWID > :after_rowid))";
+  }
+  query += " ORDER BY p.sort_key, p.ROWID";
+  if (limit != -1) query += " LIMIT :limit";
+
   QSqlQuery q(db);
   // Forward iterations only may be faster
   q.setForwardOnly(true);
   q.prepare(query);
   q.bindValue(":playlist", playlist);
+  if (after) {
+    q.bindValue(":after_sort_key", after->sort_key);
+    q.bindValue(":after_sort_key2", after->sort_key);
+    q.bindValue(":after_rowid", after->rowid);
+  }
+  if (limit != -1) q.bindValue(":limit", limit);
   q.exec();
 
   return q;
 }
 
-QList<PlaylistItemPtr> PlaylistBackend::GetPlaylistItems(int playlist) {
-  QSqlQuery q = GetPlaylistRows(playlist);
+QList<PlaylistItemPtr> PlaylistBackend::GetPlaylistItems(int playlist,
+                                                         int offset,
+                                                         int limit) {
+  SavedItem after;
+  if (offset > 0) {
+    QMutexLocker l(&saved_items_mutex_);
+    const SavedItemList loading = loading_items_.value(playlist);
+    if (loading.count() != offset) {
+      qLog(Warning) << "Playlist" << playlist
+                    << "was saved while it was being loaded";
+      return QList<PlaylistItemPtr>();
+    }
+    after = loading.last();
+  }
+
+  QSqlQuery q = GetPlaylistRows(playlist, limit, offset > 0 ? &after : nullptr);
   // Note that as this only accesses the query, not the db, we don't need the
   // mutex.
   if (db_->CheckErrors(q)) return QList<PlaylistItemPtr>();
@@ -180,8 +273,38 @@ QList<PlaylistItemPtr> PlaylistBackend::GetPlaylistItems(int playlist) {
   // same CUE so we're caching results of parsing CUEs
   std::shared_ptr<NewSongFromQueryState> state_ptr(new NewSongFromQueryState());
   QList<PlaylistItemPtr> playlistitems;
+
+  // Remember which row each item came from, so the next save only has to
+  // write the rows that change.
+  const int rowid_column = (Song::kColumns.count() + 1) * (kSongTableJoins - 1);
+  const int sort_key_column = (Song::kColumns.count() + 1) * kSongTableJoins + 2;
+  SavedItemList saved;
+
   while (q.next()) {
-    playlistitems << NewPlaylistItemFromQuery(SqlRow(q), state_ptr);
+    // The items copy what they need out of the row, so it doesn't have to be
+    // copied first.
+    const SqlRow row = SqlRow::View(q);
+    PlaylistItemPtr item = NewPlaylistItemFromQuery(row, state_ptr);
+    playlistitems << item;
+    saved << SavedItem(item, row.toInt(rowid_column),
+                       row.toLongLong(sort_key_column));
+  }
+
+  InternStrings(playlistitems);
+
+  QMutexLocker l(&saved_items_mutex_);
+  if (offset == 0) {
+    saved_items_.remove(playlist);
+    loading_items_[playlist] = saved;
+  } else if (loading_items_.value(playlist).count() == offset) {
+    loading_items_[playlist] << saved;
+  } else {
+    // A save replaced the rows while this chunk was being read.
+    return playlistitems;
+  }
+
+  if (limit == -1 || playlistitems.count() < limit) {
+    saved_items_[playlist] = loading_items_.take(playlist);
   }
   return playlistitems;
 }
@@ -197,7 +320,7 @@ QList<Song> PlaylistBackend::GetPlaylistSongs(int playlist) {
   std::shared_ptr<NewSongFromQueryState> state_ptr(new NewSongFromQueryState());
   QList<Song> songs;
   while (q.next()) {
-    songs << NewSongFromQuery(SqlRow(q), state_ptr);
+    songs << NewSongFromQuery(SqlRow::View(q), state_ptr);
   }
   return songs;
 }
@@ -208,7 +331,7 @@ PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(
   const int playlist_row = (Song::kColumns.count() + 1) * kSongTableJoins;
 
   PlaylistItemPtr item(
-      PlaylistItem::NewFromType(row.value(playlist_row).toString()));
+      PlaylistItem::NewFromType(row.toString(playlist_row)));
   if (item) {
     item->InitFromQuery(row);
     return RestoreCueData(item, state);
@@ -217,6 +340,16 @@ PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(
   }
 }
 
+void PlaylistBackend::InternStrings(const PlaylistItemList& items) {
+  QSettings s;
+  s.beginGroup(Playlist::kSettingsGroup);
+  if (!s.value("compact_items", true).toBool()) return;
+
+  for (PlaylistItemPtr item : items) {
+    if (item) item->InternStrings();
+  }
+}
+
 Song PlaylistBackend::NewSongFromQuery(
     const SqlRow& row, std::shared_ptr<NewSongFromQueryState> state) {
   return NewPlaylistItemFromQuery(row, state)->Metadata();
@@ -278,53 +411,55 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(
 
 void PlaylistBackend::SavePlaylistAsync(int playlist,
                                         const PlaylistItemList& items,
-                                        int last_played, GeneratorPtr dynamic) {
+                                        int last_played, GeneratorPtr dynamic,
+                                        const QList<int>& queue,
+                                        const PlaylistItemList& changed_items) {
   metaObject()->invokeMethod(
       this, "SavePlaylist", Qt::QueuedConnection, Q_ARG(int, playlist),
       Q_ARG(PlaylistItemList, items), Q_ARG(int, last_played),
-      Q_ARG(smart_playlists::GeneratorPtr, dynamic));
+      Q_ARG(smart_playlists::GeneratorPtr, dynamic),
+      Q_ARG(QList<int>, queue), Q_ARG(PlaylistItemList, changed_items));
+}
+
+void PlaylistBackend::SaveQueueAsync(int playlist, const QList<int>& queue) {
+  metaObject()->invokeMethod(this, "SaveQueue", Qt::QueuedConnection,
+                             Q_ARG(int, playlist), Q_ARG(QList<int>, queue));
 }
 
 void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList& items,
-                                   int last_played, GeneratorPtr dynamic) {
+                                   int last_played, GeneratorPtr dynamic,
+                                   const QList<int>& queue,
+                                   const PlaylistItemList& changed_items) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   qLog(Debug) << "Saving playlist" << playlist;
 
-  QSqlQuery clear(db);
-  clear.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
-  QSqlQuery insert(db);
-  insert.prepare(
-      "INSERT INTO playlist_items"
-      " (playlist, type, library_id, radio_service, " +
-      Song::kColumnSpec +
-      ")"
-      " VALUES (:playlist, :type, :library_id, :radio_service, " +
-      Song::kBindSpec + ")");
   QSqlQuery update(db);
   update.prepare(
       "UPDATE playlists SET "
       "   last_played=:last_played,"
       "   dynamic_playlist_type=:dynamic_type,"
       "   dynamic_playlist_data=:dynamic_data,"
-      "   dynamic_playlist_backend=:dynamic_backend"
+      "   dynamic_playlist_backend=:dynamic_backend,"
+      "   queue=:queue"
       " WHERE ROWID=:playlist");
 
-  ScopedTransaction transaction(&db);
-
-  // Clear the existing items in the playlist
-  clear.bindValue(":playlist", playlist);
-  clear.exec();
-  if (db_->CheckErrors(clear)) return;
+  bool have_saved = false;
+  SavedItemList saved;
+  {
+    QMutexLocker saved_l(&saved_items_mutex_);
+    have_saved = saved_items_.contains(playlist);
+    saved = saved_items_.value(playlist);
+  }
 
-  // Save the new ones
-  for (PlaylistItemPtr item : items) {
-    insert.bindValue(":playlist", playlist);
-    item->BindToQuery(&insert);
+  ScopedTransaction transaction(&db);
 
-    insert.exec();
-    db_->CheckErrors(insert);
+  SavedItemList result;
+  if (!have_saved || !SavePlaylistChanges(playlist, saved, items,
+                                          changed_items, db, &result)) {
+    result.clear();
+    if (!SavePlaylistItems(playlist, items, db, &result)) return;
   }
 
   // Update the last played track number
@@ -338,11 +473,191 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList& items,
     update.bindValue(":dynamic_data", QByteArray());
     update.bindValue(":dynamic_backend", QString());
   }
+  update.bindValue(":queue", QueueToString(queue));
   update.bindValue(":playlist", playlist);
   update.exec();
   if (db_->CheckErrors(update)) return;
 
   transaction.Commit();
+
+  QMutexLocker saved_l(&saved_items_mutex_);
+  saved_items_[playlist] = result;
+  loading_items_.remove(playlist);
+}
+
+void PlaylistBackend::SaveQueue(int playlist, const QList<int>& queue) {
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(db);
+  q.prepare("UPDATE playlists SET queue=:queue WHERE ROWID=:playlist");
+  q.bindValue(":queue", QueueToString(queue));
+  q.bindValue(":playlist", playlist);
+  q.exec();
+  db_->CheckErrors(q);
+}
+
+bool PlaylistBackend::SavePlaylistChanges(int playlist,
+                                          const SavedItemList& saved,
+                                          const PlaylistItemList& items,
+                                          const PlaylistItemList& changed_items,
+                                          QSqlDatabase& db,
+                                          SavedItemList* result) {
+  QHash<const PlaylistItem*, int> saved_rows;
+  for (int i = 0; i < saved.count(); ++i) {
+    saved_rows.insert(saved[i].item.get(), i);
+  }
+  QSet<const PlaylistItem*> changed;
+  for (const PlaylistItemPtr& item : changed_items) {
+    changed.insert(item.get());
+  }
+
+  // Where each item was in saved, or -1 if it needs a new row.  Changed items
+  // get new rows as well, the old ones are deleted.
+  QVector<int> old_rows(items.count(), -1);
+  QVector<bool> reused(saved.count(), false);
+  for (int i = 0; i < items.count(); ++i) {
+    const PlaylistItem* item = items[i].get();
+    if (changed.contains(item)) continue;
+
+    auto it = saved_rows.constFind(item);
+    if (it != saved_rows.constEnd() && !reused[it.value()]) {
+      old_rows[i] = it.value();
+      reused[it.value()] = true;
+    }
+  }
+
+  // The items that are still in the same order keep their sort keys, the
+  // others are moved between them.
+  const QVector<bool> keep = LongestIncreasingRun(old_rows);
+  const int kept = keep.count(true);
+  const int removed = saved.count() - reused.count(true);
+  if (removed + items.count() - kept > qMax(1, items.count() / 2)) {
+    return false;
+  }
+
+  QVector<qint64> sort_keys(items.count());
+  for (int i = 0; i < items.count();) {
+    if (keep[i]) {
+      sort_keys[i] = saved[old_rows[i]].sort_key;
+      ++i;
+      continue;
+    }
+
+    // Spread this run of new or moved items between the kept ones either
+    // side of it.
+    int end = i;
+    while (end < items.count() && !keep[end]) ++end;
+    const int count = end - i;
+    const bool has_before = i > 0;
+    const bool has_after = end < items.count();
+    const qint64 before = has_before ? sort_keys[i - 1] : 0;
+    const qint64 after = has_after ? saved[old_rows[end]].sort_key : 0;
+
+    qint64 first = 0;
+    qint64 step = kSortKeySpacing;
+    if (has_before && has_after) {
+      step = (after - before) / (count + 1);
+      if (step < 1) return false;  // No room left, renumber everything.
+      first = before + step;
+    } else if (has_before) {
+      first = before + kSortKeySpacing;
+    } else if (has_after) {
+      first = after - count * kSortKeySpacing;
+    } else {
+      first = kSortKeySpacing;
+    }
+
+    for (int j = 0; j < count; ++j) {
+      sort_keys[i + j] = first + j * step;
+    }
+    i = end;
+  }
+
+  QSqlQuery remove(db);
+  remove.prepare("DELETE FROM playlist_items WHERE ROWID = :id");
+  QSqlQuery move(db);
+  move.prepare("UPDATE playlist_items SET sort_key = :sort_key WHERE ROWID = :id");
+  QSqlQuery insert(db);
+  insert.prepare(
+      "INSERT INTO playlist_items"
+      " (playlist, sort_key, type, library_id, radio_service, " +
+      Song::kColumnSpec +
+      ")"
+      " VALUES (:playlist, :sort_key, :type, :library_id, :radio_service, " +
+      Song::kBindSpec + ")");
+
+  for (int i = 0; i < saved.count(); ++i) {
+    if (reused[i]) continue;
+    remove.bindValue(":id", saved[i].rowid);
+    remove.exec();
+    if (db_->CheckErrors(remove)) return false;
+  }
+
+  for (int i = 0; i < items.count(); ++i) {
+    if (old_rows[i] == -1) {
+      if (!InsertPlaylistItem(playlist, items[i], sort_keys[i], &insert,
+                              result)) {
+        return false;
+      }
+      continue;
+    }
+
+    const SavedItem& old = saved[old_rows[i]];
+    if (!keep[i]) {
+      move.bindValue(":sort_key", sort_keys[i]);
+      move.bindValue(":id", old.rowid);
+      move.exec();
+      if (db_->CheckErrors(move)) return false;
+    }
+    *result << SavedItem(items[i], old.rowid, sort_keys[i]);
+  }
+
+  return true;
+}
+
+bool PlaylistBackend::SavePlaylistItems(int playlist,
+                                        const PlaylistItemList& items,
+                                        QSqlDatabase& db,
+                                        SavedItemList* result) {
+  QSqlQuery clear(db);
+  clear.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
+  QSqlQuery insert(db);
+  insert.prepare(
+      "INSERT INTO playlist_items"
+      " (playlist, sort_key, type, library_id, radio_service, " +
+      Song::kColumnSpec +
+      ")"
+      " VALUES (:playlist, :sort_key, :type, :library_id, :radio_service, " +
+      Song::kBindSpec + ")");
+
+  // Clear the existing items in the playlist
+  clear.bindValue(":playlist", playlist);
+  clear.exec();
+  if (db_->CheckErrors(clear)) return false;
+
+  // Save the new ones
+  for (int i = 0; i < items.count(); ++i) {
+    if (!InsertPlaylistItem(playlist, items[i], (i + 1) * kSortKeySpacing,
+                            &insert, result)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PlaylistBackend::InsertPlaylistItem(int playlist, PlaylistItemPtr item,
+                                         qint64 sort_key, QSqlQuery* insert,
+                                         SavedItemList* result) {
+  insert->bindValue(":playlist", playlist);
+  insert->bindValue(":sort_key", sort_key);
+  item->BindToQuery(insert);
+
+  insert->exec();
+  if (db_->CheckErrors(*insert)) return false;
+
+  *result << SavedItem(item, insert->lastInsertId().toInt(), sort_key);
+  return true;
 }
 
 int PlaylistBackend::CreatePlaylist(const QString& name,
@@ -382,6 +697,10 @@ void PlaylistBackend::RemovePlaylist(int id) {
   if (db_->CheckErrors(delete_items)) return;
 
   transaction.Commit();
+
+  QMutexLocker saved_l(&saved_items_mutex_);
+  saved_items_.remove(id);
+  loading_items_.remove(id);
 }
 
 void PlaylistBackend::RenamePlaylist(int id, const QString& new_name) {
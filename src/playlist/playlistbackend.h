@@ -20,6 +20,7 @@
 
 #include <QHash>
 #include <QList>
+#include <QMap>
 #include <QMutex>
 #include <QObject>
 
@@ -29,6 +30,9 @@
 class Application;
 class Database;
 
+class QSqlDatabase;
+class QSqlQuery;
+
 class PlaylistBackend : public QObject {
   Q_OBJECT
 
@@ -50,26 +54,43 @@ class PlaylistBackend : public QObject {
     // Special playlists have different behaviour, eg. the "spotify-search"
     // type has a spotify search box at the top, replacing the ordinary filter.
     QString special_type;
+
+    // The rows in the queue, in the order they'll be played.
+    QList<int> queue;
   };
   typedef QList<Playlist> PlaylistList;
 
   static const int kSongTableJoins;
+  // The gap left between the sort keys of neighbouring items when a playlist
+  // is written in full, so items can be put between them later.
+  static const qint64 kSortKeySpacing;
 
   PlaylistList GetAllPlaylists();
   PlaylistList GetAllOpenPlaylists();
   PlaylistList GetAllFavoritePlaylists();
   PlaylistBackend::Playlist GetPlaylist(int id);
 
-  QList<PlaylistItemPtr> GetPlaylistItems(int playlist);
+  // Loads limit items (all of them if limit is -1), starting offset items
+  // into the playlist.  Chunks have to be loaded in order, and the rows only
+  // count as saved once a chunk comes back with fewer than limit items.
+  QList<PlaylistItemPtr> GetPlaylistItems(int playlist, int offset = 0,
+                                          int limit = -1);
   QList<Song> GetPlaylistSongs(int playlist);
 
   void SetPlaylistOrder(const QList<int>& ids);
   void SetPlaylistUiPath(int id, const QString& path);
 
   int CreatePlaylist(const QString& name, const QString& special_type);
+  // Only writes the rows that changed since the playlist was last saved or
+  // loaded: items that were added, removed or moved, and changed_items, whose
+  // metadata changed in place.
   void SavePlaylistAsync(int playlist, const PlaylistItemList& items,
-                         int last_played,
-                         smart_playlists::GeneratorPtr dynamic);
+                         int last_played, smart_playlists::GeneratorPtr dynamic,
+                         const QList<int>& queue,
+                         const PlaylistItemList& changed_items =
+                             PlaylistItemList());
+  // Saves just the queue, as rows of the playlist as it was last saved.
+  void SaveQueueAsync(int playlist, const QList<int>& queue);
   void RenamePlaylist(int id, const QString& new_name);
   void FavoritePlaylist(int id, bool is_favorite);
   void RemovePlaylist(int id);
@@ -78,7 +99,10 @@ class PlaylistBackend : public QObject {
 
  public slots:
   void SavePlaylist(int playlist, const PlaylistItemList& items,
-                    int last_played, smart_playlists::GeneratorPtr dynamic);
+                    int last_played, smart_playlists::GeneratorPtr dynamic,
+                    const QList<int>& queue,
+                    const PlaylistItemList& changed_items);
+  void SaveQueue(int playlist, const QList<int>& queue);
 
  private:
   struct NewSongFromQueryState {
@@ -86,12 +110,40 @@ class PlaylistBackend : public QObject {
     QMutex mutex_;
   };
 
-  QSqlQuery GetPlaylistRows(int playlist);
+  // A row of playlist_items as it was last read or written.
+  struct SavedItem {
+    SavedItem() : rowid(-1), sort_key(0) {}
+    SavedItem(PlaylistItemPtr i, int r, qint64 k)
+        : item(i), rowid(r), sort_key(k) {}
+
+    PlaylistItemPtr item;
+    int rowid;
+    qint64 sort_key;
+  };
+  typedef QList<SavedItem> SavedItemList;
+
+  // Reads up to limit rows, or all of them if limit is -1, that come after
+  // the row after in sort order.
+  QSqlQuery GetPlaylistRows(int playlist, int limit = -1,
+                            const SavedItem* after = nullptr);
+
+  // Writes the difference between saved and items.  Returns false without
+  // writing anything if that's no cheaper than writing the whole playlist.
+  bool SavePlaylistChanges(int playlist, const SavedItemList& saved,
+                           const PlaylistItemList& items,
+                           const PlaylistItemList& changed_items,
+                           QSqlDatabase& db, SavedItemList* result);
+  bool SavePlaylistItems(int playlist, const PlaylistItemList& items,
+                         QSqlDatabase& db, SavedItemList* result);
+  bool InsertPlaylistItem(int playlist, PlaylistItemPtr item, qint64 sort_key,
+                          QSqlQuery* insert, SavedItemList* result);
 
   Song NewSongFromQuery(const SqlRow& row,
                         std::shared_ptr<NewSongFromQueryState> state);
   PlaylistItemPtr NewPlaylistItemFromQuery(
       const SqlRow& row, std::shared_ptr<NewSongFromQueryState> state);
+  // Shares the tag strings of items with the ones other songs already hold.
+  void InternStrings(const PlaylistItemList& items);
   PlaylistItemPtr RestoreCueData(PlaylistItemPtr item,
                                  std::shared_ptr<NewSongFromQueryState> state);
 
@@ -104,6 +156,13 @@ class PlaylistBackend : public QObject {
 
   Application* app_;
   Database* db_;
+
+  // What's in playlist_items for each playlist.  Written by the database
+  // thread and the threads that load playlists.
+  QMutex saved_items_mutex_;
+  QMap<int, SavedItemList> saved_items_;
+  // The rows read so far for playlists that are being loaded in chunks.
+  QMap<int, SavedItemList> loading_items_;
 };
 
 #endif  // PLAYLISTBACKEND_H
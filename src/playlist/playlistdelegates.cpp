@@ -17,6 +17,7 @@
 
 #include "playlistdelegates.h"
 
+#include <QApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QFuture>
@@ -29,8 +30,8 @@
 #include <QTextDocument>
 #include <QToolTip>
 #include <QWhatsThis>
-#include <QtConcurrentRun>
 
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/player.h"
 #include "core/utilities.h"
@@ -52,6 +53,7 @@ const int QueuedItemDelegate::kQueueOpacitySteps = 10;
 const float QueuedItemDelegate::kQueueOpacityLowerBound = 0.4;
 
 const int PlaylistDelegateBase::kMinHeight = 19;
+const int PlaylistDelegateBase::kElidedTextCacheSize = 5000;
 
 QueuedItemDelegate::QueuedItemDelegate(QObject* parent, int indicator_column)
     : QStyledItemDelegate(parent), indicator_column_(indicator_column) {}
@@ -60,7 +62,12 @@ void QueuedItemDelegate::paint(QPainter* painter,
                                const QStyleOptionViewItem& option,
                                const QModelIndex& index) const {
   QStyledItemDelegate::paint(painter, option, index);
+  DrawQueueIndicator(painter, option, index);
+}
 
+void QueuedItemDelegate::DrawQueueIndicator(QPainter* painter,
+                                            const QStyleOptionViewItem& option,
+                                            const QModelIndex& index) const {
   if (index.column() == indicator_column_) {
     bool ok = false;
     const int queue_pos = index.data(Playlist::Role_QueuePosition).toInt(&ok);
@@ -135,7 +142,8 @@ PlaylistDelegateBase::PlaylistDelegateBase(QObject* parent,
                                            const QString& suffix)
     : QueuedItemDelegate(parent),
       view_(qobject_cast<QTreeView*>(parent)),
-      suffix_(suffix) {}
+      suffix_(suffix),
+      elided_text_(kElidedTextCacheSize) {}
 
 QString PlaylistDelegateBase::displayText(const QVariant& value,
                                           const QLocale&) const {
@@ -174,7 +182,19 @@ QSize PlaylistDelegateBase::sizeHint(const QStyleOptionViewItem& option,
 void PlaylistDelegateBase::paint(QPainter* painter,
                                  const QStyleOptionViewItem& option,
                                  const QModelIndex& index) const {
-  QueuedItemDelegate::paint(painter, Adjusted(option, index), index);
+  const QStyleOptionViewItem adjusted = Adjusted(option, index);
+
+  // Does what QStyledItemDelegate::paint does, but with the text already
+  // elided.
+  QStyleOptionViewItem opt(adjusted);
+  initStyleOption(&opt, index);
+  ElideText(&opt);
+
+  const QWidget* widget = opt.widget;
+  QStyle* style = widget ? widget->style() : QApplication::style();
+  style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+  DrawQueueIndicator(painter, adjusted, index);
 
   // Stop after indicator
   if (index.column() == Playlist::Column_Title) {
@@ -187,6 +207,33 @@ void PlaylistDelegateBase::paint(QPainter* painter,
   }
 }
 
+void PlaylistDelegateBase::ElideText(QStyleOptionViewItem* option) const {
+  if (option->text.isEmpty() || option->textElideMode == Qt::ElideNone) return;
+
+  const QWidget* widget = option->widget;
+  QStyle* style = widget ? widget->style() : QApplication::style();
+  const int margin =
+      style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+  int width = option->rect.width() - margin * 2;
+  if (option->features & QStyleOptionViewItem::HasDecoration) {
+    width -= option->decorationSize.width() + margin * 2;
+  }
+  if (width <= 0) return;
+
+  const QString key = option->font.key() + QChar(0) + QString::number(width) +
+                      QChar(0) + QString::number(option->textElideMode) +
+                      QChar(0) + option->text;
+  if (const QString* elided = elided_text_.object(key)) {
+    option->text = *elided;
+    return;
+  }
+
+  const QString elided = option->fontMetrics.elidedText(
+      option->text, option->textElideMode, width);
+  elided_text_.insert(key, new QString(elided));
+  option->text = elided;
+}
+
 QStyleOptionViewItem PlaylistDelegateBase::Adjusted(
     const QStyleOptionViewItem& option, const QModelIndex& index) const {
   if (!view_) return option;
@@ -401,7 +448,9 @@ TagCompleter::TagCompleter(LibraryBackend* backend, Playlist::Column column,
                            QLineEdit* editor)
     : QCompleter(editor), editor_(editor) {
   QFuture<TagCompletionModel*> future =
-      QtConcurrent::run(&InitCompletionModel, backend, column);
+      Executor::Db()->Run<TagCompletionModel*>([backend, column]() {
+        return InitCompletionModel(backend, column);
+      });
   NewClosure(future, this, SLOT(ModelReady(QFuture<TagCompletionModel*>)),
              future);
 }
@@ -18,6 +18,7 @@
 #ifndef PLAYLISTDELEGATES_H
 #define PLAYLISTDELEGATES_H
 
+#include <QCache>
 #include <QCompleter>
 #include <QPixmapCache>
 #include <QStringListModel>
@@ -41,6 +42,10 @@ class QueuedItemDelegate : public QStyledItemDelegate {
 
   int queue_indicator_size(const QModelIndex& index) const;
 
+ protected:
+  void DrawQueueIndicator(QPainter* painter, const QStyleOptionViewItem& option,
+                          const QModelIndex& index) const;
+
  private:
   static const int kQueueBoxBorder;
   static const int kQueueBoxCornerRadius;
@@ -67,14 +72,22 @@ class PlaylistDelegateBase : public QueuedItemDelegate {
                                 const QModelIndex& index) const;
 
   static const int kMinHeight;
+  static const int kElidedTextCacheSize;
 
  public slots:
   bool helpEvent(QHelpEvent* event, QAbstractItemView* view,
                  const QStyleOptionViewItem& option, const QModelIndex& index);
 
  protected:
+  // Shortens option's text to fit its rect, remembering the result so the
+  // same text isn't elided again every time the view repaints.
+  void ElideText(QStyleOptionViewItem* option) const;
+
   QTreeView* view_;
   QString suffix_;
+
+ private:
+  mutable QCache<QString, QString> elided_text_;
 };
 
 class LengthItemDelegate : public PlaylistDelegateBase {
@@ -17,14 +17,36 @@
 
 #include "playlistfilter.h"
 
+#include <QPair>
+#include <QThread>
+#include <QtConcurrentMap>
 #include <QtDebug>
 
 #include "playlistfilterparser.h"
 
+namespace {
+
+// Reads the values cached in a PlaylistFilter::FoldedItem.
+class FoldedFilterRow : public FilterRow {
+ public:
+  explicit FoldedFilterRow(const QVector<QString>& columns)
+      : columns_(columns) {}
+  QString column(int column) const { return columns_[column]; }
+
+ private:
+  const QVector<QString>& columns_;
+};
+
+}  // namespace
+
+const int PlaylistFilter::kMinRowsForParallelFilter = 2000;
+const int PlaylistFilter::kCachedFilters = 4;
+
 PlaylistFilter::PlaylistFilter(QObject* parent)
     : QSortFilterProxyModel(parent),
       filter_tree_(new NopFilter),
-      query_hash_(0) {
+      query_hash_(0),
+      row_states_valid_(false) {
   setDynamicSortFilter(true);
 
   column_names_["title"] = Playlist::Column_Title;
@@ -62,8 +84,62 @@ void PlaylistFilter::sort(int column, Qt::SortOrder order) {
   sourceModel()->sort(column, order);
 }
 
+void PlaylistFilter::setSourceModel(QAbstractItemModel* source_model) {
+  if (sourceModel()) {
+    sourceModel()->disconnect(this);
+  }
+
+  // Connect these before QSortFilterProxyModel does, so our cached state is
+  // up to date by the time it asks about the changed rows.
+  if (source_model) {
+    connect(source_model, SIGNAL(dataChanged(QModelIndex, QModelIndex)),
+            SLOT(SourceDataChanged(QModelIndex, QModelIndex)));
+    connect(source_model, SIGNAL(rowsInserted(QModelIndex, int, int)),
+            SLOT(SourceRowsInserted(QModelIndex, int, int)));
+    connect(source_model, SIGNAL(rowsRemoved(QModelIndex, int, int)),
+            SLOT(SourceRowsRemoved(QModelIndex, int, int)));
+    connect(source_model,
+            SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)),
+            SLOT(SourceRowsReordered()));
+    connect(source_model, SIGNAL(layoutChanged()),
+            SLOT(SourceRowsReordered()));
+    connect(source_model, SIGNAL(modelReset()), SLOT(SourceRowsReordered()));
+  }
+
+  folded_items_.clear();
+  row_states_valid_ = false;
+  cached_row_states_.clear();
+
+  QSortFilterProxyModel::setSourceModel(source_model);
+}
+
 bool PlaylistFilter::filterAcceptsRow(int row,
                                       const QModelIndex& parent) const {
+  UpdateFilterTree();
+
+  if (filter_tree_->type() == FilterTree::Nop) {
+    return true;
+  }
+
+  if (!row_states_valid_) {
+    FilterAllRows();
+  }
+
+  if (row >= row_states_.count()) {
+    return filter_tree_->accept(ModelFilterRow(row, parent, sourceModel()));
+  }
+
+  // Test the row if it was added or changed since the last time
+  char& state = row_states_[row];
+  if (state == Row_Unknown) {
+    state = filter_tree_->accept(FoldedFilterRow(Fold(row).columns_))
+                ? Row_Accepted
+                : Row_Rejected;
+  }
+  return state == Row_Accepted;
+}
+
+void PlaylistFilter::UpdateFilterTree() const {
   QString filter = filterRegExp().pattern();
 
   uint hash = qHash(filter);
@@ -72,9 +148,171 @@ bool PlaylistFilter::filterAcceptsRow(int row,
     FilterParser p(filter, column_names_, numerical_columns_);
     filter_tree_.reset(p.parse());
 
+    QSet<int> columns;
+    filter_tree_->columns(&columns);
+    filter_columns_ = columns.toList();
+
     query_hash_ = hash;
+    SwitchRowStates(filter.trimmed());
+  }
+}
+
+void PlaylistFilter::SwitchRowStates(const QString& filter) const {
+  if (filter == filter_) return;
+
+  if (row_states_valid_ && !filter_.isEmpty()) {
+    cached_row_states_.prepend(qMakePair(filter_, row_states_));
+  }
+  filter_ = filter;
+  row_states_valid_ = false;
+  row_states_ = RowStates();
+
+  for (int i = 0; i < cached_row_states_.count(); ++i) {
+    if (cached_row_states_[i].first == filter) {
+      row_states_ = cached_row_states_.takeAt(i).second;
+      row_states_valid_ = row_states_.count() == sourceModel()->rowCount();
+      break;
+    }
+  }
+
+  while (cached_row_states_.count() > kCachedFilters) {
+    cached_row_states_.removeLast();
+  }
+}
+
+const PlaylistFilter::FoldedItem& PlaylistFilter::Fold(int row) const {
+  const Playlist* playlist = static_cast<const Playlist*>(sourceModel());
+  const PlaylistItemPtr& item = playlist->item_at(row);
+
+  FoldedItem& folded = folded_items_[item.get()];
+  if (folded.item_.lock() != item) {
+    folded.item_ = item;
+    folded.columns_ = QVector<QString>(Playlist::ColumnCount);
+    folded.folded_ = QBitArray(Playlist::ColumnCount);
   }
 
-  // Test the row
-  return filter_tree_->accept(row, parent, sourceModel());
+  for (int column : filter_columns_) {
+    if (!folded.folded_.testBit(column)) {
+      folded.columns_[column] =
+          ModelFilterRow(row, QModelIndex(), playlist).column(column);
+      folded.folded_.setBit(column);
+    }
+  }
+
+  return folded;
+}
+
+void PlaylistFilter::FilterAllRows() const {
+  const Playlist* playlist = static_cast<const Playlist*>(sourceModel());
+  const int count = playlist->rowCount();
+
+  // Reading from the model is only safe on this thread, so fill in anything
+  // missing from the cache first.  Then the rows can be tested anywhere.
+  QVector<const QVector<QString>*> columns(count);
+  for (int row = 0; row < count; ++row) {
+    Fold(row);
+  }
+  for (int row = 0; row < count; ++row) {
+    columns[row] = &folded_items_.constFind(playlist->item_at(row).get())
+                        ->columns_;
+  }
+
+  row_states_.fill(Row_Unknown, count);
+  char* states = row_states_.data();
+  const FilterTree* tree = filter_tree_.data();
+
+  auto filter_rows = [&](const QPair<int, int>& range) {
+    for (int row = range.first; row < range.second; ++row) {
+      states[row] = tree->accept(FoldedFilterRow(*columns[row]))
+                        ? Row_Accepted
+                        : Row_Rejected;
+    }
+  };
+
+  if (count < kMinRowsForParallelFilter) {
+    filter_rows(qMakePair(0, count));
+  } else {
+    const int chunk_size =
+        qMax(1, count / (qMax(1, QThread::idealThreadCount()) * 4));
+    QList<QPair<int, int>> ranges;
+    for (int start = 0; start < count; start += chunk_size) {
+      ranges << qMakePair(start, qMin(count, start + chunk_size));
+    }
+    QtConcurrent::blockingMap(ranges, filter_rows);
+  }
+
+  row_states_valid_ = true;
+}
+
+void PlaylistFilter::ForgetDeletedItems() {
+  QHash<const PlaylistItem*, FoldedItem>::iterator it = folded_items_.begin();
+  while (it != folded_items_.end()) {
+    if (it->item_.expired()) {
+      it = folded_items_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void PlaylistFilter::SourceDataChanged(const QModelIndex& top_left,
+                                       const QModelIndex& bottom_right) {
+  const Playlist* playlist = static_cast<const Playlist*>(sourceModel());
+
+  for (int row = top_left.row(); row <= bottom_right.row(); ++row) {
+    if (!playlist->has_item_at(row)) continue;
+
+    folded_items_.remove(playlist->item_at(row).get());
+    if (row < row_states_.count()) {
+      row_states_[row] = Row_Unknown;
+    }
+    for (QPair<QString, RowStates>& cached : cached_row_states_) {
+      if (row < cached.second.count()) cached.second[row] = Row_Unknown;
+    }
+  }
+}
+
+bool PlaylistFilter::InsertRows(RowStates* states, int start, int end) {
+  if (start > states->count()) return false;
+  states->insert(start, end - start + 1, Row_Unknown);
+  return true;
+}
+
+bool PlaylistFilter::RemoveRows(RowStates* states, int start, int end) {
+  if (end >= states->count()) return false;
+  states->remove(start, end - start + 1);
+  return true;
+}
+
+void PlaylistFilter::SourceRowsInserted(const QModelIndex& parent, int start,
+                                        int end) {
+  if (!InsertRows(&row_states_, start, end)) row_states_valid_ = false;
+
+  for (auto it = cached_row_states_.begin(); it != cached_row_states_.end();) {
+    if (InsertRows(&it->second, start, end)) {
+      ++it;
+    } else {
+      it = cached_row_states_.erase(it);
+    }
+  }
+}
+
+void PlaylistFilter::SourceRowsRemoved(const QModelIndex& parent, int start,
+                                       int end) {
+  if (!RemoveRows(&row_states_, start, end)) row_states_valid_ = false;
+
+  for (auto it = cached_row_states_.begin(); it != cached_row_states_.end();) {
+    if (RemoveRows(&it->second, start, end)) {
+      ++it;
+    } else {
+      it = cached_row_states_.erase(it);
+    }
+  }
+  ForgetDeletedItems();
+}
+
+void PlaylistFilter::SourceRowsReordered() {
+  row_states_valid_ = false;
+  cached_row_states_.clear();
+  ForgetDeletedItems();
 }
@@ -18,9 +18,13 @@
 #ifndef PLAYLISTFILTER_H
 #define PLAYLISTFILTER_H
 
+#include <QBitArray>
+#include <QHash>
 #include <QScopedPointer>
 #include <QSet>
 #include <QSortFilterProxyModel>
+#include <QVector>
+#include <memory>
 
 #include "playlist.h"
 
@@ -33,17 +37,71 @@ class PlaylistFilter : public QSortFilterProxyModel {
   PlaylistFilter(QObject* parent = nullptr);
   ~PlaylistFilter();
 
+  static const int kMinRowsForParallelFilter;
+  // How many filters' row states are kept besides the current one's.
+  static const int kCachedFilters;
+
   // QAbstractItemModel
   void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 
+  // QAbstractProxyModel
+  void setSourceModel(QAbstractItemModel* source_model);
+
   // QSortFilterProxyModel
   // public so Playlist::NextVirtualIndex and friends can get at it
   bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const;
 
+ private slots:
+  void SourceDataChanged(const QModelIndex& top_left,
+                         const QModelIndex& bottom_right);
+  void SourceRowsInserted(const QModelIndex& parent, int start, int end);
+  void SourceRowsRemoved(const QModelIndex& parent, int start, int end);
+  void SourceRowsReordered();
+
  private:
+  // The lower case values of an item's columns, filled in as filters need
+  // them.  The weak pointer tells us whether the key has been reused by a new
+  // item.
+  struct FoldedItem {
+    std::weak_ptr<PlaylistItem> item_;
+    QVector<QString> columns_;
+    QBitArray folded_;
+  };
+
+  enum RowState { Row_Unknown = 0, Row_Accepted, Row_Rejected };
+  typedef QVector<char> RowStates;
+
+  // Keep a RowStates in step with rows being added to or removed from the
+  // playlist.  False if it can't be, and has to be thrown away.
+  static bool InsertRows(RowStates* states, int start, int end);
+  static bool RemoveRows(RowStates* states, int start, int end);
+
+  void UpdateFilterTree() const;
+  const FoldedItem& Fold(int row) const;
+  // Tests every row against the filter in one go, on several threads if
+  // there are enough of them.
+  void FilterAllRows() const;
+  void ForgetDeletedItems();
+  // Swap the current filter's row states for the cached ones of filter, if
+  // there are any.
+  void SwitchRowStates(const QString& filter) const;
+
   // Mutable because they're modified from filterAcceptsRow() const
   mutable QScopedPointer<FilterTree> filter_tree_;
   mutable uint query_hash_;
+  // The filter without the spaces around it, which don't change what it
+  // matches.
+  mutable QString filter_;
+  mutable QList<int> filter_columns_;
+
+  mutable QHash<const PlaylistItem*, FoldedItem> folded_items_;
+  // A RowState for each source row, valid only if row_states_valid_.
+  mutable QVector<char> row_states_;
+  mutable bool row_states_valid_;
+  // The row states of the filters used before this one, most recent first.
+  // They're kept up to date like row_states_, and forgotten if the playlist is
+  // reordered, so going back to one doesn't have to test any rows.
+  mutable QList<QPair<QString, RowStates>> cached_row_states_;
 
   QMap<QString, int> column_names_;
   QSet<int> numerical_columns_;
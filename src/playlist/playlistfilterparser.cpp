@@ -22,6 +22,10 @@
 #include "core/logging.h"
 #include "playlist.h"
 
+QString ModelFilterRow::column(int column) const {
+  return model_->index(row_, column, parent_).data().toString().toLower();
+}
+
 class SearchTermComparator {
  public:
   virtual ~SearchTermComparator() {}
@@ -189,14 +193,15 @@ class FilterTerm : public FilterTree {
                       const QList<int>& columns)
       : cmp_(comparator), columns_(columns) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
     for (int i : columns_) {
-      QModelIndex idx(model->index(row, i, parent));
-      if (cmp_->Matches(idx.data().toString().toLower())) return true;
+      if (cmp_->Matches(row.column(i))) return true;
     }
     return false;
   }
+  virtual void columns(QSet<int>* columns) const {
+    *columns += columns_.toSet();
+  }
   virtual FilterType type() { return Term; }
 
  private:
@@ -211,11 +216,10 @@ class FilterColumnTerm : public FilterTree {
   FilterColumnTerm(int column, SearchTermComparator* comparator)
       : col(column), cmp_(comparator) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    QModelIndex idx(model->index(row, col, parent));
-    return cmp_->Matches(idx.data().toString().toLower());
+  virtual bool accept(const FilterRow& row) const {
+    return cmp_->Matches(row.column(col));
   }
+  virtual void columns(QSet<int>* columns) const { columns->insert(col); }
   virtual FilterType type() { return Column; }
 
  private:
@@ -227,10 +231,10 @@ class NotFilter : public FilterTree {
  public:
   explicit NotFilter(const FilterTree* inv) : child_(inv) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    return !child_->accept(row, parent, model);
+  virtual bool accept(const FilterRow& row) const {
+    return !child_->accept(row);
   }
+  virtual void columns(QSet<int>* columns) const { child_->columns(columns); }
   virtual FilterType type() { return Not; }
 
  private:
@@ -241,13 +245,17 @@ class OrFilter : public FilterTree {
  public:
   ~OrFilter() { qDeleteAll(children_); }
   virtual void add(FilterTree* child) { children_.append(child); }
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
     for (FilterTree* child : children_) {
-      if (child->accept(row, parent, model)) return true;
+      if (child->accept(row)) return true;
     }
     return false;
   }
+  virtual void columns(QSet<int>* columns) const {
+    for (FilterTree* child : children_) {
+      child->columns(columns);
+    }
+  }
   FilterType type() { return Or; }
 
  private:
@@ -258,13 +266,17 @@ class AndFilter : public FilterTree {
  public:
   virtual ~AndFilter() { qDeleteAll(children_); }
   virtual void add(FilterTree* child) { children_.append(child); }
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
     for (FilterTree* child : children_) {
-      if (!child->accept(row, parent, model)) return false;
+      if (!child->accept(row)) return false;
     }
     return true;
   }
+  virtual void columns(QSet<int>* columns) const {
+    for (FilterTree* child : children_) {
+      child->columns(columns);
+    }
+  }
   FilterType type() { return And; }
 
  private:
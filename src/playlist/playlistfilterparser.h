@@ -25,12 +25,34 @@
 
 class QAbstractItemModel;
 
+// the lower case values of the playlist entry a filter is being tested on
+class FilterRow {
+ public:
+  virtual ~FilterRow() {}
+  virtual QString column(int column) const = 0;
+};
+
+// reads the values straight from the model
+class ModelFilterRow : public FilterRow {
+ public:
+  ModelFilterRow(int row, const QModelIndex& parent,
+                 const QAbstractItemModel* const model)
+      : row_(row), parent_(parent), model_(model) {}
+  virtual QString column(int column) const;
+
+ private:
+  int row_;
+  const QModelIndex& parent_;
+  const QAbstractItemModel* const model_;
+};
+
 // structure for filter parse tree
 class FilterTree {
  public:
   virtual ~FilterTree() {}
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const = 0;
+  virtual bool accept(const FilterRow& row) const = 0;
+  // adds the columns this filter looks at
+  virtual void columns(QSet<int>* columns) const {}
   enum FilterType { Nop = 0, Or, And, Not, Column, Term };
   virtual FilterType type() = 0;
 };
@@ -38,10 +60,7 @@ class FilterTree {
 // trivial filter that accepts *anything*
 class NopFilter : public FilterTree {
  public:
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    return true;
-  }
+  virtual bool accept(const FilterRow& row) const { return true; }
   virtual FilterType type() { return Nop; }
 };
 
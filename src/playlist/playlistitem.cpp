@@ -18,7 +18,6 @@
 #include "playlistitem.h"
 
 #include <QSqlQuery>
-#include <QtConcurrentRun>
 #include <QtDebug>
 
 #include "core/logging.h"
@@ -77,10 +76,32 @@ void PlaylistItem::SetTemporaryMetadata(const Song& metadata) {
 
 void PlaylistItem::ClearTemporaryMetadata() { temp_metadata_ = Song(); }
 
-static void ReloadPlaylistItem(PlaylistItemPtr item) { item->Reload(); }
+void PlaylistItem::AddMemoryUsage(QSet<const void*>* seen,
+                                  qint64* bytes) const {
+  Metadata().AddMemoryUsage(seen, bytes);
+  DatabaseSongMetadata().AddMemoryUsage(seen, bytes);
+  if (HasTemporaryMetadata()) temp_metadata_.AddMemoryUsage(seen, bytes);
+}
+
+void PlaylistItem::ReloadAsync(QObject*, std::function<void()> done) {
+  Reload();
+  done();
+}
 
-QFuture<void> PlaylistItem::BackgroundReload() {
-  return QtConcurrent::run(ReloadPlaylistItem, shared_from_this());
+void PlaylistItem::ReloadAllAsync(const PlaylistItemList& items,
+                                  QObject* receiver,
+                                  std::function<void()> done) {
+  if (items.isEmpty()) {
+    done();
+    return;
+  }
+
+  std::shared_ptr<int> remaining(new int(items.count()));
+  for (PlaylistItemPtr item : items) {
+    item->ReloadAsync(receiver, [remaining, done]() {
+      if (--*remaining == 0) done();
+    });
+  }
 }
 
 void PlaylistItem::SetBackgroundColor(short priority, const QColor& color) {
@@ -19,15 +19,18 @@
 #define PLAYLISTITEM_H
 
 #include <QFuture>
+#include <QList>
 #include <QMap>
 #include <QMetaType>
 #include <QStandardItem>
 #include <QUrl>
+#include <functional>
 #include <memory>
 
 #include "core/song.h"
 
 class QAction;
+class QObject;
 class SqlRow;
 
 class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
@@ -62,11 +65,25 @@ class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
   virtual bool InitFromQuery(const SqlRow& query) = 0;
   void BindToQuery(QSqlQuery* query) const;
   virtual void Reload() {}
-  QFuture<void> BackgroundReload();
+  // Reloads without blocking, and calls done in receiver's thread once the
+  // item has been updated.  Items that don't read tags just call Reload, so
+  // done may be called before this returns.
+  virtual void ReloadAsync(QObject* receiver, std::function<void()> done);
+  // Reloads all of items at once, and calls done when they're all updated.
+  static void ReloadAllAsync(
+      const QList<std::shared_ptr<PlaylistItem>>& items, QObject* receiver,
+      std::function<void()> done);
 
   virtual Song Metadata() const = 0;
   virtual QUrl Url() const = 0;
 
+  // Makes the strings in this item's song share their data with equal ones
+  // in other songs.  See Song::InternStrings.
+  virtual void InternStrings() {}
+  // Adds a rough estimate of the heap memory this item's songs hold to bytes.
+  // See Song::AddMemoryUsage.
+  void AddMemoryUsage(QSet<const void*>* seen, qint64* bytes) const;
+
   void SetTemporaryMetadata(const Song& metadata);
   void ClearTemporaryMetadata();
   bool HasTemporaryMetadata() const { return temp_metadata_.is_valid(); }
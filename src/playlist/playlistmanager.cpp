@@ -21,13 +21,16 @@
 #include <QFileInfo>
 #include <QFuture>
 #include <QMessageBox>
-#include <QtConcurrentRun>
+#include <QSettings>
 #include <QtDebug>
 
 #include "core/application.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/player.h"
 #include "core/songloader.h"
+#include "core/taskmanager.h"
+#include "core/trace.h"
 #include "core/utilities.h"
 #include "library/librarybackend.h"
 #include "library/libraryplaylistitem.h"
@@ -66,6 +69,8 @@ void PlaylistManager::Init(LibraryBackend* library_backend,
                            PlaylistBackend* playlist_backend,
                            PlaylistSequence* sequence,
                            PlaylistContainer* playlist_container) {
+  TRACE_SCOPE("PlaylistManager::Init");
+
   library_backend_ = library_backend;
   playlist_backend_ = playlist_backend;
   sequence_ = sequence;
@@ -78,6 +83,10 @@ void PlaylistManager::Init(LibraryBackend* library_backend,
           SLOT(SongsDiscovered(SongList)));
   connect(library_backend_, SIGNAL(SongsRatingChanged(SongList)),
           SLOT(SongsDiscovered(SongList)));
+  connect(library_backend_, SIGNAL(SongsReplayGainChanged(SongList)),
+          SLOT(SongsDiscovered(SongList)));
+  connect(library_backend_, SIGNAL(SongsAvailabilityChanged(SongList, bool)),
+          SLOT(SongsAvailabilityChanged(SongList, bool)));
 
   connect(parser_, SIGNAL(Error(QString)), this, SIGNAL(Error(QString)));
   for (const PlaylistBackend::Playlist& p :
@@ -123,9 +132,12 @@ Playlist* PlaylistManager::AddPlaylist(int id, const QString& name,
   connect(ret, SIGNAL(Error(QString)), SIGNAL(Error(QString)));
   connect(ret, SIGNAL(PlayRequested(QModelIndex)),
           SIGNAL(PlayRequested(QModelIndex)));
-  connect(playlist_container_->view(),
-          SIGNAL(ColumnAlignmentChanged(ColumnAlignmentMap)), ret,
-          SLOT(SetColumnAlignment(ColumnAlignmentMap)));
+  // There's no container when running headless.
+  if (playlist_container_) {
+    connect(playlist_container_->view(),
+            SIGNAL(ColumnAlignmentChanged(ColumnAlignmentMap)), ret,
+            SLOT(SetColumnAlignment(ColumnAlignmentMap)));
+  }
 
   playlists_[id] = Data(ret, name);
 
@@ -182,13 +194,16 @@ void PlaylistManager::Load(const QString& filename) {
 void PlaylistManager::Save(int id, const QString& filename,
                            Playlist::Path path_type) {
   if (playlists_.contains(id)) {
-    parser_->Save(playlist(id)->GetAllSongs(), filename, path_type);
+    Playlist* p = playlist(id);
+    p->RestoreBlocking();
+    SaveInBackground(p->GetAllSongs(), filename, path_type);
   } else {
     // Playlist is not in the playlist manager: probably save action was
     // triggered
     // from the left side bar and the playlist isn't loaded.
-    QFuture<QList<Song>> future = QtConcurrent::run(
-        playlist_backend_, &PlaylistBackend::GetPlaylistSongs, id);
+    PlaylistBackend* backend = playlist_backend_;
+    QFuture<QList<Song>> future = Executor::Db()->Run<QList<Song>>(
+        [backend, id]() { return backend->GetPlaylistSongs(id); });
     NewClosure(future, this,
                SLOT(ItemsLoadedForSavePlaylist(QFuture<SongList>, QString,
                                                Playlist::Path)),
@@ -199,7 +214,27 @@ void PlaylistManager::Save(int id, const QString& filename,
 void PlaylistManager::ItemsLoadedForSavePlaylist(QFuture<SongList> future,
                                                  const QString& filename,
                                                  Playlist::Path path_type) {
-  parser_->Save(future.result(), filename, path_type);
+  SaveInBackground(future.result(), filename, path_type);
+}
+
+void PlaylistManager::SaveInBackground(const SongList& songs,
+                                       const QString& filename,
+                                       Playlist::Path path_type) {
+  // Copying the list only copies references to the songs, the writing is what
+  // takes a while for big playlists.
+  TaskManager* task_manager = app_->task_manager();
+  const int task_id = task_manager->StartTask(
+      tr("Saving playlist %1").arg(QFileInfo(filename).fileName()));
+  const int count = songs.count();
+  const PlaylistParser* parser = parser_;
+
+  Executor::Io()->Run<void>([=]() {
+    TaskManager::ScopedTask task(task_id, task_manager);
+    parser->Save(songs, filename, path_type,
+                 [task_manager, task_id, count](int saved) {
+                   task_manager->SetTaskProgress(task_id, saved, count);
+                 });
+  });
 }
 
 void PlaylistManager::SaveWithUI(int id, const QString& playlist_name) {
@@ -347,6 +382,8 @@ void PlaylistManager::OneOfPlaylistsChanged() {
 void PlaylistManager::SetCurrentPlaylist(int id) {
   Q_ASSERT(playlists_.contains(id));
   current_ = id;
+  // Playlists aren't loaded from the database until they're first needed.
+  current()->Restore();
   emit CurrentChanged(current());
   UpdateSummaryText();
 }
@@ -359,6 +396,7 @@ void PlaylistManager::SetActivePlaylist(int id) {
   if (active_ != -1 && active_ != id) active()->set_current_row(-1);
 
   active_ = id;
+  active()->Restore();
   emit ActiveChanged(active());
 
   sequence_->SetUsingDynamicPlaylist(active()->is_dynamic());
@@ -460,15 +498,22 @@ void PlaylistManager::SongsDiscovered(const SongList& songs) {
   // Some songs might've changed in the library, let's update any playlist
   // items we have that match those songs
 
-  for (const Song& song : songs) {
-    for (const Data& data : playlists_) {
-      PlaylistItemList items = data.p->library_items_by_id(song.id());
-      for (PlaylistItemPtr item : items) {
-        if (item->Metadata().directory_id() != song.directory_id()) continue;
-        static_cast<LibraryPlaylistItem*>(item.get())->SetMetadata(song);
-        data.p->ItemChanged(item);
-      }
-    }
+  for (const Data& data : playlists_) {
+    data.p->LibrarySongsChanged(songs);
+  }
+}
+
+void PlaylistManager::SongsAvailabilityChanged(const SongList& songs,
+                                               bool unavailable) {
+  // Songs are only greyed out if the user asked for it, but always restored.
+  if (unavailable) {
+    QSettings s;
+    s.beginGroup(Playlist::kSettingsGroup);
+    if (!s.value("greyoutdeleted", false).toBool()) return;
+  }
+
+  for (const Data& data : playlists_) {
+    data.p->LibrarySongsAvailabilityChanged(songs, unavailable);
   }
 }
 
@@ -171,6 +171,7 @@ class PlaylistManager : public PlaylistManagerInterface {
     return playlists_[index].p->is_favorite();
   }
 
+  // playlist_container is nullptr when there's no main window.
   void Init(LibraryBackend* library_backend, PlaylistBackend* playlist_backend,
             PlaylistSequence* sequence, PlaylistContainer* playlist_container);
 
@@ -241,6 +242,7 @@ class PlaylistManager : public PlaylistManagerInterface {
   void OneOfPlaylistsChanged();
   void UpdateSummaryText();
   void SongsDiscovered(const SongList& songs);
+  void SongsAvailabilityChanged(const SongList& songs, bool unavailable);
   void ItemsLoadedForSavePlaylist(QFuture<SongList> future,
                                   const QString& filename,
                                   Playlist::Path path_type);
@@ -249,6 +251,9 @@ class PlaylistManager : public PlaylistManagerInterface {
   Playlist* AddPlaylist(int id, const QString& name,
                         const QString& special_type, const QString& ui_path,
                         bool favorite);
+  // Writes the songs out in an IO thread, showing the progress as a task.
+  void SaveInBackground(const SongList& songs, const QString& filename,
+                        Playlist::Path path_type);
 
  private:
   struct Data {
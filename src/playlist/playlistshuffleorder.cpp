@@ -0,0 +1,288 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "playlistshuffleorder.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+#include <QRandomGenerator>
+#endif
+
+namespace {
+
+quint64 SplitMix64(quint64* state) {
+  quint64 z = (*state += Q_UINT64_C(0x9E3779B97F4A7C15));
+  z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+  return z ^ (z >> 31);
+}
+
+// The number of values in a sorted list that come before the j'th value
+// that isn't in it, ie. the k where the j'th missing value is j + k.
+int SkippedBefore(const QVector<int>& sorted, int j) {
+  int lo = 0;
+  int hi = sorted.count();
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (sorted[mid] - mid > j) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+int CountLessThan(const QVector<int>& sorted, int value) {
+  return std::lower_bound(sorted.begin(), sorted.end(), value) -
+         sorted.begin();
+}
+
+}  // namespace
+
+PlaylistShuffleOrder::PlaylistShuffleOrder()
+    : mode_(Mode_InOrder),
+      count_(0),
+      seed_(0),
+      half_bits_(1),
+      half_mask_(1) {
+  std::fill(keys_, keys_ + 4, 0);
+}
+
+void PlaylistShuffleOrder::SetInOrder(int count) {
+  mode_ = Mode_InOrder;
+  groups_.clear();
+  group_of_row_.clear();
+  set_count(count);
+}
+
+void PlaylistShuffleOrder::Shuffle(int count) {
+  mode_ = Mode_Shuffle;
+  groups_.clear();
+  group_of_row_.clear();
+  NewSeed();
+  set_count(count);
+}
+
+void PlaylistShuffleOrder::ShuffleGroups(const QVector<QVector<int>>& groups,
+                                         int first_group) {
+  NewSeed();
+  SetGroups(groups, first_group);
+}
+
+void PlaylistShuffleOrder::SetGroups(const QVector<QVector<int>>& groups,
+                                     int first_group) {
+  mode_ = Mode_ShuffleGroups;
+  groups_ = groups;
+
+  int count = 0;
+  for (const QVector<int>& group : groups_) count += group.count();
+  count_ = count;
+
+  group_of_row_.fill(-1, count_);
+  for (int i = 0; i < groups_.count(); ++i) {
+    for (int row : groups_[i]) group_of_row_[row] = i;
+  }
+
+  UpdateGroups(first_group);
+  Update();
+}
+
+void PlaylistShuffleOrder::set_count(int count) {
+  count_ = qMax(0, count);
+
+  // The bijection needs an even number of bits so it splits into two halves.
+  int bits = 2;
+  while (bits < 32 && (Q_UINT64_C(1) << bits) < quint64(count_)) bits += 2;
+  half_bits_ = bits / 2;
+  half_mask_ = (quint32(1) << half_bits_) - 1;
+
+  Update();
+}
+
+void PlaylistShuffleOrder::set_history(const QList<int>& rows) {
+  history_.clear();
+  history_index_.clear();
+  for (int row : rows) {
+    if (row < 0 || row >= count_ || history_index_.contains(row)) continue;
+    history_index_[row] = history_.count();
+    history_ << row;
+  }
+
+  Update();
+}
+
+int PlaylistShuffleOrder::row(int virtual_index) const {
+  if (virtual_index < 0 || virtual_index >= count_) return -1;
+  if (mode_ == Mode_InOrder) return virtual_index;
+  if (virtual_index < history_.count()) return history_[virtual_index];
+
+  const int j = virtual_index - history_.count();
+  if (mode_ == Mode_Shuffle) {
+    return Permute(j + SkippedBefore(history_positions_, j));
+  }
+
+  // Find the group this position is in, then the row inside the group.
+  const int pos =
+      std::upper_bound(group_offsets_.begin(), group_offsets_.end(), j) -
+      group_offsets_.begin() - 1;
+  const int group = group_order_[pos];
+  const int i = j - group_offsets_[pos];
+  return groups_[group][i + SkippedBefore(group_history_.value(group), i)];
+}
+
+int PlaylistShuffleOrder::virtual_index(int row) const {
+  if (row < 0 || row >= count_) return -1;
+  if (mode_ == Mode_InOrder) return row;
+
+  QHash<int, int>::const_iterator it = history_index_.constFind(row);
+  if (it != history_index_.constEnd()) return it.value();
+
+  if (mode_ == Mode_Shuffle) {
+    const int t = Unpermute(row);
+    return history_.count() + t - CountLessThan(history_positions_, t);
+  }
+
+  const int group = group_of_row_[row];
+  const QVector<int>& rows = groups_[group];
+  const int i = CountLessThan(rows, row);
+  return history_.count() + group_offsets_[group_position_[group]] + i -
+         CountLessThan(group_history_.value(group), i);
+}
+
+void PlaylistShuffleOrder::NewSeed() {
+#if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+  seed_ = (quint64(qrand()) << 32) ^ (quint64(qrand()) << 16) ^ qrand();
+#else
+  seed_ = QRandomGenerator::global()->generate64();
+#endif
+
+  quint64 state = seed_;
+  for (int i = 0; i < 4; ++i) keys_[i] = quint32(SplitMix64(&state));
+}
+
+void PlaylistShuffleOrder::Update() {
+  // Drop history rows that went away when the count changed.
+  if (!history_.isEmpty()) {
+    QList<int> history;
+    for (int row : history_) {
+      if (row < count_) history << row;
+    }
+    if (history.count() != history_.count()) {
+      history_.clear();
+      history_index_.clear();
+      for (int row : history) {
+        history_index_[row] = history_.count();
+        history_ << row;
+      }
+    }
+  }
+
+  history_positions_.clear();
+  group_history_.clear();
+
+  switch (mode_) {
+    case Mode_InOrder:
+      break;
+
+    case Mode_Shuffle:
+      history_positions_.reserve(history_.count());
+      for (int row : history_) history_positions_ << Unpermute(row);
+      std::sort(history_positions_.begin(), history_positions_.end());
+      break;
+
+    case Mode_ShuffleGroups: {
+      for (int row : history_) {
+        const int group = group_of_row_[row];
+        group_history_[group] << CountLessThan(groups_[group], row);
+      }
+      for (QVector<int>& indexes : group_history_) {
+        std::sort(indexes.begin(), indexes.end());
+      }
+
+      group_offsets_.resize(group_order_.count() + 1);
+      group_offsets_[0] = 0;
+      for (int pos = 0; pos < group_order_.count(); ++pos) {
+        const int group = group_order_[pos];
+        group_offsets_[pos + 1] = group_offsets_[pos] +
+                                  groups_[group].count() -
+                                  group_history_.value(group).count();
+      }
+      break;
+    }
+  }
+}
+
+void PlaylistShuffleOrder::UpdateGroups(int first_group) {
+  group_order_.resize(groups_.count());
+  std::iota(group_order_.begin(), group_order_.end(), 0);
+
+  std::mt19937 generator(quint32(seed_ ^ (seed_ >> 32)));
+  std::shuffle(group_order_.begin(), group_order_.end(), generator);
+
+  if (first_group >= 0 && first_group < groups_.count()) {
+    std::swap(*std::find(group_order_.begin(), group_order_.end(), first_group),
+              group_order_[0]);
+  }
+
+  group_position_.resize(groups_.count());
+  for (int pos = 0; pos < group_order_.count(); ++pos) {
+    group_position_[group_order_[pos]] = pos;
+  }
+}
+
+quint32 PlaylistShuffleOrder::Round(quint32 half, int round) const {
+  quint32 h = (half * 0x9E3779B1u) ^ keys_[round];
+  h ^= h >> 15;
+  h *= 0x85EBCA77u;
+  h ^= h >> 13;
+  return h & half_mask_;
+}
+
+quint32 PlaylistShuffleOrder::Permute(quint32 x) const {
+  // Every value in the network's range maps to another one, so walking from a
+  // value past the end always comes back into [0, count_).
+  do {
+    quint32 left = x >> half_bits_;
+    quint32 right = x & half_mask_;
+    for (int i = 0; i < 4; ++i) {
+      const quint32 next = left ^ Round(right, i);
+      left = right;
+      right = next;
+    }
+    x = (left << half_bits_) | right;
+  } while (x >= quint32(count_));
+  return x;
+}
+
+quint32 PlaylistShuffleOrder::Unpermute(quint32 y) const {
+  do {
+    quint32 left = y >> half_bits_;
+    quint32 right = y & half_mask_;
+    for (int i = 3; i >= 0; --i) {
+      const quint32 previous = right ^ Round(left, i);
+      right = left;
+      left = previous;
+    }
+    y = (left << half_bits_) | right;
+  } while (y >= quint32(count_));
+  return y;
+}
@@ -0,0 +1,101 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLIST_PLAYLISTSHUFFLEORDER_H_
+#define PLAYLIST_PLAYLISTSHUFFLEORDER_H_
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+// The order a playlist's rows are played in.  The history - the rows played
+// so far, in the order they were played - comes first, followed by every
+// other row.
+//
+// When shuffled, the other rows aren't kept in a list.  They're ordered by a
+// seeded bijection on [0, count) that's computed when a position is looked
+// up, so shuffling again or adding rows doesn't touch every row.  When
+// shuffling groups (albums), the groups are shuffled and the rows inside each
+// one stay in order.
+class PlaylistShuffleOrder {
+ public:
+  PlaylistShuffleOrder();
+
+  // Plays rows [0, count) in order.  The history isn't used.
+  void SetInOrder(int count);
+  // Shuffles rows [0, count) with a new seed.
+  void Shuffle(int count);
+  // Shuffles the groups with a new seed, starting with first_group, which can
+  // be -1.  Each group lists its rows in ascending order, and every row
+  // [0, count) is in exactly one.
+  void ShuffleGroups(const QVector<QVector<int>>& groups, int first_group);
+  // Like ShuffleGroups but keeps the seed, for when the rows changed.
+  void SetGroups(const QVector<QVector<int>>& groups, int first_group);
+
+  // Rows were added or removed.  A shuffled order keeps its seed.  When
+  // shuffling groups, call SetGroups instead.
+  void set_count(int count);
+  // The rows played so far.  They must all be less than count().
+  void set_history(const QList<int>& rows);
+
+  bool is_shuffled() const { return mode_ != Mode_InOrder; }
+  int count() const { return count_; }
+
+  // The row at a position in the order, and the other way round.
+  int row(int virtual_index) const;
+  int virtual_index(int row) const;
+
+ private:
+  enum Mode { Mode_InOrder, Mode_Shuffle, Mode_ShuffleGroups };
+
+  void NewSeed();
+  void Update();
+  void UpdateGroups(int first_group);
+
+  // The bijection on [0, count_): a Feistel network over the smallest even
+  // number of bits that covers count_, with cycle walking for the values
+  // past the end.
+  quint32 Permute(quint32 x) const;
+  quint32 Unpermute(quint32 y) const;
+  quint32 Round(quint32 half, int round) const;
+
+  Mode mode_;
+  int count_;
+  quint64 seed_;
+  quint32 keys_[4];
+  int half_bits_;
+  quint32 half_mask_;
+
+  QList<int> history_;
+  QHash<int, int> history_index_;
+
+  // Mode_Shuffle: where each history row is in the bijection's order, sorted.
+  QVector<int> history_positions_;
+
+  // Mode_ShuffleGroups.
+  QVector<QVector<int>> groups_;
+  QVector<int> group_of_row_;
+  // The groups in play order, where each group is in it, and how many
+  // non-history rows come before each position.
+  QVector<int> group_order_;
+  QVector<int> group_position_;
+  QVector<int> group_offsets_;
+  // For each group, the indexes into its rows of the ones in the history.
+  QHash<int, QVector<int>> group_history_;
+};
+
+#endif  // PLAYLIST_PLAYLISTSHUFFLEORDER_H_
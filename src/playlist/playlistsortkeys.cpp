@@ -0,0 +1,273 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "playlistsortkeys.h"
+
+#include <QCollator>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <algorithm>
+
+#include "playlist.h"
+
+const int PlaylistSortKeys::kMinRowsForParallelSort = 10000;
+
+namespace {
+
+typedef QPair<int, int> Range;
+
+// Splits count rows into a few ranges per thread.
+QList<Range> SplitRows(int count) {
+  const int chunk_size =
+      qMax(1, count / (qMax(1, QThread::idealThreadCount()) * 2));
+  QList<Range> ranges;
+  for (int start = 0; start < count; start += chunk_size) {
+    ranges << qMakePair(start, qMin(count, start + chunk_size));
+  }
+  return ranges;
+}
+
+bool IsTextColumn(int column) {
+  switch (column) {
+    case Playlist::Column_Title:
+    case Playlist::Column_Artist:
+    case Playlist::Column_Album:
+    case Playlist::Column_Genre:
+    case Playlist::Column_AlbumArtist:
+    case Playlist::Column_Composer:
+    case Playlist::Column_Performer:
+    case Playlist::Column_Grouping:
+    case Playlist::Column_Comment:
+    case Playlist::Column_BaseFilename:
+    case Playlist::Column_Source:
+      return true;
+  }
+  return false;
+}
+
+QString TextField(int column, const Song& song) {
+  switch (column) {
+    case Playlist::Column_Title:
+      return song.title();
+    case Playlist::Column_Artist:
+      return song.artist();
+    case Playlist::Column_Album:
+      return song.album();
+    case Playlist::Column_Genre:
+      return song.genre();
+    case Playlist::Column_AlbumArtist:
+      return song.playlist_albumartist();
+    case Playlist::Column_Composer:
+      return song.composer();
+    case Playlist::Column_Performer:
+      return song.performer();
+    case Playlist::Column_Grouping:
+      return song.grouping();
+    case Playlist::Column_Comment:
+      return song.comment();
+    case Playlist::Column_BaseFilename:
+      return song.basefilename();
+    case Playlist::Column_Source:
+      return song.url().toString();
+  }
+  return QString();
+}
+
+double NumberField(int column, const Song& song) {
+  switch (column) {
+    case Playlist::Column_Length:
+      return song.length_nanosec();
+    case Playlist::Column_Track:
+      return song.track();
+    case Playlist::Column_Disc:
+      return song.disc();
+    case Playlist::Column_Year:
+      return song.year();
+    case Playlist::Column_OriginalYear:
+      return song.originalyear();
+    case Playlist::Column_Rating:
+      return song.rating();
+    case Playlist::Column_PlayCount:
+      return song.playcount();
+    case Playlist::Column_SkipCount:
+      return song.skipcount();
+    case Playlist::Column_LastPlayed:
+      return song.lastplayed();
+    case Playlist::Column_Score:
+      return song.score();
+    case Playlist::Column_BPM:
+      return song.bpm();
+    case Playlist::Column_Bitrate:
+      return song.bitrate();
+    case Playlist::Column_Samplerate:
+      return song.samplerate();
+    case Playlist::Column_Filesize:
+      return song.filesize();
+    case Playlist::Column_Filetype:
+      return song.filetype();
+    case Playlist::Column_DateModified:
+      return song.mtime();
+    case Playlist::Column_DateCreated:
+      return song.ctime();
+  }
+  // Columns that can't be sorted compare equal, leaving the order alone.
+  return 0;
+}
+
+}  // namespace
+
+PlaylistSortKeys::PlaylistSortKeys(int column, const QStringList& prefixes,
+                                   const PlaylistItemList& items)
+    : count_(items.count()), prefixes_(prefixes) {
+  if (column == Playlist::Column_Album) {
+    // When sorting by album, also take into account discs and tracks.
+    Component& album = AddComponent(Type_Collated);
+    Component& disc = AddComponent(Type_Number);
+    Component& track = AddComponent(Type_Number);
+    for (const PlaylistItemPtr& item : items) {
+      const Song song = item->Metadata();
+      AddText(&album, song.album());
+      disc.numbers << song.disc();
+      track.numbers << song.track();
+    }
+  } else if (column == Playlist::Column_Filename) {
+    // When sorting by full paths we also expect a hierarchical order.  This
+    // gives a breadth-first ordering of paths.
+    Component& depth = AddComponent(Type_Number);
+    Component& path = AddComponent(Type_Collated);
+    for (const PlaylistItemPtr& item : items) {
+      const QString item_path = item->Url().path();
+      depth.numbers << item_path.count('/');
+      path.texts << item_path.toLower();
+    }
+  } else if (column == Playlist::Column_BaseFilename ||
+             column == Playlist::Column_Source) {
+    Component& text = AddComponent(Type_Text);
+    for (const PlaylistItemPtr& item : items) {
+      text.texts << TextField(column, item->Metadata());
+    }
+  } else if (IsTextColumn(column)) {
+    Component& text = AddComponent(Type_Collated);
+    for (const PlaylistItemPtr& item : items) {
+      AddText(&text, TextField(column, item->Metadata()));
+    }
+  } else {
+    Component& number = AddComponent(Type_Number);
+    for (const PlaylistItemPtr& item : items) {
+      number.numbers << NumberField(column, item->Metadata());
+    }
+  }
+}
+
+PlaylistSortKeys::Component& PlaylistSortKeys::AddComponent(Type type) {
+  components_ << Component(type);
+  return components_.last();
+}
+
+void PlaylistSortKeys::AddText(Component* component,
+                               const QString& text) const {
+  QString lower = text.toLower();
+  for (const QString& prefix : prefixes_) {
+    if (lower.startsWith(prefix)) {
+      lower = lower.mid(prefix.size());
+      break;
+    }
+  }
+  component->texts << lower;
+}
+
+void PlaylistSortKeys::BuildCollatedKeys(Component* component, int begin,
+                                         int end) const {
+  // A collator for each range, they aren't safe to share between threads.
+  QCollator collator;
+  for (int row = begin; row < end; ++row) {
+    component->collated[row] = collator.sortKey(component->texts[row]);
+  }
+}
+
+bool PlaylistSortKeys::LessThan(int a, int b) const {
+  for (const Component& component : components_) {
+    int result = 0;
+    switch (component.type) {
+      case Type_Collated:
+        result = component.collated[a].compare(component.collated[b]);
+        break;
+      case Type_Text:
+        result = component.texts[a].compare(component.texts[b]);
+        break;
+      case Type_Number:
+        result = component.numbers[a] < component.numbers[b]
+                     ? -1
+                     : (component.numbers[b] < component.numbers[a] ? 1 : 0);
+        break;
+    }
+    if (result != 0) return result < 0;
+  }
+  return false;
+}
+
+QVector<int> PlaylistSortKeys::Sort(Qt::SortOrder order) {
+  const bool parallel = count_ >= kMinRowsForParallelSort;
+  QList<Range> ranges = parallel ? SplitRows(count_)
+                                 : QList<Range>() << qMakePair(0, count_);
+
+  // Turn the text into collation keys, so comparisons are a memcmp.
+  for (Component& component : components_) {
+    if (component.type != Type_Collated) continue;
+
+    component.collated.assign(count_, QCollator().sortKey(QString()));
+    QtConcurrent::blockingMap(ranges, [this, &component](const Range& range) {
+      BuildCollatedKeys(&component, range.first, range.second);
+    });
+    component.texts.clear();
+  }
+
+  QVector<int> rows(count_);
+  for (int i = 0; i < count_; ++i) rows[i] = i;
+
+  // Descending order swaps the arguments, so equal items still keep their
+  // order.
+  auto less = [this, order](int a, int b) {
+    return order == Qt::AscendingOrder ? LessThan(a, b) : LessThan(b, a);
+  };
+
+  // Sort each range, then merge neighbouring ones until there's only one.
+  int* data = rows.data();
+  QtConcurrent::blockingMap(ranges, [data, &less](const Range& range) {
+    std::stable_sort(data + range.first, data + range.second, less);
+  });
+
+  QList<Range> sorted = ranges;
+  while (sorted.count() > 1) {
+    QList<QPair<Range, Range>> pairs;
+    QList<Range> merged;
+    for (int i = 0; i + 1 < sorted.count(); i += 2) {
+      pairs << qMakePair(sorted[i], sorted[i + 1]);
+      merged << qMakePair(sorted[i].first, sorted[i + 1].second);
+    }
+    if (sorted.count() % 2) merged << sorted.last();
+
+    QtConcurrent::blockingMap(
+        pairs, [data, &less](const QPair<Range, Range>& pair) {
+          std::inplace_merge(data + pair.first.first, data + pair.second.first,
+                             data + pair.second.second, less);
+        });
+    sorted = merged;
+  }
+
+  return rows;
+}
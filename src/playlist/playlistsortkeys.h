@@ -0,0 +1,75 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLIST_PLAYLISTSORTKEYS_H_
+#define PLAYLIST_PLAYLISTSORTKEYS_H_
+
+#include <QCollatorSortKey>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+#include "playlistitem.h"
+
+// The values Playlist::sort compares, read out of the items once so a sort
+// doesn't look at the songs again for every comparison.  Constructing it only
+// copies fields, so it's done on the GUI thread; Sort() is the expensive part
+// and can run on any thread.
+class PlaylistSortKeys {
+ public:
+  // Below this many rows Sort() doesn't bother splitting the work up.
+  static const int kMinRowsForParallelSort;
+
+  // prefixes are removed from the start of text fields, lower cased.
+  PlaylistSortKeys(int column, const QStringList& prefixes,
+                   const PlaylistItemList& items);
+
+  int count() const { return count_; }
+
+  // Returns the indices of the items in sorted order.  Items that compare
+  // equal keep their order.
+  QVector<int> Sort(Qt::SortOrder order);
+
+ private:
+  enum Type {
+    Type_Collated,  // Compared with the locale
+    Type_Text,      // Compared code point by code point
+    Type_Number,
+  };
+
+  // Sorted by each component in turn.
+  struct Component {
+    explicit Component(Type t) : type(t) {}
+
+    Type type;
+    QStringList texts;
+    QVector<double> numbers;
+    std::vector<QCollatorSortKey> collated;
+  };
+
+  Component& AddComponent(Type type);
+  void AddText(Component* component, const QString& text) const;
+  void BuildCollatedKeys(Component* component, int begin, int end) const;
+
+  bool LessThan(int a, int b) const;
+
+  int count_;
+  QStringList prefixes_;
+  QList<Component> components_;
+};
+
+#endif  // PLAYLIST_PLAYLISTSORTKEYS_H_
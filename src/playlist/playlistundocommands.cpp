@@ -17,11 +17,24 @@
 
 #include "playlistundocommands.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "playlist.h"
 
 namespace PlaylistUndoCommands {
 
-Base::Base(Playlist* playlist) : QUndoCommand(0), playlist_(playlist) {}
+const qint64 Base::kItemMemoryCost = 1024;
+
+Base::Base(Playlist* playlist)
+    : QUndoCommand(0), playlist_(playlist), expired_(false) {}
+
+void Base::Expire() {
+  expired_ = true;
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 9, 0))
+  setObsolete(true);
+#endif
+}
 
 InsertItems::InsertItems(Playlist* playlist, const PlaylistItemList& items,
                          int pos, bool enqueue, bool enqueue_next)
@@ -34,14 +47,25 @@ InsertItems::InsertItems(Playlist* playlist, const PlaylistItemList& items,
 }
 
 void InsertItems::redo() {
+  if (expired()) return;
   playlist_->InsertItemsWithoutUndo(items_, pos_, enqueue_, enqueue_next_);
 }
 
 void InsertItems::undo() {
+  if (expired()) return;
   const int start = pos_ == -1 ? playlist_->rowCount() - items_.count() : pos_;
   playlist_->RemoveItemsWithoutUndo(start, items_.count());
 }
 
+qint64 InsertItems::memory_cost() const {
+  return items_.count() * kItemMemoryCost;
+}
+
+void InsertItems::Expire() {
+  Base::Expire();
+  items_.clear();
+}
+
 bool InsertItems::UpdateItem(const PlaylistItemPtr& updated_item) {
   for (int i = 0; i < items_.size(); i++) {
     PlaylistItemPtr item = items_[i];
@@ -60,20 +84,56 @@ RemoveItems::RemoveItems(Playlist* playlist, int pos, int count)
   ranges_ << Range(pos, count);
 }
 
+RemoveItems::RemoveItems(Playlist* playlist, const QList<int>& rows)
+    : Base(playlist) {
+  setText(tr("remove %n songs", "", rows.count()));
+
+  // Remove runs of rows from the bottom up, so the rows that are still to be
+  // removed don't move.
+  QList<int> sorted(rows);
+  std::sort(sorted.begin(), sorted.end(), std::greater<int>());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  for (int i = 0; i < sorted.count();) {
+    int end = i + 1;
+    while (end < sorted.count() && sorted[end] == sorted[end - 1] - 1) ++end;
+    ranges_ << Range(sorted[end - 1], end - i);
+    i = end;
+  }
+}
+
 void RemoveItems::redo() {
+  if (expired()) return;
   for (int i = 0; i < ranges_.count(); ++i)
     ranges_[i].items_ =
         playlist_->RemoveItemsWithoutUndo(ranges_[i].pos_, ranges_[i].count_);
 }
 
 void RemoveItems::undo() {
+  if (expired()) return;
   for (int i = ranges_.count() - 1; i >= 0; --i)
     playlist_->InsertItemsWithoutUndo(ranges_[i].items_, ranges_[i].pos_);
 }
 
 bool RemoveItems::mergeWith(const QUndoCommand* other) {
   const RemoveItems* remove_command = static_cast<const RemoveItems*>(other);
-  ranges_.append(remove_command->ranges_);
+  if (expired() || remove_command->expired()) return false;
+
+  for (const Range& range : remove_command->ranges_) {
+    // Removing the rows right after or right before the last range leaves
+    // one run of rows to put back, rather than a range for each removal.
+    Range& last = ranges_.last();
+    if (range.pos_ == last.pos_) {
+      last.count_ += range.count_;
+      last.items_.append(range.items_);
+    } else if (range.pos_ + range.count_ == last.pos_) {
+      last.pos_ = range.pos_;
+      last.count_ += range.count_;
+      last.items_ = range.items_ + last.items_;
+    } else {
+      ranges_ << range;
+    }
+  }
 
   int sum = 0;
   for (const Range& range : ranges_) sum += range.count_;
@@ -82,32 +142,90 @@ bool RemoveItems::mergeWith(const QUndoCommand* other) {
   return true;
 }
 
+qint64 RemoveItems::memory_cost() const {
+  qint64 cost = 0;
+  for (const Range& range : ranges_) cost += range.items_.count();
+  return cost * kItemMemoryCost;
+}
+
+void RemoveItems::Expire() {
+  Base::Expire();
+  ranges_.clear();
+}
+
 MoveItems::MoveItems(Playlist* playlist, const QList<int>& source_rows, int pos)
     : Base(playlist), source_rows_(source_rows), pos_(pos) {
   setText(tr("move %n songs", "", source_rows.count()));
 }
 
-void MoveItems::redo() { playlist_->MoveItemsWithoutUndo(source_rows_, pos_); }
+void MoveItems::redo() {
+  if (expired()) return;
+  playlist_->MoveItemsWithoutUndo(source_rows_, pos_);
+}
+
+void MoveItems::undo() {
+  if (expired()) return;
+  playlist_->MoveItemsWithoutUndo(pos_, source_rows_);
+}
+
+qint64 MoveItems::memory_cost() const {
+  return source_rows_.count() * sizeof(int);
+}
+
+void MoveItems::Expire() {
+  Base::Expire();
+  source_rows_.clear();
+}
+
+ReOrderItems::ReOrderItems(Playlist* playlist, int begin,
+                           const QVector<int>& new_rows)
+    : Base(playlist), begin_(begin), new_rows_(new_rows) {}
+
+bool ReOrderItems::CanReOrder() const {
+  return !expired() &&
+         playlist_->items_.count() == begin_ + new_rows_.count();
+}
 
-void MoveItems::undo() { playlist_->MoveItemsWithoutUndo(pos_, source_rows_); }
+void ReOrderItems::undo() {
+  if (!CanReOrder()) return;
 
-ReOrderItems::ReOrderItems(Playlist* playlist,
-                           const PlaylistItemList& new_items)
-    : Base(playlist), old_items_(playlist->items_), new_items_(new_items) {}
+  const PlaylistItemList& items = playlist_->items_;
+  PlaylistItemList old_items = items;
+  for (int i = 0; i < new_rows_.count(); ++i) {
+    old_items[begin_ + new_rows_[i]] = items[begin_ + i];
+  }
+  playlist_->ReOrderWithoutUndo(old_items);
+}
 
-void ReOrderItems::undo() { playlist_->ReOrderWithoutUndo(old_items_); }
+void ReOrderItems::redo() {
+  if (!CanReOrder()) return;
 
-void ReOrderItems::redo() { playlist_->ReOrderWithoutUndo(new_items_); }
+  const PlaylistItemList& items = playlist_->items_;
+  PlaylistItemList new_items = items.mid(0, begin_);
+  for (int row : new_rows_) {
+    new_items << items[begin_ + row];
+  }
+  playlist_->ReOrderWithoutUndo(new_items);
+}
+
+qint64 ReOrderItems::memory_cost() const {
+  return new_rows_.count() * sizeof(int);
+}
+
+void ReOrderItems::Expire() {
+  Base::Expire();
+  new_rows_.clear();
+}
 
 SortItems::SortItems(Playlist* playlist, int column, Qt::SortOrder order,
-                     const PlaylistItemList& new_items)
-    : ReOrderItems(playlist, new_items), column_(column), order_(order) {
+                     int begin, const QVector<int>& new_rows)
+    : ReOrderItems(playlist, begin, new_rows), column_(column), order_(order) {
   setText(tr("sort songs"));
 }
 
-ShuffleItems::ShuffleItems(Playlist* playlist,
-                           const PlaylistItemList& new_items)
-    : ReOrderItems(playlist, new_items) {
+ShuffleItems::ShuffleItems(Playlist* playlist, int begin,
+                           const QVector<int>& new_rows)
+    : ReOrderItems(playlist, begin, new_rows) {
   setText(tr("shuffle songs"));
 }
 
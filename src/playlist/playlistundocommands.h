@@ -20,6 +20,7 @@
 
 #include <QCoreApplication>
 #include <QUndoCommand>
+#include <QVector>
 
 #include "playlistitem.h"
 
@@ -36,8 +37,23 @@ class Base : public QUndoCommand {
  public:
   Base(Playlist* playlist);
 
+  // Roughly how much memory an item kept only by the undo stack costs, with
+  // its song.
+  static const qint64 kItemMemoryCost;
+
+  // Roughly how many bytes of memory the command keeps to be undone.
+  virtual qint64 memory_cost() const { return 0; }
+
+  // Frees everything the command keeps.  An expired command can't be undone
+  // any more, so it's dropped from the stack when it's reached.
+  virtual void Expire();
+  bool expired() const { return expired_; }
+
  protected:
   Playlist* playlist_;
+
+ private:
+  bool expired_;
 };
 
 class InsertItems : public Base {
@@ -47,6 +63,8 @@ class InsertItems : public Base {
 
   void undo();
   void redo();
+  qint64 memory_cost() const;
+  void Expire();
   // When load is async, items have already been pushed, so we need to update
   // them.
   // This function try to find the equivalent item, and replace it with the
@@ -64,12 +82,16 @@ class InsertItems : public Base {
 class RemoveItems : public Base {
  public:
   RemoveItems(Playlist* playlist, int pos, int count);
+  // Removes rows that needn't be next to each other.
+  RemoveItems(Playlist* playlist, const QList<int>& rows);
 
   int id() const { return Type_RemoveItems; }
 
   void undo();
   void redo();
   bool mergeWith(const QUndoCommand* other);
+  qint64 memory_cost() const;
+  void Expire();
 
  private:
   struct Range {
@@ -88,28 +110,39 @@ class MoveItems : public Base {
 
   void undo();
   void redo();
+  qint64 memory_cost() const;
+  void Expire();
 
  private:
   QList<int> source_rows_;
   int pos_;
 };
 
+// Only keeps where each item moved to, not the items themselves.
 class ReOrderItems : public Base {
  public:
-  ReOrderItems(Playlist* playlist, const PlaylistItemList& new_items);
+  // The item that ends up at row begin + i comes from row begin + new_rows[i].
+  // The rows before begin stay where they are.
+  ReOrderItems(Playlist* playlist, int begin, const QVector<int>& new_rows);
 
   void undo();
   void redo();
+  qint64 memory_cost() const;
+  void Expire();
 
  private:
-  PlaylistItemList old_items_;
-  PlaylistItemList new_items_;
+  // False if rows were added or removed without going through the undo
+  // stack, so the order no longer fits the playlist.
+  bool CanReOrder() const;
+
+  int begin_;
+  QVector<int> new_rows_;
 };
 
 class SortItems : public ReOrderItems {
  public:
-  SortItems(Playlist* playlist, int column, Qt::SortOrder order,
-            const PlaylistItemList& new_items);
+  SortItems(Playlist* playlist, int column, Qt::SortOrder order, int begin,
+            const QVector<int>& new_rows);
 
  private:
   int column_;
@@ -118,7 +151,7 @@ class SortItems : public ReOrderItems {
 
 class ShuffleItems : public ReOrderItems {
  public:
-  ShuffleItems(Playlist* playlist, const PlaylistItemList& new_items);
+  ShuffleItems(Playlist* playlist, int begin, const QVector<int>& new_rows);
 };
 }  // namespace PlaylistUndoCommands
 
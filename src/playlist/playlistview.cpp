@@ -185,6 +185,9 @@ PlaylistView::PlaylistView(QWidget* parent)
   verticalScrollBar()->installEventFilter(this);
 
   setAlternatingRowColors(true);
+  // Every row shows one line of text, so the view only has to measure one of
+  // them rather than asking the delegates about each row it lays out.
+  setUniformRowHeights(true);
 
   setAttribute(Qt::WA_MacShowFocusRect, false);
 
@@ -296,13 +299,26 @@ void PlaylistView::SetPlaylist(Playlist* playlist) {
   }
 
   playlist_ = playlist;
-  LoadGeometry();
-  LoadRatingLockStatus();
-  ReloadSettings();
+  if (header_loaded_) {
+    // The settings were read for the first playlist and are kept up to date
+    // by ReloadSettings, only the header has to be put back.
+    header_->RestoreState(header_state_);
+  } else {
+    LoadGeometry();
+    LoadRatingLockStatus();
+    ReloadSettings();
+  }
   DynamicModeChanged(playlist->is_dynamic());
   setFocus();
   read_only_settings_ = false;
-  JumpToLastPlayedTrack();
+
+  const ViewState state = view_states_.take(playlist->id());
+  if (state.top_.isValid() && state.top_.model() == model()) {
+    if (state.current_.isValid()) setCurrentIndex(state.current_);
+    scrollTo(state.top_, QAbstractItemView::PositionAtTop);
+  } else {
+    JumpToLastPlayedTrack();
+  }
 
   connect(playlist_, SIGNAL(RestoreFinished()), SLOT(JumpToLastPlayedTrack()));
   connect(playlist_, SIGNAL(CurrentSongChanged(Song)), SLOT(MaybeAutoscroll()));
@@ -329,6 +345,13 @@ void PlaylistView::setModel(QAbstractItemModel* m) {
     // If a remote client uses "stop after", without invaliding the stop
     // mark would not appear.
     InvalidateCachedCurrentPixmap();
+
+    header_state_ = header_->SaveState();
+    if (playlist_) {
+      ViewState& state = view_states_[playlist_->id()];
+      state.top_ = indexAt(QPoint(0, 0));
+      state.current_ = currentIndex();
+    }
   }
 
   QTreeView::setModel(m);
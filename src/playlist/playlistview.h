@@ -19,6 +19,8 @@
 #define PLAYLISTVIEW_H
 
 #include <QBasicTimer>
+#include <QHash>
+#include <QPersistentModelIndex>
 #include <QProxyStyle>
 #include <QTreeView>
 #include <memory>
@@ -199,6 +201,17 @@ class PlaylistView : public QTreeView {
   int upgrading_from_version_;
   bool header_loaded_;
 
+  // Where each playlist was left, so switching back to its tab puts the view
+  // back there without working out where the last played track is.
+  struct ViewState {
+    QPersistentModelIndex top_;
+    QPersistentModelIndex current_;
+  };
+  QHash<int, ViewState> view_states_;
+  // The header is shared by every playlist, this is its state when the last
+  // one was taken out of the view.
+  QByteArray header_state_;
+
   bool background_initialized_;
   BackgroundImageType background_image_type_;
   // Used if background image is a filemane
@@ -19,6 +19,7 @@
 
 #include <QBuffer>
 #include <QMimeData>
+#include <QSet>
 #include <QtDebug>
 #include <algorithm>
 
@@ -26,6 +27,16 @@
 
 const char* Queue::kRowsMimetype = "application/x-clementine-queue-rows";
 
+namespace {
+
+// Persistent indexes are looked up by the row they point to, so they have to
+// be for the same column.
+QPersistentModelIndex SourceRowIndex(const QModelIndex& source_index) {
+  return QPersistentModelIndex(source_index.sibling(source_index.row(), 0));
+}
+
+}  // namespace
+
 Queue::Queue(Playlist* parent)
     : QAbstractProxyModel(parent), playlist_(parent), total_length_ns_(0) {
   count_changed_ =
@@ -38,25 +49,29 @@ Queue::Queue(Playlist* parent)
 QModelIndex Queue::mapFromSource(const QModelIndex& source_index) const {
   if (!source_index.isValid()) return QModelIndex();
 
-  const int source_row = source_index.row();
-  for (int i = 0; i < source_indexes_.count(); ++i) {
-    if (source_indexes_[i].row() == source_row)
-      return index(i, source_index.column());
-  }
-  return QModelIndex();
+  const int row = source_indexes_.position_of(SourceRowIndex(source_index));
+  if (row == -1) return QModelIndex();
+  return index(row, source_index.column());
 }
 
 bool Queue::ContainsSourceRow(int source_row) const {
-  for (int i = 0; i < source_indexes_.count(); ++i) {
-    if (source_indexes_[i].row() == source_row) return true;
+  if (!sourceModel()) return false;
+  return source_indexes_.contains(
+      QPersistentModelIndex(sourceModel()->index(source_row, 0)));
+}
+
+QList<int> Queue::SourceRows() const {
+  QList<int> ret;
+  for (const QPersistentModelIndex& source_index : source_indexes_.items()) {
+    if (source_index.isValid()) ret << source_index.row();
   }
-  return false;
+  return ret;
 }
 
 QModelIndex Queue::mapToSource(const QModelIndex& proxy_index) const {
   if (!proxy_index.isValid()) return QModelIndex();
 
-  return source_indexes_[proxy_index.row()];
+  return source_indexes_.at(proxy_index.row());
 }
 
 void Queue::setSourceModel(QAbstractItemModel* source_model) {
@@ -81,11 +96,31 @@ void Queue::setSourceModel(QAbstractItemModel* source_model) {
 
 void Queue::SourceDataChanged(const QModelIndex& top_left,
                               const QModelIndex& bottom_right) {
-  for (int row = top_left.row(); row <= bottom_right.row(); ++row) {
-    QModelIndex proxy_index = mapFromSource(sourceModel()->index(row, 0));
-    if (!proxy_index.isValid()) continue;
-
-    emit dataChanged(proxy_index, proxy_index);
+  // Look through whichever is shorter, the changed rows or the queue.
+  QList<int> rows;
+  const int first_row = top_left.row();
+  const int last_row = bottom_right.row();
+  if (last_row - first_row + 1 <= source_indexes_.count()) {
+    for (int row = first_row; row <= last_row; ++row) {
+      const int proxy_row = source_indexes_.position_of(
+          QPersistentModelIndex(sourceModel()->index(row, 0)));
+      if (proxy_row != -1) rows << proxy_row;
+    }
+  } else {
+    const QList<QPersistentModelIndex> items = source_indexes_.items();
+    for (int i = 0; i < items.count(); ++i) {
+      const int row = items[i].row();
+      if (row >= first_row && row <= last_row) rows << i;
+    }
+  }
+  if (rows.isEmpty()) return;
+
+  std::sort(rows.begin(), rows.end());
+  for (int i = 0; i < rows.count();) {
+    int j = i + 1;
+    while (j < rows.count() && rows[j] == rows[j - 1] + 1) ++j;
+    emit dataChanged(index(rows[i], 0), index(rows[j - 1], 0));
+    i = j;
   }
   emit ItemCountChanged(this->ItemCount());
 }
@@ -94,15 +129,12 @@ void Queue::SourceLayoutChanged() {
   // Temporarily disconnect this signal to prevent UpdateTotalLength from
   // being called when SourceDataChanged is handled during this scrub.
   disconnect(count_changed_);
-  for (int i = 0; i < source_indexes_.count(); ++i) {
-    if (!source_indexes_[i].isValid()) {
-      beginRemoveRows(QModelIndex(), i, i);
-      source_indexes_.removeAt(i);
-      endRemoveRows();
-
-      --i;
-    }
+  QList<int> invalid_rows;
+  const QList<QPersistentModelIndex> items = source_indexes_.items();
+  for (int i = 0; i < items.count(); ++i) {
+    if (!items[i].isValid()) invalid_rows << i;
   }
+  RemoveRows(invalid_rows);
   // Re-connect before emitting the signal ourselves.
   count_changed_ =
       connect(this, SIGNAL(ItemCountChanged(int)), SLOT(UpdateTotalLength()));
@@ -122,10 +154,51 @@ int Queue::rowCount(const QModelIndex& parent) const {
   return source_indexes_.count();
 }
 
+void Queue::RemoveRows(QList<int> proxy_rows) {
+  // Remove runs of neighbouring rows together, starting at the end so the
+  // rows before them don't move.
+  std::sort(proxy_rows.begin(), proxy_rows.end());
+  proxy_rows.erase(std::unique(proxy_rows.begin(), proxy_rows.end()),
+                   proxy_rows.end());
+
+  int end = proxy_rows.count();
+  while (end > 0) {
+    int begin = end - 1;
+    while (begin > 0 && proxy_rows[begin - 1] == proxy_rows[begin] - 1) {
+      --begin;
+    }
+
+    const int first = proxy_rows[begin];
+    const int last = proxy_rows[end - 1];
+    beginRemoveRows(QModelIndex(), first, last);
+    source_indexes_.take(first, last - first + 1);
+    endRemoveRows();
+
+    end = begin;
+  }
+}
+
+void Queue::InsertRows(int proxy_row,
+                       const QList<QPersistentModelIndex>& source_indexes) {
+  // Tracks can only be in the queue once.
+  QList<QPersistentModelIndex> indexes;
+  QSet<QPersistentModelIndex> index_set;
+  for (const QPersistentModelIndex& index : source_indexes) {
+    if (source_indexes_.contains(index) || index_set.contains(index)) continue;
+    index_set << index;
+    indexes << index;
+  }
+  if (indexes.isEmpty()) return;
+
+  beginInsertRows(QModelIndex(), proxy_row, proxy_row + indexes.count() - 1);
+  source_indexes_.insert(proxy_row, indexes);
+  endInsertRows();
+}
+
 int Queue::columnCount(const QModelIndex&) const { return 1; }
 
 QVariant Queue::data(const QModelIndex& proxy_index, int role) const {
-  QModelIndex source_index = source_indexes_[proxy_index.row()];
+  QModelIndex source_index = source_indexes_.at(proxy_index.row());
 
   switch (role) {
     case Playlist::Role_QueuePosition:
@@ -151,45 +224,42 @@ QVariant Queue::data(const QModelIndex& proxy_index, int role) const {
 }
 
 void Queue::ToggleTracks(const QModelIndexList& source_indexes) {
+  QList<int> dequeue_rows;
+  QList<QPersistentModelIndex> enqueue;
+
   for (const QModelIndex& source_index : source_indexes) {
-    QModelIndex proxy_index = mapFromSource(source_index);
-    if (proxy_index.isValid()) {
+    const QPersistentModelIndex index = SourceRowIndex(source_index);
+    const int row = source_indexes_.position_of(index);
+    if (row != -1) {
       // Dequeue the track
-      const int row = proxy_index.row();
-      beginRemoveRows(QModelIndex(), row, row);
-      source_indexes_.removeAt(row);
-      endRemoveRows();
+      dequeue_rows << row;
     } else {
       // Enqueue the track
-      const int row = source_indexes_.count();
-      beginInsertRows(QModelIndex(), row, row);
-      source_indexes_ << QPersistentModelIndex(source_index);
-      endInsertRows();
+      enqueue << index;
     }
   }
+
+  RemoveRows(dequeue_rows);
+  InsertRows(source_indexes_.count(), enqueue);
 }
 
 void Queue::InsertFirst(const QModelIndexList& source_indexes) {
+  QList<int> queued_rows;
+  QList<QPersistentModelIndex> indexes;
+
   for (const QModelIndex& source_index : source_indexes) {
-    QModelIndex proxy_index = mapFromSource(source_index);
-    if (proxy_index.isValid()) {
-      // Already in the queue, so remove it to be reinserted later
-      const int row = proxy_index.row();
-      beginRemoveRows(QModelIndex(), row, row);
-      source_indexes_.removeAt(row);
-      endRemoveRows();
-    }
+    const QPersistentModelIndex index = SourceRowIndex(source_index);
+    indexes << index;
+
+    // Already in the queue, so remove it to be reinserted later
+    const int row = source_indexes_.position_of(index);
+    if (row != -1) queued_rows << row;
   }
 
-  const int rows = source_indexes.count();
+  RemoveRows(queued_rows);
+
   // Enqueue the tracks at the beginning
-  beginInsertRows(QModelIndex(), 0, rows - 1);
-  int offset = 0;
-  for (const QModelIndex& source_index : source_indexes) {
-    source_indexes_.insert(offset, QPersistentModelIndex(source_index));
-    offset++;
-  }
-  endInsertRows();
+  InsertRows(0, indexes);
 }
 
 int Queue::PositionOf(const QModelIndex& source_index) const {
@@ -198,14 +268,14 @@ int Queue::PositionOf(const QModelIndex& source_index) const {
 
 bool Queue::is_empty() const { return source_indexes_.isEmpty(); }
 
-int Queue::ItemCount() const { return source_indexes_.length(); }
+int Queue::ItemCount() const { return source_indexes_.count(); }
 
 quint64 Queue::GetTotalLength() const { return total_length_ns_; }
 
 void Queue::UpdateTotalLength() {
   quint64 total = 0;
 
-  for (QPersistentModelIndex row : source_indexes_) {
+  for (const QPersistentModelIndex& row : source_indexes_.items()) {
     int id = row.row();
 
     Q_ASSERT(playlist_->has_item_at(id));
@@ -249,16 +319,14 @@ void Queue::Move(const QList<int>& proxy_rows, int pos) {
   // insertion point changes
   int offset = 0;
   for (int row : proxy_rows) {
-    moved_items << source_indexes_.takeAt(row - offset);
+    moved_items << source_indexes_.take(row - offset);
     if (pos != -1 && pos >= row) pos--;
     offset++;
   }
 
   // Put the items back in
   const int start = pos == -1 ? source_indexes_.count() : pos;
-  for (int i = start; i < start + moved_items.count(); ++i) {
-    source_indexes_.insert(i, moved_items[i - start]);
-  }
+  source_indexes_.insert(start, moved_items);
 
   // Update persistent indexes
   for (const QModelIndex& pidx : persistentIndexList()) {
@@ -350,15 +418,11 @@ bool Queue::dropMimeData(const QMimeData* data, Qt::DropAction action, int row,
       source_indexes << source_index;
     }
 
-    if (!source_indexes.isEmpty()) {
-      const int insert_point = row == -1 ? source_indexes_.count() : row;
-      beginInsertRows(QModelIndex(), insert_point,
-                      insert_point + source_indexes.count() - 1);
-      for (int i = 0; i < source_indexes.count(); ++i) {
-        source_indexes_.insert(insert_point + i, source_indexes[i]);
-      }
-      endInsertRows();
+    QList<QPersistentModelIndex> indexes;
+    for (const QModelIndex& source_index : source_indexes) {
+      indexes << QPersistentModelIndex(source_index);
     }
+    InsertRows(row == -1 ? source_indexes_.count() : row, indexes);
   }
 
   return true;
@@ -377,14 +441,14 @@ Qt::ItemFlags Queue::flags(const QModelIndex& index) const {
 
 int Queue::PeekNext() const {
   if (source_indexes_.isEmpty()) return -1;
-  return source_indexes_.first().row();
+  return source_indexes_.at(0).row();
 }
 
 int Queue::TakeNext() {
   if (source_indexes_.isEmpty()) return -1;
 
   beginRemoveRows(QModelIndex(), 0, 0);
-  int ret = source_indexes_.takeFirst().row();
+  int ret = source_indexes_.take(0).first().row();
   endRemoveRows();
 
   return ret;
@@ -395,22 +459,4 @@ QVariant Queue::headerData(int section, Qt::Orientation orientation,
   return QVariant();
 }
 
-void Queue::Remove(QList<int>& proxy_rows) {
-  // order the rows
-  std::stable_sort(proxy_rows.begin(), proxy_rows.end());
-
-  // reflects immediately changes in the playlist
-  emit layoutAboutToBeChanged();
-
-  int removed_rows = 0;
-  for (int row : proxy_rows) {
-    // after the first row, the row number needs to be updated
-    const int real_row = row - removed_rows;
-    beginRemoveRows(QModelIndex(), real_row, real_row);
-    source_indexes_.removeAt(real_row);
-    endRemoveRows();
-    removed_rows++;
-  }
-
-  emit layoutChanged();
-}
+void Queue::Remove(QList<int>& proxy_rows) { RemoveRows(proxy_rows); }
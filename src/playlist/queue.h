@@ -21,6 +21,7 @@
 #include <QAbstractProxyModel>
 
 #include "playlist.h"
+#include "queueorder.h"
 
 class Queue : public QAbstractProxyModel {
   Q_OBJECT
@@ -36,6 +37,8 @@ class Queue : public QAbstractProxyModel {
   bool ContainsSourceRow(int source_row) const;
   int PeekNext() const;
   int ItemCount() const;
+  // The playlist rows in the queue, in order.
+  QList<int> SourceRows() const;
   quint64 GetTotalLength() const;
 
   // Modify the queue
@@ -83,7 +86,13 @@ class Queue : public QAbstractProxyModel {
   void UpdateTotalLength();
 
  private:
-  QList<QPersistentModelIndex> source_indexes_;
+  // Removes the rows, and inserts source_indexes that aren't in the queue
+  // already, with one notification for each run of neighbouring rows.
+  void RemoveRows(QList<int> proxy_rows);
+  void InsertRows(int proxy_row,
+                  const QList<QPersistentModelIndex>& source_indexes);
+
+  QueueOrder source_indexes_;
   const Playlist* playlist_;
   quint64 total_length_ns_;
   QMetaObject::Connection count_changed_;
@@ -0,0 +1,177 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "queueorder.h"
+
+QueueOrder::Node::Node(const QPersistentModelIndex& i)
+    : index_(i),
+      left_(nullptr),
+      right_(nullptr),
+      parent_(nullptr),
+      size_(1),
+      priority_(0) {}
+
+QueueOrder::QueueOrder() : root_(nullptr), priority_state_(0x9E3779B9u) {}
+
+QueueOrder::~QueueOrder() { clear(); }
+
+int QueueOrder::count() const { return SizeOf(root_); }
+
+const QPersistentModelIndex& QueueOrder::at(int position) const {
+  const Node* node = root_;
+  forever {
+    const int left_size = SizeOf(node->left_);
+    if (position < left_size) {
+      node = node->left_;
+    } else if (position == left_size) {
+      return node->index_;
+    } else {
+      position -= left_size + 1;
+      node = node->right_;
+    }
+  }
+}
+
+int QueueOrder::position_of(const QPersistentModelIndex& index) const {
+  const Node* node = nodes_.value(index);
+  if (!node) return -1;
+
+  int ret = SizeOf(node->left_);
+  for (; node->parent_; node = node->parent_) {
+    if (node == node->parent_->right_) {
+      ret += SizeOf(node->parent_->left_) + 1;
+    }
+  }
+  return ret;
+}
+
+bool QueueOrder::contains(const QPersistentModelIndex& index) const {
+  return nodes_.contains(index);
+}
+
+QList<QPersistentModelIndex> QueueOrder::items() const {
+  QList<QPersistentModelIndex> ret;
+  ret.reserve(count());
+  Collect(root_, &ret);
+  return ret;
+}
+
+int QueueOrder::insert(int position,
+                       const QList<QPersistentModelIndex>& indexes) {
+  Node* inserted = nullptr;
+  int ret = 0;
+  for (const QPersistentModelIndex& index : indexes) {
+    if (nodes_.contains(index)) continue;
+
+    Node* node = new Node(index);
+    node->priority_ = NextPriority();
+    nodes_.insert(index, node);
+    inserted = Merge(inserted, node);
+    ++ret;
+  }
+  if (!inserted) return 0;
+
+  Node* left = nullptr;
+  Node* right = nullptr;
+  Split(root_, position, &left, &right);
+  root_ = Merge(Merge(left, inserted), right);
+  root_->parent_ = nullptr;
+  return ret;
+}
+
+QList<QPersistentModelIndex> QueueOrder::take(int position, int count) {
+  Node* left = nullptr;
+  Node* middle = nullptr;
+  Node* right = nullptr;
+  Split(root_, position, &left, &middle);
+  Split(middle, count, &middle, &right);
+  root_ = Merge(left, right);
+  if (root_) root_->parent_ = nullptr;
+
+  QList<QPersistentModelIndex> ret;
+  Collect(middle, &ret);
+  Delete(middle);
+  return ret;
+}
+
+void QueueOrder::clear() {
+  Delete(root_);
+  root_ = nullptr;
+}
+
+void QueueOrder::Update(Node* node) {
+  node->size_ = 1 + SizeOf(node->left_) + SizeOf(node->right_);
+  if (node->left_) node->left_->parent_ = node;
+  if (node->right_) node->right_->parent_ = node;
+}
+
+QueueOrder::Node* QueueOrder::Merge(Node* left, Node* right) {
+  if (!left) return right;
+  if (!right) return left;
+
+  if (left->priority_ > right->priority_) {
+    left->right_ = Merge(left->right_, right);
+    Update(left);
+    return left;
+  }
+  right->left_ = Merge(left, right->left_);
+  Update(right);
+  return right;
+}
+
+void QueueOrder::Split(Node* tree, int count, Node** left, Node** right) {
+  if (!tree) {
+    *left = nullptr;
+    *right = nullptr;
+    return;
+  }
+
+  tree->parent_ = nullptr;
+  const int left_size = SizeOf(tree->left_);
+  if (count <= left_size) {
+    Split(tree->left_, count, left, &tree->left_);
+    *right = tree;
+  } else {
+    Split(tree->right_, count - left_size - 1, &tree->right_, right);
+    *left = tree;
+  }
+  Update(tree);
+}
+
+void QueueOrder::Collect(const Node* node, QList<QPersistentModelIndex>* ret) {
+  if (!node) return;
+  Collect(node->left_, ret);
+  ret->append(node->index_);
+  Collect(node->right_, ret);
+}
+
+void QueueOrder::Delete(Node* node) {
+  if (!node) return;
+  Delete(node->left_);
+  Delete(node->right_);
+  nodes_.remove(node->index_);
+  delete node;
+}
+
+quint32 QueueOrder::NextPriority() {
+  // xorshift32 - the priorities only need to look random to keep the tree
+  // balanced.
+  priority_state_ ^= priority_state_ << 13;
+  priority_state_ ^= priority_state_ >> 17;
+  priority_state_ ^= priority_state_ << 5;
+  return priority_state_;
+}
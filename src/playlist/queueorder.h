@@ -0,0 +1,84 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLIST_QUEUEORDER_H_
+#define PLAYLIST_QUEUEORDER_H_
+
+#include <QHash>
+#include <QList>
+#include <QPersistentModelIndex>
+
+// The playlist rows in a Queue, in the order they'll be played.
+//
+// The rows are kept in a balanced tree ordered by position, so finding the row
+// at a position or the position of a row, and inserting or removing rows
+// anywhere, takes O(log n).  A hash from each row's persistent index to its
+// node makes membership tests O(1).  The same row can't be in it twice.
+class QueueOrder {
+ public:
+  QueueOrder();
+  ~QueueOrder();
+
+  int count() const;
+  bool isEmpty() const { return root_ == nullptr; }
+
+  // The index at a position, which must be less than count().
+  const QPersistentModelIndex& at(int position) const;
+  // Where index is, or -1 if it isn't in the queue.
+  int position_of(const QPersistentModelIndex& index) const;
+  bool contains(const QPersistentModelIndex& index) const;
+
+  // All the indexes in order.
+  QList<QPersistentModelIndex> items() const;
+
+  // Inserts indexes at position, leaving out ones that are already in the
+  // queue.  Returns how many were inserted.
+  int insert(int position, const QList<QPersistentModelIndex>& indexes);
+  // Removes count indexes starting at position and returns them.
+  QList<QPersistentModelIndex> take(int position, int count = 1);
+  void clear();
+
+ private:
+  Q_DISABLE_COPY(QueueOrder)
+
+  struct Node {
+    explicit Node(const QPersistentModelIndex& i);
+
+    QPersistentModelIndex index_;
+    Node* left_;
+    Node* right_;
+    Node* parent_;
+    int size_;
+    quint32 priority_;
+  };
+
+  static int SizeOf(const Node* node) { return node ? node->size_ : 0; }
+  static void Update(Node* node);
+  static Node* Merge(Node* left, Node* right);
+  // Splits the first count nodes of tree into left and the rest into right.
+  static void Split(Node* tree, int count, Node** left, Node** right);
+  static void Collect(const Node* node, QList<QPersistentModelIndex>* ret);
+  void Delete(Node* node);
+
+  quint32 NextPriority();
+
+  Node* root_;
+  QHash<QPersistentModelIndex, Node*> nodes_;
+  quint32 priority_state_;
+};
+
+#endif  // PLAYLIST_QUEUEORDER_H_
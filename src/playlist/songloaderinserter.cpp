@@ -17,13 +17,16 @@
 
 #include "songloaderinserter.h"
 
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 
 #include "core/logging.h"
-#include "core/songloader.h"
 #include "core/taskmanager.h"
 #include "playlist.h"
 
+const int SongLoaderInserter::kFirstChunkSize = 20;
+const int SongLoaderInserter::kChunkSize = 500;
+
 SongLoaderInserter::SongLoaderInserter(TaskManager* task_manager,
                                        LibraryBackendInterface* library,
                                        const Player* player)
@@ -32,10 +35,14 @@ SongLoaderInserter::SongLoaderInserter(TaskManager* task_manager,
       row_(-1),
       play_now_(true),
       enqueue_(false),
+      enqueue_next_(false),
+      inserted_count_(0),
       library_(library),
       player_(player) {}
 
-SongLoaderInserter::~SongLoaderInserter() { qDeleteAll(pending_); }
+SongLoaderInserter::~SongLoaderInserter() {
+  for (const PendingLoad& load : pending_) delete load.loader_;
+}
 
 void SongLoaderInserter::Load(Playlist* destination, int row, bool play_now,
                               bool enqueue, bool enqueue_next,
@@ -47,29 +54,36 @@ void SongLoaderInserter::Load(Playlist* destination, int row, bool play_now,
   enqueue_next_ = enqueue_next;
 
   connect(destination, SIGNAL(destroyed()), SLOT(DestinationDestroyed()));
-  connect(this, SIGNAL(PreloadFinished()), SLOT(InsertSongs()));
+  connect(this, SIGNAL(PreloadFinished(const SongList&)),
+          SLOT(InsertSongs(const SongList&)));
   connect(this, SIGNAL(EffectiveLoadFinished(const SongList&)), destination,
           SLOT(UpdateItems(const SongList&)));
 
+  bool blocking_load_required = false;
   for (const QUrl& url : urls) {
     SongLoader* loader = new SongLoader(library_, player_, this);
+    PendingLoad load = {url, loader, SongLoader::BlockingLoadRequired, true};
 
-    SongLoader::Result ret = loader->Load(url);
+    if (!url.isLocalFile()) {
+      load.result_ = loader->Load(url);
+      load.local_ = false;
 
-    if (ret == SongLoader::BlockingLoadRequired) {
-      pending_.append(loader);
-      continue;
+      if (load.result_ == SongLoader::Error) {
+        emit Error(tr("Error loading %1").arg(url.toString()));
+        delete loader;
+        continue;
+      }
     }
 
-    if (ret == SongLoader::Success)
-      songs_ << loader->songs();
-    else
-      emit Error(tr("Error loading %1").arg(url.toString()));
-    delete loader;
+    if (load.result_ == SongLoader::BlockingLoadRequired) {
+      blocking_load_required = true;
+    }
+    pending_ << load;
   }
 
-  if (pending_.isEmpty()) {
-    InsertSongs();
+  if (!blocking_load_required) {
+    for (const PendingLoad& load : pending_) songs_ << load.loader_->songs();
+    InsertSongs(songs_);
     deleteLater();
   } else {
     QtConcurrent::run(this, &SongLoaderInserter::AsyncLoad);
@@ -108,7 +122,7 @@ void SongLoaderInserter::DestinationDestroyed() { destination_ = nullptr; }
 
 void SongLoaderInserter::AudioCDTracksLoaded(SongLoader* loader) {
   songs_ = loader->songs();
-  InsertSongs();
+  InsertSongs(songs_);
 }
 
 void SongLoaderInserter::AudioCDTagsLoaded(bool success) {
@@ -122,62 +136,131 @@ void SongLoaderInserter::AudioCDTagsLoaded(bool success) {
   deleteLater();
 }
 
-void SongLoaderInserter::InsertSongs() {
+void SongLoaderInserter::InsertSongs(const SongList& songs) {
   // Insert songs (that haven't been completely loaded) to allow user to see
   // and play them while not loaded completely
-  if (destination_) {
-    destination_->InsertSongsOrLibraryItems(songs_, row_, play_now_, enqueue_,
-                                            enqueue_next_);
+  if (destination_ && !songs.isEmpty()) {
+    int row = row_;
+    if (row != -1) {
+      row = qMin(row_ + inserted_count_, destination_->rowCount());
+    }
+    destination_->InsertSongsOrLibraryItems(songs, row,
+                                            play_now_ && inserted_count_ == 0,
+                                            enqueue_, enqueue_next_);
   }
+  inserted_count_ += songs.count();
 }
 
 void SongLoaderInserter::AsyncLoad() {
-  // First, quick load raw songs.
-  int async_progress = 0;
+  // First, quick load raw songs, a chunk of URLs at a time.  Local files are
+  // looked up in the library in parallel.
   int async_load_id = task_manager_->StartTask(tr("Loading tracks"));
-  task_manager_->SetTaskProgress(async_load_id, async_progress,
-                                 pending_.count());
-  bool first_loaded = false;
-  for (int i = 0; i < pending_.count(); ++i) {
-    SongLoader* loader = pending_[i];
-    SongLoader::Result res = loader->LoadFilenamesBlocking();
+  task_manager_->SetTaskProgress(async_load_id, 0, pending_.count());
 
-    task_manager_->SetTaskProgress(async_load_id, ++async_progress);
+  // Each chunk is inserted after the one before it, but chunks queued to play
+  // next would end up in the queue back to front, so those go in all at once.
+  const bool insert_chunks = !enqueue_next_;
+
+  bool first_loaded = false;
+  auto add_songs = [this, insert_chunks, &first_loaded](SongList songs) {
+    if (songs.isEmpty()) return;
 
-    if (res == SongLoader::Error) {
-      emit Error(tr("Error loading %1").arg(loader->url().toString()));
-      continue;
-    }
     if (!first_loaded) {
       // Load everything from the first song.  It'll start playing as soon as
       // we emit PreloadFinished, so it needs to have the duration set to show
       // properly in the UI.
-      loader->LoadMetadataBlocking();
+      SongLoader::EffectiveSongLoad(library_, &songs[0]);
       first_loaded = true;
     }
-    songs_ << loader->songs();
+
+    songs_ << songs;
+    if (insert_chunks) emit PreloadFinished(songs);
+  };
+
+  auto is_playlist = [](const PendingLoad& load) {
+    return load.local_ && load.loader_->IsPlaylist(load.url_);
+  };
+
+  int begin = 0;
+  while (begin < pending_.count()) {
+    PendingLoad& first = pending_[begin];
+    if (is_playlist(first)) {
+      // Playlists are loaded on their own and hand over their songs as
+      // they're parsed, so big ones start being inserted right away.
+      first.loader_->set_chunk_callback(add_songs);
+      first.result_ = first.loader_->Load(first.url_);
+      if (first.result_ == SongLoader::BlockingLoadRequired) {
+        first.result_ = first.loader_->LoadFilenamesBlocking();
+      }
+
+      if (first.result_ == SongLoader::Error) {
+        emit Error(tr("Error loading %1").arg(first.url_.toString()));
+      } else {
+        add_songs(first.loader_->songs());
+      }
+
+      ++begin;
+      task_manager_->SetTaskProgress(async_load_id, begin);
+      continue;
+    }
+
+    // Other local files are loaded in parallel, up to the next playlist.
+    const int max_end = qMin(
+        pending_.count(), begin + (begin == 0 ? kFirstChunkSize : kChunkSize));
+    int end = begin + 1;
+    while (end < max_end && !is_playlist(pending_[end])) ++end;
+
+    QtConcurrent::blockingMap(
+        pending_.begin() + begin, pending_.begin() + end,
+        [](PendingLoad& load) {
+          if (!load.local_) return;
+          load.result_ = load.loader_->Load(load.url_);
+          if (load.result_ == SongLoader::BlockingLoadRequired) {
+            load.result_ = load.loader_->LoadFilenamesBlocking();
+          }
+        });
+
+    SongList songs;
+    for (int i = begin; i < end; ++i) {
+      PendingLoad& load = pending_[i];
+      if (load.result_ == SongLoader::BlockingLoadRequired) {
+        // Remote URLs wait on their own timers and pipelines, so they're
+        // still loaded one at a time.
+        load.result_ = load.loader_->LoadFilenamesBlocking();
+      }
+
+      if (load.result_ == SongLoader::Error) {
+        emit Error(tr("Error loading %1").arg(load.url_.toString()));
+        continue;
+      }
+      songs << load.loader_->songs();
+    }
+
+    add_songs(songs);
+    task_manager_->SetTaskProgress(async_load_id, end);
+
+    begin = end;
   }
   task_manager_->SetTaskFinished(async_load_id);
-  emit PreloadFinished();
+  if (!insert_chunks) emit PreloadFinished(songs_);
 
   // Songs are inserted in playlist, now load them completely.
-  async_progress = 0;
   async_load_id = task_manager_->StartTask(tr("Loading tracks info"));
-  task_manager_->SetTaskProgress(async_load_id, async_progress, songs_.count());
-  SongList songs;
-  for (int i = 0; i < pending_.count(); ++i) {
-    SongLoader* loader = pending_[i];
-    if (i != 0) {
-      // We already did this earlier for the first song.
-      loader->LoadMetadataBlocking();
-    }
-    songs << loader->songs();
-    task_manager_->SetTaskProgress(async_load_id, songs.count());
+  task_manager_->SetTaskProgress(async_load_id, 0, songs_.count());
+  LibraryBackendInterface* library = library_;
+  for (begin = 0; begin < songs_.count(); begin += kChunkSize) {
+    const int end = qMin(songs_.count(), begin + kChunkSize);
+
+    QtConcurrent::blockingMap(songs_.begin() + begin, songs_.begin() + end,
+                              [library](Song& song) {
+                                SongLoader::EffectiveSongLoad(library, &song);
+                              });
+    task_manager_->SetTaskProgress(async_load_id, end);
+
+    // Replace the partially-loaded items by the new ones, fully loaded.
+    emit EffectiveLoadFinished(songs_.mid(begin, end - begin));
   }
   task_manager_->SetTaskFinished(async_load_id);
 
-  // Replace the partially-loaded items by the new ones, fully loaded.
-  emit EffectiveLoadFinished(songs);
-
   deleteLater();
 }
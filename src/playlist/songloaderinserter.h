@@ -23,11 +23,11 @@
 #include <QUrl>
 
 #include "core/song.h"
+#include "core/songloader.h"
 
 class LibraryBackendInterface;
 class Player;
 class Playlist;
-class SongLoader;
 class TaskManager;
 
 class QModelIndex;
@@ -44,18 +44,32 @@ class SongLoaderInserter : public QObject {
   void LoadAudioCD(Playlist* destination, int row, bool play_now, bool enqueue,
                    bool enqueue_now);
 
+  // Songs are inserted as soon as the URLs before them are loaded.  The first
+  // chunk is kept small so it can start playing right away.
+  static const int kFirstChunkSize;
+  static const int kChunkSize;
+
  signals:
   void Error(const QString& message);
-  void PreloadFinished();
+  void PreloadFinished(const SongList& songs);
   void EffectiveLoadFinished(const SongList& songs);
 
  private slots:
   void DestinationDestroyed();
   void AudioCDTracksLoaded(SongLoader* loader);
   void AudioCDTagsLoaded(bool success);
-  void InsertSongs();
+  void InsertSongs(const SongList& songs);
 
  private:
+  struct PendingLoad {
+    QUrl url_;
+    SongLoader* loader_;
+    SongLoader::Result result_;
+    // Local files are looked up in the library on a worker thread, so
+    // Load() hasn't been called yet.
+    bool local_;
+  };
+
   void AsyncLoad();
 
  private:
@@ -68,8 +82,9 @@ class SongLoaderInserter : public QObject {
   bool enqueue_next_;
 
   SongList songs_;
+  int inserted_count_;
 
-  QList<SongLoader*> pending_;
+  QList<PendingLoad> pending_;
   LibraryBackendInterface* library_;
   const Player* player_;
 };
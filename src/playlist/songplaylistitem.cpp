@@ -51,8 +51,27 @@ QUrl SongPlaylistItem::Url() const { return song_.url(); }
 void SongPlaylistItem::Reload() {
   if (song_.url().scheme() != "file") return;
 
-  TagReaderClient::Instance()->ReadFileBlocking(song_.url().toLocalFile(),
-                                                &song_);
+  TagReaderClient::Instance()->ReadFileBlocking(
+      song_.url().toLocalFile(), &song_, TagReaderClient::Priority_Playback);
+}
+
+void SongPlaylistItem::ReloadAsync(QObject* receiver,
+                                   std::function<void()> done) {
+  if (song_.url().scheme() != "file") {
+    done();
+    return;
+  }
+
+  // Holding on to the item keeps it alive until the tags are back, even if
+  // it's removed from the playlist in the mean time.
+  PlaylistItemPtr self = shared_from_this();
+  TagReaderClient::Instance()->ReadFileAsync(
+      song_.url().toLocalFile(), song_, receiver,
+      [this, self, done](const Song& song) {
+        song_ = song;
+        done();
+      },
+      TagReaderClient::Priority_Playback);
 }
 
 Song SongPlaylistItem::Metadata() const {
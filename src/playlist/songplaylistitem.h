@@ -33,8 +33,10 @@ class SongPlaylistItem : public PlaylistItem {
   // attributes (if any) but won't parse the CUE!
   bool InitFromQuery(const SqlRow& query);
   void Reload();
+  void ReloadAsync(QObject* receiver, std::function<void()> done);
 
   Song Metadata() const;
+  void InternStrings() { song_.InternStrings(); }
 
   QUrl Url() const;
 
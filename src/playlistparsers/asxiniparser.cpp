@@ -31,7 +31,7 @@ bool AsxIniParser::TryMagic(const QByteArray& data) const {
 
 SongList AsxIniParser::Load(QIODevice* device, const QString& playlist_path,
                             const QDir& dir) const {
-  SongList ret;
+  SongList songs;
 
   while (!device->atEnd()) {
     QString line = QString::fromUtf8(device->readLine()).trimmed();
@@ -40,24 +40,34 @@ SongList AsxIniParser::Load(QIODevice* device, const QString& playlist_path,
     QString value = line.mid(equals + 1);
 
     if (key.startsWith("ref")) {
-      Song song = LoadSong(value, 0, dir);
-      if (song.is_valid()) {
-        ret << song;
-      }
+      Song song;
+      LocateSong(value, 0, dir, &song);
+      songs << song;
     }
   }
 
+  LoadSongs(&songs);
+
+  SongList ret;
+  for (const Song& song : songs) {
+    if (song.is_valid()) {
+      ret << song;
+    }
+  }
   return ret;
 }
 
 void AsxIniParser::Save(const SongList& songs, QIODevice* device,
-                        const QDir& dir, Playlist::Path path_type) const {
+                        const QDir& dir, Playlist::Path path_type,
+                        const ProgressCallback& progress) const {
   QTextStream s(device);
   s << "[Reference]" << endl;
 
+  PathCache paths(dir, path_type);
   int n = 1;
   for (const Song& song : songs) {
-    s << "Ref" << n << "=" << URLOrFilename(song.url(), dir, path_type) << endl;
+    ReportProgress(progress, n - 1);
+    s << "Ref" << n << "=" << paths.URLOrFilename(song.url()) << endl;
     ++n;
   }
 }
@@ -70,8 +70,24 @@ SongList ASXParser::Load(QIODevice* device, const QString& playlist_path,
     return ret;
   }
 
+  SongList songs;
+  SongList metadata;
   while (!reader.atEnd() && Utilities::ParseUntilElement(&reader, "entry")) {
-    Song song = ParseTrack(&reader, dir);
+    Song song;
+    metadata << ParseTrack(&reader, dir, &song);
+    songs << song;
+  }
+
+  LoadSongs(&songs);
+
+  for (int i = 0; i < songs.count(); ++i) {
+    Song& song = songs[i];
+
+    // Override metadata with what was in the playlist
+    song.set_title(metadata[i].title());
+    song.set_artist(metadata[i].artist());
+    song.set_album(metadata[i].album());
+
     if (song.is_valid()) {
       ret << song;
     }
@@ -79,7 +95,8 @@ SongList ASXParser::Load(QIODevice* device, const QString& playlist_path,
   return ret;
 }
 
-Song ASXParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir) const {
+Song ASXParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir,
+                           Song* song) const {
   QString title, artist, album, ref;
 
   while (!reader->atEnd()) {
@@ -109,17 +126,17 @@ Song ASXParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir) const {
   }
 
 return_song:
-  Song song = LoadSong(ref, 0, dir);
+  LocateSong(ref, 0, dir, song);
 
-  // Override metadata with what was in the playlist
-  song.set_title(title);
-  song.set_artist(artist);
-  song.set_album(album);
-  return song;
+  Song metadata;
+  metadata.set_title(title);
+  metadata.set_artist(artist);
+  metadata.set_album(album);
+  return metadata;
 }
 
 void ASXParser::Save(const SongList& songs, QIODevice* device, const QDir&,
-                     Playlist::Path path_type) const {
+                     Playlist::Path, const ProgressCallback& progress) const {
   QXmlStreamWriter writer(device);
   writer.setAutoFormatting(true);
   writer.setAutoFormattingIndent(2);
@@ -127,7 +144,9 @@ void ASXParser::Save(const SongList& songs, QIODevice* device, const QDir&,
   {
     StreamElement asx("asx", &writer);
     writer.writeAttribute("version", "3.0");
+    int saved = 0;
     for (const Song& song : songs) {
+      ReportProgress(progress, saved++);
       StreamElement entry("entry", &writer);
       writer.writeTextElement("title", song.title());
       {
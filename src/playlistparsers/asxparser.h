@@ -34,10 +34,14 @@ class ASXParser : public XMLParser {
   SongList Load(QIODevice* device, const QString& playlist_path = "",
                 const QDir& dir = QDir()) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
 
  private:
-  Song ParseTrack(QXmlStreamReader* reader, const QDir& dir) const;
+  // Locates the entry's song and returns the metadata the playlist gives for
+  // it.
+  Song ParseTrack(QXmlStreamReader* reader, const QDir& dir,
+                  Song* song) const;
 };
 
 #endif
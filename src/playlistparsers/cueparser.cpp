@@ -224,11 +224,19 @@ SongList CueParser::Load(QIODevice* device, const QString& playlist_path,
 
   QDateTime cue_mtime = QFileInfo(playlist_path).lastModified();
 
+  SongList songs;
+  for (const CueEntry& entry : entries) {
+    Song song;
+    LocateSong(entry.file, IndexToMarker(entry.index), dir, &song);
+    songs << song;
+  }
+  LoadSongs(&songs);
+
   // finalize parsing songs
   for (int i = 0; i < entries.length(); i++) {
     CueEntry entry = entries.at(i);
 
-    Song song = LoadSong(entry.file, IndexToMarker(entry.index), dir);
+    Song song = songs[i];
 
     // cue song has mtime equal to qMax(media_file_mtime, cue_sheet_mtime)
     if (cue_mtime.isValid()) {
@@ -349,7 +357,8 @@ qint64 CueParser::IndexToMarker(const QString& index) const {
 }
 
 void CueParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
-                     Playlist::Path path_type) const {
+                     Playlist::Path path_type,
+                     const ProgressCallback& progress) const {
   // TODO: Not yet implemented. Cue files represent tracks within a single
   //       file, so the song list would need to be composed properly.
   emit Error(tr("Saving cue files is not yet supported."));
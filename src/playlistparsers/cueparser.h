@@ -55,7 +55,8 @@ class CueParser : public ParserBase {
   SongList Load(QIODevice* device, const QString& playlist_path = "",
                 const QDir& dir = QDir()) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
 
  private:
   // A single TRACK entry in .cue file.
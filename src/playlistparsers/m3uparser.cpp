@@ -31,50 +31,84 @@ M3UParser::M3UParser(LibraryBackendInterface* library, QObject* parent)
 
 SongList M3UParser::Load(QIODevice* device, const QString& playlist_path,
                          const QDir& dir) const {
-  SongList ret;
+  return LoadAllChunks(device, playlist_path, dir);
+}
 
+void M3UParser::LoadChunks(QIODevice* device, const QString& playlist_path,
+                           const QDir& dir,
+                           const ChunkCallback& callback) const {
   M3UType type = STANDARD;
   Metadata current_metadata;
 
+  SongList songs;
+  QList<Metadata> metadata;
+
   // Unicode auto-detection is enabled in QTextStream by default.
   QTextStream playlist_stream(device);
-  QString data = playlist_stream.readAll();
-  qLog(Debug) << "Detected codec" << playlist_stream.codec()->name();
-
-  // iTune playlists use \r newlines. These aren't handled by the Qt readLine
-  // methods.
-  QStringList lines = data.split(QRegExp("\n|\r|\r\n"));
-
-  for (int i = 0; i < lines.count(); i++) {
-    QString line = lines[i].trimmed();
-    if (i == 0 && line.startsWith("#EXTM3U")) {
-      // This is in extended M3U format.
-      type = EXTENDED;
-    } else if (line.startsWith('#')) {
-      // Extended info or comment.
-      if (type == EXTENDED && line.startsWith("#EXT")) {
-        if (!ParseMetadata(line, &current_metadata)) {
-          qLog(Warning) << "Failed to parse metadata: " << line;
+  bool first_line = true;
+
+  while (!playlist_stream.atEnd()) {
+    // iTune playlists use \r newlines. These aren't handled by the Qt readLine
+    // methods, so a whole playlist of them comes back as one line.
+    const QStringList lines = playlist_stream.readLine().split('\r');
+    if (first_line) {
+      qLog(Debug) << "Detected codec" << playlist_stream.codec()->name();
+    }
+
+    for (const QString& l : lines) {
+      const QString line = l.trimmed();
+      if (first_line && line.startsWith("#EXTM3U")) {
+        // This is in extended M3U format.
+        type = EXTENDED;
+      } else if (line.startsWith('#')) {
+        // Extended info or comment.
+        if (type == EXTENDED && line.startsWith("#EXT")) {
+          if (!ParseMetadata(line, &current_metadata)) {
+            qLog(Warning) << "Failed to parse metadata: " << line;
+          }
+        }
+      } else if (!line.isEmpty()) {
+        Song song;
+        LocateSong(line, 0, dir, &song);
+        songs << song;
+        metadata << current_metadata;
+
+        current_metadata = Metadata();
+
+        if (songs.count() >= kChunkSize) {
+          LoadChunk(&songs, &metadata, callback);
         }
       }
-    } else if (!line.isEmpty()) {
-      Song song = LoadSong(line, 0, dir);
-      if (!current_metadata.title.isEmpty()) {
-        song.set_title(current_metadata.title);
-      }
-      if (!current_metadata.artist.isEmpty()) {
-        song.set_artist(current_metadata.artist);
-      }
-      if (current_metadata.length > 0) {
-        song.set_length_nanosec(current_metadata.length);
-      }
-      ret << song;
+      first_line = false;
+    }
+  }
+
+  LoadChunk(&songs, &metadata, callback);
+}
 
-      current_metadata = Metadata();
+void M3UParser::LoadChunk(SongList* songs, QList<Metadata>* metadata,
+                          const ChunkCallback& callback) const {
+  if (songs->isEmpty()) return;
+
+  LoadSongs(songs);
+
+  for (int i = 0; i < songs->count(); ++i) {
+    Song& song = (*songs)[i];
+    const Metadata& song_metadata = metadata->at(i);
+    if (!song_metadata.title.isEmpty()) {
+      song.set_title(song_metadata.title);
+    }
+    if (!song_metadata.artist.isEmpty()) {
+      song.set_artist(song_metadata.artist);
+    }
+    if (song_metadata.length > 0) {
+      song.set_length_nanosec(song_metadata.length);
     }
   }
 
-  return ret;
+  callback(*songs);
+  songs->clear();
+  metadata->clear();
 }
 
 bool M3UParser::ParseMetadata(const QString& line,
@@ -102,7 +136,8 @@ bool M3UParser::ParseMetadata(const QString& line,
 }
 
 void M3UParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
-                     Playlist::Path path_type) const {
+                     Playlist::Path path_type,
+                     const ProgressCallback& progress) const {
   device->write("#EXTM3U\n");
 
   QSettings s;
@@ -110,7 +145,10 @@ void M3UParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
   bool writeMetadata = s.value(Playlist::kWriteMetadata, true).toBool();
   s.endGroup();
 
+  PathCache paths(dir, path_type);
+  int saved = 0;
   for (const Song& song : songs) {
+    ReportProgress(progress, saved++);
     if (song.url().isEmpty()) {
       continue;
     }
@@ -121,7 +159,7 @@ void M3UParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
                          .arg(song.title());
       device->write(meta.toUtf8());
     }
-    device->write(URLOrFilename(song.url(), dir, path_type).toUtf8());
+    device->write(paths.URLOrFilename(song.url()).toUtf8());
     device->write("\n");
   }
 }
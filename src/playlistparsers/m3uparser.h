@@ -40,8 +40,11 @@ class M3UParser : public ParserBase {
 
   SongList Load(QIODevice* device, const QString& playlist_path = "",
                 const QDir& dir = QDir()) const;
+  void LoadChunks(QIODevice* device, const QString& playlist_path,
+                  const QDir& dir, const ChunkCallback& callback) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
 
  private:
   enum M3UType {
@@ -58,6 +61,10 @@ class M3UParser : public ParserBase {
   };
 
   bool ParseMetadata(const QString& line, Metadata* metadata) const;
+  // Loads the located songs, applies the playlist's metadata to them and
+  // passes them to callback, then clears both lists.
+  void LoadChunk(SongList* songs, QList<Metadata>* metadata,
+                 const ChunkCallback& callback) const;
 
   FRIEND_TEST(M3UParserTest, ParsesMetadata);
   FRIEND_TEST(M3UParserTest, ParsesTrackLocation);
@@ -17,6 +17,10 @@
 
 #include "parserbase.h"
 
+#include <QBuffer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
 #include <QUrl>
 
 #include "core/tagreaderclient.h"
@@ -25,11 +29,50 @@
 #include "library/sqlrow.h"
 #include "playlist/playlist.h"
 
+const int ParserBase::kChunkSize = 500;
+
 ParserBase::ParserBase(LibraryBackendInterface* library, QObject* parent)
     : QObject(parent), library_(library) {}
 
-void ParserBase::LoadSong(const QString& filename_or_url, qint64 beginning,
-                          const QDir& dir, Song* song) const {
+void ParserBase::LoadChunks(QIODevice* device, const QString& playlist_path,
+                            const QDir& dir,
+                            const ChunkCallback& callback) const {
+  const SongList songs = Load(device, playlist_path, dir);
+  if (!songs.isEmpty()) callback(songs);
+}
+
+SongList ParserBase::LoadAllChunks(QIODevice* device,
+                                   const QString& playlist_path,
+                                   const QDir& dir) const {
+  SongList ret;
+  LoadChunks(device, playlist_path, dir,
+             [&ret](const SongList& songs) { ret << songs; });
+  return ret;
+}
+
+void ParserBase::LoadMappedFile(QFile* file, const QDir& dir,
+                                const ChunkCallback& callback) const {
+  const qint64 size = file->size();
+  uchar* data = size > 0 ? file->map(0, size) : nullptr;
+  if (!data) {
+    // Some files, like ones on network filesystems, can't be mapped.
+    file->seek(0);
+    LoadChunks(file, file->fileName(), dir, callback);
+    return;
+  }
+
+  QByteArray bytes =
+      QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::ReadOnly);
+  LoadChunks(&buffer, file->fileName(), dir, callback);
+  buffer.close();
+
+  file->unmap(data);
+}
+
+void ParserBase::LocateSong(const QString& filename_or_url, qint64 beginning,
+                            const QDir& dir, Song* song) const {
   if (filename_or_url.isEmpty()) {
     return;
   }
@@ -63,23 +106,70 @@ void ParserBase::LoadSong(const QString& filename_or_url, qint64 beginning,
     filename = QFileInfo(filename).canonicalFilePath();
   }
 
-  const QUrl url = QUrl::fromLocalFile(filename);
+  song->set_url(QUrl::fromLocalFile(filename));
+  song->set_beginning_nanosec(beginning);
+}
+
+void ParserBase::LoadSongs(SongList* songs) const {
+  // Located files are the songs that have a URL but aren't valid yet.
+  QList<int> pending;
+  QSet<QUrl> urls;
+  for (int i = 0; i < songs->count(); ++i) {
+    const Song& song = songs->at(i);
+    if (song.is_valid() || song.url().isEmpty()) continue;
+
+    pending << i;
+    urls << song.url();
+  }
+  if (pending.isEmpty()) return;
 
   // Search in the library
-  Song library_song;
+  QHash<QPair<QByteArray, qint64>, Song> library_songs;
   if (library_) {
-    library_song = library_->GetSongByUrl(url, beginning);
+    for (const Song& song : library_->GetSongsByUrls(urls.toList())) {
+      library_songs.insert(
+          qMakePair(song.url().toEncoded(), song.beginning_nanosec()), song);
+    }
   }
 
   // If it was found in the library then use it, otherwise load metadata from
-  // disk.
-  if (library_song.is_valid()) {
-    *song = library_song;
-  } else {
-    TagReaderClient::Instance()->ReadFileBlocking(filename, song);
+  // disk.  Sections of the same file only need it to be read once.
+  QMap<QString, QList<int>> misses;
+  for (int i : pending) {
+    Song* song = &(*songs)[i];
+    const Song library_song = library_songs.value(
+        qMakePair(song->url().toEncoded(), song->beginning_nanosec()));
+    if (library_song.is_valid()) {
+      *song = library_song;
+    } else {
+      misses[song->url().toLocalFile()] << i;
+    }
+  }
+  // Without a tag reader, like in the tests, they're left with just their
+  // location.
+  if (misses.isEmpty() || !TagReaderClient::Instance()) return;
+
+  const QStringList filenames = misses.keys();
+  const SongList file_songs =
+      TagReaderClient::Instance()->ReadFilesBlocking(
+          filenames, TagReaderClient::Priority_Playback);
+  for (int i = 0; i < filenames.count(); ++i) {
+    for (int index : misses[filenames[i]]) {
+      (*songs)[index] = file_songs[i];
+    }
   }
 }
 
+void ParserBase::LoadSong(const QString& filename_or_url, qint64 beginning,
+                          const QDir& dir, Song* song) const {
+  LocateSong(filename_or_url, beginning, dir, song);
+
+  SongList songs;
+  songs << *song;
+  LoadSongs(&songs);
+  *song = songs.first();
+}
+
 Song ParserBase::LoadSong(const QString& filename_or_url, qint64 beginning,
                           const QDir& dir) const {
   Song song;
@@ -89,15 +179,42 @@ Song ParserBase::LoadSong(const QString& filename_or_url, qint64 beginning,
 
 QString ParserBase::URLOrFilename(const QUrl& url, const QDir& dir,
                                   Playlist::Path path_type) const {
+  return PathCache(dir, path_type).URLOrFilename(url);
+}
+
+void ParserBase::ReportProgress(const ProgressCallback& progress, int saved) {
+  if (progress && saved % kChunkSize == 0) progress(saved);
+}
+
+ParserBase::PathCache::PathCache(const QDir& dir, Playlist::Path path_type)
+    : dir_(dir), path_type_(path_type) {}
+
+QString ParserBase::PathCache::URLOrFilename(const QUrl& url) {
   if (url.scheme() != "file") return url.toString();
 
   const QString filename = url.toLocalFile();
+  if (path_type_ == Playlist::Path_Absolute ||
+      !QDir::isAbsolutePath(filename)) {
+    return filename;
+  }
 
-  if (path_type != Playlist::Path_Absolute && QDir::isAbsolutePath(filename)) {
-    const QString relative = dir.relativeFilePath(filename);
-
-    if (!relative.startsWith("../") || path_type == Playlist::Path_Relative)
-      return relative;
+  const int slash = filename.lastIndexOf('/');
+  const QString directory = filename.left(qMax(1, slash));
+
+  QHash<QString, QString>::const_iterator it = prefixes_.constFind(directory);
+  if (it == prefixes_.constEnd()) {
+    QString prefix = dir_.relativeFilePath(directory);
+    if (prefix.isEmpty() || prefix == ".") {
+      prefix = "";
+    } else if (path_type_ != Playlist::Path_Relative &&
+               (prefix == ".." || prefix.startsWith("../"))) {
+      prefix = QString();
+    } else {
+      prefix += "/";
+    }
+    it = prefixes_.insert(directory, prefix);
   }
-  return filename;
+
+  if (it->isNull()) return filename;
+  return *it + filename.mid(slash + 1);
 }
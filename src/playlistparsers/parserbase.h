@@ -19,12 +19,15 @@
 #define PARSERBASE_H
 
 #include <QDir>
+#include <QHash>
 #include <QObject>
+#include <functional>
 
 #include "core/song.h"
 #include "playlist/playlist.h"
 
 class LibraryBackendInterface;
+class QFile;
 
 class ParserBase : public QObject {
   Q_OBJECT
@@ -32,6 +35,32 @@ class ParserBase : public QObject {
  public:
   ParserBase(LibraryBackendInterface* library, QObject* parent = nullptr);
 
+  // Called with each chunk of songs as a playlist is loaded.
+  typedef std::function<void(const SongList&)> ChunkCallback;
+  // How many entries streaming parsers read before loading them and passing
+  // them on.
+  static const int kChunkSize;
+  // Called every kChunkSize songs as a playlist is saved, with how many have
+  // been written so far.
+  typedef std::function<void(int)> ProgressCallback;
+
+  // Works out what URLOrFilename would for each song of a playlist that's
+  // being saved, but only finds the relative path of each directory once.
+  class PathCache {
+   public:
+    PathCache(const QDir& dir, Playlist::Path path_type);
+
+    QString URLOrFilename(const QUrl& url);
+
+   private:
+    QDir dir_;
+    Playlist::Path path_type_;
+    // What goes before the names of the files in each directory: a relative
+    // path ending in a slash, an empty string, or a null string if they're
+    // saved with their absolute paths.
+    QHash<QString, QString> prefixes_;
+  };
+
   virtual QString name() const = 0;
   virtual QStringList file_extensions() const = 0;
   virtual QString mime_type() const { return QString(); }
@@ -51,9 +80,22 @@ class ParserBase : public QObject {
   // from the parser's point of view).
   virtual SongList Load(QIODevice* device, const QString& playlist_path = "",
                         const QDir& dir = QDir()) const = 0;
+  // Like Load, but passes the songs to callback a chunk at a time as they're
+  // read, so the first ones can be used before the whole playlist has been
+  // parsed.  Parsers that can't read a playlist piece by piece pass all the
+  // songs in one chunk.
+  virtual void LoadChunks(QIODevice* device, const QString& playlist_path,
+                          const QDir& dir,
+                          const ChunkCallback& callback) const;
+  // Loads an opened playlist file with LoadChunks, parsing it straight from a
+  // memory mapping of the file rather than reading it into memory first.
+  void LoadMappedFile(QFile* file, const QDir& dir,
+                      const ChunkCallback& callback) const;
+
   virtual void Save(
       const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-      Playlist::Path path_type = Playlist::Path_Automatic) const = 0;
+      Playlist::Path path_type = Playlist::Path_Automatic,
+      const ProgressCallback& progress = ProgressCallback()) const = 0;
 
  signals:
   void Error(const QString& msg) const;
@@ -70,13 +112,34 @@ class ParserBase : public QObject {
   void LoadSong(const QString& filename_or_url, qint64 beginning,
                 const QDir& dir, Song* song) const;
 
+  // Loading each entry with LoadSong costs a library query, so parsers that
+  // read many entries load them in two steps instead: LocateSong sets the URL
+  // and beginning of each song without loading any metadata, then LoadSongs
+  // loads all of them at once.  Streams are complete after LocateSong.
+  void LocateSong(const QString& filename_or_url, qint64 beginning,
+                  const QDir& dir, Song* song) const;
+  // Replaces every located file in songs with its song from the Library,
+  // which is searched with one query, or else with its tags, which are read
+  // in parallel.
+  void LoadSongs(SongList* songs) const;
+
   // If the URL is a file:// URL then returns its path, absolute or relative to
   // the directory depending on the path_type option.
   // Otherwise returns the URL as is.
   // This function should always be used when saving a playlist.
+  // Parsers that save many songs should use a PathCache instead.
   QString URLOrFilename(const QUrl& url, const QDir& dir,
                         Playlist::Path path_type) const;
 
+  // For Save: calls progress if a whole chunk more songs have been saved.
+  static void ReportProgress(const ProgressCallback& progress, int saved);
+
+  LibraryBackendInterface* library() const { return library_; }
+
+  // For parsers that implement LoadChunks: collects all the chunks.
+  SongList LoadAllChunks(QIODevice* device, const QString& playlist_path,
+                         const QDir& dir) const;
+
  private:
   LibraryBackendInterface* library_;
 };
@@ -26,10 +26,12 @@
 #include "cueparser.h"
 #include "m3uparser.h"
 #include "plsparser.h"
+#include "snapshotparser.h"
 #include "wplparser.h"
 #include "xspfparser.h"
 
 const int PlaylistParser::kMagicSize = 512;
+const int PlaylistParser::kSniffSize = 12;
 
 PlaylistParser::PlaylistParser(LibraryBackendInterface* library,
                                QObject* parent)
@@ -42,6 +44,7 @@ PlaylistParser::PlaylistParser(LibraryBackendInterface* library,
   AddParser(new AsxIniParser(library, this));
   AddParser(new CueParser(library, this));
   AddParser(new WplParser(library, this));
+  AddParser(new SnapshotParser(library, this));
 }
 
 void PlaylistParser::AddParser(ParserBase* parser) {
@@ -118,8 +121,46 @@ ParserBase* PlaylistParser::ParserForMimeType(const QString& mime_type) const {
   return nullptr;
 }
 
+bool PlaylistParser::LooksLikeAudio(const QByteArray& data) {
+  if (data.size() < 4) return false;
+
+  static const char* kSignatures[] = {
+      "ID3",  "fLaC", "OggS", "MAC ", "wvpk", "MPCK", "MP+", "TTA1",
+      "\x1a\x45\xdf\xa3",  // Matroska
+      "\x30\x26\xb2\x75",  // ASF header GUID
+  };
+  for (const char* signature : kSignatures) {
+    if (data.startsWith(signature)) return true;
+  }
+
+  if (data.size() >= kSniffSize) {
+    const QByteArray type = data.mid(8, 4);
+    if (data.startsWith("RIFF") && type == "WAVE") return true;
+    if (data.startsWith("FORM") && (type == "AIFF" || type == "AIFC"))
+      return true;
+    if (data.mid(4, 4) == "ftyp") return true;
+  }
+
+  const uchar* d = reinterpret_cast<const uchar*>(data.constData());
+  if (d[0] != 0xff) return false;
+
+  // AAC in an ADTS stream.
+  if ((d[1] & 0xf6) == 0xf0) return true;
+
+  // A bare MPEG audio frame.  FF FE and FF FF look like frame syncs too, but
+  // are more likely to be the byte order mark of a UTF-16 text file.
+  if ((d[1] & 0xe0) != 0xe0 || d[1] == 0xfe || d[1] == 0xff) return false;
+  const int version = (d[1] >> 3) & 0x3;
+  const int layer = (d[1] >> 1) & 0x3;
+  const int bitrate = d[2] >> 4;
+  const int sample_rate = (d[2] >> 2) & 0x3;
+  return version != 1 && layer != 0 && bitrate != 0xf && sample_rate != 0x3;
+}
+
 ParserBase* PlaylistParser::ParserForMagic(const QByteArray& data,
                                            const QString& mime_type) const {
+  if (mime_type.isEmpty() && LooksLikeAudio(data)) return nullptr;
+
   for (ParserBase* p : parsers_) {
     if ((!mime_type.isEmpty() && mime_type == p->mime_type()) ||
         p->TryMagic(data))
@@ -129,6 +170,13 @@ ParserBase* PlaylistParser::ParserForMagic(const QByteArray& data,
 }
 
 SongList PlaylistParser::LoadFromFile(const QString& filename) const {
+  SongList ret;
+  LoadFromFile(filename, [&ret](const SongList& songs) { ret << songs; });
+  return ret;
+}
+
+void PlaylistParser::LoadFromFile(
+    const QString& filename, const ParserBase::ChunkCallback& callback) const {
   QFileInfo info(filename);
 
   // Find a parser that supports this file extension
@@ -136,14 +184,14 @@ SongList PlaylistParser::LoadFromFile(const QString& filename) const {
   if (!parser) {
     emit Error(tr("Unknown filetype: %1").arg(filename));
     qLog(Warning) << "Unknown filetype:" << filename;
-    return SongList();
+    return;
   }
 
   // Open the file
   QFile file(filename);
   file.open(QIODevice::ReadOnly);
 
-  return parser->Load(&file, filename, info.absolutePath());
+  parser->LoadMappedFile(&file, info.absolutePath(), callback);
 }
 
 SongList PlaylistParser::LoadFromDevice(QIODevice* device,
@@ -159,7 +207,8 @@ SongList PlaylistParser::LoadFromDevice(QIODevice* device,
 }
 
 void PlaylistParser::Save(const SongList& songs, const QString& filename,
-                          Playlist::Path path_type) const {
+                          Playlist::Path path_type,
+                          const ParserBase::ProgressCallback& progress) const {
   QFileInfo info(filename);
 
   // Find a parser that supports this file extension
@@ -174,5 +223,5 @@ void PlaylistParser::Save(const SongList& songs, const QString& filename,
   QFile file(filename);
   file.open(QIODevice::WriteOnly);
 
-  return parser->Save(songs, &file, info.absolutePath(), path_type);
+  return parser->Save(songs, &file, info.absolutePath(), path_type, progress);
 }
@@ -23,8 +23,8 @@
 
 #include "core/song.h"
 #include "playlist/playlist.h"
+#include "playlistparsers/parserbase.h"
 
-class ParserBase;
 class LibraryBackendInterface;
 
 class PlaylistParser : public QObject {
@@ -34,6 +34,13 @@ class PlaylistParser : public QObject {
   PlaylistParser(LibraryBackendInterface* library, QObject* parent = nullptr);
 
   static const int kMagicSize;
+  // How many bytes of a file LooksLikeAudio needs to see.
+  static const int kSniffSize;
+
+  // True if data starts with the signature of a common audio container, so
+  // the file can't be a playlist.  Only a few fixed bytes are looked at,
+  // which is much cheaper than trying every parser or running a typefind.
+  static bool LooksLikeAudio(const QByteArray& data);
 
   QStringList file_extensions() const;
   QString filters() const;
@@ -49,11 +56,16 @@ class PlaylistParser : public QObject {
   ParserBase* ParserForMimeType(const QString& mime) const;
 
   SongList LoadFromFile(const QString& filename) const;
+  // Passes the songs to callback a chunk at a time as the file is parsed.
+  void LoadFromFile(const QString& filename,
+                    const ParserBase::ChunkCallback& callback) const;
   SongList LoadFromDevice(QIODevice* device,
                           const QString& path_hint = QString(),
                           const QDir& dir_hint = QDir()) const;
-  void Save(const SongList& songs, const QString& filename,
-            Playlist::Path) const;
+  // Can be called from any thread.  Errors are emitted through Error.
+  void Save(const SongList& songs, const QString& filename, Playlist::Path,
+            const ParserBase::ProgressCallback& progress =
+                ParserBase::ProgressCallback()) const;
 
  signals:
   void Error(const QString& msg) const;
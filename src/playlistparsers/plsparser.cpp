@@ -28,7 +28,15 @@ PLSParser::PLSParser(LibraryBackendInterface* library, QObject* parent)
 
 SongList PLSParser::Load(QIODevice* device, const QString& playlist_path,
                          const QDir& dir) const {
+  return LoadAllChunks(device, playlist_path, dir);
+}
+
+void PLSParser::LoadChunks(QIODevice* device, const QString& playlist_path,
+                           const QDir& dir,
+                           const ChunkCallback& callback) const {
   QMap<int, Song> songs;
+  // The title and length each entry was given in the playlist.
+  QMap<int, Song> metadata;
   QRegExp n_re("\\d+$");
 
   while (!device->atEnd()) {
@@ -40,39 +48,73 @@ SongList PLSParser::Load(QIODevice* device, const QString& playlist_path,
     n_re.indexIn(key);
     int n = n_re.cap(0).toInt();
 
-    if (key.startsWith("file")) {
-      Song song = LoadSong(value, 0, dir);
+    if (!key.startsWith("file") && !key.startsWith("title") &&
+        !key.startsWith("length")) {
+      continue;
+    }
 
-      // Use the title and length we've already loaded if any
-      if (!songs[n].title().isEmpty()) song.set_title(songs[n].title());
-      if (songs[n].length_nanosec() != -1)
-        song.set_length_nanosec(songs[n].length_nanosec());
+    // Entries are numbered in order, so once a new one starts the ones before
+    // it are complete.
+    if (songs.count() >= kChunkSize && n > songs.lastKey()) {
+      LoadChunk(&songs, &metadata, callback);
+    }
 
+    if (key.startsWith("file")) {
+      Song song;
+      LocateSong(value, 0, dir, &song);
       songs[n] = song;
     } else if (key.startsWith("title")) {
-      songs[n].set_title(value);
-    } else if (key.startsWith("length")) {
+      if (!songs.contains(n)) songs[n] = Song();
+      metadata[n].set_title(value);
+    } else {
+      if (!songs.contains(n)) songs[n] = Song();
       qint64 seconds = value.toLongLong();
       if (seconds > 0) {
-        songs[n].set_length_nanosec(seconds * kNsecPerSec);
+        metadata[n].set_length_nanosec(seconds * kNsecPerSec);
       }
     }
   }
 
-  return songs.values();
+  LoadChunk(&songs, &metadata, callback);
+}
+
+void PLSParser::LoadChunk(QMap<int, Song>* songs, QMap<int, Song>* metadata,
+                          const ChunkCallback& callback) const {
+  if (songs->isEmpty()) return;
+
+  const QList<int> entries = songs->keys();
+  SongList ret = songs->values();
+  LoadSongs(&ret);
+
+  // Use the title and length from the playlist if any
+  for (int i = 0; i < ret.count(); ++i) {
+    const Song playlist_metadata = metadata->value(entries[i]);
+    if (!playlist_metadata.title().isEmpty()) {
+      ret[i].set_title(playlist_metadata.title());
+    }
+    if (playlist_metadata.length_nanosec() != -1) {
+      ret[i].set_length_nanosec(playlist_metadata.length_nanosec());
+    }
+  }
+  songs->clear();
+  metadata->clear();
+
+  callback(ret);
 }
 
 void PLSParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
-                     Playlist::Path path_type) const {
+                     Playlist::Path path_type,
+                     const ProgressCallback& progress) const {
   QTextStream s(device);
   s << "[playlist]" << endl;
   s << "Version=2" << endl;
   s << "NumberOfEntries=" << songs.count() << endl;
 
+  PathCache paths(dir, path_type);
   int n = 1;
   for (const Song& song : songs) {
-    s << "File" << n << "=" << URLOrFilename(song.url(), dir, path_type)
-      << endl;
+    ReportProgress(progress, n - 1);
+    s << "File" << n << "=" << paths.URLOrFilename(song.url()) << endl;
     s << "Title" << n << "=" << song.title() << endl;
     s << "Length" << n << "=" << song.length_nanosec() / kNsecPerSec << endl;
     ++n;
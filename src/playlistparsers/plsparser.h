@@ -18,6 +18,8 @@
 #ifndef PLSPARSER_H
 #define PLSPARSER_H
 
+#include <QMap>
+
 #include "parserbase.h"
 
 class PLSParser : public ParserBase {
@@ -34,8 +36,17 @@ class PLSParser : public ParserBase {
 
   SongList Load(QIODevice* device, const QString& playlist_path = "",
                 const QDir& dir = QDir()) const;
+  void LoadChunks(QIODevice* device, const QString& playlist_path,
+                  const QDir& dir, const ChunkCallback& callback) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
+
+ private:
+  // Loads the entries read so far, applies the playlist's titles and lengths
+  // to them and passes them to callback, then clears both maps.
+  void LoadChunk(QMap<int, Song>* songs, QMap<int, Song>* metadata,
+                 const ChunkCallback& callback) const;
 };
 
 #endif  // PLSPARSER_H
@@ -0,0 +1,156 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snapshotparser.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QHash>
+#include <algorithm>
+
+#include "core/logging.h"
+#include "library/librarybackend.h"
+
+const char* SnapshotParser::kMagic = "CLEMENTINE-SNAPSHOT\n";
+const quint32 SnapshotParser::kFormatVersion = 1;
+
+SnapshotParser::SnapshotParser(LibraryBackendInterface* library,
+                               QObject* parent)
+    : ParserBase(library, parent) {}
+
+bool SnapshotParser::TryMagic(const QByteArray& data) const {
+  return data.startsWith(kMagic);
+}
+
+QByteArray SnapshotParser::LibraryFingerprint() const {
+  if (!library()) return QByteArray();
+
+  QStringList directories;
+  for (const Directory& dir : library()->GetAllDirectories()) {
+    directories << QString::number(dir.id) + ":" + dir.path;
+  }
+  if (directories.isEmpty()) return QByteArray();
+
+  std::sort(directories.begin(), directories.end());
+  return QCryptographicHash::hash(directories.join("\n").toUtf8(),
+                                  QCryptographicHash::Sha1);
+}
+
+SongList SnapshotParser::Load(QIODevice* device, const QString& playlist_path,
+                              const QDir& dir) const {
+  const QByteArray magic(kMagic);
+  if (device->read(magic.size()) != magic) return SongList();
+
+  QDataStream s(device);
+  s.setVersion(QDataStream::Qt_5_6);
+
+  quint32 version = 0;
+  QByteArray fingerprint;
+  quint32 count = 0;
+  s >> version >> fingerprint >> count;
+  if (version != kFormatVersion) {
+    qLog(Warning) << "Unsupported snapshot version" << version;
+    return SongList();
+  }
+
+  QList<Entry> entries;
+  for (quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+    Entry entry;
+    s >> entry.id_ >> entry.location_ >> entry.beginning_ >> entry.end_ >>
+        entry.cue_path_ >> entry.title_ >> entry.artist_ >> entry.album_;
+    entries << entry;
+  }
+  if (s.status() != QDataStream::Ok) {
+    qLog(Warning) << "Truncated snapshot" << playlist_path;
+    return SongList();
+  }
+
+  // Ids only mean anything in the library they came from.
+  QHash<int, Song> library_songs;
+  if (!fingerprint.isEmpty() && fingerprint == LibraryFingerprint()) {
+    QList<int> ids;
+    for (const Entry& entry : entries) {
+      if (entry.id_ != -1) ids << entry.id_;
+    }
+    if (!ids.isEmpty()) {
+      for (const Song& song : library()->GetSongsById(ids)) {
+        library_songs[song.id()] = song;
+      }
+    }
+  }
+
+  SongList songs;
+  QList<int> located;
+  for (const Entry& entry : entries) {
+    Song song;
+    LocateSong(entry.location_, entry.beginning_, dir, &song);
+
+    // The song with this id might have been replaced since, so only use it if
+    // it's still the same file and section.
+    const Song library_song = library_songs.value(entry.id_);
+    if (library_song.is_valid() && library_song.url() == song.url() &&
+        library_song.beginning_nanosec() == entry.beginning_) {
+      song = library_song;
+    } else {
+      located << songs.count();
+    }
+    songs << song;
+  }
+
+  // Everything else is found the slow way.
+  LoadSongs(&songs);
+
+  for (int i : located) {
+    const Entry& entry = entries[i];
+    Song& song = songs[i];
+    if (!song.is_stream() && entry.cue_path_.isEmpty()) continue;
+
+    // Sections of a cue sheet and streams don't have tags of their own.
+    song.set_beginning_nanosec(entry.beginning_);
+    song.set_end_nanosec(entry.end_);
+    song.set_cue_path(entry.cue_path_);
+    if (!entry.title_.isEmpty()) song.set_title(entry.title_);
+    if (!entry.artist_.isEmpty()) song.set_artist(entry.artist_);
+    if (!entry.album_.isEmpty()) song.set_album(entry.album_);
+  }
+
+  // Files that have gone since the snapshot was saved.
+  songs.erase(std::remove_if(songs.begin(), songs.end(),
+                             [](const Song& song) { return !song.is_valid(); }),
+              songs.end());
+
+  return songs;
+}
+
+void SnapshotParser::Save(const SongList& songs, QIODevice* device,
+                          const QDir& dir, Playlist::Path path_type,
+                          const ProgressCallback& progress) const {
+  device->write(kMagic);
+
+  QDataStream s(device);
+  s.setVersion(QDataStream::Qt_5_6);
+  s << kFormatVersion << LibraryFingerprint() << quint32(songs.count());
+
+  PathCache paths(dir, path_type);
+  int saved = 0;
+  for (const Song& song : songs) {
+    ReportProgress(progress, saved++);
+    s << song.id() << paths.URLOrFilename(song.url())
+      << song.beginning_nanosec() << song.end_nanosec() << song.cue_path()
+      << song.title() << song.artist() << song.album();
+  }
+}
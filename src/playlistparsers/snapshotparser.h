@@ -0,0 +1,65 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLISTPARSERS_SNAPSHOTPARSER_H_
+#define PLAYLISTPARSERS_SNAPSHOTPARSER_H_
+
+#include "parserbase.h"
+
+// Clementine's own binary playlist format.  Along with each song's location
+// it keeps the song's library id and a fingerprint of the library it was saved
+// from, so loading it into the same library, or a copy of it, only takes one
+// query by id instead of a lookup or tag read per song.
+class SnapshotParser : public ParserBase {
+  Q_OBJECT
+
+ public:
+  SnapshotParser(LibraryBackendInterface* library, QObject* parent = nullptr);
+
+  static const char* kMagic;
+  static const quint32 kFormatVersion;
+
+  QString name() const { return "Clementine snapshot"; }
+  QStringList file_extensions() const { return QStringList() << "clsnap"; }
+  QString mime_type() const { return "application/x-clementine-snapshot"; }
+
+  bool TryMagic(const QByteArray& data) const;
+
+  SongList Load(QIODevice* device, const QString& playlist_path = "",
+                const QDir& dir = QDir()) const;
+  void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
+
+  // Identifies the library by its directories, so ids saved from it can be
+  // trusted when loading into a library with the same fingerprint.
+  QByteArray LibraryFingerprint() const;
+
+ private:
+  struct Entry {
+    int id_;
+    QString location_;
+    qint64 beginning_;
+    qint64 end_;
+    QString cue_path_;
+    QString title_;
+    QString artist_;
+    QString album_;
+  };
+};
+
+#endif  // PLAYLISTPARSERS_SNAPSHOTPARSER_H_
@@ -31,22 +31,43 @@ bool WplParser::TryMagic(const QByteArray& data) const {
 
 SongList WplParser::Load(QIODevice* device, const QString& playlist_path,
                          const QDir& dir) const {
-  SongList ret;
+  return LoadAllChunks(device, playlist_path, dir);
+}
 
+void WplParser::LoadChunks(QIODevice* device, const QString& playlist_path,
+                           const QDir& dir,
+                           const ChunkCallback& callback) const {
   QXmlStreamReader reader(device);
   if (!Utilities::ParseUntilElement(&reader, "smil") ||
       !Utilities::ParseUntilElement(&reader, "body")) {
-    return ret;
+    return;
   }
 
+  SongList songs;
   while (!reader.atEnd() && Utilities::ParseUntilElement(&reader, "seq")) {
-    ParseSeq(dir, &reader, &ret);
+    ParseSeq(dir, &reader, &songs, callback);
+  }
+  LoadChunk(&songs, callback);
+}
+
+void WplParser::LoadChunk(SongList* songs,
+                          const ChunkCallback& callback) const {
+  LoadSongs(songs);
+
+  SongList ret;
+  for (const Song& song : *songs) {
+    if (song.is_valid()) {
+      ret << song;
+    }
   }
-  return ret;
+  songs->clear();
+
+  if (!ret.isEmpty()) callback(ret);
 }
 
 void WplParser::ParseSeq(const QDir& dir, QXmlStreamReader* reader,
-                         SongList* songs) const {
+                         SongList* songs,
+                         const ChunkCallback& callback) const {
   while (!reader->atEnd()) {
     QXmlStreamReader::TokenType type = reader->readNext();
     switch (type) {
@@ -55,9 +76,12 @@ void WplParser::ParseSeq(const QDir& dir, QXmlStreamReader* reader,
         if (name == "media") {
           QStringRef src = reader->attributes().value("src");
           if (!src.isEmpty()) {
-            Song song = LoadSong(src.toString(), 0, dir);
-            if (song.is_valid()) {
-              songs->append(song);
+            Song song;
+            LocateSong(src.toString(), 0, dir, &song);
+            songs->append(song);
+
+            if (songs->count() >= kChunkSize) {
+              LoadChunk(songs, callback);
             }
           }
         } else {
@@ -78,7 +102,8 @@ void WplParser::ParseSeq(const QDir& dir, QXmlStreamReader* reader,
 }
 
 void WplParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
-                     Playlist::Path path_type) const {
+                     Playlist::Path path_type,
+                     const ProgressCallback& progress) const {
   QXmlStreamWriter writer(device);
   writer.setAutoFormatting(true);
   writer.setAutoFormattingIndent(2);
@@ -97,9 +122,12 @@ void WplParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
     StreamElement body("body", &writer);
     {
       StreamElement seq("seq", &writer);
+      PathCache paths(dir, path_type);
+      int saved = 0;
       for (const Song& song : songs) {
+        ReportProgress(progress, saved++);
         writer.writeStartElement("media");
-        writer.writeAttribute("src", URLOrFilename(song.url(), dir, path_type));
+        writer.writeAttribute("src", paths.URLOrFilename(song.url()));
         writer.writeEndElement();
       }
     }
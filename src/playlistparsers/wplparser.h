@@ -32,12 +32,19 @@ class WplParser : public XMLParser {
 
   SongList Load(QIODevice* device, const QString& playlist_path,
                 const QDir& dir) const;
+  void LoadChunks(QIODevice* device, const QString& playlist_path,
+                  const QDir& dir, const ChunkCallback& callback) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir,
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
 
  private:
-  void ParseSeq(const QDir& dir, QXmlStreamReader* reader,
-                SongList* songs) const;
+  // Locates the songs in a seq, passing them on a chunk at a time.
+  void ParseSeq(const QDir& dir, QXmlStreamReader* reader, SongList* songs,
+                const ChunkCallback& callback) const;
+  // Loads the located songs and passes the valid ones to callback, then
+  // clears the list.
+  void LoadChunk(SongList* songs, const ChunkCallback& callback) const;
   void WriteMeta(const QString& name, const QString& content,
                  QXmlStreamWriter* writer) const;
 };
@@ -33,24 +33,61 @@ XSPFParser::XSPFParser(LibraryBackendInterface* library, QObject* parent)
 
 SongList XSPFParser::Load(QIODevice* device, const QString& playlist_path,
                           const QDir& dir) const {
-  SongList ret;
+  return LoadAllChunks(device, playlist_path, dir);
+}
 
+void XSPFParser::LoadChunks(QIODevice* device, const QString& playlist_path,
+                            const QDir& dir,
+                            const ChunkCallback& callback) const {
   QXmlStreamReader reader(device);
   if (!Utilities::ParseUntilElement(&reader, "playlist") ||
       !Utilities::ParseUntilElement(&reader, "trackList")) {
-    return ret;
+    return;
   }
 
+  SongList songs;
+  SongList metadata;
   while (!reader.atEnd() && Utilities::ParseUntilElement(&reader, "track")) {
-    Song song = ParseTrack(&reader, dir);
+    Song song;
+    metadata << ParseTrack(&reader, dir, &song);
+    songs << song;
+
+    if (songs.count() >= kChunkSize) {
+      LoadChunk(&songs, &metadata, callback);
+    }
+  }
+  LoadChunk(&songs, &metadata, callback);
+}
+
+void XSPFParser::LoadChunk(SongList* songs, SongList* metadata,
+                           const ChunkCallback& callback) const {
+  LoadSongs(songs);
+
+  SongList ret;
+  for (int i = 0; i < songs->count(); ++i) {
+    Song& song = (*songs)[i];
+    const Song& playlist_metadata = metadata->at(i);
+
+    // Override metadata with what was in the playlist
+    song.set_title(playlist_metadata.title());
+    song.set_artist(playlist_metadata.artist());
+    song.set_album(playlist_metadata.album());
+    song.set_art_manual(playlist_metadata.art_manual());
+    song.set_length_nanosec(playlist_metadata.length_nanosec());
+    song.set_track(playlist_metadata.track());
+
     if (song.is_valid()) {
       ret << song;
     }
   }
-  return ret;
+  songs->clear();
+  metadata->clear();
+
+  if (!ret.isEmpty()) callback(ret);
 }
 
-Song XSPFParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir) const {
+Song XSPFParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir,
+                            Song* song) const {
   QString art, title, artist, album, location;
   qint64 nanosec = -1;
   int track_num = -1;
@@ -100,20 +137,21 @@ Song XSPFParser::ParseTrack(QXmlStreamReader* reader, const QDir& dir) const {
   }
 
 return_song:
-  Song song = LoadSong(location, 0, dir);
-
-  // Override metadata with what was in the playlist
-  song.set_title(title);
-  song.set_artist(artist);
-  song.set_album(album);
-  song.set_art_manual(art);
-  song.set_length_nanosec(nanosec);
-  song.set_track(track_num);
-  return song;
+  LocateSong(location, 0, dir, song);
+
+  Song metadata;
+  metadata.set_title(title);
+  metadata.set_artist(artist);
+  metadata.set_album(album);
+  metadata.set_art_manual(art);
+  metadata.set_length_nanosec(nanosec);
+  metadata.set_track(track_num);
+  return metadata;
 }
 
 void XSPFParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
-                      Playlist::Path path_type) const {
+                      Playlist::Path path_type,
+                      const ProgressCallback& progress) const {
   QFileInfo file;
   QXmlStreamWriter writer(device);
   writer.setAutoFormatting(true);
@@ -128,9 +166,12 @@ void XSPFParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
   bool writeMetadata = s.value(Playlist::kWriteMetadata, true).toBool();
   s.endGroup();
 
+  PathCache paths(dir, path_type);
+  int saved = 0;
   StreamElement tracklist("trackList", &writer);
   for (const Song& song : songs) {
-    QString filename_or_url = URLOrFilename(song.url(), dir, path_type);
+    ReportProgress(progress, saved++);
+    QString filename_or_url = paths.URLOrFilename(song.url());
 
     StreamElement track("track", &writer);
     writer.writeTextElement("location", filename_or_url);
@@ -167,7 +208,7 @@ void XSPFParser::Save(const SongList& songs, QIODevice* device, const QDir& dir,
           // playlist.
           QUrl url = QUrl(art_filename);
           url.setScheme("file");  // Need to explicitly set this.
-          art_filename = URLOrFilename(url, dir, path_type).toUtf8();
+          art_filename = paths.URLOrFilename(url);
         } else {
           // Just use whatever URL was in the Song.
           art_filename = art;
@@ -38,11 +38,21 @@ class XSPFParser : public XMLParser {
 
   SongList Load(QIODevice* device, const QString& playlist_path = "",
                 const QDir& dir = QDir()) const;
+  void LoadChunks(QIODevice* device, const QString& playlist_path,
+                  const QDir& dir, const ChunkCallback& callback) const;
   void Save(const SongList& songs, QIODevice* device, const QDir& dir = QDir(),
-            Playlist::Path path_type = Playlist::Path_Automatic) const;
+            Playlist::Path path_type = Playlist::Path_Automatic,
+            const ProgressCallback& progress = ProgressCallback()) const;
 
  private:
-  Song ParseTrack(QXmlStreamReader* reader, const QDir& dir) const;
+  // Loads the located songs, applies the playlist's metadata to them and
+  // passes the valid ones to callback, then clears both lists.
+  void LoadChunk(SongList* songs, SongList* metadata,
+                 const ChunkCallback& callback) const;
+  // Locates the track's song and returns the metadata the playlist gives for
+  // it.
+  Song ParseTrack(QXmlStreamReader* reader, const QDir& dir,
+                  Song* song) const;
 };
 
 #endif
@@ -224,6 +224,7 @@ void RipCDDialog::ClickedRipButton() {
   });
 
   ui_->progress_bar->setRange(0, 100);
+  ui_->progress_speed->clear();
   transcoding_progress_timer_connection_ =
       connect(&transcoding_progress_timer_, &QTimer::timeout, this,
               [this, ripper]() { this->TranscodingProgressTimeout(ripper); });
@@ -536,5 +537,14 @@ void RipCDDialog::TranscodingProgressTimeout(Ripper* ripper) {
     int progress =
         qBound(0, static_cast<int>(ripper->GetProgress() * 100.0f), 100);
     ui_->progress_bar->setValue(progress);
+
+    QStringList speeds;
+    if (ripper->ReadSpeed() > 0) {
+      speeds << tr("Reading at %1x").arg(ripper->ReadSpeed(), 0, 'f', 1);
+    }
+    if (ripper->EncodeSpeed() > 0) {
+      speeds << tr("encoding at %1x").arg(ripper->EncodeSpeed(), 0, 'f', 1);
+    }
+    ui_->progress_speed->setText(speeds.join(", "));
   }
 }
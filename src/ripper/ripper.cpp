@@ -37,23 +37,38 @@
 Ripper::Ripper(int track_count, QObject* parent)
     : QObject(parent),
       track_count_(track_count),
-      transcoder_(new Transcoder(this)),
+      rip_transcoder_(new Transcoder(this)),
+      encode_transcoder_(new Transcoder(this)),
+      rip_preset_(Transcoder::PresetForFileType(Song::Type_Wav)),
       cancel_requested_(false),
+      finished_ripping_(0),
       finished_success_(0),
       finished_failed_(0),
       files_tagged_(0) {
   Q_ASSERT(track_count >= 0);
 
-  transcoder_->set_max_threads(1);  // we want transcoder to read only one song
-                                    // at once from disc to prevent seeking
-  connect(transcoder_, SIGNAL(JobComplete(QUrl, QString, bool)),
-          SLOT(TranscodingJobComplete(QUrl, QString, bool)));
-  connect(transcoder_, SIGNAL(AllJobsComplete()),
-          SLOT(AllTranscodingJobsComplete()));
-  connect(transcoder_, SIGNAL(LogLine(QString)), SLOT(LogLine(QString)));
+  rip_transcoder_->set_max_threads(1);  // we want transcoder to read only one
+                                        // song at once from disc to prevent
+                                        // seeking
+  connect(rip_transcoder_, SIGNAL(JobComplete(QUrl, QString, bool)),
+          SLOT(RipJobComplete(QUrl, QString, bool)));
+  connect(rip_transcoder_, SIGNAL(AllJobsComplete()),
+          SIGNAL(RippingComplete()));
+  connect(rip_transcoder_, SIGNAL(LogLine(QString)), SLOT(LogLine(QString)));
+
+  connect(encode_transcoder_, SIGNAL(JobComplete(QUrl, QString, bool)),
+          SLOT(EncodeJobComplete(QUrl, QString, bool)));
+  connect(encode_transcoder_, SIGNAL(LogLine(QString)),
+          SLOT(LogLine(QString)));
 }
 
-Ripper::~Ripper() {}
+Ripper::~Ripper() {
+  for (const TrackInformation& track : tracks_) {
+    if (!track.temporary_filename.isEmpty()) {
+      QFile::remove(track.temporary_filename);
+    }
+  }
+}
 
 void Ripper::AddTrack(int track_number, const QString& title,
                       const QString& transcoded_filename,
@@ -99,32 +114,69 @@ void Ripper::Cancel() {
     QMutexLocker l(&mutex_);
     cancel_requested_ = true;
   }
-  transcoder_->Cancel();
+  rip_transcoder_->Cancel();
+  encode_transcoder_->Cancel();
   emit(Cancelled());
 }
 
-void Ripper::TranscodingJobComplete(const QUrl& input, const QString& output,
-                                    bool success) {
-  if (success)
-    finished_success_++;
-  else
-    finished_failed_++;
+void Ripper::RipJobComplete(const QUrl& input, const QString& output,
+                            bool success) {
+  finished_ripping_++;
+
+  for (QList<TrackInformation>::iterator it = tracks_.begin();
+       it != tracks_.end(); ++it) {
+    QUrl track_url =
+        CddaDevice::TrackStrToUrl(QString("cdda://%1").arg(it->track_number));
+    if (track_url != input) continue;
+
+    if (!success) {
+      QFile::remove(it->temporary_filename);
+      it->temporary_filename.clear();
+      TrackFinished(false);
+    } else if (it->temporary_filename.isEmpty()) {
+      // WAV tracks are read straight to where they're going.
+      it->transcoded_filename = output;
+      TrackFinished(true);
+    } else {
+      // The drive carries on with the next track while this one's encoded.
+      encode_transcoder_->AddJob(QUrl::fromLocalFile(it->temporary_filename),
+                                 it->preset, it->transcoded_filename,
+                                 it->overwrite_existing);
+      encode_transcoder_->Start();
+    }
+    break;
+  }
+}
 
+void Ripper::EncodeJobComplete(const QUrl& input, const QString& output,
+                               bool success) {
   // The transcoder does not necessarily overwrite files. If not, it changes
   // the name of the output file. We need to update the transcoded
   // filename for the corresponding track so that we tag the correct
   // file later on.
   for (QList<TrackInformation>::iterator it = tracks_.begin();
        it != tracks_.end(); ++it) {
-    QUrl track_url =
-        CddaDevice::TrackStrToUrl(QString("cdda://%1").arg(it->track_number));
-    if (track_url == input) {
-      it->transcoded_filename = output;
+    if (it->temporary_filename.isEmpty() ||
+        QUrl::fromLocalFile(it->temporary_filename) != input) {
+      continue;
     }
+
+    QFile::remove(it->temporary_filename);
+    it->temporary_filename.clear();
+    it->transcoded_filename = output;
+    TrackFinished(success);
+    break;
   }
 }
 
-void Ripper::AllTranscodingJobsComplete() { TagFiles(); }
+void Ripper::TrackFinished(bool success) {
+  if (success)
+    finished_success_++;
+  else
+    finished_failed_++;
+
+  if (finished_success_ + finished_failed_ == tracks_.length()) TagFiles();
+}
 
 void Ripper::LogLine(const QString& message) { qLog(Debug) << message; }
 
@@ -134,6 +186,7 @@ void Ripper::Rip() {
     return;
   }
 
+  finished_ripping_ = 0;
   finished_success_ = 0;
   finished_failed_ = 0;
 
@@ -141,26 +194,46 @@ void Ripper::Rip() {
        it != tracks_.end(); ++it) {
     QUrl track_url =
         CddaDevice::TrackStrToUrl(QString("cdda://%1").arg(it->track_number));
-    transcoder_->AddJob(track_url, it->preset, it->transcoded_filename);
+    if (it->preset.type_ == Song::Type_Wav) {
+      rip_transcoder_->AddJob(track_url, it->preset, it->transcoded_filename,
+                              it->overwrite_existing);
+    } else {
+      it->temporary_filename = Utilities::GetTemporaryFileName();
+      rip_transcoder_->AddJob(track_url, rip_preset_, it->temporary_filename,
+                              true);
+    }
   }
-  transcoder_->Start();
-  emit RippingComplete();
+  rip_transcoder_->Start();
 }
 
 float Ripper::GetProgress() const {
   int added_tracks = AddedTracks();
   if (added_tracks == 0) return 1.0f;
 
-  float progress = finished_success_ + finished_failed_;
-  QList<float> current_job_progress_ = transcoder_->GetProgress().values();
+  // Reading and encoding count for half each.
+  float progress = finished_ripping_ + finished_success_ + finished_failed_;
+  QList<float> current_job_progress_ = rip_transcoder_->GetProgress().values();
+  current_job_progress_ << encode_transcoder_->GetProgress().values();
   progress += std::accumulate(current_job_progress_.begin(),
                               current_job_progress_.end(), 0.0f);
-  progress /= added_tracks;
+  progress /= added_tracks * 2;
 
   qLog(Debug) << "Progress: " << progress;
   return progress;
 }
 
+double Ripper::ReadSpeed() const {
+  double ret = 0.0;
+  for (double speed : rip_transcoder_->Throughput()) ret = qMax(ret, speed);
+  return ret;
+}
+
+double Ripper::EncodeSpeed() const {
+  double ret = 0.0;
+  for (double speed : encode_transcoder_->Throughput()) ret = qMax(ret, speed);
+  return ret;
+}
+
 void Ripper::TagFiles() {
   files_tagged_ = 0;
   for (const TrackInformation& track : tracks_) {
@@ -33,6 +33,10 @@ class QFile;
 // Rips selected tracks from an audio CD, transcodes them to a chosen
 // format, and finally tags the files with the supplied metadata.
 //
+// Tracks are read from the disc one at a time, as fast as the drive goes, to
+// temporary WAV files.  Each one is encoded as soon as it's been read, on as
+// many threads as there are cores, while the next tracks are being read.
+//
 // Usage: Add tracks with AddTrack() and album metadata with
 // SetAlbumInformation(). Then start the ripper with Start(). The ripper
 // emits the Finished() signal when it's done or the Cancelled()
@@ -64,14 +68,18 @@ class Ripper : public QObject {
   // Returns the current progress of the ripping process for all tracks as a
   // floating point number between 0 and 1.
   float GetProgress() const;
+  // Seconds of audio read from the disc, and encoded, per second so far.  0
+  // until the first track is through that stage.
+  double ReadSpeed() const;
+  double EncodeSpeed() const;
 
  signals:
   // Emitted when the full process, i.e., ripping, transcoding and tagging, is
   // completed or has failed.
   void Finished();
   void Cancelled();
-  // Emitted when ripping and transcoding files is completed, but files still
-  // need to be tagged.
+  // Emitted when all the tracks have been read from the disc, they might
+  // still be being encoded and tagged.
   void RippingComplete();
 
  public slots:
@@ -79,9 +87,9 @@ class Ripper : public QObject {
   void Cancel();
 
  private slots:
-  void TranscodingJobComplete(const QUrl& input, const QString& output,
-                              bool success);
-  void AllTranscodingJobsComplete();
+  void RipJobComplete(const QUrl& input, const QString& output, bool success);
+  void EncodeJobComplete(const QUrl& input, const QString& output,
+                         bool success);
   void LogLine(const QString& message);
   void FileTagged(TagReaderReply* reply);
 
@@ -101,6 +109,8 @@ class Ripper : public QObject {
     QString transcoded_filename;
     TranscoderPreset preset;
     bool overwrite_existing;
+    // The WAV the track is read to, before it's encoded.
+    QString temporary_filename;
   };
 
   struct AlbumInformation {
@@ -117,12 +127,17 @@ class Ripper : public QObject {
   void Rip();
   void SetupProgressInterval();
   void UpdateProgress();
+  void TrackFinished(bool success);
   void TagFiles();
 
   int track_count_;
-  Transcoder* transcoder_;
+  // Reads one track at a time, so the drive doesn't have to seek.
+  Transcoder* rip_transcoder_;
+  Transcoder* encode_transcoder_;
+  TranscoderPreset rip_preset_;
   bool cancel_requested_;
   QMutex mutex_;
+  int finished_ripping_;
   int finished_success_;
   int finished_failed_;
   int files_tagged_;
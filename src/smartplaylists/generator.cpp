@@ -23,6 +23,7 @@
 #include "internet/jamendo/jamendodynamicplaylist.h"
 #include "internet/subsonic/subsonicdynamicplaylist.h"
 #include "querygenerator.h"
+#include "similargenerator.h"
 
 namespace smart_playlists {
 
@@ -39,6 +40,8 @@ GeneratorPtr Generator::Create(const QString& type) {
     return GeneratorPtr(new JamendoDynamicPlaylist);
   else if (type == "Subsonic") {
     return GeneratorPtr(new SubsonicDynamicPlaylist);
+  } else if (type == "Similar") {
+    return GeneratorPtr(new SimilarGenerator);
   }
 
   qLog(Warning) << "Invalid playlist generator type:" << type;
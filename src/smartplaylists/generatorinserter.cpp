@@ -17,9 +17,8 @@
 
 #include "smartplaylists/generatorinserter.h"
 
-#include <QtConcurrentRun>
-
 #include "core/closure.h"
+#include "core/executor.h"
 #include "core/taskmanager.h"
 #include "playlist/playlist.h"
 #include "smartplaylists/generator.h"
@@ -57,7 +56,9 @@ void GeneratorInserter::Load(Playlist* destination, int row, bool play_now,
   connect(generator.get(), SIGNAL(Error(QString)), SIGNAL(Error(QString)));
 
   QFuture<PlaylistItemList> future =
-      QtConcurrent::run(Generate, generator, dynamic_count);
+      Executor::Db()->Run<PlaylistItemList>([generator, dynamic_count]() {
+        return Generate(generator, dynamic_count);
+      });
   NewClosure(future, this, SLOT(Finished(QFuture<PlaylistItemList>)), future);
 }
 
@@ -19,15 +19,29 @@
 
 #include <QtDebug>
 
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+#include <QRandomGenerator>
+#endif
+
 #include "library/librarybackend.h"
 
 namespace smart_playlists {
 
-QueryGenerator::QueryGenerator() : dynamic_(false), current_pos_(0) {}
+const int QueryGenerator::kCandidatesMaxAgeSecs = 60 * 60;
+
+QueryGenerator::QueryGenerator()
+    : dynamic_(false),
+      current_pos_(0),
+      candidates_loaded_(false),
+      connected_to_library_(false) {}
 
 QueryGenerator::QueryGenerator(const QString& name, const Search& search,
                                bool dynamic)
-    : search_(search), dynamic_(dynamic), current_pos_(0) {
+    : search_(search),
+      dynamic_(dynamic),
+      current_pos_(0),
+      candidates_loaded_(false),
+      connected_to_library_(false) {
   set_name(name);
 }
 
@@ -35,12 +49,14 @@ void QueryGenerator::Load(const Search& search) {
   search_ = search;
   dynamic_ = false;
   current_pos_ = 0;
+  ForgetCandidates();
 }
 
 void QueryGenerator::Load(const QByteArray& data) {
   QDataStream s(data);
   s >> search_;
   s >> dynamic_;
+  ForgetCandidates();
 }
 
 QByteArray QueryGenerator::Save() const {
@@ -59,6 +75,10 @@ PlaylistItemList QueryGenerator::Generate() {
 }
 
 PlaylistItemList QueryGenerator::GenerateMore(int count) {
+  if (uses_candidates()) {
+    return GenerateMoreFromCandidates(count);
+  }
+
   Search search_copy = search_;
   search_copy.id_not_in_ = previous_ids_;
   if (count) {
@@ -70,7 +90,10 @@ PlaylistItemList QueryGenerator::GenerateMore(int count) {
     current_pos_ += search_copy.limit_;
   }
 
-  SongList songs = backend_->FindSongs(search_copy);
+  return ItemsFromSongs(backend_->FindSongs(search_copy));
+}
+
+PlaylistItemList QueryGenerator::ItemsFromSongs(const SongList& songs) {
   PlaylistItemList items;
   for (const Song& song : songs) {
     items << PlaylistItemPtr(
@@ -83,4 +106,147 @@ PlaylistItemList QueryGenerator::GenerateMore(int count) {
   return items;
 }
 
+PlaylistItemList QueryGenerator::GenerateMoreFromCandidates(int count) {
+  UpdateCandidates();
+
+  const int wanted = count ? count : search_.limit_;
+  const QSet<int> recent = previous_ids_.toSet();
+  QList<int> picks;
+
+  {
+    QMutexLocker l(&candidates_mutex_);
+
+    int available = candidates_.count();
+    for (int id : recent) {
+      if (candidate_positions_.contains(id)) --available;
+    }
+
+    // Most candidates aren't recent, so this picks each one in a couple of
+    // tries.
+    QSet<int> picked;
+    const int target = wanted < 0 ? available : qMin(wanted, available);
+    while (picks.count() < target) {
+#if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+      const int id = candidates_[qrand() % candidates_.count()];
+#else
+      const int id = candidates_[QRandomGenerator::global()->bounded(
+          candidates_.count())];
+#endif
+      if (recent.contains(id) || picked.contains(id)) continue;
+
+      picked << id;
+      picks << id;
+    }
+  }
+
+  if (picks.isEmpty()) return PlaylistItemList();
+
+  // Keep the random order
+  QHash<int, Song> songs_by_id;
+  for (const Song& song : backend_->GetSongsById(picks)) {
+    songs_by_id[song.id()] = song;
+  }
+
+  SongList songs;
+  for (int id : picks) {
+    if (songs_by_id.contains(id)) songs << songs_by_id[id];
+  }
+  return ItemsFromSongs(songs);
+}
+
+void QueryGenerator::UpdateCandidates() {
+  if (!connected_to_library_) {
+    connected_to_library_ = true;
+    connect(backend_, SIGNAL(SongsDiscovered(SongList)),
+            SLOT(SongsChanged(SongList)));
+    connect(backend_, SIGNAL(SongsStatisticsChanged(SongList)),
+            SLOT(SongsChanged(SongList)));
+    connect(backend_, SIGNAL(SongsRatingChanged(SongList)),
+            SLOT(SongsChanged(SongList)));
+    connect(backend_, SIGNAL(SongsDeleted(SongList)),
+            SLOT(SongsDeleted(SongList)));
+    connect(backend_, SIGNAL(DatabaseReset()), SLOT(ForgetCandidates()));
+  }
+
+  bool reload;
+  QSet<int> changed_ids;
+  {
+    QMutexLocker l(&candidates_mutex_);
+    reload = !candidates_loaded_ ||
+             candidates_age_.elapsed() > kCandidatesMaxAgeSecs * 1000;
+    if (!reload) {
+      changed_ids.swap(changed_ids_);
+    }
+  }
+
+  // Query the database without holding the lock, so the library signals
+  // don't have to wait for us on the UI thread.
+  if (reload) {
+    const QList<int> ids = backend_->FindSongIds(search_);
+
+    QMutexLocker l(&candidates_mutex_);
+    candidates_.clear();
+    candidate_positions_.clear();
+    for (int id : ids) {
+      AddCandidateLocked(id);
+    }
+    candidates_loaded_ = true;
+    candidates_age_.start();
+  } else if (!changed_ids.isEmpty()) {
+    Search search = search_;
+    search.id_in_ = changed_ids.toList();
+    const QList<int> matching = backend_->FindSongIds(search);
+
+    QMutexLocker l(&candidates_mutex_);
+    for (int id : changed_ids) {
+      RemoveCandidateLocked(id);
+    }
+    for (int id : matching) {
+      AddCandidateLocked(id);
+    }
+  }
+}
+
+void QueryGenerator::AddCandidateLocked(int id) {
+  if (candidate_positions_.contains(id)) return;
+
+  candidate_positions_[id] = candidates_.count();
+  candidates_ << id;
+}
+
+void QueryGenerator::RemoveCandidateLocked(int id) {
+  QHash<int, int>::iterator it = candidate_positions_.find(id);
+  if (it == candidate_positions_.end()) return;
+
+  // Move the last candidate into the hole
+  const int position = it.value();
+  const int last = candidates_.last();
+  candidates_[position] = last;
+  candidate_positions_[last] = position;
+
+  candidates_.removeLast();
+  candidate_positions_.remove(id);
+}
+
+void QueryGenerator::SongsChanged(const SongList& songs) {
+  QMutexLocker l(&candidates_mutex_);
+  for (const Song& song : songs) {
+    changed_ids_ << song.id();
+  }
+}
+
+void QueryGenerator::SongsDeleted(const SongList& songs) {
+  QMutexLocker l(&candidates_mutex_);
+  for (const Song& song : songs) {
+    RemoveCandidateLocked(song.id());
+    changed_ids_.remove(song.id());
+  }
+}
+
+void QueryGenerator::ForgetCandidates() {
+  QMutexLocker l(&candidates_mutex_);
+  candidates_loaded_ = false;
+  changed_ids_.clear();
+}
+
 }  // namespace smart_playlists
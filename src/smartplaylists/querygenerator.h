@@ -18,17 +18,31 @@
 #ifndef QUERYPLAYLISTGENERATOR_H
 #define QUERYPLAYLISTGENERATOR_H
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+#include "core/song.h"
 #include "generator.h"
 #include "search.h"
 
 namespace smart_playlists {
 
 class QueryGenerator : public Generator {
+  Q_OBJECT
+
  public:
   QueryGenerator();
   QueryGenerator(const QString& name, const Search& search,
                  bool dynamic = false);
 
+  // The matching songs of a dynamic random playlist are reloaded from scratch
+  // this often, to catch changes the library doesn't signal, like songs
+  // leaving an "in the last N days" range.
+  static const int kCandidatesMaxAgeSecs;
+
   QString type() const { return "Query"; }
 
   void Load(const Search& search);
@@ -43,12 +57,43 @@ class QueryGenerator : public Generator {
   Search search() const { return search_; }
   int GetDynamicFuture() { return search_.limit_; }
 
+ private slots:
+  void SongsChanged(const SongList& songs);
+  void SongsDeleted(const SongList& songs);
+  void ForgetCandidates();
+
+ private:
+  // Dynamic playlists sorted randomly pick from the IDs of all matching
+  // songs, loaded once and then kept up to date, instead of running the
+  // search with ORDER BY random() every time.
+  bool uses_candidates() const {
+    return dynamic_ && search_.sort_type_ == Search::Sort_Random;
+  }
+  PlaylistItemList GenerateMoreFromCandidates(int count);
+  void UpdateCandidates();
+  void AddCandidateLocked(int id);
+  void RemoveCandidateLocked(int id);
+
+  PlaylistItemList ItemsFromSongs(const SongList& songs);
+
  private:
   Search search_;
   bool dynamic_;
 
   QList<int> previous_ids_;
   int current_pos_;
+
+  // Modified from library signals on the UI thread as well as from
+  // GenerateMore.
+  QMutex candidates_mutex_;
+  bool candidates_loaded_;
+  bool connected_to_library_;
+  QElapsedTimer candidates_age_;
+  QVector<int> candidates_;
+  QHash<int, int> candidate_positions_;
+  // Songs that changed since the candidates were last updated, and might have
+  // started or stopped matching the search.
+  QSet<int> changed_ids_;
 };
 
 }  // namespace smart_playlists
@@ -33,7 +33,8 @@ Search::Search(SearchType type, TermList terms, SortType sort_type,
       sort_type_(sort_type),
       sort_field_(sort_field),
       limit_(limit),
-      first_item_(0) {}
+      first_item_(0),
+      ids_only_(false) {}
 
 void Search::Reset() {
   search_type_ = Type_And;
@@ -42,10 +43,13 @@ void Search::Reset() {
   sort_field_ = SearchTerm::Field_Title;
   limit_ = -1;
   first_item_ = 0;
+  ids_only_ = false;
 }
 
 QString Search::ToSql(const QString& songs_table) const {
-  QString sql = "SELECT ROWID," + Song::kColumnSpec + " FROM " + songs_table;
+  QString sql = "SELECT ROWID" +
+                (ids_only_ ? QString() : "," + Song::kColumnSpec) + " FROM " +
+                songs_table;
 
   // Add search terms
   QStringList where_clauses;
@@ -67,6 +71,13 @@ QString Search::ToSql(const QString& songs_table) const {
     }
     where_clauses << "(ROWID NOT IN (" + numbers + "))";
   }
+  if (!id_in_.isEmpty()) {
+    QString numbers;
+    for (int id : id_in_) {
+      numbers += (numbers.isEmpty() ? "" : ",") + QString::number(id);
+    }
+    where_clauses << "(ROWID IN (" + numbers + "))";
+  }
 
   // We never want to include songs that have been deleted, but are still kept
   // in the database in case the directory containing them has just been
@@ -77,6 +88,11 @@ QString Search::ToSql(const QString& songs_table) const {
     sql += " WHERE " + where_clauses.join(" AND ");
   }
 
+  if (ids_only_) {
+    qLog(Debug) << sql;
+    return sql;
+  }
+
   // Add sort by
   if (sort_type_ == Sort_Random) {
     sql += " ORDER BY random()";
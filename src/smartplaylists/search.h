@@ -57,7 +57,10 @@ class Search {
 
   // Not persisted, used to alter the behaviour of the query
   QList<int> id_not_in_;
+  QList<int> id_in_;
   int first_item_;
+  // Select only the ROWIDs of all matching songs, ignoring sort and limit
+  bool ids_only_;
 
   void Reset();
   QString ToSql(const QString& songs_table) const;
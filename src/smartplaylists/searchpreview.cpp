@@ -17,19 +17,33 @@
 
 #include "searchpreview.h"
 
-#include <QtConcurrentRun>
-#include <memory>
+#include <QTimer>
 
+#include "core/closure.h"
+#include "core/executor.h"
+#include "library/librarybackend.h"
 #include "playlist/playlist.h"
-#include "querygenerator.h"
+#include "playlist/playlistitem.h"
 #include "ui_searchpreview.h"
 
 namespace smart_playlists {
 
+const int SearchPreview::kUpdateDelayMsec = 250;
+
 SearchPreview::SearchPreview(QWidget* parent)
-    : QWidget(parent), ui_(new Ui_SmartPlaylistSearchPreview), model_(nullptr) {
+    : QWidget(parent),
+      ui_(new Ui_SmartPlaylistSearchPreview),
+      model_(nullptr),
+      update_timer_(new QTimer(this)),
+      generation_(new QAtomicInt),
+      shown_count_(-1),
+      found_count_(-1) {
   ui_->setupUi(this);
 
+  update_timer_->setInterval(kUpdateDelayMsec);
+  update_timer_->setSingleShot(true);
+  connect(update_timer_, SIGNAL(timeout()), SLOT(UpdateTimeout()));
+
   // Prevent editing songs and saving settings (like header columns and
   // geometry)
   ui_->tree->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -58,22 +72,23 @@ void SearchPreview::set_library(LibraryBackend* backend) {
 
 void SearchPreview::Update(const Search& search) {
   if (search == last_search_) {
-    // This search was the same as the last one we did
-    return;
-  }
-
-  if (generator_ || isHidden()) {
-    // It's busy generating something already, or the widget isn't visible
-    pending_search_ = search;
+    // This search was the same as the last one we did, so anything changed
+    // since has been changed back.
+    update_timer_->stop();
+    pending_search_ = Search();
     return;
   }
 
-  RunSearch(search);
+  // Wait for the terms to stop changing, and only search for the last one.
+  // If the widget isn't visible it's searched for when it's shown.
+  pending_search_ = search;
+  if (!isHidden()) update_timer_->start();
 }
 
 void SearchPreview::showEvent(QShowEvent* e) {
-  if (pending_search_.is_valid() && !generator_) {
+  if (pending_search_.is_valid()) {
     // There was a search waiting while we were hidden, so run it now
+    update_timer_->stop();
     RunSearch(pending_search_);
     pending_search_ = Search();
   }
@@ -81,45 +96,84 @@ void SearchPreview::showEvent(QShowEvent* e) {
   QWidget::showEvent(e);
 }
 
-PlaylistItemList DoRunSearch(GeneratorPtr gen) { return gen->Generate(); }
+void SearchPreview::UpdateTimeout() {
+  if (!pending_search_.is_valid() || isHidden()) return;
+
+  RunSearch(pending_search_);
+  pending_search_ = Search();
+}
 
 void SearchPreview::RunSearch(const Search& search) {
-  generator_.reset(new QueryGenerator);
-  generator_->set_library(backend_);
-  std::dynamic_pointer_cast<QueryGenerator>(generator_)->Load(search);
+  last_search_ = search;
+  const int generation = generation_->fetchAndAddOrdered(1) + 1;
+  shown_count_ = -1;
+  found_count_ = -1;
 
   ui_->busy_container->show();
   ui_->count_label->hide();
-  QFuture<PlaylistItemList> future = QtConcurrent::run(DoRunSearch, generator_);
-  NewClosure(future, this, SLOT(SearchFinished(QFuture<PlaylistItemList>)),
-             future);
+
+  // Only the songs that are shown are loaded, the rest are just counted.
+  Search preview = search;
+  preview.limit_ = search.limit_ == -1
+                       ? Generator::kDefaultLimit
+                       : qMin(search.limit_, Generator::kDefaultLimit);
+
+  LibraryBackend* backend = backend_;
+  std::shared_ptr<QAtomicInt> current = generation_;
+
+  QFuture<PlaylistItemList> items = Executor::Db()->Run<PlaylistItemList>(
+      [backend, preview, current, generation]() {
+        PlaylistItemList ret;
+        if (current->load() != generation) return ret;
+
+        for (const Song& song : backend->FindSongs(preview)) {
+          ret << PlaylistItemPtr(
+              PlaylistItem::NewFromSongsTable(backend->songs_table(), song));
+        }
+        return ret;
+      });
+  NewClosure(items, this,
+             SLOT(SearchFinished(QFuture<PlaylistItemList>, int)), items,
+             generation);
+
+  QFuture<int> count =
+      Executor::Db()->Run<int>([backend, search, current, generation]() {
+        if (current->load() != generation) return 0;
+
+        const int count = backend->CountSongs(search);
+        return search.limit_ == -1 ? count : qMin(count, search.limit_);
+      });
+  NewClosure(count, this, SLOT(CountFinished(QFuture<int>, int)), count,
+             generation);
 }
 
-void SearchPreview::SearchFinished(QFuture<PlaylistItemList> future) {
-  last_search_ =
-      std::dynamic_pointer_cast<QueryGenerator>(generator_)->search();
-  generator_.reset();
+void SearchPreview::SearchFinished(QFuture<PlaylistItemList> future,
+                                   int generation) {
+  if (generation != generation_->load()) return;
 
-  if (pending_search_.is_valid() && pending_search_ != last_search_) {
-    // There was another search done while we were running - throw away these
-    // results and do that one now instead
-    RunSearch(pending_search_);
-    pending_search_ = Search();
-    return;
-  }
+  const PlaylistItemList items = future.result();
+  model_->Clear();
+  model_->InsertItems(items);
 
-  PlaylistItemList all_items = future.result();
-  PlaylistItemList displayed_items = all_items.mid(0, Generator::kDefaultLimit);
+  shown_count_ = items.count();
+  UpdateCountLabel();
+}
 
-  model_->Clear();
-  model_->InsertItems(displayed_items);
+void SearchPreview::CountFinished(QFuture<int> future, int generation) {
+  if (generation != generation_->load()) return;
+
+  found_count_ = future.result();
+  UpdateCountLabel();
+}
+
+void SearchPreview::UpdateCountLabel() {
+  if (shown_count_ == -1 || found_count_ == -1) return;
 
-  if (displayed_items.count() < all_items.count()) {
-    ui_->count_label->setText(tr("%1 songs found (showing %2)")
-                                  .arg(all_items.count())
-                                  .arg(displayed_items.count()));
+  if (shown_count_ < found_count_) {
+    ui_->count_label->setText(
+        tr("%1 songs found (showing %2)").arg(found_count_).arg(shown_count_));
   } else {
-    ui_->count_label->setText(tr("%1 songs found").arg(all_items.count()));
+    ui_->count_label->setText(tr("%1 songs found").arg(found_count_));
   }
 
   ui_->busy_container->hide();
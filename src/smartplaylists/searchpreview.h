@@ -18,8 +18,10 @@
 #ifndef SMARTPLAYLISTSEARCHPREVIEW_H
 #define SMARTPLAYLISTSEARCHPREVIEW_H
 
+#include <QAtomicInt>
 #include <QFuture>
 #include <QWidget>
+#include <memory>
 
 #include "search.h"
 #include "smartplaylists/generator_fwd.h"
@@ -29,8 +31,13 @@ class LibraryBackend;
 class Playlist;
 class Ui_SmartPlaylistSearchPreview;
 
+class QTimer;
+
 namespace smart_playlists {
 
+// Shows the first few songs a search finds and how many there are.  Searches
+// are run in the background a short while after the last change, and ones
+// that a later change has made stale are dropped.
 class SearchPreview : public QWidget {
   Q_OBJECT
 
@@ -38,6 +45,9 @@ class SearchPreview : public QWidget {
   SearchPreview(QWidget* parent = nullptr);
   ~SearchPreview();
 
+  // How long to wait for another change before searching.
+  static const int kUpdateDelayMsec;
+
   void set_application(Application* app);
   void set_library(LibraryBackend* backend);
 
@@ -48,9 +58,12 @@ class SearchPreview : public QWidget {
 
  private:
   void RunSearch(const Search& search);
+  void UpdateCountLabel();
 
  private slots:
-  void SearchFinished(QFuture<PlaylistItemList> future);
+  void UpdateTimeout();
+  void SearchFinished(QFuture<PlaylistItemList> future, int generation);
+  void CountFinished(QFuture<int> future, int generation);
 
  private:
   Ui_SmartPlaylistSearchPreview* ui_;
@@ -59,9 +72,15 @@ class SearchPreview : public QWidget {
   LibraryBackend* backend_;
   Playlist* model_;
 
+  QTimer* update_timer_;
   Search pending_search_;
   Search last_search_;
-  GeneratorPtr generator_;
+
+  // Bumped by every search.  It's shared with the queries, which don't run if
+  // they're stale by the time they start.
+  std::shared_ptr<QAtomicInt> generation_;
+  int shown_count_;
+  int found_count_;
 };
 
 }  // namespace smart_playlists
@@ -0,0 +1,125 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "similargenerator.h"
+
+#include <QDataStream>
+#include <QHash>
+#include <QSet>
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+#include <QRandomGenerator>
+#endif
+
+#include "library/librarybackend.h"
+#include "similarityindex.h"
+
+namespace smart_playlists {
+
+const int SimilarGenerator::kIndexMaxAgeSecs = 60 * 60;
+const int SimilarGenerator::kChoices = 5;
+
+SimilarGenerator::SimilarGenerator() : seed_id_(-1) {}
+
+SimilarGenerator::SimilarGenerator(const QString& name, const Song& seed)
+    : seed_id_(seed.id()) {
+  set_name(name);
+}
+
+SimilarGenerator::~SimilarGenerator() {}
+
+void SimilarGenerator::Load(const QByteArray& data) {
+  QDataStream s(data);
+  qint32 seed_id = -1;
+  s >> seed_id;
+  seed_id_ = seed_id;
+  previous_ids_.clear();
+}
+
+QByteArray SimilarGenerator::Save() const {
+  QByteArray ret;
+  QDataStream s(&ret, QIODevice::WriteOnly);
+  s << qint32(seed_id_);
+  return ret;
+}
+
+PlaylistItemList SimilarGenerator::Generate() {
+  previous_ids_.clear();
+  return GenerateMore(GetDynamicFuture());
+}
+
+PlaylistItemList SimilarGenerator::GenerateMore(int count) {
+  if (!index_ || index_age_.elapsed() > kIndexMaxAgeSecs * 1000) {
+    index_ = SimilarityIndex::Load(backend_->db(), backend_->songs_table());
+    index_age_.start();
+  }
+
+  SimilarityIndex::Features seed;
+  if (!index_->Get(seed_id_, &seed)) {
+    emit Error(tr("There's no moodbar for this song yet, so similar songs "
+                  "can't be found"));
+    return PlaylistItemList();
+  }
+
+  QSet<int> exclude = previous_ids_.toSet();
+  exclude << seed_id_;
+
+  QList<int> picks;
+  SimilarityIndex::Features previous = seed;
+  if (!previous_ids_.isEmpty()) index_->Get(previous_ids_.last(), &previous);
+
+  for (int i = 0; i < count; ++i) {
+    SimilarityIndex::Features query;
+    for (int dim = 0; dim < SimilarityIndex::kDimensions; ++dim) {
+      query[dim] = (seed[dim] + previous[dim]) / 2;
+    }
+
+    const QList<int> choices = index_->Nearest(query, kChoices, exclude);
+    if (choices.isEmpty()) break;
+
+#if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+    const int id = choices[qrand() % choices.count()];
+#else
+    const int id =
+        choices[QRandomGenerator::global()->bounded(choices.count())];
+#endif
+    picks << id;
+    exclude << id;
+    index_->Get(id, &previous);
+  }
+
+  // Keep the order they were picked in.
+  QHash<int, Song> songs_by_id;
+  for (const Song& song : backend_->GetSongsById(picks)) {
+    songs_by_id[song.id()] = song;
+  }
+
+  PlaylistItemList items;
+  for (int id : picks) {
+    if (!songs_by_id.contains(id)) continue;
+
+    items << PlaylistItemPtr(PlaylistItem::NewFromSongsTable(
+        backend_->songs_table(), songs_by_id[id]));
+    previous_ids_ << id;
+    if (previous_ids_.count() > GetDynamicFuture() + GetDynamicHistory()) {
+      previous_ids_.removeFirst();
+    }
+  }
+  return items;
+}
+
+}  // namespace smart_playlists
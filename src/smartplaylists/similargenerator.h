@@ -0,0 +1,68 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SMARTPLAYLISTS_SIMILARGENERATOR_H_
+#define SMARTPLAYLISTS_SIMILARGENERATOR_H_
+
+#include <QElapsedTimer>
+#include <QList>
+#include <memory>
+
+#include "core/song.h"
+#include "generator.h"
+
+class SimilarityIndex;
+
+namespace smart_playlists {
+
+// A dynamic playlist of library songs that sound like the one it was started
+// from.  Each song is picked from the ones closest to a mix of the starting
+// song and the one before it, so the playlist can wander a little but
+// doesn't drift too far.  Only songs with moodbars can be picked.
+class SimilarGenerator : public Generator {
+  Q_OBJECT
+
+ public:
+  SimilarGenerator();
+  SimilarGenerator(const QString& name, const Song& seed);
+  ~SimilarGenerator();
+
+  // The index is loaded again this often, to pick up new moodbars.
+  static const int kIndexMaxAgeSecs;
+  // Each song is picked at random from this many of the closest ones.
+  static const int kChoices;
+
+  QString type() const { return "Similar"; }
+
+  void Load(const QByteArray& data);
+  QByteArray Save() const;
+
+  PlaylistItemList Generate();
+  PlaylistItemList GenerateMore(int count);
+  bool is_dynamic() const { return true; }
+
+ private:
+  int seed_id_;
+  QList<int> previous_ids_;
+
+  std::unique_ptr<SimilarityIndex> index_;
+  QElapsedTimer index_age_;
+};
+
+}  // namespace smart_playlists
+
+#endif  // SMARTPLAYLISTS_SIMILARGENERATOR_H_
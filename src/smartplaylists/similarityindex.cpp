@@ -0,0 +1,291 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "similarityindex.h"
+
+#include <QMutexLocker>
+#include <QSqlQuery>
+#include <QUrl>
+#include <QVariant>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "core/database.h"
+
+const int SimilarityIndex::kDefaultMaxChecks = 2000;
+
+namespace {
+
+// Each band of a moodbar's frames is a byte of colour.
+const int kBands = 3;
+const int kFeaturesPerBand = 4;
+
+}  // namespace
+
+struct SimilarityIndex::SearchState {
+  Features query_;
+  int count_;
+  const QSet<int>* exclude_;
+  int checks_left_;
+
+  // A max-heap of (distance, position), so the furthest is at the front.
+  std::vector<std::pair<float, int>> nearest_;
+
+  bool Wants(float distance) const {
+    return int(nearest_.size()) < count_ || distance < nearest_.front().first;
+  }
+
+  void Offer(float distance, int position) {
+    if (!Wants(distance)) return;
+
+    if (int(nearest_.size()) == count_) {
+      std::pop_heap(nearest_.begin(), nearest_.end());
+      nearest_.pop_back();
+    }
+    nearest_.push_back(std::make_pair(distance, position));
+    std::push_heap(nearest_.begin(), nearest_.end());
+  }
+};
+
+bool SimilarityIndex::FromMoodbar(const QByteArray& moodbar,
+                                  Features* features) {
+  const int frames = moodbar.size() / kBands;
+  if (frames < 2) return false;
+
+  const uchar* data = reinterpret_cast<const uchar*>(moodbar.constData());
+  for (int band = 0; band < kBands; ++band) {
+    double sum = 0;
+    double sum_of_squares = 0;
+    double change = 0;
+    for (int i = 0; i < frames; ++i) {
+      const double value = data[i * kBands + band] / 255.0;
+      sum += value;
+      sum_of_squares += value * value;
+      if (i > 0) {
+        change += std::abs(value - data[(i - 1) * kBands + band] / 255.0);
+      }
+    }
+
+    const double mean = sum / frames;
+    const double variance = qMax(0.0, sum_of_squares / frames - mean * mean);
+
+    int above = 0;
+    for (int i = 0; i < frames; ++i) {
+      if (data[i * kBands + band] / 255.0 > mean) ++above;
+    }
+
+    float* out = features->data() + band * kFeaturesPerBand;
+    out[0] = mean;
+    out[1] = std::sqrt(variance);
+    out[2] = change / (frames - 1);
+    out[3] = double(above) / frames;
+  }
+  return true;
+}
+
+QByteArray SimilarityIndex::Pack(const Features& features) {
+  QByteArray ret;
+  ret.resize(kDimensions * 4);
+
+  uchar* data = reinterpret_cast<uchar*>(ret.data());
+  for (float value : features) {
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian(bits, data);
+    data += 4;
+  }
+  return ret;
+}
+
+bool SimilarityIndex::Unpack(const QByteArray& data, Features* features) {
+  if (data.size() != kDimensions * 4) return false;
+
+  const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+  for (int i = 0; i < kDimensions; ++i) {
+    const quint32 bits = qFromLittleEndian<quint32>(p + i * 4);
+    memcpy(&(*features)[i], &bits, sizeof(bits));
+  }
+  return true;
+}
+
+void SimilarityIndex::Save(Database* db, const QUrl& url,
+                           const Features& features) {
+  QMutexLocker l(db->Mutex());
+  QSqlDatabase connection(db->Connect());
+
+  QSqlQuery q(connection);
+  q.prepare(
+      "INSERT OR REPLACE INTO moodbar_features (filename, features)"
+      " VALUES (:filename, :features)");
+  q.bindValue(":filename", url.toEncoded());
+  q.bindValue(":features", Pack(features));
+  q.exec();
+  db->CheckErrors(q);
+}
+
+QSet<QByteArray> SimilarityIndex::LoadFilenames(Database* db) {
+  QMutexLocker l(db->ReadMutex());
+  QSqlDatabase connection(db->ConnectReadOnly());
+
+  QSqlQuery q(connection);
+  q.exec("SELECT filename FROM moodbar_features");
+  QSet<QByteArray> ret;
+  if (db->CheckErrors(q)) return ret;
+
+  while (q.next()) ret << q.value(0).toByteArray();
+  return ret;
+}
+
+std::unique_ptr<SimilarityIndex> SimilarityIndex::Load(
+    Database* db, const QString& songs_table) {
+  std::unique_ptr<SimilarityIndex> ret(new SimilarityIndex);
+  {
+    QMutexLocker l(db->ReadMutex());
+    QSqlDatabase connection(db->ConnectReadOnly());
+
+    QSqlQuery q(connection);
+    q.exec(QString("SELECT s.ROWID, f.features FROM %1 AS s"
+                   " JOIN moodbar_features AS f ON f.filename = s.filename"
+                   " WHERE s.unavailable = 0")
+               .arg(songs_table));
+    if (!db->CheckErrors(q)) {
+      Features features;
+      while (q.next()) {
+        if (Unpack(q.value(1).toByteArray(), &features)) {
+          ret->Add(q.value(0).toInt(), features);
+        }
+      }
+    }
+  }
+
+  ret->Build();
+  return ret;
+}
+
+void SimilarityIndex::Add(int id, const Features& features) {
+  // A song can be in the library more than once, as the same file.
+  if (positions_.contains(id)) return;
+
+  positions_[id] = ids_.size();
+  ids_.push_back(id);
+  features_.push_back(features);
+}
+
+bool SimilarityIndex::Get(int id, Features* features) const {
+  auto it = positions_.constFind(id);
+  if (it == positions_.constEnd()) return false;
+
+  *features = features_[it.value()];
+  return true;
+}
+
+void SimilarityIndex::Build() {
+  order_.resize(ids_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  split_dims_.assign(ids_.size(), 0);
+  BuildRange(0, order_.size());
+}
+
+void SimilarityIndex::BuildRange(int begin, int end) {
+  if (end - begin < 2) return;
+
+  // Split along whichever feature varies most here.
+  int split_dim = 0;
+  float widest = -1;
+  for (int dim = 0; dim < kDimensions; ++dim) {
+    float low = features_[order_[begin]][dim];
+    float high = low;
+    for (int i = begin + 1; i < end; ++i) {
+      const float value = features_[order_[i]][dim];
+      low = qMin(low, value);
+      high = qMax(high, value);
+    }
+    if (high - low > widest) {
+      widest = high - low;
+      split_dim = dim;
+    }
+  }
+
+  const int middle = begin + (end - begin) / 2;
+  std::nth_element(order_.begin() + begin, order_.begin() + middle,
+                   order_.begin() + end, [this, split_dim](int a, int b) {
+                     return features_[a][split_dim] < features_[b][split_dim];
+                   });
+  split_dims_[middle] = split_dim;
+
+  BuildRange(begin, middle);
+  BuildRange(middle + 1, end);
+}
+
+float SimilarityIndex::Distance(const Features& a, const Features& b) {
+  float ret = 0;
+  for (int i = 0; i < kDimensions; ++i) {
+    const float difference = a[i] - b[i];
+    ret += difference * difference;
+  }
+  return ret;
+}
+
+QList<int> SimilarityIndex::Nearest(const Features& features, int count,
+                                    const QSet<int>& exclude,
+                                    int max_checks) const {
+  if (count <= 0) return QList<int>();
+
+  SearchState state;
+  state.query_ = features;
+  state.count_ = count;
+  state.exclude_ = &exclude;
+  state.checks_left_ = max_checks;
+  SearchRange(0, order_.size(), &state);
+
+  std::sort_heap(state.nearest_.begin(), state.nearest_.end());
+  QList<int> ret;
+  for (const auto& nearest : state.nearest_) ret << ids_[nearest.second];
+  return ret;
+}
+
+void SimilarityIndex::SearchRange(int begin, int end,
+                                  SearchState* state) const {
+  if (begin >= end || state->checks_left_ <= 0) return;
+  --state->checks_left_;
+
+  const int middle = begin + (end - begin) / 2;
+  const int position = order_[middle];
+  const Features& here = features_[position];
+  if (!state->exclude_->contains(ids_[position])) {
+    state->Offer(Distance(state->query_, here), position);
+  }
+
+  // The query's side of the split first, then the other side if anything
+  // over there could be closer than what's been found already.
+  const int dim = split_dims_[middle];
+  const float difference = state->query_[dim] - here[dim];
+  if (difference < 0) {
+    SearchRange(begin, middle, state);
+    if (state->Wants(difference * difference)) {
+      SearchRange(middle + 1, end, state);
+    }
+  } else {
+    SearchRange(middle + 1, end, state);
+    if (state->Wants(difference * difference)) {
+      SearchRange(begin, middle, state);
+    }
+  }
+}
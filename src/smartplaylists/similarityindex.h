@@ -0,0 +1,93 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SMARTPLAYLISTS_SIMILARITYINDEX_H_
+#define SMARTPLAYLISTS_SIMILARITYINDEX_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <array>
+#include <memory>
+#include <vector>
+
+class Database;
+class QUrl;
+
+// Finds the songs that sound most like another one, from a few numbers
+// worked out from each song's moodbar: how loud its low, mid and high bands
+// are on average, how much they vary, how quickly they change, and how much
+// of the song is above the average.  The features are kept in the database,
+// so the index can be built without loading any moodbars.
+//
+// The index is a k-d tree.  Searches give up after looking at a fixed number
+// of songs, so on a big library they're approximate but always quick.
+class SimilarityIndex {
+ public:
+  static const int kDimensions = 12;
+  static const int kDefaultMaxChecks;
+
+  typedef std::array<float, kDimensions> Features;
+
+  // Returns false if moodbar is too short to say anything.
+  static bool FromMoodbar(const QByteArray& moodbar, Features* features);
+  static QByteArray Pack(const Features& features);
+  static bool Unpack(const QByteArray& data, Features* features);
+
+  // Stores the features of the song at url, replacing any it had.
+  static void Save(Database* db, const QUrl& url, const Features& features);
+  // The encoded URLs of the songs that have features.
+  static QSet<QByteArray> LoadFilenames(Database* db);
+  // Makes an index of the available songs in songs_table that have features.
+  static std::unique_ptr<SimilarityIndex> Load(Database* db,
+                                               const QString& songs_table);
+
+  // Call Build after adding songs, and before searching.
+  void Add(int id, const Features& features);
+  void Build();
+
+  int count() const { return ids_.size(); }
+  bool Get(int id, Features* features) const;
+
+  // Returns up to count songs, closest to features first, leaving out the
+  // ones in exclude.  Looks at no more than max_checks songs, so it might
+  // miss one that's closer.
+  QList<int> Nearest(const Features& features, int count,
+                     const QSet<int>& exclude = QSet<int>(),
+                     int max_checks = kDefaultMaxChecks) const;
+
+ private:
+  struct SearchState;
+
+  static float Distance(const Features& a, const Features& b);
+
+  // The song at the middle of order_'s range splits the rest of it along
+  // split_dims_ at the same position.
+  void BuildRange(int begin, int end);
+  void SearchRange(int begin, int end, SearchState* state) const;
+
+  std::vector<int> ids_;
+  std::vector<Features> features_;
+  QHash<int, int> positions_;
+
+  std::vector<int> order_;
+  std::vector<quint8> split_dims_;
+};
+
+#endif  // SMARTPLAYLISTS_SIMILARITYINDEX_H_
@@ -104,6 +104,7 @@ void ArtistBiography::FetchInfo(int id, const Song& metadata) {
         SongInfoTextView* editor = new SongInfoTextView;
         editor->SetHtml(text);
         data.contents_ = editor;
+        data.html_ = text;
         emit InfoReady(id, data);
       }
       latch->CountDown();
@@ -287,6 +288,7 @@ void ArtistBiography::FetchWikipediaArticle(int id,
         SongInfoTextView* editor = new SongInfoTextView;
         editor->SetHtml(text);
         data.contents_ = editor;
+        data.html_ = text;
         emit InfoReady(id, data);
         latch->CountDown();
       });
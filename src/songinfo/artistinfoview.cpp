@@ -24,6 +24,7 @@
 #include "widgets/prettyimageview.h"
 
 ArtistInfoView::ArtistInfoView(QWidget* parent) : SongInfoBase(parent) {
+  fetcher_->set_cache_by_artist(true);
   fetcher_->AddProvider(new SongkickConcerts);
   fetcher_->AddProvider(new SpotifyImages);
   fetcher_->AddProvider(new ArtistBiography);
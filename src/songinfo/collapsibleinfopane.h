@@ -28,7 +28,11 @@ class CollapsibleInfoPane : public QWidget {
 
  public:
   struct Data {
-    Data() : type_(Type_Biography), relevance_(0) {}
+    Data()
+        : type_(Type_Biography),
+          relevance_(0),
+          contents_(nullptr),
+          content_object_(nullptr) {}
 
     bool operator<(const Data& other) const;
 
@@ -49,6 +53,10 @@ class CollapsibleInfoPane : public QWidget {
 
     QWidget* contents_;
     QObject* content_object_;
+
+    // Set if contents_ is just a SongInfoTextView showing this html.  Only
+    // these results are cached, the text view is made again from the html.
+    QString html_;
   };
 
   CollapsibleInfoPane(const Data& data, QWidget* parent = nullptr);
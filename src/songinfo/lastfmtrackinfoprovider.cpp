@@ -115,6 +115,7 @@ void LastfmTrackInfoProvider::GetWiki(int id, const lastfm::XmlQuery& q) {
 
   SongInfoTextView* widget = new SongInfoTextView;
   data.contents_ = widget;
+  data.html_ = content;
 
   widget->SetHtml(content);
 
@@ -119,6 +119,16 @@ void SongInfoBase::SongChanged(const Song& metadata) {
 
 void SongInfoBase::SongFinished() { dirty_ = false; }
 
+void SongInfoBase::PrefetchSong(const Song& metadata) {
+  // Not worth it if nobody's looking, showing the view fetches anyway.
+  if (!isVisible() || !metadata.is_valid()) return;
+  if (old_metadata_.is_valid() && !NeedsUpdate(old_metadata_, metadata)) {
+    return;
+  }
+
+  fetcher_->Prefetch(metadata);
+}
+
 void SongInfoBase::showEvent(QShowEvent* e) {
   if (dirty_) {
     MaybeUpdate(queued_metadata_);
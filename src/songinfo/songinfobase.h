@@ -47,6 +47,9 @@ class SongInfoBase : public QWidget {
   void SongFinished();
   virtual void ReloadSettings();
 
+  // Starts fetching info for a song that's likely to be played next.
+  void PrefetchSong(const Song& metadata);
+
  signals:
   void ShowSettingsDialog();
   void DoGlobalSearch(const QString& query);
@@ -17,13 +17,27 @@
 
 #include "songinfofetcher.h"
 
+#include <QDateTime>
 #include <QTimer>
+#include <algorithm>
+#include <climits>
 
 #include "core/logging.h"
 #include "songinfoprovider.h"
+#include "songinfotextview.h"
+
+const int SongInfoFetcher::kCacheDuration = 6 * 60 * 60 * 1000;  // 6 hours
+const int SongInfoFetcher::kMaxCachedSongs = 100;
+
+namespace {
+bool MoreRelevant(const SongInfoProvider* a, const SongInfoProvider* b) {
+  return a->relevance() > b->relevance();
+}
+}  // namespace
 
 SongInfoFetcher::SongInfoFetcher(QObject* parent)
     : QObject(parent),
+      cache_by_artist_(false),
       timeout_duration_(kDefaultTimeoutDuration),
       next_id_(1) {}
 
@@ -39,8 +53,75 @@ void SongInfoFetcher::AddProvider(SongInfoProvider* provider) {
 }
 
 int SongInfoFetcher::FetchInfo(const Song& metadata) {
+  const QString key = CacheKey(metadata);
+
+  // Carry on from a prefetch of this song if there's one still going
+  for (auto it = requests_.begin(); it != requests_.end(); ++it) {
+    if (!it->prefetch_ || it->key_ != key) continue;
+
+    const int id = it.key();
+    it->prefetch_ = false;
+
+    // The caller doesn't know the ID until we return, so what the prefetch
+    // got already is emitted afterwards.
+    const QList<CollapsibleInfoPane::Data> info = results_[id].info_;
+    QTimer::singleShot(0, this, [this, id, info]() {
+      for (const CollapsibleInfoPane::Data& data : info) {
+        emit InfoResultReady(id, data);
+      }
+    });
+    return id;
+  }
+
+  return StartRequest(metadata, false);
+}
+
+void SongInfoFetcher::Prefetch(const Song& metadata) {
+  const QString key = CacheKey(metadata);
+  for (const Request& request : requests_) {
+    if (request.key_ == key) return;
+  }
+  StartRequest(metadata, true);
+}
+
+int SongInfoFetcher::StartRequest(const Song& metadata, bool prefetch) {
+  const QString key = CacheKey(metadata);
+  const CachedSong cached = CachedResults(key);
+
+  // Racing providers can't beat a more relevant one that has answered before
+  int best_racer = INT_MIN;
+  for (auto it = cached.begin(); it != cached.end(); ++it) {
+    if (it.key()->races() && !it->result_.info_.isEmpty()) {
+      best_racer = qMax(best_racer, it.key()->relevance());
+    }
+  }
+
+  QMap<SongInfoProvider*, ProviderResult> from_cache;
+  QList<SongInfoProvider*> to_fetch;
+  for (SongInfoProvider* provider : providers_) {
+    if (!provider->is_enabled()) continue;
+    if (provider->races() && provider->relevance() < best_racer) continue;
+
+    if (cached.contains(provider)) {
+      from_cache[provider] = cached[provider].result_;
+    } else {
+      to_fetch << provider;
+    }
+  }
+
+  // A prefetch only has to fill in what isn't cached already
+  if (prefetch) {
+    if (to_fetch.isEmpty()) return -1;
+    from_cache.clear();
+  }
+
+  // The most relevant racers are asked first
+  std::stable_sort(to_fetch.begin(), to_fetch.end(), MoreRelevant);
+
   const int id = next_id_++;
   results_[id] = Result();
+  requests_[id].key_ = key;
+  requests_[id].prefetch_ = prefetch;
   timeout_timers_[id] = new QTimer(this);
   timeout_timers_[id]->setSingleShot(true);
   timeout_timers_[id]->setInterval(timeout_duration_);
@@ -48,57 +129,176 @@ int SongInfoFetcher::FetchInfo(const Song& metadata) {
 
   connect(timeout_timers_[id], &QTimer::timeout, [this, id]() { Timeout(id); });
 
-  for (SongInfoProvider* provider : providers_) {
-    if (provider->is_enabled()) {
-      waiting_for_[id].append(provider);
-      provider->FetchInfo(id, metadata);
-    }
+  if (!from_cache.isEmpty()) {
+    waiting_for_[id] << from_cache.keys();
+    QTimer::singleShot(0, this, [this, id, from_cache]() {
+      ReplayCached(id, from_cache);
+    });
+  }
+  for (SongInfoProvider* provider : to_fetch) {
+    waiting_for_[id].append(provider);
+    provider->FetchInfo(id, metadata);
   }
   return id;
 }
 
+void SongInfoFetcher::ReplayCached(
+    int id, const QMap<SongInfoProvider*, ProviderResult>& results) {
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    SongInfoProvider* provider = it.key();
+    if (!waiting_for_.value(id).contains(provider)) continue;
+
+    for (const QUrl& url : it->images_) {
+      AddImage(id, provider, url);
+    }
+    for (CollapsibleInfoPane::Data data : it->info_) {
+      SongInfoTextView* editor = new SongInfoTextView;
+      editor->SetHtml(data.html_);
+      data.contents_ = editor;
+      AddInfo(id, provider, data);
+    }
+    ProviderDone(id, provider, true);
+  }
+}
+
 void SongInfoFetcher::ImageReady(int id, const QUrl& url) {
+  AddImage(id, qobject_cast<SongInfoProvider*>(sender()), url);
+}
+
+void SongInfoFetcher::InfoReady(int id, const CollapsibleInfoPane::Data& data) {
+  AddInfo(id, qobject_cast<SongInfoProvider*>(sender()), data);
+}
+
+void SongInfoFetcher::ProviderFinished(int id) {
+  ProviderDone(id, qobject_cast<SongInfoProvider*>(sender()), false);
+}
+
+void SongInfoFetcher::AddImage(int id, SongInfoProvider* provider,
+                               const QUrl& url) {
   if (!results_.contains(id)) return;
   results_[id].images_ << url;
+  requests_[id].results_[provider].images_ << url;
 }
 
-void SongInfoFetcher::InfoReady(int id, const CollapsibleInfoPane::Data& data) {
+void SongInfoFetcher::AddInfo(int id, SongInfoProvider* provider,
+                              const CollapsibleInfoPane::Data& data) {
   if (!results_.contains(id)) return;
+
+  if (!waiting_for_.value(id).contains(provider)) {
+    // A racer that lost, this was on its way before it was cancelled
+    delete data.contents_;
+    delete data.content_object_;
+    return;
+  }
+
+  ProviderResult& result = requests_[id].results_[provider];
+  if (data.html_.isEmpty()) {
+    result.cacheable_ = false;
+  } else {
+    CollapsibleInfoPane::Data copy = data;
+    copy.contents_ = nullptr;
+    copy.content_object_ = nullptr;
+    result.info_ << copy;
+  }
   results_[id].info_ << data;
 
-  if (!waiting_for_.contains(id)) return;
-  emit InfoResultReady(id, data);
+  if (provider->races()) CancelLessRelevant(id, provider);
+
+  if (!requests_[id].prefetch_) emit InfoResultReady(id, data);
 }
 
-void SongInfoFetcher::ProviderFinished(int id) {
+void SongInfoFetcher::CancelLessRelevant(int id, SongInfoProvider* winner) {
+  QList<SongInfoProvider*>& waiting = waiting_for_[id];
+  for (SongInfoProvider* provider : QList<SongInfoProvider*>(waiting)) {
+    if (provider->races() && provider->relevance() < winner->relevance()) {
+      provider->Cancel(id);
+      waiting.removeAll(provider);
+    }
+  }
+}
+
+void SongInfoFetcher::ProviderDone(int id, SongInfoProvider* provider,
+                                   bool from_cache) {
   if (!results_.contains(id)) return;
   if (!waiting_for_.contains(id)) return;
-
-  SongInfoProvider* provider = qobject_cast<SongInfoProvider*>(sender());
   if (!waiting_for_[id].contains(provider)) return;
 
   waiting_for_[id].removeAll(provider);
-  if (waiting_for_[id].isEmpty()) {
-    emit ResultReady(id, results_.take(id));
-    waiting_for_.remove(id);
-    delete timeout_timers_.take(id);
+
+  // Providers that found nothing are cached too, so they aren't asked again
+  if (!from_cache) {
+    const Request& request = requests_[id];
+    const ProviderResult result = request.results_.value(provider);
+    if (result.cacheable_) AddToCache(request.key_, provider, result);
   }
+
+  if (waiting_for_[id].isEmpty()) FinishRequest(id);
 }
 
 void SongInfoFetcher::Timeout(int id) {
   if (!results_.contains(id)) return;
-  if (!waiting_for_.contains(id)) return;
-
-  // Emit the results that we have already
-  emit ResultReady(id, results_.take(id));
 
   // Cancel any providers that we're still waiting for
-  for (SongInfoProvider* provider : waiting_for_[id]) {
+  for (SongInfoProvider* provider : waiting_for_.value(id)) {
     qLog(Info) << "Request timed out from info provider" << provider->name();
     provider->Cancel(id);
   }
-  waiting_for_.remove(id);
 
-  // Remove the timer
+  // Emit the results that we have already
+  FinishRequest(id);
+}
+
+void SongInfoFetcher::FinishRequest(int id) {
+  const Result result = results_.take(id);
+  const Request request = requests_.take(id);
+  waiting_for_.remove(id);
   delete timeout_timers_.take(id);
+
+  if (!request.prefetch_) {
+    emit ResultReady(id, result);
+    return;
+  }
+
+  // Nobody asked for this song in the end, its results are in the cache
+  for (const CollapsibleInfoPane::Data& data : result.info_) {
+    delete data.contents_;
+    delete data.content_object_;
+  }
+}
+
+QString SongInfoFetcher::CacheKey(const Song& metadata) const {
+  QString key = metadata.artist().toLower();
+  if (!cache_by_artist_) key += "\n" + metadata.title().toLower();
+  return key;
+}
+
+SongInfoFetcher::CachedSong SongInfoFetcher::CachedResults(
+    const QString& key) {
+  if (!cache_.contains(key)) return CachedSong();
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  CachedSong& song = cache_[key];
+  for (auto it = song.begin(); it != song.end();) {
+    if (it->expires_msec_ <= now) {
+      it = song.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return song;
+}
+
+void SongInfoFetcher::AddToCache(const QString& key,
+                                 SongInfoProvider* provider,
+                                 const ProviderResult& result) {
+  if (!cache_.contains(key)) {
+    cache_order_ << key;
+    if (cache_order_.count() > kMaxCachedSongs) {
+      cache_.remove(cache_order_.takeFirst());
+    }
+  }
+
+  CacheEntry& entry = cache_[key][provider];
+  entry.expires_msec_ = QDateTime::currentMSecsSinceEpoch() + kCacheDuration;
+  entry.result_ = result;
 }
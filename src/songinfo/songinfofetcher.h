@@ -20,6 +20,7 @@
 
 #include <QMap>
 #include <QObject>
+#include <QStringList>
 #include <QUrl>
 
 #include "collapsibleinfopane.h"
@@ -39,10 +40,21 @@ class SongInfoFetcher : public QObject {
   };
 
   static const int kDefaultTimeoutDuration = 25000;  // msec
+  static const int kCacheDuration;                    // msec
+  static const int kMaxCachedSongs;
 
   void AddProvider(SongInfoProvider* provider);
   int FetchInfo(const Song& metadata);
 
+  // Fetches info without emitting anything, just to fill the cache.  If
+  // FetchInfo is called for the same song while this is still going, it
+  // carries on from what this has already got.
+  void Prefetch(const Song& metadata);
+
+  // By default results are cached by artist and title.  Views that only show
+  // things about the artist set this so every song by them shares an entry.
+  void set_cache_by_artist(bool by_artist) { cache_by_artist_ = by_artist; }
+
   QList<SongInfoProvider*> providers() const { return providers_; }
 
  signals:
@@ -56,11 +68,52 @@ class SongInfoFetcher : public QObject {
   void Timeout(int id);
 
  private:
+  // What one provider gave for one song.  Only the html of each info is
+  // kept, the widgets aren't.
+  struct ProviderResult {
+    ProviderResult() : cacheable_(true) {}
+
+    bool cacheable_;
+    QList<QUrl> images_;
+    QList<CollapsibleInfoPane::Data> info_;
+  };
+
+  struct CacheEntry {
+    qint64 expires_msec_;
+    ProviderResult result_;
+  };
+  typedef QMap<SongInfoProvider*, CacheEntry> CachedSong;
+
+  struct Request {
+    QString key_;
+    bool prefetch_;
+    QMap<SongInfoProvider*, ProviderResult> results_;
+  };
+
+  QString CacheKey(const Song& metadata) const;
+  CachedSong CachedResults(const QString& key);
+  void AddToCache(const QString& key, SongInfoProvider* provider,
+                  const ProviderResult& result);
+
+  int StartRequest(const Song& metadata, bool prefetch);
+  void ReplayCached(int id, const QList<SongInfoProvider*>& providers);
+  void AddImage(int id, SongInfoProvider* provider, const QUrl& url);
+  void AddInfo(int id, SongInfoProvider* provider,
+               const CollapsibleInfoPane::Data& data);
+  void CancelLessRelevant(int id, SongInfoProvider* provider);
+  void ProviderDone(int id, SongInfoProvider* provider, bool from_cache);
+  void FinishRequest(int id);
+
   QList<SongInfoProvider*> providers_;
 
   QMap<int, Result> results_;
   QMap<int, QList<SongInfoProvider*>> waiting_for_;
   QMap<int, QTimer*> timeout_timers_;
+  QMap<int, Request> requests_;
+
+  bool cache_by_artist_;
+  QMap<QString, CachedSong> cache_;
+  QStringList cache_order_;
 
   int timeout_duration_;
 
@@ -35,6 +35,11 @@ class SongInfoProvider : public QObject {
 
   virtual QString name() const;
 
+  // Providers that race each other give the same kind of result, so once one
+  // of them has answered the fetcher cancels those less relevant than it.
+  virtual int relevance() const { return 0; }
+  virtual bool races() const { return false; }
+
   bool is_enabled() const { return enabled_; }
   void set_enabled(bool enabled) { enabled_ = enabled; }
 
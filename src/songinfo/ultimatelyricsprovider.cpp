@@ -32,9 +32,7 @@ const int UltimateLyricsProvider::kRedirectLimit = 5;
 UltimateLyricsProvider::UltimateLyricsProvider()
     : network_(new NetworkAccessManager(this)),
       timeouts_(new NetworkTimeouts(30000, this)),  // 30s
-      relevance_(0),
-      redirect_count_(0),
-      url_hop_(false) {}
+      relevance_(0) {}
 
 void UltimateLyricsProvider::FetchInfo(int id, const Song& metadata) {
   // Get the text codec
@@ -54,22 +52,44 @@ void UltimateLyricsProvider::FetchInfo(int id, const Song& metadata) {
   qLog(Debug) << "Fetching lyrics from" << url_text;
 
   // Fetch the URL, follow redirects
-  metadata_ = metadata;
-  redirect_count_ = 0;
+  Request& request = requests_[id];
+  request.metadata_ = metadata;
+  request.redirect_count_ = 0;
+  request.url_hop_ = false;
+  Get(id, url, url_text);
+}
+
+void UltimateLyricsProvider::Get(int id, const QUrl& url,
+                                 const QString& orig_url) {
   QNetworkReply* reply = network_->get(QNetworkRequest(url));
   connect(reply, &QNetworkReply::finished,
-          [=] { this->RequestFinished(reply, url_text, id); });
+          [=] { this->RequestFinished(reply, orig_url, id); });
   timeouts_->AddReply(reply);
+  requests_[id].reply_ = reply;
+}
+
+void UltimateLyricsProvider::Cancel(int id) {
+  if (!requests_.contains(id)) return;
+
+  // Taken out first so RequestFinished ignores the aborted reply.
+  QNetworkReply* reply = requests_.take(id).reply_;
+  reply->abort();
+}
+
+void UltimateLyricsProvider::Finish(int id) {
+  requests_.remove(id);
+  emit Finished(id);
 }
 
 void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
                                              const QString& orig_url, int id) {
   reply->deleteLater();
+  if (!requests_.contains(id)) return;
+  Request& request = requests_[id];
 
   if (reply->error() != QNetworkReply::NoError) {
     qLog(Debug) << "Reply error" << reply->errorString();
-    url_hop_ = false;
-    emit Finished(id);
+    Finish(id);
     return;
   }
 
@@ -77,11 +97,10 @@ void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
   QVariant redirect_target =
       reply->attribute(QNetworkRequest::RedirectionTargetAttribute);
   if (redirect_target.isValid()) {
-    if (redirect_count_ >= kRedirectLimit) {
+    if (request.redirect_count_ >= kRedirectLimit) {
       qLog(Debug) << "Too many redirects from" << orig_url << "to"
                   << reply->url().toString();
-      url_hop_ = false;
-      emit Finished(id);
+      Finish(id);
       return;
     }
 
@@ -92,11 +111,8 @@ void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
       target.setPath(path);
     }
 
-    redirect_count_++;
-    QNetworkReply* reply = network_->get(QNetworkRequest(target));
-    connect(reply, &QNetworkReply::finished,
-            [=] { this->RequestFinished(reply, orig_url, id); });
-    timeouts_->AddReply(reply);
+    request.redirect_count_++;
+    Get(id, target, orig_url);
     return;
   }
 
@@ -109,30 +125,26 @@ void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
   for (const QString& indicator : invalid_indicators_) {
     if (original_content.contains(indicator)) {
       qLog(Debug) << "Found invalid indicator" << indicator;
-      url_hop_ = false;
-      emit Finished(id);
+      Finish(id);
       return;
     }
   }
 
-  if (!url_hop_) {
+  if (!request.url_hop_) {
     // Apply extract rules
     for (const Rule& rule : extract_rules_) {
       // Modify the rule for this request's metadata
       Rule rule_copy(rule);
       for (Rule::iterator it = rule_copy.begin(); it != rule_copy.end(); ++it) {
-        ReplaceFields(metadata_, &it->first);
+        ReplaceFields(request.metadata_, &it->first);
       }
 
       QString content = original_content;
       if (ApplyExtractRule(rule_copy, &content)) {
-        url_hop_ = true;
+        request.url_hop_ = true;
         QUrl url(content);
         qLog(Debug) << "Next url hop: " << url;
-        QNetworkReply* reply = network_->get(QNetworkRequest(url));
-        connect(reply, &QNetworkReply::finished,
-                [=] { this->RequestFinished(reply, orig_url, id); });
-        timeouts_->AddReply(reply);
+        Get(id, url, orig_url);
         return;
       }
 
@@ -161,6 +173,7 @@ void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
       SongInfoTextView* editor = new SongInfoTextView;
       editor->SetHtml(lyrics);
       data.contents_ = editor;
+      data.html_ = lyrics;
     } else {
       UltimateLyricsLyric* editor = new UltimateLyricsLyric;
       editor->SetHtml(lyrics);
@@ -169,8 +182,7 @@ void UltimateLyricsProvider::RequestFinished(QNetworkReply* reply,
 
     emit InfoReady(id, data);
   }
-  url_hop_ = false;
-  emit Finished(id);
+  Finish(id);
 }
 
 bool UltimateLyricsProvider::ApplyExtractRule(const Rule& rule,
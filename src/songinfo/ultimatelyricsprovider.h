@@ -18,6 +18,7 @@
 #ifndef ULTIMATELYRICSPROVIDER_H
 #define ULTIMATELYRICSPROVIDER_H
 
+#include <QMap>
 #include <QObject>
 #include <QPair>
 #include <QStringList>
@@ -59,8 +60,10 @@ class UltimateLyricsProvider : public SongInfoProvider {
 
   QString name() const { return name_; }
   int relevance() const { return relevance_; }
+  bool races() const { return true; }
 
   void FetchInfo(int id, const Song& metadata);
+  void Cancel(int id);
 
  private slots:
   void RequestFinished(QNetworkReply* reply, const QString& orig_url, int id);
@@ -85,7 +88,17 @@ class UltimateLyricsProvider : public SongInfoProvider {
                     QString* text) const;
   void ReplaceFields(const Song& metadata, QString* text) const;
 
+  void Get(int id, const QUrl& url, const QString& orig_url);
+  void Finish(int id);
+
  private:
+  struct Request {
+    Song metadata_;
+    int redirect_count_;
+    bool url_hop_;
+    QNetworkReply* reply_;
+  };
+
   NetworkAccessManager* network_;
   NetworkTimeouts* timeouts_;
 
@@ -100,9 +113,7 @@ class UltimateLyricsProvider : public SongInfoProvider {
   QList<Rule> exclude_rules_;
   QStringList invalid_indicators_;
 
-  Song metadata_;
-  int redirect_count_;
-  bool url_hop_;
+  QMap<int, Request> requests_;
 };
 
 #endif  // ULTIMATELYRICSPROVIDER_H
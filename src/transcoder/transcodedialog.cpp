@@ -62,6 +62,11 @@ TranscodeDialog::TranscodeDialog(QWidget* parent)
 
   details_ui_->setupUi(details_dialog_);
   details_ui_->pipelines->setPipelineModel(transcoder_->model());
+
+  // Nothing needs the files in order here, so the big ones go first to keep
+  // every thread busy until the end.
+  transcoder_->set_job_order(Transcoder::Order_LargestFirst);
+  transcoder_->set_skip_unchanged(true);
   QPushButton* clear_button = details_ui_->buttonBox->addButton(
       tr("Clear"), QDialogButtonBox::ResetRole);
   connect(clear_button, SIGNAL(clicked()), details_ui_->log, SLOT(clear()));
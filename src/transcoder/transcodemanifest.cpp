@@ -0,0 +1,148 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "transcodemanifest.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+
+#include "core/logging.h"
+#include "core/utilities.h"
+
+namespace {
+
+const quint32 kMagic = 0x54434d46;  // "TCMF"
+const quint32 kVersion = 1;
+
+// Organise and the transcode dialog can save at the same time.
+QMutex sFileMutex;
+
+qint64 ModificationTime(const QFileInfo& info) {
+  return info.lastModified().toMSecsSinceEpoch();
+}
+
+}  // namespace
+
+QDataStream& operator<<(QDataStream& s,
+                        const TranscodeManifest::Entry& entry) {
+  s << entry.key_ << entry.size_ << entry.mtime_;
+  return s;
+}
+
+QDataStream& operator>>(QDataStream& s, TranscodeManifest::Entry& entry) {
+  s >> entry.key_ >> entry.size_ >> entry.mtime_;
+  return s;
+}
+
+TranscodeManifest::TranscodeManifest(const QString& filename)
+    : filename_(filename) {
+  QMutexLocker l(&sFileMutex);
+  entries_ = Load(filename_);
+}
+
+QString TranscodeManifest::DefaultFilename() {
+  return Utilities::GetConfigPath(Utilities::Path_CacheRoot) +
+         "/transcodemanifest";
+}
+
+TranscodeManifest::EntryMap TranscodeManifest::Load(const QString& filename) {
+  EntryMap ret;
+
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return ret;
+
+  QDataStream s(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  s >> magic >> version;
+  if (magic != kMagic || version != kVersion) {
+    qLog(Warning) << "Ignoring transcode manifest" << filename;
+    return ret;
+  }
+
+  s >> ret;
+  if (s.status() != QDataStream::Ok) {
+    qLog(Warning) << "Transcode manifest" << filename << "is corrupt";
+    ret.clear();
+  }
+  return ret;
+}
+
+bool TranscodeManifest::IsUpToDate(const QString& output,
+                                   const QByteArray& key) const {
+  EntryMap::const_iterator it = entries_.constFind(output);
+  if (it == entries_.constEnd() || it->key_ != key) return false;
+
+  QFileInfo info(output);
+  return info.exists() && info.size() == it->size_ &&
+         ModificationTime(info) == it->mtime_;
+}
+
+void TranscodeManifest::Record(const QString& output, const QByteArray& key) {
+  QFileInfo info(output);
+  if (!info.exists()) return;
+
+  Entry entry;
+  entry.key_ = key;
+  entry.size_ = info.size();
+  entry.mtime_ = ModificationTime(info);
+
+  entries_[output] = entry;
+  changed_[output] = entry;
+}
+
+bool TranscodeManifest::Save() {
+  if (changed_.isEmpty()) return true;
+
+  QMutexLocker l(&sFileMutex);
+
+  // Someone else might have saved since we loaded, so start from the file.
+  EntryMap entries = Load(filename_);
+  for (EntryMap::const_iterator it = changed_.constBegin();
+       it != changed_.constEnd(); ++it) {
+    entries[it.key()] = it.value();
+  }
+
+  // Forget files that have gone.
+  for (EntryMap::iterator it = entries.begin(); it != entries.end();) {
+    if (QFileInfo::exists(it.key())) {
+      ++it;
+    } else {
+      it = entries.erase(it);
+    }
+  }
+
+  QSaveFile file(filename_);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qLog(Warning) << "Could not write transcode manifest" << filename_;
+    return false;
+  }
+
+  QDataStream s(&file);
+  s << kMagic << kVersion << entries;
+  if (!file.commit()) {
+    qLog(Warning) << "Could not write transcode manifest" << filename_;
+    return false;
+  }
+
+  entries_ = entries;
+  changed_.clear();
+  return true;
+}
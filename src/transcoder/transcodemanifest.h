@@ -0,0 +1,68 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSCODER_TRANSCODEMANIFEST_H_
+#define TRANSCODER_TRANSCODEMANIFEST_H_
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+class QDataStream;
+
+// Remembers what each transcoded file was made from, so a file that's
+// already been transcoded from the same source with the same settings can
+// be skipped.  Sources are identified by Transcoder::JobKey.
+//
+// The manifest is read when it's created and written by Save, which keeps
+// anything another manifest saved to the same file in the meantime.
+class TranscodeManifest {
+ public:
+  explicit TranscodeManifest(const QString& filename = DefaultFilename());
+
+  static QString DefaultFilename();
+
+  // True if output exists and is the file that was recorded for key, it
+  // hasn't been changed or replaced since.
+  bool IsUpToDate(const QString& output, const QByteArray& key) const;
+
+  // Call once output has been written.
+  void Record(const QString& output, const QByteArray& key);
+
+  bool Save();
+
+ private:
+  struct Entry {
+    Entry() : size_(0), mtime_(0) {}
+
+    QByteArray key_;
+    qint64 size_;
+    qint64 mtime_;
+  };
+  typedef QMap<QString, Entry> EntryMap;
+
+  friend QDataStream& operator<<(QDataStream& s, const Entry& entry);
+  friend QDataStream& operator>>(QDataStream& s, Entry& entry);
+
+  static EntryMap Load(const QString& filename);
+
+  QString filename_;
+  EntryMap entries_;
+  EntryMap changed_;
+};
+
+#endif  // TRANSCODER_TRANSCODEMANIFEST_H_
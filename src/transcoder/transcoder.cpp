@@ -18,9 +18,12 @@
 #include "transcoder.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QSettings>
+#include <QStorageInfo>
 #include <QThread>
 #include <QtDebug>
 #include <algorithm>
@@ -29,6 +32,7 @@
 #include "core/logging.h"
 #include "core/signalchecker.h"
 #include "core/utilities.h"
+#include "transcodemanifest.h"
 
 using std::shared_ptr;
 
@@ -221,6 +225,9 @@ QString Transcoder::JobState::GetDisplayName() {
 Transcoder::Transcoder(QObject* parent, const QString& settings_postfix)
     : QObject(parent),
       max_threads_(QThread::idealThreadCount()),
+      job_order_(Order_Queued),
+      max_jobs_per_device_(0),
+      paused_(false),
       settings_postfix_(settings_postfix),
       model_(new GstPipelineModel(this)) {
   if (JobFinishedEvent::sEventType == -1)
@@ -238,6 +245,55 @@ Transcoder::Transcoder(QObject* parent, const QString& settings_postfix)
   }
 }
 
+Transcoder::~Transcoder() {
+  if (manifest_) manifest_->Save();
+}
+
+void Transcoder::set_skip_unchanged(bool skip) {
+  if (!skip) {
+    if (manifest_) manifest_->Save();
+    manifest_.reset();
+  } else if (!manifest_) {
+    manifest_.reset(new TranscodeManifest);
+  }
+}
+
+QByteArray Transcoder::JobKey(const QUrl& input,
+                              const TranscoderPreset& preset) const {
+  // Hashing the whole file would mean reading it all, so a file is known by
+  // its path, size and modification time.
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  if (input.isLocalFile()) {
+    QFileInfo info(input.toLocalFile());
+    hash.addData(info.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+  } else {
+    hash.addData(input.toEncoded());
+  }
+  hash.addData(preset.codec_mimetype_.toUtf8());
+  hash.addData(preset.muxer_mimetype_.toUtf8());
+
+  // And the encoder settings, so changing the quality makes new files.
+  QSettings s;
+  s.beginGroup("Transcoder");
+  const QStringList groups = s.childGroups();
+  s.endGroup();
+  for (const QString& group : groups) {
+    if (!settings_postfix_.isEmpty() && !group.endsWith(settings_postfix_)) {
+      continue;
+    }
+    s.beginGroup("Transcoder/" + group);
+    for (const QString& key : s.childKeys()) {
+      hash.addData(
+          (group + "/" + key + "=" + s.value(key).toString()).toUtf8());
+    }
+    s.endGroup();
+  }
+
+  return hash.result().toHex();
+}
+
 QList<TranscoderPreset> Transcoder::GetAllPresets() {
   QList<TranscoderPreset> ret;
   ret << PresetForFileType(Song::Type_Flac);
@@ -336,6 +392,17 @@ void Transcoder::AddJob(const QUrl& input, const TranscoderPreset& preset,
     job.output = UrlToLocalFileIfPossible(input).section('.', 0, -2) + '.' +
                  preset.extension_;
 
+  // The existing file is the one we'd make, so it's left alone rather than
+  // written again or next to it.
+  if (manifest_) {
+    job.key = JobKey(input, preset);
+    if (manifest_->IsUpToDate(job.output, job.key)) {
+      job.skip = true;
+      queued_jobs_ << job;
+      return;
+    }
+  }
+
   // Don't overwrite existing files if overwrite_existing is not set
   if (!overwrite_existing && QFile::exists(job.output)) {
     for (int i = 0;; ++i) {
@@ -350,20 +417,51 @@ void Transcoder::AddJob(const QUrl& input, const TranscoderPreset& preset,
     }
   }
 
+  if (input.isLocalFile()) job.size = QFileInfo(input.toLocalFile()).size();
+  job.device = DeviceForPath(job.output);
+
   queued_jobs_ << job;
 }
 
+QString Transcoder::DeviceForPath(const QString& path) {
+  // The output's directory might not exist yet.
+  QDir dir = QFileInfo(path).absoluteDir();
+  while (!dir.exists() && !dir.isRoot()) {
+    if (!dir.cdUp()) break;
+  }
+  return QStorageInfo(dir).rootPath();
+}
+
 void Transcoder::AddTemporaryJob(const QUrl& input,
                                  const TranscoderPreset& preset) {
   AddJob(input, preset, Utilities::GetTemporaryFileName());
 }
 
 void Transcoder::Start() {
+  // Skipped jobs are done straight away, they don't need a thread.
+  QList<Job> skipped;
+  for (QList<Job>::iterator it = queued_jobs_.begin();
+       it != queued_jobs_.end();) {
+    if (it->skip) {
+      skipped << *it;
+      it = queued_jobs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (const Job& job : skipped) {
+    emit LogLine(tr("Skipping %1, %2 is up to date")
+                     .arg(UrlToLocalFileIfPossible(job.input),
+                          QDir::toNativeSeparators(job.output)));
+    emit JobComplete(job.input, job.output, true);
+  }
+
   emit LogLine(tr("Transcoding %1 files using %2 threads")
                    .arg(queued_jobs_.count())
                    .arg(max_threads()));
 
   // Kick off worker threads.
+  if (paused_) return;
   forever {
     StartJobStatus status = MaybeStartNextJob();
     if (status == AllThreadsBusy || status == NoMoreJobs) break;
@@ -371,17 +469,32 @@ void Transcoder::Start() {
 }
 
 Transcoder::StartJobStatus Transcoder::MaybeStartNextJob() {
+  if (paused_) return AllThreadsBusy;
   if (current_jobs_.count() >= max_threads()) return AllThreadsBusy;
   if (queued_jobs_.isEmpty()) {
     if (current_jobs_.isEmpty()) {
+      if (manifest_) manifest_->Save();
+      for (auto it = preset_stats_.constBegin();
+           it != preset_stats_.constEnd(); ++it) {
+        if (it->busy_msec_ <= 0) continue;
+        emit LogLine(tr("%1: %2 seconds of audio per second")
+                         .arg(it.key())
+                         .arg(double(it->audio_nsec_) / 1e6 / it->busy_msec_,
+                              0, 'f', 1));
+      }
       emit AllJobsComplete();
     }
 
     return NoMoreJobs;
   }
 
-  Job job = queued_jobs_.takeFirst();
+  // Every job left might be waiting for a busy device.
+  const int index = NextJobIndex();
+  if (index == -1) return AllThreadsBusy;
+
+  Job job = queued_jobs_.takeAt(index);
   if (StartJob(job)) {
+    JobStarted(job);
     return StartedSuccessfully;
   }
 
@@ -389,6 +502,84 @@ Transcoder::StartJobStatus Transcoder::MaybeStartNextJob() {
   return FailedToStart;
 }
 
+int Transcoder::NextJobIndex() const {
+  QMap<QString, int> device_jobs;
+  for (const auto& state : current_jobs_) device_jobs[state->job_.device]++;
+
+  int best = -1;
+  for (int i = 0; i < queued_jobs_.count(); ++i) {
+    const Job& job = queued_jobs_[i];
+    if (max_jobs_per_device_ > 0 &&
+        device_jobs.value(job.device) >= max_jobs_per_device_) {
+      continue;
+    }
+
+    if (job_order_ == Order_Queued) return i;
+    if (best == -1 || job.size > queued_jobs_[best].size) best = i;
+  }
+  return best;
+}
+
+void Transcoder::JobStarted(const Job& job) {
+  PresetStats& stats = preset_stats_[job.preset.name_];
+  if (stats.running_++ == 0 && !paused_) stats.busy_since_.start();
+}
+
+void Transcoder::JobStopped(const Job& job, qint64 audio_nsec) {
+  PresetStats& stats = preset_stats_[job.preset.name_];
+  stats.audio_nsec_ += audio_nsec;
+  if (--stats.running_ == 0 && stats.busy_since_.isValid()) {
+    stats.busy_msec_ += stats.busy_since_.elapsed();
+    stats.busy_since_.invalidate();
+  }
+}
+
+QMap<QString, double> Transcoder::Throughput() const {
+  QMap<QString, double> ret;
+  for (auto it = preset_stats_.constBegin(); it != preset_stats_.constEnd();
+       ++it) {
+    qint64 busy_msec = it->busy_msec_;
+    if (it->busy_since_.isValid()) busy_msec += it->busy_since_.elapsed();
+    if (busy_msec > 0) {
+      ret[it.key()] = double(it->audio_nsec_) / 1e6 / busy_msec;
+    }
+  }
+  return ret;
+}
+
+void Transcoder::Pause() {
+  if (paused_) return;
+  paused_ = true;
+
+  for (const auto& state : current_jobs_) {
+    gst_element_set_state(state->Pipeline(), GST_STATE_PAUSED);
+  }
+
+  // Paused time doesn't count towards the throughput.
+  for (PresetStats& stats : preset_stats_) {
+    if (!stats.busy_since_.isValid()) continue;
+    stats.busy_msec_ += stats.busy_since_.elapsed();
+    stats.busy_since_.invalidate();
+  }
+}
+
+void Transcoder::Resume() {
+  if (!paused_) return;
+  paused_ = false;
+
+  for (const auto& state : current_jobs_) {
+    gst_element_set_state(state->Pipeline(), GST_STATE_PLAYING);
+  }
+  for (PresetStats& stats : preset_stats_) {
+    if (stats.running_ > 0) stats.busy_since_.start();
+  }
+
+  forever {
+    StartJobStatus status = MaybeStartNextJob();
+    if (status == AllThreadsBusy || status == NoMoreJobs) break;
+  }
+}
+
 void Transcoder::NewPadCallback(GstElement*, GstPad* pad, gpointer data) {
   JobState* state = reinterpret_cast<JobState*>(data);
   GstPad* const audiopad =
@@ -535,6 +726,16 @@ bool Transcoder::event(QEvent* e) {
     QUrl input = (*it)->job_.input;
     QString output = (*it)->job_.output;
 
+    gint64 duration = 0;
+    if (finished_event->success_) {
+      gst_element_query_duration((*it)->Pipeline(), GST_FORMAT_TIME,
+                                 &duration);
+    }
+    JobStopped((*it)->job_, qMax(gint64(0), duration));
+    if (manifest_ && finished_event->success_) {
+      manifest_->Record(output, (*it)->job_.key);
+    }
+
     // Remove event handlers from the gstreamer pipeline so they don't get
     // called after the pipeline is shutting down
     gst_bus_set_sync_handler(
@@ -581,9 +782,12 @@ void Transcoder::Cancel() {
     }
 
     // Remove the job, this destroys the GStreamer pipeline too
+    JobStopped(state->job_, 0);
     model_->RemovePipeline((*it)->id());
     it = current_jobs_.erase(it);
   }
+
+  paused_ = false;
 }
 
 void Transcoder::DumpGraph(int id) {
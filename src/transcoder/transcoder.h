@@ -20,7 +20,9 @@
 
 #include <gst/gst.h>
 
+#include <QElapsedTimer>
 #include <QEvent>
+#include <QMap>
 #include <QMetaType>
 #include <QObject>
 #include <QStringList>
@@ -31,6 +33,7 @@
 #include "engines/gstpipelinebase.h"
 
 struct SuitableElement;
+class TranscodeManifest;
 
 struct TranscoderPreset {
   TranscoderPreset() : type_(Song::Type_Unknown) {}
@@ -61,7 +64,17 @@ class Transcoder : public QObject {
     Codec_Wma = 7
   };
 
+  // The order queued jobs are started in.
+  enum JobOrder {
+    // First come first served, for callers that want the results in order.
+    Order_Queued = 0,
+    // The biggest input files first, so a long file doesn't start last and
+    // leave every other thread idle while it finishes.
+    Order_LargestFirst = 1,
+  };
+
   Transcoder(QObject* parent = nullptr, const QString& settings_postfix = "");
+  ~Transcoder();
 
   static TranscoderPreset PresetForFileType(Song::FileType type);
   static QList<TranscoderPreset> GetAllPresets();
@@ -71,6 +84,24 @@ class Transcoder : public QObject {
   int max_threads() const { return max_threads_; }
   void set_max_threads(int count) { max_threads_ = count; }
 
+  JobOrder job_order() const { return job_order_; }
+  void set_job_order(JobOrder order) { job_order_ = order; }
+
+  // How many jobs may write to the same filesystem at once, 0 for no limit
+  // other than max_threads.  Useful for slow devices that cope badly with
+  // several files being written at the same time.
+  int max_jobs_per_device() const { return max_jobs_per_device_; }
+  void set_max_jobs_per_device(int count) { max_jobs_per_device_ = count; }
+
+  // Keep a TranscodeManifest of the files written, and skip jobs whose output
+  // was already made from the same input with the same settings.  Skipped
+  // jobs are logged and complete successfully without being run.
+  void set_skip_unchanged(bool skip);
+
+  // Identifies what transcoding input with preset would make: the input's
+  // path, size and modification time, the preset and the encoder settings.
+  QByteArray JobKey(const QUrl& input, const TranscoderPreset& preset) const;
+
   void AddJob(const QUrl& input, const TranscoderPreset& preset,
               const QString& output = QString(),
               bool overwrite_existing = false);
@@ -85,6 +116,16 @@ class Transcoder : public QObject {
   void Cancel();
   void DumpGraph(int id);
 
+  // Pause holds the running pipelines where they are and starts no new jobs
+  // until Resume.
+  void Pause();
+  void Resume();
+  bool is_paused() const { return paused_; }
+
+  // Seconds of audio transcoded per second of wall time that jobs with each
+  // preset were running, by preset name.  Only finished jobs count.
+  QMap<QString, double> Throughput() const;
+
   static QString GetEncoderFactoryForMimeType(const QString& mime_type);
  signals:
   void JobComplete(const QUrl& input, const QString& output, bool success);
@@ -97,9 +138,20 @@ class Transcoder : public QObject {
  private:
   // The description of a file to transcode - lives in the main thread.
   struct Job {
+    Job() : size(0), skip(false) {}
+
     QUrl input;
     QString output;
     TranscoderPreset preset;
+
+    // Of the input file, if it's local
+    qint64 size;
+    // The root of the filesystem the output goes to
+    QString device;
+
+    // For the manifest
+    QByteArray key;
+    bool skip;
   };
 
   // State held by a job and shared across gstreamer callbacks - lives in the
@@ -141,8 +193,24 @@ class Transcoder : public QObject {
     AllThreadsBusy,
   };
 
+  // Time spent transcoding with a preset, while any of its jobs are running.
+  struct PresetStats {
+    PresetStats() : running_(0), audio_nsec_(0), busy_msec_(0) {}
+
+    int running_;
+    qint64 audio_nsec_;
+    qint64 busy_msec_;
+    QElapsedTimer busy_since_;
+  };
+
   StartJobStatus MaybeStartNextJob();
+  // The index in queued_jobs_ of the job to start next, or -1 if none can
+  // start now.
+  int NextJobIndex() const;
   bool StartJob(const Job& job);
+  void JobStarted(const Job& job);
+  void JobStopped(const Job& job, qint64 audio_nsec);
+  static QString DeviceForPath(const QString& path);
 
   GstElement* CreateElement(const QString& factory_name,
                             GstElement* bin = nullptr,
@@ -163,10 +231,17 @@ class Transcoder : public QObject {
   typedef QList<std::shared_ptr<JobState>> JobStateList;
 
   int max_threads_;
+  JobOrder job_order_;
+  int max_jobs_per_device_;
+  bool paused_;
   QList<Job> queued_jobs_;
   JobStateList current_jobs_;
   QString settings_postfix_;
   GstPipelineModel* model_;
+
+  QMap<QString, PresetStats> preset_stats_;
+
+  std::unique_ptr<TranscodeManifest> manifest_;
 };
 
 #endif  // TRANSCODER_H
@@ -29,6 +29,7 @@
 #include <QPainter>
 #include <QProgressBar>
 #include <QPushButton>
+#include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
 #include <QTimer>
@@ -75,11 +76,23 @@ AlbumCoverManager::AlbumCoverManager(Application* app,
       no_cover_icon_(IconLoader::Load("nocover", IconLoader::Other)),
       no_cover_image_(GenerateNoCoverImage(no_cover_icon_)),
       no_cover_item_icon_(QPixmap::fromImage(no_cover_image_)),
+      unloaded_cover_item_icon_(QPixmap::fromImage(no_cover_image_)),
       context_menu_(new QMenu(this)),
       progress_bar_(new QProgressBar(this)),
       abort_progress_(new QPushButton(this)),
       jobs_(0),
       library_backend_(library_backend) {
+  update_filter_timer_ = new QTimer(this);
+  update_filter_timer_->setSingleShot(true);
+  update_filter_timer_->setInterval(100);
+  connect(update_filter_timer_, SIGNAL(timeout()), SLOT(UpdateFilter()));
+
+  visible_covers_timer_ = new QTimer(this);
+  visible_covers_timer_->setSingleShot(true);
+  visible_covers_timer_->setInterval(50);
+  connect(visible_covers_timer_, SIGNAL(timeout()),
+          SLOT(LoadVisibleCovers()));
+
   ui_->setupUi(this);
   ui_->albums->set_cover_manager(this);
 
@@ -181,6 +194,10 @@ void AlbumCoverManager::Init() {
           SIGNAL(AlbumCoverFetched(quint64, QImage, CoverSearchStatistics)),
           SLOT(AlbumCoverFetched(quint64, QImage, CoverSearchStatistics)));
   connect(ui_->action_fetch, SIGNAL(triggered()), SLOT(FetchSingleCover()));
+  connect(ui_->albums->verticalScrollBar(), SIGNAL(valueChanged(int)),
+          visible_covers_timer_, SLOT(start()));
+  connect(ui_->albums->verticalScrollBar(), SIGNAL(rangeChanged(int, int)),
+          visible_covers_timer_, SLOT(start()));
   connect(ui_->albums, SIGNAL(doubleClicked(QModelIndex)),
           SLOT(AlbumDoubleClicked(QModelIndex)));
   connect(ui_->action_add_to_playlist, SIGNAL(triggered()),
@@ -237,6 +254,7 @@ void AlbumCoverManager::CancelRequests() {
   app_->album_cover_loader()->CancelTasks(
       QSet<quint64>::fromList(cover_loading_tasks_.keys()));
   cover_loading_tasks_.clear();
+  lazy_loading_tasks_.clear();
 
   cover_exporter_->Cancel();
 
@@ -340,13 +358,11 @@ void AlbumCoverManager::ArtistChanged(QListWidgetItem* current) {
       item->setToolTip(info.album_name);
     }
 
+    // The cover itself is loaded once the item comes near the viewport.
     if (!info.art_automatic.isEmpty() || !info.art_manual.isEmpty()) {
-      quint64 id = app_->album_cover_loader()->LoadImageAsync(
-          cover_loader_options_, info.art_automatic, info.art_manual,
-          info.first_url.toLocalFile());
+      item->setIcon(unloaded_cover_item_icon_);
       item->setData(Role_PathAutomatic, info.art_automatic);
       item->setData(Role_PathManual, info.art_manual);
-      cover_loading_tasks_[id] = item;
     }
   }
 
@@ -357,11 +373,19 @@ void AlbumCoverManager::CoverImageLoaded(quint64 id, const QImage& image) {
   if (!cover_loading_tasks_.contains(id)) return;
 
   QListWidgetItem* item = cover_loading_tasks_.take(id);
+  lazy_loading_tasks_.remove(item);
 
-  if (image.isNull()) return;
+  if (image.isNull()) {
+    // Don't keep trying to load it.
+    if (item->icon().cacheKey() == unloaded_cover_item_icon_.cacheKey()) {
+      item->setIcon(no_cover_item_icon_);
+      update_filter_timer_->start();
+    }
+    return;
+  }
 
   item->setIcon(QPixmap::fromImage(image));
-  UpdateFilter();
+  update_filter_timer_->start();
 }
 
 void AlbumCoverManager::UpdateFilter() {
@@ -394,6 +418,59 @@ void AlbumCoverManager::UpdateFilter() {
 
   ui_->total_albums->setText(QString::number(total_count));
   ui_->without_cover->setText(QString::number(without_cover));
+
+  // Different albums might be on screen now.
+  visible_covers_timer_->start();
+}
+
+void AlbumCoverManager::LoadVisibleCovers() {
+  // Covers are loaded a page ahead of the viewport either way, and unloaded
+  // again when they're more than two pages away.
+  const QRect viewport = ui_->albums->viewport()->rect();
+  const int page = viewport.height();
+  const QRect load_rect = viewport.adjusted(0, -page, 0, page);
+  const QRect keep_rect = viewport.adjusted(0, -page * 2, 0, page * 2);
+
+  QSet<quint64> cancel;
+  QList<quint64> visible;
+
+  for (int i = 0; i < ui_->albums->count(); ++i) {
+    QListWidgetItem* item = ui_->albums->item(i);
+    const QRect rect =
+        item->isHidden() ? QRect() : ui_->albums->visualItemRect(item);
+    const bool loading = lazy_loading_tasks_.contains(item);
+
+    if (rect.intersects(load_rect)) {
+      quint64 id = 0;
+      if (loading) {
+        id = lazy_loading_tasks_[item];
+      } else if (item->icon().cacheKey() ==
+                 unloaded_cover_item_icon_.cacheKey()) {
+        id = app_->album_cover_loader()->LoadImageAsync(
+            cover_loader_options_, item->data(Role_PathAutomatic).toString(),
+            item->data(Role_PathManual).toString(),
+            item->data(Role_FirstUrl).toUrl().toLocalFile());
+        cover_loading_tasks_[id] = item;
+        lazy_loading_tasks_[item] = id;
+      }
+
+      if (id && rect.intersects(viewport)) visible << id;
+    } else {
+      if (loading) {
+        const quint64 id = lazy_loading_tasks_.take(item);
+        cover_loading_tasks_.remove(id);
+        cancel << id;
+      }
+
+      if (!rect.intersects(keep_rect) && ItemHasCover(*item) &&
+          item->icon().cacheKey() != unloaded_cover_item_icon_.cacheKey()) {
+        item->setIcon(unloaded_cover_item_icon_);
+      }
+    }
+  }
+
+  if (!cancel.isEmpty()) app_->album_cover_loader()->CancelTasks(cancel);
+  if (!visible.isEmpty()) app_->album_cover_loader()->PrioritiseTasks(visible);
 }
 
 bool AlbumCoverManager::ShouldHide(const QListWidgetItem& item,
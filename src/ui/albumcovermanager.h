@@ -18,6 +18,7 @@
 #ifndef ALBUMCOVERMANAGER_H
 #define ALBUMCOVERMANAGER_H
 
+#include <QHash>
 #include <QIcon>
 #include <QMainWindow>
 #include <QModelIndex>
@@ -42,6 +43,7 @@ class QMenu;
 class QNetworkAccessManager;
 class QPushButton;
 class QProgressBar;
+class QTimer;
 
 class AlbumCoverManager : public QMainWindow {
   Q_OBJECT
@@ -80,6 +82,7 @@ class AlbumCoverManager : public QMainWindow {
   void ArtistChanged(QListWidgetItem* current);
   void CoverImageLoaded(quint64 id, const QImage& image);
   void UpdateFilter();
+  void LoadVisibleCovers();
   void FetchAlbumCovers();
   void ExportCovers();
   void AlbumCoverFetched(quint64 id, const QImage& image,
@@ -160,6 +163,15 @@ class AlbumCoverManager : public QMainWindow {
   AlbumCoverLoaderOptions cover_loader_options_;
   QMap<quint64, QListWidgetItem*> cover_loading_tasks_;
 
+  // The loads started by LoadVisibleCovers, which are cancelled again if the
+  // item scrolls away before its cover arrives.
+  QHash<QListWidgetItem*, quint64> lazy_loading_tasks_;
+
+  // Covers arrive one at a time, and the view can scroll a lot in between
+  // them.  These stop every change going through all the albums.
+  QTimer* update_filter_timer_;
+  QTimer* visible_covers_timer_;
+
   AlbumCoverFetcher* cover_fetcher_;
   QMap<quint64, QListWidgetItem*> cover_fetching_tasks_;
   CoverSearchStatistics fetch_statistics_;
@@ -177,6 +189,10 @@ class AlbumCoverManager : public QMainWindow {
   const QImage no_cover_image_;
   const QIcon no_cover_item_icon_;
 
+  // Looks the same as no_cover_item_icon_, but the album has a cover that
+  // isn't loaded, so it counts as having one.
+  const QIcon unloaded_cover_item_icon_;
+
   QMenu* context_menu_;
   QList<QListWidgetItem*> context_menu_items_;
 
@@ -156,6 +156,10 @@ void AppearanceSettingsPage::Load() {
   ui_->moodbar_calculate->setChecked(!s.value("calculate", true).toBool());
   ui_->moodbar_save->setChecked(
       s.value("save_alongside_originals", false).toBool());
+  ui_->moodbar_precompute->setChecked(s.value("precompute", false).toBool());
+  ui_->moodbar_precompute_jobs->setValue(s.value("precompute_jobs", 1).toInt());
+  ui_->moodbar_low_rate->setChecked(
+      s.value("low_rate_analysis", false).toBool());
   s.endGroup();
 
   InitMoodbarPreviews();
@@ -203,6 +207,9 @@ void AppearanceSettingsPage::Save() {
   s.setValue("show", ui_->moodbar_show->isChecked());
   s.setValue("style", ui_->moodbar_style->currentIndex());
   s.setValue("save_alongside_originals", ui_->moodbar_save->isChecked());
+  s.setValue("precompute", ui_->moodbar_precompute->isChecked());
+  s.setValue("precompute_jobs", ui_->moodbar_precompute_jobs->value());
+  s.setValue("low_rate_analysis", ui_->moodbar_low_rate->isChecked());
   s.endGroup();
 }
 
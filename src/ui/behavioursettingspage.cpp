@@ -21,6 +21,7 @@
 #include <QSystemTrayIcon>
 #include <algorithm>
 
+#include "core/memorybudget.h"
 #include "core/player.h"
 #include "mainwindow.h"
 #include "playlist/playlist.h"
@@ -181,6 +182,10 @@ void BehaviourSettingsPage::Load() {
   }
   s.endGroup();
 
+  s.beginGroup(MemoryBudget::kSettingsGroup);
+  ui_->memory_limit_mb->setValue(s.value("limit_mb", 0).toInt());
+  s.endGroup();
+
   s.beginGroup("General");
   QString name = language_map_.key(s.value("language").toString());
   if (name.isEmpty())
@@ -292,6 +297,10 @@ void BehaviourSettingsPage::Save() {
 
   s.endGroup();
 
+  s.beginGroup(MemoryBudget::kSettingsGroup);
+  s.setValue("limit_mb", ui_->memory_limit_mb->value());
+  s.endGroup();
+
   s.beginGroup("General");
   s.setValue("language", language_map_.contains(ui_->language->currentText())
                              ? language_map_[ui_->language->currentText()]
@@ -9,17 +9,33 @@
 #include "core/application.h"
 #include "core/database.h"
 #include "core/logging.h"
+#include "core/memorybudget.h"
+#include "core/metrics.h"
+#include "core/networkscheduler.h"
+#include "core/utilities.h"
+#include "playlist/playlist.h"
+#include "playlist/playlistmanager.h"
 
 Console::Console(Application* app, QWidget* parent)
     : QDialog(parent), app_(app) {
   ui_.setupUi(this);
   connect(ui_.database_run, SIGNAL(clicked()), SLOT(RunQuery()));
+  connect(ui_.database_slow_queries, SIGNAL(clicked()),
+          SLOT(ShowSlowQueries()));
+  connect(ui_.playlists_memory, SIGNAL(clicked()),
+          SLOT(ShowPlaylistMemory()));
+  connect(ui_.network_statistics, SIGNAL(clicked()),
+          SLOT(ShowNetworkStatistics()));
+  connect(ui_.metrics_show, SIGNAL(clicked()), SLOT(ShowMetrics()));
   connect(ui_.qt_dump_button, SIGNAL(clicked()), SLOT(Dump()));
 
   QFont font("Monospace");
   font.setStyleHint(QFont::TypeWriter);
 
   ui_.database_output->setFont(font);
+  ui_.playlists_output->setFont(font);
+  ui_.network_output->setFont(font);
+  ui_.metrics_output->setFont(font);
   ui_.database_query->setFont(font);
 
   QList<QObject*> objs = GetTopLevelObjects();
@@ -53,6 +69,132 @@ void Console::RunQuery() {
       ui_.database_output->verticalScrollBar()->maximum());
 }
 
+void Console::ShowSlowQueries() {
+  const QList<Database::SlowQuery> queries = app_->database()->SlowQueries();
+
+  ui_.database_output->append("<b>&gt; Slow queries</b>");
+
+  const int hits = app_->database()->statement_cache_hits();
+  const int lookups = hits + app_->database()->statement_cache_misses();
+  if (lookups > 0) {
+    ui_.database_output->append(
+        QString("Prepared statement cache: %1% of %2 queries hit")
+            .arg(hits * 100 / lookups)
+            .arg(lookups));
+  }
+  if (queries.isEmpty()) {
+    ui_.database_output->append("None");
+  }
+
+  for (const Database::SlowQuery& query : queries) {
+    ui_.database_output->append(
+        QString("<b>%1 ms</b> slowest, %2 ms average, %3 runs")
+            .arg(query.slowest_msec_)
+            .arg(query.total_msec_ / query.count_)
+            .arg(query.count_));
+    ui_.database_output->append(query.sql_.toHtmlEscaped());
+    ui_.database_output->append(
+        "<i>" + query.plan_.toHtmlEscaped().replace("\n", "<br>") + "</i>");
+  }
+
+  ui_.database_output->verticalScrollBar()->setValue(
+      ui_.database_output->verticalScrollBar()->maximum());
+}
+
+void Console::ShowPlaylistMemory() {
+  PlaylistManager* manager = app_->playlist_manager();
+
+  ui_.playlists_output->append("<b>&gt; Memory usage</b>");
+
+  // Songs shared between playlists count towards each of them, but only once
+  // towards the total.
+  QSet<const void*> all_seen;
+  qint64 total_bytes = 0;
+  int total_items = 0;
+
+  for (Playlist* playlist : manager->GetAllPlaylists()) {
+    QSet<const void*> seen;
+    qint64 bytes = 0;
+    for (int i = 0; i < playlist->rowCount(); ++i) {
+      const PlaylistItemPtr& item = playlist->item_at(i);
+      item->AddMemoryUsage(&seen, &bytes);
+      item->AddMemoryUsage(&all_seen, &total_bytes);
+    }
+    bytes += playlist->rowCount() * sizeof(PlaylistItem);
+    total_bytes += playlist->rowCount() * sizeof(PlaylistItem);
+    total_items += playlist->rowCount();
+
+    ui_.playlists_output->append(
+        QString("<b>%1</b>: %2 items, %3")
+            .arg(manager->GetPlaylistName(playlist->id()).toHtmlEscaped())
+            .arg(playlist->rowCount())
+            .arg(Utilities::PrettySize(bytes)));
+  }
+
+  ui_.playlists_output->append(QString("Total: %1 items, %2")
+                                   .arg(total_items)
+                                   .arg(Utilities::PrettySize(total_bytes)));
+
+  MemoryBudget* budget = app_->memory_budget();
+  ui_.playlists_output->append(
+      QString("<b>&gt; Caches</b>%1")
+          .arg(budget->under_pressure() ? ", shrunk to save memory" : ""));
+  for (const MemoryBudget::Usage& usage : budget->usage()) {
+    ui_.playlists_output->append(
+        QString("<b>%1</b>: %2 of %3")
+            .arg(usage.name_.toHtmlEscaped())
+            .arg(usage.used_bytes_ == -1
+                     ? QString("unknown")
+                     : Utilities::PrettySize(usage.used_bytes_))
+            .arg(Utilities::PrettySize(usage.limit_bytes_)));
+  }
+  ui_.playlists_output->verticalScrollBar()->setValue(
+      ui_.playlists_output->verticalScrollBar()->maximum());
+}
+
+void Console::ShowMetrics() {
+  ui_.metrics_output->append("<b>&gt; Metrics</b>");
+  const QString text = metrics::ToString();
+  if (text.isEmpty()) {
+    ui_.metrics_output->append("None");
+  }
+  for (const QString& line : text.split('\n', QString::SkipEmptyParts)) {
+    ui_.metrics_output->append(line.toHtmlEscaped());
+  }
+  ui_.metrics_output->verticalScrollBar()->setValue(
+      ui_.metrics_output->verticalScrollBar()->maximum());
+}
+
+void Console::ShowNetworkStatistics() {
+  const QList<NetworkScheduler::SubsystemStats> stats =
+      NetworkScheduler::Instance()->Statistics();
+
+  ui_.network_output->append("<b>&gt; Requests</b>");
+  if (stats.isEmpty()) {
+    ui_.network_output->append("None");
+  }
+
+  auto msec = [](qint64 usec) { return QString::number(usec / 1000); };
+
+  for (const NetworkScheduler::SubsystemStats& subsystem : stats) {
+    ui_.network_output->append(
+        QString("<b>%1</b>: %2 requests, %3% from the cache, %4 failed")
+            .arg(subsystem.name_.toHtmlEscaped())
+            .arg(subsystem.requests_)
+            .arg(subsystem.cache_hits_ * 100 / subsystem.requests_)
+            .arg(subsystem.errors_));
+    ui_.network_output->append(
+        QString("Last %1: %2 ms median, %3 ms 90th percentile, %4 ms max")
+            .arg(subsystem.latency_.count_)
+            .arg(msec(subsystem.latency_.median_usec_))
+            .arg(msec(subsystem.latency_.p90_usec_))
+            .arg(msec(subsystem.latency_.max_usec_)));
+  }
+
+  ui_.network_output->verticalScrollBar()->setValue(
+      ui_.network_output->verticalScrollBar()->maximum());
+}
+
 void Console::Dump() {
   QString item = ui_.qt_dump_box->currentData().toString();
   QObject* obj = FindTopLevelObject(item);
@@ -17,6 +17,13 @@ class Console : public QDialog {
  private slots:
   // Database
   void RunQuery();
+  void ShowSlowQueries();
+  // Playlists
+  void ShowPlaylistMemory();
+  // Network
+  void ShowNetworkStatistics();
+  // Metrics
+  void ShowMetrics();
   // Qt
   void Dump();
 
@@ -19,17 +19,19 @@
 
 #include <QDateTime>
 #include <QDir>
-#include <QFuture>
+#include <QFileInfo>
 #include <QLabel>
 #include <QMenu>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QShortcut>
-#include <QtConcurrentRun>
 #include <QtDebug>
 #include <limits>
+#include <memory>
 
 #include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/tagreaderclient.h"
 #include "core/utilities.h"
@@ -60,6 +62,9 @@ EditTagDialog::EditTagDialog(Application* app, QWidget* parent)
       cover_art_id_(0),
       cover_art_is_set_(false),
       results_dialog_(new TrackSelectionDialog(this)) {
+  // The full size image is what gets saved.
+  cover_options_.keep_original_image_ = true;
+
   QIcon nocover = IconLoader::Load("nocover", IconLoader::Other);
   cover_options_.default_output_image_ = AlbumCoverLoader::ScaleAndPad(
       cover_options_,
@@ -69,6 +74,7 @@ EditTagDialog::EditTagDialog(Application* app, QWidget* parent)
           SIGNAL(ImageLoaded(quint64, QImage, QImage)),
           SLOT(ArtLoaded(quint64, QImage, QImage)));
 
+  tag_fetcher_->set_database(app_->database());
   connect(tag_fetcher_, SIGNAL(ResultAvailable(Song, SongList)),
           results_dialog_, SLOT(FetchTagFinished(Song, SongList)),
           Qt::QueuedConnection);
@@ -226,47 +232,51 @@ bool EditTagDialog::SetLoading(const QString& message) {
   return true;
 }
 
-QList<EditTagDialog::Data> EditTagDialog::LoadData(
-    const SongList& songs) const {
-  QList<Data> ret;
-
-  for (const Song& song : songs) {
-    if (song.IsEditable()) {
-      // Try reloading the tags from file
-      Song copy(song);
-      TagReaderClient::Instance()->ReadFileBlocking(copy.url().toLocalFile(),
-                                                    &copy);
-
-      if (copy.is_valid()) {
-        copy.MergeUserSetData(song);
-        ret << Data(copy);
-      }
-    }
-  }
-
-  return ret;
-}
-
 void EditTagDialog::SetSongs(const SongList& s, const PlaylistItemList& items) {
   // Show the loading indicator
   if (!SetLoading(tr("Loading tracks") + "...")) return;
 
   data_.clear();
   playlist_items_ = items;
+  saved_songs_.clear();
   ui_->song_list->clear();
 
-  // Reload tags in the background
-  QFuture<QList<Data>> future =
-      QtConcurrent::run(this, &EditTagDialog::LoadData, s);
-  NewClosure(future, this,
-             SLOT(SetSongsFinished(QFuture<QList<EditTagDialog::Data>>)),
-             future);
+  SongList songs;
+  for (const Song& song : s) {
+    if (song.IsEditable()) songs << song;
+  }
+  if (songs.isEmpty()) {
+    SetSongsFinished(QList<Data>());
+    return;
+  }
+
+  // Reload the tags from the files, all at once
+  std::shared_ptr<SongList> loaded(new SongList(songs));
+  std::shared_ptr<int> remaining(new int(songs.count()));
+  for (int i = 0; i < songs.count(); ++i) {
+    TagReaderClient::Instance()->ReadFileAsync(
+        songs[i].url().toLocalFile(), songs[i], this,
+        [this, songs, loaded, remaining, i](const Song& song) {
+          (*loaded)[i] = song;
+          if (--*remaining > 0) return;
+
+          QList<Data> data;
+          for (int j = 0; j < songs.count(); ++j) {
+            Song copy = loaded->at(j);
+            if (copy.is_valid()) {
+              copy.MergeUserSetData(songs[j]);
+              data << Data(copy);
+            }
+          }
+          SetSongsFinished(data);
+        });
+  }
 }
 
-void EditTagDialog::SetSongsFinished(QFuture<QList<Data>> future) {
+void EditTagDialog::SetSongsFinished(const QList<Data>& data) {
   if (!SetLoading(QString())) return;
 
-  data_ = future.result();
+  data_ = data;
   if (data_.count() == 0) {
     // If there were no valid songs, disable everything
     ui_->song_list->setEnabled(false);
@@ -697,27 +707,84 @@ void EditTagDialog::ButtonClicked(QAbstractButton* button) {
   }
 }
 
-void EditTagDialog::SaveData(const QList<Data>& data) {
-  for (int i = 0; i < data.count(); ++i) {
-    const Data& ref = data[i];
-    if (ref.current_.IsMetadataEqual(ref.original_)) continue;
+void EditTagDialog::accept() {
+  // Show the loading indicator
+  if (!SetLoading(tr("Saving tracks") + "...")) return;
 
-    if (!TagReaderClient::Instance()->SaveFileBlocking(
-            ref.current_.url().toLocalFile(), ref.current_)) {
-      emit Error(tr("An error occurred writing metadata to '%1'")
-                     .arg(ref.current_.url().toLocalFile()));
+  SongList changed;
+  for (const Data& data : data_) {
+    if (!data.current_.IsMetadataEqual(data.original_)) {
+      changed << data.current_;
     }
   }
+  if (changed.isEmpty()) {
+    AcceptFinished();
+    return;
+  }
+
+  // Save all the tags at once, the tag reader's workers write them in
+  // parallel.
+  std::shared_ptr<int> remaining(new int(changed.count()));
+  std::shared_ptr<SongList> saved(new SongList);
+  for (const Song& song : changed) {
+    const QString filename = song.url().toLocalFile();
+    TagReaderClient::Instance()->SaveFileAsync(
+        filename, song, this,
+        [this, song, filename, remaining, saved](bool success) {
+          if (success) {
+            *saved << song;
+          } else {
+            emit Error(tr("An error occurred writing metadata to '%1'")
+                           .arg(filename));
+          }
+          if (--*remaining > 0) return;
+
+          // Writing the tags changed the files' modification times.  With
+          // the new ones in the library it skips these files when it notices
+          // they changed, instead of reading them all again.
+          const SongList songs = *saved;
+          QFuture<SongList> future = Executor::Io()->Run<SongList>([songs]() {
+            SongList ret;
+            for (Song song : songs) {
+              const QFileInfo info(song.url().toLocalFile());
+              song.set_mtime(info.lastModified().toTime_t());
+              song.set_filesize(info.size());
+              ret << song;
+            }
+            return ret;
+          });
+          NewClosure(future, this, SLOT(SaveFinished(QFuture<SongList>)),
+                     future);
+        });
+  }
 }
 
-void EditTagDialog::accept() {
-  // Show the loading indicator
-  if (!SetLoading(tr("Saving tracks") + "...")) return;
+void EditTagDialog::SaveFinished(QFuture<SongList> future) {
+  saved_songs_ = future.result();
+
+  // Only songs from our own library go back to it, songs from devices have
+  // IDs from the device's database.
+  QSet<QUrl> library_urls;
+  for (PlaylistItemPtr item : playlist_items_) {
+    if (item->IsLocalLibraryItem()) library_urls << item->Url();
+  }
+
+  // All in one transaction, and the playlists pick the changes up from the
+  // library.
+  SongList library_songs;
+  for (const Song& song : saved_songs_) {
+    if (song.is_library_song() &&
+        (playlist_items_.isEmpty() || library_urls.contains(song.url()))) {
+      library_songs << song;
+    }
+  }
+  if (!library_songs.isEmpty()) {
+    QMetaObject::invokeMethod(app_->library_backend(), "AddOrUpdateSongs",
+                              Qt::QueuedConnection,
+                              Q_ARG(SongList, library_songs));
+  }
 
-  // Save tags in the background
-  QFuture<void> future =
-      QtConcurrent::run(this, &EditTagDialog::SaveData, data_);
-  NewClosure(future, this, SLOT(AcceptFinished()));
+  AcceptFinished();
 }
 
 void EditTagDialog::AcceptFinished() {
@@ -19,6 +19,7 @@
 #define EDITTAGDIALOG_H
 
 #include <QDialog>
+#include <QFuture>
 #include <QModelIndexList>
 
 #include "config.h"
@@ -53,6 +54,9 @@ class EditTagDialog : public QDialog {
                 const PlaylistItemList& items = PlaylistItemList());
 
   PlaylistItemList playlist_items() const { return playlist_items_; }
+  // The songs whose files were written when the dialog was accepted.  The
+  // ones in the library have already been sent to it.
+  SongList saved_songs() const { return saved_songs_; }
 
   void accept();
 
@@ -83,7 +87,7 @@ class EditTagDialog : public QDialog {
   };
 
  private slots:
-  void SetSongsFinished(QFuture<QList<EditTagDialog::Data>> future);
+  void SaveFinished(QFuture<SongList> future);
   void AcceptFinished();
 
   void SelectionChanged();
@@ -137,10 +141,7 @@ class EditTagDialog : public QDialog {
 
   bool SetLoading(const QString& message);
   void SetSongListVisibility(bool visible);
-
-  // Called by QtConcurrentRun
-  QList<Data> LoadData(const SongList& songs) const;
-  void SaveData(const QList<Data>& data);
+  void SetSongsFinished(const QList<Data>& data);
 
  private:
   Ui_EditTagDialog* ui_;
@@ -151,6 +152,7 @@ class EditTagDialog : public QDialog {
   bool loading_;
 
   PlaylistItemList playlist_items_;
+  SongList saved_songs_;
   QList<Data> data_;
   QList<FieldData> fields_;
 
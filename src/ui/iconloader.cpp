@@ -19,19 +19,27 @@
 #include "iconloader.h"
 
 #include <QDir>
+#include <QDirIterator>
+#include <QMutexLocker>
 #include <QSettings>
 #include <QtDebug>
 
 #include "core/appearance.h"
 #include "core/logging.h"
+#include "core/trace.h"
 #include "core/utilities.h"
 
 QList<int> IconLoader::sizes_;
 QString IconLoader::custom_icon_path_;
 QList<QString> IconLoader::icon_sub_path_;
 bool IconLoader::use_sys_icons_;
+QMutex IconLoader::mutex_;
+QHash<QString, QSet<QString>> IconLoader::files_;
+QHash<QString, QIcon> IconLoader::icons_;
 
 void IconLoader::Init() {
+  TRACE_SCOPE("IconLoader::Init");
+
   sizes_.clear();
   sizes_ << 22 << 32 << 48;
   custom_icon_path_ = Utilities::GetConfigPath(Utilities::Path_Icons);
@@ -43,15 +51,48 @@ void IconLoader::Init() {
   QSettings settings;
   settings.beginGroup(Appearance::kSettingsGroup);
   use_sys_icons_ = settings.value("b_use_sys_icons", false).toBool();
+
+  QMutexLocker l(&mutex_);
+  files_.clear();
+  icons_.clear();
 }
 
 QIcon IconLoader::Load(const QString& name, const IconType& icontype) {
-  QIcon ret;
   // If the icon name is empty
   if (name.isEmpty()) {
     qLog(Warning) << "Icon name is null";
-    return ret;
+    return QIcon();
+  }
+
+  QMutexLocker l(&mutex_);
+  const QString key = QString::number(icontype) + "/" + name;
+  QHash<QString, QIcon>::const_iterator it = icons_.constFind(key);
+  if (it != icons_.constEnd()) return *it;
+
+  QIcon ret = LoadUncached(name, icontype);
+  icons_.insert(key, ret);
+  return ret;
+}
+
+const QSet<QString>& IconLoader::FilesIn(const QString& dir,
+                                         bool recursive) {
+  QHash<QString, QSet<QString>>::iterator it = files_.find(dir);
+  if (it != files_.end()) return *it;
+
+  QSet<QString> files;
+  QDirIterator dir_it(dir, QDir::Files,
+                      recursive ? QDirIterator::Subdirectories
+                                : QDirIterator::NoIteratorFlags);
+  while (dir_it.hasNext()) {
+    dir_it.next();
+    files.insert(dir_it.filePath().mid(dir.length() + 1));
   }
+  return *files_.insert(dir, files);
+}
+
+QIcon IconLoader::LoadUncached(const QString& name,
+                               const IconType& icontype) {
+  QIcon ret;
 
 #if QT_VERSION >= 0x040600
   if (use_sys_icons_) {
@@ -66,24 +107,28 @@ QIcon IconLoader::Load(const QString& name, const IconType& icontype) {
     case Provider: {
       const QString custom_icon_location =
           custom_icon_path_ + icon_sub_path_.at(icontype);
-      if (QDir(custom_icon_location).exists()) {
+      const QSet<QString>& custom_files = FilesIn(custom_icon_location, true);
+      if (!custom_files.isEmpty()) {
         // Try to load icons from the custom icon location initially
-        const QString locate(custom_icon_location + "/%1x%2/%3.png");
         for (int size : sizes_) {
-          QString filename_custom(locate.arg(size).arg(size).arg(name));
-
-          if (QFile::exists(filename_custom))
-            ret.addFile(filename_custom, QSize(size, size));
+          const QString file(
+              QString("%1x%2/%3.png").arg(size).arg(size).arg(name));
+          if (custom_files.contains(file)) {
+            ret.addFile(custom_icon_location + "/" + file, QSize(size, size));
+          }
         }
         if (!ret.isNull()) return ret;
       }
 
       // Otherwise use our fallback theme
-      const QString path(":" + icon_sub_path_.at(icontype) + "/%1x%2/%3.png");
+      const QString path(":" + icon_sub_path_.at(icontype));
+      const QSet<QString>& files = FilesIn(path, true);
       for (int size : sizes_) {
-        QString filename(path.arg(size).arg(size).arg(name));
-
-        if (QFile::exists(filename)) ret.addFile(filename, QSize(size, size));
+        const QString file(
+            QString("%1x%2/%3.png").arg(size).arg(size).arg(name));
+        if (files.contains(file)) {
+          ret.addFile(path + "/" + file, QSize(size, size));
+        }
       }
       break;
     }
@@ -93,20 +138,18 @@ QIcon IconLoader::Load(const QString& name, const IconType& icontype) {
       // lastfm icons location
       const QString custom_fm_other_icon_location =
           custom_icon_path_ + icon_sub_path_.at(icontype);
-      if (QDir(custom_fm_other_icon_location).exists()) {
-        // Try to load icons from the custom icon location initially
-        const QString locate_file(custom_fm_other_icon_location + "/" + name +
-                                  ".png");
-
-        if (QFile::exists(locate_file)) ret.addFile(locate_file);
-        if (!ret.isNull()) return ret;
+      // Try to load icons from the custom icon location initially
+      if (FilesIn(custom_fm_other_icon_location, false)
+              .contains(name + ".png")) {
+        ret.addFile(custom_fm_other_icon_location + "/" + name + ".png");
+        return ret;
       }
 
       // Otherwise use our fallback theme
-      const QString path_file(":" + icon_sub_path_.at(icontype) + "/" + name +
-                              ".png");
-
-      if (QFile::exists(path_file)) ret.addFile(path_file);
+      const QString path(":" + icon_sub_path_.at(icontype));
+      if (FilesIn(path, false).contains(name + ".png")) {
+        ret.addFile(path + "/" + name + ".png");
+      }
       break;
     }
 
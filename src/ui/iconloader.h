@@ -19,7 +19,10 @@
 #ifndef ICONLOADER_H
 #define ICONLOADER_H
 
+#include <QHash>
 #include <QIcon>
+#include <QMutex>
+#include <QSet>
 
 class IconLoader {
  public:
@@ -31,10 +34,21 @@ class IconLoader {
  private:
   IconLoader() {}
 
+  static QIcon LoadUncached(const QString& name, const IconType& icontype);
+
+  // The files in dir, and its subdirectories if recursive, relative to it.
+  // Each directory is only listed once, so icons that aren't there don't cost
+  // a lookup on disk each time.
+  static const QSet<QString>& FilesIn(const QString& dir, bool recursive);
+
   static QList<int> sizes_;
   static QString custom_icon_path_;
   static QList<QString> icon_sub_path_;
   static bool use_sys_icons_;
+
+  static QMutex mutex_;
+  static QHash<QString, QSet<QString>> files_;
+  static QHash<QString, QIcon> icons_;
 };
 
 #endif  // ICONLOADER_H
@@ -56,6 +56,7 @@
 #include "core/stylesheetloader.h"
 #include "core/taskmanager.h"
 #include "core/timeconstants.h"
+#include "core/trace.h"
 #include "core/utilities.h"
 #include "devices/devicemanager.h"
 #include "devices/devicestatefiltermodel.h"
@@ -72,12 +73,14 @@
 #include "internet/internetradio/savedradio.h"
 #include "internet/magnatune/magnatuneservice.h"
 #include "internet/podcasts/podcastservice.h"
+#include "library/duplicatefinder.h"
 #include "library/groupbydialog.h"
 #include "library/library.h"
 #include "library/librarybackend.h"
 #include "library/librarydirectorymodel.h"
 #include "library/libraryfilterwidget.h"
 #include "library/libraryviewcontainer.h"
+#include "library/replaygainscanner.h"
 #include "musicbrainz/tagfetcher.h"
 #include "networkremote/networkremote.h"
 #include "playlist/playlist.h"
@@ -96,6 +99,7 @@
 #endif
 #include "smartplaylists/generator.h"
 #include "smartplaylists/generatormimedata.h"
+#include "smartplaylists/similargenerator.h"
 #include "songinfo/artistinfoview.h"
 #include "songinfo/songinfoview.h"
 #include "songinfo/streamdiscoverer.h"
@@ -214,6 +218,12 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
         manager->SetPlaylistManager(app->playlist_manager());
         return manager;
       }),
+      duplicate_finder_([=]() {
+        DuplicateFinder* finder = new DuplicateFinder(app);
+        connect(finder, SIGNAL(Finished(SongList)), this,
+                SLOT(DuplicatesFound(SongList)));
+        return finder;
+      }),
       playlist_menu_(new QMenu(this)),
       playlist_add_to_another_(nullptr),
       playlistitem_actions_separator_(nullptr),
@@ -228,6 +238,7 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
       doubleclick_addmode_(AddBehaviour_Append),
       doubleclick_playmode_(PlayBehaviour_IfStopped),
       menu_playmode_(PlayBehaviour_IfStopped) {
+  TRACE_SCOPE("MainWindow::MainWindow");
   qLog(Debug) << "Starting";
 
   connect(app, SIGNAL(ErrorAdded(QString)), SLOT(ShowErrorDialog(QString)));
@@ -251,9 +262,11 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
   StyleHelper::setBaseColor(palette().color(QPalette::Highlight).darker());
 
   // Add global search providers
-  app_->global_search()->AddProvider(new LibrarySearchProvider(
+  LibrarySearchProvider* library_search_provider = new LibrarySearchProvider(
       app_->library_backend(), tr("Library"), "library",
-      IconLoader::Load("folder-sound", IconLoader::Base), true, app_, this));
+      IconLoader::Load("folder-sound", IconLoader::Base), true, app_, this);
+  library_search_provider->EnableIndex();
+  app_->global_search()->AddProvider(library_search_provider);
 
   connect(global_search_view_, SIGNAL(AddToPlaylist(QMimeData*)),
           SLOT(AddToPlaylist(QMimeData*)));
@@ -630,6 +643,8 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
 
   connect(ui_->track_slider, SIGNAL(ValueChangedSeconds(int)), app_->player(),
           SLOT(SeekTo(int)));
+  connect(ui_->track_slider, SIGNAL(ScrubbingChanged(bool)), app_->player(),
+          SLOT(SetScrubbing(bool)));
   connect(ui_->track_slider, SIGNAL(SeekForward()), app_->player(),
           SLOT(SeekForward()));
   connect(ui_->track_slider, SIGNAL(SeekBackward()), app_->player(),
@@ -717,6 +732,13 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
   search_for_album_ = playlist_menu_->addAction(
       IconLoader::Load("system-search", IconLoader::Base),
       tr("Search for album"), this, SLOT(SearchForAlbum()));
+  play_similar_ =
+      playlist_menu_->addAction(tr("Play similar songs"), this,
+                                SLOT(PlaySimilar()));
+#ifndef HAVE_MOODBAR
+  // The songs are compared by their moodbars.
+  play_similar_->setEnabled(false);
+#endif
   playlist_menu_->addSeparator();
   playlist_menu_->addAction(ui_->action_remove_from_playlist);
   playlist_undoredo_ = playlist_menu_->addSeparator();
@@ -896,6 +918,8 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
   // Lyrics
   ConnectInfoView(song_info_view_);
   ConnectInfoView(artist_info_view_);
+  connect(app_->playlist_manager(), SIGNAL(CurrentSongChanged(Song)),
+          SLOT(PrefetchSongInfo()));
 
   // Analyzer
   ui_->analyzer->SetEngine(app_->player()->engine());
@@ -929,8 +953,40 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
   connect(app_->moodbar_controller(),
           SIGNAL(CurrentMoodbarDataChanged(QByteArray)),
           ui_->track_slider->moodbar_style(), SLOT(SetMoodbarData(QByteArray)));
+
+  // Goes with the library scans in the tools menu
+  QAction* calculate_moodbars =
+      new QAction(tr("Calculate moodbars for the library"), this);
+  const QList<QAction*> tools_actions = ui_->menu_tools->actions();
+  const int full_scan_index =
+      tools_actions.indexOf(ui_->action_full_library_scan);
+  ui_->menu_tools->insertAction(tools_actions.value(full_scan_index + 1),
+                                calculate_moodbars);
+  // The precomputer is built in the warm-up after the window's shown, or
+  // here if it's wanted before then.
+  connect(calculate_moodbars, &QAction::triggered,
+          [this]() { app_->moodbar_precomputer()->Start(); });
 #endif
 
+  QAction* analyse_loudness =
+      new QAction(tr("Analyse the loudness of the library"), this);
+  const QList<QAction*> menu_actions = ui_->menu_tools->actions();
+  ui_->menu_tools->insertAction(
+      menu_actions.value(menu_actions.indexOf(ui_->action_full_library_scan) +
+                         1),
+      analyse_loudness);
+  connect(analyse_loudness, &QAction::triggered,
+          [this]() { app_->replaygain_scanner()->Start(); });
+
+  QAction* find_duplicates =
+      new QAction(tr("Find duplicate songs in the library"), this);
+  ui_->menu_tools->insertAction(
+      menu_actions.value(menu_actions.indexOf(ui_->action_full_library_scan) +
+                         1),
+      find_duplicates);
+  connect(find_duplicates, &QAction::triggered,
+          [this]() { duplicate_finder_->Start(); });
+
   // Now playing widget
   qLog(Debug) << "Creating now playing widget";
   ui_->now_playing->set_ideal_height(ui_->status_bar->sizeHint().height() +
@@ -1247,6 +1303,18 @@ void MainWindow::SongChanged(const Song& song) {
 #endif
 }
 
+void MainWindow::PrefetchSongInfo() {
+  // The info views have started on the current song by now, so the next one
+  // can be fetched while it's playing.
+  Playlist* playlist = app_->playlist_manager()->active();
+  const int next_row = playlist->next_row();
+  if (!playlist->has_item_at(next_row)) return;
+
+  const Song next_song = playlist->item_at(next_row)->Metadata();
+  song_info_view_->PrefetchSong(next_song);
+  artist_info_view_->PrefetchSong(next_song);
+}
+
 void MainWindow::TrackSkipped(PlaylistItemPtr item) {
   // If it was a library item then we have to increment its skipped count in
   // the database.
@@ -1883,6 +1951,12 @@ void MainWindow::PlaylistRightClick(const QPoint& global_pos,
 
   search_for_artist_->setVisible(all == 1);
   search_for_album_->setVisible(all == 1);
+  play_similar_->setVisible(
+      all == 1 && app_->playlist_manager()
+                      ->current()
+                      ->item_at(source_index.row())
+                      ->Metadata()
+                      .is_library_song());
 
   if (in_queue == 1 && not_in_queue == 0)
     playlist_queue_->setText(tr("Dequeue track"));
@@ -2039,14 +2113,28 @@ void MainWindow::EditTracks() {
 }
 
 void MainWindow::EditTagDialogAccepted() {
+  QSet<QUrl> saved_urls;
+  for (const Song& song : edit_tag_dialog_->saved_songs()) {
+    saved_urls << song.url();
+  }
+
+  // Only the files that were written need reading again, and library items
+  // are updated when the library gets the new tags.
+  PlaylistItemList items;
   for (PlaylistItemPtr item : edit_tag_dialog_->playlist_items()) {
-    item->Reload();
+    if (!item->IsLocalLibraryItem() && saved_urls.contains(item->Url())) {
+      items << item;
+    }
   }
+  if (items.isEmpty()) return;
 
-  // This is really lame but we don't know what rows have changed
-  ui_->playlist->view()->update();
+  Playlist* playlist = app_->playlist_manager()->current();
+  PlaylistItem::ReloadAllAsync(items, playlist, [this, items, playlist]() {
+    // This is really lame but we don't know what rows have changed
+    ui_->playlist->view()->update();
 
-  app_->playlist_manager()->current()->Save();
+    playlist->Save(items);
+  });
 }
 
 void MainWindow::DiscoverStreamDetails() {
@@ -2549,12 +2637,8 @@ void MainWindow::PlaylistOrganiseSelected(bool copy) {
 void MainWindow::PlaylistDelete() {
   // Note: copied from LibraryView::Delete
 
-  if (QMessageBox::warning(this, tr("Delete files"),
-                           tr("These files will be permanently deleted from "
-                              "disk, are you sure you want to continue?"),
-                           QMessageBox::Yes,
-                           QMessageBox::Cancel) != QMessageBox::Yes)
-    return;
+  bool use_trash = false;
+  if (!DeleteFiles::ConfirmDeleteFromDisk(this, &use_trash)) return;
 
   std::shared_ptr<MusicStorage> storage(new FilesystemMusicStorage("/"));
 
@@ -2587,6 +2671,9 @@ void MainWindow::PlaylistDelete() {
   ui_->playlist->view()->RemoveSelected(true);
 
   DeleteFiles* delete_files = new DeleteFiles(app_->task_manager(), storage);
+  delete_files->set_use_trash(use_trash);
+  connect(delete_files, SIGNAL(SongsDeleted(SongList)),
+          app_->library_backend(), SLOT(DeleteSongs(SongList)));
   connect(delete_files, SIGNAL(Finished(SongList)),
           SLOT(DeleteFinished(SongList)));
   delete_files->Start(selected_songs);
@@ -2696,6 +2783,17 @@ void MainWindow::SearchForArtist() {
   }
 }
 
+void MainWindow::PlaySimilar() {
+  PlaylistItemPtr item(
+      app_->playlist_manager()->current()->item_at(playlist_menu_index_.row()));
+  const Song song = item->Metadata();
+  if (!song.is_library_song()) return;
+
+  smart_playlists::GeneratorPtr generator(new smart_playlists::SimilarGenerator(
+      tr("Similar to %1").arg(song.PrettyTitle()), song));
+  app_->playlist_manager()->PlaySmartPlaylist(generator, true, false);
+}
+
 void MainWindow::SearchForAlbum() {
   PlaylistItemPtr item(
       app_->playlist_manager()->current()->item_at(playlist_menu_index_.row()));
@@ -2822,6 +2920,17 @@ void MainWindow::CheckFullRescanRevisions() {
 
 void MainWindow::ShowQueueManager() { queue_manager_->show(); }
 
+void MainWindow::DuplicatesFound(const SongList& duplicates) {
+  if (duplicates.isEmpty()) {
+    QMessageBox::information(this, tr("Find duplicate songs"),
+                             tr("No duplicate songs were found."));
+    return;
+  }
+
+  app_->playlist_manager()->New(tr("Duplicates"));
+  app_->playlist_manager()->current()->InsertLibraryItems(duplicates);
+}
+
 void MainWindow::ShowVisualisations() {
 #ifdef HAVE_VISUALISATIONS
   if (!visualisation_) {
@@ -2923,6 +3032,7 @@ void MainWindow::AutoCompleteTags() {
   // Create the tag fetching stuff if it hasn't been already
   if (!tag_fetcher_) {
     tag_fetcher_.reset(new TagFetcher);
+    tag_fetcher_->set_database(app_->database());
     track_selection_dialog_.reset(new TrackSelectionDialog);
     track_selection_dialog_->set_save_on_close(true);
 
@@ -2964,12 +3074,10 @@ void MainWindow::AutoCompleteTags() {
 }
 
 void MainWindow::AutoCompleteTagsAccepted() {
-  for (PlaylistItemPtr item : autocomplete_tag_items_) {
-    item->Reload();
-  }
-
-  // This is really lame but we don't know what rows have changed
-  ui_->playlist->view()->update();
+  PlaylistItem::ReloadAllAsync(autocomplete_tag_items_, this, [this]() {
+    // This is really lame but we don't know what rows have changed
+    ui_->playlist->view()->update();
+  });
 }
 
 QPixmap MainWindow::CreateOverlayedIcon(int position, int scrobble_point) {
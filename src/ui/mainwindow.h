@@ -49,6 +49,7 @@ class Database;
 class DeviceManager;
 class DeviceView;
 class DeviceViewContainer;
+class DuplicateFinder;
 class EditTagDialog;
 class LoveDialog;
 class Equalizer;
@@ -188,6 +189,7 @@ class MainWindow : public QMainWindow, public PlatformInterface {
 
   void SearchForArtist();
   void SearchForAlbum();
+  void PlaySimilar();
 
   void PlaylistCopyToLibrary();
   void PlaylistMoveToLibrary();
@@ -204,6 +206,7 @@ class MainWindow : public QMainWindow, public PlatformInterface {
   void StopAfterCurrent();
 
   void SongChanged(const Song& song);
+  void PrefetchSongInfo();
   void VolumeChanged(int volume);
 
   void CopyFilesToLibrary(const QList<QUrl>& urls);
@@ -266,6 +269,7 @@ class MainWindow : public QMainWindow, public PlatformInterface {
   void ShowTranscodeDialog();
   void ShowErrorDialog(const QString& message);
   void ShowQueueManager();
+  void DuplicatesFound(const SongList& duplicates);
   void ShowVisualisations();
   SettingsDialog* CreateSettingsDialog();
   EditTagDialog* CreateEditTagDialog();
@@ -347,6 +351,7 @@ class MainWindow : public QMainWindow, public PlatformInterface {
   Lazy<ErrorDialog> error_dialog_;
   Lazy<OrganiseDialog> organise_dialog_;
   Lazy<QueueManager> queue_manager_;
+  Lazy<DuplicateFinder> duplicate_finder_;
 
   std::unique_ptr<TagFetcher> tag_fetcher_;
   std::unique_ptr<TrackSelectionDialog> track_selection_dialog_;
@@ -385,6 +390,7 @@ class MainWindow : public QMainWindow, public PlatformInterface {
 
   QAction* search_for_artist_;
   QAction* search_for_album_;
+  QAction* play_similar_;
 
   QSortFilterProxyModel* library_sort_model_;
 
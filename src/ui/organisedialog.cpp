@@ -243,10 +243,13 @@ void OrganiseDialog::UpdatePreviews() {
   ui_->preview_group->setVisible(has_local_destination);
   ui_->naming_group->setVisible(has_local_destination);
   if (has_local_destination) {
+    QStringList filenames;
+    filenames.reserve(new_songs_info_.count());
     for (const Organise::NewSongInfo& song_info : new_songs_info_) {
       QString filename = storage->LocalPath() + "/" + song_info.new_filename_;
-      ui_->preview->addItem(QDir::toNativeSeparators(filename));
+      filenames << QDir::toNativeSeparators(filename);
     }
+    ui_->preview->addItems(filenames);
   }
 
   if (!resized_by_user_) {
@@ -316,8 +319,8 @@ void OrganiseDialog::accept() {
           SLOT(OrganiseFinished(QStringList)));
   connect(organise, SIGNAL(FileCopied(int)), this, SIGNAL(FileCopied(int)));
   if (backend_ != nullptr) {
-    connect(organise, SIGNAL(SongPathChanged(const Song&, const QFileInfo&)),
-            backend_, SLOT(SongPathChanged(const Song&, const QFileInfo&)));
+    connect(organise, SIGNAL(SongPathsChanged(SongList)), backend_,
+            SLOT(AddOrUpdateSongs(SongList)));
   }
   organise->Start();
 
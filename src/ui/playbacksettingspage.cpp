@@ -44,6 +44,8 @@ PlaybackSettingsPage::PlaybackSettingsPage(SettingsDialog* dialog)
   ui_->replaygain_preamp_label->setMinimumWidth(
       QFontMetrics(ui_->replaygain_preamp_label->font()).width("-WW.W dB"));
   RgPreampChanged(ui_->replaygain_preamp->value());
+  connect(ui_->replaygain_analyse, SIGNAL(toggled(bool)),
+          ui_->replaygain_write_tags, SLOT(setEnabled(bool)));
 
   ui_->sample_rate->setItemData(0, GstEngine::kAutoSampleRate);
   ui_->sample_rate->setItemData(1, 44100);
@@ -118,14 +120,22 @@ void PlaybackSettingsPage::Load() {
                                    150);
   ui_->replaygain_compression->setChecked(
       s.value("rgcompression", true).toBool());
+  ui_->replaygain_analyse->setChecked(s.value("rganalyse", false).toBool());
+  ui_->replaygain_write_tags->setChecked(
+      s.value("rgwritetags", false).toBool());
   ui_->buffer_duration->setValue(s.value("bufferduration", 4000).toInt());
   ui_->mono_playback->setChecked(s.value("monoplayback", false).toBool());
+  ui_->reuse_pipeline->setChecked(s.value("reusepipeline", false).toBool());
   ui_->sample_rate->setCurrentIndex(ui_->sample_rate->findData(
       s.value("samplerate", GstEngine::kAutoSampleRate).toInt()));
   ui_->output_format->setCurrentIndex(ui_->output_format->findData(
       s.value(GstEngine::kSettingFormat, GstEngine::kOutFormatDetect)
           .toString()));
   ui_->buffer_min_fill->setValue(s.value("bufferminfill", 33).toInt());
+  ui_->adaptive_buffering->setChecked(
+      s.value("adaptivebuffering", false).toBool());
+  ui_->mix_background_streams->setChecked(
+      s.value("mixbackgroundstreams", false).toBool());
   s.endGroup();
 }
 
@@ -157,8 +167,11 @@ void PlaybackSettingsPage::Save() {
   s.setValue("rgmode", ui_->replaygain_mode->currentIndex());
   s.setValue("rgpreamp", float(ui_->replaygain_preamp->value()) / 10 - 15);
   s.setValue("rgcompression", ui_->replaygain_compression->isChecked());
+  s.setValue("rganalyse", ui_->replaygain_analyse->isChecked());
+  s.setValue("rgwritetags", ui_->replaygain_write_tags->isChecked());
   s.setValue("bufferduration", ui_->buffer_duration->value());
   s.setValue("monoplayback", ui_->mono_playback->isChecked());
+  s.setValue("reusepipeline", ui_->reuse_pipeline->isChecked());
   s.setValue(
       "samplerate",
       ui_->sample_rate->itemData(ui_->sample_rate->currentIndex()).toInt());
@@ -166,6 +179,8 @@ void PlaybackSettingsPage::Save() {
              ui_->output_format->itemData(ui_->output_format->currentIndex())
                  .toString());
   s.setValue("bufferminfill", ui_->buffer_min_fill->value());
+  s.setValue("adaptivebuffering", ui_->adaptive_buffering->isChecked());
+  s.setValue("mixbackgroundstreams", ui_->mix_background_streams->isChecked());
   s.endGroup();
 }
 
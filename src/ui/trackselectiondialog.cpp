@@ -22,8 +22,8 @@
 #include <QShortcut>
 #include <QTreeWidget>
 #include <QUrl>
-#include <QtConcurrentRun>
 #include <QtDebug>
+#include <memory>
 
 #include "core/tagreaderclient.h"
 #include "ui/iconloader.h"
@@ -228,6 +228,7 @@ void TrackSelectionDialog::SetLoading(const QString& message) {
 }
 
 void TrackSelectionDialog::SaveData(const QList<Data>& data) {
+  SongList songs;
   for (int i = 0; i < data.count(); ++i) {
     const Data& ref = data[i];
     if (ref.pending_ || ref.results_.isEmpty() || ref.selected_result_ == -1)
@@ -241,23 +242,33 @@ void TrackSelectionDialog::SaveData(const QList<Data>& data) {
     copy.set_album(new_metadata.album());
     copy.set_track(new_metadata.track());
     copy.set_year(new_metadata.year());
+    songs << copy;
+  }
 
-    if (!TagReaderClient::Instance()->SaveFileBlocking(copy.url().toLocalFile(),
-                                                       copy)) {
-      emit Error(tr("Failed to write new auto-tags to '%1'")
-                     .arg(copy.url().toLocalFile()));
-    }
+  if (songs.isEmpty()) {
+    AcceptFinished();
+    return;
+  }
+
+  // Save all the tags at once, AcceptFinished is called after the last one.
+  std::shared_ptr<int> remaining(new int(songs.count()));
+  for (const Song& song : songs) {
+    const QString filename = song.url().toLocalFile();
+    TagReaderClient::Instance()->SaveFileAsync(
+        filename, song, this, [this, filename, remaining](bool success) {
+          if (!success) {
+            emit Error(tr("Failed to write new auto-tags to '%1'")
+                           .arg(filename));
+          }
+          if (--*remaining == 0) AcceptFinished();
+        });
   }
 }
 
 void TrackSelectionDialog::accept() {
   if (save_on_close_) {
     SetLoading(tr("Saving tracks") + "...");
-
-    // Save tags in the background
-    QFuture<void> future =
-        QtConcurrent::run(this, &TrackSelectionDialog::SaveData, data_);
-    NewClosure(future, this, SLOT(AcceptFinished()));
+    SaveData(data_);
     return;
   }
 
@@ -75,6 +75,7 @@ class TrackSelectionDialog : public QDialog {
   void AddSong(const Song& song, int result_index, QTreeWidget* parent) const;
 
   void SetLoading(const QString& message);
+  // Calls AcceptFinished once all the files have been written.
   void SaveData(const QList<Data>& data);
 
  private:
@@ -0,0 +1,346 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "projectmrenderer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QThread>
+#include <QTimerEvent>
+#include <algorithm>
+
+#include "core/logging.h"
+
+#ifdef USE_SYSTEM_PROJECTM
+#include <libprojectM/projectM.hpp>
+#else
+#include "projectM.hpp"
+#endif
+
+#ifdef Q_OS_MAC
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+const int ProjectMRenderer::kMinTextureSize = 128;
+
+namespace {
+
+// How many frames in a row have to miss the frame interval before the
+// texture size is halved.
+const int kSlowFramesBeforeDrop = 10;
+
+// How many frames in a row have to take less than half the frame interval
+// before the texture size is doubled again.  Changing the size rebuilds
+// projectM's renderer, so this is long enough not to flip back and forth.
+const int kFastFramesBeforeRaise = 300;
+
+// At most this many samples per channel are kept waiting for the next frame.
+const int kMaxPendingSamples = 44100;
+
+// projectM takes a short for the number of samples.
+const int kMaxPCMChunk = 4096;
+
+}  // namespace
+
+ProjectMRenderer::ProjectMRenderer(QOpenGLContext* share_context,
+                                   QMutex* projectm_mutex)
+    : thread_(new QThread),
+      context_(new QOpenGLContext),
+      surface_(new QOffscreenSurface),
+      projectm_mutex_(projectm_mutex),
+      projectm_(nullptr),
+      delete_projectm_(nullptr),
+      projectm_texture_(0),
+      interval_msec_(0),
+      view_width_(0),
+      view_height_(0),
+      governed_texture_size_(0),
+      slow_frames_(0),
+      fast_frames_(0),
+      fps_(35),
+      requested_texture_size_(512),
+      requested_view_size_(0),
+      occluded_(0),
+      current_texture_size_(0),
+      front_texture_(0) {
+  // The context and the surface have to be made in the GUI thread, the
+  // context is then moved over to the render thread with us.
+  context_->setFormat(share_context->format());
+  context_->setShareContext(share_context);
+  context_->create();
+
+  surface_->setFormat(context_->format());
+  surface_->create();
+
+  thread_->setObjectName("projectM renderer");
+  moveToThread(thread_.get());
+  context_->moveToThread(thread_.get());
+}
+
+ProjectMRenderer::~ProjectMRenderer() {
+  thread_->quit();
+  thread_->wait();
+  delete context_;
+}
+
+projectM* ProjectMRenderer::Start(std::function<projectM*()> create) {
+  create_ = create;
+  thread_->start();
+  QMetaObject::invokeMethod(this, "Create", Qt::BlockingQueuedConnection);
+  return projectm_;
+}
+
+void ProjectMRenderer::Stop(projectM* projectm) {
+  delete_projectm_ = projectm;
+  QMetaObject::invokeMethod(this, "Destroy", Qt::BlockingQueuedConnection);
+}
+
+void ProjectMRenderer::SetFps(int fps) { fps_.store(qMax(1, fps)); }
+
+void ProjectMRenderer::SetTextureSize(int size) {
+  requested_texture_size_.store(size);
+}
+
+void ProjectMRenderer::SetViewSize(int width, int height) {
+  requested_view_size_.store((qBound(0, width, 0xffff) << 16) |
+                             qBound(0, height, 0xffff));
+}
+
+void ProjectMRenderer::SetOccluded(bool occluded) {
+  occluded_.store(occluded ? 1 : 0);
+}
+
+void ProjectMRenderer::AddPCM(const short* data, int samples_per_channel) {
+  QMutexLocker l(&pcm_mutex_);
+  pcm_.insert(pcm_.end(), data, data + samples_per_channel * 2);
+
+  // If frames are slow, only the latest samples matter.
+  const int excess = pcm_.size() - kMaxPendingSamples * 2;
+  if (excess > 0) pcm_.erase(pcm_.begin(), pcm_.begin() + excess);
+}
+
+void ProjectMRenderer::Create() {
+  context_->makeCurrent(surface_.get());
+
+  projectm_ = create_();
+  create_ = nullptr;
+
+  // initRenderToTexture makes projectM draw its output into a texture of its
+  // own instead of the window, which only works with framebuffer objects.
+  projectm_texture_ = projectm_->initRenderToTexture();
+  if (projectm_texture_ == static_cast<unsigned int>(-1)) {
+    qLog(Warning) << "projectM can't render to a texture";
+    delete projectm_;
+    projectm_ = nullptr;
+    context_->doneCurrent();
+    return;
+  }
+
+  governed_texture_size_ = requested_texture_size_.load();
+  ApplyTextureSize(projectm_->settings().textureSize);
+
+  interval_msec_ = 1000 / fps_.load();
+  timer_.start(interval_msec_, this);
+}
+
+void ProjectMRenderer::Destroy() {
+  timer_.stop();
+
+  context_->makeCurrent(surface_.get());
+  {
+    QMutexLocker l(&frame_mutex_);
+    front_texture_ = 0;
+  }
+  front_.reset();
+  back_.reset();
+  delete delete_projectm_;
+  delete_projectm_ = nullptr;
+  projectm_ = nullptr;
+  context_->doneCurrent();
+
+  context_->moveToThread(QCoreApplication::instance()->thread());
+}
+
+void ProjectMRenderer::timerEvent(QTimerEvent* e) {
+  if (e->timerId() == timer_.timerId()) RenderFrame();
+}
+
+void ProjectMRenderer::RenderFrame() {
+  if (!projectm_) return;
+
+  QElapsedTimer frame_time;
+  frame_time.start();
+
+  context_->makeCurrent(surface_.get());
+
+  {
+    QMutexLocker l(projectm_mutex_);
+
+    const int desired =
+        occluded_.load() ? kMinTextureSize
+                         : qMin(requested_texture_size_.load(),
+                                governed_texture_size_);
+    if (desired != current_texture_size_.load()) ApplyTextureSize(desired);
+
+    const int view_size = requested_view_size_.load();
+    const int view_width = view_size >> 16;
+    const int view_height = view_size & 0xffff;
+    if (view_width > 0 && view_height > 0 &&
+        (view_width != view_width_ || view_height != view_height_)) {
+      view_width_ = view_width;
+      view_height_ = view_height;
+      projectm_->projectM_resetGL(view_width_, view_height_);
+    }
+
+    FeedPCM();
+    projectm_->renderFrame();
+  }
+
+  // Copy the frame into the back buffer so projectM can carry on with the
+  // next one while the GUI draws this one.
+  const int size = current_texture_size_.load();
+  back_->bind();
+  glViewport(0, 0, size, size);
+  DrawTexture(projectm_texture_);
+  back_->release();
+
+  // The GUI's context only sees the finished texture once we're done with it.
+  glFinish();
+
+  {
+    QMutexLocker l(&frame_mutex_);
+    std::swap(front_, back_);
+    front_texture_ = front_->texture();
+  }
+
+  const int interval_msec = 1000 / fps_.load();
+  if (interval_msec != interval_msec_) {
+    interval_msec_ = interval_msec;
+    timer_.start(interval_msec_, this);
+  }
+
+  Govern(frame_time.elapsed(), interval_msec_);
+}
+
+void ProjectMRenderer::ApplyTextureSize(int size) {
+  // changeTextureSize makes a new renderer, which forgets it was rendering
+  // to a texture.
+  if (size != projectm_->settings().textureSize) {
+    projectm_->changeTextureSize(size);
+    if (view_width_ > 0) {
+      projectm_->projectM_resetGL(view_width_, view_height_);
+    }
+    projectm_texture_ = projectm_->initRenderToTexture();
+  }
+
+  {
+    QMutexLocker l(&frame_mutex_);
+    front_texture_ = 0;
+  }
+  front_.reset(new QOpenGLFramebufferObject(size, size));
+  back_.reset(new QOpenGLFramebufferObject(size, size));
+  current_texture_size_.store(size);
+  slow_frames_ = 0;
+  fast_frames_ = 0;
+
+  qLog(Debug) << "Rendering projectM at" << size << "x" << size;
+}
+
+void ProjectMRenderer::FeedPCM() {
+  std::vector<short> pcm;
+  {
+    QMutexLocker l(&pcm_mutex_);
+    pcm.swap(pcm_);
+  }
+
+  const int samples_per_channel = pcm.size() / 2;
+  for (int i = 0; i < samples_per_channel; i += kMaxPCMChunk) {
+    const int count = qMin(kMaxPCMChunk, samples_per_channel - i);
+    projectm_->pcm()->addPCM16Data(pcm.data() + i * 2, count);
+  }
+}
+
+void ProjectMRenderer::Govern(qint64 frame_msec, int interval_msec) {
+  if (frame_msec > interval_msec) {
+    fast_frames_ = 0;
+    if (++slow_frames_ >= kSlowFramesBeforeDrop &&
+        governed_texture_size_ > kMinTextureSize) {
+      governed_texture_size_ /= 2;
+      slow_frames_ = 0;
+      qLog(Debug) << "projectM frames are taking" << frame_msec
+                  << "ms, more than the" << interval_msec << "ms we have";
+    }
+  } else if (frame_msec * 2 < interval_msec) {
+    slow_frames_ = 0;
+    if (++fast_frames_ >= kFastFramesBeforeRaise &&
+        governed_texture_size_ < requested_texture_size_.load()) {
+      governed_texture_size_ *= 2;
+      fast_frames_ = 0;
+    }
+  } else {
+    slow_frames_ = 0;
+    fast_frames_ = 0;
+  }
+}
+
+void ProjectMRenderer::DrawLatestFrame(int width, int height) {
+  QMutexLocker l(&frame_mutex_);
+  if (front_texture_ == 0) return;
+
+  glViewport(0, 0, width, height);
+  DrawTexture(front_texture_);
+}
+
+void ProjectMRenderer::DrawTexture(unsigned int texture) {
+  glPushAttrib(GL_ALL_ATTRIB_BITS);
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0, 1, 0, 1, -1, 1);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glColor4f(1, 1, 1, 1);
+
+  glBegin(GL_QUADS);
+  glTexCoord2f(0, 0);
+  glVertex2f(0, 0);
+  glTexCoord2f(1, 0);
+  glVertex2f(1, 0);
+  glTexCoord2f(1, 1);
+  glVertex2f(1, 1);
+  glTexCoord2f(0, 1);
+  glVertex2f(0, 1);
+  glEnd();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glMatrixMode(GL_MODELVIEW);
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glPopAttrib();
+}
@@ -0,0 +1,130 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROJECTMRENDERER_H
+#define PROJECTMRENDERER_H
+
+#include <QAtomicInt>
+#include <QBasicTimer>
+#include <QMutex>
+#include <QObject>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class projectM;
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+class QThread;
+
+// Renders projectM into an offscreen texture in a thread of its own, so heavy
+// presets don't hold up the GUI.  The scene only draws the latest finished
+// frame.
+//
+// projectM isn't thread safe, so anything else that uses it has to hold the
+// mutex given to the constructor.  Rendering holds it for a whole frame.
+//
+// A governor keeps to the frame rate: if frames keep taking longer than the
+// frame interval, or the window can't be seen, the texture size is dropped,
+// and it's raised again once there's plenty of time to spare.
+class ProjectMRenderer : public QObject {
+  Q_OBJECT
+
+ public:
+  // share_context is the context of the view the frames are drawn in.  Must
+  // be created in the GUI thread.
+  ProjectMRenderer(QOpenGLContext* share_context, QMutex* projectm_mutex);
+  ~ProjectMRenderer();
+
+  static const int kMinTextureSize;
+
+  // Starts the render thread and calls create in it to make projectM, waiting
+  // until that's done.  Returns nullptr if projectM can't render to a texture
+  // here, in which case the caller should render it itself.
+  projectM* Start(std::function<projectM*()> create);
+
+  // Stops rendering and deletes projectm in the render thread.
+  void Stop(projectM* projectm);
+
+  // These can be called from the GUI thread at any time, they're picked up
+  // before the next frame.
+  void SetFps(int fps);
+  void SetTextureSize(int size);
+  void SetViewSize(int width, int height);
+  void SetOccluded(bool occluded);
+  void AddPCM(const short* data, int samples_per_channel);
+
+  // The texture size the governor settled on.
+  int texture_size() const { return current_texture_size_.load(); }
+
+  // Draws the latest finished frame over a viewport of width by height
+  // pixels.  Called in the GUI thread with the view's context current.
+  void DrawLatestFrame(int width, int height);
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private slots:
+  void Create();
+  void Destroy();
+
+ private:
+  void RenderFrame();
+  void ApplyTextureSize(int size);
+  void FeedPCM();
+  void Govern(qint64 frame_msec, int interval_msec);
+
+  static void DrawTexture(unsigned int texture);
+
+  std::unique_ptr<QThread> thread_;
+  QOpenGLContext* context_;
+  std::unique_ptr<QOffscreenSurface> surface_;
+  QMutex* projectm_mutex_;
+
+  // Only used in the render thread.
+  std::function<projectM*()> create_;
+  projectM* projectm_;
+  projectM* delete_projectm_;
+  unsigned int projectm_texture_;
+  std::unique_ptr<QOpenGLFramebufferObject> back_;
+  std::unique_ptr<QOpenGLFramebufferObject> front_;
+  QBasicTimer timer_;
+  int interval_msec_;
+  int view_width_;
+  int view_height_;
+  int governed_texture_size_;
+  int slow_frames_;
+  int fast_frames_;
+
+  // Set from the GUI thread.
+  QAtomicInt fps_;
+  QAtomicInt requested_texture_size_;
+  QAtomicInt requested_view_size_;
+  QAtomicInt occluded_;
+  QAtomicInt current_texture_size_;
+
+  QMutex pcm_mutex_;
+  std::vector<short> pcm_;
+
+  // Guards the front frame while the GUI draws it, and the swap.
+  QMutex frame_mutex_;
+  unsigned int front_texture_;
+};
+
+#endif  // PROJECTMRENDERER_H
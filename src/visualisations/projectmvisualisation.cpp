@@ -23,6 +23,7 @@
 #include <QGLWidget>
 #include <QGraphicsView>
 #include <QMessageBox>
+#include <QOpenGLContext>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QSettings>
@@ -31,7 +32,9 @@
 #include <QtDebug>
 
 #include "config.h"
+#include "core/logging.h"
 #include "projectmpresetmodel.h"
+#include "projectmrenderer.h"
 #include "visualisationcontainer.h"
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
@@ -54,6 +57,9 @@
 
 ProjectMVisualisation::ProjectMVisualisation(VisualisationContainer* container)
     : QGraphicsScene(container),
+      projectm_mutex_(QMutex::Recursive),
+      threaded_(false),
+      fps_(35),
       preset_model_(nullptr),
       mode_(Random),
       duration_(15),
@@ -67,7 +73,10 @@ ProjectMVisualisation::ProjectMVisualisation(VisualisationContainer* container)
     default_rating_list_.push_back(3);
 }
 
-ProjectMVisualisation::~ProjectMVisualisation() {}
+ProjectMVisualisation::~ProjectMVisualisation() {
+  // projectM has to be deleted in the thread whose context it was made in.
+  if (renderer_) renderer_->Stop(projectm_.release());
+}
 
 void ProjectMVisualisation::InitProjectM() {
   // Find the projectM presets
@@ -123,7 +132,16 @@ void ProjectMVisualisation::InitProjectM() {
   s.menuFontURL = font_path.toStdString();
   s.titleFontURL = font_path.toStdString();
 
-  projectm_.reset(new projectM(s));
+  if (renderer_) {
+    projectm_.reset(renderer_->Start([s]() { return new projectM(s); }));
+    if (!projectm_) {
+      qLog(Warning) << "Rendering projectM in the GUI thread instead";
+      renderer_.reset();
+    }
+  }
+  if (!projectm_) projectm_.reset(new projectM(s));
+
+  QMutexLocker l(&projectm_mutex_);
   preset_model_ = new ProjectMPresetModel(this, this);
   Load();
 
@@ -152,12 +170,26 @@ void ProjectMVisualisation::drawBackground(QPainter* p, const QRectF&) {
   p->beginNativePainting();
 
   if (!projectm_) {
+    if (threaded_) {
+      renderer_.reset(new ProjectMRenderer(QOpenGLContext::currentContext(),
+                                           &projectm_mutex_));
+      renderer_->SetFps(fps_);
+      renderer_->SetTextureSize(texture_size_);
+      renderer_->SetViewSize(sceneRect().width() * pixel_ratio_,
+                             sceneRect().height() * pixel_ratio_);
+    }
     InitProjectM();
   }
 
-  projectm_->projectM_resetGL(sceneRect().width() * pixel_ratio_,
-                              sceneRect().height() * pixel_ratio_);
-  projectm_->renderFrame();
+  if (renderer_) {
+    // The frame was rendered in the other thread, all we do is show it.
+    renderer_->DrawLatestFrame(sceneRect().width() * pixel_ratio_,
+                               sceneRect().height() * pixel_ratio_);
+  } else {
+    projectm_->projectM_resetGL(sceneRect().width() * pixel_ratio_,
+                                sceneRect().height() * pixel_ratio_);
+    projectm_->renderFrame();
+  }
 
   p->endNativePainting();
 }
@@ -167,20 +199,38 @@ void ProjectMVisualisation::SceneRectChanged(const QRectF& rect) {
   // QScreen becomes a lot easier in Qt 5.14 with QWidget::screen().
   pixel_ratio_ = container_->devicePixelRatio();
 
-  if (projectm_)
+  if (renderer_) {
+    renderer_->SetViewSize(rect.width() * pixel_ratio_,
+                           rect.height() * pixel_ratio_);
+  } else if (projectm_) {
     projectm_->projectM_resetGL(rect.width() * pixel_ratio_,
                                 rect.height() * pixel_ratio_);
+  }
 }
 
 void ProjectMVisualisation::SetTextureSize(int size) {
   texture_size_ = size;
 
-  if (projectm_) projectm_->changeTextureSize(texture_size_);
+  if (renderer_) {
+    renderer_->SetTextureSize(texture_size_);
+  } else if (projectm_) {
+    projectm_->changeTextureSize(texture_size_);
+  }
+}
+
+void ProjectMVisualisation::SetFps(int fps) {
+  fps_ = fps;
+  if (renderer_) renderer_->SetFps(fps_);
+}
+
+void ProjectMVisualisation::SetOccluded(bool occluded) {
+  if (renderer_) renderer_->SetOccluded(occluded);
 }
 
 void ProjectMVisualisation::SetDuration(int seconds) {
   duration_ = seconds;
 
+  QMutexLocker l(&projectm_mutex_);
   if (projectm_) projectm_->changePresetDuration(duration_);
 
   Save();
@@ -192,7 +242,9 @@ void ProjectMVisualisation::ConsumeBuffer(GstBuffer* buffer, int) {
   const int samples_per_channel = map.size / sizeof(short) / 2;
   const short* data = reinterpret_cast<short*>(map.data);
 
-  if (projectm_) {
+  if (renderer_) {
+    renderer_->AddPCM(data, samples_per_channel);
+  } else if (projectm_) {
     projectm_->pcm()->addPCM16Data(data, samples_per_channel);
   }
 
@@ -202,6 +254,7 @@ void ProjectMVisualisation::ConsumeBuffer(GstBuffer* buffer, int) {
 
 void ProjectMVisualisation::SetSelected(const QStringList& paths,
                                         bool selected) {
+  QMutexLocker l(&projectm_mutex_);
   for (const QString& path : paths) {
     int index = IndexOfPreset(path);
     if (selected && index == -1) {
@@ -216,11 +269,13 @@ void ProjectMVisualisation::SetSelected(const QStringList& paths,
 }
 
 void ProjectMVisualisation::ClearSelected() {
+  QMutexLocker l(&projectm_mutex_);
   projectm_->clearPlaylist();
   Save();
 }
 
 int ProjectMVisualisation::IndexOfPreset(const QString& path) const {
+  QMutexLocker l(&projectm_mutex_);
   for (uint i = 0; i < projectm_->getPlaylistSize(); ++i) {
     if (QString::fromStdString(projectm_->getPresetURL(i)) == path) return i;
   }
@@ -233,6 +288,7 @@ void ProjectMVisualisation::Load() {
   mode_ = Mode(s.value("mode", 0).toInt());
   duration_ = s.value("duration", duration_).toInt();
 
+  QMutexLocker l(&projectm_mutex_);
   projectm_->changePresetDuration(duration_);
   projectm_->clearPlaylist();
   switch (mode_) {
@@ -277,10 +333,12 @@ void ProjectMVisualisation::SetMode(Mode mode) {
 }
 
 QString ProjectMVisualisation::preset_url() const {
+  QMutexLocker l(&projectm_mutex_);
   return QString::fromStdString(projectm_->settings().presetURL);
 }
 
 void ProjectMVisualisation::SetImmediatePreset(const QString& path) {
+  QMutexLocker l(&projectm_mutex_);
   int index = IndexOfPreset(path);
   if (index == -1) {
     index = projectm_->addPresetURL(path.toStdString(), std::string(),
@@ -291,6 +349,7 @@ void ProjectMVisualisation::SetImmediatePreset(const QString& path) {
 }
 
 void ProjectMVisualisation::Lock(bool lock) {
+  QMutexLocker l(&projectm_mutex_);
   projectm_->setPresetLock(lock);
 
   if (!lock) Load();
@@ -20,6 +20,7 @@
 
 #include <QBasicTimer>
 #include <QGraphicsScene>
+#include <QMutex>
 #include <QSet>
 #include <memory>
 
@@ -28,6 +29,7 @@
 class projectM;
 
 class ProjectMPresetModel;
+class ProjectMRenderer;
 
 class VisualisationContainer;
 
@@ -53,8 +55,17 @@ class ProjectMVisualisation : public QGraphicsScene, public BufferConsumer {
   // BufferConsumer
   void ConsumeBuffer(GstBuffer* buffer, int);
 
+  // Renders projectM in a thread of its own instead of in drawBackground.
+  // Only has an effect before the first frame is drawn.
+  void SetThreadedRendering(bool threaded) { threaded_ = threaded; }
+  bool is_threaded() const { return renderer_ != nullptr; }
+
  public slots:
   void SetTextureSize(int size);
+  void SetFps(int fps);
+  // The threaded renderer drops to a low texture size while nobody can see
+  // the window.
+  void SetOccluded(bool occluded);
   void SetDuration(int seconds);
 
   void SetSelected(const QStringList& paths, bool selected);
@@ -80,6 +91,12 @@ class ProjectMVisualisation : public QGraphicsScene, public BufferConsumer {
 
  private:
   std::unique_ptr<projectM> projectm_;
+  // Held by anything that uses projectm_, since the threaded renderer uses it
+  // from another thread.  Recursive, as some of our slots call each other.
+  mutable QMutex projectm_mutex_;
+  bool threaded_;
+  std::unique_ptr<ProjectMRenderer> renderer_;
+  int fps_;
   ProjectMPresetModel* preset_model_;
   Mode mode_;
   int duration_;
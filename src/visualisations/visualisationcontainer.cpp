@@ -25,6 +25,7 @@
 #include <QMessageBox>
 #include <QSettings>
 #include <QShortcut>
+#include <QWindow>
 #include <QtDebug>
 
 #include "config.h"
@@ -58,7 +59,8 @@ VisualisationContainer::VisualisationContainer(QWidget* parent)
       overlay_proxy_(nullptr),
       menu_(new QMenu(this)),
       fps_(kDefaultFps),
-      size_(kDefaultTextureSize) {
+      size_(kDefaultTextureSize),
+      threaded_(false) {
   QSettings s;
   s.beginGroup(kSettingsGroup);
   if (!restoreGeometry(s.value("geometry").toByteArray())) {
@@ -66,6 +68,7 @@ VisualisationContainer::VisualisationContainer(QWidget* parent)
   }
   fps_ = s.value("fps", kDefaultFps).toInt();
   size_ = s.value("size", kDefaultTextureSize).toInt();
+  threaded_ = s.value("threaded", false).toBool();
 
   QShortcut* close = new QShortcut(QKeySequence::Close, this);
   connect(close, SIGNAL(activated()), SLOT(close()));
@@ -92,6 +95,8 @@ void VisualisationContainer::Init() {
   connect(overlay_, SIGNAL(ShowPopupMenu(QPoint)), SLOT(ShowPopupMenu(QPoint)));
   ChangeOverlayOpacity(0.0);
 
+  vis_->SetThreadedRendering(threaded_);
+  vis_->SetFps(fps_);
   vis_->SetTextureSize(size_);
   SizeChanged();
 
@@ -122,6 +127,11 @@ void VisualisationContainer::Init() {
   AddQualityMenuItem(tr("Super high (2048x2048)"), 2048, size_, quality_group);
   quality_menu->addActions(quality_group->actions());
 
+  QAction* threaded = menu_->addAction(tr("Render in a separate thread"));
+  threaded->setCheckable(true);
+  threaded->setChecked(threaded_);
+  connect(threaded, SIGNAL(toggled(bool)), SLOT(SetThreadedRendering(bool)));
+
   menu_->addAction(tr("Select visualizations..."), selector_, SLOT(show()));
 
   menu_->addSeparator();
@@ -169,6 +179,7 @@ void VisualisationContainer::showEvent(QShowEvent* e) {
 
   QGraphicsView::showEvent(e);
   update_timer_.start(1000 / fps_, this);
+  vis_->SetOccluded(false);
 
   if (engine_) engine_->AddBufferConsumer(vis_);
 }
@@ -177,6 +188,7 @@ void VisualisationContainer::hideEvent(QHideEvent* e) {
   qLog(Debug) << "Hiding visualization";
   QGraphicsView::hideEvent(e);
   update_timer_.stop();
+  vis_->SetOccluded(true);
 
   if (engine_) engine_->RemoveBufferConsumer(vis_);
 }
@@ -207,7 +219,12 @@ void VisualisationContainer::SizeChanged() {
 
 void VisualisationContainer::timerEvent(QTimerEvent* e) {
   QGraphicsView::timerEvent(e);
-  if (e->timerId() == update_timer_.timerId()) scene()->update();
+  if (e->timerId() == update_timer_.timerId()) {
+    // Covered windows aren't hidden, but their window isn't exposed either.
+    vis_->SetOccluded(isMinimized() ||
+                      (windowHandle() && !windowHandle()->isExposed()));
+    scene()->update();
+  }
 }
 
 void VisualisationContainer::SetActions(QAction* previous, QAction* play_pause,
@@ -289,6 +306,8 @@ void VisualisationContainer::SetFps(int fps) {
 
   update_timer_.stop();
   update_timer_.start(1000 / fps_, this);
+
+  vis_->SetFps(fps_);
 }
 
 void VisualisationContainer::ShowPopupMenu(const QPoint& pos) {
@@ -305,3 +324,19 @@ void VisualisationContainer::SetQuality(int size) {
 
   vis_->SetTextureSize(size_);
 }
+
+void VisualisationContainer::SetThreadedRendering(bool threaded) {
+  threaded_ = threaded;
+
+  // Save settings
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.setValue("threaded", threaded_);
+
+  // projectM is only ever made once, so this takes effect after a restart.
+  if (vis_->is_threaded() != threaded_) {
+    QMessageBox::information(
+        this, tr("Clementine Visualization"),
+        tr("Clementine will need to be restarted for this to take effect."));
+  }
+}
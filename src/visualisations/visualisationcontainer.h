@@ -85,6 +85,7 @@ class VisualisationContainer : public QGraphicsView {
   void ToggleFullscreen();
   void SetFps(int fps);
   void SetQuality(int size);
+  void SetThreadedRendering(bool threaded);
 
  private:
   bool initialised_;
@@ -102,6 +103,7 @@ class VisualisationContainer : public QGraphicsView {
 
   int fps_;
   int size_;
+  bool threaded_;
 };
 
 #endif  // VISUALISATIONCONTAINER_H
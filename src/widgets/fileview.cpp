@@ -19,7 +19,6 @@
 
 #include <QFileSystemModel>
 #include <QKeyEvent>
-#include <QMessageBox>
 #include <QScrollBar>
 
 #include "core/deletefiles.h"
@@ -186,14 +185,11 @@ void FileView::UndoCommand::undo() {
 void FileView::Delete(const QStringList& filenames) {
   if (filenames.isEmpty()) return;
 
-  if (QMessageBox::warning(this, tr("Delete files"),
-                           tr("These files will be permanently deleted from "
-                              "disk, are you sure you want to continue?"),
-                           QMessageBox::Yes,
-                           QMessageBox::Cancel) != QMessageBox::Yes)
-    return;
+  bool use_trash = false;
+  if (!DeleteFiles::ConfirmDeleteFromDisk(this, &use_trash)) return;
 
   DeleteFiles* delete_files = new DeleteFiles(task_manager_, storage_);
+  delete_files->set_use_trash(use_trash);
   connect(delete_files, SIGNAL(Finished(SongList)),
           SLOT(DeleteFinished(SongList)));
   delete_files->Start(filenames);
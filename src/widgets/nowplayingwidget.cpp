@@ -30,6 +30,8 @@
 #include <QtDebug>
 
 #include "core/application.h"
+#include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "covers/albumcoverloader.h"
 #include "covers/coverproviders.h"
@@ -61,6 +63,9 @@ const int NowPlayingWidget::kBottomOffset = 0;
 // Border for large mode
 const int NowPlayingWidget::kTopBorder = 4;
 
+// How many sizes of the cover are kept around
+const int NowPlayingWidget::kMaxScaledCovers = 4;
+
 NowPlayingWidget::NowPlayingWidget(QWidget* parent)
     : QWidget(parent),
       app_(nullptr),
@@ -74,6 +79,8 @@ NowPlayingWidget::NowPlayingWidget(QWidget* parent)
       fit_width_(false),
       show_hide_animation_(new QTimeLine(500, this)),
       fade_animation_(new QTimeLine(1000, this)),
+      cover_id_(0),
+      scaling_size_(0),
       details_(new QTextDocument(this)),
       previous_track_opacity_(0.0),
       bask_in_his_glory_action_(nullptr),
@@ -300,9 +307,58 @@ void NowPlayingWidget::UpdateDetailsText() {
 }
 
 void NowPlayingWidget::ScaleCover() {
-  cover_ = QPixmap::fromImage(
-      AlbumCoverLoader::ScaleAndPad(cover_loader_options_, original_));
+  const qreal pixel_ratio = devicePixelRatioF();
+  const int size = qRound(cover_loader_options_.desired_height_ * pixel_ratio);
+
+  if (scaled_covers_.contains(size)) {
+    SetCover(scaled_covers_[size]);
+    return;
+  }
+  if (scaling_size_ != 0) return;
+
+  // Scaling a big cover smoothly takes long enough to hold up resizing and
+  // the animations.
+  scaling_size_ = size;
+  AlbumCoverLoaderOptions options(cover_loader_options_);
+  options.desired_height_ = size;
+  const QImage original = original_;
+  QFuture<QImage> future =
+      Executor::Cpu()->Run<QImage>([options, original, pixel_ratio]() {
+        QImage scaled = AlbumCoverLoader::ScaleAndPad(options, original);
+        scaled.setDevicePixelRatio(pixel_ratio);
+        return scaled;
+      });
+  NewClosure(future, this, SLOT(CoverScaled(QFuture<QImage>, int, int)),
+             future, cover_id_, size);
+}
+
+void NowPlayingWidget::CoverScaled(QFuture<QImage> future, int cover_id,
+                                   int size) {
+  scaling_size_ = 0;
+
+  if (cover_id == cover_id_) {
+    scaled_covers_[size] = QPixmap::fromImage(future.result());
+    if (scaled_covers_.count() > kMaxScaledCovers) {
+      // Drop the smallest one that isn't this one.
+      QMap<int, QPixmap>::iterator it = scaled_covers_.begin();
+      if (it.key() == size) ++it;
+      scaled_covers_.erase(it);
+    }
+  }
+
+  // The cover or the widget's size may have changed while this was scaled.
+  ScaleCover();
+}
+
+void NowPlayingWidget::SetCover(const QPixmap& cover) {
+  cover_ = cover;
   update();
+
+  // Were we waiting for this cover to be scaled before we started fading?
+  if (!previous_track_.isNull() &&
+      fade_animation_->state() != QTimeLine::Running) {
+    fade_animation_->start();
+  }
 }
 
 void NowPlayingWidget::KittenLoaded(quint64 id, const QImage& image) {
@@ -331,7 +387,8 @@ void NowPlayingWidget::AlbumArtLoaded(const Song& metadata, const QString& uri,
 void NowPlayingWidget::SetImage(const QImage& image) {
   if (visible_) {
     // Cache the current pixmap so we can fade between them
-    previous_track_ = QPixmap(size());
+    previous_track_ = QPixmap(size() * devicePixelRatioF());
+    previous_track_.setDevicePixelRatio(devicePixelRatioF());
     previous_track_.fill(palette().window().color());
     previous_track_opacity_ = 1.0;
     QPainter p(&previous_track_);
@@ -340,15 +397,14 @@ void NowPlayingWidget::SetImage(const QImage& image) {
   }
 
   original_ = image;
+  ++cover_id_;
+  scaled_covers_.clear();
+  cover_ = QPixmap();
 
+  // The fade starts once the new cover has been scaled.
   UpdateDetailsText();
   ScaleCover();
   SetVisible(true);
-
-  // Were we waiting for this cover to load before we started fading?
-  if (!previous_track_.isNull()) {
-    fade_animation_->start();
-  }
 }
 
 void NowPlayingWidget::SetHeight(int height) { setMaximumHeight(height); }
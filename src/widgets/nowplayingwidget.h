@@ -18,6 +18,8 @@
 #ifndef NOWPLAYINGWIDGET_H
 #define NOWPLAYINGWIDGET_H
 
+#include <QFuture>
+#include <QMap>
 #include <QWidget>
 #include <memory>
 
@@ -50,6 +52,7 @@ class NowPlayingWidget : public QWidget {
   static const int kMaxCoverSize;
   static const int kBottomOffset;
   static const int kTopBorder;
+  static const int kMaxScaledCovers;
 
   // Values are saved in QSettings
   enum Mode {
@@ -90,6 +93,7 @@ class NowPlayingWidget : public QWidget {
   void AlbumArtLoaded(const Song& metadata, const QString& uri,
                       const QImage& image);
   void KittenLoaded(quint64 id, const QImage& image);
+  void CoverScaled(QFuture<QImage> future, int cover_id, int size);
 
   void SetVisible(bool visible);
   void SetHeight(int height);
@@ -114,7 +118,10 @@ class NowPlayingWidget : public QWidget {
   void UpdateHeight();
   void DrawContents(QPainter* p);
   void SetImage(const QImage& image);
+  // Shows original_ at the current size, scaling it in the background if it
+  // hasn't been shown at this size before.
   void ScaleCover();
+  void SetCover(const QPixmap& cover);
   bool GetCoverAutomatically();
 
  private:
@@ -141,6 +148,14 @@ class NowPlayingWidget : public QWidget {
   QPixmap cover_;
   // A copy of the original, unscaled album cover.
   QImage original_;
+  // Changes whenever original_ does, so scales of an old cover are dropped.
+  int cover_id_;
+  // original_ scaled to the sizes it's been shown at, by height in device
+  // pixels, so switching modes or resizing back doesn't scale it again.
+  QMap<int, QPixmap> scaled_covers_;
+  // The size being scaled in the background, or 0.  Only one is scaled at a
+  // time, the latest size is started when it's done.
+  int scaling_size_;
   QTextDocument* details_;
 
   // Holds the last track while we're fading to the new track
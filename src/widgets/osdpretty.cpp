@@ -25,6 +25,7 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPixmapCache>
 #include <QScreen>
 #include <QSettings>
 #include <QTimeLine>
@@ -32,6 +33,8 @@
 #include <QWindow>
 
 #include "config.h"
+#include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "ui_osdpretty.h"
 
@@ -209,7 +212,37 @@ QRect OSDPretty::BoxBorder() const {
 }
 
 void OSDPretty::paintEvent(QPaintEvent*) {
+  // Fades and repaints only draw the cached frame.  It's only rendered again
+  // for a new size, mode or colour.
+  const qreal device_pixel_ratio = devicePixelRatioF();
+  const QString cache_key = FrameCacheKey(device_pixel_ratio);
+
+  QPixmap frame;
+  if (!QPixmapCache::find(cache_key, &frame)) {
+    frame = RenderFrame(device_pixel_ratio);
+    QPixmapCache::insert(cache_key, frame);
+  }
+
   QPainter p(this);
+  p.drawPixmap(0, 0, frame);
+}
+
+QString OSDPretty::FrameCacheKey(qreal device_pixel_ratio) const {
+  return QString("osdpretty/%1x%2@%3/%4/%5/%6")
+      .arg(width())
+      .arg(height())
+      .arg(device_pixel_ratio)
+      .arg(mode_)
+      .arg(background_color_.rgb(), 0, 16)
+      .arg(background_opacity_);
+}
+
+QPixmap OSDPretty::RenderFrame(qreal device_pixel_ratio) const {
+  QPixmap frame(size() * device_pixel_ratio);
+  frame.setDevicePixelRatio(device_pixel_ratio);
+  frame.fill(Qt::transparent);
+
+  QPainter p(&frame);
   p.setRenderHint(QPainter::Antialiasing);
   p.setRenderHint(QPainter::HighQualityAntialiasing);
 
@@ -261,17 +294,31 @@ void OSDPretty::paintEvent(QPaintEvent*) {
   p.setBrush(QBrush());
   p.setPen(QPen(background_color_.darker(150), 2));
   p.drawRoundedRect(box, kBorderRadius, kBorderRadius);
+
+  p.end();
+
+  return frame;
 }
 
 void OSDPretty::SetMessage(const QString& summary, const QString& message,
                            const QImage& image) {
   if (!image.isNull()) {
-    QImage scaled_image =
-        image.scaled(kMaxIconSize, kMaxIconSize, Qt::KeepAspectRatio,
-                     Qt::SmoothTransformation);
-    ui_->icon->setPixmap(QPixmap::fromImage(scaled_image));
+    // Covers are scaled in the background, but the icon gets its size now so
+    // the OSD doesn't change size when it arrives.
+    const QSize icon_size = image.size().scaled(kMaxIconSize, kMaxIconSize,
+                                                Qt::KeepAspectRatio);
+    ui_->icon->setFixedSize(icon_size);
+    ui_->icon->clear();
     ui_->icon->show();
+
+    icon_future_ = Executor::Cpu()->Run<QImage>([image, icon_size]() {
+      return image.scaled(icon_size, Qt::IgnoreAspectRatio,
+                          Qt::SmoothTransformation);
+    });
+    NewClosure(icon_future_, this, SLOT(IconScaled(QFuture<QImage>)),
+               icon_future_);
   } else {
+    icon_future_ = QFuture<QImage>();
     ui_->icon->hide();
   }
 
@@ -360,6 +407,13 @@ void OSDPretty::FaderFinished() {
 
 void OSDPretty::FaderValueChanged(qreal value) { setWindowOpacity(value); }
 
+void OSDPretty::IconScaled(QFuture<QImage> future) {
+  // Skipping through tracks quickly can leave older covers behind.
+  if (future != icon_future_) return;
+
+  ui_->icon->setPixmap(QPixmap::fromImage(future.result()));
+}
+
 void OSDPretty::Reposition() {
   // Make the OSD the proper size
   layout()->activate();
@@ -384,6 +438,16 @@ void OSDPretty::Reposition() {
     move(x, y);
   }
 
+  // If there's no compositing window manager running then we have to set an
+  // XShape mask.  Windows always needs one, for the blur behind it.
+  const bool transparency = IsTransparencyAvailable();
+#ifndef Q_OS_WIN32
+  if (transparency) {
+    clearMask();
+    return;
+  }
+#endif
+
   // Create a mask for the actual area of the OSD
   QBitmap mask(size());
   mask.clear();
@@ -394,9 +458,7 @@ void OSDPretty::Reposition() {
                     kBorderRadius);
   p.end();
 
-  // If there's no compositing window manager running then we have to set an
-  // XShape mask.
-  if (IsTransparencyAvailable())
+  if (transparency)
     clearMask();
   else {
     setMask(mask);
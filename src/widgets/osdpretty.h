@@ -18,6 +18,8 @@
 #ifndef OSDPRETTY_H
 #define OSDPRETTY_H
 
+#include <QFuture>
+#include <QImage>
 #include <QMap>
 #include <QWidget>
 
@@ -106,10 +108,14 @@ class OSDPretty : public QWidget {
   void Load();
 
   QRect BoxBorder() const;
+  // The shadow, background and border, which is everything paintEvent draws.
+  QPixmap RenderFrame(qreal device_pixel_ratio) const;
+  QString FrameCacheKey(qreal device_pixel_ratio) const;
 
  private slots:
   void FaderValueChanged(qreal value);
   void FaderFinished();
+  void IconScaled(QFuture<QImage> future);
   void ScreenAdded(QScreen* screen);
   void ScreenRemoved(QScreen* screen);
 
@@ -134,6 +140,9 @@ class OSDPretty : public QWidget {
   QPixmap shadow_corner_[4];
   QPixmap background_;
 
+  // The icon of the latest message, while it's being scaled.
+  QFuture<QImage> icon_future_;
+
   // For dragging the OSD
   QPoint original_window_pos_;
   QPoint drag_start_pos_;
@@ -18,10 +18,12 @@
 #include "prettyimage.h"
 
 #include <QApplication>
+#include <QBuffer>
 #include <QContextMenuEvent>
 #include <QDir>
 #include <QFileDialog>
 #include <QFuture>
+#include <QImageReader>
 #include <QLabel>
 #include <QMenu>
 #include <QNetworkAccessManager>
@@ -31,9 +33,9 @@
 #include <QScrollArea>
 #include <QSettings>
 #include <QWindow>
-#include <QtConcurrentRun>
 
 #include "core/closure.h"
+#include "core/executor.h"
 #include "core/logging.h"
 #include "core/network.h"
 #include "ui/iconloader.h"
@@ -47,6 +49,36 @@ const int PrettyImage::kMaxImageWidth = 300;
 
 const char* PrettyImage::kSettingsGroup = "PrettyImageView";
 
+namespace {
+
+// Artists' images are often photos several thousand pixels across, so where
+// the format allows it they're decoded straight to the thumbnail's size.
+QImage DecodeThumbnail(const QByteArray& data, qreal pixel_ratio) {
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+
+  const QSize box =
+      QSize(PrettyImage::kMaxImageWidth, PrettyImage::kImageHeight) *
+      pixel_ratio;
+
+  QImageReader reader(&buffer);
+  QSize size = reader.size();
+  if (size.isValid()) {
+    size.scale(box, Qt::KeepAspectRatio);
+    reader.setScaledSize(size);
+  }
+
+  QImage image = reader.read();
+  if (!image.isNull() && !size.isValid()) {
+    image = image.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  }
+  image.setDevicePixelRatio(pixel_ratio);
+  return image;
+}
+
+}  // namespace
+
 PrettyImage::PrettyImage(const QUrl& url, QNetworkAccessManager* network,
                          QWidget* parent)
     : QWidget(parent),
@@ -55,27 +87,35 @@ PrettyImage::PrettyImage(const QUrl& url, QNetworkAccessManager* network,
       url_(url),
       menu_(nullptr) {
   setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-
-  LazyLoad();
 }
 
 void PrettyImage::LazyLoad() {
   if (state_ != State_WaitingForLazyLoad) return;
 
-  // Start fetching the image
-  QNetworkReply* reply = network_->get(QNetworkRequest(url_));
+  // Start fetching the image.  It's been fetched before if it was unloaded,
+  // so don't ask the server again if we don't have to.
+  QNetworkRequest request(url_);
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       QNetworkRequest::PreferCache);
+  QNetworkReply* reply = network_->get(request);
   RedirectFollower* follower = new RedirectFollower(reply);
   state_ = State_Fetching;
   NewClosure(follower, SIGNAL(finished()), this,
              SLOT(ImageFetched(RedirectFollower*)), follower);
 }
 
-QSize PrettyImage::image_size() const {
-  if (state_ != State_Finished) return QSize(kImageHeight * 1.6, kImageHeight);
+void PrettyImage::Unload() {
+  if (state_ != State_Finished) return;
 
-  QSize ret = image_.size();
-  ret.scale(kMaxImageWidth, kImageHeight, Qt::KeepAspectRatio);
-  return ret;
+  state_ = State_WaitingForLazyLoad;
+  data_.clear();
+  thumbnail_ = QPixmap();
+  update();
+}
+
+QSize PrettyImage::image_size() const {
+  if (!image_size_.isValid()) return QSize(kImageHeight * 1.6, kImageHeight);
+  return image_size_;
 }
 
 QSize PrettyImage::sizeHint() const {
@@ -87,24 +127,33 @@ void PrettyImage::ImageFetched(RedirectFollower* follower) {
   QNetworkReply* reply = follower->reply();
   reply->deleteLater();
 
-  QImage image = QImage::fromData(reply->readAll());
-  if (image.isNull()) {
+  if (reply->error() != QNetworkReply::NoError) {
     qLog(Debug) << "Image failed to load" << reply->request().url()
                 << reply->error();
     deleteLater();
-  } else {
-    state_ = State_CreatingThumbnail;
-    image_ = image;
-
-    QFuture<QImage> future =
-        QtConcurrent::run(image_, &QImage::scaled, image_size(),
-                          Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    NewClosure(future, this, SLOT(ImageScaled(QFuture<QImage>)), future);
+    return;
   }
+
+  state_ = State_CreatingThumbnail;
+  data_ = reply->readAll();
+
+  const QByteArray data = data_;
+  const qreal pixel_ratio = devicePixelRatioF();
+  QFuture<QImage> future = Executor::Cpu()->Run<QImage>(
+      [data, pixel_ratio]() { return DecodeThumbnail(data, pixel_ratio); });
+  NewClosure(future, this, SLOT(ImageScaled(QFuture<QImage>)), future);
 }
 
 void PrettyImage::ImageScaled(QFuture<QImage> future) {
-  thumbnail_ = QPixmap::fromImage(future.result());
+  const QImage thumbnail = future.result();
+  if (thumbnail.isNull()) {
+    qLog(Debug) << "Image failed to load" << url_;
+    deleteLater();
+    return;
+  }
+
+  thumbnail_ = QPixmap::fromImage(thumbnail);
+  image_size_ = thumbnail.size() / thumbnail.devicePixelRatio();
   state_ = State_Finished;
 
   updateGeometry();
@@ -176,7 +225,7 @@ void PrettyImage::DrawThumbnail(QPainter* p, const QRect& rect) {
 }
 
 void PrettyImage::contextMenuEvent(QContextMenuEvent* e) {
-  if (e->pos().y() >= kImageHeight) return;
+  if (e->pos().y() >= kImageHeight || state_ != State_Finished) return;
 
   if (!menu_) {
     menu_ = new QMenu(this);
@@ -190,6 +239,9 @@ void PrettyImage::contextMenuEvent(QContextMenuEvent* e) {
 }
 
 void PrettyImage::ShowFullsize() {
+  const QImage image = QImage::fromData(data_);
+  if (image.isNull()) return;
+
   // Create the window
   QScrollArea* pwindow = new QScrollArea;
   pwindow->setAttribute(Qt::WA_DeleteOnClose, true);
@@ -205,14 +257,14 @@ void PrettyImage::ShowFullsize() {
 #endif
   if (screen) {
     QRect desktop_rect(screen->availableGeometry());
-    QSize window_size(qMin(desktop_rect.width() - 20, image_.width()),
-                      qMin(desktop_rect.height() - 20, image_.height()));
+    QSize window_size(qMin(desktop_rect.width() - 20, image.width()),
+                      qMin(desktop_rect.height() - 20, image.height()));
     pwindow->resize(window_size);
   }
 
   // Create the label that displays the image
   QLabel* label = new QLabel(pwindow);
-  label->setPixmap(QPixmap::fromImage(image_));
+  label->setPixmap(QPixmap::fromImage(image));
 
   // Show the label in the window
   pwindow->setWidget(label);
@@ -240,7 +292,7 @@ void PrettyImage::SaveAs() {
   filename = QFileDialog::getSaveFileName(this, tr("Save image"), path);
   if (filename.isEmpty()) return;
 
-  image_.save(filename);
+  QImage::fromData(data_).save(filename);
 
   s.setValue("last_save_dir", last_save_dir);
 }
@@ -18,6 +18,7 @@
 #ifndef PRETTYIMAGE_H
 #define PRETTYIMAGE_H
 
+#include <QByteArray>
 #include <QFuture>
 #include <QUrl>
 #include <QWidget>
@@ -26,6 +27,8 @@ class QMenu;
 class QNetworkAccessManager;
 class RedirectFollower;
 
+// Shows one image with a reflection.  Nothing is fetched until LazyLoad is
+// called, and the image is decoded straight to the size it's shown at.
 class PrettyImage : public QWidget {
   Q_OBJECT
 
@@ -49,6 +52,9 @@ class PrettyImage : public QWidget {
 
  public slots:
   void LazyLoad();
+  // Drops the image to save memory.  The widget keeps its size, and the next
+  // LazyLoad gets the image from the network cache.
+  void Unload();
   void SaveAs();
   void ShowFullsize();
 
@@ -75,8 +81,12 @@ class PrettyImage : public QWidget {
   State state_;
   QUrl url_;
 
-  QImage image_;
+  // The image as it was downloaded, only decoded in full when it's shown
+  // fullsize or saved.
+  QByteArray data_;
   QPixmap thumbnail_;
+  // How big the image is shown, once it's known.
+  QSize image_size_;
 
   QMenu* menu_;
   QString last_save_dir_;
@@ -26,6 +26,9 @@
 
 #include "prettyimage.h"
 
+const int PrettyImageView::kLoadAheadViews = 1;
+const int PrettyImageView::kKeepLoadedViews = 3;
+
 PrettyImageView::PrettyImageView(QNetworkAccessManager* network,
                                  QWidget* parent)
     : QScrollArea(parent),
@@ -35,7 +38,8 @@ PrettyImageView::PrettyImageView(QNetworkAccessManager* network,
       current_index_(-1),
       scroll_animation_(
           new QPropertyAnimation(horizontalScrollBar(), "value", this)),
-      recursion_filter_(false) {
+      recursion_filter_(false),
+      load_visible_pending_(false) {
   setWidget(container_);
   setWidgetResizable(true);
   setMinimumHeight(PrettyImage::kTotalHeight + 10);
@@ -49,6 +53,8 @@ PrettyImageView::PrettyImageView(QNetworkAccessManager* network,
           SLOT(ScrollBarReleased()));
   connect(horizontalScrollBar(), SIGNAL(actionTriggered(int)),
           SLOT(ScrollBarAction(int)));
+  connect(horizontalScrollBar(), SIGNAL(valueChanged(int)),
+          SLOT(LoadVisibleImagesLater()));
 
   layout_->setSizeConstraint(QLayout::SetMinAndMaxSize);
   layout_->setContentsMargins(6, 6, 6, 6);
@@ -74,9 +80,49 @@ void PrettyImageView::AddImage(const QUrl& url) {
   PrettyImage* image = new PrettyImage(url, network_, container_);
   connect(image, SIGNAL(destroyed()), SLOT(ScrollToCurrent()));
   connect(image, SIGNAL(Loaded()), SLOT(ScrollToCurrent()));
+  // Images change size when they load, which moves the ones after them.
+  connect(image, SIGNAL(Loaded()), SLOT(LoadVisibleImagesLater()));
 
   layout_->insertWidget(layout_->count() - 1, image);
   if (current_index_ == -1) ScrollTo(0);
+
+  LoadVisibleImagesLater();
+}
+
+void PrettyImageView::LoadVisibleImagesLater() {
+  // Adding a lot of images, or scrolling, would otherwise go through all of
+  // them each time.
+  if (load_visible_pending_) return;
+  load_visible_pending_ = true;
+  QTimer::singleShot(0, this, SLOT(LoadVisibleImages()));
+}
+
+void PrettyImageView::LoadVisibleImages() {
+  load_visible_pending_ = false;
+
+  // Newly added images haven't been given a place yet.
+  layout_->activate();
+
+  const int view_width = viewport()->width();
+  const int view_left = horizontalScrollBar()->value();
+  const int view_right = view_left + view_width;
+  const int load_margin = view_width * kLoadAheadViews;
+  const int keep_margin = view_width * kKeepLoadedViews;
+
+  for (int i = 1; i < layout_->count() - 1; ++i) {
+    PrettyImage* image =
+        qobject_cast<PrettyImage*>(layout_->itemAt(i)->widget());
+    if (!image) continue;
+
+    const QRect rect = image->geometry();
+    if (rect.right() >= view_left - load_margin &&
+        rect.left() <= view_right + load_margin) {
+      image->LazyLoad();
+    } else if (rect.right() < view_left - keep_margin ||
+               rect.left() > view_right + keep_margin) {
+      image->Unload();
+    }
+  }
 }
 
 void PrettyImageView::mouseReleaseEvent(QMouseEvent* e) {
@@ -155,6 +201,7 @@ void PrettyImageView::ScrollBarAction(int action) {
 void PrettyImageView::resizeEvent(QResizeEvent* e) {
   QScrollArea::resizeEvent(e);
   ScrollTo(current_index_, false);
+  LoadVisibleImagesLater();
 }
 
 void PrettyImageView::wheelEvent(QWheelEvent* e) {
@@ -29,6 +29,9 @@ class QNetworkReply;
 class QPropertyAnimation;
 class QTimeLine;
 
+// A row of images that scrolls from one to the next.  Only the images near
+// the visible part of the row are loaded, and ones that are scrolled far
+// enough away are unloaded again.
 class PrettyImageView : public QScrollArea {
   Q_OBJECT
 
@@ -36,6 +39,10 @@ class PrettyImageView : public QScrollArea {
   PrettyImageView(QNetworkAccessManager* network, QWidget* parent = nullptr);
 
   static const char* kSettingsGroup;
+  // Images within this many view widths of the visible part are loaded.
+  static const int kLoadAheadViews;
+  // Loaded images further away than this many view widths are unloaded.
+  static const int kKeepLoadedViews;
 
  public slots:
   void AddImage(const QUrl& url);
@@ -50,6 +57,8 @@ class PrettyImageView : public QScrollArea {
   void ScrollBarAction(int action);
   void ScrollTo(int index, bool smooth = true);
   void ScrollToCurrent();
+  void LoadVisibleImagesLater();
+  void LoadVisibleImages();
 
  private:
   bool eventFilter(QObject*, QEvent*);
@@ -63,6 +72,7 @@ class PrettyImageView : public QScrollArea {
   QPropertyAnimation* scroll_animation_;
 
   bool recursion_filter_;
+  bool load_visible_pending_;
 };
 
 #endif  // PRETTYIMAGEVIEW_H
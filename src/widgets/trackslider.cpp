@@ -48,6 +48,8 @@ TrackSlider::TrackSlider(QWidget* parent)
 
   connect(ui_->slider, SIGNAL(sliderMoved(int)), SIGNAL(ValueChanged(int)));
   connect(ui_->slider, SIGNAL(valueChanged(int)), SLOT(ValueMaybeChanged(int)));
+  connect(ui_->slider, SIGNAL(sliderPressed()), SLOT(SliderPressed()));
+  connect(ui_->slider, SIGNAL(sliderReleased()), SLOT(SliderReleased()));
   connect(ui_->slider, SIGNAL(SeekForward()), SIGNAL(SeekForward()));
   connect(ui_->slider, SIGNAL(SeekBackward()), SIGNAL(SeekBackward()));
   connect(ui_->slider, SIGNAL(Previous()), SIGNAL(Previous()));
@@ -151,6 +153,10 @@ void TrackSlider::ValueMaybeChanged(int value) {
   emit ValueChangedSeconds(value / kMsecPerSec);
 }
 
+void TrackSlider::SliderPressed() { emit ScrubbingChanged(true); }
+
+void TrackSlider::SliderReleased() { emit ScrubbingChanged(false); }
+
 bool TrackSlider::event(QEvent* e) {
   switch (e->type()) {
     case QEvent::ApplicationFontChange:
@@ -54,6 +54,8 @@ class TrackSlider : public QWidget {
  signals:
   void ValueChanged(int value);
   void ValueChangedSeconds(int value);
+  // True while the user is dragging the slider.
+  void ScrubbingChanged(bool scrubbing);
 
   void SeekForward();
   void SeekBackward();
@@ -62,6 +64,8 @@ class TrackSlider : public QWidget {
 
  private slots:
   void ValueMaybeChanged(int value);
+  void SliderPressed();
+  void SliderReleased();
   void ToggleTimeDisplay();
 
  private:
@@ -18,6 +18,7 @@
 #include "test_utils.h"
 #include "gmock/gmock-matchers.h"
 #include "gtest/gtest.h"
+#include "mock_librarybackend.h"
 
 #include "core/timeconstants.h"
 #include "playlistparsers/asxparser.h"
@@ -26,6 +27,8 @@
 #include <QUrl>
 
 using ::testing::HasSubstr;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
 
 class ASXParserTest : public ::testing::Test {
 
@@ -72,6 +75,41 @@ TEST_F(ASXParserTest, ParsesMoreThanOneTrackFromXML) {
   EXPECT_TRUE(songs[1].is_stream());
 }
 
+TEST_F(ASXParserTest, LooksUpLocalFilesInOneBatch) {
+  QByteArray data =
+      "<asx version=\"3.0\">"
+        "<entry><ref href=\"/music/a.mp3\"/></entry>"
+        "<entry><ref href=\"/music/b.mp3\"/></entry>"
+      "</asx>";
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  SongList library_songs;
+  for (const QString& filename : QStringList() << "/music/a.mp3"
+                                               << "/music/b.mp3") {
+    Song song;
+    song.set_id(library_songs.count() + 1);
+    song.set_url(QUrl::fromLocalFile(filename));
+    song.set_valid(true);
+    library_songs << song;
+  }
+
+  MockLibraryBackend library;
+  EXPECT_CALL(library,
+              GetSongsByUrls(UnorderedElementsAre(
+                  QUrl::fromLocalFile("/music/a.mp3"),
+                  QUrl::fromLocalFile("/music/b.mp3"))))
+      .WillOnce(Return(library_songs));
+
+  ASXParser parser(&library);
+  SongList songs = parser.Load(&buffer);
+  ASSERT_EQ(2, songs.count());
+  EXPECT_EQ(1, songs[0].id());
+  EXPECT_EQ(QUrl::fromLocalFile("/music/a.mp3"), songs[0].url());
+  EXPECT_EQ(2, songs[1].id());
+  EXPECT_EQ(QUrl::fromLocalFile("/music/b.mp3"), songs[1].url());
+}
+
 TEST_F(ASXParserTest, ParsesBrokenXmlEntities) {
   QByteArray data =
       "<asx version = \"3.0\">"
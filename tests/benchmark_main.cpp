@@ -0,0 +1,51 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <QApplication>
+#include <QModelIndex>
+#include <QResource>
+
+#include "core/logging.h"
+#include "core/song.h"
+#include "library/directory.h"
+
+// Like the tests' main, without gtest.  Pass --benchmark_out=file.json
+// --benchmark_out_format=json for a machine readable report.  The library
+// and playlist models load icons, so this needs a GUI application.
+int main(int argc, char** argv) {
+  QApplication a(argc, argv);
+
+  qRegisterMetaType<Directory>("Directory");
+  qRegisterMetaType<DirectoryList>("DirectoryList");
+  qRegisterMetaType<Subdirectory>("Subdirectory");
+  qRegisterMetaType<SubdirectoryList>("SubdirectoryList");
+  qRegisterMetaType<SongList>("SongList");
+  qRegisterMetaType<QModelIndex>("QModelIndex");
+
+  Q_INIT_RESOURCE(data);
+
+  // Logging from the code being measured would be measured too.
+  logging::Init();
+  logging::SetLevels("*:1");
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
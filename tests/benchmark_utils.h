@@ -0,0 +1,66 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARK_UTILS_H
+#define BENCHMARK_UTILS_H
+
+#include <benchmark/benchmark.h>
+
+#include <QString>
+#include <QUrl>
+
+#include "core/song.h"
+#include "core/timeconstants.h"
+
+// Runs a benchmark over libraries of 10k, 100k and 1M songs.
+inline void SongCounts(benchmark::internal::Benchmark* b) {
+  b->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+}
+
+// The i'th song of a made up library laid out like a real one: ten tracks to
+// an album, five albums to an artist.  Titles are scrambled so they don't
+// sort in the order they were added.
+inline Song MakeSong(int i) {
+  const int album = i / 10;
+  const int artist = album / 5;
+
+  Song song;
+  song.Init(QString("Track %1").arg((i * 7919) % 1000003),
+            QString("Artist %1").arg(artist), QString("Album %1").arg(album),
+            (120 + (i * 31) % 300) * kNsecPerSec);
+  song.set_track(i % 10 + 1);
+  song.set_year(1960 + artist % 60);
+  song.set_genre(QString("Genre %1").arg(artist % 20));
+  song.set_filetype(Song::Type_Mpeg);
+  song.set_directory_id(1);
+  song.set_url(QUrl::fromLocalFile(
+      QString("/music/Artist %1/Album %2/%3.mp3").arg(artist).arg(album).arg(
+          i)));
+  song.set_mtime(1);
+  song.set_ctime(1);
+  song.set_filesize(5000000);
+  return song;
+}
+
+inline SongList MakeSongs(int count) {
+  SongList ret;
+  ret.reserve(count);
+  for (int i = 0; i < count; ++i) ret << MakeSong(i);
+  return ret;
+}
+
+#endif  // BENCHMARK_UTILS_H
@@ -0,0 +1,63 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/bktree.h"
+
+#include <QStringList>
+
+namespace {
+
+TEST(BKTreeTest, Distance) {
+  EXPECT_EQ(0, BKTree::Distance("beatles", "beatles"));
+  EXPECT_EQ(2, BKTree::Distance("beatles", "beatels"));
+  EXPECT_EQ(3, BKTree::Distance("kitten", "sitting"));
+  EXPECT_EQ(4, BKTree::Distance("", "abba"));
+  EXPECT_EQ(4, BKTree::Distance("abba", ""));
+}
+
+TEST(BKTreeTest, Find) {
+  BKTree tree;
+  tree.Insert("beatles");
+  tree.Insert("beat");
+  tree.Insert("metallica");
+  tree.Insert("beatles");
+  tree.Insert("beastie");
+  EXPECT_EQ(4, tree.count());
+
+  QStringList matches;
+  for (const BKTree::Match& match : tree.Find("beetles", 1)) {
+    matches << match.first;
+  }
+  EXPECT_EQ(QStringList() << "beatles", matches);
+
+  matches.clear();
+  for (const BKTree::Match& match : tree.Find("beatle", 2)) {
+    matches << match.first;
+  }
+  matches.sort();
+  EXPECT_EQ(QStringList() << "beastie"
+                          << "beat"
+                          << "beatles",
+            matches);
+
+  EXPECT_TRUE(tree.Find("zappa", 1).isEmpty());
+}
+
+}  // namespace
@@ -0,0 +1,90 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "covers/coverprovider.h"
+#include "covers/coverproviders.h"
+
+namespace {
+
+class FakeCoverProvider : public CoverProvider {
+ public:
+  explicit FakeCoverProvider(const QString& name)
+      : CoverProvider(name, true, nullptr) {}
+
+  bool StartSearch(const QString&, const QString&, int) { return true; }
+};
+
+class CoverProvidersTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    providers_.AddProvider(&fast_);
+    providers_.AddProvider(&slow_);
+    providers_.AddProvider(&new_);
+  }
+
+  void TearDown() {
+    providers_.RemoveProvider(&fast_);
+    providers_.RemoveProvider(&slow_);
+    providers_.RemoveProvider(&new_);
+  }
+
+  FakeCoverProvider fast_{"fast"};
+  FakeCoverProvider slow_{"slow"};
+  FakeCoverProvider new_{"new"};
+  CoverProviders providers_;
+};
+
+TEST_F(CoverProvidersTest, NewProvidersGoBetweenGoodAndBad) {
+  for (int i = 0; i < 10; ++i) {
+    providers_.ProviderSearched("fast", 200, true);
+    providers_.ProviderChosen("fast");
+    providers_.ProviderSearched("slow", 5000, false);
+  }
+
+  QList<CoverProvider*> expected;
+  expected << &fast_ << &new_ << &slow_;
+  EXPECT_EQ(expected, providers_.ListByHistory());
+}
+
+TEST_F(CoverProvidersTest, ChosenBeatsFast) {
+  for (int i = 0; i < 10; ++i) {
+    providers_.ProviderSearched("fast", 200, false);
+    providers_.ProviderSearched("slow", 1500, true);
+    providers_.ProviderChosen("slow");
+  }
+
+  EXPECT_EQ(&slow_, providers_.ListByHistory().first());
+}
+
+TEST_F(CoverProvidersTest, OldHistoryFades) {
+  for (int i = 0; i < 200; ++i) {
+    providers_.ProviderSearched("slow", 200, true);
+    providers_.ProviderChosen("slow");
+  }
+  for (int i = 0; i < 300; ++i) {
+    providers_.ProviderSearched("slow", 200, false);
+    providers_.ProviderSearched("fast", 200, true);
+    providers_.ProviderChosen("fast");
+  }
+
+  EXPECT_EQ(&fast_, providers_.ListByHistory().first());
+}
+
+}  // namespace
@@ -29,7 +29,7 @@
 class DatabaseTest : public ::testing::Test {
  protected:
   virtual void SetUp() {
-    database_.reset(new MemoryDatabase);
+    database_.reset(new MemoryDatabase(nullptr));
   }
 
   std::unique_ptr<Database> database_;
@@ -53,6 +53,33 @@ TEST_F(DatabaseTest, DatabaseInitialises) {
   EXPECT_FALSE(q.next());
 }
 
+TEST_F(DatabaseTest, CachedQueries) {
+  QSqlDatabase db = database_->Connect();
+  const QString sql = "SELECT version FROM schema_version WHERE version > ?";
+
+  {
+    std::shared_ptr<QSqlQuery> q = database_->CachedQuery(db, sql);
+    q->bindValue(0, 0);
+    ASSERT_TRUE(q->exec());
+    ASSERT_TRUE(q->next());
+    EXPECT_EQ(Database::kSchemaVersion, q->value(0).toInt());
+  }
+  EXPECT_EQ(0, database_->statement_cache_hits());
+  EXPECT_EQ(1, database_->statement_cache_misses());
+
+  // The second time the statement is already prepared.
+  std::shared_ptr<QSqlQuery> q = database_->CachedQuery(db, sql);
+  EXPECT_EQ(1, database_->statement_cache_hits());
+  q->bindValue(0, Database::kSchemaVersion);
+  ASSERT_TRUE(q->exec());
+  EXPECT_FALSE(q->next());
+
+  // Another user of the same SQL while q is out gets its own statement.
+  std::shared_ptr<QSqlQuery> q2 = database_->CachedQuery(db, sql);
+  EXPECT_NE(q.get(), q2.get());
+  EXPECT_EQ(2, database_->statement_cache_misses());
+}
+
 TEST_F(DatabaseTest, FTSOpenParsesSimpleInput) {
   sqlite3_tokenizer_cursor* cursor = nullptr;
   Database::FTSOpen(nullptr, "foo", 3, &cursor);
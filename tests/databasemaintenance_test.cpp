@@ -0,0 +1,75 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/database.h"
+#include "core/databasemaintenance.h"
+
+#include <QSqlQuery>
+#include <QVariant>
+#include <memory>
+
+namespace {
+
+class DatabaseMaintenanceTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    database_.reset(new MemoryDatabase(nullptr));
+    maintenance_.reset(new DatabaseMaintenance(nullptr, database_.get()));
+  }
+
+  QVariant Pragma(const QString& pragma) {
+    QSqlQuery q(database_->Connect());
+    if (!q.exec("PRAGMA " + pragma) || !q.next()) return QVariant();
+    return q.value(0);
+  }
+
+  std::unique_ptr<Database> database_;
+  std::unique_ptr<DatabaseMaintenance> maintenance_;
+};
+
+TEST_F(DatabaseMaintenanceTest, RunsEveryStep) {
+  EXPECT_NE(2, Pragma("auto_vacuum").toInt());
+
+  int runs = 0;
+  while (maintenance_->RunStep()) {
+    ASSERT_LT(++runs, 100);
+  }
+  EXPECT_EQ(DatabaseMaintenance::Step_Done, maintenance_->step());
+
+  // The database has been analyzed and switched to incremental vacuum.
+  EXPECT_TRUE(database_->Connect().tables().contains("sqlite_stat1"));
+  EXPECT_EQ(2, Pragma("auto_vacuum").toInt());
+  EXPECT_EQ(0, Pragma("freelist_count").toInt());
+}
+
+TEST_F(DatabaseMaintenanceTest, InterruptKeepsTheStep) {
+  maintenance_->Interrupt();
+  EXPECT_TRUE(maintenance_->RunStep());
+  EXPECT_EQ(DatabaseMaintenance::Step_QuickCheck, maintenance_->step());
+}
+
+TEST_F(DatabaseMaintenanceTest, StepNames) {
+  EXPECT_EQ("quick_check", DatabaseMaintenance::StepName(
+                               DatabaseMaintenance::Step_QuickCheck));
+  EXPECT_EQ("vacuum", DatabaseMaintenance::StepName(
+                          DatabaseMaintenance::Step_Vacuum));
+}
+
+}  // namespace
@@ -0,0 +1,86 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/database.h"
+#include "musicbrainz/discidcache.h"
+
+#include <QDateTime>
+#include <QSqlQuery>
+#include <memory>
+
+namespace {
+
+class DiscIdCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() { database_.reset(new MemoryDatabase(nullptr)); }
+
+  static MusicBrainzClient::ResultList MakeTracks() {
+    MusicBrainzClient::ResultList ret;
+    for (int i = 1; i <= 3; ++i) {
+      MusicBrainzClient::Result track;
+      track.title_ = QString("Track %1").arg(i);
+      track.artist_ = "Artist";
+      track.album_ = "Album";
+      track.duration_msec_ = i * 1000;
+      track.track_ = i;
+      track.year_ = 1999;
+      ret << track;
+    }
+    return ret;
+  }
+
+  std::unique_ptr<Database> database_;
+};
+
+TEST_F(DiscIdCacheTest, UnknownDisc) {
+  DiscIdCache cache(database_.get());
+  EXPECT_FALSE(cache.Lookup("nothing").is_valid());
+}
+
+TEST_F(DiscIdCacheTest, StoresTracks) {
+  DiscIdCache cache(database_.get());
+  cache.Store("discid", "Artist", "Album", MakeTracks());
+
+  const DiscIdCache::Entry entry = cache.Lookup("discid");
+  ASSERT_TRUE(entry.is_valid());
+  EXPECT_FALSE(entry.is_stale());
+  EXPECT_EQ("Artist", entry.artist_);
+  EXPECT_EQ("Album", entry.album_);
+  EXPECT_EQ(MakeTracks(), entry.tracks_);
+}
+
+TEST_F(DiscIdCacheTest, OldEntriesAreStale) {
+  DiscIdCache cache(database_.get());
+  cache.Store("discid", "Artist", "Album", MakeTracks());
+
+  QSqlQuery q(database_->Connect());
+  q.prepare("UPDATE musicbrainz_discids SET fetched = :fetched");
+  q.bindValue(":fetched", QDateTime::currentDateTime()
+                              .addDays(-DiscIdCache::kMaxAgeDays)
+                              .toTime_t());
+  ASSERT_TRUE(q.exec());
+
+  // Still there for when MusicBrainz can't be reached.
+  const DiscIdCache::Entry entry = cache.Lookup("discid");
+  ASSERT_TRUE(entry.is_valid());
+  EXPECT_TRUE(entry.is_stale());
+}
+
+}  // namespace
@@ -0,0 +1,155 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "gst/dsp/dspprocessor.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int kRate = 44100;
+
+std::vector<float> Noise(int samples) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> value(-0.5, 0.5);
+  std::vector<float> ret(samples);
+  for (float& sample : ret) sample = value(random);
+  return ret;
+}
+
+// Runs one channel through the filters in double precision.
+std::vector<double> Reference(const std::vector<float>& samples, int channel,
+                              int channels, const float* gains) {
+  std::vector<double> ret;
+  for (int i = channel; i < int(samples.size()); i += channels) {
+    ret.push_back(samples[i]);
+  }
+
+  float last_frequency = 0;
+  for (int band = 0; band < DspProcessor::kBands; ++band) {
+    const float frequency = DspProcessor::kBandFrequencies[band];
+    const DspProcessor::Filter f = DspProcessor::Peaking(
+        frequency, frequency - last_frequency, gains[band], kRate);
+    last_frequency = frequency;
+    if (gains[band] == 0) continue;
+
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    for (double& sample : ret) {
+      const double y =
+          f.b0_ * sample + f.b1_ * x1 + f.b2_ * x2 - f.a1_ * y1 - f.a2_ * y2;
+      x2 = x1;
+      x1 = sample;
+      y2 = y1;
+      y1 = y;
+      sample = y;
+    }
+  }
+  return ret;
+}
+
+TEST(DspProcessorTest, Passthrough) {
+  const float gains[DspProcessor::kBands] = {};
+  DspProcessor processor;
+  processor.Configure(kRate, 2, 1, 0, gains);
+  EXPECT_TRUE(processor.is_passthrough());
+
+  const std::vector<float> input = Noise(64);
+  std::vector<float> output = input;
+  processor.Process(output.data(), 32);
+  EXPECT_EQ(input, output);
+
+  // Balance does nothing to mono.
+  processor.Configure(kRate, 1, 1, 0.5, gains);
+  EXPECT_TRUE(processor.is_passthrough());
+  processor.Configure(kRate, 2, 1, 0.5, gains);
+  EXPECT_FALSE(processor.is_passthrough());
+}
+
+TEST(DspProcessorTest, PeakingGainAtCentre) {
+  const DspProcessor::Filter f = DspProcessor::Peaking(1000, 400, 6, kRate);
+
+  // The magnitude of the response at the centre frequency.
+  const double w = 2 * M_PI * 1000 / kRate;
+  const double re_num = f.b0_ + f.b1_ * std::cos(w) + f.b2_ * std::cos(2 * w);
+  const double im_num = -f.b1_ * std::sin(w) - f.b2_ * std::sin(2 * w);
+  const double re_den = 1 + f.a1_ * std::cos(w) + f.a2_ * std::cos(2 * w);
+  const double im_den = -f.a1_ * std::sin(w) - f.a2_ * std::sin(2 * w);
+  const double magnitude = std::sqrt(re_num * re_num + im_num * im_num) /
+                           std::sqrt(re_den * re_den + im_den * im_den);
+  EXPECT_NEAR(6, 20 * std::log10(magnitude), 0.01);
+}
+
+TEST(DspProcessorTest, StereoMatchesReference) {
+  const float gains[DspProcessor::kBands] = {6, 0, -12, 3, 0, 0, -6, 12, 0, 4};
+  const int kFrames = 4096;
+
+  DspProcessor processor;
+  processor.Configure(kRate, 2, 1, 0, gains);
+  const std::vector<float> input = Noise(kFrames * 2);
+  std::vector<float> output = input;
+  // In two buffers, so the history is carried over.
+  processor.Process(output.data(), kFrames / 2);
+  processor.Process(output.data() + kFrames, kFrames / 2);
+
+  for (int channel = 0; channel < 2; ++channel) {
+    const std::vector<double> expected = Reference(input, channel, 2, gains);
+    for (int i = 0; i < kFrames; ++i) {
+      ASSERT_NEAR(expected[i], output[i * 2 + channel], 1e-3) << i;
+    }
+  }
+}
+
+TEST(DspProcessorTest, MonoMatchesReference) {
+  const float gains[DspProcessor::kBands] = {0, 5, 0, 0, -8, 0, 0, 0, 2, 0};
+  const int kFrames = 2048;
+
+  DspProcessor processor;
+  processor.Configure(kRate, 1, 0.5, 0, gains);
+  const std::vector<float> input = Noise(kFrames);
+  std::vector<float> output = input;
+  processor.Process(output.data(), kFrames);
+
+  const std::vector<double> expected = Reference(input, 0, 1, gains);
+  for (int i = 0; i < kFrames; ++i) {
+    ASSERT_NEAR(expected[i] * 0.5, output[i], 1e-3) << i;
+  }
+}
+
+TEST(DspProcessorTest, Balance) {
+  const float gains[DspProcessor::kBands] = {};
+  DspProcessor processor;
+
+  float frame[] = {0.4, 0.2};
+  processor.Configure(kRate, 2, 2, 0.25, gains);
+  processor.Process(frame, 1);
+  // Some of the left moves over to the right.
+  EXPECT_FLOAT_EQ(2 * 0.4 * 0.75, frame[0]);
+  EXPECT_FLOAT_EQ(2 * (0.2 + 0.4 * 0.25), frame[1]);
+
+  float other[] = {0.4, 0.2};
+  processor.Configure(kRate, 2, 1, -1, gains);
+  processor.Process(other, 1);
+  EXPECT_FLOAT_EQ(0.6, other[0]);
+  EXPECT_FLOAT_EQ(0, other[1]);
+}
+
+}  // namespace
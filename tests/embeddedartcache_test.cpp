@@ -0,0 +1,84 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/embeddedartcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+
+class EmbeddedArtCacheTest : public ::testing::Test {
+ protected:
+  QString WriteSong(const QString& name, const QByteArray& contents) {
+    const QString filename = dir_.path() + "/" + name;
+    QFile file(filename);
+    file.open(QIODevice::WriteOnly);
+    file.write(contents);
+    return filename;
+  }
+
+  QTemporaryDir dir_;
+};
+
+TEST_F(EmbeddedArtCacheTest, PutAndGet) {
+  EmbeddedArtCache cache(dir_.path() + "/cache");
+  const QString song = WriteSong("song.mp3", "song");
+
+  QByteArray data;
+  EXPECT_FALSE(cache.Get(song, &data));
+
+  cache.Put(song, "art");
+  ASSERT_TRUE(cache.Get(song, &data));
+  EXPECT_EQ(QByteArray("art"), data);
+}
+
+TEST_F(EmbeddedArtCacheTest, RemembersSongsWithoutArt) {
+  EmbeddedArtCache cache(dir_.path() + "/cache");
+  const QString song = WriteSong("song.mp3", "song");
+
+  cache.Put(song, QByteArray());
+  QByteArray data = "old";
+  EXPECT_TRUE(cache.Get(song, &data));
+  EXPECT_TRUE(data.isEmpty());
+}
+
+TEST_F(EmbeddedArtCacheTest, ChangedSongIsMissed) {
+  EmbeddedArtCache cache(dir_.path() + "/cache");
+  const QString song = WriteSong("song.mp3", "song");
+  cache.Put(song, "art");
+
+  // Different size, so it's different whatever the mtime resolution is.
+  WriteSong("song.mp3", "new tags");
+  QByteArray data;
+  EXPECT_FALSE(cache.Get(song, &data));
+}
+
+TEST_F(EmbeddedArtCacheTest, SharesArt) {
+  EmbeddedArtCache cache(dir_.path() + "/cache");
+  cache.Put(WriteSong("one.mp3", "one"), "art");
+  cache.Put(WriteSong("two.mp3", "two"), "art");
+
+  const QDir art_dir(dir_.path() + "/cache/art");
+  EXPECT_EQ(1, art_dir.entryList(QDir::Files).count());
+}
+
+}  // namespace
@@ -0,0 +1,73 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/executor.h"
+
+#include <QSemaphore>
+
+namespace {
+
+TEST(ExecutorTest, ReturnsResults) {
+  Executor executor("test", 2);
+  QFuture<int> future = executor.Run<int>([]() { return 42; });
+  EXPECT_EQ(42, future.result());
+
+  bool ran = false;
+  executor.Run<void>([&ran]() { ran = true; }).waitForFinished();
+  EXPECT_TRUE(ran);
+  EXPECT_EQ(2, executor.completed());
+}
+
+TEST(ExecutorTest, CountsQueuedAndActiveTasks) {
+  Executor executor("test", 1);
+  QSemaphore started;
+  QSemaphore release;
+
+  // The first task holds the only thread, so the others have to wait.
+  QFuture<void> first = executor.Run<void>([&]() {
+    started.release();
+    release.acquire();
+  });
+  started.acquire();
+  QFuture<void> second = executor.Run<void>([]() {});
+  QFuture<void> third = executor.Run<void>([]() {});
+
+  EXPECT_EQ(1, executor.active());
+  EXPECT_EQ(2, executor.queued());
+  EXPECT_EQ(2, executor.peak_queued());
+
+  release.release();
+  first.waitForFinished();
+  second.waitForFinished();
+  third.waitForFinished();
+
+  EXPECT_EQ(0, executor.queued());
+  EXPECT_EQ(3, executor.completed());
+  EXPECT_EQ(2, executor.peak_queued());
+}
+
+TEST(ExecutorTest, NamedPools) {
+  EXPECT_EQ("io", Executor::Io()->name());
+  EXPECT_EQ("cpu", Executor::Cpu()->name());
+  EXPECT_EQ("db", Executor::Db()->name());
+  EXPECT_EQ(Executor::Io(), Executor::Io());
+}
+
+}  // namespace
@@ -0,0 +1,70 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/fasthash.h"
+
+#include <QBuffer>
+
+namespace {
+
+QByteArray HexHash(const QByteArray& data) {
+  return FastHash::Hash(data).toHex();
+}
+
+TEST(FastHashTest, KnownValues) {
+  // MurmurHash3_x64_128 with a seed of 0.
+  EXPECT_EQ("00000000000000000000000000000000", HexHash(""));
+  EXPECT_EQ("029bbd41b3a7d8cb191dae486a901e5b", HexHash("hello"));
+  EXPECT_EQ("6c1b07bc7bbc4be347939ac4a93c437a",
+            HexHash("The quick brown fox jumps over the lazy dog"));
+}
+
+TEST(FastHashTest, PiecesMatchWhole) {
+  QByteArray data;
+  for (int i = 0; i < 1000; ++i) data.append(static_cast<char>(i * 31));
+
+  for (int piece : {1, 3, 15, 16, 17, 100}) {
+    FastHash hash;
+    for (int pos = 0; pos < data.size(); pos += piece) {
+      hash.AddData(data.mid(pos, piece));
+    }
+    EXPECT_EQ(FastHash::Hash(data), hash.Result()) << piece;
+  }
+}
+
+TEST(FastHashTest, ResultCanBeTakenPartWay) {
+  FastHash hash;
+  hash.AddData("hello");
+  EXPECT_EQ(FastHash::Hash("hello"), hash.Result());
+  hash.AddData(" world");
+  EXPECT_EQ(FastHash::Hash("hello world"), hash.Result());
+
+  hash.Reset();
+  EXPECT_EQ(FastHash::Hash(""), hash.Result());
+}
+
+TEST(FastHashTest, HashesDevices) {
+  QByteArray data(3 * 1024 * 1024 + 7, 'x');
+  QBuffer buffer(&data);
+  EXPECT_EQ(FastHash::Hash(data), FastHash::Hash(&buffer));
+  EXPECT_FALSE(buffer.isOpen());
+}
+
+}  // namespace
@@ -0,0 +1,45 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "analyzers/fht.h"
+
+namespace {
+
+// One analyzer frame: the power spectrum of 2^n samples.
+void BM_FHTPower2(benchmark::State& state) {
+  FHT fht(state.range(0));
+  std::vector<float> samples(fht.size());
+  for (int i = 0; i < fht.size(); ++i) {
+    samples[i] = std::sin(2 * M_PI * i / 64);
+  }
+
+  std::vector<float> buffer(fht.size());
+  for (auto _ : state) {
+    buffer = samples;
+    fht.power2(buffer.data());
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations() * fht.size());
+}
+BENCHMARK(BM_FHTPower2)->DenseRange(7, 11);
+
+}  // namespace
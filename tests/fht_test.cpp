@@ -0,0 +1,166 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "analyzers/fht.h"
+#include "analyzers/fhtkernels.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtDebug>
+
+#include <cmath>
+
+namespace {
+
+QVector<float> Noise(int n, unsigned int seed) {
+  QVector<float> ret(n);
+  for (int i = 0; i < n; ++i) {
+    seed = seed * 1103515245 + 12345;
+    ret[i] = static_cast<float>((seed >> 16) & 0x7fff) / 0x7fff - 0.5f;
+  }
+  return ret;
+}
+
+void ExpectNear(const QVector<float>& expected, const QVector<float>& actual,
+                const char* kernels) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-4 * (1 + std::fabs(expected[i])))
+        << kernels << " at " << i;
+  }
+}
+
+TEST(FHTTest, Transform8MatchesRecursive) {
+  // A 16 point transform recurses into two 8 point ones, so transforming
+  // an impulse should give a flat spectrum either way.
+  for (int exp : {3, 4, 5}) {
+    FHT fht(exp);
+    QVector<float> data(fht.size());
+    data[0] = 1;
+    fht.transform(data.data());
+    for (int i = 0; i < data.size(); ++i) EXPECT_FLOAT_EQ(1, data[i]);
+  }
+}
+
+TEST(FHTTest, KernelsMatchScalar) {
+  for (const FHTKernels* kernels : FHTKernels::Available()) {
+    // The smallest sizes are handled entirely by the scalar tail loops.
+    for (int exp = 3; exp <= 11; ++exp) {
+      FHT scalar(exp);
+      scalar.set_kernels(&FHTKernels::Scalar());
+      FHT fht(exp);
+      fht.set_kernels(kernels);
+
+      const QVector<float> input = Noise(scalar.size(), exp);
+
+      QVector<float> expected = input;
+      QVector<float> actual = input;
+      scalar.transform(expected.data());
+      fht.transform(actual.data());
+      ExpectNear(expected, actual, kernels->name);
+
+      expected = input;
+      actual = input;
+      scalar.power2(expected.data());
+      fht.power2(actual.data());
+      ExpectNear(expected.mid(0, scalar.size() / 2),
+                 actual.mid(0, scalar.size() / 2), kernels->name);
+
+      expected = input;
+      actual = input;
+      scalar.scale(expected.data(), 3.5f);
+      fht.scale(actual.data(), 3.5f);
+      ExpectNear(expected, actual, kernels->name);
+
+      QVector<float> fresh = Noise(scalar.size(), exp + 100);
+      expected = input;
+      actual = input;
+      scalar.ewma(expected.data(), fresh.data(), 0.7f);
+      fht.ewma(actual.data(), fresh.data(), 0.7f);
+      ExpectNear(expected, actual, kernels->name);
+    }
+  }
+}
+
+TEST(FHTTest, KernelsHandleOddSizes) {
+  // deinterleave and butterfly are also used directly with sizes that
+  // aren't a multiple of the vector width.
+  for (const FHTKernels* kernels : FHTKernels::Available()) {
+    for (int n = 1; n < 40; ++n) {
+      const QVector<float> in = Noise(n * 2, n);
+      QVector<float> even(n), odd(n);
+      kernels->deinterleave(in.constData(), even.data(), odd.data(), n);
+      for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(in[i * 2], even[i]) << kernels->name;
+        EXPECT_EQ(in[i * 2 + 1], odd[i]) << kernels->name;
+      }
+
+      const QVector<float> lo = Noise(n, n + 1);
+      const QVector<float> hi = Noise(n, n + 2);
+      const QVector<float> cos = Noise(n, n + 3);
+      const QVector<float> sin = Noise(n, n + 4);
+      QVector<float> expected_lo(n), expected_hi(n);
+      QVector<float> actual_lo(n), actual_hi(n);
+      FHTKernels::Scalar().butterfly(lo.constData(), hi.constData(),
+                                     cos.constData(), sin.constData(),
+                                     expected_lo.data(), expected_hi.data(), n);
+      kernels->butterfly(lo.constData(), hi.constData(), cos.constData(),
+                         sin.constData(), actual_lo.data(), actual_hi.data(),
+                         n);
+      ExpectNear(expected_lo, actual_lo, kernels->name);
+      ExpectNear(expected_hi, actual_hi, kernels->name);
+    }
+  }
+}
+
+// Compares the speed of each version of the kernels.  Disabled because it
+// only prints timings, run it with --gtest_also_run_disabled_tests.
+TEST(FHTTest, DISABLED_Benchmark) {
+  const int kIterations = 20000;
+
+  for (int exp : {9, 11}) {
+    const QVector<float> input = Noise(1 << exp, exp);
+    qint64 scalar_nsec = 0;
+
+    for (const FHTKernels* kernels : FHTKernels::Available()) {
+      FHT fht(exp);
+      fht.set_kernels(kernels);
+      QVector<float> data = input;
+      QVector<float> average(fht.size());
+
+      QElapsedTimer timer;
+      timer.start();
+      for (int i = 0; i < kIterations; ++i) {
+        std::copy(input.constBegin(), input.constEnd(), data.begin());
+        fht.power2(data.data());
+        fht.scale(data.data(), 1.0f / 20);
+        fht.ewma(average.data(), data.data(), 0.75f);
+      }
+      const qint64 nsec = timer.nsecsElapsed();
+      if (kernels == &FHTKernels::Scalar()) scalar_nsec = nsec;
+
+      qDebug() << "FHT size" << fht.size() << kernels->name << "-"
+               << nsec / kIterations << "ns per frame,"
+               << static_cast<double>(scalar_nsec) / nsec << "x scalar";
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,114 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "library/fingerprintindex.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+typedef FingerprintIndex::Fingerprint Fingerprint;
+
+Fingerprint RandomFingerprint(std::mt19937* random, int size) {
+  Fingerprint ret(size);
+  for (quint32& item : ret) item = (*random)();
+  return ret;
+}
+
+// Flips each bit with the given probability, like a different encode of the
+// same audio would.
+Fingerprint AddNoise(const Fingerprint& fingerprint, double probability,
+                     std::mt19937* random) {
+  std::bernoulli_distribution flip(probability);
+  Fingerprint ret(fingerprint);
+  for (quint32& item : ret) {
+    for (int bit = 0; bit < 32; ++bit) {
+      if (flip(*random)) item ^= 1u << bit;
+    }
+  }
+  return ret;
+}
+
+TEST(FingerprintIndexTest, PackAndUnpack) {
+  const Fingerprint fingerprint = {0, 1, 0xdeadbeef, 0xffffffff};
+  const QByteArray packed = FingerprintIndex::Pack(fingerprint);
+
+  EXPECT_EQ(16, packed.size());
+  EXPECT_EQ(char(0xef), packed[8]);
+  EXPECT_EQ(fingerprint, FingerprintIndex::Unpack(packed));
+}
+
+TEST(FingerprintIndexTest, Similarity) {
+  std::mt19937 random(1);
+  const Fingerprint a = RandomFingerprint(&random, 100);
+
+  EXPECT_DOUBLE_EQ(1.0, FingerprintIndex::Similarity(a, a));
+  EXPECT_GT(FingerprintIndex::Similarity(a, AddNoise(a, 0.05, &random)), 0.9);
+  EXPECT_LT(
+      FingerprintIndex::Similarity(a, RandomFingerprint(&random, 100), 0),
+      0.6);
+  EXPECT_DOUBLE_EQ(0, FingerprintIndex::Similarity(a, Fingerprint()));
+}
+
+TEST(FingerprintIndexTest, SimilarityLinesUpOffsets) {
+  std::mt19937 random(2);
+  const Fingerprint a = RandomFingerprint(&random, 100);
+  const Fingerprint later(a.begin() + 5, a.end());
+
+  EXPECT_DOUBLE_EQ(1.0, FingerprintIndex::Similarity(a, later));
+  EXPECT_LT(FingerprintIndex::Similarity(a, later, 2), 0.6);
+}
+
+TEST(FingerprintIndexTest, FindsDuplicates) {
+  std::mt19937 random(3);
+  FingerprintIndex index;
+
+  const Fingerprint original = RandomFingerprint(&random, 120);
+  index.Add(1, original);
+  for (int id = 2; id < 200; ++id) {
+    index.Add(id, RandomFingerprint(&random, 120));
+  }
+  index.Add(200, AddNoise(original, 0.03, &random));
+  index.Add(201, Fingerprint(original.begin() + 3, original.end()));
+
+  const QList<QList<int>> duplicates = index.FindDuplicates();
+  ASSERT_EQ(1, duplicates.count());
+
+  QList<int> group = duplicates[0];
+  std::sort(group.begin(), group.end());
+  EXPECT_EQ(QList<int>() << 1 << 200 << 201, group);
+}
+
+TEST(FingerprintIndexTest, IgnoresSilence) {
+  // Songs that only have silence in common aren't duplicates.
+  std::mt19937 random(4);
+  FingerprintIndex index;
+  for (int id = 0; id < 100; ++id) {
+    Fingerprint fingerprint(40, 0);
+    const Fingerprint rest = RandomFingerprint(&random, 80);
+    fingerprint.insert(fingerprint.end(), rest.begin(), rest.end());
+    index.Add(id, fingerprint);
+  }
+
+  EXPECT_TRUE(index.FindDuplicates().isEmpty());
+}
+
+}  // namespace
@@ -0,0 +1,60 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/latencystats.h"
+
+namespace {
+
+TEST(LatencyStatsTest, Summaries) {
+  LatencyStats stats;
+  for (int i = 100; i >= 1; --i) stats.Record("b", i * 1000);
+  stats.Record("a", 5);
+
+  QList<LatencyStats::Summary> summaries = stats.Summaries();
+  ASSERT_EQ(2, summaries.count());
+
+  EXPECT_EQ("b", summaries[0].name_);
+  EXPECT_EQ(100, summaries[0].count_);
+  EXPECT_EQ(1000, summaries[0].min_usec_);
+  EXPECT_EQ(51000, summaries[0].median_usec_);
+  EXPECT_EQ(91000, summaries[0].p90_usec_);
+  EXPECT_EQ(100000, summaries[0].max_usec_);
+
+  EXPECT_EQ("a", summaries[1].name_);
+  EXPECT_EQ(1, summaries[1].count_);
+  EXPECT_EQ(5, summaries[1].median_usec_);
+}
+
+TEST(LatencyStatsTest, KeepsRecentSamples) {
+  LatencyStats stats;
+  for (int i = 0; i < LatencyStats::kMaxSamples + 10; ++i) {
+    stats.Record("a", i);
+  }
+
+  QList<LatencyStats::Summary> summaries = stats.Summaries();
+  ASSERT_EQ(1, summaries.count());
+  EXPECT_EQ(LatencyStats::kMaxSamples, summaries[0].count_);
+  EXPECT_EQ(10, summaries[0].min_usec_);
+
+  stats.Clear();
+  EXPECT_TRUE(stats.Summaries().isEmpty());
+}
+
+}  // namespace
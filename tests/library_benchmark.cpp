@@ -0,0 +1,136 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmark_utils.h"
+
+#include <QMutexLocker>
+#include <memory>
+
+#include "core/database.h"
+#include "library/library.h"
+#include "library/librarybackend.h"
+#include "library/librarymodel.h"
+#include "library/libraryquery.h"
+#include "library/sqlrow.h"
+
+namespace {
+
+// A library of count songs in an in-memory database.
+class LibraryFixture {
+ public:
+  explicit LibraryFixture(int count)
+      : count_(count),
+        database_(new MemoryDatabase(nullptr)),
+        backend_(new LibraryBackend) {
+    backend_->Init(database_.get(), Library::kSongsTable, Library::kDirsTable,
+                   Library::kSubdirsTable, Library::kFtsTable);
+    backend_->AddDirectory("/music");
+  }
+
+  // Making a library of a million songs takes a while, so the last one is
+  // kept for the next benchmark that wants one the same size.
+  static LibraryFixture* Filled(int count) {
+    static std::unique_ptr<LibraryFixture> sFixture;
+    if (!sFixture || sFixture->count_ != count) {
+      sFixture.reset();
+      sFixture.reset(new LibraryFixture(count));
+
+      LibraryBackend::BulkReplace writer(sFixture->backend());
+      for (int i = 0; i < count; ++i) writer.Add(MakeSong(i));
+      writer.Commit();
+    }
+    return sFixture.get();
+  }
+
+  LibraryBackend* backend() const { return backend_.get(); }
+
+ private:
+  const int count_;
+  std::shared_ptr<Database> database_;
+  std::unique_ptr<LibraryBackend> backend_;
+};
+
+// What a full scan of a new library ends with: every song it found written in
+// one go.
+void BM_AddOrUpdateSongs(benchmark::State& state) {
+  const SongList songs = MakeSongs(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<LibraryFixture> fixture(new LibraryFixture(songs.count()));
+    state.ResumeTiming();
+
+    fixture->backend()->AddOrUpdateSongs(songs);
+
+    state.PauseTiming();
+    fixture.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * songs.count());
+}
+BENCHMARK(BM_AddOrUpdateSongs)->Apply(SongCounts);
+
+// Reads every song in the library, either straight from the query the way
+// ExecLibraryQuery does, or through a SqlRow like the playlist items.
+template <bool kThroughSqlRow>
+void InitFromQuery(benchmark::State& state) {
+  LibraryFixture* fixture = LibraryFixture::Filled(state.range(0));
+
+  int64_t total = 0;
+  for (auto _ : state) {
+    LibraryQuery query;
+    query.SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
+    QMutexLocker l(fixture->backend()->db()->ReadMutex());
+    fixture->backend()->ExecQuery(&query);
+
+    while (query.Next()) {
+      Song song;
+      if (kThroughSqlRow) {
+        song.InitFromQuery(SqlRow(query), true);
+      } else {
+        song.InitFromQuery(query, true);
+      }
+      benchmark::DoNotOptimize(song);
+      ++total;
+    }
+  }
+  state.SetItemsProcessed(total);
+}
+
+void BM_SongInitFromQuery(benchmark::State& state) {
+  InitFromQuery<false>(state);
+}
+BENCHMARK(BM_SongInitFromQuery)->Apply(SongCounts);
+
+void BM_SongInitFromSqlRow(benchmark::State& state) {
+  InitFromQuery<true>(state);
+}
+BENCHMARK(BM_SongInitFromSqlRow)->Apply(SongCounts);
+
+// Filling the library view's top level, grouped by artist.
+void BM_LibraryModelInit(benchmark::State& state) {
+  LibraryFixture* fixture = LibraryFixture::Filled(state.range(0));
+
+  for (auto _ : state) {
+    LibraryModel model(fixture->backend(), nullptr);
+    model.Init(false);
+    benchmark::DoNotOptimize(model.rowCount(QModelIndex()));
+  }
+}
+BENCHMARK(BM_LibraryModelInit)->Apply(SongCounts);
+
+}  // namespace
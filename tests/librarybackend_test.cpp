@@ -22,22 +22,25 @@
 
 #include <QFileInfo>
 #include <QSignalSpy>
+#include <QSqlQuery>
 #include <QThread>
 #include <QtDebug>
 
 #include "library/librarybackend.h"
 #include "library/library.h"
 #include "core/song.h"
+#include "core/timeconstants.h"
 #include "core/database.h"
+#include "library/sqlrow.h"
 
 namespace {
 
 class LibraryBackendTest : public ::testing::Test {
  protected:
   virtual void SetUp() {
-    database_.reset(new MemoryDatabase);
+    database_.reset(new MemoryDatabase(nullptr));
     backend_.reset(new LibraryBackend);
-    backend_->Init(database_, Library::kSongsTable,
+    backend_->Init(database_.get(), Library::kSongsTable,
                    Library::kDirsTable, Library::kSubdirsTable,
                    Library::kFtsTable);
   }
@@ -104,31 +107,130 @@ TEST_F(LibraryBackendTest, AddInvalidSong) {
   Song s;
   s.set_directory_id(1);
 
-  QSignalSpy spy(database_.get(), SIGNAL(Error(QString)));
+  QSignalSpy spy(backend_.get(), SIGNAL(SongsDiscovered(SongList)));
 
   backend_->AddOrUpdateSongs(SongList() << s);
-  ASSERT_EQ(1, spy.count()); spy.takeFirst();
+  ASSERT_EQ(0, spy.count());
 
   s.set_url(QUrl::fromLocalFile("foo"));
   backend_->AddOrUpdateSongs(SongList() << s);
-  ASSERT_EQ(1, spy.count()); spy.takeFirst();
+  ASSERT_EQ(0, spy.count());
 
   s.set_filesize(100);
   backend_->AddOrUpdateSongs(SongList() << s);
-  ASSERT_EQ(1, spy.count()); spy.takeFirst();
+  ASSERT_EQ(0, spy.count());
 
   s.set_mtime(100);
   backend_->AddOrUpdateSongs(SongList() << s);
-  ASSERT_EQ(1, spy.count()); spy.takeFirst();
+  ASSERT_EQ(0, spy.count());
 
   s.set_ctime(100);
   backend_->AddOrUpdateSongs(SongList() << s);
-  ASSERT_EQ(0, spy.count());
+  ASSERT_EQ(1, spy.count());
+}
+
+TEST_F(LibraryBackendTest, CueSheetCache) {
+  backend_->set_cue_sheets_table(Library::kCueSheetsTable);
+
+  Song song = MakeDummySong(1);
+  song.Init("Title", "Artist", "Album", 2 * kNsecPerSec, 5 * kNsecPerSec);
+  song.set_art_manual("/art.jpg");
+  song.set_cue_path("/music/album.cue");
+
+  SongList songs;
+  EXPECT_FALSE(
+      backend_->GetCachedCueSheet("/music/album.cue", 10, 100, &songs));
+
+  backend_->CacheCueSheet("/music/album.cue", 10, 100, SongList() << song);
+  ASSERT_TRUE(backend_->GetCachedCueSheet("/music/album.cue", 10, 100, &songs));
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ("Title", songs[0].title());
+  EXPECT_EQ(song.url(), songs[0].url());
+  EXPECT_EQ(2 * kNsecPerSec, songs[0].beginning_nanosec());
+  EXPECT_EQ(5 * kNsecPerSec, songs[0].end_nanosec());
+  EXPECT_EQ("/art.jpg", songs[0].art_manual());
+  EXPECT_EQ("/music/album.cue", songs[0].cue_path());
+
+  // A different mtime or size means the sheet changed.
+  EXPECT_FALSE(
+      backend_->GetCachedCueSheet("/music/album.cue", 11, 100, &songs));
+  EXPECT_FALSE(
+      backend_->GetCachedCueSheet("/music/album.cue", 10, 101, &songs));
+
+  // Caching the changed sheet replaces the old entry.
+  backend_->CacheCueSheet("/music/album.cue", 11, 100, SongList());
+  songs.clear();
+  EXPECT_TRUE(backend_->GetCachedCueSheet("/music/album.cue", 11, 100, &songs));
+  EXPECT_TRUE(songs.isEmpty());
+  EXPECT_FALSE(
+      backend_->GetCachedCueSheet("/music/album.cue", 10, 100, &songs));
+}
+
+TEST_F(LibraryBackendTest, TagReaderCrashQuarantine) {
+  // Nothing is recorded until there's a table.
+  backend_->AddTagReaderCrash(QStringList() << "/music/d.mp3");
+  EXPECT_TRUE(backend_->QuarantinedFiles().isEmpty());
+
+  backend_->set_tag_reader_crashes_table(Library::kTagReaderCrashesTable);
+  EXPECT_TRUE(backend_->QuarantinedFiles().isEmpty());
+
+  // Crashes with several files in flight don't count against any of them,
+  // however often they happen.
+  backend_->AddTagReaderCrash(QStringList() << "/music/a.mp3"
+                                            << "/music/b.mp3");
+  backend_->AddTagReaderCrash(QStringList() << "/music/a.mp3"
+                                            << "/music/c.mp3");
+  EXPECT_TRUE(backend_->QuarantinedFiles().isEmpty());
+
+  // A file that was alone when the worker crashed is quarantined straight
+  // away.
+  backend_->AddTagReaderCrash(QStringList() << "/music/d.mp3");
+  QHash<QString, uint> quarantined = backend_->QuarantinedFiles();
+  EXPECT_EQ(1, quarantined.count());
+  EXPECT_TRUE(quarantined.contains("/music/d.mp3"));
 }
 
 TEST_F(LibraryBackendTest, GetAlbumArtNonExistent) {
 }
 
+TEST_F(LibraryBackendTest, ManySongsById) {
+  backend_->AddDirectory("/music");
+
+  SongList songs;
+  for (int i = 0; i < 1000; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i)));
+    songs << song;
+  }
+  backend_->AddOrUpdateSongs(songs);
+
+  // Every other song, enough to go through the id table.
+  QList<int> ids;
+  for (int id = 1; id <= 1000; id += 2) ids << id;
+
+  QSignalSpy spy(backend_.get(), SIGNAL(SongsRatingChanged(SongList)));
+  backend_->UpdateSongsRating(ids, 0.5);
+  ASSERT_EQ(1, spy.count());
+  EXPECT_EQ(500, spy[0][0].value<SongList>().count());
+
+  const SongList found = backend_->GetSongsById(ids);
+  ASSERT_EQ(500, found.count());
+  for (const Song& song : found) {
+    EXPECT_EQ(1, song.id() % 2);
+    EXPECT_FLOAT_EQ(0.5, song.rating());
+  }
+
+  // A short list afterwards doesn't see the long one's ids.
+  EXPECT_EQ(2, backend_->GetSongsById(QList<int>() << 2 << 4).count());
+
+  // Neither does another long one, which reuses the id table.
+  QList<int> even_ids;
+  for (int id = 2; id <= 400; id += 2) even_ids << id;
+  const SongList even = backend_->GetSongsById(even_ids);
+  ASSERT_EQ(200, even.count());
+  for (const Song& song : even) EXPECT_EQ(0, song.id() % 2);
+}
+
 // Test adding a single song to the database, then getting various information
 // back about it.
 class SingleSong : public LibraryBackendTest {
@@ -235,6 +337,19 @@ TEST_F(SingleSong, GetSongById) {
   EXPECT_EQ(1, song.id());
 }
 
+TEST_F(SingleSong, GetSongsByUrls) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  SongList songs = backend_->GetSongsByUrls(
+      QList<QUrl>() << QUrl::fromLocalFile("bar.mp3") << song_.url());
+  ASSERT_EQ(1, songs.size());
+  EXPECT_EQ(song_.title(), songs[0].title());
+  EXPECT_EQ(song_.url(), songs[0].url());
+  EXPECT_EQ(1, songs[0].id());
+
+  EXPECT_TRUE(backend_->GetSongsByUrls(QList<QUrl>()).isEmpty());
+}
+
 TEST_F(SingleSong, FindSongsInDirectory) {
   AddDummySong();  if (HasFatalFailure()) return;
 
@@ -271,6 +386,56 @@ TEST_F(SingleSong, UpdateSong) {
   EXPECT_EQ(1, songs_added[0].id());
 }
 
+TEST_F(SingleSong, UpdateUnchangedSong) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  Song same_song = backend_->GetSongById(1);
+  ASSERT_TRUE(same_song.is_valid());
+
+  QSignalSpy deleted_spy(backend_.get(), SIGNAL(SongsDeleted(SongList)));
+  QSignalSpy added_spy(backend_.get(), SIGNAL(SongsDiscovered(SongList)));
+
+  backend_->AddOrUpdateSongs(SongList() << same_song);
+
+  EXPECT_EQ(0, added_spy.size());
+  EXPECT_EQ(0, deleted_spy.size());
+}
+
+TEST_F(LibraryBackendTest, UpdateSomeUnchangedSongs) {
+  backend_->AddDirectory("/tmp");
+
+  SongList songs;
+  for (int i = 1; i <= 2; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_url(QUrl::fromLocalFile(QString("/tmp/%1.mp3").arg(i)));
+    song.set_title(QString::number(i));
+    songs << song;
+  }
+  backend_->AddOrUpdateSongs(songs);
+
+  Song unchanged = backend_->GetSongById(1);
+  Song changed = backend_->GetSongById(2);
+  ASSERT_TRUE(unchanged.is_valid());
+  ASSERT_TRUE(changed.is_valid());
+  changed.set_title("A different title");
+
+  QSignalSpy deleted_spy(backend_.get(), SIGNAL(SongsDeleted(SongList)));
+  QSignalSpy added_spy(backend_.get(), SIGNAL(SongsDiscovered(SongList)));
+
+  backend_->AddOrUpdateSongs(SongList() << unchanged << changed);
+
+  // Only the changed song is written and reported.
+  ASSERT_EQ(1, added_spy.count());
+  ASSERT_EQ(1, deleted_spy.count());
+  const SongList added = added_spy[0][0].value<SongList>();
+  const SongList deleted = deleted_spy[0][0].value<SongList>();
+  ASSERT_EQ(1, added.count());
+  ASSERT_EQ(1, deleted.count());
+  EXPECT_EQ(2, added[0].id());
+  EXPECT_EQ("A different title", added[0].title());
+  EXPECT_EQ("2", deleted[0].title());
+}
+
 TEST_F(SingleSong, DeleteSongs) {
   AddDummySong();  if (HasFatalFailure()) return;
 
@@ -301,6 +466,111 @@ TEST_F(SingleSong, DeleteSongs) {
   EXPECT_EQ(0, albums.size());
 }
 
+TEST_F(SingleSong, InitFromQueryMatchesSqlRow) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  QSqlQuery q(database_->Connect());
+  q.prepare("SELECT ROWID, " + Song::kColumnSpec + " FROM songs");
+  ASSERT_TRUE(q.exec());
+  ASSERT_TRUE(q.next());
+
+  Song from_query;
+  from_query.InitFromQuery(q, true);
+  Song from_row;
+  from_row.InitFromQuery(SqlRow(q), true);
+  Song from_view;
+  from_view.InitFromQuery(SqlRow::View(q), true);
+
+  EXPECT_EQ(1, from_query.id());
+  EXPECT_EQ("foo.mp3", from_query.basefilename());
+  EXPECT_EQ(from_row.url(), from_query.url());
+  EXPECT_EQ(from_row.basefilename(), from_query.basefilename());
+  EXPECT_EQ(from_row.title(), from_query.title());
+  EXPECT_EQ(from_row.artist(), from_query.artist());
+  EXPECT_EQ(from_row.album(), from_query.album());
+  EXPECT_EQ(from_row.length_nanosec(), from_query.length_nanosec());
+  EXPECT_EQ(from_row.playcount(), from_query.playcount());
+  EXPECT_EQ(from_row.rating(), from_query.rating());
+  EXPECT_EQ(from_row.year(), from_query.year());
+
+  EXPECT_EQ(from_query.url(), from_view.url());
+  EXPECT_EQ(from_query.title(), from_view.title());
+  EXPECT_EQ(from_query.length_nanosec(), from_view.length_nanosec());
+  EXPECT_EQ(from_query.id(), SqlRow::View(q).toInt(0));
+
+  // A copied row outlives the query it came from
+  const SqlRow copy(q);
+  q.finish();
+  EXPECT_EQ(1, copy.toInt(0));
+  EXPECT_EQ("Title", copy.toString(Song::kColumns.indexOf("title") + 1));
+}
+
+TEST_F(SingleSong, InitFromQueryDecodesFilename) {
+  song_.set_url(QUrl::fromLocalFile("/tmp/a b%.mp3"));
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  QSqlQuery q(database_->Connect());
+  q.prepare("SELECT ROWID, " + Song::kColumnSpec + " FROM songs");
+  ASSERT_TRUE(q.exec());
+  ASSERT_TRUE(q.next());
+
+  Song song;
+  song.InitFromQuery(q, true);
+  EXPECT_EQ(song_.url(), song.url());
+  EXPECT_EQ("a b%.mp3", song.basefilename());
+}
+
+TEST_F(SingleSong, BulkReplace) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  QSignalSpy reset_spy(backend_.get(), SIGNAL(DatabaseReset()));
+
+  {
+    LibraryBackend::BulkReplace writer(backend_.get());
+    for (int i = 0; i < 3; ++i) {
+      Song song(song_);
+      song.set_artist(QString("Artist %1").arg(i));
+      ASSERT_TRUE(writer.Add(song));
+    }
+    EXPECT_TRUE(writer.Commit());
+  }
+
+  EXPECT_EQ(1, reset_spy.count());
+
+  QStringList artists = backend_->GetAllArtists();
+  artists.sort();
+  EXPECT_EQ(QStringList() << "Artist 0"
+                          << "Artist 1"
+                          << "Artist 2",
+            artists);
+
+  // The full-text index was replaced along with the songs
+  QSqlQuery q(database_->Connect());
+  ASSERT_TRUE(q.exec(QString("SELECT COUNT(*) FROM %1 WHERE ROWID IN "
+                             "(SELECT ROWID FROM %2)")
+                         .arg(Library::kFtsTable, Library::kSongsTable)));
+  ASSERT_TRUE(q.next());
+  EXPECT_EQ(3, q.value(0).toInt());
+  ASSERT_TRUE(q.exec(QString("SELECT COUNT(*) FROM %1")
+                         .arg(Library::kFtsTable)));
+  ASSERT_TRUE(q.next());
+  EXPECT_EQ(3, q.value(0).toInt());
+}
+
+TEST_F(SingleSong, BulkReplaceNotCommitted) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  {
+    LibraryBackend::BulkReplace writer(backend_.get());
+    Song song(song_);
+    song.set_artist("Another artist");
+    ASSERT_TRUE(writer.Add(song));
+  }
+
+  // The old song is still there.
+  EXPECT_EQ(QStringList() << "Artist", backend_->GetAllArtists());
+}
+
 TEST_F(SingleSong, MarkSongsUnavailable) {
   AddDummySong();  if (HasFatalFailure()) return;
 
@@ -331,4 +601,202 @@ TEST_F(SingleSong, MarkSongsUnavailable) {
   EXPECT_EQ(0, albums.size());
 }
 
+TEST_F(SingleSong, SyncRevisions) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  // Returns (revision, deleted) for the song, which the network remote uses
+  // to send only what changed.
+  auto sync_row = [this]() {
+    QSqlQuery q("SELECT revision, deleted FROM songs_sync WHERE song_id = 1",
+                database_->Connect());
+    EXPECT_TRUE(q.exec());
+    EXPECT_TRUE(q.next());
+    return qMakePair(q.value(0).toLongLong(), q.value(1).toBool());
+  };
+
+  const QPair<qint64, bool> added = sync_row();
+  EXPECT_FALSE(added.second);
+
+  Song new_song(song_);
+  new_song.set_id(1);
+  new_song.set_title("A different title");
+  backend_->AddOrUpdateSongs(SongList() << new_song);
+
+  const QPair<qint64, bool> updated = sync_row();
+  EXPECT_GT(updated.first, added.first);
+  EXPECT_FALSE(updated.second);
+
+  // Unavailable songs are still in the table, the remote finds out from the
+  // songs' unavailable column.
+  backend_->MarkSongsUnavailable(SongList() << new_song);
+
+  const QPair<qint64, bool> unavailable = sync_row();
+  EXPECT_GT(unavailable.first, updated.first);
+  EXPECT_FALSE(unavailable.second);
+
+  backend_->DeleteSongs(SongList() << new_song);
+
+  const QPair<qint64, bool> deleted = sync_row();
+  EXPECT_GT(deleted.first, unavailable.first);
+  EXPECT_TRUE(deleted.second);
+}
+
+TEST_F(SingleSong, CoalescedStatistics) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  QSignalSpy statistics_spy(backend_.get(),
+                            SIGNAL(SongsStatisticsChanged(SongList)));
+  QSignalSpy rating_spy(backend_.get(), SIGNAL(SongsRatingChanged(SongList)));
+
+  // Nothing is written until the flush, and then it's all written at once.
+  backend_->IncrementPlayCountAsync(1);
+  backend_->IncrementSkipCountAsync(1, 0.5);
+  backend_->IncrementPlayCountAsync(1);
+  backend_->UpdateSongRatingAsync(1, 0.2);
+  backend_->UpdateSongRatingAsync(1, 0.8);
+  EXPECT_EQ(0, backend_->GetSongById(1).playcount());
+
+  backend_->FlushStatistics();
+  ASSERT_EQ(1, statistics_spy.count());
+  ASSERT_EQ(1, rating_spy.count());
+  EXPECT_EQ(1, statistics_spy[0][0].value<SongList>().count());
+
+  Song song = backend_->GetSongById(1);
+  EXPECT_EQ(2, song.playcount());
+  EXPECT_EQ(1, song.skipcount());
+  EXPECT_FLOAT_EQ(0.8, song.rating());
+
+  // A reset drops the plays that were waiting before it.
+  backend_->IncrementPlayCountAsync(1);
+  backend_->ResetStatisticsAsync(1);
+  backend_->IncrementSkipCountAsync(1, 0.1);
+  backend_->FlushStatistics();
+  EXPECT_EQ(2, statistics_spy.count());
+  EXPECT_EQ(1, rating_spy.count());
+
+  song = backend_->GetSongById(1);
+  EXPECT_EQ(0, song.playcount());
+  EXPECT_EQ(1, song.skipcount());
+}
+
+TEST_F(SingleSong, FlushesStatisticsWhenDeleted) {
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  backend_->IncrementPlayCountAsync(1);
+  backend_.reset(new LibraryBackend);
+  backend_->Init(database_.get(), Library::kSongsTable, Library::kDirsTable,
+                 Library::kSubdirsTable, Library::kFtsTable);
+
+  EXPECT_EQ(1, backend_->GetSongById(1).playcount());
+}
+
+TEST_F(SingleSong, AggregateAlbums) {
+  backend_->set_aggregate_tables(Library::kAggregatesTable,
+                                 Library::kAlbumsTable);
+  AddDummySong();  if (HasFatalFailure()) return;
+
+  LibraryBackend::AlbumList albums = backend_->GetAllAlbums();
+  ASSERT_EQ(1, albums.size());
+  EXPECT_EQ(song_.album(), albums[0].album_name);
+  EXPECT_EQ(song_.artist(), albums[0].artist);
+  EXPECT_EQ(song_.url(), albums[0].first_url);
+
+  // Moving the song to another album should move its aggregate row too
+  Song new_song(song_);
+  new_song.set_id(1);
+  new_song.set_album("New album");
+  backend_->AddOrUpdateSongs(SongList() << new_song);
+
+  albums = backend_->GetAllAlbums();
+  ASSERT_EQ(1, albums.size());
+  EXPECT_EQ("New album", albums[0].album_name);
+
+  backend_->DeleteSongs(SongList() << new_song);
+  EXPECT_EQ(0, backend_->GetAllAlbums().size());
+}
+
+TEST_F(LibraryBackendTest, AggregateAlbumsMoveSong) {
+  backend_->set_aggregate_tables(Library::kAggregatesTable,
+                                 Library::kAlbumsTable);
+  backend_->AddDirectory("/tmp");
+
+  SongList songs;
+  for (int i = 1; i <= 3; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_url(QUrl::fromLocalFile(QString("/tmp/%1.mp3").arg(i)));
+    song.set_title(QString::number(i));
+    song.set_artist("Artist");
+    song.set_album(i < 3 ? "First" : "Second");
+    songs << song;
+  }
+  backend_->AddOrUpdateSongs(songs);
+
+  // Song 1 is the first song of both albums once it moves.  The one it left
+  // has to go on to song 2 without taking the other album along with it.
+  Song moved = backend_->GetSongById(1);
+  ASSERT_TRUE(moved.is_valid());
+  moved.set_album("Second");
+  backend_->AddOrUpdateSongs(SongList() << moved);
+
+  LibraryBackend::AlbumList albums = backend_->GetAllAlbums();
+  ASSERT_EQ(2, albums.size());
+  for (const LibraryBackend::Album& album : albums) {
+    if (album.album_name == "First") {
+      EXPECT_EQ(QUrl::fromLocalFile("/tmp/2.mp3"), album.first_url);
+    } else {
+      EXPECT_EQ("Second", album.album_name);
+      EXPECT_EQ(QUrl::fromLocalFile("/tmp/1.mp3"), album.first_url);
+    }
+  }
+}
+
+TEST_F(LibraryBackendTest, ChangeDirPath) {
+  backend_->AddDirectory("/tmp");
+  const QString old_path = QFileInfo("/tmp").canonicalFilePath();
+
+  Subdirectory subdir;
+  subdir.directory_id = 1;
+  subdir.path = old_path + "/a b";
+  subdir.mtime = 5;
+  backend_->AddOrUpdateSubdirs(SubdirectoryList() << subdir);
+
+  Song song = MakeDummySong(1);
+  song.set_url(QUrl::fromLocalFile(old_path + "/a b/foo.mp3"));
+  backend_->AddOrUpdateSongs(SongList() << song);
+
+  backend_->ChangeDirPath(1, old_path, "/media/new");
+
+  // The subdirectories keep their mtimes, so they aren't scanned again.
+  SubdirectoryList subdirs = backend_->SubdirsInDirectory(1);
+  ASSERT_EQ(1, subdirs.count());
+  EXPECT_EQ("/media/new/a b", subdirs[0].path);
+  EXPECT_EQ(5u, subdirs[0].mtime);
+
+  EXPECT_TRUE(
+      backend_->GetSongByUrl(QUrl::fromLocalFile("/media/new/a b/foo.mp3"))
+          .is_valid());
+}
+
+TEST_F(LibraryBackendTest, EnsureGroupingIndex) {
+  backend_->EnsureGroupingIndex(QStringList() << "composer"
+                                              << "album");
+
+  QSqlQuery q(database_->Connect());
+  q.prepare("SELECT sql FROM sqlite_master WHERE type = 'index' AND name = ?");
+  q.addBindValue("idx_songs_grouping_composer_album");
+  ASSERT_TRUE(q.exec());
+  ASSERT_TRUE(q.next());
+  EXPECT_TRUE(q.value(0).toString().contains(
+      "composer, album, effective_compilation, unavailable"));
+
+  // Asking again is harmless
+  backend_->EnsureGroupingIndex(QStringList() << "composer"
+                                              << "album");
+
+  // The standard groupings are indexed by the schema already
+  q.addBindValue("idx_songs_grouping_genre_artist_album");
+  ASSERT_TRUE(q.exec());
+  EXPECT_TRUE(q.next());
+}
+
 } // namespace
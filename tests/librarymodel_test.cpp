@@ -35,11 +35,11 @@ namespace {
 class LibraryModelTest : public ::testing::Test {
  protected:
   void SetUp() {
-    database_.reset(new MemoryDatabase);
+    database_.reset(new MemoryDatabase(nullptr));
     backend_.reset(new LibraryBackend);
-    backend_->Init(database_, Library::kSongsTable,
+    backend_->Init(database_.get(), Library::kSongsTable,
                    Library::kDirsTable, Library::kSubdirsTable, Library::kFtsTable);
-    model_.reset(new LibraryModel(backend_.get(), nullptr));
+    model_.reset(new LibraryModel(backend_, nullptr));
 
     added_dir_ = false;
 
@@ -73,7 +73,7 @@ class LibraryModelTest : public ::testing::Test {
   }
 
   std::shared_ptr<Database> database_;
-  std::unique_ptr<LibraryBackend> backend_;
+  std::shared_ptr<LibraryBackend> backend_;
   std::unique_ptr<LibraryModel> model_;
   std::unique_ptr<QSortFilterProxyModel> model_sorted_;
 
@@ -304,4 +304,90 @@ TEST_F(LibraryModelTest, RemoveEmptyArtists) {
   ASSERT_EQ(0, model_->rowCount(QModelIndex()));
 }
 
+TEST_F(LibraryModelTest, FilterKeepsLoadedNodes) {
+  AddSong("Title", "Artist 1", "Album", 123);
+  AddSong("Title", "Artist 2", "Album", 123);
+  model_->set_show_dividers(false);
+  model_->Init(false);
+  ASSERT_EQ(2, model_->rowCount(QModelIndex()));
+
+  // Lazy load the first artist
+  QModelIndex artist_index = model_->index(0, 0, QModelIndex());
+  const QString artist = artist_index.data().toString();
+  model_->fetchMore(artist_index);
+  ASSERT_EQ(1, model_->rowCount(artist_index));
+
+  QSignalSpy spy_remove(model_.get(), SIGNAL(rowsRemoved(QModelIndex,int,int)));
+  QSignalSpy spy_reset(model_.get(), SIGNAL(modelReset()));
+
+  // Filtering should only remove the other artist
+  model_->SetFilterText(artist);
+  ASSERT_TRUE(spy_remove.wait());
+  EXPECT_EQ(1, spy_remove.count());
+  EXPECT_EQ(0, spy_reset.count());
+
+  ASSERT_EQ(1, model_->rowCount(QModelIndex()));
+  artist_index = model_->index(0, 0, QModelIndex());
+  EXPECT_EQ(artist, artist_index.data().toString());
+  EXPECT_EQ(1, model_->rowCount(artist_index));
+}
+
+TEST_F(LibraryModelTest, FetchMoreInChunks) {
+  const int count = LibraryModel::kFetchChunkSize * 2 + 1;
+  for (int i=0 ; i<count ; ++i) {
+    Song song;
+    song.Init("Title " + QString::number(i), "Artist", "Album", 123);
+    song.set_url(QUrl("file:///tmp/foo" + QString::number(i)));
+    AddSong(song);
+  }
+  model_->set_show_dividers(false);
+  model_->Init(false);
+
+  QModelIndex artist_index = model_->index(0, 0, QModelIndex());
+  model_->fetchMore(artist_index);
+  QModelIndex album_index = model_->index(0, 0, artist_index);
+  model_->fetchMore(album_index);
+
+  // Only the first chunk is there straight away, the rest follow from the
+  // event loop.
+  EXPECT_FALSE(model_->canFetchMore(album_index));
+  ASSERT_EQ(LibraryModel::kFetchChunkSize, model_->rowCount(album_index));
+
+  QSignalSpy spy(model_.get(), SIGNAL(rowsInserted(QModelIndex,int,int)));
+  ASSERT_TRUE(spy.wait());
+  EXPECT_EQ(LibraryModel::kFetchChunkSize * 2, model_->rowCount(album_index));
+
+  // Asking for the songs doesn't wait for the rest.
+  EXPECT_EQ(count, model_->GetChildSongs(album_index).count());
+  EXPECT_EQ(count, model_->rowCount(album_index));
+}
+
+TEST_F(LibraryModelTest, DeleteSongNotPostedYet) {
+  const int count = LibraryModel::kFetchChunkSize + 1;
+  for (int i=0 ; i<count ; ++i) {
+    Song song;
+    song.Init("Title " + QString::number(i), "Artist", "Album", 123);
+    song.set_url(QUrl("file:///tmp/foo" + QString::number(i)));
+    AddSong(song);
+  }
+  model_->set_show_dividers(false);
+  model_->Init(false);
+
+  QModelIndex artist_index = model_->index(0, 0, QModelIndex());
+  model_->fetchMore(artist_index);
+  QModelIndex album_index = model_->index(0, 0, artist_index);
+  model_->fetchMore(album_index);
+  ASSERT_EQ(LibraryModel::kFetchChunkSize, model_->rowCount(album_index));
+
+  // The rest of the album is posted first, so the song can be removed on its
+  // own instead of resetting the model.
+  QSignalSpy spy_reset(model_.get(), SIGNAL(modelReset()));
+  Song last = backend_->GetSongById(count);
+  ASSERT_TRUE(last.is_valid());
+  backend_->DeleteSongs(SongList() << last);
+
+  EXPECT_EQ(0, spy_reset.count());
+  EXPECT_EQ(count - 1, model_->rowCount(album_index));
+}
+
 } // namespace
@@ -0,0 +1,124 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/logging.h"
+#include "core/messagering.h"
+
+namespace {
+
+TEST(MessageRingTest, PushAndPop) {
+  MessageRing ring(3);
+  EXPECT_EQ(4u, ring.capacity());
+
+  EXPECT_TRUE(ring.Push("one"));
+  EXPECT_TRUE(ring.Push("two"));
+
+  std::string message;
+  ASSERT_TRUE(ring.Pop(&message));
+  EXPECT_EQ("one", message);
+  ASSERT_TRUE(ring.Pop(&message));
+  EXPECT_EQ("two", message);
+  EXPECT_FALSE(ring.Pop(&message));
+}
+
+TEST(MessageRingTest, FullRingDropsMessages) {
+  MessageRing ring(2);
+  EXPECT_TRUE(ring.Push("one"));
+  EXPECT_TRUE(ring.Push("two"));
+  EXPECT_FALSE(ring.Push("three"));
+
+  std::string message;
+  ASSERT_TRUE(ring.Pop(&message));
+  EXPECT_TRUE(ring.Push("three"));
+}
+
+TEST(MessageRingTest, ManyThreads) {
+  const int kThreads = 4;
+  const int kMessages = 10000;
+  MessageRing ring(64);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&ring, t]() {
+      for (int i = 0; i < kMessages; ++i) {
+        // A failed push leaves the message alone.
+        std::string message = std::to_string(t * kMessages + i);
+        while (!ring.Push(std::move(message))) std::this_thread::yield();
+      }
+    });
+  }
+
+  std::vector<bool> seen(kThreads * kMessages, false);
+  int popped = 0;
+  std::string message;
+  while (popped < kThreads * kMessages) {
+    if (ring.Pop(&message)) {
+      const int n = std::stoi(message);
+      EXPECT_FALSE(seen[n]);
+      seen[n] = true;
+      ++popped;
+    }
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+TEST(LoggingTest, MemoryLogKeepsTheEnd) {
+  logging::SetMemoryLogSize(64);
+  for (int i = 0; i < 20; ++i) qLog(Error) << "message" << i;
+
+  const std::string log = logging::MemoryLog();
+  EXPECT_EQ(64u, log.size());
+  EXPECT_NE(std::string::npos, log.find("message 19\n"));
+  EXPECT_EQ(std::string::npos, log.find("message 1\n"));
+
+  logging::SetMemoryLogSize(0);
+}
+
+TEST(LoggingTest, RateLimit) {
+  logging::SetMemoryLogSize(0);
+  logging::SetRateLimit(5);
+  const uint64_t dropped = logging::DroppedMessages();
+
+  for (int i = 0; i < 10; ++i) qLogCat(Warning, "RateLimitTest") << i;
+  // Errors always get through.
+  qLogCat(Error, "RateLimitTest") << "error";
+
+  logging::SetRateLimit(0);
+  // Most likely 5, unless the second ticked over in the middle.
+  EXPECT_LE(1u, logging::DroppedMessages() - dropped);
+  EXPECT_GE(5u, logging::DroppedMessages() - dropped);
+}
+
+TEST(LoggingTest, AsyncWriter) {
+  logging::SetMemoryLogSize(4096);
+  logging::StartAsyncWriter();
+  qLog(Error) << "written later";
+  logging::StopAsyncWriter();
+
+  // Stopping writes everything that was queued.
+  EXPECT_NE(std::string::npos, logging::MemoryLog().find("written later"));
+  logging::SetMemoryLogSize(0);
+}
+
+}  // namespace
@@ -0,0 +1,108 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/loudnessmeter.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// seconds of a 1 kHz sine in both channels, peaking at level dBFS.
+std::vector<float> Sine(double level, double seconds) {
+  const int frames = seconds * LoudnessMeter::kSampleRate;
+  const double amplitude = std::pow(10, level / 20);
+  std::vector<float> ret(frames * 2);
+  for (int i = 0; i < frames; ++i) {
+    const float sample =
+        amplitude * std::sin(2 * M_PI * 1000 * i / LoudnessMeter::kSampleRate);
+    ret[i * 2] = sample;
+    ret[i * 2 + 1] = sample;
+  }
+  return ret;
+}
+
+double Measure(const std::vector<float>& samples) {
+  LoudnessMeter meter(2);
+  meter.Process(samples.data(), samples.size() / 2);
+  return meter.IntegratedLoudness();
+}
+
+TEST(LoudnessMeterTest, SineWave) {
+  // From EBU Tech 3341: a -23 dBFS 1 kHz sine in both channels is -23 LUFS.
+  EXPECT_NEAR(-23.0, Measure(Sine(-23, 20)), 0.1);
+  EXPECT_NEAR(-33.0, Measure(Sine(-33, 20)), 0.1);
+}
+
+TEST(LoudnessMeterTest, GatesSilence) {
+  std::vector<float> samples = Sine(-20, 10);
+  samples.resize(samples.size() * 2, 0);
+  EXPECT_NEAR(-20.0, Measure(samples), 0.1);
+}
+
+TEST(LoudnessMeterTest, Silence) {
+  EXPECT_EQ(LoudnessMeter::kSilence, Measure(std::vector<float>(96000, 0)));
+  // Too short for a single block.
+  EXPECT_EQ(LoudnessMeter::kSilence, Measure(Sine(-20, 0.3)));
+}
+
+TEST(LoudnessMeterTest, Mono) {
+  // One channel of the same sine is 3 dB quieter.
+  const std::vector<float> stereo = Sine(-20, 10);
+  std::vector<float> mono(stereo.size() / 2);
+  for (size_t i = 0; i < mono.size(); ++i) mono[i] = stereo[i * 2];
+
+  LoudnessMeter meter(1);
+  meter.Process(mono.data(), mono.size());
+  EXPECT_NEAR(-23.01, meter.IntegratedLoudness(), 0.1);
+}
+
+TEST(LoudnessMeterTest, ChunksDontMatter) {
+  const std::vector<float> samples = Sine(-20, 5);
+  LoudnessMeter meter(2);
+  for (size_t i = 0; i < samples.size(); i += 2 * 1001) {
+    const int frames = std::min<size_t>(1001, (samples.size() - i) / 2);
+    meter.Process(samples.data() + i, frames);
+  }
+  EXPECT_EQ(Measure(samples), meter.IntegratedLoudness());
+}
+
+TEST(LoudnessMeterTest, PeakAndAlbum) {
+  const std::vector<float> quiet = Sine(-30, 10);
+  const std::vector<float> loud = Sine(-10, 10);
+
+  LoudnessMeter quiet_meter(2);
+  quiet_meter.Process(quiet.data(), quiet.size() / 2);
+  LoudnessMeter loud_meter(2);
+  loud_meter.Process(loud.data(), loud.size() / 2);
+
+  EXPECT_NEAR(std::pow(10, -10 / 20.0), loud_meter.peak(), 0.001);
+  EXPECT_NEAR(-18 + 10, LoudnessMeter::Gain(loud_meter.IntegratedLoudness()),
+              0.1);
+
+  // The quiet track is more than 10 dB below the loud one, so the relative
+  // gate leaves it out of the album's loudness.
+  std::vector<double> album = quiet_meter.blocks();
+  album.insert(album.end(), loud_meter.blocks().begin(),
+               loud_meter.blocks().end());
+  EXPECT_NEAR(-10.0, LoudnessMeter::IntegratedLoudness(album), 0.1);
+}
+
+}  // namespace
@@ -48,33 +48,21 @@ TEST_F(M3UParserTest, ParsesMetadata) {
 TEST_F(M3UParserTest, ParsesTrackLocation) {
   QTemporaryFile temp;
   temp.open();
-  taglib_.ExpectCall(temp.fileName(), "foo", "bar", "baz");
-  Song song(&taglib_);
+  Song song;
   QString line(temp.fileName());
-  parser_.LoadSong(line, 0, QDir(), &song);
-  ASSERT_EQ(QUrl::fromLocalFile(temp.fileName()), song.url());
-
-  song.InitFromFile(song.url().toLocalFile(), -1);
-
-  EXPECT_EQ("foo", song.title());
-  EXPECT_EQ("bar", song.artist());
-  EXPECT_EQ("baz", song.album());
+  parser_.LocateSong(line, 0, QDir(), &song);
+  EXPECT_EQ(QUrl::fromLocalFile(temp.fileName()), song.url());
 }
 
 TEST_F(M3UParserTest, ParsesTrackLocationRelative) {
   QTemporaryFile temp;
   temp.open();
   QFileInfo info(temp);
-  taglib_.ExpectCall(temp.fileName(), "foo", "bar", "baz");
   M3UParser parser(nullptr);
   QString line(info.fileName());
-  Song song(&taglib_);
-  parser.LoadSong(line, 0, info.dir(), &song);
-  ASSERT_EQ(QUrl::fromLocalFile(temp.fileName()), song.url());
-
-  song.InitFromFile(song.url().toLocalFile(), -1);
-
-  EXPECT_EQ("foo", song.title());
+  Song song;
+  parser.LocateSong(line, 0, info.dir(), &song);
+  EXPECT_EQ(QUrl::fromLocalFile(temp.fileName()), song.url());
 }
 
 TEST_F(M3UParserTest, ParsesTrackLocationHttp) {
@@ -115,6 +103,42 @@ TEST_F(M3UParserTest, ParsesNonExtendedM3U) {
   EXPECT_TRUE(songs[0].artist().isEmpty());
 }
 
+TEST_F(M3UParserTest, LoadsInChunks) {
+  const int count = ParserBase::kChunkSize * 2 + 1;
+  QByteArray data = "#EXTM3U\n";
+  for (int i = 0; i < count; ++i) {
+    data += QString("#EXTINF:1,Artist - Title %1\n").arg(i).toUtf8();
+    data += QString("http://foo.com/%1.mp3\n").arg(i).toUtf8();
+  }
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  M3UParser parser(nullptr);
+  QList<SongList> chunks;
+  parser.LoadChunks(&buffer, "", QDir(),
+                    [&chunks](const SongList& songs) { chunks << songs; });
+  ASSERT_EQ(3, chunks.count());
+  EXPECT_EQ(ParserBase::kChunkSize, chunks[0].count());
+  EXPECT_EQ(1, chunks[2].count());
+  EXPECT_EQ("Title 0", chunks[0][0].title());
+  EXPECT_EQ(QUrl(QString("http://foo.com/%1.mp3").arg(count - 1)),
+            chunks[2][0].url());
+}
+
+TEST_F(M3UParserTest, ParsesCarriageReturns) {
+  QByteArray data = "#EXTM3U\r"
+                    "#EXTINF:123,Some Artist - Some Title\r"
+                    "http://foo.com/bar/somefile.mp3\r"
+                    "http://baz.com/thing.mp3\r";
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  M3UParser parser(nullptr);
+  SongList songs = parser.Load(&buffer);
+  ASSERT_EQ(2, songs.size());
+  EXPECT_EQ("Some Title", songs[0].title());
+  EXPECT_EQ(QUrl("http://baz.com/thing.mp3"), songs[1].url());
+}
+
 TEST_F(M3UParserTest, ParsesActualM3U) {
   QFile file(":testdata/test.m3u");
   file.open(QIODevice::ReadOnly);
@@ -146,6 +170,49 @@ TEST_F(M3UParserTest, SavesSong) {
   EXPECT_THAT(data.constData(), HasSubstr("http://www.example.com/foo.mp3"));
 }
 
+TEST_F(M3UParserTest, SavesRelativePaths) {
+  SongList songs;
+  for (const QString& path :
+       {"/music/a/1.mp3", "/music/a/2.mp3", "/music/b/c/3.mp3",
+        "/music/4.mp3", "/other/5.mp3"}) {
+    Song song;
+    song.set_url(QUrl::fromLocalFile(path));
+    songs << song;
+  }
+
+  QList<int> progress;
+  QBuffer buffer;
+  buffer.open(QIODevice::WriteOnly);
+  M3UParser parser(nullptr);
+  parser.Save(songs, &buffer, QDir("/music"), Playlist::Path_Automatic,
+              [&progress](int saved) { progress << saved; });
+
+  const QStringList lines = QString::fromUtf8(buffer.data()).split('\n');
+  EXPECT_TRUE(lines.contains("a/1.mp3"));
+  EXPECT_TRUE(lines.contains("a/2.mp3"));
+  EXPECT_TRUE(lines.contains("b/c/3.mp3"));
+  EXPECT_TRUE(lines.contains("4.mp3"));
+  // Outside the playlist's directory, so absolute unless asked otherwise.
+  EXPECT_TRUE(lines.contains("/other/5.mp3"));
+  EXPECT_EQ(QList<int>() << 0, progress);
+
+  QBuffer relative;
+  relative.open(QIODevice::WriteOnly);
+  parser.Save(songs, &relative, QDir("/music"), Playlist::Path_Relative);
+  EXPECT_TRUE(QString::fromUtf8(relative.data())
+                  .split('\n')
+                  .contains("../other/5.mp3"));
+
+  // Progress is reported once per chunk.
+  while (songs.count() <= ParserBase::kChunkSize) songs << songs.first();
+  progress.clear();
+  QBuffer big;
+  big.open(QIODevice::WriteOnly);
+  parser.Save(songs, &big, QDir("/music"), Playlist::Path_Automatic,
+              [&progress](int saved) { progress << saved; });
+  EXPECT_EQ(QList<int>() << 0 << ParserBase::kChunkSize, progress);
+}
+
 TEST_F(M3UParserTest, ParsesUTF8) {
   QByteArray data = "#EXTM3U\n"
                     "#EXTINF:123,Разные - исполнители\n"
@@ -0,0 +1,107 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/memorybudget.h"
+
+#include <QCoreApplication>
+
+namespace {
+
+TEST(MemoryBudgetTest, NoLimit) {
+  MemoryBudget budget;
+  budget.SetLimit(0);
+
+  qint64 limit = -1;
+  budget.Register("a", 1000, []() { return 10; },
+                  [&](qint64 bytes) { limit = bytes; });
+
+  // Caches keep the size they asked for.
+  EXPECT_EQ(-1, limit);
+  ASSERT_EQ(1, budget.usage().count());
+  EXPECT_EQ("a", budget.usage()[0].name_);
+  EXPECT_EQ(10, budget.usage()[0].used_bytes_);
+  EXPECT_EQ(1000, budget.usage()[0].limit_bytes_);
+}
+
+TEST(MemoryBudgetTest, SharesTheLimit) {
+  MemoryBudget budget;
+  budget.SetLimit(0);
+
+  qint64 a_limit = -1;
+  qint64 b_limit = -1;
+  budget.Register("a", 3000, nullptr, [&](qint64 bytes) { a_limit = bytes; });
+  budget.Register("b", 1000, nullptr, [&](qint64 bytes) { b_limit = bytes; });
+
+  budget.SetLimit(2000);
+  EXPECT_EQ(1500, a_limit);
+  EXPECT_EQ(500, b_limit);
+  EXPECT_EQ(-1, budget.usage()[0].used_bytes_);
+
+  // A limit that's big enough doesn't grow them past what they wanted.
+  budget.SetLimit(8000);
+  EXPECT_EQ(3000, a_limit);
+  EXPECT_EQ(1000, b_limit);
+}
+
+TEST(MemoryBudgetTest, RegisteringShrinksTheOthers) {
+  MemoryBudget budget;
+  budget.SetLimit(1000);
+
+  qint64 a_limit = -1;
+  qint64 b_limit = -1;
+  budget.Register("a", 1000, nullptr, [&](qint64 bytes) { a_limit = bytes; });
+  budget.Register("b", 1000, nullptr, [&](qint64 bytes) { b_limit = bytes; });
+  EXPECT_EQ(500, b_limit);
+
+  // The others are told later, in the budget's thread.
+  QCoreApplication::processEvents();
+  EXPECT_EQ(500, a_limit);
+}
+
+TEST(MemoryBudgetTest, Pressure) {
+  MemoryBudget budget;
+  budget.SetLimit(0);
+
+  qint64 limit = -1;
+  budget.Register("a", 1000, nullptr, [&](qint64 bytes) { limit = bytes; });
+
+  budget.SetUnderPressure(true);
+  EXPECT_TRUE(budget.under_pressure());
+  EXPECT_EQ(500, limit);
+
+  budget.SetUnderPressure(false);
+  EXPECT_EQ(1000, limit);
+}
+
+TEST(MemoryBudgetTest, Unregister) {
+  MemoryBudget budget;
+  budget.SetLimit(0);
+
+  int calls = 0;
+  const int id =
+      budget.Register("a", 1000, nullptr, [&](qint64) { ++calls; });
+  budget.Unregister(id);
+  EXPECT_TRUE(budget.usage().isEmpty());
+
+  budget.SetLimit(100);
+  EXPECT_EQ(0, calls);
+}
+
+}  // namespace
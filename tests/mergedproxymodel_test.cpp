@@ -160,3 +160,31 @@ TEST_F(MergedProxyModelTest, SubRemove) {
   EXPECT_EQ(0, after_spy[0][1].toInt());
   EXPECT_EQ(0, after_spy[0][2].toInt());
 }
+
+TEST_F(MergedProxyModelTest, MergePointMoves) {
+  source_.appendRow(new QStandardItem("one"));
+  source_.appendRow(new QStandardItem("two"));
+
+  QStandardItemModel submodel;
+  submodel.appendRow(new QStandardItem("three"));
+
+  merged_.AddSubModel(source_.index(1, 0, QModelIndex()), &submodel);
+  ASSERT_EQ(1, merged_.rowCount(merged_.index(1, 0, QModelIndex())));
+
+  // Rows added and removed above the merge point move it, and the submodel
+  // should move with it.
+  source_.insertRow(0, new QStandardItem("zero"));
+  ASSERT_EQ(3, merged_.rowCount(QModelIndex()));
+  EXPECT_FALSE(merged_.hasChildren(merged_.index(1, 0, QModelIndex())));
+
+  QModelIndex two_i = merged_.index(2, 0, QModelIndex());
+  EXPECT_EQ("two", two_i.data().toString());
+  ASSERT_EQ(1, merged_.rowCount(two_i));
+  EXPECT_EQ("three", merged_.index(0, 0, two_i).data().toString());
+
+  source_.removeRows(0, 2);
+  two_i = merged_.index(0, 0, QModelIndex());
+  EXPECT_EQ("two", two_i.data().toString());
+  ASSERT_EQ(1, merged_.rowCount(two_i));
+  EXPECT_EQ("three", merged_.index(0, 0, two_i).data().toString());
+}
@@ -0,0 +1,90 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/metrics.h"
+
+namespace {
+
+TEST(MetricsTest, SameNameSameMetric) {
+  metrics::Counter* counter =
+      metrics::GetCounter("test_same_name_total", "A counter");
+  EXPECT_EQ(counter, metrics::GetCounter("test_same_name_total", "Ignored"));
+
+  const qint64 before = counter->value();
+  counter->Increment();
+  counter->Increment(2);
+  EXPECT_EQ(before + 3, counter->value());
+}
+
+TEST(MetricsTest, WrongTypeIsntExported) {
+  metrics::GetGauge("test_wrong_type", "A gauge")->Set(5);
+  metrics::GetCounter("test_wrong_type", "Not a counter")->Increment(7);
+
+  const QByteArray text = metrics::PrometheusText();
+  EXPECT_TRUE(text.contains("# TYPE test_wrong_type gauge\n"));
+  EXPECT_TRUE(text.contains("\ntest_wrong_type 5\n"));
+}
+
+TEST(MetricsTest, CounterAndGaugeText) {
+  metrics::GetCounter("test_text_total", "Things\nthat happened")
+      ->Increment(4);
+  metrics::Gauge* gauge = metrics::GetGauge("test_text_gauge", "A level");
+  gauge->Set(10);
+  gauge->Add(-3);
+
+  const QByteArray text = metrics::PrometheusText();
+  EXPECT_TRUE(text.contains("# HELP test_text_total Things\\nthat happened\n"
+                            "# TYPE test_text_total counter\n"
+                            "test_text_total 4\n"));
+  EXPECT_TRUE(text.contains("# TYPE test_text_gauge gauge\n"
+                            "test_text_gauge 7\n"));
+}
+
+TEST(MetricsTest, HistogramText) {
+  metrics::Histogram* histogram =
+      metrics::GetHistogram("test_histogram_seconds", "Durations");
+  histogram->ObserveUsec(50);
+  histogram->ObserveUsec(2000);
+  histogram->ObserveUsec(60000000);
+
+  EXPECT_EQ(3, histogram->count());
+  EXPECT_EQ(60002050, histogram->sum_usec());
+  EXPECT_EQ(1, histogram->bucket(0));
+  EXPECT_EQ(1, histogram->bucket(3));
+
+  const QByteArray text = metrics::PrometheusText();
+  EXPECT_TRUE(text.contains("test_histogram_seconds_bucket{le=\"0.0001\"} 1\n"
+                            "test_histogram_seconds_bucket{le=\"0.0005\"} 1\n"
+                            "test_histogram_seconds_bucket{le=\"0.001\"} 1\n"
+                            "test_histogram_seconds_bucket{le=\"0.005\"} 2\n"));
+  EXPECT_TRUE(text.contains("test_histogram_seconds_bucket{le=\"5\"} 2\n"
+                            "test_histogram_seconds_bucket{le=\"+Inf\"} 3\n"
+                            "test_histogram_seconds_sum 60.00205\n"
+                            "test_histogram_seconds_count 3\n"));
+}
+
+TEST(MetricsTest, ScopedTimer) {
+  metrics::Histogram* histogram =
+      metrics::GetHistogram("test_timer_seconds", "Durations");
+  { metrics::ScopedTimer timer(histogram); }
+  EXPECT_EQ(1, histogram->count());
+}
+
+}  // namespace
@@ -51,9 +51,11 @@ class MockLibraryBackend : public LibraryBackendInterface {
   MOCK_METHOD2(GetAlbumArt, Album(const QString&, const QString&));
 
   MOCK_METHOD1(GetSongById, Song(int));
+  MOCK_METHOD1(GetSongsById, SongList(const QList<int>&));
 
   MOCK_METHOD1(GetSongsByUrl, SongList(const QUrl&));
   MOCK_METHOD2(GetSongByUrl, Song(const QUrl&, qint64));
+  MOCK_METHOD1(GetSongsByUrls, SongList(const QList<QUrl>&));
 
   MOCK_METHOD1(AddDirectory, void(const QString&));
   MOCK_METHOD1(RemoveDirectory, void(const Directory&));
@@ -0,0 +1,151 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "moodbar/moodbarstore.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QUrl>
+
+namespace {
+
+class MoodbarStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() { filename_ = dir_.path() + "/moodbars.store"; }
+
+  static QUrl Song(int i) {
+    return QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i));
+  }
+
+  QTemporaryDir dir_;
+  QString filename_;
+};
+
+TEST_F(MoodbarStoreTest, PutAndGet) {
+  MoodbarStore store(filename_);
+  store.Put(Song(1), 100, "one");
+  store.Put(Song(2), 200, "two");
+
+  QByteArray data;
+  ASSERT_TRUE(store.Get(Song(1), 100, &data));
+  EXPECT_EQ("one", data);
+  ASSERT_TRUE(store.Get(Song(2), 200, &data));
+  EXPECT_EQ("two", data);
+  EXPECT_FALSE(store.Get(Song(3), 100, &data));
+}
+
+TEST_F(MoodbarStoreTest, IgnoresChangedFiles) {
+  MoodbarStore store(filename_);
+  store.Put(Song(1), 100, "old");
+
+  QByteArray data;
+  EXPECT_FALSE(store.Contains(Song(1), 101));
+  EXPECT_FALSE(store.Get(Song(1), 101, &data));
+
+  store.Put(Song(1), 101, "new");
+  ASSERT_TRUE(store.Get(Song(1), 101, &data));
+  EXPECT_EQ("new", data);
+  EXPECT_EQ(1, store.count());
+  EXPECT_LT(0, store.wasted_bytes());
+}
+
+TEST_F(MoodbarStoreTest, Reopen) {
+  {
+    MoodbarStore store(filename_);
+    store.Put(Song(1), 100, "one");
+  }
+
+  MoodbarStore store(filename_);
+  QByteArray data;
+  ASSERT_TRUE(store.Get(Song(1), 100, &data));
+  EXPECT_EQ("one", data);
+}
+
+TEST_F(MoodbarStoreTest, FindsRecordsAfterTheIndex) {
+  {
+    MoodbarStore store(filename_);
+    store.Put(Song(1), 100, "one");
+  }
+
+  // Pretend the index wasn't saved after the second record, as if we'd
+  // crashed.
+  QFile::copy(filename_ + ".index", filename_ + ".index.old");
+  {
+    MoodbarStore store(filename_);
+    store.Put(Song(2), 200, "two");
+  }
+  QFile::remove(filename_ + ".index");
+  QFile::rename(filename_ + ".index.old", filename_ + ".index");
+
+  MoodbarStore store(filename_);
+  QByteArray data;
+  ASSERT_TRUE(store.Get(Song(2), 200, &data));
+  EXPECT_EQ("two", data);
+  EXPECT_EQ(2, store.count());
+}
+
+TEST_F(MoodbarStoreTest, DropsCutShortRecords) {
+  {
+    MoodbarStore store(filename_);
+    store.Put(Song(1), 100, "one");
+    store.Put(Song(2), 200, "two");
+  }
+  QFile::remove(filename_ + ".index");
+
+  QFile file(filename_);
+  ASSERT_TRUE(file.resize(file.size() - 1));
+
+  MoodbarStore store(filename_);
+  QByteArray data;
+  EXPECT_TRUE(store.Get(Song(1), 100, &data));
+  EXPECT_FALSE(store.Get(Song(2), 200, &data));
+  EXPECT_EQ(1, store.count());
+
+  // New records go where the broken one was.
+  store.Put(Song(3), 300, "three");
+  ASSERT_TRUE(store.Get(Song(3), 300, &data));
+  EXPECT_EQ("three", data);
+}
+
+TEST_F(MoodbarStoreTest, Compact) {
+  MoodbarStore store(filename_);
+  for (int i = 0; i < 10; ++i) store.Put(Song(1), i, QByteArray(100, 'a' + i));
+  store.Put(Song(2), 200, "two");
+
+  const qint64 size_before = QFileInfo(filename_).size();
+  store.Compact();
+  EXPECT_EQ(0, store.wasted_bytes());
+  EXPECT_GT(size_before, QFileInfo(filename_).size());
+
+  QByteArray data;
+  ASSERT_TRUE(store.Get(Song(1), 9, &data));
+  EXPECT_EQ(QByteArray(100, 'j'), data);
+  ASSERT_TRUE(store.Get(Song(2), 200, &data));
+  EXPECT_EQ("two", data);
+
+  // And it still works after the compacted file is opened again.
+  store.Put(Song(3), 300, "three");
+  MoodbarStore reopened(filename_);
+  ASSERT_TRUE(reopened.Get(Song(3), 300, &data));
+  EXPECT_EQ("three", data);
+}
+
+}  // namespace
@@ -0,0 +1,79 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/multisortfilterproxy.h"
+
+#include <QStandardItemModel>
+
+namespace {
+
+const int kGroupRole = Qt::UserRole;
+
+QStandardItem* MakeItem(const QString& text, int group) {
+  QStandardItem* item = new QStandardItem(text);
+  item->setData(group, kGroupRole);
+  return item;
+}
+
+class MultiSortFilterProxyTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    proxy_.AddSortSpec(kGroupRole);
+    proxy_.AddSortSpec(Qt::DisplayRole, Qt::DescendingOrder);
+    proxy_.setDynamicSortFilter(true);
+    proxy_.setSourceModel(&source_);
+    proxy_.sort(0);
+  }
+
+  QStringList Rows() const {
+    QStringList ret;
+    for (int i = 0; i < proxy_.rowCount(); ++i) {
+      ret << proxy_.index(i, 0).data().toString();
+    }
+    return ret;
+  }
+
+  QStandardItemModel source_;
+  MultiSortFilterProxy proxy_;
+};
+
+TEST_F(MultiSortFilterProxyTest, SortsBySpecs) {
+  source_.appendRow(MakeItem("a", 2));
+  source_.appendRow(MakeItem("b", 1));
+  source_.appendRow(MakeItem("c", 1));
+  source_.appendRow(MakeItem("d", 2));
+
+  EXPECT_EQ(QStringList() << "c" << "b" << "d" << "a", Rows());
+}
+
+TEST_F(MultiSortFilterProxyTest, ResortsChangedRows) {
+  source_.appendRow(MakeItem("a", 1));
+  source_.appendRow(MakeItem("b", 2));
+  ASSERT_EQ(QStringList() << "a" << "b", Rows());
+
+  source_.item(0)->setData(3, kGroupRole);
+  EXPECT_EQ(QStringList() << "b" << "a", Rows());
+
+  source_.item(1)->setText("z");
+  source_.appendRow(MakeItem("y", 2));
+  EXPECT_EQ(QStringList() << "z" << "y" << "a", Rows());
+}
+
+}  // namespace
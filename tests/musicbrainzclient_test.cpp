@@ -17,8 +17,10 @@
 
 #include <memory>
 
+#include "core/database.h"
 #include "core/logging.h"
 #include "musicbrainz/musicbrainzclient.h"
+#include "musicbrainz/recordingcache.h"
 
 #include <QCoreApplication>
 #include <QEventLoop>
@@ -248,3 +250,42 @@ TEST_F(MusicBrainzClientTest, ParseTrackWithMultipleReleases) {
   ResultList tracks = result.takeFirst().value<ResultList>();
   EXPECT_EQ(expected_number_of_releases, tracks.count());
 }
+
+// Recordings that have been looked up before come from the database.
+TEST_F(MusicBrainzClientTest, CachesRecordings) {
+  QByteArray data = ReadDataFromFile(":testdata/recording.xml");
+  ASSERT_FALSE(data.isEmpty());
+
+  MemoryDatabase database(nullptr);
+  MusicBrainzClient musicbrainz_client(nullptr, mock_network_.get());
+  musicbrainz_client.set_database(&database);
+
+  QMap<QString, QString> params;
+  params["inc"] = "artists+releases+media";
+  MockNetworkReply* reply =
+      mock_network_->ExpectGet("recording", params, 200, data);
+
+  QSignalSpy spy(&musicbrainz_client,
+                 SIGNAL(Finished(int, const MusicBrainzClient::ResultList&)));
+  ASSERT_TRUE(spy.isValid());
+
+  musicbrainz_client.Start(0, QStringList() << "fooMbid");
+  reply->Done();
+  QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  ASSERT_EQ(1, spy.count());
+  const ResultList fetched = spy.takeFirst()[1].value<ResultList>();
+  ASSERT_FALSE(fetched.isEmpty());
+
+  ResultList cached;
+  ASSERT_TRUE(RecordingCache(&database).Lookup("fooMbid", &cached));
+
+  // No network request is expected this time.
+  musicbrainz_client.Start(1, QStringList() << "fooMbid");
+  EXPECT_EQ(0, spy.count());
+  QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  ASSERT_EQ(1, spy.count());
+
+  QList<QVariant> result = spy.takeFirst();
+  EXPECT_EQ(1, result[0].toInt());
+  EXPECT_EQ(fetched, result[1].value<ResultList>());
+}
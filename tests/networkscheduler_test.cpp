@@ -0,0 +1,105 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/networkscheduler.h"
+
+namespace {
+
+// The scheduler is shared by the whole process, so each test uses hosts of
+// its own.
+
+TEST(NetworkSchedulerTest, LimitsConnections) {
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+  scheduler->SetDomainLimits("connections.test", 2, 0);
+
+  EXPECT_TRUE(scheduler->TryStart("connections.test"));
+  EXPECT_TRUE(scheduler->TryStart("connections.test"));
+  EXPECT_FALSE(scheduler->TryStart("connections.test"));
+
+  scheduler->Release("connections.test");
+  EXPECT_TRUE(scheduler->TryStart("connections.test"));
+
+  scheduler->Release("connections.test");
+  scheduler->Release("connections.test");
+}
+
+TEST(NetworkSchedulerTest, LimitsSubdomains) {
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+  scheduler->SetDomainLimits("subdomains.test", 1, 0);
+
+  // Each host is counted on its own, but they're all given the same limits.
+  EXPECT_TRUE(scheduler->TryStart("a.subdomains.test"));
+  EXPECT_FALSE(scheduler->TryStart("a.subdomains.test"));
+  EXPECT_TRUE(scheduler->TryStart("b.subdomains.test"));
+
+  // Not a subdomain.
+  EXPECT_TRUE(scheduler->TryStart("notsubdomains.test"));
+  EXPECT_TRUE(scheduler->TryStart("notsubdomains.test"));
+
+  scheduler->Release("a.subdomains.test");
+  scheduler->Release("b.subdomains.test");
+  scheduler->Release("notsubdomains.test");
+  scheduler->Release("notsubdomains.test");
+}
+
+TEST(NetworkSchedulerTest, LimitsRate) {
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+  scheduler->SetDomainLimits("rate.test", 4, 60000);
+
+  EXPECT_TRUE(scheduler->TryStart("rate.test"));
+  scheduler->Release("rate.test");
+
+  // There's a connection free, but it's too soon.
+  EXPECT_FALSE(scheduler->TryStart("rate.test"));
+}
+
+TEST(NetworkSchedulerTest, Backoff) {
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+
+  EXPECT_TRUE(scheduler->TryStart("backoff.test"));
+  scheduler->Backoff("backoff.test", 60000);
+  scheduler->Release("backoff.test");
+
+  EXPECT_FALSE(scheduler->TryStart("backoff.test"));
+}
+
+TEST(NetworkSchedulerTest, Statistics) {
+  NetworkScheduler* scheduler = NetworkScheduler::Instance();
+  scheduler->RecordRequest("StatisticsTest", 100, false, false);
+  scheduler->RecordRequest("StatisticsTest", 10, true, false);
+  scheduler->RecordRequest("StatisticsTest", 300, false, true);
+
+  for (const NetworkScheduler::SubsystemStats& stats :
+       scheduler->Statistics()) {
+    if (stats.name_ != "StatisticsTest") continue;
+
+    EXPECT_EQ(3, stats.requests_);
+    EXPECT_EQ(1, stats.cache_hits_);
+    EXPECT_EQ(1, stats.errors_);
+    EXPECT_EQ(3, stats.latency_.count_);
+    EXPECT_EQ(10000, stats.latency_.min_usec_);
+    EXPECT_EQ(100000, stats.latency_.median_usec_);
+    EXPECT_EQ(300000, stats.latency_.max_usec_);
+    return;
+  }
+  FAIL() << "No statistics for StatisticsTest";
+}
+
+}  // namespace
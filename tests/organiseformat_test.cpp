@@ -152,3 +152,32 @@ TEST_F(OrganiseFormatTest, ReplaceSlashes) {
   song_.set_title("foo/bar\\baz");
   EXPECT_EQ("foo_bar_baz", format_.GetFilenameForSong(song_));
 }
+
+TEST_F(OrganiseFormatTest, TagNextToBlock) {
+  format_.set_format("%track{ - %title}");
+  song_.set_track(1);
+  song_.set_title("100% Pure");
+  EXPECT_EQ("01 - 100% Pure", format_.GetFilenameForSong(song_));
+
+  song_.set_title("");
+  EXPECT_EQ("01", format_.GetFilenameForSong(song_));
+}
+
+TEST_F(OrganiseFormatTest, ManySongs) {
+  format_.set_format("%artist/%title.mp3");
+
+  SongList songs;
+  for (int i = 0; i < 5000; ++i) {
+    Song song;
+    song.set_artist("Artist");
+    song.set_title(QString::number(i % 2500));
+    songs << song;
+  }
+
+  const QStringList filenames = format_.GetFilenamesForSongs(songs);
+  ASSERT_EQ(5000, filenames.count());
+  EXPECT_EQ("Artist/0.mp3", filenames[0]);
+  EXPECT_EQ("Artist/2499.mp3", filenames[2499]);
+  EXPECT_EQ("Artist/0(2).mp3", filenames[2500]);
+  EXPECT_EQ("Artist/2499(2).mp3", filenames[4999]);
+}
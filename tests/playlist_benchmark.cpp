@@ -0,0 +1,80 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmark_utils.h"
+
+#include <QSortFilterProxyModel>
+#include <memory>
+
+#include "playlist/playlist.h"
+#include "playlist/playlistsortkeys.h"
+#include "playlist/songplaylistitem.h"
+
+namespace {
+
+PlaylistItemList MakeItems(int count) {
+  PlaylistItemList ret;
+  ret.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    ret << PlaylistItemPtr(new SongPlaylistItem(MakeSong(i)));
+  }
+  return ret;
+}
+
+// Titles are compared with the locale, lengths as numbers.
+void SortKeys(benchmark::State& state, Playlist::Column column) {
+  const PlaylistItemList items = MakeItems(state.range(0));
+
+  for (auto _ : state) {
+    PlaylistSortKeys keys(column, QStringList(), items);
+    benchmark::DoNotOptimize(keys.Sort(Qt::AscendingOrder));
+  }
+  state.SetItemsProcessed(state.iterations() * items.count());
+}
+
+void BM_PlaylistSortByTitle(benchmark::State& state) {
+  SortKeys(state, Playlist::Column_Title);
+}
+BENCHMARK(BM_PlaylistSortByTitle)->Apply(SongCounts);
+
+void BM_PlaylistSortByLength(benchmark::State& state) {
+  SortKeys(state, Playlist::Column_Length);
+}
+BENCHMARK(BM_PlaylistSortByLength)->Apply(SongCounts);
+
+// Typing in the playlist's filter box.  Each change filters every row again:
+// the first iteration also folds every item, like the first filter after
+// the playlist was loaded.
+void BM_PlaylistFilter(benchmark::State& state) {
+  Playlist playlist(nullptr, nullptr, nullptr, 1);
+  playlist.InsertItems(MakeItems(state.range(0)));
+  QSortFilterProxyModel* proxy = playlist.proxy();
+
+  const QStringList filters = QStringList()
+                              << "artist:\"artist 12\" OR length:>5:00"
+                              << "album 3 -track:<4"
+                              << "genre:\"genre 7\" year:>=1990";
+  int i = 0;
+  for (auto _ : state) {
+    proxy->setFilterFixedString(filters[i++ % filters.count()]);
+    benchmark::DoNotOptimize(proxy->rowCount());
+  }
+  state.SetItemsProcessed(state.iterations() * playlist.rowCount());
+}
+BENCHMARK(BM_PlaylistFilter)->Apply(SongCounts);
+
+}  // namespace
@@ -0,0 +1,167 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <memory>
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "playlist/playlist.h"
+#include "mock_settingsprovider.h"
+#include "mock_playlistitem.h"
+
+#include <QSortFilterProxyModel>
+#include <QUndoStack>
+
+using ::testing::Return;
+
+namespace {
+
+// Filtering, sorting and editing a playlist.  playlist_test covers the rest
+// of Playlist but isn't built.
+class PlaylistModelTest : public ::testing::Test {
+ protected:
+  PlaylistModelTest()
+      : playlist_(nullptr, nullptr, nullptr, 1),
+        sequence_(nullptr, new DummySettingsProvider) {}
+
+  void SetUp() { playlist_.set_sequence(&sequence_); }
+
+  PlaylistItemPtr MakeMockItemP(const QString& title,
+                                const QString& artist = QString(),
+                                const QString& album = QString(),
+                                int length = 123) const {
+    Song metadata;
+    metadata.Init(title, artist, album, length);
+
+    MockPlaylistItem* ret = new MockPlaylistItem;
+    EXPECT_CALL(*ret, Metadata()).WillRepeatedly(Return(metadata));
+    return PlaylistItemPtr(ret);
+  }
+
+  Playlist playlist_;
+  PlaylistSequence sequence_;
+};
+
+TEST_F(PlaylistModelTest, FilterInsertedAndRemovedRows) {
+  playlist_.InsertItems(PlaylistItemList() << MakeMockItemP("One")
+                                           << MakeMockItemP("Two")
+                                           << MakeMockItemP("Three"));
+
+  QSortFilterProxyModel* proxy = playlist_.proxy();
+  proxy->setFilterFixedString("t");
+  EXPECT_EQ(2, proxy->rowCount());
+
+  // Rows added or removed after filtering are tested on their own
+  playlist_.InsertItems(PlaylistItemList() << MakeMockItemP("Ten"), 0);
+  EXPECT_EQ(3, proxy->rowCount());
+  EXPECT_EQ("Ten", proxy->index(0, Playlist::Column_Title).data().toString());
+
+  playlist_.removeRow(1);  // One
+  EXPECT_EQ(3, proxy->rowCount());
+
+  playlist_.removeRow(1);  // Two
+  EXPECT_EQ(2, proxy->rowCount());
+  EXPECT_EQ("Three",
+            proxy->index(1, Playlist::Column_Title).data().toString());
+
+  proxy->setFilterFixedString("three");
+  EXPECT_EQ(1, proxy->rowCount());
+}
+
+TEST_F(PlaylistModelTest, SortByTitle) {
+  playlist_.InsertItems(PlaylistItemList()
+      << MakeMockItemP("b") << MakeMockItemP("C") << MakeMockItemP("a"));
+
+  playlist_.sort(Playlist::Column_Title, Qt::AscendingOrder);
+  EXPECT_EQ("a", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("b", playlist_.item_at(1)->Metadata().title());
+  EXPECT_EQ("C", playlist_.item_at(2)->Metadata().title());
+
+  playlist_.sort(Playlist::Column_Title, Qt::DescendingOrder);
+  EXPECT_EQ("C", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("a", playlist_.item_at(2)->Metadata().title());
+}
+
+TEST_F(PlaylistModelTest, SortIsStable) {
+  playlist_.InsertItems(PlaylistItemList()
+      << MakeMockItemP("One", "", "", 2) << MakeMockItemP("Two", "", "", 1)
+      << MakeMockItemP("Three", "", "", 2));
+
+  playlist_.sort(Playlist::Column_Length, Qt::AscendingOrder);
+  EXPECT_EQ("Two", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("One", playlist_.item_at(1)->Metadata().title());
+  EXPECT_EQ("Three", playlist_.item_at(2)->Metadata().title());
+}
+
+TEST_F(PlaylistModelTest, UndoSort) {
+  playlist_.InsertItems(PlaylistItemList()
+      << MakeMockItemP("b") << MakeMockItemP("c") << MakeMockItemP("a"));
+
+  playlist_.sort(Playlist::Column_Title, Qt::AscendingOrder);
+  ASSERT_TRUE(playlist_.undo_stack()->canUndo());
+  EXPECT_EQ("sort songs", playlist_.undo_stack()->undoText());
+
+  playlist_.undo_stack()->undo();
+  EXPECT_EQ("b", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("c", playlist_.item_at(1)->Metadata().title());
+  EXPECT_EQ("a", playlist_.item_at(2)->Metadata().title());
+
+  playlist_.undo_stack()->redo();
+  EXPECT_EQ("a", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("b", playlist_.item_at(1)->Metadata().title());
+  EXPECT_EQ("c", playlist_.item_at(2)->Metadata().title());
+}
+
+TEST_F(PlaylistModelTest, UndoShuffle) {
+  PlaylistItemList items;
+  for (int i = 0; i < 20; ++i) items << MakeMockItemP(QString::number(i));
+  playlist_.InsertItems(items);
+
+  playlist_.Shuffle();
+  ASSERT_TRUE(playlist_.undo_stack()->canUndo());
+  EXPECT_EQ("shuffle songs", playlist_.undo_stack()->undoText());
+
+  playlist_.undo_stack()->undo();
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(QString::number(i), playlist_.item_at(i)->Metadata().title());
+  }
+}
+
+TEST_F(PlaylistModelTest, RemoveDuplicateSongs) {
+  playlist_.InsertItems(PlaylistItemList()
+      << MakeMockItemP("One", "Artist") << MakeMockItemP("Two", "Artist")
+      << MakeMockItemP("one", "ARTIST") << MakeMockItemP("One", "Other")
+      << MakeMockItemP("Two", "Artist"));
+  ASSERT_EQ(5, playlist_.rowCount(QModelIndex()));
+
+  playlist_.RemoveDuplicateSongs();
+  ASSERT_EQ(3, playlist_.rowCount(QModelIndex()));
+  EXPECT_EQ("One", playlist_.item_at(0)->Metadata().title());
+  EXPECT_EQ("Two", playlist_.item_at(1)->Metadata().title());
+  EXPECT_EQ("Other", playlist_.item_at(2)->Metadata().artist());
+
+  // Both duplicates come back in one step.
+  ASSERT_TRUE(playlist_.undo_stack()->canUndo());
+  EXPECT_EQ("remove 2 songs", playlist_.undo_stack()->undoText());
+  playlist_.undo_stack()->undo();
+  ASSERT_EQ(5, playlist_.rowCount(QModelIndex()));
+  EXPECT_EQ("one", playlist_.item_at(2)->Metadata().title());
+  EXPECT_EQ("Two", playlist_.item_at(4)->Metadata().title());
+}
+
+}  // namespace
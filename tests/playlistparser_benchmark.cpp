@@ -0,0 +1,60 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmark_utils.h"
+
+#include <QBuffer>
+
+#include "playlistparsers/m3uparser.h"
+#include "playlistparsers/xspfparser.h"
+
+namespace {
+
+// Streams are complete without any library lookups or tag reading, so only
+// the parsing is measured.
+SongList MakeStreams(int count) {
+  SongList ret = MakeSongs(count);
+  for (int i = 0; i < ret.count(); ++i) {
+    ret[i].set_url(QUrl(QString("http://example.com/%1.mp3").arg(i)));
+  }
+  return ret;
+}
+
+template <typename T>
+void Load(benchmark::State& state) {
+  T parser(nullptr);
+  QBuffer saved;
+  saved.open(QIODevice::WriteOnly);
+  parser.Save(MakeStreams(state.range(0)), &saved);
+  const QByteArray data = saved.data();
+
+  for (auto _ : state) {
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    benchmark::DoNotOptimize(parser.Load(&buffer));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+void BM_M3UParserLoad(benchmark::State& state) { Load<M3UParser>(state); }
+BENCHMARK(BM_M3UParserLoad)->Apply(SongCounts);
+
+void BM_XSPFParserLoad(benchmark::State& state) { Load<XSPFParser>(state); }
+BENCHMARK(BM_XSPFParserLoad)->Apply(SongCounts);
+
+}  // namespace
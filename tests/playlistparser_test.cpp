@@ -0,0 +1,53 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "playlistparsers/playlistparser.h"
+
+namespace {
+
+// Keeps any embedded nulls, which QByteArray(const char*) would stop at.
+template <int N>
+bool LooksLikeAudio(const char (&data)[N]) {
+  return PlaylistParser::LooksLikeAudio(QByteArray(data, N - 1));
+}
+
+TEST(PlaylistParserTest, RecognisesAudioHeaders) {
+  EXPECT_TRUE(LooksLikeAudio("ID3\x04\0\0\0\0\0\0\0\0"));
+  EXPECT_TRUE(LooksLikeAudio("fLaC\0\0\0\x22"));
+  EXPECT_TRUE(LooksLikeAudio("OggS\0\x02\0\0"));
+  EXPECT_TRUE(LooksLikeAudio("RIFF\x24\0\0\0WAVE"));
+  EXPECT_TRUE(LooksLikeAudio("FORM\0\0\0\0AIFF"));
+  EXPECT_TRUE(LooksLikeAudio("\0\0\0\x20" "ftypM4A "));
+  EXPECT_TRUE(LooksLikeAudio("\xff\xfb\x90\x64"));
+  EXPECT_TRUE(LooksLikeAudio("\xff\xf1\x50\x80"));
+}
+
+TEST(PlaylistParserTest, RejectsPlaylistHeaders) {
+  EXPECT_FALSE(LooksLikeAudio("#EXTM3U\n#EXTINF:1,a"));
+  EXPECT_FALSE(LooksLikeAudio("[playlist]\nFile1=a"));
+  EXPECT_FALSE(LooksLikeAudio("<?xml version=\"1.0\"?>"));
+  EXPECT_FALSE(LooksLikeAudio("RIFF\x24\0\0\0AVI "));
+  EXPECT_FALSE(LooksLikeAudio("ID"));
+
+  // UTF-16 text starts with a byte order mark that looks like a frame sync.
+  EXPECT_FALSE(LooksLikeAudio("\xff\xfe#\0"));
+}
+
+}  // namespace
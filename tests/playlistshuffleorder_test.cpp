@@ -0,0 +1,110 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "playlist/playlistshuffleorder.h"
+
+#include <QSet>
+
+namespace {
+
+// Checks that every row appears once and virtual_index undoes row.
+void ExpectBijection(const PlaylistShuffleOrder& order) {
+  QSet<int> rows;
+  for (int i = 0; i < order.count(); ++i) {
+    const int row = order.row(i);
+    ASSERT_GE(row, 0);
+    ASSERT_LT(row, order.count());
+    EXPECT_FALSE(rows.contains(row));
+    rows << row;
+    EXPECT_EQ(i, order.virtual_index(row));
+  }
+}
+
+TEST(PlaylistShuffleOrderTest, InOrder) {
+  PlaylistShuffleOrder order;
+  order.SetInOrder(5);
+  EXPECT_FALSE(order.is_shuffled());
+  EXPECT_EQ(5, order.count());
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(i, order.row(i));
+  EXPECT_EQ(-1, order.row(5));
+}
+
+TEST(PlaylistShuffleOrderTest, Shuffle) {
+  for (int count : {1, 2, 3, 16, 17, 1000, 4097}) {
+    PlaylistShuffleOrder order;
+    order.Shuffle(count);
+    EXPECT_TRUE(order.is_shuffled());
+    ExpectBijection(order);
+  }
+}
+
+TEST(PlaylistShuffleOrderTest, History) {
+  PlaylistShuffleOrder order;
+  order.Shuffle(100);
+  order.set_history(QList<int>() << 42 << 7 << 99);
+
+  EXPECT_EQ(42, order.row(0));
+  EXPECT_EQ(7, order.row(1));
+  EXPECT_EQ(99, order.row(2));
+  ExpectBijection(order);
+
+  // Rows added at the end keep the history in front.
+  order.set_count(150);
+  EXPECT_EQ(42, order.row(0));
+  EXPECT_EQ(7, order.row(1));
+  EXPECT_EQ(99, order.row(2));
+  ExpectBijection(order);
+
+  // Rows that went away drop out of the history.
+  order.set_count(50);
+  EXPECT_EQ(42, order.row(0));
+  EXPECT_EQ(7, order.row(1));
+  ExpectBijection(order);
+}
+
+TEST(PlaylistShuffleOrderTest, ShuffleGroups) {
+  QVector<QVector<int>> groups;
+  groups << (QVector<int>() << 0 << 1 << 5) << (QVector<int>() << 2 << 3)
+         << (QVector<int>() << 4) << (QVector<int>() << 6 << 7 << 8);
+
+  PlaylistShuffleOrder order;
+  order.ShuffleGroups(groups, 1);
+  EXPECT_EQ(9, order.count());
+  ExpectBijection(order);
+
+  // The first group comes first, and each group's rows are played together
+  // and in order.
+  EXPECT_EQ(2, order.row(0));
+  EXPECT_EQ(3, order.row(1));
+  for (const QVector<int>& group : groups) {
+    const int start = order.virtual_index(group[0]);
+    for (int i = 1; i < group.count(); ++i) {
+      EXPECT_EQ(start + i, order.virtual_index(group[i]));
+    }
+  }
+
+  order.set_history(QList<int>() << 2 << 8);
+  EXPECT_EQ(2, order.row(0));
+  EXPECT_EQ(8, order.row(1));
+  EXPECT_EQ(3, order.row(2));
+  ExpectBijection(order);
+}
+
+}  // namespace
@@ -0,0 +1,136 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "internet/podcasts/podcastparser.h"
+
+#include <QBuffer>
+
+namespace {
+
+QByteArray Item(int n, const char* date) {
+  return QString(
+             "<item><title>Episode %1</title>"
+             "<description>Description %1</description>"
+             "<pubDate>%2</pubDate>"
+             "<enclosure url=\"http://example.com/%1.mp3\""
+             " type=\"audio/mpeg\"/>"
+             "</item>")
+      .arg(n)
+      .arg(date)
+      .toUtf8();
+}
+
+QByteArray Feed(const QByteArray& items) {
+  return "<?xml version=\"1.0\"?><rss version=\"2.0\"><channel>"
+         "<title>Podcast</title>" +
+         items + "</channel></rss>";
+}
+
+Podcast Parse(const QByteArray& data, const PodcastParser::Options& options) {
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+
+  PodcastParser parser;
+  const QVariant ret =
+      parser.Load(&buffer, QUrl("http://example.com/feed"), options);
+  EXPECT_TRUE(ret.canConvert<Podcast>());
+  return ret.value<Podcast>();
+}
+
+QUrl EpisodeUrl(int n) {
+  return QUrl(QString("http://example.com/%1.mp3").arg(n));
+}
+
+TEST(PodcastParserTest, ParsesEverythingByDefault) {
+  const Podcast podcast =
+      Parse(Feed(Item(3, "Wed, 03 Jan 2024 10:00:00 +0000") +
+                 Item(2, "Tue, 02 Jan 2024 10:00:00 +0000") +
+                 Item(1, "Mon, 01 Jan 2024 10:00:00 +0000")),
+            PodcastParser::Options());
+
+  EXPECT_EQ("Podcast", podcast.title());
+  ASSERT_EQ(3, podcast.episodes().count());
+  EXPECT_EQ("Description 3", podcast.episodes()[0].description());
+}
+
+TEST(PodcastParserTest, StopsAtKnownEpisode) {
+  PodcastParser::Options options;
+  options.known_urls_ << EpisodeUrl(2) << EpisodeUrl(1);
+
+  const Podcast podcast =
+      Parse(Feed(Item(4, "Thu, 04 Jan 2024 10:00:00 +0000") +
+                 Item(3, "Wed, 03 Jan 2024 10:00:00 +0000") +
+                 Item(2, "Tue, 02 Jan 2024 10:00:00 +0000") +
+                 Item(1, "Mon, 01 Jan 2024 10:00:00 +0000")),
+            options);
+
+  ASSERT_EQ(2, podcast.episodes().count());
+  EXPECT_EQ(EpisodeUrl(4), podcast.episodes()[0].url());
+  EXPECT_EQ(EpisodeUrl(3), podcast.episodes()[1].url());
+}
+
+TEST(PodcastParserTest, ReadsAllOfOldestFirstFeeds) {
+  PodcastParser::Options options;
+  options.known_urls_ << EpisodeUrl(1) << EpisodeUrl(2);
+
+  const Podcast podcast =
+      Parse(Feed(Item(1, "Mon, 01 Jan 2024 10:00:00 +0000") +
+                 Item(2, "Tue, 02 Jan 2024 10:00:00 +0000") +
+                 Item(3, "Wed, 03 Jan 2024 10:00:00 +0000")),
+            options);
+
+  ASSERT_EQ(1, podcast.episodes().count());
+  EXPECT_EQ(EpisodeUrl(3), podcast.episodes()[0].url());
+}
+
+TEST(PodcastParserTest, StopsAtOldEpisode) {
+  PodcastParser::Options options;
+  options.newest_known_ = QDateTime(QDate(2024, 1, 2), QTime(12, 0));
+
+  const Podcast podcast =
+      Parse(Feed(Item(3, "Wed, 03 Jan 2024 10:00:00 +0000") +
+                 Item(2, "Tue, 02 Jan 2024 10:00:00 +0000") +
+                 Item(1, "Mon, 01 Jan 2024 10:00:00 +0000")),
+            options);
+
+  ASSERT_EQ(1, podcast.episodes().count());
+  EXPECT_EQ(EpisodeUrl(3), podcast.episodes()[0].url());
+}
+
+TEST(PodcastParserTest, DropsLongDescriptions) {
+  const QByteArray long_item =
+      "<item><description>" + QByteArray(1000, 'x') +
+      "</description><enclosure url=\"http://example.com/2.mp3\" "
+      "type=\"audio/mpeg\"/></item>";
+
+  PodcastParser::Options options;
+  options.max_description_length_ = 100;
+
+  const Podcast podcast = Parse(
+      Feed(Item(1, "Mon, 01 Jan 2024 10:00:00 +0000") + long_item), options);
+
+  ASSERT_EQ(2, podcast.episodes().count());
+  EXPECT_EQ("Description 1", podcast.episodes()[0].description());
+  EXPECT_EQ(QString(), podcast.episodes()[1].description());
+  EXPECT_EQ(EpisodeUrl(2), podcast.episodes()[1].url());
+}
+
+}  // namespace
@@ -0,0 +1,113 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "playlist/queueorder.h"
+
+#include <QStandardItemModel>
+
+namespace {
+
+class QueueOrderTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    for (int i = 0; i < 100; ++i) {
+      model_.appendRow(new QStandardItem(QString::number(i)));
+    }
+  }
+
+  QPersistentModelIndex Row(int row) {
+    return QPersistentModelIndex(model_.index(row, 0));
+  }
+
+  QList<int> Rows() const {
+    QList<int> ret;
+    for (const QPersistentModelIndex& index : order_.items()) {
+      ret << index.row();
+    }
+    return ret;
+  }
+
+  QStandardItemModel model_;
+  QueueOrder order_;
+};
+
+TEST_F(QueueOrderTest, Insert) {
+  EXPECT_TRUE(order_.isEmpty());
+
+  EXPECT_EQ(3, order_.insert(0, QList<QPersistentModelIndex>()
+                                    << Row(5) << Row(7) << Row(9)));
+  EXPECT_EQ(2, order_.insert(0, QList<QPersistentModelIndex>()
+                                    << Row(1) << Row(7) << Row(2)));
+  EXPECT_EQ(1, order_.insert(3, QList<QPersistentModelIndex>() << Row(50)));
+
+  EXPECT_EQ(QList<int>() << 1 << 2 << 5 << 50 << 7 << 9, Rows());
+  EXPECT_EQ(6, order_.count());
+  EXPECT_EQ(50, order_.at(3).row());
+}
+
+TEST_F(QueueOrderTest, PositionOf) {
+  QList<QPersistentModelIndex> indexes;
+  for (int i = 99; i >= 0; i -= 2) indexes << Row(i);
+  order_.insert(0, indexes);
+
+  for (int i = 0; i < indexes.count(); ++i) {
+    EXPECT_EQ(i, order_.position_of(Row(99 - i * 2)));
+    EXPECT_TRUE(order_.contains(Row(99 - i * 2)));
+  }
+  EXPECT_EQ(-1, order_.position_of(Row(0)));
+  EXPECT_FALSE(order_.contains(Row(0)));
+}
+
+TEST_F(QueueOrderTest, Take) {
+  QList<QPersistentModelIndex> indexes;
+  for (int i = 0; i < 10; ++i) indexes << Row(i);
+  order_.insert(0, indexes);
+
+  QList<QPersistentModelIndex> taken = order_.take(3, 4);
+  ASSERT_EQ(4, taken.count());
+  EXPECT_EQ(3, taken[0].row());
+  EXPECT_EQ(6, taken[3].row());
+  EXPECT_EQ(QList<int>() << 0 << 1 << 2 << 7 << 8 << 9, Rows());
+  EXPECT_FALSE(order_.contains(Row(4)));
+  EXPECT_EQ(3, order_.position_of(Row(7)));
+
+  // Taken rows can be put back.
+  order_.insert(0, taken);
+  EXPECT_EQ(QList<int>() << 3 << 4 << 5 << 6 << 0 << 1 << 2 << 7 << 8 << 9,
+            Rows());
+
+  order_.clear();
+  EXPECT_TRUE(order_.isEmpty());
+  EXPECT_EQ(-1, order_.position_of(Row(3)));
+}
+
+TEST_F(QueueOrderTest, FollowsSourceRows) {
+  order_.insert(0, QList<QPersistentModelIndex>() << Row(10) << Row(20));
+
+  model_.removeRows(0, 5);
+  EXPECT_EQ(QList<int>() << 5 << 15, Rows());
+  EXPECT_EQ(1, order_.position_of(Row(15)));
+
+  model_.removeRows(5, 1);
+  EXPECT_FALSE(order_.at(0).isValid());
+  EXPECT_EQ(1, order_.position_of(Row(14)));
+}
+
+}  // namespace
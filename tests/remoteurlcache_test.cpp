@@ -0,0 +1,78 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/remoteurlcache.h"
+
+#include <QThread>
+
+namespace {
+
+SongList MakeSongs(const QString& url) {
+  Song song;
+  song.set_valid(true);
+  song.set_filetype(Song::Type_Stream);
+  song.set_url(QUrl(url));
+  return SongList() << song;
+}
+
+TEST(RemoteUrlCacheTest, StoresAndLooksUp) {
+  RemoteUrlCache cache;
+  const QUrl url("http://example.com/station.pls");
+  EXPECT_TRUE(cache.Lookup(url).isEmpty());
+
+  cache.Store(url, MakeSongs("http://example.com/stream"));
+  const SongList songs = cache.Lookup(url);
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(QUrl("http://example.com/stream"), songs[0].url());
+  EXPECT_TRUE(cache.Lookup(QUrl("http://example.com/other.pls")).isEmpty());
+}
+
+TEST(RemoteUrlCacheTest, IgnoresEmptyResults) {
+  RemoteUrlCache cache;
+  cache.Store(QUrl("http://example.com/empty.m3u"), SongList());
+  EXPECT_EQ(0, cache.count());
+}
+
+TEST(RemoteUrlCacheTest, Expires) {
+  RemoteUrlCache cache(0);
+  const QUrl url("http://example.com/station.pls");
+  cache.Store(url, MakeSongs("http://example.com/stream"));
+  EXPECT_TRUE(cache.Lookup(url).isEmpty());
+}
+
+TEST(RemoteUrlCacheTest, DropsOldestWhenFull) {
+  RemoteUrlCache cache;
+  const QUrl first("http://example.com/0");
+  cache.Store(first, MakeSongs("http://example.com/stream/0"));
+  QThread::msleep(2);
+  for (int i = 1; i < RemoteUrlCache::kMaxEntries; ++i) {
+    cache.Store(QUrl(QString("http://example.com/%1").arg(i)),
+                MakeSongs(QString("http://example.com/stream/%1").arg(i)));
+  }
+  EXPECT_EQ(RemoteUrlCache::kMaxEntries, cache.count());
+
+  cache.Store(QUrl("http://example.com/new"),
+              MakeSongs("http://example.com/stream/new"));
+  EXPECT_EQ(RemoteUrlCache::kMaxEntries, cache.count());
+  EXPECT_TRUE(cache.Lookup(first).isEmpty());
+  EXPECT_FALSE(cache.Lookup(QUrl("http://example.com/new")).isEmpty());
+}
+
+}  // namespace
@@ -0,0 +1,73 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "covers/scaledcovercache.h"
+
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+namespace {
+
+class ScaledCoverCacheTest : public ::testing::Test {
+ protected:
+  QString CoverFile() const { return dir_.path() + "/cover.png"; }
+
+  QTemporaryDir dir_;
+};
+
+TEST_F(ScaledCoverCacheTest, StandardSize) {
+  EXPECT_EQ(32, ScaledCoverCache::StandardSize(16));
+  EXPECT_EQ(32, ScaledCoverCache::StandardSize(32));
+  EXPECT_EQ(128, ScaledCoverCache::StandardSize(120));
+  EXPECT_EQ(512, ScaledCoverCache::StandardSize(500));
+  EXPECT_EQ(0, ScaledCoverCache::StandardSize(1000));
+}
+
+TEST_F(ScaledCoverCacheTest, SourceKey) {
+  EXPECT_TRUE(ScaledCoverCache::SourceKey(CoverFile(), false).isEmpty());
+
+  QImage(10, 10, QImage::Format_RGB32).save(CoverFile(), "PNG");
+  const QString key = ScaledCoverCache::SourceKey(CoverFile(), false);
+  EXPECT_FALSE(key.isEmpty());
+  EXPECT_EQ(key, ScaledCoverCache::SourceKey(CoverFile(), false));
+  EXPECT_NE(key, ScaledCoverCache::SourceKey(CoverFile(), true));
+}
+
+TEST_F(ScaledCoverCacheTest, PutAndGet) {
+  QImage image(64, 64, QImage::Format_ARGB32);
+  image.fill(Qt::red);
+
+  {
+    ScaledCoverCache cache(dir_.path() + "/cache");
+    EXPECT_TRUE(cache.Get("key", 64).isNull());
+    cache.Put("key", 64, image);
+    EXPECT_EQ(image, cache.Get("key", 64));
+    EXPECT_TRUE(cache.Get("key", 128).isNull());
+  }
+
+  // A new cache finds it on disk.
+  ScaledCoverCache cache(dir_.path() + "/cache");
+  const QImage loaded = cache.Get("key", 64);
+  EXPECT_EQ(image.size(), loaded.size());
+  EXPECT_EQ(QColor(Qt::red), loaded.pixelColor(10, 10));
+}
+
+}  // namespace
@@ -0,0 +1,95 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/database.h"
+#include "internet/lastfm/scrobblejournal.h"
+
+#include <memory>
+
+namespace {
+
+class ScrobbleJournalTest : public ::testing::Test {
+ protected:
+  void SetUp() { database_.reset(new MemoryDatabase(nullptr)); }
+
+  static ScrobbleJournal::Entry MakeEntry(const QString& title,
+                                          qint64 timestamp) {
+    ScrobbleJournal::Entry ret;
+    ret.artist_ = "Artist";
+    ret.title_ = title;
+    ret.album_ = "Album";
+    ret.track_ = 3;
+    ret.duration_secs_ = 180;
+    ret.timestamp_ = timestamp;
+    return ret;
+  }
+
+  std::unique_ptr<Database> database_;
+};
+
+TEST_F(ScrobbleJournalTest, Empty) {
+  ScrobbleJournal journal(database_.get());
+  EXPECT_EQ(0, journal.Count("user"));
+  EXPECT_TRUE(journal.Next("user", 50).isEmpty());
+}
+
+TEST_F(ScrobbleJournalTest, OldestFirst) {
+  ScrobbleJournal journal(database_.get());
+  journal.Add("user", MakeEntry("Second", 2000));
+  journal.Add("user", MakeEntry("First", 1000));
+  journal.Add("user", MakeEntry("Third", 3000));
+
+  const ScrobbleJournal::EntryList entries = journal.Next("user", 2);
+  ASSERT_EQ(2, entries.count());
+  EXPECT_EQ("First", entries[0].title_);
+  EXPECT_EQ(1000, entries[0].timestamp_);
+  EXPECT_EQ("Artist", entries[0].artist_);
+  EXPECT_EQ("Album", entries[0].album_);
+  EXPECT_EQ(3, entries[0].track_);
+  EXPECT_EQ(180, entries[0].duration_secs_);
+  EXPECT_EQ("Second", entries[1].title_);
+  EXPECT_EQ(3, journal.Count("user"));
+}
+
+TEST_F(ScrobbleJournalTest, Remove) {
+  ScrobbleJournal journal(database_.get());
+  journal.Add("user", MakeEntry("First", 1000));
+  journal.Add("user", MakeEntry("Second", 2000));
+  journal.Add("user", MakeEntry("Third", 3000));
+
+  journal.Remove(journal.Next("user", 2));
+
+  const ScrobbleJournal::EntryList entries = journal.Next("user", 50);
+  ASSERT_EQ(1, entries.count());
+  EXPECT_EQ("Third", entries[0].title_);
+}
+
+TEST_F(ScrobbleJournalTest, SeparateUsers) {
+  ScrobbleJournal journal(database_.get());
+  journal.Add("user", MakeEntry("Mine", 1000));
+  journal.Add("other", MakeEntry("Theirs", 2000));
+
+  const ScrobbleJournal::EntryList entries = journal.Next("user", 50);
+  ASSERT_EQ(1, entries.count());
+  EXPECT_EQ("Mine", entries[0].title_);
+  EXPECT_EQ(1, journal.Count("other"));
+}
+
+}  // namespace
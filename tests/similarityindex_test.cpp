@@ -0,0 +1,133 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "smartplaylists/similarityindex.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+typedef SimilarityIndex::Features Features;
+
+Features RandomFeatures(std::mt19937* random) {
+  std::uniform_real_distribution<float> value(0, 1);
+  Features ret;
+  for (float& item : ret) item = value(*random);
+  return ret;
+}
+
+float Distance(const Features& a, const Features& b) {
+  float ret = 0;
+  for (int i = 0; i < SimilarityIndex::kDimensions; ++i) {
+    ret += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return ret;
+}
+
+TEST(SimilarityIndexTest, FromMoodbar) {
+  // Red goes between 0 and 255, green stays at 51 and blue is up for one
+  // frame in four.
+  QByteArray moodbar;
+  for (int i = 0; i < 4; ++i) {
+    moodbar.append(char(i % 2 ? 255 : 0));
+    moodbar.append(char(51));
+    moodbar.append(char(i == 3 ? 255 : 0));
+  }
+
+  Features features;
+  ASSERT_TRUE(SimilarityIndex::FromMoodbar(moodbar, &features));
+
+  EXPECT_FLOAT_EQ(0.5, features[0]);
+  EXPECT_FLOAT_EQ(0.5, features[1]);
+  EXPECT_FLOAT_EQ(1.0, features[2]);
+  EXPECT_FLOAT_EQ(0.5, features[3]);
+
+  EXPECT_FLOAT_EQ(0.2, features[4]);
+  EXPECT_NEAR(0.0, features[5], 1e-6);
+  EXPECT_FLOAT_EQ(0.0, features[6]);
+  EXPECT_FLOAT_EQ(0.0, features[7]);
+
+  EXPECT_FLOAT_EQ(0.25, features[8]);
+  EXPECT_FLOAT_EQ(1.0 / 3, features[10]);
+  EXPECT_FLOAT_EQ(0.25, features[11]);
+
+  EXPECT_FALSE(SimilarityIndex::FromMoodbar(QByteArray(3, 0), &features));
+}
+
+TEST(SimilarityIndexTest, PackAndUnpack) {
+  std::mt19937 random(1);
+  const Features features = RandomFeatures(&random);
+  const QByteArray packed = SimilarityIndex::Pack(features);
+  EXPECT_EQ(int(sizeof(float) * SimilarityIndex::kDimensions), packed.size());
+
+  Features unpacked;
+  ASSERT_TRUE(SimilarityIndex::Unpack(packed, &unpacked));
+  EXPECT_EQ(features, unpacked);
+  EXPECT_FALSE(SimilarityIndex::Unpack(packed.left(10), &unpacked));
+}
+
+TEST(SimilarityIndexTest, NearestMatchesBruteForce) {
+  std::mt19937 random(2);
+  std::vector<Features> songs;
+  SimilarityIndex index;
+  for (int i = 0; i < 500; ++i) {
+    songs.push_back(RandomFeatures(&random));
+    index.Add(i, songs.back());
+  }
+  index.Build();
+  EXPECT_EQ(500, index.count());
+
+  for (int query = 0; query < 20; ++query) {
+    const Features features = RandomFeatures(&random);
+
+    std::vector<int> expected(songs.size());
+    for (int i = 0; i < int(songs.size()); ++i) expected[i] = i;
+    std::sort(expected.begin(), expected.end(), [&](int a, int b) {
+      return Distance(features, songs[a]) < Distance(features, songs[b]);
+    });
+    expected.erase(std::remove(expected.begin(), expected.end(), query),
+                   expected.end());
+    expected.resize(5);
+    QList<int> expected_list;
+    for (int id : expected) expected_list << id;
+
+    // Given enough checks the search is exact.
+    const QList<int> nearest =
+        index.Nearest(features, 5, QSet<int>() << query, songs.size());
+    EXPECT_EQ(expected_list, nearest);
+  }
+}
+
+TEST(SimilarityIndexTest, LimitedChecks) {
+  std::mt19937 random(3);
+  SimilarityIndex index;
+  for (int i = 0; i < 1000; ++i) index.Add(i, RandomFeatures(&random));
+  index.Build();
+
+  Features features;
+  ASSERT_TRUE(index.Get(10, &features));
+  const QList<int> nearest = index.Nearest(features, 3, QSet<int>(), 50);
+  ASSERT_EQ(3, nearest.size());
+  EXPECT_EQ(10, nearest[0]);
+  EXPECT_FALSE(index.Get(1000, &features));
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "mock_librarybackend.h"
+#include "playlistparsers/snapshotparser.h"
+
+#include <QBuffer>
+
+using ::testing::_;
+using ::testing::Return;
+
+namespace {
+
+class SnapshotParserTest : public ::testing::Test {
+ protected:
+  SnapshotParserTest() : parser_(&library_) {
+    Directory dir;
+    dir.id = 1;
+    dir.path = "/music";
+    EXPECT_CALL(library_, GetAllDirectories())
+        .WillRepeatedly(Return(DirectoryList() << dir));
+  }
+
+  QByteArray Save(const SongList& songs) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    parser_.Save(songs, &buffer);
+    return data;
+  }
+
+  SongList Load(const QByteArray& data) {
+    QBuffer buffer(const_cast<QByteArray*>(&data));
+    buffer.open(QIODevice::ReadOnly);
+    return parser_.Load(&buffer);
+  }
+
+  MockLibraryBackend library_;
+  SnapshotParser parser_;
+};
+
+TEST_F(SnapshotParserTest, DetectsMagic) {
+  const QByteArray data = Save(SongList());
+  EXPECT_TRUE(parser_.TryMagic(data));
+  EXPECT_FALSE(parser_.TryMagic("#EXTM3U\n"));
+}
+
+TEST_F(SnapshotParserTest, LoadsLibrarySongsById) {
+  Song song;
+  song.Init("Title", "Artist", "Album", 123);
+  song.set_id(42);
+  song.set_url(QUrl::fromLocalFile("/music/foo.mp3"));
+  song.set_valid(true);
+
+  const QByteArray data = Save(SongList() << song);
+
+  EXPECT_CALL(library_, GetSongsById(QList<int>() << 42))
+      .WillOnce(Return(SongList() << song));
+  EXPECT_CALL(library_, GetSongsByUrls(_)).Times(0);
+
+  SongList songs = Load(data);
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(42, songs[0].id());
+  EXPECT_EQ("Title", songs[0].title());
+}
+
+TEST_F(SnapshotParserTest, RestoresStreamMetadata) {
+  Song song;
+  song.set_url(QUrl("http://example.com/stream"));
+  song.set_title("Radio");
+  song.set_artist("Someone");
+
+  SongList songs = Load(Save(SongList() << song));
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(QUrl("http://example.com/stream"), songs[0].url());
+  EXPECT_EQ("Radio", songs[0].title());
+  EXPECT_EQ("Someone", songs[0].artist());
+}
+
+TEST_F(SnapshotParserTest, DropsInvalidSongs) {
+  Song stream;
+  stream.set_url(QUrl("http://example.com/stream"));
+
+  SongList songs = Load(Save(SongList() << Song() << stream));
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(QUrl("http://example.com/stream"), songs[0].url());
+}
+
+TEST_F(SnapshotParserTest, RejectsTruncatedData) {
+  Song song;
+  song.set_url(QUrl("http://example.com/stream"));
+  QByteArray data = Save(SongList() << song);
+  data.chop(4);
+  EXPECT_TRUE(Load(data).isEmpty());
+}
+
+}  // namespace
@@ -423,4 +423,41 @@ TEST_F(SongTest, MergeUserSetDataTest) {
   EXPECT_EQ(song_file_with_no_rating.rating(), song_db_with_rating.rating());
 }
 
+TEST_F(SongTest, InternStrings) {
+  // Build the strings at runtime so they don't start out shared.
+  Song a;
+  a.Init(QString("Title %1").arg(1), QString("Artist %1").arg(1),
+         QString("Album %1").arg(1), 100);
+  Song b;
+  b.Init(QString("Title %1").arg(2), QString("Artist %1").arg(1),
+         QString("Album %1").arg(1), 100);
+  ASSERT_NE(a.artist().constData(), b.artist().constData());
+
+  qint64 separate_bytes = 0;
+  {
+    QSet<const void*> seen;
+    a.AddMemoryUsage(&seen, &separate_bytes);
+    b.AddMemoryUsage(&seen, &separate_bytes);
+  }
+
+  a.InternStrings();
+  b.InternStrings();
+
+  EXPECT_EQ(a.artist().constData(), b.artist().constData());
+  EXPECT_EQ(a.album().constData(), b.album().constData());
+  EXPECT_NE(a.title().constData(), b.title().constData());
+  EXPECT_EQ("Artist 1", b.artist());
+
+  qint64 shared_bytes = 0;
+  QSet<const void*> seen;
+  a.AddMemoryUsage(&seen, &shared_bytes);
+  b.AddMemoryUsage(&seen, &shared_bytes);
+  EXPECT_LT(shared_bytes, separate_bytes);
+
+  // Counting the same song again adds nothing.
+  const qint64 before = shared_bytes;
+  a.AddMemoryUsage(&seen, &shared_bytes);
+  EXPECT_EQ(before, shared_bytes);
+}
+
 }  // namespace
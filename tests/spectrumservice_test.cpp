@@ -0,0 +1,140 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "analyzers/fht.h"
+#include "engines/enginebase.h"
+#include "engines/spectrumservice.h"
+
+#include <QThread>
+#include <cmath>
+
+namespace {
+
+// Counts how many times the scope is read, and fills it with a sine wave
+// whose frequency goes up each time.
+class FakeEngine : public Engine::Base {
+ public:
+  FakeEngine() : scope_reads_(0) {}
+
+  bool Init() { return true; }
+  bool Play(quint64) { return true; }
+  void Stop(bool) {}
+  void Pause() {}
+  void Unpause() {}
+  void Seek(quint64) {}
+  Engine::State state() const { return Engine::Playing; }
+  qint64 position_nanosec() const { return 0; }
+  qint64 length_nanosec() const { return 0; }
+
+  const Engine::Scope& scope(int) {
+    ++scope_reads_;
+    for (int i = 0; i < kScopeSize / 2; ++i) {
+      const int16_t sample = 10000 * std::sin(2 * M_PI * scope_reads_ * i / 64);
+      scope_[i * 2] = sample;
+      scope_[i * 2 + 1] = sample;
+    }
+    return scope_;
+  }
+
+  int scope_reads_;
+
+ protected:
+  void SetVolumeSW(uint) {}
+};
+
+TEST(SpectrumServiceTest, SharesFramesBetweenCallers) {
+  FakeEngine engine;
+  SpectrumService* service = engine.spectrum();
+
+  const std::vector<float>& first = service->Power2(9, 1000);
+  const std::vector<float> copy = first;
+  EXPECT_EQ(1, engine.scope_reads_);
+  EXPECT_EQ(512u, first.size());
+
+  // Another analyzer asking within the same hop gets the same frame, whatever
+  // size it wants.
+  EXPECT_EQ(&first, &service->Power2(9, 1000));
+  EXPECT_EQ(copy, service->Power2(9, 1000));
+  EXPECT_EQ(128u, service->Power2(7, 1000).size());
+  EXPECT_EQ(1, engine.scope_reads_);
+  EXPECT_EQ(1u, service->frame());
+}
+
+TEST(SpectrumServiceTest, AdvancesEachHop) {
+  FakeEngine engine;
+  SpectrumService* service = engine.spectrum();
+
+  const std::vector<float> first = service->Power2(9, 1);
+  QThread::msleep(5);
+  const std::vector<float> second = service->Power2(9, 1);
+  EXPECT_EQ(2, engine.scope_reads_);
+  EXPECT_EQ(2u, service->frame());
+  EXPECT_NE(first, second);
+}
+
+TEST(SpectrumServiceTest, MatchesFHT) {
+  FakeEngine engine;
+  const std::vector<float> power = engine.spectrum()->Power2(6, 1000);
+
+  // The same samples, mixed down and transformed by hand.
+  FHT fht(6);
+  const Engine::Scope& scope = engine.Engine::Base::scope(0);
+  std::vector<float> expected(fht.size());
+  for (int i = 0; i < fht.size(); ++i) {
+    expected[i] =
+        static_cast<double>(scope[i * 2] + scope[i * 2 + 1]) / (2 * (1 << 15));
+  }
+  fht.power2(expected.data());
+
+  ASSERT_EQ(expected.size(), power.size());
+  for (int i = 0; i < fht.size() / 2; ++i) {
+    EXPECT_FLOAT_EQ(expected[i], power[i]);
+  }
+}
+
+TEST(SpectrumServiceTest, Subscribers) {
+  FakeEngine engine;
+  SpectrumService* service = engine.spectrum();
+  EXPECT_FALSE(service->has_subscribers());
+
+  service->AddSubscriber();
+  service->AddSubscriber();
+  service->RemoveSubscriber();
+  EXPECT_TRUE(service->has_subscribers());
+  service->RemoveSubscriber();
+  EXPECT_FALSE(service->has_subscribers());
+}
+
+TEST(SpectrumServiceTest, MixToMono) {
+  // An odd number of frames so the scalar tail is used too.
+  const int kFrames = 11;
+  int16_t samples[kFrames * 2];
+  for (int i = 0; i < kFrames * 2; ++i) {
+    samples[i] = (i * 7919) % 65536 - 32768;
+  }
+
+  float mono[kFrames];
+  SpectrumService::MixToMono(samples, kFrames * 2, mono);
+  for (int i = 0; i < kFrames; ++i) {
+    EXPECT_FLOAT_EQ((samples[i * 2] + samples[i * 2 + 1]) / 65536.0, mono[i]);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,76 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/streambuffer.h"
+
+#include <QThread>
+#include <QXmlStreamReader>
+#include <thread>
+
+namespace {
+
+TEST(StreamBufferTest, ReadsWhatWasAppended) {
+  StreamBuffer buffer;
+  buffer.Append("hello ");
+  buffer.Append("world");
+  buffer.Finish();
+
+  EXPECT_EQ(11, buffer.bytesAvailable());
+  EXPECT_EQ(QByteArray("hello wo"), buffer.read(8));
+  EXPECT_EQ(QByteArray("rld"), buffer.readAll());
+  EXPECT_TRUE(buffer.atEnd());
+}
+
+TEST(StreamBufferTest, WaitsForData) {
+  StreamBuffer buffer;
+
+  // The reader sees a whole document even though it arrives in pieces.
+  std::thread writer([&buffer]() {
+    for (const char* piece : {"<a>", "<b>text</b>", "</a>"}) {
+      QThread::msleep(10);
+      buffer.Append(piece);
+    }
+    buffer.Finish();
+  });
+
+  QXmlStreamReader reader(&buffer);
+  QString text;
+  while (!reader.atEnd()) {
+    if (reader.readNext() == QXmlStreamReader::Characters) {
+      text += reader.text();
+    }
+  }
+  writer.join();
+
+  EXPECT_FALSE(reader.hasError()) << reader.errorString().toStdString();
+  EXPECT_EQ("text", text);
+}
+
+TEST(StreamBufferTest, Abort) {
+  StreamBuffer buffer;
+  buffer.Append("data");
+  buffer.Abort();
+
+  char data[4];
+  EXPECT_EQ(-1, buffer.read(data, sizeof(data)));
+  EXPECT_TRUE(buffer.atEnd());
+}
+
+}  // namespace
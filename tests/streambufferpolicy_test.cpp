@@ -0,0 +1,57 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "core/timeconstants.h"
+#include "engines/streambufferpolicy.h"
+
+namespace {
+
+const qint64 kDefaultDuration = 4000 * kNsecPerMsec;
+
+TEST(StreamBufferPolicyTest, ThroughputStats) {
+  ThroughputStats stats;
+  stats.AddSample(200, 100);
+  stats.AddSample(0, 100);
+  stats.AddSample(400, 100);
+  EXPECT_EQ(2, stats.count());
+  EXPECT_DOUBLE_EQ(3.0, stats.headroom());
+  EXPECT_GT(stats.jitter(), 0.4);
+}
+
+TEST(StreamBufferPolicyTest, FastSteadyLinksGetShortBuffers) {
+  StreamBufferPolicy::Params fast =
+      StreamBufferPolicy::ParamsFor(8, 0, kDefaultDuration, 33);
+  StreamBufferPolicy::Params normal =
+      StreamBufferPolicy::ParamsFor(2, 0, kDefaultDuration, 33);
+  StreamBufferPolicy::Params poor =
+      StreamBufferPolicy::ParamsFor(1.1, 0.5, kDefaultDuration, 33);
+
+  EXPECT_LT(fast.duration_nanosec_, normal.duration_nanosec_);
+  EXPECT_EQ(kDefaultDuration, normal.duration_nanosec_);
+  EXPECT_GT(poor.duration_nanosec_, normal.duration_nanosec_);
+  EXPECT_LE(poor.duration_nanosec_, 4 * kDefaultDuration);
+
+  EXPECT_EQ(33, normal.low_percent_);
+  EXPECT_GT(poor.low_percent_, normal.low_percent_);
+  EXPECT_GT(poor.high_percent_, normal.high_percent_);
+  EXPECT_LE(poor.high_percent_, 99);
+}
+
+}  // namespace
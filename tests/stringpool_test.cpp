@@ -0,0 +1,84 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/stringpool.h"
+
+namespace {
+
+TEST(StringPoolTest, SharesEqualStrings) {
+  StringPool pool;
+  const QString first = pool.Intern(QString("Art") + "ist");
+  const QString second = pool.Intern(QString("Artis") + "t");
+
+  EXPECT_EQ("Artist", second);
+  EXPECT_EQ(first.constData(), second.constData());
+  EXPECT_EQ(1, pool.count());
+  EXPECT_LT(0, pool.bytes_saved());
+}
+
+TEST(StringPoolTest, KeepsDifferentStrings) {
+  StringPool pool;
+  EXPECT_EQ("Album", pool.Intern("Album"));
+  EXPECT_EQ("Artist", pool.Intern("Artist"));
+  EXPECT_EQ(2, pool.count());
+  EXPECT_EQ(0, pool.bytes_saved());
+}
+
+TEST(StringPoolTest, IgnoresEmptyStrings) {
+  StringPool pool;
+  EXPECT_TRUE(pool.Intern(QString()).isNull());
+  EXPECT_TRUE(pool.Intern("").isEmpty());
+  EXPECT_EQ(0, pool.count());
+}
+
+TEST(StringPoolTest, InternsInPlace) {
+  StringPool pool;
+  QString first = QString("Art") + "ist";
+  QString second = QString("Artis") + "t";
+  QString empty;
+  pool.Intern({&first, &second, &empty});
+
+  EXPECT_EQ(first.constData(), second.constData());
+  EXPECT_TRUE(empty.isNull());
+  EXPECT_EQ(1, pool.count());
+}
+
+TEST(StringPoolTest, DropsUnusedStringsWhenFull) {
+  StringPool pool(2);
+  const QString kept = pool.Intern(QString("a") + "1");
+  pool.Intern(QString("b") + "1");
+  pool.Intern(QString("c") + "1");
+  EXPECT_EQ(2, pool.count());
+
+  // The one that's still in use stays shared.
+  EXPECT_EQ(kept.constData(), pool.Intern(QString("a") + "1").constData());
+}
+
+TEST(StringPoolTest, TurnsAwayStringsWhenFullOfUsedOnes) {
+  StringPool pool(2);
+  const QString a = pool.Intern(QString("a") + "1");
+  const QString b = pool.Intern(QString("b") + "1");
+  const QString c = QString("c") + "1";
+  EXPECT_EQ(c.constData(), pool.Intern(c).constData());
+  EXPECT_EQ(2, pool.count());
+  EXPECT_EQ(a.constData(), pool.Intern(QString("a") + "1").constData());
+}
+
+}  // namespace
@@ -0,0 +1,59 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/taskmanager.h"
+
+#include <QSignalSpy>
+
+namespace {
+
+TEST(TaskManagerTest, CoalescesProgress) {
+  TaskManager manager;
+  QSignalSpy spy(&manager, SIGNAL(TasksChanged()));
+
+  const int id = manager.StartTask("test");
+  EXPECT_EQ(1, spy.count());
+
+  // A burst of progress straight after starting is held back...
+  for (int i = 1; i <= 100; ++i) manager.SetTaskProgress(id, i, 100);
+  EXPECT_EQ(1, spy.count());
+  EXPECT_EQ(100, manager.GetTaskProgress(id));
+
+  // ...and passed on once when the interval is up.
+  EXPECT_TRUE(spy.wait(TaskManager::kProgressIntervalMsec * 10));
+  EXPECT_EQ(2, spy.count());
+}
+
+TEST(TaskManagerTest, StartAndFinishAreImmediate) {
+  TaskManager manager;
+  QSignalSpy spy(&manager, SIGNAL(TasksChanged()));
+
+  const int id = manager.StartTask("test");
+  manager.IncreaseTaskProgress(id, 1);
+  manager.SetTaskFinished(id);
+  EXPECT_EQ(2, spy.count());
+  EXPECT_TRUE(manager.GetTasks().isEmpty());
+
+  // The finish already carried the progress, so nothing more is sent.
+  EXPECT_FALSE(spy.wait(TaskManager::kProgressIntervalMsec * 3));
+  EXPECT_EQ(2, spy.count());
+}
+
+}  // namespace
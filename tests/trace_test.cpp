@@ -0,0 +1,94 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/trace.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+namespace {
+
+QJsonArray ReadEvents(const QString& path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) return QJsonArray();
+  return QJsonDocument::fromJson(file.readAll())
+      .object()["traceEvents"]
+      .toArray();
+}
+
+QJsonObject FindEvent(const QJsonArray& events, const QString& name) {
+  for (const QJsonValue& value : events) {
+    if (value.toObject()["name"].toString() == name) return value.toObject();
+  }
+  return QJsonObject();
+}
+
+TEST(TraceTest, NothingRecordedUntilStarted) {
+  EXPECT_FALSE(trace::IsEnabled());
+  { TRACE_SCOPE("Before"); }
+
+  QTemporaryDir dir;
+  const QString path = dir.path() + "/trace.json";
+  trace::Start(path);
+  EXPECT_TRUE(trace::IsEnabled());
+  trace::Finish();
+  EXPECT_FALSE(trace::IsEnabled());
+
+  EXPECT_TRUE(FindEvent(ReadEvents(path), "Before").isEmpty());
+}
+
+TEST(TraceTest, WritesEvents) {
+  QTemporaryDir dir;
+  const QString path = dir.path() + "/trace.json";
+  trace::Start(path);
+
+  {
+    TRACE_SCOPE("Outer");
+    { TRACE_SCOPE(QString("Inner %1").arg(1)); }
+    trace::Instant("Mark");
+  }
+  trace::Finish();
+  // Only the first call writes anything.
+  trace::Finish();
+
+  const QJsonArray events = ReadEvents(path);
+  const QJsonObject outer = FindEvent(events, "Outer");
+  const QJsonObject inner = FindEvent(events, "Inner 1");
+  const QJsonObject mark = FindEvent(events, "Mark");
+
+  EXPECT_EQ("X", outer["ph"].toString());
+  EXPECT_EQ("X", inner["ph"].toString());
+  EXPECT_EQ("i", mark["ph"].toString());
+
+  // The inner scope is inside the outer one.
+  EXPECT_LE(outer["ts"].toDouble(), inner["ts"].toDouble());
+  EXPECT_LE(inner["ts"].toDouble() + inner["dur"].toDouble(),
+            outer["ts"].toDouble() + outer["dur"].toDouble());
+  EXPECT_EQ(outer["tid"].toInt(), inner["tid"].toInt());
+
+  const QJsonObject thread = FindEvent(events, "thread_name");
+  EXPECT_EQ("M", thread["ph"].toString());
+  EXPECT_EQ(outer["tid"].toInt(), thread["tid"].toInt());
+}
+
+}  // namespace
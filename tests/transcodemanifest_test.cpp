@@ -0,0 +1,95 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include "transcoder/transcodemanifest.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+
+class TranscodeManifestTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    filename_ = dir_.path() + "/manifest";
+    output_ = dir_.path() + "/song.mp3";
+    Write(output_, "encoded");
+  }
+
+  static void Write(const QString& filename, const QByteArray& data) {
+    QFile file(filename);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(data);
+  }
+
+  QTemporaryDir dir_;
+  QString filename_;
+  QString output_;
+};
+
+TEST_F(TranscodeManifestTest, RecordAndCheck) {
+  TranscodeManifest manifest(filename_);
+  EXPECT_FALSE(manifest.IsUpToDate(output_, "key"));
+
+  manifest.Record(output_, "key");
+  EXPECT_TRUE(manifest.IsUpToDate(output_, "key"));
+  EXPECT_FALSE(manifest.IsUpToDate(output_, "other key"));
+  EXPECT_FALSE(manifest.IsUpToDate(dir_.path() + "/other.mp3", "key"));
+}
+
+TEST_F(TranscodeManifestTest, ChangedOutput) {
+  TranscodeManifest manifest(filename_);
+  manifest.Record(output_, "key");
+
+  Write(output_, "something else");
+  EXPECT_FALSE(manifest.IsUpToDate(output_, "key"));
+
+  QFile::remove(output_);
+  EXPECT_FALSE(manifest.IsUpToDate(output_, "key"));
+}
+
+TEST_F(TranscodeManifestTest, SaveAndLoad) {
+  {
+    TranscodeManifest manifest(filename_);
+    manifest.Record(output_, "key");
+    ASSERT_TRUE(manifest.Save());
+  }
+
+  TranscodeManifest manifest(filename_);
+  EXPECT_TRUE(manifest.IsUpToDate(output_, "key"));
+}
+
+TEST_F(TranscodeManifestTest, SaveKeepsOthers) {
+  const QString other = dir_.path() + "/other.mp3";
+  Write(other, "other");
+
+  TranscodeManifest first(filename_);
+  TranscodeManifest second(filename_);
+  first.Record(output_, "first");
+  second.Record(other, "second");
+  ASSERT_TRUE(first.Save());
+  ASSERT_TRUE(second.Save());
+
+  TranscodeManifest manifest(filename_);
+  EXPECT_TRUE(manifest.IsUpToDate(output_, "first"));
+  EXPECT_TRUE(manifest.IsUpToDate(other, "second"));
+}
+
+}  // namespace
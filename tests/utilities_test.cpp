@@ -22,7 +22,11 @@
 #include "core/utilities.h"
 
 #include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
 #include <QtDebug>
+#include <limits>
 
 TEST(UtilitiesTest, HmacFunctions) {
   QString key("key");
@@ -45,3 +49,19 @@ TEST(UtilitiesTest, ParseRFC822DateTim) {
   result_DateTime = Utilities::ParseRFC822DateTime(QString("Mon, 12 March 2012 20:00:00 +0100"));
   EXPECT_TRUE(result_DateTime.isValid());
 }
+
+TEST(UtilitiesTest, PruneOldestFiles) {
+  QTemporaryDir dir;
+  for (const QString& name : QStringList() << "a" << "b" << "c") {
+    QFile file(dir.path() + "/" + name);
+    file.open(QIODevice::WriteOnly);
+    file.write("0123456789");
+  }
+
+  Utilities::PruneOldestFiles(dir.path(), 20, std::numeric_limits<int>::max());
+  EXPECT_EQ(2, QDir(dir.path()).entryList(QDir::Files).count());
+
+  Utilities::PruneOldestFiles(dir.path(), std::numeric_limits<qint64>::max(),
+                              1);
+  EXPECT_EQ(1, QDir(dir.path()).entryList(QDir::Files).count());
+}
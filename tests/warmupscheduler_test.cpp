@@ -0,0 +1,64 @@
+/* This file is part of Clementine.
+   Copyright 2026, Clementine developers
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/warmupscheduler.h"
+
+#include <QEventLoop>
+#include <QStringList>
+
+namespace {
+
+TEST(WarmUpSchedulerTest, OneStepPerSlice) {
+  WarmUpScheduler scheduler;
+  QStringList built;
+  scheduler.Add("a", []() { return false; }, [&]() { built << "a"; });
+  scheduler.Add("b", []() { return false; }, [&]() { built << "b"; });
+  EXPECT_EQ(2, scheduler.pending());
+
+  // Nothing's built until the event loop gets to it.
+  scheduler.Start();
+  EXPECT_TRUE(built.isEmpty());
+
+  QEventLoop loop;
+  QObject::connect(&scheduler, SIGNAL(Finished()), &loop, SLOT(quit()));
+  loop.exec();
+
+  EXPECT_EQ(QStringList() << "a"
+                          << "b",
+            built);
+  EXPECT_EQ(0, scheduler.pending());
+  EXPECT_FALSE(scheduler.is_running());
+}
+
+TEST(WarmUpSchedulerTest, SkipsThingsAlreadyBuilt) {
+  WarmUpScheduler scheduler;
+  QStringList built;
+  scheduler.Add("a", []() { return true; }, [&]() { built << "a"; });
+  scheduler.Add("b", []() { return false; }, [&]() { built << "b"; });
+
+  QEventLoop loop;
+  QObject::connect(&scheduler, SIGNAL(Finished()), &loop, SLOT(quit()));
+  scheduler.Start();
+  loop.exec();
+
+  EXPECT_EQ(QStringList() << "b", built);
+}
+
+}  // namespace